@@ -31,6 +31,9 @@ typedef struct MQTTBrokerConnection MQTTBrokerConnection;
 struct MQTTTopicConnection;
 typedef struct MQTTTopicConnection MQTTTopicConnection;
 
+struct MQTTTopicNode;
+typedef struct MQTTTopicNode MQTTTopicNode;
+
 /* Prevent the inclusion of "mqtt_pal.h". We make the definitions inline here to remain
  * architecture and OS-agnostic. */
 #define __MQTT_PAL_H__
@@ -71,8 +74,11 @@ static ssize_t mqtt_pal_recvall(mqtt_pal_socket_handle fd, void* buf, size_t buf
 #include "../../deps/mqtt-c/src/mqtt.c"
 
 #define MQTT_MESSAGE_MAXLEN (1u << 20) /* 1MB */
-#define MQTT_PARAMETERSSIZE 8
-#define MQTT_BROKERPARAMETERSSIZE 5 /* Parameters shared by topic connections
+#define MQTT_SENDBUFFER_SIZE (1u << 16) /* Retains QoS1 publishes until ACKed */
+#define MQTT_SENDQUEUE_MAX 64 /* Flush when more buffers are queued */
+#define MQTT_INFLIGHT_DEFAULT 64
+#define MQTT_PARAMETERSSIZE 10
+#define MQTT_BROKERPARAMETERSSIZE 6 /* Parameters shared by topic connections
                                      * connected to the same broker */
 
 static const struct {
@@ -85,9 +91,25 @@ static const struct {
     {{0, UA_STRING_STATIC("keep-alive")}, &UA_TYPES[UA_TYPES_UINT16], false},
     {{0, UA_STRING_STATIC("username")}, &UA_TYPES[UA_TYPES_STRING], false},
     {{0, UA_STRING_STATIC("password")}, &UA_TYPES[UA_TYPES_STRING], false},
+    {{0, UA_STRING_STATIC("max-inflight")}, &UA_TYPES[UA_TYPES_UINT16], false},
     {{0, UA_STRING_STATIC("validate")}, &UA_TYPES[UA_TYPES_BOOLEAN], false},
     {{0, UA_STRING_STATIC("subscribe")}, &UA_TYPES[UA_TYPES_BOOLEAN], false},
-    {{0, UA_STRING_STATIC("topic")}, &UA_TYPES[UA_TYPES_STRING], true}
+    {{0, UA_STRING_STATIC("topic")}, &UA_TYPES[UA_TYPES_STRING], true},
+    {{0, UA_STRING_STATIC("qos")}, &UA_TYPES[UA_TYPES_BYTE], false}
+};
+
+/* The subscriptions of a BrokerConnection are indexed in a trie over the topic
+ * levels. A received publish is dispatched by walking the trie along the
+ * levels of its topic name. So the cost depends on the length of the topic and
+ * not on the number of subscriptions. */
+struct MQTTTopicNode {
+    MQTTTopicNode *parent; /* NULL for the root */
+    UA_String level;       /* Points into the memory of the node */
+    MQTTTopicNode **children; /* Sorted with cmpTopicLevel */
+    size_t childrenSize;
+    MQTTTopicNode *plus;   /* Single-level wildcard */
+    MQTTTopicNode *hash;   /* Multi-level wildcard */
+    LIST_HEAD(, MQTTTopicConnection) subscribers;
 };
 
 /* The BrokerConnection is a stateful connection to the broker that aggregates
@@ -107,11 +129,22 @@ struct MQTTBrokerConnection {
     UA_DateTime lastSendTime; /* When was the last packet sent out? */
     UA_UInt16 keepalive;      /* Seconds between keepalives */
     UA_UInt64 keepAliveCallbackId; /* Registered callback to send the keepalive */
+    UA_UInt16 maxInflight;    /* QoS1 publishes not yet acknowledged */
+
+    /* Outgoing packets are collected during the EventLoop iteration and sent
+     * to the broker with a single (scatter-gather) write. This is only used if
+     * the TCP ConnectionManager supports sendWithConnectionV. */
+    UA_ByteString sendQueue[MQTT_SENDQUEUE_MAX];
+    size_t sendQueueSize;
+    size_t sendQueueBytes;
 
     /* Topic connections sharing the same connection to a broker */
     LIST_HEAD(, MQTTTopicConnection) topicConnections;
     uintptr_t lastTopicConnectionId;
 
+    /* Root of the subscription trie */
+    MQTTTopicNode topics;
+
     /* Store the connection parameters. To reconnect when necessary and to check
      * if a matching connection to the broker already exists. */
     UA_KeyValueMap params;
@@ -128,6 +161,11 @@ struct MQTTTopicConnection {
 
     UA_String topic;      /* Name of the topic */
     UA_Boolean subscribe; /* Subscribe or publish? */
+    UA_Byte qos;          /* QoS level 0 or 1 */
+
+    /* Position in the subscription trie (only for subscribe-connections) */
+    MQTTTopicNode *topicNode;
+    LIST_ENTRY(MQTTTopicConnection) subscriberNext;
 
     /* Backpointer to the connection to the broker (is always set) */
     MQTTBrokerConnection *brokerConnection;
@@ -147,8 +185,65 @@ struct MQTTConnectionManager {
     UA_ConnectionManager *tcpCM; /* The TCP ConnectionManager to use. Set during
                                   * the start of this CM. */
     LIST_HEAD(, MQTTBrokerConnection) connections;
+
+    /* Flush the send queues at the end of the EventLoop iteration */
+    UA_Boolean flushScheduled;
+    UA_DelayedCallback flushCallback;
 };
 
+static void
+flushSendQueue(MQTTBrokerConnection *bc) {
+    if(bc->sendQueueSize == 0)
+        return;
+    UA_ConnectionManager *tcpCM = bc->mcm->tcpCM;
+    UA_StatusCode res =
+        tcpCM->sendWithConnectionV(tcpCM, bc->tcpConnectionId, &UA_KEYVALUEMAP_NULL,
+                                   bc->sendQueue, bc->sendQueueSize);
+    if(res != UA_STATUSCODE_GOOD)
+        UA_LOG_WARNING(bc->mcm->cm.eventSource.eventLoop->logger,
+                       UA_LOGCATEGORY_NETWORK, "MQTT-TCP %u\t| Sending %u packets "
+                       "failed", (unsigned)bc->tcpConnectionId,
+                       (unsigned)bc->sendQueueSize);
+    bc->sendQueueSize = 0;
+    bc->sendQueueBytes = 0;
+    bc->lastSendTime = UA_DateTime_nowMonotonic();
+}
+
+static void
+flushSendQueuesDelayed(void *application, void *context) {
+    MQTTConnectionManager *mcm = (MQTTConnectionManager*)context;
+    mcm->flushScheduled = false;
+    MQTTBrokerConnection *bc;
+    LIST_FOREACH(bc, &mcm->connections, next) {
+        flushSendQueue(bc);
+    }
+}
+
+/* Takes ownership of the buffer */
+static void
+enqueueSend(MQTTBrokerConnection *bc, UA_ByteString *buf) {
+    if(bc->sendQueueSize == MQTT_SENDQUEUE_MAX)
+        flushSendQueue(bc);
+    bc->sendQueue[bc->sendQueueSize++] = *buf;
+    bc->sendQueueBytes += buf->length;
+    UA_ByteString_init(buf);
+
+    MQTTConnectionManager *mcm = bc->mcm;
+    if(!mcm->flushScheduled) {
+        UA_EventLoop *el = mcm->cm.eventSource.eventLoop;
+        mcm->flushCallback.callback = flushSendQueuesDelayed;
+        mcm->flushCallback.application = NULL;
+        mcm->flushCallback.context = mcm;
+        el->addDelayedCallback(el, &mcm->flushCallback);
+        mcm->flushScheduled = true;
+    }
+}
+
+static UA_Boolean
+batchSend(MQTTBrokerConnection *bc) {
+    return (bc->mcm->tcpCM->sendWithConnectionV != NULL);
+}
+
 /* Send via the underlying TCP connection */
 ssize_t
 mqtt_pal_sendall(MQTTBrokerConnection *bc, const void* buf, size_t len, int flags) {
@@ -162,6 +257,10 @@ mqtt_pal_sendall(MQTTBrokerConnection *bc, const void* buf, size_t len, int flag
         return MQTT_ERROR_SOCKET_ERROR;
         
     memcpy(msg.data, buf, len);
+    if(batchSend(bc)) {
+        enqueueSend(bc, &msg);
+        return (ssize_t)len;
+    }
     res = tcpCM->sendWithConnection(tcpCM, bc->tcpConnectionId,
                                     &UA_KEYVALUEMAP_NULL, &msg);
     if(res != UA_STATUSCODE_GOOD)
@@ -178,6 +277,11 @@ mqtt_pal_recvall(MQTTBrokerConnection *bc, void* buf, size_t bufsz, int flags) {
     return 0;
 }
 
+static UA_StatusCode
+MQTT_sendWithConnectionV(UA_ConnectionManager *cm, uintptr_t connectionId,
+                         const UA_KeyValueMap *params,
+                         UA_ByteString *bufs, size_t bufsSize);
+
 static UA_StatusCode
 MQTT_eventSourceStart(UA_ConnectionManager *cm) {
     MQTTConnectionManager *mcm = (MQTTConnectionManager*)cm;
@@ -201,6 +305,9 @@ MQTT_eventSourceStart(UA_ConnectionManager *cm) {
         UA_ConnectionManager *cm2 = (UA_ConnectionManager*)es;
         if(UA_String_equal(&tcp, &cm2->protocol)) {
             mcm->tcpCM = cm2;
+            /* Batching needs TCP buffers that can be held concurrently */
+            cm->sendWithConnectionV = (cm2->sendWithConnectionV) ?
+                MQTT_sendWithConnectionV : NULL;
             cm->eventSource.state = UA_EVENTSOURCESTATE_STARTED;
             return UA_STATUSCODE_GOOD;
         }
@@ -229,6 +336,7 @@ shutdownBrokerConnection(MQTTBrokerConnection *bc) {
     if(bc->tcpConnectionState == UA_CONNECTIONSTATE_ESTABLISHED) {
         mqtt_disconnect(&bc->client);
         __mqtt_send(&bc->client);
+        flushSendQueue(bc);
     }
 
     /* Close the TCP connection -> callback in the next el iteration */
@@ -262,23 +370,224 @@ MQTT_eventSourceStop(UA_ConnectionManager *cm) {
 
 static UA_StatusCode
 MQTT_eventSourceDelete(UA_ConnectionManager *cm) {
+    MQTTConnectionManager *mcm = (MQTTConnectionManager*)cm;
+    if(mcm->flushScheduled)
+        cm->eventSource.eventLoop->removeDelayedCallback(cm->eventSource.eventLoop,
+                                                         &mcm->flushCallback);
     UA_String_clear(&cm->eventSource.name);
     UA_free(cm);
     return UA_STATUSCODE_GOOD;
 }
 
+/* The network buffers are allocated from the TCP ConnectionManager. So that
+ * QoS0 payloads can be handed to TCP without copying. */
 static UA_StatusCode
 MQTT_allocNetworkBuffer(UA_ConnectionManager *cm, uintptr_t connectionId,
                         UA_ByteString *buf, size_t bufSize) {
     UA_ConnectionManager *tcpCM = ((MQTTConnectionManager*)cm)->tcpCM;
-    return tcpCM->allocNetworkBuffer(tcpCM, connectionId, buf, bufSize);
+    return tcpCM->allocNetworkBuffer(tcpCM, connectionId / 1000, buf, bufSize);
 }
 
 static void
 MQTT_freeNetworkBuffer(UA_ConnectionManager *cm, uintptr_t connectionId,
                        UA_ByteString *buf) {
     UA_ConnectionManager *tcpCM = ((MQTTConnectionManager*)cm)->tcpCM;
-    tcpCM->freeNetworkBuffer(tcpCM, connectionId, buf);
+    tcpCM->freeNetworkBuffer(tcpCM, connectionId / 1000, buf);
+}
+
+/* Extract the next level of a topic name or filter. Levels are separated by
+ * '/' and can be empty. Returns false after the last level. */
+static UA_Boolean
+nextTopicLevel(const UA_String *topic, size_t *pos, UA_String *level) {
+    if(*pos > topic->length)
+        return false;
+    size_t end = *pos;
+    while(end < topic->length && topic->data[end] != '/')
+        end++;
+    level->data = &topic->data[*pos];
+    level->length = end - *pos;
+    *pos = end + 1;
+    return true;
+}
+
+static int
+cmpTopicLevel(const UA_String *a, const UA_String *b) {
+    if(a->length != b->length)
+        return (a->length < b->length) ? -1 : 1;
+    if(a->length == 0)
+        return 0;
+    return memcmp(a->data, b->data, a->length);
+}
+
+/* Binary search in the sorted children. Returns the position where the level
+ * is or would have to be inserted. */
+static size_t
+findTopicChild(const MQTTTopicNode *node, const UA_String *level, UA_Boolean *found) {
+    size_t lo = 0, hi = node->childrenSize;
+    while(lo < hi) {
+        size_t mid = lo + ((hi - lo) / 2);
+        int c = cmpTopicLevel(&node->children[mid]->level, level);
+        if(c == 0) {
+            *found = true;
+            return mid;
+        }
+        if(c < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    *found = false;
+    return lo;
+}
+
+static MQTTTopicNode *
+newTopicNode(MQTTTopicNode *parent, const UA_String *level) {
+    MQTTTopicNode *node = (MQTTTopicNode*)
+        UA_calloc(1, sizeof(MQTTTopicNode) + level->length);
+    if(!node)
+        return NULL;
+    node->parent = parent;
+    node->level.data = (UA_Byte*)&node[1];
+    node->level.length = level->length;
+    if(level->length > 0)
+        memcpy(node->level.data, level->data, level->length);
+    return node;
+}
+
+/* Remove nodes without subscribers and children up to the root */
+static void
+pruneTopicNode(MQTTTopicNode *node) {
+    while(node->parent && LIST_EMPTY(&node->subscribers) &&
+          node->childrenSize == 0 && !node->plus && !node->hash) {
+        MQTTTopicNode *parent = node->parent;
+        if(parent->plus == node) {
+            parent->plus = NULL;
+        } else if(parent->hash == node) {
+            parent->hash = NULL;
+        } else {
+            UA_Boolean found;
+            size_t i = findTopicChild(parent, &node->level, &found);
+            UA_assert(found && parent->children[i] == node);
+            parent->childrenSize--;
+            memmove(&parent->children[i], &parent->children[i+1],
+                    sizeof(MQTTTopicNode*) * (parent->childrenSize - i));
+            if(parent->childrenSize == 0) {
+                UA_free(parent->children);
+                parent->children = NULL;
+            }
+        }
+        UA_free(node);
+        node = parent;
+    }
+}
+
+/* Get or create the node for a topic filter */
+static MQTTTopicNode *
+addTopicNode(MQTTTopicNode *root, const UA_String *filter) {
+    MQTTTopicNode *node = root;
+    size_t pos = 0;
+    UA_String level;
+    while(nextTopicLevel(filter, &pos, &level)) {
+        /* Wildcards */
+        MQTTTopicNode **wildcard = NULL;
+        if(level.length == 1 && level.data[0] == '+')
+            wildcard = &node->plus;
+        else if(level.length == 1 && level.data[0] == '#')
+            wildcard = &node->hash;
+        if(wildcard) {
+            if(!*wildcard && !(*wildcard = newTopicNode(node, &level)))
+                goto error;
+            node = *wildcard;
+            continue;
+        }
+
+        /* Existing child */
+        UA_Boolean found;
+        size_t i = findTopicChild(node, &level, &found);
+        if(found) {
+            node = node->children[i];
+            continue;
+        }
+
+        /* Insert a new child at the sorted position */
+        MQTTTopicNode *child = newTopicNode(node, &level);
+        if(!child)
+            goto error;
+        MQTTTopicNode **children = (MQTTTopicNode**)
+            UA_realloc(node->children, sizeof(MQTTTopicNode*) * (node->childrenSize + 1));
+        if(!children) {
+            UA_free(child);
+            goto error;
+        }
+        memmove(&children[i+1], &children[i],
+                sizeof(MQTTTopicNode*) * (node->childrenSize - i));
+        children[i] = child;
+        node->children = children;
+        node->childrenSize++;
+        node = child;
+    }
+    return node;
+
+ error:
+    pruneTopicNode(node);
+    return NULL;
+}
+
+static void
+notifyTopicSubscribers(MQTTBrokerConnection *bc, MQTTTopicNode *node,
+                       const UA_KeyValueMap *kvm, const UA_ByteString msg) {
+    MQTTTopicConnection *tc;
+    LIST_FOREACH(tc, &node->subscribers, subscriberNext) {
+        UA_LOG_DEBUG(bc->mcm->cm.eventSource.eventLoop->logger,
+                     UA_LOGCATEGORY_NETWORK, "MQTT %u\t| Received a message of "
+                     "%u bytes", (unsigned)tc->topicConnectionId, (unsigned)msg.length);
+
+        /* Notify the appliation that the connection is now established. The
+         * only way to know about this is to receive the first message for the
+         * topic (MQTT-C recieves a SUBACK message but does not forward that
+         * information). */
+        if(tc->topicConnectionState != UA_CONNECTIONSTATE_ESTABLISHED) {
+            tc->topicConnectionState = UA_CONNECTIONSTATE_ESTABLISHED;
+            tc->callback(&bc->mcm->cm, tc->topicConnectionId,
+                         tc->application, &tc->context,
+                         UA_CONNECTIONSTATE_ESTABLISHED, kvm,
+                         UA_BYTESTRING_NULL);
+        }
+
+        /* Forward the received message */
+        tc->callback(&bc->mcm->cm, tc->topicConnectionId, tc->application,
+                     &tc->context, UA_CONNECTIONSTATE_ESTABLISHED, kvm, msg);
+    }
+}
+
+/* Walk the trie along the levels of the topic name. Every node is reached at
+ * most once. So every subscriber is notified at most once per message. */
+static void
+dispatchPublish(MQTTBrokerConnection *bc, MQTTTopicNode *node,
+                const UA_String *topic, size_t pos,
+                const UA_KeyValueMap *kvm, const UA_ByteString msg) {
+    /* Topics starting with '$' are not matched by wildcards on the first
+     * level (MQTT 3.1.1, Section 4.7.2) */
+    UA_Boolean matchWildcards =
+        (node->parent || topic->length == 0 || topic->data[0] != '$');
+
+    /* The multi-level wildcard also matches the parent level */
+    if(node->hash && matchWildcards)
+        notifyTopicSubscribers(bc, node->hash, kvm, msg);
+
+    UA_String level;
+    if(!nextTopicLevel(topic, &pos, &level)) {
+        notifyTopicSubscribers(bc, node, kvm, msg);
+        return;
+    }
+
+    if(node->plus && matchWildcards)
+        dispatchPublish(bc, node->plus, topic, pos, kvm, msg);
+
+    UA_Boolean found;
+    size_t i = findTopicChild(node, &level, &found);
+    if(found)
+        dispatchPublish(bc, node->children[i], topic, pos, kvm, msg);
 }
 
 static void
@@ -287,13 +596,20 @@ removeTopicConnection(MQTTTopicConnection *tc) {
                 UA_LOGCATEGORY_NETWORK, "MQTT %u\t| Closing the connection",
                 (unsigned)tc->topicConnectionId);
 
-    /* Send the UNSUBSCRIBE packet */
+    /* Remove from the subscription trie. Send the UNSUBSCRIBE packet only if
+     * no other connection is subscribed with the same topic filter. */
     MQTTBrokerConnection *bc = tc->brokerConnection;
-    if(tc->subscribe &&
-       tc->topicConnectionState == UA_CONNECTIONSTATE_ESTABLISHED &&
-       bc->tcpConnectionState == UA_CONNECTIONSTATE_ESTABLISHED) {
-        mqtt_unsubscribe(&bc->client, (const char*)tc->topic.data);
-        __mqtt_send(&bc->client);
+    MQTTTopicNode *node = tc->topicNode;
+    if(node) {
+        LIST_REMOVE(tc, subscriberNext);
+        tc->topicNode = NULL;
+        if(LIST_EMPTY(&node->subscribers) &&
+           tc->topicConnectionState == UA_CONNECTIONSTATE_ESTABLISHED &&
+           bc->tcpConnectionState == UA_CONNECTIONSTATE_ESTABLISHED) {
+            mqtt_unsubscribe(&bc->client, (const char*)tc->topic.data);
+            __mqtt_send(&bc->client);
+        }
+        pruneTopicNode(node);
     }
 
     /* Remove from linked list */
@@ -348,7 +664,13 @@ removeBrokerConnection(MQTTBrokerConnection *bc) {
         removeTopicConnection(tc);
     }
 
+    /* Release packets that were not sent */
+    UA_ConnectionManager *tcpCM = mcm->tcpCM;
+    for(size_t i = 0; i < bc->sendQueueSize; i++)
+        tcpCM->freeNetworkBuffer(tcpCM, bc->tcpConnectionId, &bc->sendQueue[i]);
+
     UA_KeyValueMap_clear(&bc->params);
+    UA_free(bc->topics.children); /* Pruned with the last topic connection */
     UA_free(bc->client.recv_buffer.mem_start);
     UA_free(bc->client.mq.mem_start);
     UA_free(bc);
@@ -364,9 +686,12 @@ static MQTTBrokerConnection *
 findIdenticalBrokerConnection(MQTTConnectionManager *mcm, const UA_KeyValueMap *kvm) {
     MQTTBrokerConnection *bc;
     LIST_FOREACH(bc, &mcm->connections, next) {
+        /* Don't attach to a connection that is going away */
+        if(bc->tcpConnectionState == UA_CONNECTIONSTATE_CLOSING)
+            continue;
         UA_Boolean found = true;
         for(size_t i = 0; i < MQTT_BROKERPARAMETERSSIZE; i++) {
-            const UA_Variant *v1 = UA_KeyValueMap_get(kvm, MQTTConnectionParameters[i].name);
+            const UA_Variant *v1 = UA_KeyValueMap_get(&bc->params, MQTTConnectionParameters[i].name);
             const UA_Variant *v2 = UA_KeyValueMap_get(kvm, MQTTConnectionParameters[i].name);
             if(v1 == v2)
                 continue;
@@ -433,32 +758,8 @@ MQTTPublishResponseCallback(void** state, struct mqtt_response_publish *publish)
     UA_Variant_setScalar(&kvp[1].value, &subscribe, &UA_TYPES[UA_TYPES_BOOLEAN]);
     UA_KeyValueMap kvm = {2, kvp};
 
-    /* Notify all matching topic connections */
-    MQTTTopicConnection *tc;
-    LIST_FOREACH(tc, &bc->topicConnections, next) {
-        if(!tc->subscribe || !UA_String_equal(&topic, &tc->topic))
-            continue;
-
-        UA_LOG_DEBUG(tc->brokerConnection->mcm->cm.eventSource.eventLoop->logger,
-                     UA_LOGCATEGORY_NETWORK, "MQTT %u\t| Received a message of "
-                     "%u bytes", (unsigned)tc->topicConnectionId, (unsigned)msg.length);
-
-        /* Notify the appliation that the connection is now established. The
-         * only way to know about this is to receive the first message for the
-         * topic (MQTT-C recieves a SUBACK message but does not forward that
-         * information). */
-        if(tc->topicConnectionState != UA_CONNECTIONSTATE_ESTABLISHED) {
-            tc->topicConnectionState = UA_CONNECTIONSTATE_ESTABLISHED;
-            tc->callback(&bc->mcm->cm, tc->topicConnectionId,
-                         tc->application, &tc->context,
-                         UA_CONNECTIONSTATE_ESTABLISHED, &kvm,
-                         UA_BYTESTRING_NULL);
-        }
-
-        /* Forward the received message */
-        tc->callback(&bc->mcm->cm, tc->topicConnectionId, tc->application,
-                     &tc->context, UA_CONNECTIONSTATE_ESTABLISHED, &kvm, msg);
-    }
+    /* Notify all topic connections with a matching topic filter */
+    dispatchPublish(bc, &bc->topics, &topic, 0, &kvm, msg);
 }
 
 static void
@@ -499,7 +800,7 @@ MQTTNetworkCallback(UA_ConnectionManager *tcpCM, uintptr_t connectionId,
         /* Initialize the MQTT client. We have to call mqtt_connect right afterward.
          * Otherwise the client lock is not released. */
         mqtt_init(&bc->client, bc,
-                  (uint8_t*)UA_calloc(1,1024), 1024,
+                  (uint8_t*)UA_calloc(1, MQTT_SENDBUFFER_SIZE), MQTT_SENDBUFFER_SIZE,
                   (uint8_t*)UA_calloc(1,1024), 1024,
                   MQTTPublishResponseCallback);
 
@@ -520,7 +821,7 @@ MQTTNetworkCallback(UA_ConnectionManager *tcpCM, uintptr_t connectionId,
                 /* Subscribe-connections call mqtt_subscribe but wait until the
                  * first received message to signal that they successfully
                  * opened */
-                err = mqtt_subscribe(&bc->client, (const char*)tc->topic.data, 0);
+                err = mqtt_subscribe(&bc->client, (const char*)tc->topic.data, tc->qos);
                 if(err == MQTT_OK)
                     err = (enum MQTTErrors)__mqtt_send(&bc->client);
                 if(err != MQTT_OK)
@@ -616,6 +917,14 @@ createBrokerConnection(MQTTConnectionManager *mcm, const UA_KeyValueMap *params,
     if(keepAlive && *keepAlive > 0)
         bc->keepalive = *keepAlive;
 
+    const UA_UInt16 *maxInflight = (const UA_UInt16*)
+        UA_KeyValueMap_getScalar(params,
+                                 UA_QUALIFIEDNAME(0, "max-inflight"),
+                                 &UA_TYPES[UA_TYPES_UINT16]);
+    bc->maxInflight = MQTT_INFLIGHT_DEFAULT;
+    if(maxInflight && *maxInflight > 0)
+        bc->maxInflight = *maxInflight;
+
     /* Open the Connection. This also sets the broker connection id to the TCP id. */
     UA_KeyValuePair tcpParams[3];
     tcpParams[0].key = UA_QUALIFIEDNAME(0, "address");
@@ -671,6 +980,11 @@ createTopicConnection(MQTTConnectionManager *mcm, MQTTBrokerConnection *bc,
                                  &UA_TYPES[UA_TYPES_STRING]);
     if(topic->length == 0)
         return NULL;
+    const UA_Byte *qos = (const UA_Byte*)
+        UA_KeyValueMap_getScalar(params, UA_QUALIFIEDNAME(0, "qos"),
+                                 &UA_TYPES[UA_TYPES_BYTE]);
+    if(qos && *qos > 1)
+        return NULL; /* QoS2 is not supported */
 
     MQTTTopicConnection *tc = (MQTTTopicConnection*)
         UA_calloc(1, sizeof(MQTTTopicConnection));
@@ -682,6 +996,7 @@ createTopicConnection(MQTTConnectionManager *mcm, MQTTBrokerConnection *bc,
     tc->brokerConnection = bc;
     tc->topicConnectionId = (bc->tcpConnectionId * 1000) + (++bc->lastTopicConnectionId);
     tc->subscribe = subscribe;
+    tc->qos = (qos) ? *qos : 0;
 
     /* Make a null-terminated copy of the topic string to forward to the MQTT client. */
     tc->topic.data = (UA_Byte*)UA_malloc(topic->length + 1);
@@ -693,14 +1008,28 @@ createTopicConnection(MQTTConnectionManager *mcm, MQTTBrokerConnection *bc,
     tc->topic.data[topic->length] = 0;
     tc->topic.length = topic->length;
 
+    /* Index the subscription */
+    if(subscribe) {
+        tc->topicNode = addTopicNode(&bc->topics, &tc->topic);
+        if(!tc->topicNode) {
+            UA_String_clear(&tc->topic);
+            UA_free(tc);
+            return NULL;
+        }
+        LIST_INSERT_HEAD(&tc->topicNode->subscribers, tc, subscriberNext);
+    }
+
     /* Subscribe the MQTT client if the client is already connected. Otherwise
      * defer mqtt_subscribe until the TCP socket is fully opened and we
      * connect. */
     if(bc->tcpConnectionState == UA_CONNECTIONSTATE_ESTABLISHED) {
         tc->topicConnectionState = UA_CONNECTIONSTATE_ESTABLISHED;
         if(subscribe) {
-            enum MQTTErrors err = mqtt_subscribe(&bc->client, (const char*)topic->data, 0);
+            enum MQTTErrors err = mqtt_subscribe(&bc->client, (const char*)tc->topic.data,
+                                                 tc->qos);
             if(err != MQTT_OK) {
+                LIST_REMOVE(tc, subscriberNext);
+                pruneTopicNode(tc->topicNode);
                 UA_String_clear(&tc->topic);
                 UA_free(tc);
                 return NULL;
@@ -777,20 +1106,72 @@ MQTT_openConnection(UA_ConnectionManager *cm, const UA_KeyValueMap *params,
     return UA_STATUSCODE_GOOD;
 }
 
+/* Number of QoS1 publishes not yet acknowledged by the broker */
+static size_t
+inflightPublishes(MQTTBrokerConnection *bc, size_t *bytes) {
+    size_t count = 0;
+    ssize_t len = mqtt_mq_length(&bc->client.mq);
+    for(ssize_t i = 0; i < len; i++) {
+        struct mqtt_queued_message *m = mqtt_mq_get(&bc->client.mq, i);
+        if(m->control_type != MQTT_CONTROL_PUBLISH || m->state == MQTT_QUEUED_COMPLETE)
+            continue;
+        count++;
+        if(bytes)
+            *bytes += m->size;
+    }
+    return count;
+}
+
+/* QoS0 publishes are not retained for retransmission. Encode the fixed header
+ * and the topic in a small buffer and send the payload buffer as-is after it.
+ * So large messages are neither copied nor limited by the MQTT-C send
+ * buffer. */
 static UA_StatusCode
-MQTT_sendWithConnection(UA_ConnectionManager *cm, uintptr_t connectionId,
-                        const UA_KeyValueMap *params,
-                        UA_ByteString *buf) {
-    MQTTConnectionManager *mcm = (MQTTConnectionManager*)cm;
-    MQTTTopicConnection *tc = findTopicConnection(mcm, connectionId);
-    if(!tc) {
-        UA_ByteString_clear(buf);
-        return UA_STATUSCODE_BADINTERNALERROR;
+enqueuePublish(MQTTTopicConnection *tc, UA_ByteString *payload) {
+    MQTTBrokerConnection *bc = tc->brokerConnection;
+    UA_ConnectionManager *tcpCM = bc->mcm->tcpCM;
+    size_t remaining = 2 + tc->topic.length + payload->length;
+    if(remaining > 268435455) { /* Maximum of the variable length encoding */
+        tcpCM->freeNetworkBuffer(tcpCM, bc->tcpConnectionId, payload);
+        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+    }
+
+    UA_ByteString header;
+    UA_StatusCode res = tcpCM->allocNetworkBuffer(tcpCM, bc->tcpConnectionId, &header,
+                                                  1 + 4 + 2 + tc->topic.length);
+    if(res != UA_STATUSCODE_GOOD) {
+        tcpCM->freeNetworkBuffer(tcpCM, bc->tcpConnectionId, payload);
+        return res;
     }
 
+    UA_Byte *pos = header.data;
+    *pos++ = (UA_Byte)(MQTT_CONTROL_PUBLISH << 4);
+    do {
+        UA_Byte b = (UA_Byte)(remaining & 0x7f);
+        remaining >>= 7;
+        if(remaining > 0)
+            b |= 0x80;
+        *pos++ = b;
+    } while(remaining > 0);
+    *pos++ = (UA_Byte)(tc->topic.length >> 8);
+    *pos++ = (UA_Byte)(tc->topic.length & 0xff);
+    memcpy(pos, tc->topic.data, tc->topic.length);
+    header.length = (size_t)(pos - header.data) + tc->topic.length;
+
+    /* Header and payload must be sent in the same batch */
+    if(bc->sendQueueSize + 2 > MQTT_SENDQUEUE_MAX)
+        flushSendQueue(bc);
+    enqueueSend(bc, &header);
+    enqueueSend(bc, payload);
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+publish(MQTTTopicConnection *tc, UA_ByteString *buf) {
     MQTTBrokerConnection *bc = tc->brokerConnection;
+    UA_ConnectionManager *tcpCM = bc->mcm->tcpCM;
     if(bc->tcpConnectionState != UA_CONNECTIONSTATE_ESTABLISHED) {
-        UA_ByteString_clear(buf);
+        tcpCM->freeNetworkBuffer(tcpCM, bc->tcpConnectionId, buf);
         return UA_STATUSCODE_BADCONNECTIONREJECTED;
     }
 
@@ -799,14 +1180,80 @@ MQTT_sendWithConnection(UA_ConnectionManager *cm, uintptr_t connectionId,
                  "a message with %u bytes", (unsigned)tc->topicConnectionId,
                  (char*)tc->topic.data, (unsigned)buf->length);
 
+    if(tc->qos == 0 && batchSend(bc))
+        return enqueuePublish(tc, buf);
+
+    /* Backpressure if too many QoS1 publishes await their PUBACK. The
+     * acknowledgements are processed in batches as they arrive. */
+    if(tc->qos > 0 && inflightPublishes(bc, NULL) >= bc->maxInflight) {
+        UA_LOG_WARNING(bc->mcm->cm.eventSource.eventLoop->logger,
+                       UA_LOGCATEGORY_NETWORK, "MQTT %u\t| Dropping a message: "
+                       "%u publishes are awaiting acknowledgement",
+                       (unsigned)tc->topicConnectionId, (unsigned)bc->maxInflight);
+        tcpCM->freeNetworkBuffer(tcpCM, bc->tcpConnectionId, buf);
+        return UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+    }
+
+    /* MQTT-C copies the message into the send buffer and retains it until it
+     * is acknowledged */
+    uint8_t flags = (tc->qos > 0) ? MQTT_PUBLISH_QOS_1 : MQTT_PUBLISH_QOS_0;
     enum MQTTErrors res = mqtt_publish(&bc->client, (const char*)tc->topic.data,
-                                       buf->data, buf->length, 0);
+                                       buf->data, buf->length, flags);
     if(UA_LIKELY(res == MQTT_OK))
         res = (enum MQTTErrors)__mqtt_send(&bc->client);
-    UA_ByteString_clear(buf);
+    tcpCM->freeNetworkBuffer(tcpCM, bc->tcpConnectionId, buf);
     return (res == MQTT_OK) ? UA_STATUSCODE_GOOD : UA_STATUSCODE_BADINTERNALERROR;
 }
 
+static UA_StatusCode
+MQTT_sendWithConnection(UA_ConnectionManager *cm, uintptr_t connectionId,
+                        const UA_KeyValueMap *params,
+                        UA_ByteString *buf) {
+    MQTTConnectionManager *mcm = (MQTTConnectionManager*)cm;
+    MQTTTopicConnection *tc = findTopicConnection(mcm, connectionId);
+    if(!tc) {
+        MQTT_freeNetworkBuffer(cm, connectionId, buf);
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+    return publish(tc, buf);
+}
+
+/* Every buffer is a separate publish. They end up in the same batch towards
+ * the broker. */
+static UA_StatusCode
+MQTT_sendWithConnectionV(UA_ConnectionManager *cm, uintptr_t connectionId,
+                         const UA_KeyValueMap *params,
+                         UA_ByteString *bufs, size_t bufsSize) {
+    MQTTConnectionManager *mcm = (MQTTConnectionManager*)cm;
+    MQTTTopicConnection *tc = findTopicConnection(mcm, connectionId);
+    UA_StatusCode res = (tc) ? UA_STATUSCODE_GOOD : UA_STATUSCODE_BADINTERNALERROR;
+    for(size_t i = 0; i < bufsSize; i++) {
+        if(res != UA_STATUSCODE_GOOD) {
+            MQTT_freeNetworkBuffer(cm, connectionId, &bufs[i]);
+            continue;
+        }
+        res = publish(tc, &bufs[i]);
+    }
+    return res;
+}
+
+/* Bytes queued for the next batch, QoS1 publishes awaiting their PUBACK and
+ * the send queue of the underlying TCP connection */
+static size_t
+MQTT_getSendQueueSize(UA_ConnectionManager *cm, uintptr_t connectionId) {
+    MQTTConnectionManager *mcm = (MQTTConnectionManager*)cm;
+    MQTTBrokerConnection *bc = findBrokerConnection(mcm, connectionId);
+    if(!bc)
+        return 0;
+    size_t bytes = bc->sendQueueBytes;
+    if(bc->tcpConnectionState == UA_CONNECTIONSTATE_ESTABLISHED)
+        inflightPublishes(bc, &bytes);
+    UA_ConnectionManager *tcpCM = mcm->tcpCM;
+    if(tcpCM->getSendQueueSize)
+        bytes += tcpCM->getSendQueueSize(tcpCM, bc->tcpConnectionId);
+    return bytes;
+}
+
 static UA_StatusCode
 MQTT_shutdownConnection(UA_ConnectionManager *cm, uintptr_t connectionId) {
     MQTTConnectionManager *mcm = (MQTTConnectionManager*)cm;
@@ -856,6 +1303,7 @@ UA_ConnectionManager_new_MQTT(const UA_String eventSourceName) {
     cm->cm.allocNetworkBuffer = MQTT_allocNetworkBuffer;
     cm->cm.freeNetworkBuffer = MQTT_freeNetworkBuffer;
     cm->cm.sendWithConnection = MQTT_sendWithConnection;
+    cm->cm.getSendQueueSize = MQTT_getSendQueueSize;
     cm->cm.closeConnection = MQTT_shutdownConnection;
     return &cm->cm;
 }
@@ -0,0 +1,231 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "profiler.h"
+#include "../../deps/mp_printf.h"
+
+void
+UA_EventLoopProfiler_init(UA_EventLoopProfiler *p) {
+    memset(p, 0, sizeof(UA_EventLoopProfiler));
+    UA_LOCK_INIT(&p->profilerMutex);
+    UA_LOCK_SETRANK(&p->profilerMutex, UA_LOCKRANK_PROFILER);
+}
+
+void
+UA_EventLoopProfiler_clear(UA_EventLoopProfiler *p) {
+    UA_free(p->entries);
+    UA_free(p->trace);
+#if UA_MULTITHREADING >= 100
+    UA_LOCK_DESTROY(&p->profilerMutex);
+#endif
+    memset(p, 0, sizeof(UA_EventLoopProfiler));
+}
+
+UA_StatusCode
+UA_EventLoopProfiler_enable(UA_EventLoopProfiler *p, UA_DateTime now,
+                            size_t traceSize) {
+    UA_EventLoopTraceEvent *trace = NULL;
+    if(traceSize > 0) {
+        trace = (UA_EventLoopTraceEvent*)
+            UA_malloc(traceSize * sizeof(UA_EventLoopTraceEvent));
+        if(!trace)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+
+    UA_LOCK(&p->profilerMutex);
+    UA_free(p->trace);
+    p->trace = trace;
+    p->traceSize = traceSize;
+    p->traceCount = 0;
+    p->traceNext = 0;
+    p->entriesSize = 0; /* Keep the memory of the entries */
+    p->startTime = now;
+    p->enabled = true;
+    UA_UNLOCK(&p->profilerMutex);
+    return UA_STATUSCODE_GOOD;
+}
+
+void
+UA_EventLoopProfiler_disable(UA_EventLoopProfiler *p) {
+    UA_LOCK(&p->profilerMutex);
+    p->enabled = false;
+    UA_UNLOCK(&p->profilerMutex);
+}
+
+/* Binary search for the entry. Returns the insert position if not found. */
+static size_t
+findEntry(const UA_EventLoopProfiler *p, UA_EventLoopProfileType type,
+          UA_UInt64 id, UA_Boolean *found) {
+    size_t lo = 0, hi = p->entriesSize;
+    while(lo < hi) {
+        size_t mid = lo + ((hi - lo) / 2);
+        const UA_EventLoopProfileEntry *e = &p->entries[mid];
+        if(e->type < type || (e->type == type && e->id < id)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    *found = (lo < p->entriesSize && p->entries[lo].type == type &&
+              p->entries[lo].id == id);
+    return lo;
+}
+
+static UA_EventLoopProfileEntry *
+getEntry(UA_EventLoopProfiler *p, UA_EventLoopProfileType type, UA_UInt64 id) {
+    UA_Boolean found;
+    size_t pos = findEntry(p, type, id, &found);
+    if(found)
+        return &p->entries[pos];
+
+    /* Grow the array */
+    if(p->entriesSize == p->entriesCapacity) {
+        size_t newCapacity = (p->entriesCapacity == 0) ?
+            16 : p->entriesCapacity * 2;
+        UA_EventLoopProfileEntry *entries = (UA_EventLoopProfileEntry*)
+            UA_realloc(p->entries, newCapacity * sizeof(UA_EventLoopProfileEntry));
+        if(!entries)
+            return NULL;
+        p->entries = entries;
+        p->entriesCapacity = newCapacity;
+    }
+
+    /* Insert at the sorted position */
+    memmove(&p->entries[pos + 1], &p->entries[pos],
+            (p->entriesSize - pos) * sizeof(UA_EventLoopProfileEntry));
+    p->entriesSize++;
+    UA_EventLoopProfileEntry *e = &p->entries[pos];
+    memset(e, 0, sizeof(UA_EventLoopProfileEntry));
+    e->type = type;
+    e->id = id;
+    return e;
+}
+
+void
+UA_EventLoopProfiler_record(UA_EventLoopProfiler *p,
+                            UA_EventLoopProfileType type, UA_UInt64 id,
+                            UA_DateTime start, UA_DateTime end,
+                            UA_Boolean overrun) {
+    UA_LOCK(&p->profilerMutex);
+    if(!p->enabled) {
+        UA_UNLOCK(&p->profilerMutex);
+        return;
+    }
+
+    UA_DateTime duration = end - start;
+    if(duration < 0)
+        duration = 0;
+
+    /* Aggregate. Drop the measurement if out of memory. */
+    UA_EventLoopProfileEntry *e = getEntry(p, type, id);
+    if(e) {
+        e->invocations++;
+        if(overrun)
+            e->overruns++;
+        e->timeTotal += duration;
+        e->timeLast = duration;
+        if(duration > e->timeMax)
+            e->timeMax = duration;
+    }
+
+    /* Add to the ring buffer */
+    if(p->traceSize > 0) {
+        UA_EventLoopTraceEvent *ev = &p->trace[p->traceNext];
+        ev->type = type;
+        ev->id = id;
+        ev->start = start;
+        ev->duration = duration;
+        p->traceNext = (p->traceNext + 1) % p->traceSize;
+        if(p->traceCount < p->traceSize)
+            p->traceCount++;
+    }
+
+    UA_UNLOCK(&p->profilerMutex);
+}
+
+UA_StatusCode
+UA_EventLoopProfiler_getEntries(UA_EventLoopProfiler *p,
+                                UA_EventLoopProfileEntry **entries,
+                                size_t *entriesSize) {
+    UA_LOCK(&p->profilerMutex);
+    *entries = NULL;
+    *entriesSize = 0;
+    if(p->entriesSize > 0) {
+        *entries = (UA_EventLoopProfileEntry*)
+            UA_malloc(p->entriesSize * sizeof(UA_EventLoopProfileEntry));
+        if(!*entries) {
+            UA_UNLOCK(&p->profilerMutex);
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        }
+        memcpy(*entries, p->entries,
+               p->entriesSize * sizeof(UA_EventLoopProfileEntry));
+        *entriesSize = p->entriesSize;
+    }
+    UA_UNLOCK(&p->profilerMutex);
+    return UA_STATUSCODE_GOOD;
+}
+
+static const char *profileTypeNames[4] = {"iteration", "timer", "delayed", "fd"};
+
+/* Microseconds with one decimal from the 100ns DateTime resolution */
+#define TRACE_USEC(t) (long long)((t) / 10), (int)((t) % 10)
+
+/* Upper bound for the length of one printed event */
+#define TRACE_EVENT_MAXLEN 160
+
+UA_StatusCode
+UA_EventLoopProfiler_printTrace(UA_EventLoopProfiler *p, UA_String *output) {
+    UA_LOCK(&p->profilerMutex);
+
+    size_t size = 64 + (p->traceCount * TRACE_EVENT_MAXLEN);
+    char *buf = (char*)UA_malloc(size);
+    if(!buf) {
+        UA_UNLOCK(&p->profilerMutex);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+
+    size_t pos = (size_t)
+        mp_snprintf(buf, size, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+    /* Print from the oldest to the newest event */
+    size_t first = (p->traceNext + p->traceSize - p->traceCount) %
+        (p->traceSize > 0 ? p->traceSize : 1);
+    for(size_t i = 0; i < p->traceCount; i++) {
+        const UA_EventLoopTraceEvent *ev = &p->trace[(first + i) % p->traceSize];
+        UA_DateTime ts = ev->start - p->startTime;
+        if(ts < 0)
+            ts = 0;
+        const char *name = profileTypeNames[ev->type];
+        const char *sep = (i > 0) ? "," : "";
+        if(ev->type == UA_EVENTLOOPPROFILETYPE_ITERATION) {
+            pos += (size_t)
+                mp_snprintf(&buf[pos], size - pos,
+                            "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\","
+                            "\"ts\":%lld.%d,\"dur\":%lld.%d,\"pid\":1,\"tid\":1}",
+                            sep, name, name,
+                            TRACE_USEC(ts), TRACE_USEC(ev->duration));
+        } else if(ev->type == UA_EVENTLOOPPROFILETYPE_DELAYED) {
+            pos += (size_t)
+                mp_snprintf(&buf[pos], size - pos,
+                            "%s\n{\"name\":\"%s 0x%llx\",\"cat\":\"%s\",\"ph\":\"X\","
+                            "\"ts\":%lld.%d,\"dur\":%lld.%d,\"pid\":1,\"tid\":1}",
+                            sep, name, (unsigned long long)ev->id, name,
+                            TRACE_USEC(ts), TRACE_USEC(ev->duration));
+        } else {
+            pos += (size_t)
+                mp_snprintf(&buf[pos], size - pos,
+                            "%s\n{\"name\":\"%s %llu\",\"cat\":\"%s\",\"ph\":\"X\","
+                            "\"ts\":%lld.%d,\"dur\":%lld.%d,\"pid\":1,\"tid\":1}",
+                            sep, name, (unsigned long long)ev->id, name,
+                            TRACE_USEC(ts), TRACE_USEC(ev->duration));
+        }
+    }
+    pos += (size_t)mp_snprintf(&buf[pos], size - pos, "\n]}\n");
+    UA_UNLOCK(&p->profilerMutex);
+
+    output->data = (UA_Byte*)buf;
+    output->length = pos;
+    return UA_STATUSCODE_GOOD;
+}
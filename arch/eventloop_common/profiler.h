@@ -0,0 +1,89 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef UA_EVENTLOOP_PROFILER_H_
+#define UA_EVENTLOOP_PROFILER_H_
+
+#include <open62541/types.h>
+#include <open62541/plugin/eventloop.h>
+
+_UA_BEGIN_DECLS
+
+/* Profiler for the EventLoop implementations. Not part of the public API.
+ *
+ * The EventLoop measures the execution of its callbacks and records the
+ * measurements in the profiler. The profiler aggregates them per callback
+ * (sorted array with binary search) and keeps the last events in a ring
+ * buffer for the trace output.
+ *
+ * The profiler is protected by its own mutex. The mutex is only taken for
+ * recording and reading and never held while calling out. So the profiler can
+ * be used from every context within the EventLoop. The enabled flag is checked
+ * without the mutex before measuring, so that a disabled profiler has no
+ * overhead except for the flag check. */
+
+typedef struct {
+    UA_EventLoopProfileType type;
+    UA_UInt64 id;
+    UA_DateTime start;
+    UA_DateTime duration;
+} UA_EventLoopTraceEvent;
+
+typedef struct {
+    volatile UA_Boolean enabled;
+    UA_DateTime startTime; /* Time when profiling was enabled. The trace
+                            * timestamps are relative to it. */
+
+    /* Aggregated measurements, sorted by type and id */
+    UA_EventLoopProfileEntry *entries;
+    size_t entriesSize;
+    size_t entriesCapacity;
+
+    /* Ring buffer of the last events */
+    UA_EventLoopTraceEvent *trace;
+    size_t traceSize;  /* Capacity of the ring buffer */
+    size_t traceCount; /* Number of events in the ring buffer */
+    size_t traceNext;  /* Position of the next event */
+
+#if UA_MULTITHREADING >= 100
+    UA_Lock profilerMutex;
+#endif
+} UA_EventLoopProfiler;
+
+void
+UA_EventLoopProfiler_init(UA_EventLoopProfiler *p);
+
+void
+UA_EventLoopProfiler_clear(UA_EventLoopProfiler *p);
+
+/* Reset the profile and start recording. Keeps the last traceSize events for
+ * the trace output. */
+UA_StatusCode
+UA_EventLoopProfiler_enable(UA_EventLoopProfiler *p, UA_DateTime now,
+                            size_t traceSize);
+
+/* Stop recording. The profile is kept for reading. */
+void
+UA_EventLoopProfiler_disable(UA_EventLoopProfiler *p);
+
+/* Record one execution. Does nothing if the profiler is disabled. */
+void
+UA_EventLoopProfiler_record(UA_EventLoopProfiler *p,
+                            UA_EventLoopProfileType type, UA_UInt64 id,
+                            UA_DateTime start, UA_DateTime end,
+                            UA_Boolean overrun);
+
+UA_StatusCode
+UA_EventLoopProfiler_getEntries(UA_EventLoopProfiler *p,
+                                UA_EventLoopProfileEntry **entries,
+                                size_t *entriesSize);
+
+/* Print the events of the ring buffer as Chrome trace JSON */
+UA_StatusCode
+UA_EventLoopProfiler_printTrace(UA_EventLoopProfiler *p, UA_String *output);
+
+_UA_END_DECLS
+
+#endif /* UA_EVENTLOOP_PROFILER_H_ */
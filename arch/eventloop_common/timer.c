@@ -22,8 +22,13 @@ cmpId(const UA_UInt64 *a, const UA_UInt64 *b) {
     return (*a < *b) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
 }
 
+static btree_rank
+rankId(const UA_UInt64 *id) {
+    return *id;
+}
+
 ZIP_FUNCTIONS(UA_TimerTree, UA_TimerEntry, treeEntry, UA_DateTime, nextTime, cmpDateTime)
-ZIP_FUNCTIONS(UA_TimerIdTree, UA_TimerEntry, idTreeEntry, UA_UInt64, id, cmpId)
+BTREE_FUNCTIONS(UA_TimerIdTree, UA_TimerEntry, UA_UInt64, id, cmpId, rankId)
 
 static UA_DateTime
 calculateNextTime(UA_DateTime currentTime, UA_DateTime baseTime,
@@ -47,6 +52,7 @@ void
 UA_Timer_init(UA_Timer *t) {
     memset(t, 0, sizeof(UA_Timer));
     UA_LOCK_INIT(&t->timerMutex);
+    UA_LOCK_SETRANK(&t->timerMutex, UA_LOCKRANK_TIMER);
 }
 
 /* Adding repeated callbacks: Add an entry with the "nextTime" timestamp in the
@@ -95,10 +101,15 @@ UA_Timer_add(UA_Timer *t, UA_ApplicationCallback callback,
     /* Insert into the timer */
     UA_LOCK(&t->timerMutex);
     te->id = ++t->idCounter;
+    if(BTREE_INSERT(UA_TimerIdTree, &t->idTree, te) != 0) {
+        UA_UNLOCK(&t->timerMutex);
+        UA_free(te);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
     if(callbackId)
         *callbackId = te->id;
     ZIP_INSERT(UA_TimerTree, &t->tree, te);
-    ZIP_INSERT(UA_TimerIdTree, &t->idTree, te);
+    t->entriesCount++;
     UA_UNLOCK(&t->timerMutex);
 
     return UA_STATUSCODE_GOOD;
@@ -125,7 +136,7 @@ UA_Timer_modify(UA_Timer *t, UA_UInt64 callbackId,
     UA_LOCK(&t->timerMutex);
 
     /* Find timer entry based on id */
-    UA_TimerEntry *te = ZIP_FIND(UA_TimerIdTree, &t->idTree, &callbackId);
+    UA_TimerEntry *te = BTREE_FIND(UA_TimerIdTree, &t->idTree, &callbackId);
     if(!te) {
         UA_UNLOCK(&t->timerMutex);
         return UA_STATUSCODE_BADNOTFOUND;
@@ -154,7 +165,7 @@ UA_Timer_modify(UA_Timer *t, UA_UInt64 callbackId,
 void
 UA_Timer_remove(UA_Timer *t, UA_UInt64 callbackId) {
     UA_LOCK(&t->timerMutex);
-    UA_TimerEntry *te = ZIP_FIND(UA_TimerIdTree, &t->idTree, &callbackId);
+    UA_TimerEntry *te = BTREE_FIND(UA_TimerIdTree, &t->idTree, &callbackId);
     if(!te) {
         UA_UNLOCK(&t->timerMutex);
         return;
@@ -165,8 +176,9 @@ UA_Timer_remove(UA_Timer *t, UA_UInt64 callbackId) {
      * processing. Do not edit the process tree while iterating over it. */
     UA_Boolean processing = (ZIP_REMOVE(UA_TimerTree, &t->tree, te) == NULL);
     if(!processing) {
-        ZIP_REMOVE(UA_TimerIdTree, &t->idTree, te);
+        BTREE_REMOVE(UA_TimerIdTree, &t->idTree, te);
         UA_free(te);
+        t->entriesCount--;
     } else {
         te->callback = NULL;
     }
@@ -186,15 +198,22 @@ processEntryCallback(void *context, UA_TimerEntry *te) {
 
     /* Execute the callback */
     if(te->callback) {
+        UA_TimerExecuteHook hook = t->executeHook;
+        void *hookContext = t->executeContext;
         UA_UNLOCK(&t->timerMutex);
-        te->callback(te->application, te->data);
+        if(hook)
+            hook(hookContext, te->id, te->nextTime, te->interval,
+                 te->callback, te->application, te->data);
+        else
+            te->callback(te->application, te->data);
         UA_LOCK(&t->timerMutex);
     }
 
     /* Remove the entry if marked for deletion or a "once" policy */
     if(!te->callback || te->timerPolicy == UA_TIMERPOLICY_ONCE) {
-        ZIP_REMOVE(UA_TimerIdTree, &t->idTree, te);
+        BTREE_REMOVE(UA_TimerIdTree, &t->idTree, te);
         UA_free(te);
+        t->entriesCount--;
         return NULL;
     }
 
@@ -259,6 +278,22 @@ UA_Timer_next(UA_Timer *t) {
     return next;
 }
 
+size_t
+UA_Timer_count(UA_Timer *t) {
+    UA_LOCK(&t->timerMutex);
+    size_t count = t->entriesCount;
+    UA_UNLOCK(&t->timerMutex);
+    return count;
+}
+
+void
+UA_Timer_setExecuteHook(UA_Timer *t, UA_TimerExecuteHook hook, void *context) {
+    UA_LOCK(&t->timerMutex);
+    t->executeHook = hook;
+    t->executeContext = context;
+    UA_UNLOCK(&t->timerMutex);
+}
+
 static void *
 freeEntryCallback(void *context, UA_TimerEntry *entry) {
     UA_free(entry);
@@ -269,10 +304,11 @@ void
 UA_Timer_clear(UA_Timer *t) {
     UA_LOCK(&t->timerMutex);
 
-    ZIP_ITER(UA_TimerIdTree, &t->idTree, freeEntryCallback, NULL);
+    BTREE_ITER(UA_TimerIdTree, &t->idTree, freeEntryCallback, NULL);
+    BTREE_CLEAR(UA_TimerIdTree, &t->idTree);
     t->tree.root = NULL;
-    t->idTree.root = NULL;
     t->idCounter = 0;
+    t->entriesCount = 0;
 
     UA_UNLOCK(&t->timerMutex);
 
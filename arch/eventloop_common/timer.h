@@ -11,7 +11,7 @@
 
 #include <open62541/types.h>
 #include <open62541/plugin/eventloop.h>
-#include "ziptree.h"
+#include "btree.h"
 
 _UA_BEGIN_DECLS
 
@@ -26,6 +26,14 @@ _UA_BEGIN_DECLS
 /* Callback where the application is either a client or a server */
 typedef void (*UA_ApplicationCallback)(void *application, void *data);
 
+/* Optional hook that executes the callbacks instead of the timer. E.g. to
+ * measure the execution time. The scheduled time and the interval of the entry
+ * are passed along. The hook is called without holding the timer mutex. */
+typedef void (*UA_TimerExecuteHook)(void *context, UA_UInt64 id,
+                                    UA_DateTime scheduled, UA_DateTime interval,
+                                    UA_ApplicationCallback callback,
+                                    void *application, void *data);
+
 typedef struct UA_TimerEntry {
     ZIP_ENTRY(UA_TimerEntry) treeEntry;
     UA_TimerPolicy timerPolicy;      /* Timer policy to handle cycle misses */
@@ -40,18 +48,20 @@ typedef struct UA_TimerEntry {
     void *application;
     void *data;
 
-    ZIP_ENTRY(UA_TimerEntry) idTreeEntry;
     UA_UInt64 id;                            /* Id of the entry */
 } UA_TimerEntry;
 
 typedef ZIP_HEAD(UA_TimerTree, UA_TimerEntry) UA_TimerTree;
-typedef ZIP_HEAD(UA_TimerIdTree, UA_TimerEntry) UA_TimerIdTree;
+typedef BTREE_HEAD(UA_TimerIdTree, UA_TimerEntry) UA_TimerIdTree;
 
 typedef struct {
     UA_TimerTree tree;     /* The root of the time-sorted tree */
     UA_TimerIdTree idTree; /* The root of the id-sorted tree */
     UA_UInt64 idCounter;   /* Generate unique identifiers. Identifiers are
                             * always above zero. */
+    size_t entriesCount;   /* Total number of entries */
+    UA_TimerExecuteHook executeHook;
+    void *executeContext;
 #if UA_MULTITHREADING >= 100
     UA_Lock timerMutex;
 #endif
@@ -63,6 +73,14 @@ UA_Timer_init(UA_Timer *t);
 UA_DateTime
 UA_Timer_next(UA_Timer *t);
 
+/* Number of registered timers */
+size_t
+UA_Timer_count(UA_Timer *t);
+
+/* Set the execute hook. NULL to execute the callbacks directly. */
+void
+UA_Timer_setExecuteHook(UA_Timer *t, UA_TimerExecuteHook hook, void *context);
+
 UA_StatusCode
 UA_Timer_add(UA_Timer *t, UA_ApplicationCallback callback,
              void *application, void *data, UA_Double interval_ms,
@@ -0,0 +1,500 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "timer_wheel.h"
+
+/* Position of the entries that are not in a slot of the wheel */
+#define UA_TIMERWHEEL_OVERFLOW 0
+#define UA_TIMERWHEEL_PROCESSING 1
+
+#define UA_TIMERWHEEL_WORDS (UA_TIMERWHEEL_SLOTS / 64)
+#define UA_TIMERWHEEL_MASK ((UA_UInt64)UA_TIMERWHEEL_SLOTS - 1)
+#define UA_TIMERWHEEL_RANGEBITS (UA_TIMERWHEEL_LEVELS * UA_TIMERWHEEL_SLOTBITS)
+
+static UA_Int64
+wheelTickOf(UA_DateTime t) {
+    /* Round towards negative infinity */
+    if(t >= 0)
+        return t / UA_TIMERWHEEL_TICK;
+    return -((-t + UA_TIMERWHEEL_TICK - 1) / UA_TIMERWHEEL_TICK);
+}
+
+static UA_DateTime
+wheelCalculateNextTime(UA_DateTime currentTime, UA_DateTime baseTime,
+                       UA_DateTime interval) {
+    UA_DateTime cycleDelay = (currentTime - baseTime) % interval;
+    if(UA_UNLIKELY(cycleDelay < 0))
+        cycleDelay += interval;
+    return currentTime + interval - cycleDelay;
+}
+
+static unsigned
+wheelLowestBit(UA_UInt64 word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_ctzll(word);
+#else
+    unsigned i = 0;
+    while(!(word & 1)) {
+        word >>= 1;
+        i++;
+    }
+    return i;
+#endif
+}
+
+/* Find the first occupied slot >= from at the level */
+static UA_Boolean
+wheelNextOccupied(const UA_TimerWheel *t, size_t level,
+                  size_t from, size_t *slot) {
+    for(size_t w = from / 64; w < UA_TIMERWHEEL_WORDS; w++) {
+        UA_UInt64 word = t->occupied[level][w];
+        if(w == from / 64)
+            word &= ~(UA_UInt64)0 << (from % 64);
+        if(word) {
+            *slot = (w * 64) + wheelLowestBit(word);
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Insert the entry into the slot for its nextTime relative to the current
+ * tick */
+static void
+wheelPlaceEntry(UA_TimerWheel *t, UA_TimerWheelEntry *te) {
+    UA_UInt64 cur = (UA_UInt64)t->currentTick;
+    UA_UInt64 due = (UA_UInt64)wheelTickOf(te->nextTime);
+    if(wheelTickOf(te->nextTime) <= t->currentTick)
+        due = cur; /* Due already */
+
+    /* The level is given by the most significant bits that differ */
+    UA_UInt64 diff = due ^ cur;
+    size_t level = 0;
+    while(level < UA_TIMERWHEEL_LEVELS &&
+          (diff >> ((level + 1) * UA_TIMERWHEEL_SLOTBITS)) != 0)
+        level++;
+
+    if(level == UA_TIMERWHEEL_LEVELS) {
+        te->level = UA_TIMERWHEEL_LEVELS;
+        te->slot = UA_TIMERWHEEL_OVERFLOW;
+        LIST_INSERT_HEAD(&t->overflow, te, listEntry);
+        return;
+    }
+
+    size_t slot = (size_t)((due >> (level * UA_TIMERWHEEL_SLOTBITS)) &
+                           UA_TIMERWHEEL_MASK);
+    te->level = (UA_Byte)level;
+    te->slot = (UA_Byte)slot;
+    LIST_INSERT_HEAD(&t->slots[level][slot], te, listEntry);
+    t->occupied[level][slot / 64] |= (UA_UInt64)1 << (slot % 64);
+}
+
+/* Remove the entry from its slot or the overflow list. Entries in processing
+ * are not touched. */
+static void
+wheelUnlinkEntry(UA_TimerWheel *t, UA_TimerWheelEntry *te) {
+    if(te->level == UA_TIMERWHEEL_LEVELS) {
+        if(te->slot == UA_TIMERWHEEL_OVERFLOW)
+            LIST_REMOVE(te, listEntry);
+        return;
+    }
+    LIST_REMOVE(te, listEntry);
+    if(LIST_EMPTY(&t->slots[te->level][te->slot]))
+        t->occupied[te->level][te->slot / 64] &=
+            ~((UA_UInt64)1 << (te->slot % 64));
+}
+
+/* The next tick (> currentTick) where either a level 0 slot is reached or a
+ * slot of a higher level needs to be cascaded. The levels are searched from
+ * the bottom. Because the events of a level all come before the next slot
+ * boundary of the level above. */
+static UA_Int64
+wheelNextEventTick(const UA_TimerWheel *t) {
+    UA_UInt64 cur = (UA_UInt64)t->currentTick;
+    for(size_t level = 0; level < UA_TIMERWHEEL_LEVELS; level++) {
+        size_t shift = level * UA_TIMERWHEEL_SLOTBITS;
+        size_t pos = (size_t)((cur >> shift) & UA_TIMERWHEEL_MASK);
+        size_t slot;
+        if(!wheelNextOccupied(t, level, pos + 1, &slot))
+            continue;
+        UA_UInt64 window = (cur >> (shift + UA_TIMERWHEEL_SLOTBITS))
+            << (shift + UA_TIMERWHEEL_SLOTBITS);
+        return (UA_Int64)(window | ((UA_UInt64)slot << shift));
+    }
+    if(!LIST_EMPTY(&t->overflow))
+        return (UA_Int64)(((cur >> UA_TIMERWHEEL_RANGEBITS) + 1)
+                          << UA_TIMERWHEEL_RANGEBITS);
+    return UA_INT64_MAX;
+}
+
+/* Redistribute the entries of a slot (or the overflow list) relative to the
+ * current tick */
+static void
+wheelCascadeList(UA_TimerWheel *t, UA_TimerWheelList *list) {
+    UA_TimerWheelList tmp = *list;
+    if(tmp.lh_first)
+        tmp.lh_first->listEntry.le_prev = &tmp.lh_first;
+    LIST_INIT(list);
+    UA_TimerWheelEntry *te;
+    while((te = LIST_FIRST(&tmp))) {
+        LIST_REMOVE(te, listEntry);
+        wheelPlaceEntry(t, te);
+    }
+}
+
+static void
+wheelCascade(UA_TimerWheel *t) {
+    UA_UInt64 cur = (UA_UInt64)t->currentTick;
+    if((cur & (((UA_UInt64)1 << UA_TIMERWHEEL_RANGEBITS) - 1)) == 0)
+        wheelCascadeList(t, &t->overflow);
+    for(size_t level = UA_TIMERWHEEL_LEVELS - 1; level > 0; level--) {
+        size_t shift = level * UA_TIMERWHEEL_SLOTBITS;
+        if((cur & (((UA_UInt64)1 << shift) - 1)) != 0)
+            continue;
+        size_t slot = (size_t)((cur >> shift) & UA_TIMERWHEEL_MASK);
+        if(LIST_EMPTY(&t->slots[level][slot]))
+            continue;
+        t->occupied[level][slot / 64] &= ~((UA_UInt64)1 << (slot % 64));
+        wheelCascadeList(t, &t->slots[level][slot]);
+    }
+}
+
+/* Move the due entries from the level 0 slot of the current tick to the
+ * processing queue */
+static void
+wheelCollectDue(UA_TimerWheel *t, UA_DateTime now) {
+    size_t slot = (size_t)((UA_UInt64)t->currentTick & UA_TIMERWHEEL_MASK);
+    UA_TimerWheelEntry *te, *te_tmp;
+    LIST_FOREACH_SAFE(te, &t->slots[0][slot], listEntry, te_tmp) {
+        if(te->nextTime > now)
+            continue;
+        wheelUnlinkEntry(t, te);
+        te->level = UA_TIMERWHEEL_LEVELS;
+        te->slot = UA_TIMERWHEEL_PROCESSING;
+        SIMPLEQ_INSERT_TAIL(&t->processing, te, processEntry);
+    }
+}
+
+static UA_DateTime
+wheelMinNextTime(const UA_TimerWheelList *list) {
+    UA_DateTime next = UA_INT64_MAX;
+    UA_TimerWheelEntry *te;
+    LIST_FOREACH(te, list, listEntry) {
+        if(te->nextTime < next)
+            next = te->nextTime;
+    }
+    return next;
+}
+
+/* The earliest time where processing is required. For the level 0 slots this
+ * is the exact nextTime of the earliest entry. For the higher levels this is
+ * the time where the slot is cascaded. */
+static UA_DateTime
+wheelComputeNext(const UA_TimerWheel *t) {
+    size_t pos = (size_t)((UA_UInt64)t->currentTick & UA_TIMERWHEEL_MASK);
+    if(!LIST_EMPTY(&t->slots[0][pos]))
+        return wheelMinNextTime(&t->slots[0][pos]);
+    UA_Int64 tick = wheelNextEventTick(t);
+    if(tick == UA_INT64_MAX)
+        return UA_INT64_MAX;
+    size_t slot = (size_t)((UA_UInt64)tick & UA_TIMERWHEEL_MASK);
+    if((UA_Int64)((UA_UInt64)tick & ~UA_TIMERWHEEL_MASK) ==
+       (UA_Int64)((UA_UInt64)t->currentTick & ~UA_TIMERWHEEL_MASK) &&
+       !LIST_EMPTY(&t->slots[0][slot]))
+        return wheelMinNextTime(&t->slots[0][slot]);
+    return tick * UA_TIMERWHEEL_TICK;
+}
+
+/* Identifier table. The identifier contains the index in the table (lower 32
+ * bit) and the generation of the index (upper 32 bit). The generation is
+ * incremented when the index is freed. Identifiers are always above zero. */
+static UA_StatusCode
+wheelAllocId(UA_TimerWheel *t, UA_TimerWheelEntry *te) {
+    if(t->idsFree == UA_UINT32_MAX) {
+        UA_UInt32 newSize = (t->idsSize == 0) ? 16 : t->idsSize * 2;
+        if(newSize <= t->idsSize || newSize == UA_UINT32_MAX)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        UA_TimerWheelId *ids = (UA_TimerWheelId*)
+            UA_realloc(t->ids, sizeof(UA_TimerWheelId) * newSize);
+        if(!ids)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        for(UA_UInt32 i = t->idsSize; i < newSize; i++) {
+            ids[i].entry = NULL;
+            ids[i].generation = 1;
+            ids[i].nextFree = (i + 1 < newSize) ? i + 1 : UA_UINT32_MAX;
+        }
+        t->idsFree = t->idsSize;
+        t->ids = ids;
+        t->idsSize = newSize;
+    }
+
+    UA_UInt32 index = t->idsFree;
+    UA_TimerWheelId *id = &t->ids[index];
+    t->idsFree = id->nextFree;
+    id->entry = te;
+    te->id = ((UA_UInt64)id->generation << 32) | index;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_TimerWheelEntry *
+wheelFindEntry(const UA_TimerWheel *t, UA_UInt64 callbackId) {
+    UA_UInt32 index = (UA_UInt32)callbackId;
+    if(index >= t->idsSize)
+        return NULL;
+    const UA_TimerWheelId *id = &t->ids[index];
+    if(id->generation != (UA_UInt32)(callbackId >> 32))
+        return NULL;
+    return id->entry;
+}
+
+static void
+wheelFreeEntry(UA_TimerWheel *t, UA_TimerWheelEntry *te) {
+    UA_UInt32 index = (UA_UInt32)te->id;
+    UA_TimerWheelId *id = &t->ids[index];
+    id->entry = NULL;
+    id->generation++;
+    if(id->generation == 0)
+        id->generation = 1;
+    id->nextFree = t->idsFree;
+    t->idsFree = index;
+    t->entriesCount--;
+    UA_free(te);
+}
+
+void
+UA_TimerWheel_init(UA_TimerWheel *t) {
+    memset(t, 0, sizeof(UA_TimerWheel));
+    SIMPLEQ_INIT(&t->processing);
+    t->idsFree = UA_UINT32_MAX;
+    UA_LOCK_INIT(&t->timerMutex);
+    UA_LOCK_SETRANK(&t->timerMutex, UA_LOCKRANK_TIMER);
+}
+
+UA_StatusCode
+UA_TimerWheel_add(UA_TimerWheel *t, UA_ApplicationCallback callback,
+                  void *application, void *data, UA_Double interval_ms,
+                  UA_DateTime now, UA_DateTime *baseTime,
+                  UA_TimerPolicy timerPolicy, UA_UInt64 *callbackId) {
+    /* A callback method needs to be present */
+    if(!callback)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    /* The interval needs to be positive. The exception is for the "once"
+     * policy. See UA_Timer_add. */
+    UA_DateTime interval = (UA_DateTime)(interval_ms * UA_DATETIME_MSEC);
+    if(interval <= 0) {
+        if(timerPolicy != UA_TIMERPOLICY_ONCE)
+            return UA_STATUSCODE_BADINTERNALERROR;
+        if(baseTime) {
+            interval = *baseTime - now;
+            baseTime = NULL;
+        }
+    }
+
+    /* Allocate the repeated callback structure */
+    UA_TimerWheelEntry *te = (UA_TimerWheelEntry*)
+        UA_malloc(sizeof(UA_TimerWheelEntry));
+    if(!te)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    te->interval = interval;
+    te->callback = callback;
+    te->application = application;
+    te->data = data;
+    te->nextTime = (baseTime == NULL) ?
+        now + interval : wheelCalculateNextTime(now, *baseTime, interval);
+    te->timerPolicy = timerPolicy;
+
+    UA_LOCK(&t->timerMutex);
+
+    UA_StatusCode res = wheelAllocId(t, te);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_UNLOCK(&t->timerMutex);
+        UA_free(te);
+        return res;
+    }
+    if(callbackId)
+        *callbackId = te->id;
+
+    /* Fast-forward the empty wheel to the current time */
+    if(t->entriesCount == 0 && wheelTickOf(now) > t->currentTick)
+        t->currentTick = wheelTickOf(now);
+    t->entriesCount++;
+    wheelPlaceEntry(t, te);
+
+    UA_UNLOCK(&t->timerMutex);
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_TimerWheel_modify(UA_TimerWheel *t, UA_UInt64 callbackId,
+                     UA_Double interval_ms, UA_DateTime now,
+                     UA_DateTime *baseTime, UA_TimerPolicy timerPolicy) {
+    UA_DateTime interval = (UA_DateTime)(interval_ms * UA_DATETIME_MSEC);
+    if(interval <= 0) {
+        if(timerPolicy != UA_TIMERPOLICY_ONCE)
+            return UA_STATUSCODE_BADINTERNALERROR;
+        if(baseTime) {
+            interval = *baseTime - now;
+            baseTime = NULL;
+        }
+    }
+
+    UA_LOCK(&t->timerMutex);
+
+    UA_TimerWheelEntry *te = wheelFindEntry(t, callbackId);
+    if(!te) {
+        UA_UNLOCK(&t->timerMutex);
+        return UA_STATUSCODE_BADNOTFOUND;
+    }
+
+    UA_Boolean processing = (te->level == UA_TIMERWHEEL_LEVELS &&
+                             te->slot == UA_TIMERWHEEL_PROCESSING);
+    wheelUnlinkEntry(t, te);
+
+    te->nextTime = (baseTime == NULL) ?
+        now + interval : wheelCalculateNextTime(now, *baseTime, interval);
+    te->interval = interval;
+    te->timerPolicy = timerPolicy;
+
+    if(processing)
+        te->nextTime -= interval; /* adjust for re-adding after processing */
+    else
+        wheelPlaceEntry(t, te);
+
+    UA_UNLOCK(&t->timerMutex);
+    return UA_STATUSCODE_GOOD;
+}
+
+void
+UA_TimerWheel_remove(UA_TimerWheel *t, UA_UInt64 callbackId) {
+    UA_LOCK(&t->timerMutex);
+    UA_TimerWheelEntry *te = wheelFindEntry(t, callbackId);
+    if(!te) {
+        UA_UNLOCK(&t->timerMutex);
+        return;
+    }
+
+    /* Leave a sentinel for entries in processing. They are freed after their
+     * turn in the processing queue has come. */
+    if(te->level == UA_TIMERWHEEL_LEVELS &&
+       te->slot == UA_TIMERWHEEL_PROCESSING) {
+        te->callback = NULL;
+    } else {
+        wheelUnlinkEntry(t, te);
+        wheelFreeEntry(t, te);
+    }
+
+    UA_UNLOCK(&t->timerMutex);
+}
+
+UA_DateTime
+UA_TimerWheel_process(UA_TimerWheel *t, UA_DateTime now) {
+    UA_LOCK(&t->timerMutex);
+
+    /* Advance the wheel up to the current tick. Jump from event to event
+     * (reached level 0 slot or cascading of a higher level). The due entries
+     * are collected in the processing queue in the order of their ticks. */
+    UA_Int64 target = wheelTickOf(now);
+    if(t->entriesCount == 0 && target > t->currentTick)
+        t->currentTick = target;
+    wheelCollectDue(t, now);
+    while(t->currentTick < target) {
+        UA_Int64 next = wheelNextEventTick(t);
+        if(next > target) {
+            t->currentTick = target;
+            break;
+        }
+        t->currentTick = next;
+        wheelCascade(t);
+        wheelCollectDue(t, now);
+    }
+
+    /* Execute the due entries in one batch */
+    UA_TimerWheelEntry *te;
+    while((te = SIMPLEQ_FIRST(&t->processing))) {
+        SIMPLEQ_REMOVE_HEAD(&t->processing, processEntry);
+
+        if(te->callback) {
+            UA_TimerExecuteHook hook = t->executeHook;
+            void *hookContext = t->executeContext;
+            UA_UNLOCK(&t->timerMutex);
+            if(hook)
+                hook(hookContext, te->id, te->nextTime, te->interval,
+                     te->callback, te->application, te->data);
+            else
+                te->callback(te->application, te->data);
+            UA_LOCK(&t->timerMutex);
+        }
+
+        /* Remove the entry if marked for deletion or a "once" policy */
+        if(!te->callback || te->timerPolicy == UA_TIMERPOLICY_ONCE) {
+            wheelFreeEntry(t, te);
+            continue;
+        }
+
+        /* Set the time for the next regular execution. Handle missed
+         * execution windows as in UA_Timer_process. */
+        te->nextTime += te->interval;
+        if(te->nextTime < now) {
+            te->nextTime = (te->timerPolicy == UA_TIMERPOLICY_CURRENTTIME) ?
+                now + te->interval :
+                wheelCalculateNextTime(now, te->nextTime, te->interval);
+        }
+        wheelPlaceEntry(t, te);
+    }
+
+    UA_DateTime next = wheelComputeNext(t);
+    UA_UNLOCK(&t->timerMutex);
+    return next;
+}
+
+size_t
+UA_TimerWheel_count(UA_TimerWheel *t) {
+    UA_LOCK(&t->timerMutex);
+    size_t count = t->entriesCount;
+    UA_UNLOCK(&t->timerMutex);
+    return count;
+}
+
+void
+UA_TimerWheel_setExecuteHook(UA_TimerWheel *t, UA_TimerExecuteHook hook,
+                             void *context) {
+    UA_LOCK(&t->timerMutex);
+    t->executeHook = hook;
+    t->executeContext = context;
+    UA_UNLOCK(&t->timerMutex);
+}
+
+UA_DateTime
+UA_TimerWheel_next(UA_TimerWheel *t) {
+    UA_LOCK(&t->timerMutex);
+    UA_DateTime next = wheelComputeNext(t);
+    UA_UNLOCK(&t->timerMutex);
+    return next;
+}
+
+void
+UA_TimerWheel_clear(UA_TimerWheel *t) {
+    UA_LOCK(&t->timerMutex);
+
+    for(UA_UInt32 i = 0; i < t->idsSize; i++)
+        UA_free(t->ids[i].entry);
+    UA_free(t->ids);
+    t->ids = NULL;
+    t->idsSize = 0;
+    t->idsFree = UA_UINT32_MAX;
+    t->entriesCount = 0;
+    t->currentTick = 0;
+    memset(t->slots, 0, sizeof(t->slots));
+    memset(t->occupied, 0, sizeof(t->occupied));
+    LIST_INIT(&t->overflow);
+    SIMPLEQ_INIT(&t->processing);
+
+    UA_UNLOCK(&t->timerMutex);
+
+#if UA_MULTITHREADING >= 100
+    UA_LOCK_DESTROY(&t->timerMutex);
+#endif
+}
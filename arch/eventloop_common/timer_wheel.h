@@ -0,0 +1,125 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef UA_TIMER_WHEEL_H_
+#define UA_TIMER_WHEEL_H_
+
+#include <open62541/types.h>
+#include <open62541/plugin/eventloop.h>
+#include "open62541_queue.h"
+#include "timer.h"
+
+_UA_BEGIN_DECLS
+
+/* Hierarchical timing wheel with the same interface and semantics as the
+ * ziptree-based UA_Timer. It is used by the POSIX EventLoop if
+ * UA_ENABLE_TIMER_WHEEL is defined.
+ *
+ * Time is divided into ticks of one millisecond. The wheel has four levels of
+ * 256 slots each. The slots of level l cover 256^l ticks. A timer is put into
+ * the lowest level where its tick differs from the current tick only in the
+ * bits of that level. Timers beyond the range of the highest level (~49 days)
+ * are kept in an overflow list. When the current tick crosses a slot boundary
+ * of level l, the timers of the slot are redistributed ("cascaded") to the
+ * lower levels. Bitmaps of the occupied slots allow to skip over empty slots
+ * in constant time.
+ *
+ * Adding, modifying and removing timers is O(1). Callback identifiers index
+ * into a table of entries with a generation counter to detect stale
+ * identifiers. Due timers are collected slot-by-slot (in the order of their
+ * ticks) and then executed in one batch. Within a tick the execution order
+ * is unspecified.
+ *
+ * The timer is protected by its own mutex. The same rules as for UA_Timer
+ * apply. */
+
+#define UA_TIMERWHEEL_LEVELS 4
+#define UA_TIMERWHEEL_SLOTBITS 8
+#define UA_TIMERWHEEL_SLOTS (1 << UA_TIMERWHEEL_SLOTBITS)
+#define UA_TIMERWHEEL_TICK UA_DATETIME_MSEC
+
+typedef struct UA_TimerWheelEntry {
+    LIST_ENTRY(UA_TimerWheelEntry) listEntry;
+    SIMPLEQ_ENTRY(UA_TimerWheelEntry) processEntry;
+    UA_TimerPolicy timerPolicy;
+    UA_Byte level;                   /* UA_TIMERWHEEL_LEVELS for the entries
+                                      * not in a slot. Then the slot denotes
+                                      * the overflow list or processing. */
+    UA_Byte slot;
+    UA_DateTime nextTime;
+    UA_DateTime interval;            /* Interval in 100ns resolution */
+    UA_ApplicationCallback callback; /* NULL marks the entry for deletion */
+    void *application;
+    void *data;
+    UA_UInt64 id;
+} UA_TimerWheelEntry;
+
+typedef LIST_HEAD(UA_TimerWheelList, UA_TimerWheelEntry) UA_TimerWheelList;
+typedef SIMPLEQ_HEAD(UA_TimerWheelQueue, UA_TimerWheelEntry) UA_TimerWheelQueue;
+
+typedef struct {
+    UA_TimerWheelEntry *entry;
+    UA_UInt32 generation;
+    UA_UInt32 nextFree;
+} UA_TimerWheelId;
+
+typedef struct {
+    UA_Int64 currentTick; /* Timers up to and including this tick are kept in
+                           * the level 0 slot of the current tick */
+    size_t entriesCount;  /* Total number of entries */
+    UA_TimerWheelList slots[UA_TIMERWHEEL_LEVELS][UA_TIMERWHEEL_SLOTS];
+    UA_UInt64 occupied[UA_TIMERWHEEL_LEVELS][UA_TIMERWHEEL_SLOTS / 64];
+    UA_TimerWheelList overflow;
+    UA_TimerWheelQueue processing; /* Due entries during _process */
+
+    /* Lookup of the entries by their identifier */
+    UA_TimerWheelId *ids;
+    UA_UInt32 idsSize;
+    UA_UInt32 idsFree; /* Head of the free-list, UA_UINT32_MAX if empty */
+
+    UA_TimerExecuteHook executeHook;
+    void *executeContext;
+
+#if UA_MULTITHREADING >= 100
+    UA_Lock timerMutex;
+#endif
+} UA_TimerWheel;
+
+void
+UA_TimerWheel_init(UA_TimerWheel *t);
+
+UA_DateTime
+UA_TimerWheel_next(UA_TimerWheel *t);
+
+size_t
+UA_TimerWheel_count(UA_TimerWheel *t);
+
+void
+UA_TimerWheel_setExecuteHook(UA_TimerWheel *t, UA_TimerExecuteHook hook,
+                             void *context);
+
+UA_StatusCode
+UA_TimerWheel_add(UA_TimerWheel *t, UA_ApplicationCallback callback,
+                  void *application, void *data, UA_Double interval_ms,
+                  UA_DateTime now, UA_DateTime *baseTime,
+                  UA_TimerPolicy timerPolicy, UA_UInt64 *callbackId);
+
+UA_StatusCode
+UA_TimerWheel_modify(UA_TimerWheel *t, UA_UInt64 callbackId,
+                     UA_Double interval_ms, UA_DateTime now,
+                     UA_DateTime *baseTime, UA_TimerPolicy timerPolicy);
+
+void
+UA_TimerWheel_remove(UA_TimerWheel *t, UA_UInt64 callbackId);
+
+UA_DateTime
+UA_TimerWheel_process(UA_TimerWheel *t, UA_DateTime now);
+
+void
+UA_TimerWheel_clear(UA_TimerWheel *t);
+
+_UA_END_DECLS
+
+#endif /* UA_TIMER_WHEEL_H_ */
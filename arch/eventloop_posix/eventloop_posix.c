@@ -13,6 +13,16 @@
 #include <time.h>
 #endif
 
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+/* epoll_pwait2 with a nanosecond timeout was added in glibc 2.35 */
+#if defined(UA_HAVE_EPOLL) && defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 35))
+# define UA_HAVE_EPOLL_PWAIT2
+#endif
+
 /*********/
 /* Timer */
 /*********/
@@ -20,9 +30,15 @@
 static UA_DateTime
 UA_EventLoopPOSIX_nextTimer(UA_EventLoop *public_el) {
     UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)public_el;
-    return UA_Timer_next(&el->timer);
+    return UA_EL_TIMER(next)(&el->timer);
 }
 
+static UA_DateTime
+UA_EventLoopPOSIX_readClockMonotonic(UA_EventLoopPOSIX *el);
+
+static UA_DateTime
+UA_EventLoopPOSIX_updateClock(UA_EventLoopPOSIX *el);
+
 static UA_StatusCode
 UA_EventLoopPOSIX_addTimer(UA_EventLoop *public_el,
                                     UA_Callback cb,
@@ -32,9 +48,9 @@ UA_EventLoopPOSIX_addTimer(UA_EventLoop *public_el,
                                     UA_TimerPolicy timerPolicy,
                                     UA_UInt64 *callbackId) {
     UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)public_el;
-    return UA_Timer_add(&el->timer, cb, application, data, interval_ms,
-                        public_el->dateTime_nowMonotonic(public_el),
-                        baseTime, timerPolicy, callbackId);
+    return UA_EL_TIMER(add)(&el->timer, cb, application, data, interval_ms,
+                            UA_EventLoopPOSIX_readClockMonotonic(el),
+                            baseTime, timerPolicy, callbackId);
 }
 
 static UA_StatusCode
@@ -44,27 +60,86 @@ UA_EventLoopPOSIX_modifyTimer(UA_EventLoop *public_el,
                               UA_DateTime *baseTime,
                               UA_TimerPolicy timerPolicy) {
     UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)public_el;
-    return UA_Timer_modify(&el->timer, callbackId, interval_ms,
-                           public_el->dateTime_nowMonotonic(public_el),
-                           baseTime, timerPolicy);
+    return UA_EL_TIMER(modify)(&el->timer, callbackId, interval_ms,
+                               UA_EventLoopPOSIX_readClockMonotonic(el),
+                               baseTime, timerPolicy);
 }
 
 static void
 UA_EventLoopPOSIX_removeTimer(UA_EventLoop *public_el,
                               UA_UInt64 callbackId) {
     UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)public_el;
-    UA_Timer_remove(&el->timer, callbackId);
+    UA_EL_TIMER(remove)(&el->timer, callbackId);
+}
+
+/* Execute the timer callback with profiling. Timed callbacks overrun if they
+ * finish after the next cycle is due. */
+static void
+profileTimerCallback(void *context, UA_UInt64 id, UA_DateTime scheduled,
+                     UA_DateTime interval, UA_ApplicationCallback callback,
+                     void *application, void *data) {
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)context;
+    UA_DateTime start = UA_EventLoopPOSIX_readClockMonotonic(el);
+    callback(application, data);
+    UA_DateTime end = UA_EventLoopPOSIX_readClockMonotonic(el);
+    UA_Boolean overrun = (interval > 0 && end > scheduled + interval);
+    UA_EventLoopProfiler_record(&el->profiler, UA_EVENTLOOPPROFILETYPE_TIMER,
+                                id, start, end, overrun);
 }
 
 void
 UA_EventLoopPOSIX_addDelayedCallback(UA_EventLoop *public_el,
                                      UA_DelayedCallback *dc) {
     UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)public_el;
-    UA_DelayedCallback *old;
+    dc->next = NULL;
+    UA_DelayedCallback *prev;
     do {
-        old = el->delayedCallbacks;
-        dc->next = old;
-    } while(UA_atomic_cmpxchg((void * volatile *)&el->delayedCallbacks, old, dc) != old);
+        prev = el->delayedHead;
+    } while(UA_atomic_cmpxchg((void * volatile *)&el->delayedHead, prev, dc) != prev);
+    /* Link the entry. Until then the consumer cannot proceed beyond prev. */
+    UA_atomic_xchg((void * volatile *)&prev->next, dc);
+}
+
+/* Move the entries from the lock-free queue to the ready list. Returns false
+ * if a producer has swapped the head but not yet linked its entry. The
+ * remaining entries are then taken in a later call. */
+static UA_Boolean
+takeDelayed(UA_EventLoopPOSIX *el) {
+    UA_LOCK_ASSERT(&el->elMutex);
+    UA_DelayedCallback *stub = &el->delayedStub;
+    while(true) {
+        UA_DelayedCallback *tail = el->delayedTail;
+        UA_DelayedCallback *next = tail->next;
+
+        /* Skip the stub */
+        if(tail == stub) {
+            if(!next)
+                return (el->delayedHead == stub);
+            el->delayedTail = next;
+            tail = next;
+            next = next->next;
+        }
+
+        /* The tail is the last linked entry. Re-add the stub behind it, so
+         * that the tail can be detached. */
+        if(!next) {
+            if(tail != el->delayedHead)
+                return false;
+            UA_EventLoopPOSIX_addDelayedCallback(&el->eventLoop, stub);
+            next = tail->next;
+            if(!next)
+                return false; /* Another producer came before the stub */
+        }
+
+        /* Append the tail to the ready list */
+        el->delayedTail = next;
+        tail->next = NULL;
+        if(el->delayedReadyLast)
+            el->delayedReadyLast->next = tail;
+        else
+            el->delayedReady = tail;
+        el->delayedReadyLast = tail;
+    }
 }
 
 static void
@@ -72,13 +147,21 @@ UA_EventLoopPOSIX_removeDelayedCallback(UA_EventLoop *public_el,
                                      UA_DelayedCallback *dc) {
     UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)public_el;
     UA_LOCK(&el->elMutex);
-    UA_DelayedCallback **prev = &el->delayedCallbacks;
+
+    /* Take all entries from the queue. Wait for the producers that are
+     * between swapping the head and linking their entry. */
+    while(!takeDelayed(el)) {}
+
+    UA_DelayedCallback **prev = &el->delayedReady;
+    UA_DelayedCallback *last = NULL;
     while(*prev) {
         if(*prev == dc) {
-            *prev = (*prev)->next;
-            UA_UNLOCK(&el->elMutex);
-            return;
+            *prev = dc->next;
+            if(el->delayedReadyLast == dc)
+                el->delayedReadyLast = last;
+            break;
         }
+        last = *prev;
         prev = &(*prev)->next;
     }
     UA_UNLOCK(&el->elMutex);
@@ -92,11 +175,13 @@ processDelayed(UA_EventLoopPOSIX *el) {
 
     UA_LOCK_ASSERT(&el->elMutex);
 
-    /* First empty the linked list in the el. So a delayed callback can add
-     * (itself) to the list. New entries are then processed during the next
+    /* First take the ready list from the el. So a delayed callback can add
+     * (itself) again. New entries are then processed during the next
      * iteration. */
-    UA_DelayedCallback *dc = el->delayedCallbacks, *next = NULL;
-    el->delayedCallbacks = NULL;
+    takeDelayed(el);
+    UA_DelayedCallback *dc = el->delayedReady, *next = NULL;
+    el->delayedReady = NULL;
+    el->delayedReadyLast = NULL;
 
     for(; dc; dc = next) {
         next = dc->next;
@@ -105,7 +190,21 @@ processDelayed(UA_EventLoopPOSIX *el) {
         if(!dc->callback)
             continue;
         UA_UNLOCK(&el->elMutex);
-        dc->callback(dc->application, dc->context);
+        if(el->profiler.enabled) {
+            /* The dc can be freed in the callback */
+            UA_Callback callback = dc->callback;
+            UA_DateTime start =
+                UA_EventLoopPOSIX_readClockMonotonic(el);
+            callback(dc->application, dc->context);
+            UA_DateTime end =
+                UA_EventLoopPOSIX_readClockMonotonic(el);
+            UA_EventLoopProfiler_record(&el->profiler,
+                                        UA_EVENTLOOPPROFILETYPE_DELAYED,
+                                        (UA_UInt64)(uintptr_t)callback,
+                                        start, end, false);
+        } else {
+            dc->callback(dc->application, dc->context);
+        }
         UA_LOCK(&el->elMutex);
     }
 }
@@ -155,6 +254,49 @@ UA_EventLoopPOSIX_start(UA_EventLoopPOSIX *el) {
     }
 #endif
 
+#if defined(__linux__)
+    el->threadSchedulingApplied = false;
+#endif
+
+    /* Snapshot the clocks once per iteration */
+    const UA_Boolean *coarseClock = (const UA_Boolean*)
+        UA_KeyValueMap_getScalar(&el->eventLoop.params,
+                                 UA_QUALIFIEDNAME(0, "coarse-clock"),
+                                 &UA_TYPES[UA_TYPES_BOOLEAN]);
+    el->coarseClock = (coarseClock) ? *coarseClock : false;
+    el->cachedNow = 0;
+    el->cachedNowMonotonic = 0;
+
+    /* Busy-polling interval in microseconds */
+    const UA_UInt32 *busyPoll = (const UA_UInt32*)
+        UA_KeyValueMap_getScalar(&el->eventLoop.params,
+                                 UA_QUALIFIEDNAME(0, "busy-poll"),
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+    el->busyPoll = (busyPoll) ? (UA_DateTime)*busyPoll * UA_DATETIME_USEC : 0;
+    el->lastActivity = 0;
+
+    /* Map the network buffer pool. It is kept when the EventLoop is restarted
+     * as buffers might still be in use. */
+    const UA_UInt32 *poolSize = (const UA_UInt32*)
+        UA_KeyValueMap_getScalar(&el->eventLoop.params,
+                                 UA_QUALIFIEDNAME(0, "buffer-pool-size"),
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+    const UA_UInt32 *poolBufSize = (const UA_UInt32*)
+        UA_KeyValueMap_getScalar(&el->eventLoop.params,
+                                 UA_QUALIFIEDNAME(0, "buffer-pool-bufsize"),
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+    if(poolSize && *poolSize > 0 && !el->bufferPool.memory) {
+        UA_StatusCode res =
+            UA_NetworkBufferPool_init(&el->bufferPool, el->eventLoop.logger, *poolSize,
+                                      (poolBufSize) ? *poolBufSize : 1u << 16);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
+                           "Eventloop\t| Could not create the network buffer "
+                           "pool (%s). Allocate the buffers individually.",
+                           UA_StatusCode_name(res));
+        }
+    }
+
     /* Create the self-pipe */
     int err = UA_EventLoopPOSIX_pipe(el->selfpipe);
     if(err != 0) {
@@ -165,17 +307,33 @@ UA_EventLoopPOSIX_start(UA_EventLoopPOSIX *el) {
         UA_UNLOCK(&el->elMutex);
         return UA_STATUSCODE_BADINTERNALERROR;
     }
+    el->wakeupPending = NULL;
 
     /* Create the epoll socket */
 #ifdef UA_HAVE_EPOLL
+    /* Allocate the buffer for the events received in one epoll_wait */
+    const UA_UInt32 *maxEvents = (const UA_UInt32*)
+        UA_KeyValueMap_getScalar(&el->eventLoop.params,
+                                 UA_QUALIFIEDNAME(0, "epoll-maxevents"),
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+    el->epollEventsSize = (maxEvents && *maxEvents > 0) ? *maxEvents : 256;
+    el->epollEvents = (struct epoll_event*)
+        UA_malloc(sizeof(struct epoll_event) * el->epollEventsSize);
+    if(!el->epollEvents) {
+        UA_EventLoopPOSIX_closePipe(el->selfpipe);
+        UA_UNLOCK(&el->elMutex);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+
     el->epollfd = epoll_create1(0);
     if(el->epollfd == -1) {
         UA_LOG_SOCKET_ERRNO_WRAP(
            UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
                           "Eventloop\t| Could not create the epoll socket (%s)",
                           errno_str));
-        UA_close(el->selfpipe[0]);
-        UA_close(el->selfpipe[1]);
+        UA_EventLoopPOSIX_closePipe(el->selfpipe);
+        UA_free(el->epollEvents);
+        el->epollEvents = NULL;
         UA_UNLOCK(&el->elMutex);
         return UA_STATUSCODE_BADINTERNALERROR;
     }
@@ -191,9 +349,10 @@ UA_EventLoopPOSIX_start(UA_EventLoopPOSIX *el) {
            UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
                           "Eventloop\t| Could not register the self-pipe for epoll (%s)",
                           errno_str));
-        UA_close(el->selfpipe[0]);
-        UA_close(el->selfpipe[1]);
+        UA_EventLoopPOSIX_closePipe(el->selfpipe);
         close(el->epollfd);
+        UA_free(el->epollEvents);
+        el->epollEvents = NULL;
         UA_UNLOCK(&el->elMutex);
         return UA_STATUSCODE_BADINTERNALERROR;
     }
@@ -229,20 +388,25 @@ checkClosed(UA_EventLoopPOSIX *el) {
     }
 
     /* Not closed until all delayed callbacks are processed */
-    if(el->delayedCallbacks != NULL)
+    if(UA_EventLoopPOSIX_hasDelayed(el))
         return;
 
     /* Close the self-pipe when everything else is done */
-    UA_close(el->selfpipe[0]);
-    UA_close(el->selfpipe[1]);
+    UA_EventLoopPOSIX_closePipe(el->selfpipe);
 
     /* Dirty-write the state that is const "from the outside" */
     *(UA_EventLoopState*)(uintptr_t)&el->eventLoop.state =
         UA_EVENTLOOPSTATE_STOPPED;
 
+    /* Read the clocks directly while the EventLoop is not running */
+    el->cachedNow = 0;
+    el->cachedNowMonotonic = 0;
+
     /* Close the epoll/IOCP socket once all EventSources have shut down */
 #ifdef UA_HAVE_EPOLL
     close(el->epollfd);
+    UA_free(el->epollEvents);
+    el->epollEvents = NULL;
 #endif
 
     UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
@@ -284,6 +448,80 @@ UA_EventLoopPOSIX_stop(UA_EventLoopPOSIX *el) {
     UA_UNLOCK(&el->elMutex);
 }
 
+#if defined(__linux__)
+/* Apply the real-time scheduling parameters to the calling thread. Dedicated
+ * EventLoops (e.g. for a PubSubConnection) run the cyclic publishing and the
+ * receiving in their own thread that is then not preempted by the server. */
+static void
+applyThreadScheduling(UA_EventLoopPOSIX *el) {
+    const UA_Int32 *prio = (const UA_Int32*)
+        UA_KeyValueMap_getScalar(&el->eventLoop.params,
+                                 UA_QUALIFIEDNAME(0, "rt-priority"),
+                                 &UA_TYPES[UA_TYPES_INT32]);
+    if(prio) {
+        struct sched_param sp;
+        memset(&sp, 0, sizeof(struct sched_param));
+        sp.sched_priority = *prio;
+        if(sched_setscheduler(0, SCHED_FIFO, &sp) != 0) {
+            UA_LOG_SOCKET_ERRNO_WRAP(
+               UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
+                              "Eventloop\t| Could not set the SCHED_FIFO "
+                              "priority %i (%s)", (int)*prio, errno_str));
+        }
+    }
+
+    const UA_UInt32 *cpu = (const UA_UInt32*)
+        UA_KeyValueMap_getScalar(&el->eventLoop.params,
+                                 UA_QUALIFIEDNAME(0, "cpu-affinity"),
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+    if(cpu) {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(*cpu, &cpuSet);
+        if(sched_setaffinity(0, sizeof(cpu_set_t), &cpuSet) != 0) {
+            UA_LOG_SOCKET_ERRNO_WRAP(
+               UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
+                              "Eventloop\t| Could not pin the thread to "
+                              "CPU %u (%s)", (unsigned)*cpu, errno_str));
+        }
+    }
+
+    el->threadSchedulingApplied = true;
+}
+#endif
+
+/* Poll the sockets without a timeout as long as there was activity within the
+ * busy-poll interval. This avoids the wakeup latency of the blocking wait while
+ * traffic is flowing. Block for the remaining time once the sockets are idle
+ * for longer than the interval. */
+static UA_StatusCode
+busyPollFDs(UA_EventLoopPOSIX *el, UA_DateTime dateNext) {
+    UA_DateTime now = UA_EventLoopPOSIX_readClockMonotonic(el);
+    while(now < dateNext && now < el->lastActivity + el->busyPoll) {
+        UA_StatusCode rv = UA_EventLoopPOSIX_pollFDs(el, 0);
+        if(rv != UA_STATUSCODE_GOOD)
+            return rv;
+        now = UA_EventLoopPOSIX_readClockMonotonic(el);
+        if(el->pollEvents > 0) {
+            el->lastActivity = now;
+            return UA_STATUSCODE_GOOD;
+        }
+        /* A callback was added from another thread. Process in the next
+         * iteration. */
+        if(UA_EventLoopPOSIX_hasDelayed(el) ||
+           el->eventLoop.state == UA_EVENTLOOPSTATE_STOPPING)
+            return UA_STATUSCODE_GOOD;
+    }
+
+    UA_DateTime listenTimeout = dateNext - now;
+    if(listenTimeout < 0)
+        listenTimeout = 0;
+    UA_StatusCode rv = UA_EventLoopPOSIX_pollFDs(el, listenTimeout);
+    if(el->pollEvents > 0)
+        el->lastActivity = UA_EventLoopPOSIX_readClockMonotonic(el);
+    return rv;
+}
+
 static UA_StatusCode
 UA_EventLoopPOSIX_run(UA_EventLoopPOSIX *el, UA_UInt32 timeout) {
     UA_LOCK(&el->elMutex);
@@ -310,12 +548,16 @@ UA_EventLoopPOSIX_run(UA_EventLoopPOSIX *el, UA_UInt32 timeout) {
     UA_LOG_TRACE(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
                  "Iterate the EventLoop");
 
+#if defined(__linux__)
+    if(!el->threadSchedulingApplied)
+        applyThreadScheduling(el);
+#endif
+
     /* Process cyclic callbacks */
-    UA_DateTime dateBefore =
-        el->eventLoop.dateTime_nowMonotonic(&el->eventLoop);
+    UA_DateTime dateBefore = UA_EventLoopPOSIX_updateClock(el);
 
     UA_UNLOCK(&el->elMutex);
-    UA_DateTime dateNext = UA_Timer_process(&el->timer, dateBefore);
+    UA_DateTime dateNext = UA_EL_TIMER(process)(&el->timer, dateBefore);
     UA_LOCK(&el->elMutex);
 
     /* Process delayed callbacks here:
@@ -329,7 +571,7 @@ UA_EventLoopPOSIX_run(UA_EventLoopPOSIX *el, UA_UInt32 timeout) {
      * itself). In that case we don't want to wait (indefinitely) for an event
      * to happen. Process queued events but don't sleep. Then process the
      * delayed callbacks in the next iteration. */
-    if(el->delayedCallbacks != NULL)
+    if(UA_EventLoopPOSIX_hasDelayed(el))
         timeout = 0;
 
     /* Compute the remaining time */
@@ -337,23 +579,89 @@ UA_EventLoopPOSIX_run(UA_EventLoopPOSIX *el, UA_UInt32 timeout) {
     if(dateNext > maxDate)
         dateNext = maxDate;
     UA_DateTime listenTimeout =
-        dateNext - el->eventLoop.dateTime_nowMonotonic(&el->eventLoop);
+        dateNext - UA_EventLoopPOSIX_readClockMonotonic(el);
     if(listenTimeout < 0)
         listenTimeout = 0;
 
     /* Listen on the active file-descriptors (sockets) from the
      * ConnectionManagers */
-    UA_StatusCode rv = UA_EventLoopPOSIX_pollFDs(el, listenTimeout);
+    el->waitTime = 0;
+    UA_StatusCode rv = (el->busyPoll > 0) ?
+        busyPollFDs(el, dateNext) : UA_EventLoopPOSIX_pollFDs(el, listenTimeout);
 
     /* Check if the last EventSource was successfully stopped */
     if(el->eventLoop.state == UA_EVENTLOOPSTATE_STOPPING)
         checkClosed(el);
 
+    /* Update the statistics */
+    UA_DateTime iterationTime =
+        UA_EventLoopPOSIX_readClockMonotonic(el) -
+        dateBefore - el->waitTime;
+    if(iterationTime < 0)
+        iterationTime = 0;
+    el->iterationCount++;
+    el->iterationTimeLast = iterationTime;
+    el->iterationTimeTotal += iterationTime;
+    if(iterationTime > el->iterationTimeMax)
+        el->iterationTimeMax = iterationTime;
+
+    /* The profiled iteration includes the wait for events */
+    if(el->profiler.enabled)
+        UA_EventLoopProfiler_record(&el->profiler,
+                                    UA_EVENTLOOPPROFILETYPE_ITERATION, 0,
+                                    dateBefore, dateBefore + iterationTime +
+                                    el->waitTime, false);
+
     el->executing = false;
     UA_UNLOCK(&el->elMutex);
     return rv;
 }
 
+static void
+UA_EventLoopPOSIX_getStatistics(UA_EventLoopPOSIX *el,
+                                UA_EventLoopStatistics *stats) {
+    stats->timerCount = UA_EL_TIMER(count)(&el->timer);
+    UA_LOCK(&el->elMutex);
+    stats->iterationCount = el->iterationCount;
+    stats->iterationTimeLast = el->iterationTimeLast;
+    stats->iterationTimeMax = el->iterationTimeMax;
+    stats->iterationTimeTotal = el->iterationTimeTotal;
+    stats->networkBuffers = el->bufferPool.buffersSize;
+    stats->networkBuffersInUse = el->bufferPool.inUse;
+    stats->networkBufferPoolMisses = el->bufferPool.misses;
+    UA_UNLOCK(&el->elMutex);
+}
+
+static UA_StatusCode
+UA_EventLoopPOSIX_setProfiling(UA_EventLoopPOSIX *el, UA_Boolean enable,
+                               size_t traceSize) {
+    if(!enable) {
+        UA_EL_TIMER(setExecuteHook)(&el->timer, NULL, NULL);
+        UA_EventLoopProfiler_disable(&el->profiler);
+        return UA_STATUSCODE_GOOD;
+    }
+
+    UA_DateTime now = UA_EventLoopPOSIX_readClockMonotonic(el);
+    UA_StatusCode res =
+        UA_EventLoopProfiler_enable(&el->profiler, now, traceSize);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    UA_EL_TIMER(setExecuteHook)(&el->timer, profileTimerCallback, el);
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+UA_EventLoopPOSIX_getProfile(UA_EventLoopPOSIX *el,
+                             UA_EventLoopProfileEntry **entries,
+                             size_t *entriesSize) {
+    return UA_EventLoopProfiler_getEntries(&el->profiler, entries, entriesSize);
+}
+
+static UA_StatusCode
+UA_EventLoopPOSIX_printProfileTrace(UA_EventLoopPOSIX *el, UA_String *output) {
+    return UA_EventLoopProfiler_printTrace(&el->profiler, output);
+}
+
 /*****************************/
 /* Registering Event Sources */
 /*****************************/
@@ -425,11 +733,19 @@ UA_EventLoopPOSIX_deregisterEventSource(UA_EventLoopPOSIX *el,
 /***************/
 
 static UA_DateTime
-UA_EventLoopPOSIX_DateTime_now(UA_EventLoop *el) {
+UA_EventLoopPOSIX_DateTime_now(UA_EventLoop *public_el);
+static UA_DateTime
+UA_EventLoopPOSIX_DateTime_nowMonotonic(UA_EventLoop *public_el);
+
+/* Read the clocks without the coarse-clock snapshots. A clock function replaced
+ * by the application (e.g. a simulated clock) is still used. */
+static UA_DateTime
+UA_EventLoopPOSIX_readClock(UA_EventLoopPOSIX *el) {
+    if(el->eventLoop.dateTime_now != UA_EventLoopPOSIX_DateTime_now)
+        return el->eventLoop.dateTime_now(&el->eventLoop);
 #if defined(UA_ARCHITECTURE_POSIX) && !defined(__APPLE__) && !defined(__MACH__)
-    UA_EventLoopPOSIX *pel = (UA_EventLoopPOSIX*)el;
     struct timespec ts;
-    int res = clock_gettime(pel->clockSource, &ts);
+    int res = clock_gettime(el->clockSource, &ts);
     if(UA_UNLIKELY(res != 0))
         return 0;
     return (ts.tv_sec * UA_DATETIME_SEC) + (ts.tv_nsec / 100) + UA_DATETIME_UNIX_EPOCH;
@@ -439,11 +755,12 @@ UA_EventLoopPOSIX_DateTime_now(UA_EventLoop *el) {
 }
 
 static UA_DateTime
-UA_EventLoopPOSIX_DateTime_nowMonotonic(UA_EventLoop *el) {
+UA_EventLoopPOSIX_readClockMonotonic(UA_EventLoopPOSIX *el) {
+    if(el->eventLoop.dateTime_nowMonotonic != UA_EventLoopPOSIX_DateTime_nowMonotonic)
+        return el->eventLoop.dateTime_nowMonotonic(&el->eventLoop);
 #if defined(UA_ARCHITECTURE_POSIX) && !defined(__APPLE__) && !defined(__MACH__)
-    UA_EventLoopPOSIX *pel = (UA_EventLoopPOSIX*)el;
     struct timespec ts;
-    int res = clock_gettime(pel->clockSourceMonotonic, &ts);
+    int res = clock_gettime(el->clockSourceMonotonic, &ts);
     if(UA_UNLIKELY(res != 0))
         return 0;
     /* Also add the unix epoch for the monotonic clock. So we get a "normal"
@@ -454,6 +771,39 @@ UA_EventLoopPOSIX_DateTime_nowMonotonic(UA_EventLoop *el) {
 #endif
 }
 
+/* Take the snapshots of the coarse clock. Returns the current monotonic time
+ * also if the coarse clock is disabled. */
+static UA_DateTime
+UA_EventLoopPOSIX_updateClock(UA_EventLoopPOSIX *el) {
+    UA_DateTime now = UA_EventLoopPOSIX_readClockMonotonic(el);
+    if(el->coarseClock) {
+        el->cachedNow = UA_EventLoopPOSIX_readClock(el);
+        el->cachedNowMonotonic = now;
+    }
+    return now;
+}
+
+/* With the coarse clock, all callbacks of an EventLoop iteration see the same
+ * time. Precise measurements inside the EventLoop (timers, statistics,
+ * profiling) read the clocks directly. */
+static UA_DateTime
+UA_EventLoopPOSIX_DateTime_now(UA_EventLoop *public_el) {
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)public_el;
+    UA_DateTime now = el->cachedNow;
+    if(el->coarseClock && now != 0)
+        return now;
+    return UA_EventLoopPOSIX_readClock(el);
+}
+
+static UA_DateTime
+UA_EventLoopPOSIX_DateTime_nowMonotonic(UA_EventLoop *public_el) {
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)public_el;
+    UA_DateTime now = el->cachedNowMonotonic;
+    if(el->coarseClock && now != 0)
+        return now;
+    return UA_EventLoopPOSIX_readClockMonotonic(el);
+}
+
 static UA_Int64
 UA_EventLoopPOSIX_DateTime_localTimeUtcOffset(UA_EventLoop *el) {
     /* TODO: Fix for custom clock sources */
@@ -487,7 +837,7 @@ UA_EventLoopPOSIX_free(UA_EventLoopPOSIX *el) {
     }
 
     /* Remove the repeated timed callbacks */
-    UA_Timer_clear(&el->timer);
+    UA_EL_TIMER(clear)(&el->timer);
 
     /* Process remaining delayed callbacks */
     processDelayed(el);
@@ -498,6 +848,8 @@ UA_EventLoopPOSIX_free(UA_EventLoopPOSIX *el) {
 #endif
 
     UA_KeyValueMap_clear(&el->eventLoop.params);
+    UA_EventLoopProfiler_clear(&el->profiler);
+    UA_NetworkBufferPool_clear(&el->bufferPool);
 
     /* Clean up */
     UA_UNLOCK(&el->elMutex);
@@ -514,7 +866,13 @@ UA_EventLoop_new_POSIX(const UA_Logger *logger) {
         return NULL;
 
     UA_LOCK_INIT(&el->elMutex);
-    UA_Timer_init(&el->timer);
+    UA_LOCK_SETRANK(&el->elMutex, UA_LOCKRANK_EVENTLOOP);
+    UA_EL_TIMER(init)(&el->timer);
+    UA_EventLoopProfiler_init(&el->profiler);
+
+    /* The queue of delayed callbacks starts with the stub */
+    el->delayedHead = &el->delayedStub;
+    el->delayedTail = &el->delayedStub;
 
 #ifdef _WIN32
     /* Start the WSA networking subsystem on Windows */
@@ -551,6 +909,19 @@ UA_EventLoop_new_POSIX(const UA_Logger *logger) {
         (UA_StatusCode (*)(UA_EventLoop*, UA_EventSource*))
         UA_EventLoopPOSIX_deregisterEventSource;
 
+    el->eventLoop.getStatistics =
+        (void (*)(UA_EventLoop*, UA_EventLoopStatistics*))
+        UA_EventLoopPOSIX_getStatistics;
+    el->eventLoop.setProfiling =
+        (UA_StatusCode (*)(UA_EventLoop*, UA_Boolean, size_t))
+        UA_EventLoopPOSIX_setProfiling;
+    el->eventLoop.getProfile =
+        (UA_StatusCode (*)(UA_EventLoop*, UA_EventLoopProfileEntry**, size_t*))
+        UA_EventLoopPOSIX_getProfile;
+    el->eventLoop.printProfileTrace =
+        (UA_StatusCode (*)(UA_EventLoop*, UA_String*))
+        UA_EventLoopPOSIX_printProfileTrace;
+
     return &el->eventLoop;
 }
 
@@ -564,8 +935,19 @@ UA_EventLoopPOSIX_allocNetworkBuffer(UA_ConnectionManager *cm,
                                      UA_ByteString *buf,
                                      size_t bufSize) {
     UA_POSIXConnectionManager *pcm = (UA_POSIXConnectionManager*)cm;
-    if(pcm->txBuffer.length == 0)
+    if(pcm->txBuffer.length == 0) {
+        /* Take from the pool if the buffer fits */
+        UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+        if(bufSize > 0 && bufSize <= el->bufferPool.bufferSize) {
+            UA_Byte *data = UA_NetworkBufferPool_take(&el->bufferPool);
+            if(data) {
+                buf->data = data;
+                buf->length = bufSize;
+                return UA_STATUSCODE_GOOD;
+            }
+        }
         return UA_ByteString_allocBuffer(buf, bufSize);
+    }
     if(pcm->txBuffer.length < bufSize)
         return UA_STATUSCODE_BADOUTOFMEMORY;
     *buf = pcm->txBuffer;
@@ -578,12 +960,27 @@ UA_EventLoopPOSIX_freeNetworkBuffer(UA_ConnectionManager *cm,
                                     uintptr_t connectionId,
                                     UA_ByteString *buf) {
     UA_POSIXConnectionManager *pcm = (UA_POSIXConnectionManager*)cm;
-    if(pcm->txBuffer.data == buf->data)
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    if(pcm->txBuffer.data == buf->data ||
+       UA_NetworkBufferPool_release(&el->bufferPool, buf->data))
         UA_ByteString_init(buf);
     else
         UA_ByteString_clear(buf);
 }
 
+/* Only buffers from the pool can be retained. Also parts of a received buffer
+ * can be retained. The buffer is reused once all parts are released. */
+UA_StatusCode
+UA_EventLoopPOSIX_retainNetworkBuffer(UA_ConnectionManager *cm,
+                                      uintptr_t connectionId,
+                                      const UA_ByteString *buf) {
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    if(buf->length == 0 ||
+       !UA_NetworkBufferPool_retain(&el->bufferPool, buf->data))
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+    return UA_STATUSCODE_GOOD;
+}
+
 UA_StatusCode
 UA_EventLoopPOSIX_allocateStaticBuffers(UA_POSIXConnectionManager *pcm) {
     UA_StatusCode res = UA_STATUSCODE_GOOD;
@@ -662,24 +1059,63 @@ UA_EventLoopPOSIX_setReusable(UA_FD sockfd) {
 #endif
 }
 
+void
+UA_EventLoopPOSIX_setBusyPoll(UA_EventLoopPOSIX *el, UA_FD sockfd) {
+    if(el->busyPoll <= 0)
+        return;
+#ifdef SO_BUSY_POLL
+    int val = (int)(el->busyPoll / UA_DATETIME_USEC);
+    if(UA_setsockopt(sockfd, SOL_SOCKET, SO_BUSY_POLL, &val, sizeof(val)) != 0) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                        "Socket %u\t| Could not set SO_BUSY_POLL (%s)",
+                        (unsigned)sockfd, errno_str));
+    }
+#endif
+}
+
 /************************/
 /* Select / epoll Logic */
 /************************/
 
-/* Re-arm the self-pipe socket for the next signal by reading from it */
+/* Re-arm the self-pipe socket for the next signal by reading from it. Clear
+ * the pending flag first, so that no wakeup between the read and clearing the
+ * flag gets lost. */
 static void
-flushSelfPipe(UA_SOCKET s) {
+flushSelfPipe(UA_EventLoopPOSIX *el) {
+    UA_atomic_xchg(&el->wakeupPending, NULL);
+#if defined(_WIN32)
     char buf[128];
-#ifdef _WIN32
-    recv(s, buf, 128, 0);
+    recv(el->selfpipe[0], buf, 128, 0);
+#elif defined(UA_HAVE_EVENTFD)
+    uint64_t counter;
+    ssize_t i = read(el->selfpipe[0], &counter, sizeof(counter));
+    (void)i;
 #else
+    char buf[128];
     ssize_t i;
     do {
-        i = read(s, buf, 128);
+        i = read(el->selfpipe[0], buf, 128);
     } while(i > 0);
 #endif
 }
 
+/* Call the EventSource callback for the fd. With profiling if enabled. */
+static void
+UA_EventLoopPOSIX_callFD(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd,
+                         short event) {
+    if(!el->profiler.enabled) {
+        rfd->eventSourceCB(rfd->es, rfd, event);
+        return;
+    }
+    UA_FD fd = rfd->fd;
+    UA_DateTime start = UA_EventLoopPOSIX_readClockMonotonic(el);
+    rfd->eventSourceCB(rfd->es, rfd, event);
+    UA_DateTime end = UA_EventLoopPOSIX_readClockMonotonic(el);
+    UA_EventLoopProfiler_record(&el->profiler, UA_EVENTLOOPPROFILETYPE_FD,
+                                (UA_UInt64)fd, start, end, false);
+}
+
 #if !defined(UA_HAVE_EPOLL)
 
 UA_StatusCode
@@ -779,6 +1215,7 @@ UA_StatusCode
 UA_EventLoopPOSIX_pollFDs(UA_EventLoopPOSIX *el, UA_DateTime listenTimeout) {
     UA_assert(listenTimeout >= 0);
     UA_LOCK_ASSERT(&el->elMutex);
+    el->pollEvents = 0;
 
     fd_set readset, writeset, errset;
     UA_FD highestfd = setFDSets(el, &readset, &writeset, &errset);
@@ -800,9 +1237,12 @@ UA_EventLoopPOSIX_pollFDs(UA_EventLoopPOSIX *el, UA_DateTime listenTimeout) {
 #endif
     };
 
+    UA_DateTime waitStart = UA_EventLoopPOSIX_readClockMonotonic(el);
     UA_UNLOCK(&el->elMutex);
     int selectStatus = UA_select(highestfd+1, &readset, &writeset, &errset, &tmptv);
     UA_LOCK(&el->elMutex);
+    el->waitTime += UA_EventLoopPOSIX_updateClock(el) - waitStart;
+    el->pollEvents = (selectStatus > 0) ? (size_t)selectStatus : 0;
     if(selectStatus < 0) {
         /* We will retry, only log the error */
         UA_LOG_SOCKET_ERRNO_WRAP(
@@ -813,7 +1253,7 @@ UA_EventLoopPOSIX_pollFDs(UA_EventLoopPOSIX *el, UA_DateTime listenTimeout) {
 
     /* The self-pipe has received. Clear the buffer by reading. */
     if(UA_UNLIKELY(FD_ISSET(el->selfpipe[0], &readset)))
-        flushSelfPipe(el->selfpipe[0]);
+        flushSelfPipe(el);
 
     /* Loop over all registered FD to see if an event arrived. Yes, this is why
      * select is slow for many open sockets. */
@@ -842,7 +1282,7 @@ UA_EventLoopPOSIX_pollFDs(UA_EventLoopPOSIX *el, UA_DateTime listenTimeout) {
                      (unsigned)rfd->fd);
 
         /* Call the EventSource callback */
-        rfd->eventSourceCB(rfd->es, rfd, event);
+        UA_EventLoopPOSIX_callFD(el, rfd, event);
 
         /* The fd has removed itself */
         if(i == el->fdsSize || rfd != el->fds[i])
@@ -913,21 +1353,37 @@ UA_EventLoopPOSIX_pollFDs(UA_EventLoopPOSIX *el, UA_DateTime listenTimeout) {
     UA_assert(listenTimeout >= 0);
 
     /* Poll the registered sockets */
-    struct epoll_event epoll_events[64];
+    struct epoll_event *epoll_events = el->epollEvents;
+    int maxEvents = (el->epollEventsSize < INT_MAX) ?
+        (int)el->epollEventsSize : INT_MAX;
     int epollfd = el->epollfd;
+    UA_DateTime waitStart = UA_EventLoopPOSIX_readClockMonotonic(el);
     UA_UNLOCK(&el->elMutex);
-    int events = epoll_wait(epollfd, epoll_events, 64,
+    int events;
+#ifdef UA_HAVE_EPOLL_PWAIT2
+    /* Wake up precisely for the next cyclic callback. With epoll_wait, the
+     * timeout is rounded down to milliseconds. */
+    if(!el->noPwait2) {
+        struct timespec precisionTimeout = {
+            (time_t)(listenTimeout / UA_DATETIME_SEC),
+            (long)((listenTimeout % UA_DATETIME_SEC) * 100)
+        };
+        events = epoll_pwait2(epollfd, epoll_events, maxEvents,
+                              &precisionTimeout, NULL);
+        if(events == -1 && errno == ENOSYS) {
+            el->noPwait2 = true;
+            events = epoll_wait(epollfd, epoll_events, maxEvents,
+                                (int)(listenTimeout / UA_DATETIME_MSEC));
+        }
+    } else
+#endif
+    {
+        events = epoll_wait(epollfd, epoll_events, maxEvents,
                             (int)(listenTimeout / UA_DATETIME_MSEC));
-    /* TODO: Replace with pwait2 for higher-precision timeouts once this is
-     * available in the standard library.
-     *
-     * struct timespec precisionTimeout = {
-     *  (long)(listenTimeout / UA_DATETIME_SEC),
-     *   (long)((listenTimeout % UA_DATETIME_SEC) * 100)
-     * };
-     * int events = epoll_pwait2(epollfd, epoll_events, 64,
-     *                        precisionTimeout, NULL); */
+    }
     UA_LOCK(&el->elMutex);
+    el->waitTime += UA_EventLoopPOSIX_updateClock(el) - waitStart;
+    el->pollEvents = (events > 0) ? (size_t)events : 0;
 
     /* Handle error conditions */
     if(events == -1) {
@@ -950,7 +1406,7 @@ UA_EventLoopPOSIX_pollFDs(UA_EventLoopPOSIX *el, UA_DateTime listenTimeout) {
 
         /* The self-pipe has received */
         if(!rfd) {
-            flushSelfPipe(el->selfpipe[0]);
+            flushSelfPipe(el);
             continue;
         }
 
@@ -970,7 +1426,7 @@ UA_EventLoopPOSIX_pollFDs(UA_EventLoopPOSIX *el, UA_DateTime listenTimeout) {
         }
 
         /* Call the EventSource callback */
-        rfd->eventSourceCB(rfd->es, rfd, revent);
+        UA_EventLoopPOSIX_callFD(el, rfd, revent);
     }
     return UA_STATUSCODE_GOOD;
 }
@@ -1020,13 +1476,21 @@ UA_EventLoopPOSIX_cancel(UA_EventLoopPOSIX *el) {
     if(!el->executing)
         return;
 
+    /* A wakeup is already pending */
+    if(UA_atomic_cmpxchg(&el->wakeupPending, NULL, (void*)0x01) != NULL)
+        return;
+
     /* Trigger the self-pipe */
-#ifdef _WIN32
+#if defined(_WIN32)
     int err = send(el->selfpipe[1], ".", 1, 0);
+#elif defined(UA_HAVE_EVENTFD)
+    uint64_t one = 1;
+    ssize_t err = write(el->selfpipe[1], &one, sizeof(one));
 #else
     ssize_t err = write(el->selfpipe[1], ".", 1);
 #endif
     if(err <= 0) {
+        UA_atomic_xchg(&el->wakeupPending, NULL);
         UA_LOG_SOCKET_ERRNO_WRAP(
             UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
                            "Eventloop\t| Error signaling self-pipe (%s)", errno_str));
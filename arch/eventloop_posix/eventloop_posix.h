@@ -15,7 +15,9 @@
 #include <open62541/plugin/eventloop.h>
 
 #include "../eventloop_common/timer.h"
+#include "../eventloop_common/timer_wheel.h"
 #include "../eventloop_common/eventloop_common.h"
+#include "../eventloop_common/profiler.h"
 #include "../../deps/mp_printf.h"
 #include "../../deps/open62541_queue.h"
 
@@ -111,6 +113,7 @@ typedef SSIZE_T ssize_t;
 #include <netdb.h>
 #include <sys/ioctl.h>
 #include <sys/select.h>
+#include <sys/uio.h>
 #include <net/if.h>
 #include <poll.h>
 #include <fcntl.h>
@@ -165,6 +168,8 @@ typedef int SOCKET;
 #if defined(__linux__) && !defined(__TINYC__)
 # define UA_HAVE_EPOLL
 # include <sys/epoll.h>
+# define UA_HAVE_EVENTFD
+# include <sys/eventfd.h>
 #endif
 
 #endif
@@ -236,14 +241,76 @@ typedef struct {
     UA_FDTree fds;
 } UA_POSIXConnectionManager;
 
+/* Pool of network buffers with a fixed size. The buffers are carved from a
+ * single memory region that is mapped with huge pages if possible. Taking and
+ * releasing buffers is lock-free. The free buffers are kept in a stack whose
+ * head carries a counter against the ABA problem. Every buffer has a reference
+ * count so that (parts of) a received buffer can be retained by the
+ * application beyond the receive callback. */
+typedef struct {
+    UA_Byte *memory;       /* NULL if the pool is disabled */
+    size_t memorySize;
+    size_t bufferSize;
+    UA_UInt32 buffersSize;
+    UA_Boolean hugePages;  /* Mapped with MAP_HUGETLB */
+    UA_UInt32 *next;       /* Next free buffer (index + 1, zero at the end) */
+    UA_UInt32 *refCount;
+    UA_UInt64 freeHead;    /* Counter in the upper 32 bit, the lower 32 bit are
+                            * the index + 1 of the first free buffer */
+
+    /* Statistics */
+    size_t inUse;
+    UA_UInt64 misses;      /* The pool was exhausted */
+} UA_NetworkBufferPool;
+
+UA_StatusCode
+UA_NetworkBufferPool_init(UA_NetworkBufferPool *bp, const UA_Logger *logger,
+                          UA_UInt32 buffers, size_t bufferSize);
+
+/* All buffers must be released before */
+void
+UA_NetworkBufferPool_clear(UA_NetworkBufferPool *bp);
+
+/* Returns NULL if the pool is disabled or exhausted */
+UA_Byte *
+UA_NetworkBufferPool_take(UA_NetworkBufferPool *bp);
+
+/* The position can point anywhere into the buffer. Returns false if the
+ * position is not inside a buffer of the pool. */
+UA_Boolean
+UA_NetworkBufferPool_retain(UA_NetworkBufferPool *bp, const UA_Byte *pos);
+
+UA_Boolean
+UA_NetworkBufferPool_release(UA_NetworkBufferPool *bp, const UA_Byte *pos);
+
+/* The timing wheel has the same interface as the ziptree-based timer */
+#ifdef UA_ENABLE_TIMER_WHEEL
+#define UA_EL_TIMER(fn) UA_TimerWheel_##fn
+#else
+#define UA_EL_TIMER(fn) UA_Timer_##fn
+#endif
+
 typedef struct {
     UA_EventLoop eventLoop;
 
     /* Timer */
+#ifdef UA_ENABLE_TIMER_WHEEL
+    UA_TimerWheel timer;
+#else
     UA_Timer timer;
+#endif
 
-    /* Linked List of Delayed Callbacks */
-    UA_DelayedCallback *delayedCallbacks;
+    /* Delayed callbacks are added without a lock to an intrusive
+     * multi-producer single-consumer queue. The producers append at the
+     * delayedHead. While holding the elMutex, the EventLoop takes the entries
+     * from the delayedTail in FIFO order and appends them to the ready list.
+     * The stub entry keeps the queue from ever becoming empty, so that the
+     * producers never touch the delayedTail. */
+    UA_DelayedCallback * volatile delayedHead;
+    UA_DelayedCallback *delayedTail;
+    UA_DelayedCallback delayedStub;
+    UA_DelayedCallback *delayedReady;
+    UA_DelayedCallback *delayedReadyLast;
 
     /* Flag determining whether the eventloop is currently within the
      * "run" method */
@@ -255,15 +322,54 @@ typedef struct {
     UA_Int32 clockSourceMonotonic;
 #endif
 
+    /* Clock snapshots for the "coarse-clock" parameter. Taken at the start of
+     * every iteration and after the wait for events. Zero when unset. */
+    UA_Boolean coarseClock;
+    volatile UA_DateTime cachedNow;
+    volatile UA_DateTime cachedNowMonotonic;
+
+#if defined(__linux__)
+    /* The real-time scheduling parameters are applied to the thread that
+     * first runs the EventLoop after starting */
+    UA_Boolean threadSchedulingApplied;
+#endif
+
 #if defined(UA_HAVE_EPOLL)
     UA_FD epollfd;
+    struct epoll_event *epollEvents; /* Events received in one epoll_wait */
+    size_t epollEventsSize;
+    UA_Boolean noPwait2; /* epoll_pwait2 is not supported by the kernel */
 #else
     UA_RegisteredFD **fds;
     size_t fdsSize;
 #endif
 
-    /* Self-pipe to cancel blocking wait */
+    /* Self-pipe to cancel blocking wait. With eventfd, both ends are the same
+     * fd. Only one wakeup is pending at a time, so that concurrent cancels
+     * don't write to the self-pipe again before it was flushed. */
     UA_FD selfpipe[2]; /* 0: read, 1: write */
+    void * volatile wakeupPending;
+
+    /* Busy-polling with the "busy-poll" parameter. After socket activity, the
+     * sockets are polled without a timeout for the busyPoll interval before
+     * the EventLoop blocks in the wait for events again. */
+    UA_DateTime busyPoll;
+    UA_DateTime lastActivity;
+    size_t pollEvents; /* Events received during the last pollFDs */
+
+    /* Statistics. The waitTime is set by pollFDs to the time spent in the
+     * blocking wait for events. */
+    UA_DateTime waitTime;
+    UA_UInt64 iterationCount;
+    UA_DateTime iterationTimeLast;
+    UA_DateTime iterationTimeMax;
+    UA_DateTime iterationTimeTotal;
+
+    /* Measures the callbacks if enabled */
+    UA_EventLoopProfiler profiler;
+
+    /* Network buffers shared by the ConnectionManagers */
+    UA_NetworkBufferPool bufferPool;
 
 #if UA_MULTITHREADING >= 100
     UA_Lock elMutex;
@@ -303,6 +409,11 @@ UA_EventLoopPOSIX_freeNetworkBuffer(UA_ConnectionManager *cm,
                                     uintptr_t connectionId,
                                     UA_ByteString *buf);
 
+UA_StatusCode
+UA_EventLoopPOSIX_retainNetworkBuffer(UA_ConnectionManager *cm,
+                                      uintptr_t connectionId,
+                                      const UA_ByteString *buf);
+
 /* Set the socket non-blocking. If the listen-socket is nonblocking, incoming
  * connections inherit this state. */
 UA_StatusCode
@@ -316,22 +427,49 @@ UA_EventLoopPOSIX_setNoSigPipe(UA_FD sockfd);
 UA_StatusCode
 UA_EventLoopPOSIX_setReusable(UA_FD sockfd);
 
+/* Busy-poll the device queue of the socket if the "busy-poll" parameter of the
+ * EventLoop is set. Best effort, failures are only logged. */
+void
+UA_EventLoopPOSIX_setBusyPoll(UA_EventLoopPOSIX *el, UA_FD sockfd);
+
 /* Windows has no pipes. Use a local TCP connection for the self-pipe trick.
- * https://stackoverflow.com/a/3333565 */
+ * https://stackoverflow.com/a/3333565. On Linux, an eventfd replaces the pipe.
+ * Writes to its counter never block and one read resets it. */
 #if defined(_WIN32) || defined(__APPLE__)
 int UA_EventLoopPOSIX_pipe(SOCKET fds[2]);
+#elif defined(UA_HAVE_EVENTFD)
+static UA_INLINE int
+UA_EventLoopPOSIX_pipe(UA_FD fds[2]) {
+    fds[0] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    fds[1] = fds[0];
+    return (fds[0] < 0) ? -1 : 0;
+}
 #else
 # define UA_EventLoopPOSIX_pipe(fds) pipe2(fds, O_NONBLOCK)
 #endif
 
+static UA_INLINE void
+UA_EventLoopPOSIX_closePipe(UA_FD fds[2]) {
+    UA_close(fds[0]);
+    if(fds[1] != fds[0])
+        UA_close(fds[1]);
+}
+
 /* Cancel the current _run by sending to the self-pipe */
 void
 UA_EventLoopPOSIX_cancel(UA_EventLoopPOSIX *el);
 
+/* Non-blocking, can be called from any thread and from an interrupt context */
 void
 UA_EventLoopPOSIX_addDelayedCallback(UA_EventLoop *public_el,
                                      UA_DelayedCallback *dc);
 
+/* Delayed callbacks are queued or ready for processing */
+static UA_INLINE UA_Boolean
+UA_EventLoopPOSIX_hasDelayed(UA_EventLoopPOSIX *el) {
+    return (el->delayedReady != NULL || el->delayedHead != &el->delayedStub);
+}
+
 _UA_END_DECLS
 
 #endif /* defined(UA_ARCHITECTURE_POSIX) || defined(UA_ARCHITECTURE_WIN32) */
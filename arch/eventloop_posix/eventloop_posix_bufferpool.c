@@ -0,0 +1,223 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "eventloop_posix.h"
+
+#if defined(UA_ARCHITECTURE_POSIX)
+#include <sys/mman.h>
+#endif
+
+/*********************/
+/* Atomic Operations */
+/*********************/
+
+#if UA_MULTITHREADING >= 100 && defined(_WIN32)
+# define BP_LOAD32(x) ((UA_UInt32)InterlockedOr((volatile LONG*)&(x), 0))
+# define BP_STORE32(x, v) (void)InterlockedExchange((volatile LONG*)&(x), (LONG)(v))
+# define BP_LOAD64(x) ((UA_UInt64)InterlockedOr64((volatile LONG64*)&(x), 0))
+# define BP_CAS64(x, exp, des)                                          \
+    ((UA_UInt64)InterlockedCompareExchange64((volatile LONG64*)&(x),    \
+                                             (LONG64)(des), (LONG64)(exp)) == (exp))
+# define BP_INC32(x) ((UA_UInt32)InterlockedIncrement((volatile LONG*)&(x)))
+# define BP_DEC32(x) ((UA_UInt32)InterlockedDecrement((volatile LONG*)&(x)))
+# define BP_ADD(x, v) (void)InterlockedExchangeAdd64((volatile LONG64*)&(x), (LONG64)(v))
+#elif UA_MULTITHREADING >= 100 && defined(__GNUC__)
+# define BP_LOAD32(x) __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+# define BP_STORE32(x, v) __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+# define BP_LOAD64(x) __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+# define BP_CAS64(x, exp, des)                                          \
+    __atomic_compare_exchange_n(&(x), &(exp), (des), false,             \
+                                __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+# define BP_INC32(x) __atomic_add_fetch(&(x), 1, __ATOMIC_ACQ_REL)
+# define BP_DEC32(x) __atomic_sub_fetch(&(x), 1, __ATOMIC_ACQ_REL)
+# define BP_ADD(x, v) (void)__atomic_add_fetch(&(x), (v), __ATOMIC_RELAXED)
+#else
+# define BP_LOAD32(x) (x)
+# define BP_STORE32(x, v) (void)((x) = (v))
+# define BP_LOAD64(x) (x)
+# define BP_CAS64(x, exp, des) ((x) == (exp) ? ((x) = (des), true) : false)
+# define BP_INC32(x) (++(x))
+# define BP_DEC32(x) (--(x))
+# define BP_ADD(x, v) (void)((x) += (v))
+#endif
+
+#define BP_HUGEPAGESIZE ((size_t)2 << 20)
+
+/******************/
+/* Memory Mapping */
+/******************/
+
+static UA_Byte *
+mapMemory(UA_NetworkBufferPool *bp, const UA_Logger *logger) {
+#if defined(UA_ARCHITECTURE_POSIX)
+    void *mem = MAP_FAILED;
+
+# ifdef MAP_HUGETLB
+    /* Explicit huge pages. Fails unless the administrator has reserved huge
+     * pages (vm.nr_hugepages). */
+    size_t hugeSize = (bp->memorySize + BP_HUGEPAGESIZE - 1) & ~(BP_HUGEPAGESIZE - 1);
+    mem = mmap(NULL, hugeSize, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if(mem != MAP_FAILED) {
+        bp->memorySize = hugeSize;
+        bp->hugePages = true;
+        return (UA_Byte*)mem;
+    }
+# endif
+
+    mem = mmap(NULL, bp->memorySize, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(mem == MAP_FAILED) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_WARNING(logger, UA_LOGCATEGORY_EVENTLOOP,
+                          "Eventloop\t| Could not map the network buffer pool (%s)",
+                          errno_str));
+        return NULL;
+    }
+
+# ifdef MADV_HUGEPAGE
+    /* Ask for transparent huge pages instead */
+    madvise(mem, bp->memorySize, MADV_HUGEPAGE);
+# endif
+    return (UA_Byte*)mem;
+#else
+    return (UA_Byte*)UA_malloc(bp->memorySize);
+#endif
+}
+
+static void
+unmapMemory(UA_NetworkBufferPool *bp) {
+#if defined(UA_ARCHITECTURE_POSIX)
+    munmap(bp->memory, bp->memorySize);
+#else
+    UA_free(bp->memory);
+#endif
+}
+
+/***************/
+/* Buffer Pool */
+/***************/
+
+UA_StatusCode
+UA_NetworkBufferPool_init(UA_NetworkBufferPool *bp, const UA_Logger *logger,
+                          UA_UInt32 buffers, size_t bufferSize) {
+    memset(bp, 0, sizeof(UA_NetworkBufferPool));
+    if(buffers == 0 || bufferSize == 0)
+        return UA_STATUSCODE_GOOD; /* Disabled */
+    if(bufferSize > SIZE_MAX / buffers)
+        return UA_STATUSCODE_BADOUTOFRANGE;
+
+    bp->next = (UA_UInt32*)UA_calloc(buffers, sizeof(UA_UInt32));
+    bp->refCount = (UA_UInt32*)UA_calloc(buffers, sizeof(UA_UInt32));
+    if(!bp->next || !bp->refCount) {
+        UA_free(bp->next);
+        UA_free(bp->refCount);
+        bp->next = NULL;
+        bp->refCount = NULL;
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+
+    bp->bufferSize = bufferSize;
+    bp->buffersSize = buffers;
+    bp->memorySize = bufferSize * buffers;
+    bp->memory = mapMemory(bp, logger);
+    if(!bp->memory) {
+        UA_free(bp->next);
+        UA_free(bp->refCount);
+        memset(bp, 0, sizeof(UA_NetworkBufferPool));
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+
+    /* All buffers are free */
+    for(UA_UInt32 i = 0; i < buffers; i++)
+        bp->next[i] = (i + 1 < buffers) ? i + 2 : 0;
+    bp->freeHead = 1;
+
+    UA_LOG_INFO(logger, UA_LOGCATEGORY_EVENTLOOP,
+                "Eventloop\t| Network buffer pool with %u buffers of %u bytes "
+                "(%s)", (unsigned)buffers, (unsigned)bufferSize,
+                (bp->hugePages) ? "huge pages" : "normal pages");
+    return UA_STATUSCODE_GOOD;
+}
+
+void
+UA_NetworkBufferPool_clear(UA_NetworkBufferPool *bp) {
+    if(!bp->memory)
+        return;
+    unmapMemory(bp);
+    UA_free(bp->next);
+    UA_free(bp->refCount);
+    memset(bp, 0, sizeof(UA_NetworkBufferPool));
+}
+
+UA_Byte *
+UA_NetworkBufferPool_take(UA_NetworkBufferPool *bp) {
+    if(!bp->memory)
+        return NULL;
+
+    /* Pop from the free stack */
+    UA_UInt64 head = BP_LOAD64(bp->freeHead);
+    UA_UInt32 index;
+    while(true) {
+        index = (UA_UInt32)head;
+        if(index == 0) {
+            BP_ADD(bp->misses, 1);
+            return NULL;
+        }
+        UA_UInt64 newHead = (((head >> 32) + 1) << 32) |
+            BP_LOAD32(bp->next[index - 1]);
+        if(BP_CAS64(bp->freeHead, head, newHead))
+            break;
+#if UA_MULTITHREADING >= 100 && defined(_WIN32)
+        head = BP_LOAD64(bp->freeHead);
+#endif
+    }
+
+    index--;
+    BP_STORE32(bp->refCount[index], 1);
+    BP_ADD(bp->inUse, 1);
+    return &bp->memory[index * bp->bufferSize];
+}
+
+static UA_Boolean
+getIndex(const UA_NetworkBufferPool *bp, const UA_Byte *pos, UA_UInt32 *index) {
+    if(!bp->memory || pos < bp->memory ||
+       pos >= &bp->memory[(size_t)bp->buffersSize * bp->bufferSize])
+        return false;
+    *index = (UA_UInt32)((size_t)(pos - bp->memory) / bp->bufferSize);
+    return true;
+}
+
+UA_Boolean
+UA_NetworkBufferPool_retain(UA_NetworkBufferPool *bp, const UA_Byte *pos) {
+    UA_UInt32 index;
+    if(!getIndex(bp, pos, &index))
+        return false;
+    BP_INC32(bp->refCount[index]);
+    return true;
+}
+
+UA_Boolean
+UA_NetworkBufferPool_release(UA_NetworkBufferPool *bp, const UA_Byte *pos) {
+    UA_UInt32 index;
+    if(!getIndex(bp, pos, &index))
+        return false;
+    if(BP_DEC32(bp->refCount[index]) > 0)
+        return true;
+
+    /* Push to the free stack */
+    UA_UInt64 head = BP_LOAD64(bp->freeHead);
+    while(true) {
+        BP_STORE32(bp->next[index], (UA_UInt32)head);
+        UA_UInt64 newHead = (((head >> 32) + 1) << 32) | (index + 1);
+        if(BP_CAS64(bp->freeHead, head, newHead))
+            break;
+#if UA_MULTITHREADING >= 100 && defined(_WIN32)
+        head = BP_LOAD64(bp->freeHead);
+#endif
+    }
+    BP_ADD(bp->inUse, (size_t)-1);
+    return true;
+}
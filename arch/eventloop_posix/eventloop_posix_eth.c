@@ -16,6 +16,7 @@
 #include <net/ethernet.h> /* ETH_P_*/
 #include <linux/if_packet.h>
 #include <linux/net_tstamp.h> /* txtime */
+#include <sys/mman.h> /* PACKET_MMAP ring */
 
 /* Configuration parameters */
 
@@ -26,7 +27,7 @@ static UA_KeyValueRestriction ethManagerParams[ETH_MANAGERPARAMS] = {
     {{0, UA_STRING_STATIC("send-bufsize")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false}
 };
 
-#define ETH_PARAMETERSSIZE 15
+#define ETH_PARAMETERSSIZE 18
 #define ETH_PARAMINDEX_ADDR 0
 #define ETH_PARAMINDEX_LISTEN 1
 #define ETH_PARAMINDEX_IFACE 2
@@ -42,6 +43,9 @@ static UA_KeyValueRestriction ethManagerParams[ETH_MANAGERPARAMS] = {
 #define ETH_PARAMINDEX_TXTIME_PICO 12
 #define ETH_PARAMINDEX_TXTIME_DROP 13
 #define ETH_PARAMINDEX_VALIDATE 14
+#define ETH_PARAMINDEX_RINGFRAMES 15
+#define ETH_PARAMINDEX_QDISCBYPASS 16
+#define ETH_PARAMINDEX_BUSYPOLL 17
 
 static UA_KeyValueRestriction ethConnectionParams[ETH_PARAMETERSSIZE+1] = {
     {{0, UA_STRING_STATIC("address")}, &UA_TYPES[UA_TYPES_STRING], false, true, false},
@@ -59,6 +63,9 @@ static UA_KeyValueRestriction ethConnectionParams[ETH_PARAMETERSSIZE+1] = {
     {{0, UA_STRING_STATIC("txtime-pico")}, &UA_TYPES[UA_TYPES_UINT16], false, true, false},
     {{0, UA_STRING_STATIC("txtime-drop-late")}, &UA_TYPES[UA_TYPES_BOOLEAN], false, true, false},
     {{0, UA_STRING_STATIC("validate")}, &UA_TYPES[UA_TYPES_BOOLEAN], false, true, false},
+    {{0, UA_STRING_STATIC("ring-frames")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false},
+    {{0, UA_STRING_STATIC("qdisc-bypass")}, &UA_TYPES[UA_TYPES_BOOLEAN], false, true, false},
+    {{0, UA_STRING_STATIC("busy-poll")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false},
     /* Duplicated address parameter with a scalar value required. For the send-socket case. */
     {{0, UA_STRING_STATIC("address")}, &UA_TYPES[UA_TYPES_STRING], true, true, false},
 };
@@ -84,8 +91,25 @@ typedef struct {
     unsigned char lengthOffset; /* No length field if zero */
 
     UA_Boolean txtimeEnabled;
+
+    /* PACKET_MMAP ring shared with the kernel (optional). Listen connections
+     * have a receive ring, send connections a send ring. Messages for sending
+     * are encoded in-place in the ring frames. */
+    UA_Byte *ring;
+    size_t frameSize;
+    size_t frameCount;
+    size_t ringHead; /* Next frame to receive or to reserve for sending */
+    UA_Boolean ringTx;
 } ETH_FD;
 
+/* The data of a frame in the send ring begins at a fixed offset */
+#define ETH_TX_DATAOFFSET (TPACKET2_HDRLEN - sizeof(struct sockaddr_ll))
+
+/* Frames in the send ring that are handed out for encoding but not yet
+ * requested for sending. The kernel stops at the first frame not requested for
+ * sending. So the frames are sent in the order of their reservation. */
+#define ETH_TX_RESERVED TP_STATUS_WRONG_FORMAT
+
 /* The format of a Ethernet address is six groups of hexadecimal digits,
  * separated by hyphens (e.g. 01-23-45-67-89-ab). */
 static UA_StatusCode
@@ -206,23 +230,211 @@ setETHHeader(unsigned char *buf,
     return (unsigned char)pos;
 }
 
+/*******************/
+/* PACKET_MMAP Ring */
+/*******************/
+
+/* The frames of the ring are shared with the kernel. Received frames are handed
+ * to the application without copying. Messages for sending are encoded directly
+ * into a reserved frame. Then the kernel is triggered to send all requested
+ * frames with a single syscall. */
+
+static struct tpacket2_hdr *
+ETH_ringFrame(ETH_FD *conn, size_t index) {
+    return (struct tpacket2_hdr*)(conn->ring + (index * conn->frameSize));
+}
+
+static UA_Boolean
+ETH_inRing(ETH_FD *conn, const UA_Byte *data) {
+    return (conn->ring && data >= conn->ring &&
+            data < conn->ring + (conn->frameSize * conn->frameCount));
+}
+
+static UA_StatusCode
+ETH_setupRing(UA_EventLoopPOSIX *el, ETH_FD *conn, const char *ifname,
+              UA_UInt32 frames, UA_Boolean tx) {
+    UA_FD fd = conn->rfd.fd;
+
+    /* The frames must hold the MTU plus the Ethernet and ring headers */
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(struct ifreq));
+    strncpy(ifr.ifr_name, ifname, IFNAMSIZ - 1);
+    if(ioctl(fd, SIOCGIFMTU, &ifr) == -1) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                        "ETH %u\t| Cannot get the MTU, %s", (unsigned)fd, errno_str));
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+    size_t minFrameSize = TPACKET_ALIGN(TPACKET2_HDRLEN) +
+        UA_ETH_MAXHEADERLENGTH + (size_t)ifr.ifr_mtu;
+    size_t frameSize = (size_t)getpagesize();
+    while(frameSize < minFrameSize)
+        frameSize <<= 1;
+
+    /* Configure the ring. One frame per block. Let the kernel skip frames with
+     * an invalid length in the send ring (released without sending). */
+    int version = TPACKET_V2;
+    int loss = 1;
+    struct tpacket_req req;
+    memset(&req, 0, sizeof(struct tpacket_req));
+    req.tp_block_size = (unsigned)frameSize;
+    req.tp_block_nr = frames;
+    req.tp_frame_size = (unsigned)frameSize;
+    req.tp_frame_nr = frames;
+    if(setsockopt(fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) != 0 ||
+       (tx && setsockopt(fd, SOL_PACKET, PACKET_LOSS, &loss, sizeof(loss)) != 0) ||
+       setsockopt(fd, SOL_PACKET, (tx) ? PACKET_TX_RING : PACKET_RX_RING,
+                  &req, sizeof(req)) != 0) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                        "ETH %u\t| Could not set up the PACKET_MMAP ring (%s)",
+                        (unsigned)fd, errno_str));
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    void *ring = mmap(NULL, frameSize * frames, PROT_READ | PROT_WRITE,
+                      MAP_SHARED, fd, 0);
+    if(ring == MAP_FAILED) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                        "ETH %u\t| Could not map the PACKET_MMAP ring (%s)",
+                        (unsigned)fd, errno_str));
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    conn->ring = (UA_Byte*)ring;
+    conn->frameSize = frameSize;
+    conn->frameCount = frames;
+    conn->ringHead = 0;
+    conn->ringTx = tx;
+
+    UA_LOG_INFO(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                "ETH %u\t| Using a PACKET_MMAP %s ring with %u frames of %u bytes",
+                (unsigned)fd, (tx) ? "send" : "receive",
+                (unsigned)frames, (unsigned)frameSize);
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+ETH_freeRing(ETH_FD *conn) {
+    if(!conn->ring)
+        return;
+    munmap(conn->ring, conn->frameSize * conn->frameCount);
+    conn->ring = NULL;
+}
+
+/* Reserve the next frame of the send ring for a frame of the given length
+ * (including the Ethernet header). Returns NULL if no frame is available. */
+static struct tpacket2_hdr *
+ETH_reserveTxFrame(ETH_FD *conn, size_t length) {
+    if(!conn->ringTx || ETH_TX_DATAOFFSET + length > conn->frameSize)
+        return NULL;
+    struct tpacket2_hdr *hdr = ETH_ringFrame(conn, conn->ringHead);
+    if(__atomic_load_n(&hdr->tp_status, __ATOMIC_ACQUIRE) != TP_STATUS_AVAILABLE)
+        return NULL;
+    hdr->tp_status = ETH_TX_RESERVED;
+    conn->ringHead = (conn->ringHead + 1) % conn->frameCount;
+    return hdr;
+}
+
+/* Hand the reserved frame to the kernel. A zero length releases the frame
+ * without sending (the kernel skips it due to PACKET_LOSS). */
+static void
+ETH_requestTxFrame(ETH_FD *conn, const UA_Byte *data, size_t length) {
+    size_t index = (size_t)(data - conn->ring) / conn->frameSize;
+    struct tpacket2_hdr *hdr = ETH_ringFrame(conn, index);
+    hdr->tp_len = (__u32)length;
+    __atomic_store_n(&hdr->tp_status, TP_STATUS_SEND_REQUEST, __ATOMIC_RELEASE);
+}
+
+/* Trigger the kernel to send all requested frames. If the device queue is
+ * full, block until the frames could be handed to the device. */
+static UA_StatusCode
+ETH_flushTxRing(UA_EventLoopPOSIX *el, ETH_FD *conn, UA_Boolean blocking) {
+    int flags = MSG_NOSIGNAL | ((blocking) ? 0 : MSG_DONTWAIT);
+    while(UA_sendto(conn->rfd.fd, NULL, 0, flags,
+                    (struct sockaddr*)&conn->sll, sizeof(conn->sll)) < 0) {
+        if(UA_ERRNO == UA_INTERRUPTED)
+            continue;
+        if(!blocking && (UA_ERRNO == UA_WOULDBLOCK || UA_ERRNO == UA_AGAIN ||
+                         UA_ERRNO == ENOBUFS)) {
+            flags = MSG_NOSIGNAL;
+            blocking = true;
+            continue;
+        }
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                        "ETH %u\t| Send failed with error %s",
+                        (unsigned)conn->rfd.fd, errno_str));
+        return UA_STATUSCODE_BADCONNECTIONCLOSED;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Request sending for a frame with the Ethernet header already set. Messages
+ * that were not encoded in the ring (e.g. the ring was full during allocation)
+ * are copied into a frame. */
+static UA_StatusCode
+ETH_queueTxFrame(UA_EventLoopPOSIX *el, ETH_FD *conn, const UA_ByteString *buf) {
+    if(ETH_inRing(conn, buf->data)) {
+        ETH_requestTxFrame(conn, buf->data, buf->length);
+        return UA_STATUSCODE_GOOD;
+    }
+
+    struct tpacket2_hdr *hdr = ETH_reserveTxFrame(conn, buf->length);
+    if(!hdr) {
+        /* Send out the pending frames to make room */
+        UA_StatusCode res = ETH_flushTxRing(el, conn, true);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+        hdr = ETH_reserveTxFrame(conn, buf->length);
+        if(!hdr) {
+            UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                         "ETH %u\t| No frame of the send ring available",
+                         (unsigned)conn->rfd.fd);
+            return UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+        }
+    }
+
+    UA_Byte *data = (UA_Byte*)hdr + ETH_TX_DATAOFFSET;
+    memcpy(data, buf->data, buf->length);
+    ETH_requestTxFrame(conn, data, buf->length);
+    return UA_STATUSCODE_GOOD;
+}
+
 static UA_StatusCode
 ETH_allocNetworkBuffer(UA_ConnectionManager *cm, uintptr_t connectionId,
                        UA_ByteString *buf, size_t bufSize) {
-    /* Get the ETH_FD */
     UA_POSIXConnectionManager *pcm = (UA_POSIXConnectionManager*)cm;
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    (void)el;
+    UA_LOCK(&el->elMutex);
+
+    /* Get the ETH_FD */
     UA_FD fd = (UA_FD)connectionId;
     ETH_FD *erfd = (ETH_FD*)ZIP_FIND(UA_FDTree, &pcm->fds, &fd);
-    if(!erfd)
+    if(!erfd) {
+        UA_UNLOCK(&el->elMutex);
         return UA_STATUSCODE_BADCONNECTIONREJECTED;
+    }
+
+    /* Encode in-place in a frame of the send ring */
+    unsigned char headerSize = erfd->headerSize;
+    struct tpacket2_hdr *hdr = ETH_reserveTxFrame(erfd, bufSize + headerSize);
+    UA_UNLOCK(&el->elMutex);
+    if(hdr) {
+        buf->data = (UA_Byte*)hdr + ETH_TX_DATAOFFSET + headerSize;
+        buf->length = bufSize;
+        return UA_STATUSCODE_GOOD;
+    }
 
     /* Allocate the buffer with the hidden Ethernet header in front */
     UA_StatusCode res =
         UA_EventLoopPOSIX_allocNetworkBuffer(cm, connectionId, buf,
-                                             bufSize + erfd->headerSize);
+                                             bufSize + headerSize);
     if(UA_LIKELY(res == UA_STATUSCODE_GOOD)) {
-        buf->data   += erfd->headerSize;
-        buf->length -= erfd->headerSize;
+        buf->data   += headerSize;
+        buf->length -= headerSize;
     }
     return res;
 }
@@ -230,16 +442,31 @@ ETH_allocNetworkBuffer(UA_ConnectionManager *cm, uintptr_t connectionId,
 static void
 ETH_freeNetworkBuffer(UA_ConnectionManager *cm, uintptr_t connectionId,
                       UA_ByteString *buf) {
-    /* Get the ETH_FD */
     UA_POSIXConnectionManager *pcm = (UA_POSIXConnectionManager*)cm;
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    (void)el;
+    UA_LOCK(&el->elMutex);
+
+    /* Get the ETH_FD */
     UA_FD fd = (UA_FD)connectionId;
     ETH_FD *erfd = (ETH_FD*)ZIP_FIND(UA_FDTree, &pcm->fds, &fd);
-    if(!erfd)
+    if(!erfd) {
+        UA_UNLOCK(&el->elMutex);
         return;
+    }
+
+    /* Release the frame of the send ring */
+    if(ETH_inRing(erfd, buf->data)) {
+        ETH_requestTxFrame(erfd, buf->data, 0);
+        UA_UNLOCK(&el->elMutex);
+        UA_ByteString_init(buf);
+        return;
+    }
 
     /* Unhide the Ethernet header and free */
     buf->data   -= erfd->headerSize;
     buf->length += erfd->headerSize;
+    UA_UNLOCK(&el->elMutex);
     UA_EventLoopPOSIX_freeNetworkBuffer(cm, connectionId, buf);
 }
 
@@ -284,7 +511,8 @@ ETH_close(UA_POSIXConnectionManager *pcm, ETH_FD *conn) {
                         &UA_KEYVALUEMAP_NULL, UA_BYTESTRING_NULL);
     UA_LOCK(&el->elMutex);
 
-    /* Close the socket */
+    /* Unmap the ring and close the socket */
+    ETH_freeRing(conn);
     int ret = UA_close(conn->rfd.fd);
     if(ret == 0) {
         UA_LOG_INFO(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
@@ -318,59 +546,15 @@ ETH_delayedClose(void *application, void *context) {
     UA_free(conn);
 }
 
-/* Gets called when a socket receives data or closes */
+/* Parse the Ethernet header and forward the frame to the application */
 static void
-ETH_connectionSocketCallback(UA_ConnectionManager *cm, UA_RegisteredFD *rfd,
-                             short event) {
-    UA_POSIXConnectionManager *pcm = (UA_POSIXConnectionManager*)cm;
-    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+ETH_deliver(UA_POSIXConnectionManager *pcm, ETH_FD *conn, UA_ByteString response) {
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)pcm->cm.eventSource.eventLoop;
     UA_LOCK_ASSERT(&el->elMutex);
 
-    ETH_FD *conn = (ETH_FD*)rfd;
-    if(event == UA_FDEVENT_ERR) {
-        UA_LOG_SOCKET_ERRNO_WRAP(
-           UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
-                        "ETH %u\t| recv signaled the socket was shutdown (%s)",
-                        (unsigned)rfd->fd, errno_str));
-        ETH_close(pcm, conn);
-        UA_free(rfd);
-        return;
-    }
-
-    /* Use the already allocated receive-buffer */
-    UA_ByteString response = pcm->rxBuffer;;
-
-    /* Receive */
-#ifndef _WIN32
-    ssize_t ret = UA_recv(rfd->fd, (char*)response.data,
-                          response.length, MSG_DONTWAIT);
-#else
-    int ret = UA_recv(rfd->fd, (char*)response.data,
-                      response.length, MSG_DONTWAIT);
-#endif
-
-    /* Receive has failed */
-    if(ret <= 0) {
-        if(UA_ERRNO == UA_INTERRUPTED)
-            return;
-
-        /* Orderly shutdown of the socket. We can immediately close as no method
-         * "below" in the call stack will use the socket in this iteration of
-         * the EventLoop. */
-        UA_LOG_SOCKET_ERRNO_WRAP(
-           UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
-                        "ETH %u\t| recv signaled the socket was shutdown (%s)",
-                        (unsigned)rfd->fd, errno_str));
-        ETH_close(pcm, conn);
-        UA_free(rfd);
-        return;
-    }
-
     UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
                  "ETH %u\t| Received message of size %u",
-                 (unsigned)rfd->fd, (unsigned)ret);
-
-    response.length = (size_t)ret;
+                 (unsigned)conn->rfd.fd, (unsigned)response.length);
 
     /* Parse the Ethernet header */
     unsigned char destAddr[ETHER_ADDR_LEN];
@@ -420,11 +604,86 @@ ETH_connectionSocketCallback(UA_ConnectionManager *cm, UA_RegisteredFD *rfd,
     response.data += headerSize;
     response.length -= headerSize;
     UA_UNLOCK(&el->elMutex);
-    conn->applicationCB(cm, (uintptr_t)rfd->fd, conn->application, &conn->context,
-                        UA_CONNECTIONSTATE_ESTABLISHED, &map, response);
+    conn->applicationCB(&pcm->cm, (uintptr_t)conn->rfd.fd, conn->application,
+                        &conn->context, UA_CONNECTIONSTATE_ESTABLISHED, &map, response);
     UA_LOCK(&el->elMutex);
-    response.data -= headerSize;
-    response.length += headerSize;
+}
+
+/* Forward all frames the kernel has placed in the receive ring. The frames are
+ * handed to the application in-place and returned to the kernel afterwards. */
+static void
+ETH_receiveRing(UA_POSIXConnectionManager *pcm, ETH_FD *conn) {
+    for(size_t i = 0; i < conn->frameCount; i++) {
+        struct tpacket2_hdr *hdr = ETH_ringFrame(conn, conn->ringHead);
+        if(!(__atomic_load_n(&hdr->tp_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER))
+            break;
+        UA_ByteString frame = {hdr->tp_snaplen, (UA_Byte*)hdr + hdr->tp_mac};
+        ETH_deliver(pcm, conn, frame);
+        __atomic_store_n(&hdr->tp_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+        conn->ringHead = (conn->ringHead + 1) % conn->frameCount;
+
+        /* The connection was shut down in the application callback */
+        if(conn->rfd.dc.callback)
+            break;
+    }
+}
+
+/* Gets called when a socket receives data or closes */
+static void
+ETH_connectionSocketCallback(UA_ConnectionManager *cm, UA_RegisteredFD *rfd,
+                             short event) {
+    UA_POSIXConnectionManager *pcm = (UA_POSIXConnectionManager*)cm;
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    UA_LOCK_ASSERT(&el->elMutex);
+
+    ETH_FD *conn = (ETH_FD*)rfd;
+    if(event == UA_FDEVENT_ERR) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                        "ETH %u\t| recv signaled the socket was shutdown (%s)",
+                        (unsigned)rfd->fd, errno_str));
+        ETH_close(pcm, conn);
+        UA_free(rfd);
+        return;
+    }
+
+    /* Receive from the ring without a syscall */
+    if(conn->ring && !conn->ringTx) {
+        ETH_receiveRing(pcm, conn);
+        return;
+    }
+
+    /* Use the already allocated receive-buffer */
+    UA_ByteString response = pcm->rxBuffer;;
+
+    /* Receive */
+#ifndef _WIN32
+    ssize_t ret = UA_recv(rfd->fd, (char*)response.data,
+                          response.length, MSG_DONTWAIT);
+#else
+    int ret = UA_recv(rfd->fd, (char*)response.data,
+                      response.length, MSG_DONTWAIT);
+#endif
+
+    /* Receive has failed */
+    if(ret <= 0) {
+        if(UA_ERRNO == UA_INTERRUPTED)
+            return;
+
+        /* Orderly shutdown of the socket. We can immediately close as no method
+         * "below" in the call stack will use the socket in this iteration of
+         * the EventLoop. */
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                        "ETH %u\t| recv signaled the socket was shutdown (%s)",
+                        (unsigned)rfd->fd, errno_str));
+        ETH_close(pcm, conn);
+        UA_free(rfd);
+        return;
+    }
+
+    response.length = (size_t)ret;
+    ETH_deliver(pcm, conn, response);
 }
 
 static UA_StatusCode
@@ -471,6 +730,27 @@ ETH_openListenConnection(UA_EventLoopPOSIX *el, ETH_FD *conn,
         }
     }
 
+    /* Busy-poll the device queue for incoming frames (microseconds) */
+    const UA_UInt32 *busyPoll = (const UA_UInt32*)
+        UA_KeyValueMap_getScalar(params, ethConnectionParams[ETH_PARAMINDEX_BUSYPOLL].name,
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+    if(busyPoll && *busyPoll > 0 && !validate) {
+#ifdef SO_BUSY_POLL
+        int busyPollVal = (int)*busyPoll;
+        if(setsockopt(conn->rfd.fd, SOL_SOCKET, SO_BUSY_POLL,
+                      &busyPollVal, sizeof(busyPollVal)) != 0) {
+            UA_LOG_SOCKET_ERRNO_WRAP(
+               UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                            "ETH %u	| setsockopt SO_BUSY_POLL failed with error %s",
+                            (unsigned)conn->rfd.fd, errno_str));
+            return UA_STATUSCODE_BADINTERNALERROR;
+        }
+#else
+        UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                       "ETH %u\t| busy-poll not supported", (unsigned)conn->rfd.fd);
+#endif
+    }
+
     /* Register for multicast if an address is defined */
     const UA_String *address = (const UA_String*)
         UA_KeyValueMap_getScalar(params, ethConnectionParams[ETH_PARAMINDEX_ADDR].name,
@@ -578,6 +858,29 @@ ETH_openSendConnection(UA_EventLoopPOSIX *el, ETH_FD *conn, const UA_KeyValueMap
         }
     }
 
+    /* Hand frames directly to the device queue, bypassing the traffic control
+     * layer of the kernel */
+    const UA_Boolean *qdiscBypass = (const UA_Boolean*)
+        UA_KeyValueMap_getScalar(params,
+                                 ethConnectionParams[ETH_PARAMINDEX_QDISCBYPASS].name,
+                                 &UA_TYPES[UA_TYPES_BOOLEAN]);
+    if(qdiscBypass && *qdiscBypass) {
+#ifdef PACKET_QDISC_BYPASS
+        int bypass = 1;
+        if(setsockopt(conn->rfd.fd, SOL_PACKET, PACKET_QDISC_BYPASS,
+                      &bypass, sizeof(bypass)) != 0) {
+            UA_LOG_SOCKET_ERRNO_WRAP(
+               UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                            "setsockopt PACKET_QDISC_BYPASS failed with error %s",
+                            errno_str));
+            return UA_STATUSCODE_BADINTERNALERROR;
+        }
+#else
+        UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                       "ETH %u\t| qdisc-bypass not supported", (unsigned)conn->rfd.fd);
+#endif
+    }
+
     /* Enable txtime sending */
     const UA_Boolean *txtime_enable = (const UA_Boolean*)
         UA_KeyValueMap_getScalar(params,
@@ -697,7 +1000,6 @@ ETH_openConnection(UA_ConnectionManager *cm, const UA_KeyValueMap *params,
         UA_UNLOCK(&el->elMutex);
         return UA_STATUSCODE_BADINTERNALERROR;
     }
-    res |= UA_EventLoopPOSIX_setReusable(sockfd);
     res |= UA_EventLoopPOSIX_setNonBlocking(sockfd);
     res |= UA_EventLoopPOSIX_setNoSigPipe(sockfd);
     if(res != UA_STATUSCODE_GOOD)
@@ -743,6 +1045,24 @@ ETH_openConnection(UA_ConnectionManager *cm, const UA_KeyValueMap *params,
     if(validate || res != UA_STATUSCODE_GOOD)
         goto cleanup;
 
+    /* Set up the PACKET_MMAP ring. Sending with a txtime requires the control
+     * message of the individual send call. */
+    const UA_UInt32 *ringFrames = (const UA_UInt32*)
+        UA_KeyValueMap_getScalar(params,
+                                 ethConnectionParams[ETH_PARAMINDEX_RINGFRAMES].name,
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+    if(ringFrames && *ringFrames > 0) {
+        if(conn->txtimeEnabled) {
+            UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                           "ETH %u\t| The ring cannot be used with txtime sending",
+                           (unsigned)sockfd);
+        } else {
+            res = ETH_setupRing(el, conn, ifname, *ringFrames, !listen || !*listen);
+            if(res != UA_STATUSCODE_GOOD)
+                goto cleanup;
+        }
+    }
+
     /* Register in the EventLoop */
     res = UA_EventLoopPOSIX_registerFD(el, &conn->rfd);
     if(res != UA_STATUSCODE_GOOD)
@@ -760,6 +1080,8 @@ ETH_openConnection(UA_ConnectionManager *cm, const UA_KeyValueMap *params,
     return UA_STATUSCODE_GOOD;
 
  cleanup:
+    if(conn)
+        ETH_freeRing(conn);
     UA_close(sockfd);
     UA_free(conn);
     UA_UNLOCK(&el->elMutex);
@@ -789,9 +1111,7 @@ ETH_shutdown(UA_POSIXConnectionManager *pcm, ETH_FD *conn) {
     dc->application = pcm;
     dc->context = conn;
 
-    /* Don't use the "public" el->addDelayedCallback. It takes a lock. */
-    dc->next = el->delayedCallbacks;
-    el->delayedCallbacks = dc;
+    UA_EventLoopPOSIX_addDelayedCallback(&el->eventLoop, dc);
 }
 
 static UA_StatusCode
@@ -884,6 +1204,49 @@ send_txtime(UA_EventLoopPOSIX *el, ETH_FD *conn, const UA_KeyValueMap *params,
 }
 #endif
 
+/* Uncover and set the Ethernet header */
+static void
+ETH_setHeader(ETH_FD *conn, UA_ByteString *buf) {
+    buf->data -= conn->headerSize;
+    buf->length += conn->headerSize;
+    memcpy(buf->data, conn->header, conn->headerSize);
+    if(conn->lengthOffset) {
+        UA_UInt16 *ethLength =  (UA_UInt16*)&buf->data[conn->lengthOffset];
+        *ethLength = htons((UA_UInt16)(buf->length - conn->headerSize));
+    }
+}
+
+/* Queue the frames in the send ring and send them with a single syscall. The
+ * buffers have the Ethernet header already set. */
+static UA_StatusCode
+ETH_sendRing(UA_POSIXConnectionManager *pcm, ETH_FD *conn,
+             UA_ByteString *bufs, size_t bufsSize) {
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)pcm->cm.eventSource.eventLoop;
+    UA_LOCK_ASSERT(&el->elMutex);
+
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    for(size_t i = 0; i < bufsSize; i++) {
+        UA_Boolean inRing = ETH_inRing(conn, bufs[i].data);
+        if(res == UA_STATUSCODE_GOOD)
+            res = ETH_queueTxFrame(el, conn, &bufs[i]);
+        else if(inRing)
+            ETH_requestTxFrame(conn, bufs[i].data, 0); /* Release the frame */
+        if(inRing)
+            UA_ByteString_init(&bufs[i]);
+        else
+            UA_EventLoopPOSIX_freeNetworkBuffer(&pcm->cm, (uintptr_t)conn->rfd.fd,
+                                                &bufs[i]);
+    }
+
+    /* Send the queued frames also if the queueing failed midway */
+    UA_StatusCode flushRes = ETH_flushTxRing(el, conn, false);
+    if(flushRes != UA_STATUSCODE_GOOD) {
+        ETH_shutdown(pcm, conn);
+        return flushRes;
+    }
+    return res;
+}
+
 static UA_StatusCode
 ETH_sendWithConnection(UA_ConnectionManager *cm, uintptr_t connectionId,
                        const UA_KeyValueMap *params, UA_ByteString *buf) {
@@ -902,13 +1265,7 @@ ETH_sendWithConnection(UA_ConnectionManager *cm, uintptr_t connectionId,
     }
 
     /* Uncover and set the Ethernet header */
-    buf->data -= conn->headerSize;
-    buf->length += conn->headerSize;
-    memcpy(buf->data, conn->header, conn->headerSize);
-    if(conn->lengthOffset) {
-        UA_UInt16 *ethLength =  (UA_UInt16*)&buf->data[conn->lengthOffset];
-        *ethLength = htons((UA_UInt16)(buf->length - conn->headerSize));
-    }
+    ETH_setHeader(conn, buf);
 
     /* Was a txtime configured? */
     const UA_DateTime *txtime = (const UA_DateTime*)
@@ -923,6 +1280,13 @@ ETH_sendWithConnection(UA_ConnectionManager *cm, uintptr_t connectionId,
         return UA_STATUSCODE_BADINTERNALERROR;
     }
 
+    /* Send via the ring */
+    if(conn->ringTx) {
+        UA_StatusCode res = ETH_sendRing(pcm, conn, buf, 1);
+        UA_UNLOCK(&el->elMutex);
+        return res;
+    }
+
     /* Prevent OS signals when sending to a closed socket */
     int flags = MSG_NOSIGNAL;
 
@@ -991,6 +1355,39 @@ ETH_sendWithConnection(UA_ConnectionManager *cm, uintptr_t connectionId,
     return UA_STATUSCODE_GOOD;
 }
 
+static UA_StatusCode
+ETH_sendWithConnectionV(UA_ConnectionManager *cm, uintptr_t connectionId,
+                        const UA_KeyValueMap *params,
+                        UA_ByteString *bufs, size_t bufsSize) {
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    (void)el;
+    UA_POSIXConnectionManager *pcm = (UA_POSIXConnectionManager*)cm;
+
+    UA_LOCK(&el->elMutex);
+
+    /* Without a send ring (or with a txtime), each frame is sent individually */
+    UA_FD fd = (UA_FD)connectionId;
+    ETH_FD *conn = (ETH_FD*)ZIP_FIND(UA_FDTree, &pcm->fds, &fd);
+    if(!conn || !conn->ringTx ||
+       UA_KeyValueMap_contains(params, ethConnectionParams[ETH_PARAMINDEX_TXTIME].name)) {
+        UA_UNLOCK(&el->elMutex);
+        UA_StatusCode res = UA_STATUSCODE_GOOD;
+        for(size_t i = 0; i < bufsSize; i++) {
+            UA_StatusCode res2 = ETH_sendWithConnection(cm, connectionId,
+                                                        params, &bufs[i]);
+            if(res == UA_STATUSCODE_GOOD)
+                res = res2;
+        }
+        return res;
+    }
+
+    for(size_t i = 0; i < bufsSize; i++)
+        ETH_setHeader(conn, &bufs[i]);
+    UA_StatusCode res = ETH_sendRing(pcm, conn, bufs, bufsSize);
+    UA_UNLOCK(&el->elMutex);
+    return res;
+}
+
 static UA_StatusCode
 ETH_eventSourceStart(UA_ConnectionManager *cm) {
     UA_POSIXConnectionManager *pcm = (UA_POSIXConnectionManager*)cm;
@@ -1019,6 +1416,10 @@ ETH_eventSourceStart(UA_ConnectionManager *cm) {
     if(res != UA_STATUSCODE_GOOD)
         goto finish;
 
+    /* Send several frames at once only without a static send buffer */
+    cm->sendWithConnectionV = (pcm->txBuffer.length == 0) ?
+        ETH_sendWithConnectionV : NULL;
+
     /* Set the EventSource to the started state */
     cm->eventSource.state = UA_EVENTSOURCESTATE_STARTED;
 
@@ -0,0 +1,1159 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "eventloop_posix.h"
+
+#if defined(UA_ARCHITECTURE_POSIX) && defined(__linux__)
+
+#include <sys/mman.h> /* memfd_create, mmap */
+#include <sys/stat.h>
+#include <sys/un.h>
+
+/* Shared-Memory Connections
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~
+ * A connection consists of a Unix domain socket (the control socket) and a
+ * shared memory region with two single-producer/single-consumer byte rings,
+ * one for each direction. The client creates the region and two eventfds
+ * (doorbells) and hands them to the server over the control socket. The data
+ * is then copied into the ring and the doorbell of the remote side is only
+ * rung if the consumer waits for it. The control socket carries no data after
+ * the handshake. It is used to detect that the remote side has closed.
+ *
+ * The ring indices are counters that wrap around. Only the producer writes the
+ * head and only the consumer writes the tail. The remote side runs in a
+ * different process. So the atomic builtins are used independent of the
+ * UA_MULTITHREADING level. */
+
+/* Configuration parameters */
+#define SHM_MANAGERPARAMS 3
+#define SHM_MANAGERPARAMINDEX_RINGSIZE 0
+#define SHM_MANAGERPARAMINDEX_SENDQUEUE 1
+#define SHM_MANAGERPARAMINDEX_MAXREADS 2
+
+static UA_KeyValueRestriction shmManagerParams[SHM_MANAGERPARAMS] = {
+    {{0, UA_STRING_STATIC("ring-size")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false},
+    {{0, UA_STRING_STATIC("send-queue-size")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false},
+    {{0, UA_STRING_STATIC("recv-max-reads")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false}
+};
+
+#define SHM_PARAMETERSSIZE 3
+#define SHM_PARAMINDEX_ADDR 0
+#define SHM_PARAMINDEX_LISTEN 1
+#define SHM_PARAMINDEX_VALIDATE 2
+
+static UA_KeyValueRestriction shmConnectionParams[SHM_PARAMETERSSIZE] = {
+    {{0, UA_STRING_STATIC("address")}, &UA_TYPES[UA_TYPES_STRING], true, true, false},
+    {{0, UA_STRING_STATIC("listen")}, &UA_TYPES[UA_TYPES_BOOLEAN], false, true, false},
+    {{0, UA_STRING_STATIC("validate")}, &UA_TYPES[UA_TYPES_BOOLEAN], false, true, false}
+};
+
+/* Default size of each ring (1MB). Must be a power of two. */
+#define SHM_DEFAULT_RINGSIZE (1u << 20)
+#define SHM_MIN_RINGSIZE (1u << 12)
+#define SHM_MAX_RINGSIZE (1u << 28)
+
+/* Default upper bound for the bytes queued per connection (4MB) */
+#define SHM_DEFAULT_SENDQUEUE (1u << 22)
+
+/* Default upper bound for the ring segments handled per doorbell event */
+#define SHM_DEFAULT_MAXREADS 8
+
+/* Prefix of the socket name in the abstract namespace */
+#define SHM_SOCKETPREFIX "open62541-shm/"
+
+#define SHM_MAGIC 0x4d485355 /* "USHM" */
+#define SHM_VERSION 1
+#define SHM_CACHELINE 64
+
+/* Sent by the client together with the file descriptors for the region, the
+ * doorbell of the server and the doorbell of the client */
+typedef struct {
+    UA_UInt32 magic;
+    UA_UInt32 version;
+    UA_UInt32 ringSize;
+} SHM_Hello;
+
+/* Placed in the shared region. Head and tail are on separate cache lines. */
+typedef struct {
+    UA_UInt32 head; /* Bytes written, updated by the producer */
+    UA_Byte pad0[SHM_CACHELINE - sizeof(UA_UInt32)];
+    UA_UInt32 tail; /* Bytes read, updated by the consumer */
+    UA_Byte pad1[SHM_CACHELINE - sizeof(UA_UInt32)];
+    UA_UInt32 consumerWaiting; /* Ring the doorbell when data is written */
+    UA_UInt32 producerWaiting; /* Ring the doorbell when data is read */
+    UA_Byte pad2[SHM_CACHELINE - (2 * sizeof(UA_UInt32))];
+} SHM_RingHeader;
+
+typedef struct {
+    SHM_RingHeader *hdr;
+    UA_Byte *data;
+    UA_UInt32 size;
+} SHM_Ring;
+
+/* Remainder of a buffer that did not fit into the ring */
+typedef struct SHM_SendBuffer {
+    SIMPLEQ_ENTRY(SHM_SendBuffer) next;
+    UA_ByteString buf;
+    size_t pos; /* Bytes already written */
+} SHM_SendBuffer;
+
+typedef struct {
+    UA_RegisteredFD rfd; /* Control socket. Its fd is the connectionId. */
+    UA_RegisteredFD bell; /* Doorbell for the incoming ring. Registered in the
+                           * EventLoop once the region is mapped. */
+    UA_FD remoteBell;
+
+    UA_ConnectionManager_connectionCallback applicationCB;
+    void *application;
+    void *context;
+    UA_Boolean signaled; /* The application was notified of the connection */
+
+    void *region;
+    size_t regionSize;
+    SHM_Ring rx;
+    SHM_Ring tx;
+
+    /* Outbound queue. Flushed when the remote side has freed space. */
+    SIMPLEQ_HEAD(, SHM_SendBuffer) sendQueue;
+    size_t sendQueueSize; /* Bytes not yet written */
+} SHM_FD;
+
+static void
+SHM_shutdown(UA_ConnectionManager *cm, SHM_FD *conn);
+
+static UA_UInt32
+SHM_getManagerParam(UA_ConnectionManager *cm, size_t index, UA_UInt32 defaultValue) {
+    const UA_UInt32 *val = (const UA_UInt32*)
+        UA_KeyValueMap_getScalar(&cm->eventSource.params, shmManagerParams[index].name,
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+    return (val && *val > 0) ? *val : defaultValue;
+}
+
+static size_t
+SHM_regionSize(UA_UInt32 ringSize) {
+    return (2 * sizeof(SHM_RingHeader)) + (2 * (size_t)ringSize);
+}
+
+/* The first ring transports from the client to the server */
+static void
+SHM_mapRings(SHM_FD *conn, UA_UInt32 ringSize, UA_Boolean client) {
+    SHM_RingHeader *hdrs = (SHM_RingHeader*)conn->region;
+    UA_Byte *data = (UA_Byte*)conn->region + (2 * sizeof(SHM_RingHeader));
+    SHM_Ring *c2s = (client) ? &conn->tx : &conn->rx;
+    SHM_Ring *s2c = (client) ? &conn->rx : &conn->tx;
+    c2s->hdr = &hdrs[0];
+    c2s->data = data;
+    c2s->size = ringSize;
+    s2c->hdr = &hdrs[1];
+    s2c->data = data + ringSize;
+    s2c->size = ringSize;
+}
+
+/* Name in the abstract socket namespace (not visible in the file system) */
+static UA_StatusCode
+SHM_socketAddress(const UA_String *name, struct sockaddr_un *addr,
+                  socklen_t *addrLen) {
+    const size_t prefixLen = sizeof(SHM_SOCKETPREFIX) - 1;
+    if(name->length == 0 || 1 + prefixLen + name->length > sizeof(addr->sun_path))
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+    memset(addr, 0, sizeof(struct sockaddr_un));
+    addr->sun_family = AF_UNIX;
+    memcpy(&addr->sun_path[1], SHM_SOCKETPREFIX, prefixLen);
+    memcpy(&addr->sun_path[1 + prefixLen], name->data, name->length);
+    *addrLen = (socklen_t)(offsetof(struct sockaddr_un, sun_path) +
+                           1 + prefixLen + name->length);
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+SHM_ringBell(UA_FD bell) {
+    UA_UInt64 one = 1;
+    ssize_t res = write(bell, &one, sizeof(one));
+    (void)res; /* A full counter is signaled already */
+}
+
+/* Copy as much as fits into the ring. Returns the number of bytes written. */
+static size_t
+SHM_ringWrite(SHM_Ring *r, const UA_Byte *buf, size_t len) {
+    UA_UInt32 head = r->hdr->head;
+    UA_UInt32 tail = __atomic_load_n(&r->hdr->tail, __ATOMIC_ACQUIRE);
+    UA_UInt32 used = head - tail;
+    if(used >= r->size)
+        return 0;
+    size_t space = r->size - used;
+    if(len > space)
+        len = space;
+    size_t pos = head & (r->size - 1);
+    size_t first = r->size - pos;
+    if(first > len)
+        first = len;
+    memcpy(r->data + pos, buf, first);
+    memcpy(r->data, buf + first, len - first);
+    __atomic_store_n(&r->hdr->head, head + (UA_UInt32)len, __ATOMIC_RELEASE);
+    return len;
+}
+
+static UA_Boolean
+SHM_ringFull(SHM_Ring *r) {
+    UA_UInt32 tail = __atomic_load_n(&r->hdr->tail, __ATOMIC_SEQ_CST);
+    return (UA_UInt32)(r->hdr->head - tail) >= r->size;
+}
+
+/* Ring the doorbell only if the consumer waits for it */
+static void
+SHM_notifyConsumer(SHM_FD *conn) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if(__atomic_exchange_n(&conn->tx.hdr->consumerWaiting, 0, __ATOMIC_SEQ_CST))
+        SHM_ringBell(conn->remoteBell);
+}
+
+/* Write the queued buffers until the queue is empty or the ring is full. In
+ * the latter case the remote side rings the doorbell once it has read. */
+static void
+SHM_flushSendQueue(UA_ConnectionManager *cm, SHM_FD *conn) {
+    SHM_SendBuffer *sb;
+    while(true) {
+        size_t written = 0;
+        while((sb = SIMPLEQ_FIRST(&conn->sendQueue))) {
+            size_t n = SHM_ringWrite(&conn->tx, sb->buf.data + sb->pos,
+                                     sb->buf.length - sb->pos);
+            written += n;
+            sb->pos += n;
+            conn->sendQueueSize -= n;
+            if(sb->pos < sb->buf.length)
+                break;
+            SIMPLEQ_REMOVE_HEAD(&conn->sendQueue, next);
+            UA_EventLoopPOSIX_freeNetworkBuffer(cm, (uintptr_t)conn->rfd.fd, &sb->buf);
+            UA_free(sb);
+        }
+        if(written > 0)
+            SHM_notifyConsumer(conn);
+        if(SIMPLEQ_EMPTY(&conn->sendQueue))
+            return;
+
+        /* Wait for the doorbell. Retry if space was freed in the meantime. */
+        __atomic_store_n(&conn->tx.hdr->producerWaiting, 1, __ATOMIC_SEQ_CST);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if(SHM_ringFull(&conn->tx))
+            return;
+    }
+}
+
+/* Append the unwritten remainder of the buffer to the outbound queue. Takes
+ * ownership of the buffer unless it is the static send buffer. */
+static UA_StatusCode
+SHM_enqueue(UA_POSIXConnectionManager *pcm, SHM_FD *conn,
+            UA_ByteString *buf, size_t pos) {
+    SHM_SendBuffer *sb = (SHM_SendBuffer*)UA_malloc(sizeof(SHM_SendBuffer));
+    if(!sb)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    if(buf->data == pcm->txBuffer.data) {
+        UA_ByteString rest = {buf->length - pos, buf->data + pos};
+        UA_StatusCode res = UA_ByteString_copy(&rest, &sb->buf);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_free(sb);
+            return res;
+        }
+        sb->pos = 0;
+    } else {
+        sb->buf = *buf;
+        sb->pos = pos;
+        UA_ByteString_init(buf);
+    }
+    conn->sendQueueSize += sb->buf.length - sb->pos;
+    SIMPLEQ_INSERT_TAIL(&conn->sendQueue, sb, next);
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Hand the contiguous segments of the incoming ring to the application. The
+ * segments are only valid during the callback. */
+static void
+SHM_receive(UA_ConnectionManager *cm, SHM_FD *conn) {
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    UA_LOCK_ASSERT(&el->elMutex);
+
+    SHM_Ring *r = &conn->rx;
+    UA_UInt32 maxReads =
+        SHM_getManagerParam(cm, SHM_MANAGERPARAMINDEX_MAXREADS, SHM_DEFAULT_MAXREADS);
+    for(UA_UInt32 reads = 0; reads < maxReads; reads++) {
+        UA_UInt32 tail = r->hdr->tail;
+        UA_UInt32 avail = __atomic_load_n(&r->hdr->head, __ATOMIC_ACQUIRE) - tail;
+        if(avail == 0) {
+            /* Wait for the doorbell. Check again to not miss a write that
+             * happened before the flag was set. */
+            __atomic_store_n(&r->hdr->consumerWaiting, 1, __ATOMIC_SEQ_CST);
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            avail = __atomic_load_n(&r->hdr->head, __ATOMIC_SEQ_CST) - tail;
+            if(avail == 0)
+                return;
+            __atomic_store_n(&r->hdr->consumerWaiting, 0, __ATOMIC_SEQ_CST);
+        }
+
+        /* The remote side has corrupted the ring */
+        if(avail > r->size) {
+            UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                           "SHM %u\t| Invalid ring state, closing the connection",
+                           (unsigned)conn->rfd.fd);
+            SHM_shutdown(cm, conn);
+            return;
+        }
+
+        size_t pos = tail & (r->size - 1);
+        size_t len = r->size - pos;
+        if(len > avail)
+            len = avail;
+
+        UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                     "SHM %u\t| Received message of size %u",
+                     (unsigned)conn->rfd.fd, (unsigned)len);
+
+        /* Callback to the application layer */
+        UA_ByteString msg = {len, r->data + pos};
+        UA_UNLOCK(&el->elMutex);
+        conn->applicationCB(cm, (uintptr_t)conn->rfd.fd,
+                            conn->application, &conn->context,
+                            UA_CONNECTIONSTATE_ESTABLISHED,
+                            &UA_KEYVALUEMAP_NULL, msg);
+        UA_LOCK(&el->elMutex);
+
+        /* Release the segment. Ring the doorbell if the producer waits for
+         * space. */
+        __atomic_store_n(&r->hdr->tail, tail + (UA_UInt32)len, __ATOMIC_RELEASE);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if(__atomic_exchange_n(&r->hdr->producerWaiting, 0, __ATOMIC_SEQ_CST))
+            SHM_ringBell(conn->remoteBell);
+
+        /* The connection was closed in the callback */
+        if(conn->rfd.dc.callback)
+            return;
+    }
+
+    /* Capped so that a busy connection does not starve the others. Continue
+     * in the next EventLoop iteration. */
+    SHM_ringBell(conn->bell.fd);
+}
+
+/* The remote side has written data or freed space in the outgoing ring */
+static void
+SHM_bellCallback(UA_ConnectionManager *cm, UA_RegisteredFD *bell, short event) {
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    (void)el;
+    UA_LOCK_ASSERT(&el->elMutex);
+    SHM_FD *conn = (SHM_FD*)((uintptr_t)bell - offsetof(SHM_FD, bell));
+
+    UA_UInt64 count;
+    ssize_t res = read(bell->fd, &count, sizeof(count));
+    (void)res;
+
+    if(conn->rfd.dc.callback)
+        return; /* Closing */
+
+    if(!SIMPLEQ_EMPTY(&conn->sendQueue))
+        SHM_flushSendQueue(cm, conn);
+    SHM_receive(cm, conn);
+}
+
+static UA_StatusCode
+SHM_registerBell(UA_POSIXConnectionManager *pcm, SHM_FD *conn, UA_FD bell) {
+    conn->bell.fd = bell;
+    conn->bell.listenEvents = UA_FDEVENT_IN;
+    conn->bell.es = &pcm->cm.eventSource;
+    conn->bell.eventSourceCB = (UA_FDCallback)SHM_bellCallback;
+    UA_StatusCode res =
+        UA_EventLoopPOSIX_registerFD((UA_EventLoopPOSIX*)pcm->cm.eventSource.eventLoop,
+                                     &conn->bell);
+    if(res != UA_STATUSCODE_GOOD)
+        conn->bell.fd = UA_INVALID_FD;
+    return res;
+}
+
+/* Test if the ConnectionManager can be stopped */
+static void
+SHM_checkStopped(UA_POSIXConnectionManager *pcm) {
+    UA_LOCK_ASSERT(&((UA_EventLoopPOSIX*)pcm->cm.eventSource.eventLoop)->elMutex);
+
+    if(pcm->fdsSize == 0 &&
+       pcm->cm.eventSource.state == UA_EVENTSOURCESTATE_STOPPING) {
+        UA_LOG_DEBUG(pcm->cm.eventSource.eventLoop->logger, UA_LOGCATEGORY_NETWORK,
+                     "SHM\t| All connections closed, the EventLoop has stopped");
+        pcm->cm.eventSource.state = UA_EVENTSOURCESTATE_STOPPED;
+    }
+}
+
+static void
+SHM_delayedClose(void *application, void *context) {
+    UA_POSIXConnectionManager *pcm = (UA_POSIXConnectionManager*)application;
+    UA_ConnectionManager *cm = &pcm->cm;
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    SHM_FD *conn = (SHM_FD*)context;
+
+    UA_LOCK(&el->elMutex);
+
+    UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
+                 "SHM %u\t| Delayed closing of the connection",
+                 (unsigned)conn->rfd.fd);
+
+    /* Deregister from the EventLoop */
+    UA_EventLoopPOSIX_deregisterFD(el, &conn->rfd);
+    if(conn->bell.fd != UA_INVALID_FD)
+        UA_EventLoopPOSIX_deregisterFD(el, &conn->bell);
+
+    /* Deregister internally */
+    ZIP_REMOVE(UA_FDTree, &pcm->fds, &conn->rfd);
+    UA_assert(pcm->fdsSize > 0);
+    pcm->fdsSize--;
+
+    /* Signal closing to the application */
+    if(conn->signaled) {
+        UA_UNLOCK(&el->elMutex);
+        conn->applicationCB(cm, (uintptr_t)conn->rfd.fd,
+                            conn->application, &conn->context,
+                            UA_CONNECTIONSTATE_CLOSING,
+                            &UA_KEYVALUEMAP_NULL, UA_BYTESTRING_NULL);
+        UA_LOCK(&el->elMutex);
+    }
+
+    /* Release the resources */
+    UA_close(conn->rfd.fd);
+    if(conn->bell.fd != UA_INVALID_FD)
+        UA_close(conn->bell.fd);
+    if(conn->remoteBell != UA_INVALID_FD)
+        UA_close(conn->remoteBell);
+    if(conn->region)
+        munmap(conn->region, conn->regionSize);
+
+    UA_LOG_INFO(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                "SHM %u\t| Connection closed", (unsigned)conn->rfd.fd);
+
+    /* Drop the unsent buffers */
+    SHM_SendBuffer *sb;
+    while((sb = SIMPLEQ_FIRST(&conn->sendQueue))) {
+        SIMPLEQ_REMOVE_HEAD(&conn->sendQueue, next);
+        UA_EventLoopPOSIX_freeNetworkBuffer(cm, (uintptr_t)conn->rfd.fd, &sb->buf);
+        UA_free(sb);
+    }
+
+    UA_free(conn);
+
+    /* Check if this was the last connection for a closing ConnectionManager */
+    SHM_checkStopped(pcm);
+
+    UA_UNLOCK(&el->elMutex);
+}
+
+static void
+SHM_shutdown(UA_ConnectionManager *cm, SHM_FD *conn) {
+    /* Already closing - nothing to do */
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    UA_LOCK_ASSERT(&el->elMutex);
+
+    if(conn->rfd.dc.callback) {
+        UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                     "SHM %u\t| Cannot close - already closing",
+                     (unsigned)conn->rfd.fd);
+        return;
+    }
+
+    /* The remote side sees the control socket closing */
+    shutdown(conn->rfd.fd, UA_SHUT_RDWR);
+
+    UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                 "SHM %u\t| Shutdown triggered", (unsigned)conn->rfd.fd);
+
+    /* Add to the delayed callback list. Will be cleaned up in the next
+     * iteration. */
+    UA_DelayedCallback *dc = &conn->rfd.dc;
+    dc->callback = SHM_delayedClose;
+    dc->application = cm;
+    dc->context = conn;
+    UA_EventLoopPOSIX_addDelayedCallback(&el->eventLoop, dc);
+}
+
+static SHM_FD *
+SHM_newConnection(UA_POSIXConnectionManager *pcm, UA_FD fd, UA_FDCallback cb,
+                  UA_ConnectionManager_connectionCallback connectionCallback,
+                  void *application, void *context) {
+    SHM_FD *conn = (SHM_FD*)UA_calloc(1, sizeof(SHM_FD));
+    if(!conn)
+        return NULL;
+    conn->rfd.fd = fd;
+    conn->rfd.listenEvents = UA_FDEVENT_IN;
+    conn->rfd.es = &pcm->cm.eventSource;
+    conn->rfd.eventSourceCB = cb;
+    conn->bell.fd = UA_INVALID_FD;
+    conn->remoteBell = UA_INVALID_FD;
+    conn->applicationCB = connectionCallback;
+    conn->application = application;
+    conn->context = context;
+    SIMPLEQ_INIT(&conn->sendQueue);
+    return conn;
+}
+
+/* Receive the region and the doorbells from the client */
+static UA_StatusCode
+SHM_receiveHello(UA_POSIXConnectionManager *pcm, SHM_FD *conn) {
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)pcm->cm.eventSource.eventLoop;
+
+    SHM_Hello hello;
+    struct iovec iov = {&hello, sizeof(hello)};
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(3 * sizeof(int))];
+    } control;
+    struct msghdr mh;
+    memset(&mh, 0, sizeof(mh));
+    mh.msg_iov = &iov;
+    mh.msg_iovlen = 1;
+    mh.msg_control = control.buf;
+    mh.msg_controllen = sizeof(control.buf);
+    ssize_t n = recvmsg(conn->rfd.fd, &mh, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+    if(n < 0 && (UA_ERRNO == UA_INTERRUPTED || UA_ERRNO == UA_WOULDBLOCK ||
+                 UA_ERRNO == UA_AGAIN))
+        return UA_STATUSCODE_GOODCALLAGAIN;
+
+    /* Take the file descriptors */
+    int fds[3] = {UA_INVALID_FD, UA_INVALID_FD, UA_INVALID_FD};
+    size_t fdsSize = 0;
+    for(struct cmsghdr *cmsg = CMSG_FIRSTHDR(&mh); cmsg;
+        cmsg = CMSG_NXTHDR(&mh, cmsg)) {
+        if(cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+            continue;
+        size_t cnt = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        int *cfds = (int*)CMSG_DATA(cmsg);
+        for(size_t i = 0; i < cnt; i++) {
+            if(fdsSize < 3)
+                fds[fdsSize++] = cfds[i];
+            else
+                UA_close(cfds[i]);
+        }
+    }
+
+    UA_StatusCode res = UA_STATUSCODE_BADCONNECTIONREJECTED;
+    if(n != (ssize_t)sizeof(hello) || fdsSize != 3 ||
+       hello.magic != SHM_MAGIC || hello.version != SHM_VERSION ||
+       hello.ringSize < SHM_MIN_RINGSIZE || hello.ringSize > SHM_MAX_RINGSIZE ||
+       (hello.ringSize & (hello.ringSize - 1)) != 0) {
+        UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                       "SHM %u\t| Invalid handshake", (unsigned)conn->rfd.fd);
+        goto cleanup;
+    }
+
+    /* Map the region */
+    size_t regionSize = SHM_regionSize(hello.ringSize);
+    struct stat st;
+    if(fstat(fds[0], &st) != 0 || (size_t)st.st_size < regionSize) {
+        UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                       "SHM %u\t| The shared memory region is too small",
+                       (unsigned)conn->rfd.fd);
+        goto cleanup;
+    }
+    void *region = mmap(NULL, regionSize, PROT_READ | PROT_WRITE,
+                        MAP_SHARED, fds[0], 0);
+    if(region == MAP_FAILED) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                          "SHM %u\t| Could not map the shared memory (%s)",
+                          (unsigned)conn->rfd.fd, errno_str));
+        goto cleanup;
+    }
+    conn->region = region;
+    conn->regionSize = regionSize;
+    SHM_mapRings(conn, hello.ringSize, false);
+
+    /* Register the doorbell */
+    res = SHM_registerBell(pcm, conn, fds[1]);
+    if(res != UA_STATUSCODE_GOOD)
+        goto cleanup;
+    fds[1] = UA_INVALID_FD;
+    conn->remoteBell = fds[2];
+    fds[2] = UA_INVALID_FD;
+
+ cleanup:
+    for(size_t i = 0; i < 3; i++) {
+        if(fds[i] != UA_INVALID_FD)
+            UA_close(fds[i]);
+    }
+    return res;
+}
+
+/* Gets called when the handshake arrives, when an active connection has opened
+ * or when the remote side closes the control socket */
+static void
+SHM_connectionSocketCallback(UA_ConnectionManager *cm, SHM_FD *conn,
+                             short event) {
+    UA_POSIXConnectionManager *pcm = (UA_POSIXConnectionManager*)cm;
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    UA_LOCK_ASSERT(&el->elMutex);
+
+    if(event == UA_FDEVENT_ERR) {
+        UA_LOG_INFO(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                    "SHM %u\t| The connection closes with an error",
+                    (unsigned)conn->rfd.fd);
+        SHM_shutdown(cm, conn);
+        return;
+    }
+
+    /* Server-side: Wait for the handshake */
+    if(!conn->region) {
+        UA_StatusCode res = SHM_receiveHello(pcm, conn);
+        if(res == UA_STATUSCODE_GOODCALLAGAIN)
+            return;
+        if(res != UA_STATUSCODE_GOOD) {
+            SHM_shutdown(cm, conn);
+            return;
+        }
+
+        /* Forward the process id of the remote side to the application */
+        char remote[32];
+        struct ucred cred;
+        socklen_t credLen = sizeof(cred);
+        if(getsockopt(conn->rfd.fd, SOL_SOCKET, SO_PEERCRED, &cred, &credLen) == 0)
+            mp_snprintf(remote, sizeof(remote), "pid:%d", (int)cred.pid);
+        else
+            mp_snprintf(remote, sizeof(remote), "pid:unknown");
+        UA_KeyValuePair kvp;
+        kvp.key = UA_QUALIFIEDNAME(0, "remote-address");
+        UA_String remoteStr = UA_STRING(remote);
+        UA_Variant_setScalar(&kvp.value, &remoteStr, &UA_TYPES[UA_TYPES_STRING]);
+        UA_KeyValueMap kvm = {1, &kvp};
+
+        UA_LOG_INFO(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                    "SHM %u\t| Connection opened from %s",
+                    (unsigned)conn->rfd.fd, remote);
+
+        conn->signaled = true;
+        UA_UNLOCK(&el->elMutex);
+        conn->applicationCB(cm, (uintptr_t)conn->rfd.fd,
+                            conn->application, &conn->context,
+                            UA_CONNECTIONSTATE_ESTABLISHED,
+                            &kvm, UA_BYTESTRING_NULL);
+        UA_LOCK(&el->elMutex);
+        return;
+    }
+
+    /* Client-side: The handshake was sent and the connection is open */
+    if(event == UA_FDEVENT_OUT) {
+        conn->rfd.listenEvents = UA_FDEVENT_IN;
+        UA_EventLoopPOSIX_modifyFD(el, &conn->rfd);
+        UA_UNLOCK(&el->elMutex);
+        conn->applicationCB(cm, (uintptr_t)conn->rfd.fd,
+                            conn->application, &conn->context,
+                            UA_CONNECTIONSTATE_ESTABLISHED,
+                            &UA_KEYVALUEMAP_NULL, UA_BYTESTRING_NULL);
+        UA_LOCK(&el->elMutex);
+        return;
+    }
+
+    /* No data is expected on the control socket after the handshake */
+    char c;
+    ssize_t n = recv(conn->rfd.fd, &c, 1, MSG_DONTWAIT);
+    if(n < 0 && (UA_ERRNO == UA_INTERRUPTED || UA_ERRNO == UA_WOULDBLOCK ||
+                 UA_ERRNO == UA_AGAIN))
+        return;
+    UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                 "SHM %u\t| The remote side has closed the connection",
+                 (unsigned)conn->rfd.fd);
+    SHM_shutdown(cm, conn);
+}
+
+/* Gets called when a new client connects */
+static void
+SHM_listenSocketCallback(UA_ConnectionManager *cm, SHM_FD *conn, short event) {
+    UA_POSIXConnectionManager *pcm = (UA_POSIXConnectionManager*)cm;
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    UA_LOCK_ASSERT(&el->elMutex);
+
+    UA_FD newfd = accept4(conn->rfd.fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if(newfd == UA_INVALID_FD) {
+        if(UA_ERRNO == UA_INTERRUPTED)
+            return;
+        if(cm->eventSource.state != UA_EVENTSOURCESTATE_STOPPING) {
+            UA_LOG_SOCKET_ERRNO_WRAP(
+                UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                               "SHM %u\t| Error %s, closing the server socket",
+                               (unsigned)conn->rfd.fd, errno_str));
+        }
+        SHM_shutdown(cm, conn);
+        return;
+    }
+
+    /* The shared memory is only exchanged with processes of the same user
+     * (or with any process if the server runs as root) */
+    struct ucred cred;
+    socklen_t credLen = sizeof(cred);
+    if(getsockopt(newfd, SOL_SOCKET, SO_PEERCRED, &cred, &credLen) != 0 ||
+       (geteuid() != 0 && cred.uid != geteuid())) {
+        UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                       "SHM %u\t| Rejecting a connection from a different user",
+                       (unsigned)conn->rfd.fd);
+        UA_close(newfd);
+        return;
+    }
+
+    /* The application is notified once the handshake has arrived */
+    SHM_FD *newConn =
+        SHM_newConnection(pcm, newfd, (UA_FDCallback)SHM_connectionSocketCallback,
+                          conn->applicationCB, conn->application, conn->context);
+    if(!newConn) {
+        UA_close(newfd);
+        return;
+    }
+    UA_StatusCode res = UA_EventLoopPOSIX_registerFD(el, &newConn->rfd);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_free(newConn);
+        UA_close(newfd);
+        return;
+    }
+    ZIP_INSERT(UA_FDTree, &pcm->fds, &newConn->rfd);
+    pcm->fdsSize++;
+}
+
+static UA_StatusCode
+SHM_openPassiveConnection(UA_POSIXConnectionManager *pcm, const UA_String *name,
+                          void *application, void *context,
+                          UA_ConnectionManager_connectionCallback connectionCallback,
+                          UA_Boolean validate) {
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)pcm->cm.eventSource.eventLoop;
+    UA_LOCK_ASSERT(&el->elMutex);
+
+    struct sockaddr_un addr;
+    socklen_t addrLen;
+    UA_StatusCode res = SHM_socketAddress(name, &addr, &addrLen);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                       "SHM\t| Invalid name %S", *name);
+        return res;
+    }
+    if(validate)
+        return UA_STATUSCODE_GOOD;
+
+    UA_FD fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(fd == UA_INVALID_FD)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    if(bind(fd, (struct sockaddr*)&addr, addrLen) != 0 ||
+       listen(fd, UA_MAXBACKLOG) != 0) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                          "SHM\t| Cannot listen on %S (%s)", *name, errno_str));
+        UA_close(fd);
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    SHM_FD *conn =
+        SHM_newConnection(pcm, fd, (UA_FDCallback)SHM_listenSocketCallback,
+                          connectionCallback, application, context);
+    if(!conn) {
+        UA_close(fd);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    res = UA_EventLoopPOSIX_registerFD(el, &conn->rfd);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_free(conn);
+        UA_close(fd);
+        return res;
+    }
+    ZIP_INSERT(UA_FDTree, &pcm->fds, &conn->rfd);
+    pcm->fdsSize++;
+    conn->signaled = true;
+
+    UA_LOG_INFO(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                "SHM %u\t| Listening on %S", (unsigned)fd, *name);
+
+    /* Announce the listen-connection in the application */
+    UA_KeyValuePair kvp;
+    kvp.key = UA_QUALIFIEDNAME(0, "listen-address");
+    UA_Variant_setScalar(&kvp.value, (void*)(uintptr_t)name, &UA_TYPES[UA_TYPES_STRING]);
+    UA_KeyValueMap kvm = {1, &kvp};
+    UA_UNLOCK(&el->elMutex);
+    connectionCallback(&pcm->cm, (uintptr_t)fd, application, &conn->context,
+                       UA_CONNECTIONSTATE_ESTABLISHED, &kvm, UA_BYTESTRING_NULL);
+    UA_LOCK(&el->elMutex);
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Create the region and the doorbells and send them to the server */
+static UA_StatusCode
+SHM_openActiveConnection(UA_POSIXConnectionManager *pcm, const UA_String *name,
+                         void *application, void *context,
+                         UA_ConnectionManager_connectionCallback connectionCallback,
+                         UA_Boolean validate) {
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)pcm->cm.eventSource.eventLoop;
+    UA_LOCK_ASSERT(&el->elMutex);
+
+    struct sockaddr_un addr;
+    socklen_t addrLen;
+    UA_StatusCode res = SHM_socketAddress(name, &addr, &addrLen);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                       "SHM\t| Invalid name %S", *name);
+        return res;
+    }
+    if(validate)
+        return UA_STATUSCODE_GOOD;
+
+    /* Round the ring size to a power of two */
+    UA_UInt32 cfgSize = SHM_getManagerParam(&pcm->cm, SHM_MANAGERPARAMINDEX_RINGSIZE,
+                                            SHM_DEFAULT_RINGSIZE);
+    UA_UInt32 ringSize = SHM_MIN_RINGSIZE;
+    while(ringSize < cfgSize && ringSize < SHM_MAX_RINGSIZE)
+        ringSize <<= 1;
+    size_t regionSize = SHM_regionSize(ringSize);
+
+    /* Connect the control socket. Connecting to a local socket does not
+     * block. */
+    UA_FD fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(fd == UA_INVALID_FD)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    if(connect(fd, (struct sockaddr*)&addr, addrLen) != 0) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                          "SHM\t| Connecting to %S failed (%s)", *name, errno_str));
+        UA_close(fd);
+        return UA_STATUSCODE_BADDISCONNECT;
+    }
+    UA_EventLoopPOSIX_setNonBlocking(fd);
+
+    /* Create the region and the doorbells */
+    SHM_FD *conn =
+        SHM_newConnection(pcm, fd, (UA_FDCallback)SHM_connectionSocketCallback,
+                          connectionCallback, application, context);
+    if(!conn) {
+        UA_close(fd);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    conn->rfd.listenEvents = UA_FDEVENT_OUT; /* Switched to _IN once the
+                                              * connection is open */
+    int memfd = memfd_create("open62541-shm", MFD_CLOEXEC);
+    UA_FD localBell = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    conn->remoteBell = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    res = UA_STATUSCODE_BADINTERNALERROR;
+    if(memfd < 0 || localBell == UA_INVALID_FD || conn->remoteBell == UA_INVALID_FD ||
+       ftruncate(memfd, (off_t)regionSize) != 0)
+        goto error;
+    conn->region = mmap(NULL, regionSize, PROT_READ | PROT_WRITE,
+                        MAP_SHARED, memfd, 0);
+    if(conn->region == MAP_FAILED) {
+        conn->region = NULL;
+        goto error;
+    }
+    conn->regionSize = regionSize;
+    SHM_mapRings(conn, ringSize, true);
+    conn->tx.hdr->consumerWaiting = 1;
+    conn->rx.hdr->consumerWaiting = 1;
+
+    /* Send the handshake */
+    SHM_Hello hello = {SHM_MAGIC, SHM_VERSION, ringSize};
+    struct iovec iov = {&hello, sizeof(hello)};
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(3 * sizeof(int))];
+    } control;
+    memset(&control, 0, sizeof(control));
+    struct msghdr mh;
+    memset(&mh, 0, sizeof(mh));
+    mh.msg_iov = &iov;
+    mh.msg_iovlen = 1;
+    mh.msg_control = control.buf;
+    mh.msg_controllen = sizeof(control.buf);
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&mh);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(3 * sizeof(int));
+    int fds[3] = {memfd, conn->remoteBell, localBell};
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+    if(sendmsg(fd, &mh, MSG_NOSIGNAL) != (ssize_t)sizeof(hello)) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                          "SHM %u\t| Sending the handshake failed (%s)",
+                          (unsigned)fd, errno_str));
+        goto error;
+    }
+    UA_close(memfd);
+    memfd = -1;
+
+    /* Register in the EventLoop */
+    res = SHM_registerBell(pcm, conn, localBell);
+    if(res != UA_STATUSCODE_GOOD)
+        goto error;
+    localBell = UA_INVALID_FD;
+    res = UA_EventLoopPOSIX_registerFD(el, &conn->rfd);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_EventLoopPOSIX_deregisterFD(el, &conn->bell);
+        localBell = conn->bell.fd;
+        goto error;
+    }
+    ZIP_INSERT(UA_FDTree, &pcm->fds, &conn->rfd);
+    pcm->fdsSize++;
+    conn->signaled = true;
+
+    UA_LOG_INFO(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                "SHM %u\t| Opening a connection to %S", (unsigned)fd, *name);
+
+    /* Signal the new connection to the application as asynchonously opening */
+    UA_UNLOCK(&el->elMutex);
+    connectionCallback(&pcm->cm, (uintptr_t)fd, application, &conn->context,
+                       UA_CONNECTIONSTATE_OPENING, &UA_KEYVALUEMAP_NULL,
+                       UA_BYTESTRING_NULL);
+    UA_LOCK(&el->elMutex);
+    return UA_STATUSCODE_GOOD;
+
+ error:
+    if(memfd >= 0)
+        UA_close(memfd);
+    if(localBell != UA_INVALID_FD)
+        UA_close(localBell);
+    if(conn->remoteBell != UA_INVALID_FD)
+        UA_close(conn->remoteBell);
+    if(conn->region)
+        munmap(conn->region, conn->regionSize);
+    UA_free(conn);
+    UA_close(fd);
+    return res;
+}
+
+static UA_StatusCode
+SHM_openConnection(UA_ConnectionManager *cm, const UA_KeyValueMap *params,
+                   void *application, void *context,
+                   UA_ConnectionManager_connectionCallback connectionCallback) {
+    UA_POSIXConnectionManager *pcm = (UA_POSIXConnectionManager*)cm;
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    UA_LOCK(&el->elMutex);
+
+    if(cm->eventSource.state != UA_EVENTSOURCESTATE_STARTED) {
+        UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                     "SHM\t| Cannot open a connection for a "
+                     "ConnectionManager that is not started");
+        UA_UNLOCK(&el->elMutex);
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    /* Check the parameters */
+    UA_StatusCode res =
+        UA_KeyValueRestriction_validate(el->eventLoop.logger, "SHM",
+                                        shmConnectionParams,
+                                        SHM_PARAMETERSSIZE, params);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_UNLOCK(&el->elMutex);
+        return res;
+    }
+
+    const UA_String *name = (const UA_String*)
+        UA_KeyValueMap_getScalar(params, shmConnectionParams[SHM_PARAMINDEX_ADDR].name,
+                                 &UA_TYPES[UA_TYPES_STRING]);
+    UA_assert(name); /* existence is checked before */
+
+    UA_Boolean validate = false;
+    const UA_Boolean *validateParam = (const UA_Boolean*)
+        UA_KeyValueMap_getScalar(params,
+                                 shmConnectionParams[SHM_PARAMINDEX_VALIDATE].name,
+                                 &UA_TYPES[UA_TYPES_BOOLEAN]);
+    if(validateParam)
+        validate = *validateParam;
+
+    UA_Boolean listen = false;
+    const UA_Boolean *listenParam = (const UA_Boolean*)
+        UA_KeyValueMap_getScalar(params,
+                                 shmConnectionParams[SHM_PARAMINDEX_LISTEN].name,
+                                 &UA_TYPES[UA_TYPES_BOOLEAN]);
+    if(listenParam)
+        listen = *listenParam;
+
+    if(listen) {
+        res = SHM_openPassiveConnection(pcm, name, application, context,
+                                        connectionCallback, validate);
+    } else {
+        res = SHM_openActiveConnection(pcm, name, application, context,
+                                       connectionCallback, validate);
+    }
+
+    UA_UNLOCK(&el->elMutex);
+    return res;
+}
+
+static UA_StatusCode
+SHM_sendWithConnection(UA_ConnectionManager *cm, uintptr_t connectionId,
+                       const UA_KeyValueMap *params, UA_ByteString *buf) {
+    UA_POSIXConnectionManager *pcm = (UA_POSIXConnectionManager*)cm;
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    UA_LOCK(&el->elMutex);
+
+    UA_FD fd = (UA_FD)connectionId;
+    SHM_FD *conn = (SHM_FD*)ZIP_FIND(UA_FDTree, &pcm->fds, &fd);
+    if(!conn || conn->rfd.dc.callback || !conn->region ||
+       conn->bell.fd == UA_INVALID_FD) {
+        UA_EventLoopPOSIX_freeNetworkBuffer(cm, connectionId, buf);
+        UA_UNLOCK(&el->elMutex);
+        return UA_STATUSCODE_BADCONNECTIONCLOSED;
+    }
+
+    /* Write directly if nothing is queued. Otherwise the buffer is queued to
+     * keep the order. */
+    size_t written = 0;
+    if(SIMPLEQ_EMPTY(&conn->sendQueue)) {
+        written = SHM_ringWrite(&conn->tx, buf->data, buf->length);
+        if(written > 0)
+            SHM_notifyConsumer(conn);
+    }
+
+    /* Queue the remainder */
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    if(written < buf->length) {
+        size_t limit = SHM_getManagerParam(cm, SHM_MANAGERPARAMINDEX_SENDQUEUE,
+                                           SHM_DEFAULT_SENDQUEUE);
+        if(conn->sendQueueSize + (buf->length - written) > limit) {
+            UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                           "SHM %u\t| The send queue is full, closing the "
+                           "connection", (unsigned)connectionId);
+            res = UA_STATUSCODE_BADCONNECTIONCLOSED;
+        } else {
+            res = SHM_enqueue(pcm, conn, buf, written);
+            if(res == UA_STATUSCODE_GOOD)
+                SHM_flushSendQueue(cm, conn);
+        }
+        if(res != UA_STATUSCODE_GOOD)
+            SHM_shutdown(cm, conn);
+    }
+
+    UA_EventLoopPOSIX_freeNetworkBuffer(cm, connectionId, buf);
+    UA_UNLOCK(&el->elMutex);
+    return res;
+}
+
+static size_t
+SHM_getSendQueueSize(UA_ConnectionManager *cm, uintptr_t connectionId) {
+    UA_POSIXConnectionManager *pcm = (UA_POSIXConnectionManager*)cm;
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    (void)el;
+    UA_LOCK(&el->elMutex);
+    UA_FD fd = (UA_FD)connectionId;
+    SHM_FD *conn = (SHM_FD*)ZIP_FIND(UA_FDTree, &pcm->fds, &fd);
+    size_t size = (conn) ? conn->sendQueueSize : 0;
+    UA_UNLOCK(&el->elMutex);
+    return size;
+}
+
+static UA_StatusCode
+SHM_shutdownConnection(UA_ConnectionManager *cm, uintptr_t connectionId) {
+    UA_POSIXConnectionManager *pcm = (UA_POSIXConnectionManager*)cm;
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX *)cm->eventSource.eventLoop;
+    UA_LOCK(&el->elMutex);
+
+    UA_FD fd = (UA_FD)connectionId;
+    SHM_FD *conn = (SHM_FD*)ZIP_FIND(UA_FDTree, &pcm->fds, &fd);
+    if(!conn) {
+        UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                       "SHM\t| Cannot close connection %u - not found",
+                       (unsigned)connectionId);
+        UA_UNLOCK(&el->elMutex);
+        return UA_STATUSCODE_BADNOTFOUND;
+    }
+
+    SHM_shutdown(cm, conn);
+
+    UA_UNLOCK(&el->elMutex);
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+SHM_eventSourceStart(UA_ConnectionManager *cm) {
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    if(!el)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    UA_LOCK(&el->elMutex);
+
+    /* Check the state */
+    if(cm->eventSource.state != UA_EVENTSOURCESTATE_STOPPED) {
+        UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                     "SHM\t| To start the ConnectionManager, it has to be "
+                     "registered in an EventLoop and not started yet");
+        UA_UNLOCK(&el->elMutex);
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    /* Check the parameters */
+    UA_StatusCode res =
+        UA_KeyValueRestriction_validate(el->eventLoop.logger, "SHM",
+                                        shmManagerParams, SHM_MANAGERPARAMS,
+                                        &cm->eventSource.params);
+    if(res == UA_STATUSCODE_GOOD)
+        cm->eventSource.state = UA_EVENTSOURCESTATE_STARTED;
+
+    UA_UNLOCK(&el->elMutex);
+    return res;
+}
+
+static void *
+SHM_shutdownCB(void *application, UA_RegisteredFD *rfd) {
+    UA_ConnectionManager *cm = (UA_ConnectionManager*)application;
+    SHM_shutdown(cm, (SHM_FD*)rfd);
+    return NULL;
+}
+
+static void
+SHM_eventSourceStop(UA_ConnectionManager *cm) {
+    UA_POSIXConnectionManager *pcm = (UA_POSIXConnectionManager*)cm;
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    (void)el;
+
+    UA_LOCK(&el->elMutex);
+
+    UA_LOG_DEBUG(cm->eventSource.eventLoop->logger, UA_LOGCATEGORY_NETWORK,
+                 "SHM\t| Shutting down the ConnectionManager");
+
+    /* Prevent new connections to open */
+    cm->eventSource.state = UA_EVENTSOURCESTATE_STOPPING;
+
+    /* Shutdown all existing connection */
+    ZIP_ITER(UA_FDTree, &pcm->fds, SHM_shutdownCB, cm);
+
+    /* All connections closed? Otherwise iterate some more. */
+    SHM_checkStopped(pcm);
+
+    UA_UNLOCK(&el->elMutex);
+}
+
+static UA_StatusCode
+SHM_eventSourceDelete(UA_ConnectionManager *cm) {
+    UA_POSIXConnectionManager *pcm = (UA_POSIXConnectionManager*)cm;
+    if(cm->eventSource.state >= UA_EVENTSOURCESTATE_STARTING) {
+        UA_LOG_ERROR(cm->eventSource.eventLoop->logger, UA_LOGCATEGORY_EVENTLOOP,
+                     "SHM\t| The EventSource must be stopped before it can be deleted");
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    UA_ByteString_clear(&pcm->rxBuffer);
+    UA_ByteString_clear(&pcm->txBuffer);
+    UA_KeyValueMap_clear(&cm->eventSource.params);
+    UA_String_clear(&cm->eventSource.name);
+    UA_free(cm);
+    return UA_STATUSCODE_GOOD;
+}
+
+static const char *shmName = "shm";
+
+UA_ConnectionManager *
+UA_ConnectionManager_new_POSIX_SHM(const UA_String eventSourceName) {
+    UA_POSIXConnectionManager *cm = (UA_POSIXConnectionManager*)
+        UA_calloc(1, sizeof(UA_POSIXConnectionManager));
+    if(!cm)
+        return NULL;
+
+    cm->cm.eventSource.eventSourceType = UA_EVENTSOURCETYPE_CONNECTIONMANAGER;
+    UA_String_copy(&eventSourceName, &cm->cm.eventSource.name);
+    cm->cm.eventSource.start = (UA_StatusCode (*)(UA_EventSource *))SHM_eventSourceStart;
+    cm->cm.eventSource.stop = (void (*)(UA_EventSource *))SHM_eventSourceStop;
+    cm->cm.eventSource.free = (UA_StatusCode (*)(UA_EventSource *))SHM_eventSourceDelete;
+    cm->cm.protocol = UA_STRING((char*)(uintptr_t)shmName);
+    cm->cm.openConnection = SHM_openConnection;
+    cm->cm.allocNetworkBuffer = UA_EventLoopPOSIX_allocNetworkBuffer;
+    cm->cm.freeNetworkBuffer = UA_EventLoopPOSIX_freeNetworkBuffer;
+    cm->cm.sendWithConnection = SHM_sendWithConnection;
+    cm->cm.getSendQueueSize = SHM_getSendQueueSize;
+    cm->cm.closeConnection = SHM_shutdownConnection;
+    return &cm->cm;
+}
+
+#endif /* defined(UA_ARCHITECTURE_POSIX) && defined(__linux__) */
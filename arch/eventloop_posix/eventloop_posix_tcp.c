@@ -10,13 +10,33 @@
 #include "eventloop_posix.h"
 
 /* Configuration parameters */
-#define TCP_MANAGERPARAMS 2
+#define TCP_MANAGERPARAMS 6
+#define TCP_MANAGERPARAMINDEX_SENDQUEUE 2
+#define TCP_MANAGERPARAMINDEX_MAXREADS 3
+#define TCP_MANAGERPARAMINDEX_ACCEPTBATCH 4
+#define TCP_MANAGERPARAMINDEX_ACCEPTRATE 5
 
 static UA_KeyValueRestriction tcpManagerParams[TCP_MANAGERPARAMS] = {
     {{0, UA_STRING_STATIC("recv-bufsize")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false},
-    {{0, UA_STRING_STATIC("send-bufsize")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false}
+    {{0, UA_STRING_STATIC("send-bufsize")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false},
+    {{0, UA_STRING_STATIC("send-queue-size")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false},
+    {{0, UA_STRING_STATIC("recv-max-reads")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false},
+    {{0, UA_STRING_STATIC("accept-batch")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false},
+    {{0, UA_STRING_STATIC("accept-rate-limit")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false}
 };
 
+/* Default upper bound for the bytes queued per connection (4MB) */
+#define TCP_DEFAULT_SENDQUEUE (1u << 22)
+
+/* Default upper bound for the reads per socket event */
+#define TCP_DEFAULT_MAXREADS 8
+
+/* Default upper bound for the connections accepted per listen socket event */
+#define TCP_DEFAULT_ACCEPTBATCH 16
+
+/* Size of the table with the recent connection count per source address */
+#define TCP_RATESLOTS 256
+
 #define TCP_PARAMETERSSIZE 5
 #define TCP_PARAMINDEX_ADDR 0
 #define TCP_PARAMINDEX_PORT 1
@@ -32,14 +52,38 @@ static UA_KeyValueRestriction tcpConnectionParams[TCP_PARAMETERSSIZE] = {
     {{0, UA_STRING_STATIC("reuse")}, &UA_TYPES[UA_TYPES_BOOLEAN], false, true, false}
 };
 
+/* Remainder of a buffer that could not be sent without blocking */
+typedef struct TCP_SendBuffer {
+    SIMPLEQ_ENTRY(TCP_SendBuffer) next;
+    UA_ByteString buf;
+    size_t pos; /* Bytes already sent */
+} TCP_SendBuffer;
+
 typedef struct {
     UA_RegisteredFD rfd;
 
     UA_ConnectionManager_connectionCallback applicationCB;
     void *application;
     void *context;
+
+    /* Outbound queue. Flushed when the socket becomes writable. */
+    SIMPLEQ_HEAD(, TCP_SendBuffer) sendQueue;
+    size_t sendQueueSize; /* Bytes not yet sent */
 } TCP_FD;
 
+typedef struct {
+    UA_UInt64 addrHash;
+    UA_DateTime windowStart;
+    UA_UInt32 count;
+} TCP_RateSlot;
+
+/* The TCP ConnectionManager extends the POSIX ConnectionManager with the
+ * state of the accept-rate-limit */
+typedef struct {
+    UA_POSIXConnectionManager pcm;
+    TCP_RateSlot rateSlots[TCP_RATESLOTS];
+} TCP_ConnectionManager;
+
 static void
 TCP_shutdown(UA_ConnectionManager *cm, TCP_FD *conn);
 
@@ -112,6 +156,15 @@ TCP_delayedClose(void *application, void *context) {
                           (unsigned)conn->rfd.fd, errno_str));
     }
 
+    /* Drop the unsent buffers */
+    TCP_SendBuffer *sb;
+    while((sb = SIMPLEQ_FIRST(&conn->sendQueue))) {
+        SIMPLEQ_REMOVE_HEAD(&conn->sendQueue, next);
+        UA_EventLoopPOSIX_freeNetworkBuffer(cm, (uintptr_t)conn->rfd.fd,
+                                            &sb->buf);
+        UA_free(sb);
+    }
+
     UA_free(conn);
 
     /* Check if this was the last connection for a closing ConnectionManager */
@@ -134,6 +187,60 @@ getSockError(TCP_FD *conn) {
     return (err == 0) ? error : err;
 }
 
+/* Send from the queue until it is empty or the socket would block. In the
+ * blocking mode, wait for the socket until the queue is empty. */
+static UA_StatusCode
+TCP_flushSendQueue(TCP_FD *conn, UA_Boolean blocking) {
+    struct pollfd tmp_poll_fd;
+    tmp_poll_fd.fd = conn->rfd.fd;
+    tmp_poll_fd.events = UA_POLLOUT;
+
+    TCP_SendBuffer *sb;
+    while((sb = SIMPLEQ_FIRST(&conn->sendQueue))) {
+        ssize_t n = UA_send(conn->rfd.fd, (const char*)sb->buf.data + sb->pos,
+                            sb->buf.length - sb->pos, MSG_NOSIGNAL);
+        if(n < 0) {
+            if(UA_ERRNO == UA_INTERRUPTED)
+                continue;
+            if(UA_ERRNO != UA_WOULDBLOCK && UA_ERRNO != UA_AGAIN)
+                return UA_STATUSCODE_BADCONNECTIONCLOSED;
+            if(!blocking)
+                return UA_STATUSCODE_GOOD;
+
+            /* Poll for the socket resources to become available and retry */
+            int poll_ret;
+            do {
+                poll_ret = UA_poll(&tmp_poll_fd, 1, 100);
+                if(poll_ret < 0 && UA_ERRNO != UA_INTERRUPTED)
+                    return UA_STATUSCODE_BADCONNECTIONCLOSED;
+            } while(poll_ret <= 0);
+            continue;
+        }
+
+        sb->pos += (size_t)n;
+        conn->sendQueueSize -= (size_t)n;
+        if(sb->pos < sb->buf.length)
+            continue;
+        SIMPLEQ_REMOVE_HEAD(&conn->sendQueue, next);
+        UA_EventLoopPOSIX_freeNetworkBuffer((UA_ConnectionManager*)conn->rfd.es,
+                                            (uintptr_t)conn->rfd.fd, &sb->buf);
+        UA_free(sb);
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Listen for write-events only while buffers are queued */
+static void
+TCP_updateSendEvents(UA_EventLoopPOSIX *el, TCP_FD *conn) {
+    short events = UA_FDEVENT_IN;
+    if(!SIMPLEQ_EMPTY(&conn->sendQueue))
+        events |= UA_FDEVENT_OUT;
+    if(conn->rfd.listenEvents == events)
+        return;
+    conn->rfd.listenEvents = events;
+    UA_EventLoopPOSIX_modifyFD(el, &conn->rfd);
+}
+
 /* Gets called when a connection socket opens, receives data or closes */
 static void
 TCP_connectionSocketCallback(UA_ConnectionManager *cm, TCP_FD *conn,
@@ -154,6 +261,25 @@ TCP_connectionSocketCallback(UA_ConnectionManager *cm, TCP_FD *conn,
         return;
     }
 
+    /* Flush the outbound queue. Also when reading, as only one event is
+     * signaled per iteration. */
+    if(!SIMPLEQ_EMPTY(&conn->sendQueue)) {
+        if(TCP_flushSendQueue(conn, false) != UA_STATUSCODE_GOOD) {
+            UA_LOG_SOCKET_ERRNO_WRAP(
+               UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                            "TCP %u\t| Send failed with error %s",
+                            (unsigned)conn->rfd.fd, errno_str));
+            TCP_shutdown(cm, conn);
+            return;
+        }
+        TCP_updateSendEvents(el, conn);
+    }
+
+    /* Write-event for an established connection (listening for read-events
+     * already). The queue was flushed above. */
+    if(event == UA_FDEVENT_OUT && (conn->rfd.listenEvents & UA_FDEVENT_IN))
+        return;
+
     /* Write-Event, a new connection has opened. But some errors come as an
      * out-event. For example if the remote side could not be reached to
      * initiate the connection. So we check manually for error conditions on
@@ -186,72 +312,155 @@ TCP_connectionSocketCallback(UA_ConnectionManager *cm, TCP_FD *conn,
         return;
     }
 
-    UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
-                 "TCP %u\t| Allocate receive buffer",
-                 (unsigned)conn->rfd.fd);
+    /* Read until the socket is drained. The number of reads per event is
+     * capped so that a busy connection does not starve the others. The
+     * remaining data is signaled again in the next EventLoop iteration. */
+    UA_UInt32 maxReads = TCP_DEFAULT_MAXREADS;
+    const UA_UInt32 *configMaxReads = (const UA_UInt32*)
+        UA_KeyValueMap_getScalar(&cm->eventSource.params,
+                                 tcpManagerParams[TCP_MANAGERPARAMINDEX_MAXREADS].name,
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+    if(configMaxReads && *configMaxReads > 0)
+        maxReads = *configMaxReads;
 
-    /* Use the already allocated receive-buffer */
     UA_POSIXConnectionManager *pcm = (UA_POSIXConnectionManager*)cm;
-    UA_ByteString response = pcm->rxBuffer;
+    for(UA_UInt32 reads = 0; reads < maxReads; reads++) {
+        UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                     "TCP %u\t| Allocate receive buffer",
+                     (unsigned)conn->rfd.fd);
+
+        /* Receive into a buffer from the pool. The application can retain
+         * it. Otherwise use the already allocated receive-buffer. */
+        UA_ByteString response = pcm->rxBuffer;
+        UA_Byte *pooled = UA_NetworkBufferPool_take(&el->bufferPool);
+        if(pooled) {
+            response.data = pooled;
+            response.length = el->bufferPool.bufferSize;
+        }
 
-    /* Receive */
+        /* Receive */
 #ifndef _WIN32
-    ssize_t ret = UA_recv(conn->rfd.fd, (char*)response.data,
-                          response.length, MSG_DONTWAIT);
+        ssize_t ret = UA_recv(conn->rfd.fd, (char*)response.data,
+                              response.length, MSG_DONTWAIT);
 #else
-    int ret = UA_recv(conn->rfd.fd, (char*)response.data,
-                      response.length, MSG_DONTWAIT);
+        int ret = UA_recv(conn->rfd.fd, (char*)response.data,
+                          response.length, MSG_DONTWAIT);
 #endif
 
-    /* Receive has failed */
-    if(ret <= 0) {
-        if(UA_ERRNO == UA_INTERRUPTED ||
-           UA_ERRNO == UA_WOULDBLOCK ||
-           UA_ERRNO == UA_AGAIN)
-            return; /* Temporary error on an non-blocking socket */
+        /* Receive has failed */
+        if(ret <= 0) {
+            if(pooled)
+                UA_NetworkBufferPool_release(&el->bufferPool, pooled);
+            /* The errno is only set for ret < 0. Zero signals the shutdown. */
+            if(ret < 0 &&
+               (UA_ERRNO == UA_INTERRUPTED ||
+                UA_ERRNO == UA_WOULDBLOCK ||
+                UA_ERRNO == UA_AGAIN))
+                return; /* Temporary error on an non-blocking socket */
+
+            /* Orderly shutdown of the socket */
+            UA_LOG_SOCKET_ERRNO_WRAP(
+               UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                            "TCP %u\t| recv signaled the socket was shutdown (%s)",
+                            (unsigned)conn->rfd.fd, errno_str));
+            TCP_shutdown(cm, conn);
+            return;
+        }
 
-        /* Orderly shutdown of the socket */
-        UA_LOG_SOCKET_ERRNO_WRAP(
-           UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
-                        "TCP %u\t| recv signaled the socket was shutdown (%s)",
-                        (unsigned)conn->rfd.fd, errno_str));
-        TCP_shutdown(cm, conn);
-        return;
+        UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                     "TCP %u\t| Received message of size %u",
+                     (unsigned)conn->rfd.fd, (unsigned)ret);
+
+        /* Callback to the application layer */
+        size_t bufSize = response.length;
+        response.length = (size_t)ret; /* Set the length of the received buffer */
+        UA_UNLOCK(&el->elMutex);
+        conn->applicationCB(cm, (uintptr_t)conn->rfd.fd,
+                            conn->application, &conn->context,
+                            UA_CONNECTIONSTATE_ESTABLISHED,
+                            &UA_KEYVALUEMAP_NULL, response);
+        if(pooled)
+            UA_NetworkBufferPool_release(&el->bufferPool, pooled);
+        UA_LOCK(&el->elMutex);
+
+        /* The buffer was not filled, so the socket is drained. Or the
+         * connection was closed in the callback. */
+        if((size_t)ret < bufSize || conn->rfd.dc.callback)
+            return;
     }
+}
 
-    UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
-                 "TCP %u\t| Received message of size %u",
-                 (unsigned)conn->rfd.fd, (unsigned)ret);
+/* Returns true if the connection from the remote address exceeds the
+ * accept-rate-limit. The addresses are hashed into a fixed table. Colliding
+ * addresses reset the window of each other. So the limit is never enforced
+ * too strictly. */
+static UA_Boolean
+TCP_acceptRateExceeded(TCP_ConnectionManager *tcm, UA_UInt32 limit,
+                       const struct sockaddr_storage *remote, UA_DateTime now) {
+    const UA_Byte *addr;
+    size_t addrLen;
+    if(remote->ss_family == AF_INET) {
+        const struct sockaddr_in *sin = (const struct sockaddr_in*)remote;
+        addr = (const UA_Byte*)&sin->sin_addr;
+        addrLen = sizeof(sin->sin_addr);
+    } else if(remote->ss_family == AF_INET6) {
+        const struct sockaddr_in6 *sin6 = (const struct sockaddr_in6*)remote;
+        addr = (const UA_Byte*)&sin6->sin6_addr;
+        addrLen = sizeof(sin6->sin6_addr);
+    } else {
+        return false;
+    }
 
-    /* Callback to the application layer */
-    response.length = (size_t)ret; /* Set the length of the received buffer */
-    UA_UNLOCK(&el->elMutex);
-    conn->applicationCB(cm, (uintptr_t)conn->rfd.fd,
-                        conn->application, &conn->context,
-                        UA_CONNECTIONSTATE_ESTABLISHED,
-                        &UA_KEYVALUEMAP_NULL, response);
-    UA_LOCK(&el->elMutex);
+    /* FNV-1a hash of the address without the port */
+    UA_UInt64 hash = 0xcbf29ce484222325ULL;
+    for(size_t i = 0; i < addrLen; i++) {
+        hash ^= addr[i];
+        hash *= 0x100000001b3ULL;
+    }
+
+    /* Count the connections in a window of one second */
+    TCP_RateSlot *slot = &tcm->rateSlots[hash % TCP_RATESLOTS];
+    if(slot->addrHash != hash || now - slot->windowStart >= UA_DATETIME_SEC) {
+        slot->addrHash = hash;
+        slot->windowStart = now;
+        slot->count = 0;
+    }
+    slot->count++;
+    return (slot->count > limit);
 }
 
-/* Gets called when a new connection opens or if the listenSocket is closed */
-static void
-TCP_listenSocketCallback(UA_ConnectionManager *cm, TCP_FD *conn, short event) {
+/* Accept a single connection. Returns false if no more connections can be
+ * accepted in this EventLoop iteration. */
+static UA_Boolean
+TCP_acceptConnection(UA_ConnectionManager *cm, TCP_FD *conn, UA_UInt32 rateLimit) {
     UA_POSIXConnectionManager *pcm = (UA_POSIXConnectionManager*)cm;
     UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
-    UA_LOCK_ASSERT(&el->elMutex);
-
-    UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
-                 "TCP %u\t| Callback on server socket",
-                 (unsigned)conn->rfd.fd);
 
-    /* Try to accept a new connection */
+    /* Try to accept a new connection. On Linux, the new socket does not
+     * inherit the non-blocking state from the listen socket. Set it right
+     * away without additional syscalls. */
     struct sockaddr_storage remote;
     socklen_t remote_size = sizeof(remote);
+#if defined(__linux__)
+    UA_FD newsockfd = accept4(conn->rfd.fd, (struct sockaddr*)&remote,
+                              &remote_size, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
     UA_FD newsockfd = accept(conn->rfd.fd, (struct sockaddr*)&remote, &remote_size);
+#endif
     if(newsockfd == UA_INVALID_FD) {
         /* Temporary error -- retry */
         if(UA_ERRNO == UA_INTERRUPTED)
-            return;
+            return true;
+
+        /* No more pending connections */
+        if(UA_ERRNO == UA_WOULDBLOCK || UA_ERRNO == UA_AGAIN)
+            return false;
+
+#ifdef ECONNABORTED
+        /* The connection was aborted while waiting in the backlog */
+        if(UA_ERRNO == ECONNABORTED)
+            return true;
+#endif
 
         /* Close the listen socket */
         if(cm->eventSource.state != UA_EVENTSOURCESTATE_STOPPING) {
@@ -262,15 +471,29 @@ TCP_listenSocketCallback(UA_ConnectionManager *cm, TCP_FD *conn, short event) {
         }
 
         TCP_shutdown(cm, conn);
-        return;
+        return false;
+    }
+
+    /* Too many connections from the same source. Close before any further
+     * work is done for the connection. */
+    if(rateLimit > 0 &&
+       TCP_acceptRateExceeded((TCP_ConnectionManager*)cm, rateLimit, &remote,
+                              el->eventLoop.dateTime_nowMonotonic(&el->eventLoop))) {
+        UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                     "TCP %u\t| Connection rejected, the accept-rate-limit "
+                     "for the source address is exceeded", (unsigned)conn->rfd.fd);
+        UA_close(newsockfd);
+        return true;
     }
 
-    /* Log the name of the remote host */
+    /* Get the numeric address of the remote host. This is no reverse lookup
+     * via DNS. */
     char hoststr[UA_MAXHOSTNAME_LENGTH];
-    int get_res = UA_getnameinfo((struct sockaddr *)&remote, sizeof(remote),
+    int get_res = UA_getnameinfo((struct sockaddr *)&remote, remote_size,
                                  hoststr, sizeof(hoststr),
                                  NULL, 0, NI_NUMERICHOST);
     if(get_res != 0) {
+        hoststr[0] = 0;
         UA_LOG_SOCKET_ERRNO_WRAP(
            UA_LOG_WARNING(cm->eventSource.eventLoop->logger, UA_LOGCATEGORY_NETWORK,
                           "TCP %u\t| getnameinfo(...) could not resolve the "
@@ -282,9 +505,13 @@ TCP_listenSocketCallback(UA_ConnectionManager *cm, TCP_FD *conn, short event) {
 
     /* Configure the new socket */
     UA_StatusCode res = UA_STATUSCODE_GOOD;
+#if !defined(__linux__)
     /* res |= UA_EventLoopPOSIX_setNonBlocking(newsockfd); Inherited from the listen-socket */
     res |= UA_EventLoopPOSIX_setNoSigPipe(newsockfd); /* Supress interrupts from the socket */
+#endif
     res |= TCP_setNoNagle(newsockfd);     /* Disable Nagle's algorithm */
+    UA_EventLoopPOSIX_setBusyPoll((UA_EventLoopPOSIX*)cm->eventSource.eventLoop,
+                                  newsockfd);
     if(res != UA_STATUSCODE_GOOD) {
         UA_LOG_SOCKET_ERRNO_WRAP(
             UA_LOG_WARNING(cm->eventSource.eventLoop->logger, UA_LOGCATEGORY_NETWORK,
@@ -292,7 +519,7 @@ TCP_listenSocketCallback(UA_ConnectionManager *cm, TCP_FD *conn, short event) {
                            (unsigned)newsockfd, errno_str));
         /* Close the new socket */
         UA_close(newsockfd);
-        return;
+        return true;
     }
 
     /* Allocate the UA_RegisteredFD */
@@ -302,10 +529,11 @@ TCP_listenSocketCallback(UA_ConnectionManager *cm, TCP_FD *conn, short event) {
                        "TCP %u\t| Error allocating memory for the socket",
                        (unsigned)newsockfd);
         UA_close(newsockfd);
-        return;
+        return true;
     }
 
     newConn->rfd.fd = newsockfd;
+    SIMPLEQ_INIT(&newConn->sendQueue);
     newConn->rfd.listenEvents = UA_FDEVENT_IN;
     newConn->rfd.es = &cm->eventSource;
     newConn->rfd.eventSourceCB = (UA_FDCallback)TCP_connectionSocketCallback;
@@ -321,7 +549,7 @@ TCP_listenSocketCallback(UA_ConnectionManager *cm, TCP_FD *conn, short event) {
                        (unsigned)newsockfd);
         UA_free(newConn);
         UA_close(newsockfd);
-        return;
+        return true;
     }
 
     /* Register internally in the EventSource */
@@ -345,6 +573,43 @@ TCP_listenSocketCallback(UA_ConnectionManager *cm, TCP_FD *conn, short event) {
                            UA_CONNECTIONSTATE_ESTABLISHED,
                            &kvm, UA_BYTESTRING_NULL);
     UA_LOCK(&el->elMutex);
+    return true;
+}
+
+/* Gets called when new connections open or if the listenSocket is closed.
+ * Pending connections are accepted in a batch. So a backlog of connection
+ * requests is drained quickly. */
+static void
+TCP_listenSocketCallback(UA_ConnectionManager *cm, TCP_FD *conn, short event) {
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    UA_LOCK_ASSERT(&el->elMutex);
+
+    UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                 "TCP %u\t| Callback on server socket",
+                 (unsigned)conn->rfd.fd);
+
+    UA_UInt32 maxAccepts = TCP_DEFAULT_ACCEPTBATCH;
+    const UA_UInt32 *configMaxAccepts = (const UA_UInt32*)
+        UA_KeyValueMap_getScalar(&cm->eventSource.params,
+                                 tcpManagerParams[TCP_MANAGERPARAMINDEX_ACCEPTBATCH].name,
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+    if(configMaxAccepts && *configMaxAccepts > 0)
+        maxAccepts = *configMaxAccepts;
+
+    UA_UInt32 rateLimit = 0;
+    const UA_UInt32 *configRateLimit = (const UA_UInt32*)
+        UA_KeyValueMap_getScalar(&cm->eventSource.params,
+                                 tcpManagerParams[TCP_MANAGERPARAMINDEX_ACCEPTRATE].name,
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+    if(configRateLimit)
+        rateLimit = *configRateLimit;
+
+    for(UA_UInt32 accepts = 0; accepts < maxAccepts; accepts++) {
+        /* Stop if the listen socket was closed (also in the application
+         * callback) */
+        if(!TCP_acceptConnection(cm, conn, rateLimit) || conn->rfd.dc.callback)
+            return;
+    }
 }
 
 static UA_StatusCode
@@ -617,9 +882,7 @@ TCP_shutdown(UA_ConnectionManager *cm, TCP_FD *conn) {
     dc->application = cm;
     dc->context = conn;
 
-    /* Don't use the "public" el->addDelayedCallback. It takes a lock. */
-    dc->next = el->delayedCallbacks;
-    el->delayedCallbacks = dc;
+    UA_EventLoopPOSIX_addDelayedCallback(&el->eventLoop, dc);
 }
 
 static UA_StatusCode
@@ -644,64 +907,221 @@ TCP_shutdownConnection(UA_ConnectionManager *cm, uintptr_t connectionId) {
     return UA_STATUSCODE_GOOD;
 }
 
+/* Append the unsent remainder of the buffer to the outbound queue. Takes
+ * ownership of the buffer unless it is the static send buffer. */
+static UA_StatusCode
+TCP_enqueue(UA_POSIXConnectionManager *pcm, TCP_FD *conn,
+            UA_ByteString *buf, size_t pos) {
+    TCP_SendBuffer *sb = (TCP_SendBuffer*)UA_malloc(sizeof(TCP_SendBuffer));
+    if(!sb)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    if(buf->data == pcm->txBuffer.data) {
+        UA_ByteString rest = {buf->length - pos, buf->data + pos};
+        UA_StatusCode res = UA_ByteString_copy(&rest, &sb->buf);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_free(sb);
+            return res;
+        }
+        sb->pos = 0;
+    } else {
+        sb->buf = *buf;
+        sb->pos = pos;
+        UA_ByteString_init(buf);
+    }
+    conn->sendQueueSize += sb->buf.length - sb->pos;
+    SIMPLEQ_INSERT_TAIL(&conn->sendQueue, sb, next);
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Flush after buffers were enqueued. Sending becomes blocking if the queue
+ * exceeds the configured send-queue-size. */
+static UA_StatusCode
+TCP_processSendQueue(UA_ConnectionManager *cm, TCP_FD *conn) {
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    size_t limit = TCP_DEFAULT_SENDQUEUE;
+    const UA_UInt32 *configLimit = (const UA_UInt32*)
+        UA_KeyValueMap_getScalar(&cm->eventSource.params,
+                                 tcpManagerParams[TCP_MANAGERPARAMINDEX_SENDQUEUE].name,
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+    if(configLimit)
+        limit = *configLimit;
+    UA_StatusCode res = TCP_flushSendQueue(conn, conn->sendQueueSize > limit);
+    if(res == UA_STATUSCODE_GOOD)
+        TCP_updateSendEvents(el, conn);
+    return res;
+}
+
 static UA_StatusCode
 TCP_sendWithConnection(UA_ConnectionManager *cm, uintptr_t connectionId,
                        const UA_KeyValueMap *params, UA_ByteString *buf) {
-    /* We may not have a lock. But we need not take it. As the connectionId is
-     * the fd, no need to do a lookup and access internal data strucures. */
-
-    /* Prevent OS signals when sending to a closed socket */
-    int flags = MSG_NOSIGNAL;
+    UA_POSIXConnectionManager *pcm = (UA_POSIXConnectionManager*)cm;
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    UA_LOCK(&el->elMutex);
 
-    struct pollfd tmp_poll_fd;
-    tmp_poll_fd.fd = (UA_FD)connectionId;
-    tmp_poll_fd.events = UA_POLLOUT;
+    UA_FD fd = (UA_FD)connectionId;
+    TCP_FD *conn = (TCP_FD*)ZIP_FIND(UA_FDTree, &pcm->fds, &fd);
+    if(!conn || conn->rfd.dc.callback) {
+        UA_EventLoopPOSIX_freeNetworkBuffer(cm, connectionId, buf);
+        UA_UNLOCK(&el->elMutex);
+        return UA_STATUSCODE_BADCONNECTIONCLOSED;
+    }
 
-    /* Send the full buffer. This may require several calls to send */
+    /* Send directly if nothing is queued. Otherwise the buffer is queued to
+     * keep the order. Prevent OS signals when sending to a closed socket. */
     size_t nWritten = 0;
-    do {
-        ssize_t n = 0;
-        do {
-            UA_LOG_DEBUG(cm->eventSource.eventLoop->logger, UA_LOGCATEGORY_NETWORK,
+    if(SIMPLEQ_EMPTY(&conn->sendQueue)) {
+        while(nWritten < buf->length) {
+            UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
                          "TCP %u\t| Attempting to send", (unsigned)connectionId);
-            size_t bytes_to_send = buf->length - nWritten;
-            n = UA_send((UA_FD)connectionId,
-                        (const char*)buf->data + nWritten,
-                        bytes_to_send, flags);
+            ssize_t n = UA_send(fd, (const char*)buf->data + nWritten,
+                                buf->length - nWritten, MSG_NOSIGNAL);
             if(n < 0) {
+                if(UA_ERRNO == UA_INTERRUPTED)
+                    continue;
                 /* An error we cannot recover from? */
-                if(UA_ERRNO != UA_INTERRUPTED && UA_ERRNO != UA_WOULDBLOCK &&
-                   UA_ERRNO != UA_AGAIN)
+                if(UA_ERRNO != UA_WOULDBLOCK && UA_ERRNO != UA_AGAIN)
                     goto shutdown;
-
-                /* Poll for the socket resources to become available and retry
-                 * (blocking) */
-                int poll_ret;
-                do {
-                    poll_ret = UA_poll(&tmp_poll_fd, 1, 100);
-                    if(poll_ret < 0 && UA_ERRNO != UA_INTERRUPTED)
-                        goto shutdown;
-                } while(poll_ret <= 0);
+                break; /* The socket would block */
             }
-        } while(n < 0);
-        nWritten += (size_t)n;
-    } while(nWritten < buf->length);
+            nWritten += (size_t)n;
+        }
+    }
+
+    /* Queue the remainder. It is sent once the socket becomes writable. */
+    if(nWritten < buf->length) {
+        UA_StatusCode res = TCP_enqueue(pcm, conn, buf, nWritten);
+        if(res == UA_STATUSCODE_GOOD)
+            res = TCP_processSendQueue(cm, conn);
+        if(res != UA_STATUSCODE_GOOD)
+            goto shutdown;
+    }
 
     /* Clean up and return */
     UA_EventLoopPOSIX_freeNetworkBuffer(cm, connectionId, buf);
+    UA_UNLOCK(&el->elMutex);
     return UA_STATUSCODE_GOOD;
 
  shutdown:
     /* Error -> shutdown the connection  */
     UA_LOG_SOCKET_ERRNO_WRAP(
-       UA_LOG_ERROR(cm->eventSource.eventLoop->logger, UA_LOGCATEGORY_NETWORK,
+       UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
                     "TCP %u\t| Send failed with error %s",
                     (unsigned)connectionId, errno_str));
-    TCP_shutdownConnection(cm, connectionId);
+    TCP_shutdown(cm, conn);
     UA_EventLoopPOSIX_freeNetworkBuffer(cm, connectionId, buf);
+    UA_UNLOCK(&el->elMutex);
+    return UA_STATUSCODE_BADCONNECTIONCLOSED;
+}
+
+#if defined(UA_ARCHITECTURE_POSIX)
+
+/* Number of buffers handed to the kernel in a single sendmsg call */
+#define TCP_SENDV_MAXBUFS 16
+
+static UA_StatusCode
+TCP_sendWithConnectionV(UA_ConnectionManager *cm, uintptr_t connectionId,
+                        const UA_KeyValueMap *params, UA_ByteString *bufs,
+                        size_t bufsSize) {
+    UA_POSIXConnectionManager *pcm = (UA_POSIXConnectionManager*)cm;
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    UA_LOCK(&el->elMutex);
+
+    UA_FD fd = (UA_FD)connectionId;
+    TCP_FD *conn = (TCP_FD*)ZIP_FIND(UA_FDTree, &pcm->fds, &fd);
+    if(!conn || conn->rfd.dc.callback) {
+        for(size_t i = 0; i < bufsSize; i++)
+            UA_EventLoopPOSIX_freeNetworkBuffer(cm, connectionId, &bufs[i]);
+        UA_UNLOCK(&el->elMutex);
+        return UA_STATUSCODE_BADCONNECTIONCLOSED;
+    }
+
+    /* Send the buffers in batches of up to TCP_SENDV_MAXBUFS if nothing is
+     * queued. Stop when the socket would block. */
+    size_t i = 0;   /* Current buffer */
+    size_t pos = 0; /* Bytes sent from the current buffer */
+    if(SIMPLEQ_EMPTY(&conn->sendQueue)) {
+        while(i < bufsSize) {
+            struct iovec iov[TCP_SENDV_MAXBUFS];
+            size_t iovSize = 0;
+            for(; iovSize < TCP_SENDV_MAXBUFS && i + iovSize < bufsSize; iovSize++) {
+                size_t offset = (iovSize == 0) ? pos : 0;
+                iov[iovSize].iov_base = bufs[i + iovSize].data + offset;
+                iov[iovSize].iov_len = bufs[i + iovSize].length - offset;
+            }
+
+            struct msghdr msg;
+            memset(&msg, 0, sizeof(struct msghdr));
+            msg.msg_iov = iov;
+            msg.msg_iovlen = iovSize;
+            UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                         "TCP %u\t| Attempting to send %u buffers",
+                         (unsigned)connectionId, (unsigned)iovSize);
+            ssize_t n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+            if(n < 0) {
+                if(UA_ERRNO == UA_INTERRUPTED)
+                    continue;
+                /* An error we cannot recover from? */
+                if(UA_ERRNO != UA_WOULDBLOCK && UA_ERRNO != UA_AGAIN)
+                    goto shutdown;
+                break; /* The socket would block */
+            }
+
+            /* Advance over the written bytes and empty buffers */
+            size_t written = (size_t)n;
+            while(i < bufsSize && written >= bufs[i].length - pos) {
+                written -= bufs[i].length - pos;
+                pos = 0;
+                i++;
+            }
+            pos += written;
+        }
+    }
+
+    /* Queue the remainder. It is sent once the socket becomes writable. */
+    if(i < bufsSize) {
+        for(; i < bufsSize; i++, pos = 0) {
+            UA_StatusCode res = TCP_enqueue(pcm, conn, &bufs[i], pos);
+            if(res != UA_STATUSCODE_GOOD)
+                goto shutdown;
+        }
+        if(TCP_processSendQueue(cm, conn) != UA_STATUSCODE_GOOD)
+            goto shutdown;
+    }
+
+    /* Clean up and return */
+    for(size_t j = 0; j < bufsSize; j++)
+        UA_EventLoopPOSIX_freeNetworkBuffer(cm, connectionId, &bufs[j]);
+    UA_UNLOCK(&el->elMutex);
+    return UA_STATUSCODE_GOOD;
+
+ shutdown:
+    /* Error -> shutdown the connection  */
+    UA_LOG_SOCKET_ERRNO_WRAP(
+       UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                    "TCP %u\t| Send failed with error %s",
+                    (unsigned)connectionId, errno_str));
+    TCP_shutdown(cm, conn);
+    for(size_t j = 0; j < bufsSize; j++)
+        UA_EventLoopPOSIX_freeNetworkBuffer(cm, connectionId, &bufs[j]);
+    UA_UNLOCK(&el->elMutex);
     return UA_STATUSCODE_BADCONNECTIONCLOSED;
 }
 
+#endif /* UA_ARCHITECTURE_POSIX */
+
+static size_t
+TCP_getSendQueueSize(UA_ConnectionManager *cm, uintptr_t connectionId) {
+    UA_POSIXConnectionManager *pcm = (UA_POSIXConnectionManager*)cm;
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    (void)el;
+    UA_LOCK(&el->elMutex);
+    UA_FD fd = (UA_FD)connectionId;
+    TCP_FD *conn = (TCP_FD*)ZIP_FIND(UA_FDTree, &pcm->fds, &fd);
+    size_t size = (conn) ? conn->sendQueueSize : 0;
+    UA_UNLOCK(&el->elMutex);
+    return size;
+}
+
 /* Create a listen-socket that waits for incoming connections */
 static UA_StatusCode
 TCP_openPassiveConnection(UA_POSIXConnectionManager *pcm, const UA_KeyValueMap *params,
@@ -838,6 +1258,7 @@ TCP_openActiveConnection(UA_POSIXConnectionManager *pcm, const UA_KeyValueMap *p
     res |= UA_EventLoopPOSIX_setNonBlocking(newSock);
     res |= UA_EventLoopPOSIX_setNoSigPipe(newSock);
     res |= TCP_setNoNagle(newSock);
+    UA_EventLoopPOSIX_setBusyPoll(el, newSock);
     if(res != UA_STATUSCODE_GOOD) {
         UA_LOG_SOCKET_ERRNO_WRAP(
             UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
@@ -879,6 +1300,7 @@ TCP_openActiveConnection(UA_POSIXConnectionManager *pcm, const UA_KeyValueMap *p
     }
 
     newConn->rfd.fd = newSock;
+    SIMPLEQ_INIT(&newConn->sendQueue);
     newConn->rfd.es = &pcm->cm.eventSource;
     newConn->rfd.eventSourceCB = (UA_FDCallback)TCP_connectionSocketCallback;
     newConn->rfd.listenEvents = UA_FDEVENT_OUT; /* Switched to _IN once the
@@ -1003,6 +1425,13 @@ TCP_eventSourceStart(UA_ConnectionManager *cm) {
     if(res != UA_STATUSCODE_GOOD)
         goto finish;
 
+#if defined(UA_ARCHITECTURE_POSIX)
+    /* Batched sending requires independent network buffers. Not available
+     * with a static send buffer. */
+    cm->sendWithConnectionV = (pcm->txBuffer.length == 0) ?
+        TCP_sendWithConnectionV : NULL;
+#endif
+
     /* Set the EventSource to the started state */
     cm->eventSource.state = UA_EVENTSOURCESTATE_STARTED;
 
@@ -1064,7 +1493,7 @@ static const char *tcpName = "tcp";
 UA_ConnectionManager *
 UA_ConnectionManager_new_POSIX_TCP(const UA_String eventSourceName) {
     UA_POSIXConnectionManager *cm = (UA_POSIXConnectionManager*)
-        UA_calloc(1, sizeof(UA_POSIXConnectionManager));
+        UA_calloc(1, sizeof(TCP_ConnectionManager));
     if(!cm)
         return NULL;
 
@@ -1077,7 +1506,9 @@ UA_ConnectionManager_new_POSIX_TCP(const UA_String eventSourceName) {
     cm->cm.openConnection = TCP_openConnection;
     cm->cm.allocNetworkBuffer = UA_EventLoopPOSIX_allocNetworkBuffer;
     cm->cm.freeNetworkBuffer = UA_EventLoopPOSIX_freeNetworkBuffer;
+    cm->cm.retainNetworkBuffer = UA_EventLoopPOSIX_retainNetworkBuffer;
     cm->cm.sendWithConnection = TCP_sendWithConnection;
+    cm->cm.getSendQueueSize = TCP_getSendQueueSize;
     cm->cm.closeConnection = TCP_shutdownConnection;
     return &cm->cm;
 }
@@ -17,14 +17,24 @@
 
 /* Configuration parameters */
 
-#define UDP_MANAGERPARAMS 2
+#define UDP_MANAGERPARAMS 3
+#define UDP_MANAGERPARAMINDEX_RECVBATCH 2
 
 static UA_KeyValueRestriction udpManagerParams[UDP_MANAGERPARAMS] = {
     {{0, UA_STRING_STATIC("recv-bufsize")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false},
-    {{0, UA_STRING_STATIC("send-bufsize")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false}
+    {{0, UA_STRING_STATIC("send-bufsize")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false},
+    {{0, UA_STRING_STATIC("recv-batchsize")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false}
 };
 
-#define UDP_PARAMETERSSIZE 9
+/* Receive and send several datagrams with a single syscall */
+#if defined(__linux__)
+# define UDP_MMSG 1
+# define UDP_MAXBATCH 64
+# define UDP_DEFAULT_RECVBATCH 8
+# include <linux/net_tstamp.h> /* txtime */
+#endif
+
+#define UDP_PARAMETERSSIZE 14
 #define UDP_PARAMINDEX_LISTEN 0
 #define UDP_PARAMINDEX_ADDR 1
 #define UDP_PARAMINDEX_PORT 2
@@ -34,6 +44,11 @@ static UA_KeyValueRestriction udpManagerParams[UDP_MANAGERPARAMS] = {
 #define UDP_PARAMINDEX_REUSE 6
 #define UDP_PARAMINDEX_SOCKPRIO 7
 #define UDP_PARAMINDEX_VALIDATE 8
+#define UDP_PARAMINDEX_TXTIME_ENABLE 9
+#define UDP_PARAMINDEX_TXTIME_FLAGS 10
+#define UDP_PARAMINDEX_TXTIME 11
+#define UDP_PARAMINDEX_TXTIME_PICO 12
+#define UDP_PARAMINDEX_TXTIME_DROP 13
 
 static UA_KeyValueRestriction udpConnectionParams[UDP_PARAMETERSSIZE] = {
     {{0, UA_STRING_STATIC("listen")}, &UA_TYPES[UA_TYPES_BOOLEAN], false, true, false},
@@ -44,7 +59,12 @@ static UA_KeyValueRestriction udpConnectionParams[UDP_PARAMETERSSIZE] = {
     {{0, UA_STRING_STATIC("loopback")}, &UA_TYPES[UA_TYPES_BOOLEAN], false, true, false},
     {{0, UA_STRING_STATIC("reuse")}, &UA_TYPES[UA_TYPES_BOOLEAN], false, true, false},
     {{0, UA_STRING_STATIC("sockpriority")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false},
-    {{0, UA_STRING_STATIC("validate")}, &UA_TYPES[UA_TYPES_BOOLEAN], false, true, false}
+    {{0, UA_STRING_STATIC("validate")}, &UA_TYPES[UA_TYPES_BOOLEAN], false, true, false},
+    {{0, UA_STRING_STATIC("txtime-enable")}, &UA_TYPES[UA_TYPES_BOOLEAN], false, true, false},
+    {{0, UA_STRING_STATIC("txtime-flags")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false},
+    {{0, UA_STRING_STATIC("txtime")}, &UA_TYPES[UA_TYPES_DATETIME], false, true, false},
+    {{0, UA_STRING_STATIC("txtime-pico")}, &UA_TYPES[UA_TYPES_UINT16], false, true, false},
+    {{0, UA_STRING_STATIC("txtime-drop-late")}, &UA_TYPES[UA_TYPES_BOOLEAN], false, true, false}
 };
 
 /* A registered file descriptor with an additional method pointer */
@@ -61,6 +81,8 @@ typedef struct {
 #else
     socklen_t sendAddrLength;
 #endif
+
+    UA_Boolean txtimeEnabled;
 } UDP_FD;
 
 typedef enum {
@@ -638,6 +660,122 @@ UDP_delayedClose(void *application, void *context) {
     UA_UNLOCK(&el->elMutex);
 }
 
+/* Number of datagrams received with a single syscall */
+static size_t
+UDP_getRecvBatchSize(UA_POSIXConnectionManager *pcm) {
+#ifdef UDP_MMSG
+    const UA_UInt32 *batch = (const UA_UInt32*)
+        UA_KeyValueMap_getScalar(&pcm->cm.eventSource.params,
+                                 udpManagerParams[UDP_MANAGERPARAMINDEX_RECVBATCH].name,
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+    if(!batch)
+        return UDP_DEFAULT_RECVBATCH;
+    if(*batch == 0)
+        return 1;
+    if(*batch > UDP_MAXBATCH)
+        return UDP_MAXBATCH;
+    return *batch;
+#else
+    return 1;
+#endif
+}
+
+/* Forward a received datagram to the application */
+static void
+UDP_deliver(UA_POSIXConnectionManager *pcm, UDP_FD *conn,
+            struct sockaddr_storage *source, UA_ByteString msg) {
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)pcm->cm.eventSource.eventLoop;
+
+    /* Extract message source and port */
+    char sourceAddr[64];
+    UA_UInt16 sourcePort;
+    switch(source->ss_family) {
+        case AF_INET:
+            inet_ntop(AF_INET, &((struct sockaddr_in *)source)->sin_addr,
+                    sourceAddr, 64);
+            sourcePort = htons(((struct sockaddr_in *)source)->sin_port);
+            break;
+        case AF_INET6:
+            inet_ntop(AF_INET6, &(((struct sockaddr_in6 *)source)->sin6_addr),
+                    sourceAddr, 64);
+            sourcePort = htons(((struct sockaddr_in6 *)source)->sin6_port);
+            break;
+        default:
+            sourceAddr[0] = 0;
+            sourcePort = 0;
+    }
+
+    UA_String sourceAddrStr = UA_STRING(sourceAddr);
+    UA_KeyValuePair kvp[2];
+    kvp[0].key = UA_QUALIFIEDNAME(0, "remote-address");
+    UA_Variant_setScalar(&kvp[0].value, &sourceAddrStr, &UA_TYPES[UA_TYPES_STRING]);
+    kvp[1].key = UA_QUALIFIEDNAME(0, "remote-port");
+    UA_Variant_setScalar(&kvp[1].value, &sourcePort, &UA_TYPES[UA_TYPES_UINT16]);
+    UA_KeyValueMap kvm = {2, kvp};
+
+    UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                 "UDP %u\t| Received message of size %u from %s on port %u",
+                 (unsigned)conn->rfd.fd, (unsigned)msg.length,
+                 sourceAddr, sourcePort);
+
+    /* Callback to the application layer */
+    UA_UNLOCK(&el->elMutex);
+    conn->applicationCB(&pcm->cm, (uintptr_t)conn->rfd.fd,
+                        conn->application, &conn->context,
+                        UA_CONNECTIONSTATE_ESTABLISHED,
+                        &kvm, msg);
+    UA_LOCK(&el->elMutex);
+}
+
+#ifdef UDP_MMSG
+/* Receive up to batch datagrams into the slots of the rx buffer */
+static void
+UDP_receiveBatch(UA_POSIXConnectionManager *pcm, UDP_FD *conn, size_t batch) {
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)pcm->cm.eventSource.eventLoop;
+    size_t slotSize = pcm->rxBuffer.length / batch;
+
+    struct mmsghdr msgs[UDP_MAXBATCH];
+    struct iovec iovs[UDP_MAXBATCH];
+    struct sockaddr_storage sources[UDP_MAXBATCH];
+    memset(msgs, 0, sizeof(struct mmsghdr) * batch);
+    for(size_t i = 0; i < batch; i++) {
+        iovs[i].iov_base = pcm->rxBuffer.data + (i * slotSize);
+        iovs[i].iov_len = slotSize;
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_name = &sources[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
+    }
+
+    int ret = recvmmsg(conn->rfd.fd, msgs, (unsigned)batch, MSG_DONTWAIT, NULL);
+
+    /* Receive has failed */
+    if(ret <= 0) {
+        if(UA_ERRNO == UA_INTERRUPTED)
+            return;
+
+        /* Orderly shutdown of the socket */
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                        "UDP %u\t| recv signaled the socket was shutdown (%s)",
+                        (unsigned)conn->rfd.fd, errno_str));
+        UDP_close(pcm, conn);
+        return;
+    }
+
+    /* Forward the datagrams. Stop if the application closes the connection
+     * in the callback. */
+    for(int i = 0; i < ret; i++) {
+        if(msgs[i].msg_len == 0)
+            continue;
+        UA_ByteString msg = {msgs[i].msg_len, (UA_Byte*)iovs[i].iov_base};
+        UDP_deliver(pcm, conn, &sources[i], msg);
+        if(conn->rfd.dc.callback)
+            return;
+    }
+}
+#endif
+
 /* Gets called when a socket receives data or closes */
 static void
 UDP_connectionSocketCallback(UA_POSIXConnectionManager *pcm, UDP_FD *conn,
@@ -658,6 +796,15 @@ UDP_connectionSocketCallback(UA_POSIXConnectionManager *pcm, UDP_FD *conn,
         return;
     }
 
+#ifdef UDP_MMSG
+    /* Receive a batch of datagrams */
+    size_t batch = UDP_getRecvBatchSize(pcm);
+    if(batch > 1) {
+        UDP_receiveBatch(pcm, conn, batch);
+        return;
+    }
+#endif
+
     UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
                  "UDP %u\t| Allocate receive buffer", (unsigned)conn->rfd.fd);
 
@@ -693,46 +840,7 @@ UDP_connectionSocketCallback(UA_POSIXConnectionManager *pcm, UDP_FD *conn,
     }
 
     response.length = (size_t)ret; /* Set the length of the received buffer */
-
-    /* Extract message source and port */
-    char sourceAddr[64];
-    UA_UInt16 sourcePort;
-    switch(source.ss_family) {
-        case AF_INET:
-            inet_ntop(AF_INET, &((struct sockaddr_in *)&source)->sin_addr,
-                    sourceAddr, 64);
-            sourcePort = htons(((struct sockaddr_in *)&source)->sin_port);
-            break;
-        case AF_INET6:
-            inet_ntop(AF_INET6, &(((struct sockaddr_in6 *)&source)->sin6_addr),
-                    sourceAddr, 64);
-            sourcePort = htons(((struct sockaddr_in6 *)&source)->sin6_port);
-            break;
-        default:
-            sourceAddr[0] = 0;
-            sourcePort = 0;
-    }
-
-    UA_String sourceAddrStr = UA_STRING(sourceAddr);
-    UA_KeyValuePair kvp[2];
-    kvp[0].key = UA_QUALIFIEDNAME(0, "remote-address");
-    UA_Variant_setScalar(&kvp[0].value, &sourceAddrStr, &UA_TYPES[UA_TYPES_STRING]);
-    kvp[1].key = UA_QUALIFIEDNAME(0, "remote-port");
-    UA_Variant_setScalar(&kvp[1].value, &sourcePort, &UA_TYPES[UA_TYPES_UINT16]);
-    UA_KeyValueMap kvm = {2, kvp};
-
-    UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
-                 "UDP %u\t| Received message of size %u from %s on port %u",
-                 (unsigned)conn->rfd.fd, (unsigned)ret,
-                 sourceAddr, sourcePort);
-
-    /* Callback to the application layer */
-    UA_UNLOCK(&el->elMutex);
-    conn->applicationCB(&pcm->cm, (uintptr_t)conn->rfd.fd,
-                        conn->application, &conn->context,
-                        UA_CONNECTIONSTATE_ESTABLISHED,
-                        &kvm, response);
-    UA_LOCK(&el->elMutex);
+    UDP_deliver(pcm, conn, &source, response);
 }
 
 static UA_StatusCode
@@ -777,6 +885,7 @@ UDP_registerListenSocket(UA_POSIXConnectionManager *pcm, UA_UInt16 port,
         UA_close(listenSocket);
         return UA_STATUSCODE_BADCONNECTIONREJECTED;
     }
+    UA_EventLoopPOSIX_setBusyPoll(el, listenSocket);
 
     /* Are we going to prepare a socket for multicast? */
     MultiCastType mc = multiCastType(info);
@@ -984,9 +1093,7 @@ UDP_shutdown(UA_ConnectionManager *cm, UA_RegisteredFD *rfd) {
     dc->application = cm;
     dc->context = rfd;
 
-    /* Don't use the "public" el->addDelayedCallback. It takes a lock. */
-    dc->next = el->delayedCallbacks;
-    el->delayedCallbacks = dc;
+    UA_EventLoopPOSIX_addDelayedCallback(&el->eventLoop, dc);
 }
 
 static UA_StatusCode
@@ -1009,6 +1116,107 @@ UDP_shutdownConnection(UA_ConnectionManager *cm, uintptr_t connectionId) {
     return UA_STATUSCODE_GOOD;
 }
 
+/* Enable sending with a txtime. The kernel (and the NIC with an ETF qdisc)
+ * holds the datagrams back until the txtime of the monotonic clock source of
+ * the EventLoop. */
+static void
+UDP_enableTxtime(UA_EventLoopPOSIX *el, UDP_FD *conn, const UA_KeyValueMap *params) {
+    const UA_Boolean *txtime_enable = (const UA_Boolean*)
+        UA_KeyValueMap_getScalar(params,
+                                 udpConnectionParams[UDP_PARAMINDEX_TXTIME_ENABLE].name,
+                                 &UA_TYPES[UA_TYPES_BOOLEAN]);
+    if(!txtime_enable || !*txtime_enable)
+        return;
+#ifndef SO_TXTIME
+    UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                   "UDP %u\t| txtime feature not supported",
+                   (unsigned)conn->rfd.fd);
+#else
+    const UA_UInt32 *txtime_flags = (const UA_UInt32*)
+        UA_KeyValueMap_getScalar(params,
+                                 udpConnectionParams[UDP_PARAMINDEX_TXTIME_FLAGS].name,
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+    struct sock_txtime so_txtime_val;
+    memset(&so_txtime_val, 0, sizeof(struct sock_txtime));
+    so_txtime_val.clockid = el->clockSourceMonotonic;
+    so_txtime_val.flags = SOF_TXTIME_REPORT_ERRORS;
+    if(txtime_flags)
+        so_txtime_val.flags = *txtime_flags;
+    if(setsockopt(conn->rfd.fd, SOL_SOCKET, SO_TXTIME,
+                  &so_txtime_val, sizeof(so_txtime_val)) == 0) {
+        conn->txtimeEnabled = true;
+    } else {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                          "UDP %u\t| Could not enable txtime (%s)",
+                          (unsigned)conn->rfd.fd, errno_str));
+    }
+#endif
+}
+
+#ifdef SO_TXTIME
+/* Aligned buffer for the txtime control messages */
+typedef union {
+    char buf[CMSG_SPACE(sizeof(__u64))
+#ifdef SCM_DROP_IF_LATE
+             + CMSG_SPACE(sizeof(uint8_t))
+#endif
+             ];
+    struct cmsghdr align;
+} UDP_TxtimeControl;
+
+/* Encode the txtime send parameters as control messages. The same control
+ * buffer can be attached to several messages. */
+static UA_StatusCode
+UDP_setTxtimeControl(UA_EventLoopPOSIX *el, UDP_FD *conn,
+                     const UA_KeyValueMap *params, UA_DateTime txtime,
+                     UDP_TxtimeControl *control) {
+    const UA_UInt16 *txtime_pico = (const UA_UInt16*)
+        UA_KeyValueMap_getScalar(params,
+                                 udpConnectionParams[UDP_PARAMINDEX_TXTIME_PICO].name,
+                                 &UA_TYPES[UA_TYPES_UINT16]);
+    const UA_Boolean *txtime_drop = (const UA_Boolean*)
+        UA_KeyValueMap_getScalar(params,
+                                 udpConnectionParams[UDP_PARAMINDEX_TXTIME_DROP].name,
+                                 &UA_TYPES[UA_TYPES_BOOLEAN]);
+#ifndef SCM_DROP_IF_LATE
+    if(txtime_drop) {
+        UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                     "UDP %u\t| txtime drop_if_late not supported on the current system",
+                     (unsigned)conn->rfd.fd);
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+    }
+#endif
+
+    /* Transform from 100ns since 1601 to ns since the Unix Epoch */
+    UA_UInt64 transmission_time = (UA_UInt64)
+        (txtime - UA_DATETIME_UNIX_EPOCH) * 100;
+    if(txtime_pico)
+        transmission_time += (*txtime_pico) / 1000;
+
+    struct msghdr message;
+    memset(&message, 0, sizeof(struct msghdr));
+    memset(control, 0, sizeof(UDP_TxtimeControl));
+    message.msg_control = control->buf;
+    message.msg_controllen = sizeof(control->buf);
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&message);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type  = SCM_TXTIME;
+    cmsg->cmsg_len   = CMSG_LEN(sizeof(__u64));
+    memcpy(CMSG_DATA(cmsg), &transmission_time, sizeof(__u64));
+
+#ifdef SCM_DROP_IF_LATE
+    cmsg = CMSG_NXTHDR(&message, cmsg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_DROP_IF_LATE;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(uint8_t));
+    *((uint8_t*)CMSG_DATA(cmsg)) = (!txtime_drop || *txtime_drop) ? 1: 0;
+#endif
+    return UA_STATUSCODE_GOOD;
+}
+#endif
+
 static UA_StatusCode
 UDP_sendWithConnection(UA_ConnectionManager *cm, uintptr_t connectionId,
                        const UA_KeyValueMap *params,
@@ -1027,6 +1235,40 @@ UDP_sendWithConnection(UA_ConnectionManager *cm, uintptr_t connectionId,
         return UA_STATUSCODE_BADINTERNALERROR;
     }
 
+    /* Was a txtime configured? */
+    const UA_DateTime *txtime = (const UA_DateTime*)
+        UA_KeyValueMap_getScalar(params, udpConnectionParams[UDP_PARAMINDEX_TXTIME].name,
+                                 &UA_TYPES[UA_TYPES_DATETIME]);
+    if(txtime && !conn->txtimeEnabled) {
+        UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                     "UDP %u\t| txtime was not configured for the connection",
+                     (unsigned)connectionId);
+        UA_UNLOCK(&el->elMutex);
+        UA_EventLoopPOSIX_freeNetworkBuffer(cm, connectionId, buf);
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+#ifdef SO_TXTIME
+    UDP_TxtimeControl control;
+    struct iovec iov;
+    struct msghdr message;
+    if(txtime) {
+        UA_StatusCode res = UDP_setTxtimeControl(el, conn, params, *txtime, &control);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_UNLOCK(&el->elMutex);
+            UA_EventLoopPOSIX_freeNetworkBuffer(cm, connectionId, buf);
+            return res;
+        }
+        memset(&message, 0, sizeof(struct msghdr));
+        message.msg_name = &conn->sendAddr;
+        message.msg_namelen = conn->sendAddrLength;
+        message.msg_iov = &iov;
+        message.msg_iovlen = 1;
+        message.msg_control = control.buf;
+        message.msg_controllen = sizeof(control.buf);
+    }
+#endif
+
     /* Send the full buffer. This may require several calls to send */
     size_t nWritten = 0;
     do {
@@ -1038,9 +1280,18 @@ UDP_sendWithConnection(UA_ConnectionManager *cm, uintptr_t connectionId,
             /* Prevent OS signals when sending to a closed socket */
             int flags = MSG_NOSIGNAL;
             size_t bytes_to_send = buf->length - nWritten;
-            n = UA_sendto((UA_FD)connectionId, (const char*)buf->data + nWritten,
-                          bytes_to_send, flags, (struct sockaddr*)&conn->sendAddr,
-                          conn->sendAddrLength);
+#ifdef SO_TXTIME
+            if(txtime) {
+                iov.iov_base = buf->data + nWritten;
+                iov.iov_len = bytes_to_send;
+                n = sendmsg((UA_FD)connectionId, &message, flags);
+            } else
+#endif
+            {
+                n = UA_sendto((UA_FD)connectionId, (const char*)buf->data + nWritten,
+                              bytes_to_send, flags, (struct sockaddr*)&conn->sendAddr,
+                              conn->sendAddrLength);
+            }
             if(n < 0) {
                 /* An error we cannot recover from? */
                 if(UA_ERRNO != UA_INTERRUPTED &&
@@ -1087,6 +1338,117 @@ UDP_sendWithConnection(UA_ConnectionManager *cm, uintptr_t connectionId,
     return UA_STATUSCODE_GOOD;
 }
 
+#ifdef UDP_MMSG
+/* Send each buffer as a datagram. Up to UDP_MAXBATCH datagrams are handed to
+ * the kernel with a single syscall. */
+static UA_StatusCode
+UDP_sendWithConnectionV(UA_ConnectionManager *cm, uintptr_t connectionId,
+                        const UA_KeyValueMap *params, UA_ByteString *bufs,
+                        size_t bufsSize) {
+    UA_POSIXConnectionManager *pcm = (UA_POSIXConnectionManager*)cm;
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+
+    UA_LOCK(&el->elMutex);
+
+    /* Look up the registered UDP socket */
+    UA_FD fd = (UA_FD)connectionId;
+    UDP_FD *conn = (UDP_FD*)ZIP_FIND(UA_FDTree, &pcm->fds, &fd);
+    if(!conn) {
+        res = UA_STATUSCODE_BADINTERNALERROR;
+        goto cleanup;
+    }
+
+    /* Was a txtime configured? Then all datagrams are sent with it. */
+    const UA_DateTime *txtime = (const UA_DateTime*)
+        UA_KeyValueMap_getScalar(params, udpConnectionParams[UDP_PARAMINDEX_TXTIME].name,
+                                 &UA_TYPES[UA_TYPES_DATETIME]);
+    if(txtime && !conn->txtimeEnabled) {
+        UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                     "UDP %u\t| txtime was not configured for the connection",
+                     (unsigned)connectionId);
+        res = UA_STATUSCODE_BADINTERNALERROR;
+        goto cleanup;
+    }
+#ifdef SO_TXTIME
+    UDP_TxtimeControl control;
+    if(txtime) {
+        res = UDP_setTxtimeControl(el, conn, params, *txtime, &control);
+        if(res != UA_STATUSCODE_GOOD)
+            goto cleanup;
+    }
+#endif
+
+    size_t done = 0;
+    while(done < bufsSize) {
+        struct mmsghdr msgs[UDP_MAXBATCH];
+        struct iovec iovs[UDP_MAXBATCH];
+        size_t batch = bufsSize - done;
+        if(batch > UDP_MAXBATCH)
+            batch = UDP_MAXBATCH;
+        memset(msgs, 0, sizeof(struct mmsghdr) * batch);
+        for(size_t i = 0; i < batch; i++) {
+            iovs[i].iov_base = bufs[done + i].data;
+            iovs[i].iov_len = bufs[done + i].length;
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+            msgs[i].msg_hdr.msg_name = &conn->sendAddr;
+            msgs[i].msg_hdr.msg_namelen = conn->sendAddrLength;
+#ifdef SO_TXTIME
+            if(txtime) {
+                msgs[i].msg_hdr.msg_control = control.buf;
+                msgs[i].msg_hdr.msg_controllen = sizeof(control.buf);
+            }
+#endif
+        }
+
+        UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                     "UDP %u\t| Attempting to send %u datagrams",
+                     (unsigned)connectionId, (unsigned)batch);
+
+        /* Prevent OS signals when sending to a closed socket */
+        int n = sendmmsg(fd, msgs, (unsigned)batch, MSG_NOSIGNAL);
+        if(n > 0) {
+            done += (size_t)n;
+            continue;
+        }
+
+        /* An error we cannot recover from? */
+        if(UA_ERRNO != UA_INTERRUPTED &&
+           UA_ERRNO != UA_WOULDBLOCK &&
+           UA_ERRNO != UA_AGAIN)
+            goto shutdown;
+
+        /* Poll for the socket resources to become available and retry
+         * (blocking) */
+        int poll_ret;
+        struct pollfd tmp_poll_fd;
+        tmp_poll_fd.fd = fd;
+        tmp_poll_fd.events = UA_POLLOUT;
+        do {
+            poll_ret = UA_poll(&tmp_poll_fd, 1, 100);
+            if(poll_ret < 0 && UA_ERRNO != UA_INTERRUPTED)
+                goto shutdown;
+        } while(poll_ret <= 0);
+    }
+    goto cleanup;
+
+ shutdown:
+    UA_LOG_SOCKET_ERRNO_WRAP(
+       UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                    "UDP %u\t| Send failed with error %s",
+                    (unsigned)connectionId, errno_str));
+    UDP_shutdown(cm, &conn->rfd);
+    res = UA_STATUSCODE_BADCONNECTIONCLOSED;
+
+ cleanup:
+    UA_UNLOCK(&el->elMutex);
+    for(size_t i = 0; i < bufsSize; i++)
+        UA_EventLoopPOSIX_freeNetworkBuffer(cm, connectionId, &bufs[i]);
+    return res;
+}
+#endif
+
 static UA_StatusCode
 registerSocketAndDestinationForSend(const UA_KeyValueMap *params,
                                     const char *hostname, struct addrinfo *info,
@@ -1196,6 +1558,9 @@ UDP_openSendConnection(UA_POSIXConnectionManager *pcm, const UA_KeyValueMap *par
     conn->application = application;
     conn->context = context;
 
+    /* Enable txtime sending if configured */
+    UDP_enableTxtime(el, conn, params);
+
     /* Register the fd to trigger when output is possible (the connection is open) */
     res = UA_EventLoopPOSIX_registerFD(el, &conn->rfd);
     if(res != UA_STATUSCODE_GOOD) {
@@ -1359,6 +1724,23 @@ UDP_eventSourceStart(UA_ConnectionManager *cm) {
     if(res != UA_STATUSCODE_GOOD)
         goto finish;
 
+#ifdef UDP_MMSG
+    /* Extend the rx buffer to hold one datagram per slot of a receive batch */
+    size_t batch = UDP_getRecvBatchSize(pcm);
+    if(batch > 1) {
+        size_t slotSize = pcm->rxBuffer.length;
+        UA_ByteString_clear(&pcm->rxBuffer);
+        res = UA_ByteString_allocBuffer(&pcm->rxBuffer, slotSize * batch);
+        if(res != UA_STATUSCODE_GOOD)
+            goto finish;
+    }
+
+    /* Batched sending requires independent network buffers. Not available
+     * with a static send buffer. */
+    cm->sendWithConnectionV = (pcm->txBuffer.length == 0) ?
+        UDP_sendWithConnectionV : NULL;
+#endif
+
     /* Set the EventSource to the started state */
     cm->eventSource.state = UA_EVENTSOURCESTATE_STARTED;
 
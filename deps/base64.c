@@ -8,10 +8,217 @@
 
 #include "base64.h"
 #include <open62541/types.h>
+#include <string.h>
+
+/* Vectorized encoding and decoding with SSSE3 and AVX2 on x86. The kernels are
+ * compiled with a target attribute and selected at runtime. So they are also
+ * used when the library is built for the x86-64 baseline (SSE2). The kernels
+ * process full blocks only and leave the remainder (and the padding) to the
+ * scalar code. Based on the algorithms by Wojciech Mula and Daniel Lemire,
+ * "Faster Base64 Encoding and Decoding using AVX2 Instructions" (2018). */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define BASE64_X86
+# include <immintrin.h>
+# define BASE64_TARGET(t) __attribute__((target(t)))
+#endif
 
 static const unsigned char base64_table[65] =
 	"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
+#ifdef BASE64_X86
+
+/* Spread 12 input bytes to 16 bytes with a 6-bit index each */
+BASE64_TARGET("ssse3") static __m128i
+enc_reshuffle_ssse3(__m128i in) {
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7,
+                                           4, 5, 3, 4, 1, 2, 0, 1));
+    const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+    const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+    const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+    return _mm_or_si128(t1, t3);
+}
+
+/* Translate the 6-bit indices to the base64 characters. The ranges of the
+ * alphabet are mapped to an offset that is added to the index. */
+BASE64_TARGET("ssse3") static __m128i
+enc_translate_ssse3(const __m128i in) {
+    const __m128i lut = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52,
+                                      '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                      '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                      '/' - 63, 'A', 0, 0);
+    __m128i idx = _mm_subs_epu8(in, _mm_set1_epi8(51));
+    const __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), in);
+    idx = _mm_or_si128(idx, _mm_and_si128(less, _mm_set1_epi8(13)));
+    return _mm_add_epi8(_mm_shuffle_epi8(lut, idx), in);
+}
+
+BASE64_TARGET("ssse3") static size_t
+base64_enc_ssse3(const unsigned char **src, size_t len, unsigned char *out) {
+    const unsigned char *in = *src;
+    unsigned char *pos = out;
+    for(; len >= 16; len -= 12, in += 12, pos += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(const void*)in);
+        v = enc_translate_ssse3(enc_reshuffle_ssse3(v));
+        _mm_storeu_si128((__m128i*)(void*)pos, v);
+    }
+    *src = in;
+    return (size_t)(pos - out);
+}
+
+BASE64_TARGET("avx2") static size_t
+base64_enc_avx2(const unsigned char **src, size_t len, unsigned char *out) {
+    const __m256i shuf =
+        _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+                        10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+    const __m256i lut =
+        _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                         '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                         '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+                         'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                         '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                         '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    const unsigned char *in = *src;
+    unsigned char *pos = out;
+    /* Each 128bit lane takes 12 input bytes. The second load reads up to
+     * 12 + 16 = 28 bytes. */
+    for(; len >= 28; len -= 24, in += 24, pos += 32) {
+        __m256i v = _mm256_castsi128_si256(
+            _mm_loadu_si128((const __m128i*)(const void*)in));
+        v = _mm256_inserti128_si256(
+            v, _mm_loadu_si128((const __m128i*)(const void*)(in + 12)), 1);
+        v = _mm256_shuffle_epi8(v, shuf);
+        const __m256i t0 = _mm256_and_si256(v, _mm256_set1_epi32(0x0fc0fc00));
+        const __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+        const __m256i t2 = _mm256_and_si256(v, _mm256_set1_epi32(0x003f03f0));
+        const __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+        v = _mm256_or_si256(t1, t3);
+        __m256i idx = _mm256_subs_epu8(v, _mm256_set1_epi8(51));
+        const __m256i less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), v);
+        idx = _mm256_or_si256(idx, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+        v = _mm256_add_epi8(_mm256_shuffle_epi8(lut, idx), v);
+        _mm256_storeu_si256((__m256i*)(void*)pos, v);
+    }
+    *src = in;
+    return (size_t)(pos - out);
+}
+
+/* Map the characters to their 6-bit value. Both the standard and the URL-safe
+ * alphabet are accepted (as in the scalar table). Returns false if the block
+ * contains another character (e.g. padding). Then the scalar code takes
+ * over. */
+BASE64_TARGET("ssse3") static UA_Boolean
+dec_translate_ssse3(__m128i in, __m128i *out) {
+    const __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8('A' - 1)),
+                                        _mm_cmplt_epi8(in, _mm_set1_epi8('Z' + 1)));
+    const __m128i lower = _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8('a' - 1)),
+                                        _mm_cmplt_epi8(in, _mm_set1_epi8('z' + 1)));
+    const __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8('0' - 1)),
+                                        _mm_cmplt_epi8(in, _mm_set1_epi8('9' + 1)));
+    const __m128i plus = _mm_or_si128(_mm_cmpeq_epi8(in, _mm_set1_epi8('+')),
+                                      _mm_cmpeq_epi8(in, _mm_set1_epi8('-')));
+    const __m128i slash = _mm_cmpeq_epi8(in, _mm_set1_epi8('/'));
+    const __m128i under = _mm_cmpeq_epi8(in, _mm_set1_epi8('_'));
+    const __m128i valid =
+        _mm_or_si128(_mm_or_si128(upper, lower),
+                     _mm_or_si128(_mm_or_si128(digit, plus),
+                                  _mm_or_si128(slash, under)));
+    if(_mm_movemask_epi8(valid) != 0xffff)
+        return false;
+    /* '-' is two above '+' */
+    const __m128i minus = _mm_cmpeq_epi8(in, _mm_set1_epi8('-'));
+    __m128i shift = _mm_and_si128(upper, _mm_set1_epi8(-'A'));
+    shift = _mm_or_si128(shift, _mm_and_si128(lower, _mm_set1_epi8(26 - 'a')));
+    shift = _mm_or_si128(shift, _mm_and_si128(digit, _mm_set1_epi8(52 - '0')));
+    shift = _mm_or_si128(shift, _mm_and_si128(plus, _mm_set1_epi8(62 - '+')));
+    shift = _mm_sub_epi8(shift, _mm_and_si128(minus, _mm_set1_epi8('-' - '+')));
+    shift = _mm_or_si128(shift, _mm_and_si128(slash, _mm_set1_epi8(63 - '/')));
+    shift = _mm_or_si128(shift, _mm_and_si128(under, _mm_set1_epi8(63 - '_')));
+    *out = _mm_add_epi8(in, shift);
+    return true;
+}
+
+/* Pack 16 6-bit values to 12 bytes (in the lower 96 bits) */
+BASE64_TARGET("ssse3") static __m128i
+dec_pack_ssse3(__m128i v) {
+    const __m128i ab_bc = _mm_maddubs_epi16(v, _mm_set1_epi32(0x01400140));
+    const __m128i abcd = _mm_madd_epi16(ab_bc, _mm_set1_epi32(0x00011000));
+    return _mm_shuffle_epi8(abcd, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8,
+                                                14, 13, 12, -1, -1, -1, -1));
+}
+
+BASE64_TARGET("ssse3") static size_t
+base64_dec_ssse3(const unsigned char *src, size_t len, unsigned char *out,
+                 size_t *consumed) {
+    size_t i = 0;
+    unsigned char *pos = out;
+    for(; len - i >= 16; i += 16, pos += 12) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(const void*)&src[i]);
+        if(!dec_translate_ssse3(v, &v))
+            break;
+        v = dec_pack_ssse3(v);
+        _mm_storel_epi64((__m128i*)(void*)pos, v);
+        int tail = _mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+        memcpy(pos + 8, &tail, 4);
+    }
+    *consumed = i;
+    return (size_t)(pos - out);
+}
+
+BASE64_TARGET("avx2") static size_t
+base64_dec_avx2(const unsigned char *src, size_t len, unsigned char *out,
+                size_t *consumed) {
+    size_t i = 0;
+    unsigned char *pos = out;
+    for(; len - i >= 32; i += 32, pos += 24) {
+        __m256i in = _mm256_loadu_si256((const __m256i*)(const void*)&src[i]);
+        const __m256i upper =
+            _mm256_and_si256(_mm256_cmpgt_epi8(in, _mm256_set1_epi8('A' - 1)),
+                             _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), in));
+        const __m256i lower =
+            _mm256_and_si256(_mm256_cmpgt_epi8(in, _mm256_set1_epi8('a' - 1)),
+                             _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), in));
+        const __m256i digit =
+            _mm256_and_si256(_mm256_cmpgt_epi8(in, _mm256_set1_epi8('0' - 1)),
+                             _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), in));
+        const __m256i minus = _mm256_cmpeq_epi8(in, _mm256_set1_epi8('-'));
+        const __m256i plus =
+            _mm256_or_si256(_mm256_cmpeq_epi8(in, _mm256_set1_epi8('+')), minus);
+        const __m256i slash = _mm256_cmpeq_epi8(in, _mm256_set1_epi8('/'));
+        const __m256i under = _mm256_cmpeq_epi8(in, _mm256_set1_epi8('_'));
+        const __m256i valid =
+            _mm256_or_si256(_mm256_or_si256(upper, lower),
+                            _mm256_or_si256(_mm256_or_si256(digit, plus),
+                                            _mm256_or_si256(slash, under)));
+        if(_mm256_movemask_epi8(valid) != -1)
+            break;
+        __m256i shift = _mm256_and_si256(upper, _mm256_set1_epi8(-'A'));
+        shift = _mm256_or_si256(shift, _mm256_and_si256(lower, _mm256_set1_epi8(26 - 'a')));
+        shift = _mm256_or_si256(shift, _mm256_and_si256(digit, _mm256_set1_epi8(52 - '0')));
+        shift = _mm256_or_si256(shift, _mm256_and_si256(plus, _mm256_set1_epi8(62 - '+')));
+        shift = _mm256_sub_epi8(shift, _mm256_and_si256(minus, _mm256_set1_epi8('-' - '+')));
+        shift = _mm256_or_si256(shift, _mm256_and_si256(slash, _mm256_set1_epi8(63 - '/')));
+        shift = _mm256_or_si256(shift, _mm256_and_si256(under, _mm256_set1_epi8(63 - '_')));
+        __m256i v = _mm256_add_epi8(in, shift);
+
+        /* Pack to 12 bytes per lane. Then move the bytes of both lanes
+         * together. */
+        v = _mm256_maddubs_epi16(v, _mm256_set1_epi32(0x01400140));
+        v = _mm256_madd_epi16(v, _mm256_set1_epi32(0x00011000));
+        v = _mm256_shuffle_epi8(v, _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8,
+                                                    14, 13, 12, -1, -1, -1, -1,
+                                                    2, 1, 0, 6, 5, 4, 10, 9, 8,
+                                                    14, 13, 12, -1, -1, -1, -1));
+        v = _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+        _mm_storeu_si128((__m128i*)(void*)pos, _mm256_castsi256_si128(v));
+        _mm_storel_epi64((__m128i*)(void*)(pos + 16), _mm256_extracti128_si256(v, 1));
+    }
+    *consumed = i;
+    return (size_t)(pos - out);
+}
+
+#endif /* BASE64_X86 */
+
 unsigned char *
 UA_base64(const unsigned char *src, size_t len, size_t *out_len) {
     if(len == 0) {
@@ -36,6 +243,12 @@ UA_base64_buf(const unsigned char *src, size_t len, unsigned char *out) {
 	const unsigned char *end = src + len;
 	const unsigned char *in = src;
 	unsigned char *pos = out;
+#ifdef BASE64_X86
+	if(__builtin_cpu_supports("avx2"))
+		pos += base64_enc_avx2(&in, len, pos);
+	if(__builtin_cpu_supports("ssse3"))
+		pos += base64_enc_ssse3(&in, (size_t)(end - in), pos);
+#endif
 	while(end - in >= 3) {
 		*pos++ = base64_table[in[0] >> 2];
 		*pos++ = base64_table[((in[0] & 0x03) << 4) | (in[1] >> 4)];
@@ -96,37 +309,44 @@ UA_unbase64(const unsigned char *src, size_t len, size_t *out_len) {
 	if(!out)
 		return NULL;
 
-    /* Iterate over the input */
-	size_t pad = 0;
-    unsigned char count = 0;
-    unsigned char block[4];
+    /* Decode the full blocks without padding with the vector kernels */
+    size_t i = 0;
     unsigned char *pos = out;
-	for(size_t i = 0; i < len; i++) {
-		unsigned char tmp = dtable[src[i]];
-        if(tmp == 0x80)
+#ifdef BASE64_X86
+    size_t consumed = 0;
+    if(__builtin_cpu_supports("avx2")) {
+        pos += base64_dec_avx2(src, len, pos, &consumed);
+        i += consumed;
+    }
+    if(__builtin_cpu_supports("ssse3")) {
+        pos += base64_dec_ssse3(&src[i], len - i, pos, &consumed);
+        i += consumed;
+    }
+#endif
+
+    /* Iterate over the remaining input in blocks of four characters */
+    for(; i < len; i += 4) {
+        const unsigned char *s = &src[i];
+        unsigned char a = dtable[s[0]];
+        unsigned char b = dtable[s[1]];
+        unsigned char c = dtable[s[2]];
+        unsigned char d = dtable[s[3]];
+        if((a | b | c | d) & 0x80)
             goto error; /* Invalid input */
 
-		if(src[i] == '=')
-			pad++;
-
-		block[count] = tmp;
-		count++;
-		if(count == 4) {
-			*pos++ = (unsigned char)((block[0] << 2) | (block[1] >> 4));
-			*pos++ = (unsigned char)((block[1] << 4) | (block[2] >> 2));
-			*pos++ = (unsigned char)((block[2] << 6) | block[3]);
-			if(pad) {
-                if(pad == 1)
-                    pos--;
-                else if(pad == 2)
-                    pos -= 2;
-                else
-                    goto error; /* Invalid padding */
-				break;
-            }
-			count = 0;
-		}
-	}
+        *pos++ = (unsigned char)((a << 2) | (b >> 4));
+        *pos++ = (unsigned char)((b << 4) | (c >> 2));
+        *pos++ = (unsigned char)((c << 6) | d);
+
+        size_t pad = (size_t)(s[0] == '=') + (size_t)(s[1] == '=') +
+            (size_t)(s[2] == '=') + (size_t)(s[3] == '=');
+        if(pad) {
+            if(pad > 2)
+                goto error; /* Invalid padding */
+            pos -= pad;
+            break;
+        }
+    }
 
 	*out_len = (size_t)(pos - out);
 	return out;
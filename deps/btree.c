@@ -0,0 +1,380 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "btree.h"
+#include <open62541/types.h>
+#include <string.h>
+
+/* The element (with its rank and key) that is inserted, removed or searched
+ * for. Without the elm pointer, all elements with an equal key match. */
+typedef struct {
+    zip_cmp_cb cmp;
+    btree_rank_cb rank;
+    unsigned short keyoffset;
+    btree_rank r;
+    const void *key;
+    const void *elm;
+} btree_probe;
+
+#define BTREE_KEY(p, e) ((const void*)((const char*)(e) + (p)->keyoffset))
+
+static void
+initProbe(btree_probe *p, zip_cmp_cb cmp, btree_rank_cb rank,
+          unsigned short keyoffset, const void *elm) {
+    p->cmp = cmp;
+    p->rank = rank;
+    p->keyoffset = keyoffset;
+    p->elm = elm;
+    p->key = BTREE_KEY(p, elm);
+    p->r = rank(p->key);
+}
+
+static enum ZIP_CMP
+cmpSlot(const btree_probe *p, const struct btree_node *n, unsigned short i) {
+    if(p->r != n->ranks[i])
+        return (p->r < n->ranks[i]) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+    enum ZIP_CMP eq = p->cmp(p->key, BTREE_KEY(p, n->elms[i]));
+    if(eq != ZIP_CMP_EQ || !p->elm || p->elm == n->elms[i])
+        return eq;
+    return ((uintptr_t)p->elm < (uintptr_t)n->elms[i]) ?
+        ZIP_CMP_LESS : ZIP_CMP_MORE;
+}
+
+/* Index of the first slot that is not less than the probe */
+static unsigned short
+lowerBound(const btree_probe *p, const struct btree_node *n) {
+    unsigned short i = 0;
+    while(i < n->count && n->ranks[i] < p->r)
+        i++;
+    while(i < n->count && n->ranks[i] == p->r &&
+          cmpSlot(p, n, i) == ZIP_CMP_MORE)
+        i++;
+    return i;
+}
+
+static struct btree_node *
+newNode(unsigned short leaf) {
+    size_t size = (leaf) ? offsetof(struct btree_node, children) :
+        sizeof(struct btree_node);
+    struct btree_node *n = (struct btree_node*)UA_malloc(size);
+    if(!n)
+        return NULL;
+    n->count = 0;
+    n->leaf = leaf;
+    return n;
+}
+
+static void
+insertSlot(struct btree_node *n, unsigned short i,
+           btree_rank r, void *elm) {
+    memmove(&n->ranks[i+1], &n->ranks[i], sizeof(btree_rank) * (size_t)(n->count - i));
+    memmove(&n->elms[i+1], &n->elms[i], sizeof(void*) * (size_t)(n->count - i));
+    n->ranks[i] = r;
+    n->elms[i] = elm;
+    n->count++;
+}
+
+static void
+removeSlot(struct btree_node *n, unsigned short i) {
+    n->count--;
+    memmove(&n->ranks[i], &n->ranks[i+1], sizeof(btree_rank) * (size_t)(n->count - i));
+    memmove(&n->elms[i], &n->elms[i+1], sizeof(void*) * (size_t)(n->count - i));
+}
+
+/* Split the full child i of n. The median moves up into n. */
+static int
+splitChild(struct btree_node *n, unsigned short i) {
+    struct btree_node *y = n->children[i];
+    struct btree_node *z = newNode(y->leaf);
+    if(!z)
+        return -1;
+    const unsigned short m = BTREE_MINKEYS;
+    z->count = (unsigned short)(BTREE_MAXKEYS - m - 1);
+    memcpy(z->ranks, &y->ranks[m+1], sizeof(btree_rank) * z->count);
+    memcpy(z->elms, &y->elms[m+1], sizeof(void*) * z->count);
+    if(!y->leaf)
+        memcpy(z->children, &y->children[m+1],
+               sizeof(struct btree_node*) * (size_t)(z->count + 1));
+    y->count = m;
+
+    memmove(&n->children[i+2], &n->children[i+1],
+            sizeof(struct btree_node*) * (size_t)(n->count - i));
+    n->children[i+1] = z;
+    insertSlot(n, i, y->ranks[m], y->elms[m]);
+    return 0;
+}
+
+int
+__BTREE_INSERT(struct btree_node **root, zip_cmp_cb cmp, btree_rank_cb rank,
+               unsigned short keyoffset, void *elm) {
+    btree_probe p;
+    initProbe(&p, cmp, rank, keyoffset, elm);
+
+    /* Empty tree */
+    struct btree_node *n = *root;
+    if(!n) {
+        n = newNode(1);
+        if(!n)
+            return -1;
+        insertSlot(n, 0, p.r, elm);
+        *root = n;
+        return 0;
+    }
+
+    /* Grow in height by splitting a full root */
+    if(n->count == BTREE_MAXKEYS) {
+        struct btree_node *s = newNode(0);
+        if(!s)
+            return -1;
+        s->children[0] = n;
+        if(splitChild(s, 0) != 0) {
+            UA_free(s);
+            return -1;
+        }
+        *root = s;
+        n = s;
+    }
+
+    /* Descend and split full nodes on the way. So the leaf is never full. If an
+     * allocation fails, the tree is still valid. */
+    while(!n->leaf) {
+        unsigned short i = lowerBound(&p, n);
+        if(n->children[i]->count == BTREE_MAXKEYS) {
+            if(splitChild(n, i) != 0)
+                return -1;
+            if(cmpSlot(&p, n, i) == ZIP_CMP_MORE)
+                i++;
+        }
+        n = n->children[i];
+    }
+    insertSlot(n, lowerBound(&p, n), p.r, elm);
+    return 0;
+}
+
+/* Merge child i+1 and the separator i into child i */
+static void
+mergeChildren(struct btree_node *n, unsigned short i) {
+    struct btree_node *y = n->children[i];
+    struct btree_node *z = n->children[i+1];
+    y->ranks[y->count] = n->ranks[i];
+    y->elms[y->count] = n->elms[i];
+    memcpy(&y->ranks[y->count+1], z->ranks, sizeof(btree_rank) * z->count);
+    memcpy(&y->elms[y->count+1], z->elms, sizeof(void*) * z->count);
+    if(!y->leaf)
+        memcpy(&y->children[y->count+1], z->children,
+               sizeof(struct btree_node*) * (size_t)(z->count + 1));
+    y->count = (unsigned short)(y->count + z->count + 1);
+    UA_free(z);
+
+    removeSlot(n, i);
+    memmove(&n->children[i+1], &n->children[i+2],
+            sizeof(struct btree_node*) * (size_t)(n->count - i));
+}
+
+/* Ensure that child i has more than the minimum number of keys before
+ * descending into it. Returns the index of the child to descend into. */
+static unsigned short
+fillChild(struct btree_node *n, unsigned short i) {
+    struct btree_node *c = n->children[i];
+    if(c->count > BTREE_MINKEYS)
+        return i;
+
+    /* Borrow from the left sibling */
+    if(i > 0 && n->children[i-1]->count > BTREE_MINKEYS) {
+        struct btree_node *l = n->children[i-1];
+        if(!c->leaf)
+            memmove(&c->children[1], &c->children[0],
+                    sizeof(struct btree_node*) * (size_t)(c->count + 1));
+        insertSlot(c, 0, n->ranks[i-1], n->elms[i-1]);
+        if(!c->leaf)
+            c->children[0] = l->children[l->count];
+        l->count--;
+        n->ranks[i-1] = l->ranks[l->count];
+        n->elms[i-1] = l->elms[l->count];
+        return i;
+    }
+
+    /* Borrow from the right sibling */
+    if(i < n->count && n->children[i+1]->count > BTREE_MINKEYS) {
+        struct btree_node *r = n->children[i+1];
+        c->ranks[c->count] = n->ranks[i];
+        c->elms[c->count] = n->elms[i];
+        c->count++;
+        if(!c->leaf) {
+            c->children[c->count] = r->children[0];
+            memmove(&r->children[0], &r->children[1],
+                    sizeof(struct btree_node*) * r->count);
+        }
+        n->ranks[i] = r->ranks[0];
+        n->elms[i] = r->elms[0];
+        removeSlot(r, 0);
+        return i;
+    }
+
+    /* Merge with a sibling */
+    if(i < n->count) {
+        mergeChildren(n, i);
+        return i;
+    }
+    mergeChildren(n, (unsigned short)(i - 1));
+    return (unsigned short)(i - 1);
+}
+
+static void *
+removeRec(struct btree_node *n, const btree_probe *p) {
+    while(true) {
+        unsigned short i = lowerBound(p, n);
+        UA_Boolean found = (i < n->count && cmpSlot(p, n, i) == ZIP_CMP_EQ);
+
+        if(n->leaf) {
+            if(!found)
+                return NULL;
+            void *elm = n->elms[i];
+            removeSlot(n, i);
+            return elm;
+        }
+
+        if(!found) {
+            n = n->children[fillChild(n, i)];
+            continue;
+        }
+
+        /* Replace with the predecessor or the successor. Remove that from the
+         * child (which has more than the minimum number of keys). Otherwise
+         * merge the children around the found element and continue the
+         * removal in the merged node. */
+        void *elm = n->elms[i];
+        struct btree_node *sub;
+        void *repl;
+        if(n->children[i]->count > BTREE_MINKEYS) {
+            sub = n->children[i];
+            struct btree_node *c = sub;
+            while(!c->leaf)
+                c = c->children[c->count];
+            repl = c->elms[c->count - 1];
+        } else if(n->children[i+1]->count > BTREE_MINKEYS) {
+            sub = n->children[i+1];
+            struct btree_node *c = sub;
+            while(!c->leaf)
+                c = c->children[0];
+            repl = c->elms[0];
+        } else {
+            mergeChildren(n, i);
+            n = n->children[i];
+            continue;
+        }
+
+        btree_probe q = *p;
+        q.elm = repl;
+        q.key = BTREE_KEY(p, repl);
+        q.r = p->rank(q.key);
+        removeRec(sub, &q);
+        n->ranks[i] = q.r;
+        n->elms[i] = repl;
+        return elm;
+    }
+}
+
+void *
+__BTREE_REMOVE(struct btree_node **root, zip_cmp_cb cmp, btree_rank_cb rank,
+               unsigned short keyoffset, void *elm) {
+    struct btree_node *n = *root;
+    if(!n)
+        return NULL;
+    btree_probe p;
+    initProbe(&p, cmp, rank, keyoffset, elm);
+    void *res = removeRec(n, &p);
+
+    /* Shrink in height if the root is empty */
+    if(n->count == 0) {
+        *root = (n->leaf) ? NULL : n->children[0];
+        UA_free(n);
+    }
+    return res;
+}
+
+void *
+__BTREE_MIN(struct btree_node *n) {
+    if(!n)
+        return NULL;
+    while(!n->leaf)
+        n = n->children[0];
+    return n->elms[0];
+}
+
+void *
+__BTREE_MAX(struct btree_node *n) {
+    if(!n)
+        return NULL;
+    while(!n->leaf)
+        n = n->children[n->count];
+    return n->elms[n->count - 1];
+}
+
+void *
+__BTREE_ITER(struct btree_node *n, zip_iter_cb cb, void *context) {
+    if(!n)
+        return NULL;
+    void *res;
+    for(unsigned short i = 0; i < n->count; i++) {
+        if(!n->leaf) {
+            res = __BTREE_ITER(n->children[i], cb, context);
+            if(res)
+                return res;
+        }
+        res = cb(context, n->elms[i]);
+        if(res)
+            return res;
+    }
+    return (n->leaf) ? NULL : __BTREE_ITER(n->children[n->count], cb, context);
+}
+
+static void *
+iterKey(struct btree_node *n, const btree_probe *p,
+        zip_iter_cb cb, void *context) {
+    void *res;
+    unsigned short i = lowerBound(p, n);
+    for(; i < n->count; i++) {
+        enum ZIP_CMP eq = cmpSlot(p, n, i);
+        if(!n->leaf) {
+            res = iterKey(n->children[i], p, cb, context);
+            if(res)
+                return res;
+        }
+        if(eq != ZIP_CMP_EQ)
+            return NULL; /* The key is smaller than the slot */
+        res = cb(context, n->elms[i]);
+        if(res)
+            return res;
+    }
+    return (n->leaf) ? NULL : iterKey(n->children[n->count], p, cb, context);
+}
+
+void *
+__BTREE_ITER_KEY(struct btree_node *n, zip_cmp_cb cmp, btree_rank_cb rank,
+                 unsigned short keyoffset, const void *key,
+                 zip_iter_cb cb, void *context) {
+    if(!n)
+        return NULL;
+    btree_probe p;
+    p.cmp = cmp;
+    p.rank = rank;
+    p.keyoffset = keyoffset;
+    p.key = key;
+    p.elm = NULL;
+    p.r = rank(key);
+    return iterKey(n, &p, cb, context);
+}
+
+void
+__BTREE_CLEAR(struct btree_node *n) {
+    if(!n)
+        return;
+    if(!n->leaf) {
+        for(unsigned short i = 0; i <= n->count; i++)
+            __BTREE_CLEAR(n->children[i]);
+    }
+    UA_free(n);
+}
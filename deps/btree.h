@@ -0,0 +1,194 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef	BTREE_H_
+#define	BTREE_H_
+
+#include "ziptree.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Reusable B-tree implementation with the same interface style as the zip tree
+ * in ziptree.h. The comparison method and the iteration callbacks are the same.
+ *
+ * Zip trees (and other binary trees) visit one element per level. Every step
+ * is a cache miss for large trees. The B-tree stores up to BTREE_MAXKEYS
+ * element pointers per node. Additionally, an integer "rank" of every element
+ * is stored in the node itself. The search within a node scans the ranks
+ * (two cache lines) and only dereferences the element for the full comparison
+ * if the ranks are equal. The rank method must be consistent with the
+ * comparison: rank(a) < rank(b) implies cmp(a, b) == ZIP_CMP_LESS. Typical
+ * ranks are the hash of the key (if the comparison orders by the hash first)
+ * or an integer key itself. A constant rank is valid, but then every
+ * comparison dereferences the element.
+ *
+ *   btree_rank rankMethod(const keytype *key);
+ *
+ * The tree is not intrusive. The elements need no BTREE_ENTRY. Instead, the
+ * tree nodes are allocated with UA_malloc. So BTREE_INSERT can fail and the
+ * tree must be cleaned up with BTREE_CLEAR (which does not touch the
+ * elements).
+ *
+ * Multiple elements with the same key can be inserted. These are ordered by
+ * their pointer value. So every element has a unique position and BTREE_REMOVE
+ * removes exactly the given element. BTREE_FIND returns any of the elements
+ * with the key. */
+
+#define BTREE_MAXKEYS 15
+#define BTREE_MINKEYS (BTREE_MAXKEYS / 2)
+
+typedef unsigned long long btree_rank;
+typedef btree_rank (*btree_rank_cb)(const void *key);
+
+/* Internal node layout. Leaf nodes are allocated without the children array.
+ * The ranks are first so that the scan in a node touches few cache lines. */
+struct btree_node {
+    unsigned short count;
+    unsigned short leaf;
+    btree_rank ranks[BTREE_MAXKEYS];
+    void *elms[BTREE_MAXKEYS];
+    struct btree_node *children[BTREE_MAXKEYS + 1];
+};
+
+#define BTREE_HEAD(name, type)                  \
+struct name {                                   \
+    struct btree_node *root;                    \
+}
+
+#define BTREE_INIT(head) do { (head)->root = NULL; } while (0)
+#define BTREE_EMPTY(head) ((head)->root == NULL)
+
+/* Returns 0 on success and -1 if a tree node could not be allocated. The tree
+ * is unchanged in that case. */
+#define BTREE_INSERT(name, head, elm) name##_BTREE_INSERT(head, elm)
+
+/* Returns the element if it was found in the tree. Returns NULL otherwise. */
+#define BTREE_REMOVE(name, head, elm) name##_BTREE_REMOVE(head, elm)
+
+#define BTREE_FIND(name, head, key) name##_BTREE_FIND(head, key)
+#define BTREE_MIN(name, head) name##_BTREE_MIN(head)
+#define BTREE_MAX(name, head) name##_BTREE_MAX(head)
+
+/* In-order traversal. The first callback to return non-NULL aborts the
+ * iteration. This pointer is then returned. The tree must not be modified
+ * during the iteration. But the elements can be freed from within the callback
+ * if BTREE_CLEAR is called afterwards. */
+#define BTREE_ITER(name, head, cb, ctx) name##_BTREE_ITER(head, cb, ctx)
+
+/* Same as _ITER, but only visits elements with the given key */
+#define BTREE_ITER_KEY(name, head, key, cb, ctx) \
+    name##_BTREE_ITER_KEY(head, key, cb, ctx)
+
+/* Free the tree nodes. The elements are not touched. */
+#define BTREE_CLEAR(name, head) name##_BTREE_CLEAR(head)
+
+/* Macro to generate typed B-tree methods */
+#define BTREE_FUNCTIONS(name, type, keytype, keyfield, cmp, rank)       \
+                                                                        \
+ZIP_UNUSED static ZIP_INLINE int                                        \
+name##_BTREE_INSERT(struct name *head, struct type *elm) {              \
+    return __BTREE_INSERT(&head->root, (zip_cmp_cb)cmp,                 \
+                          (btree_rank_cb)rank,                          \
+                          offsetof(struct type, keyfield), elm);        \
+}                                                                       \
+                                                                        \
+ZIP_UNUSED static ZIP_INLINE struct type *                              \
+name##_BTREE_REMOVE(struct name *head, struct type *elm) {              \
+    return (struct type*)                                               \
+        __BTREE_REMOVE(&head->root, (zip_cmp_cb)cmp,                    \
+                       (btree_rank_cb)rank,                             \
+                       offsetof(struct type, keyfield), elm);           \
+}                                                                       \
+                                                                        \
+ZIP_UNUSED static ZIP_INLINE struct type *                              \
+name##_BTREE_FIND(struct name *head, const keytype *key) {              \
+    btree_rank r = rank(key);                                           \
+    struct btree_node *n = head->root;                                  \
+    while(n) {                                                          \
+        unsigned short i = 0;                                           \
+        while(i < n->count && n->ranks[i] < r)                          \
+            i++;                                                        \
+        for(; i < n->count && n->ranks[i] == r; i++) {                  \
+            struct type *cur = (struct type*)n->elms[i];                \
+            enum ZIP_CMP eq = cmp(key, &cur->keyfield);                 \
+            if(eq == ZIP_CMP_EQ)                                        \
+                return cur;                                             \
+            if(eq == ZIP_CMP_LESS)                                      \
+                break;                                                  \
+        }                                                               \
+        if(n->leaf)                                                     \
+            break;                                                      \
+        n = n->children[i];                                             \
+    }                                                                   \
+    return NULL;                                                        \
+}                                                                       \
+                                                                        \
+ZIP_UNUSED static ZIP_INLINE struct type *                              \
+name##_BTREE_MIN(struct name *head) {                                   \
+    return (struct type*)__BTREE_MIN(head->root);                       \
+}                                                                       \
+                                                                        \
+ZIP_UNUSED static ZIP_INLINE struct type *                              \
+name##_BTREE_MAX(struct name *head) {                                   \
+    return (struct type*)__BTREE_MAX(head->root);                       \
+}                                                                       \
+                                                                        \
+typedef void * (*name##_btree_cb)(void *context, struct type *elm);     \
+                                                                        \
+ZIP_UNUSED static ZIP_INLINE void *                                     \
+name##_BTREE_ITER(struct name *head, name##_btree_cb cb,                \
+                  void *context) {                                      \
+    return __BTREE_ITER(head->root, (zip_iter_cb)cb, context);          \
+}                                                                       \
+                                                                        \
+ZIP_UNUSED static ZIP_INLINE void *                                     \
+name##_BTREE_ITER_KEY(struct name *head, const keytype *key,            \
+                      name##_btree_cb cb, void *context) {              \
+    return __BTREE_ITER_KEY(head->root, (zip_cmp_cb)cmp,                \
+                            (btree_rank_cb)rank,                        \
+                            offsetof(struct type, keyfield), key,       \
+                            (zip_iter_cb)cb, context);                  \
+}                                                                       \
+                                                                        \
+ZIP_UNUSED static ZIP_INLINE void                                       \
+name##_BTREE_CLEAR(struct name *head) {                                 \
+    __BTREE_CLEAR(head->root);                                          \
+    head->root = NULL;                                                  \
+}
+
+/* Internal definitions. Don't use directly. */
+
+int
+__BTREE_INSERT(struct btree_node **root, zip_cmp_cb cmp, btree_rank_cb rank,
+               unsigned short keyoffset, void *elm);
+
+void *
+__BTREE_REMOVE(struct btree_node **root, zip_cmp_cb cmp, btree_rank_cb rank,
+               unsigned short keyoffset, void *elm);
+
+void *
+__BTREE_MIN(struct btree_node *n);
+
+void *
+__BTREE_MAX(struct btree_node *n);
+
+void *
+__BTREE_ITER(struct btree_node *n, zip_iter_cb cb, void *context);
+
+void *
+__BTREE_ITER_KEY(struct btree_node *n, zip_cmp_cb cmp, btree_rank_cb rank,
+                 unsigned short keyoffset, const void *key,
+                 zip_iter_cb cb, void *context);
+
+void
+__BTREE_CLEAR(struct btree_node *n);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* BTREE_H_ */
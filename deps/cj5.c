@@ -28,6 +28,12 @@
 #include <float.h>
 #include <string.h>
 
+#if defined(__SSE2__)
+# include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+# include <arm_neon.h>
+#endif
+
 #if defined(_MSC_VER)
 # define CJ5_INLINE __inline
 #else
@@ -101,6 +107,59 @@ cj5__alloc_token(cj5__parser *parser) {
     return token;
 }
 
+// Return the index of the next character in the string that is the closing
+// quote, a newline or a backslash (or len). Tests 16 characters at a time with
+// SSE2/NEON and eight characters at a time otherwise.
+static unsigned int
+cj5__skip_string_chars(const char *json5, unsigned int pos, unsigned int len,
+                       char str_open) {
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8(str_open);
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    for(; len - pos >= 16; pos += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(const void*)&json5[pos]);
+        __m128i m = _mm_or_si128(_mm_cmpeq_epi8(v, quote),
+                                 _mm_cmpeq_epi8(v, newline));
+        m = _mm_or_si128(m, _mm_cmpeq_epi8(v, backslash));
+        unsigned mask = (unsigned)_mm_movemask_epi8(m);
+        if(mask != 0)
+            return pos + (unsigned int)__builtin_ctz(mask);
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint8x16_t quote = vdupq_n_u8((uint8_t)str_open);
+    const uint8x16_t newline = vdupq_n_u8('\n');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    for(; len - pos >= 16; pos += 16) {
+        uint8x16_t v = vld1q_u8((const uint8_t*)&json5[pos]);
+        uint8x16_t m = vorrq_u8(vceqq_u8(v, quote), vceqq_u8(v, newline));
+        m = vorrq_u8(m, vceqq_u8(v, backslash));
+        if(vmaxvq_u8(m) != 0)
+            break; // Find the exact position below
+    }
+#else
+    // SWAR: Test for a zero byte after xor with the searched character. The
+    // expression is exact for whether any byte matches (not for which one).
+    const uint64_t ones = 0x0101010101010101ull;
+    const uint64_t highs = 0x8080808080808080ull;
+    for(; len - pos >= 8; pos += 8) {
+        uint64_t x;
+        memcpy(&x, &json5[pos], 8);
+        uint64_t q = x ^ (ones * (uint8_t)str_open);
+        uint64_t n = x ^ (ones * '\n');
+        uint64_t b = x ^ (ones * '\\');
+        if((((q - ones) & ~q) | ((n - ones) & ~n) | ((b - ones) & ~b)) & highs)
+            break; // Find the exact position below
+    }
+#endif
+    for(; pos < len; pos++) {
+        char c = json5[pos];
+        if(c == str_open || c == '\n' || c == '\\')
+            break;
+    }
+    return pos;
+}
+
 static void
 cj5__parse_string(cj5__parser *parser) {
     const char *json5 = parser->json5;
@@ -110,6 +169,10 @@ cj5__parse_string(cj5__parser *parser) {
 
     parser->pos++;
     for(; parser->pos < len; parser->pos++) {
+        // Skip over the plain characters in bulk
+        parser->pos = cj5__skip_string_chars(json5, parser->pos, len, str_open);
+        if(parser->pos >= len)
+            break;
         char c = json5[parser->pos];
 
         // End of string
@@ -333,6 +333,34 @@ emit_digits(char* digits, unsigned ndigits, char* dest, int K, bool neg) {
     return idx;
 }
 
+static const char digit_pairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/* Print n with two digits per step from the back and append ".0" */
+static unsigned
+emit_integer(uint64_t n, char* dest) {
+    char tmp[20];
+    char* pos = tmp + 20;
+    while(n >= 100) {
+        unsigned r = (unsigned)(n % 100) * 2;
+        n /= 100;
+        *--pos = digit_pairs[r + 1];
+        *--pos = digit_pairs[r];
+    }
+    if(n >= 10) {
+        *--pos = digit_pairs[n * 2 + 1];
+        *--pos = digit_pairs[n * 2];
+    } else {
+        *--pos = (char)('0' + n);
+    }
+    unsigned len = (unsigned)(tmp + 20 - pos);
+    memcpy(dest, pos, len);
+    memcpy(dest + len, ".0", 2);
+    return len + 2;
+}
+
 unsigned dtoa(double d, char* buffer) {
     uint64_t bits = 0;
     memcpy(&bits, &d, sizeof(double));
@@ -364,6 +392,16 @@ unsigned dtoa(double d, char* buffer) {
         }
     }
 
+    /* Fast path for integral values that are printed without an exponent
+     * (less than eight trailing zeros). Integers below 2^53 are exact and
+     * their decimal digits are the shortest roundtrip representation. */
+    double a = sign ? -d : d;
+    if(a >= 1.0 && a < 9007199254740992.0 && a == (double)(uint64_t)a) {
+        uint64_t n = (uint64_t)a;
+        if(n % 100000000U != 0)
+            return pos + emit_integer(n, buffer);
+    }
+
     int K = 0;
     char digits[18];
     memset(digits, 0, 18);
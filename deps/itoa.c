@@ -24,6 +24,44 @@
 
 #include "itoa.h"
 
+static const char digitPairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/* Number of decimal digits. Compares against powers of ten instead of dividing
+ * in a loop. */
+static UA_UInt16 countDigits(UA_UInt64 n) {
+    UA_UInt16 d = 1;
+    if(n >= 10000000000ULL) { d += 10; n /= 10000000000ULL; }
+    if(n >= 100000) { d += 5; n /= 100000; }
+    if(n >= 1000) { d += 3; n /= 1000; }
+    if(n >= 100) d += 2;
+    else if(n >= 10) d += 1;
+    return d;
+}
+
+/* Print the decimal digits back to front, two digits per step from a lookup
+ * table. So the buffer needs not be reversed. */
+static UA_UInt16 printDecimal(UA_UInt64 n, char *buffer) {
+    UA_UInt16 len = countDigits(n);
+    char *pos = buffer + len;
+    *pos = '\0'; /* null terminate string */
+    while(n >= 100) {
+        UA_UInt64 r = (n % 100) * 2;
+        n /= 100;
+        *--pos = digitPairs[r + 1];
+        *--pos = digitPairs[r];
+    }
+    if(n >= 10) {
+        *--pos = digitPairs[n * 2 + 1];
+        *--pos = digitPairs[n * 2];
+    } else {
+        *--pos = (char)('0' + n);
+    }
+    return len;
+}
+
 static void swap(char *x, char *y) {
     char t = *x;
     *x = *y;
@@ -40,6 +78,9 @@ static char* reverse(char *buffer, UA_UInt16 i, UA_UInt16 j) {
 
 /* adapted from http://www.techiedelight.com/implement-itoa-function-in-c/ to use UA_... types */
 UA_UInt16 itoaUnsigned(UA_UInt64 value, char* buffer, UA_Byte base) {
+    if(base == 10)
+        return printDecimal(value, buffer);
+
     /* consider absolute value of number */
     UA_UInt64 n = value;
 
@@ -80,21 +121,9 @@ UA_UInt16 itoaSigned(UA_Int64 value, char* buffer) {
         }
     }
 
-    UA_UInt16 i = 0;
-    while(n) {
-        UA_UInt64 r = n % 10;
-        buffer[i++] = (char)('0' + r);
-        n = n / 10;
-    }
-
-    if(i == 0)
-        buffer[i++] = '0'; /* if number is 0 */
-    if(value < 0)
-        buffer[i++] = '-';
-    buffer[i] = '\0'; /* null terminate string */
-    i--;
-    reverse(buffer, 0, i); /* reverse the string and return it */
-    i++;
-    return i;
+    if(value >= 0)
+        return printDecimal(n, buffer);
+    buffer[0] = '-';
+    return (UA_UInt16)(printDecimal(n, buffer + 1) + 1);
 }
 
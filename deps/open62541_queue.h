@@ -244,6 +244,13 @@ struct {								\
     _Q_INVALIDATE((elm)->field.le_next);				\
 } while (0)
 
+/* Move all elements from head2 to the empty head1 */
+#define LIST_MOVE(head1, head2, field) do {				\
+    if (((head1)->lh_first = (head2)->lh_first) != NULL)		\
+        (head1)->lh_first->field.le_prev = &(head1)->lh_first;	\
+    LIST_INIT((head2));						\
+} while (0)
+
 /*
  * Simple queue definitions.
  */
@@ -516,6 +523,15 @@ struct {								\
     _Q_INVALIDATE((elm)->field.tqe_next);				\
 } while (0)
 
+#define TAILQ_CONCAT(head1, head2, field) do {				\
+    if (!TAILQ_EMPTY(head2)) {					\
+        *(head1)->tqh_last = (head2)->tqh_first;		\
+        (head2)->tqh_first->field.tqe_prev = (head1)->tqh_last;	\
+        (head1)->tqh_last = (head2)->tqh_last;			\
+        TAILQ_INIT((head2));					\
+    }								\
+} while (0)
+
 /*
  * Circular queue definitions.
  */
@@ -53,15 +53,25 @@ parseUInt64(const char *str, size_t size, uint64_t *result) {
         return (i > 2) ? i : 0; /* 2 -> No digit was parsed */
     }
 
-    /* Decimal */
-    for(; i < size; i++) {
-        if(str[i] < '0' || str[i] > '9')
+    /* Decimal. Up to 19 digits cannot overflow. Only the 20th digit needs to
+     * be checked. Leading zeros don't count. */
+    while(i < size && str[i] == '0')
+        i++;
+    size_t lim = i + 19;
+    for(; i < size && i < lim; i++) {
+        uint8_t c = (uint8_t)(str[i] - '0');
+        if(c > 9)
             break;
-        /* Fast multiplication: n*10 == (n*8) + (n*2) */
-        n = (n << 3) + (n << 1) + (uint8_t)(str[i] - '0');
-        if(n < prev) /* Check for overflow */
-            return 0;
-        prev = n;
+        n = n * 10 + c;
+    }
+    if(i == lim && i < size && str[i] >= '0' && str[i] <= '9') {
+        uint8_t c = (uint8_t)(str[i] - '0');
+        if(n > (UINT64_MAX - c) / 10)
+            return 0; /* Overflow */
+        n = n * 10 + c;
+        i++;
+        if(i < size && str[i] >= '0' && str[i] <= '9')
+            return 0; /* Overflow */
     }
     *result = n;
     return i;
@@ -96,7 +106,92 @@ parseInt64(const char *str, size_t size, int64_t *result) {
     return len + i;
 }
 
+static const double exactPowersOfTen[23] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* Fast path for decimal numbers where the significand fits into 53 bits and
+ * the power of ten is exactly representable (Clinger). Then a single
+ * multiplication or division is correctly rounded. Returns 0 if the number
+ * needs to be handled by strtod. */
+static size_t
+parseDoubleFast(const char *str, size_t size, double *result) {
+    size_t i = 0;
+    bool neg = false;
+    if(i < size && (str[i] == '-' || str[i] == '+')) {
+        neg = (str[i] == '-');
+        i++;
+    }
+
+    uint64_t m = 0;
+    int digits = 0;   /* Significant digits in m */
+    int exp10 = 0;
+    bool anyDigit = false;
+    for(; i < size && str[i] >= '0' && str[i] <= '9'; i++) {
+        anyDigit = true;
+        if(m == 0 && str[i] == '0')
+            continue;
+        if(++digits > 19)
+            return 0;
+        m = m * 10 + (uint64_t)(str[i] - '0');
+    }
+    if(i < size && str[i] == '.') {
+        i++;
+        for(; i < size && str[i] >= '0' && str[i] <= '9'; i++) {
+            anyDigit = true;
+            exp10--;
+            if(m == 0 && str[i] == '0')
+                continue;
+            if(++digits > 19)
+                return 0;
+            m = m * 10 + (uint64_t)(str[i] - '0');
+        }
+    }
+    if(!anyDigit)
+        return 0; /* inf, nan, ... */
+
+    /* Hex floats */
+    if(i < size && (str[i] | 32) == 'x')
+        return 0;
+
+    /* The exponent is only consumed if it has digits */
+    if(i < size && (str[i] | 32) == 'e') {
+        size_t j = i + 1;
+        bool expNeg = false;
+        if(j < size && (str[j] == '-' || str[j] == '+')) {
+            expNeg = (str[j] == '-');
+            j++;
+        }
+        if(j < size && str[j] >= '0' && str[j] <= '9') {
+            int e = 0;
+            for(; j < size && str[j] >= '0' && str[j] <= '9'; j++) {
+                if(e > 10000)
+                    return 0;
+                e = e * 10 + (str[j] - '0');
+            }
+            exp10 += (expNeg) ? -e : e;
+            i = j;
+        }
+    }
+
+    if(m > ((uint64_t)1 << 53) || exp10 < -22 || exp10 > 22)
+        return 0;
+    double d = (double)m;
+    if(exp10 < 0)
+        d /= exactPowersOfTen[-exp10];
+    else
+        d *= exactPowersOfTen[exp10];
+    *result = (neg) ? -d : d;
+    return i;
+}
+
 size_t parseDouble(const char *str, size_t size, double *result) {
+    size_t len = parseDoubleFast(str, size, result);
+    if(len > 0)
+        return len;
+
+    /* Fall back to strtod on a null-terminated copy */
     char buf[2000];
     if(size >= 2000)
         return 0;
@@ -104,8 +199,8 @@ size_t parseDouble(const char *str, size_t size, double *result) {
     buf[size] = 0;
     errno = 0;
     char *endptr;
-    *result = strtod(str, &endptr);
+    *result = strtod(buf, &endptr);
     if(errno != 0 && errno != ERANGE)
         return 0;
-    return (uintptr_t)endptr - (uintptr_t)str;
+    return (uintptr_t)endptr - (uintptr_t)buf;
 }
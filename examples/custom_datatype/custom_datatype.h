@@ -57,7 +57,8 @@ static const UA_DataType PointType = {
         false,                              /* .overlayable (depends on endianness and
                                             the absence of padding) */
         3,                                  /* .membersSize */
-        Point_members
+        Point_members,                   /* .members */
+        12                               /* .binarySize */
 };
 
 /* The datatype description for the Measurement-Series datatype (Array Example)*/
@@ -96,7 +97,8 @@ static const UA_DataType MeasurementType = {
     false,                                  /* .overlayable (depends on endianness and
                                                 the absence of padding) */
     2,                                      /* .membersSize */
-    Measurements_members
+    Measurements_members,            /* .members */
+    0                                /* .binarySize */
 };
 
 
@@ -146,7 +148,8 @@ static const UA_DataType OptType = {
     false,                              /* .overlayable (depends on endianness and
                                             the absence of padding) */
     3,                                  /* .membersSize */
-    Opt_members
+    Opt_members,                     /* .members */
+    0                                /* .binarySize */
 };
 
 /* The datatype description for the Uni datatype (Union example) */
@@ -189,5 +192,6 @@ static const UA_DataType UniType = {
     false,                                  /* .overlayable (depends on endianness and
                                             the absence of padding) */
     2,                                      /* .membersSize */
-    Uni_members
+    Uni_members,                     /* .members */
+    0                                /* .binarySize */
 };
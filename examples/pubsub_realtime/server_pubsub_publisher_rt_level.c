@@ -66,9 +66,19 @@ int main(void) {
     UA_Server *server = UA_Server_new();
 
     /* Instantiate the custom EventLoop.
-     * Will be attached to the PubSubConnection and gets used for everything "above".
-     * This should be bound to a dedicated core for RT. */
+     * Will be attached to the PubSubConnection and gets used for everything "above". */
     pubSubEL = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+
+    /* Run the thread of the EventLoop with SCHED_FIFO priority on a dedicated
+     * core for RT. This requires the respective privileges (otherwise a warning is
+     * logged and the thread runs with the default scheduling). */
+    UA_Int32 rtPriority = 80;
+    UA_UInt32 rtCpu = 1;
+    UA_KeyValueMap_setScalar(&pubSubEL->params, UA_QUALIFIEDNAME(0, "rt-priority"),
+                             &rtPriority, &UA_TYPES[UA_TYPES_INT32]);
+    UA_KeyValueMap_setScalar(&pubSubEL->params, UA_QUALIFIEDNAME(0, "cpu-affinity"),
+                             &rtCpu, &UA_TYPES[UA_TYPES_UINT32]);
+
     UA_ConnectionManager *udpCM =
         UA_ConnectionManager_new_POSIX_UDP(UA_STRING("udp connection manager"));
     pubSubEL->registerEventSource(pubSubEL, (UA_EventSource *)udpCM);
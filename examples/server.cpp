@@ -1,37 +1,46 @@
 /* This work is licensed under a Creative Commons CCZero 1.0 Universal License.
  * See http://creativecommons.org/publicdomain/zero/1.0/ for more information. */
 
-#include <open62541/server.h>
+#include <open62541/server.hpp>
 
 /* Build Instructions (Linux)
- * - g++ server.cpp -lopen62541 -o server */
-
-using namespace std;
+ * - g++ -std=c++17 server.cpp -lopen62541 -o server */
 
 int main() {
     UA_Server *server = UA_Server_new();
 
     // add a variable node to the adresspace
-    UA_VariableAttributes attr = UA_VariableAttributes_default;
-    UA_Int32 myInteger = 42;
-    UA_Variant_setScalarCopy(&attr.value, &myInteger, &UA_TYPES[UA_TYPES_INT32]);
-    attr.description = UA_LOCALIZEDTEXT_ALLOC("en-US","the answer");
-    attr.displayName = UA_LOCALIZEDTEXT_ALLOC("en-US","the answer");
-    UA_NodeId myIntegerNodeId = UA_NODEID_STRING_ALLOC(1, "the.answer");
-    UA_QualifiedName myIntegerName = UA_QUALIFIEDNAME_ALLOC(1, "the answer");
+    // the attributes are cleared when they go out of scope
+    ua::Owned<UA_VariableAttributes> attr;
+    *attr = UA_VariableAttributes_default;
+    ua::Owned<UA_Variant> value;
+    ua::setScalar(value, (UA_Int32)42);
+    attr->value = value.release(); // moved, not copied
+    attr->description = UA_LOCALIZEDTEXT_ALLOC("en-US","the answer");
+    attr->displayName = UA_LOCALIZEDTEXT_ALLOC("en-US","the answer");
+
+    // borrowed strings point to the literals and are never freed
+    UA_NodeId myIntegerNodeId;
+    myIntegerNodeId.namespaceIndex = 1;
+    myIntegerNodeId.identifierType = UA_NODEIDTYPE_STRING;
+    myIntegerNodeId.identifier.string = ua::borrow("the.answer");
+    UA_QualifiedName myIntegerName;
+    myIntegerName.namespaceIndex = 1;
+    myIntegerName.name = ua::borrow("the answer");
     UA_NodeId parentNodeId = UA_NS0ID(OBJECTSFOLDER);
     UA_NodeId parentReferenceNodeId = UA_NS0ID(ORGANIZES);
     UA_Server_addVariableNode(server, myIntegerNodeId, parentNodeId,
                               parentReferenceNodeId, myIntegerName,
-                              UA_NODEID_NULL, attr, NULL, NULL);
+                              UA_NODEID_NULL, *attr, NULL, NULL);
 
-    /* allocations on the heap need to be freed */
-    UA_VariableAttributes_clear(&attr);
-    UA_NodeId_clear(&myIntegerNodeId);
-    UA_QualifiedName_clear(&myIntegerName);
+    // typed access to the value without looking up the node every time
+    ua::ValueHandle<UA_Int32> answer;
+    if(answer.resolve(server, myIntegerNodeId) == UA_STATUSCODE_GOOD)
+        answer.write(43);
 
     UA_StatusCode retval = UA_Server_runUntilInterrupt(server);
 
+    answer.reset();
     UA_Server_delete(server);
     return retval == UA_STATUSCODE_GOOD ? EXIT_SUCCESS : EXIT_FAILURE;
 }
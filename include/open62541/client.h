@@ -156,6 +156,12 @@ struct UA_ClientConfig {
      * data types are provided in ``/examples/custom_datatype/``. */
     const UA_DataTypeArray *customDataTypes;
 
+    /* Optional hashed index of the data types used for decoding. When set, the
+     * lookup of received ExtensionObjects uses the registry first and falls
+     * back to the linear search in ``customDataTypes``. The registry is owned
+     * by the configuration and deleted together with it. */
+    UA_DataTypeRegistry *dataTypeRegistry;
+
     /**
      * Advanced Client Configuration
      * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
@@ -167,6 +173,22 @@ struct UA_ClientConfig {
     UA_UInt32 connectivityCheckInterval;     /* Connectivity check interval in ms.
                                               * 0 = background task disabled */
 
+    /* Coalesce the async ReadRequests (__UA_Client_AsyncService and the
+     * UA_Client_read*Attribute_async functions) that are issued before the next
+     * EventLoop cycle into one ReadRequest with up to readCoalescingMaxNodes
+     * operations. The results are split up and dispatched to the individual
+     * callbacks. Requests with a manually defined requestHandle, diagnostics or
+     * an additional header are sent as-is. All requests in a combined request
+     * share its RequestId. So UA_Client_modifyAsyncCallback and
+     * UA_Client_cancelByRequestId apply to the combined request. The value
+     * should not exceed the MaxNodesPerRead limit of the server.
+     * 0 or 1 = coalescing disabled */
+    UA_UInt32 readCoalescingMaxNodes;
+
+    /* Maximum number of combined ReadRequests in flight. Further combined
+     * requests are held back until a response arrives. 0 = unlimited */
+    UA_UInt32 readCoalescingWindow;
+
     /* EventLoop */
     UA_EventLoop *eventLoop;
     UA_Boolean externalEventLoop; /* The EventLoop is not deleted with the config */
@@ -212,6 +234,14 @@ struct UA_ClientConfig {
     /* Number of PublishResponse queued up in the server */
     UA_UInt16 outStandingPublishRequests;
 
+    /* If non-zero, the number of PublishRequests in flight adapts between
+     * minOutStandingPublishRequests and outStandingPublishRequests. The lower
+     * limit is raised to cover the measured round-trip time. The count grows
+     * while the server reports moreNotifications and shrinks when keep-alive
+     * messages arrive while other PublishRequests are still waiting.
+     * 0 = always keep outStandingPublishRequests in flight */
+    UA_UInt16 minOutStandingPublishRequests;
+
     /* If the client does not receive a PublishResponse after the defined delay
      * of ``(sub->publishingInterval * sub->maxKeepAliveCount) +
      * client->config.timeout)``, then subscriptionInactivityCallback is called
@@ -954,6 +984,58 @@ UA_Client_removeCallback(UA_Client *client, UA_UInt64 callbackId);
 #define UA_Client_removeRepeatedCallback(server, callbackId)    \
     UA_Client_removeCallback(server, callbackId);
 
+/**
+ * Client Pool
+ * -----------
+ *
+ * A single SecureChannel is processed sequentially. For parallel throughput to
+ * one server, a client pool manages several clients with their own
+ * SecureChannel and Session to the same endpoint. The clients share one
+ * EventLoop. Async service calls are distributed by selecting the client with
+ * an activated Session and the fewest outstanding requests. A client whose
+ * connection attempt failed is reconnected by the pool after its configured
+ * timeout.
+ *
+ * The pool is not thread-safe. It is used from the thread that runs the
+ * shared EventLoop. */
+
+struct UA_ClientPool;
+typedef struct UA_ClientPool UA_ClientPool;
+
+UA_EXPORT UA_ClientPool *
+UA_ClientPool_new(void);
+
+/* Add a client to the pool. The pool takes ownership of the client. The
+ * EventLoop of the first client is shared by all clients. The EventLoops of
+ * the clients added later must not be started yet and are deleted. */
+UA_StatusCode UA_EXPORT
+UA_ClientPool_addClient(UA_ClientPool *pool, UA_Client *client);
+
+/* Returns the client with an activated Session and the fewest outstanding
+ * async service calls. Returns NULL if no Session is activated. The client
+ * remains owned by the pool. Use it with the async service API. */
+UA_EXPORT UA_Client *
+UA_ClientPool_getClient(UA_ClientPool *pool);
+
+/* Connect all clients asynchronously to the endpoint */
+UA_StatusCode UA_EXPORT
+UA_ClientPool_connectAsync(UA_ClientPool *pool, const char *endpointUrl);
+
+/* Run one iteration of the shared EventLoop and reconnect the clients whose
+ * connection failed. Returns a good status if at least one client is
+ * connected or still connecting. */
+UA_StatusCode UA_EXPORT
+UA_ClientPool_run_iterate(UA_ClientPool *pool, UA_UInt32 timeout);
+
+/* Disconnect all clients. They are not reconnected until the next
+ * UA_ClientPool_connectAsync. */
+void UA_EXPORT
+UA_ClientPool_disconnect(UA_ClientPool *pool);
+
+/* Disconnect and delete the clients and the pool */
+void UA_EXPORT
+UA_ClientPool_delete(UA_ClientPool *pool);
+
 /**
  * Client Utility Functions
  * ------------------------ */
@@ -963,6 +1045,24 @@ UA_Client_removeCallback(UA_Client *client, UA_UInt64 callbackId);
 UA_EXPORT const UA_DataType *
 UA_Client_findDataType(UA_Client *client, const UA_NodeId *typeId);
 
+/* Read the DataTypeDefinition of the data types from the server. Data types
+ * the structure fields refer to are read as well, unless they are already
+ * known in the client. Data types without a DataTypeDefinition are added as
+ * SimpleTypeDescription with their builtin supertype. The namespace array of
+ * the server is stored in the schema. So a stored schema can be checked
+ * against the server before it is used again. */
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Client_readDataTypeSchema(UA_Client *client, size_t dataTypesSize,
+                             const UA_NodeId *dataTypes,
+                             UA_DataTypeSchemaHeader *schema);
+
+/* Generate the data types of the schema (see UA_DataTypeArray_fromSchema) and
+ * add them to the custom data types of the client configuration and to the
+ * data type registry if one is configured. Received structures of these types
+ * are then decoded instead of being kept as an encoded ExtensionObject. */
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Client_addDataTypes(UA_Client *client, const UA_DataTypeSchemaHeader *schema);
+
 /**
  * .. toctree::
  *
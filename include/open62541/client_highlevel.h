@@ -660,6 +660,67 @@ UA_Client_forEachChildNodeCall(
     UA_Client *client, UA_NodeId parentNodeId,
     UA_NodeIteratorCallback callback, void *handle);
 
+/**
+ * Browse Cache
+ * ^^^^^^^^^^^^
+ * The crawler discovers the address space below a start node breadth-first.
+ * Many nodes are browsed in one request, continuation points are followed with
+ * BrowseNext and several requests are in flight at the same time. So a crawl
+ * is bound by the bandwidth and not by the round-trip time.
+ *
+ * The discovered nodes are stored in a browse cache. Every node is stored with
+ * the ReferenceDescription by which it was found first. If the cache is
+ * attached to the client, ``UA_Client_readNodeClassAttribute``,
+ * ``UA_Client_readBrowseNameAttribute`` and
+ * ``UA_Client_readDisplayNameAttribute`` are answered from the cache for the
+ * known nodes. The cache is not updated when the address space changes. */
+
+typedef struct UA_ClientBrowseCache UA_ClientBrowseCache;
+
+UA_ClientBrowseCache UA_EXPORT *
+UA_ClientBrowseCache_new(void);
+
+void UA_EXPORT
+UA_ClientBrowseCache_delete(UA_ClientBrowseCache *cache);
+
+size_t UA_EXPORT
+UA_ClientBrowseCache_size(const UA_ClientBrowseCache *cache);
+
+/* Returns NULL if the node is unknown. The start node of a crawl is stored
+ * with an empty ReferenceDescription (NodeClass unspecified). The pointer
+ * remains valid until the cache is deleted. */
+const UA_ReferenceDescription UA_EXPORT *
+UA_ClientBrowseCache_get(const UA_ClientBrowseCache *cache,
+                         const UA_NodeId *nodeId);
+
+typedef struct {
+    UA_NodeId referenceTypeId; /* Followed references (including subtypes).
+                                * Null: HierarchicalReferences */
+    UA_UInt32 nodesPerBrowse;  /* BrowseDescriptions per request (0: 100) */
+    UA_UInt32 maxReferencesPerNode; /* 0: the server decides */
+    UA_UInt32 maxInFlight;     /* Concurrent requests (0: 4) */
+} UA_ClientCrawlOptions;
+
+/* Browse the (forward) hierarchy below the start node and add the discovered
+ * nodes to the cache. Nodes that are already in the cache are not browsed
+ * again. Only local nodes (server index 0) are followed. The options can be
+ * NULL for the defaults. */
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Client_crawl(UA_Client *client, const UA_NodeId startNode,
+                UA_ClientBrowseCache *cache,
+                const UA_ClientCrawlOptions *options);
+
+/* Answer the reads of static attributes from the cache (or NULL to detach).
+ * The cache must outlive the client or be detached before it is deleted. */
+void UA_EXPORT UA_THREADSAFE
+UA_Client_setBrowseCache(UA_Client *client, UA_ClientBrowseCache *cache);
+
+/* Read the NodeClass, BrowseName or DisplayName from the attached cache.
+ * Returns BadNotFound if the cache cannot answer. */
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Client_readCachedAttribute(UA_Client *client, const UA_NodeId *nodeId,
+                              UA_AttributeId attributeId, void *out);
+
 _UA_END_DECLS
 
 #endif /* UA_CLIENT_HIGHLEVEL_H_ */
@@ -632,6 +632,47 @@ UA_Client_addMethodNode_async(
         (UA_ClientAsyncServiceCallback)callback, userdata, reqId);
 })
 
+/**
+ * Historical Access
+ * ^^^^^^^^^^^^^^^^^
+ * Read the history of many nodes with pipelined HistoryRead requests. Every
+ * request carries several HistoryReadValueIds, the returned continuation
+ * points are followed in the next requests and several requests are in flight
+ * at the same time. If the server has no continuation points left, the node is
+ * read again after the pending requests have released theirs.
+ *
+ * The results are handed to the sink as they arrive and are not accumulated.
+ * The HistoryReadResult is valid only during the sink callback. The
+ * ``continuationPoint`` of the result is non-empty if more data is available
+ * for the node. Return false from the sink to stop reading the node. Its
+ * continuation point is then released. The done callback is called once after
+ * the last response was processed. */
+
+typedef UA_Boolean
+(*UA_ClientHistoryReadSink)(UA_Client *client, void *context, size_t nodeIndex,
+                            const UA_HistoryReadResult *result);
+
+typedef void
+(*UA_ClientHistoryReadDone)(UA_Client *client, void *context,
+                            UA_StatusCode status);
+
+typedef struct {
+    UA_UInt32 nodesPerRequest; /* HistoryReadValueIds per request (0: 10) */
+    UA_UInt32 maxInFlight;     /* Concurrent requests (0: 4) */
+    UA_TimestampsToReturn timestampsToReturn;
+} UA_ClientHistoryReadOptions;
+
+/* The historyReadDetails (e.g. ReadRawModifiedDetails) apply to all nodes. The
+ * details and the nodes are copied. The nodeIndex of the sink refers to the
+ * nodesToRead array. The options can be NULL for the defaults. If an error is
+ * returned, neither the sink nor the done callback is called. */
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Client_HistoryRead_stream_async(
+    UA_Client *client, const UA_ExtensionObject *historyReadDetails,
+    const UA_HistoryReadValueId *nodesToRead, size_t nodesToReadSize,
+    const UA_ClientHistoryReadOptions *options, UA_ClientHistoryReadSink sink,
+    UA_ClientHistoryReadDone done, void *context);
+
 _UA_END_DECLS
 
 #endif /* UA_CLIENT_HIGHLEVEL_ASYNC_H_ */
@@ -102,6 +102,23 @@ UA_Client_Subscriptions_delete_async(UA_Client *client,
 UA_StatusCode UA_EXPORT UA_THREADSAFE
 UA_Client_Subscriptions_deleteSingle(UA_Client *client, UA_UInt32 subscriptionId);
 
+/* Receive all DataChangeNotifications of a subscription in one call. The
+ * notification is handed over without copying and must not be retained beyond
+ * the callback. The arrays monIds and monContexts run parallel to
+ * notification->monitoredItems. For a clientHandle that does not resolve to a
+ * data MonitoredItem, the monId is zero and the context is NULL. While a batch
+ * callback is set, the dataChangeCallbacks of the individual MonitoredItems
+ * are not called. Set the callback to NULL to restore the per-item
+ * callbacks. */
+typedef void (*UA_Client_DataChangeBatchCallback)
+    (UA_Client *client, UA_UInt32 subId, void *subContext,
+     UA_DataChangeNotification *notification,
+     const UA_UInt32 *monIds, void * const *monContexts);
+
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Client_Subscriptions_setDataChangeBatchCallback(UA_Client *client,
+    UA_UInt32 subscriptionId, UA_Client_DataChangeBatchCallback callback);
+
 static UA_INLINE UA_THREADSAFE UA_SetPublishingModeResponse
 UA_Client_Subscriptions_setPublishingMode(UA_Client *client,
     const UA_SetPublishingModeRequest request) {
@@ -182,6 +199,27 @@ UA_Client_MonitoredItems_createDataChange(UA_Client *client,
     void *context, UA_Client_DataChangeNotificationCallback callback,
     UA_Client_DeleteMonitoredItemCallback deleteCallback);
 
+/* Create a large number of DataChange MonitoredItems. The items are split into
+ * chunks that respect the MaxMonitoredItemsPerCall OperationLimit of the server
+ * (read once per Session). Several chunks are in flight at the same time. The
+ * results are merged into one response in the order of the request. If a chunk
+ * fails as a whole, the results of its items carry the StatusCode.
+ *
+ * The async variant calls the createCallback once with the merged response
+ * and requestId 0. */
+UA_CreateMonitoredItemsResponse UA_EXPORT UA_THREADSAFE
+UA_Client_MonitoredItems_createDataChangesBulk(UA_Client *client,
+    const UA_CreateMonitoredItemsRequest request, void **contexts,
+    UA_Client_DataChangeNotificationCallback *callbacks,
+    UA_Client_DeleteMonitoredItemCallback *deleteCallbacks);
+
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Client_MonitoredItems_createDataChangesBulk_async(UA_Client *client,
+    const UA_CreateMonitoredItemsRequest request, void **contexts,
+    UA_Client_DataChangeNotificationCallback *callbacks,
+    UA_Client_DeleteMonitoredItemCallback *deleteCallbacks,
+    UA_ClientAsyncServiceCallback createCallback, void *userdata);
+
 /* Monitor the EventNotifier attribute only */
 UA_CreateMonitoredItemsResponse UA_EXPORT UA_THREADSAFE
 UA_Client_MonitoredItems_createEvents(UA_Client *client,
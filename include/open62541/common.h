@@ -248,6 +248,13 @@ typedef struct {
     size_t channelTimeoutCount; /* only used by servers */
     size_t channelAbortCount;
     size_t channelPurgeCount;   /* only used by servers */
+    size_t handshakeRejectCount; /* only used by servers */
+    size_t asyncHandshakeCount;  /* only used by servers */
+    size_t certificateCacheHitCount; /* only used by servers */
+    size_t securedChunksSentCount;     /* only used by servers. Chunks signed
+                                        * and/or encrypted for sending */
+    size_t securedChunksReceivedCount; /* only used by servers. Chunks
+                                        * decrypted and/or verified */
 } UA_SecureChannelStatistics;
 
 typedef struct {
@@ -257,6 +264,10 @@ typedef struct {
     size_t rejectedSessionCount;
     size_t sessionTimeoutCount;          /* only used by servers */
     size_t sessionAbortCount;            /* only used by servers */
+    size_t sessionLookupCount;           /* only used by servers */
+    size_t sessionLookupSteps;           /* only used by servers. Accumulated
+                                          * cost (number of index nodes
+                                          * visited) of the session lookups */
 } UA_SessionStatistics;
 
 /**
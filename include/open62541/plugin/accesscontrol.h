@@ -32,6 +32,16 @@ struct UA_AccessControl {
     void *context;
     void (*clear)(UA_AccessControl *ac);
 
+    /* Cache the decisions of getUserRightsMask, getUserAccessLevel and
+     * getUserExecutable in every Session for up to decisionCacheSize nodes.
+     * Only set this if the decisions depend on nothing but the Session and the
+     * NodeId. A value of zero disables the cache. The cached decisions of a
+     * Session are dropped when it is (re-)activated. Increase the
+     * decisionEpoch to drop all cached decisions, for example when the
+     * permissions of a user or a node have changed. */
+    size_t decisionCacheSize;
+    UA_UInt32 decisionEpoch;
+
     /* Supported login mechanisms. The server endpoints are created from here. */
     size_t userTokenPoliciesSize;
     UA_UserTokenPolicy *userTokenPolicies;
@@ -51,6 +61,14 @@ struct UA_AccessControl {
                                      const UA_ExtensionObject *userIdentityToken,
                                      void **sessionContext);
 
+    /* Map the authenticated session to a bitmask of roles. Called after
+     * activateSession has succeeded. The roles are checked against the role
+     * masks of the nodes (see UA_NodeRoleMasks). If the callback is not set,
+     * the session has no roles. Nodes with role masks are then only accessible
+     * for the admin session. */
+    UA_UInt64 (*getSessionRoles)(UA_Server *server, UA_AccessControl *ac,
+                                 const UA_NodeId *sessionId, void *sessionContext);
+
     /* Deauthenticate a session and cleanup */
     void (*closeSession)(UA_Server *server, UA_AccessControl *ac,
                          const UA_NodeId *sessionId, void *sessionContext);
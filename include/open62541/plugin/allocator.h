@@ -0,0 +1,103 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef UA_PLUGIN_ALLOCATOR_H_
+#define UA_PLUGIN_ALLOCATOR_H_
+
+#include <open62541/types.h>
+
+_UA_BEGIN_DECLS
+
+/**
+ * .. _allocator:
+ *
+ * Allocator Plugin API
+ * ====================
+ *
+ * With ``UA_ENABLE_MALLOC_SINGLETON``, the memory management (``UA_malloc``
+ * etc.) can be routed through an allocator plugin. Every allocation is tagged
+ * with the memory category of the subsystem that is currently active. So the
+ * allocator can keep separate pools and statistics for the subsystems.
+ *
+ * The current category is kept in the thread-local variable
+ * ``UA_memoryCategory``. The library sets it when entering a subsystem and
+ * restores the previous value when leaving. Allocations outside of the tagged
+ * subsystems use the default category. Note that memory can be freed from
+ * another subsystem than it was allocated in. For example, a value copied from
+ * the nodestore is freed after the response is sent. So the allocator has to
+ * find the category of a memory block from the pointer. */
+
+typedef enum {
+    UA_MEMORYCATEGORY_DEFAULT = 0,
+    UA_MEMORYCATEGORY_NODESTORE = 1,     /* Adding and editing nodes */
+    UA_MEMORYCATEGORY_SUBSCRIPTIONS = 2, /* Subscriptions and the publishing */
+    UA_MEMORYCATEGORY_SECURECHANNEL = 3, /* Chunk buffers and message assembly */
+    UA_MEMORYCATEGORY_PUBSUB = 4,        /* Sending and receiving NetworkMessages */
+    UA_MEMORYCATEGORY_ENCODING = 5,      /* Temporary memory for decoding */
+    UA_MEMORYCATEGORY_SESSIONS = 6,      /* Creating and activating Sessions */
+    UA_MEMORYCATEGORY_MONITOREDITEMS = 7 /* MonitoredItems, their samples and
+                                          * notifications */
+} UA_MemoryCategory;
+
+#define UA_MEMORYCATEGORIES 8
+
+/* Lower-case name of the category (e.g. "nodestore") */
+UA_EXPORT const char *
+UA_MemoryCategory_name(UA_MemoryCategory category);
+
+typedef struct {
+    size_t bytesInUse;    /* Requested size of the allocated blocks */
+    size_t blocksInUse;
+    size_t bytesReserved; /* Memory taken from the system, including the
+                           * headers and the free blocks kept in pools */
+    UA_UInt64 allocations;
+    UA_UInt64 frees;
+} UA_MemoryStatistics;
+
+struct UA_Allocator;
+typedef struct UA_Allocator UA_Allocator;
+
+struct UA_Allocator {
+    void *context;
+
+    void * (*malloc)(UA_Allocator *a, UA_MemoryCategory category, size_t size);
+    void * (*calloc)(UA_Allocator *a, UA_MemoryCategory category,
+                     size_t nelem, size_t elsize);
+
+    /* The block keeps its category. A NULL ptr allocates in the category. */
+    void * (*realloc)(UA_Allocator *a, UA_MemoryCategory category,
+                      void *ptr, size_t size);
+    void (*free)(UA_Allocator *a, void *ptr);
+
+    /* Optional. Returns UA_STATUSCODE_BADNOTSUPPORTED if not implemented. */
+    UA_StatusCode (*getStatistics)(UA_Allocator *a, UA_MemoryCategory category,
+                                   UA_MemoryStatistics *stats);
+
+    /* Releases all memory of the allocator */
+    void (*clear)(UA_Allocator *a);
+};
+
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+
+extern UA_THREAD_LOCAL UA_MemoryCategory UA_memoryCategory;
+
+/* Routes UA_malloc et al. through the allocator by setting the malloc
+ * singletons of the current thread. The worker threads started by the library
+ * inherit the singletons. Other threads that call into the library have to set
+ * the allocator as well. NULL restores the default malloc. The allocator must
+ * only be changed when no memory from the previous allocator is in use, e.g.
+ * before a server is created and after it was deleted. */
+UA_EXPORT void
+UA_Allocator_set(UA_Allocator *a);
+
+/* Returns NULL if the default malloc is used */
+UA_EXPORT UA_Allocator *
+UA_Allocator_get(void);
+
+#endif
+
+_UA_END_DECLS
+
+#endif /* UA_PLUGIN_ALLOCATOR_H_ */
@@ -0,0 +1,48 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef UA_PLUGIN_CAPTURE_H_
+#define UA_PLUGIN_CAPTURE_H_
+
+#include <open62541/types.h>
+
+_UA_BEGIN_DECLS
+
+/**
+ * .. _packet-capture:
+ *
+ * Packet Capture Plugin API
+ * =========================
+ *
+ * The packet capture plugin receives the chunks of the binary protocol in
+ * plaintext. Received chunks are handed over after they were decrypted and
+ * verified. Sent chunks are handed over before they are signed and encrypted.
+ * The padding and the signature are not part of the captured chunk. So the
+ * MessageSize field in the header can be larger than the captured chunk.
+ *
+ * The capture callback is called from the thread processing the
+ * SecureChannel. It has to return quickly. A plugin that writes to a file,
+ * for example, should only copy the chunk and do the writing in the
+ * background. The enabled flag is checked before calling into the plugin. So
+ * the capture can be toggled at runtime and has no overhead when disabled. */
+
+struct UA_PacketCapture;
+typedef struct UA_PacketCapture UA_PacketCapture;
+
+struct UA_PacketCapture {
+    volatile UA_Boolean enabled;
+
+    /* The connectionId identifies the connection within the server. The sent
+     * flag is true for chunks sent by the server. */
+    void (*capture)(UA_PacketCapture *pc, uintptr_t connectionId,
+                    UA_Boolean sent, const UA_ByteString *chunk);
+
+    /* Clean up the plugin. Writes out the pending captures. */
+    void (*clear)(UA_PacketCapture *pc);
+};
+
+_UA_END_DECLS
+
+#endif /* UA_PLUGIN_CAPTURE_H_ */
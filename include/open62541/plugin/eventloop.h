@@ -90,6 +90,50 @@ typedef enum {
                                 * cycles to finish */
 } UA_EventLoopState;
 
+/* Statistics of the EventLoop. The processing time of an iteration does not
+ * include the time spent waiting for events. */
+typedef struct {
+    size_t timerCount;                /* Currently registered timers */
+    UA_UInt64 iterationCount;         /* Completed calls of the run method */
+    UA_DateTime iterationTimeLast;    /* Processing time of the last iteration */
+    UA_DateTime iterationTimeMax;     /* Maximum processing time */
+    UA_DateTime iterationTimeTotal;   /* Accumulated processing time */
+    size_t networkBuffers;            /* Size of the network buffer pool */
+    size_t networkBuffersInUse;       /* Taken from the pool */
+    UA_UInt64 networkBufferPoolMisses; /* Pool exhausted, allocated instead */
+} UA_EventLoopStatistics;
+
+/* Profiling of the EventLoop. If profiling is enabled, the execution time of
+ * every callback is measured. The measurements are aggregated per callback.
+ * Additionally the last events are kept in a ring buffer that can be printed
+ * in the Chrome trace format (load into chrome://tracing or Perfetto). */
+typedef enum {
+    UA_EVENTLOOPPROFILETYPE_ITERATION = 0, /* Call of the run method */
+    UA_EVENTLOOPPROFILETYPE_TIMER = 1,     /* Timed callback */
+    UA_EVENTLOOPPROFILETYPE_DELAYED = 2,   /* Delayed callback */
+    UA_EVENTLOOPPROFILETYPE_FD = 3         /* Event on a file descriptor */
+} UA_EventLoopProfileType;
+
+/* The identifier depends on the type:
+ * - Iteration: Always zero (all iterations are aggregated)
+ * - Timer: The callbackId returned by addTimer
+ * - Delayed: The address of the callback function
+ * - FD: The file descriptor. For the POSIX ConnectionManagers this is also
+ *   the connectionId.
+ *
+ * Timed callbacks overrun if they finish after the next cycle is due (their
+ * scheduled time plus the interval). The overrun count is always zero for the
+ * other types. */
+typedef struct {
+    UA_EventLoopProfileType type;
+    UA_UInt64 id;
+    UA_UInt64 invocations;
+    UA_UInt64 overruns;
+    UA_DateTime timeTotal;
+    UA_DateTime timeMax;
+    UA_DateTime timeLast;
+} UA_EventLoopProfileEntry;
+
 struct UA_EventLoop {
     /* Configuration
      * ~~~~~~~~~~~~~~~
@@ -220,6 +264,34 @@ struct UA_EventLoop {
     /* Stops the EventSource before deregistrering it */
     UA_StatusCode
     (*deregisterEventSource)(UA_EventLoop *el, UA_EventSource *es);
+
+    /* Statistics
+     * ~~~~~~~~~~
+     * Optional, can be NULL if the implementation keeps no statistics. */
+
+    void (*getStatistics)(UA_EventLoop *el, UA_EventLoopStatistics *stats);
+
+    /* Profiling
+     * ~~~~~~~~~
+     * Optional, can be NULL if the implementation has no profiler.
+     *
+     * Enabling resets the profile and keeps the last traceSize events for the
+     * trace output (zero for no trace). After disabling, the profile can
+     * still be read until profiling is enabled again. */
+
+    UA_StatusCode
+    (*setProfiling)(UA_EventLoop *el, UA_Boolean enable, size_t traceSize);
+
+    /* Returns a copy of the aggregated entries. The array has to be freed by
+     * the caller with UA_free. */
+    UA_StatusCode
+    (*getProfile)(UA_EventLoop *el, UA_EventLoopProfileEntry **entries,
+                  size_t *entriesSize);
+
+    /* Prints the recorded events as Chrome trace JSON. The output string is
+     * allocated and has to be cleared by the caller. */
+    UA_StatusCode
+    (*printProfileTrace)(UA_EventLoop *el, UA_String *output);
 };
 
 /**
@@ -386,6 +458,39 @@ struct UA_ConnectionManager {
     void
     (*freeNetworkBuffer)(UA_ConnectionManager *cm, uintptr_t connectionId,
                          UA_ByteString *buf);
+
+    /* Scatter-Gather Sending
+     * ~~~~~~~~~~~~~~~~~~~~~~
+     * Send several buffers with a single (scatter-gather) operation. The
+     * buffers are sent in order as if sendWithConnection was called for each
+     * of them. All buffers are released internally (also if sending fails).
+     * This is optional and can be NULL. It must only be set if the buffers
+     * from allocNetworkBuffer can be held concurrently (i.e. there is no
+     * static send buffer). */
+    UA_StatusCode
+    (*sendWithConnectionV)(UA_ConnectionManager *cm, uintptr_t connectionId,
+                           const UA_KeyValueMap *params, UA_ByteString *bufs,
+                           size_t bufsSize);
+
+    /* Send Queue
+     * ~~~~~~~~~~
+     * Number of bytes that were accepted for sending but not yet handed to
+     * the operating system because the connection is congested. Applications
+     * can use this to pause sending to slow consumers. This is optional and
+     * can be NULL. */
+    size_t
+    (*getSendQueueSize)(UA_ConnectionManager *cm, uintptr_t connectionId);
+
+    /* Retain a Received Buffer
+     * ~~~~~~~~~~~~~~~~~~~~~~~~
+     * The buffer passed to the connectionCallback is only valid during the
+     * callback. Some ConnectionManagers can retain (a part of) the received
+     * buffer so that it is not copied. The retained part is released with
+     * freeNetworkBuffer. Returns UA_STATUSCODE_BADNOTSUPPORTED if the buffer
+     * cannot be retained. This is optional and can be NULL. */
+    UA_StatusCode
+    (*retainNetworkBuffer)(UA_ConnectionManager *cm, uintptr_t connectionId,
+                           const UA_ByteString *buf);
 };
 
 /**
@@ -455,7 +560,73 @@ struct UA_InterruptManager {
  *   well. But expect accordingly longer sleep-times for timed events when the
  *   clock is set to the past. See the man-page of "clock_gettime" on how to get
  *   a clock source id for a character-device such as /dev/ptp0. (default:
- *   CLOCK_MONOTONIC_RAW) */
+ *   CLOCK_MONOTONIC_RAW)
+ *
+ * 0:coarse-clock [boolean]
+ *    Read both clocks once at the start of every EventLoop iteration and again
+ *    after the wait for events. ``dateTime_now`` and ``dateTime_nowMonotonic``
+ *    return these snapshots instead of reading the clock source. This saves
+ *    the clock reads on busy servers, where every service call, sampling and
+ *    timeout check takes timestamps. All timestamps within one iteration are
+ *    then identical, e.g. the ServerTimestamp of all values in a Read response.
+ *    The timers and statistics of the EventLoop keep using the precise clock.
+ *    Threads outside the EventLoop see the time of the last snapshot. Not
+ *    suited for real-time PubSub. (default: false)
+ *
+ * **Socket polling (Linux only)**
+ *
+ * 0:epoll-maxevents [uint32]
+ *    Maximum number of socket events retrieved with a single call to
+ *    epoll_wait. Servers with many active connections need fewer EventLoop
+ *    iterations (and syscalls) to handle all events with a larger value.
+ *    (default: 256)
+ *
+ * With glibc 2.35 and Linux 5.11 or newer, the EventLoop waits with nanosecond
+ * precision for the next cyclic callback. Otherwise the timeout of epoll_wait
+ * is rounded down to milliseconds.
+ *
+ * **Busy-polling**
+ *
+ * 0:busy-poll [uint32]
+ *    Interval in microseconds for which the sockets are polled without a
+ *    timeout after the last socket activity. This avoids the latency of the
+ *    wakeup from the blocking wait while traffic is flowing, at the cost of a
+ *    busy CPU core. When the sockets are idle for longer than the interval, the
+ *    EventLoop blocks in the wait for events again. On Linux, the interval is
+ *    also set as SO_BUSY_POLL on the TCP and UDP sockets. (default: 0,
+ *    disabled)
+ *
+ * **Real-time scheduling (Linux only)**
+ *
+ * A dedicated EventLoop, for example attached to a PubSubConnection, can be run
+ * in a separate real-time thread. Then the cyclic publishing and the receiving
+ * of the connection are not delayed by the processing in the server's
+ * EventLoop. The parameters are applied to the thread that first runs the
+ * EventLoop after it was started.
+ *
+ * 0:rt-priority [int32]
+ *    Run the thread with the SCHED_FIFO policy and the given priority
+ *    (default: unchanged scheduling policy).
+ *
+ * 0:cpu-affinity [uint32]
+ *    Pin the thread to the given CPU (default: no pinning).
+ *
+ * **Network buffer pool**
+ *
+ * The ConnectionManagers for TCP and UDP share a pool of network buffers with
+ * a fixed size. The pool is mapped when the EventLoop starts, with huge pages
+ * if they are available. The send buffers and the TCP receive buffers are
+ * taken from the pool without a malloc call. A received TCP buffer can be
+ * retained by the SecureChannel for chunks that are processed later. If the
+ * pool is exhausted or a buffer is too large, the buffer is allocated
+ * individually.
+ *
+ * 0:buffer-pool-size [uint32]
+ *    Number of buffers in the pool (default: 0, no pool).
+ *
+ * 0:buffer-pool-bufsize [uint32]
+ *    Size of each buffer. Should match the send and receive buffer size of
+ *    the SecureChannels (default: 65536). */
 
 UA_EXPORT UA_EventLoop *
 UA_EventLoop_new_POSIX(const UA_Logger *logger);
@@ -488,6 +659,26 @@ UA_EventLoop_new_POSIX(const UA_Logger *logger);
  *    becomes an upper bound for the message size. If undefined a fresh buffer
  *    is allocated for every `allocNetworkBuffer` (default: no buffer).
  *
+ * 0:send-queue-size [uint32]
+ *    Data that cannot be sent without blocking is queued per connection and
+ *    sent once the socket becomes writable. Sending blocks only if the queue
+ *    exceeds this number of bytes (default: 4MB).
+ *
+ * 0:recv-max-reads [uint32]
+ *    A connection is read until the socket is drained when it signals
+ *    incoming data. This limits the number of reads (of up to recv-bufsize
+ *    each) per EventLoop iteration, so that a busy connection does not starve
+ *    the others (default: 8).
+ *
+ * 0:accept-batch [uint32]
+ *    Pending connections of a listen socket are accepted in a loop. This limits
+ *    the number of connections accepted per EventLoop iteration (default: 16).
+ *
+ * 0:accept-rate-limit [uint32]
+ *    Maximum number of connections accepted per second from the same remote
+ *    address. Further connections are closed right away (default: 0, no
+ *    limit).
+ *
  * **Open Connection Parameters:**
  *
  * 0:address [string | array of string]
@@ -544,6 +735,12 @@ UA_ConnectionManager_new_POSIX_TCP(const UA_String eventSourceName);
  *    becomes an upper bound for the message size. If undefined a fresh buffer
  *    is allocated for every `allocNetworkBuffer` (default: no buffer).
  *
+ * 0:recv-batchsize [uint32]
+ *    Number of datagrams received with a single syscall where recvmmsg is
+ *    available. The receive buffer is allocated for that many datagrams of
+ *    recv-bufsize each. The datagrams are forwarded to the connection
+ *    callback one after the other (default: 8, at most 64).
+ *
  * **Open Connection Parameters:**
  *
  * 0:listen [boolean]
@@ -585,6 +782,14 @@ UA_ConnectionManager_new_POSIX_TCP(const UA_String eventSourceName);
  *    creating any connection but solely validating the provided parameters
  *    (default: false)
  *
+ * 0:txtime-enable [bool]
+ *    Enable sending with a txtime for the connection (default: false). Only
+ *    available on recent Linux kernels. Same conventions as for the Ethernet
+ *    ConnectionManager.
+ *
+ * 0:txtime-flags [uint32]
+ *    txtime flags set for the socket (default: SOF_TXTIME_REPORT_ERRORS).
+ *
  * **Connection Callback Parameters:**
  *
  * 0:remote-address [string]
@@ -593,9 +798,18 @@ UA_ConnectionManager_new_POSIX_TCP(const UA_String eventSourceName);
  * 0:remote-port [uint16]
  *    Contains the remote port.
  *
- * **Send Parameters:**
+ * **Send Parameters (only with txtime enabled for the connection):**
+ *
+ * 0:txtime [datetime]
+ *    Time when the datagram is sent out (Datetime has 100ns precision) for the
+ *    "monotonic" clock source of the EventLoop. With `sendWithConnectionV`
+ *    all datagrams get the same txtime.
  *
- * No additional parameters for sending over an UDP connection defined. */
+ * 0:txtime-pico [uint16]
+ *    Picoseconds added to the txtime timestamp (default: 0).
+ *
+ * 0:txtime-drop-late [bool]
+ *    Drop datagram if it cannot be sent in time (default: true). */
 UA_EXPORT UA_ConnectionManager *
 UA_ConnectionManager_new_POSIX_UDP(const UA_String eventSourceName);
 
@@ -656,6 +870,23 @@ UA_ConnectionManager_new_POSIX_UDP(const UA_String eventSourceName);
  *    creating any connection but solely validating the provided parameters
  *    (default: false)
  *
+ * 0:ring-frames [uint32]
+ *    Number of frames in a PACKET_MMAP ring shared with the kernel (default: 0,
+ *    no ring). Listen connections receive from the ring without a syscall per
+ *    frame. Send connections hand out ring frames in `allocNetworkBuffer`, so
+ *    that messages are encoded in-place, and send all frames of
+ *    `sendWithConnectionV` with a single syscall. Not used together with
+ *    txtime sending.
+ *
+ * 0:qdisc-bypass [bool]
+ *    Send frames directly to the device queue, bypassing the traffic control
+ *    layer of the kernel (default: false). Defined only for send connections.
+ *
+ * 0:busy-poll [uint32]
+ *    Busy-poll the device queue for up to the given number of microseconds
+ *    when waiting for frames (default: 0, disabled). Defined only for listen
+ *    connections.
+ *
  * Sending with a txtime (for Time-Sensitive Networking) is possible on recent
  * Linux kernels, If enabled for the socket, then a txtime parameters can be
  * passed to `sendWithConnection`. Note that the clock source for txtime sending
@@ -683,6 +914,58 @@ UA_ConnectionManager_new_POSIX_UDP(const UA_String eventSourceName);
 UA_EXPORT UA_ConnectionManager *
 UA_ConnectionManager_new_POSIX_Ethernet(const UA_String eventSourceName);
 
+/**
+ * Shared-Memory Connection Manager
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Transport for a client and server on the same host (Linux only). The client
+ * creates a shared memory region with a byte ring for each direction and hands
+ * it to the server over a Unix domain socket in the abstract namespace. After
+ * this handshake, the messages are copied into the ring and the remote side is
+ * woken up with an eventfd only if it waits for data. Connections are only
+ * accepted from processes of the same user (or from any process if the server
+ * runs as root). The protocol identifier is "shm" and the endpoint URL scheme
+ * is ``opc.shm://<name>``.
+ *
+ * The received messages point directly into the ring and are only valid
+ * during the connection callback.
+ *
+ * **Configuration parameters:**
+ *
+ * 0:ring-size [uint32]
+ *    Size of each ring in bytes, rounded up to a power of two (default: 1MB).
+ *    Set by the side that opens the connection.
+ *
+ * 0:send-queue-size [uint32]
+ *    Maximum number of bytes queued per connection when the ring is full
+ *    (default: 4MB). The connection is closed when it is exceeded.
+ *
+ * 0:recv-max-reads [uint32]
+ *    Maximum number of ring segments handled per connection in one EventLoop
+ *    iteration (default: 8).
+ *
+ * **Open Connection Parameters:**
+ *
+ * 0:address [string]
+ *    Name of the endpoint (required).
+ *
+ * 0:listen [boolean]
+ *    Listen for incoming connections (default: false).
+ *
+ * 0:validate [boolean]
+ *    If true, the connection setup will act as a dry-run without actually
+ *    creating any connection (default: false).
+ *
+ * **Connection Callback Parameters:**
+ *
+ * 0:listen-address [string]
+ *    Name of the endpoint for listen connections.
+ *
+ * 0:remote-address [string]
+ *    Process id of the remote side for connections opened by a listen
+ *    connection. */
+UA_EXPORT UA_ConnectionManager *
+UA_ConnectionManager_new_POSIX_SHM(const UA_String eventSourceName);
+
 /**
  * MQTT Connection Manager
  * ~~~~~~~~~~~~~~~~~~~~~~~
@@ -712,6 +995,11 @@ UA_ConnectionManager_new_POSIX_Ethernet(const UA_String eventSourceName);
  * 0:keep-alive [uint16]
  *   Number of seconds for the keep-alive (ping) (default: 400).
  *
+ * 0:max-inflight [uint16]
+ *   Maximum number of QoS1 publishes awaiting their acknowledgement from the
+ *   broker. Further publishes are rejected with BadResourceUnavailable until
+ *   acknowledgements arrive (default: 64).
+ *
  * 0:validate [boolean]
  *    If true, the connection setup will act as a dry-run without actually
  *    creating any connection but solely validating the provided parameters
@@ -724,6 +1012,15 @@ UA_ConnectionManager_new_POSIX_Ethernet(const UA_String eventSourceName);
  *    Subscribe to the topic (default: false). Otherwise it is only possible to
  *    publish on the topic. Subscribed topics can also be published to.
  *
+ * 0:qos [byte]
+ *    QoS level 0 or 1 for publishing and subscribing (default: 0).
+ *
+ * Outgoing packets are collected during an EventLoop iteration and written to
+ * the broker connection at once. QoS0 payloads are sent from the buffer
+ * allocated with ``allocNetworkBuffer`` without further copies.
+ * ``getSendQueueSize`` returns the bytes waiting for the next write, the
+ * unacknowledged QoS1 publishes and the send queue of the TCP connection.
+ *
  * **Connection Callback Parameters:**
  *
  * 0:topic [string]
@@ -128,8 +128,8 @@ struct UA_HistoryDatabase {
                UA_HistoryReadResponse *response,
                UA_HistoryEvent * const * const historyData);
 
-    /* No default implementation is provided by UA_HistoryDatabase_default
-     * for the following function */
+    /* UA_HistoryDatabase_default implements the aggregates Interpolative,
+     * Average, Minimum, Maximum and Count */
     void
     (*readProcessed)(UA_Server *server,
                void *hdbContext,
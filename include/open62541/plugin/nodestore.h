@@ -336,11 +336,14 @@ typedef struct UA_ReferenceTargetTreeElem {
 
 
 /* List of reference targets with the same reference type and direction. Uses
- * either an array or a tree structure. The SDK will not change the type of
- * reference target structure internally. The nodestore implementations may
- * switch internally when a node is updated.
+ * either an array, a tree or a compact structure. The SDK will not change the
+ * type of reference target structure internally. The nodestore implementations
+ * may switch internally when a node is updated.
  *
- * The recommendation is to switch to a tree once the number of refs > 8. */
+ * UA_Node_addReference switches to a tree once the number of refs > 16. The
+ * BrowseName index of the tree is used to resolve BrowsePaths. Wide lists of
+ * static models can be packed into the compact representation with
+ * UA_NodeReferenceKind_switchCompact. */
 typedef struct {
     union {
         /* Organize the references in an array. Uses less memory, but incurs
@@ -357,16 +360,28 @@ typedef struct {
             UA_ReferenceTargetTreeElem *idRoot;   /* Lookup based on target id */
             UA_ReferenceTargetTreeElem *nameRoot; /* Lookup based on browseName*/
         } tree;
+
+        /* Compact representation if all targets are local numeric NodeIds in
+         * the namespace compactNamespace. Uses 12 Bytes per target. A single
+         * allocation holds three UInt32 arrays of length targetsSize: the
+         * numeric identifiers in ascending order, the BrowseName hashes in the
+         * same order and the positions of the targets sorted by the BrowseName
+         * hash. UA_Node_addReference switches to the tree representation
+         * before adding a target. */
+        UA_UInt32 *compact;
     } targets;
     size_t targetsSize;
     UA_Boolean hasRefTree; /* RefTree or RefArray? */
     UA_Byte referenceTypeIndex;
     UA_Boolean isInverse;
+    UA_Boolean isCompact; /* Compact representation (hasRefTree is false) */
+    UA_UInt16 compactNamespace;
 } UA_NodeReferenceKind;
 
 /* Iterate over the references. Aborts when the first callback return a non-NULL
  * pointer and returns that pointer. Do not modify the reference targets during
- * the iteration. */
+ * the iteration. For the compact representation, the target passed to the
+ * callback is a temporary that is valid only during the callback. */
 typedef void *
 (*UA_NodeReferenceKind_iterateCallback)(void *context, UA_ReferenceTarget *target);
 
@@ -375,16 +390,24 @@ UA_NodeReferenceKind_iterate(UA_NodeReferenceKind *rk,
                              UA_NodeReferenceKind_iterateCallback callback,
                              void *context);
 
-/* Returns the entry for the targetId or NULL if not found */
+/* Returns the entry for the targetId or NULL if not found. The compact
+ * representation has no stored entry. Then a pointer to a static placeholder
+ * is returned if the target is found. */
 UA_EXPORT const UA_ReferenceTarget *
 UA_NodeReferenceKind_findTarget(const UA_NodeReferenceKind *rk,
                                 const UA_ExpandedNodeId *targetId);
 
-/* Switch between array and tree representation. Does nothing upon error (e.g.
- * out-of-memory). */
+/* Switch between array and tree representation. The compact representation is
+ * switched to a tree. Does nothing upon error (e.g. out-of-memory). */
 UA_EXPORT UA_StatusCode
 UA_NodeReferenceKind_switch(UA_NodeReferenceKind *rk);
 
+/* Switch to the compact representation. Returns
+ * UA_STATUSCODE_BADNOTSUPPORTED if not all targets are local numeric NodeIds
+ * of the same namespace. Does nothing upon error. */
+UA_EXPORT UA_StatusCode
+UA_NodeReferenceKind_switchCompact(UA_NodeReferenceKind *rk);
+
 /* Singly-linked LocalizedText list */
 typedef struct UA_LocalizedTextListEntry {
     struct UA_LocalizedTextListEntry *next;
@@ -392,9 +415,29 @@ typedef struct UA_LocalizedTextListEntry {
 } UA_LocalizedTextListEntry;
 
 /* Every Node starts with these attributes */
+/**
+ * Role Masks
+ * ~~~~~~~~~~
+ * Role-based permissions are evaluated natively with bitmasks of up to 64
+ * roles. The meaning of the bits is defined by the application. The
+ * AccessControl plugin maps the identity of a Session to its roles when the
+ * Session is activated. A node can carry for every permission the mask of the
+ * roles that are granted it. The check is then a single AND with the roles of
+ * the Session. Nodes without role masks are not restricted. */
+
+typedef struct {
+    UA_UInt64 browse; /* Browse the node and read its attributes (except the
+                       * Value) */
+    UA_UInt64 read;   /* Read the Value */
+    UA_UInt64 write;  /* Write the attributes */
+    UA_UInt64 call;   /* Call the method */
+} UA_NodeRoleMasks;
+
 struct UA_NodeHead {
     UA_NodeId nodeId;
     UA_NodeClass nodeClass;
+    UA_UInt32 nodeIdHash; /* UA_NodeId_hash of the nodeId. Set by the Nodestore
+                           * when the node is inserted. Zero if unknown. */
     UA_QualifiedName browseName;
 
     /* A node can have different localizations for displayName and description.
@@ -414,6 +457,7 @@ struct UA_NodeHead {
     /* Members specific to open62541 */
     void *context;
     UA_Boolean constructed; /* Constructors were called */
+    UA_NodeRoleMasks *roleMasks; /* NULL if the node is not restricted */
 #ifdef UA_ENABLE_SUBSCRIPTIONS
     UA_MonitoredItem *monitoredItems; /* MonitoredItems for Events and immediate
                                        * DataChanges (no sampling interval). */
@@ -532,6 +576,38 @@ typedef struct {
                            const UA_DataValue *value);
 } UA_DataSource;
 
+/* A single read operation forwarded to the batch read callback of a
+ * DataSource. The value is returned in the same way as for the read callback
+ * of the DataSource (zero-copy with UA_VARIANT_DATA_NODELETE is possible). */
+typedef struct {
+    const UA_NodeId *nodeId;
+    void *nodeContext;
+    const UA_NumericRange *range; /* NULL if the entire value is read */
+    UA_DataValue *value;          /* Initialized and non-NULL */
+} UA_DataSourceReadItem;
+
+/* Read the values of several DataSource variables of the same device in one
+ * call.
+ *
+ * @param server The server executing the callback
+ * @param sessionId The identifier of the session
+ * @param sessionContext Additional data attached to the session in the access
+ *        control layer
+ * @param device The device key set for the variables
+ * @param includeSourceTimeStamp If true, then the datasource is expected to set
+ *        the source timestamp in the returned values
+ * @param itemsSize The number of read items
+ * @param items The read items. The results are set in their values.
+ * @return Returns a status code for logging. If an error is returned, then the
+ *         error is set as the status of all items and no releasing of the
+ *         values is done */
+typedef UA_StatusCode
+(*UA_DataSourceReadBatchCallback)(UA_Server *server, const UA_NodeId *sessionId,
+                                  void *sessionContext, void *device,
+                                  UA_Boolean includeSourceTimeStamp,
+                                  size_t itemsSize,
+                                  const UA_DataSourceReadItem *items);
+
 /**
  * .. _value-callback:
  *
@@ -572,7 +648,8 @@ typedef enum {
     UA_VALUEBACKENDTYPE_NONE,
     UA_VALUEBACKENDTYPE_INTERNAL,
     UA_VALUEBACKENDTYPE_DATA_SOURCE_CALLBACK,
-    UA_VALUEBACKENDTYPE_EXTERNAL
+    UA_VALUEBACKENDTYPE_EXTERNAL,
+    UA_VALUEBACKENDTYPE_MEMORY
 } UA_ValueBackendType;
 
 typedef struct {
@@ -587,6 +664,23 @@ typedef struct {
             UA_DataValue **value;
             UA_ExternalValueCallback callback;
         } external;
+        /* The value lives in an application-owned memory region, e.g. a
+         * process image that is shared with PubSub or another process. The
+         * region holds a scalar (arrayLength == 0) or a fixed-length array of
+         * a pointer-free type. Reads encode directly from the region or copy
+         * it without further callbacks. Writes are copied into the region.
+         *
+         * If the seqlock is set, every writer increments it before and after
+         * modifying the region. So the counter is odd during a write. Readers
+         * retry until they see the same even counter before and after copying
+         * the region. The server follows the protocol for its own writes.
+         * Without a seqlock the application has to prevent torn reads. */
+        struct {
+            void *data;
+            const UA_DataType *type;
+            size_t arrayLength;
+            volatile size_t *seqlock;
+        } memory;
     } backend;
 } UA_ValueBackend;
 
@@ -622,6 +716,14 @@ typedef struct {
                            * background. Only dynamic variables conserve source
                            * and server timestamp for the value attribute.
                            * Static variables have timestamps of "now". */
+#if UA_MULTITHREADING >= 100
+    UA_Boolean async; /* Read/write the DataSource value asynchronously */
+#endif
+
+    /* Read the DataSource value together with the other variables of the
+     * device (see UA_Server_setVariableNode_dataSourceReadBatch) */
+    UA_DataSourceReadBatchCallback readBatch;
+    void *readBatchDevice;
 } UA_VariableNode;
 
 /**
@@ -806,7 +908,14 @@ typedef struct {
      *
      * The attribute-mask and reference-description indicate if only a subset of
      * the attributes and referencs are to be modified. Other attributes and
-     * references shall not be changed. */
+     * references shall not be changed.
+     *
+     * The server changes existing nodes (attribute writes, adding and removing
+     * references) only via ``getEditNode`` and ``releaseNode``. So the node is
+     * edited in-situ if the plugin allows it. ``getNodeCopy`` and
+     * ``replaceNode`` are used only where a new node is derived from an
+     * existing one. A plugin that must isolate concurrent readers can return a
+     * copy from ``getEditNode`` and publish it in ``releaseNode``. */
     UA_Node * (*getEditNode)(void *nsCtx, const UA_NodeId *nodeId,
                              UA_UInt32 attributeMask,
                              UA_ReferenceTypeSet references,
@@ -852,8 +961,60 @@ typedef struct {
     /* Execute a callback for every node in the nodestore. */
     void (*iterate)(void *nsCtx, UA_NodestoreVisitor visitor,
                     void *visitorCtx);
+
+    /* Optional. Reorganize the stored nodes for faster lookup and a smaller
+     * memory footprint. The server calls this once after namespace 0 was
+     * created, before it becomes accessible from other threads. Pointers to
+     * nodes that are not currently retrieved (getNode, getEditNode,
+     * getNodeCopy) can become invalid. */
+    void (*compact)(void *nsCtx);
+
+    /* Optional. Get several nodes with one call. The result for each NodeId is
+     * the same as from ``getNode`` (NULL if the node is not found). Every
+     * returned node has to be released individually with ``releaseNode``. The
+     * attribute mask and references apply to all nodes. This allows the
+     * Nodestore to overlap the memory accesses of the lookups. */
+    void (*getNodes)(void *nsCtx, size_t nodesSize, const UA_NodeId **nodeIds,
+                     UA_UInt32 attributeMask, UA_ReferenceTypeSet references,
+                     UA_BrowseDirection referenceDirections,
+                     const UA_Node **outNodes);
+
+    /* Set if ``getNode``, ``getNodes`` and ``releaseNode`` can be called from
+     * several threads at the same time. (But not at the same time as the other
+     * methods.) Then the local Read API of the server (e.g. UA_Server_read)
+     * holds the service lock only in shared mode. Readers in different threads
+     * can run in parallel. */
+    UA_Boolean concurrentReads;
+
+    /* Optional. Release a node that has been retrieved with ``getEditNode``
+     * or ``getEditNodeFromPtr`` and return whether the changes were
+     * published. A Nodestore that returns a copy from ``getEditNode``
+     * replaces the original here and returns the status of the replacement
+     * (see ``replaceNode``). The server uses ``releaseNode`` if this is not
+     * set. */
+    UA_StatusCode (*releaseEditNode)(void *nsCtx, UA_Node *node);
 } UA_Nodestore;
 
+/* Decode the header of an address space snapshot (see
+ * UA_Server_saveAddressSpaceSnapshot) and return the namespace array of the
+ * server the snapshot was taken from. The offset is moved to the first node. */
+UA_EXPORT UA_StatusCode
+UA_AddressSpaceSnapshot_decodeHeader(const UA_ByteString *snapshot, size_t *offset,
+                                     size_t *namespacesSize, UA_String **namespaces);
+
+/* Decode the node at the offset of a snapshot and move the offset behind it.
+ * The node is allocated with the Nodestore. The NodeIds of the ReferenceTypes
+ * are resolved to their ReferenceTypeIndex with ``getNode``. After the last
+ * node, outNode is set to NULL.
+ *
+ * If ns is NULL, the references are skipped and the node is allocated with
+ * UA_malloc. It has to be deleted with UA_Node_clear and UA_free. */
+UA_EXPORT UA_StatusCode
+UA_AddressSpaceSnapshot_decodeNode(const UA_ByteString *snapshot, size_t *offset,
+                                   const UA_Nodestore *ns,
+                                   const UA_DataTypeArray *customTypes,
+                                   UA_Node **outNode);
+
 /* Attributes must be of a matching type (VariableAttributes, ObjectAttributes,
  * and so on). The attributes are copied. Note that the attributes structs do
  * not contain NodeId, NodeClass and BrowseName. The NodeClass of the node needs
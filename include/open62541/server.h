@@ -22,6 +22,8 @@
 #include <open62541/util.h>
 
 #include <open62541/plugin/log.h>
+#include <open62541/plugin/allocator.h>
+#include <open62541/plugin/capture.h>
 #include <open62541/plugin/certificategroup.h>
 #include <open62541/plugin/nodestore.h>
 #include <open62541/plugin/eventloop.h>
@@ -69,6 +71,19 @@ typedef void (*UA_Server_AsyncOperationNotifyCallback)(UA_Server *server);
  *
  * The :ref:`tutorials` provide a good starting point for this. */
 
+/* CPU placement for the threads of a role (Linux only). The threads are pinned
+ * to the union of the listed CPUs and of the CPUs of the listed NUMA nodes.
+ * The scheduler can still move a thread between the CPUs of the set. The
+ * kernel allocates memory on the NUMA node of the thread that first writes to
+ * it (first-touch). So the buffers and nodes created by a pinned thread stay
+ * local to its node. With both lists empty, the threads are not pinned. */
+typedef struct {
+    size_t cpusSize;
+    UA_UInt32 *cpus;
+    size_t numaNodesSize;
+    UA_UInt32 *numaNodes;
+} UA_ThreadPlacement;
+
 struct UA_ServerConfig {
     void *context; /* Used to attach custom data to a server config. This can
                     * then be retrieved e.g. in a callback that forwards a
@@ -153,6 +168,10 @@ struct UA_ServerConfig {
     UA_EventLoop *eventLoop;
     UA_Boolean externalEventLoop; /* The EventLoop is not deleted with the config */
 
+    /* Placement of the thread that calls UA_Server_run_startup. This is
+     * usually the thread that then runs the EventLoop. */
+    UA_ThreadPlacement eventLoopPlacement;
+
     /**
      * Networking
      * ^^^^^^^^^^
@@ -178,6 +197,10 @@ struct UA_ServerConfig {
                               * (default: 0 -> unbounded) */
     UA_Boolean tcpReuseAddr;
 
+    /* Capture the chunks of the binary protocol (e.g. into a pcapng file).
+     * Optional, can be NULL. Cleaned up together with the config. */
+    UA_PacketCapture *packetCapture;
+
     /**
      * Security and Encryption
      * ^^^^^^^^^^^^^^^^^^^^^^^ */
@@ -239,6 +262,26 @@ struct UA_ServerConfig {
     UA_UInt16 maxSecureChannels;
     UA_UInt32 maxSecurityTokenLifetime; /* in ms */
 
+    /* Token bucket for the opening of new SecureChannels. Every first
+     * OpenSecureChannel request takes a token before the (expensive)
+     * asymmetric cryptography is applied. The bucket is refilled with
+     * maxHandshakesPerSecond tokens per second and holds up to
+     * maxHandshakeBurst tokens. Handshakes without a token are rejected with
+     * BadTcpServerTooBusy, so that the clients retry later. The rejections are
+     * counted in the handshakeRejectCount of the SecureChannel statistics.
+     * (default: 0 -> unlimited) */
+    UA_UInt32 maxHandshakesPerSecond;
+    UA_UInt32 maxHandshakeBurst; /* (default: 0 -> maxHandshakesPerSecond) */
+
+    /* Remote certificates that passed the verification with the
+     * secureChannelPKI are remembered for this duration. Reconnecting clients
+     * with the same certificate skip the verification. Note that changes to
+     * the trust list (e.g. a removed certificate) only take effect for
+     * remembered certificates once their entry expires. The skipped
+     * verifications are counted in the certificateCacheHitCount of the
+     * SecureChannel statistics. (in ms, default: 0 -> disabled) */
+    UA_UInt32 certificateCacheTtl;
+
     /* Limits for Sessions */
     UA_UInt16 maxSessions;
     UA_Double maxSessionTimeout; /* in ms */
@@ -256,6 +299,85 @@ struct UA_ServerConfig {
     /* Limits for Requests */
     UA_UInt32 maxReferencesPerNode;
 
+    /* Decode every received service request into a memory arena that is
+     * released in one go after the request was processed. This avoids
+     * individual allocations for every decoded field. The value is the
+     * (initial) size of the arena in bytes. The arena grows on demand and
+     * shrinks back to the initial size after each request. With the arena,
+     * the Strings and ByteStrings of the request point directly into the
+     * received message instead of being copied.
+     * (default: 0 -> disabled) */
+    UA_UInt32 requestArenaSize;
+
+#if UA_MULTITHREADING >= 200
+    /* Read requests with at least this many operations are processed by
+     * parallel worker threads. The workers are started on demand and kept
+     * until the server is deleted. The thread processing the request holds
+     * the service lock meanwhile. Operations that call a value callback
+     * (onRead, DataSource, external value backend) are processed afterwards
+     * by the requesting thread. But the access control callbacks
+     * (getUserAccessLevel, getUserRightsMask, getUserExecutable) are called
+     * concurrently from the worker threads without releasing the lock. So
+     * they must be thread-safe if parallelReadThreshold is set and must not
+     * call back into the server API. (Only on POSIX.)
+     * (default: 0 -> disabled) */
+    UA_UInt32 parallelReadThreshold;
+    UA_UInt16 parallelReadThreads; /* (default: 0 -> 4 threads) */
+
+    /* SamplingGroups (MonitoredItems with the same sampling interval) with at
+     * least this many MonitoredItems read the sampled values in parallel
+     * worker threads (parallelReadThreads) with the same restrictions as for
+     * the parallel read. The detection of changes, the notification queues
+     * and the publishing remain in the EventLoop thread. (Only on POSIX.)
+     * (default: 0 -> disabled) */
+    UA_UInt32 parallelSamplingThreshold;
+
+    /* Messages of SecureChannels with signing (and encryption) that span at
+     * least this many chunks are decrypted and verified by parallel worker
+     * threads. The intermediate chunks are buffered until the threshold is
+     * reached or the final chunk arrives. Every worker uses its own context
+     * of the SecurityPolicy with the remote keys of the channel. The sequence
+     * numbers are checked afterwards in the order of the chunks. Chunks that
+     * arrive during a SecurityToken rollover are processed one by one.
+     * (Only on POSIX.)
+     * (default: 0 -> disabled) */
+    UA_UInt32 parallelDecryptThreshold;
+    UA_UInt16 parallelDecryptThreads; /* (default: 0 -> 4 threads) */
+
+    /* Decrypt and verify the first OpenSecureChannel request of a new
+     * SecureChannel with a worker thread. The EventLoop continues to serve the
+     * established SecureChannels in the meantime. The channel is completed
+     * from the EventLoop once the worker is done. The asymmetric module of the
+     * SecurityPolicies must then be thread-safe (e.g. with OpenSSL). The
+     * offloaded handshakes are counted in the asyncHandshakeCount of the
+     * SecureChannel statistics. (Only on POSIX.)
+     * (default: false) */
+    UA_Boolean asyncHandshake;
+
+    /* Process the service requests with a pool of worker threads instead of
+     * the EventLoop. The requests of a Session are processed one after the
+     * other in the order they were received. Requests of different Sessions
+     * (and SecureChannels) are processed in parallel. The workers decode the
+     * requests without holding the service lock. But the services are still
+     * executed (and the responses sent) with the service lock held. The
+     * EventLoop then also holds the service lock while it processes the
+     * network input of the SecureChannels. (Only on POSIX.)
+     * (default: 0 -> requests are processed by the EventLoop) */
+    UA_UInt16 requestWorkers;
+    UA_ThreadPlacement requestWorkerPlacement;
+#endif
+
+    /* Array values of at least this many bytes that are written into a
+     * VariableNode are stored as a shared (reference-counted) buffer. Reading
+     * the value, sampling it in a MonitoredItem and queueing the notification
+     * then reference the same immutable buffer instead of copying the array
+     * every time. See ``UA_VARIANT_DATA_SHARED``. The values returned by the
+     * local API (e.g. UA_Server_readValue) and passed to callbacks can then
+     * also be shared. Applications must not modify them in place without
+     * calling UA_Variant_unshare first.
+     * (default: 0 -> disabled) */
+    UA_UInt32 sharedValueThreshold;
+
 #ifdef UA_ENABLE_ENCRYPTION
     /* Limits for TrustList */
     UA_UInt32 maxTrustListSize; /* in bytes, 0 => unlimited */
@@ -271,6 +393,12 @@ struct UA_ServerConfig {
     size_t maxAsyncOperationQueueSize; /* 0 => unlimited */
     /* Notify workers when an async operation was enqueued */
     UA_Server_AsyncOperationNotifyCallback asyncOperationNotifyCallback;
+    /* Number of built-in worker threads for async operations. With zero
+     * workers, the operations are taken by user-managed workers with
+     * UA_Server_getAsyncOperationNonBlocking. Only supported for the POSIX
+     * architecture. (default: 0) */
+    UA_UInt16 asyncOperationWorkers;
+    UA_ThreadPlacement asyncOperationWorkerPlacement;
 #endif
 
     /**
@@ -310,6 +438,15 @@ struct UA_ServerConfig {
     UA_UInt32 maxNotificationsPerPublish;
     UA_Boolean enableRetransmissionQueue;
     UA_UInt32 maxRetransmissionQueueSize; /* 0 -> unlimited size */
+    /* Byte budgets for the encoded messages in the retransmission queues per
+     * Session and for the entire server. The oldest messages are released
+     * first when a budget is exceeded. 0 -> unlimited */
+    UA_UInt32 maxRetransmissionQueueBytes;
+    UA_UInt32 maxRetransmissionBytes;
+    /* Maximum number of released Notifications (and of released
+     * retransmission entries) that are kept for reuse instead of being freed.
+     * 0 -> disabled */
+    UA_UInt32 notificationPoolSize;
 # ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
     UA_UInt32 maxEventsPerNode; /* 0 -> unlimited size */
 # endif
@@ -320,6 +457,22 @@ struct UA_ServerConfig {
     UA_DurationRange samplingIntervalLimits; /* in ms (must not be less than 5) */
     UA_UInt32Range queueSizeLimits; /* Negotiated with the client */
 
+    /* Sampled values with a payload of at least this many bytes are not kept
+     * in the MonitoredItem for the change detection. Only a 64-bit hash of the
+     * last value is stored and compared. This applies to arrays of
+     * pointer-free types and to scalar Strings and ByteStrings without a
+     * deadband filter. A hash collision (very unlikely) suppresses the
+     * notification for a change. A ResendData call reports the current value
+     * instead of the last value sent for these MonitoredItems.
+     * (default: 0 -> disabled) */
+    UA_UInt32 monitoredItemHashThreshold;
+
+    /* CreateMonitoredItems requests with at least this many items are created
+     * as a batch. The initial samples are then not taken within the request.
+     * They are produced incrementally in the following iterations of the
+     * EventLoop. (default: 0 -> disabled) */
+    UA_UInt32 monitoredItemsBatchThreshold;
+
     /* Limits for PublishRequests */
     UA_UInt32 maxPublishReqPerSession;
 
@@ -954,6 +1107,44 @@ UA_Server_writeExecutable(UA_Server *server, const UA_NodeId nodeId,
                              &UA_TYPES[UA_TYPES_BOOLEAN], &executable); 
 })
 
+/**
+ * Value Handles
+ * ~~~~~~~~~~~~~
+ * Application code that accesses the same variables over and over (e.g. a
+ * control loop that mirrors process data into the information model) can
+ * resolve the VariableNode once into a value handle. Reading the scalar value
+ * through the handle copies it directly out of the node without looking up the
+ * NodeId, creating a DataValue or calling the access control. Writing through
+ * the handle skips the type checks when the new value has the exact type of
+ * the current value. MonitoredItems without a sampling interval are still
+ * triggered by the write.
+ *
+ * The handle is re-resolved internally when the Nodestore was modified since
+ * the last access. Variables with a DataSource, a value backend or an onWrite
+ * callback are accessed through the regular Read and Write services. The
+ * handles are owned by the server and released at the latest when the server
+ * is deleted. */
+
+typedef struct UA_ValueHandle UA_ValueHandle;
+
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Server_getValueHandle(UA_Server *server, const UA_NodeId nodeId,
+                         UA_ValueHandle **outHandle);
+
+void UA_EXPORT UA_THREADSAFE
+UA_Server_releaseValueHandle(UA_Server *server, UA_ValueHandle *handle);
+
+/* Read the scalar value of the variable. Returns BadTypeMismatch if the value
+ * is not a scalar of the given type. The value is deep-copied into the
+ * (uninitialized) memory at outValue. */
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Server_readValueHandle(UA_Server *server, UA_ValueHandle *handle,
+                          const UA_DataType *type, void *outValue);
+
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Server_writeValueHandle(UA_Server *server, UA_ValueHandle *handle,
+                           const UA_DataType *type, const void *value);
+
 /**
  * Browsing
  * -------- */
@@ -1128,6 +1319,15 @@ UA_StatusCode UA_EXPORT UA_THREADSAFE
 UA_Server_setNodeContext(UA_Server *server, UA_NodeId nodeId,
                          void *nodeContext);
 
+/* Set the role masks of the node (see UA_NodeRoleMasks). Browse, Read, Write
+ * and Call of a session require at least one of its roles in the mask of the
+ * respective permission. References to nodes without the browse permission
+ * are omitted from the Browse results. Pass NULL to remove the restrictions
+ * of the node. */
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Server_setNodeRoleMasks(UA_Server *server, const UA_NodeId nodeId,
+                           const UA_NodeRoleMasks *roleMasks);
+
 /**
  * .. _datasource:
  *
@@ -1146,6 +1346,19 @@ UA_StatusCode UA_EXPORT UA_THREADSAFE
 UA_Server_setVariableNode_dataSource(UA_Server *server, const UA_NodeId nodeId,
                                      const UA_DataSource dataSource);
 
+/* Read the value of a DataSource variable in batches. The Read service and the
+ * sampling of MonitoredItems collect the value reads of their operations. The
+ * reads of variables with the same batch callback and device key are then
+ * forwarded in a single call. For example, a field bus driver can read all
+ * registers of a device in one transaction. The read callback of the
+ * DataSource is still used for single reads (e.g. UA_Server_read). Set the
+ * callback to NULL to disable batching for the variable. */
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Server_setVariableNode_dataSourceReadBatch(UA_Server *server,
+                                              const UA_NodeId nodeId,
+                                              UA_DataSourceReadBatchCallback readBatch,
+                                              void *device);
+
 UA_StatusCode UA_EXPORT UA_THREADSAFE
 UA_Server_setVariableNode_valueCallback(UA_Server *server,
                                         const UA_NodeId nodeId,
@@ -1607,6 +1820,105 @@ UA_Server_addMethodNode_finish(UA_Server *server, const UA_NodeId nodeId,
 
 #endif
 
+/* Bulk loading of nodes. Between _begin and _end, the _finish part of adding
+ * a node defers the type-checking of variables and the calls to the node
+ * constructors. The nodes are inserted and their mandatory children are
+ * instantiated right away. UA_Server_endBulkLoad then type-checks all added
+ * nodes and calls the constructors in one pass. Nodes that fail the check are
+ * removed (like in _finish) and the first error is returned.
+ *
+ * The bulk mode applies to all nodes added to the server in between, also via
+ * the AddNodes service. The values of the added variables are not yet
+ * type-checked before UA_Server_endBulkLoad.
+ *
+ * UA_Server_endBulkLoad also packs the references of nodes with many targets
+ * into a compact representation if all targets are numeric NodeIds of the same
+ * namespace. That reduces the memory for the references of large static
+ * models. Adding a reference to such a node unpacks its targets again. */
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Server_beginBulkLoad(UA_Server *server);
+
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Server_endBulkLoad(UA_Server *server);
+
+/* Node tables are static descriptions of nodes and their references. They
+ * are generated by the nodeset compiler (backend "open62541_table") instead of
+ * one function per node. NodeIds are numeric. Their namespace is an index into
+ * the namespace mapping that is passed to UA_Server_addNodeTable. Strings are
+ * indices into a pool of unique strings.
+ *
+ * Nodes that cannot be described by the table (e.g. with a value, a string
+ * NodeId or method nodes) use generated _begin/_finish functions instead. The
+ * _begin function also adds the references of the node. */
+typedef struct {
+    UA_UInt16 namespaceIndex; /* Index in the namespace mapping */
+    UA_UInt32 identifier;
+} UA_NodeTableNodeId;
+
+typedef struct {
+    UA_NodeTableNodeId referenceTypeId;
+    UA_NodeTableNodeId targetId;
+    UA_Boolean isForward;
+} UA_NodeTableReference;
+
+#define UA_NODETABLE_ISABSTRACT      0x01
+#define UA_NODETABLE_SYMMETRIC       0x02
+#define UA_NODETABLE_HISTORIZING     0x04
+#define UA_NODETABLE_EXECUTABLE      0x08
+#define UA_NODETABLE_USEREXECUTABLE  0x10
+#define UA_NODETABLE_CONTAINSNOLOOPS 0x20
+
+typedef UA_StatusCode (*UA_NodeTableCallback)(UA_Server *server, UA_UInt16 *ns);
+
+typedef struct {
+    /* If set, replaces the generic _begin/_finish from the table entry */
+    UA_NodeTableCallback begin;
+    UA_NodeTableCallback finish;
+
+    UA_NodeTableNodeId nodeId;
+    UA_NodeTableNodeId parentNodeId;
+    UA_NodeTableNodeId referenceTypeId; /* To the parent */
+    UA_NodeTableNodeId typeDefinition;
+    UA_NodeTableNodeId dataType;
+    UA_UInt16 browseNameNamespace; /* Index in the namespace mapping */
+    UA_UInt32 browseName;          /* The strings are indices in the pool */
+    UA_UInt32 displayNameLocale;
+    UA_UInt32 displayName;
+    UA_UInt32 description;         /* Index in the description pool */
+    UA_UInt32 inverseName;
+    UA_UInt32 writeMask;
+    UA_UInt32 userWriteMask;
+    UA_Double minimumSamplingInterval;
+    UA_Int32 valueRank;
+    UA_UInt32 arrayDimensions;     /* Index of the first dimension in the pool.
+                                    * valueRank > 0 is the number of dims. */
+    UA_UInt32 referencesOffset;    /* Range in the references array */
+    UA_UInt32 referencesSize;
+    UA_Byte nodeClass;
+    UA_Byte flags;
+    UA_Byte eventNotifier;
+    UA_Byte accessLevel;
+    UA_Byte userAccessLevel;
+} UA_NodeTableEntry;
+
+typedef struct {
+    const UA_NodeTableEntry *nodes;
+    size_t nodesSize;
+    const UA_NodeTableReference *references;
+    const char * const *strings;      /* The first string is "" */
+    const char * const *descriptions; /* Can be NULL to skip the descriptions */
+    const UA_UInt32 *arrayDimensions;
+} UA_NodeTable;
+
+/* Adds the nodes of the table in bulk mode (unless the server already is in
+ * bulk mode). The nodes are added in the order of the table. The _finish
+ * part is called right after _begin for ReferenceType nodes and in reverse
+ * order for all other nodes afterwards. The ns mapping translates the
+ * namespace indices of the table to the server. */
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Server_addNodeTable(UA_Server *server, const UA_NodeTable *table,
+                       UA_UInt16 *ns);
+
 /* Deletes a node and optionally all references leading to the node. */
 UA_StatusCode UA_EXPORT UA_THREADSAFE
 UA_Server_deleteNode(UA_Server *server, const UA_NodeId nodeId,
@@ -1680,6 +1992,29 @@ UA_Server_triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
                        const UA_NodeId originId, UA_ByteString *outEventId,
                        const UA_Boolean deleteEventNode);
 
+/* Triggers an event that is given by its fields without creating a node
+ * representation. The fields are filtered and encoded directly for the
+ * listening MonitoredItems. The key of each field is the BrowseName of the
+ * event property. Nested properties join the BrowseNames of the path with '/'
+ * and use the namespace index of the last element (e.g. "EnabledState/Id").
+ * Only the Value attribute of the fields can be selected.
+ *
+ * The EventId, EventType, SourceNode and ReceiveTime are set by the server.
+ * The Time defaults to the ReceiveTime if it is not part of the fields.
+ * Condition events need the node representation and cannot be triggered this
+ * way.
+ *
+ * @param server The server object
+ * @param eventType The type of the event. Must be a subtype of BaseEventType.
+ * @param originId The NodeId of the node from which the event is emitted
+ * @param fields The event fields. Can be NULL. The fields are not modified.
+ * @param outEventId The EventId of the new event. Can be NULL.
+ * @return The StatusCode of the UA_Server_triggerEventFields method */
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Server_triggerEventFields(UA_Server *server, const UA_NodeId eventType,
+                             const UA_NodeId originId, const UA_KeyValueMap *fields,
+                             UA_ByteString *outEventId);
+
 #endif /* UA_ENABLE_SUBSCRIPTIONS_EVENTS */
 
 /**
@@ -1866,7 +2201,9 @@ UA_Server_deleteCondition(UA_Server *server,
                           const UA_NodeId condition,
                           const UA_NodeId conditionSource);
 
-/* Set the LimitState of the LimitAlarmType
+/* Set the LimitState of the LimitAlarmType. The limits are cached in the
+ * condition and kept up to date when the limit properties are written. The
+ * LimitState fields are only written when the state changes.
  *
  * @param server The server object
  * @param conditionId NodeId of the node representation of the Condition Instance
@@ -1875,6 +2212,30 @@ UA_StatusCode UA_EXPORT
 UA_Server_setLimitState(UA_Server *server, const UA_NodeId conditionId,
                         UA_Double limitValue);
 
+/* Evaluate the LimitAlarm whenever the value of the input node is written.
+ * Every transition of the LimitState sets the ActiveState and triggers an
+ * event for the condition. The InputNode property is set accordingly. Use
+ * UA_NODEID_NULL to remove the input.
+ *
+ * @param server The server object
+ * @param conditionId NodeId of the node representation of the Condition Instance
+ * @param inputNode The numeric variable that is monitored by the alarm */
+UA_StatusCode UA_EXPORT
+UA_Server_setLimitAlarmInput(UA_Server *server, const UA_NodeId conditionId,
+                             const UA_NodeId inputNode);
+
+/* Evaluate the LimitAlarms for sampled values of their input nodes without
+ * writing the values into the input nodes. The samples are evaluated in
+ * order with a single acquisition of the server lock.
+ *
+ * @param server The server object
+ * @param samplesSize Number of samples
+ * @param inputNodes The input node of each sample
+ * @param samples The sampled values */
+void UA_EXPORT
+UA_Server_evaluateLimitAlarms(UA_Server *server, size_t samplesSize,
+                              const UA_NodeId *inputNodes, const UA_Double *samples);
+
 /* Parse the certifcate and set Expiration date
  *
  * @param server The server object
@@ -1932,6 +2293,74 @@ UA_StatusCode UA_EXPORT UA_THREADSAFE
 UA_Server_getNamespaceByIndex(UA_Server *server, const size_t namespaceIndex,
                               UA_String *foundUri);
 
+/* Serialize all nodes of the information model and the namespace array into a
+ * binary image. The node attributes and references are stored in the OPC UA
+ * binary encoding. Node contexts, callbacks (e.g. DataSources and methods) and
+ * the values of DataSource variables are not part of the snapshot. The
+ * returned ByteString has to be cleared by the caller. */
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Server_saveAddressSpaceSnapshot(UA_Server *server, UA_ByteString *snapshot);
+
+/* Restore the nodes from a snapshot, e.g. from a memory-mapped file. Nodes
+ * that do not exist are inserted directly into the Nodestore. The type checks
+ * of the AddNodes service are skipped and constructors are not called. So the
+ * snapshot must come from a trusted source. For nodes that exist already (e.g.
+ * in namespace 0) only the missing references are added. The namespaces of
+ * the snapshot are added to the server and must result in the same indices. */
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Server_loadAddressSpaceSnapshot(UA_Server *server,
+                                   const UA_ByteString *snapshot);
+
+/**
+ * .. _replication:
+ *
+ * Hot-Standby Replication
+ * -----------------------
+ * The Sessions, Subscriptions and MonitoredItems of a server can be replicated
+ * to a standby server. The primary server hands the changes to the
+ * replication callback as an opaque delta (at most once per EventLoop
+ * iteration and without holding the server lock). How the deltas get to the
+ * standby is left to the application. The standby applies them to a shadow
+ * state without creating the entities.
+ *
+ * When the standby takes over, it creates the Sessions with the same SessionId
+ * and AuthenticationToken and the Subscriptions and MonitoredItems with the
+ * same identifiers and sequence numbers. So the clients can reactivate their
+ * Session on a new SecureChannel and keep publishing without recreating their
+ * Subscriptions. Queued notifications, the retransmission queue and triggering
+ * links are not replicated. The AccessControl plugin sets up the context of a
+ * Session when the client reactivates it. */
+
+typedef void
+(*UA_Server_ReplicationCallback)(UA_Server *server, void *context,
+                                 const UA_ByteString *delta);
+
+/* Set the callback for the deltas of the primary server. Set the callback to
+ * NULL to stop the replication. Deltas that are not yet delivered when the
+ * server is stopped are dropped. */
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Server_setReplicationCallback(UA_Server *server,
+                                 UA_Server_ReplicationCallback callback,
+                                 void *context);
+
+/* Encode the complete state to synchronize a new standby. Call this after
+ * setting the replication callback, so that no changes are lost in between.
+ * The state is applied like a delta and replaces the previous shadow state of
+ * the standby. The returned ByteString has to be cleared by the caller. */
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Server_getReplicationState(UA_Server *server, UA_ByteString *state);
+
+/* Apply a delta (or the complete state) in the standby server. The deltas
+ * have to be applied in the order they were produced and must come from a
+ * trusted source. */
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Server_applyReplicationDelta(UA_Server *server, const UA_ByteString *delta);
+
+/* Create the Sessions, Subscriptions and MonitoredItems from the shadow state
+ * of the standby server. The shadow state is consumed. */
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Server_takeOverReplication(UA_Server *server);
+
 /**
  * .. _async-operations:
  *
@@ -1947,6 +2376,22 @@ UA_Server_getNamespaceByIndex(UA_Server *server, const size_t namespaceIndex,
  * ready. See the examples in ``/examples/tutorial_server_method_async.c`` for
  * the usage.
  *
+ * Likewise, reading and writing the value attribute of a variable with a
+ * DataSource (e.g. backed by a slow field bus) can be marked as async. Then the
+ * DataSource callbacks are executed by the workers.
+ *
+ * The workers are either managed by the user or started by the server (see the
+ * asyncOperationWorkers setting in the server config). The built-in workers
+ * have a queue of operations each and steal from the other queues when idle.
+ * Workers execute the operations with the admin session. The access rights of
+ * the requesting session are checked before the operation is enqueued.
+ *
+ * Instead of polling for new operations, the application can register an
+ * executor. The server hands every new operation to the executor right away.
+ * The result can be returned from any thread. Returned results wake up the
+ * EventLoop and the response is sent as soon as all operations of the request
+ * are done.
+ *
  * Note that the operation can time out (see the asyncOperationTimeout setting in
  * the server config) also when it has been retrieved by the worker. */
 
@@ -1957,23 +2402,29 @@ UA_StatusCode UA_EXPORT
 UA_Server_setMethodNodeAsync(UA_Server *server, const UA_NodeId id,
                              UA_Boolean isAsync);
 
+/* Set the async flag in a variable node. Only takes effect for the value
+ * attribute of variables with a DataSource. */
+UA_StatusCode UA_EXPORT
+UA_Server_setVariableNodeAsync(UA_Server *server, const UA_NodeId id,
+                               UA_Boolean isAsync);
+
 typedef enum {
     UA_ASYNCOPERATIONTYPE_INVALID, /* 0, the default */
-    UA_ASYNCOPERATIONTYPE_CALL
-    /* UA_ASYNCOPERATIONTYPE_READ, */
-    /* UA_ASYNCOPERATIONTYPE_WRITE, */
+    UA_ASYNCOPERATIONTYPE_CALL,
+    UA_ASYNCOPERATIONTYPE_READ,
+    UA_ASYNCOPERATIONTYPE_WRITE
 } UA_AsyncOperationType;
 
 typedef union {
     UA_CallMethodRequest callMethodRequest;
-    /* UA_ReadValueId readValueId; */
-    /* UA_WriteValue writeValue; */
+    UA_ReadValueId readValueId;
+    UA_WriteValue writeValue;
 } UA_AsyncOperationRequest;
 
 typedef union {
     UA_CallMethodResult callMethodResult;
-    /* UA_DataValue readResult; */
-    /* UA_StatusCode writeResult; */
+    UA_DataValue readResult;
+    UA_StatusCode writeResult;
 } UA_AsyncOperationResponse;
 
 /* Get the next async operation without blocking
@@ -1998,7 +2449,7 @@ UA_Server_getAsyncOperationNonBlocking(UA_Server *server,
 /*                                     const UA_AsyncOperationRequest **request, */
 /*                                     void **context, UA_DateTime *timeout); */
 
-/* Submit an async operation result
+/* Submit an async operation result. Can be called from any thread.
  *
  * @param server The server object
  * @param response Pointer to the operation result
@@ -2008,6 +2459,27 @@ UA_Server_setAsyncOperationResult(UA_Server *server,
                                   const UA_AsyncOperationResponse *response,
                                   void *context);
 
+/* Hand a new async operation to the executor. The executor is called while
+ * the server is locked. It must not block and must not call into the server
+ * API, except for UA_Server_setAsyncOperationResult. Typically the operation
+ * is passed on to a thread pool. The request pointer remains valid until the
+ * result is set for the context. The result has to be set in any case, also
+ * after the timeout. */
+typedef void
+(*UA_Server_AsyncOperationExecutor)(UA_Server *server, void *executorContext,
+                                    UA_AsyncOperationType type,
+                                    const UA_AsyncOperationRequest *request,
+                                    void *context, UA_DateTime timeout);
+
+/* Register the executor for new async operations. It takes precedence over
+ * the built-in workers and UA_Server_getAsyncOperationNonBlocking. Operations
+ * that were enqueued before are not handed to the executor. Set a NULL
+ * executor to unregister. */
+void UA_EXPORT UA_THREADSAFE
+UA_Server_setAsyncOperationExecutor(UA_Server *server,
+                                    UA_Server_AsyncOperationExecutor executor,
+                                    void *executorContext);
+
 #endif /* !UA_MULTITHREADING >= 100 */
 
 /**
@@ -2016,14 +2488,122 @@ UA_Server_setAsyncOperationResult(UA_Server *server,
  * Statistic counters keeping track of the current state of the stack. Counters
  * are structured per OPC UA communication layer. */
 
+typedef struct {
+    size_t notificationCount;          /* Currently allocated Notifications */
+    size_t notificationHighWaterMark;  /* Maximum allocated at the same time */
+    size_t notificationPoolSize;       /* Released and kept for reuse */
+    size_t retransmissionCount;        /* Currently allocated retransmission
+                                        * entries */
+    size_t retransmissionHighWaterMark;
+    size_t retransmissionPoolSize;
+    size_t subscriptionCount;          /* Currently active Subscriptions */
+    size_t monitoredItemCount;         /* Currently active MonitoredItems */
+} UA_NotificationStatistics;
+
+typedef struct {
+    size_t publishCycleCount;        /* Executed WriterGroup publish cycles */
+    size_t publishCycleOverrunCount; /* Publish cycles that started more than
+                                      * half a PublishingInterval late. That
+                                      * is, a cycle was skipped or the previous
+                                      * cycle took too long. */
+} UA_PubSubStatistics;
+
 typedef struct {
    UA_SecureChannelStatistics scs;
    UA_SessionStatistics ss;
+   UA_NotificationStatistics ns; /* Only with subscriptions enabled */
+   UA_PubSubStatistics ps;       /* Only with PubSub enabled */
 } UA_ServerStatistics;
 
 UA_ServerStatistics UA_EXPORT
 UA_Server_getStatistics(UA_Server *server);
 
+/**
+ * Memory Report
+ * ~~~~~~~~~~~~~
+ * The memory in use by the server objects. The allocations are attributed to
+ * the memory category of the subsystem where they were made (see
+ * :ref:`allocator`). For example, the samples and notifications of a
+ * MonitoredItem are counted in the MonitoredItems category. Dividing by the
+ * number of objects gives the average footprint per object. This is the
+ * estimate to size how many Sessions, MonitoredItems or nodes fit into the
+ * memory of a device.
+ *
+ * The report requires ``UA_ENABLE_MALLOC_SINGLETON`` and an allocator plugin
+ * with statistics (e.g. ``UA_Allocator_Tracking_new``) that is set before the
+ * server is created. Otherwise only the object counts are returned together
+ * with the status code ``UA_STATUSCODE_BADNOTSUPPORTED``. */
+
+typedef struct {
+    size_t objects;        /* Current number of objects */
+    size_t bytesInUse;     /* Memory of the category */
+    size_t blocksInUse;
+    size_t bytesPerObject; /* bytesInUse / objects (zero if no objects) */
+} UA_MemoryReportEntry;
+
+typedef struct {
+    UA_MemoryReportEntry sessions;
+    UA_MemoryReportEntry subscriptions;
+    UA_MemoryReportEntry monitoredItems;
+    UA_MemoryReportEntry nodes;
+    UA_MemoryStatistics categories[UA_MEMORYCATEGORIES]; /* All categories */
+} UA_MemoryReport;
+
+UA_StatusCode UA_EXPORT
+UA_Server_getMemoryReport(UA_Server *server, UA_MemoryReport *report);
+
+#ifdef UA_ENABLE_DIAGNOSTICS
+
+/**
+ * With diagnostics enabled, the server also measures the processing time of
+ * every request from the dispatch to the service until the response is ready.
+ * The latencies are kept in log-linear histograms per service and per session.
+ * The percentiles computed from them have a relative error below 12.5%.
+ * Requests that are not answered right away (Publish and the async Call, Read
+ * and Write) are only counted. For them, the high-water mark of the queue they
+ * wait in is recorded (the Publish queue of the session or the async
+ * operations of the server).
+ *
+ * The statistics are also exposed in the information model. Below
+ * ``Server/ServerDiagnostics``, the vendor-specific object
+ * ``ServiceStatistics`` has a variable for every service. Every session
+ * diagnostics object has a ``ServiceStatistics`` variable for the requests of
+ * that session. The variables contain an array of KeyValuePair with the
+ * members of UA_ServiceStatistics as keys. */
+
+typedef struct {
+    UA_UInt64 requestCount;
+    UA_UInt64 errorCount;     /* Requests answered with a bad ServiceResult */
+    UA_UInt64 operationCount; /* Elements of the operations array (e.g. the
+                               * nodesToRead). One for requests without. */
+    UA_UInt64 asyncCount;     /* Requests not answered right away */
+    size_t queueDepthHighWaterMark;
+    UA_Duration latencyMean;  /* All latencies in milliseconds */
+    UA_Duration latencyP50;
+    UA_Duration latencyP90;
+    UA_Duration latencyP99;
+    UA_Duration latencyP999;
+    UA_Duration latencyMax;
+} UA_ServiceStatistics;
+
+/* Statistics for the service with the given request type (e.g.
+ * &UA_TYPES[UA_TYPES_READREQUEST]). If the requestType is NULL, the
+ * statistics of all services are combined. */
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Server_getServiceStatistics(UA_Server *server, const UA_DataType *requestType,
+                               UA_ServiceStatistics *stats);
+
+/* Statistics for all requests of a session */
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Server_getSessionServiceStatistics(UA_Server *server, const UA_NodeId *sessionId,
+                                      UA_ServiceStatistics *stats);
+
+/* Reset the statistics of all services and sessions */
+void UA_EXPORT UA_THREADSAFE
+UA_Server_resetServiceStatistics(UA_Server *server);
+
+#endif /* UA_ENABLE_DIAGNOSTICS */
+
 /**
  * Reverse Connect
  * ---------------
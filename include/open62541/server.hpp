@@ -0,0 +1,120 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef UA_SERVER_HPP_
+#define UA_SERVER_HPP_
+
+#include <open62541/types.hpp>
+#include <open62541/server.h>
+
+/**
+ * C++ Server Wrappers
+ * ===================
+ *
+ * Typed Value Handles
+ * -------------------
+ * ``ua::ValueHandle<T>`` wraps the ``UA_ValueHandle`` of a VariableNode whose
+ * value is a scalar of type ``T``. The handle is resolved once. Reads and
+ * writes go through the fast path of the value handles (see
+ * ``UA_Server_getValueHandle``). The type is bound at compile time, so no
+ * ``UA_DataType`` is passed around in the application code.
+ *
+ * Writing borrows the value. The server makes the only copy (into the node).
+ * Reading deep-copies out of the node directly into the target. The wrapper
+ * releases the handle in the destructor and is move-only. It must not outlive
+ * the server. */
+
+namespace ua {
+
+template <typename T>
+class ValueHandle {
+public:
+    ValueHandle() noexcept : server_(nullptr), handle_(nullptr) {}
+
+    ~ValueHandle() { reset(); }
+
+    ValueHandle(const ValueHandle &) = delete;
+    ValueHandle &operator=(const ValueHandle &) = delete;
+
+    ValueHandle(ValueHandle &&other) noexcept
+        : server_(other.server_), handle_(other.handle_) {
+        other.server_ = nullptr;
+        other.handle_ = nullptr;
+    }
+
+    ValueHandle &operator=(ValueHandle &&other) noexcept {
+        if(this != &other) {
+            reset();
+            server_ = other.server_;
+            handle_ = other.handle_;
+            other.server_ = nullptr;
+            other.handle_ = nullptr;
+        }
+        return *this;
+    }
+
+    /* Resolve the VariableNode. The handle remains empty if this fails. */
+    UA_StatusCode
+    resolve(UA_Server *server, const UA_NodeId &nodeId) noexcept {
+        reset();
+        UA_StatusCode res = UA_Server_getValueHandle(server, nodeId, &handle_);
+        if(res != UA_STATUSCODE_GOOD) {
+            handle_ = nullptr;
+            return res;
+        }
+        server_ = server;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    void
+    reset() noexcept {
+        if(handle_)
+            UA_Server_releaseValueHandle(server_, handle_);
+        server_ = nullptr;
+        handle_ = nullptr;
+    }
+
+    bool valid() const noexcept { return handle_ != nullptr; }
+
+    UA_StatusCode
+    write(const T &value) const noexcept {
+        if(!handle_)
+            return UA_STATUSCODE_BADNODEIDUNKNOWN;
+        return UA_Server_writeValueHandle(server_, handle_, dataType<T>(), &value);
+    }
+
+    /* Replaces the value in out. Returns BadTypeMismatch if the variable does
+     * not hold a scalar of type T. */
+    UA_StatusCode
+    read(Owned<T> &out) const noexcept {
+        if(!handle_)
+            return UA_STATUSCODE_BADNODEIDUNKNOWN;
+        T tmp;
+        UA_StatusCode res =
+            UA_Server_readValueHandle(server_, handle_, dataType<T>(), &tmp);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+        out = Owned<T>::adopt(tmp);
+        return UA_STATUSCODE_GOOD;
+    }
+
+    /* For the types without heap buffers (numbers, Guid, ...) */
+    UA_StatusCode
+    read(T &out) const noexcept {
+        static_assert(std::is_arithmetic_v<T> || std::is_same_v<T, UA_Guid>,
+                      "Read into an Owned<T> for types with heap buffers");
+        if(!handle_)
+            return UA_STATUSCODE_BADNODEIDUNKNOWN;
+        return UA_Server_readValueHandle(server_, handle_, dataType<T>(), &out);
+    }
+
+private:
+    UA_Server *server_;
+    UA_ValueHandle *handle_;
+};
+
+} /* namespace ua */
+
+#endif /* UA_SERVER_HPP_ */
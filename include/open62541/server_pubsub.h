@@ -174,6 +174,13 @@ typedef struct {
 
 #ifdef UA_ENABLE_PUBSUB_INFORMATIONMODEL
     UA_Boolean enableInformationModelMethods;
+
+    /* Create the information model representation of the PubSub components
+     * only when their parent node is browsed (or traversed with
+     * TranslateBrowsePathsToNodeIds). Until then the components have a
+     * reserved NodeId without a node. Saves startup time and memory for large
+     * configurations that are rarely inspected by clients. */
+    UA_Boolean lazyInformationModel;
 #endif
 
     /* PubSub security policies */
@@ -342,7 +349,9 @@ typedef struct {
     struct {
         UA_Boolean rtFieldSourceEnabled;
         /* If the rtInformationModelNode is set, the nodeid in publishParameter
-         * must point to a node with external data source backend defined */
+         * must point to a node with external data source backend defined. For
+         * a WriterGroup with fixed offsets the external value is resolved when
+         * the WriterGroup is enabled. */
         UA_Boolean rtInformationModelNode;
         /* TODO: Decide if suppress C++ warnings and use 'UA_DataValue * * const
          * staticValueSource;' */
@@ -413,6 +422,9 @@ UA_Server_removeDataSetField(UA_Server *server, const UA_NodeId dsfId);
  * UA_PUBSUB_RT_FIXED_SIZE
  *    Validate that the message constains only fields with a known size.
  *    Then the message fields have fixed offsets that are known ahead of time.
+ *    DataSetFields can be added and removed while the WriterGroup is enabled.
+ *    Then only the affected DataSetMessages are re-encoded and the new offset
+ *    table replaces the old one in a single step.
  *
  * UA_PUBSUB_RT_DETERMINISTIC
  *    Both direct-access and fixed-size is being used. The server pre-allocates
@@ -475,6 +487,17 @@ typedef struct {
     UA_UInt16 maxEncapsulatedDataSetMessageCount;
     /* non std. field */
     UA_PubSubRTLevel rtLevel;
+    /* non std. field. Offset (in ms) into the publishing cycle when the
+     * NetworkMessages leave the network interface. The publishing cycles are
+     * then aligned to multiples of the publishingInterval on the monotonic
+     * clock of the EventLoop. The NetworkMessages are handed to the
+     * ConnectionManager with a "txtime" send parameter, so that the transmit
+     * time does not depend on when the publish callback runs. Requires txtime
+     * sending for the connection ("txtime-enable" in the connectionProperties)
+     * and e.g. an ETF qdisc for the network interface. The offset has to leave
+     * enough time to encode the NetworkMessages (default: 0, send right
+     * away). */
+    UA_Duration transmitTimeOffset;
 
     /* Message are encrypted if a SecurityPolicy is configured and the
      * securityMode set accordingly. The symmetric key is a runtime information
@@ -855,6 +878,82 @@ UA_Server_writePubSubConfigurationToByteString(UA_Server *server,
 #define UA_Server_setReaderGroupDisabled(server, rgId) \
     UA_Server_disableReaderGroup(server, rgId)
 
+/**
+ * Cycle Statistics
+ * ----------------
+ * Every WriterGroup and ReaderGroup keeps statistics of its cycles. For a
+ * WriterGroup, a cycle is the execution of the publish callback. For a
+ * ReaderGroup, a cycle is a received NetworkMessage that was processed by the
+ * group. The duration of the stages of a cycle are recorded in log-linear
+ * histograms (relative error of the percentiles below 12.5%):
+ *
+ * - Jitter: For a WriterGroup, the deviation of the cycle start from the
+ *   previous cycle start plus the PublishingInterval. For a ReaderGroup, the
+ *   deviation of the time between two received messages from the time between
+ *   the two messages before.
+ * - Encoding: Generating and encoding the messages (WriterGroup) or decoding
+ *   the headers (ReaderGroup).
+ * - Security: Signing and encryption (WriterGroup) or verification and
+ *   decryption (ReaderGroup).
+ * - Transfer: Handing the messages to the ConnectionManager (WriterGroup) or
+ *   processing the DataSetMessages in the DataSetReaders (ReaderGroup).
+ * - Total: The entire cycle.
+ *
+ * The messages of WriterGroups that are batched on the PubSubConnection are
+ * sent after the publish callback. Their transfer time is not attributed to
+ * the WriterGroup.
+ *
+ * With the PubSub information model, the WriterGroup and ReaderGroup objects
+ * have the vendor-specific variable ``CycleStatistics``. It contains an array
+ * of KeyValuePair with the counters and the statistics of the stages as keys
+ * (e.g. "JitterP99"). */
+
+typedef enum {
+    UA_PUBSUBSTAGE_JITTER = 0,
+    UA_PUBSUBSTAGE_ENCODING = 1,
+    UA_PUBSUBSTAGE_SECURITY = 2,
+    UA_PUBSUBSTAGE_TRANSFER = 3,
+    UA_PUBSUBSTAGE_TOTAL = 4
+} UA_PubSubStage;
+
+#define UA_PUBSUBSTAGES 5
+
+typedef struct {
+    UA_Duration min; /* All durations in milliseconds */
+    UA_Duration mean;
+    UA_Duration p99;
+    UA_Duration max;
+} UA_PubSubStageStatistics;
+
+#define UA_PUBSUB_CYCLEHISTORY 32
+
+typedef struct {
+    UA_UInt64 cycleCount;
+    UA_UInt64 overrunCount;     /* WriterGroup: Cycles that started more than
+                                 * half a PublishingInterval late.
+                                 * ReaderGroup: MessageReceiveTimeouts of the
+                                 * DataSetReaders. */
+    UA_UInt64 missedCycleCount; /* WriterGroup: Cycles skipped entirely during
+                                 * overruns. Always zero for ReaderGroups. */
+    UA_PubSubStageStatistics stages[UA_PUBSUBSTAGES];
+    size_t recentCyclesSize;
+    UA_DateTime recentCycles[UA_PUBSUB_CYCLEHISTORY]; /* Start of the most
+                                                       * recent cycles, oldest
+                                                       * first (monotonic) */
+} UA_PubSubCycleStatistics;
+
+UA_EXPORT UA_StatusCode UA_THREADSAFE
+UA_Server_getWriterGroupCycleStatistics(UA_Server *server, const UA_NodeId wgId,
+                                        UA_PubSubCycleStatistics *stats);
+
+UA_EXPORT UA_StatusCode UA_THREADSAFE
+UA_Server_getReaderGroupCycleStatistics(UA_Server *server, const UA_NodeId rgId,
+                                        UA_PubSubCycleStatistics *stats);
+
+/* Reset the statistics of a WriterGroup or ReaderGroup */
+UA_EXPORT UA_StatusCode UA_THREADSAFE
+UA_Server_resetPubSubCycleStatistics(UA_Server *server, const UA_NodeId groupId);
+
 #ifdef UA_ENABLE_PUBSUB_SKS
 
 /**
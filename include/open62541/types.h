@@ -414,6 +414,22 @@ UA_NodeId_print(const UA_NodeId *id, UA_String *output);
 UA_StatusCode UA_EXPORT
 UA_NodeId_parse(UA_NodeId *id, const UA_String str);
 
+/* Parse without allocating memory. String identifiers point into the input
+ * string. They must not be cleaned up and the input has to outlive the NodeId.
+ * ByteString identifiers are base64-encoded and cannot be borrowed. They return
+ * BadNotSupported. */
+UA_StatusCode UA_EXPORT
+UA_NodeId_parseBorrowed(UA_NodeId *id, const UA_String str);
+
+/* Parse an array of NodeId strings. The result is a single allocation with the
+ * NodeIds followed by their (String and ByteString) identifiers. It is freed
+ * with a single UA_free. Do not call UA_NodeId_clear on the individual
+ * NodeIds. If parsing fails, the index of the first bad string is written to
+ * failedIndex (if not NULL). */
+UA_StatusCode UA_EXPORT
+UA_NodeId_parseArray(UA_NodeId **ids, const UA_String *strs, size_t strsSize,
+                     size_t *failedIndex);
+
 UA_INLINABLE(UA_NodeId
              UA_NODEID(const char *chars), {
     UA_NodeId id;
@@ -738,10 +754,22 @@ typedef struct UA_DataType UA_DataType;
 #define UA_EMPTY_ARRAY_SENTINEL ((void*)0x01)
 
 typedef enum {
-    UA_VARIANT_DATA,         /* The data has the same lifecycle as the variant */
-    UA_VARIANT_DATA_NODELETE /* The data is "borrowed" by the variant and is
-                              * not deleted when the variant is cleared up.
-                              * The array dimensions also borrowed. */
+    UA_VARIANT_DATA,          /* The data has the same lifecycle as the variant */
+    UA_VARIANT_DATA_NODELETE, /* The data is "borrowed" by the variant and is
+                               * not deleted when the variant is cleared up.
+                               * The array dimensions also borrowed. */
+    UA_VARIANT_DATA_SHARED    /* The data is a reference-counted buffer that is
+                               * shared with other variants. Copying the
+                               * variant takes another reference instead of
+                               * copying the data. The data is deleted with the
+                               * last reference. The array dimensions are not
+                               * shared. Shared data is immutable. Use
+                               * UA_Variant_unshare before modifying it.
+                               * UA_copy and UA_Variant_copy of a shared
+                               * variant return shared variants. This includes
+                               * the values returned by the server API (e.g.
+                               * UA_Server_readValue) if the server config
+                               * enables sharedValueThreshold. */
 } UA_VariantStorageType;
 
 typedef struct {
@@ -874,6 +902,24 @@ UA_StatusCode UA_EXPORT
 UA_Variant_setRangeCopy(UA_Variant *v, const void * UA_RESTRICT array,
                         size_t arraySize, const UA_NumericRange range);
 
+/* Move the data of the variant into a reference-counted buffer. Afterwards,
+ * copies of the variant reference the same buffer instead of copying the data
+ * (see ``UA_VARIANT_DATA_SHARED``). Variants with borrowed data
+ * (``UA_VARIANT_DATA_NODELETE``) cannot be shared.
+ *
+ * @param v The variant
+ * @return Returns UA_STATUSCODE_GOOD or an error code */
+UA_StatusCode UA_EXPORT
+UA_Variant_share(UA_Variant *v);
+
+/* Make the data of the variant private again, so that it can be modified. If
+ * the buffer is still referenced by other variants, the data is copied.
+ *
+ * @param v The variant
+ * @return Returns UA_STATUSCODE_GOOD or an error code */
+UA_StatusCode UA_EXPORT
+UA_Variant_unshare(UA_Variant *v);
+
 /**
  * .. _extensionobject:
  *
@@ -1084,6 +1130,9 @@ struct UA_DataType {
                                  * in memory and on the binary stream. */
     UA_UInt32 membersSize : 8;  /* How many members does the type have? */
     UA_DataTypeMember *members;
+    UA_UInt32 binarySize;       /* Size of the binary encoding if it is the
+                                 * same for all values of the type. Zero if
+                                 * the size depends on the value. */
 };
 
 /* Datatype arrays with custom type definitions can be added in a linked list to
@@ -1134,6 +1183,40 @@ const UA_DataType UA_EXPORT *
 UA_findDataTypeWithCustom(const UA_NodeId *typeId,
                           const UA_DataTypeArray *customTypes);
 
+/**
+ * The linear search through the linked list of data type arrays becomes slow
+ * for many custom types. The data type registry is a hashed index for the
+ * lookup by the type NodeId and by the binary encoding NodeId. It contains the
+ * builtin types from the start. Data type arrays can be added incrementally,
+ * for example after the definitions have been fetched from a server. The
+ * registry does not take ownership of the arrays, they must remain valid while
+ * the registry is used. A type with the same type NodeId as an existing entry
+ * replaces it.
+ *
+ * The registry can be shared between the decoding contexts. It must not be
+ * modified while it is used for decoding in another thread. */
+
+struct UA_DataTypeRegistry;
+typedef struct UA_DataTypeRegistry UA_DataTypeRegistry;
+
+UA_EXPORT UA_DataTypeRegistry *
+UA_DataTypeRegistry_new(void);
+
+UA_EXPORT void
+UA_DataTypeRegistry_delete(UA_DataTypeRegistry *r);
+
+/* Add the types of all arrays in the linked list */
+UA_EXPORT UA_StatusCode
+UA_DataTypeRegistry_add(UA_DataTypeRegistry *r,
+                        const UA_DataTypeArray *customTypes);
+
+const UA_DataType UA_EXPORT *
+UA_DataTypeRegistry_find(const UA_DataTypeRegistry *r, const UA_NodeId *typeId);
+
+const UA_DataType UA_EXPORT *
+UA_DataTypeRegistry_findByBinary(const UA_DataTypeRegistry *r,
+                                 const UA_NodeId *encodingId);
+
 /** The following functions are used for generic handling of data types. */
 
 /* Allocates and initializes a variable of type dataType
@@ -1241,6 +1324,20 @@ UA_EXPORT UA_StatusCode
 UA_encodeBinary(const void *p, const UA_DataType *type,
                 UA_ByteString *outBuf);
 
+/* The tokens of the JSON document are stored in an array before decoding. Up
+ * to 256 tokens are kept on the stack. Larger documents need a heap
+ * allocation. A token buffer can be reused across decodings to avoid the
+ * allocation per decoding. Initialize the structure with zeroes. The buffer is
+ * grown when required and has to be freed with UA_JsonTokenBuffer_clear. Do
+ * not use the same buffer in concurrent decodings. */
+typedef struct {
+    void *tokens;
+    size_t tokensSize; /* Number of tokens that fit into the buffer */
+} UA_JsonTokenBuffer;
+
+void UA_EXPORT
+UA_JsonTokenBuffer_clear(UA_JsonTokenBuffer *tb);
+
 /* The structure with the decoding options may be extended in the future.
  * Zero-out the entire structure initially to ensure code-compatibility when
  * more fields are added in a later release. */
@@ -1252,6 +1349,17 @@ typedef struct {
      * memory is not freed if decoding fails afterwards. */
     void *callocContext;
     void * (*calloc)(void *callocContext, size_t nelem, size_t elsize);
+
+    /* Decoded Strings, ByteStrings and XmlElements point into the input buffer
+     * instead of copying their content. This only takes effect together with
+     * the calloc override, as the borrowed content must not be freed with
+     * UA_clear. The decoded value is valid only as long as the input
+     * buffer. */
+    UA_Boolean borrowStrings;
+
+    /* Hashed lookup of the data types. Takes precedence over the linear search
+     * in UA_TYPES and the customTypes. */
+    const UA_DataTypeRegistry *typeRegistry;
 } UA_DecodeBinaryOptions;
 
 /* Decodes a data structure from the input buffer in the binary format. It is
@@ -1313,7 +1421,8 @@ UA_calcSizeJson(const void *src, const UA_DataType *type,
  * @param src The value. Must not be NULL.
  * @param type The value type. Must not be NULL.
  * @param outBuf Pointer to ByteString containing the result if the encoding
- *        was successful
+ *        was successful. If the ByteString is empty, then the buffer is
+ *        allocated and grown while encoding (one pass, no UA_calcSizeJson).
  * @return Returns a statuscode whether encoding succeeded. */
 UA_StatusCode UA_EXPORT
 UA_encodeJson(const void *src, const UA_DataType *type, UA_ByteString *outBuf,
@@ -1333,6 +1442,10 @@ typedef struct {
                             * stored to the pointer. When this is set, decoding
                             * succeeds also if there is more content after the
                             * first JSON element in the input string. */
+    UA_JsonTokenBuffer *tokenBuffer; /* Reused token buffer (can be NULL) */
+    size_t maxTokens; /* If non-zero, decoding fails with
+                       * BadEncodingLimitsExceeded if the document has more
+                       * tokens. Bounds the memory used for the decoding. */
 } UA_DecodeJsonOptions;
 
 /* Decodes a scalar value described by type from json encoding.
@@ -1394,7 +1507,12 @@ typedef struct {
                                           * datatype definitions */
 } UA_DecodeXmlOptions;
 
-/* Decodes a scalar value described by type from xml encoding.
+/* Decodes a scalar value described by type from xml encoding. For builtin
+ * scalars (numbers, strings, NodeIds, ...) the buffer contains the text of the
+ * element. For structured types (LocalizedText, Variant, ExtensionObject,
+ * generated structures, ...) the buffer contains the content of the element,
+ * i.e. the sequence of child elements. Namespace prefixes of the element names
+ * are ignored. The decoded value does not point into the source buffer.
  *
  * @param src The buffer with the xml encoded value. Must not be NULL.
  * @param dst The target value. Must not be NULL. The target is assumed to have
@@ -0,0 +1,443 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef UA_TYPES_HPP_
+#define UA_TYPES_HPP_
+
+#include <open62541/types.h>
+
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+#if !(__cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L))
+# error "open62541/types.hpp requires C++17"
+#endif
+
+/**
+ * C++ Type Wrappers
+ * =================
+ *
+ * Header-only C++17 layer on top of the C API in ``open62541/types.h``. It adds
+ * no runtime state. All wrappers have the memory layout of the wrapped C type
+ * and call the C API for the type-generic operations.
+ *
+ * - The ``UA_DataType`` of a C++ type is resolved at compile time with
+ *   ``ua::dataType<T>()``.
+ * - ``ua::Owned<T>`` owns a value and clears it in the destructor. It is
+ *   move-only. Moving transfers the heap buffers of the value instead of
+ *   deep-copying it. Deep copies are explicit with ``copyFrom``.
+ * - ``ua::ArrayView<T>`` and ``std::string_view`` are non-owning views on
+ *   arrays and strings.
+ *
+ * Error handling follows the C API. Operations that can fail return a
+ * ``UA_StatusCode``. No exceptions are thrown.
+ *
+ * Type Binding
+ * ------------
+ * ``ua::TypeBinding<T>`` maps a C++ type to its ``UA_DataType``. The builtin
+ * types and the common structures of the standard-defined types are bound
+ * below. Additional types (e.g. from a custom or a generated nodeset type
+ * array) are bound with the ``UA_CPP_BIND_TYPE`` macro at the global namespace
+ * scope::
+ *
+ *    UA_CPP_BIND_TYPE(UA_Point, UA_TYPES_EXAMPLE, UA_TYPES_EXAMPLE_POINT)
+ *
+ * Several builtin types share their C representation. For example,
+ * ``UA_ByteString`` is a typedef of ``UA_String`` and ``UA_StatusCode`` of
+ * ``UA_UInt32``. The binding resolves to the base type (String, UInt32, Int64
+ * for ``UA_DateTime``). Ownership is not affected by this, as the aliased types
+ * are cleared and copied the same way. Where the type tag is visible (e.g. in
+ * a Variant), the functions take the ``UA_DataType`` as an optional
+ * argument. */
+
+namespace ua {
+
+template <typename T>
+struct TypeBinding; /* Unbound types are a compile-time error */
+
+} /* namespace ua */
+
+#define UA_CPP_BIND_TYPE(CTYPE, TYPES, INDEX)                           \
+    template <>                                                         \
+    struct ua::TypeBinding<CTYPE> {                                     \
+        static const UA_DataType *get() noexcept { return &TYPES[INDEX]; } \
+    };
+
+UA_CPP_BIND_TYPE(UA_Boolean, UA_TYPES, UA_TYPES_BOOLEAN)
+UA_CPP_BIND_TYPE(UA_SByte, UA_TYPES, UA_TYPES_SBYTE)
+UA_CPP_BIND_TYPE(UA_Byte, UA_TYPES, UA_TYPES_BYTE)
+UA_CPP_BIND_TYPE(UA_Int16, UA_TYPES, UA_TYPES_INT16)
+UA_CPP_BIND_TYPE(UA_UInt16, UA_TYPES, UA_TYPES_UINT16)
+UA_CPP_BIND_TYPE(UA_Int32, UA_TYPES, UA_TYPES_INT32)
+UA_CPP_BIND_TYPE(UA_UInt32, UA_TYPES, UA_TYPES_UINT32)
+UA_CPP_BIND_TYPE(UA_Int64, UA_TYPES, UA_TYPES_INT64)
+UA_CPP_BIND_TYPE(UA_UInt64, UA_TYPES, UA_TYPES_UINT64)
+UA_CPP_BIND_TYPE(UA_Float, UA_TYPES, UA_TYPES_FLOAT)
+UA_CPP_BIND_TYPE(UA_Double, UA_TYPES, UA_TYPES_DOUBLE)
+UA_CPP_BIND_TYPE(UA_String, UA_TYPES, UA_TYPES_STRING)
+UA_CPP_BIND_TYPE(UA_Guid, UA_TYPES, UA_TYPES_GUID)
+UA_CPP_BIND_TYPE(UA_NodeId, UA_TYPES, UA_TYPES_NODEID)
+UA_CPP_BIND_TYPE(UA_ExpandedNodeId, UA_TYPES, UA_TYPES_EXPANDEDNODEID)
+UA_CPP_BIND_TYPE(UA_QualifiedName, UA_TYPES, UA_TYPES_QUALIFIEDNAME)
+UA_CPP_BIND_TYPE(UA_LocalizedText, UA_TYPES, UA_TYPES_LOCALIZEDTEXT)
+UA_CPP_BIND_TYPE(UA_ExtensionObject, UA_TYPES, UA_TYPES_EXTENSIONOBJECT)
+UA_CPP_BIND_TYPE(UA_DataValue, UA_TYPES, UA_TYPES_DATAVALUE)
+UA_CPP_BIND_TYPE(UA_Variant, UA_TYPES, UA_TYPES_VARIANT)
+UA_CPP_BIND_TYPE(UA_DiagnosticInfo, UA_TYPES, UA_TYPES_DIAGNOSTICINFO)
+
+/* The generated types depend on the selected datatypes of the build */
+#ifdef UA_TYPES_RANGE
+UA_CPP_BIND_TYPE(UA_Range, UA_TYPES, UA_TYPES_RANGE)
+#endif
+#ifdef UA_TYPES_EUINFORMATION
+UA_CPP_BIND_TYPE(UA_EUInformation, UA_TYPES, UA_TYPES_EUINFORMATION)
+#endif
+#ifdef UA_TYPES_ARGUMENT
+UA_CPP_BIND_TYPE(UA_Argument, UA_TYPES, UA_TYPES_ARGUMENT)
+#endif
+#ifdef UA_TYPES_VARIABLEATTRIBUTES
+UA_CPP_BIND_TYPE(UA_VariableAttributes, UA_TYPES, UA_TYPES_VARIABLEATTRIBUTES)
+#endif
+#ifdef UA_TYPES_OBJECTATTRIBUTES
+UA_CPP_BIND_TYPE(UA_ObjectAttributes, UA_TYPES, UA_TYPES_OBJECTATTRIBUTES)
+#endif
+#ifdef UA_TYPES_READVALUEID
+UA_CPP_BIND_TYPE(UA_ReadValueId, UA_TYPES, UA_TYPES_READVALUEID)
+#endif
+#ifdef UA_TYPES_WRITEVALUE
+UA_CPP_BIND_TYPE(UA_WriteValue, UA_TYPES, UA_TYPES_WRITEVALUE)
+#endif
+#ifdef UA_TYPES_BROWSEDESCRIPTION
+UA_CPP_BIND_TYPE(UA_BrowseDescription, UA_TYPES, UA_TYPES_BROWSEDESCRIPTION)
+#endif
+#ifdef UA_TYPES_BROWSERESULT
+UA_CPP_BIND_TYPE(UA_BrowseResult, UA_TYPES, UA_TYPES_BROWSERESULT)
+#endif
+#ifdef UA_TYPES_REFERENCEDESCRIPTION
+UA_CPP_BIND_TYPE(UA_ReferenceDescription, UA_TYPES, UA_TYPES_REFERENCEDESCRIPTION)
+#endif
+#ifdef UA_TYPES_CALLMETHODREQUEST
+UA_CPP_BIND_TYPE(UA_CallMethodRequest, UA_TYPES, UA_TYPES_CALLMETHODREQUEST)
+#endif
+#ifdef UA_TYPES_CALLMETHODRESULT
+UA_CPP_BIND_TYPE(UA_CallMethodResult, UA_TYPES, UA_TYPES_CALLMETHODRESULT)
+#endif
+
+namespace ua {
+
+template <typename T, typename = void>
+struct IsBound : std::false_type {};
+
+template <typename T>
+struct IsBound<T, std::void_t<decltype(TypeBinding<T>::get())>> : std::true_type {};
+
+/* Has the C++ type a UA_DataType binding? */
+template <typename T>
+inline constexpr bool isBound = IsBound<std::remove_cv_t<T>>::value;
+
+template <typename T>
+inline const UA_DataType *
+dataType() noexcept {
+    return TypeBinding<std::remove_cv_t<T>>::get();
+}
+
+/**
+ * Owning Wrapper
+ * --------------
+ * ``ua::Owned<T>`` holds a value of the C type ``T`` and clears it with
+ * ``UA_clear`` in the destructor. The wrapper is move-only. Moving copies the
+ * (shallow) struct and resets the source. So the heap buffers of the value
+ * (e.g. the characters of a String or the content of a Variant) are
+ * transferred without allocation. A value received from the C API can be
+ * adopted in the same way. */
+
+template <typename T>
+class Owned {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "Only the C types of open62541 can be wrapped");
+
+public:
+    Owned() noexcept { std::memset(&value_, 0, sizeof(T)); }
+
+    ~Owned() { UA_clear(&value_, dataType<T>()); }
+
+    Owned(const Owned &) = delete;
+    Owned &operator=(const Owned &) = delete;
+
+    Owned(Owned &&other) noexcept {
+        std::memcpy(&value_, &other.value_, sizeof(T));
+        std::memset(&other.value_, 0, sizeof(T));
+    }
+
+    Owned &operator=(Owned &&other) noexcept {
+        if(this != &other) {
+            UA_clear(&value_, dataType<T>());
+            std::memcpy(&value_, &other.value_, sizeof(T));
+            std::memset(&other.value_, 0, sizeof(T));
+        }
+        return *this;
+    }
+
+    /* Take ownership of the value. The source is reset to the initial state
+     * and must not be cleared by the caller. */
+    static Owned
+    adopt(T &src) noexcept {
+        Owned o;
+        std::memcpy(&o.value_, &src, sizeof(T));
+        std::memset(&src, 0, sizeof(T));
+        return o;
+    }
+
+    /* Replace the value with a deep copy of src. The current value is kept if
+     * the copy fails. */
+    UA_StatusCode
+    copyFrom(const T &src) noexcept {
+        T tmp;
+        UA_StatusCode res = UA_copy(&src, &tmp, dataType<T>());
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+        UA_clear(&value_, dataType<T>());
+        std::memcpy(&value_, &tmp, sizeof(T));
+        return UA_STATUSCODE_GOOD;
+    }
+
+    /* Give up ownership. The caller has to clear the returned value. */
+    T
+    release() noexcept {
+        T out;
+        std::memcpy(&out, &value_, sizeof(T));
+        std::memset(&value_, 0, sizeof(T));
+        return out;
+    }
+
+    void clear() noexcept { UA_clear(&value_, dataType<T>()); }
+
+    T *get() noexcept { return &value_; }
+    const T *get() const noexcept { return &value_; }
+    T &operator*() noexcept { return value_; }
+    const T &operator*() const noexcept { return value_; }
+    T *operator->() noexcept { return &value_; }
+    const T *operator->() const noexcept { return &value_; }
+
+private:
+    T value_;
+};
+
+/**
+ * Array Views
+ * -----------
+ * Non-owning view on a C array with its length. An empty array (also with the
+ * ``UA_EMPTY_ARRAY_SENTINEL``) has a null data pointer in the view. */
+
+template <typename T>
+class ArrayView {
+public:
+    constexpr ArrayView() noexcept : data_(nullptr), size_(0) {}
+
+    ArrayView(T *data, size_t size) noexcept
+        : data_(size > 0 ? data : nullptr), size_(size) {}
+
+    template <size_t N>
+    constexpr ArrayView(T (&array)[N]) noexcept : data_(array), size_(N) {}
+
+    T *data() const noexcept { return data_; }
+    size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+    T *begin() const noexcept { return data_; }
+    T *end() const noexcept { return data_ + size_; }
+    T &operator[](size_t i) const noexcept { return data_[i]; }
+
+    operator ArrayView<const T>() const noexcept { return {data_, size_}; }
+
+private:
+    T *data_;
+    size_t size_;
+};
+
+/* Owning array allocated with UA_Array_new. Move-only, same as Owned<T>. */
+template <typename T>
+class OwnedArray {
+public:
+    OwnedArray() noexcept : data_(nullptr), size_(0) {}
+
+    /* Allocates size initialized elements. Check with data() if the
+     * allocation succeeded (for size > 0). */
+    explicit OwnedArray(size_t size) noexcept
+        : data_(static_cast<T*>(UA_Array_new(size, dataType<T>()))),
+          size_(data_ ? size : 0) {}
+
+    ~OwnedArray() { UA_Array_delete(data_, size_, dataType<T>()); }
+
+    OwnedArray(const OwnedArray &) = delete;
+    OwnedArray &operator=(const OwnedArray &) = delete;
+
+    OwnedArray(OwnedArray &&other) noexcept
+        : data_(other.data_), size_(other.size_) {
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+
+    OwnedArray &operator=(OwnedArray &&other) noexcept {
+        if(this != &other) {
+            UA_Array_delete(data_, size_, dataType<T>());
+            data_ = other.data_;
+            size_ = other.size_;
+            other.data_ = nullptr;
+            other.size_ = 0;
+        }
+        return *this;
+    }
+
+    /* Take ownership of an array from the C API. The source pointer and
+     * length are reset. */
+    static OwnedArray
+    adopt(T *&data, size_t &size) noexcept {
+        OwnedArray a;
+        a.data_ = data;
+        a.size_ = size;
+        data = nullptr;
+        size = 0;
+        return a;
+    }
+
+    /* Give up ownership. The caller has to delete the returned array. */
+    T *
+    release(size_t *outSize) noexcept {
+        T *out = data_;
+        *outSize = size_;
+        data_ = nullptr;
+        size_ = 0;
+        return out;
+    }
+
+    T *data() const noexcept { return data_; }
+    size_t size() const noexcept { return size_; }
+    T &operator[](size_t i) const noexcept { return data_[i]; }
+    ArrayView<T> view() const noexcept { return {data_, size_}; }
+    T *begin() const noexcept { return data_; }
+    T *end() const noexcept { return data_ + size_; }
+
+private:
+    T *data_;
+    size_t size_;
+};
+
+/**
+ * String Views
+ * ------------
+ * A ``UA_String`` that borrows the characters of a ``std::string_view`` must
+ * not outlive the viewed characters and must never be cleared. The C API
+ * functions that take a const argument (e.g. for writing values) deep-copy
+ * where needed. */
+
+inline std::string_view
+view(const UA_String &s) noexcept {
+    if(s.length == 0)
+        return {};
+    return {reinterpret_cast<const char*>(s.data), s.length};
+}
+
+inline UA_String
+borrow(std::string_view sv) noexcept {
+    UA_String s;
+    s.length = sv.size();
+    s.data = reinterpret_cast<UA_Byte*>(const_cast<char*>(sv.data()));
+    return s;
+}
+
+/* Allocates a String with a copy of the characters */
+inline Owned<UA_String>
+toString(std::string_view sv) noexcept {
+    UA_String tmp = borrow(sv);
+    Owned<UA_String> s;
+    s.copyFrom(tmp); /* Remains empty if out of memory */
+    return s;
+}
+
+/**
+ * Variant Access
+ * --------------
+ * Typed access to the content of a Variant without copying. The setters move
+ * the owned value into the Variant. Only the small struct of a scalar is
+ * allocated, the heap buffers of the value are transferred. */
+
+/* Returns nullptr if the Variant holds no scalar of the type */
+template <typename T>
+inline const T *
+scalar(const UA_Variant &v, const UA_DataType *type = dataType<T>()) noexcept {
+    if(!UA_Variant_hasScalarType(&v, type))
+        return nullptr;
+    return static_cast<const T*>(v.data);
+}
+
+/* Returns an empty view if the Variant holds no array of the type */
+template <typename T>
+inline ArrayView<const T>
+array(const UA_Variant &v, const UA_DataType *type = dataType<T>()) noexcept {
+    if(!UA_Variant_hasArrayType(&v, type))
+        return {};
+    return {static_cast<const T*>(v.data), v.arrayLength};
+}
+
+template <typename T>
+inline UA_StatusCode
+setScalar(Owned<UA_Variant> &v, Owned<T> &&value,
+          const UA_DataType *type = dataType<T>()) noexcept {
+    T *p = static_cast<T*>(UA_malloc(sizeof(T)));
+    if(!p)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    *p = value.release();
+    v.clear();
+    UA_Variant_setScalar(v.get(), p, type);
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Scalars without heap buffers (numbers, Guid, ...) are set by value */
+template <typename T>
+inline UA_StatusCode
+setScalar(Owned<UA_Variant> &v, const T &value,
+          const UA_DataType *type = dataType<T>()) noexcept {
+    static_assert(std::is_arithmetic_v<T> || std::is_same_v<T, UA_Guid>,
+                  "Move an Owned<T> into the Variant for types with heap buffers");
+    v.clear();
+    return UA_Variant_setScalarCopy(v.get(), &value, type);
+}
+
+template <typename T>
+inline void
+setArray(Owned<UA_Variant> &v, OwnedArray<T> &&array,
+         const UA_DataType *type = dataType<T>()) noexcept {
+    size_t size = 0;
+    T *data = array.release(&size);
+    v.clear();
+    UA_Variant_setArray(v.get(), data ? static_cast<void*>(data)
+                        : UA_EMPTY_ARRAY_SENTINEL, size, type);
+}
+
+/* Non-owning Variant that points to the value. For passing a value into a
+ * function of the C API that takes a const Variant. Must not be cleared. */
+template <typename T>
+inline UA_Variant
+borrowScalar(const T &value, const UA_DataType *type = dataType<T>()) noexcept {
+    UA_Variant v;
+    UA_Variant_setScalar(&v, const_cast<T*>(&value), type);
+    return v;
+}
+
+template <typename T>
+inline UA_Variant
+borrowArray(ArrayView<const T> array,
+            const UA_DataType *type = dataType<T>()) noexcept {
+    UA_Variant v;
+    UA_Variant_setArray(&v, array.empty() ? UA_EMPTY_ARRAY_SENTINEL :
+                        const_cast<T*>(array.data()), array.size(), type);
+    return v;
+}
+
+} /* namespace ua */
+
+#endif /* UA_TYPES_HPP_ */
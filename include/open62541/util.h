@@ -362,6 +362,27 @@ UA_SimpleAttributeOperand_print(const UA_SimpleAttributeOperand *sao,
                                 UA_String *out);
 #endif
 
+/**
+ * Runtime Data Types
+ * ------------------
+ * Generate data type descriptions from their DataTypeDefinition. This allows
+ * to decode structures that are only known at runtime, for example after the
+ * definitions have been read from a server. The StructureDescriptions and
+ * EnumDescriptions are collected in a DataTypeSchemaHeader. The schema is a
+ * regular OPC UA type. So it can be encoded and stored to skip reading the
+ * definitions again. Fields with a SimpleTypeDescription of the schema are
+ * mapped to the builtin type. Members can refer to types of the schema, to the
+ * customTypes and to the standard-defined types.
+ *
+ * The memory layout of the generated types is the same as for a C structure
+ * with the members in order. Structures with subtyped values are not
+ * supported. The returned array has the cleanup flag set. It is freed with the
+ * client or server configuration it is added to. */
+UA_EXPORT UA_StatusCode
+UA_DataTypeArray_fromSchema(const UA_DataTypeSchemaHeader *schema,
+                            const UA_DataTypeArray *customTypes,
+                            UA_DataTypeArray **out);
+
 /**
  * Convenience macros for complex types
  * ------------------------------------ */
@@ -54,12 +54,12 @@ typedef struct {
 typedef struct {
     Aes128Sha256PsaOaep_PolicyContext *policyContext;
 
-    UA_ByteString localSymSigningKey;
-    UA_ByteString localSymEncryptingKey;
+    mbedtls_md_context_t localSymSigningCtx;
+    mbedtls_aes_context localSymEncryptingCtx;
     UA_ByteString localSymIv;
 
-    UA_ByteString remoteSymSigningKey;
-    UA_ByteString remoteSymEncryptingKey;
+    mbedtls_md_context_t remoteSymSigningCtx;
+    mbedtls_aes_context remoteSymEncryptingCtx;
     UA_ByteString remoteSymIv;
 
     mbedtls_x509_crt remoteCertificate;
@@ -260,10 +260,8 @@ sym_verify_sp_aes128sha256rsaoaep(Aes128Sha256PsaOaep_ChannelContext *cc,
     /* Compute MAC */
     if(signature->length != UA_SHA256_LENGTH)
         return UA_STATUSCODE_BADSECURITYCHECKSFAILED;
-    Aes128Sha256PsaOaep_PolicyContext *pc = cc->policyContext;
     unsigned char mac[UA_SHA256_LENGTH];
-    if(mbedtls_hmac(&pc->sha256MdContext, &cc->remoteSymSigningKey,
-                    message, mac) != UA_STATUSCODE_GOOD)
+    if(mbedtls_hmac_keyed(&cc->remoteSymSigningCtx, message, mac) != UA_STATUSCODE_GOOD)
         return UA_STATUSCODE_BADSECURITYCHECKSFAILED;
 
     /* Compare with Signature */
@@ -273,14 +271,14 @@ sym_verify_sp_aes128sha256rsaoaep(Aes128Sha256PsaOaep_ChannelContext *cc,
 }
 
 static UA_StatusCode
-sym_sign_sp_aes128sha256rsaoaep(const Aes128Sha256PsaOaep_ChannelContext *cc,
+sym_sign_sp_aes128sha256rsaoaep(Aes128Sha256PsaOaep_ChannelContext *cc,
                                 const UA_ByteString *message,
                                 UA_ByteString *signature) {
     if(signature->length != UA_SHA256_LENGTH)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    if(mbedtls_hmac(&cc->policyContext->sha256MdContext, &cc->localSymSigningKey,
-                    message, signature->data) != UA_STATUSCODE_GOOD)
+    if(mbedtls_hmac_keyed(&cc->localSymSigningCtx, message,
+                          signature->data) != UA_STATUSCODE_GOOD)
         return UA_STATUSCODE_BADSECURITYCHECKSFAILED;
 
     return UA_STATUSCODE_GOOD;
@@ -312,7 +310,7 @@ sym_getPlainTextBlockSize_sp_aes128sha256rsaoaep(const void *channelContext) {
 }
 
 static UA_StatusCode
-sym_encrypt_sp_aes128sha256rsaoaep(const Aes128Sha256PsaOaep_ChannelContext *cc,
+sym_encrypt_sp_aes128sha256rsaoaep(Aes128Sha256PsaOaep_ChannelContext *cc,
                                    UA_ByteString *data) {
     if(cc == NULL || data == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
@@ -325,28 +323,12 @@ sym_encrypt_sp_aes128sha256rsaoaep(const Aes128Sha256PsaOaep_ChannelContext *cc,
     if(data->length % plainTextBlockSize != 0)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    /* Keylength in bits */
-    unsigned int keylength = (unsigned int)(cc->localSymEncryptingKey.length * 8);
-    mbedtls_aes_context aesContext;
-    int mbedErr = mbedtls_aes_setkey_enc(&aesContext, cc->localSymEncryptingKey.data, keylength);
-    if(mbedErr)
-        return UA_STATUSCODE_BADINTERNALERROR;
-
-    UA_ByteString ivCopy;
-    UA_StatusCode retval = UA_ByteString_copy(&cc->localSymIv, &ivCopy);
-    if(retval != UA_STATUSCODE_GOOD)
-        return retval;
-
-    mbedErr = mbedtls_aes_crypt_cbc(&aesContext, MBEDTLS_AES_ENCRYPT, data->length,
-                                    ivCopy.data, data->data, data->data);
-    if(mbedErr)
-        retval = UA_STATUSCODE_BADINTERNALERROR;
-    UA_ByteString_clear(&ivCopy);
-    return retval;
+    return mbedtls_cbc_crypt(&cc->localSymEncryptingCtx, MBEDTLS_AES_ENCRYPT,
+                             &cc->localSymIv, data);
 }
 
 static UA_StatusCode
-sym_decrypt_sp_aes128sha256rsaoaep(const Aes128Sha256PsaOaep_ChannelContext *cc,
+sym_decrypt_sp_aes128sha256rsaoaep(Aes128Sha256PsaOaep_ChannelContext *cc,
                                    UA_ByteString *data) {
     if(cc == NULL || data == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
@@ -359,23 +341,8 @@ sym_decrypt_sp_aes128sha256rsaoaep(const Aes128Sha256PsaOaep_ChannelContext *cc,
     if(data->length % encryptionBlockSize != 0)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    unsigned int keylength = (unsigned int)(cc->remoteSymEncryptingKey.length * 8);
-    mbedtls_aes_context aesContext;
-    int mbedErr = mbedtls_aes_setkey_dec(&aesContext, cc->remoteSymEncryptingKey.data, keylength);
-    if(mbedErr)
-        return UA_STATUSCODE_BADINTERNALERROR;
-
-    UA_ByteString ivCopy;
-    UA_StatusCode retval = UA_ByteString_copy(&cc->remoteSymIv, &ivCopy);
-    if(retval != UA_STATUSCODE_GOOD)
-        return retval;
-
-    mbedErr = mbedtls_aes_crypt_cbc(&aesContext, MBEDTLS_AES_DECRYPT, data->length,
-                                    ivCopy.data, data->data, data->data);
-    if(mbedErr)
-        retval = UA_STATUSCODE_BADINTERNALERROR;
-    UA_ByteString_clear(&ivCopy);
-    return retval;
+    return mbedtls_cbc_crypt(&cc->remoteSymEncryptingCtx, MBEDTLS_AES_DECRYPT,
+                             &cc->remoteSymIv, data);
 }
 
 static UA_StatusCode
@@ -431,12 +398,12 @@ parseRemoteCertificate_sp_aes128sha256rsaoaep(Aes128Sha256PsaOaep_ChannelContext
 
 static void
 channelContext_deleteContext_sp_aes128sha256rsaoaep(Aes128Sha256PsaOaep_ChannelContext *cc) {
-    UA_ByteString_clear(&cc->localSymSigningKey);
-    UA_ByteString_clear(&cc->localSymEncryptingKey);
+    mbedtls_md_free(&cc->localSymSigningCtx);
+    mbedtls_aes_free(&cc->localSymEncryptingCtx);
     UA_ByteString_clear(&cc->localSymIv);
 
-    UA_ByteString_clear(&cc->remoteSymSigningKey);
-    UA_ByteString_clear(&cc->remoteSymEncryptingKey);
+    mbedtls_md_free(&cc->remoteSymSigningCtx);
+    mbedtls_aes_free(&cc->remoteSymEncryptingCtx);
     UA_ByteString_clear(&cc->remoteSymIv);
 
     mbedtls_x509_crt_free(&cc->remoteCertificate);
@@ -461,12 +428,12 @@ channelContext_newContext_sp_aes128sha256rsaoaep(const UA_SecurityPolicy *securi
     /* Initialize the channel context */
     cc->policyContext = (Aes128Sha256PsaOaep_PolicyContext *)securityPolicy->policyContext;
 
-    UA_ByteString_init(&cc->localSymSigningKey);
-    UA_ByteString_init(&cc->localSymEncryptingKey);
+    mbedtls_md_init(&cc->localSymSigningCtx);
+    mbedtls_aes_init(&cc->localSymEncryptingCtx);
     UA_ByteString_init(&cc->localSymIv);
 
-    UA_ByteString_init(&cc->remoteSymSigningKey);
-    UA_ByteString_init(&cc->remoteSymEncryptingKey);
+    mbedtls_md_init(&cc->remoteSymSigningCtx);
+    mbedtls_aes_init(&cc->remoteSymEncryptingCtx);
     UA_ByteString_init(&cc->remoteSymIv);
 
     mbedtls_x509_crt_init(&cc->remoteCertificate);
@@ -486,8 +453,7 @@ channelContext_setLocalSymEncryptingKey_sp_aes128sha256rsaoaep(Aes128Sha256PsaOa
     if(key == NULL || cc == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    UA_ByteString_clear(&cc->localSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->localSymEncryptingKey);
+    return mbedtls_cbc_setKey(&cc->localSymEncryptingCtx, key, true);
 }
 
 static UA_StatusCode
@@ -496,8 +462,7 @@ channelContext_setLocalSymSigningKey_sp_aes128sha256rsaoaep(Aes128Sha256PsaOaep_
     if(key == NULL || cc == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    UA_ByteString_clear(&cc->localSymSigningKey);
-    return UA_ByteString_copy(key, &cc->localSymSigningKey);
+    return mbedtls_hmac_setKey(&cc->localSymSigningCtx, MBEDTLS_MD_SHA256, key);
 }
 
 
@@ -517,8 +482,7 @@ channelContext_setRemoteSymEncryptingKey_sp_aes128sha256rsaoaep(Aes128Sha256PsaO
     if(key == NULL || cc == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    UA_ByteString_clear(&cc->remoteSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->remoteSymEncryptingKey);
+    return mbedtls_cbc_setKey(&cc->remoteSymEncryptingCtx, key, false);
 }
 
 static UA_StatusCode
@@ -527,8 +491,7 @@ channelContext_setRemoteSymSigningKey_sp_aes128sha256rsaoaep(Aes128Sha256PsaOaep
     if(key == NULL || cc == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    UA_ByteString_clear(&cc->remoteSymSigningKey);
-    return UA_ByteString_copy(key, &cc->remoteSymSigningKey);
+    return mbedtls_hmac_setKey(&cc->remoteSymSigningCtx, MBEDTLS_MD_SHA256, key);
 }
 
 static UA_StatusCode
@@ -51,12 +51,12 @@ typedef struct {
 typedef struct {
     Aes256Sha256RsaPss_PolicyContext *policyContext;
 
-    UA_ByteString localSymSigningKey;
-    UA_ByteString localSymEncryptingKey;
+    mbedtls_md_context_t localSymSigningCtx;
+    mbedtls_aes_context localSymEncryptingCtx;
     UA_ByteString localSymIv;
 
-    UA_ByteString remoteSymSigningKey;
-    UA_ByteString remoteSymEncryptingKey;
+    mbedtls_md_context_t remoteSymSigningCtx;
+    mbedtls_aes_context remoteSymEncryptingCtx;
     UA_ByteString remoteSymIv;
 
     mbedtls_x509_crt remoteCertificate;
@@ -256,9 +256,8 @@ sym_verify_sp_aes256sha256rsapss(Aes256Sha256RsaPss_ChannelContext *cc,
     /* Compute MAC */
     if(signature->length != UA_SHA256_LENGTH)
         return UA_STATUSCODE_BADSECURITYCHECKSFAILED;
-    Aes256Sha256RsaPss_PolicyContext *pc = cc->policyContext;
     unsigned char mac[UA_SHA256_LENGTH];
-    if(mbedtls_hmac(&pc->sha256MdContext, &cc->remoteSymSigningKey, message, mac) != UA_STATUSCODE_GOOD)
+    if(mbedtls_hmac_keyed(&cc->remoteSymSigningCtx, message, mac) != UA_STATUSCODE_GOOD)
         return UA_STATUSCODE_BADSECURITYCHECKSFAILED;
 
     /* Compare with Signature */
@@ -268,14 +267,14 @@ sym_verify_sp_aes256sha256rsapss(Aes256Sha256RsaPss_ChannelContext *cc,
 }
 
 static UA_StatusCode
-sym_sign_sp_aes256sha256rsapss(const Aes256Sha256RsaPss_ChannelContext *cc,
+sym_sign_sp_aes256sha256rsapss(Aes256Sha256RsaPss_ChannelContext *cc,
                                 const UA_ByteString *message,
                                 UA_ByteString *signature) {
     if(signature->length != UA_SHA256_LENGTH)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    if(mbedtls_hmac(&cc->policyContext->sha256MdContext, &cc->localSymSigningKey,
-                    message, signature->data) != UA_STATUSCODE_GOOD)
+    if(mbedtls_hmac_keyed(&cc->localSymSigningCtx, message,
+                          signature->data) != UA_STATUSCODE_GOOD)
         return UA_STATUSCODE_BADSECURITYCHECKSFAILED;
 
     return UA_STATUSCODE_GOOD;
@@ -307,7 +306,7 @@ sym_getPlainTextBlockSize_sp_aes256sha256rsapss(const void *channelContext) {
 }
 
 static UA_StatusCode
-sym_encrypt_sp_aes256sha256rsapss(const Aes256Sha256RsaPss_ChannelContext *cc,
+sym_encrypt_sp_aes256sha256rsapss(Aes256Sha256RsaPss_ChannelContext *cc,
                                    UA_ByteString *data) {
     if(cc == NULL || data == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
@@ -320,28 +319,12 @@ sym_encrypt_sp_aes256sha256rsapss(const Aes256Sha256RsaPss_ChannelContext *cc,
     if(data->length % plainTextBlockSize != 0)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    /* Keylength in bits */
-    unsigned int keylength = (unsigned int)(cc->localSymEncryptingKey.length * 8);
-    mbedtls_aes_context aesContext;
-    int mbedErr = mbedtls_aes_setkey_enc(&aesContext, cc->localSymEncryptingKey.data, keylength);
-    if(mbedErr)
-        return UA_STATUSCODE_BADINTERNALERROR;
-
-    UA_ByteString ivCopy;
-    UA_StatusCode retval = UA_ByteString_copy(&cc->localSymIv, &ivCopy);
-    if(retval != UA_STATUSCODE_GOOD)
-        return retval;
-
-    mbedErr = mbedtls_aes_crypt_cbc(&aesContext, MBEDTLS_AES_ENCRYPT, data->length,
-                                    ivCopy.data, data->data, data->data);
-    if(mbedErr)
-        retval = UA_STATUSCODE_BADINTERNALERROR;
-    UA_ByteString_clear(&ivCopy);
-    return retval;
+    return mbedtls_cbc_crypt(&cc->localSymEncryptingCtx, MBEDTLS_AES_ENCRYPT,
+                             &cc->localSymIv, data);
 }
 
 static UA_StatusCode
-sym_decrypt_sp_aes256sha256rsapss(const Aes256Sha256RsaPss_ChannelContext *cc,
+sym_decrypt_sp_aes256sha256rsapss(Aes256Sha256RsaPss_ChannelContext *cc,
                                    UA_ByteString *data) {
     if(cc == NULL || data == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
@@ -354,23 +337,8 @@ sym_decrypt_sp_aes256sha256rsapss(const Aes256Sha256RsaPss_ChannelContext *cc,
     if(data->length % encryptionBlockSize != 0)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    unsigned int keylength = (unsigned int)(cc->remoteSymEncryptingKey.length * 8);
-    mbedtls_aes_context aesContext;
-    int mbedErr = mbedtls_aes_setkey_dec(&aesContext, cc->remoteSymEncryptingKey.data, keylength);
-    if(mbedErr)
-        return UA_STATUSCODE_BADINTERNALERROR;
-
-    UA_ByteString ivCopy;
-    UA_StatusCode retval = UA_ByteString_copy(&cc->remoteSymIv, &ivCopy);
-    if(retval != UA_STATUSCODE_GOOD)
-        return retval;
-
-    mbedErr = mbedtls_aes_crypt_cbc(&aesContext, MBEDTLS_AES_DECRYPT, data->length,
-                                    ivCopy.data, data->data, data->data);
-    if(mbedErr)
-        retval = UA_STATUSCODE_BADINTERNALERROR;
-    UA_ByteString_clear(&ivCopy);
-    return retval;
+    return mbedtls_cbc_crypt(&cc->remoteSymEncryptingCtx, MBEDTLS_AES_DECRYPT,
+                             &cc->remoteSymIv, data);
 }
 
 static UA_StatusCode
@@ -523,12 +491,12 @@ parseRemoteCertificate_sp_aes256sha256rsapss(Aes256Sha256RsaPss_ChannelContext *
 
 static void
 channelContext_deleteContext_sp_aes256sha256rsapss(Aes256Sha256RsaPss_ChannelContext *cc) {
-    UA_ByteString_clear(&cc->localSymSigningKey);
-    UA_ByteString_clear(&cc->localSymEncryptingKey);
+    mbedtls_md_free(&cc->localSymSigningCtx);
+    mbedtls_aes_free(&cc->localSymEncryptingCtx);
     UA_ByteString_clear(&cc->localSymIv);
 
-    UA_ByteString_clear(&cc->remoteSymSigningKey);
-    UA_ByteString_clear(&cc->remoteSymEncryptingKey);
+    mbedtls_md_free(&cc->remoteSymSigningCtx);
+    mbedtls_aes_free(&cc->remoteSymEncryptingCtx);
     UA_ByteString_clear(&cc->remoteSymIv);
 
     mbedtls_x509_crt_free(&cc->remoteCertificate);
@@ -553,12 +521,12 @@ channelContext_newContext_sp_aes256sha256rsapss(const UA_SecurityPolicy *securit
     /* Initialize the channel context */
     cc->policyContext = (Aes256Sha256RsaPss_PolicyContext *)securityPolicy->policyContext;
 
-    UA_ByteString_init(&cc->localSymSigningKey);
-    UA_ByteString_init(&cc->localSymEncryptingKey);
+    mbedtls_md_init(&cc->localSymSigningCtx);
+    mbedtls_aes_init(&cc->localSymEncryptingCtx);
     UA_ByteString_init(&cc->localSymIv);
 
-    UA_ByteString_init(&cc->remoteSymSigningKey);
-    UA_ByteString_init(&cc->remoteSymEncryptingKey);
+    mbedtls_md_init(&cc->remoteSymSigningCtx);
+    mbedtls_aes_init(&cc->remoteSymEncryptingCtx);
     UA_ByteString_init(&cc->remoteSymIv);
 
     mbedtls_x509_crt_init(&cc->remoteCertificate);
@@ -578,8 +546,7 @@ channelContext_setLocalSymEncryptingKey_sp_aes256sha256rsapss(Aes256Sha256RsaPss
     if(key == NULL || cc == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    UA_ByteString_clear(&cc->localSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->localSymEncryptingKey);
+    return mbedtls_cbc_setKey(&cc->localSymEncryptingCtx, key, true);
 }
 
 static UA_StatusCode
@@ -588,8 +555,7 @@ channelContext_setLocalSymSigningKey_sp_aes256sha256rsapss(Aes256Sha256RsaPss_Ch
     if(key == NULL || cc == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    UA_ByteString_clear(&cc->localSymSigningKey);
-    return UA_ByteString_copy(key, &cc->localSymSigningKey);
+    return mbedtls_hmac_setKey(&cc->localSymSigningCtx, MBEDTLS_MD_SHA256, key);
 }
 
 
@@ -609,8 +575,7 @@ channelContext_setRemoteSymEncryptingKey_sp_aes256sha256rsapss(Aes256Sha256RsaPs
     if(key == NULL || cc == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    UA_ByteString_clear(&cc->remoteSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->remoteSymEncryptingKey);
+    return mbedtls_cbc_setKey(&cc->remoteSymEncryptingCtx, key, false);
 }
 
 static UA_StatusCode
@@ -619,8 +584,7 @@ channelContext_setRemoteSymSigningKey_sp_aes256sha256rsapss(Aes256Sha256RsaPss_C
     if(key == NULL || cc == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    UA_ByteString_clear(&cc->remoteSymSigningKey);
-    return UA_ByteString_copy(key, &cc->remoteSymSigningKey);
+    return mbedtls_hmac_setKey(&cc->remoteSymSigningCtx, MBEDTLS_MD_SHA256, key);
 }
 
 static UA_StatusCode
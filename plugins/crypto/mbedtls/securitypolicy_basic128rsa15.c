@@ -53,12 +53,12 @@ typedef struct {
 typedef struct {
     Basic128Rsa15_PolicyContext *policyContext;
 
-    UA_ByteString localSymSigningKey;
-    UA_ByteString localSymEncryptingKey;
+    mbedtls_md_context_t localSymSigningCtx;
+    mbedtls_aes_context localSymEncryptingCtx;
     UA_ByteString localSymIv;
 
-    UA_ByteString remoteSymSigningKey;
-    UA_ByteString remoteSymEncryptingKey;
+    mbedtls_md_context_t remoteSymSigningCtx;
+    mbedtls_aes_context remoteSymEncryptingCtx;
     UA_ByteString remoteSymIv;
 
     mbedtls_x509_crt remoteCertificate;
@@ -282,11 +282,8 @@ sym_verify_sp_basic128rsa15(Basic128Rsa15_ChannelContext *cc,
     if(signature->length != UA_SHA1_LENGTH)
         return UA_STATUSCODE_BADSECURITYCHECKSFAILED;
 
-    Basic128Rsa15_PolicyContext *pc = cc->policyContext;
-
     unsigned char mac[UA_SHA1_LENGTH];
-    if(mbedtls_hmac(&pc->sha1MdContext, &cc->remoteSymSigningKey,
-                    message, mac) != UA_STATUSCODE_GOOD)
+    if(mbedtls_hmac_keyed(&cc->remoteSymSigningCtx, message, mac) != UA_STATUSCODE_GOOD)
         return UA_STATUSCODE_BADSECURITYCHECKSFAILED;
 
     /* Compare with Signature */
@@ -296,14 +293,14 @@ sym_verify_sp_basic128rsa15(Basic128Rsa15_ChannelContext *cc,
 }
 
 static UA_StatusCode
-sym_sign_sp_basic128rsa15(const Basic128Rsa15_ChannelContext *cc,
+sym_sign_sp_basic128rsa15(Basic128Rsa15_ChannelContext *cc,
                           const UA_ByteString *message,
                           UA_ByteString *signature) {
     if(signature->length != UA_SHA1_LENGTH)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    if(mbedtls_hmac(&cc->policyContext->sha1MdContext, &cc->localSymSigningKey,
-                    message, signature->data) != UA_STATUSCODE_GOOD)
+    if(mbedtls_hmac_keyed(&cc->localSymSigningCtx, message,
+                          signature->data) != UA_STATUSCODE_GOOD)
         return UA_STATUSCODE_BADSECURITYCHECKSFAILED;
 
     return UA_STATUSCODE_GOOD;
@@ -335,7 +332,7 @@ sym_getPlainTextBlockSize_sp_basic128rsa15(const void *const channelContext) {
 }
 
 static UA_StatusCode
-sym_encrypt_sp_basic128rsa15(const Basic128Rsa15_ChannelContext *cc,
+sym_encrypt_sp_basic128rsa15(Basic128Rsa15_ChannelContext *cc,
                              UA_ByteString *data) {
     if(cc == NULL || data == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
@@ -347,28 +344,12 @@ sym_encrypt_sp_basic128rsa15(const Basic128Rsa15_ChannelContext *cc,
     if(data->length % plainTextBlockSize != 0)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    /* Keylength in bits */
-    unsigned int keylength = (unsigned int)(cc->localSymEncryptingKey.length * 8);
-    mbedtls_aes_context aesContext;
-    int mbedErr = mbedtls_aes_setkey_enc(&aesContext, cc->localSymEncryptingKey.data, keylength);
-    if(mbedErr)
-        return UA_STATUSCODE_BADINTERNALERROR;
-
-    UA_ByteString ivCopy;
-    UA_StatusCode retval = UA_ByteString_copy(&cc->localSymIv, &ivCopy);
-    if(retval != UA_STATUSCODE_GOOD)
-        return retval;
-
-    mbedErr = mbedtls_aes_crypt_cbc(&aesContext, MBEDTLS_AES_ENCRYPT, data->length,
-                                    ivCopy.data, data->data, data->data);
-    if(mbedErr)
-        retval = UA_STATUSCODE_BADINTERNALERROR;
-    UA_ByteString_clear(&ivCopy);
-    return retval;
+    return mbedtls_cbc_crypt(&cc->localSymEncryptingCtx, MBEDTLS_AES_ENCRYPT,
+                             &cc->localSymIv, data);
 }
 
 static UA_StatusCode
-sym_decrypt_sp_basic128rsa15(const Basic128Rsa15_ChannelContext *cc,
+sym_decrypt_sp_basic128rsa15(Basic128Rsa15_ChannelContext *cc,
                              UA_ByteString *data) {
     if(cc == NULL || data == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
@@ -380,24 +361,8 @@ sym_decrypt_sp_basic128rsa15(const Basic128Rsa15_ChannelContext *cc,
     if(data->length % encryptionBlockSize != 0)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    unsigned int keylength = (unsigned int)(cc->remoteSymEncryptingKey.length * 8);
-    mbedtls_aes_context aesContext;
-    int mbedErr = mbedtls_aes_setkey_dec(&aesContext,
-                                         cc->remoteSymEncryptingKey.data, keylength);
-    if(mbedErr)
-        return UA_STATUSCODE_BADINTERNALERROR;
-
-    UA_ByteString ivCopy;
-    UA_StatusCode retval = UA_ByteString_copy(&cc->remoteSymIv, &ivCopy);
-    if(retval != UA_STATUSCODE_GOOD)
-        return retval;
-
-    mbedErr = mbedtls_aes_crypt_cbc(&aesContext, MBEDTLS_AES_DECRYPT, data->length,
-                                    ivCopy.data, data->data, data->data);
-    if(mbedErr)
-        retval = UA_STATUSCODE_BADINTERNALERROR;
-    UA_ByteString_clear(&ivCopy);
-    return retval;
+    return mbedtls_cbc_crypt(&cc->remoteSymEncryptingCtx, MBEDTLS_AES_DECRYPT,
+                             &cc->remoteSymIv, data);
 }
 
 static UA_StatusCode
@@ -454,11 +419,11 @@ parseRemoteCertificate_sp_basic128rsa15(Basic128Rsa15_ChannelContext *cc,
 
 static void
 channelContext_deleteContext_sp_basic128rsa15(Basic128Rsa15_ChannelContext *cc) {
-    UA_ByteString_clear(&cc->localSymSigningKey);
-    UA_ByteString_clear(&cc->localSymEncryptingKey);
+    mbedtls_md_free(&cc->localSymSigningCtx);
+    mbedtls_aes_free(&cc->localSymEncryptingCtx);
     UA_ByteString_clear(&cc->localSymIv);
-    UA_ByteString_clear(&cc->remoteSymSigningKey);
-    UA_ByteString_clear(&cc->remoteSymEncryptingKey);
+    mbedtls_md_free(&cc->remoteSymSigningCtx);
+    mbedtls_aes_free(&cc->remoteSymEncryptingCtx);
     UA_ByteString_clear(&cc->remoteSymIv);
     mbedtls_x509_crt_free(&cc->remoteCertificate);
     UA_free(cc);
@@ -481,12 +446,12 @@ channelContext_newContext_sp_basic128rsa15(const UA_SecurityPolicy *securityPoli
     /* Initialize the channel context */
     cc->policyContext = (Basic128Rsa15_PolicyContext *)securityPolicy->policyContext;
 
-    UA_ByteString_init(&cc->localSymSigningKey);
-    UA_ByteString_init(&cc->localSymEncryptingKey);
+    mbedtls_md_init(&cc->localSymSigningCtx);
+    mbedtls_aes_init(&cc->localSymEncryptingCtx);
     UA_ByteString_init(&cc->localSymIv);
 
-    UA_ByteString_init(&cc->remoteSymSigningKey);
-    UA_ByteString_init(&cc->remoteSymEncryptingKey);
+    mbedtls_md_init(&cc->remoteSymSigningCtx);
+    mbedtls_aes_init(&cc->remoteSymEncryptingCtx);
     UA_ByteString_init(&cc->remoteSymIv);
 
     mbedtls_x509_crt_init(&cc->remoteCertificate);
@@ -506,8 +471,7 @@ channelContext_setLocalSymEncryptingKey_sp_basic128rsa15(Basic128Rsa15_ChannelCo
     if(key == NULL || cc == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    UA_ByteString_clear(&cc->localSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->localSymEncryptingKey);
+    return mbedtls_cbc_setKey(&cc->localSymEncryptingCtx, key, true);
 }
 
 static UA_StatusCode
@@ -516,8 +480,7 @@ channelContext_setLocalSymSigningKey_sp_basic128rsa15(Basic128Rsa15_ChannelConte
     if(key == NULL || cc == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    UA_ByteString_clear(&cc->localSymSigningKey);
-    return UA_ByteString_copy(key, &cc->localSymSigningKey);
+    return mbedtls_hmac_setKey(&cc->localSymSigningCtx, MBEDTLS_MD_SHA1, key);
 }
 
 
@@ -537,8 +500,7 @@ channelContext_setRemoteSymEncryptingKey_sp_basic128rsa15(Basic128Rsa15_ChannelC
     if(key == NULL || cc == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    UA_ByteString_clear(&cc->remoteSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->remoteSymEncryptingKey);
+    return mbedtls_cbc_setKey(&cc->remoteSymEncryptingCtx, key, false);
 }
 
 static UA_StatusCode
@@ -547,8 +509,7 @@ channelContext_setRemoteSymSigningKey_sp_basic128rsa15(Basic128Rsa15_ChannelCont
     if(key == NULL || cc == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    UA_ByteString_clear(&cc->remoteSymSigningKey);
-    return UA_ByteString_copy(key, &cc->remoteSymSigningKey);
+    return mbedtls_hmac_setKey(&cc->remoteSymSigningCtx, MBEDTLS_MD_SHA1, key);
 }
 
 static UA_StatusCode
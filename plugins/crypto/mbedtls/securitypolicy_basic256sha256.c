@@ -55,12 +55,12 @@ typedef struct {
 typedef struct {
     Basic256Sha256_PolicyContext *policyContext;
 
-    UA_ByteString localSymSigningKey;
-    UA_ByteString localSymEncryptingKey;
+    mbedtls_md_context_t localSymSigningCtx;
+    mbedtls_aes_context localSymEncryptingCtx;
     UA_ByteString localSymIv;
 
-    UA_ByteString remoteSymSigningKey;
-    UA_ByteString remoteSymEncryptingKey;
+    mbedtls_md_context_t remoteSymSigningCtx;
+    mbedtls_aes_context remoteSymEncryptingCtx;
     UA_ByteString remoteSymIv;
 
     mbedtls_x509_crt remoteCertificate;
@@ -263,9 +263,8 @@ sym_verify_sp_basic256sha256(Basic256Sha256_ChannelContext *cc,
     if(signature->length != UA_SHA256_LENGTH)
         return UA_STATUSCODE_BADSECURITYCHECKSFAILED;
 
-    Basic256Sha256_PolicyContext *pc = cc->policyContext;
     unsigned char mac[UA_SHA256_LENGTH];
-    if(mbedtls_hmac(&pc->sha256MdContext, &cc->remoteSymSigningKey, message, mac) != UA_STATUSCODE_GOOD)
+    if(mbedtls_hmac_keyed(&cc->remoteSymSigningCtx, message, mac) != UA_STATUSCODE_GOOD)
         return UA_STATUSCODE_BADSECURITYCHECKSFAILED;
 
     /* Compare with Signature */
@@ -275,14 +274,14 @@ sym_verify_sp_basic256sha256(Basic256Sha256_ChannelContext *cc,
 }
 
 static UA_StatusCode
-sym_sign_sp_basic256sha256(const Basic256Sha256_ChannelContext *cc,
+sym_sign_sp_basic256sha256(Basic256Sha256_ChannelContext *cc,
                            const UA_ByteString *message,
                            UA_ByteString *signature) {
     if(signature->length != UA_SHA256_LENGTH)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    if(mbedtls_hmac(&cc->policyContext->sha256MdContext, &cc->localSymSigningKey,
-                    message, signature->data) != UA_STATUSCODE_GOOD)
+    if(mbedtls_hmac_keyed(&cc->localSymSigningCtx, message,
+                          signature->data) != UA_STATUSCODE_GOOD)
         return UA_STATUSCODE_BADSECURITYCHECKSFAILED;
 
     return UA_STATUSCODE_GOOD;
@@ -314,7 +313,7 @@ sym_getPlainTextBlockSize_sp_basic256sha256(const void *channelContext) {
 }
 
 static UA_StatusCode
-sym_encrypt_sp_basic256sha256(const Basic256Sha256_ChannelContext *cc,
+sym_encrypt_sp_basic256sha256(Basic256Sha256_ChannelContext *cc,
                               UA_ByteString *data) {
     if(cc == NULL || data == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
@@ -327,28 +326,12 @@ sym_encrypt_sp_basic256sha256(const Basic256Sha256_ChannelContext *cc,
     if(data->length % plainTextBlockSize != 0)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    /* Keylength in bits */
-    unsigned int keylength = (unsigned int)(cc->localSymEncryptingKey.length * 8);
-    mbedtls_aes_context aesContext;
-    int mbedErr = mbedtls_aes_setkey_enc(&aesContext, cc->localSymEncryptingKey.data, keylength);
-    if(mbedErr)
-        return UA_STATUSCODE_BADINTERNALERROR;
-
-    UA_ByteString ivCopy;
-    UA_StatusCode retval = UA_ByteString_copy(&cc->localSymIv, &ivCopy);
-    if(retval != UA_STATUSCODE_GOOD)
-        return retval;
-
-    mbedErr = mbedtls_aes_crypt_cbc(&aesContext, MBEDTLS_AES_ENCRYPT, data->length,
-                                    ivCopy.data, data->data, data->data);
-    if(mbedErr)
-        retval = UA_STATUSCODE_BADINTERNALERROR;
-    UA_ByteString_clear(&ivCopy);
-    return retval;
+    return mbedtls_cbc_crypt(&cc->localSymEncryptingCtx, MBEDTLS_AES_ENCRYPT,
+                             &cc->localSymIv, data);
 }
 
 static UA_StatusCode
-sym_decrypt_sp_basic256sha256(const Basic256Sha256_ChannelContext *cc,
+sym_decrypt_sp_basic256sha256(Basic256Sha256_ChannelContext *cc,
                               UA_ByteString *data) {
     if(cc == NULL || data == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
@@ -360,23 +343,8 @@ sym_decrypt_sp_basic256sha256(const Basic256Sha256_ChannelContext *cc,
     if(data->length % encryptionBlockSize != 0)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    unsigned int keylength = (unsigned int)(cc->remoteSymEncryptingKey.length * 8);
-    mbedtls_aes_context aesContext;
-    int mbedErr = mbedtls_aes_setkey_dec(&aesContext, cc->remoteSymEncryptingKey.data, keylength);
-    if(mbedErr)
-        return UA_STATUSCODE_BADINTERNALERROR;
-
-    UA_ByteString ivCopy;
-    UA_StatusCode retval = UA_ByteString_copy(&cc->remoteSymIv, &ivCopy);
-    if(retval != UA_STATUSCODE_GOOD)
-        return retval;
-
-    mbedErr = mbedtls_aes_crypt_cbc(&aesContext, MBEDTLS_AES_DECRYPT, data->length,
-                                    ivCopy.data, data->data, data->data);
-    if(mbedErr)
-        retval = UA_STATUSCODE_BADINTERNALERROR;
-    UA_ByteString_clear(&ivCopy);
-    return retval;
+    return mbedtls_cbc_crypt(&cc->remoteSymEncryptingCtx, MBEDTLS_AES_DECRYPT,
+                             &cc->remoteSymIv, data);
 }
 
 static UA_StatusCode
@@ -432,12 +400,12 @@ parseRemoteCertificate_sp_basic256sha256(Basic256Sha256_ChannelContext *cc,
 
 static void
 channelContext_deleteContext_sp_basic256sha256(Basic256Sha256_ChannelContext *cc) {
-    UA_ByteString_clear(&cc->localSymSigningKey);
-    UA_ByteString_clear(&cc->localSymEncryptingKey);
+    mbedtls_md_free(&cc->localSymSigningCtx);
+    mbedtls_aes_free(&cc->localSymEncryptingCtx);
     UA_ByteString_clear(&cc->localSymIv);
 
-    UA_ByteString_clear(&cc->remoteSymSigningKey);
-    UA_ByteString_clear(&cc->remoteSymEncryptingKey);
+    mbedtls_md_free(&cc->remoteSymSigningCtx);
+    mbedtls_aes_free(&cc->remoteSymEncryptingCtx);
     UA_ByteString_clear(&cc->remoteSymIv);
 
     mbedtls_x509_crt_free(&cc->remoteCertificate);
@@ -462,12 +430,12 @@ channelContext_newContext_sp_basic256sha256(const UA_SecurityPolicy *securityPol
     /* Initialize the channel context */
     cc->policyContext = (Basic256Sha256_PolicyContext *)securityPolicy->policyContext;
 
-    UA_ByteString_init(&cc->localSymSigningKey);
-    UA_ByteString_init(&cc->localSymEncryptingKey);
+    mbedtls_md_init(&cc->localSymSigningCtx);
+    mbedtls_aes_init(&cc->localSymEncryptingCtx);
     UA_ByteString_init(&cc->localSymIv);
 
-    UA_ByteString_init(&cc->remoteSymSigningKey);
-    UA_ByteString_init(&cc->remoteSymEncryptingKey);
+    mbedtls_md_init(&cc->remoteSymSigningCtx);
+    mbedtls_aes_init(&cc->remoteSymEncryptingCtx);
     UA_ByteString_init(&cc->remoteSymIv);
 
     mbedtls_x509_crt_init(&cc->remoteCertificate);
@@ -487,8 +455,7 @@ channelContext_setLocalSymEncryptingKey_sp_basic256sha256(Basic256Sha256_Channel
     if(key == NULL || cc == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    UA_ByteString_clear(&cc->localSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->localSymEncryptingKey);
+    return mbedtls_cbc_setKey(&cc->localSymEncryptingCtx, key, true);
 }
 
 static UA_StatusCode
@@ -497,8 +464,7 @@ channelContext_setLocalSymSigningKey_sp_basic256sha256(Basic256Sha256_ChannelCon
     if(key == NULL || cc == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    UA_ByteString_clear(&cc->localSymSigningKey);
-    return UA_ByteString_copy(key, &cc->localSymSigningKey);
+    return mbedtls_hmac_setKey(&cc->localSymSigningCtx, MBEDTLS_MD_SHA256, key);
 }
 
 
@@ -518,8 +484,7 @@ channelContext_setRemoteSymEncryptingKey_sp_basic256sha256(Basic256Sha256_Channe
     if(key == NULL || cc == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    UA_ByteString_clear(&cc->remoteSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->remoteSymEncryptingKey);
+    return mbedtls_cbc_setKey(&cc->remoteSymEncryptingCtx, key, false);
 }
 
 static UA_StatusCode
@@ -528,8 +493,7 @@ channelContext_setRemoteSymSigningKey_sp_basic256sha256(Basic256Sha256_ChannelCo
     if(key == NULL || cc == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    UA_ByteString_clear(&cc->remoteSymSigningKey);
-    return UA_ByteString_copy(key, &cc->remoteSymSigningKey);
+    return mbedtls_hmac_setKey(&cc->remoteSymSigningCtx, MBEDTLS_MD_SHA256, key);
 }
 
 static UA_StatusCode
@@ -51,6 +51,66 @@ mbedtls_hmac(mbedtls_md_context_t *context, const UA_ByteString *key,
     return UA_STATUSCODE_GOOD;
 }
 
+UA_StatusCode
+mbedtls_hmac_setKey(mbedtls_md_context_t *context, mbedtls_md_type_t mdType,
+                    const UA_ByteString *key) {
+    /* Drop the pads of the previous key */
+    mbedtls_md_free(context);
+    mbedtls_md_init(context);
+
+    const mbedtls_md_info_t *mdInfo = mbedtls_md_info_from_type(mdType);
+    if(!mdInfo || mbedtls_md_setup(context, mdInfo, 1) != 0)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    if(mbedtls_md_hmac_starts(context, key->data, key->length) != 0)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+mbedtls_hmac_keyed(mbedtls_md_context_t *context, const UA_ByteString *in,
+                   unsigned char *out) {
+    if(mbedtls_md_hmac_reset(context) != 0)
+        return UA_STATUSCODE_BADSECURITYCHECKSFAILED;
+
+    if(mbedtls_md_hmac_update(context, in->data, in->length) != 0)
+        return UA_STATUSCODE_BADSECURITYCHECKSFAILED;
+
+    if(mbedtls_md_hmac_finish(context, out) != 0)
+        return UA_STATUSCODE_BADSECURITYCHECKSFAILED;
+
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+mbedtls_cbc_setKey(mbedtls_aes_context *context, const UA_ByteString *key,
+                   UA_Boolean encrypt) {
+    /* Keylength in bits */
+    unsigned int keylength = (unsigned int)(key->length * 8);
+    int mbedErr = (encrypt) ?
+        mbedtls_aes_setkey_enc(context, key->data, keylength) :
+        mbedtls_aes_setkey_dec(context, key->data, keylength);
+    if(mbedErr)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+mbedtls_cbc_crypt(mbedtls_aes_context *context, int mode,
+                  const UA_ByteString *iv, UA_ByteString *data) {
+    /* The IV is updated by mbedtls_aes_crypt_cbc. Keep the channel IV intact. */
+    unsigned char ivCopy[16];
+    if(iv->length != sizeof(ivCopy))
+        return UA_STATUSCODE_BADINTERNALERROR;
+    memcpy(ivCopy, iv->data, sizeof(ivCopy));
+
+    int mbedErr = mbedtls_aes_crypt_cbc(context, mode, data->length,
+                                        ivCopy, data->data, data->data);
+    if(mbedErr)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    return UA_STATUSCODE_GOOD;
+}
+
 UA_StatusCode
 mbedtls_generateKey(mbedtls_md_context_t *context,
                     const UA_ByteString *secret, const UA_ByteString *seed,
@@ -11,6 +11,7 @@
 
 #if defined(UA_ENABLE_ENCRYPTION_MBEDTLS)
 
+#include <mbedtls/aes.h>
 #include <mbedtls/md.h>
 #include <mbedtls/version.h>
 #include <mbedtls/x509_crt.h>
@@ -55,6 +56,27 @@ UA_StatusCode
 mbedtls_hmac(mbedtls_md_context_t *context, const UA_ByteString *key,
              const UA_ByteString *in, unsigned char *out);
 
+/* The symmetric contexts are keyed once when the channel installs a new key
+ * (initial handshake and every token renewal). Per message, the HMAC is reset
+ * to the stored inner/outer pads and CBC runs in place on a stack copy of the
+ * IV. AES-NI and the ARMv8 crypto extensions are picked up by mbedtls_aes_*
+ * when they are enabled in the mbedTLS configuration. */
+UA_StatusCode
+mbedtls_hmac_setKey(mbedtls_md_context_t *context, mbedtls_md_type_t mdType,
+                    const UA_ByteString *key);
+
+UA_StatusCode
+mbedtls_hmac_keyed(mbedtls_md_context_t *context, const UA_ByteString *in,
+                   unsigned char *out);
+
+UA_StatusCode
+mbedtls_cbc_setKey(mbedtls_aes_context *context, const UA_ByteString *key,
+                   UA_Boolean encrypt);
+
+UA_StatusCode
+mbedtls_cbc_crypt(mbedtls_aes_context *context, int mode,
+                  const UA_ByteString *iv, UA_ByteString *data);
+
 UA_StatusCode
 mbedtls_generateKey(mbedtls_md_context_t *context,
                     const UA_ByteString *secret, const UA_ByteString *seed,
@@ -23,9 +23,11 @@
 
 /* Configuration parameters */
 
-#define MEMORYCERTSTORE_PARAMETERSSIZE 2
+#define MEMORYCERTSTORE_PARAMETERSSIZE 4
 #define MEMORYCERTSTORE_PARAMINDEX_MAXTRUSTLISTSIZE 0
 #define MEMORYCERTSTORE_PARAMINDEX_MAXREJECTEDLISTSIZE 1
+#define MEMORYCERTSTORE_PARAMINDEX_VERIFYCACHESIZE 2
+#define MEMORYCERTSTORE_PARAMINDEX_VERIFYCACHETTL 3
 
 static const struct {
     UA_QualifiedName name;
@@ -33,9 +35,20 @@ static const struct {
     UA_Boolean required;
 } MemoryCertStoreParameters[MEMORYCERTSTORE_PARAMETERSSIZE] = {
     {{0, UA_STRING_STATIC("maxTrustListSize")}, &UA_TYPES[UA_TYPES_UINT16], false},
-    {{0, UA_STRING_STATIC("maxRejectedListSize")}, &UA_TYPES[UA_TYPES_STRING], false}
+    {{0, UA_STRING_STATIC("maxRejectedListSize")}, &UA_TYPES[UA_TYPES_STRING], false},
+    {{0, UA_STRING_STATIC("verifyCacheSize")}, &UA_TYPES[UA_TYPES_UINT32], false},
+    {{0, UA_STRING_STATIC("verifyCacheTtl")}, &UA_TYPES[UA_TYPES_UINT32], false}
 };
 
+/* Result of a recent verification. The entries are ordered from the most to
+ * the least recently used. */
+typedef struct {
+    UA_UInt32 hash;
+    UA_StatusCode result;
+    UA_DateTime expires; /* Monotonic time */
+    UA_ByteString certificate;
+} VerifyCacheEntry;
+
 struct MemoryCertStore;
 typedef struct MemoryCertStore MemoryCertStore;
 
@@ -52,8 +65,72 @@ struct MemoryCertStore {
     STACK_OF(X509) *trustedCertificates;
     STACK_OF(X509) *issuerCertificates;
     STACK_OF(X509_CRL) *crls;
+
+    /* The trusted certificates are also kept in an X509_STORE. The store is
+     * indexed by the subject name. So the issuer lookup during the chain
+     * building does not scan the entire trust list. */
+    X509_STORE *trustedStore;
+
+    /* Results of recent verifications. Cleared when the trust list changes. */
+    UA_UInt32 verifyCacheSize;
+    UA_DateTime verifyCacheTtl;
+    size_t verifyCacheUsed;
+    VerifyCacheEntry *verifyCache;
 };
 
+static void
+clearVerifyCache(MemoryCertStore *context) {
+    for(size_t i = 0; i < context->verifyCacheUsed; i++)
+        UA_ByteString_clear(&context->verifyCache[i].certificate);
+    context->verifyCacheUsed = 0;
+}
+
+/* Look up a recent result. A hit is moved to the front. */
+static UA_Boolean
+lookupVerifyCache(MemoryCertStore *context, const UA_ByteString *certificate,
+                  UA_UInt32 hash, UA_DateTime now, UA_StatusCode *result) {
+    for(size_t i = 0; i < context->verifyCacheUsed; i++) {
+        VerifyCacheEntry *e = &context->verifyCache[i];
+        if(e->hash != hash || !UA_ByteString_equal(&e->certificate, certificate))
+            continue;
+        if(e->expires <= now) {
+            /* Expired. Remove the entry. */
+            UA_ByteString_clear(&e->certificate);
+            memmove(e, e + 1, (context->verifyCacheUsed - i - 1) * sizeof(VerifyCacheEntry));
+            context->verifyCacheUsed--;
+            return false;
+        }
+        *result = e->result;
+        VerifyCacheEntry tmp = *e;
+        memmove(&context->verifyCache[1], &context->verifyCache[0], i * sizeof(VerifyCacheEntry));
+        context->verifyCache[0] = tmp;
+        return true;
+    }
+    return false;
+}
+
+/* Add a result at the front. The least recently used entry is dropped if the
+ * cache is full. */
+static void
+addVerifyCache(MemoryCertStore *context, const UA_ByteString *certificate,
+               UA_UInt32 hash, UA_DateTime now, UA_StatusCode result) {
+    UA_ByteString copy;
+    if(UA_ByteString_copy(certificate, &copy) != UA_STATUSCODE_GOOD)
+        return;
+    if(context->verifyCacheUsed == context->verifyCacheSize) {
+        context->verifyCacheUsed--;
+        UA_ByteString_clear(&context->verifyCache[context->verifyCacheUsed].certificate);
+    }
+    memmove(&context->verifyCache[1], &context->verifyCache[0],
+            context->verifyCacheUsed * sizeof(VerifyCacheEntry));
+    VerifyCacheEntry *e = &context->verifyCache[0];
+    e->hash = hash;
+    e->result = result;
+    e->expires = now + context->verifyCacheTtl;
+    e->certificate = copy;
+    context->verifyCacheUsed++;
+}
+
 static UA_StatusCode
 MemoryCertStore_removeFromTrustList(UA_CertificateGroup *certGroup, const UA_TrustListDataType *trustList) {
     /* Check parameter */
@@ -172,6 +249,11 @@ MemoryCertStore_clear(UA_CertificateGroup *certGroup) {
         sk_X509_pop_free (context->trustedCertificates, X509_free);
         sk_X509_pop_free (context->issuerCertificates, X509_free);
         sk_X509_CRL_pop_free (context->crls, X509_CRL_free);
+        if(context->trustedStore)
+            X509_STORE_free(context->trustedStore);
+
+        clearVerifyCache(context);
+        UA_free(context->verifyCache);
 
         UA_free(context);
         certGroup->context = NULL;
@@ -187,6 +269,17 @@ reloadCertificates(UA_CertificateGroup *certGroup) {
 
     MemoryCertStore *context = (MemoryCertStore *)certGroup->context;
 
+    /* Previous results are no longer valid */
+    clearVerifyCache(context);
+
+    if(context->trustedStore)
+        X509_STORE_free(context->trustedStore);
+    context->trustedStore = X509_STORE_new();
+    if(context->trustedStore == NULL) {
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    X509_STORE_set_flags(context->trustedStore, 0);
+
     sk_X509_pop_free(context->trustedCertificates, X509_free);
     context->trustedCertificates = sk_X509_new_null();
     if(context->trustedCertificates == NULL) {
@@ -197,6 +290,8 @@ reloadCertificates(UA_CertificateGroup *certGroup) {
         if(cert == NULL)
             return UA_STATUSCODE_BADINTERNALERROR;
         sk_X509_push(context->trustedCertificates, cert);
+        /* Takes its own reference. Duplicates are ignored. */
+        X509_STORE_add_cert(context->trustedStore, cert);
     }
 
     sk_X509_pop_free(context->issuerCertificates, X509_free);
@@ -322,7 +417,7 @@ verifyCertificate(UA_CertificateGroup *certGroup, const UA_ByteString *certifica
     }
 
     X509_STORE_CTX *storeCtx = NULL;
-    X509_STORE *store = NULL;
+    X509_STORE *store = context->trustedStore;
     UA_StatusCode ret = UA_STATUSCODE_GOOD;
 
     /* Parse the certificate */
@@ -332,25 +427,19 @@ verifyCertificate(UA_CertificateGroup *certGroup, const UA_ByteString *certifica
         goto cleanup;
     }
 
-    store = X509_STORE_new();
     storeCtx = X509_STORE_CTX_new();
     if(store == NULL || storeCtx == NULL) {
         ret = UA_STATUSCODE_BADOUTOFMEMORY;
         goto cleanup;
     }
 
-    X509_STORE_set_flags(store, 0);
+    /* The trusted certificates are looked up in the (indexed) store */
     int opensslRet = X509_STORE_CTX_init(storeCtx, store, certificateX509,
                                          context->issuerCertificates);
     if(opensslRet != 1) {
         ret = UA_STATUSCODE_BADINTERNALERROR;
         goto cleanup;
     }
-#if defined(OPENSSL_API_COMPAT) && OPENSSL_API_COMPAT < 0x10100000L
-    (void) X509_STORE_CTX_trusted_stack(storeCtx, context->trustedCertificates);
-#else
-    (void) X509_STORE_CTX_set0_trusted_stack(storeCtx, context->trustedCertificates);
-#endif
 
     /* Set crls to ctx */
     if(sk_X509_CRL_num(context->crls) > 0) {
@@ -390,12 +479,8 @@ verifyCertificate(UA_CertificateGroup *certGroup, const UA_ByteString *certifica
             storeCtx = X509_STORE_CTX_new();
 
             /* Sets up X509_STORE_CTX structure for a subsequent verification operation */
-            X509_STORE_set_flags(store, 0);
             X509_STORE_CTX_init(storeCtx, store, certificateX509, context->issuerCertificates);
 
-            /* Set trust list to ctx */
-            (void) X509_STORE_CTX_trusted_stack(storeCtx, context->trustedCertificates);
-
             /* Set crls to ctx */
             X509_STORE_CTX_set0_crls(storeCtx, context->crls);
 
@@ -449,8 +534,6 @@ verifyCertificate(UA_CertificateGroup *certGroup, const UA_ByteString *certifica
     }
 
 cleanup:
-    if(store)
-        X509_STORE_free(store);
     if(storeCtx)
         X509_STORE_CTX_free(storeCtx);
     if(certificateX509)
@@ -466,7 +549,28 @@ MemoryCertStore_verifyCertificate(UA_CertificateGroup *certGroup,
         return UA_STATUSCODE_BADINVALIDARGUMENT;
     }
 
-    UA_StatusCode retval = verifyCertificate(certGroup, certificate);
+    /* Use a recent result for the certificate. Unless the trust list has
+     * changed in the meantime. */
+    MemoryCertStore *context = (MemoryCertStore *)certGroup->context;
+    UA_StatusCode retval = UA_STATUSCODE_GOOD;
+    UA_Boolean cached = false;
+    UA_UInt32 hash = 0;
+    UA_DateTime now = 0;
+    UA_Boolean useCache = (context && context->verifyCacheSize > 0);
+    if(useCache) {
+        hash = UA_ByteString_hash(0, certificate->data, certificate->length);
+        now = UA_DateTime_nowMonotonic();
+        if(!context->reloadRequired)
+            cached = lookupVerifyCache(context, certificate, hash, now, &retval);
+    }
+
+    if(!cached) {
+        retval = verifyCertificate(certGroup, certificate);
+        if(useCache && retval != UA_STATUSCODE_BADINTERNALERROR &&
+           retval != UA_STATUSCODE_BADOUTOFMEMORY)
+            addVerifyCache(context, certificate, hash, now, retval);
+    }
+
     if(retval == UA_STATUSCODE_BADCERTIFICATEUNTRUSTED ||
         retval == UA_STATUSCODE_BADCERTIFICATEUSENOTALLOWED ||
         retval == UA_STATUSCODE_BADCERTIFICATEREVOCATIONUNKNOWN ||
@@ -517,6 +621,7 @@ UA_CertificateGroup_Memorystore(UA_CertificateGroup *certGroup,
     /* Default values */
     context->maxTrustListSize = 65535;
     context->maxRejectedListSize = 100;
+    context->verifyCacheTtl = 60 * UA_DATETIME_SEC;
 
     if(params) {
         const UA_UInt32 *maxTrustListSize = (const UA_UInt32*)
@@ -534,6 +639,30 @@ UA_CertificateGroup_Memorystore(UA_CertificateGroup *certGroup,
         if(maxRejectedListSize) {
             context->maxRejectedListSize = *maxRejectedListSize;
         }
+
+        const UA_UInt32 *verifyCacheSize = (const UA_UInt32*)
+        UA_KeyValueMap_getScalar(params, MemoryCertStoreParameters[MEMORYCERTSTORE_PARAMINDEX_VERIFYCACHESIZE].name,
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+
+        const UA_UInt32 *verifyCacheTtl = (const UA_UInt32*)
+        UA_KeyValueMap_getScalar(params, MemoryCertStoreParameters[MEMORYCERTSTORE_PARAMINDEX_VERIFYCACHETTL].name,
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+
+        if(verifyCacheSize) {
+            context->verifyCacheSize = *verifyCacheSize;
+        }
+
+        if(verifyCacheTtl) {
+            context->verifyCacheTtl = (UA_DateTime)*verifyCacheTtl * UA_DATETIME_MSEC;
+        }
+    }
+
+    /* Without the memory for the cache, every certificate is verified */
+    if(context->verifyCacheSize > 0) {
+        context->verifyCache = (VerifyCacheEntry*)
+            UA_calloc(context->verifyCacheSize, sizeof(VerifyCacheEntry));
+        if(!context->verifyCache)
+            context->verifyCacheSize = 0;
     }
 
     UA_TrustListDataType_add(trustList, &context->trustList);
@@ -36,11 +36,11 @@ typedef struct {
 } Policy_Context_Aes128Sha256RsaOaep;
 
 typedef struct {
-    UA_ByteString localSymSigningKey;
-    UA_ByteString localSymEncryptingKey;
+    UA_OpenSSL_HMAC_CTX *localSymSigningCtx;
+    EVP_CIPHER_CTX *localSymEncryptingCtx;
     UA_ByteString localSymIv;
-    UA_ByteString remoteSymSigningKey;
-    UA_ByteString remoteSymEncryptingKey;
+    UA_OpenSSL_HMAC_CTX *remoteSymSigningCtx;
+    EVP_CIPHER_CTX *remoteSymEncryptingCtx;
     UA_ByteString remoteSymIv;
 
     Policy_Context_Aes128Sha256RsaOaep *policyContext;
@@ -209,11 +209,11 @@ UA_ChannelModule_Aes128Sha256RsaOaep_New_Context(const UA_SecurityPolicy *securi
         return UA_STATUSCODE_BADOUTOFMEMORY;
     }
 
-    UA_ByteString_init(&context->localSymSigningKey);
-    UA_ByteString_init(&context->localSymEncryptingKey);
+    context->localSymSigningCtx = NULL;
+    context->localSymEncryptingCtx = NULL;
     UA_ByteString_init(&context->localSymIv);
-    UA_ByteString_init(&context->remoteSymSigningKey);
-    UA_ByteString_init(&context->remoteSymEncryptingKey);
+    context->remoteSymSigningCtx = NULL;
+    context->remoteSymEncryptingCtx = NULL;
     UA_ByteString_init(&context->remoteSymIv);
 
     UA_StatusCode retval =
@@ -252,11 +252,11 @@ UA_ChannelModule_Aes128Sha256RsaOaep_Delete_Context(void *channelContext) {
             (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
         X509_free(cc->remoteCertificateX509);
         UA_ByteString_clear(&cc->remoteCertificate);
-        UA_ByteString_clear(&cc->localSymSigningKey);
-        UA_ByteString_clear(&cc->localSymEncryptingKey);
+        UA_OpenSSL_HMAC_free(cc->localSymSigningCtx);
+        EVP_CIPHER_CTX_free(cc->localSymEncryptingCtx);
         UA_ByteString_clear(&cc->localSymIv);
-        UA_ByteString_clear(&cc->remoteSymSigningKey);
-        UA_ByteString_clear(&cc->remoteSymEncryptingKey);
+        UA_OpenSSL_HMAC_free(cc->remoteSymSigningCtx);
+        EVP_CIPHER_CTX_free(cc->remoteSymEncryptingCtx);
         UA_ByteString_clear(&cc->remoteSymIv);
 
         UA_LOG_INFO(
@@ -416,8 +416,7 @@ UA_ChannelModule_Aes128Sha256RsaOaep_setLocalSymSigningKey(void *channelContext,
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
-    UA_ByteString_clear(&cc->localSymSigningKey);
-    return UA_ByteString_copy(key, &cc->localSymSigningKey);
+    return UA_OpenSSL_HMAC_setKey(&cc->localSymSigningCtx, EVP_sha256(), key);
 }
 
 static UA_StatusCode
@@ -427,8 +426,7 @@ UA_ChannelM_Aes128Sha256RsaOaep_setLocalSymEncryptingKey(void *channelContext,
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
-    UA_ByteString_clear(&cc->localSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->localSymEncryptingKey);
+    return UA_OpenSSL_Cipher_setKey(&cc->localSymEncryptingCtx, EVP_aes_128_cbc(), key, true);
 }
 
 static UA_StatusCode
@@ -466,8 +464,7 @@ UA_ChannelM_Aes128Sha256RsaOaep_setRemoteSymSigningKey(void *channelContext,
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
-    UA_ByteString_clear(&cc->remoteSymSigningKey);
-    return UA_ByteString_copy(key, &cc->remoteSymSigningKey);
+    return UA_OpenSSL_HMAC_setKey(&cc->remoteSymSigningCtx, EVP_sha256(), key);
 }
 
 static UA_StatusCode
@@ -477,8 +474,7 @@ UA_ChannelM_Aes128Sha256RsaOaep_setRemoteSymEncryptingKey(void *channelContext,
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
-    UA_ByteString_clear(&cc->remoteSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->remoteSymEncryptingKey);
+    return UA_OpenSSL_Cipher_setKey(&cc->remoteSymEncryptingCtx, EVP_aes_128_cbc(), key, false);
 }
 
 static UA_StatusCode
@@ -527,7 +523,7 @@ UA_SymSig_Aes128Sha256RsaOaep_verify(void *channelContext, const UA_ByteString *
 
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
-    return UA_OpenSSL_HMAC_SHA256_Verify(message, &cc->remoteSymSigningKey, signature);
+    return UA_OpenSSL_HMAC_verify(cc->remoteSymSigningCtx, message, signature);
 }
 
 static UA_StatusCode
@@ -539,7 +535,7 @@ UA_SymSig_Aes128Sha256RsaOaep_sign(void *channelContext, const UA_ByteString *me
 
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
-    return UA_OpenSSL_HMAC_SHA256_Sign(message, &cc->localSymSigningKey, signature);
+    return UA_OpenSSL_HMAC_sign(cc->localSymSigningCtx, message, signature);
 }
 
 static size_t
@@ -553,8 +549,7 @@ UA_SymEn_Aes128Sha256RsaOaep_decrypt(void *channelContext, UA_ByteString *data)
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
-    return UA_OpenSSL_AES_128_CBC_Decrypt(&cc->remoteSymIv, &cc->remoteSymEncryptingKey,
-                                          data);
+    return UA_OpenSSL_Cipher_decrypt(cc->remoteSymEncryptingCtx, &cc->remoteSymIv, data);
 }
 
 static UA_StatusCode
@@ -564,8 +559,7 @@ UA_SymEn_Aes128Sha256RsaOaep_encrypt(void *channelContext, UA_ByteString *data)
 
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
-    return UA_OpenSSL_AES_128_CBC_Encrypt(&cc->localSymIv, &cc->localSymEncryptingKey,
-                                          data);
+    return UA_OpenSSL_Cipher_encrypt(cc->localSymEncryptingCtx, &cc->localSymIv, data);
 }
 
 static UA_StatusCode
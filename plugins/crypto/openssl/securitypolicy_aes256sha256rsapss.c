@@ -36,11 +36,11 @@ typedef struct {
 } Policy_Context_Aes256Sha256RsaPss;
 
 typedef struct {
-    UA_ByteString localSymSigningKey;
-    UA_ByteString localSymEncryptingKey;
+    UA_OpenSSL_HMAC_CTX *localSymSigningCtx;
+    EVP_CIPHER_CTX *localSymEncryptingCtx;
     UA_ByteString localSymIv;
-    UA_ByteString remoteSymSigningKey;
-    UA_ByteString remoteSymEncryptingKey;
+    UA_OpenSSL_HMAC_CTX *remoteSymSigningCtx;
+    EVP_CIPHER_CTX *remoteSymEncryptingCtx;
     UA_ByteString remoteSymIv;
 
     Policy_Context_Aes256Sha256RsaPss *policyContext;
@@ -206,11 +206,11 @@ UA_ChannelModule_Aes256Sha256RsaPss_New_Context(const UA_SecurityPolicy *securit
         return UA_STATUSCODE_BADOUTOFMEMORY;
     }
 
-    UA_ByteString_init(&context->localSymSigningKey);
-    UA_ByteString_init(&context->localSymEncryptingKey);
+    context->localSymSigningCtx = NULL;
+    context->localSymEncryptingCtx = NULL;
     UA_ByteString_init(&context->localSymIv);
-    UA_ByteString_init(&context->remoteSymSigningKey);
-    UA_ByteString_init(&context->remoteSymEncryptingKey);
+    context->remoteSymSigningCtx = NULL;
+    context->remoteSymEncryptingCtx = NULL;
     UA_ByteString_init(&context->remoteSymIv);
 
     UA_StatusCode retval =
@@ -249,11 +249,11 @@ UA_ChannelModule_Aes256Sha256RsaPss_Delete_Context(void *channelContext) {
             (Channel_Context_Aes256Sha256RsaPss *)channelContext;
         X509_free(cc->remoteCertificateX509);
         UA_ByteString_clear(&cc->remoteCertificate);
-        UA_ByteString_clear(&cc->localSymSigningKey);
-        UA_ByteString_clear(&cc->localSymEncryptingKey);
+        UA_OpenSSL_HMAC_free(cc->localSymSigningCtx);
+        EVP_CIPHER_CTX_free(cc->localSymEncryptingCtx);
         UA_ByteString_clear(&cc->localSymIv);
-        UA_ByteString_clear(&cc->remoteSymSigningKey);
-        UA_ByteString_clear(&cc->remoteSymEncryptingKey);
+        UA_OpenSSL_HMAC_free(cc->remoteSymSigningCtx);
+        EVP_CIPHER_CTX_free(cc->remoteSymEncryptingCtx);
         UA_ByteString_clear(&cc->remoteSymIv);
 
         UA_LOG_INFO(
@@ -462,8 +462,7 @@ UA_ChannelModule_Aes256Sha256RsaPss_setLocalSymSigningKey(void *channelContext,
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Aes256Sha256RsaPss *cc =
         (Channel_Context_Aes256Sha256RsaPss *)channelContext;
-    UA_ByteString_clear(&cc->localSymSigningKey);
-    return UA_ByteString_copy(key, &cc->localSymSigningKey);
+    return UA_OpenSSL_HMAC_setKey(&cc->localSymSigningCtx, EVP_sha256(), key);
 }
 
 static UA_StatusCode
@@ -473,8 +472,7 @@ UA_ChannelM_Aes256Sha256RsaPss_setLocalSymEncryptingKey(void *channelContext,
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Aes256Sha256RsaPss *cc =
         (Channel_Context_Aes256Sha256RsaPss *)channelContext;
-    UA_ByteString_clear(&cc->localSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->localSymEncryptingKey);
+    return UA_OpenSSL_Cipher_setKey(&cc->localSymEncryptingCtx, EVP_aes_256_cbc(), key, true);
 }
 
 static UA_StatusCode
@@ -512,8 +510,7 @@ UA_ChannelM_Aes256Sha256RsaPss_setRemoteSymSigningKey(void *channelContext,
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Aes256Sha256RsaPss *cc =
         (Channel_Context_Aes256Sha256RsaPss *)channelContext;
-    UA_ByteString_clear(&cc->remoteSymSigningKey);
-    return UA_ByteString_copy(key, &cc->remoteSymSigningKey);
+    return UA_OpenSSL_HMAC_setKey(&cc->remoteSymSigningCtx, EVP_sha256(), key);
 }
 
 static UA_StatusCode
@@ -523,8 +520,7 @@ UA_ChannelM_Aes256Sha256RsaPss_setRemoteSymEncryptingKey(void *channelContext,
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Aes256Sha256RsaPss *cc =
         (Channel_Context_Aes256Sha256RsaPss *)channelContext;
-    UA_ByteString_clear(&cc->remoteSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->remoteSymEncryptingKey);
+    return UA_OpenSSL_Cipher_setKey(&cc->remoteSymEncryptingCtx, EVP_aes_256_cbc(), key, false);
 }
 
 static UA_StatusCode
@@ -575,7 +571,7 @@ UA_SymSig_Aes256Sha256RsaPss_verify(void *channelContext, const UA_ByteString *m
 
     Channel_Context_Aes256Sha256RsaPss *cc =
         (Channel_Context_Aes256Sha256RsaPss *)channelContext;
-    return UA_OpenSSL_HMAC_SHA256_Verify(message, &cc->remoteSymSigningKey, signature);
+    return UA_OpenSSL_HMAC_verify(cc->remoteSymSigningCtx, message, signature);
 }
 
 static UA_StatusCode
@@ -587,7 +583,7 @@ UA_SymSig_Aes256Sha256RsaPss_sign(void *channelContext, const UA_ByteString *mes
 
     Channel_Context_Aes256Sha256RsaPss *cc =
         (Channel_Context_Aes256Sha256RsaPss *)channelContext;
-    return UA_OpenSSL_HMAC_SHA256_Sign(message, &cc->localSymSigningKey, signature);
+    return UA_OpenSSL_HMAC_sign(cc->localSymSigningCtx, message, signature);
 }
 
 static size_t
@@ -601,8 +597,7 @@ UA_SymEn_Aes256Sha256RsaPss_decrypt(void *channelContext, UA_ByteString *data) {
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Aes256Sha256RsaPss *cc =
         (Channel_Context_Aes256Sha256RsaPss *)channelContext;
-    return UA_OpenSSL_AES_256_CBC_Decrypt(&cc->remoteSymIv, &cc->remoteSymEncryptingKey,
-                                          data);
+    return UA_OpenSSL_Cipher_decrypt(cc->remoteSymEncryptingCtx, &cc->remoteSymIv, data);
 }
 
 static UA_StatusCode
@@ -612,8 +607,7 @@ UA_SymEn_Aes256Sha256RsaPss_encrypt(void *channelContext, UA_ByteString *data) {
 
     Channel_Context_Aes256Sha256RsaPss *cc =
         (Channel_Context_Aes256Sha256RsaPss *)channelContext;
-    return UA_OpenSSL_AES_256_CBC_Encrypt(&cc->localSymIv, &cc->localSymEncryptingKey,
-                                          data);
+    return UA_OpenSSL_Cipher_encrypt(cc->localSymEncryptingCtx, &cc->localSymIv, data);
 }
 
 static UA_StatusCode
@@ -30,11 +30,11 @@ typedef struct {
 } Policy_Context_Basic256;
 
 typedef struct {
-    UA_ByteString             localSymSigningKey;
-    UA_ByteString             localSymEncryptingKey;
+    UA_OpenSSL_HMAC_CTX *     localSymSigningCtx;
+    EVP_CIPHER_CTX *          localSymEncryptingCtx;
     UA_ByteString             localSymIv;
-    UA_ByteString             remoteSymSigningKey;
-    UA_ByteString             remoteSymEncryptingKey;
+    UA_OpenSSL_HMAC_CTX *     remoteSymSigningCtx;
+    EVP_CIPHER_CTX *          remoteSymEncryptingCtx;
     UA_ByteString             remoteSymIv;
 
     Policy_Context_Basic256 * policyContext;
@@ -199,11 +199,11 @@ UA_ChannelModule_Basic256_New_Context (const UA_SecurityPolicy * securityPolicy,
         return UA_STATUSCODE_BADOUTOFMEMORY;
     }
 
-    UA_ByteString_init(&context->localSymSigningKey);
-    UA_ByteString_init(&context->localSymEncryptingKey);
+    context->localSymSigningCtx = NULL;
+    context->localSymEncryptingCtx = NULL;
     UA_ByteString_init(&context->localSymIv);
-    UA_ByteString_init(&context->remoteSymSigningKey);
-    UA_ByteString_init(&context->remoteSymEncryptingKey);
+    context->remoteSymSigningCtx = NULL;
+    context->remoteSymEncryptingCtx = NULL;
     UA_ByteString_init(&context->remoteSymIv);
 
     UA_StatusCode retval = UA_copyCertificate (&context->remoteCertificate,
@@ -242,11 +242,11 @@ UA_ChannelModule_Basic256_Delete_Context (void * channelContext) {
                                            channelContext;
         X509_free (cc->remoteCertificateX509);
         UA_ByteString_clear (&cc->remoteCertificate);
-        UA_ByteString_clear (&cc->localSymSigningKey);
-        UA_ByteString_clear (&cc->localSymEncryptingKey);
+        UA_OpenSSL_HMAC_free (cc->localSymSigningCtx);
+        EVP_CIPHER_CTX_free (cc->localSymEncryptingCtx);
         UA_ByteString_clear (&cc->localSymIv);
-        UA_ByteString_clear (&cc->remoteSymSigningKey);
-        UA_ByteString_clear (&cc->remoteSymEncryptingKey);
+        UA_OpenSSL_HMAC_free (cc->remoteSymSigningCtx);
+        EVP_CIPHER_CTX_free (cc->remoteSymEncryptingCtx);
         UA_ByteString_clear (&cc->remoteSymIv);
         UA_LOG_INFO (cc->policyContext->logger,
                  UA_LOGCATEGORY_SECURITYPOLICY,
@@ -292,8 +292,7 @@ UA_ChannelModule_Basic256_setLocalSymSigningKey (void *                channelCo
     }
 
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;
-    UA_ByteString_clear(&cc->localSymSigningKey);
-    return UA_ByteString_copy(key, &cc->localSymSigningKey);
+    return UA_OpenSSL_HMAC_setKey(&cc->localSymSigningCtx, EVP_sha1(), key);
 }
 
 static UA_StatusCode
@@ -304,8 +303,7 @@ UA_ChannelModule_Basic256_setLocalSymEncryptingKey (void *                channe
     }
 
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;
-    UA_ByteString_clear(&cc->localSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->localSymEncryptingKey);
+    return UA_OpenSSL_Cipher_setKey(&cc->localSymEncryptingCtx, EVP_aes_256_cbc(), key, true);
 }
 
 static UA_StatusCode
@@ -328,8 +326,7 @@ UA_ChannelModule_Basic256_setRemoteSymSigningKey (void *                channelC
     }
 
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;
-    UA_ByteString_clear(&cc->remoteSymSigningKey);
-    return UA_ByteString_copy(key, &cc->remoteSymSigningKey);
+    return UA_OpenSSL_HMAC_setKey(&cc->remoteSymSigningCtx, EVP_sha1(), key);
 }
 
 static UA_StatusCode
@@ -340,8 +337,7 @@ UA_ChannelModule_Basic256_setRemoteSymEncryptingKey (void *                chann
     }
 
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;
-    UA_ByteString_clear(&cc->remoteSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->remoteSymEncryptingKey);
+    return UA_OpenSSL_Cipher_setKey(&cc->remoteSymEncryptingCtx, EVP_aes_256_cbc(), key, false);
 }
 
 static UA_StatusCode
@@ -535,7 +531,7 @@ UA_SymEn_Basic256_Encrypt (void *                    channelContext,
         return UA_STATUSCODE_BADINVALIDARGUMENT;
 
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;
-    return UA_OpenSSL_AES_256_CBC_Encrypt (&cc->localSymIv, &cc->localSymEncryptingKey, data);
+    return UA_OpenSSL_Cipher_encrypt(cc->localSymEncryptingCtx, &cc->localSymIv, data);
 }
 
 static UA_StatusCode
@@ -544,7 +540,7 @@ UA_SymEn_Basic256_Decrypt (void *                    channelContext,
     if(channelContext == NULL || data == NULL)
         return UA_STATUSCODE_BADINVALIDARGUMENT;
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;
-    return UA_OpenSSL_AES_256_CBC_Decrypt (&cc->remoteSymIv, &cc->remoteSymEncryptingKey, data);
+    return UA_OpenSSL_Cipher_decrypt(cc->remoteSymEncryptingCtx, &cc->remoteSymIv, data);
 }
 
 static size_t
@@ -566,9 +562,7 @@ UA_SymSig_Basic256_Verify (void *                    channelContext,
         return UA_STATUSCODE_BADINVALIDARGUMENT;
 
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;
-    return UA_OpenSSL_HMAC_SHA1_Verify (message,
-                                        &cc->remoteSymSigningKey,
-                                        signature);
+    return UA_OpenSSL_HMAC_verify(cc->remoteSymSigningCtx, message, signature);
 }
 
 static UA_StatusCode
@@ -579,7 +573,7 @@ UA_SymSig_Basic256_Sign (void *                    channelContext,
         return UA_STATUSCODE_BADINVALIDARGUMENT;
 
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;
-    return UA_OpenSSL_HMAC_SHA1_Sign (message, &cc->localSymSigningKey, signature);
+    return UA_OpenSSL_HMAC_sign(cc->localSymSigningCtx, message, signature);
 }
 
 /* the main entry of Basic256 */
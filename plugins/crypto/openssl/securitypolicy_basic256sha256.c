@@ -37,11 +37,11 @@ typedef struct {
 } Policy_Context_Basic256Sha256;
 
 typedef struct {
-    UA_ByteString localSymSigningKey;
-    UA_ByteString localSymEncryptingKey;
+    UA_OpenSSL_HMAC_CTX *localSymSigningCtx;
+    EVP_CIPHER_CTX *localSymEncryptingCtx;
     UA_ByteString localSymIv;
-    UA_ByteString remoteSymSigningKey;
-    UA_ByteString remoteSymEncryptingKey;
+    UA_OpenSSL_HMAC_CTX *remoteSymSigningCtx;
+    EVP_CIPHER_CTX *remoteSymEncryptingCtx;
     UA_ByteString remoteSymIv;
 
     Policy_Context_Basic256Sha256 *policyContext;
@@ -198,11 +198,11 @@ UA_ChannelModule_New_Context(const UA_SecurityPolicy * securityPolicy,
     if(context == NULL)
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
-    UA_ByteString_init(&context->localSymSigningKey);
-    UA_ByteString_init(&context->localSymEncryptingKey);
+    context->localSymSigningCtx = NULL;
+    context->localSymEncryptingCtx = NULL;
     UA_ByteString_init(&context->localSymIv);
-    UA_ByteString_init(&context->remoteSymSigningKey);
-    UA_ByteString_init(&context->remoteSymEncryptingKey);
+    context->remoteSymSigningCtx = NULL;
+    context->remoteSymEncryptingCtx = NULL;
     UA_ByteString_init(&context->remoteSymIv);
 
     UA_StatusCode retval =
@@ -240,11 +240,11 @@ UA_ChannelModule_Delete_Context(void * channelContext) {
     Channel_Context_Basic256Sha256 * cc = (Channel_Context_Basic256Sha256 *)channelContext;
     X509_free(cc->remoteCertificateX509);
     UA_ByteString_clear(&cc->remoteCertificate);
-    UA_ByteString_clear(&cc->localSymSigningKey);
-    UA_ByteString_clear(&cc->localSymEncryptingKey);
+    UA_OpenSSL_HMAC_free(cc->localSymSigningCtx);
+    EVP_CIPHER_CTX_free(cc->localSymEncryptingCtx);
     UA_ByteString_clear(&cc->localSymIv);
-    UA_ByteString_clear(&cc->remoteSymSigningKey);
-    UA_ByteString_clear(&cc->remoteSymEncryptingKey);
+    UA_OpenSSL_HMAC_free(cc->remoteSymSigningCtx);
+    EVP_CIPHER_CTX_free(cc->remoteSymEncryptingCtx);
     UA_ByteString_clear(&cc->remoteSymIv);
 
     UA_LOG_INFO(cc->policyContext->logger, UA_LOGCATEGORY_SECURITYPOLICY,
@@ -398,8 +398,7 @@ UA_ChannelModule_Basic256Sha256_setLocalSymSigningKey(void * channelContext,
     if(key == NULL || channelContext == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Basic256Sha256 * cc = (Channel_Context_Basic256Sha256 *) channelContext;
-    UA_ByteString_clear(&cc->localSymSigningKey);
-    return UA_ByteString_copy(key, &cc->localSymSigningKey);
+    return UA_OpenSSL_HMAC_setKey(&cc->localSymSigningCtx, EVP_sha256(), key);
 }
 
 static UA_StatusCode
@@ -408,8 +407,7 @@ UA_ChannelM_Basic256Sha256_setLocalSymEncryptingKey(void * channelContext,
     if(key == NULL || channelContext == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Basic256Sha256 * cc = (Channel_Context_Basic256Sha256 *) channelContext;
-    UA_ByteString_clear(&cc->localSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->localSymEncryptingKey);
+    return UA_OpenSSL_Cipher_setKey(&cc->localSymEncryptingCtx, EVP_aes_256_cbc(), key, true);
 }
 
 static UA_StatusCode
@@ -445,8 +443,7 @@ UA_ChannelM_Basic256Sha256_setRemoteSymSigningKey(void *channelContext,
     if(key == NULL || channelContext == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Basic256Sha256 * cc = (Channel_Context_Basic256Sha256 *) channelContext;
-    UA_ByteString_clear(&cc->remoteSymSigningKey);
-    return UA_ByteString_copy(key, &cc->remoteSymSigningKey);
+    return UA_OpenSSL_HMAC_setKey(&cc->remoteSymSigningCtx, EVP_sha256(), key);
 }
 
 static UA_StatusCode
@@ -455,8 +452,7 @@ UA_ChannelM_Basic256Sha256_setRemoteSymEncryptingKey(void *channelContext,
     if(key == NULL || channelContext == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Basic256Sha256 * cc = (Channel_Context_Basic256Sha256 *) channelContext;
-    UA_ByteString_clear(&cc->remoteSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->remoteSymEncryptingKey);
+    return UA_OpenSSL_Cipher_setKey(&cc->remoteSymEncryptingCtx, EVP_aes_256_cbc(), key, false);
 }
 
 static UA_StatusCode
@@ -501,7 +497,7 @@ UA_SymSig_Basic256Sha256_verify(void *channelContext, const UA_ByteString *messa
         return UA_STATUSCODE_BADINTERNALERROR;
 
     Channel_Context_Basic256Sha256 * cc = (Channel_Context_Basic256Sha256 *) channelContext;
-    return UA_OpenSSL_HMAC_SHA256_Verify(message, &cc->remoteSymSigningKey, signature);
+    return UA_OpenSSL_HMAC_verify(cc->remoteSymSigningCtx, message, signature);
 }
 
 static UA_StatusCode
@@ -511,7 +507,7 @@ UA_SymSig_Basic256Sha256_sign(void *channelContext, const UA_ByteString *message
         return UA_STATUSCODE_BADINTERNALERROR;
 
     Channel_Context_Basic256Sha256 * cc = (Channel_Context_Basic256Sha256 *) channelContext;
-    return UA_OpenSSL_HMAC_SHA256_Sign(message, &cc->localSymSigningKey, signature);
+    return UA_OpenSSL_HMAC_sign(cc->localSymSigningCtx, message, signature);
 }
 
 static size_t
@@ -524,8 +520,7 @@ UA_SymEn_Basic256Sha256_decrypt(void *channelContext, UA_ByteString *data) {
     if(channelContext == NULL || data == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Basic256Sha256 * cc = (Channel_Context_Basic256Sha256 *) channelContext;
-    return UA_OpenSSL_AES_256_CBC_Decrypt(&cc->remoteSymIv,
-                                          &cc->remoteSymEncryptingKey, data);
+    return UA_OpenSSL_Cipher_decrypt(cc->remoteSymEncryptingCtx, &cc->remoteSymIv, data);
 }
 
 static UA_StatusCode
@@ -534,7 +529,7 @@ UA_SymEn_Basic256Sha256_encrypt(void *channelContext, UA_ByteString *data) {
         return UA_STATUSCODE_BADINTERNALERROR;
 
     Channel_Context_Basic256Sha256 * cc = (Channel_Context_Basic256Sha256 *) channelContext;
-    return UA_OpenSSL_AES_256_CBC_Encrypt(&cc->localSymIv, &cc->localSymEncryptingKey, data);
+    return UA_OpenSSL_Cipher_encrypt(cc->localSymEncryptingCtx, &cc->localSymIv, data);
 }
 
 static UA_StatusCode
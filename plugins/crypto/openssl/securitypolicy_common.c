@@ -29,6 +29,10 @@ modification history
 #include <openssl/aes.h>
 #include <openssl/pem.h>
 #include <openssl/rand.h>
+#if (OPENSSL_VERSION_NUMBER >= 0x30000000L)
+#include <openssl/core_names.h>
+#include <openssl/params.h>
+#endif
 
 #include "securitypolicy_common.h"
 
@@ -630,199 +634,157 @@ UA_Openssl_RSA_PSS_SHA256_Sign (const UA_ByteString * message,
                                         RSA_PKCS1_PSS_PADDING, outSignature);
 }
 
-UA_StatusCode
-UA_OpenSSL_HMAC_SHA256_Verify (const UA_ByteString *     message,
-                               const UA_ByteString *     key,
-                               const UA_ByteString *     signature
-                              ) {
-    unsigned char buf[SHA256_DIGEST_LENGTH] = {0};
-    UA_ByteString mac = {SHA256_DIGEST_LENGTH, buf};
-
-    if (HMAC (EVP_sha256(), key->data, (int) key->length, message->data, message->length,
-              mac.data, (unsigned int *) &mac.length) == NULL) {
-        return UA_STATUSCODE_BADINTERNALERROR;
-    }
-    if (UA_ByteString_equal (signature, &mac)) {
-        return UA_STATUSCODE_GOOD;
-    }
-    else {
-        return UA_STATUSCODE_BADINTERNALERROR;
-    }
-}
+/* Symmetric cipher and HMAC contexts
+ * ----------------------------------
+ * The contexts are keyed once when the symmetric keys of the channel are
+ * derived. For every chunk the cipher is only reset with the IV and the HMAC
+ * reuses the precomputed key pads. */
 
 UA_StatusCode
-UA_OpenSSL_HMAC_SHA256_Sign (const UA_ByteString *     message,
-                             const UA_ByteString *     key,
-                             UA_ByteString *           signature
-                             ) {
-    if (HMAC (EVP_sha256(), key->data, (int) key->length, message->data,
-              message->length,
-              signature->data, (unsigned int *) &(signature->length)) == NULL) {
+UA_OpenSSL_Cipher_setKey(EVP_CIPHER_CTX **ctx, const EVP_CIPHER *cipherAlg,
+                         const UA_ByteString *key, UA_Boolean encrypt) {
+    if(key->length != (size_t)EVP_CIPHER_key_length(cipherAlg))
+        return UA_STATUSCODE_BADINTERNALERROR;
+    if(!*ctx) {
+        *ctx = EVP_CIPHER_CTX_new();
+        if(!*ctx)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    if(EVP_CipherInit_ex(*ctx, cipherAlg, NULL, key->data, NULL, encrypt ? 1 : 0) != 1) {
+        EVP_CIPHER_CTX_free(*ctx);
+        *ctx = NULL;
         return UA_STATUSCODE_BADINTERNALERROR;
     }
     return UA_STATUSCODE_GOOD;
 }
 
+/* Padding is done in the stack before calling encryption. The data is
+ * en-/decrypted in place. */
 static UA_StatusCode
-UA_OpenSSL_Decrypt (const UA_ByteString * iv,
-                    const UA_ByteString * key,
-                    const EVP_CIPHER *    cipherAlg,
-                    UA_ByteString *       data  /* [in/out]*/) {
-    UA_ByteString    ivCopy    = {0, NULL};
-    UA_ByteString    cipherTxt = {0, NULL};
-    EVP_CIPHER_CTX * ctx       = NULL;
-    UA_StatusCode    ret;
-    int              opensslRet;
-    int              outLen;
-    int              tmpLen;
-
-    /* copy the IV because the AES_cbc_encrypt function overwrites it. */
-
-    ret = UA_ByteString_copy (iv, &ivCopy);
-    if (ret != UA_STATUSCODE_GOOD) {
-        goto errout;
-    }
-
-    ret = UA_ByteString_copy (data, &cipherTxt);
-    if (ret != UA_STATUSCODE_GOOD) {
-        goto errout;
-    }
+UA_OpenSSL_Cipher_apply(EVP_CIPHER_CTX *ctx, const UA_ByteString *iv,
+                        UA_ByteString *data /* [in/out]*/) {
+    if(!ctx || iv->length < (size_t)EVP_CIPHER_CTX_iv_length(ctx))
+        return UA_STATUSCODE_BADINTERNALERROR;
 
-    ctx = EVP_CIPHER_CTX_new ();
-    if (ctx == NULL) {
-        ret = UA_STATUSCODE_BADOUTOFMEMORY;
-        goto errout;
-    }
+    /* Ensure that we have a multiple of the block size */
+    if(data->length % (size_t)EVP_CIPHER_CTX_block_size(ctx))
+        return UA_STATUSCODE_BADINTERNALERROR;
 
-    /* call EVP_* to decrypt */
+    /* Reset the IV. Keeps the key schedule. */
+    if(EVP_CipherInit_ex(ctx, NULL, NULL, NULL, iv->data, -1) != 1 ||
+       EVP_CIPHER_CTX_set_padding(ctx, 0) != 1)
+        return UA_STATUSCODE_BADINTERNALERROR;
 
-    opensslRet = EVP_DecryptInit_ex (ctx, cipherAlg, NULL, key->data, ivCopy.data);
-    if (opensslRet != 1) {
-        ret = UA_STATUSCODE_BADINTERNALERROR;
-        goto errout;
-    }
-    /* EVP_DecryptFinal() will return an error code if padding is enabled
-     * and the final block is not correctly formatted.
-     */
-    EVP_CIPHER_CTX_set_padding (ctx, 0);
-    opensslRet = EVP_DecryptUpdate (ctx, data->data, &outLen,
-                                    cipherTxt.data, (int) cipherTxt.length);
-    if (opensslRet != 1) {
-        ret = UA_STATUSCODE_BADINTERNALERROR;
-        goto errout;
-    }
-    opensslRet = EVP_DecryptFinal_ex (ctx, data->data + outLen, &tmpLen);
-    if (opensslRet != 1) {
-        ret = UA_STATUSCODE_BADINTERNALERROR;
-        goto errout;
-    }
-    outLen += tmpLen;
-    data->length = (size_t) outLen;
-    ret = UA_STATUSCODE_GOOD;
+    int outLen = 0;
+    int tmpLen = 0;
+    if(EVP_CipherUpdate(ctx, data->data, &outLen, data->data, (int)data->length) != 1)
+        return UA_STATUSCODE_BADINTERNALERROR;
 
-errout:
-    UA_ByteString_clear (&ivCopy);
-    UA_ByteString_clear (&cipherTxt);
-    if (ctx != NULL) {
-        EVP_CIPHER_CTX_free(ctx);
-    }
-    return ret;
+    /* Final does nothing as padding is disabled */
+    if(EVP_CipherFinal_ex(ctx, data->data + outLen, &tmpLen) != 1)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    data->length = (size_t)(outLen + tmpLen);
+    return UA_STATUSCODE_GOOD;
 }
 
-static UA_StatusCode
-UA_OpenSSL_Encrypt (const UA_ByteString * iv,
-                    const UA_ByteString * key,
-                    const EVP_CIPHER *    cipherAlg,
-                    UA_ByteString *       data  /* [in/out]*/
-                    ) {
-
-    UA_ByteString    ivCopy   = {0, NULL};
-    UA_ByteString    plainTxt = {0, NULL};
-    EVP_CIPHER_CTX * ctx      = NULL;
-    UA_StatusCode    ret;
-    int              opensslRet;
-    int              outLen;
-    int              tmpLen;
-
-    /* copy the IV because the AES_cbc_encrypt function overwrites it. */
-
-    ret = UA_ByteString_copy (iv, &ivCopy);
-    if (ret != UA_STATUSCODE_GOOD) {
-        goto errout;
-    }
-
-    ret = UA_ByteString_copy (data, &plainTxt);
-    if (ret != UA_STATUSCODE_GOOD) {
-        goto errout;
-    }
-
-    ctx = EVP_CIPHER_CTX_new ();
-    if (ctx == NULL) {
-        ret = UA_STATUSCODE_BADOUTOFMEMORY;
-        goto errout;
-    }
-
-    /* call EVP_* to encrypt */
+UA_StatusCode
+UA_OpenSSL_Cipher_encrypt(EVP_CIPHER_CTX *ctx, const UA_ByteString *iv,
+                          UA_ByteString *data /* [in/out]*/) {
+    return UA_OpenSSL_Cipher_apply(ctx, iv, data);
+}
 
-    opensslRet = EVP_EncryptInit_ex (ctx, cipherAlg, NULL, key->data, ivCopy.data);
-    if (opensslRet != 1) {
-        ret = UA_STATUSCODE_BADINTERNALERROR;
-        goto errout;
-    }
+UA_StatusCode
+UA_OpenSSL_Cipher_decrypt(EVP_CIPHER_CTX *ctx, const UA_ByteString *iv,
+                          UA_ByteString *data /* [in/out]*/) {
+    return UA_OpenSSL_Cipher_apply(ctx, iv, data);
+}
 
-    /* Disable padding. Padding is done in the stack before calling encryption.
-     * Ensure that we have a multiple of the block size */
-    if(data->length % (size_t)EVP_CIPHER_CTX_block_size(ctx)) {
-        ret = UA_STATUSCODE_BADINTERNALERROR;
-        goto errout;
-    }
-    opensslRet = EVP_CIPHER_CTX_set_padding(ctx, 0);
-    if (opensslRet != 1) {
-        ret = UA_STATUSCODE_BADINTERNALERROR;
-        goto errout;
+UA_StatusCode
+UA_OpenSSL_HMAC_setKey(UA_OpenSSL_HMAC_CTX **ctx, const EVP_MD *md,
+                       const UA_ByteString *key) {
+    UA_OpenSSL_HMAC_free(*ctx);
+    *ctx = NULL;
+#if (OPENSSL_VERSION_NUMBER >= 0x30000000L)
+    EVP_MAC *mac = EVP_MAC_fetch(NULL, "HMAC", NULL);
+    if(!mac)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    EVP_MAC_CTX *macCtx = EVP_MAC_CTX_new(mac);
+    EVP_MAC_free(mac); /* The context keeps a reference */
+    if(!macCtx)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    OSSL_PARAM params[2];
+    params[0] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST,
+                                                 (char *)(uintptr_t)EVP_MD_get0_name(md), 0);
+    params[1] = OSSL_PARAM_construct_end();
+    if(EVP_MAC_init(macCtx, key->data, key->length, params) != 1) {
+        EVP_MAC_CTX_free(macCtx);
+        return UA_STATUSCODE_BADINTERNALERROR;
     }
-
-    /* Encrypt the data */
-    opensslRet = EVP_EncryptUpdate (ctx, data->data, &outLen,
-                                    plainTxt.data, (int) plainTxt.length);
-    if (opensslRet != 1) {
-        ret = UA_STATUSCODE_BADINTERNALERROR;
-        goto errout;
+#else
+    HMAC_CTX *macCtx = HMAC_CTX_new();
+    if(!macCtx)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    if(HMAC_Init_ex(macCtx, key->data, (int)key->length, md, NULL) != 1) {
+        HMAC_CTX_free(macCtx);
+        return UA_STATUSCODE_BADINTERNALERROR;
     }
+#endif
+    *ctx = macCtx;
+    return UA_STATUSCODE_GOOD;
+}
 
-    /* Encrypt-final does nothing as padding is disabled */
-    opensslRet = EVP_EncryptFinal_ex(ctx, data->data + outLen, &tmpLen);
-    if (opensslRet != 1) {
-        ret = UA_STATUSCODE_BADINTERNALERROR;
-        goto errout;
-    }
-    outLen += tmpLen;
-    data->length = (size_t) outLen;
-    ret = UA_STATUSCODE_GOOD;
+void
+UA_OpenSSL_HMAC_free(UA_OpenSSL_HMAC_CTX *ctx) {
+#if (OPENSSL_VERSION_NUMBER >= 0x30000000L)
+    EVP_MAC_CTX_free(ctx);
+#else
+    HMAC_CTX_free(ctx);
+#endif
+}
 
-errout:
-    UA_ByteString_clear (&ivCopy);
-    UA_ByteString_clear (&plainTxt);
-    if (ctx != NULL) {
-        EVP_CIPHER_CTX_free(ctx);
-    }
-    return ret;
+/* Computes the HMAC with the keyed context. The buffer must be large enough for
+ * the digest. */
+static UA_StatusCode
+UA_OpenSSL_HMAC_compute(UA_OpenSSL_HMAC_CTX *ctx, const UA_ByteString *message,
+                        UA_ByteString *mac) {
+    if(!ctx)
+        return UA_STATUSCODE_BADINTERNALERROR;
+#if (OPENSSL_VERSION_NUMBER >= 0x30000000L)
+    /* Initializing without a key reuses the key of the context */
+    size_t macLen = 0;
+    if(EVP_MAC_init(ctx, NULL, 0, NULL) != 1 ||
+       EVP_MAC_update(ctx, message->data, message->length) != 1 ||
+       EVP_MAC_final(ctx, mac->data, &macLen, mac->length) != 1)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    mac->length = macLen;
+#else
+    unsigned int macLen = 0;
+    if(HMAC_Init_ex(ctx, NULL, 0, NULL, NULL) != 1 ||
+       HMAC_Update(ctx, message->data, message->length) != 1 ||
+       HMAC_Final(ctx, mac->data, &macLen) != 1)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    mac->length = macLen;
+#endif
+    return UA_STATUSCODE_GOOD;
 }
 
 UA_StatusCode
-UA_OpenSSL_AES_256_CBC_Decrypt (const UA_ByteString * iv,
-                                const UA_ByteString * key,
-                                UA_ByteString *       data  /* [in/out]*/
-                                ) {
-    return UA_OpenSSL_Decrypt (iv, key, EVP_aes_256_cbc (), data);
+UA_OpenSSL_HMAC_sign(UA_OpenSSL_HMAC_CTX *ctx, const UA_ByteString *message,
+                     UA_ByteString *signature) {
+    return UA_OpenSSL_HMAC_compute(ctx, message, signature);
 }
 
 UA_StatusCode
-UA_OpenSSL_AES_256_CBC_Encrypt (const UA_ByteString * iv,
-                            const UA_ByteString * key,
-                            UA_ByteString *       data  /* [in/out]*/
-                            ) {
-    return UA_OpenSSL_Encrypt (iv, key, EVP_aes_256_cbc (), data);
+UA_OpenSSL_HMAC_verify(UA_OpenSSL_HMAC_CTX *ctx, const UA_ByteString *message,
+                       const UA_ByteString *signature) {
+    unsigned char buf[EVP_MAX_MD_SIZE];
+    UA_ByteString mac = {EVP_MAX_MD_SIZE, buf};
+    UA_StatusCode res = UA_OpenSSL_HMAC_compute(ctx, message, &mac);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    if(!UA_ByteString_equal(signature, &mac))
+        return UA_STATUSCODE_BADINTERNALERROR;
+    return UA_STATUSCODE_GOOD;
 }
 
 UA_StatusCode
@@ -937,39 +899,6 @@ UA_Openssl_Random_Key_PSHA1_Derive (const UA_ByteString *     secret,
     return UA_STATUSCODE_GOOD;
 }
 
-UA_StatusCode
-UA_OpenSSL_HMAC_SHA1_Verify (const UA_ByteString *     message,
-                             const UA_ByteString *     key,
-                             const UA_ByteString *     signature
-                             ) {
-    unsigned char buf[SHA1_DIGEST_LENGTH] = {0};
-    UA_ByteString mac = {SHA1_DIGEST_LENGTH, buf};
-
-    if(HMAC (EVP_sha1(), key->data, (int) key->length, message->data, message->length,
-             mac.data, (unsigned int *) &mac.length) == NULL) {
-        return UA_STATUSCODE_BADINTERNALERROR;
-    }
-    if (UA_ByteString_equal (signature, &mac)) {
-        return UA_STATUSCODE_GOOD;
-    }
-    else {
-        return UA_STATUSCODE_BADINTERNALERROR;
-    }
-}
-
-UA_StatusCode
-UA_OpenSSL_HMAC_SHA1_Sign (const UA_ByteString *     message,
-                           const UA_ByteString *     key,
-                           UA_ByteString *           signature
-                           ) {
-    if (HMAC (EVP_sha1(), key->data, (int) key->length, message->data,
-              message->length,
-              signature->data, (unsigned int *) &(signature->length)) == NULL) {
-        return UA_STATUSCODE_BADINTERNALERROR;
-    }
-    return UA_STATUSCODE_GOOD;
-}
-
 UA_StatusCode
 UA_Openssl_RSA_PKCS1_V15_Decrypt (UA_ByteString *       data,
                                   EVP_PKEY * privateKey) {
@@ -994,22 +923,6 @@ UA_Openssl_RSA_PKCS1_V15_Encrypt (UA_ByteString * data,
     return ret;
 }
 
-UA_StatusCode
-UA_OpenSSL_AES_128_CBC_Decrypt (const UA_ByteString * iv,
-                                const UA_ByteString * key,
-                                UA_ByteString *       data  /* [in/out]*/
-                                ) {
-    return UA_OpenSSL_Decrypt (iv, key, EVP_aes_128_cbc (), data);
-}
-
-UA_StatusCode
-UA_OpenSSL_AES_128_CBC_Encrypt (const UA_ByteString * iv,
-                                const UA_ByteString * key,
-                                UA_ByteString *       data  /* [in/out]*/
-                                ) {
-    return UA_OpenSSL_Encrypt (iv, key, EVP_aes_128_cbc (), data);
-}
-
 static UA_StatusCode
 UA_OpenSSL_X509_AddSubjectAttributes(const UA_String* subject, X509_NAME* name) {
     char *subj = (char *)UA_malloc(subject->length + 1);
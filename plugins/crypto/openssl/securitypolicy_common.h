@@ -17,6 +17,7 @@
 
 #include <openssl/x509.h>
 #include <openssl/evp.h>
+#include <openssl/hmac.h>
 
 _UA_BEGIN_DECLS
 
@@ -106,25 +107,39 @@ UA_Openssl_RSA_PSS_SHA256_Sign (const UA_ByteString * message,
                                 EVP_PKEY * privateKey,
                                 UA_ByteString *       outSignature);
 
+/* Symmetric cipher and HMAC contexts that are keyed once per channel key */
+#if (OPENSSL_VERSION_NUMBER >= 0x30000000L)
+typedef EVP_MAC_CTX UA_OpenSSL_HMAC_CTX;
+#else
+typedef HMAC_CTX UA_OpenSSL_HMAC_CTX;
+#endif
+
+UA_StatusCode
+UA_OpenSSL_Cipher_setKey(EVP_CIPHER_CTX **ctx, const EVP_CIPHER *cipherAlg,
+                         const UA_ByteString *key, UA_Boolean encrypt);
+
+UA_StatusCode
+UA_OpenSSL_Cipher_encrypt(EVP_CIPHER_CTX *ctx, const UA_ByteString *iv,
+                          UA_ByteString *data  /* [in/out]*/);
+
 UA_StatusCode
-UA_OpenSSL_HMAC_SHA256_Verify(const UA_ByteString *message,
-                              const UA_ByteString *key,
-                              const UA_ByteString *signature);
+UA_OpenSSL_Cipher_decrypt(EVP_CIPHER_CTX *ctx, const UA_ByteString *iv,
+                          UA_ByteString *data  /* [in/out]*/);
 
 UA_StatusCode
-UA_OpenSSL_HMAC_SHA256_Sign(const UA_ByteString *message,
-                            const UA_ByteString *key,
-                            UA_ByteString *signature);
+UA_OpenSSL_HMAC_setKey(UA_OpenSSL_HMAC_CTX **ctx, const EVP_MD *md,
+                       const UA_ByteString *key);
+
+void
+UA_OpenSSL_HMAC_free(UA_OpenSSL_HMAC_CTX *ctx);
 
 UA_StatusCode
-UA_OpenSSL_AES_256_CBC_Decrypt(const UA_ByteString *iv,
-                               const UA_ByteString *key,
-                               UA_ByteString *data  /* [in/out]*/);
+UA_OpenSSL_HMAC_sign(UA_OpenSSL_HMAC_CTX *ctx, const UA_ByteString *message,
+                     UA_ByteString *signature);
 
 UA_StatusCode
-UA_OpenSSL_AES_256_CBC_Encrypt(const UA_ByteString *iv,
-                               const UA_ByteString *key,
-                               UA_ByteString *data  /* [in/out]*/);
+UA_OpenSSL_HMAC_verify(UA_OpenSSL_HMAC_CTX *ctx, const UA_ByteString *message,
+                       const UA_ByteString *signature);
 
 UA_StatusCode
 UA_OpenSSL_X509_compare(const UA_ByteString *cert, const X509 *b);
@@ -147,16 +162,6 @@ UA_Openssl_Random_Key_PSHA1_Derive(const UA_ByteString *secret,
                                    const UA_ByteString *seed,
                                    UA_ByteString *out);
 UA_StatusCode
-UA_OpenSSL_HMAC_SHA1_Verify(const UA_ByteString *message,
-                            const UA_ByteString *key,
-                            const UA_ByteString *signature);
-
-UA_StatusCode
-UA_OpenSSL_HMAC_SHA1_Sign(const UA_ByteString *message,
-                          const UA_ByteString *key,
-                          UA_ByteString *signature);
-
-UA_StatusCode
 UA_Openssl_RSA_PKCS1_V15_Decrypt(UA_ByteString *data,
                                  EVP_PKEY *privateKey);
 
@@ -165,16 +170,6 @@ UA_Openssl_RSA_PKCS1_V15_Encrypt(UA_ByteString *data,
                                  size_t paddingSize,
                                  X509 *publicX509);
 
-UA_StatusCode
-UA_OpenSSL_AES_128_CBC_Decrypt(const UA_ByteString *iv,
-                               const UA_ByteString *key,
-                               UA_ByteString *data  /* [in/out]*/);
-
-UA_StatusCode
-UA_OpenSSL_AES_128_CBC_Encrypt(const UA_ByteString *iv,
-                               const UA_ByteString *key,
-                               UA_ByteString *data  /* [in/out]*/);
-
 UA_StatusCode
 UA_OpenSSL_CreateSigningRequest(EVP_PKEY *localPrivateKey,
                                 EVP_PKEY **csrLocalPrivateKey,
@@ -0,0 +1,1389 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <open62541/plugin/historydata/history_data_backend_compressed.h>
+
+#include "ziptree.h"
+
+#include <string.h>
+
+/**************/
+/* Bit Buffer */
+/**************/
+
+typedef struct {
+    UA_Byte *data;
+    size_t size;   /* Bytes allocated */
+    size_t bitPos; /* Bits written */
+} BitBuffer;
+
+static UA_UInt64
+lowBits(UA_UInt64 value, UA_Byte bits) {
+    return (bits >= 64) ? value : value & ((((UA_UInt64)1) << bits) - 1);
+}
+
+/* Write the lowest bits of the value, most significant bit first */
+static UA_StatusCode
+writeBits(BitBuffer *b, UA_UInt64 value, UA_Byte bits) {
+    size_t needed = (b->bitPos + bits + 7) / 8;
+    if(needed > b->size) {
+        size_t newSize = (b->size == 0) ? 64 : b->size * 2;
+        while(newSize < needed)
+            newSize *= 2;
+        UA_Byte *data = (UA_Byte*)UA_realloc(b->data, newSize);
+        if(!data)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        memset(&data[b->size], 0, newSize - b->size);
+        b->data = data;
+        b->size = newSize;
+    }
+    while(bits > 0) {
+        UA_Byte space = (UA_Byte)(8 - (b->bitPos % 8));
+        UA_Byte n = (bits < space) ? bits : space;
+        UA_Byte chunk = (UA_Byte)lowBits(value >> (bits - n), n);
+        b->data[b->bitPos / 8] |= (UA_Byte)(chunk << (space - n));
+        b->bitPos += n;
+        bits = (UA_Byte)(bits - n);
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+typedef struct {
+    const UA_Byte *data;
+    size_t bitPos;
+} BitReader;
+
+static UA_UInt64
+readBits(BitReader *r, UA_Byte bits) {
+    UA_UInt64 value = 0;
+    while(bits > 0) {
+        UA_Byte space = (UA_Byte)(8 - (r->bitPos % 8));
+        UA_Byte n = (bits < space) ? bits : space;
+        UA_Byte chunk = (UA_Byte)(r->data[r->bitPos / 8] >> (space - n));
+        value = (value << n) | lowBits(chunk, n);
+        r->bitPos += n;
+        bits = (UA_Byte)(bits - n);
+    }
+    return value;
+}
+
+/* Variable-length signed integers. Zero takes a single bit. */
+static UA_StatusCode
+writeSigned(BitBuffer *b, UA_Int64 v) {
+    if(v == 0)
+        return writeBits(b, 0, 1);
+    static const UA_Byte widths[4] = {7, 12, 20, 32};
+    for(UA_Byte i = 0; i < 4; i++) {
+        UA_Int64 limit = ((UA_Int64)1) << (widths[i] - 1);
+        if(v >= -limit && v < limit) {
+            /* Prefix of i+1 one bits followed by a zero bit */
+            UA_StatusCode res = writeBits(b, (((UA_UInt64)1) << (i + 2)) - 2,
+                                          (UA_Byte)(i + 2));
+            res |= writeBits(b, (UA_UInt64)v, widths[i]);
+            return res;
+        }
+    }
+    UA_StatusCode res = writeBits(b, 0x1f, 5);
+    res |= writeBits(b, (UA_UInt64)v, 64);
+    return res;
+}
+
+static UA_Int64
+readSigned(BitReader *r) {
+    static const UA_Byte widths[5] = {7, 12, 20, 32, 64};
+    UA_Byte ones = 0;
+    while(ones < 5 && readBits(r, 1) == 1)
+        ones++;
+    if(ones == 0)
+        return 0;
+    UA_Byte width = widths[ones - 1];
+    UA_UInt64 v = readBits(r, width);
+    if(width < 64 && (v & (((UA_UInt64)1) << (width - 1))))
+        v |= ~((((UA_UInt64)1) << width) - 1); /* Sign extension */
+    return (UA_Int64)v;
+}
+
+static UA_Byte
+leadingZeros(UA_UInt64 x) {
+    UA_Byte n = 0;
+    while(n < 64 && !(x & (((UA_UInt64)1) << (63 - n))))
+        n++;
+    return n;
+}
+
+static UA_Byte
+trailingZeros(UA_UInt64 x) {
+    UA_Byte n = 0;
+    while(n < 64 && !(x & (((UA_UInt64)1) << n)))
+        n++;
+    return n;
+}
+
+/*********/
+/* Codec */
+/*********/
+
+#define SAMPLE_HASVALUE             0x01
+#define SAMPLE_HASSTATUS            0x02
+#define SAMPLE_HASSOURCETIMESTAMP   0x04
+#define SAMPLE_HASSERVERTIMESTAMP   0x08
+#define SAMPLE_HASSOURCEPICOSECONDS 0x10
+#define SAMPLE_HASSERVERPICOSECONDS 0x20
+
+/* The state after the previous sample. Identical for encoding and decoding. */
+typedef struct {
+    UA_DateTime time;
+    UA_Int64 delta;
+    UA_Int64 serverOffset; /* Server timestamp minus the source timestamp */
+    UA_Byte flags;
+    UA_StatusCode status;
+    UA_UInt16 sourcePicoseconds;
+    UA_UInt16 serverPicoseconds;
+    UA_UInt64 value;
+    UA_Byte leading;  /* 0xff until the first value was written */
+    UA_Byte trailing;
+} CodecState;
+
+static void
+CodecState_init(CodecState *s) {
+    memset(s, 0, sizeof(CodecState));
+    s->leading = 0xff;
+}
+
+/* The samples are ordered by the source timestamp, or by the server timestamp
+ * if there is no source timestamp. The backend always sets the server
+ * timestamp. */
+static UA_DateTime
+sampleTime(const UA_DataValue *dv) {
+    return (dv->hasSourceTimestamp) ? dv->sourceTimestamp : dv->serverTimestamp;
+}
+
+static UA_Byte
+sampleFlags(const UA_DataValue *dv) {
+    UA_Byte flags = 0;
+    if(dv->hasValue)
+        flags |= SAMPLE_HASVALUE;
+    if(dv->hasStatus)
+        flags |= SAMPLE_HASSTATUS;
+    if(dv->hasSourceTimestamp)
+        flags |= SAMPLE_HASSOURCETIMESTAMP;
+    if(dv->hasServerTimestamp)
+        flags |= SAMPLE_HASSERVERTIMESTAMP;
+    if(dv->hasSourcePicoseconds)
+        flags |= SAMPLE_HASSOURCEPICOSECONDS;
+    if(dv->hasServerPicoseconds)
+        flags |= SAMPLE_HASSERVERPICOSECONDS;
+    return flags;
+}
+
+/* Scalars of up to 64 bit without pointers can be stored as a bit pattern */
+static UA_Boolean
+isCompressibleType(const UA_DataType *type) {
+    if(!type->pointerFree || type->memSize > 8)
+        return false;
+    switch(type->typeKind) {
+    case UA_DATATYPEKIND_BOOLEAN:
+    case UA_DATATYPEKIND_SBYTE:
+    case UA_DATATYPEKIND_BYTE:
+    case UA_DATATYPEKIND_INT16:
+    case UA_DATATYPEKIND_UINT16:
+    case UA_DATATYPEKIND_INT32:
+    case UA_DATATYPEKIND_UINT32:
+    case UA_DATATYPEKIND_INT64:
+    case UA_DATATYPEKIND_UINT64:
+    case UA_DATATYPEKIND_FLOAT:
+    case UA_DATATYPEKIND_DOUBLE:
+    case UA_DATATYPEKIND_DATETIME:
+    case UA_DATATYPEKIND_STATUSCODE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static UA_UInt64
+scalarToBits(const void *p, const UA_DataType *type) {
+    switch(type->memSize) {
+    case 1: { UA_Byte v; memcpy(&v, p, 1); return v; }
+    case 2: { UA_UInt16 v; memcpy(&v, p, 2); return v; }
+    case 4: { UA_UInt32 v; memcpy(&v, p, 4); return v; }
+    default: { UA_UInt64 v; memcpy(&v, p, 8); return v; }
+    }
+}
+
+static void
+bitsToScalar(UA_UInt64 bits, void *p, const UA_DataType *type) {
+    switch(type->memSize) {
+    case 1: { UA_Byte v = (UA_Byte)bits; memcpy(p, &v, 1); break; }
+    case 2: { UA_UInt16 v = (UA_UInt16)bits; memcpy(p, &v, 2); break; }
+    case 4: { UA_UInt32 v = (UA_UInt32)bits; memcpy(p, &v, 4); break; }
+    default: memcpy(p, &bits, 8); break;
+    }
+}
+
+/* Gorilla-style XOR encoding. Identical values take a single bit. If the
+ * meaningful bits fit into the window of the previous value, the window is
+ * reused. */
+static UA_StatusCode
+writeXorValue(BitBuffer *b, CodecState *s, UA_UInt64 value) {
+    UA_UInt64 x = value ^ s->value;
+    s->value = value;
+    if(x == 0)
+        return writeBits(b, 0, 1);
+    UA_Byte lead = leadingZeros(x);
+    UA_Byte trail = trailingZeros(x);
+    if(lead > 31)
+        lead = 31;
+    if(s->leading != 0xff && lead >= s->leading && trail >= s->trailing) {
+        UA_StatusCode res = writeBits(b, 2, 2); /* 10 */
+        res |= writeBits(b, x >> s->trailing,
+                         (UA_Byte)(64 - s->leading - s->trailing));
+        return res;
+    }
+    UA_Byte len = (UA_Byte)(64 - lead - trail);
+    UA_StatusCode res = writeBits(b, 3, 2); /* 11 */
+    res |= writeBits(b, lead, 5);
+    res |= writeBits(b, (UA_UInt64)(len - 1), 6);
+    res |= writeBits(b, x >> trail, len);
+    s->leading = lead;
+    s->trailing = trail;
+    return res;
+}
+
+static UA_UInt64
+readXorValue(BitReader *r, CodecState *s) {
+    if(readBits(r, 1) == 0)
+        return s->value;
+    if(readBits(r, 1) == 1) {
+        s->leading = (UA_Byte)readBits(r, 5);
+        UA_Byte len = (UA_Byte)(readBits(r, 6) + 1);
+        s->trailing = (UA_Byte)(64 - s->leading - len);
+    }
+    UA_Byte len = (UA_Byte)(64 - s->leading - s->trailing);
+    s->value ^= readBits(r, len) << s->trailing;
+    return s->value;
+}
+
+/**********/
+/* Blocks */
+/**********/
+
+typedef struct {
+    UA_UInt64 id;      /* Unique. A modified block gets a new id. */
+    size_t startIndex; /* Index of the first sample in the series */
+    UA_UInt32 count;
+    UA_DateTime firstTime;
+    UA_DateTime lastTime;
+
+    /* Uncompressed block */
+    UA_Boolean raw;
+    UA_DataValue *values;
+    UA_UInt32 valuesCapacity;
+
+    /* Compressed block */
+    const UA_DataType *type; /* Type of the values, NULL before the first */
+    BitBuffer bits;
+    CodecState enc;          /* To append further samples */
+
+    /* Rollup of all samples for the aggregates. Valid if summaryId == id. */
+    UA_UInt64 summaryId;
+    UA_HistoryAggregateSummary summary;
+} HistoryBlock;
+
+static void
+HistoryBlock_clear(HistoryBlock *block) {
+    if(block->raw)
+        UA_Array_delete(block->values, block->count, &UA_TYPES[UA_TYPES_DATAVALUE]);
+    UA_free(block->bits.data);
+    memset(block, 0, sizeof(HistoryBlock));
+}
+
+static UA_Boolean
+fitsCompressedBlock(const HistoryBlock *block, const UA_DataValue *dv) {
+    if(!dv->hasValue)
+        return true;
+    const UA_Variant *v = &dv->value;
+    if(!v->type || !UA_Variant_isScalar(v) || !isCompressibleType(v->type))
+        return false;
+    return (!block || !block->type || block->type == v->type);
+}
+
+static UA_StatusCode
+appendCompressed(HistoryBlock *block, const UA_DataValue *dv) {
+    CodecState *s = &block->enc;
+    BitBuffer *b = &block->bits;
+    UA_DateTime t = sampleTime(dv);
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+
+    /* Timestamp as delta-of-delta. The first timestamp is in the header. */
+    if(block->count == 0) {
+        CodecState_init(s);
+        block->firstTime = t;
+    } else {
+        UA_Int64 delta = (UA_Int64)((UA_UInt64)t - (UA_UInt64)s->time);
+        res |= writeSigned(b, (UA_Int64)((UA_UInt64)delta - (UA_UInt64)s->delta));
+        s->delta = delta;
+    }
+    s->time = t;
+
+    /* The metadata is only written when it changes */
+    UA_Byte flags = sampleFlags(dv);
+    UA_StatusCode status = (dv->hasStatus) ? dv->status : UA_STATUSCODE_GOOD;
+    UA_UInt16 sourcePs = (dv->hasSourcePicoseconds) ? dv->sourcePicoseconds : 0;
+    UA_UInt16 serverPs = (dv->hasServerPicoseconds) ? dv->serverPicoseconds : 0;
+    if(flags == s->flags && status == s->status &&
+       sourcePs == s->sourcePicoseconds && serverPs == s->serverPicoseconds) {
+        res |= writeBits(b, 0, 1);
+    } else {
+        res |= writeBits(b, 1, 1);
+        res |= writeBits(b, flags, 8);
+        res |= writeBits(b, status, 32);
+        res |= writeBits(b, sourcePs, 16);
+        res |= writeBits(b, serverPs, 16);
+        s->flags = flags;
+        s->status = status;
+        s->sourcePicoseconds = sourcePs;
+        s->serverPicoseconds = serverPs;
+    }
+
+    /* Server timestamp relative to the source timestamp */
+    if(dv->hasSourceTimestamp && dv->hasServerTimestamp) {
+        UA_Int64 offset = (UA_Int64)((UA_UInt64)dv->serverTimestamp -
+                                     (UA_UInt64)dv->sourceTimestamp);
+        res |= writeSigned(b, (UA_Int64)((UA_UInt64)offset - (UA_UInt64)s->serverOffset));
+        s->serverOffset = offset;
+    }
+
+    if(dv->hasValue) {
+        block->type = dv->value.type;
+        res |= writeXorValue(b, s, scalarToBits(dv->value.data, dv->value.type));
+    }
+
+    if(res != UA_STATUSCODE_GOOD)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    block->lastTime = t;
+    block->count++;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+appendRaw(HistoryBlock *block, const UA_DataValue *dv) {
+    if(block->count == block->valuesCapacity) {
+        UA_UInt32 capacity = (block->valuesCapacity == 0) ? 16 : block->valuesCapacity * 2;
+        UA_DataValue *values = (UA_DataValue*)
+            UA_realloc(block->values, capacity * sizeof(UA_DataValue));
+        if(!values)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        block->values = values;
+        block->valuesCapacity = capacity;
+    }
+    UA_StatusCode res = UA_DataValue_copy(dv, &block->values[block->count]);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    UA_DateTime t = sampleTime(dv);
+    if(block->count == 0)
+        block->firstTime = t;
+    block->lastTime = t;
+    block->count++;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Decode all samples of a compressed block */
+static UA_StatusCode
+decodeBlock(const HistoryBlock *block, UA_DataValue **outValues) {
+    UA_DataValue *values = (UA_DataValue*)
+        UA_Array_new(block->count, &UA_TYPES[UA_TYPES_DATAVALUE]);
+    if(!values)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    CodecState s;
+    CodecState_init(&s);
+    BitReader r = {block->bits.data, 0};
+    for(UA_UInt32 i = 0; i < block->count; i++) {
+        UA_DataValue *dv = &values[i];
+        if(i == 0) {
+            s.time = block->firstTime;
+        } else {
+            s.delta = (UA_Int64)((UA_UInt64)s.delta + (UA_UInt64)readSigned(&r));
+            s.time = (UA_DateTime)((UA_UInt64)s.time + (UA_UInt64)s.delta);
+        }
+
+        if(readBits(&r, 1) == 1) {
+            s.flags = (UA_Byte)readBits(&r, 8);
+            s.status = (UA_StatusCode)readBits(&r, 32);
+            s.sourcePicoseconds = (UA_UInt16)readBits(&r, 16);
+            s.serverPicoseconds = (UA_UInt16)readBits(&r, 16);
+        }
+        dv->hasValue = (s.flags & SAMPLE_HASVALUE) != 0;
+        dv->hasStatus = (s.flags & SAMPLE_HASSTATUS) != 0;
+        dv->hasSourceTimestamp = (s.flags & SAMPLE_HASSOURCETIMESTAMP) != 0;
+        dv->hasServerTimestamp = (s.flags & SAMPLE_HASSERVERTIMESTAMP) != 0;
+        dv->hasSourcePicoseconds = (s.flags & SAMPLE_HASSOURCEPICOSECONDS) != 0;
+        dv->hasServerPicoseconds = (s.flags & SAMPLE_HASSERVERPICOSECONDS) != 0;
+        dv->status = s.status;
+        dv->sourcePicoseconds = s.sourcePicoseconds;
+        dv->serverPicoseconds = s.serverPicoseconds;
+
+        if(dv->hasSourceTimestamp) {
+            dv->sourceTimestamp = s.time;
+            if(dv->hasServerTimestamp) {
+                s.serverOffset = (UA_Int64)((UA_UInt64)s.serverOffset +
+                                            (UA_UInt64)readSigned(&r));
+                dv->serverTimestamp =
+                    (UA_DateTime)((UA_UInt64)s.time + (UA_UInt64)s.serverOffset);
+            }
+        } else {
+            dv->serverTimestamp = s.time;
+        }
+
+        if(dv->hasValue) {
+            UA_UInt64 bits = readXorValue(&r, &s);
+            void *data = UA_new(block->type);
+            if(!data) {
+                UA_Array_delete(values, block->count, &UA_TYPES[UA_TYPES_DATAVALUE]);
+                return UA_STATUSCODE_BADOUTOFMEMORY;
+            }
+            bitsToScalar(bits, data, block->type);
+            UA_Variant_setScalar(&dv->value, data, block->type);
+        }
+    }
+    *outValues = values;
+    return UA_STATUSCODE_GOOD;
+}
+
+/**********/
+/* Series */
+/**********/
+
+typedef struct HistorySeries {
+    ZIP_ENTRY(HistorySeries) zipfields;
+    UA_UInt32 nodeIdHash;
+    UA_NodeId nodeId;
+    HistoryBlock *blocks; /* Ordered by time, not overlapping */
+    size_t blocksSize;
+    size_t blocksCapacity;
+} HistorySeries;
+
+static enum ZIP_CMP
+cmpHistorySeries(const void *a, const void *b) {
+    const HistorySeries *aa = (const HistorySeries*)a;
+    const HistorySeries *bb = (const HistorySeries*)b;
+    if(aa->nodeIdHash != bb->nodeIdHash)
+        return (aa->nodeIdHash < bb->nodeIdHash) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+    return (enum ZIP_CMP)UA_NodeId_order(&aa->nodeId, &bb->nodeId);
+}
+
+typedef ZIP_HEAD(HistorySeriesTree, HistorySeries) HistorySeriesTree;
+ZIP_FUNCTIONS(HistorySeriesTree, HistorySeries, zipfields,
+              HistorySeries, zipfields, cmpHistorySeries)
+
+typedef struct {
+    HistorySeriesTree series;
+    UA_UInt32 samplesPerBlock;
+    UA_UInt64 nextBlockId;
+
+    /* The most recently decoded compressed block */
+    UA_UInt64 cacheId;
+    UA_DataValue *cache;
+    UA_UInt32 cacheSize;
+} UA_CompressedStoreContext;
+
+static void
+clearSeriesBlocks(HistorySeries *series) {
+    for(size_t i = 0; i < series->blocksSize; i++)
+        HistoryBlock_clear(&series->blocks[i]);
+    UA_free(series->blocks);
+    series->blocks = NULL;
+    series->blocksSize = 0;
+    series->blocksCapacity = 0;
+}
+
+static void *
+deleteHistorySeries(void *context, HistorySeries *series) {
+    clearSeriesBlocks(series);
+    UA_NodeId_clear(&series->nodeId);
+    UA_free(series);
+    return NULL;
+}
+
+static void
+invalidateCache(UA_CompressedStoreContext *ctx) {
+    UA_Array_delete(ctx->cache, ctx->cacheSize, &UA_TYPES[UA_TYPES_DATAVALUE]);
+    ctx->cache = NULL;
+    ctx->cacheSize = 0;
+    ctx->cacheId = 0;
+}
+
+static HistorySeries *
+findSeries(UA_CompressedStoreContext *ctx, const UA_NodeId *nodeId) {
+    HistorySeries dummy;
+    dummy.nodeIdHash = UA_NodeId_hash(nodeId);
+    dummy.nodeId = *nodeId;
+    return ZIP_FIND(HistorySeriesTree, &ctx->series, &dummy);
+}
+
+static HistorySeries *
+getOrCreateSeries(UA_CompressedStoreContext *ctx, const UA_NodeId *nodeId) {
+    HistorySeries *series = findSeries(ctx, nodeId);
+    if(series)
+        return series;
+    series = (HistorySeries*)UA_calloc(1, sizeof(HistorySeries));
+    if(!series)
+        return NULL;
+    if(UA_NodeId_copy(nodeId, &series->nodeId) != UA_STATUSCODE_GOOD) {
+        UA_free(series);
+        return NULL;
+    }
+    series->nodeIdHash = UA_NodeId_hash(nodeId);
+    ZIP_INSERT(HistorySeriesTree, &ctx->series, series);
+    return series;
+}
+
+static size_t
+seriesEnd(const HistorySeries *series) {
+    if(!series || series->blocksSize == 0)
+        return 0;
+    const HistoryBlock *last = &series->blocks[series->blocksSize - 1];
+    return last->startIndex + last->count;
+}
+
+static void
+updateStartIndices(HistorySeries *series, size_t from) {
+    for(size_t i = from; i < series->blocksSize; i++)
+        series->blocks[i].startIndex = (i == 0) ? 0 :
+            series->blocks[i-1].startIndex + series->blocks[i-1].count;
+}
+
+/* Insert empty blocks at the position */
+static UA_StatusCode
+insertBlocks(HistorySeries *series, size_t pos, size_t n) {
+    if(series->blocksSize + n > series->blocksCapacity) {
+        size_t capacity = (series->blocksCapacity == 0) ? 8 : series->blocksCapacity;
+        while(capacity < series->blocksSize + n)
+            capacity *= 2;
+        HistoryBlock *blocks = (HistoryBlock*)
+            UA_realloc(series->blocks, capacity * sizeof(HistoryBlock));
+        if(!blocks)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        series->blocks = blocks;
+        series->blocksCapacity = capacity;
+    }
+    memmove(&series->blocks[pos + n], &series->blocks[pos],
+            (series->blocksSize - pos) * sizeof(HistoryBlock));
+    memset(&series->blocks[pos], 0, n * sizeof(HistoryBlock));
+    series->blocksSize += n;
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+removeBlocks(HistorySeries *series, size_t pos, size_t n) {
+    for(size_t i = pos; i < pos + n; i++)
+        HistoryBlock_clear(&series->blocks[i]);
+    memmove(&series->blocks[pos], &series->blocks[pos + n],
+            (series->blocksSize - pos - n) * sizeof(HistoryBlock));
+    series->blocksSize -= n;
+}
+
+/* Release the unused capacity of a block that is no longer appended to */
+static void
+sealBlock(HistoryBlock *block) {
+    if(block->raw) {
+        if(block->valuesCapacity > block->count && block->count > 0) {
+            UA_DataValue *values = (UA_DataValue*)
+                UA_realloc(block->values, block->count * sizeof(UA_DataValue));
+            if(values) {
+                block->values = values;
+                block->valuesCapacity = block->count;
+            }
+        }
+        return;
+    }
+    size_t used = (block->bits.bitPos + 7) / 8;
+    if(block->bits.size > used && used > 0) {
+        UA_Byte *data = (UA_Byte*)UA_realloc(block->bits.data, used);
+        if(data) {
+            block->bits.data = data;
+            block->bits.size = used;
+        }
+    }
+}
+
+/* Append a sample that is not earlier than the last sample of the series */
+static UA_StatusCode
+appendSample(UA_CompressedStoreContext *ctx, HistorySeries *series,
+             const UA_DataValue *dv) {
+    UA_Boolean compress = fitsCompressedBlock(NULL, dv);
+    HistoryBlock *last = (series->blocksSize > 0) ?
+        &series->blocks[series->blocksSize - 1] : NULL;
+    if(!last || last->count >= ctx->samplesPerBlock ||
+       (last->raw ? compress : !fitsCompressedBlock(last, dv))) {
+        if(last)
+            sealBlock(last);
+        UA_StatusCode res = insertBlocks(series, series->blocksSize, 1);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+        last = &series->blocks[series->blocksSize - 1];
+        last->raw = !compress;
+        last->startIndex = (series->blocksSize == 1) ? 0 :
+            series->blocks[series->blocksSize - 2].startIndex +
+            series->blocks[series->blocksSize - 2].count;
+    }
+    last->id = ++ctx->nextBlockId; /* Invalidates the cache */
+    UA_StatusCode res = (last->raw) ? appendRaw(last, dv) : appendCompressed(last, dv);
+    if(res != UA_STATUSCODE_GOOD && last->count == 0)
+        removeBlocks(series, series->blocksSize - 1, 1);
+    return res;
+}
+
+/* Returns the samples of a block. Raw blocks are not copied. Compressed blocks
+ * are decoded into the cache. */
+static const UA_DataValue *
+getBlockValues(UA_CompressedStoreContext *ctx, const HistoryBlock *block) {
+    if(block->raw)
+        return block->values;
+    if(ctx->cacheId == block->id)
+        return ctx->cache;
+    invalidateCache(ctx);
+    if(decodeBlock(block, &ctx->cache) != UA_STATUSCODE_GOOD)
+        return NULL;
+    ctx->cacheSize = block->count;
+    ctx->cacheId = block->id;
+    return ctx->cache;
+}
+
+/* Replace the block at the position with the encoding of the samples. The
+ * samples are ordered. They can result in zero or more blocks. */
+static UA_StatusCode
+rebuildBlock(UA_CompressedStoreContext *ctx, HistorySeries *series, size_t pos,
+             const UA_DataValue *values, size_t valuesSize) {
+    HistorySeries tmp;
+    memset(&tmp, 0, sizeof(HistorySeries));
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    for(size_t i = 0; i < valuesSize && res == UA_STATUSCODE_GOOD; i++)
+        res = appendSample(ctx, &tmp, &values[i]);
+    if(res == UA_STATUSCODE_GOOD && tmp.blocksSize > 1)
+        res = insertBlocks(series, pos + 1, tmp.blocksSize - 1);
+    if(res != UA_STATUSCODE_GOOD) {
+        clearSeriesBlocks(&tmp);
+        return res;
+    }
+
+    HistoryBlock_clear(&series->blocks[pos]);
+    if(tmp.blocksSize == 0)
+        removeBlocks(series, pos, 1);
+    else
+        memcpy(&series->blocks[pos], tmp.blocks, tmp.blocksSize * sizeof(HistoryBlock));
+    UA_free(tmp.blocks);
+    updateStartIndices(series, pos);
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Decode a block into a modifiable array with one spare element */
+static UA_StatusCode
+copyBlockValues(UA_CompressedStoreContext *ctx, const HistoryBlock *block,
+                UA_DataValue **outValues) {
+    const UA_DataValue *values = getBlockValues(ctx, block);
+    if(!values)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_DataValue *copy = (UA_DataValue*)
+        UA_Array_new(block->count + 1, &UA_TYPES[UA_TYPES_DATAVALUE]);
+    if(!copy)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    for(UA_UInt32 i = 0; i < block->count; i++) {
+        UA_StatusCode res = UA_DataValue_copy(&values[i], &copy[i]);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_Array_delete(copy, block->count + 1, &UA_TYPES[UA_TYPES_DATAVALUE]);
+            return res;
+        }
+    }
+    *outValues = copy;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Find the first block with lastTime >= t (or > t if strict). Returns
+ * blocksSize if there is none. */
+static size_t
+findBlockByTime(const HistorySeries *series, UA_DateTime t, UA_Boolean strict) {
+    size_t min = 0;
+    size_t max = series->blocksSize;
+    while(min < max) {
+        size_t mid = (min + max) / 2;
+        UA_DateTime last = series->blocks[mid].lastTime;
+        if(last < t || (strict && last == t))
+            min = mid + 1;
+        else
+            max = mid;
+    }
+    return min;
+}
+
+static size_t
+findBlockByIndex(const HistorySeries *series, size_t index) {
+    size_t min = 0;
+    size_t max = series->blocksSize;
+    while(min + 1 < max) {
+        size_t mid = (min + max) / 2;
+        if(series->blocks[mid].startIndex <= index)
+            min = mid;
+        else
+            max = mid;
+    }
+    return min;
+}
+
+/* Index of the first sample with time >= t (or > t if strict). Only the block
+ * that contains the bound is decoded. */
+static size_t
+timeBound(UA_CompressedStoreContext *ctx, const HistorySeries *series,
+          UA_DateTime t, UA_Boolean strict) {
+    size_t b = findBlockByTime(series, t, strict);
+    if(b == series->blocksSize)
+        return seriesEnd(series);
+    const HistoryBlock *block = &series->blocks[b];
+    if(block->firstTime > t || (!strict && block->firstTime == t))
+        return block->startIndex;
+    const UA_DataValue *values = getBlockValues(ctx, block);
+    if(!values)
+        return seriesEnd(series);
+    size_t min = 0;
+    size_t max = block->count;
+    while(min < max) {
+        size_t mid = (min + max) / 2;
+        UA_DateTime mt = sampleTime(&values[mid]);
+        if(mt < t || (strict && mt == t))
+            min = mid + 1;
+        else
+            max = mid;
+    }
+    return block->startIndex + min;
+}
+
+static const UA_DataValue *
+getSample(UA_CompressedStoreContext *ctx, const HistorySeries *series, size_t index) {
+    if(index >= seriesEnd(series))
+        return NULL;
+    const HistoryBlock *block = &series->blocks[findBlockByIndex(series, index)];
+    const UA_DataValue *values = getBlockValues(ctx, block);
+    return (values) ? &values[index - block->startIndex] : NULL;
+}
+
+/* Insert a sample after the samples with an earlier time */
+static UA_StatusCode
+insertSample(UA_CompressedStoreContext *ctx, HistorySeries *series,
+             const UA_DataValue *dv) {
+    /* Fast path: Append at the end */
+    UA_DateTime t = sampleTime(dv);
+    if(series->blocksSize == 0 ||
+       series->blocks[series->blocksSize - 1].lastTime <= t)
+        return appendSample(ctx, series, dv);
+
+    /* Late sample: Re-encode the block with the sample */
+    size_t b = findBlockByTime(series, t, false);
+    HistoryBlock *block = &series->blocks[b];
+    UA_UInt32 count = block->count;
+    UA_DataValue *values = NULL;
+    UA_StatusCode res = copyBlockValues(ctx, block, &values);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    size_t pos = 0;
+    while(pos < count && sampleTime(&values[pos]) < t)
+        pos++;
+    memmove(&values[pos + 1], &values[pos], (count - pos) * sizeof(UA_DataValue));
+    res = UA_DataValue_copy(dv, &values[pos]);
+    if(res == UA_STATUSCODE_GOOD)
+        res = rebuildBlock(ctx, series, b, values, count + 1);
+    else
+        UA_DataValue_init(&values[pos]);
+    UA_Array_delete(values, count + 1, &UA_TYPES[UA_TYPES_DATAVALUE]);
+    return res;
+}
+
+/* Remove the samples in the index range [start, end) */
+static UA_StatusCode
+removeSamples(UA_CompressedStoreContext *ctx, HistorySeries *series,
+              size_t start, size_t end) {
+    if(start >= end)
+        return UA_STATUSCODE_GOOD;
+    size_t first = findBlockByIndex(series, start);
+    size_t last = findBlockByIndex(series, end - 1);
+    /* Back to front. The positions of the earlier blocks remain valid. */
+    for(size_t b = last + 1; b > first; b--) {
+        HistoryBlock *block = &series->blocks[b - 1];
+        size_t from = (start > block->startIndex) ? start - block->startIndex : 0;
+        size_t to = end - block->startIndex;
+        if(to > block->count)
+            to = block->count;
+        if(from == 0 && to == block->count) {
+            removeBlocks(series, b - 1, 1);
+            continue;
+        }
+        UA_UInt32 count = block->count;
+        UA_DataValue *values = NULL;
+        UA_StatusCode res = copyBlockValues(ctx, block, &values);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+        for(size_t i = from; i < to; i++)
+            UA_DataValue_clear(&values[i]);
+        memmove(&values[from], &values[to], (count - to) * sizeof(UA_DataValue));
+        memset(&values[count - (to - from)], 0, (to - from) * sizeof(UA_DataValue));
+        res = rebuildBlock(ctx, series, b - 1, values, count - (to - from));
+        UA_Array_delete(values, count + 1, &UA_TYPES[UA_TYPES_DATAVALUE]);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+    updateStartIndices(series, first);
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Set the server timestamp if it is missing. The DataValue is a shallow copy. */
+static void
+prepareSample(UA_DataValue *dv, const UA_DataValue *value, UA_DateTime t) {
+    *dv = *value;
+    if(!dv->hasServerTimestamp) {
+        dv->serverTimestamp = t;
+        dv->hasServerTimestamp = true;
+    }
+}
+
+/*****************************/
+/* Backend Interface Methods */
+/*****************************/
+
+static UA_StatusCode
+serverSetHistoryData_backend_compressed(UA_Server *server, void *context,
+                                        const UA_NodeId *sessionId,
+                                        void *sessionContext,
+                                        const UA_NodeId *nodeId,
+                                        UA_Boolean historizing,
+                                        const UA_DataValue *value) {
+    UA_CompressedStoreContext *ctx = (UA_CompressedStoreContext*)context;
+    HistorySeries *series = getOrCreateSeries(ctx, nodeId);
+    if(!series)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_DateTime t;
+    if(value->hasSourceTimestamp)
+        t = value->sourceTimestamp;
+    else if(value->hasServerTimestamp)
+        t = value->serverTimestamp;
+    else
+        t = UA_DateTime_now();
+    UA_DataValue dv;
+    prepareSample(&dv, value, t);
+    return insertSample(ctx, series, &dv);
+}
+
+static size_t
+getEnd_backend_compressed(UA_Server *server, void *context,
+                          const UA_NodeId *sessionId, void *sessionContext,
+                          const UA_NodeId *nodeId) {
+    return seriesEnd(findSeries((UA_CompressedStoreContext*)context, nodeId));
+}
+
+static size_t
+lastIndex_backend_compressed(UA_Server *server, void *context,
+                             const UA_NodeId *sessionId, void *sessionContext,
+                             const UA_NodeId *nodeId) {
+    size_t end = seriesEnd(findSeries((UA_CompressedStoreContext*)context, nodeId));
+    return (end == 0) ? 0 : end - 1;
+}
+
+static size_t
+firstIndex_backend_compressed(UA_Server *server, void *context,
+                              const UA_NodeId *sessionId, void *sessionContext,
+                              const UA_NodeId *nodeId) {
+    return 0;
+}
+
+static size_t
+resultSize_backend_compressed(UA_Server *server, void *context,
+                              const UA_NodeId *sessionId, void *sessionContext,
+                              const UA_NodeId *nodeId,
+                              size_t startIndex, size_t endIndex) {
+    size_t end = seriesEnd(findSeries((UA_CompressedStoreContext*)context, nodeId));
+    if(end == 0 || startIndex == end || endIndex == end)
+        return 0;
+    return endIndex - startIndex + 1;
+}
+
+static size_t
+getDateTimeMatch_backend_compressed(UA_Server *server, void *context,
+                                    const UA_NodeId *sessionId,
+                                    void *sessionContext,
+                                    const UA_NodeId *nodeId,
+                                    const UA_DateTime timestamp,
+                                    const MatchStrategy strategy) {
+    UA_CompressedStoreContext *ctx = (UA_CompressedStoreContext*)context;
+    HistorySeries *series = findSeries(ctx, nodeId);
+    size_t end = seriesEnd(series);
+    if(end == 0)
+        return 0;
+    size_t lower = timeBound(ctx, series, timestamp, false);
+    const UA_DataValue *dv = getSample(ctx, series, lower);
+    UA_Boolean equal = (dv && sampleTime(dv) == timestamp);
+    switch(strategy) {
+    case MATCH_EQUAL:
+        return (equal) ? lower : end;
+    case MATCH_EQUAL_OR_AFTER:
+        return lower;
+    case MATCH_AFTER:
+        return (equal) ? timeBound(ctx, series, timestamp, true) : lower;
+    case MATCH_EQUAL_OR_BEFORE:
+        if(equal)
+            return lower;
+        /* Fall through */
+    case MATCH_BEFORE:
+        return (lower > 0) ? lower - 1 : end;
+    default:
+        return end;
+    }
+}
+
+static UA_Boolean
+boundSupported_backend_compressed(UA_Server *server, void *context,
+                                  const UA_NodeId *sessionId, void *sessionContext,
+                                  const UA_NodeId *nodeId) {
+    return true;
+}
+
+static UA_Boolean
+timestampsToReturnSupported_backend_compressed(UA_Server *server, void *context,
+                                               const UA_NodeId *sessionId,
+                                               void *sessionContext,
+                                               const UA_NodeId *nodeId,
+                                               const UA_TimestampsToReturn timestampsToReturn) {
+    UA_CompressedStoreContext *ctx = (UA_CompressedStoreContext*)context;
+    const UA_DataValue *first = getSample(ctx, findSeries(ctx, nodeId), 0);
+    if(!first)
+        return true;
+    if(timestampsToReturn == UA_TIMESTAMPSTORETURN_NEITHER
+       || timestampsToReturn == UA_TIMESTAMPSTORETURN_INVALID
+       || (timestampsToReturn == UA_TIMESTAMPSTORETURN_SERVER
+           && !first->hasServerTimestamp)
+       || (timestampsToReturn == UA_TIMESTAMPSTORETURN_SOURCE
+           && !first->hasSourceTimestamp)
+       || (timestampsToReturn == UA_TIMESTAMPSTORETURN_BOTH
+           && !(first->hasSourceTimestamp && first->hasServerTimestamp)))
+        return false;
+    return true;
+}
+
+static const UA_DataValue *
+getDataValue_backend_compressed(UA_Server *server, void *context,
+                                const UA_NodeId *sessionId, void *sessionContext,
+                                const UA_NodeId *nodeId, size_t index) {
+    UA_CompressedStoreContext *ctx = (UA_CompressedStoreContext*)context;
+    return getSample(ctx, findSeries(ctx, nodeId), index);
+}
+
+static UA_StatusCode
+copySample(const UA_DataValue *src, UA_DataValue *dst, const UA_NumericRange range) {
+    if(range.dimensionsSize == 0)
+        return UA_DataValue_copy(src, dst);
+    memcpy(dst, src, sizeof(UA_DataValue));
+    UA_Variant_init(&dst->value);
+    if(src->hasValue)
+        return UA_Variant_copyRange(&src->value, &dst->value, range);
+    return UA_STATUSCODE_BADDATAUNAVAILABLE;
+}
+
+static UA_StatusCode
+copyDataValues_backend_compressed(UA_Server *server, void *context,
+                                  const UA_NodeId *sessionId, void *sessionContext,
+                                  const UA_NodeId *nodeId,
+                                  size_t startIndex, size_t endIndex,
+                                  UA_Boolean reverse, size_t maxValues,
+                                  UA_NumericRange range,
+                                  UA_Boolean releaseContinuationPoints,
+                                  const UA_ByteString *continuationPoint,
+                                  UA_ByteString *outContinuationPoint,
+                                  size_t *providedValues, UA_DataValue *values) {
+    size_t skip = 0;
+    if(continuationPoint->length > 0) {
+        if(continuationPoint->length != sizeof(size_t))
+            return UA_STATUSCODE_BADCONTINUATIONPOINTINVALID;
+        memcpy(&skip, continuationPoint->data, sizeof(size_t));
+    }
+
+    UA_CompressedStoreContext *ctx = (UA_CompressedStoreContext*)context;
+    HistorySeries *series = findSeries(ctx, nodeId);
+    size_t end = seriesEnd(series);
+    size_t total = (reverse) ? startIndex - endIndex + 1 : endIndex - startIndex + 1;
+    size_t counter = 0;
+    for(size_t i = skip; i < total && counter < maxValues; i++) {
+        size_t index = (reverse) ? startIndex - i : startIndex + i;
+        if(index >= end)
+            break;
+        const UA_DataValue *dv = getSample(ctx, series, index);
+        if(!dv)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        copySample(dv, &values[counter], range);
+        counter++;
+    }
+
+    if(providedValues)
+        *providedValues = counter;
+
+    if(total > skip + counter) {
+        UA_StatusCode res = UA_ByteString_allocBuffer(outContinuationPoint, sizeof(size_t));
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+        size_t next = skip + counter;
+        memcpy(outContinuationPoint->data, &next, sizeof(size_t));
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+/* The cursor keeps the next index. A block is decoded only once when the
+ * cursor enters it. */
+typedef struct {
+    UA_NodeId nodeId;
+    size_t next;
+    size_t last;
+    UA_Boolean reverse;
+    UA_Boolean done;
+} CompressedCursor;
+
+static UA_StatusCode
+openCursor_backend_compressed(UA_Server *server, void *context,
+                              const UA_NodeId *sessionId, void *sessionContext,
+                              const UA_NodeId *nodeId, size_t startIndex,
+                              size_t endIndex, UA_Boolean reverse, void **cursor) {
+    CompressedCursor *cc = (CompressedCursor*)UA_calloc(1, sizeof(CompressedCursor));
+    if(!cc)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_StatusCode res = UA_NodeId_copy(nodeId, &cc->nodeId);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_free(cc);
+        return res;
+    }
+    cc->next = startIndex;
+    cc->last = endIndex;
+    cc->reverse = reverse;
+    cc->done = (reverse) ? startIndex < endIndex : startIndex > endIndex;
+    *cursor = cc;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+readCursor_backend_compressed(UA_Server *server, void *context, void *cursor,
+                              size_t maxValues, UA_NumericRange range,
+                              size_t *providedValues, UA_DataValue *values) {
+    UA_CompressedStoreContext *ctx = (UA_CompressedStoreContext*)context;
+    CompressedCursor *cc = (CompressedCursor*)cursor;
+    HistorySeries *series = findSeries(ctx, &cc->nodeId);
+    size_t end = seriesEnd(series);
+    const HistoryBlock *block = NULL;
+    const UA_DataValue *blockValues = NULL;
+    size_t counter = 0;
+    while(!cc->done && counter < maxValues && cc->next < end) {
+        if(!block || cc->next < block->startIndex ||
+           cc->next - block->startIndex >= block->count) {
+            block = &series->blocks[findBlockByIndex(series, cc->next)];
+            blockValues = getBlockValues(ctx, block);
+            if(!blockValues)
+                return UA_STATUSCODE_BADOUTOFMEMORY;
+        }
+        copySample(&blockValues[cc->next - block->startIndex], &values[counter], range);
+        counter++;
+        if(cc->next == cc->last)
+            cc->done = true;
+        else if(cc->reverse)
+            cc->next--;
+        else
+            cc->next++;
+    }
+    *providedValues = counter;
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+closeCursor_backend_compressed(UA_Server *server, void *context, void *cursor) {
+    CompressedCursor *cc = (CompressedCursor*)cursor;
+    UA_NodeId_clear(&cc->nodeId);
+    UA_free(cc);
+}
+
+static UA_StatusCode
+insertDataValue_backend_compressed(UA_Server *server, void *hdbContext,
+                                   const UA_NodeId *sessionId, void *sessionContext,
+                                   const UA_NodeId *nodeId, const UA_DataValue *value) {
+    if(!value->hasSourceTimestamp && !value->hasServerTimestamp)
+        return UA_STATUSCODE_BADINVALIDTIMESTAMP;
+    UA_DateTime t = (value->hasSourceTimestamp) ?
+        value->sourceTimestamp : value->serverTimestamp;
+    UA_CompressedStoreContext *ctx = (UA_CompressedStoreContext*)hdbContext;
+    HistorySeries *series = getOrCreateSeries(ctx, nodeId);
+    if(!series)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    const UA_DataValue *existing =
+        getSample(ctx, series, timeBound(ctx, series, t, false));
+    if(existing && sampleTime(existing) == t)
+        return UA_STATUSCODE_BADENTRYEXISTS;
+    UA_DataValue dv;
+    prepareSample(&dv, value, t);
+    return insertSample(ctx, series, &dv);
+}
+
+static UA_StatusCode
+replaceDataValue_backend_compressed(UA_Server *server, void *hdbContext,
+                                    const UA_NodeId *sessionId, void *sessionContext,
+                                    const UA_NodeId *nodeId, const UA_DataValue *value) {
+    if(!value->hasSourceTimestamp && !value->hasServerTimestamp)
+        return UA_STATUSCODE_BADINVALIDTIMESTAMP;
+    UA_DateTime t = (value->hasSourceTimestamp) ?
+        value->sourceTimestamp : value->serverTimestamp;
+    UA_CompressedStoreContext *ctx = (UA_CompressedStoreContext*)hdbContext;
+    HistorySeries *series = findSeries(ctx, nodeId);
+    if(!series)
+        return UA_STATUSCODE_BADNOENTRYEXISTS;
+    size_t index = timeBound(ctx, series, t, false);
+    const UA_DataValue *existing = getSample(ctx, series, index);
+    if(!existing || sampleTime(existing) != t)
+        return UA_STATUSCODE_BADNOENTRYEXISTS;
+
+    size_t b = findBlockByIndex(series, index);
+    HistoryBlock *block = &series->blocks[b];
+    UA_UInt32 count = block->count;
+    UA_DataValue *values = NULL;
+    UA_StatusCode res = copyBlockValues(ctx, block, &values);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    size_t pos = index - block->startIndex;
+    UA_DataValue dv;
+    prepareSample(&dv, value, t);
+    UA_DataValue_clear(&values[pos]);
+    res = UA_DataValue_copy(&dv, &values[pos]);
+    if(res == UA_STATUSCODE_GOOD)
+        res = rebuildBlock(ctx, series, b, values, count);
+    UA_Array_delete(values, count + 1, &UA_TYPES[UA_TYPES_DATAVALUE]);
+    return res;
+}
+
+static UA_StatusCode
+updateDataValue_backend_compressed(UA_Server *server, void *hdbContext,
+                                   const UA_NodeId *sessionId, void *sessionContext,
+                                   const UA_NodeId *nodeId, const UA_DataValue *value) {
+    UA_StatusCode ret =
+        replaceDataValue_backend_compressed(server, hdbContext, sessionId,
+                                            sessionContext, nodeId, value);
+    if(ret == UA_STATUSCODE_GOOD)
+        return UA_STATUSCODE_GOODENTRYREPLACED;
+    ret = insertDataValue_backend_compressed(server, hdbContext, sessionId,
+                                             sessionContext, nodeId, value);
+    if(ret == UA_STATUSCODE_GOOD)
+        return UA_STATUSCODE_GOODENTRYINSERTED;
+    return ret;
+}
+
+static UA_StatusCode
+removeDataValue_backend_compressed(UA_Server *server, void *hdbContext,
+                                   const UA_NodeId *sessionId, void *sessionContext,
+                                   const UA_NodeId *nodeId,
+                                   UA_DateTime startTimestamp,
+                                   UA_DateTime endTimestamp) {
+    if(startTimestamp > endTimestamp)
+        return UA_STATUSCODE_BADTIMESTAMPNOTSUPPORTED;
+    UA_CompressedStoreContext *ctx = (UA_CompressedStoreContext*)hdbContext;
+    HistorySeries *series = findSeries(ctx, nodeId);
+    if(!series)
+        return UA_STATUSCODE_BADNODATA;
+
+    /* Same semantics as the memory backend. A single timestamp is removed if
+     * start and end are equal. Otherwise the end is exclusive. */
+    size_t start = timeBound(ctx, series, startTimestamp, false);
+    size_t end;
+    if(startTimestamp == endTimestamp) {
+        const UA_DataValue *dv = getSample(ctx, series, start);
+        if(!dv || sampleTime(dv) != startTimestamp)
+            return UA_STATUSCODE_BADNODATA;
+        end = start + 1;
+    } else {
+        end = timeBound(ctx, series, endTimestamp, false);
+        if(start >= end)
+            return UA_STATUSCODE_BADNODATA;
+    }
+    return removeSamples(ctx, series, start, end);
+}
+
+static void
+UA_CompressedStoreContext_delete(UA_CompressedStoreContext *ctx) {
+    ZIP_ITER(HistorySeriesTree, &ctx->series, deleteHistorySeries, NULL);
+    invalidateCache(ctx);
+    UA_free(ctx);
+}
+
+static void
+deleteMembers_backend_compressed(UA_HistoryDataBackend *backend) {
+    if(backend == NULL || backend->context == NULL)
+        return;
+    UA_CompressedStoreContext_delete((UA_CompressedStoreContext*)backend->context);
+    backend->context = NULL;
+}
+
+static UA_Boolean
+numericSample(const UA_DataValue *dv, UA_Double *out) {
+    if(!dv->hasValue || !UA_Variant_isScalar(&dv->value))
+        return false;
+    const void *p = dv->value.data;
+    switch(dv->value.type->typeKind) {
+    case UA_DATATYPEKIND_SBYTE: *out = *(const UA_SByte*)p; return true;
+    case UA_DATATYPEKIND_BYTE: *out = *(const UA_Byte*)p; return true;
+    case UA_DATATYPEKIND_INT16: *out = *(const UA_Int16*)p; return true;
+    case UA_DATATYPEKIND_UINT16: *out = *(const UA_UInt16*)p; return true;
+    case UA_DATATYPEKIND_INT32: *out = *(const UA_Int32*)p; return true;
+    case UA_DATATYPEKIND_UINT32: *out = *(const UA_UInt32*)p; return true;
+    case UA_DATATYPEKIND_INT64: *out = (UA_Double)*(const UA_Int64*)p; return true;
+    case UA_DATATYPEKIND_UINT64: *out = (UA_Double)*(const UA_UInt64*)p; return true;
+    case UA_DATATYPEKIND_FLOAT: *out = *(const UA_Float*)p; return true;
+    case UA_DATATYPEKIND_DOUBLE: *out = *(const UA_Double*)p; return true;
+    default: return false;
+    }
+}
+
+static void
+addToSummary(UA_HistoryAggregateSummary *s, const UA_DataValue *dv) {
+    if(dv->hasStatus && !UA_StatusCode_isGood(dv->status))
+        return;
+    s->count++;
+    UA_Double v;
+    if(!numericSample(dv, &v))
+        return;
+    if(s->numericCount == 0 || v < s->min)
+        s->min = v;
+    if(s->numericCount == 0 || v > s->max)
+        s->max = v;
+    s->sum += v;
+    s->numericCount++;
+}
+
+static void
+mergeSummary(UA_HistoryAggregateSummary *s, const UA_HistoryAggregateSummary *add) {
+    s->count += add->count;
+    if(add->numericCount == 0)
+        return;
+    if(s->numericCount == 0 || add->min < s->min)
+        s->min = add->min;
+    if(s->numericCount == 0 || add->max > s->max)
+        s->max = add->max;
+    s->sum += add->sum;
+    s->numericCount += add->numericCount;
+}
+
+/* Blocks that lie completely in the range use the cached rollup. Only the
+ * blocks at the bounds of the range are decoded. */
+static UA_StatusCode
+summarizeBlock(UA_CompressedStoreContext *ctx, HistoryBlock *block,
+               UA_DateTime start, UA_DateTime end, UA_HistoryAggregateSummary *s) {
+    UA_Boolean whole = (block->firstTime >= start && block->lastTime < end);
+    if(whole && block->summaryId == block->id) {
+        mergeSummary(s, &block->summary);
+        return UA_STATUSCODE_GOOD;
+    }
+    const UA_DataValue *values = getBlockValues(ctx, block);
+    if(!values)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_HistoryAggregateSummary bs;
+    memset(&bs, 0, sizeof(UA_HistoryAggregateSummary));
+    for(UA_UInt32 i = 0; i < block->count; i++) {
+        UA_DateTime t = sampleTime(&values[i]);
+        if(t >= start && t < end)
+            addToSummary(&bs, &values[i]);
+    }
+    if(whole) {
+        block->summary = bs;
+        block->summaryId = block->id;
+    }
+    mergeSummary(s, &bs);
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+getAggregateSummary_backend_compressed(UA_Server *server, void *context,
+                                       const UA_NodeId *sessionId,
+                                       void *sessionContext,
+                                       const UA_NodeId *nodeId,
+                                       UA_DateTime start, UA_DateTime end,
+                                       UA_HistoryAggregateSummary *summary) {
+    UA_CompressedStoreContext *ctx = (UA_CompressedStoreContext*)context;
+    memset(summary, 0, sizeof(UA_HistoryAggregateSummary));
+    HistorySeries *series = findSeries(ctx, nodeId);
+    if(!series)
+        return UA_STATUSCODE_GOOD;
+    for(size_t b = findBlockByTime(series, start, false);
+        b < series->blocksSize && series->blocks[b].firstTime < end; b++) {
+        UA_StatusCode res = summarizeBlock(ctx, &series->blocks[b], start, end, summary);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_HistoryDataBackend
+UA_HistoryDataBackend_Compressed(size_t samplesPerBlock) {
+    if(samplesPerBlock == 0)
+        samplesPerBlock = UA_HISTORY_COMPRESSED_BLOCKSIZE;
+    if(samplesPerBlock > UA_UINT32_MAX)
+        samplesPerBlock = UA_UINT32_MAX;
+    UA_HistoryDataBackend result;
+    memset(&result, 0, sizeof(UA_HistoryDataBackend));
+    UA_CompressedStoreContext *ctx = (UA_CompressedStoreContext*)
+        UA_calloc(1, sizeof(UA_CompressedStoreContext));
+    if(!ctx)
+        return result;
+    ctx->samplesPerBlock = (UA_UInt32)samplesPerBlock;
+    result.serverSetHistoryData = &serverSetHistoryData_backend_compressed;
+    result.resultSize = &resultSize_backend_compressed;
+    result.getEnd = &getEnd_backend_compressed;
+    result.lastIndex = &lastIndex_backend_compressed;
+    result.firstIndex = &firstIndex_backend_compressed;
+    result.getDateTimeMatch = &getDateTimeMatch_backend_compressed;
+    result.copyDataValues = &copyDataValues_backend_compressed;
+    result.openCursor = &openCursor_backend_compressed;
+    result.readCursor = &readCursor_backend_compressed;
+    result.closeCursor = &closeCursor_backend_compressed;
+    result.getDataValue = &getDataValue_backend_compressed;
+    result.boundSupported = &boundSupported_backend_compressed;
+    result.timestampsToReturnSupported = &timestampsToReturnSupported_backend_compressed;
+    result.insertDataValue = &insertDataValue_backend_compressed;
+    result.updateDataValue = &updateDataValue_backend_compressed;
+    result.replaceDataValue = &replaceDataValue_backend_compressed;
+    result.removeDataValue = &removeDataValue_backend_compressed;
+    result.getAggregateSummary = &getAggregateSummary_backend_compressed;
+    result.deleteMembers = &deleteMembers_backend_compressed;
+    result.getHistoryData = NULL;
+    result.context = ctx;
+    return result;
+}
+
+static void *
+addSeriesMemory(void *context, HistorySeries *series) {
+    size_t *usage = (size_t*)context;
+    *usage += sizeof(HistorySeries) + series->blocksCapacity * sizeof(HistoryBlock);
+    for(size_t i = 0; i < series->blocksSize; i++) {
+        const HistoryBlock *block = &series->blocks[i];
+        *usage += block->bits.size;
+        if(!block->raw)
+            continue;
+        *usage += block->valuesCapacity * sizeof(UA_DataValue);
+        for(UA_UInt32 j = 0; j < block->count; j++)
+            *usage += UA_calcSizeBinary(&block->values[j], &UA_TYPES[UA_TYPES_DATAVALUE]);
+    }
+    return NULL;
+}
+
+size_t
+UA_HistoryDataBackend_Compressed_memoryUsage(const UA_HistoryDataBackend *backend) {
+    UA_CompressedStoreContext *ctx = (UA_CompressedStoreContext*)backend->context;
+    size_t usage = 0;
+    if(ctx)
+        ZIP_ITER(HistorySeriesTree, &ctx->series, addSeriesMemory, &usage);
+    return usage;
+}
+
+void
+UA_HistoryDataBackend_Compressed_clear(UA_HistoryDataBackend *backend) {
+    deleteMembers_backend_compressed(backend);
+    memset(backend, 0, sizeof(UA_HistoryDataBackend));
+}
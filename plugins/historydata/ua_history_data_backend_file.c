@@ -0,0 +1,1252 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <open62541/plugin/historydata/history_data_backend_file.h>
+
+#ifdef UA_ARCHITECTURE_POSIX
+
+#include "ziptree.h"
+#include "mp_printf.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Segment file layout:
+ *
+ * - Header: Magic "UAHS", UInt32 version, Int64 segmentDuration
+ * - Records: UInt32 record length (including the record header), Byte kind,
+ *   Int64 time, Int64 time2, the binary-encoded NodeId and (for samples) the
+ *   binary-encoded DataValue.
+ *
+ * The integers of the headers are little-endian. Every record only affects the
+ * samples in the time window of its segment. So the segments can be replayed
+ * (and compacted) independently. */
+
+#define SEGMENT_HEADER_SIZE 16
+#define SEGMENT_VERSION 1
+#define SEGMENT_SUFFIX ".seg"
+#define RECORD_HEADER_SIZE 21
+
+#define RECORD_SAMPLE  1 /* Insert after the samples with the same time */
+#define RECORD_REPLACE 2 /* Replace the first sample with the same time */
+#define RECORD_REMOVE  3 /* Remove the first sample at time if time == time2,
+                          * otherwise all samples in [time, time2) */
+
+#define FILE_DEFAULT_SEGMENTDURATION (3600 * UA_DATETIME_SEC)
+#define FILE_DEFAULT_COMMITSAMPLES 256
+
+static void
+writeUInt32(UA_Byte *p, UA_UInt32 v) {
+    for(size_t i = 0; i < 4; i++)
+        p[i] = (UA_Byte)(v >> (8 * i));
+}
+
+static void
+writeInt64(UA_Byte *p, UA_Int64 v) {
+    for(size_t i = 0; i < 8; i++)
+        p[i] = (UA_Byte)((UA_UInt64)v >> (8 * i));
+}
+
+static UA_UInt32
+readUInt32(const UA_Byte *p) {
+    UA_UInt32 v = 0;
+    for(size_t i = 0; i < 4; i++)
+        v |= ((UA_UInt32)p[i]) << (8 * i);
+    return v;
+}
+
+static UA_Int64
+readInt64(const UA_Byte *p) {
+    UA_UInt64 v = 0;
+    for(size_t i = 0; i < 8; i++)
+        v |= ((UA_UInt64)p[i]) << (8 * i);
+    return (UA_Int64)v;
+}
+
+/**********/
+/* Series */
+/**********/
+
+typedef struct {
+    UA_DateTime time;
+    UA_UInt64 offset; /* Of the record in the segment file */
+} FileEntry;
+
+typedef struct FileSeries {
+    ZIP_ENTRY(FileSeries) zipfields;
+    UA_UInt32 nodeIdHash;
+    UA_NodeId nodeId;
+    size_t nodeIdSize; /* Encoded size of the NodeId in the records */
+    FileEntry *entries; /* Ordered by time */
+    size_t entriesSize;
+    size_t entriesCapacity;
+} FileSeries;
+
+static enum ZIP_CMP
+cmpFileSeries(const void *a, const void *b) {
+    const FileSeries *aa = (const FileSeries*)a;
+    const FileSeries *bb = (const FileSeries*)b;
+    if(aa->nodeIdHash != bb->nodeIdHash)
+        return (aa->nodeIdHash < bb->nodeIdHash) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+    return (enum ZIP_CMP)UA_NodeId_order(&aa->nodeId, &bb->nodeId);
+}
+
+typedef ZIP_HEAD(FileSeriesTree, FileSeries) FileSeriesTree;
+ZIP_FUNCTIONS(FileSeriesTree, FileSeries, zipfields,
+              FileSeries, zipfields, cmpFileSeries)
+
+/* Index of the first entry with time >= t (or > t if strict) */
+static size_t
+entryBound(const FileSeries *series, UA_DateTime t, UA_Boolean strict) {
+    size_t min = 0;
+    size_t max = series->entriesSize;
+    while(min < max) {
+        size_t mid = (min + max) / 2;
+        UA_DateTime mt = series->entries[mid].time;
+        if(mt < t || (strict && mt == t))
+            min = mid + 1;
+        else
+            max = mid;
+    }
+    return min;
+}
+
+static UA_StatusCode
+insertEntry(FileSeries *series, UA_DateTime t, UA_UInt64 offset) {
+    if(series->entriesSize == series->entriesCapacity) {
+        size_t capacity = (series->entriesCapacity == 0) ?
+            64 : series->entriesCapacity * 2;
+        FileEntry *entries = (FileEntry*)
+            UA_realloc(series->entries, capacity * sizeof(FileEntry));
+        if(!entries)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        series->entries = entries;
+        series->entriesCapacity = capacity;
+    }
+    size_t pos = entryBound(series, t, true);
+    memmove(&series->entries[pos + 1], &series->entries[pos],
+            (series->entriesSize - pos) * sizeof(FileEntry));
+    series->entries[pos].time = t;
+    series->entries[pos].offset = offset;
+    series->entriesSize++;
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+removeEntries(FileSeries *series, size_t from, size_t to) {
+    memmove(&series->entries[from], &series->entries[to],
+            (series->entriesSize - to) * sizeof(FileEntry));
+    series->entriesSize -= to - from;
+}
+
+/************/
+/* Segments */
+/************/
+
+typedef struct {
+    UA_Int64 window; /* Covers [window * duration, (window + 1) * duration) */
+    int fd;
+    UA_Byte *map;
+    size_t mapLength;
+    size_t fileLength; /* Bytes written to the file */
+
+    /* Records that are not yet written. They are located after fileLength. */
+    UA_Byte *pending;
+    size_t pendingLength;
+    size_t pendingCapacity;
+    UA_Boolean unsynced; /* Written but not yet synced */
+
+    size_t records;
+    size_t deadRecords; /* Replaced and removed samples, remove records */
+} FileSegment;
+
+typedef struct {
+    char *directory;
+    UA_HistoryDataBackendFileOptions options;
+    FileSeriesTree series;
+    FileSegment *segments; /* Ordered by the window */
+    size_t segmentsSize;
+    size_t pendingRecords;
+    UA_DataValue current; /* Returned by getDataValue */
+} UA_FileStoreContext;
+
+static UA_Int64
+windowOf(const UA_FileStoreContext *ctx, UA_DateTime t) {
+    UA_Int64 d = ctx->options.segmentDuration;
+    UA_Int64 w = t / d;
+    if(t % d != 0 && t < 0)
+        w--; /* Round towards negative infinity */
+    return w;
+}
+
+/* The decimal window has at most 20 characters including the sign */
+static char *
+segmentPath(const UA_FileStoreContext *ctx, UA_Int64 window, const char *suffix) {
+    size_t len = strlen(ctx->directory) + 1 + 20 +
+        strlen(SEGMENT_SUFFIX) + strlen(suffix) + 1;
+    char *path = (char*)UA_malloc(len);
+    if(!path)
+        return NULL;
+    int res = mp_snprintf(path, len, "%s/%lld%s%s", ctx->directory,
+                          (long long)window, SEGMENT_SUFFIX, suffix);
+    if(res < 0 || (size_t)res >= len) {
+        UA_free(path);
+        return NULL;
+    }
+    return path;
+}
+
+/* Binary search. Returns the insert position if not found. */
+static FileSegment *
+findSegment(UA_FileStoreContext *ctx, UA_Int64 window, size_t *pos) {
+    size_t min = 0;
+    size_t max = ctx->segmentsSize;
+    while(min < max) {
+        size_t mid = (min + max) / 2;
+        if(ctx->segments[mid].window < window)
+            min = mid + 1;
+        else
+            max = mid;
+    }
+    if(pos)
+        *pos = min;
+    if(min < ctx->segmentsSize && ctx->segments[min].window == window)
+        return &ctx->segments[min];
+    return NULL;
+}
+
+static UA_StatusCode
+writeAll(int fd, const UA_Byte *data, size_t length) {
+    while(length > 0) {
+        ssize_t n = write(fd, data, length);
+        if(n <= 0)
+            return UA_STATUSCODE_BADINTERNALERROR;
+        data += n;
+        length -= (size_t)n;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Map the file up to the written length */
+static UA_StatusCode
+mapSegment(FileSegment *seg) {
+    if(seg->mapLength == seg->fileLength)
+        return UA_STATUSCODE_GOOD;
+    if(seg->map)
+        munmap(seg->map, seg->mapLength);
+    seg->map = NULL;
+    seg->mapLength = 0;
+    void *map = mmap(NULL, seg->fileLength, PROT_READ, MAP_SHARED, seg->fd, 0);
+    if(map == MAP_FAILED)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    seg->map = (UA_Byte*)map;
+    seg->mapLength = seg->fileLength;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Returns the bytes from the offset until the end of the segment. Records that
+ * are not yet written are read from the pending buffer. */
+static UA_StatusCode
+segmentData(FileSegment *seg, UA_UInt64 offset, UA_ByteString *buf) {
+    if(offset >= seg->fileLength) {
+        size_t pos = (size_t)(offset - seg->fileLength);
+        if(pos >= seg->pendingLength)
+            return UA_STATUSCODE_BADINTERNALERROR;
+        buf->data = &seg->pending[pos];
+        buf->length = seg->pendingLength - pos;
+        return UA_STATUSCODE_GOOD;
+    }
+    UA_StatusCode res = mapSegment(seg);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    buf->data = &seg->map[offset];
+    buf->length = seg->mapLength - (size_t)offset;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+writeOutSegment(FileSegment *seg) {
+    if(seg->pendingLength == 0)
+        return UA_STATUSCODE_GOOD;
+    UA_StatusCode res = writeAll(seg->fd, seg->pending, seg->pendingLength);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    seg->fileLength += seg->pendingLength;
+    seg->pendingLength = 0;
+    seg->unsynced = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+syncSegment(FileSegment *seg) {
+    UA_StatusCode res = writeOutSegment(seg);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    if(seg->unsynced && fsync(seg->fd) != 0)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    seg->unsynced = false;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+commitSegments(UA_FileStoreContext *ctx) {
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    for(size_t i = 0; i < ctx->segmentsSize; i++)
+        res |= syncSegment(&ctx->segments[i]);
+    if(res != UA_STATUSCODE_GOOD)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    ctx->pendingRecords = 0;
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+closeSegment(FileSegment *seg) {
+    if(seg->map)
+        munmap(seg->map, seg->mapLength);
+    if(seg->fd >= 0)
+        close(seg->fd);
+    UA_free(seg->pending);
+    memset(seg, 0, sizeof(FileSegment));
+    seg->fd = -1;
+}
+
+static UA_StatusCode
+addSegment(UA_FileStoreContext *ctx, size_t pos, UA_Int64 window, int fd,
+           size_t fileLength) {
+    FileSegment *segments = (FileSegment*)
+        UA_realloc(ctx->segments, (ctx->segmentsSize + 1) * sizeof(FileSegment));
+    if(!segments)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    ctx->segments = segments;
+    memmove(&segments[pos + 1], &segments[pos],
+            (ctx->segmentsSize - pos) * sizeof(FileSegment));
+    ctx->segmentsSize++;
+    FileSegment *seg = &segments[pos];
+    memset(seg, 0, sizeof(FileSegment));
+    seg->window = window;
+    seg->fd = fd;
+    seg->fileLength = fileLength;
+    return UA_STATUSCODE_GOOD;
+}
+
+static FileSegment *
+getOrCreateSegment(UA_FileStoreContext *ctx, UA_Int64 window) {
+    size_t pos;
+    FileSegment *seg = findSegment(ctx, window, &pos);
+    if(seg)
+        return seg;
+
+    char *path = segmentPath(ctx, window, "");
+    if(!path)
+        return NULL;
+    int fd = open(path, O_RDWR | O_CREAT | O_EXCL | O_APPEND, 0644);
+    UA_free(path);
+    if(fd < 0)
+        return NULL;
+
+    UA_Byte header[SEGMENT_HEADER_SIZE];
+    memcpy(header, "UAHS", 4);
+    writeUInt32(&header[4], SEGMENT_VERSION);
+    writeInt64(&header[8], ctx->options.segmentDuration);
+    if(writeAll(fd, header, SEGMENT_HEADER_SIZE) != UA_STATUSCODE_GOOD ||
+       addSegment(ctx, pos, window, fd, SEGMENT_HEADER_SIZE) != UA_STATUSCODE_GOOD) {
+        close(fd);
+        return NULL;
+    }
+    return &ctx->segments[pos];
+}
+
+/* Append a record to the pending buffer. The records are written in groups. */
+static UA_StatusCode
+appendRecord(UA_FileStoreContext *ctx, FileSegment *seg, UA_Byte kind,
+             UA_DateTime time, UA_DateTime time2, const UA_NodeId *nodeId,
+             const UA_DataValue *value, UA_UInt64 *offset) {
+    size_t nodeIdSize = UA_calcSizeBinary(nodeId, &UA_TYPES[UA_TYPES_NODEID]);
+    size_t valueSize = (value) ?
+        UA_calcSizeBinary(value, &UA_TYPES[UA_TYPES_DATAVALUE]) : 0;
+    size_t length = RECORD_HEADER_SIZE + nodeIdSize + valueSize;
+    if(nodeIdSize == 0 || (value && valueSize == 0) || length > UA_UINT32_MAX)
+        return UA_STATUSCODE_BADENCODINGERROR;
+
+    if(seg->pendingLength + length > seg->pendingCapacity) {
+        size_t capacity = (seg->pendingCapacity == 0) ? 4096 : seg->pendingCapacity;
+        while(capacity < seg->pendingLength + length)
+            capacity *= 2;
+        UA_Byte *pending = (UA_Byte*)UA_realloc(seg->pending, capacity);
+        if(!pending)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        seg->pending = pending;
+        seg->pendingCapacity = capacity;
+    }
+
+    UA_Byte *p = &seg->pending[seg->pendingLength];
+    writeUInt32(p, (UA_UInt32)length);
+    p[4] = kind;
+    writeInt64(&p[5], time);
+    writeInt64(&p[13], time2);
+    UA_ByteString buf = {nodeIdSize, &p[RECORD_HEADER_SIZE]};
+    UA_StatusCode res = UA_encodeBinary(nodeId, &UA_TYPES[UA_TYPES_NODEID], &buf);
+    if(value) {
+        buf.data = &p[RECORD_HEADER_SIZE + nodeIdSize];
+        buf.length = valueSize;
+        res |= UA_encodeBinary(value, &UA_TYPES[UA_TYPES_DATAVALUE], &buf);
+    }
+    if(res != UA_STATUSCODE_GOOD)
+        return UA_STATUSCODE_BADENCODINGERROR;
+
+    if(offset)
+        *offset = seg->fileLength + seg->pendingLength;
+    seg->pendingLength += length;
+    seg->records++;
+
+    /* Group commit */
+    ctx->pendingRecords++;
+    if(ctx->pendingRecords >= ctx->options.commitSamples)
+        return commitSegments(ctx);
+    return UA_STATUSCODE_GOOD;
+}
+
+/***********/
+/* Context */
+/***********/
+
+static FileSeries *
+findSeries(UA_FileStoreContext *ctx, const UA_NodeId *nodeId) {
+    FileSeries dummy;
+    dummy.nodeIdHash = UA_NodeId_hash(nodeId);
+    dummy.nodeId = *nodeId;
+    return ZIP_FIND(FileSeriesTree, &ctx->series, &dummy);
+}
+
+static FileSeries *
+getOrCreateSeries(UA_FileStoreContext *ctx, const UA_NodeId *nodeId) {
+    FileSeries *series = findSeries(ctx, nodeId);
+    if(series)
+        return series;
+    series = (FileSeries*)UA_calloc(1, sizeof(FileSeries));
+    if(!series)
+        return NULL;
+    if(UA_NodeId_copy(nodeId, &series->nodeId) != UA_STATUSCODE_GOOD) {
+        UA_free(series);
+        return NULL;
+    }
+    series->nodeIdHash = UA_NodeId_hash(nodeId);
+    series->nodeIdSize = UA_calcSizeBinary(nodeId, &UA_TYPES[UA_TYPES_NODEID]);
+    ZIP_INSERT(FileSeriesTree, &ctx->series, series);
+    return series;
+}
+
+static void *
+deleteFileSeries(void *context, FileSeries *series) {
+    UA_NodeId_clear(&series->nodeId);
+    UA_free(series->entries);
+    UA_free(series);
+    return NULL;
+}
+
+static UA_StatusCode
+decodeRecord(FileSegment *seg, const FileSeries *series,
+             const FileEntry *entry, UA_DataValue *value) {
+    UA_ByteString buf;
+    UA_StatusCode res =
+        segmentData(seg, entry->offset + RECORD_HEADER_SIZE + series->nodeIdSize, &buf);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    return UA_decodeBinary(&buf, value, &UA_TYPES[UA_TYPES_DATAVALUE], NULL);
+}
+
+static UA_StatusCode
+decodeEntry(UA_FileStoreContext *ctx, const FileSeries *series,
+            const FileEntry *entry, UA_DataValue *value) {
+    FileSegment *seg = findSegment(ctx, windowOf(ctx, entry->time), NULL);
+    if(!seg)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    return decodeRecord(seg, series, entry, value);
+}
+
+/* Apply a record to the index. Used for writing and for the replay. */
+static UA_StatusCode
+applyRecord(FileSegment *seg, FileSeries *series, UA_Byte kind,
+            UA_DateTime time, UA_DateTime time2, UA_UInt64 offset) {
+    size_t index;
+    switch(kind) {
+    case RECORD_SAMPLE:
+        return insertEntry(series, time, offset);
+    case RECORD_REPLACE:
+        index = entryBound(series, time, false);
+        if(index == series->entriesSize || series->entries[index].time != time)
+            return UA_STATUSCODE_BADNOENTRYEXISTS;
+        series->entries[index].offset = offset;
+        seg->deadRecords++;
+        return UA_STATUSCODE_GOOD;
+    case RECORD_REMOVE: {
+        size_t from = entryBound(series, time, false);
+        size_t to;
+        if(time == time2)
+            to = (from < series->entriesSize &&
+                  series->entries[from].time == time) ? from + 1 : from;
+        else
+            to = entryBound(series, time2, false);
+        removeEntries(series, from, to);
+        seg->deadRecords += to - from + 1;
+        return UA_STATUSCODE_GOOD;
+    }
+    default:
+        return UA_STATUSCODE_BADDECODINGERROR;
+    }
+}
+
+/* Scan the records of a segment file. A truncated record at the end (from an
+ * interrupted write) is cut off. */
+static UA_StatusCode
+loadSegment(UA_FileStoreContext *ctx, UA_Int64 window) {
+    size_t pos;
+    if(findSegment(ctx, window, &pos))
+        return UA_STATUSCODE_GOOD;
+
+    char *path = segmentPath(ctx, window, "");
+    if(!path)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    int fd = open(path, O_RDWR | O_APPEND);
+    UA_free(path);
+    if(fd < 0)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size < SEGMENT_HEADER_SIZE) {
+        close(fd);
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+    UA_StatusCode res = addSegment(ctx, pos, window, fd, (size_t)st.st_size);
+    if(res != UA_STATUSCODE_GOOD) {
+        close(fd);
+        return res;
+    }
+    FileSegment *seg = &ctx->segments[pos];
+    res = mapSegment(seg);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    const UA_Byte *data = seg->map;
+    if(memcmp(data, "UAHS", 4) != 0 || readUInt32(&data[4]) != SEGMENT_VERSION ||
+       readInt64(&data[8]) != ctx->options.segmentDuration)
+        return UA_STATUSCODE_BADCONFIGURATIONERROR;
+
+    size_t offset = SEGMENT_HEADER_SIZE;
+    while(offset + RECORD_HEADER_SIZE <= seg->fileLength) {
+        const UA_Byte *p = &data[offset];
+        UA_UInt32 length = readUInt32(p);
+        if(length < RECORD_HEADER_SIZE || length > seg->fileLength - offset)
+            break;
+        UA_NodeId nodeId;
+        UA_ByteString buf = {length - RECORD_HEADER_SIZE, (UA_Byte*)(uintptr_t)&p[RECORD_HEADER_SIZE]};
+        if(UA_decodeBinary(&buf, &nodeId, &UA_TYPES[UA_TYPES_NODEID], NULL) !=
+           UA_STATUSCODE_GOOD)
+            break;
+        FileSeries *series = getOrCreateSeries(ctx, &nodeId);
+        UA_NodeId_clear(&nodeId);
+        if(!series)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        seg->records++;
+        res = applyRecord(seg, series, p[4], readInt64(&p[5]),
+                          readInt64(&p[13]), offset);
+        if(res == UA_STATUSCODE_BADOUTOFMEMORY)
+            return res;
+        offset += length;
+    }
+
+    /* Cut off an incomplete record */
+    if(offset < seg->fileLength) {
+        if(ftruncate(fd, (off_t)offset) != 0)
+            return UA_STATUSCODE_BADINTERNALERROR;
+        seg->fileLength = offset;
+        return mapSegment(seg);
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+loadDirectory(UA_FileStoreContext *ctx) {
+    DIR *dir = opendir(ctx->directory);
+    if(!dir)
+        return UA_STATUSCODE_BADNOTFOUND;
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    struct dirent *de;
+    while(res == UA_STATUSCODE_GOOD && (de = readdir(dir))) {
+        char *end = NULL;
+        long long window = strtoll(de->d_name, &end, 10);
+        if(end == de->d_name || strcmp(end, SEGMENT_SUFFIX) != 0)
+            continue;
+        res = loadSegment(ctx, (UA_Int64)window);
+    }
+    closedir(dir);
+    return res;
+}
+
+/* Write a record and apply it to the index */
+static UA_StatusCode
+writeRecord(UA_FileStoreContext *ctx, FileSeries *series, UA_Byte kind,
+            UA_DateTime time, UA_DateTime time2, const UA_DataValue *value) {
+    FileSegment *seg = getOrCreateSegment(ctx, windowOf(ctx, time));
+    if(!seg)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    UA_UInt64 offset = 0;
+    UA_StatusCode res = appendRecord(ctx, seg, kind, time, time2,
+                                     &series->nodeId, value, &offset);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    return applyRecord(seg, series, kind, time, time2, offset);
+}
+
+/* Set the server timestamp if it is missing. Returns the ordering time. The
+ * DataValue is a shallow copy. */
+static UA_DateTime
+prepareSample(UA_DataValue *dv, const UA_DataValue *value) {
+    *dv = *value;
+    UA_DateTime t;
+    if(value->hasSourceTimestamp)
+        t = value->sourceTimestamp;
+    else if(value->hasServerTimestamp)
+        t = value->serverTimestamp;
+    else
+        t = UA_DateTime_now();
+    if(!dv->hasServerTimestamp) {
+        dv->serverTimestamp = t;
+        dv->hasServerTimestamp = true;
+    }
+    return t;
+}
+
+/*****************************/
+/* Backend Interface Methods */
+/*****************************/
+
+static UA_StatusCode
+serverSetHistoryData_backend_file(UA_Server *server, void *context,
+                                  const UA_NodeId *sessionId, void *sessionContext,
+                                  const UA_NodeId *nodeId, UA_Boolean historizing,
+                                  const UA_DataValue *value) {
+    UA_FileStoreContext *ctx = (UA_FileStoreContext*)context;
+    FileSeries *series = getOrCreateSeries(ctx, nodeId);
+    if(!series)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_DataValue dv;
+    UA_DateTime t = prepareSample(&dv, value);
+    return writeRecord(ctx, series, RECORD_SAMPLE, t, t, &dv);
+}
+
+/* The batch is committed to disk at once */
+static UA_StatusCode
+serverSetHistoryDataBatch_backend_file(UA_Server *server, void *context,
+                                       size_t valuesSize, const UA_NodeId *nodeIds,
+                                       const UA_DataValue *values) {
+    UA_FileStoreContext *ctx = (UA_FileStoreContext*)context;
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    for(size_t i = 0; i < valuesSize; i++)
+        res |= serverSetHistoryData_backend_file(server, context, NULL, NULL,
+                                                 &nodeIds[i], true, &values[i]);
+    if(res != UA_STATUSCODE_GOOD)
+        res = UA_STATUSCODE_BADINTERNALERROR;
+    UA_StatusCode res2 = commitSegments(ctx);
+    return (res != UA_STATUSCODE_GOOD) ? res : res2;
+}
+
+static size_t
+getEnd_backend_file(UA_Server *server, void *context,
+                    const UA_NodeId *sessionId, void *sessionContext,
+                    const UA_NodeId *nodeId) {
+    FileSeries *series = findSeries((UA_FileStoreContext*)context, nodeId);
+    return (series) ? series->entriesSize : 0;
+}
+
+static size_t
+lastIndex_backend_file(UA_Server *server, void *context,
+                       const UA_NodeId *sessionId, void *sessionContext,
+                       const UA_NodeId *nodeId) {
+    FileSeries *series = findSeries((UA_FileStoreContext*)context, nodeId);
+    if(!series || series->entriesSize == 0)
+        return 0;
+    return series->entriesSize - 1;
+}
+
+static size_t
+firstIndex_backend_file(UA_Server *server, void *context,
+                        const UA_NodeId *sessionId, void *sessionContext,
+                        const UA_NodeId *nodeId) {
+    return 0;
+}
+
+static size_t
+resultSize_backend_file(UA_Server *server, void *context,
+                        const UA_NodeId *sessionId, void *sessionContext,
+                        const UA_NodeId *nodeId,
+                        size_t startIndex, size_t endIndex) {
+    FileSeries *series = findSeries((UA_FileStoreContext*)context, nodeId);
+    size_t end = (series) ? series->entriesSize : 0;
+    if(end == 0 || startIndex == end || endIndex == end)
+        return 0;
+    return endIndex - startIndex + 1;
+}
+
+static size_t
+getDateTimeMatch_backend_file(UA_Server *server, void *context,
+                              const UA_NodeId *sessionId, void *sessionContext,
+                              const UA_NodeId *nodeId, const UA_DateTime timestamp,
+                              const MatchStrategy strategy) {
+    FileSeries *series = findSeries((UA_FileStoreContext*)context, nodeId);
+    if(!series || series->entriesSize == 0)
+        return 0;
+    size_t end = series->entriesSize;
+    size_t lower = entryBound(series, timestamp, false);
+    UA_Boolean equal = (lower < end && series->entries[lower].time == timestamp);
+    switch(strategy) {
+    case MATCH_EQUAL:
+        return (equal) ? lower : end;
+    case MATCH_EQUAL_OR_AFTER:
+        return lower;
+    case MATCH_AFTER:
+        return entryBound(series, timestamp, true);
+    case MATCH_EQUAL_OR_BEFORE:
+        if(equal)
+            return lower;
+        /* Fall through */
+    case MATCH_BEFORE:
+        return (lower > 0) ? lower - 1 : end;
+    default:
+        return end;
+    }
+}
+
+static UA_Boolean
+boundSupported_backend_file(UA_Server *server, void *context,
+                            const UA_NodeId *sessionId, void *sessionContext,
+                            const UA_NodeId *nodeId) {
+    return true;
+}
+
+static const UA_DataValue *
+getDataValue_backend_file(UA_Server *server, void *context,
+                          const UA_NodeId *sessionId, void *sessionContext,
+                          const UA_NodeId *nodeId, size_t index) {
+    UA_FileStoreContext *ctx = (UA_FileStoreContext*)context;
+    FileSeries *series = findSeries(ctx, nodeId);
+    if(!series || index >= series->entriesSize)
+        return NULL;
+    UA_DataValue_clear(&ctx->current);
+    if(decodeEntry(ctx, series, &series->entries[index],
+                   &ctx->current) != UA_STATUSCODE_GOOD)
+        return NULL;
+    return &ctx->current;
+}
+
+static UA_Boolean
+timestampsToReturnSupported_backend_file(UA_Server *server, void *context,
+                                         const UA_NodeId *sessionId,
+                                         void *sessionContext,
+                                         const UA_NodeId *nodeId,
+                                         const UA_TimestampsToReturn timestampsToReturn) {
+    const UA_DataValue *first =
+        getDataValue_backend_file(server, context, sessionId, sessionContext, nodeId, 0);
+    if(!first)
+        return true;
+    if(timestampsToReturn == UA_TIMESTAMPSTORETURN_NEITHER
+       || timestampsToReturn == UA_TIMESTAMPSTORETURN_INVALID
+       || (timestampsToReturn == UA_TIMESTAMPSTORETURN_SERVER
+           && !first->hasServerTimestamp)
+       || (timestampsToReturn == UA_TIMESTAMPSTORETURN_SOURCE
+           && !first->hasSourceTimestamp)
+       || (timestampsToReturn == UA_TIMESTAMPSTORETURN_BOTH
+           && !(first->hasSourceTimestamp && first->hasServerTimestamp)))
+        return false;
+    return true;
+}
+
+static UA_StatusCode
+copyDataValues_backend_file(UA_Server *server, void *context,
+                            const UA_NodeId *sessionId, void *sessionContext,
+                            const UA_NodeId *nodeId,
+                            size_t startIndex, size_t endIndex,
+                            UA_Boolean reverse, size_t maxValues,
+                            UA_NumericRange range,
+                            UA_Boolean releaseContinuationPoints,
+                            const UA_ByteString *continuationPoint,
+                            UA_ByteString *outContinuationPoint,
+                            size_t *providedValues, UA_DataValue *values) {
+    size_t skip = 0;
+    if(continuationPoint->length > 0) {
+        if(continuationPoint->length != sizeof(size_t))
+            return UA_STATUSCODE_BADCONTINUATIONPOINTINVALID;
+        memcpy(&skip, continuationPoint->data, sizeof(size_t));
+    }
+
+    UA_FileStoreContext *ctx = (UA_FileStoreContext*)context;
+    FileSeries *series = findSeries(ctx, nodeId);
+    size_t end = (series) ? series->entriesSize : 0;
+    size_t total = (reverse) ? startIndex - endIndex + 1 : endIndex - startIndex + 1;
+    size_t counter = 0;
+    for(size_t i = skip; i < total && counter < maxValues; i++) {
+        size_t index = (reverse) ? startIndex - i : startIndex + i;
+        if(index >= end)
+            break;
+        /* Decode from the memory-mapped segment */
+        UA_DataValue *dv = &values[counter];
+        UA_StatusCode res = decodeEntry(ctx, series, &series->entries[index], dv);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+        if(range.dimensionsSize > 0) {
+            UA_Variant v = dv->value;
+            UA_Variant_init(&dv->value);
+            if(dv->hasValue)
+                UA_Variant_copyRange(&v, &dv->value, range);
+            UA_Variant_clear(&v);
+        }
+        counter++;
+    }
+
+    if(providedValues)
+        *providedValues = counter;
+
+    if(total > skip + counter) {
+        UA_StatusCode res = UA_ByteString_allocBuffer(outContinuationPoint, sizeof(size_t));
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+        size_t next = skip + counter;
+        memcpy(outContinuationPoint->data, &next, sizeof(size_t));
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+/* The cursor walks the index of the series. The segment is looked up only when
+ * the values cross into the next time window. */
+typedef struct {
+    UA_NodeId nodeId;
+    size_t next;
+    size_t last;
+    UA_Boolean reverse;
+    UA_Boolean done;
+} FileCursor;
+
+static UA_StatusCode
+openCursor_backend_file(UA_Server *server, void *context,
+                        const UA_NodeId *sessionId, void *sessionContext,
+                        const UA_NodeId *nodeId, size_t startIndex,
+                        size_t endIndex, UA_Boolean reverse, void **cursor) {
+    FileCursor *fc = (FileCursor*)UA_calloc(1, sizeof(FileCursor));
+    if(!fc)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_StatusCode res = UA_NodeId_copy(nodeId, &fc->nodeId);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_free(fc);
+        return res;
+    }
+    fc->next = startIndex;
+    fc->last = endIndex;
+    fc->reverse = reverse;
+    fc->done = (reverse) ? startIndex < endIndex : startIndex > endIndex;
+    *cursor = fc;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+readCursor_backend_file(UA_Server *server, void *context, void *cursor,
+                        size_t maxValues, UA_NumericRange range,
+                        size_t *providedValues, UA_DataValue *values) {
+    UA_FileStoreContext *ctx = (UA_FileStoreContext*)context;
+    FileCursor *fc = (FileCursor*)cursor;
+    FileSeries *series = findSeries(ctx, &fc->nodeId);
+    FileSegment *seg = NULL;
+    UA_Int64 window = 0;
+    size_t counter = 0;
+    while(!fc->done && series && counter < maxValues &&
+          fc->next < series->entriesSize) {
+        const FileEntry *entry = &series->entries[fc->next];
+        UA_Int64 w = windowOf(ctx, entry->time);
+        if(!seg || w != window) {
+            seg = findSegment(ctx, w, NULL);
+            window = w;
+            if(!seg)
+                return UA_STATUSCODE_BADINTERNALERROR;
+        }
+        UA_DataValue *dv = &values[counter];
+        UA_StatusCode res = decodeRecord(seg, series, entry, dv);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+        if(range.dimensionsSize > 0) {
+            UA_Variant v = dv->value;
+            UA_Variant_init(&dv->value);
+            if(dv->hasValue)
+                UA_Variant_copyRange(&v, &dv->value, range);
+            UA_Variant_clear(&v);
+        }
+        counter++;
+        if(fc->next == fc->last)
+            fc->done = true;
+        else if(fc->reverse)
+            fc->next--;
+        else
+            fc->next++;
+    }
+    *providedValues = counter;
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+closeCursor_backend_file(UA_Server *server, void *context, void *cursor) {
+    FileCursor *fc = (FileCursor*)cursor;
+    UA_NodeId_clear(&fc->nodeId);
+    UA_free(fc);
+}
+
+static UA_StatusCode
+insertDataValue_backend_file(UA_Server *server, void *hdbContext,
+                             const UA_NodeId *sessionId, void *sessionContext,
+                             const UA_NodeId *nodeId, const UA_DataValue *value) {
+    if(!value->hasSourceTimestamp && !value->hasServerTimestamp)
+        return UA_STATUSCODE_BADINVALIDTIMESTAMP;
+    UA_FileStoreContext *ctx = (UA_FileStoreContext*)hdbContext;
+    FileSeries *series = getOrCreateSeries(ctx, nodeId);
+    if(!series)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_DataValue dv;
+    UA_DateTime t = prepareSample(&dv, value);
+    size_t index = entryBound(series, t, false);
+    if(index < series->entriesSize && series->entries[index].time == t)
+        return UA_STATUSCODE_BADENTRYEXISTS;
+    return writeRecord(ctx, series, RECORD_SAMPLE, t, t, &dv);
+}
+
+static UA_StatusCode
+replaceDataValue_backend_file(UA_Server *server, void *hdbContext,
+                              const UA_NodeId *sessionId, void *sessionContext,
+                              const UA_NodeId *nodeId, const UA_DataValue *value) {
+    if(!value->hasSourceTimestamp && !value->hasServerTimestamp)
+        return UA_STATUSCODE_BADINVALIDTIMESTAMP;
+    UA_FileStoreContext *ctx = (UA_FileStoreContext*)hdbContext;
+    FileSeries *series = findSeries(ctx, nodeId);
+    if(!series)
+        return UA_STATUSCODE_BADNOENTRYEXISTS;
+    UA_DataValue dv;
+    UA_DateTime t = prepareSample(&dv, value);
+    size_t index = entryBound(series, t, false);
+    if(index == series->entriesSize || series->entries[index].time != t)
+        return UA_STATUSCODE_BADNOENTRYEXISTS;
+    return writeRecord(ctx, series, RECORD_REPLACE, t, t, &dv);
+}
+
+static UA_StatusCode
+updateDataValue_backend_file(UA_Server *server, void *hdbContext,
+                             const UA_NodeId *sessionId, void *sessionContext,
+                             const UA_NodeId *nodeId, const UA_DataValue *value) {
+    UA_StatusCode ret =
+        replaceDataValue_backend_file(server, hdbContext, sessionId,
+                                      sessionContext, nodeId, value);
+    if(ret == UA_STATUSCODE_GOOD)
+        return UA_STATUSCODE_GOODENTRYREPLACED;
+    ret = insertDataValue_backend_file(server, hdbContext, sessionId,
+                                       sessionContext, nodeId, value);
+    if(ret == UA_STATUSCODE_GOOD)
+        return UA_STATUSCODE_GOODENTRYINSERTED;
+    return ret;
+}
+
+static UA_StatusCode
+removeDataValue_backend_file(UA_Server *server, void *hdbContext,
+                             const UA_NodeId *sessionId, void *sessionContext,
+                             const UA_NodeId *nodeId,
+                             UA_DateTime startTimestamp,
+                             UA_DateTime endTimestamp) {
+    if(startTimestamp > endTimestamp)
+        return UA_STATUSCODE_BADTIMESTAMPNOTSUPPORTED;
+    UA_FileStoreContext *ctx = (UA_FileStoreContext*)hdbContext;
+    FileSeries *series = findSeries(ctx, nodeId);
+    if(!series)
+        return UA_STATUSCODE_BADNODATA;
+
+    /* Same semantics as the memory backend. A single sample is removed if
+     * start and end are equal. Otherwise the end is exclusive. */
+    size_t from = entryBound(series, startTimestamp, false);
+    if(startTimestamp == endTimestamp) {
+        if(from == series->entriesSize || series->entries[from].time != startTimestamp)
+            return UA_STATUSCODE_BADNODATA;
+        return writeRecord(ctx, series, RECORD_REMOVE,
+                           startTimestamp, startTimestamp, NULL);
+    }
+    size_t to = entryBound(series, endTimestamp, false);
+    if(from == to)
+        return UA_STATUSCODE_BADNODATA;
+
+    /* Write one remove record per affected segment, clipped to its window */
+    while(from < to) {
+        UA_DateTime ws = windowOf(ctx, series->entries[from].time) *
+            ctx->options.segmentDuration;
+        UA_DateTime we = ws + ctx->options.segmentDuration;
+        UA_DateTime t1 = (startTimestamp > ws) ? startTimestamp : ws;
+        UA_DateTime t2 = (endTimestamp < we) ? endTimestamp : we;
+        UA_StatusCode res = writeRecord(ctx, series, RECORD_REMOVE, t1, t2, NULL);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+        from = entryBound(series, t2, false);
+        to = entryBound(series, endTimestamp, false);
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+/***************/
+/* Maintenance */
+/***************/
+
+typedef struct {
+    UA_FileStoreContext *ctx;
+    FileSegment *seg;
+    int fd;                /* Write the live records to the file */
+    UA_UInt64 offset;      /* Offset in the new file */
+    UA_Boolean update;     /* Update the index to the new offsets */
+    UA_StatusCode res;
+} CompactContext;
+
+static void *
+compactSeries(void *context, FileSeries *series) {
+    CompactContext *cc = (CompactContext*)context;
+    UA_DateTime ws = cc->seg->window * cc->ctx->options.segmentDuration;
+    size_t from = entryBound(series, ws, false);
+    size_t to = entryBound(series, ws + cc->ctx->options.segmentDuration, false);
+    for(size_t i = from; i < to; i++) {
+        FileEntry *entry = &series->entries[i];
+        UA_ByteString buf;
+        cc->res = segmentData(cc->seg, entry->offset, &buf);
+        if(cc->res != UA_STATUSCODE_GOOD)
+            return cc;
+        UA_UInt32 length = readUInt32(buf.data);
+        if(cc->update) {
+            entry->offset = cc->offset;
+        } else {
+            /* A replacement becomes a plain sample */
+            UA_Byte kind = RECORD_SAMPLE;
+            cc->res = writeAll(cc->fd, buf.data, 4);
+            cc->res |= writeAll(cc->fd, &kind, 1);
+            cc->res |= writeAll(cc->fd, &buf.data[5], length - 5);
+            if(cc->res != UA_STATUSCODE_GOOD)
+                return cc;
+        }
+        cc->offset += length;
+    }
+    return NULL;
+}
+
+/* Rewrite the segment with only the live samples. The new file replaces the
+ * old one atomically. The index is only updated after the rename. */
+static UA_StatusCode
+compactSegment(UA_FileStoreContext *ctx, FileSegment *seg) {
+    UA_StatusCode res = writeOutSegment(seg);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    res = mapSegment(seg);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    char *path = segmentPath(ctx, seg->window, "");
+    char *tmpPath = segmentPath(ctx, seg->window, ".tmp");
+    if(!path || !tmpPath) {
+        UA_free(path);
+        UA_free(tmpPath);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+
+    CompactContext cc;
+    memset(&cc, 0, sizeof(CompactContext));
+    cc.ctx = ctx;
+    cc.seg = seg;
+    cc.offset = SEGMENT_HEADER_SIZE;
+    cc.fd = open(tmpPath, O_RDWR | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if(cc.fd < 0) {
+        res = UA_STATUSCODE_BADINTERNALERROR;
+        goto cleanup;
+    }
+    res = writeAll(cc.fd, seg->map, SEGMENT_HEADER_SIZE);
+    if(res == UA_STATUSCODE_GOOD) {
+        ZIP_ITER(FileSeriesTree, &ctx->series, compactSeries, &cc);
+        res = cc.res;
+    }
+    if(res == UA_STATUSCODE_GOOD &&
+       (fsync(cc.fd) != 0 || rename(tmpPath, path) != 0))
+        res = UA_STATUSCODE_BADINTERNALERROR;
+    if(res != UA_STATUSCODE_GOOD) {
+        close(cc.fd);
+        unlink(tmpPath);
+        goto cleanup;
+    }
+
+    /* Switch to the new file. Iterate again in the same order to update the
+     * offsets in the index. */
+    UA_UInt64 fileLength = cc.offset;
+    cc.offset = SEGMENT_HEADER_SIZE;
+    cc.update = true;
+    ZIP_ITER(FileSeriesTree, &ctx->series, compactSeries, &cc);
+    UA_Int64 window = seg->window;
+    size_t records = seg->records - seg->deadRecords;
+    closeSegment(seg);
+    seg->window = window;
+    seg->fd = cc.fd;
+    seg->fileLength = (size_t)fileLength;
+    seg->records = records;
+    seg->deadRecords = 0;
+    res = mapSegment(seg);
+
+ cleanup:
+    UA_free(path);
+    UA_free(tmpPath);
+    return res;
+}
+
+typedef struct {
+    UA_DateTime start;
+    UA_DateTime end;
+} TimeRange;
+
+static void *
+dropSeriesRange(void *context, FileSeries *series) {
+    TimeRange *r = (TimeRange*)context;
+    removeEntries(series, entryBound(series, r->start, false),
+                  entryBound(series, r->end, false));
+    return NULL;
+}
+
+static UA_StatusCode
+maintain(UA_FileStoreContext *ctx) {
+    UA_StatusCode res = commitSegments(ctx);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    /* Retention. The segments are ordered by time. */
+    if(ctx->options.retention > 0) {
+        UA_DateTime cutoff = UA_DateTime_now() - ctx->options.retention;
+        while(ctx->segmentsSize > 0) {
+            FileSegment *seg = &ctx->segments[0];
+            TimeRange r;
+            r.start = seg->window * ctx->options.segmentDuration;
+            r.end = r.start + ctx->options.segmentDuration;
+            if(r.end > cutoff)
+                break;
+            ZIP_ITER(FileSeriesTree, &ctx->series, dropSeriesRange, &r);
+            char *path = segmentPath(ctx, seg->window, "");
+            if(path) {
+                unlink(path);
+                UA_free(path);
+            }
+            closeSegment(seg);
+            ctx->segmentsSize--;
+            memmove(&ctx->segments[0], &ctx->segments[1],
+                    ctx->segmentsSize * sizeof(FileSegment));
+        }
+    }
+
+    /* Compaction */
+    for(size_t i = 0; i < ctx->segmentsSize; i++) {
+        FileSegment *seg = &ctx->segments[i];
+        if(seg->deadRecords > 0 && seg->deadRecords * 2 > seg->records)
+            res |= compactSegment(ctx, seg);
+    }
+    return (res == UA_STATUSCODE_GOOD) ? res : UA_STATUSCODE_BADINTERNALERROR;
+}
+
+static void
+UA_FileStoreContext_delete(UA_FileStoreContext *ctx) {
+    commitSegments(ctx);
+    for(size_t i = 0; i < ctx->segmentsSize; i++)
+        closeSegment(&ctx->segments[i]);
+    UA_free(ctx->segments);
+    ZIP_ITER(FileSeriesTree, &ctx->series, deleteFileSeries, NULL);
+    UA_DataValue_clear(&ctx->current);
+    UA_free(ctx->directory);
+    UA_free(ctx);
+}
+
+static void
+deleteMembers_backend_file(UA_HistoryDataBackend *backend) {
+    if(backend == NULL || backend->context == NULL)
+        return;
+    UA_FileStoreContext_delete((UA_FileStoreContext*)backend->context);
+    backend->context = NULL;
+}
+
+UA_StatusCode
+UA_HistoryDataBackend_File(UA_HistoryDataBackend *backend, const char *directory,
+                           const UA_HistoryDataBackendFileOptions *options) {
+    memset(backend, 0, sizeof(UA_HistoryDataBackend));
+    UA_FileStoreContext *ctx = (UA_FileStoreContext*)
+        UA_calloc(1, sizeof(UA_FileStoreContext));
+    if(!ctx)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    size_t len = strlen(directory);
+    ctx->directory = (char*)UA_malloc(len + 1);
+    if(!ctx->directory) {
+        UA_free(ctx);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    memcpy(ctx->directory, directory, len + 1);
+    if(options)
+        ctx->options = *options;
+    if(ctx->options.segmentDuration <= 0)
+        ctx->options.segmentDuration = FILE_DEFAULT_SEGMENTDURATION;
+    if(ctx->options.commitSamples == 0)
+        ctx->options.commitSamples = FILE_DEFAULT_COMMITSAMPLES;
+
+    /* Rebuild the index from the existing segments */
+    UA_StatusCode res = loadDirectory(ctx);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_FileStoreContext_delete(ctx);
+        return res;
+    }
+
+    backend->serverSetHistoryData = &serverSetHistoryData_backend_file;
+    backend->serverSetHistoryDataBatch = &serverSetHistoryDataBatch_backend_file;
+    backend->resultSize = &resultSize_backend_file;
+    backend->getEnd = &getEnd_backend_file;
+    backend->lastIndex = &lastIndex_backend_file;
+    backend->firstIndex = &firstIndex_backend_file;
+    backend->getDateTimeMatch = &getDateTimeMatch_backend_file;
+    backend->copyDataValues = &copyDataValues_backend_file;
+    backend->openCursor = &openCursor_backend_file;
+    backend->readCursor = &readCursor_backend_file;
+    backend->closeCursor = &closeCursor_backend_file;
+    backend->getDataValue = &getDataValue_backend_file;
+    backend->boundSupported = &boundSupported_backend_file;
+    backend->timestampsToReturnSupported = &timestampsToReturnSupported_backend_file;
+    backend->insertDataValue = &insertDataValue_backend_file;
+    backend->updateDataValue = &updateDataValue_backend_file;
+    backend->replaceDataValue = &replaceDataValue_backend_file;
+    backend->removeDataValue = &removeDataValue_backend_file;
+    backend->deleteMembers = &deleteMembers_backend_file;
+    backend->getHistoryData = NULL;
+    backend->context = ctx;
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_HistoryDataBackend_File_commit(UA_HistoryDataBackend *backend) {
+    if(!backend->context)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    return commitSegments((UA_FileStoreContext*)backend->context);
+}
+
+UA_StatusCode
+UA_HistoryDataBackend_File_maintain(UA_HistoryDataBackend *backend) {
+    if(!backend->context)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    return maintain((UA_FileStoreContext*)backend->context);
+}
+
+void
+UA_HistoryDataBackend_File_clear(UA_HistoryDataBackend *backend) {
+    deleteMembers_backend_file(backend);
+    memset(backend, 0, sizeof(UA_HistoryDataBackend));
+}
+
+#endif /* UA_ARCHITECTURE_POSIX */
@@ -8,7 +8,6 @@
 
 #include <open62541/plugin/historydata/history_data_backend_memory.h>
 
-#include <limits.h>
 #include <string.h>
 
 typedef struct {
@@ -29,25 +28,92 @@ typedef struct {
     size_t storeSize;
     /* New field useful for circular buffer management */
     size_t lastInserted;
+    UA_Boolean circular;
 } UA_NodeIdStoreContextItem_backend_memory;
 
+/* Position of the sample with the index in the time order. The circular buffer
+ * starts with the oldest sample, which follows the last inserted sample once
+ * the buffer is full. */
+static size_t
+storePosition(const UA_NodeIdStoreContextItem_backend_memory *item, size_t index) {
+    if (!item->circular)
+        return index;
+    size_t first = (item->lastInserted + item->storeSize - item->storeEnd) % item->storeSize;
+    return (first + index) % item->storeSize;
+}
+
+static UA_DataValueMemoryStoreItem *
+storeAt(const UA_NodeIdStoreContextItem_backend_memory *item, size_t index) {
+    return item->dataStore[storePosition(item, index)];
+}
+
 static void
 UA_NodeIdStoreContextItem_clear(UA_NodeIdStoreContextItem_backend_memory* item) {
     UA_NodeId_clear(&item->nodeId);
     for (size_t i = 0; i < item->storeEnd; ++i) {
-        UA_DataValueMemoryStoreItem_clear(item->dataStore[i]);
-        UA_free(item->dataStore[i]);
+        UA_DataValueMemoryStoreItem *storeItem = storeAt(item, i);
+        UA_DataValueMemoryStoreItem_clear(storeItem);
+        UA_free(storeItem);
     }
     UA_free(item->dataStore);
 }
 
+/* Insert a sample at the index of the circular buffer. The later samples move
+ * one position towards the end. If the buffer is full, the oldest sample is
+ * dropped. */
+static void
+ringInsert(UA_NodeIdStoreContextItem_backend_memory *item, size_t index,
+           UA_DataValueMemoryStoreItem *newItem) {
+    if (item->storeEnd == item->storeSize) {
+        if (index == 0) {
+            /* The new sample would be dropped right away */
+            UA_DataValueMemoryStoreItem_clear(newItem);
+            UA_free(newItem);
+            return;
+        }
+        size_t oldest = storePosition(item, 0);
+        UA_DataValueMemoryStoreItem_clear(item->dataStore[oldest]);
+        UA_free(item->dataStore[oldest]);
+        item->dataStore[oldest] = NULL;
+        --item->storeEnd;
+        --index;
+    }
+    for (size_t i = item->storeEnd; i > index; --i)
+        item->dataStore[storePosition(item, i)] = item->dataStore[storePosition(item, i - 1)];
+    item->dataStore[storePosition(item, index)] = newItem;
+    ++item->storeEnd;
+    item->lastInserted = item->lastInserted % item->storeSize + 1;
+}
+
+/* Remove the samples [index1, index2) from the circular buffer */
+static void
+ringRemove(UA_NodeIdStoreContextItem_backend_memory *item, size_t index1, size_t index2) {
+    size_t n = index2 - index1;
+    for (size_t i = index1; i < index2; ++i) {
+        UA_DataValueMemoryStoreItem_clear(storeAt(item, i));
+        UA_free(storeAt(item, i));
+    }
+    for (size_t i = index1; i + n < item->storeEnd; ++i)
+        item->dataStore[storePosition(item, i)] = item->dataStore[storePosition(item, i + n)];
+    for (size_t i = item->storeEnd - n; i < item->storeEnd; ++i)
+        item->dataStore[storePosition(item, i)] = NULL;
+    item->storeEnd -= n;
+    item->lastInserted = (item->lastInserted + item->storeSize - n) % item->storeSize;
+}
+
 typedef struct {
     UA_NodeIdStoreContextItem_backend_memory *dataStore;
     size_t storeEnd;
     size_t storeSize;
     size_t initialStoreSize;
+    UA_Boolean circular;
 } UA_MemoryStoreContext;
 
+static UA_NodeIdStoreContextItem_backend_memory *
+getNewNodeIdContext_backend_memory_Circular(UA_MemoryStoreContext *context,
+                                            UA_Server *server,
+                                            const UA_NodeId *nodeId);
+
 static void
 UA_MemoryStoreContext_clear(UA_MemoryStoreContext* ctx) {
     for (size_t i = 0; i < ctx->storeEnd; ++i) {
@@ -83,6 +149,8 @@ getNewNodeIdContext_backend_memory(UA_MemoryStoreContext* context,
     item->dataStore = store;
     item->storeSize = ctx->initialStoreSize;
     item->storeEnd = 0;
+    item->lastInserted = 0;
+    item->circular = false;
     ++ctx->storeEnd;
     return item;
 }
@@ -97,6 +165,8 @@ getNodeIdStoreContextItem_backend_memory(UA_MemoryStoreContext* context,
             return &context->dataStore[i];
         }
     }
+    if (context->circular)
+        return getNewNodeIdContext_backend_memory_Circular(context, server, nodeId);
     return getNewNodeIdContext_backend_memory(context, server, nodeId);
 }
 
@@ -112,9 +182,9 @@ binarySearch_backend_memory(const UA_NodeIdStoreContextItem_backend_memory* item
     size_t max = item->storeEnd - 1;
     while (min <= max) {
         *index = (min + max) / 2;
-        if (item->dataStore[*index]->timestamp == timestamp) {
+        if (storeAt(item, *index)->timestamp == timestamp) {
             return true;
-        } else if (item->dataStore[*index]->timestamp < timestamp) {
+        } else if (storeAt(item, *index)->timestamp < timestamp) {
             if (*index == item->storeEnd - 1) {
                 *index = item->storeEnd;
                 return false;
@@ -221,13 +291,16 @@ serverSetHistoryData_backend_memory(UA_Server *server,
         newItem->value.serverTimestamp = timestamp;
         newItem->value.hasServerTimestamp = true;
     }
-    size_t index = getDateTimeMatch_backend_memory(server,
-                                                   context,
-                                                   NULL,
-                                                   NULL,
-                                                   nodeId,
-                                                   timestamp,
-                                                   MATCH_EQUAL_OR_AFTER);
+    /* Appending in timestamp order needs no search */
+    size_t index = item->storeEnd;
+    if (item->storeEnd > 0 && item->dataStore[item->storeEnd - 1]->timestamp > timestamp)
+        index = getDateTimeMatch_backend_memory(server,
+                                                context,
+                                                NULL,
+                                                NULL,
+                                                nodeId,
+                                                timestamp,
+                                                MATCH_EQUAL_OR_AFTER);
     if (item->storeEnd > 0 && index < item->storeEnd) {
         memmove(&item->dataStore[index+1], &item->dataStore[index], sizeof(UA_DataValueMemoryStoreItem*) * (item->storeEnd - index));
     }
@@ -296,12 +369,12 @@ timestampsToReturnSupported_backend_memory(UA_Server *server,
     if (timestampsToReturn == UA_TIMESTAMPSTORETURN_NEITHER
             || timestampsToReturn == UA_TIMESTAMPSTORETURN_INVALID
             || (timestampsToReturn == UA_TIMESTAMPSTORETURN_SERVER
-                && !item->dataStore[0]->value.hasServerTimestamp)
+                && !storeAt(item, 0)->value.hasServerTimestamp)
             || (timestampsToReturn == UA_TIMESTAMPSTORETURN_SOURCE
-                && !item->dataStore[0]->value.hasSourceTimestamp)
+                && !storeAt(item, 0)->value.hasSourceTimestamp)
             || (timestampsToReturn == UA_TIMESTAMPSTORETURN_BOTH
-                && !(item->dataStore[0]->value.hasSourceTimestamp
-                     && item->dataStore[0]->value.hasServerTimestamp))) {
+                && !(storeAt(item, 0)->value.hasSourceTimestamp
+                     && storeAt(item, 0)->value.hasServerTimestamp))) {
         return false;
     }
     return true;
@@ -314,7 +387,7 @@ getDataValue_backend_memory(UA_Server *server,
                             void *sessionContext,
                             const UA_NodeId * nodeId, size_t index) {
     const UA_NodeIdStoreContextItem_backend_memory* item = getNodeIdStoreContextItem_backend_memory((UA_MemoryStoreContext*)context, server, nodeId);
-    return &item->dataStore[index]->value;
+    return &storeAt(item, index)->value;
 }
 
 static UA_StatusCode
@@ -360,9 +433,9 @@ copyDataValues_backend_memory(UA_Server *server,
         while (index >= endIndex && index < item->storeEnd && counter < maxValues) {
             if (skipedValues++ >= skip) {
                 if (range.dimensionsSize > 0) {
-                    UA_DataValue_backend_copyRange(&item->dataStore[index]->value, &values[counter], range);
+                    UA_DataValue_backend_copyRange(&storeAt(item, index)->value, &values[counter], range);
                 } else {
-                    UA_DataValue_copy(&item->dataStore[index]->value, &values[counter]);
+                    UA_DataValue_copy(&storeAt(item, index)->value, &values[counter]);
                 }
                 ++counter;
             }
@@ -372,9 +445,9 @@ copyDataValues_backend_memory(UA_Server *server,
         while (index <= endIndex && counter < maxValues) {
             if (skipedValues++ >= skip) {
                 if (range.dimensionsSize > 0) {
-                    UA_DataValue_backend_copyRange(&item->dataStore[index]->value, &values[counter], range);
+                    UA_DataValue_backend_copyRange(&storeAt(item, index)->value, &values[counter], range);
                 } else {
-                    UA_DataValue_copy(&item->dataStore[index]->value, &values[counter]);
+                    UA_DataValue_copy(&storeAt(item, index)->value, &values[counter]);
                 }
                 ++counter;
             }
@@ -395,6 +468,84 @@ copyDataValues_backend_memory(UA_Server *server,
     return UA_STATUSCODE_GOOD;
 }
 
+/* The cursor keeps the next index. Resuming does not walk over the values
+ * that were already returned. */
+typedef struct {
+    UA_NodeId nodeId;
+    size_t next;
+    size_t last;
+    UA_Boolean reverse;
+    UA_Boolean done;
+} UA_MemoryStoreCursor;
+
+static UA_StatusCode
+openCursor_backend_memory(UA_Server *server,
+                          void *context,
+                          const UA_NodeId *sessionId,
+                          void *sessionContext,
+                          const UA_NodeId *nodeId,
+                          size_t startIndex,
+                          size_t endIndex,
+                          UA_Boolean reverse,
+                          void **cursor)
+{
+    UA_MemoryStoreCursor *mc = (UA_MemoryStoreCursor*)UA_calloc(1, sizeof(UA_MemoryStoreCursor));
+    if (!mc)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_StatusCode res = UA_NodeId_copy(nodeId, &mc->nodeId);
+    if (res != UA_STATUSCODE_GOOD) {
+        UA_free(mc);
+        return res;
+    }
+    mc->next = startIndex;
+    mc->last = endIndex;
+    mc->reverse = reverse;
+    mc->done = (reverse) ? startIndex < endIndex : startIndex > endIndex;
+    *cursor = mc;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+readCursor_backend_memory(UA_Server *server,
+                          void *context,
+                          void *cursor,
+                          size_t maxValues,
+                          UA_NumericRange range,
+                          size_t *providedValues,
+                          UA_DataValue *values)
+{
+    UA_MemoryStoreCursor *mc = (UA_MemoryStoreCursor*)cursor;
+    /* Look up the item every time. The store is moved when nodes are added. */
+    const UA_NodeIdStoreContextItem_backend_memory* item = getNodeIdStoreContextItem_backend_memory((UA_MemoryStoreContext*)context, server, &mc->nodeId);
+    size_t counter = 0;
+    while (!mc->done && item && counter < maxValues && mc->next < item->storeEnd) {
+        if (range.dimensionsSize > 0) {
+            UA_DataValue_backend_copyRange(&storeAt(item, mc->next)->value, &values[counter], range);
+        } else {
+            UA_DataValue_copy(&storeAt(item, mc->next)->value, &values[counter]);
+        }
+        ++counter;
+        if (mc->next == mc->last)
+            mc->done = true;
+        else if (mc->reverse)
+            --mc->next;
+        else
+            ++mc->next;
+    }
+    *providedValues = counter;
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+closeCursor_backend_memory(UA_Server *server,
+                           void *context,
+                           void *cursor)
+{
+    UA_MemoryStoreCursor *mc = (UA_MemoryStoreCursor*)cursor;
+    UA_NodeId_clear(&mc->nodeId);
+    UA_free(mc);
+}
+
 static UA_StatusCode
 insertDataValue_backend_memory(UA_Server *server,
                    void *hdbContext,
@@ -408,17 +559,20 @@ insertDataValue_backend_memory(UA_Server *server,
     const UA_DateTime timestamp = value->hasSourceTimestamp ? value->sourceTimestamp : value->serverTimestamp;
     UA_NodeIdStoreContextItem_backend_memory* item = getNodeIdStoreContextItem_backend_memory((UA_MemoryStoreContext*)hdbContext, server, nodeId);
 
-    size_t index = getDateTimeMatch_backend_memory(server,
-                                    hdbContext,
-                                    sessionId,
-                                    sessionContext,
-                                    nodeId,
-                                    timestamp,
-                                    MATCH_EQUAL_OR_AFTER);
-    if (item->storeEnd != index && item->dataStore[index]->timestamp == timestamp)
+    /* Appending in timestamp order needs no search */
+    size_t index = item->storeEnd;
+    if (item->storeEnd > 0 && storeAt(item, item->storeEnd - 1)->timestamp >= timestamp)
+        index = getDateTimeMatch_backend_memory(server,
+                                                hdbContext,
+                                                sessionId,
+                                                sessionContext,
+                                                nodeId,
+                                                timestamp,
+                                                MATCH_EQUAL_OR_AFTER);
+    if (item->storeEnd != index && storeAt(item, index)->timestamp == timestamp)
         return UA_STATUSCODE_BADENTRYEXISTS;
 
-    if (item->storeEnd >= item->storeSize) {
+    if (!item->circular && item->storeEnd >= item->storeSize) {
         size_t newStoreSize = item->storeSize == 0 ? INITIAL_MEMORY_STORE_SIZE : item->storeSize * 2;
         item->dataStore = (UA_DataValueMemoryStoreItem **)UA_realloc(item->dataStore,  (newStoreSize * sizeof(UA_DataValueMemoryStoreItem*)));
         if (!item->dataStore) {
@@ -435,6 +589,10 @@ insertDataValue_backend_memory(UA_Server *server,
         newItem->value.hasServerTimestamp = true;
     }
 
+    if (item->circular) {
+        ringInsert(item, index, newItem);
+        return UA_STATUSCODE_GOOD;
+    }
     if (item->storeEnd > 0 && index < item->storeEnd) {
         memmove(&item->dataStore[index+1], &item->dataStore[index], sizeof(UA_DataValueMemoryStoreItem*) * (item->storeEnd - index));
     }
@@ -465,11 +623,12 @@ replaceDataValue_backend_memory(UA_Server *server,
                                     MATCH_EQUAL);
     if (index == item->storeEnd)
         return UA_STATUSCODE_BADNOENTRYEXISTS;
-    UA_DataValue_clear(&item->dataStore[index]->value);
-    UA_DataValue_copy(value, &item->dataStore[index]->value);
-    if(!item->dataStore[index]->value.hasServerTimestamp) {
-        item->dataStore[index]->value.serverTimestamp = timestamp;
-        item->dataStore[index]->value.hasServerTimestamp = true;
+    UA_DataValueMemoryStoreItem *storeItem = storeAt(item, index);
+    UA_DataValue_clear(&storeItem->value);
+    UA_DataValue_copy(value, &storeItem->value);
+    if(!storeItem->value.hasServerTimestamp) {
+        storeItem->value.serverTimestamp = timestamp;
+        storeItem->value.hasServerTimestamp = true;
     }
     return UA_STATUSCODE_GOOD;
 }
@@ -552,6 +711,10 @@ removeDataValue_backend_memory(UA_Server *server,
             return UA_STATUSCODE_BADNODATA;
         ++index2;
     }
+    if (item->circular) {
+        ringRemove(item, index1, index2);
+        return UA_STATUSCODE_GOOD;
+    }
 #ifndef __clang_analyzer__
     for (size_t i = index1; i < index2; ++i) {
         UA_DataValueMemoryStoreItem_clear(item->dataStore[i]);
@@ -599,6 +762,9 @@ UA_HistoryDataBackend_Memory(size_t initialNodeIdStoreSize, size_t initialDataSt
     result.firstIndex = &firstIndex_backend_memory;
     result.getDateTimeMatch = &getDateTimeMatch_backend_memory;
     result.copyDataValues = &copyDataValues_backend_memory;
+    result.openCursor = &openCursor_backend_memory;
+    result.readCursor = &readCursor_backend_memory;
+    result.closeCursor = &closeCursor_backend_memory;
     result.getDataValue = &getDataValue_backend_memory;
     result.boundSupported = &boundSupported_backend_memory;
     result.timestampsToReturnSupported = &timestampsToReturnSupported_backend_memory;
@@ -640,6 +806,8 @@ getNewNodeIdContext_backend_memory_Circular(UA_MemoryStoreContext *context,
     item->dataStore = store;
     item->storeSize = ctx->initialStoreSize;
     item->storeEnd = 0;
+    item->lastInserted = 0;
+    item->circular = true;
     ++ctx->storeEnd;
     return item;
 }
@@ -668,10 +836,6 @@ serverSetHistoryData_backend_memory_Circular(UA_Server *server,
     if(item == NULL) {
         return UA_STATUSCODE_BADOUTOFMEMORY;
     }
-    if(item->lastInserted >= item->storeSize) {
-        /* If the buffer size is overcomed, push new elements from the start of the buffer */
-        item->lastInserted = 0;
-    }
     UA_DateTime timestamp = 0;
     if(value->hasSourceTimestamp) {
         timestamp = value->sourceTimestamp;
@@ -681,6 +845,8 @@ serverSetHistoryData_backend_memory_Circular(UA_Server *server,
         timestamp = UA_DateTime_now();
     }
     UA_DataValueMemoryStoreItem *newItem = (UA_DataValueMemoryStoreItem *)UA_calloc(1, sizeof(UA_DataValueMemoryStoreItem));
+    if(!newItem)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
     newItem->timestamp = timestamp;
     UA_DataValue_copy(value, &newItem->value);
     if(!newItem->value.hasServerTimestamp) {
@@ -688,197 +854,36 @@ serverSetHistoryData_backend_memory_Circular(UA_Server *server,
         newItem->value.hasServerTimestamp = true;
     }
 
-
-    /* This implementation does NOT sort values by timestamp */
-
-    if(item->dataStore[item->lastInserted] != NULL) {
-        UA_DataValueMemoryStoreItem_clear(item->dataStore[item->lastInserted]);
-        UA_free(item->dataStore[item->lastInserted]);
+    /* Late samples are inserted after the samples with the same or an earlier
+     * timestamp. The samples stay ordered by timestamp. */
+    if(item->storeEnd > 0 && storeAt(item, item->storeEnd - 1)->timestamp > timestamp) {
+        size_t index = getDateTimeMatch_backend_memory(server, context, NULL, NULL,
+                                                       nodeId, timestamp, MATCH_AFTER);
+        ringInsert(item, index, newItem);
+        return UA_STATUSCODE_GOOD;
     }
-    item->dataStore[item->lastInserted] = newItem;
-    ++item->lastInserted;
 
+    /* Samples in timestamp order replace the oldest sample once the buffer is
+     * full */
+    size_t position = item->lastInserted % item->storeSize;
+    if(item->storeEnd == item->storeSize) {
+        UA_DataValueMemoryStoreItem_clear(item->dataStore[position]);
+        UA_free(item->dataStore[position]);
+    }
+    item->dataStore[position] = newItem;
+    item->lastInserted = position + 1;
     if(item->storeEnd < item->storeSize) {
         ++item->storeEnd;
     }
-
-    return UA_STATUSCODE_GOOD;
-}
-
-static size_t
-getResultSize_service_Circular(const UA_HistoryDataBackend *backend, UA_Server *server,
-                               const UA_NodeId *sessionId, void *sessionContext,
-                               const UA_NodeId *nodeId, UA_DateTime start,
-                               UA_DateTime end, UA_UInt32 numValuesPerNode,
-                               UA_Boolean returnBounds, size_t *startIndex,
-                               size_t *endIndex, UA_Boolean *addFirst,
-                               UA_Boolean *addLast, UA_Boolean *reverse) {
-    *startIndex = 0;
-    *endIndex = backend->lastIndex(server, backend->context, sessionId, sessionContext, nodeId);
-    *addFirst = false;
-    *addLast = false;
-    if(end == LLONG_MIN) {
-        *reverse = false;
-    } else if(start == LLONG_MIN) {
-        *reverse = true;
-    } else {
-        *reverse = end < start;
-    }
-
-    size_t size = 0;
-    const UA_NodeIdStoreContextItem_backend_memory *item = getNodeIdStoreContextItem_backend_memory_Circular((UA_MemoryStoreContext *)backend->context, server, nodeId);
-    if(item == NULL) {
-        size = 0;
-    } else {
-        size = item->storeEnd;
-    }
-    return size;
-}
-
-static UA_StatusCode
-getHistoryData_service_Circular(UA_Server *server,
-                                const UA_NodeId *sessionId,
-                                void *sessionContext,
-                                const UA_HistoryDataBackend *backend,
-                                const UA_DateTime start,
-                                const UA_DateTime end,
-                                const UA_NodeId *nodeId,
-                                size_t maxSize,
-                                UA_UInt32 numValuesPerNode,
-                                UA_Boolean returnBounds,
-                                UA_TimestampsToReturn timestampsToReturn,
-                                UA_NumericRange range,
-                                UA_Boolean releaseContinuationPoints,
-                                const UA_ByteString *continuationPoint,
-                                UA_ByteString *outContinuationPoint,
-                                UA_HistoryData *historyData) {
-    size_t *resultSize = &historyData->dataValuesSize;
-    UA_DataValue **result = &historyData->dataValues;
-    size_t skip = 0;
-    UA_ByteString backendContinuationPoint;
-    UA_ByteString_init(&backendContinuationPoint);
-    if(continuationPoint->length > 0) {
-        if(continuationPoint->length < sizeof(size_t))
-            return UA_STATUSCODE_BADCONTINUATIONPOINTINVALID;
-        skip = *((size_t *)(continuationPoint->data));
-        backendContinuationPoint.length = continuationPoint->length - sizeof(size_t);
-        backendContinuationPoint.data = continuationPoint->data + sizeof(size_t);
-    }
-    size_t storeEnd = backend->getEnd(server, backend->context, sessionId, sessionContext, nodeId);
-    size_t startIndex;
-    size_t endIndex;
-    UA_Boolean addFirst;
-    UA_Boolean addLast;
-    UA_Boolean reverse;
-    size_t _resultSize = getResultSize_service_Circular(backend,
-                                                        server,
-                                                        sessionId,
-                                                        sessionContext,
-                                                        nodeId,
-                                                        start,
-                                                        end,
-                                                        numValuesPerNode == 0 ? 0 : numValuesPerNode + (UA_UInt32)skip,
-                                                        returnBounds,
-                                                        &startIndex,
-                                                        &endIndex,
-                                                        &addFirst,
-                                                        &addLast,
-                                                        &reverse);
-    *resultSize = _resultSize - skip;
-    if(*resultSize > maxSize) {
-        *resultSize = maxSize;
-    }
-    UA_DataValue *outResult = (UA_DataValue *)UA_Array_new(*resultSize, &UA_TYPES[UA_TYPES_DATAVALUE]);
-    if(!outResult) {
-        *resultSize = 0;
-        return UA_STATUSCODE_BADOUTOFMEMORY;
-    }
-    *result = outResult;
-    size_t counter = 0;
-    if(addFirst) {
-        if(skip == 0) {
-            outResult[counter].hasStatus = true;
-            outResult[counter].status = UA_STATUSCODE_BADBOUNDNOTFOUND;
-            outResult[counter].hasSourceTimestamp = true;
-            if(start == LLONG_MIN) {
-                outResult[counter].sourceTimestamp = end;
-            } else {
-                outResult[counter].sourceTimestamp = start;
-            }
-            ++counter;
-        }
-    }
-    UA_ByteString backendOutContinuationPoint;
-    UA_ByteString_init(&backendOutContinuationPoint);
-    if(endIndex != storeEnd && startIndex != storeEnd) {
-        size_t retval = 0;
-        size_t valueSize = *resultSize - counter;
-        if(valueSize + skip > _resultSize - addFirst - addLast) {
-            if(skip == 0) {
-                valueSize = _resultSize - addFirst - addLast;
-            } else {
-                valueSize = _resultSize - skip - addLast;
-            }
-        }
-        UA_StatusCode ret = UA_STATUSCODE_GOOD;
-        if(valueSize > 0)
-            ret = backend->copyDataValues(server,
-                                          backend->context,
-                                          sessionId,
-                                          sessionContext,
-                                          nodeId,
-                                          startIndex,
-                                          endIndex,
-                                          reverse,
-                                          valueSize,
-                                          range,
-                                          releaseContinuationPoints,
-                                          &backendContinuationPoint,
-                                          &backendOutContinuationPoint,
-                                          &retval,
-                                          &outResult[counter]);
-        if(ret != UA_STATUSCODE_GOOD) {
-            UA_Array_delete(outResult, *resultSize, &UA_TYPES[UA_TYPES_DATAVALUE]);
-            *result = NULL;
-            *resultSize = 0;
-            return ret;
-        }
-        counter += retval;
-    }
-    if(addLast && counter < *resultSize) {
-        outResult[counter].hasStatus = true;
-        outResult[counter].status = UA_STATUSCODE_BADBOUNDNOTFOUND;
-        outResult[counter].hasSourceTimestamp = true;
-        if(start == LLONG_MIN && storeEnd != backend->firstIndex(server, backend->context, sessionId, sessionContext, nodeId)) {
-            outResult[counter].sourceTimestamp = backend->getDataValue(server, backend->context, sessionId, sessionContext, nodeId, endIndex)->sourceTimestamp - UA_DATETIME_SEC;
-        } else if(end == LLONG_MIN && storeEnd != backend->firstIndex(server, backend->context, sessionId, sessionContext, nodeId)) {
-            outResult[counter].sourceTimestamp = backend->getDataValue(server, backend->context, sessionId, sessionContext, nodeId, endIndex)->sourceTimestamp + UA_DATETIME_SEC;
-        } else {
-            outResult[counter].sourceTimestamp = end;
-        }
-    }
-    // there are more values
-    if(skip + *resultSize < _resultSize
-       // there are not more values for this request, but there are more values in
-       // database
-       || (backendOutContinuationPoint.length > 0 && numValuesPerNode != 0)
-       // we deliver just one value which is a FIRST/LAST value
-       || (skip == 0 && addFirst == true && *resultSize == 1)) {
-        if(UA_ByteString_allocBuffer(outContinuationPoint, backendOutContinuationPoint.length + sizeof(size_t)) != UA_STATUSCODE_GOOD) {
-            return UA_STATUSCODE_BADOUTOFMEMORY;
-        }
-        *((size_t *)(outContinuationPoint->data)) = skip + *resultSize;
-        if(backendOutContinuationPoint.length > 0)
-            memcpy(outContinuationPoint->data + sizeof(size_t), backendOutContinuationPoint.data, backendOutContinuationPoint.length);
-    }
-    UA_ByteString_clear(&backendOutContinuationPoint);
     return UA_STATUSCODE_GOOD;
 }
 
 UA_HistoryDataBackend
 UA_HistoryDataBackend_Memory_Circular(size_t initialNodeIdStoreSize, size_t initialDataStoreSize) {
     UA_HistoryDataBackend result = UA_HistoryDataBackend_Memory(initialNodeIdStoreSize, initialDataStoreSize);
+    if(!result.context)
+        return result;
+    ((UA_MemoryStoreContext *)result.context)->circular = true;
     result.serverSetHistoryData = &serverSetHistoryData_backend_memory_Circular;
-    result.getHistoryData = &getHistoryData_service_Circular;
     return result;
 }
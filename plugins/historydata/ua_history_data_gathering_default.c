@@ -12,18 +12,44 @@
 
 #include <string.h>
 
+#if UA_MULTITHREADING >= 100 && defined(UA_ARCHITECTURE_POSIX)
+#define UA_BATCH_THREAD
+#include <pthread.h>
+#include <time.h>
+#endif
+
+struct UA_BatchQueue;
+typedef struct UA_BatchQueue UA_BatchQueue;
+
+/* Wraps a backend to serialize the access with the batch thread */
+typedef struct {
+    UA_HistoryDataBackend backend;
+    UA_BatchQueue *queue;
+    UA_DataValue current; /* Copy of the value returned by getDataValue */
+} UA_LockedBackend;
+
 typedef struct {
     UA_NodeId nodeId;
     UA_HistorizingNodeIdSettings setting;
     UA_MonitoredItemCreateResult monitoredResult;
+
+    /* Batched gathering */
+    UA_BatchQueue *queue;
+    UA_LockedBackend *locked;
+    UA_HistorizingNodeIdSettings lockedSetting;
 } UA_NodeIdStoreContextItem_gathering_default;
 
 typedef struct {
     UA_NodeIdStoreContextItem_gathering_default *dataStore;
     size_t storeEnd;
     size_t storeSize;
+    UA_BatchQueue *queue; /* Batched gathering */
 } UA_NodeIdStoreContext;
 
+static void
+enqueueValue(UA_BatchQueue *q, UA_Server *server, const UA_HistoryDataBackend *backend,
+             const UA_NodeId *nodeId, const UA_DataValue *value);
+
 static void
 dataChangeCallback_gathering_default(UA_Server *server,
                                      UA_UInt32 monitoredItemId,
@@ -34,6 +60,10 @@ dataChangeCallback_gathering_default(UA_Server *server,
                                      const UA_DataValue *value)
 {
     UA_NodeIdStoreContextItem_gathering_default *context = (UA_NodeIdStoreContextItem_gathering_default*)monitoredItemContext;
+    if (context->queue) {
+        enqueueValue(context->queue, server, &context->setting.historizingBackend, nodeId, value);
+        return;
+    }
     context->setting.historizingBackend.serverSetHistoryData(server,
                                                              context->setting.historizingBackend.context,
                                                              NULL,
@@ -200,6 +230,10 @@ setValue_gathering_default(UA_Server *server,
         return;
     }
     if (item->setting.historizingUpdateStrategy == UA_HISTORIZINGUPDATESTRATEGY_VALUESET) {
+        if (item->queue) {
+            enqueueValue(item->queue, server, &item->setting.historizingBackend, nodeId, value);
+            return;
+        }
         item->setting.historizingBackend.serverSetHistoryData(server,
                                                               item->setting.historizingBackend.context,
                                                               sessionId,
@@ -256,3 +290,538 @@ UA_HistoryDataGathering_Circular(size_t initialNodeIdStoreSize) {
     gathering.registerNodeId = &registerNodeId_gathering_circular;
     return gathering;
 }
+
+/* Batched gathering */
+
+#define BATCH_DEFAULT_QUEUESIZE 4096
+#define BATCH_SIZE 256             /* Values per call into the backend */
+#define BATCH_FLUSHINTERVAL_MS 100 /* Maximum delay of the batch thread */
+
+/* A slot is free for the enqueue position pos if seq == pos. It contains the
+ * value of position pos if seq == pos + 1. */
+typedef struct {
+    void * volatile seq;
+    UA_HistoryDataBackend backend;
+    UA_NodeId nodeId;
+    UA_DataValue value;
+} UA_BatchSlot;
+
+struct UA_BatchQueue {
+    UA_BatchSlot *slots;
+    size_t size; /* Power of two */
+    void * volatile tail; /* Next enqueue position */
+    size_t head;          /* Next dequeue position. Protected by the lock. */
+    UA_Server *server;
+
+    /* Buffer for one batch. Protected by the lock. */
+    UA_NodeId *batchNodeIds;
+    UA_DataValue *batchValues;
+
+#ifdef UA_BATCH_THREAD
+    pthread_mutex_t lock;
+    pthread_cond_t wakeup;
+    pthread_t thread;
+    UA_Boolean started;
+    UA_Boolean running;
+#endif
+};
+
+#ifdef UA_BATCH_THREAD
+# define BATCH_LOCK(q) pthread_mutex_lock(&(q)->lock)
+# define BATCH_UNLOCK(q) pthread_mutex_unlock(&(q)->lock)
+#else
+# define BATCH_LOCK(q)
+# define BATCH_UNLOCK(q)
+#endif
+
+/* Atomic read with a full memory barrier */
+static size_t
+atomicLoad(void * volatile *addr) {
+    return (size_t)(uintptr_t)UA_atomic_cmpxchg(addr, NULL, NULL);
+}
+
+static size_t
+queuedValues(UA_BatchQueue *q) {
+    return atomicLoad(&q->tail) - q->head;
+}
+
+static void
+storeBatch(UA_BatchQueue *q, const UA_HistoryDataBackend *backend, size_t n) {
+    if(backend->serverSetHistoryDataBatch) {
+        backend->serverSetHistoryDataBatch(q->server, backend->context, n,
+                                           q->batchNodeIds, q->batchValues);
+    } else {
+        for(size_t i = 0; i < n; i++)
+            backend->serverSetHistoryData(q->server, backend->context, NULL, NULL,
+                                          &q->batchNodeIds[i], true,
+                                          &q->batchValues[i]);
+    }
+    for(size_t i = 0; i < n; i++) {
+        UA_NodeId_clear(&q->batchNodeIds[i]);
+        UA_DataValue_clear(&q->batchValues[i]);
+    }
+}
+
+/* Store all published values in the backends. The caller holds the lock. The
+ * values of consecutive slots with the same backend form a batch. */
+static void
+drainQueue(UA_BatchQueue *q) {
+    UA_HistoryDataBackend backend;
+    memset(&backend, 0, sizeof(UA_HistoryDataBackend));
+    size_t n = 0;
+    while(true) {
+        UA_BatchSlot *slot = &q->slots[q->head & (q->size - 1)];
+        UA_Boolean ready = (atomicLoad(&slot->seq) == q->head + 1);
+        if(n > 0 && (!ready || n == BATCH_SIZE ||
+                     slot->backend.context != backend.context ||
+                     slot->backend.serverSetHistoryData != backend.serverSetHistoryData)) {
+            storeBatch(q, &backend, n);
+            n = 0;
+        }
+        if(!ready)
+            break;
+
+        /* Move the value out of the slot and release the slot for the
+         * position one round later */
+        backend = slot->backend;
+        q->batchNodeIds[n] = slot->nodeId;
+        q->batchValues[n] = slot->value;
+        n++;
+        UA_atomic_cmpxchg(&slot->seq, (void*)(uintptr_t)(q->head + 1),
+                          (void*)(uintptr_t)(q->head + q->size));
+        q->head++;
+    }
+}
+
+static UA_Boolean
+tryEnqueue(UA_BatchQueue *q, const UA_HistoryDataBackend *backend,
+           const UA_NodeId *nodeId, const UA_DataValue *value) {
+    /* Reserve a slot */
+    size_t pos;
+    UA_BatchSlot *slot;
+    while(true) {
+        pos = atomicLoad(&q->tail);
+        slot = &q->slots[pos & (q->size - 1)];
+        size_t seq = atomicLoad(&slot->seq);
+        if(seq == pos) {
+            if(UA_atomic_cmpxchg(&q->tail, (void*)(uintptr_t)pos,
+                                 (void*)(uintptr_t)(pos + 1)) == (void*)(uintptr_t)pos)
+                break;
+        } else if((intptr_t)(seq - pos) < 0) {
+            return false; /* Full */
+        }
+    }
+
+    /* Fill and publish. The value is not lost if the copy fails. Then the slot
+     * is published with an empty value. */
+    slot->backend = *backend;
+    UA_NodeId_copy(nodeId, &slot->nodeId);
+    UA_DataValue_copy(value, &slot->value);
+    UA_atomic_cmpxchg(&slot->seq, (void*)(uintptr_t)pos, (void*)(uintptr_t)(pos + 1));
+    return true;
+}
+
+static void
+enqueueValue(UA_BatchQueue *q, UA_Server *server, const UA_HistoryDataBackend *backend,
+             const UA_NodeId *nodeId, const UA_DataValue *value) {
+    q->server = server;
+    while(!tryEnqueue(q, backend, nodeId, value)) {
+        /* Backpressure. Store the queued values in this thread. */
+        BATCH_LOCK(q);
+        drainQueue(q);
+        BATCH_UNLOCK(q);
+    }
+    if(queuedValues(q) < BATCH_SIZE)
+        return;
+#ifdef UA_BATCH_THREAD
+    pthread_cond_signal(&q->wakeup);
+#else
+    drainQueue(q);
+#endif
+}
+
+#ifdef UA_BATCH_THREAD
+static void *
+batchThreadLoop(void *data) {
+    UA_BatchQueue *q = (UA_BatchQueue*)data;
+    BATCH_LOCK(q);
+    while(q->running) {
+        if(queuedValues(q) < BATCH_SIZE) {
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            ts.tv_nsec += BATCH_FLUSHINTERVAL_MS * 1000000L;
+            if(ts.tv_nsec >= 1000000000L) {
+                ts.tv_sec++;
+                ts.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&q->wakeup, &q->lock, &ts);
+        }
+        drainQueue(q);
+    }
+    BATCH_UNLOCK(q);
+    return NULL;
+}
+#endif
+
+static void
+UA_BatchQueue_delete(UA_BatchQueue *q) {
+#ifdef UA_BATCH_THREAD
+    if(q->started) {
+        BATCH_LOCK(q);
+        q->running = false;
+        pthread_cond_signal(&q->wakeup);
+        BATCH_UNLOCK(q);
+        pthread_join(q->thread, NULL);
+    }
+    pthread_cond_destroy(&q->wakeup);
+    pthread_mutex_destroy(&q->lock);
+#endif
+    drainQueue(q);
+    UA_free(q->slots);
+    UA_free(q->batchNodeIds);
+    UA_free(q->batchValues);
+    UA_free(q);
+}
+
+static UA_BatchQueue *
+UA_BatchQueue_new(size_t queueSize) {
+    size_t size = 2;
+    while(size < queueSize)
+        size *= 2;
+    UA_BatchQueue *q = (UA_BatchQueue*)UA_calloc(1, sizeof(UA_BatchQueue));
+    if(!q)
+        return NULL;
+    q->size = size;
+    q->slots = (UA_BatchSlot*)UA_calloc(size, sizeof(UA_BatchSlot));
+    q->batchNodeIds = (UA_NodeId*)UA_calloc(BATCH_SIZE, sizeof(UA_NodeId));
+    q->batchValues = (UA_DataValue*)UA_calloc(BATCH_SIZE, sizeof(UA_DataValue));
+#ifdef UA_BATCH_THREAD
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->wakeup, NULL);
+#endif
+    if(!q->slots || !q->batchNodeIds || !q->batchValues) {
+        UA_BatchQueue_delete(q);
+        return NULL;
+    }
+    for(size_t i = 0; i < size; i++)
+        q->slots[i].seq = (void*)(uintptr_t)i;
+#ifdef UA_BATCH_THREAD
+    q->running = true;
+    q->started = (pthread_create(&q->thread, NULL, batchThreadLoop, q) == 0);
+#endif
+    return q;
+}
+
+/* The wrapped backend methods store the queued values first */
+
+static UA_StatusCode
+serverSetHistoryData_locked(UA_Server *server, void *hdbContext,
+                            const UA_NodeId *sessionId, void *sessionContext,
+                            const UA_NodeId *nodeId, UA_Boolean historizing,
+                            const UA_DataValue *value) {
+    UA_LockedBackend *lb = (UA_LockedBackend*)hdbContext;
+    BATCH_LOCK(lb->queue);
+    drainQueue(lb->queue);
+    UA_StatusCode res =
+        lb->backend.serverSetHistoryData(server, lb->backend.context, sessionId,
+                                         sessionContext, nodeId, historizing, value);
+    BATCH_UNLOCK(lb->queue);
+    return res;
+}
+
+static UA_StatusCode
+getHistoryData_locked(UA_Server *server, const UA_NodeId *sessionId,
+                      void *sessionContext, const UA_HistoryDataBackend *backend,
+                      const UA_DateTime start, const UA_DateTime end,
+                      const UA_NodeId *nodeId, size_t maxSizePerResponse,
+                      UA_UInt32 numValuesPerNode, UA_Boolean returnBounds,
+                      UA_TimestampsToReturn timestampsToReturn,
+                      UA_NumericRange range, UA_Boolean releaseContinuationPoints,
+                      const UA_ByteString *continuationPoint,
+                      UA_ByteString *outContinuationPoint, UA_HistoryData *result) {
+    UA_LockedBackend *lb = (UA_LockedBackend*)backend->context;
+    BATCH_LOCK(lb->queue);
+    drainQueue(lb->queue);
+    UA_StatusCode res =
+        lb->backend.getHistoryData(server, sessionId, sessionContext, &lb->backend,
+                                   start, end, nodeId, maxSizePerResponse,
+                                   numValuesPerNode, returnBounds, timestampsToReturn,
+                                   range, releaseContinuationPoints, continuationPoint,
+                                   outContinuationPoint, result);
+    BATCH_UNLOCK(lb->queue);
+    return res;
+}
+
+static size_t
+getDateTimeMatch_locked(UA_Server *server, void *hdbContext,
+                        const UA_NodeId *sessionId, void *sessionContext,
+                        const UA_NodeId *nodeId, const UA_DateTime timestamp,
+                        const MatchStrategy strategy) {
+    UA_LockedBackend *lb = (UA_LockedBackend*)hdbContext;
+    BATCH_LOCK(lb->queue);
+    drainQueue(lb->queue);
+    size_t res = lb->backend.getDateTimeMatch(server, lb->backend.context, sessionId,
+                                              sessionContext, nodeId, timestamp,
+                                              strategy);
+    BATCH_UNLOCK(lb->queue);
+    return res;
+}
+
+/* getEnd, lastIndex and firstIndex have the same signature */
+#define UA_LOCKED_INDEX_METHOD(METHOD)                                  \
+static size_t                                                           \
+METHOD##_locked(UA_Server *server, void *hdbContext,                    \
+                const UA_NodeId *sessionId, void *sessionContext,       \
+                const UA_NodeId *nodeId) {                              \
+    UA_LockedBackend *lb = (UA_LockedBackend*)hdbContext;               \
+    BATCH_LOCK(lb->queue);                                              \
+    drainQueue(lb->queue);                                              \
+    size_t res = lb->backend.METHOD(server, lb->backend.context,        \
+                                    sessionId, sessionContext, nodeId); \
+    BATCH_UNLOCK(lb->queue);                                            \
+    return res;                                                         \
+}
+
+UA_LOCKED_INDEX_METHOD(getEnd)
+UA_LOCKED_INDEX_METHOD(lastIndex)
+UA_LOCKED_INDEX_METHOD(firstIndex)
+
+static size_t
+resultSize_locked(UA_Server *server, void *hdbContext,
+                  const UA_NodeId *sessionId, void *sessionContext,
+                  const UA_NodeId *nodeId, size_t startIndex, size_t endIndex) {
+    UA_LockedBackend *lb = (UA_LockedBackend*)hdbContext;
+    BATCH_LOCK(lb->queue);
+    drainQueue(lb->queue);
+    size_t res = lb->backend.resultSize(server, lb->backend.context, sessionId,
+                                        sessionContext, nodeId, startIndex, endIndex);
+    BATCH_UNLOCK(lb->queue);
+    return res;
+}
+
+static UA_StatusCode
+copyDataValues_locked(UA_Server *server, void *hdbContext,
+                      const UA_NodeId *sessionId, void *sessionContext,
+                      const UA_NodeId *nodeId, size_t startIndex, size_t endIndex,
+                      UA_Boolean reverse, size_t valueSize, UA_NumericRange range,
+                      UA_Boolean releaseContinuationPoints,
+                      const UA_ByteString *continuationPoint,
+                      UA_ByteString *outContinuationPoint,
+                      size_t *providedValues, UA_DataValue *values) {
+    UA_LockedBackend *lb = (UA_LockedBackend*)hdbContext;
+    BATCH_LOCK(lb->queue);
+    drainQueue(lb->queue);
+    UA_StatusCode res =
+        lb->backend.copyDataValues(server, lb->backend.context, sessionId,
+                                   sessionContext, nodeId, startIndex, endIndex,
+                                   reverse, valueSize, range,
+                                   releaseContinuationPoints, continuationPoint,
+                                   outContinuationPoint, providedValues, values);
+    BATCH_UNLOCK(lb->queue);
+    return res;
+}
+
+/* The backend can change the value behind the returned pointer once the lock
+ * is released. So a copy is returned. */
+static const UA_DataValue *
+getDataValue_locked(UA_Server *server, void *hdbContext,
+                    const UA_NodeId *sessionId, void *sessionContext,
+                    const UA_NodeId *nodeId, size_t index) {
+    UA_LockedBackend *lb = (UA_LockedBackend*)hdbContext;
+    BATCH_LOCK(lb->queue);
+    drainQueue(lb->queue);
+    const UA_DataValue *dv =
+        lb->backend.getDataValue(server, lb->backend.context, sessionId,
+                                 sessionContext, nodeId, index);
+    UA_DataValue_clear(&lb->current);
+    if(dv && UA_DataValue_copy(dv, &lb->current) != UA_STATUSCODE_GOOD)
+        dv = NULL;
+    BATCH_UNLOCK(lb->queue);
+    return (dv) ? &lb->current : NULL;
+}
+
+static UA_Boolean
+boundSupported_locked(UA_Server *server, void *hdbContext,
+                      const UA_NodeId *sessionId, void *sessionContext,
+                      const UA_NodeId *nodeId) {
+    UA_LockedBackend *lb = (UA_LockedBackend*)hdbContext;
+    BATCH_LOCK(lb->queue);
+    UA_Boolean res = lb->backend.boundSupported(server, lb->backend.context,
+                                                sessionId, sessionContext, nodeId);
+    BATCH_UNLOCK(lb->queue);
+    return res;
+}
+
+static UA_Boolean
+timestampsToReturnSupported_locked(UA_Server *server, void *hdbContext,
+                                   const UA_NodeId *sessionId, void *sessionContext,
+                                   const UA_NodeId *nodeId,
+                                   const UA_TimestampsToReturn timestampsToReturn) {
+    UA_LockedBackend *lb = (UA_LockedBackend*)hdbContext;
+    BATCH_LOCK(lb->queue);
+    drainQueue(lb->queue);
+    UA_Boolean res =
+        lb->backend.timestampsToReturnSupported(server, lb->backend.context, sessionId,
+                                                sessionContext, nodeId,
+                                                timestampsToReturn);
+    BATCH_UNLOCK(lb->queue);
+    return res;
+}
+
+/* insertDataValue, replaceDataValue and updateDataValue have the same
+ * signature */
+#define UA_LOCKED_UPDATE_METHOD(METHOD)                                 \
+static UA_StatusCode                                                    \
+METHOD##_locked(UA_Server *server, void *hdbContext,                    \
+                const UA_NodeId *sessionId, void *sessionContext,       \
+                const UA_NodeId *nodeId, const UA_DataValue *value) {   \
+    UA_LockedBackend *lb = (UA_LockedBackend*)hdbContext;               \
+    BATCH_LOCK(lb->queue);                                              \
+    drainQueue(lb->queue);                                              \
+    UA_StatusCode res =                                                 \
+        lb->backend.METHOD(server, lb->backend.context, sessionId,      \
+                           sessionContext, nodeId, value);              \
+    BATCH_UNLOCK(lb->queue);                                            \
+    return res;                                                         \
+}
+
+UA_LOCKED_UPDATE_METHOD(insertDataValue)
+UA_LOCKED_UPDATE_METHOD(replaceDataValue)
+UA_LOCKED_UPDATE_METHOD(updateDataValue)
+
+static UA_StatusCode
+removeDataValue_locked(UA_Server *server, void *hdbContext,
+                       const UA_NodeId *sessionId, void *sessionContext,
+                       const UA_NodeId *nodeId, UA_DateTime startTimestamp,
+                       UA_DateTime endTimestamp) {
+    UA_LockedBackend *lb = (UA_LockedBackend*)hdbContext;
+    BATCH_LOCK(lb->queue);
+    drainQueue(lb->queue);
+    UA_StatusCode res =
+        lb->backend.removeDataValue(server, lb->backend.context, sessionId,
+                                    sessionContext, nodeId, startTimestamp,
+                                    endTimestamp);
+    BATCH_UNLOCK(lb->queue);
+    return res;
+}
+
+static UA_StatusCode
+getAggregateSummary_locked(UA_Server *server, void *hdbContext,
+                           const UA_NodeId *sessionId, void *sessionContext,
+                           const UA_NodeId *nodeId, UA_DateTime start,
+                           UA_DateTime end, UA_HistoryAggregateSummary *summary) {
+    UA_LockedBackend *lb = (UA_LockedBackend*)hdbContext;
+    BATCH_LOCK(lb->queue);
+    drainQueue(lb->queue);
+    UA_StatusCode res =
+        lb->backend.getAggregateSummary(server, lb->backend.context, sessionId,
+                                        sessionContext, nodeId, start, end, summary);
+    BATCH_UNLOCK(lb->queue);
+    return res;
+}
+
+/* The wrapper only has the methods of the wrapped backend. For example, the
+ * HistoryDatabase decides between the high-level and the low-level API by the
+ * getHistoryData method. */
+static void
+setLockedBackend(UA_NodeIdStoreContextItem_gathering_default *item) {
+    const UA_HistoryDataBackend *b = &item->setting.historizingBackend;
+    item->locked->backend = *b;
+    item->lockedSetting = item->setting;
+    UA_HistoryDataBackend *lb = &item->lockedSetting.historizingBackend;
+    memset(lb, 0, sizeof(UA_HistoryDataBackend));
+    lb->context = item->locked;
+#define UA_LOCKED_SET(METHOD) if(b->METHOD) lb->METHOD = METHOD##_locked
+    UA_LOCKED_SET(serverSetHistoryData);
+    UA_LOCKED_SET(getHistoryData);
+    UA_LOCKED_SET(getDateTimeMatch);
+    UA_LOCKED_SET(getEnd);
+    UA_LOCKED_SET(lastIndex);
+    UA_LOCKED_SET(firstIndex);
+    UA_LOCKED_SET(resultSize);
+    UA_LOCKED_SET(copyDataValues);
+    UA_LOCKED_SET(getDataValue);
+    UA_LOCKED_SET(boundSupported);
+    UA_LOCKED_SET(timestampsToReturnSupported);
+    UA_LOCKED_SET(insertDataValue);
+    UA_LOCKED_SET(replaceDataValue);
+    UA_LOCKED_SET(updateDataValue);
+    UA_LOCKED_SET(removeDataValue);
+    UA_LOCKED_SET(getAggregateSummary);
+#undef UA_LOCKED_SET
+}
+
+static UA_StatusCode
+registerNodeId_gathering_batched(UA_Server *server, void *context,
+                                 const UA_NodeId *nodeId,
+                                 const UA_HistorizingNodeIdSettings setting) {
+    UA_NodeIdStoreContext *ctx = (UA_NodeIdStoreContext*)context;
+    UA_LockedBackend *locked = (UA_LockedBackend*)UA_calloc(1, sizeof(UA_LockedBackend));
+    if(!locked)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_StatusCode res = registerNodeId_gathering_default(server, context, nodeId, setting);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_free(locked);
+        return res;
+    }
+    UA_NodeIdStoreContextItem_gathering_default *item = &ctx->dataStore[ctx->storeEnd - 1];
+    locked->queue = ctx->queue;
+    item->queue = ctx->queue;
+    item->locked = locked;
+    setLockedBackend(item);
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_Boolean
+updateNodeIdSetting_gathering_batched(UA_Server *server, void *context,
+                                      const UA_NodeId *nodeId,
+                                      const UA_HistorizingNodeIdSettings setting) {
+    /* The queued values go to the previous backend */
+    UA_NodeIdStoreContext *ctx = (UA_NodeIdStoreContext*)context;
+    BATCH_LOCK(ctx->queue);
+    drainQueue(ctx->queue);
+    UA_Boolean res = updateNodeIdSetting_gathering_default(server, context, nodeId, setting);
+    if(res)
+        setLockedBackend(getNodeIdStoreContextItem_gathering_default(ctx, nodeId));
+    BATCH_UNLOCK(ctx->queue);
+    return res;
+}
+
+static const UA_HistorizingNodeIdSettings*
+getHistorizingSetting_gathering_batched(UA_Server *server, void *context,
+                                        const UA_NodeId *nodeId) {
+    UA_NodeIdStoreContext *ctx = (UA_NodeIdStoreContext*)context;
+    UA_NodeIdStoreContextItem_gathering_default *item =
+        getNodeIdStoreContextItem_gathering_default(ctx, nodeId);
+    return (item) ? &item->lockedSetting : NULL;
+}
+
+static void
+deleteMembers_gathering_batched(UA_HistoryDataGathering *gathering) {
+    if(gathering == NULL || gathering->context == NULL)
+        return;
+    UA_NodeIdStoreContext *ctx = (UA_NodeIdStoreContext*)gathering->context;
+    UA_BatchQueue_delete(ctx->queue); /* Stores the queued values */
+    for(size_t i = 0; i < ctx->storeEnd; ++i) {
+        UA_DataValue_clear(&ctx->dataStore[i].locked->current);
+        UA_free(ctx->dataStore[i].locked);
+    }
+    deleteMembers_gathering_default(gathering);
+}
+
+UA_HistoryDataGathering
+UA_HistoryDataGathering_Batched(size_t initialNodeIdStoreSize, size_t queueSize) {
+    UA_HistoryDataGathering gathering = UA_HistoryDataGathering_Default(initialNodeIdStoreSize);
+    UA_NodeIdStoreContext *ctx = (UA_NodeIdStoreContext*)gathering.context;
+    ctx->queue = UA_BatchQueue_new((queueSize > 0) ? queueSize : BATCH_DEFAULT_QUEUESIZE);
+    if(!ctx->queue) {
+        deleteMembers_gathering_default(&gathering);
+        memset(&gathering, 0, sizeof(UA_HistoryDataGathering));
+        return gathering;
+    }
+    gathering.registerNodeId = &registerNodeId_gathering_batched;
+    gathering.updateNodeIdSetting = &updateNodeIdSetting_gathering_batched;
+    gathering.getHistorizingSetting = &getHistorizingSetting_gathering_batched;
+    gathering.deleteMembers = &deleteMembers_gathering_batched;
+    return gathering;
+}
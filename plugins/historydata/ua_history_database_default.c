@@ -10,8 +10,17 @@
 
 #include <limits.h>
 
+struct HistoryCursor;
+
 typedef struct {
     UA_HistoryDataGathering gathering;
+    UA_HistoryEventBackend eventBackend;
+
+    /* Cursors of the open ReadRaw continuation points */
+    struct HistoryCursor *cursors;
+    size_t cursorsSize;
+    UA_UInt32 lastCursorId;
+    UA_UInt64 cursorClock;
 } UA_HistoryDatabaseContext_default;
 
 static size_t
@@ -142,8 +151,218 @@ getResultSize_service_default(const UA_HistoryDataBackend* backend,
     return size;
 }
 
+/* Server-held state of a ReadRaw continuation point. The continuation point
+ * carries only the id of the cursor. Follow-up calls resume from the cursor of
+ * the backend instead of locating the already returned values again. Backends
+ * without cursors resume from their own continuation point. The indices of the
+ * low level API are opaque and cannot be advanced by the database. */
+typedef struct HistoryCursor {
+    struct HistoryCursor *next;
+    UA_UInt32 id;
+    UA_UInt64 lastUse;
+    UA_NodeId sessionId;
+    UA_NodeId nodeId;
+    UA_HistoryDataBackend backend;
+    void *backendCursor; /* Opened if the backend implements cursors */
+    UA_Boolean addFirst; /* Bound values that are not yet returned */
+    UA_Boolean addLast;
+    UA_DateTime firstTime;
+    UA_DateTime lastTime;
+    UA_Boolean reverse;
+    size_t startIndex;
+    size_t endIndex;
+    UA_ByteString backendContinuationPoint;
+    size_t remaining; /* Values left in the range without the bounds */
+} HistoryCursor;
+
+/* Cursors of abandoned continuation points are evicted beyond this number */
+#define HISTORYCURSORS_MAX 256
+
+static UA_StatusCode
+openHistoryCursor(HistoryCursor *c, const UA_HistoryDataBackend *backend,
+                  UA_Server *server, const UA_NodeId *sessionId,
+                  void *sessionContext, const UA_NodeId *nodeId,
+                  UA_DateTime start, UA_DateTime end, UA_Boolean returnBounds) {
+    memset(c, 0, sizeof(HistoryCursor));
+    c->backend = *backend;
+    size_t storeEnd = backend->getEnd(server, backend->context, sessionId, sessionContext, nodeId);
+    size_t firstIndex = backend->firstIndex(server, backend->context, sessionId, sessionContext, nodeId);
+    size_t size = getResultSize_service_default(backend, server, sessionId, sessionContext,
+                                                nodeId, start, end, 0, returnBounds,
+                                                &c->startIndex, &c->endIndex, &c->addFirst,
+                                                &c->addLast, &c->reverse);
+    if(c->startIndex != storeEnd && c->endIndex != storeEnd)
+        c->remaining = size - c->addFirst - c->addLast;
+
+    /* The timestamps of the bound values */
+    c->firstTime = (start == LLONG_MIN) ? end : start;
+    c->lastTime = end;
+    if(c->addLast && storeEnd != firstIndex &&
+       (start == LLONG_MIN || end == LLONG_MIN)) {
+        const UA_DataValue *dv = backend->getDataValue(server, backend->context, sessionId,
+                                                       sessionContext, nodeId, c->endIndex);
+        if(dv)
+            c->lastTime = (start == LLONG_MIN) ?
+                dv->sourceTimestamp - UA_DATETIME_SEC : dv->sourceTimestamp + UA_DATETIME_SEC;
+    }
+
+    UA_StatusCode res = UA_NodeId_copy(nodeId, &c->nodeId);
+    if(res == UA_STATUSCODE_GOOD && sessionId)
+        res = UA_NodeId_copy(sessionId, &c->sessionId);
+    if(res == UA_STATUSCODE_GOOD && c->remaining > 0 && backend->openCursor)
+        res = backend->openCursor(server, backend->context, sessionId, sessionContext,
+                                  nodeId, c->startIndex, c->endIndex, c->reverse,
+                                  &c->backendCursor);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_NodeId_clear(&c->nodeId);
+        UA_NodeId_clear(&c->sessionId);
+    }
+    return res;
+}
+
+static UA_Boolean
+historyCursorDone(const HistoryCursor *c) {
+    return !c->addFirst && !c->addLast && c->remaining == 0;
+}
+
+static void
+closeHistoryCursor(UA_Server *server, HistoryCursor *c) {
+    if(c->backendCursor)
+        c->backend.closeCursor(server, c->backend.context, c->backendCursor);
+    c->backendCursor = NULL;
+    UA_ByteString_clear(&c->backendContinuationPoint);
+    UA_NodeId_clear(&c->nodeId);
+    UA_NodeId_clear(&c->sessionId);
+}
+
+static void
+setBoundValue(UA_DataValue *dv, UA_DateTime t) {
+    dv->hasStatus = true;
+    dv->status = UA_STATUSCODE_BADBOUNDNOTFOUND;
+    dv->hasSourceTimestamp = true;
+    dv->sourceTimestamp = t;
+}
+
+/* Read up to limit values (no limit for zero) from the cursor */
 static UA_StatusCode
-getHistoryData_service_default(const UA_HistoryDataBackend* backend,
+readHistoryCursor(HistoryCursor *c, UA_Server *server, const UA_NodeId *sessionId,
+                  void *sessionContext, size_t limit, UA_NumericRange range,
+                  size_t *resultSize, UA_DataValue **result) {
+    size_t size = (size_t)c->addFirst + c->remaining + (size_t)c->addLast;
+    if(limit > 0 && size > limit)
+        size = limit;
+    UA_DataValue *values = (UA_DataValue*)UA_Array_new(size, &UA_TYPES[UA_TYPES_DATAVALUE]);
+    if(!values)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    size_t counter = 0;
+    if(c->addFirst && counter < size) {
+        setBoundValue(&values[counter++], c->firstTime);
+        c->addFirst = false;
+    }
+
+    if(c->remaining > 0 && counter < size) {
+        size_t n = size - counter;
+        if(n > c->remaining)
+            n = c->remaining;
+        size_t provided = 0;
+        UA_Boolean more = true;
+        UA_StatusCode res;
+        if(c->backendCursor) {
+            res = c->backend.readCursor(server, c->backend.context, c->backendCursor,
+                                        n, range, &provided, &values[counter]);
+        } else {
+            UA_ByteString backendOutContinuationPoint = UA_BYTESTRING_NULL;
+            res = c->backend.copyDataValues(server, c->backend.context, sessionId,
+                                            sessionContext, &c->nodeId, c->startIndex,
+                                            c->endIndex, c->reverse, n, range, false,
+                                            &c->backendContinuationPoint,
+                                            &backendOutContinuationPoint,
+                                            &provided, &values[counter]);
+            UA_ByteString_clear(&c->backendContinuationPoint);
+            c->backendContinuationPoint = backendOutContinuationPoint;
+            more = (backendOutContinuationPoint.length > 0);
+        }
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_Array_delete(values, size, &UA_TYPES[UA_TYPES_DATAVALUE]);
+            return res;
+        }
+        if(provided > n)
+            provided = n;
+        counter += provided;
+        /* The backend has no more values if it provides less */
+        c->remaining = (!more || provided < n) ? 0 : c->remaining - provided;
+    }
+
+    if(c->addLast && c->remaining == 0 && counter < size) {
+        setBoundValue(&values[counter++], c->lastTime);
+        c->addLast = false;
+    }
+
+    /* The unused values at the end of the array are empty */
+    *resultSize = counter;
+    *result = values;
+    return UA_STATUSCODE_GOOD;
+}
+
+static HistoryCursor *
+findHistoryCursor(UA_HistoryDatabaseContext_default *ctx, const UA_NodeId *sessionId,
+                  const UA_NodeId *nodeId, const UA_ByteString *continuationPoint) {
+    if(continuationPoint->length != sizeof(UA_UInt32))
+        return NULL;
+    UA_UInt32 id;
+    memcpy(&id, continuationPoint->data, sizeof(UA_UInt32));
+    for(HistoryCursor *c = ctx->cursors; c; c = c->next) {
+        if(c->id != id)
+            continue;
+        /* Continuation points are valid only for the session and node */
+        if(!UA_NodeId_equal(&c->nodeId, nodeId) ||
+           !UA_NodeId_equal(&c->sessionId, (sessionId) ? sessionId : &UA_NODEID_NULL))
+            return NULL;
+        return c;
+    }
+    return NULL;
+}
+
+static void
+removeHistoryCursor(UA_Server *server, UA_HistoryDatabaseContext_default *ctx,
+                    HistoryCursor *cursor) {
+    for(HistoryCursor **c = &ctx->cursors; *c; c = &(*c)->next) {
+        if(*c != cursor)
+            continue;
+        *c = cursor->next;
+        ctx->cursorsSize--;
+        break;
+    }
+    closeHistoryCursor(server, cursor);
+    UA_free(cursor);
+}
+
+static void
+addHistoryCursor(UA_Server *server, UA_HistoryDatabaseContext_default *ctx,
+                 HistoryCursor *cursor) {
+    /* Evict the least recently used cursor */
+    if(ctx->cursorsSize >= HISTORYCURSORS_MAX) {
+        HistoryCursor *oldest = ctx->cursors;
+        for(HistoryCursor *c = ctx->cursors; c; c = c->next) {
+            if(c->lastUse < oldest->lastUse)
+                oldest = c;
+        }
+        removeHistoryCursor(server, ctx, oldest);
+    }
+
+    /* Zero is not used as an id */
+    do {
+        cursor->id = ++ctx->lastCursorId;
+    } while(cursor->id == 0);
+    cursor->next = ctx->cursors;
+    ctx->cursors = cursor;
+    ctx->cursorsSize++;
+}
+
+static UA_StatusCode
+getHistoryData_service_default(UA_HistoryDatabaseContext_default *ctx,
+                               const UA_HistoryDataBackend* backend,
                                const UA_DateTime start,
                                const UA_DateTime end,
                                UA_Server *server,
@@ -161,137 +380,56 @@ getHistoryData_service_default(const UA_HistoryDataBackend* backend,
                                size_t *resultSize,
                                UA_DataValue ** result)
 {
-    size_t skip = 0;
-    UA_ByteString backendContinuationPoint;
-    UA_ByteString_init(&backendContinuationPoint);
-    if (continuationPoint->length > 0) {
-        if (continuationPoint->length >= sizeof(size_t)) {
-            skip = *((size_t*)(continuationPoint->data));
-            if (continuationPoint->length > 0) {
-                backendContinuationPoint.length = continuationPoint->length - sizeof(size_t);
-                backendContinuationPoint.data = continuationPoint->data + sizeof(size_t);
-            }
-        } else {
+    /* Resume from the cursor of the continuation point */
+    HistoryCursor *cursor = NULL;
+    if(continuationPoint->length > 0) {
+        cursor = findHistoryCursor(ctx, sessionId, nodeId, continuationPoint);
+        if(!cursor)
             return UA_STATUSCODE_BADCONTINUATIONPOINTINVALID;
+        if(releaseContinuationPoints) {
+            removeHistoryCursor(server, ctx, cursor);
+            return UA_STATUSCODE_GOOD;
         }
-    }
-
-    size_t storeEnd = backend->getEnd(server, backend->context, sessionId, sessionContext, nodeId);
-    size_t startIndex;
-    size_t endIndex;
-    UA_Boolean addFirst;
-    UA_Boolean addLast;
-    UA_Boolean reverse;
-    size_t _resultSize = getResultSize_service_default(backend,
-                                                       server,
-                                                       sessionId,
-                                                       sessionContext,
-                                                       nodeId,
-                                                       start,
-                                                       end,
-                                                       numValuesPerNode == 0 ? 0 : numValuesPerNode + (UA_UInt32)skip,
-                                                       returnBounds,
-                                                       &startIndex,
-                                                       &endIndex,
-                                                       &addFirst,
-                                                       &addLast,
-                                                       &reverse);
-    *resultSize = _resultSize - skip;
-    if (*resultSize > maxSize) {
-        *resultSize = maxSize;
-    }
-    UA_DataValue *outResult= (UA_DataValue*)UA_Array_new(*resultSize, &UA_TYPES[UA_TYPES_DATAVALUE]);
-    if (!outResult) {
-        *resultSize = 0;
-        return UA_STATUSCODE_BADOUTOFMEMORY;
-    }
-    *result = outResult;
-
-    size_t counter = 0;
-    if (addFirst) {
-        if (skip == 0) {
-            outResult[counter].hasStatus = true;
-            outResult[counter].status = UA_STATUSCODE_BADBOUNDNOTFOUND;
-            outResult[counter].hasSourceTimestamp = true;
-            if (start == LLONG_MIN) {
-                outResult[counter].sourceTimestamp = end;
-            } else {
-                outResult[counter].sourceTimestamp = start;
-            }
-            ++counter;
+    } else {
+        cursor = (HistoryCursor*)UA_malloc(sizeof(HistoryCursor));
+        if(!cursor)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        UA_StatusCode res = openHistoryCursor(cursor, backend, server, sessionId,
+                                              sessionContext, nodeId, start, end,
+                                              returnBounds);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_free(cursor);
+            return res;
         }
     }
-    UA_ByteString backendOutContinuationPoint;
-    UA_ByteString_init(&backendOutContinuationPoint);
-    if (endIndex != storeEnd && startIndex != storeEnd) {
-        size_t retval = 0;
+    cursor->lastUse = ++ctx->cursorClock;
 
-        size_t valueSize = *resultSize - counter;
-        if (valueSize + skip > _resultSize - addFirst - addLast) {
-            if (skip == 0) {
-                valueSize = _resultSize - addFirst - addLast;
-            } else {
-                valueSize = _resultSize - skip - addLast;
-            }
-
-        }
-
-        UA_StatusCode ret = UA_STATUSCODE_GOOD;
-        if (valueSize > 0)
-            ret = backend->copyDataValues(server,
-                                          backend->context,
-                                          sessionId,
-                                          sessionContext,
-                                          nodeId,
-                                          startIndex,
-                                          endIndex,
-                                          reverse,
-                                          valueSize,
-                                          range,
-                                          releaseContinuationPoints,
-                                          &backendContinuationPoint,
-                                          &backendOutContinuationPoint,
-                                          &retval,
-                                          &outResult[counter]);
-        if (ret != UA_STATUSCODE_GOOD) {
-            UA_Array_delete(outResult, *resultSize, &UA_TYPES[UA_TYPES_DATAVALUE]);
-            *result = NULL;
-            *resultSize = 0;
-            return ret;
-        }
-        counter += retval;
-    }
-    if (addLast && counter < *resultSize) {
-        outResult[counter].hasStatus = true;
-        outResult[counter].status = UA_STATUSCODE_BADBOUNDNOTFOUND;
-        outResult[counter].hasSourceTimestamp = true;
-        if (start == LLONG_MIN && storeEnd != backend->firstIndex(server, backend->context, sessionId, sessionContext, nodeId)) {
-            outResult[counter].sourceTimestamp = backend->getDataValue(server, backend->context, sessionId, sessionContext, nodeId, endIndex)->sourceTimestamp - UA_DATETIME_SEC;
-        } else if (end == LLONG_MIN && storeEnd != backend->firstIndex(server, backend->context, sessionId, sessionContext, nodeId)) {
-            outResult[counter].sourceTimestamp = backend->getDataValue(server, backend->context, sessionId, sessionContext, nodeId, endIndex)->sourceTimestamp + UA_DATETIME_SEC;
-        } else {
-            outResult[counter].sourceTimestamp = end;
+    size_t limit = maxSize;
+    if(numValuesPerNode > 0 && (limit == 0 || numValuesPerNode < limit))
+        limit = numValuesPerNode;
+    UA_StatusCode res = readHistoryCursor(cursor, server, sessionId, sessionContext,
+                                          limit, range, resultSize, result);
+    if(res == UA_STATUSCODE_GOOD && !historyCursorDone(cursor)) {
+        res = UA_ByteString_allocBuffer(outContinuationPoint, sizeof(UA_UInt32));
+        if(res == UA_STATUSCODE_GOOD) {
+            if(cursor->id == 0)
+                addHistoryCursor(server, ctx, cursor);
+            memcpy(outContinuationPoint->data, &cursor->id, sizeof(UA_UInt32));
+            return UA_STATUSCODE_GOOD;
         }
+        UA_Array_delete(*result, *resultSize, &UA_TYPES[UA_TYPES_DATAVALUE]);
+        *result = NULL;
+        *resultSize = 0;
     }
-    // there are more values
-    if (skip + *resultSize < _resultSize
-            // there are not more values for this request, but there are more values in database
-            || (backendOutContinuationPoint.length > 0
-                && numValuesPerNode != 0)
-            // we deliver just one value which is a FIRST/LAST value
-            || (skip == 0
-                && addFirst == true
-                && *resultSize == 1)) {
-        if(UA_ByteString_allocBuffer(outContinuationPoint, backendOutContinuationPoint.length + sizeof(size_t))
-                != UA_STATUSCODE_GOOD) {
-            return UA_STATUSCODE_BADOUTOFMEMORY;
-        }
-        *((size_t*)(outContinuationPoint->data)) = skip + *resultSize;
-        if(backendOutContinuationPoint.length > 0)
-            memcpy(outContinuationPoint->data + sizeof(size_t), backendOutContinuationPoint.data, backendOutContinuationPoint.length);
+
+    /* The cursor is done or failed */
+    if(cursor->id != 0) {
+        removeHistoryCursor(server, ctx, cursor);
+    } else {
+        closeHistoryCursor(server, cursor);
+        UA_free(cursor);
     }
-    UA_ByteString_clear(&backendOutContinuationPoint);
-    return UA_STATUSCODE_GOOD;
+    return res;
 }
 
 static void
@@ -551,6 +689,7 @@ readRaw_service_default(UA_Server *server,
                         historyData[i]);
         } else {
             getHistoryDataStatusCode = getHistoryData_service_default(
+                        ctx,
                         &setting->historizingBackend,
                         historyReadDetails->startTime,
                         historyReadDetails->endTime,
@@ -578,6 +717,503 @@ readRaw_service_default(UA_Server *server,
     return;
 }
 
+/**************/
+/* Aggregates */
+/**************/
+
+/* Raw samples are read in chunks of this size */
+#define AGGREGATE_CHUNKSIZE 1024
+
+/* StatusCode with the InfoType DataValue and the historian bits of Part 11,
+ * 6.3.1 */
+#define AGGREGATE_CALCULATED   0x00000401
+#define AGGREGATE_INTERPOLATED 0x00000402
+
+/* The intervals of a ReadProcessed request. Interval j starts at
+ * origin + j * interval (origin - j * interval in reverse) and ends at the next
+ * interval or at the limit. Only the intervals [first, first + count) are
+ * returned by the current call. */
+typedef struct {
+    UA_DateTime origin;
+    UA_DateTime limit;
+    UA_DateTime interval;
+    UA_Boolean reverse;
+    size_t total;
+    size_t first;
+    size_t count;
+} AggregateIntervals;
+
+static void
+intervalBounds(const AggregateIntervals *iv, size_t k,
+               UA_DateTime *start, UA_DateTime *end) {
+    UA_DateTime j = (UA_DateTime)(iv->first + k);
+    if(!iv->reverse) {
+        *start = iv->origin + j * iv->interval;
+        *end = (j + 1 == (UA_DateTime)iv->total) ? iv->limit : *start + iv->interval;
+    } else {
+        *end = iv->origin - j * iv->interval;
+        *start = (j + 1 == (UA_DateTime)iv->total) ? iv->limit : *end - iv->interval;
+    }
+}
+
+/* Returns the local index of the interval that contains the time, or count */
+static size_t
+intervalOf(const AggregateIntervals *iv, UA_DateTime t) {
+    UA_DateTime offset = (!iv->reverse) ? t - iv->origin : iv->origin - 1 - t;
+    if(offset < 0)
+        return iv->count;
+    size_t j = (size_t)(offset / iv->interval);
+    if(j < iv->first || j - iv->first >= iv->count)
+        return iv->count;
+    return j - iv->first;
+}
+
+static UA_DateTime
+sampleTime(const UA_DataValue *dv) {
+    return (dv->hasSourceTimestamp) ? dv->sourceTimestamp : dv->serverTimestamp;
+}
+
+static UA_Boolean
+isGoodSample(const UA_DataValue *dv) {
+    return !dv->hasStatus || UA_StatusCode_isGood(dv->status);
+}
+
+static UA_Boolean
+numericValue(const UA_DataValue *dv, UA_Double *out) {
+    if(!dv->hasValue || !UA_Variant_isScalar(&dv->value))
+        return false;
+    const void *p = dv->value.data;
+    switch(dv->value.type->typeKind) {
+    case UA_DATATYPEKIND_SBYTE: *out = *(const UA_SByte*)p; return true;
+    case UA_DATATYPEKIND_BYTE: *out = *(const UA_Byte*)p; return true;
+    case UA_DATATYPEKIND_INT16: *out = *(const UA_Int16*)p; return true;
+    case UA_DATATYPEKIND_UINT16: *out = *(const UA_UInt16*)p; return true;
+    case UA_DATATYPEKIND_INT32: *out = *(const UA_Int32*)p; return true;
+    case UA_DATATYPEKIND_UINT32: *out = *(const UA_UInt32*)p; return true;
+    case UA_DATATYPEKIND_INT64: *out = (UA_Double)*(const UA_Int64*)p; return true;
+    case UA_DATATYPEKIND_UINT64: *out = (UA_Double)*(const UA_UInt64*)p; return true;
+    case UA_DATATYPEKIND_FLOAT: *out = *(const UA_Float*)p; return true;
+    case UA_DATATYPEKIND_DOUBLE: *out = *(const UA_Double*)p; return true;
+    default: return false;
+    }
+}
+
+/* Add the numeric values to the summary. The loops run over a contiguous array
+ * with independent accumulators, so the compiler can vectorize them. */
+static void
+reduceValues(const UA_Double *v, size_t n, UA_HistoryAggregateSummary *s) {
+    if(n == 0)
+        return;
+    UA_Double sum[4] = {0.0, 0.0, 0.0, 0.0};
+    UA_Double min = v[0];
+    UA_Double max = v[0];
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4) {
+        sum[0] += v[i];
+        sum[1] += v[i+1];
+        sum[2] += v[i+2];
+        sum[3] += v[i+3];
+    }
+    for(; i < n; i++)
+        sum[0] += v[i];
+    for(i = 0; i < n; i++) {
+        min = (v[i] < min) ? v[i] : min;
+        max = (v[i] > max) ? v[i] : max;
+    }
+    if(s->numericCount == 0 || min < s->min)
+        s->min = min;
+    if(s->numericCount == 0 || max > s->max)
+        s->max = max;
+    s->sum += (sum[0] + sum[1]) + (sum[2] + sum[3]);
+    s->numericCount += n;
+}
+
+/* Add a chunk of raw samples (ordered by time) to the interval summaries */
+static void
+accumulateSamples(const AggregateIntervals *iv, const UA_DataValue *values,
+                  size_t valuesSize, UA_Double *buf,
+                  UA_HistoryAggregateSummary *summaries) {
+    size_t i = 0;
+    while(i < valuesSize) {
+        size_t k = intervalOf(iv, sampleTime(&values[i]));
+        if(k == iv->count) {
+            i++;
+            continue;
+        }
+        size_t n = 0;
+        for(; i < valuesSize && intervalOf(iv, sampleTime(&values[i])) == k; i++) {
+            if(!isGoodSample(&values[i]))
+                continue;
+            summaries[k].count++;
+            if(!numericValue(&values[i], &buf[n]))
+                continue;
+            if(++n == AGGREGATE_CHUNKSIZE) {
+                reduceValues(buf, n, &summaries[k]);
+                n = 0;
+            }
+        }
+        reduceValues(buf, n, &summaries[k]);
+    }
+}
+
+/* Read the raw samples in chunks. The low level API is streamed through a
+ * local cursor. */
+static UA_StatusCode
+readRawChunk(UA_Server *server, const UA_NodeId *sessionId, void *sessionContext,
+             const UA_HistoryDataBackend *backend, const UA_NodeId *nodeId,
+             UA_DateTime start, UA_DateTime end, HistoryCursor *cursor,
+             const UA_ByteString *continuationPoint,
+             UA_ByteString *outContinuationPoint, UA_HistoryData *data) {
+    UA_NumericRange range;
+    range.dimensionsSize = 0;
+    range.dimensions = NULL;
+    if(backend->getHistoryData)
+        return backend->getHistoryData(server, sessionId, sessionContext, backend,
+                                       start, end, nodeId, AGGREGATE_CHUNKSIZE, 0,
+                                       false, UA_TIMESTAMPSTORETURN_BOTH, range, false,
+                                       continuationPoint, outContinuationPoint, data);
+    UA_StatusCode res = readHistoryCursor(cursor, server, sessionId, sessionContext,
+                                          AGGREGATE_CHUNKSIZE, range,
+                                          &data->dataValuesSize, &data->dataValues);
+    if(res != UA_STATUSCODE_GOOD || historyCursorDone(cursor))
+        return res;
+    /* Only signals that there are more samples */
+    return UA_ByteString_allocBuffer(outContinuationPoint, 1);
+}
+
+/* Summarize the intervals in a single pass over the raw samples */
+static UA_StatusCode
+summarizeRaw(UA_Server *server, const UA_NodeId *sessionId, void *sessionContext,
+             const UA_HistoryDataBackend *backend, const UA_NodeId *nodeId,
+             const AggregateIntervals *iv, UA_HistoryAggregateSummary *summaries) {
+    UA_DateTime start, end, unused;
+    intervalBounds(iv, 0, &start, &end);
+    if(!iv->reverse)
+        intervalBounds(iv, iv->count - 1, &unused, &end);
+    else
+        intervalBounds(iv, iv->count - 1, &start, &unused);
+
+    UA_Double *buf = (UA_Double*)UA_malloc(AGGREGATE_CHUNKSIZE * sizeof(UA_Double));
+    if(!buf)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    HistoryCursor cursor;
+    memset(&cursor, 0, sizeof(HistoryCursor));
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    if(!backend->getHistoryData)
+        res = openHistoryCursor(&cursor, backend, server, sessionId, sessionContext,
+                                nodeId, start, end, false);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_free(buf);
+        return res;
+    }
+    UA_ByteString cp = UA_BYTESTRING_NULL;
+    do {
+        UA_HistoryData data;
+        UA_HistoryData_init(&data);
+        UA_ByteString outCp = UA_BYTESTRING_NULL;
+        res = readRawChunk(server, sessionId, sessionContext, backend, nodeId,
+                           start, end, &cursor, &cp, &outCp, &data);
+        UA_ByteString_clear(&cp);
+        cp = outCp;
+        if(res == UA_STATUSCODE_GOOD)
+            accumulateSamples(iv, data.dataValues, data.dataValuesSize, buf, summaries);
+        if(data.dataValuesSize == 0)
+            UA_ByteString_clear(&cp); /* No progress */
+        UA_HistoryData_clear(&data);
+    } while(res == UA_STATUSCODE_GOOD && cp.length > 0);
+    UA_ByteString_clear(&cp);
+    if(!backend->getHistoryData)
+        closeHistoryCursor(server, &cursor);
+    UA_free(buf);
+    return res;
+}
+
+/* Summarize the intervals with the rollups of the backend */
+static UA_StatusCode
+summarizeRollup(UA_Server *server, const UA_NodeId *sessionId, void *sessionContext,
+                const UA_HistoryDataBackend *backend, const UA_NodeId *nodeId,
+                const AggregateIntervals *iv, UA_HistoryAggregateSummary *summaries) {
+    for(size_t k = 0; k < iv->count; k++) {
+        UA_DateTime start, end;
+        intervalBounds(iv, k, &start, &end);
+        UA_StatusCode res =
+            backend->getAggregateSummary(server, backend->context, sessionId,
+                                         sessionContext, nodeId, start, end,
+                                         &summaries[k]);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Linear interpolation between the samples around the timestamp */
+static void
+interpolate(UA_Server *server, const UA_NodeId *sessionId, void *sessionContext,
+            const UA_HistoryDataBackend *backend, const UA_NodeId *nodeId,
+            UA_DateTime t, UA_DataValue *out) {
+    out->hasStatus = true;
+    out->status = UA_STATUSCODE_BADNODATA;
+    size_t storeEnd = backend->getEnd(server, backend->context, sessionId,
+                                      sessionContext, nodeId);
+    size_t before = backend->getDateTimeMatch(server, backend->context, sessionId,
+                                              sessionContext, nodeId, t,
+                                              MATCH_EQUAL_OR_BEFORE);
+    if(before == storeEnd)
+        return;
+    const UA_DataValue *dv = backend->getDataValue(server, backend->context, sessionId,
+                                                   sessionContext, nodeId, before);
+    UA_Double v0;
+    if(!dv || !isGoodSample(dv) || !numericValue(dv, &v0))
+        return;
+    UA_DateTime t0 = sampleTime(dv);
+    UA_Double v = v0;
+    UA_StatusCode status = UA_STATUSCODE_GOOD;
+    if(t0 != t) {
+        size_t after = backend->getDateTimeMatch(server, backend->context, sessionId,
+                                                 sessionContext, nodeId, t, MATCH_AFTER);
+        if(after == storeEnd)
+            return;
+        dv = backend->getDataValue(server, backend->context, sessionId,
+                                   sessionContext, nodeId, after);
+        UA_Double v1;
+        if(!dv || !isGoodSample(dv) || !numericValue(dv, &v1))
+            return;
+        UA_DateTime t1 = sampleTime(dv);
+        v = v0 + (v1 - v0) * ((UA_Double)(t - t0) / (UA_Double)(t1 - t0));
+        status = AGGREGATE_INTERPOLATED;
+    }
+    if(UA_Variant_setScalarCopy(&out->value, &v, &UA_TYPES[UA_TYPES_DOUBLE]) != UA_STATUSCODE_GOOD)
+        return;
+    out->hasValue = true;
+    out->status = status;
+}
+
+static void
+summaryToDataValue(UA_UInt32 aggregate, const UA_HistoryAggregateSummary *s,
+                   UA_DataValue *out) {
+    out->hasStatus = true;
+    if(aggregate == UA_NS0ID_AGGREGATEFUNCTION_COUNT) {
+        UA_Int32 count = (UA_Int32)s->count;
+        out->status = AGGREGATE_CALCULATED;
+        out->hasValue =
+            (UA_Variant_setScalarCopy(&out->value, &count, &UA_TYPES[UA_TYPES_INT32])
+             == UA_STATUSCODE_GOOD);
+        return;
+    }
+    if(s->count == 0) {
+        out->status = UA_STATUSCODE_BADNODATA;
+        return;
+    }
+    if(s->numericCount == 0) {
+        out->status = UA_STATUSCODE_BADAGGREGATEINVALIDINPUTS;
+        return;
+    }
+    UA_Double v = s->min;
+    if(aggregate == UA_NS0ID_AGGREGATEFUNCTION_AVERAGE)
+        v = s->sum / (UA_Double)s->numericCount;
+    else if(aggregate == UA_NS0ID_AGGREGATEFUNCTION_MAXIMUM)
+        v = s->max;
+    out->status = AGGREGATE_CALCULATED;
+    out->hasValue =
+        (UA_Variant_setScalarCopy(&out->value, &v, &UA_TYPES[UA_TYPES_DOUBLE])
+         == UA_STATUSCODE_GOOD);
+}
+
+static UA_StatusCode
+getProcessedData(UA_Server *server, const UA_NodeId *sessionId, void *sessionContext,
+                 const UA_HistorizingNodeIdSettings *setting, const UA_NodeId *nodeId,
+                 const UA_ReadProcessedDetails *details, UA_UInt32 aggregate,
+                 UA_TimestampsToReturn timestampsToReturn,
+                 const UA_ByteString *continuationPoint,
+                 UA_ByteString *outContinuationPoint, UA_HistoryData *result) {
+    const UA_HistoryDataBackend *backend = &setting->historizingBackend;
+    if(aggregate == UA_NS0ID_AGGREGATEFUNCTION_INTERPOLATIVE &&
+       (!backend->getEnd || !backend->getDateTimeMatch || !backend->getDataValue))
+        return UA_STATUSCODE_BADAGGREGATENOTSUPPORTED;
+
+    /* Compute the intervals */
+    AggregateIntervals iv;
+    memset(&iv, 0, sizeof(AggregateIntervals));
+    iv.origin = details->startTime;
+    iv.limit = details->endTime;
+    iv.reverse = details->endTime < details->startTime;
+    UA_DateTime span = (iv.reverse) ? iv.origin - iv.limit : iv.limit - iv.origin;
+    if(span <= 0)
+        return UA_STATUSCODE_BADINVALIDTIMESTAMPARGUMENT;
+    iv.interval = (UA_DateTime)(details->processingInterval * UA_DATETIME_MSEC);
+    if(iv.interval <= 0 || iv.interval > span)
+        iv.interval = span; /* A single interval */
+    iv.total = (size_t)((span - 1) / iv.interval) + 1;
+
+    if(continuationPoint->length > 0) {
+        if(continuationPoint->length != sizeof(size_t))
+            return UA_STATUSCODE_BADCONTINUATIONPOINTINVALID;
+        memcpy(&iv.first, continuationPoint->data, sizeof(size_t));
+        if(iv.first >= iv.total)
+            return UA_STATUSCODE_BADCONTINUATIONPOINTINVALID;
+    }
+    iv.count = iv.total - iv.first;
+    if(setting->maxHistoryDataResponseSize > 0 &&
+       iv.count > setting->maxHistoryDataResponseSize)
+        iv.count = setting->maxHistoryDataResponseSize;
+
+    UA_DataValue *values = (UA_DataValue*)
+        UA_Array_new(iv.count, &UA_TYPES[UA_TYPES_DATAVALUE]);
+    if(!values)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    /* Compute the aggregate for every interval */
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    if(aggregate == UA_NS0ID_AGGREGATEFUNCTION_INTERPOLATIVE) {
+        for(size_t k = 0; k < iv.count; k++) {
+            UA_DateTime start, end;
+            intervalBounds(&iv, k, &start, &end);
+            interpolate(server, sessionId, sessionContext, backend, nodeId,
+                        (iv.reverse) ? end : start, &values[k]);
+        }
+    } else {
+        UA_HistoryAggregateSummary *summaries = (UA_HistoryAggregateSummary*)
+            UA_calloc(iv.count, sizeof(UA_HistoryAggregateSummary));
+        if(!summaries) {
+            UA_Array_delete(values, iv.count, &UA_TYPES[UA_TYPES_DATAVALUE]);
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        }
+        res = UA_STATUSCODE_BADNOTSUPPORTED;
+        if(backend->getAggregateSummary)
+            res = summarizeRollup(server, sessionId, sessionContext, backend,
+                                  nodeId, &iv, summaries);
+        if(res != UA_STATUSCODE_GOOD) {
+            memset(summaries, 0, iv.count * sizeof(UA_HistoryAggregateSummary));
+            res = summarizeRaw(server, sessionId, sessionContext, backend,
+                               nodeId, &iv, summaries);
+        }
+        for(size_t k = 0; k < iv.count && res == UA_STATUSCODE_GOOD; k++)
+            summaryToDataValue(aggregate, &summaries[k], &values[k]);
+        UA_free(summaries);
+    }
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_Array_delete(values, iv.count, &UA_TYPES[UA_TYPES_DATAVALUE]);
+        return res;
+    }
+
+    /* The interval start is the timestamp */
+    for(size_t k = 0; k < iv.count; k++) {
+        UA_DateTime start, end;
+        intervalBounds(&iv, k, &start, &end);
+        UA_DateTime t = (iv.reverse) ? end : start;
+        if(timestampsToReturn == UA_TIMESTAMPSTORETURN_SOURCE ||
+           timestampsToReturn == UA_TIMESTAMPSTORETURN_BOTH) {
+            values[k].hasSourceTimestamp = true;
+            values[k].sourceTimestamp = t;
+        }
+        if(timestampsToReturn == UA_TIMESTAMPSTORETURN_SERVER ||
+           timestampsToReturn == UA_TIMESTAMPSTORETURN_BOTH) {
+            values[k].hasServerTimestamp = true;
+            values[k].serverTimestamp = t;
+        }
+    }
+
+    /* There are more intervals */
+    size_t next = iv.first + iv.count;
+    if(next < iv.total) {
+        res = UA_ByteString_allocBuffer(outContinuationPoint, sizeof(size_t));
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_Array_delete(values, iv.count, &UA_TYPES[UA_TYPES_DATAVALUE]);
+            return res;
+        }
+        memcpy(outContinuationPoint->data, &next, sizeof(size_t));
+    }
+    result->dataValues = values;
+    result->dataValuesSize = iv.count;
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+readProcessed_service_default(UA_Server *server,
+                              void *context,
+                              const UA_NodeId *sessionId,
+                              void *sessionContext,
+                              const UA_RequestHeader *requestHeader,
+                              const UA_ReadProcessedDetails *historyReadDetails,
+                              UA_TimestampsToReturn timestampsToReturn,
+                              UA_Boolean releaseContinuationPoints,
+                              size_t nodesToReadSize,
+                              const UA_HistoryReadValueId *nodesToRead,
+                              UA_HistoryReadResponse *response,
+                              UA_HistoryData * const * const historyData)
+{
+    /* One aggregate for every node */
+    if (historyReadDetails->aggregateTypeSize != nodesToReadSize) {
+        response->responseHeader.serviceResult = UA_STATUSCODE_BADAGGREGATELISTMISMATCH;
+        return;
+    }
+
+    UA_HistoryDatabaseContext_default *ctx = (UA_HistoryDatabaseContext_default*)context;
+    for (size_t i = 0; i < nodesToReadSize; ++i) {
+        /* The continuation points hold no resources */
+        if (releaseContinuationPoints)
+            continue;
+
+        UA_Byte accessLevel = 0;
+        UA_Server_readAccessLevel(server,
+                                  nodesToRead[i].nodeId,
+                                  &accessLevel);
+        if (!(accessLevel & UA_ACCESSLEVELMASK_HISTORYREAD)) {
+            response->results[i].statusCode = UA_STATUSCODE_BADUSERACCESSDENIED;
+            continue;
+        }
+
+        UA_Boolean historizing = false;
+        UA_Server_readHistorizing(server,
+                                  nodesToRead[i].nodeId,
+                                  &historizing);
+        if (!historizing) {
+            response->results[i].statusCode = UA_STATUSCODE_BADHISTORYOPERATIONINVALID;
+            continue;
+        }
+
+        const UA_HistorizingNodeIdSettings *setting = ctx->gathering.getHistorizingSetting(
+                    server,
+                    ctx->gathering.context,
+                    &nodesToRead[i].nodeId);
+
+        if (!setting) {
+            response->results[i].statusCode = UA_STATUSCODE_BADHISTORYOPERATIONINVALID;
+            continue;
+        }
+
+        const UA_NodeId *aggregateType = &historyReadDetails->aggregateType[i];
+        if (aggregateType->namespaceIndex != 0 ||
+            aggregateType->identifierType != UA_NODEIDTYPE_NUMERIC) {
+            response->results[i].statusCode = UA_STATUSCODE_BADAGGREGATENOTSUPPORTED;
+            continue;
+        }
+        UA_UInt32 aggregate = aggregateType->identifier.numeric;
+        if (aggregate != UA_NS0ID_AGGREGATEFUNCTION_INTERPOLATIVE &&
+            aggregate != UA_NS0ID_AGGREGATEFUNCTION_AVERAGE &&
+            aggregate != UA_NS0ID_AGGREGATEFUNCTION_MINIMUM &&
+            aggregate != UA_NS0ID_AGGREGATEFUNCTION_MAXIMUM &&
+            aggregate != UA_NS0ID_AGGREGATEFUNCTION_COUNT) {
+            response->results[i].statusCode = UA_STATUSCODE_BADAGGREGATENOTSUPPORTED;
+            continue;
+        }
+
+        response->results[i].statusCode = getProcessedData(
+                    server,
+                    sessionId,
+                    sessionContext,
+                    setting,
+                    &nodesToRead[i].nodeId,
+                    historyReadDetails,
+                    aggregate,
+                    timestampsToReturn,
+                    &nodesToRead[i].continuationPoint,
+                    &response->results[i].continuationPoint,
+                    historyData[i]);
+    }
+    response->responseHeader.serviceResult = UA_STATUSCODE_GOOD;
+}
+
 static void
 setValue_service_default(UA_Server *server,
                          void *context,
@@ -598,13 +1234,90 @@ setValue_service_default(UA_Server *server,
                                 value);
 }
 
+/**********/
+/* Events */
+/**********/
+
+static void
+setEvent_service_default(UA_Server *server,
+                         void *context,
+                         const UA_NodeId *originId,
+                         const UA_NodeId *emitterId,
+                         const UA_EventFilter *historicalEventFilter,
+                         UA_EventFieldList *fieldList)
+{
+    UA_HistoryDatabaseContext_default *ctx = (UA_HistoryDatabaseContext_default*)context;
+    UA_StatusCode res = ctx->eventBackend.storeEvent(server,
+                                                     ctx->eventBackend.context,
+                                                     originId,
+                                                     emitterId,
+                                                     historicalEventFilter,
+                                                     fieldList);
+    if (res != UA_STATUSCODE_GOOD)
+        UA_LOG_WARNING(UA_Server_getConfig(server)->logging, UA_LOGCATEGORY_SERVER,
+                       "Could not store the historical event. StatusCode %s",
+                       UA_StatusCode_name(res));
+}
+
+static void
+readEvent_service_default(UA_Server *server,
+                          void *context,
+                          const UA_NodeId *sessionId,
+                          void *sessionContext,
+                          const UA_RequestHeader *requestHeader,
+                          const UA_ReadEventDetails *historyReadDetails,
+                          UA_TimestampsToReturn timestampsToReturn,
+                          UA_Boolean releaseContinuationPoints,
+                          size_t nodesToReadSize,
+                          const UA_HistoryReadValueId *nodesToRead,
+                          UA_HistoryReadResponse *response,
+                          UA_HistoryEvent * const * const historyData)
+{
+    UA_HistoryDatabaseContext_default *ctx = (UA_HistoryDatabaseContext_default*)context;
+    for (size_t i = 0; i < nodesToReadSize; ++i) {
+        /* The continuation points hold no resources */
+        if (releaseContinuationPoints)
+            continue;
+
+        UA_Byte eventNotifier = 0;
+        UA_Server_readEventNotifier(server,
+                                    nodesToRead[i].nodeId,
+                                    &eventNotifier);
+        if (!(eventNotifier & UA_EVENTNOTIFIER_HISTORY_READ)) {
+            response->results[i].statusCode = UA_STATUSCODE_BADUSERACCESSDENIED;
+            continue;
+        }
+
+        response->results[i].statusCode = ctx->eventBackend.readEvents(
+                    server,
+                    ctx->eventBackend.context,
+                    sessionId,
+                    sessionContext,
+                    &nodesToRead[i].nodeId,
+                    historyReadDetails,
+                    timestampsToReturn,
+                    &nodesToRead[i].continuationPoint,
+                    &response->results[i].continuationPoint,
+                    historyData[i]);
+    }
+    response->responseHeader.serviceResult = UA_STATUSCODE_GOOD;
+}
+
 static void
 clear_service_default(UA_HistoryDatabase *hdb)
 {
     if (hdb == NULL || hdb->context == NULL)
         return;
     UA_HistoryDatabaseContext_default *ctx = (UA_HistoryDatabaseContext_default*)hdb->context;
+    while(ctx->cursors) {
+        HistoryCursor *c = ctx->cursors;
+        ctx->cursors = c->next;
+        closeHistoryCursor(NULL, c);
+        UA_free(c);
+    }
     ctx->gathering.deleteMembers(&ctx->gathering);
+    if (ctx->eventBackend.deleteMembers)
+        ctx->eventBackend.deleteMembers(&ctx->eventBackend);
     UA_free(ctx);
 }
 
@@ -619,9 +1332,27 @@ UA_HistoryDatabase_default(UA_HistoryDataGathering gathering)
     context->gathering = gathering;
     hdb.context = context;
     hdb.readRaw = &readRaw_service_default;
+    hdb.readProcessed = &readProcessed_service_default;
     hdb.setValue = &setValue_service_default;
     hdb.updateData = &updateData_service_default;
     hdb.deleteRawModified = &deleteRawModified_service_default;
     hdb.clear = clear_service_default;
     return hdb;
 }
+
+UA_HistoryDatabase
+UA_HistoryDatabase_defaultWithEvents(UA_HistoryDataGathering gathering,
+                                     UA_HistoryEventBackend eventBackend)
+{
+    UA_HistoryDatabase hdb = UA_HistoryDatabase_default(gathering);
+    if (hdb.context == NULL)
+        return hdb;
+    UA_HistoryDatabaseContext_default *context =
+            (UA_HistoryDatabaseContext_default*)hdb.context;
+    context->eventBackend = eventBackend;
+    if (eventBackend.storeEvent)
+        hdb.setEvent = &setEvent_service_default;
+    if (eventBackend.readEvents)
+        hdb.readEvent = &readEvent_service_default;
+    return hdb;
+}
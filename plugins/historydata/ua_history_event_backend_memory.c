@@ -0,0 +1,1253 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <open62541/plugin/historydata/history_event_backend_memory.h>
+
+#include "ziptree.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if UA_MULTITHREADING >= 100 && defined(UA_ARCHITECTURE_POSIX)
+#define UA_EVENTSTORE_THREAD
+#include <pthread.h>
+#endif
+
+#define NO_ENTRY UA_UINT32_MAX    /* No value in a dictionary-encoded column */
+#define NO_SEVERITY UA_UINT32_MAX /* No Severity stored */
+#define NO_COLUMN ((size_t)-1)    /* The operand is not stored */
+
+/**********/
+/* Fields */
+/**********/
+
+/* Fields that are additionally kept in typed columns for the indexes */
+typedef enum {
+    FIELD_OTHER = 0,
+    FIELD_TIME,
+    FIELD_EVENTTYPE,
+    FIELD_SOURCENODE,
+    FIELD_SEVERITY
+} StandardField;
+
+static const UA_String standardFieldNames[4] = {
+    UA_STRING_STATIC("Time"), UA_STRING_STATIC("EventType"),
+    UA_STRING_STATIC("SourceNode"), UA_STRING_STATIC("Severity")};
+
+static StandardField
+standardField(const UA_SimpleAttributeOperand *sao) {
+    if(sao->attributeId != UA_ATTRIBUTEID_VALUE || sao->browsePathSize != 1 ||
+       sao->indexRange.length > 0 || sao->browsePath[0].namespaceIndex != 0)
+        return FIELD_OTHER;
+    for(size_t i = 0; i < 4; i++) {
+        if(UA_String_equal(&sao->browsePath[0].name, &standardFieldNames[i]))
+            return (StandardField)(i + 1);
+    }
+    return FIELD_OTHER;
+}
+
+/* The type definition is ignored. The fields of the BaseEventType are found
+ * with the same browse path for all event types. */
+static UA_Boolean
+sameOperand(const UA_SimpleAttributeOperand *a, const UA_SimpleAttributeOperand *b) {
+    if(a->attributeId != b->attributeId || a->browsePathSize != b->browsePathSize ||
+       !UA_String_equal(&a->indexRange, &b->indexRange))
+        return false;
+    for(size_t i = 0; i < a->browsePathSize; i++) {
+        if(a->browsePath[i].namespaceIndex != b->browsePath[i].namespaceIndex ||
+           !UA_String_equal(&a->browsePath[i].name, &b->browsePath[i].name))
+            return false;
+    }
+    return true;
+}
+
+static UA_Boolean
+numericScalar(const UA_Variant *v, UA_Double *out) {
+    if(!UA_Variant_isScalar(v))
+        return false;
+    const void *p = v->data;
+    switch(v->type->typeKind) {
+    case UA_DATATYPEKIND_BOOLEAN: *out = *(const UA_Boolean*)p ? 1.0 : 0.0; return true;
+    case UA_DATATYPEKIND_SBYTE: *out = *(const UA_SByte*)p; return true;
+    case UA_DATATYPEKIND_BYTE: *out = *(const UA_Byte*)p; return true;
+    case UA_DATATYPEKIND_INT16: *out = *(const UA_Int16*)p; return true;
+    case UA_DATATYPEKIND_UINT16: *out = *(const UA_UInt16*)p; return true;
+    case UA_DATATYPEKIND_ENUM:
+    case UA_DATATYPEKIND_INT32: *out = *(const UA_Int32*)p; return true;
+    case UA_DATATYPEKIND_UINT32: *out = *(const UA_UInt32*)p; return true;
+    case UA_DATATYPEKIND_INT64: *out = (UA_Double)*(const UA_Int64*)p; return true;
+    case UA_DATATYPEKIND_UINT64: *out = (UA_Double)*(const UA_UInt64*)p; return true;
+    case UA_DATATYPEKIND_FLOAT: *out = *(const UA_Float*)p; return true;
+    case UA_DATATYPEKIND_DOUBLE: *out = *(const UA_Double*)p; return true;
+    default: return false;
+    }
+}
+
+/****************/
+/* Dictionaries */
+/****************/
+
+/* A distinct value of a dictionary-encoded column with the (ascending) rows
+ * where it occurs */
+typedef struct {
+    UA_NodeId id;
+    size_t *rows;
+    size_t rowsSize;
+    size_t rowsCapacity;
+} EventPosting;
+
+typedef struct {
+    EventPosting *entries;
+    size_t entriesSize;
+} EventDictionary;
+
+/* The number of distinct event types and sources is small. A linear search
+ * is sufficient. */
+static UA_UInt32
+dictFind(const EventDictionary *dict, const UA_NodeId *id) {
+    for(size_t i = 0; i < dict->entriesSize; i++) {
+        if(UA_NodeId_equal(&dict->entries[i].id, id))
+            return (UA_UInt32)i;
+    }
+    return NO_ENTRY;
+}
+
+/* Find or add the entry and ensure space for one more row */
+static UA_StatusCode
+dictReserve(EventDictionary *dict, const UA_NodeId *id, UA_UInt32 *index) {
+    UA_UInt32 i = dictFind(dict, id);
+    if(i == NO_ENTRY) {
+        if(dict->entriesSize >= NO_ENTRY)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        EventPosting *entries = (EventPosting*)
+            UA_realloc(dict->entries, (dict->entriesSize + 1) * sizeof(EventPosting));
+        if(!entries)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        dict->entries = entries;
+        EventPosting *p = &entries[dict->entriesSize];
+        memset(p, 0, sizeof(EventPosting));
+        UA_StatusCode res = UA_NodeId_copy(id, &p->id);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+        i = (UA_UInt32)dict->entriesSize++;
+    }
+    EventPosting *p = &dict->entries[i];
+    if(p->rowsSize == p->rowsCapacity) {
+        size_t cap = (p->rowsCapacity == 0) ? 16 : p->rowsCapacity * 2;
+        size_t *rows = (size_t*)UA_realloc(p->rows, cap * sizeof(size_t));
+        if(!rows)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        p->rows = rows;
+        p->rowsCapacity = cap;
+    }
+    *index = i;
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+dictClear(EventDictionary *dict) {
+    for(size_t i = 0; i < dict->entriesSize; i++) {
+        UA_NodeId_clear(&dict->entries[i].id);
+        UA_free(dict->entries[i].rows);
+    }
+    UA_free(dict->entries);
+    dict->entries = NULL;
+    dict->entriesSize = 0;
+}
+
+/**********/
+/* Stores */
+/**********/
+
+/* A stored select clause with its values for all rows */
+typedef struct {
+    UA_SimpleAttributeOperand operand;
+    StandardField field;
+    UA_Variant *values; /* rowsCapacity entries, empty if not set */
+} EventColumn;
+
+/* The events of one emitter. The rows are in the order of arrival. */
+typedef struct EventStore {
+    ZIP_ENTRY(EventStore) zipfields;
+    UA_UInt32 emitterHash;
+    UA_NodeId emitter;
+
+    size_t rowsSize;
+    size_t rowsCapacity;
+
+    EventColumn *columns;
+    size_t columnsSize;
+
+    /* Typed columns */
+    UA_DateTime *time;
+    UA_UInt32 *severity; /* Or NO_SEVERITY */
+    UA_UInt32 *type;     /* Entry in types or NO_ENTRY */
+    UA_UInt32 *source;   /* Entry in sources or NO_ENTRY */
+    EventDictionary types;
+    EventDictionary sources;
+
+    /* The rows ordered by (time, row) */
+    size_t *order;
+} EventStore;
+
+static enum ZIP_CMP
+cmpEventStore(const void *a, const void *b) {
+    const EventStore *aa = (const EventStore*)a;
+    const EventStore *bb = (const EventStore*)b;
+    if(aa->emitterHash != bb->emitterHash)
+        return (aa->emitterHash < bb->emitterHash) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+    return (enum ZIP_CMP)UA_NodeId_order(&aa->emitter, &bb->emitter);
+}
+
+typedef ZIP_HEAD(EventStoreTree, EventStore) EventStoreTree;
+ZIP_FUNCTIONS(EventStoreTree, EventStore, zipfields,
+              EventStore, zipfields, cmpEventStore)
+
+typedef struct {
+    EventStoreTree stores;
+#ifdef UA_EVENTSTORE_THREAD
+    pthread_mutex_t lock;
+#endif
+} UA_EventStoreContext;
+
+#ifdef UA_EVENTSTORE_THREAD
+# define EVENTSTORE_LOCK(ctx) pthread_mutex_lock(&(ctx)->lock)
+# define EVENTSTORE_UNLOCK(ctx) pthread_mutex_unlock(&(ctx)->lock)
+#else
+# define EVENTSTORE_LOCK(ctx)
+# define EVENTSTORE_UNLOCK(ctx)
+#endif
+
+static void *
+deleteEventStore(void *context, EventStore *s) {
+    for(size_t i = 0; i < s->columnsSize; i++) {
+        UA_SimpleAttributeOperand_clear(&s->columns[i].operand);
+        for(size_t j = 0; j < s->rowsSize; j++)
+            UA_Variant_clear(&s->columns[i].values[j]);
+        UA_free(s->columns[i].values);
+    }
+    UA_free(s->columns);
+    UA_free(s->time);
+    UA_free(s->severity);
+    UA_free(s->type);
+    UA_free(s->source);
+    UA_free(s->order);
+    dictClear(&s->types);
+    dictClear(&s->sources);
+    UA_NodeId_clear(&s->emitter);
+    UA_free(s);
+    return NULL;
+}
+
+static EventStore *
+findStore(UA_EventStoreContext *ctx, const UA_NodeId *emitterId) {
+    EventStore dummy;
+    dummy.emitterHash = UA_NodeId_hash(emitterId);
+    dummy.emitter = *emitterId;
+    return ZIP_FIND(EventStoreTree, &ctx->stores, &dummy);
+}
+
+static EventStore *
+getOrCreateStore(UA_EventStoreContext *ctx, const UA_NodeId *emitterId) {
+    EventStore *s = findStore(ctx, emitterId);
+    if(s)
+        return s;
+    s = (EventStore*)UA_calloc(1, sizeof(EventStore));
+    if(!s)
+        return NULL;
+    if(UA_NodeId_copy(emitterId, &s->emitter) != UA_STATUSCODE_GOOD) {
+        UA_free(s);
+        return NULL;
+    }
+    s->emitterHash = UA_NodeId_hash(emitterId);
+    ZIP_INSERT(EventStoreTree, &ctx->stores, s);
+    return s;
+}
+
+#define GROW_ARRAY(ARR, TYPE, CAP) do {                                  \
+        TYPE *tmp = (TYPE*)UA_realloc(ARR, (CAP) * sizeof(TYPE));        \
+        if(!tmp)                                                         \
+            return UA_STATUSCODE_BADOUTOFMEMORY;                         \
+        ARR = tmp;                                                       \
+    } while(0)
+
+/* The capacity is only increased once all arrays are grown. Arrays that were
+ * grown before a failure keep their size. */
+static UA_StatusCode
+growRows(EventStore *s) {
+    size_t cap = (s->rowsCapacity == 0) ? 64 : s->rowsCapacity * 2;
+    GROW_ARRAY(s->time, UA_DateTime, cap);
+    GROW_ARRAY(s->severity, UA_UInt32, cap);
+    GROW_ARRAY(s->type, UA_UInt32, cap);
+    GROW_ARRAY(s->source, UA_UInt32, cap);
+    GROW_ARRAY(s->order, size_t, cap);
+    for(size_t i = 0; i < s->columnsSize; i++) {
+        EventColumn *c = &s->columns[i];
+        GROW_ARRAY(c->values, UA_Variant, cap);
+        memset(&c->values[s->rowsCapacity], 0,
+               (cap - s->rowsCapacity) * sizeof(UA_Variant));
+    }
+    s->rowsCapacity = cap;
+    return UA_STATUSCODE_GOOD;
+}
+
+static size_t
+findColumn(const EventStore *s, const UA_SimpleAttributeOperand *sao) {
+    for(size_t i = 0; i < s->columnsSize; i++) {
+        if(sameOperand(&s->columns[i].operand, sao))
+            return i;
+    }
+    return NO_COLUMN;
+}
+
+/* The new column is empty for the existing rows */
+static UA_StatusCode
+addColumn(EventStore *s, const UA_SimpleAttributeOperand *sao, size_t *index) {
+    UA_Variant *values = (UA_Variant*)UA_calloc(s->rowsCapacity, sizeof(UA_Variant));
+    if(!values)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    EventColumn *columns = (EventColumn*)
+        UA_realloc(s->columns, (s->columnsSize + 1) * sizeof(EventColumn));
+    if(!columns) {
+        UA_free(values);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    s->columns = columns;
+    EventColumn *c = &columns[s->columnsSize];
+    UA_StatusCode res = UA_SimpleAttributeOperand_copy(sao, &c->operand);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_free(values);
+        return res;
+    }
+    c->field = standardField(sao);
+    c->values = values;
+    *index = s->columnsSize++;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Compare (time, row) keys */
+static UA_Boolean
+keyLess(UA_DateTime t1, size_t r1, UA_DateTime t2, size_t r2) {
+    return (t1 < t2) || (t1 == t2 && r1 < r2);
+}
+
+/* First position in the order with a key >= (t, row) */
+static size_t
+lowerBound(const EventStore *s, UA_DateTime t, size_t row) {
+    size_t lo = 0, hi = s->rowsSize;
+    while(lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        size_t r = s->order[mid];
+        if(keyLess(s->time[r], r, t, row))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static void
+clearRow(EventStore *s, size_t row) {
+    for(size_t i = 0; i < s->columnsSize; i++)
+        UA_Variant_clear(&s->columns[i].values[row]);
+}
+
+static UA_StatusCode
+appendEvent(EventStore *s, const UA_EventFilter *filter,
+            const UA_EventFieldList *fieldList) {
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    if(s->rowsSize == s->rowsCapacity) {
+        res = growRows(s);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+
+    /* Copy the fields into the columns */
+    size_t row = s->rowsSize;
+    UA_DateTime time = UA_DateTime_now();
+    UA_UInt32 severity = NO_SEVERITY;
+    const UA_NodeId *type = NULL;
+    const UA_NodeId *source = NULL;
+    for(size_t i = 0; i < filter->selectClausesSize; i++) {
+        size_t col = findColumn(s, &filter->selectClauses[i]);
+        if(col == NO_COLUMN) {
+            res = addColumn(s, &filter->selectClauses[i], &col);
+            if(res != UA_STATUSCODE_GOOD)
+                goto error;
+        }
+        UA_Variant *dst = &s->columns[col].values[row];
+        const UA_Variant *v = &fieldList->eventFields[i];
+        if(!UA_Variant_isEmpty(dst) || UA_Variant_isEmpty(v))
+            continue; /* Duplicate select clause or no value */
+        res = UA_Variant_copy(v, dst);
+        if(res != UA_STATUSCODE_GOOD)
+            goto error;
+        switch(s->columns[col].field) {
+        case FIELD_TIME: /* DateTime or the UtcTime subtype */
+            if(UA_Variant_isScalar(v) && v->type->typeKind == UA_DATATYPEKIND_DATETIME)
+                time = *(UA_DateTime*)v->data;
+            break;
+        case FIELD_EVENTTYPE:
+            if(UA_Variant_hasScalarType(v, &UA_TYPES[UA_TYPES_NODEID]))
+                type = (const UA_NodeId*)v->data;
+            break;
+        case FIELD_SOURCENODE:
+            if(UA_Variant_hasScalarType(v, &UA_TYPES[UA_TYPES_NODEID]))
+                source = (const UA_NodeId*)v->data;
+            break;
+        case FIELD_SEVERITY:
+            if(UA_Variant_hasScalarType(v, &UA_TYPES[UA_TYPES_UINT16]))
+                severity = *(UA_UInt16*)v->data;
+            break;
+        default:
+            break;
+        }
+    }
+
+    /* Reserve the dictionary entries. Then the row is added without further
+     * allocations. */
+    UA_UInt32 typeIndex = NO_ENTRY;
+    UA_UInt32 sourceIndex = NO_ENTRY;
+    if(type) {
+        res = dictReserve(&s->types, type, &typeIndex);
+        if(res != UA_STATUSCODE_GOOD)
+            goto error;
+    }
+    if(source) {
+        res = dictReserve(&s->sources, source, &sourceIndex);
+        if(res != UA_STATUSCODE_GOOD)
+            goto error;
+    }
+    if(typeIndex != NO_ENTRY) {
+        EventPosting *p = &s->types.entries[typeIndex];
+        p->rows[p->rowsSize++] = row;
+    }
+    if(sourceIndex != NO_ENTRY) {
+        EventPosting *p = &s->sources.entries[sourceIndex];
+        p->rows[p->rowsSize++] = row;
+    }
+    s->time[row] = time;
+    s->severity[row] = severity;
+    s->type[row] = typeIndex;
+    s->source[row] = sourceIndex;
+
+    /* Events in time order are appended. Late events are sorted in. */
+    size_t pos = s->rowsSize;
+    if(pos > 0 && time < s->time[s->order[pos - 1]]) {
+        pos = lowerBound(s, time, row);
+        memmove(&s->order[pos + 1], &s->order[pos],
+                (s->rowsSize - pos) * sizeof(size_t));
+    }
+    s->order[pos] = row;
+    s->rowsSize++;
+    return UA_STATUSCODE_GOOD;
+
+ error:
+    clearRow(s, row);
+    return res;
+}
+
+static UA_StatusCode
+storeEvent_backend_memory(UA_Server *server, void *context,
+                          const UA_NodeId *originId, const UA_NodeId *emitterId,
+                          const UA_EventFilter *historicalEventFilter,
+                          const UA_EventFieldList *fieldList) {
+    if(fieldList->eventFieldsSize != historicalEventFilter->selectClausesSize)
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+    UA_EventStoreContext *ctx = (UA_EventStoreContext*)context;
+    EVENTSTORE_LOCK(ctx);
+    UA_StatusCode res = UA_STATUSCODE_BADOUTOFMEMORY;
+    EventStore *s = getOrCreateStore(ctx, emitterId);
+    if(s)
+        res = appendEvent(s, historicalEventFilter, fieldList);
+    EVENTSTORE_UNLOCK(ctx);
+    return res;
+}
+
+/***********/
+/* Queries */
+/***********/
+
+typedef struct {
+    UA_NodeId *types;     /* OfType: the type and its subtypes.
+                           * Equals on EventType: the literal. */
+    size_t typesSize;
+    UA_Boolean pushed;    /* The EventType restriction is answered by the index */
+    UA_Boolean *typeOk;   /* For the entries of the type dictionary */
+    size_t *columns;      /* Stored column of the operands or NO_COLUMN */
+} QueryElement;
+
+typedef struct {
+    const UA_ContentFilter *where;
+    QueryElement *elements;
+
+    /* Predicates pushed down into the indexes */
+    const UA_NodeId *source;
+    UA_Boolean hasSeverity;
+    UA_Int64 severityMin;
+    UA_Int64 severityMax;
+    UA_Boolean empty; /* Contradicting predicates, nothing matches */
+    UA_Boolean exact; /* The indexes answer the complete where clause */
+} EventQuery;
+
+static const UA_Variant *
+literalOperand(const UA_ExtensionObject *op) {
+    if(op->encoding < UA_EXTENSIONOBJECT_DECODED ||
+       op->content.decoded.type != &UA_TYPES[UA_TYPES_LITERALOPERAND])
+        return NULL;
+    return &((const UA_LiteralOperand*)op->content.decoded.data)->value;
+}
+
+static const UA_SimpleAttributeOperand *
+attributeOperand(const UA_ExtensionObject *op) {
+    if(op->encoding < UA_EXTENSIONOBJECT_DECODED ||
+       op->content.decoded.type != &UA_TYPES[UA_TYPES_SIMPLEATTRIBUTEOPERAND])
+        return NULL;
+    return (const UA_SimpleAttributeOperand*)op->content.decoded.data;
+}
+
+static UA_Boolean
+elementOperand(const UA_ExtensionObject *op, UA_UInt32 *index) {
+    if(op->encoding < UA_EXTENSIONOBJECT_DECODED ||
+       op->content.decoded.type != &UA_TYPES[UA_TYPES_ELEMENTOPERAND])
+        return false;
+    *index = ((const UA_ElementOperand*)op->content.decoded.data)->index;
+    return true;
+}
+
+/* Resolve the type and all its subtypes. Called without the lock, as the
+ * server API is used. */
+static UA_StatusCode
+resolveSubtypes(UA_Server *server, const UA_NodeId *type, QueryElement *qe) {
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = *type;
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+    bd.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE);
+    bd.includeSubtypes = true;
+    bd.nodeClassMask = UA_NODECLASS_OBJECTTYPE;
+    size_t subtypesSize = 0;
+    UA_ExpandedNodeId *subtypes = NULL;
+    UA_StatusCode res = UA_Server_browseRecursive(server, &bd, &subtypesSize, &subtypes);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    qe->types = (UA_NodeId*)UA_Array_new(subtypesSize + 1, &UA_TYPES[UA_TYPES_NODEID]);
+    if(!qe->types) {
+        UA_Array_delete(subtypes, subtypesSize, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    qe->typesSize = subtypesSize + 1;
+    /* Move the NodeIds out of the ExpandedNodeIds */
+    for(size_t i = 0; i < subtypesSize; i++) {
+        qe->types[i + 1] = subtypes[i].nodeId;
+        UA_NodeId_init(&subtypes[i].nodeId);
+    }
+    UA_Array_delete(subtypes, subtypesSize, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
+    return UA_NodeId_copy(type, &qe->types[0]);
+}
+
+static size_t
+operandCount(UA_FilterOperator op) {
+    switch(op) {
+    case UA_FILTEROPERATOR_ISNULL:
+    case UA_FILTEROPERATOR_NOT:
+    case UA_FILTEROPERATOR_OFTYPE:
+        return 1;
+    case UA_FILTEROPERATOR_BETWEEN:
+        return 3;
+    case UA_FILTEROPERATOR_INLIST:
+        return 0; /* At least two */
+    case UA_FILTEROPERATOR_EQUALS:
+    case UA_FILTEROPERATOR_GREATERTHAN:
+    case UA_FILTEROPERATOR_LESSTHAN:
+    case UA_FILTEROPERATOR_GREATERTHANOREQUAL:
+    case UA_FILTEROPERATOR_LESSTHANOREQUAL:
+    case UA_FILTEROPERATOR_AND:
+    case UA_FILTEROPERATOR_OR:
+        return 2;
+    default:
+        return 1; /* Not supported */
+    }
+}
+
+static UA_StatusCode
+validateElement(UA_Server *server, EventQuery *q, size_t i) {
+    const UA_ContentFilterElement *e = &q->where->elements[i];
+    size_t count = operandCount(e->filterOperator);
+    if(count == 1 && e->filterOperator != UA_FILTEROPERATOR_ISNULL &&
+       e->filterOperator != UA_FILTEROPERATOR_NOT &&
+       e->filterOperator != UA_FILTEROPERATOR_OFTYPE)
+        return UA_STATUSCODE_BADFILTEROPERATORUNSUPPORTED;
+    if((count > 0 && e->filterOperandsSize != count) ||
+       (count == 0 && e->filterOperandsSize < 2))
+        return UA_STATUSCODE_BADFILTEROPERANDCOUNTMISMATCH;
+
+    for(size_t j = 0; j < e->filterOperandsSize; j++) {
+        const UA_ExtensionObject *op = &e->filterOperands[j];
+        UA_UInt32 index;
+        if(elementOperand(op, &index)) {
+            /* Only forward references, so there are no cycles */
+            if(index <= i || index >= q->where->elementsSize)
+                return UA_STATUSCODE_BADFILTEROPERANDINVALID;
+        } else if(!literalOperand(op) && !attributeOperand(op)) {
+            return UA_STATUSCODE_BADFILTEROPERANDINVALID;
+        }
+    }
+
+    if(e->filterOperator == UA_FILTEROPERATOR_OFTYPE) {
+        const UA_Variant *lit = literalOperand(&e->filterOperands[0]);
+        if(!lit || !UA_Variant_hasScalarType(lit, &UA_TYPES[UA_TYPES_NODEID]))
+            return UA_STATUSCODE_BADFILTEROPERANDINVALID;
+        return resolveSubtypes(server, (const UA_NodeId*)lit->data, &q->elements[i]);
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Find a standard field compared with a literal. Returns false if the operands
+ * have a different form. swapped is set if the literal comes first. */
+static UA_Boolean
+fieldWithLiteral(const UA_ContentFilterElement *e, StandardField *field,
+                 const UA_Variant **lit, UA_Boolean *swapped) {
+    const UA_SimpleAttributeOperand *sao = attributeOperand(&e->filterOperands[0]);
+    *lit = literalOperand(&e->filterOperands[1]);
+    *swapped = false;
+    if(!sao || !*lit) {
+        sao = attributeOperand(&e->filterOperands[1]);
+        *lit = literalOperand(&e->filterOperands[0]);
+        *swapped = true;
+    }
+    if(!sao || !*lit)
+        return false;
+    *field = standardField(sao);
+    return (*field != FIELD_OTHER);
+}
+
+/* The Severity is an integer. The bounds are rounded to the next integers
+ * within the range. */
+static void
+restrictSeverity(EventQuery *q, UA_FilterOperator op, UA_Double v) {
+    UA_Int64 floorV = (v < 0.0) ? -1 : (v > 65535.0) ? 65535 : (UA_Int64)v;
+    UA_Int64 ceilV = (v < 0.0) ? 0 : (v > 65535.0) ? 65536 :
+        floorV + ((UA_Double)floorV < v);
+    UA_Int64 min = 0, max = 65535;
+    switch(op) {
+    case UA_FILTEROPERATOR_EQUALS:
+        if(floorV != ceilV) {
+            q->empty = true;
+            return;
+        }
+        min = max = floorV;
+        break;
+    case UA_FILTEROPERATOR_GREATERTHAN: min = floorV + 1; break;
+    case UA_FILTEROPERATOR_GREATERTHANOREQUAL: min = ceilV; break;
+    case UA_FILTEROPERATOR_LESSTHAN: max = ceilV - 1; break;
+    case UA_FILTEROPERATOR_LESSTHANOREQUAL: max = floorV; break;
+    default: return;
+    }
+    if(!q->hasSeverity || min > q->severityMin)
+        q->severityMin = min;
+    if(!q->hasSeverity || max < q->severityMax)
+        q->severityMax = max;
+    q->hasSeverity = true;
+}
+
+static UA_FilterOperator
+swapOperator(UA_FilterOperator op) {
+    switch(op) {
+    case UA_FILTEROPERATOR_GREATERTHAN: return UA_FILTEROPERATOR_LESSTHAN;
+    case UA_FILTEROPERATOR_LESSTHAN: return UA_FILTEROPERATOR_GREATERTHAN;
+    case UA_FILTEROPERATOR_GREATERTHANOREQUAL: return UA_FILTEROPERATOR_LESSTHANOREQUAL;
+    case UA_FILTEROPERATOR_LESSTHANOREQUAL: return UA_FILTEROPERATOR_GREATERTHANOREQUAL;
+    default: return op;
+    }
+}
+
+/* Push the predicates of the AND-chain at the root of the where clause down
+ * into the indexes. Returns whether the element is answered completely by
+ * the indexes. */
+static UA_StatusCode
+pushDown(EventQuery *q, size_t i, UA_Boolean *exact) {
+    const UA_ContentFilterElement *e = &q->where->elements[i];
+    QueryElement *qe = &q->elements[i];
+    *exact = false;
+    StandardField field;
+    const UA_Variant *lit;
+    UA_Boolean swapped;
+    UA_Double v;
+    switch(e->filterOperator) {
+    case UA_FILTEROPERATOR_AND: {
+        UA_UInt32 a, b;
+        UA_Boolean exactA = false, exactB = false;
+        UA_StatusCode res = UA_STATUSCODE_GOOD;
+        if(elementOperand(&e->filterOperands[0], &a))
+            res |= pushDown(q, a, &exactA);
+        if(elementOperand(&e->filterOperands[1], &b))
+            res |= pushDown(q, b, &exactB);
+        *exact = exactA && exactB;
+        return res;
+    }
+
+    case UA_FILTEROPERATOR_OFTYPE:
+        qe->pushed = true;
+        *exact = true;
+        return UA_STATUSCODE_GOOD;
+
+    case UA_FILTEROPERATOR_EQUALS:
+        if(!fieldWithLiteral(e, &field, &lit, &swapped))
+            return UA_STATUSCODE_GOOD;
+        if(field == FIELD_EVENTTYPE) {
+            if(!UA_Variant_hasScalarType(lit, &UA_TYPES[UA_TYPES_NODEID]))
+                return UA_STATUSCODE_GOOD;
+            qe->types = UA_NodeId_new();
+            if(!qe->types)
+                return UA_STATUSCODE_BADOUTOFMEMORY;
+            qe->typesSize = 1;
+            qe->pushed = true;
+            *exact = true;
+            return UA_NodeId_copy((const UA_NodeId*)lit->data, qe->types);
+        }
+        if(field == FIELD_SOURCENODE) {
+            if(!UA_Variant_hasScalarType(lit, &UA_TYPES[UA_TYPES_NODEID]))
+                return UA_STATUSCODE_GOOD;
+            const UA_NodeId *source = (const UA_NodeId*)lit->data;
+            if(q->source && !UA_NodeId_equal(q->source, source))
+                q->empty = true;
+            q->source = source;
+            *exact = true;
+            return UA_STATUSCODE_GOOD;
+        }
+        if(field == FIELD_SEVERITY && numericScalar(lit, &v)) {
+            restrictSeverity(q, e->filterOperator, v);
+            *exact = true;
+        }
+        return UA_STATUSCODE_GOOD;
+
+    case UA_FILTEROPERATOR_GREATERTHAN:
+    case UA_FILTEROPERATOR_LESSTHAN:
+    case UA_FILTEROPERATOR_GREATERTHANOREQUAL:
+    case UA_FILTEROPERATOR_LESSTHANOREQUAL:
+        if(!fieldWithLiteral(e, &field, &lit, &swapped) ||
+           field != FIELD_SEVERITY || !numericScalar(lit, &v))
+            return UA_STATUSCODE_GOOD;
+        restrictSeverity(q, swapped ? swapOperator(e->filterOperator) :
+                         e->filterOperator, v);
+        *exact = true;
+        return UA_STATUSCODE_GOOD;
+
+    case UA_FILTEROPERATOR_BETWEEN: {
+        const UA_SimpleAttributeOperand *sao = attributeOperand(&e->filterOperands[0]);
+        const UA_Variant *low = literalOperand(&e->filterOperands[1]);
+        const UA_Variant *high = literalOperand(&e->filterOperands[2]);
+        UA_Double lv, hv;
+        if(!sao || standardField(sao) != FIELD_SEVERITY || !low || !high ||
+           !numericScalar(low, &lv) || !numericScalar(high, &hv))
+            return UA_STATUSCODE_GOOD;
+        restrictSeverity(q, UA_FILTEROPERATOR_GREATERTHANOREQUAL, lv);
+        restrictSeverity(q, UA_FILTEROPERATOR_LESSTHANOREQUAL, hv);
+        *exact = true;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    default:
+        return UA_STATUSCODE_GOOD;
+    }
+}
+
+static void
+clearQuery(EventQuery *q) {
+    if(!q->elements)
+        return;
+    for(size_t i = 0; i < q->where->elementsSize; i++) {
+        QueryElement *qe = &q->elements[i];
+        UA_Array_delete(qe->types, qe->typesSize, &UA_TYPES[UA_TYPES_NODEID]);
+        UA_free(qe->typeOk);
+        UA_free(qe->columns);
+    }
+    UA_free(q->elements);
+    q->elements = NULL;
+}
+
+static UA_StatusCode
+prepareQuery(UA_Server *server, const UA_ContentFilter *where, EventQuery *q) {
+    memset(q, 0, sizeof(EventQuery));
+    q->where = where;
+    q->exact = true;
+    if(where->elementsSize == 0)
+        return UA_STATUSCODE_GOOD;
+    q->elements = (QueryElement*)UA_calloc(where->elementsSize, sizeof(QueryElement));
+    if(!q->elements)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    for(size_t i = 0; i < where->elementsSize; i++) {
+        UA_StatusCode res = validateElement(server, q, i);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+    return pushDown(q, 0, &q->exact);
+}
+
+/* Map the operands and the type restrictions onto the store. Called with the
+ * lock held. */
+static UA_StatusCode
+bindQuery(EventQuery *q, const EventStore *s) {
+    for(size_t i = 0; i < q->where->elementsSize; i++) {
+        const UA_ContentFilterElement *e = &q->where->elements[i];
+        QueryElement *qe = &q->elements[i];
+        qe->columns = (size_t*)UA_malloc((e->filterOperandsSize + 1) * sizeof(size_t));
+        if(!qe->columns)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        for(size_t j = 0; j < e->filterOperandsSize; j++) {
+            const UA_SimpleAttributeOperand *sao = attributeOperand(&e->filterOperands[j]);
+            qe->columns[j] = (sao) ? findColumn(s, sao) : NO_COLUMN;
+        }
+        if(!qe->types)
+            continue;
+        qe->typeOk = (UA_Boolean*)UA_calloc(s->types.entriesSize + 1, sizeof(UA_Boolean));
+        if(!qe->typeOk)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        for(size_t j = 0; j < qe->typesSize; j++) {
+            UA_UInt32 entry = dictFind(&s->types, &qe->types[j]);
+            if(entry != NO_ENTRY)
+                qe->typeOk[entry] = true;
+        }
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+/**************/
+/* Evaluation */
+/**************/
+
+static const UA_Boolean bTrue = true;
+static const UA_Boolean bFalse = false;
+
+typedef struct {
+    const EventQuery *q;
+    const EventStore *s;
+    size_t row;
+} EvalContext;
+
+static UA_Boolean
+evalElement(const EvalContext *ec, size_t i);
+
+/* Returns NULL for a null value */
+static const UA_Variant *
+evalOperand(const EvalContext *ec, size_t i, size_t j, UA_Variant *tmp) {
+    const UA_ExtensionObject *op = &ec->q->where->elements[i].filterOperands[j];
+    UA_UInt32 index;
+    if(elementOperand(op, &index)) {
+        const UA_Boolean *b = evalElement(ec, index) ? &bTrue : &bFalse;
+        UA_Variant_setScalar(tmp, (void*)(uintptr_t)b, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        return tmp;
+    }
+    const UA_Variant *lit = literalOperand(op);
+    if(lit)
+        return UA_Variant_isEmpty(lit) ? NULL : lit;
+    size_t col = ec->q->elements[i].columns[j];
+    if(col == NO_COLUMN)
+        return NULL;
+    const UA_Variant *v = &ec->s->columns[col].values[ec->row];
+    return UA_Variant_isEmpty(v) ? NULL : v;
+}
+
+static UA_Boolean
+evalBoolean(const EvalContext *ec, size_t i, size_t j) {
+    UA_Variant tmp;
+    const UA_Variant *v = evalOperand(ec, i, j, &tmp);
+    return v && UA_Variant_hasScalarType(v, &UA_TYPES[UA_TYPES_BOOLEAN]) &&
+        *(const UA_Boolean*)v->data;
+}
+
+/* Numeric values are compared as numbers. Other values only with the same
+ * type. Returns false if the values cannot be compared. */
+static UA_Boolean
+compareValues(const UA_Variant *a, const UA_Variant *b, UA_Order *order) {
+    if(!a || !b || !UA_Variant_isScalar(a) || !UA_Variant_isScalar(b))
+        return false;
+    UA_Double da, db;
+    if(numericScalar(a, &da) && numericScalar(b, &db)) {
+        *order = (da < db) ? UA_ORDER_LESS : (da > db) ? UA_ORDER_MORE : UA_ORDER_EQ;
+        return true;
+    }
+    if(a->type != b->type)
+        return false;
+    *order = UA_order(a->data, b->data, a->type);
+    return true;
+}
+
+static UA_Boolean
+evalCompare(const EvalContext *ec, size_t i, size_t j1, size_t j2, UA_Order *order) {
+    UA_Variant tmp1, tmp2;
+    const UA_Variant *a = evalOperand(ec, i, j1, &tmp1);
+    const UA_Variant *b = evalOperand(ec, i, j2, &tmp2);
+    return compareValues(a, b, order);
+}
+
+static UA_Boolean
+evalElement(const EvalContext *ec, size_t i) {
+    const UA_ContentFilterElement *e = &ec->q->where->elements[i];
+    UA_Order o, o2;
+    UA_Variant tmp;
+    switch(e->filterOperator) {
+    case UA_FILTEROPERATOR_AND:
+        return evalBoolean(ec, i, 0) && evalBoolean(ec, i, 1);
+    case UA_FILTEROPERATOR_OR:
+        return evalBoolean(ec, i, 0) || evalBoolean(ec, i, 1);
+    case UA_FILTEROPERATOR_NOT:
+        return !evalBoolean(ec, i, 0);
+    case UA_FILTEROPERATOR_ISNULL:
+        return evalOperand(ec, i, 0, &tmp) == NULL;
+    case UA_FILTEROPERATOR_OFTYPE: {
+        UA_UInt32 t = ec->s->type[ec->row];
+        return t != NO_ENTRY && ec->q->elements[i].typeOk[t];
+    }
+    case UA_FILTEROPERATOR_EQUALS:
+        return evalCompare(ec, i, 0, 1, &o) && o == UA_ORDER_EQ;
+    case UA_FILTEROPERATOR_GREATERTHAN:
+        return evalCompare(ec, i, 0, 1, &o) && o == UA_ORDER_MORE;
+    case UA_FILTEROPERATOR_LESSTHAN:
+        return evalCompare(ec, i, 0, 1, &o) && o == UA_ORDER_LESS;
+    case UA_FILTEROPERATOR_GREATERTHANOREQUAL:
+        return evalCompare(ec, i, 0, 1, &o) && o != UA_ORDER_LESS;
+    case UA_FILTEROPERATOR_LESSTHANOREQUAL:
+        return evalCompare(ec, i, 0, 1, &o) && o != UA_ORDER_MORE;
+    case UA_FILTEROPERATOR_BETWEEN:
+        return evalCompare(ec, i, 0, 1, &o) && o != UA_ORDER_LESS &&
+            evalCompare(ec, i, 0, 2, &o2) && o2 != UA_ORDER_MORE;
+    case UA_FILTEROPERATOR_INLIST:
+        for(size_t j = 1; j < e->filterOperandsSize; j++) {
+            if(evalCompare(ec, i, 0, j, &o) && o == UA_ORDER_EQ)
+                return true;
+        }
+        return false;
+    default:
+        return false;
+    }
+}
+
+/* The predicates that were pushed down, evaluated on the typed columns */
+typedef struct {
+    UA_Boolean *typeOk;    /* Combined restriction of the EventType or NULL */
+    UA_UInt32 source;      /* Entry of the SourceNode or NO_ENTRY */
+} IndexFilter;
+
+static UA_Boolean
+indexMatch(const EventQuery *q, const IndexFilter *f, const EventStore *s, size_t row) {
+    if(f->typeOk) {
+        UA_UInt32 t = s->type[row];
+        if(t == NO_ENTRY || !f->typeOk[t])
+            return false;
+    }
+    if(q->source && s->source[row] != f->source)
+        return false;
+    if(q->hasSeverity) {
+        UA_UInt32 sev = s->severity[row];
+        if(sev == NO_SEVERITY || (UA_Int64)sev < q->severityMin ||
+           (UA_Int64)sev > q->severityMax)
+            return false;
+    }
+    return true;
+}
+
+/*********/
+/* Reads */
+/*********/
+
+typedef struct {
+    UA_DateTime time;
+    size_t row;
+} EventKey;
+
+static int
+cmpEventKey(const void *a, const void *b) {
+    const EventKey *ka = (const EventKey*)a;
+    const EventKey *kb = (const EventKey*)b;
+    if(keyLess(ka->time, ka->row, kb->time, kb->row))
+        return -1;
+    if(keyLess(kb->time, kb->row, ka->time, ka->row))
+        return 1;
+    return 0;
+}
+
+/* The continuation point is the key of the last returned event */
+#define EVENT_CP_LENGTH (sizeof(UA_DateTime) + sizeof(UA_UInt64))
+
+static UA_StatusCode
+appendResult(const EventStore *s, const size_t *selectColumns, size_t selectSize,
+             size_t row, UA_HistoryEvent *result, size_t *capacity) {
+    if(result->eventsSize == *capacity) {
+        size_t cap = (*capacity == 0) ? 16 : *capacity * 2;
+        UA_HistoryEventFieldList *events = (UA_HistoryEventFieldList*)
+            UA_realloc(result->events, cap * sizeof(UA_HistoryEventFieldList));
+        if(!events)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        result->events = events;
+        *capacity = cap;
+    }
+    UA_HistoryEventFieldList *efl = &result->events[result->eventsSize];
+    UA_HistoryEventFieldList_init(efl);
+    efl->eventFields = (UA_Variant*)UA_Array_new(selectSize, &UA_TYPES[UA_TYPES_VARIANT]);
+    if(!efl->eventFields)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    efl->eventFieldsSize = selectSize;
+    result->eventsSize++;
+    for(size_t i = 0; i < selectSize; i++) {
+        if(selectColumns[i] == NO_COLUMN)
+            continue;
+        UA_StatusCode res =
+            UA_Variant_copy(&s->columns[selectColumns[i]].values[row], &efl->eventFields[i]);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+/* The smallest posting list of the pushed-down EventType and SourceNode
+ * predicates, or NULL */
+static const EventPosting *
+smallestPosting(const EventQuery *q, const IndexFilter *f, const EventStore *s) {
+    const EventPosting *best = NULL;
+    if(q->source)
+        best = &s->sources.entries[f->source];
+    if(f->typeOk) {
+        const EventPosting *single = NULL;
+        size_t allowed = 0;
+        for(size_t i = 0; i < s->types.entriesSize; i++) {
+            if(f->typeOk[i]) {
+                single = &s->types.entries[i];
+                allowed++;
+            }
+        }
+        if(allowed == 1 && (!best || single->rowsSize < best->rowsSize))
+            best = single;
+    }
+    return best;
+}
+
+static UA_StatusCode
+readStore(const EventQuery *q, const IndexFilter *f, const EventStore *s,
+          const UA_ReadEventDetails *details, const UA_ByteString *continuationPoint,
+          UA_ByteString *outContinuationPoint, UA_HistoryEvent *result) {
+    /* Time range and direction. The bounds are included. */
+    UA_DateTime lo, hi;
+    UA_Boolean reverse;
+    if(details->startTime == 0) {
+        lo = UA_INT64_MIN;
+        hi = details->endTime;
+        reverse = true;
+    } else if(details->endTime == 0) {
+        lo = details->startTime;
+        hi = UA_INT64_MAX;
+        reverse = false;
+    } else {
+        reverse = (details->startTime > details->endTime);
+        lo = reverse ? details->endTime : details->startTime;
+        hi = reverse ? details->startTime : details->endTime;
+    }
+
+    /* Key range [lowTime/lowRow, highTime/highRow) */
+    UA_DateTime lowTime = lo, highTime = hi;
+    size_t lowRow = 0, highRow = NO_COLUMN;
+    if(continuationPoint->length > 0) {
+        UA_DateTime cpTime;
+        UA_UInt64 cpRow;
+        memcpy(&cpTime, continuationPoint->data, sizeof(UA_DateTime));
+        memcpy(&cpRow, continuationPoint->data + sizeof(UA_DateTime), sizeof(UA_UInt64));
+        if(cpRow >= s->rowsSize)
+            return UA_STATUSCODE_BADCONTINUATIONPOINTINVALID;
+        if(reverse) {
+            if(keyLess(cpTime, (size_t)cpRow, highTime, highRow)) {
+                highTime = cpTime;
+                highRow = (size_t)cpRow;
+            }
+        } else if(keyLess(lowTime, lowRow, cpTime, (size_t)cpRow + 1)) {
+            lowTime = cpTime;
+            lowRow = (size_t)cpRow + 1;
+        }
+    }
+
+    /* Candidate rows in key order. Either a range of the time index or the
+     * rows of a posting list in the key range. */
+    size_t from = lowerBound(s, lowTime, lowRow);
+    size_t to = lowerBound(s, highTime, highRow);
+    if(to < from)
+        to = from;
+    const size_t *candidates = &s->order[from];
+    size_t candidatesSize = to - from;
+    size_t *postingRows = NULL;
+    const EventPosting *p = smallestPosting(q, f, s);
+    if(p && p->rowsSize < candidatesSize) {
+        EventKey *keys = (EventKey*)UA_malloc((p->rowsSize + 1) * sizeof(EventKey));
+        postingRows = (size_t*)UA_malloc((p->rowsSize + 1) * sizeof(size_t));
+        if(!keys || !postingRows) {
+            UA_free(keys);
+            UA_free(postingRows);
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        }
+        size_t keysSize = 0;
+        for(size_t i = 0; i < p->rowsSize; i++) {
+            size_t r = p->rows[i];
+            if(keyLess(s->time[r], r, lowTime, lowRow) ||
+               !keyLess(s->time[r], r, highTime, highRow))
+                continue;
+            keys[keysSize].time = s->time[r];
+            keys[keysSize].row = r;
+            keysSize++;
+        }
+        qsort(keys, keysSize, sizeof(EventKey), cmpEventKey);
+        for(size_t i = 0; i < keysSize; i++)
+            postingRows[i] = keys[i].row;
+        UA_free(keys);
+        candidates = postingRows;
+        candidatesSize = keysSize;
+    }
+
+    /* Filter and copy out the events */
+    const UA_EventFilter *filter = &details->filter;
+    size_t *selectColumns = (size_t*)
+        UA_malloc((filter->selectClausesSize + 1) * sizeof(size_t));
+    if(!selectColumns) {
+        UA_free(postingRows);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    for(size_t i = 0; i < filter->selectClausesSize; i++)
+        selectColumns[i] = findColumn(s, &filter->selectClauses[i]);
+
+    EvalContext ec;
+    ec.q = q;
+    ec.s = s;
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    size_t capacity = 0;
+    size_t last = 0;
+    UA_Boolean more = false;
+    for(size_t k = 0; k < candidatesSize; k++) {
+        size_t row = candidates[reverse ? candidatesSize - 1 - k : k];
+        if(!indexMatch(q, f, s, row))
+            continue;
+        ec.row = row;
+        if(!q->exact && !evalElement(&ec, 0))
+            continue;
+        if(details->numValuesPerNode > 0 &&
+           result->eventsSize == details->numValuesPerNode) {
+            more = true;
+            break;
+        }
+        res = appendResult(s, selectColumns, filter->selectClausesSize,
+                           row, result, &capacity);
+        if(res != UA_STATUSCODE_GOOD)
+            break;
+        last = row;
+    }
+    UA_free(selectColumns);
+    UA_free(postingRows);
+    if(res != UA_STATUSCODE_GOOD || !more)
+        return res;
+
+    res = UA_ByteString_allocBuffer(outContinuationPoint, EVENT_CP_LENGTH);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    UA_UInt64 lastRow = last;
+    memcpy(outContinuationPoint->data, &s->time[last], sizeof(UA_DateTime));
+    memcpy(outContinuationPoint->data + sizeof(UA_DateTime), &lastRow, sizeof(UA_UInt64));
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+readEvents_backend_memory(UA_Server *server, void *context,
+                          const UA_NodeId *sessionId, void *sessionContext,
+                          const UA_NodeId *emitterId,
+                          const UA_ReadEventDetails *details,
+                          UA_TimestampsToReturn timestampsToReturn,
+                          const UA_ByteString *continuationPoint,
+                          UA_ByteString *outContinuationPoint,
+                          UA_HistoryEvent *result) {
+    if(details->startTime == 0 && details->endTime == 0)
+        return UA_STATUSCODE_BADINVALIDTIMESTAMPARGUMENT;
+    if(continuationPoint->length != 0 && continuationPoint->length != EVENT_CP_LENGTH)
+        return UA_STATUSCODE_BADCONTINUATIONPOINTINVALID;
+
+    /* Validate the filter and resolve the types before taking the lock */
+    EventQuery q;
+    UA_StatusCode res = prepareQuery(server, &details->filter.whereClause, &q);
+    if(res != UA_STATUSCODE_GOOD || q.empty) {
+        clearQuery(&q);
+        return res;
+    }
+
+    IndexFilter f;
+    f.typeOk = NULL;
+    f.source = NO_ENTRY;
+    UA_EventStoreContext *ctx = (UA_EventStoreContext*)context;
+    EVENTSTORE_LOCK(ctx);
+    const EventStore *s = findStore(ctx, emitterId);
+    if(!s)
+        goto out;
+    res = bindQuery(&q, s);
+    if(res != UA_STATUSCODE_GOOD)
+        goto out;
+
+    /* Combine the pushed-down predicates. The type restrictions are ANDed
+     * into the first one. This does not change the evaluation of the where
+     * clause, as all pushed-down elements have to match anyway. */
+    if(q.source) {
+        f.source = dictFind(&s->sources, q.source);
+        if(f.source == NO_ENTRY)
+            goto out;
+    }
+    for(size_t i = 0; i < q.where->elementsSize; i++) {
+        QueryElement *qe = &q.elements[i];
+        if(!qe->pushed)
+            continue;
+        if(!f.typeOk) {
+            f.typeOk = qe->typeOk;
+            continue;
+        }
+        for(size_t j = 0; j < s->types.entriesSize; j++)
+            f.typeOk[j] = f.typeOk[j] && qe->typeOk[j];
+    }
+
+    res = readStore(&q, &f, s, details, continuationPoint,
+                    outContinuationPoint, result);
+
+ out:
+    EVENTSTORE_UNLOCK(ctx);
+    clearQuery(&q);
+    return res;
+}
+
+static void
+deleteMembers_backend_memory(UA_HistoryEventBackend *backend) {
+    if(backend == NULL || backend->context == NULL)
+        return;
+    UA_EventStoreContext *ctx = (UA_EventStoreContext*)backend->context;
+    ZIP_ITER(EventStoreTree, &ctx->stores, deleteEventStore, NULL);
+#ifdef UA_EVENTSTORE_THREAD
+    pthread_mutex_destroy(&ctx->lock);
+#endif
+    UA_free(ctx);
+    backend->context = NULL;
+}
+
+UA_HistoryEventBackend
+UA_HistoryEventBackend_Memory(void) {
+    UA_HistoryEventBackend result;
+    memset(&result, 0, sizeof(UA_HistoryEventBackend));
+    UA_EventStoreContext *ctx = (UA_EventStoreContext*)
+        UA_calloc(1, sizeof(UA_EventStoreContext));
+    if(!ctx)
+        return result;
+#ifdef UA_EVENTSTORE_THREAD
+    pthread_mutex_init(&ctx->lock, NULL);
+#endif
+    result.context = ctx;
+    result.deleteMembers = &deleteMembers_backend_memory;
+    result.storeEvent = &storeEvent_backend_memory;
+    result.readEvents = &readEvents_backend_memory;
+    return result;
+}
+
+void
+UA_HistoryEventBackend_Memory_clear(UA_HistoryEventBackend *backend) {
+    deleteMembers_backend_memory(backend);
+}
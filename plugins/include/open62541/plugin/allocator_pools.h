@@ -0,0 +1,30 @@
+/* This work is licensed under a Creative Commons CCZero 1.0 Universal License.
+ * See http://creativecommons.org/publicdomain/zero/1.0/ for more information.
+ */
+
+#ifndef UA_ALLOCATOR_POOLS_H_
+#define UA_ALLOCATOR_POOLS_H_
+
+#include <open62541/plugin/allocator.h>
+
+_UA_BEGIN_DECLS
+
+/* Allocator with pools per memory category. Blocks up to 4kB are rounded up
+ * to a power of two (the size class) and carved from slabs of 64kB. Freed
+ * blocks are kept in a free list of their category and size class. So
+ * short-lived allocations of one subsystem do not fragment the memory of
+ * another. Larger blocks are taken from malloc directly.
+ *
+ * Every block has a header of 16 bytes with its category and size. The
+ * statistics are kept per category. The slabs are only released when the
+ * allocator is cleared. So bytesReserved is the high-water mark of the pooled
+ * memory plus the large blocks in use.
+ *
+ * Use with ``UA_Allocator_set`` to route the memory management of the library
+ * through the allocator. */
+UA_EXPORT UA_Allocator *
+UA_Allocator_Pools_new(void);
+
+_UA_END_DECLS
+
+#endif /* UA_ALLOCATOR_POOLS_H_ */
@@ -0,0 +1,28 @@
+/* This work is licensed under a Creative Commons CCZero 1.0 Universal License.
+ * See http://creativecommons.org/publicdomain/zero/1.0/ for more information.
+ */
+
+#ifndef UA_ALLOCATOR_TRACKING_H_
+#define UA_ALLOCATOR_TRACKING_H_
+
+#include <open62541/plugin/allocator.h>
+
+_UA_BEGIN_DECLS
+
+/* Allocator that takes every block from the system malloc and only keeps the
+ * statistics per memory category. Unlike the pool allocator, the memory is
+ * returned to the system when a block is freed. So the footprint of the
+ * application does not change, apart from a header of 16 bytes per block that
+ * holds the category and the size.
+ *
+ * bytesReserved is bytesInUse plus the block headers. The statistics are the
+ * input for ``UA_Server_getMemoryReport``.
+ *
+ * Use with ``UA_Allocator_set`` to route the memory management of the library
+ * through the allocator. */
+UA_EXPORT UA_Allocator *
+UA_Allocator_Tracking_new(void);
+
+_UA_END_DECLS
+
+#endif /* UA_ALLOCATOR_TRACKING_H_ */
@@ -0,0 +1,48 @@
+/* This work is licensed under a Creative Commons CCZero 1.0 Universal License.
+ * See http://creativecommons.org/publicdomain/zero/1.0/ for more information.
+ */
+
+#ifndef UA_CAPTURE_PCAPNG_H_
+#define UA_CAPTURE_PCAPNG_H_
+
+#include <open62541/plugin/capture.h>
+
+_UA_BEGIN_DECLS
+
+/* Packet capture into a pcapng file. Available only for Linux/Unices with
+ * multithreading enabled.
+ *
+ * Every captured chunk is written as a packet with synthetic IPv4 and TCP
+ * headers. So the file can be opened in Wireshark with the OPC UA dissector.
+ * The server is at 127.0.0.1:4840. The client port is derived from the
+ * connectionId. The MessageSize field is set to the length of the captured
+ * plaintext chunk (without padding and signature). Chunks longer than a TCP
+ * segment are split up.
+ *
+ * The capture callback only copies the packet into a buffer. A background
+ * thread writes the buffer to the file. If the buffer is full, the packet is
+ * dropped and counted. */
+
+#if (defined(__linux__) || defined(__unix__)) && UA_MULTITHREADING >= 100
+
+/* Opens the file, writes the pcapng header and starts the background thread.
+ * The bufferSize is the number of bytes buffered between two writes (default
+ * 1MB if zero). The capture is enabled right away. Set the enabled flag to
+ * toggle at runtime. */
+UA_EXPORT UA_PacketCapture *
+UA_PacketCapture_Pcapng_new(const char *filename, size_t bufferSize);
+
+/* Wait until all packets that were captured before are written to the file */
+UA_EXPORT void
+UA_PacketCapture_Pcapng_flush(UA_PacketCapture *pc);
+
+/* Number of captured and dropped chunks */
+UA_EXPORT void
+UA_PacketCapture_Pcapng_getStatistics(UA_PacketCapture *pc, size_t *captured,
+                                      size_t *dropped);
+
+#endif
+
+_UA_END_DECLS
+
+#endif /* UA_CAPTURE_PCAPNG_H_ */
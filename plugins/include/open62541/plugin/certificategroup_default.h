@@ -31,6 +31,15 @@ UA_CertificateGroup_AcceptAll(UA_CertificateGroup *certGroup);
  * 0:max-rejected-listsize [uint32]
  *    The maximum number of certificate files that can be stored in the rejected list.
  *    (default: 100).
+ *
+ * 0:verifyCacheSize [uint32]
+ *    The number of recent verification results that are remembered (least
+ *    recently used entries are dropped). The results are discarded when the
+ *    trust list changes. Only with OpenSSL so far. (default: 0 -> disabled).
+ *
+ * 0:verifyCacheTtl [uint32]
+ *    The time in ms after which a remembered result is no longer used.
+ *    (default: 60000).
  */
 UA_EXPORT UA_StatusCode
 UA_CertificateGroup_Memorystore(UA_CertificateGroup *certGroup,
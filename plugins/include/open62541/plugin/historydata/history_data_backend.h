@@ -24,6 +24,16 @@ typedef enum {
                              that is earlier in time from the provided timestamp. */
 } MatchStrategy;
 
+/* Summary of the samples in a time range for the aggregates of ReadProcessed.
+ * Only samples with a good status are considered. */
+typedef struct {
+    size_t count;        /* Number of samples */
+    size_t numericCount; /* Number of samples with a numeric scalar value */
+    UA_Double sum;       /* Sum, minimum and maximum of the numeric values */
+    UA_Double min;
+    UA_Double max;
+} UA_HistoryAggregateSummary;
+
 typedef struct UA_HistoryDataBackend UA_HistoryDataBackend;
 
 struct UA_HistoryDataBackend {
@@ -284,6 +294,99 @@ struct UA_HistoryDataBackend {
                        const UA_NodeId *nodeId,
                        UA_DateTime startTimestamp,
                        UA_DateTime endTimestamp);
+
+    /* Stores a batch of gathered values like serverSetHistoryData. This
+     * function is optional (can be NULL). Then serverSetHistoryData is called
+     * for every value. The values are ordered as they were gathered. The
+     * session is unknown and the historizing flag is invalid.
+     *
+     * server is the server the nodes live in.
+     * hdbContext is the context of the UA_HistoryDataBackend.
+     * valuesSize is the number of values.
+     * nodeIds contains the node for each value.
+     * values contains the values which shall be stored. */
+    UA_StatusCode
+    (*serverSetHistoryDataBatch)(UA_Server *server,
+                                 void *hdbContext,
+                                 size_t valuesSize,
+                                 const UA_NodeId *nodeIds,
+                                 const UA_DataValue *values);
+
+    /* Returns the summary of the samples in the time range [start, end). This
+     * function is optional (can be NULL) and lets a backend answer the
+     * aggregates Average, Minimum, Maximum and Count from pre-aggregated
+     * rollups. If it is NULL or does not return UA_STATUSCODE_GOOD, the
+     * samples are aggregated in a pass over the raw data.
+     *
+     * server is the server the node lives in.
+     * hdbContext is the context of the UA_HistoryDataBackend.
+     * sessionId and sessionContext identify the session that wants to read historical data.
+     * nodeId is the node for which the summary shall be computed.
+     * start and end are the bounds of the time range.
+     * summary is the output. */
+    UA_StatusCode
+    (*getAggregateSummary)(UA_Server *server,
+                           void *hdbContext,
+                           const UA_NodeId *sessionId,
+                           void *sessionContext,
+                           const UA_NodeId *nodeId,
+                           UA_DateTime start,
+                           UA_DateTime end,
+                           UA_HistoryAggregateSummary *summary);
+
+    /* Opens a cursor over the values from startIndex to endIndex (both
+     * included, walked backwards if reverse is set). The server holds the
+     * cursor for a continuation point of ReadRaw and resumes reading where the
+     * last call of readCursor stopped. This lets backends stream the values
+     * from storage without locating the position again. The cursor functions
+     * are optional (can be NULL). Then the values are copied with
+     * copyDataValues from the index where the last call stopped.
+     *
+     * server is the server the node lives in.
+     * hdbContext is the context of the UA_HistoryDataBackend.
+     * sessionId and sessionContext identify the session that wants to read historical data.
+     * nodeId is the node id of the node for which the values shall be read.
+     * startIndex is the index of the first value in the range.
+     * endIndex is the index of the last value in the range.
+     * reverse determines if the values shall be read in reverse order.
+     * cursor is the output. */
+    UA_StatusCode
+    (*openCursor)(UA_Server *server,
+                  void *hdbContext,
+                  const UA_NodeId *sessionId,
+                  void *sessionContext,
+                  const UA_NodeId *nodeId,
+                  size_t startIndex,
+                  size_t endIndex,
+                  UA_Boolean reverse,
+                  void **cursor);
+
+    /* Copies the next values of the cursor. Providing less than maxValues
+     * values ends the cursor.
+     *
+     * server is the server the node lives in.
+     * hdbContext is the context of the UA_HistoryDataBackend.
+     * cursor is the cursor returned by openCursor.
+     * maxValues is the maximal number of data values to copy.
+     * range is the numeric range which shall be copied for every data value.
+     * providedValues contains the number of values that were copied.
+     * values contains the values that have been copied from the database. */
+    UA_StatusCode
+    (*readCursor)(UA_Server *server,
+                  void *hdbContext,
+                  void *cursor,
+                  size_t maxValues,
+                  UA_NumericRange range,
+                  size_t *providedValues,
+                  UA_DataValue *values);
+
+    /* Frees a cursor. It is called when the continuation point is finished,
+     * released or evicted. The server is NULL if the cursor is closed while
+     * the history database is deleted. */
+    void
+    (*closeCursor)(UA_Server *server,
+                   void *hdbContext,
+                   void *cursor);
 };
 
 _UA_END_DECLS
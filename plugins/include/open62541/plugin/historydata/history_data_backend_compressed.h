@@ -0,0 +1,43 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef UA_HISTORYDATABACKEND_COMPRESSED_H_
+#define UA_HISTORYDATABACKEND_COMPRESSED_H_
+
+#include "history_data_backend.h"
+
+_UA_BEGIN_DECLS
+
+#define UA_HISTORY_COMPRESSED_BLOCKSIZE 1024
+
+/* This function constructs a UA_HistoryDataBackend that stores the samples of
+ * every node in time-ordered blocks. Within a block, the timestamps are stored
+ * as delta-of-deltas and scalar numeric values (Boolean to Double, DateTime,
+ * StatusCode) as the XOR with the previous value. The StatusCode and the
+ * timestamp flags are only stored when they change. Values that cannot be
+ * compressed (strings, arrays, structures, ...) go into uncompressed blocks.
+ *
+ * Time-range lookups skip the blocks by their first and last timestamp and
+ * decode only the block that contains the bound. The most recently decoded
+ * block is cached. The nodes are found in a tree keyed by the NodeId hash.
+ *
+ * Appending in timestamp order is fast. Late samples, replacing and deleting
+ * decode and re-encode the affected blocks.
+ *
+ * samplesPerBlock is the maximum number of samples per block (0 for
+ * UA_HISTORY_COMPRESSED_BLOCKSIZE). */
+UA_HistoryDataBackend UA_EXPORT
+UA_HistoryDataBackend_Compressed(size_t samplesPerBlock);
+
+/* Returns the number of bytes allocated for the stored samples of all nodes */
+size_t UA_EXPORT
+UA_HistoryDataBackend_Compressed_memoryUsage(const UA_HistoryDataBackend *backend);
+
+void UA_EXPORT
+UA_HistoryDataBackend_Compressed_clear(UA_HistoryDataBackend *backend);
+
+_UA_END_DECLS
+
+#endif /* UA_HISTORYDATABACKEND_COMPRESSED_H_ */
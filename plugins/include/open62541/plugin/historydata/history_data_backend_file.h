@@ -0,0 +1,63 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef UA_HISTORYDATABACKEND_FILE_H_
+#define UA_HISTORYDATABACKEND_FILE_H_
+
+#include "history_data_backend.h"
+
+_UA_BEGIN_DECLS
+
+#ifdef UA_ARCHITECTURE_POSIX
+
+typedef struct {
+    /* Samples are stored in one segment file per time window of this duration
+     * (0 for one hour). Must not change for an existing directory. */
+    UA_DateTime segmentDuration;
+
+    /* Written samples are buffered and committed to disk (write and fsync) in
+     * groups of this many samples (0 for 256). Pending samples are lost if the
+     * process ends without a commit. */
+    size_t commitSamples;
+
+    /* Segments whose time window ended longer ago than the retention are
+     * deleted during the maintenance (0 to keep all segments). */
+    UA_DateTime retention;
+} UA_HistoryDataBackendFileOptions;
+
+/* This function constructs a UA_HistoryDataBackend that persists the samples
+ * of all nodes in append-only segment files in the directory. The directory
+ * has to exist. Existing segment files are replayed to rebuild the index, so
+ * the history survives a restart.
+ *
+ * The index (timestamp and file offset of every sample) is held in RAM. The
+ * samples themselves are decoded on demand from a read-only memory mapping of
+ * the segment files. Replaced and deleted samples are recorded as new records.
+ * The dead records are removed when the segment is compacted.
+ *
+ * The options can be NULL for the defaults. */
+UA_StatusCode UA_EXPORT
+UA_HistoryDataBackend_File(UA_HistoryDataBackend *backend, const char *directory,
+                           const UA_HistoryDataBackendFileOptions *options);
+
+/* Commit the pending samples to disk */
+UA_StatusCode UA_EXPORT
+UA_HistoryDataBackend_File_commit(UA_HistoryDataBackend *backend);
+
+/* Commit the pending samples, delete the segments beyond the retention and
+ * compact the segments where more than half of the records are dead. Call this
+ * regularly, e.g. from a repeated callback of the server. */
+UA_StatusCode UA_EXPORT
+UA_HistoryDataBackend_File_maintain(UA_HistoryDataBackend *backend);
+
+/* Commits the pending samples and closes the files */
+void UA_EXPORT
+UA_HistoryDataBackend_File_clear(UA_HistoryDataBackend *backend);
+
+#endif /* UA_ARCHITECTURE_POSIX */
+
+_UA_END_DECLS
+
+#endif /* UA_HISTORYDATABACKEND_FILE_H_ */
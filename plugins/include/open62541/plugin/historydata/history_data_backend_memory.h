@@ -23,6 +23,9 @@ UA_HistoryDataBackend_Memory(size_t initialNodeIdStoreSize, size_t initialDataSt
  * initialNodeIdStoreSize is the maximum number of NodeIds that will be historized. This number cannot be overcomed.
  * initialDataStoreSize is the maximum number of UA_DataValueMemoryStoreItem that will be saved in the circular buffer for a particular NodeId.
  *                      Subsequent UA_DataValueMemoryStoreItem will be saved replacing the oldest ones following the logic of circular buffers.
+ *
+ * The values are kept ordered by timestamp. Values in timestamp order are appended in constant time. Late values are
+ * sorted in and drop the oldest value if the buffer is full. Time ranges are found with a binary search over the buffer.
  */
 UA_HistoryDataBackend UA_EXPORT
 UA_HistoryDataBackend_Memory_Circular(size_t initialNodeIdStoreSize, size_t initialDataStoreSize);
@@ -23,6 +23,23 @@ UA_HistoryDataGathering_Default(size_t initialNodeIdStoreSize);
 UA_HistoryDataGathering UA_EXPORT
 UA_HistoryDataGathering_Circular(size_t initialNodeIdStoreSize);
 
+/* This function constructs a UA_HistoryDataGathering that takes the backend
+ * out of the write and sampling path. The gathered values are copied into a
+ * lock-free queue with queueSize entries (0 for 4096) that accepts values from
+ * several threads. A background thread stores the values in batches in the
+ * backends (with serverSetHistoryDataBatch where available). Without
+ * multithreading support, a batch is stored when enough values are queued.
+ * If the queue is full, the producer stores the queued values itself.
+ *
+ * The backend in the settings returned by getHistorizingSetting is a wrapper
+ * that serializes the access with the background thread. It stores the queued
+ * values first, so HistoryRead and HistoryUpdate see all gathered values.
+ *
+ * initialNodeIdStoreSize is the initial number of NodeIds for which the data
+ * will be gathered. */
+UA_HistoryDataGathering UA_EXPORT
+UA_HistoryDataGathering_Batched(size_t initialNodeIdStoreSize, size_t queueSize);
+
 _UA_END_DECLS
 
 #endif /* UA_HISTORYDATAGATHERING_DEFAULT_H_ */
@@ -11,12 +11,21 @@
 #include <open62541/plugin/historydatabase.h>
 
 #include "history_data_gathering.h"
+#include "history_event_backend.h"
 
 _UA_BEGIN_DECLS
 
 UA_HistoryDatabase UA_EXPORT
 UA_HistoryDatabase_default(UA_HistoryDataGathering gathering);
 
+/* In addition to the historical data of the gathering, the events of nodes
+ * with a HistoricalEventFilter property are stored in the eventBackend and
+ * served for ReadEvent requests. The emitter needs the HistoryRead bit in its
+ * EventNotifier to be read. The eventBackend is deleted with the database. */
+UA_HistoryDatabase UA_EXPORT
+UA_HistoryDatabase_defaultWithEvents(UA_HistoryDataGathering gathering,
+                                     UA_HistoryEventBackend eventBackend);
+
 _UA_END_DECLS
 
 #endif /* UA_HISTORYDATASERVICE_DEFAULT_H_ */
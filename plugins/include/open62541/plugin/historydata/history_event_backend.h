@@ -0,0 +1,74 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef UA_PLUGIN_HISTORY_EVENT_BACKEND_H_
+#define UA_PLUGIN_HISTORY_EVENT_BACKEND_H_
+
+#include <open62541/server.h>
+
+_UA_BEGIN_DECLS
+
+typedef struct UA_HistoryEventBackend UA_HistoryEventBackend;
+
+struct UA_HistoryEventBackend {
+    void *context;
+
+    void
+    (*deleteMembers)(UA_HistoryEventBackend *backend);
+
+    /* This function stores an event in the historical event storage.
+     *
+     * server is the server the emitting node lives in.
+     * hdbContext is the context of the UA_HistoryEventBackend.
+     * originId is the node that triggered the event.
+     * emitterId is the node that emits the event. The events are stored per
+     * emitter.
+     * historicalEventFilter is the HistoricalEventFilter property of the
+     * emitter. Its select clauses describe the fields in fieldList.
+     * fieldList holds the values of the select clauses for this event.
+     *
+     * The function is called with the server lock held. It must not call the
+     * public server API. */
+    UA_StatusCode
+    (*storeEvent)(UA_Server *server,
+                  void *hdbContext,
+                  const UA_NodeId *originId,
+                  const UA_NodeId *emitterId,
+                  const UA_EventFilter *historicalEventFilter,
+                  const UA_EventFieldList *fieldList);
+
+    /* This function reads the stored events of an emitter.
+     *
+     * server is the server the emitting node lives in.
+     * hdbContext is the context of the UA_HistoryEventBackend.
+     * sessionId and sessionContext identify the session that wants to read
+     * the historical events.
+     * emitterId is the node whose events are read.
+     * details holds the time range, the maximum number of events and the
+     * filter. Only events that match the where clause are returned. For every
+     * event, the values of the select clauses are returned.
+     * timestampsToReturn is the requested timestamps to return.
+     * continuationPoint is the continuation point of a previous call or has
+     * length 0.
+     * outContinuationPoint is set if more events are available.
+     * result is the initialized UA_HistoryEvent to fill.
+     *
+     * The function is called without the server lock held. */
+    UA_StatusCode
+    (*readEvents)(UA_Server *server,
+                  void *hdbContext,
+                  const UA_NodeId *sessionId,
+                  void *sessionContext,
+                  const UA_NodeId *emitterId,
+                  const UA_ReadEventDetails *details,
+                  UA_TimestampsToReturn timestampsToReturn,
+                  const UA_ByteString *continuationPoint,
+                  UA_ByteString *outContinuationPoint,
+                  UA_HistoryEvent *result);
+};
+
+_UA_END_DECLS
+
+#endif /* UA_PLUGIN_HISTORY_EVENT_BACKEND_H_ */
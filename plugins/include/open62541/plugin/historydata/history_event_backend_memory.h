@@ -0,0 +1,40 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef UA_HISTORYEVENTBACKEND_MEMORY_H_
+#define UA_HISTORYEVENTBACKEND_MEMORY_H_
+
+#include "history_event_backend.h"
+
+_UA_BEGIN_DECLS
+
+/* This function constructs a UA_HistoryEventBackend that stores the events of
+ * every emitter in memory. The emitters are found in a tree keyed by the
+ * NodeId hash.
+ *
+ * The event fields are stored column-wise, one column per select clause of the
+ * HistoricalEventFilter. Select clauses are matched by their browse path,
+ * attribute and index range (the type definition is ignored). A new select
+ * clause adds a column that is empty for the earlier events.
+ *
+ * The Time, EventType, SourceNode and Severity fields (if selected by the
+ * HistoricalEventFilter) are additionally kept in typed columns. The events
+ * are indexed by time. EventType and SourceNode are dictionary-encoded with a
+ * list of events for every distinct value.
+ *
+ * In a read, an AND-chain of OfType and Equals on EventType, Equals on
+ * SourceNode and comparisons of Severity with literals is answered from the
+ * indexes. The remaining where clause is then evaluated on the stored fields
+ * of the candidate events only. Operands that are not stored evaluate to null.
+ * Events without a stored Time are indexed with the time they were stored. */
+UA_HistoryEventBackend UA_EXPORT
+UA_HistoryEventBackend_Memory(void);
+
+void UA_EXPORT
+UA_HistoryEventBackend_Memory_clear(UA_HistoryEventBackend *backend);
+
+_UA_END_DECLS
+
+#endif /* UA_HISTORYEVENTBACKEND_MEMORY_H_ */
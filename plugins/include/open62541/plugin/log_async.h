@@ -0,0 +1,47 @@
+/* This work is licensed under a Creative Commons CCZero 1.0 Universal License.
+ * See http://creativecommons.org/publicdomain/zero/1.0/ for more information.
+ */
+
+#ifndef UA_LOG_ASYNC_H_
+#define UA_LOG_ASYNC_H_
+
+#include <open62541/plugin/log.h>
+
+_UA_BEGIN_DECLS
+
+/* Asynchronous logging is available only for Linux/Unices with
+ * multithreading enabled.
+ *
+ * The calling thread formats the message into a slot of a lock-free ring
+ * buffer and returns. It takes no lock and makes no system call. A background
+ * thread adds the timestamp prefix and writes the messages to stdout in the
+ * same format as the stdout-logger. Messages are written at the latest 10ms
+ * after they were logged.
+ *
+ * If the ring buffer is full, the message is dropped and counted. The number
+ * of dropped messages is also written to the log once there is space again.
+ * Messages longer than 511 characters are truncated. */
+
+#if (defined(__linux__) || defined(__unix__)) && UA_MULTITHREADING >= 100
+
+/* Allocates the logger and starts the background thread. The bufferSize is
+ * the number of messages in the ring buffer. It is rounded up to the next
+ * power of two (default 1024 if zero). Automatically cleared up via _clear.
+ * Remaining messages are written before the logger is cleared. */
+UA_EXPORT UA_Logger *
+UA_Log_Async_new(UA_LogLevel minlevel, size_t bufferSize);
+
+/* Wait until all messages that were logged before are written */
+UA_EXPORT void
+UA_Log_Async_flush(const UA_Logger *logger);
+
+/* Number of written and dropped messages */
+UA_EXPORT void
+UA_Log_Async_getStatistics(const UA_Logger *logger, size_t *written,
+                           size_t *dropped);
+
+#endif
+
+_UA_END_DECLS
+
+#endif /* UA_LOG_ASYNC_H_ */
@@ -0,0 +1,64 @@
+/* This work is licensed under a Creative Commons CCZero 1.0 Universal License.
+ * See http://creativecommons.org/publicdomain/zero/1.0/ for more information.
+ */
+
+#ifndef UA_METRICS_PROMETHEUS_H_
+#define UA_METRICS_PROMETHEUS_H_
+
+#include <open62541/server.h>
+
+_UA_BEGIN_DECLS
+
+/**
+ * Prometheus Metrics Exporter
+ * ---------------------------
+ * The exporter serves the statistics of the server over HTTP in the Prometheus
+ * text format (version 0.0.4), which can also be read by OpenMetrics scrapers.
+ * The HTTP endpoint is opened on the TCP ConnectionManager of the server's
+ * EventLoop. So no additional thread is required and a scrape does not go
+ * through the OPC UA stack (SecureChannel, Session, Read service). The
+ * metrics are answered for ``GET /metrics`` (and ``GET /``).
+ *
+ * The exported metrics are:
+ *
+ * - SecureChannels and Sessions (current, opened, closed by reason)
+ * - Subscriptions, MonitoredItems, queued Notifications and retransmission
+ *   queue entries (with subscriptions enabled)
+ * - Secured chunks sent and received (signed and/or encrypted)
+ * - EventLoop timers, iterations and processing time (if the EventLoop
+ *   implements getStatistics)
+ * - PubSub publish cycles and cycle overruns (with PubSub enabled)
+ * - Heap usage of the allocator (with glibc 2.33 or newer)
+ * - Requests, errors, operations and latency quantiles per service (with
+ *   diagnostics enabled)
+ *
+ * The exporter must be created after the server was started (e.g. after
+ * ``UA_Server_run_startup``), as the listen socket can only be opened in a
+ * running EventLoop. The endpoint has no access control. Bind it to a
+ * management interface with the listenAddress argument if required. */
+
+typedef struct UA_MetricsExporter UA_MetricsExporter;
+
+/* Start serving the metrics on the given port. The listenAddress can be NULL
+ * to listen on all interfaces. Returns NULL if the listen socket could not be
+ * opened. */
+UA_EXPORT UA_MetricsExporter *
+UA_MetricsExporter_Prometheus_new(UA_Server *server,
+                                  const UA_String *listenAddress,
+                                  UA_UInt16 port);
+
+/* Close the listen socket and all connections. The memory is released once
+ * the EventLoop has closed the sockets. If the EventLoop is already stopped,
+ * the memory is released right away. */
+UA_EXPORT void
+UA_MetricsExporter_delete(UA_MetricsExporter *me);
+
+/* Print the metrics of the server in the Prometheus text format. The output
+ * string is allocated and has to be cleared by the caller. This can be used
+ * to serve the metrics from an HTTP server of the application. */
+UA_EXPORT UA_StatusCode
+UA_MetricsExporter_Prometheus_print(UA_Server *server, UA_String *output);
+
+_UA_END_DECLS
+
+#endif /* UA_METRICS_PROMETHEUS_H_ */
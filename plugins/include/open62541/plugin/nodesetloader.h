@@ -14,11 +14,24 @@ _UA_BEGIN_DECLS
 typedef void UA_NodeSetLoaderOptions;
 
 /* Load the typemodel at runtime, without the need to statically compile the model.
- * This is an alternative to the Python nodeset compiler approach. */
+ * This is an alternative to the Python nodeset compiler approach.
+ *
+ * The nodes are added in bulk mode (see UA_Server_beginBulkLoad). The
+ * type-checks and constructors run once after the file was loaded. If the
+ * server is already in bulk mode, they run when the caller ends it. */
 UA_EXPORT UA_StatusCode
 UA_Server_loadNodeset(UA_Server *server, const char *nodeset2XmlFilePath,
                       UA_NodeSetLoaderOptions *options);
 
+/* Load several nodesets in the given order within a single bulk load. A
+ * nodeset can only reference nodes of the nodesets before it. Loading the
+ * companion specifications together defers the type-checks, the constructors
+ * and the packing of references for all of them to one pass at the end. The
+ * loading stops at the first file that cannot be loaded. */
+UA_EXPORT UA_StatusCode
+UA_Server_loadNodesets(UA_Server *server, const char **nodeset2XmlFilePaths,
+                       size_t nodesetsSize, UA_NodeSetLoaderOptions *options);
+
 _UA_END_DECLS
 
 #endif /* UA_NODESET_LOADER_DEFAULT_H_ */
@@ -18,6 +18,15 @@ _UA_BEGIN_DECLS
 UA_EXPORT UA_StatusCode
 UA_Nodestore_HashMap(UA_Nodestore *ns);
 
+/* Variant of the HashMap Nodestore where getNode/releaseNode do not block.
+ * Nodes are never modified in-situ. Instead getEditNode returns a copy that
+ * replaces the original node in releaseNode (copy-on-write). Removed and
+ * replaced nodes are freed by the writers once they are no longer used by any
+ * reader. Multiple readers can run in parallel to one writer. But the writers
+ * (all other methods) have to be serialized. */
+UA_EXPORT UA_StatusCode
+UA_Nodestore_ConcurrentHashMap(UA_Nodestore *ns);
+
 /* The ZipTree Nodestore holds all nodes in RAM in a tree structure. The lookup
  * time is about O(log n). Adding/removing nodes does not require resizing of
  * the underlying array with the linear overhead.
@@ -27,6 +36,28 @@ UA_Nodestore_HashMap(UA_Nodestore *ns);
 UA_EXPORT UA_StatusCode
 UA_Nodestore_ZipTree(UA_Nodestore *ns);
 
+#ifdef UA_ARCHITECTURE_POSIX
+/* The MappedFile Nodestore serves the nodes of an address space snapshot file
+ * (see UA_Server_saveAddressSpaceSnapshot) from a read-only memory mapping.
+ * Only the NodeId index and the recently used nodes (up to cacheSize decoded
+ * nodes) are held in RAM. Added and modified nodes are kept in RAM in addition
+ * to the file. The file must not change while it is mapped. The namespace
+ * indices of the snapshot have to match the server. */
+UA_EXPORT UA_StatusCode
+UA_Nodestore_MappedFile(UA_Nodestore *ns, const char *path, size_t cacheSize,
+                        const UA_DataTypeArray *customTypes);
+
+/* Like UA_Nodestore_MappedFile. But also namespace 0 is served from the
+ * snapshot file. The server then does not create namespace 0 on startup and
+ * only the nodes it modifies (e.g. to set data sources) are held in RAM. So
+ * startup time and memory per server instance hardly depend on the size of
+ * namespace 0. Server instances mapping the same file share its pages. The
+ * snapshot must have been saved by a server with the same build options. */
+UA_EXPORT UA_StatusCode
+UA_Nodestore_MappedFileNs0(UA_Nodestore *ns, const char *path, size_t cacheSize,
+                           const UA_DataTypeArray *customTypes);
+#endif
+
 _UA_END_DECLS
 
 #endif /* UA_NODESTORE_DEFAULT_H_ */
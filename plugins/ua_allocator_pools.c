@@ -0,0 +1,259 @@
+/* This work is licensed under a Creative Commons CCZero 1.0 Universal License.
+ * See http://creativecommons.org/publicdomain/zero/1.0/ for more information.
+ */
+
+#include <open62541/plugin/allocator_pools.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+/* The memory is taken from the system malloc. UA_malloc can be routed
+ * through this allocator and must not be used here. */
+
+#define POOLS_MINSHIFT 4      /* Smallest size class of 16 bytes */
+#define POOLS_SIZECLASSES 9   /* Up to 4kB */
+#define POOLS_MAXSIZE ((size_t)1 << (POOLS_MINSHIFT + POOLS_SIZECLASSES - 1))
+#define POOLS_LARGE POOLS_SIZECLASSES
+#define POOLS_SLABSIZE ((size_t)1 << 16)
+
+/* The header keeps the alignment of malloc for the following user memory */
+typedef union {
+    struct {
+        UA_UInt32 category;
+        UA_UInt32 sizeClass; /* POOLS_LARGE for blocks from malloc */
+        size_t size;         /* Requested size */
+    } h;
+    UA_Byte align[16];
+} PoolHeader;
+
+/* Slabs are linked for the cleanup. The blocks start after the link. */
+typedef union PoolSlab {
+    union PoolSlab *next;
+    UA_Byte align[16];
+} PoolSlab;
+
+typedef struct {
+#if UA_MULTITHREADING >= 100
+    UA_Lock lock;
+#endif
+    PoolHeader *freeLists[POOLS_SIZECLASSES]; /* The next pointer is stored in
+                                               * the user memory */
+    UA_Byte *slabPos[POOLS_SIZECLASSES];      /* Unused rest of the current
+                                               * slab of the size class */
+    UA_Byte *slabEnd[POOLS_SIZECLASSES];
+    PoolSlab *slabs;
+    UA_MemoryStatistics stats;
+} PoolCategory;
+
+typedef struct {
+    UA_Allocator a;
+    PoolCategory categories[UA_MEMORYCATEGORIES];
+} PoolAllocator;
+
+static size_t
+blockSize(UA_UInt32 sizeClass) {
+    return sizeof(PoolHeader) + ((size_t)1 << (POOLS_MINSHIFT + sizeClass));
+}
+
+static UA_UInt32
+getSizeClass(size_t size) {
+    UA_UInt32 sizeClass = 0;
+    while(((size_t)1 << (POOLS_MINSHIFT + sizeClass)) < size)
+        sizeClass++;
+    return sizeClass;
+}
+
+/* Take a block from the free list or from the current slab of the size
+ * class. Called with the lock held. */
+static PoolHeader *
+takeBlock(PoolCategory *pc, UA_UInt32 sizeClass) {
+    PoolHeader *hdr = pc->freeLists[sizeClass];
+    if(hdr) {
+        memcpy(&pc->freeLists[sizeClass], &hdr[1], sizeof(PoolHeader*));
+        return hdr;
+    }
+
+    size_t bs = blockSize(sizeClass);
+    if((size_t)(pc->slabEnd[sizeClass] - pc->slabPos[sizeClass]) < bs) {
+        PoolSlab *slab = (PoolSlab*)malloc(POOLS_SLABSIZE);
+        if(!slab)
+            return NULL;
+        slab->next = pc->slabs;
+        pc->slabs = slab;
+        pc->slabPos[sizeClass] = (UA_Byte*)&slab[1];
+        pc->slabEnd[sizeClass] = (UA_Byte*)slab + POOLS_SLABSIZE;
+        pc->stats.bytesReserved += POOLS_SLABSIZE;
+    }
+
+    hdr = (PoolHeader*)pc->slabPos[sizeClass];
+    pc->slabPos[sizeClass] += bs;
+    return hdr;
+}
+
+static void *
+Pools_malloc(UA_Allocator *a, UA_MemoryCategory category, size_t size) {
+    PoolAllocator *pa = (PoolAllocator*)a;
+    if((unsigned)category >= UA_MEMORYCATEGORIES)
+        category = UA_MEMORYCATEGORY_DEFAULT;
+    PoolCategory *pc = &pa->categories[category];
+
+    /* Large blocks directly from malloc */
+    PoolHeader *hdr;
+    UA_UInt32 sizeClass = POOLS_LARGE;
+    if(size > POOLS_MAXSIZE) {
+        if(size > SIZE_MAX - sizeof(PoolHeader))
+            return NULL;
+        hdr = (PoolHeader*)malloc(sizeof(PoolHeader) + size);
+        if(!hdr)
+            return NULL;
+        UA_LOCK(&pc->lock);
+        pc->stats.bytesReserved += sizeof(PoolHeader) + size;
+    } else {
+        sizeClass = getSizeClass(size);
+        UA_LOCK(&pc->lock);
+        hdr = takeBlock(pc, sizeClass);
+        if(!hdr) {
+            UA_UNLOCK(&pc->lock);
+            return NULL;
+        }
+    }
+
+    hdr->h.category = (UA_UInt32)category;
+    hdr->h.sizeClass = sizeClass;
+    hdr->h.size = size;
+    pc->stats.bytesInUse += size;
+    pc->stats.blocksInUse++;
+    pc->stats.allocations++;
+    UA_UNLOCK(&pc->lock);
+    return &hdr[1];
+}
+
+static void *
+Pools_calloc(UA_Allocator *a, UA_MemoryCategory category,
+             size_t nelem, size_t elsize) {
+    if(elsize > 0 && nelem > SIZE_MAX / elsize)
+        return NULL;
+    void *p = Pools_malloc(a, category, nelem * elsize);
+    if(p)
+        memset(p, 0, nelem * elsize);
+    return p;
+}
+
+static void
+Pools_free(UA_Allocator *a, void *ptr) {
+    if(!ptr)
+        return;
+    PoolAllocator *pa = (PoolAllocator*)a;
+    PoolHeader *hdr = &((PoolHeader*)ptr)[-1];
+    PoolCategory *pc = &pa->categories[hdr->h.category];
+
+    UA_LOCK(&pc->lock);
+    pc->stats.bytesInUse -= hdr->h.size;
+    pc->stats.blocksInUse--;
+    pc->stats.frees++;
+    if(hdr->h.sizeClass == POOLS_LARGE) {
+        pc->stats.bytesReserved -= sizeof(PoolHeader) + hdr->h.size;
+        UA_UNLOCK(&pc->lock);
+        free(hdr);
+        return;
+    }
+    memcpy(&hdr[1], &pc->freeLists[hdr->h.sizeClass], sizeof(PoolHeader*));
+    pc->freeLists[hdr->h.sizeClass] = hdr;
+    UA_UNLOCK(&pc->lock);
+}
+
+static void *
+Pools_realloc(UA_Allocator *a, UA_MemoryCategory category,
+              void *ptr, size_t size) {
+    if(!ptr)
+        return Pools_malloc(a, category, size);
+
+    PoolAllocator *pa = (PoolAllocator*)a;
+    PoolHeader *hdr = &((PoolHeader*)ptr)[-1];
+    PoolCategory *pc = &pa->categories[hdr->h.category];
+    size_t oldSize = hdr->h.size;
+
+    /* Stay in the size class */
+    if(hdr->h.sizeClass != POOLS_LARGE && size <= POOLS_MAXSIZE &&
+       getSizeClass(size) == hdr->h.sizeClass) {
+        UA_LOCK(&pc->lock);
+        pc->stats.bytesInUse -= oldSize;
+        pc->stats.bytesInUse += size;
+        hdr->h.size = size;
+        UA_UNLOCK(&pc->lock);
+        return ptr;
+    }
+
+    /* Large blocks are resized with realloc */
+    if(hdr->h.sizeClass == POOLS_LARGE && size > POOLS_MAXSIZE) {
+        if(size > SIZE_MAX - sizeof(PoolHeader))
+            return NULL;
+        PoolHeader *newHdr = (PoolHeader*)realloc(hdr, sizeof(PoolHeader) + size);
+        if(!newHdr)
+            return NULL;
+        UA_LOCK(&pc->lock);
+        pc->stats.bytesInUse -= oldSize;
+        pc->stats.bytesInUse += size;
+        pc->stats.bytesReserved -= oldSize;
+        pc->stats.bytesReserved += size;
+        newHdr->h.size = size;
+        UA_UNLOCK(&pc->lock);
+        return &newHdr[1];
+    }
+
+    /* Move to another block of the same category */
+    void *newPtr = Pools_malloc(a, (UA_MemoryCategory)hdr->h.category, size);
+    if(!newPtr)
+        return NULL;
+    memcpy(newPtr, ptr, (oldSize < size) ? oldSize : size);
+    Pools_free(a, ptr);
+    return newPtr;
+}
+
+static UA_StatusCode
+Pools_getStatistics(UA_Allocator *a, UA_MemoryCategory category,
+                    UA_MemoryStatistics *stats) {
+    if((unsigned)category >= UA_MEMORYCATEGORIES)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    PoolCategory *pc = &((PoolAllocator*)a)->categories[category];
+    UA_LOCK(&pc->lock);
+    *stats = pc->stats;
+    UA_UNLOCK(&pc->lock);
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Large blocks that are still in use are not tracked and not freed */
+static void
+Pools_clear(UA_Allocator *a) {
+    PoolAllocator *pa = (PoolAllocator*)a;
+    for(size_t i = 0; i < UA_MEMORYCATEGORIES; i++) {
+        PoolCategory *pc = &pa->categories[i];
+        PoolSlab *slab = pc->slabs;
+        while(slab) {
+            PoolSlab *next = slab->next;
+            free(slab);
+            slab = next;
+        }
+        UA_LOCK_DESTROY(&pc->lock);
+    }
+    free(pa);
+}
+
+UA_Allocator *
+UA_Allocator_Pools_new(void) {
+    PoolAllocator *pa = (PoolAllocator*)calloc(1, sizeof(PoolAllocator));
+    if(!pa)
+        return NULL;
+    for(size_t i = 0; i < UA_MEMORYCATEGORIES; i++) {
+        UA_LOCK_INIT(&pa->categories[i].lock);
+        UA_LOCK_SETRANK(&pa->categories[i].lock, UA_LOCKRANK_ALLOCATOR);
+    }
+    pa->a.context = pa;
+    pa->a.malloc = Pools_malloc;
+    pa->a.calloc = Pools_calloc;
+    pa->a.realloc = Pools_realloc;
+    pa->a.free = Pools_free;
+    pa->a.getStatistics = Pools_getStatistics;
+    pa->a.clear = Pools_clear;
+    return &pa->a;
+}
@@ -0,0 +1,148 @@
+/* This work is licensed under a Creative Commons CCZero 1.0 Universal License.
+ * See http://creativecommons.org/publicdomain/zero/1.0/ for more information.
+ */
+
+#include <open62541/plugin/allocator_tracking.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+/* The memory is taken from the system malloc. UA_malloc can be routed
+ * through this allocator and must not be used here. */
+
+/* The header keeps the alignment of malloc for the following user memory */
+typedef union {
+    struct {
+        UA_UInt32 category;
+        size_t size; /* Requested size */
+    } h;
+    UA_Byte align[16];
+} TrackingHeader;
+
+typedef struct {
+#if UA_MULTITHREADING >= 100
+    UA_Lock lock;
+#endif
+    UA_MemoryStatistics stats;
+} TrackingCategory;
+
+typedef struct {
+    UA_Allocator a;
+    TrackingCategory categories[UA_MEMORYCATEGORIES];
+} TrackingAllocator;
+
+static void
+addBlock(TrackingCategory *tc, size_t size) {
+    UA_LOCK(&tc->lock);
+    tc->stats.bytesInUse += size;
+    tc->stats.bytesReserved += sizeof(TrackingHeader) + size;
+    tc->stats.blocksInUse++;
+    tc->stats.allocations++;
+    UA_UNLOCK(&tc->lock);
+}
+
+static void *
+Tracking_malloc(UA_Allocator *a, UA_MemoryCategory category, size_t size) {
+    if((unsigned)category >= UA_MEMORYCATEGORIES)
+        category = UA_MEMORYCATEGORY_DEFAULT;
+    if(size > SIZE_MAX - sizeof(TrackingHeader))
+        return NULL;
+    TrackingHeader *hdr = (TrackingHeader*)malloc(sizeof(TrackingHeader) + size);
+    if(!hdr)
+        return NULL;
+    hdr->h.category = (UA_UInt32)category;
+    hdr->h.size = size;
+    addBlock(&((TrackingAllocator*)a)->categories[category], size);
+    return &hdr[1];
+}
+
+static void *
+Tracking_calloc(UA_Allocator *a, UA_MemoryCategory category,
+                size_t nelem, size_t elsize) {
+    if(elsize > 0 && nelem > SIZE_MAX / elsize)
+        return NULL;
+    void *p = Tracking_malloc(a, category, nelem * elsize);
+    if(p)
+        memset(p, 0, nelem * elsize);
+    return p;
+}
+
+static void
+Tracking_free(UA_Allocator *a, void *ptr) {
+    if(!ptr)
+        return;
+    TrackingHeader *hdr = &((TrackingHeader*)ptr)[-1];
+    TrackingCategory *tc = &((TrackingAllocator*)a)->categories[hdr->h.category];
+    UA_LOCK(&tc->lock);
+    tc->stats.bytesInUse -= hdr->h.size;
+    tc->stats.bytesReserved -= sizeof(TrackingHeader) + hdr->h.size;
+    tc->stats.blocksInUse--;
+    tc->stats.frees++;
+    UA_UNLOCK(&tc->lock);
+    free(hdr);
+}
+
+/* The block keeps its category */
+static void *
+Tracking_realloc(UA_Allocator *a, UA_MemoryCategory category,
+                 void *ptr, size_t size) {
+    if(!ptr)
+        return Tracking_malloc(a, category, size);
+    if(size > SIZE_MAX - sizeof(TrackingHeader))
+        return NULL;
+    TrackingHeader *hdr = &((TrackingHeader*)ptr)[-1];
+    size_t oldSize = hdr->h.size;
+    TrackingHeader *newHdr = (TrackingHeader*)
+        realloc(hdr, sizeof(TrackingHeader) + size);
+    if(!newHdr)
+        return NULL;
+    newHdr->h.size = size;
+    TrackingCategory *tc = &((TrackingAllocator*)a)->categories[newHdr->h.category];
+    UA_LOCK(&tc->lock);
+    tc->stats.bytesInUse -= oldSize;
+    tc->stats.bytesInUse += size;
+    tc->stats.bytesReserved -= oldSize;
+    tc->stats.bytesReserved += size;
+    UA_UNLOCK(&tc->lock);
+    return &newHdr[1];
+}
+
+static UA_StatusCode
+Tracking_getStatistics(UA_Allocator *a, UA_MemoryCategory category,
+                       UA_MemoryStatistics *stats) {
+    if((unsigned)category >= UA_MEMORYCATEGORIES)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    TrackingCategory *tc = &((TrackingAllocator*)a)->categories[category];
+    UA_LOCK(&tc->lock);
+    *stats = tc->stats;
+    UA_UNLOCK(&tc->lock);
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Blocks that are still in use are not tracked and not freed */
+static void
+Tracking_clear(UA_Allocator *a) {
+    TrackingAllocator *ta = (TrackingAllocator*)a;
+    for(size_t i = 0; i < UA_MEMORYCATEGORIES; i++)
+        UA_LOCK_DESTROY(&ta->categories[i].lock);
+    free(ta);
+}
+
+UA_Allocator *
+UA_Allocator_Tracking_new(void) {
+    TrackingAllocator *ta = (TrackingAllocator*)calloc(1, sizeof(TrackingAllocator));
+    if(!ta)
+        return NULL;
+    for(size_t i = 0; i < UA_MEMORYCATEGORIES; i++) {
+        UA_LOCK_INIT(&ta->categories[i].lock);
+        UA_LOCK_SETRANK(&ta->categories[i].lock, UA_LOCKRANK_ALLOCATOR);
+    }
+    ta->a.context = ta;
+    ta->a.malloc = Tracking_malloc;
+    ta->a.calloc = Tracking_calloc;
+    ta->a.realloc = Tracking_realloc;
+    ta->a.free = Tracking_free;
+    ta->a.getStatistics = Tracking_getStatistics;
+    ta->a.clear = Tracking_clear;
+    return &ta->a;
+}
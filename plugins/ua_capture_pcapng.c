@@ -0,0 +1,382 @@
+/* This work is licensed under a Creative Commons CCZero 1.0 Universal License.
+ * See http://creativecommons.org/publicdomain/zero/1.0/ for more information.
+ */
+
+#include <open62541/plugin/capture_pcapng.h>
+#include <open62541/types.h>
+
+#if (defined(__linux__) || defined(__unix__)) && UA_MULTITHREADING >= 100
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define PCAPNG_DEFAULTSIZE (1 << 20) /* 1MB */
+#define PCAPNG_INTERVAL_MS 10
+#define PCAPNG_CONNECTIONS 256
+
+/* pcapng block types and the raw IP link type */
+#define PCAPNG_SHB 0x0A0D0D0A
+#define PCAPNG_IDB 0x00000001
+#define PCAPNG_EPB 0x00000006
+#define PCAPNG_BYTEORDER 0x1A2B3C4D
+#define PCAPNG_LINKTYPE_RAW 101
+
+#define PCAPNG_EPB_LENGTH 32 /* Without the packet data */
+#define PCAPNG_IP_LENGTH 20
+#define PCAPNG_TCP_LENGTH 20
+#define PCAPNG_SEGMENT_MAX (65535 - PCAPNG_IP_LENGTH - PCAPNG_TCP_LENGTH)
+
+#define PCAPNG_SERVER_ADDR 0x7F000001 /* 127.0.0.1 */
+#define PCAPNG_CLIENT_ADDR 0x7F000002 /* 127.0.0.2 */
+#define PCAPNG_SERVER_PORT 4840
+
+/* TCP sequence numbers of a connection in both directions. Connections are
+ * mapped to the slots by their identifier. If two connections share a slot,
+ * the sequence numbers restart. Wireshark then shows a retransmission or a
+ * gap but still dissects the packets. */
+typedef struct {
+    uintptr_t connectionId;
+    UA_Boolean used;
+    UA_UInt32 serverSeq;
+    UA_UInt32 clientSeq;
+} PcapngConnection;
+
+typedef struct {
+    UA_PacketCapture pc;
+    FILE *file;
+
+    /* Double buffering. The capture callback appends to the active buffer.
+     * The background thread swaps the buffers and writes out the inactive one
+     * outside of the critical section. */
+    UA_Byte *active;
+    UA_Byte *inactive;
+    size_t bufferSize;
+    size_t activePos;
+    size_t activeChunks;
+
+    PcapngConnection connections[PCAPNG_CONNECTIONS];
+
+    /* Statistics */
+    size_t captured;
+    size_t dropped;
+    size_t written;
+
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    UA_Boolean running;
+} PcapngContext;
+
+static void
+writeUInt16BE(UA_Byte *pos, UA_UInt16 v) {
+    pos[0] = (UA_Byte)(v >> 8);
+    pos[1] = (UA_Byte)v;
+}
+
+static void
+writeUInt32BE(UA_Byte *pos, UA_UInt32 v) {
+    pos[0] = (UA_Byte)(v >> 24);
+    pos[1] = (UA_Byte)(v >> 16);
+    pos[2] = (UA_Byte)(v >> 8);
+    pos[3] = (UA_Byte)v;
+}
+
+static void
+writeUInt32LE(UA_Byte *pos, UA_UInt32 v) {
+    pos[0] = (UA_Byte)v;
+    pos[1] = (UA_Byte)(v >> 8);
+    pos[2] = (UA_Byte)(v >> 16);
+    pos[3] = (UA_Byte)(v >> 24);
+}
+
+/* The pcapng blocks use the byte order of the writer */
+static void
+writeUInt32(UA_Byte *pos, UA_UInt32 v) {
+    memcpy(pos, &v, sizeof(UA_UInt32));
+}
+
+static UA_UInt16
+ipChecksum(const UA_Byte *header) {
+    UA_UInt32 sum = 0;
+    for(size_t i = 0; i < PCAPNG_IP_LENGTH; i += 2)
+        sum += (UA_UInt32)((header[i] << 8) | header[i+1]);
+    while(sum >> 16)
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    return (UA_UInt16)~sum;
+}
+
+static PcapngConnection *
+getConnection(PcapngContext *ctx, uintptr_t connectionId) {
+    PcapngConnection *c = &ctx->connections[connectionId % PCAPNG_CONNECTIONS];
+    if(!c->used || c->connectionId != connectionId) {
+        c->used = true;
+        c->connectionId = connectionId;
+        c->serverSeq = 1;
+        c->clientSeq = 1;
+    }
+    return c;
+}
+
+/* Encode one segment as an Enhanced Packet Block. Returns the block length. */
+static size_t
+encodeSegment(UA_Byte *pos, UA_UInt64 timestamp, uintptr_t connectionId,
+              UA_Boolean sent, UA_UInt32 seq, UA_UInt32 ack,
+              const UA_Byte *payload, size_t payloadLength) {
+    size_t packetLength = PCAPNG_IP_LENGTH + PCAPNG_TCP_LENGTH + payloadLength;
+    size_t paddedLength = (packetLength + 3) & ~(size_t)3;
+    size_t blockLength = PCAPNG_EPB_LENGTH + paddedLength;
+
+    /* Block header */
+    writeUInt32(pos, PCAPNG_EPB);
+    writeUInt32(&pos[4], (UA_UInt32)blockLength);
+    writeUInt32(&pos[8], 0); /* Interface */
+    writeUInt32(&pos[12], (UA_UInt32)(timestamp >> 32));
+    writeUInt32(&pos[16], (UA_UInt32)timestamp);
+    writeUInt32(&pos[20], (UA_UInt32)packetLength);
+    writeUInt32(&pos[24], (UA_UInt32)packetLength);
+    UA_Byte *ip = &pos[28];
+
+    /* IPv4 header */
+    UA_UInt32 serverAddr = PCAPNG_SERVER_ADDR;
+    UA_UInt32 clientAddr = PCAPNG_CLIENT_ADDR;
+    memset(ip, 0, PCAPNG_IP_LENGTH);
+    ip[0] = 0x45; /* Version 4, 5 words */
+    writeUInt16BE(&ip[2], (UA_UInt16)packetLength);
+    writeUInt16BE(&ip[6], 0x4000); /* Don't fragment */
+    ip[8] = 64; /* TTL */
+    ip[9] = 6;  /* TCP */
+    writeUInt32BE(&ip[12], sent ? serverAddr : clientAddr);
+    writeUInt32BE(&ip[16], sent ? clientAddr : serverAddr);
+    writeUInt16BE(&ip[10], ipChecksum(ip));
+
+    /* TCP header. The checksum is left empty. Wireshark does not validate it
+     * by default. */
+    UA_Byte *tcp = &ip[PCAPNG_IP_LENGTH];
+    UA_UInt16 clientPort = (UA_UInt16)(1024 + (connectionId % (65536 - 1024)));
+    memset(tcp, 0, PCAPNG_TCP_LENGTH);
+    writeUInt16BE(tcp, sent ? PCAPNG_SERVER_PORT : clientPort);
+    writeUInt16BE(&tcp[2], sent ? clientPort : PCAPNG_SERVER_PORT);
+    writeUInt32BE(&tcp[4], seq);
+    writeUInt32BE(&tcp[8], ack);
+    tcp[12] = 0x50; /* 5 words */
+    tcp[13] = 0x18; /* PSH, ACK */
+    writeUInt16BE(&tcp[14], 0xFFFF); /* Window */
+
+    /* Payload and padding */
+    memcpy(&tcp[PCAPNG_TCP_LENGTH], payload, payloadLength);
+    memset(&ip[packetLength], 0, paddedLength - packetLength);
+
+    writeUInt32(&pos[blockLength - 4], (UA_UInt32)blockLength);
+    return blockLength;
+}
+
+static void
+UA_PacketCapture_Pcapng_capture(UA_PacketCapture *pc, uintptr_t connectionId,
+                                UA_Boolean sent, const UA_ByteString *chunk) {
+    PcapngContext *ctx = (PcapngContext*)pc;
+    if(chunk->length == 0)
+        return;
+
+    /* Microseconds since 1970 (the default resolution in pcapng) */
+    UA_UInt64 timestamp = (UA_UInt64)
+        ((UA_DateTime_now() - UA_DATETIME_UNIX_EPOCH) / UA_DATETIME_USEC);
+
+    /* Required space for all segments */
+    size_t segments = (chunk->length + PCAPNG_SEGMENT_MAX - 1) / PCAPNG_SEGMENT_MAX;
+    size_t required = (segments * (PCAPNG_EPB_LENGTH + PCAPNG_IP_LENGTH +
+                                   PCAPNG_TCP_LENGTH + 3)) + chunk->length;
+
+    pthread_mutex_lock(&ctx->mutex);
+    if(ctx->activePos + required > ctx->bufferSize) {
+        ctx->dropped++;
+        pthread_mutex_unlock(&ctx->mutex);
+        return;
+    }
+
+    UA_Byte *begin = &ctx->active[ctx->activePos];
+    PcapngConnection *c = getConnection(ctx, connectionId);
+    UA_UInt32 *seq = sent ? &c->serverSeq : &c->clientSeq;
+    UA_UInt32 ack = sent ? c->clientSeq : c->serverSeq;
+    for(size_t offset = 0; offset < chunk->length; offset += PCAPNG_SEGMENT_MAX) {
+        size_t len = chunk->length - offset;
+        if(len > PCAPNG_SEGMENT_MAX)
+            len = PCAPNG_SEGMENT_MAX;
+        ctx->activePos +=
+            encodeSegment(&ctx->active[ctx->activePos], timestamp, connectionId,
+                          sent, *seq, ack, &chunk->data[offset], len);
+        *seq += (UA_UInt32)len;
+    }
+
+    /* Set the MessageSize to the captured length. The padding and signature
+     * were removed and the dissector reassembles the chunk from the
+     * MessageSize. The first segment is 28 bytes into the EPB. */
+    if(chunk->length >= 8)
+        writeUInt32LE(&begin[28 + PCAPNG_IP_LENGTH + PCAPNG_TCP_LENGTH + 4],
+                      (UA_UInt32)chunk->length);
+
+    ctx->activeChunks++;
+    ctx->captured++;
+
+    /* Wake up the writer early if the buffer is filling up */
+    if(ctx->activePos > ctx->bufferSize / 2)
+        pthread_cond_signal(&ctx->cond);
+    pthread_mutex_unlock(&ctx->mutex);
+}
+
+/* Swap the buffers and write out. Returns the number of written chunks. The
+ * mutex is held when called and held again when returning. */
+static size_t
+writeBuffer(PcapngContext *ctx) {
+    if(ctx->activePos == 0)
+        return 0;
+
+    UA_Byte *buf = ctx->active;
+    size_t len = ctx->activePos;
+    size_t chunks = ctx->activeChunks;
+    ctx->active = ctx->inactive;
+    ctx->inactive = buf;
+    ctx->activePos = 0;
+    ctx->activeChunks = 0;
+
+    pthread_mutex_unlock(&ctx->mutex);
+    fwrite(buf, 1, len, ctx->file);
+    fflush(ctx->file);
+    pthread_mutex_lock(&ctx->mutex);
+
+    ctx->written += chunks;
+    return chunks;
+}
+
+static void *
+pcapngThread(void *context) {
+    PcapngContext *ctx = (PcapngContext*)context;
+    pthread_mutex_lock(&ctx->mutex);
+    while(ctx->running) {
+        if(writeBuffer(ctx) > 0)
+            continue;
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += PCAPNG_INTERVAL_MS * 1000000;
+        if(ts.tv_nsec >= 1000000000) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000;
+        }
+        pthread_cond_timedwait(&ctx->cond, &ctx->mutex, &ts);
+    }
+
+    /* Write the packets captured until the stop */
+    writeBuffer(ctx);
+    pthread_mutex_unlock(&ctx->mutex);
+    return NULL;
+}
+
+void
+UA_PacketCapture_Pcapng_flush(UA_PacketCapture *pc) {
+    PcapngContext *ctx = (PcapngContext*)pc;
+    pthread_mutex_lock(&ctx->mutex);
+    size_t target = ctx->captured;
+    while(ctx->written < target) {
+        pthread_cond_signal(&ctx->cond);
+        pthread_mutex_unlock(&ctx->mutex);
+        struct timespec ts = {0, 1000000}; /* 1ms */
+        nanosleep(&ts, NULL);
+        pthread_mutex_lock(&ctx->mutex);
+    }
+    pthread_mutex_unlock(&ctx->mutex);
+}
+
+void
+UA_PacketCapture_Pcapng_getStatistics(UA_PacketCapture *pc, size_t *captured,
+                                      size_t *dropped) {
+    PcapngContext *ctx = (PcapngContext*)pc;
+    pthread_mutex_lock(&ctx->mutex);
+    *captured = ctx->captured;
+    *dropped = ctx->dropped;
+    pthread_mutex_unlock(&ctx->mutex);
+}
+
+static void
+UA_PacketCapture_Pcapng_clear(UA_PacketCapture *pc) {
+    PcapngContext *ctx = (PcapngContext*)pc;
+    pc->enabled = false;
+    pthread_mutex_lock(&ctx->mutex);
+    ctx->running = false;
+    pthread_cond_signal(&ctx->cond);
+    pthread_mutex_unlock(&ctx->mutex);
+    pthread_join(ctx->thread, NULL);
+
+    pthread_cond_destroy(&ctx->cond);
+    pthread_mutex_destroy(&ctx->mutex);
+    fclose(ctx->file);
+    UA_free(ctx->active);
+    UA_free(ctx->inactive);
+    UA_free(ctx);
+}
+
+/* Section Header Block and Interface Description Block */
+static UA_Boolean
+writeFileHeader(FILE *file) {
+    UA_Byte header[28 + 20];
+    writeUInt32(header, PCAPNG_SHB);
+    writeUInt32(&header[4], 28);
+    writeUInt32(&header[8], PCAPNG_BYTEORDER);
+    UA_UInt16 version[2] = {1, 0}; /* Major and minor version */
+    memcpy(&header[12], version, sizeof(version));
+    memset(&header[16], 0xFF, 8); /* Section length unknown */
+    writeUInt32(&header[24], 28);
+
+    UA_Byte *idb = &header[28];
+    writeUInt32(idb, PCAPNG_IDB);
+    writeUInt32(&idb[4], 20);
+    UA_UInt16 linkType = PCAPNG_LINKTYPE_RAW;
+    memcpy(&idb[8], &linkType, 2);
+    memset(&idb[10], 0, 2);
+    writeUInt32(&idb[12], 65535); /* Snap length */
+    writeUInt32(&idb[16], 20);
+
+    return (fwrite(header, 1, sizeof(header), file) == sizeof(header) &&
+            fflush(file) == 0);
+}
+
+UA_PacketCapture *
+UA_PacketCapture_Pcapng_new(const char *filename, size_t bufferSize) {
+    if(bufferSize == 0)
+        bufferSize = PCAPNG_DEFAULTSIZE;
+
+    PcapngContext *ctx = (PcapngContext*)UA_calloc(1, sizeof(PcapngContext));
+    if(!ctx)
+        return NULL;
+    ctx->active = (UA_Byte*)UA_malloc(bufferSize);
+    ctx->inactive = (UA_Byte*)UA_malloc(bufferSize);
+    ctx->file = fopen(filename, "wb");
+    if(!ctx->active || !ctx->inactive || !ctx->file ||
+       !writeFileHeader(ctx->file))
+        goto error;
+
+    ctx->bufferSize = bufferSize;
+    ctx->running = true;
+    pthread_mutex_init(&ctx->mutex, NULL);
+    pthread_cond_init(&ctx->cond, NULL);
+    if(pthread_create(&ctx->thread, NULL, pcapngThread, ctx) != 0) {
+        pthread_cond_destroy(&ctx->cond);
+        pthread_mutex_destroy(&ctx->mutex);
+        goto error;
+    }
+
+    ctx->pc.capture = UA_PacketCapture_Pcapng_capture;
+    ctx->pc.clear = UA_PacketCapture_Pcapng_clear;
+    ctx->pc.enabled = true;
+    return &ctx->pc;
+
+ error:
+    if(ctx->file)
+        fclose(ctx->file);
+    UA_free(ctx->active);
+    UA_free(ctx->inactive);
+    UA_free(ctx);
+    return NULL;
+}
+
+#endif
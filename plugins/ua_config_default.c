@@ -307,6 +307,12 @@ setDefaultConfig(UA_ServerConfig *conf, UA_UInt16 portNumber) {
             UA_ConnectionManager_new_POSIX_Ethernet(UA_STRING("eth connection manager"));
         if(ethCM)
             conf->eventLoop->registerEventSource(conf->eventLoop, (UA_EventSource *)ethCM);
+
+        /* Add the shared-memory connection manager */
+        UA_ConnectionManager *shmCM =
+            UA_ConnectionManager_new_POSIX_SHM(UA_STRING("shm connection manager"));
+        if(shmCM)
+            conf->eventLoop->registerEventSource(conf->eventLoop, (UA_EventSource *)shmCM);
 #endif
 
         /* Add the interrupt manager */
@@ -458,6 +464,9 @@ setDefaultConfig(UA_ServerConfig *conf, UA_UInt16 portNumber) {
     conf->maxNotificationsPerPublish = 1000;
     conf->enableRetransmissionQueue = true;
     conf->maxRetransmissionQueueSize = 0; /* unlimited */
+    conf->maxRetransmissionQueueBytes = 0; /* unlimited */
+    conf->maxRetransmissionBytes = 0; /* unlimited */
+    conf->notificationPoolSize = 1024;
 # ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
     conf->maxEventsPerNode = 0; /* unlimited */
 # endif
@@ -465,6 +474,7 @@ setDefaultConfig(UA_ServerConfig *conf, UA_UInt16 portNumber) {
     /* Limits for MonitoredItems */
     conf->samplingIntervalLimits = UA_DURATIONRANGE(50.0, 24.0 * 3600.0 * 1000.0);
     conf->queueSizeLimits = UA_UINT32RANGE(1, 100);
+    conf->monitoredItemsBatchThreshold = 1000;
 #endif
 
 #ifdef UA_ENABLE_DISCOVERY
@@ -1533,6 +1543,14 @@ UA_ClientConfig_setDefault(UA_ClientConfig *config) {
         UA_ConnectionManager *udpCM =
             UA_ConnectionManager_new_POSIX_UDP(UA_STRING("udp connection manager"));
         config->eventLoop->registerEventSource(config->eventLoop, (UA_EventSource *)udpCM);
+
+#ifdef __linux__
+        /* Add the shared-memory connection manager */
+        UA_ConnectionManager *shmCM =
+            UA_ConnectionManager_new_POSIX_SHM(UA_STRING("shm connection manager"));
+        if(shmCM)
+            config->eventLoop->registerEventSource(config->eventLoop, (UA_EventSource *)shmCM);
+#endif
     }
 
     if(config->localConnectionConfig.recvBufferSize == 0)
@@ -497,6 +497,10 @@ PARSE_JSON(SubscriptionConfigurationField) {
                 parseJsonJumpTable[UA_SERVERCONFIGFIELD_BOOLEAN](ctx, &config->enableRetransmissionQueue, NULL);
             else if(strcmp(field_str, "maxRetransmissionQueueSize") == 0)
                 parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT32](ctx, &config->maxRetransmissionQueueSize, NULL);
+            else if(strcmp(field_str, "maxRetransmissionQueueBytes") == 0)
+                parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT32](ctx, &config->maxRetransmissionQueueBytes, NULL);
+            else if(strcmp(field_str, "maxRetransmissionBytes") == 0)
+                parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT32](ctx, &config->maxRetransmissionBytes, NULL);
 # ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
             else if(strcmp(field_str, "maxEventsPerNode") == 0)
                 parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT32](ctx, &config->maxEventsPerNode, NULL);
@@ -570,6 +574,8 @@ PARSE_JSON(PubsubConfigurationField) {
 #ifdef UA_ENABLE_PUBSUB_INFORMATIONMODEL
             else if(strcmp(field_str, "enableInformationModelMethods") == 0)
                 parseJsonJumpTable[UA_SERVERCONFIGFIELD_BOOLEAN](ctx, &field->enableInformationModelMethods, NULL);
+            else if(strcmp(field_str, "lazyInformationModel") == 0)
+                parseJsonJumpTable[UA_SERVERCONFIGFIELD_BOOLEAN](ctx, &field->lazyInformationModel, NULL);
 #endif
             else {
                 UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND, "Unknown field name.");
@@ -872,9 +878,28 @@ static UA_StatusCode
 parseJSONConfig(UA_ServerConfig *config, UA_ByteString json_config) {
     // Parsing json config
     const char *json = (const char*)json_config.data;
-    cj5_token tokens[MAX_TOKENS];
+    cj5_token stackTokens[MAX_TOKENS];
+    cj5_token *tokens = stackTokens;
     cj5_result r = cj5_parse(json, (unsigned int)json_config.length, tokens, MAX_TOKENS, NULL);
 
+    /* Large configurations need more tokens than fit on the stack. The parser
+     * has counted them. Allocate and parse again. */
+    if(r.error == CJ5_ERROR_OVERFLOW) {
+        tokens = (cj5_token*)UA_malloc(sizeof(cj5_token) * r.num_tokens);
+        if(!tokens)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        r = cj5_parse(json, (unsigned int)json_config.length,
+                      tokens, r.num_tokens, NULL);
+    }
+    if(r.error != CJ5_ERROR_NONE) {
+        UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                     "Invalid json config in line %u, column %u",
+                     r.error_line, r.error_col);
+        if(tokens != stackTokens)
+            UA_free(tokens);
+        return UA_STATUSCODE_BADDECODINGERROR;
+    }
+
     ParsingCtx ctx;
     ctx.json = json;
     ctx.result = r;
@@ -996,7 +1021,7 @@ parseJSONConfig(UA_ServerConfig *config, UA_ByteString json_config) {
                 UA_free(field);
                 if(retval != UA_STATUSCODE_GOOD) {
                     UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND, "An error occurred while parsing the configuration file.");
-                    return retval;
+                    goto cleanup;
                 }
                 break;
             }
@@ -1005,6 +1030,10 @@ parseJSONConfig(UA_ServerConfig *config, UA_ByteString json_config) {
         }
         ctx.index += 1;
     }
+
+ cleanup:
+    if(tokens != stackTokens)
+        UA_free(tokens);
     return retval;
 }
 
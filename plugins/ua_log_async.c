@@ -0,0 +1,268 @@
+/* This work is licensed under a Creative Commons CCZero 1.0 Universal License.
+ * See http://creativecommons.org/publicdomain/zero/1.0/ for more information.
+ */
+
+#include <open62541/plugin/log_async.h>
+#include <open62541/types.h>
+
+#if (defined(__linux__) || defined(__unix__)) && UA_MULTITHREADING >= 100
+
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "mp_printf.h"
+
+#define ANSI_COLOR_RED     "\x1b[31m"
+#define ANSI_COLOR_GREEN   "\x1b[32m"
+#define ANSI_COLOR_YELLOW  "\x1b[33m"
+#define ANSI_COLOR_MAGENTA "\x1b[35m"
+#define ANSI_COLOR_RESET   "\x1b[0m"
+
+static const char *
+asyncLogLevelNames[6] = {"trace", "debug",
+                         ANSI_COLOR_GREEN "info",
+                         ANSI_COLOR_YELLOW "warn",
+                         ANSI_COLOR_RED "error",
+                         ANSI_COLOR_MAGENTA "fatal"};
+static const char *
+asyncLogCategoryNames[UA_LOGCATEGORIES] =
+    {"network", "channel", "session", "server", "client",
+     "userland", "securitypolicy", "eventloop", "pubsub", "discovery"};
+
+#define ASYNC_LOG_MSGSIZE 512
+#define ASYNC_LOG_DEFAULTSIZE 1024
+#define ASYNC_LOG_INTERVAL_MS 10
+
+/* Bounded multi-producer single-consumer ring buffer. Every slot carries a
+ * sequence number. A producer claims the position pos with a compare-and-swap
+ * of the tail if the sequence of the slot equals pos (free). After writing the
+ * slot, the sequence is set to pos+1 (published). The consumer reads the slot
+ * at the head position once it is published and then frees it for the next
+ * round by setting the sequence to head+capacity. */
+typedef struct {
+    size_t sequence;
+    UA_DateTime timestamp;
+    UA_LogLevel level;
+    UA_LogCategory category;
+    char msg[ASYNC_LOG_MSGSIZE];
+} AsyncLogSlot;
+
+typedef struct {
+    UA_LogLevel minLevel;
+
+    AsyncLogSlot *slots;
+    size_t capacity; /* Power of two */
+    size_t tail;     /* Next position for the producers */
+    size_t head;     /* Next position for the consumer */
+
+    /* Statistics */
+    size_t written;
+    size_t dropped;
+    size_t droppedReported;
+
+    /* Background thread. The mutex and condition are only used to wake up
+     * the background thread early. Not for logging. */
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    UA_Boolean running;
+} AsyncLogContext;
+
+#define LOAD(x) __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define STORE(x, v) __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+
+#ifdef __clang__
+__attribute__((__format__(__printf__, 4 , 0)))
+#endif
+static void
+UA_Log_Async_log(void *context, UA_LogLevel level, UA_LogCategory category,
+                 const char *msg, va_list args) {
+    AsyncLogContext *ctx = (AsyncLogContext*)context;
+    if(ctx->minLevel > level)
+        return;
+
+    /* Claim a slot */
+    AsyncLogSlot *slot;
+    size_t pos = __atomic_load_n(&ctx->tail, __ATOMIC_RELAXED);
+    for(;;) {
+        slot = &ctx->slots[pos & (ctx->capacity - 1)];
+        size_t seq = LOAD(slot->sequence);
+        if(seq == pos) {
+            if(__atomic_compare_exchange_n(&ctx->tail, &pos, pos + 1, true,
+                                           __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        } else if((ptrdiff_t)(seq - pos) < 0) {
+            /* The ring buffer is full */
+            __atomic_fetch_add(&ctx->dropped, 1, __ATOMIC_RELAXED);
+            return;
+        } else {
+            pos = __atomic_load_n(&ctx->tail, __ATOMIC_RELAXED);
+        }
+    }
+
+    /* Format into the slot and publish */
+    slot->timestamp = UA_DateTime_now();
+    slot->level = level;
+    slot->category = category;
+    mp_vsnprintf(slot->msg, ASYNC_LOG_MSGSIZE, msg, args);
+    STORE(slot->sequence, pos + 1);
+}
+
+static void
+writeMessage(UA_DateTime timestamp, UA_LogLevel level,
+             UA_LogCategory category, const char *msg) {
+    UA_Int64 tOffset = UA_DateTime_localTimeUtcOffset();
+    UA_DateTimeStruct dts = UA_DateTime_toStruct(timestamp + tOffset);
+
+    int logLevelSlot = ((int)level / 100) - 1;
+    if(logLevelSlot < 0 || logLevelSlot > 5)
+        logLevelSlot = 5; /* Set to fatal if the level is outside the range */
+
+    printf("[%04u-%02u-%02u %02u:%02u:%02u.%03u (UTC%+05d)] %s/%s" ANSI_COLOR_RESET "\t%s\n",
+           dts.year, dts.month, dts.day, dts.hour, dts.min, dts.sec, dts.milliSec,
+           (int)(tOffset / UA_DATETIME_SEC / 36), asyncLogLevelNames[logLevelSlot],
+           asyncLogCategoryNames[category], msg);
+}
+
+/* Write all published messages. Returns the number of written messages. */
+static size_t
+drain(AsyncLogContext *ctx) {
+    size_t count = 0;
+    size_t head = ctx->head;
+    for(;;) {
+        AsyncLogSlot *slot = &ctx->slots[head & (ctx->capacity - 1)];
+        if(LOAD(slot->sequence) != head + 1)
+            break;
+        writeMessage(slot->timestamp, slot->level, slot->category, slot->msg);
+        STORE(slot->sequence, head + ctx->capacity);
+        head++;
+        count++;
+    }
+
+    /* Report the dropped messages once there is space again */
+    size_t dropped = LOAD(ctx->dropped);
+    UA_Boolean reportDropped = (dropped != ctx->droppedReported);
+    if(reportDropped) {
+        char buf[64];
+        mp_snprintf(buf, sizeof(buf), "%lu log messages dropped",
+                    (unsigned long)(dropped - ctx->droppedReported));
+        writeMessage(UA_DateTime_now(), UA_LOGLEVEL_WARNING,
+                     UA_LOGCATEGORY_USERLAND, buf);
+        ctx->droppedReported = dropped;
+    }
+
+    if(count > 0 || reportDropped)
+        fflush(stdout);
+    if(count > 0) {
+        STORE(ctx->written, ctx->written + count);
+        STORE(ctx->head, head);
+    }
+    return count;
+}
+
+static void *
+asyncLogThread(void *context) {
+    AsyncLogContext *ctx = (AsyncLogContext*)context;
+    for(;;) {
+        if(drain(ctx) > 0)
+            continue;
+        pthread_mutex_lock(&ctx->mutex);
+        if(!ctx->running) {
+            pthread_mutex_unlock(&ctx->mutex);
+            break;
+        }
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += ASYNC_LOG_INTERVAL_MS * 1000000;
+        if(ts.tv_nsec >= 1000000000) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000;
+        }
+        pthread_cond_timedwait(&ctx->cond, &ctx->mutex, &ts);
+        pthread_mutex_unlock(&ctx->mutex);
+    }
+
+    /* Write the messages logged until the stop */
+    drain(ctx);
+    return NULL;
+}
+
+void
+UA_Log_Async_flush(const UA_Logger *logger) {
+    AsyncLogContext *ctx = (AsyncLogContext*)logger->context;
+    size_t target = LOAD(ctx->tail);
+    while((ptrdiff_t)(LOAD(ctx->head) - target) < 0) {
+        pthread_mutex_lock(&ctx->mutex);
+        pthread_cond_signal(&ctx->cond);
+        pthread_mutex_unlock(&ctx->mutex);
+        struct timespec ts = {0, 1000000}; /* 1ms */
+        nanosleep(&ts, NULL);
+    }
+}
+
+void
+UA_Log_Async_getStatistics(const UA_Logger *logger, size_t *written,
+                           size_t *dropped) {
+    AsyncLogContext *ctx = (AsyncLogContext*)logger->context;
+    *written = LOAD(ctx->written);
+    *dropped = LOAD(ctx->dropped);
+}
+
+static void
+UA_Log_Async_clear(UA_Logger *logger) {
+    AsyncLogContext *ctx = (AsyncLogContext*)logger->context;
+    pthread_mutex_lock(&ctx->mutex);
+    ctx->running = false;
+    pthread_cond_signal(&ctx->cond);
+    pthread_mutex_unlock(&ctx->mutex);
+    pthread_join(ctx->thread, NULL);
+
+    pthread_cond_destroy(&ctx->cond);
+    pthread_mutex_destroy(&ctx->mutex);
+    UA_free(ctx->slots);
+    UA_free(ctx);
+    UA_free(logger);
+}
+
+UA_Logger *
+UA_Log_Async_new(UA_LogLevel minlevel, size_t bufferSize) {
+    if(bufferSize == 0)
+        bufferSize = ASYNC_LOG_DEFAULTSIZE;
+    size_t capacity = 1;
+    while(capacity < bufferSize)
+        capacity <<= 1;
+
+    UA_Logger *logger = (UA_Logger*)UA_malloc(sizeof(UA_Logger));
+    AsyncLogContext *ctx = (AsyncLogContext*)UA_calloc(1, sizeof(AsyncLogContext));
+    AsyncLogSlot *slots = (AsyncLogSlot*)UA_malloc(capacity * sizeof(AsyncLogSlot));
+    if(!logger || !ctx || !slots)
+        goto error;
+
+    for(size_t i = 0; i < capacity; i++)
+        slots[i].sequence = i;
+    ctx->minLevel = minlevel;
+    ctx->slots = slots;
+    ctx->capacity = capacity;
+    ctx->running = true;
+    pthread_mutex_init(&ctx->mutex, NULL);
+    pthread_cond_init(&ctx->cond, NULL);
+    if(pthread_create(&ctx->thread, NULL, asyncLogThread, ctx) != 0) {
+        pthread_cond_destroy(&ctx->cond);
+        pthread_mutex_destroy(&ctx->mutex);
+        goto error;
+    }
+
+    logger->log = UA_Log_Async_log;
+    logger->context = ctx;
+    logger->clear = UA_Log_Async_clear;
+    return logger;
+
+ error:
+    UA_free(slots);
+    UA_free(ctx);
+    UA_free(logger);
+    return NULL;
+}
+
+#endif
@@ -48,7 +48,7 @@ logCategoryNames[UA_LOGCATEGORIES] =
  * Use a spinlock on non-POSIX as we cannot statically initialize a global lock. */
 #if UA_MULTITHREADING >= 100
 # ifdef UA_ARCHITECTURE_POSIX
-UA_Lock logLock = UA_LOCK_STATIC_INIT;
+UA_Lock logLock = UA_LOCK_STATIC_INIT_RANK(UA_LOCKRANK_LOG);
 # else
 void * volatile logSpinLock = NULL;
 static UA_INLINE void spinLock(void) {
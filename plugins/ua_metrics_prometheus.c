@@ -0,0 +1,716 @@
+/* This work is licensed under a Creative Commons CCZero 1.0 Universal License.
+ * See http://creativecommons.org/publicdomain/zero/1.0/ for more information.
+ */
+
+#include <open62541/plugin/metrics_prometheus.h>
+#include <open62541/plugin/allocator.h>
+
+#include "open62541_queue.h"
+#include "mp_printf.h"
+
+#include <stdarg.h>
+#include <string.h>
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+# define UA_METRICS_MALLINFO2
+# include <malloc.h>
+#endif
+
+#define UA_METRICS_MAXLISTENSOCKETS 8
+#define UA_METRICS_MAXCONNECTIONS 16
+#define UA_METRICS_MAXREQUESTSIZE 8192
+#define UA_METRICS_INITIALBUFSIZE 4096
+#define UA_METRICS_MINSENDSIZE 512
+
+/*****************/
+/* Output Buffer */
+/*****************/
+
+typedef struct {
+    UA_String out;
+    size_t capacity;
+    UA_StatusCode res;
+} MetricsBuffer;
+
+#ifdef __clang__
+__attribute__((__format__(__printf__, 2 , 3)))
+#endif
+static void
+appendf(MetricsBuffer *mb, const char *format, ...) {
+    if(mb->res != UA_STATUSCODE_GOOD)
+        return;
+    for(int i = 0; i < 2; i++) {
+        size_t remaining = mb->capacity - mb->out.length;
+        va_list args;
+        va_start(args, format);
+        int len = mp_vsnprintf((char*)mb->out.data + mb->out.length,
+                               remaining, format, args);
+        va_end(args);
+        if(len < 0) {
+            mb->res = UA_STATUSCODE_BADINTERNALERROR;
+            return;
+        }
+        if((size_t)len < remaining) {
+            mb->out.length += (size_t)len;
+            return;
+        }
+
+        /* Grow the buffer and try again. Leave room for the terminating
+         * null character written by mp_vsnprintf. */
+        size_t newCapacity = mb->capacity * 2;
+        if(newCapacity < mb->out.length + (size_t)len + 1)
+            newCapacity = mb->out.length + (size_t)len + 1;
+        UA_Byte *data = (UA_Byte*)UA_realloc(mb->out.data, newCapacity);
+        if(!data) {
+            mb->res = UA_STATUSCODE_BADOUTOFMEMORY;
+            return;
+        }
+        mb->out.data = data;
+        mb->capacity = newCapacity;
+    }
+}
+
+static void
+printHeader(MetricsBuffer *mb, const char *name,
+            const char *type, const char *help) {
+    appendf(mb, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+static void
+printMetric(MetricsBuffer *mb, const char *name, const char *type,
+            const char *help, UA_UInt64 value) {
+    printHeader(mb, name, type, help);
+    appendf(mb, "%s %llu\n", name, (unsigned long long)value);
+}
+
+/* Durations are exported in seconds */
+static void
+printSeconds(MetricsBuffer *mb, const char *name, const char *type,
+             const char *help, UA_DateTime duration) {
+    printHeader(mb, name, type, help);
+    appendf(mb, "%s %.7f\n", name, (UA_Double)duration / UA_DATETIME_SEC);
+}
+
+/*****************/
+/* Print Metrics */
+/*****************/
+
+static void
+printSecureChannelMetrics(MetricsBuffer *mb, const UA_ServerStatistics *stats) {
+    const UA_SecureChannelStatistics *scs = &stats->scs;
+    printMetric(mb, "opcua_secure_channels", "gauge",
+                "Currently open SecureChannels", scs->currentChannelCount);
+    printMetric(mb, "opcua_secure_channels_opened_total", "counter",
+                "SecureChannels opened since the server start",
+                scs->cumulatedChannelCount);
+    printHeader(mb, "opcua_secure_channels_closed_total", "counter",
+                "SecureChannels closed for a reason other than a regular close");
+    appendf(mb, "opcua_secure_channels_closed_total{reason=\"rejected\"} %llu\n"
+            "opcua_secure_channels_closed_total{reason=\"timeout\"} %llu\n"
+            "opcua_secure_channels_closed_total{reason=\"abort\"} %llu\n"
+            "opcua_secure_channels_closed_total{reason=\"purge\"} %llu\n",
+            (unsigned long long)scs->rejectedChannelCount,
+            (unsigned long long)scs->channelTimeoutCount,
+            (unsigned long long)scs->channelAbortCount,
+            (unsigned long long)scs->channelPurgeCount);
+    printHeader(mb, "opcua_secured_chunks_total", "counter",
+                "Chunks signed and/or encrypted for sending and chunks "
+                "decrypted and/or verified after receiving");
+    appendf(mb, "opcua_secured_chunks_total{direction=\"sent\"} %llu\n"
+            "opcua_secured_chunks_total{direction=\"received\"} %llu\n",
+            (unsigned long long)scs->securedChunksSentCount,
+            (unsigned long long)scs->securedChunksReceivedCount);
+}
+
+static void
+printSessionMetrics(MetricsBuffer *mb, const UA_ServerStatistics *stats) {
+    const UA_SessionStatistics *ss = &stats->ss;
+    printMetric(mb, "opcua_sessions", "gauge",
+                "Currently active Sessions", ss->currentSessionCount);
+    printMetric(mb, "opcua_sessions_created_total", "counter",
+                "Sessions created since the server start",
+                ss->cumulatedSessionCount);
+    printHeader(mb, "opcua_sessions_rejected_total", "counter",
+                "Rejected Session requests");
+    appendf(mb, "opcua_sessions_rejected_total{reason=\"security\"} %llu\n"
+            "opcua_sessions_rejected_total{reason=\"other\"} %llu\n",
+            (unsigned long long)ss->securityRejectedSessionCount,
+            (unsigned long long)ss->rejectedSessionCount);
+    printHeader(mb, "opcua_sessions_closed_total", "counter",
+                "Sessions closed for a reason other than a regular close");
+    appendf(mb, "opcua_sessions_closed_total{reason=\"timeout\"} %llu\n"
+            "opcua_sessions_closed_total{reason=\"abort\"} %llu\n",
+            (unsigned long long)ss->sessionTimeoutCount,
+            (unsigned long long)ss->sessionAbortCount);
+}
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+static void
+printSubscriptionMetrics(MetricsBuffer *mb, const UA_ServerStatistics *stats) {
+    const UA_NotificationStatistics *ns = &stats->ns;
+    printMetric(mb, "opcua_subscriptions", "gauge",
+                "Currently active Subscriptions", ns->subscriptionCount);
+    printMetric(mb, "opcua_monitored_items", "gauge",
+                "Currently active MonitoredItems", ns->monitoredItemCount);
+    printMetric(mb, "opcua_notifications", "gauge",
+                "Currently queued Notifications", ns->notificationCount);
+    printMetric(mb, "opcua_notifications_high_water_mark", "gauge",
+                "Maximum of the queued Notifications",
+                ns->notificationHighWaterMark);
+    printMetric(mb, "opcua_retransmission_queue_entries", "gauge",
+                "NotificationMessages kept for retransmission",
+                ns->retransmissionCount);
+    printMetric(mb, "opcua_retransmission_queue_high_water_mark", "gauge",
+                "Maximum of the NotificationMessages kept for retransmission",
+                ns->retransmissionHighWaterMark);
+}
+#endif
+
+#ifdef UA_ENABLE_PUBSUB
+static void
+printPubSubMetrics(MetricsBuffer *mb, const UA_ServerStatistics *stats) {
+    printMetric(mb, "opcua_pubsub_publish_cycles_total", "counter",
+                "Executed WriterGroup publish cycles",
+                stats->ps.publishCycleCount);
+    printMetric(mb, "opcua_pubsub_publish_cycle_overruns_total", "counter",
+                "WriterGroup publish cycles started more than half a "
+                "PublishingInterval late", stats->ps.publishCycleOverrunCount);
+}
+#endif
+
+static void
+printEventLoopMetrics(MetricsBuffer *mb, UA_EventLoop *el) {
+    if(!el || !el->getStatistics)
+        return;
+    UA_EventLoopStatistics els;
+    memset(&els, 0, sizeof(UA_EventLoopStatistics));
+    el->getStatistics(el, &els);
+    printMetric(mb, "opcua_eventloop_timers", "gauge",
+                "Timers registered in the EventLoop", els.timerCount);
+    printMetric(mb, "opcua_eventloop_iterations_total", "counter",
+                "Iterations of the EventLoop", els.iterationCount);
+    printSeconds(mb, "opcua_eventloop_busy_seconds_total", "counter",
+                 "Processing time of the EventLoop without waiting for events",
+                 els.iterationTimeTotal);
+    printSeconds(mb, "opcua_eventloop_iteration_seconds_last", "gauge",
+                 "Processing time of the last EventLoop iteration",
+                 els.iterationTimeLast);
+    printSeconds(mb, "opcua_eventloop_iteration_seconds_max", "gauge",
+                 "Maximum processing time of an EventLoop iteration",
+                 els.iterationTimeMax);
+}
+
+static void
+printAllocatorMetrics(MetricsBuffer *mb) {
+#ifdef UA_METRICS_MALLINFO2
+    struct mallinfo2 mi = mallinfo2();
+    printMetric(mb, "process_heap_allocated_bytes", "gauge",
+                "Heap memory in use by allocations", mi.uordblks + mi.hblkhd);
+    printMetric(mb, "process_heap_free_bytes", "gauge",
+                "Heap memory held by the allocator but not in use",
+                mi.fordblks);
+#endif
+
+    /* Statistics per memory category of the allocator plugin */
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+    UA_Allocator *a = UA_Allocator_get();
+    if(!a || !a->getStatistics)
+        return;
+    UA_MemoryStatistics ms[UA_MEMORYCATEGORIES];
+    for(size_t i = 0; i < UA_MEMORYCATEGORIES; i++) {
+        if(a->getStatistics(a, (UA_MemoryCategory)i, &ms[i]) != UA_STATUSCODE_GOOD)
+            return;
+    }
+    printHeader(mb, "opcua_memory_bytes", "gauge",
+                "Requested bytes of the allocated blocks per memory category");
+    for(size_t i = 0; i < UA_MEMORYCATEGORIES; i++)
+        appendf(mb, "opcua_memory_bytes{category=\"%s\"} %llu\n",
+                UA_MemoryCategory_name((UA_MemoryCategory)i),
+                (unsigned long long)ms[i].bytesInUse);
+    printHeader(mb, "opcua_memory_reserved_bytes", "gauge",
+                "Memory taken from the system per memory category");
+    for(size_t i = 0; i < UA_MEMORYCATEGORIES; i++)
+        appendf(mb, "opcua_memory_reserved_bytes{category=\"%s\"} %llu\n",
+                UA_MemoryCategory_name((UA_MemoryCategory)i),
+                (unsigned long long)ms[i].bytesReserved);
+    printHeader(mb, "opcua_memory_allocations_total", "counter",
+                "Number of allocations per memory category");
+    for(size_t i = 0; i < UA_MEMORYCATEGORIES; i++)
+        appendf(mb, "opcua_memory_allocations_total{category=\"%s\"} %llu\n",
+                UA_MemoryCategory_name((UA_MemoryCategory)i),
+                (unsigned long long)ms[i].allocations);
+#else
+    (void)mb;
+#endif
+}
+
+#if defined(UA_ENABLE_DIAGNOSTICS) && defined(UA_ENABLE_TYPEDESCRIPTION)
+
+/* The service name is the name of the request type without the "Request"
+ * suffix. Returns the length of the name or zero if the type is no request. */
+static size_t
+serviceNameLength(const UA_DataType *type) {
+    static const char suffix[] = "Request";
+    const size_t suffixLen = sizeof(suffix) - 1;
+    size_t len = strlen(type->typeName);
+    if(len <= suffixLen || strcmp(type->typeName + len - suffixLen, suffix) != 0)
+        return 0;
+    return len - suffixLen;
+}
+
+static void
+printServiceMetrics(MetricsBuffer *mb, UA_Server *server) {
+    /* Collect the statistics of the services that were used */
+    UA_ServiceStatistics stats[UA_TYPES_COUNT];
+    const UA_DataType *types[UA_TYPES_COUNT];
+    size_t count = 0;
+    for(size_t i = 0; i < UA_TYPES_COUNT; i++) {
+        if(serviceNameLength(&UA_TYPES[i]) == 0)
+            continue;
+        UA_StatusCode res =
+            UA_Server_getServiceStatistics(server, &UA_TYPES[i], &stats[count]);
+        if(res != UA_STATUSCODE_GOOD || stats[count].requestCount == 0)
+            continue;
+        types[count] = &UA_TYPES[i];
+        count++;
+    }
+    if(count == 0)
+        return;
+
+    printHeader(mb, "opcua_service_requests_total", "counter",
+                "Requests received per service");
+    for(size_t i = 0; i < count; i++)
+        appendf(mb, "opcua_service_requests_total{service=\"%.*s\"} %llu\n",
+                (int)serviceNameLength(types[i]), types[i]->typeName,
+                (unsigned long long)stats[i].requestCount);
+
+    printHeader(mb, "opcua_service_errors_total", "counter",
+                "Requests answered with a bad ServiceResult per service");
+    for(size_t i = 0; i < count; i++)
+        appendf(mb, "opcua_service_errors_total{service=\"%.*s\"} %llu\n",
+                (int)serviceNameLength(types[i]), types[i]->typeName,
+                (unsigned long long)stats[i].errorCount);
+
+    printHeader(mb, "opcua_service_operations_total", "counter",
+                "Operations (e.g. nodes to read) requested per service");
+    for(size_t i = 0; i < count; i++)
+        appendf(mb, "opcua_service_operations_total{service=\"%.*s\"} %llu\n",
+                (int)serviceNameLength(types[i]), types[i]->typeName,
+                (unsigned long long)stats[i].operationCount);
+
+    /* The latencies are only measured for requests answered right away */
+    printHeader(mb, "opcua_service_latency_seconds", "summary",
+                "Processing time of the requests answered right away");
+    for(size_t i = 0; i < count; i++) {
+        int nameLen = (int)serviceNameLength(types[i]);
+        const char *name = types[i]->typeName;
+        const UA_ServiceStatistics *s = &stats[i];
+        UA_UInt64 measured = s->requestCount - s->asyncCount;
+        if(measured == 0)
+            continue;
+        const char *quantiles[4] = {"0.5", "0.9", "0.99", "0.999"};
+        const UA_Duration values[4] = {s->latencyP50, s->latencyP90,
+                                        s->latencyP99, s->latencyP999};
+        for(size_t q = 0; q < 4; q++)
+            appendf(mb, "opcua_service_latency_seconds{service=\"%.*s\","
+                    "quantile=\"%s\"} %.7f\n", nameLen, name,
+                    quantiles[q], values[q] / 1000.0);
+        appendf(mb, "opcua_service_latency_seconds_sum{service=\"%.*s\"} %.7f\n"
+                "opcua_service_latency_seconds_count{service=\"%.*s\"} %llu\n",
+                nameLen, name, s->latencyMean * (UA_Double)measured / 1000.0,
+                nameLen, name, (unsigned long long)measured);
+    }
+}
+
+#endif
+
+UA_StatusCode
+UA_MetricsExporter_Prometheus_print(UA_Server *server, UA_String *output) {
+    MetricsBuffer mb;
+    mb.out.length = 0;
+    mb.out.data = (UA_Byte*)UA_malloc(UA_METRICS_INITIALBUFSIZE);
+    if(!mb.out.data)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    mb.capacity = UA_METRICS_INITIALBUFSIZE;
+    mb.res = UA_STATUSCODE_GOOD;
+
+    UA_ServerStatistics stats = UA_Server_getStatistics(server);
+    printSecureChannelMetrics(&mb, &stats);
+    printSessionMetrics(&mb, &stats);
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    printSubscriptionMetrics(&mb, &stats);
+#endif
+#ifdef UA_ENABLE_PUBSUB
+    printPubSubMetrics(&mb, &stats);
+#endif
+    printEventLoopMetrics(&mb, UA_Server_getConfig(server)->eventLoop);
+    printAllocatorMetrics(&mb);
+#if defined(UA_ENABLE_DIAGNOSTICS) && defined(UA_ENABLE_TYPEDESCRIPTION)
+    printServiceMetrics(&mb, server);
+#endif
+
+    if(mb.res != UA_STATUSCODE_GOOD) {
+        UA_free(mb.out.data);
+        return mb.res;
+    }
+    *output = mb.out;
+    return UA_STATUSCODE_GOOD;
+}
+
+/*****************/
+/* HTTP Endpoint */
+/*****************/
+
+typedef struct MetricsConnection {
+    LIST_ENTRY(MetricsConnection) pointers;
+    uintptr_t connectionId;
+    UA_ByteString request; /* Received bytes of the incomplete request */
+} MetricsConnection;
+
+struct UA_MetricsExporter {
+    UA_Server *server;
+    UA_ConnectionManager *cm;
+    const UA_Logger *logging;
+
+    uintptr_t listenSockets[UA_METRICS_MAXLISTENSOCKETS];
+    size_t listenSocketsSize;
+
+    LIST_HEAD(, MetricsConnection) connections;
+    size_t connectionsSize;
+
+    UA_Boolean deleteFlag; /* Free the memory when the last socket closes */
+};
+
+static void
+checkDelete(UA_MetricsExporter *me) {
+    if(me->deleteFlag && me->listenSocketsSize == 0 && me->connectionsSize == 0)
+        UA_free(me);
+}
+
+/* Send the buffer in pieces if the ConnectionManager cannot allocate a network
+ * buffer of the full size (e.g. with a static send buffer) */
+static UA_StatusCode
+sendBytes(UA_MetricsExporter *me, uintptr_t connectionId,
+          const UA_Byte *data, size_t length) {
+    size_t pieceSize = length;
+    while(length > 0) {
+        if(pieceSize > length)
+            pieceSize = length;
+        UA_ByteString buf;
+        UA_StatusCode res =
+            me->cm->allocNetworkBuffer(me->cm, connectionId, &buf, pieceSize);
+        if(res != UA_STATUSCODE_GOOD) {
+            if(pieceSize <= UA_METRICS_MINSENDSIZE)
+                return res;
+            pieceSize /= 2;
+            continue;
+        }
+        memcpy(buf.data, data, pieceSize);
+        res = me->cm->sendWithConnection(me->cm, connectionId,
+                                         &UA_KEYVALUEMAP_NULL, &buf);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+        data += pieceSize;
+        length -= pieceSize;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+sendResponse(UA_MetricsExporter *me, uintptr_t connectionId,
+             const char *status, const char *contentType,
+             const UA_String *body) {
+    char header[256];
+    int len = mp_snprintf(header, sizeof(header),
+                          "HTTP/1.1 %s\r\n"
+                          "Content-Type: %s\r\n"
+                          "Content-Length: %llu\r\n\r\n", status, contentType,
+                          (unsigned long long)body->length);
+    if(len < 0 || (size_t)len >= sizeof(header))
+        return UA_STATUSCODE_BADINTERNALERROR;
+    UA_StatusCode res =
+        sendBytes(me, connectionId, (const UA_Byte*)header, (size_t)len);
+    if(res != UA_STATUSCODE_GOOD || body->length == 0)
+        return res;
+    return sendBytes(me, connectionId, body->data, body->length);
+}
+
+/* Answer a request (without the terminating empty line). The connection stays
+ * open for the next request (HTTP keep-alive). */
+static UA_StatusCode
+processRequest(UA_MetricsExporter *me, uintptr_t connectionId,
+               const UA_Byte *request, size_t length) {
+    /* Parse the request line "<method> <path> <version>" */
+    const UA_Byte *end = request + length;
+    const UA_Byte *method = request;
+    const UA_Byte *pos = method;
+    while(pos < end && *pos != ' ')
+        pos++;
+    size_t methodLen = (size_t)(pos - method);
+    if(pos < end)
+        pos++;
+    const UA_Byte *path = pos;
+    while(pos < end && *pos != ' ' && *pos != '\r' && *pos != '?')
+        pos++;
+    size_t pathLen = (size_t)(pos - path);
+
+    const char *textType = "text/plain; charset=utf-8";
+    if(methodLen != 3 || strncmp((const char*)method, "GET", 3) != 0) {
+        UA_String body = UA_STRING("Method Not Allowed\n");
+        return sendResponse(me, connectionId, "405 Method Not Allowed",
+                            textType, &body);
+    }
+    if(!(pathLen == 1 && path[0] == '/') &&
+       !(pathLen == 8 && strncmp((const char*)path, "/metrics", 8) == 0)) {
+        UA_String body = UA_STRING("Not Found\n");
+        return sendResponse(me, connectionId, "404 Not Found", textType, &body);
+    }
+
+    UA_String metrics;
+    UA_StatusCode res = UA_MetricsExporter_Prometheus_print(me->server, &metrics);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_String body = UA_STRING("Internal Server Error\n");
+        return sendResponse(me, connectionId, "500 Internal Server Error",
+                            textType, &body);
+    }
+    res = sendResponse(me, connectionId, "200 OK",
+                       "text/plain; version=0.0.4; charset=utf-8", &metrics);
+    UA_String_clear(&metrics);
+    return res;
+}
+
+/* Find the end of the request header. Returns the length without the empty
+ * line or zero if the header is incomplete. */
+static size_t
+findHeaderEnd(const UA_ByteString *buf, size_t *consumed) {
+    for(size_t i = 0; i + 3 < buf->length; i++) {
+        if(buf->data[i] == '\r' && buf->data[i+1] == '\n' &&
+           buf->data[i+2] == '\r' && buf->data[i+3] == '\n') {
+            *consumed = i + 4;
+            return i;
+        }
+    }
+    return 0;
+}
+
+static void
+processReceived(UA_MetricsExporter *me, MetricsConnection *conn,
+                const UA_ByteString msg) {
+    /* Append to the incomplete request */
+    if(conn->request.length + msg.length > UA_METRICS_MAXREQUESTSIZE) {
+        UA_LOG_WARNING(me->logging, UA_LOGCATEGORY_SERVER,
+                       "Metrics\t| Request too large, closing the connection");
+        me->cm->closeConnection(me->cm, conn->connectionId);
+        return;
+    }
+    UA_Byte *data = (UA_Byte*)
+        UA_realloc(conn->request.data, conn->request.length + msg.length);
+    if(!data) {
+        me->cm->closeConnection(me->cm, conn->connectionId);
+        return;
+    }
+    memcpy(data + conn->request.length, msg.data, msg.length);
+    conn->request.data = data;
+    conn->request.length += msg.length;
+
+    /* Process all complete requests. Request bodies are not expected. */
+    size_t consumed = 0;
+    size_t headerLen;
+    while((headerLen = findHeaderEnd(&conn->request, &consumed)) > 0) {
+        UA_StatusCode res = processRequest(me, conn->connectionId,
+                                           conn->request.data, headerLen);
+        memmove(conn->request.data, conn->request.data + consumed,
+                conn->request.length - consumed);
+        conn->request.length -= consumed;
+        if(res != UA_STATUSCODE_GOOD) {
+            me->cm->closeConnection(me->cm, conn->connectionId);
+            return;
+        }
+    }
+    if(conn->request.length == 0) {
+        UA_free(conn->request.data);
+        conn->request.data = NULL;
+    }
+}
+
+static UA_Boolean
+isListenSocket(UA_MetricsExporter *me, uintptr_t connectionId) {
+    for(size_t i = 0; i < me->listenSocketsSize; i++) {
+        if(me->listenSockets[i] == connectionId)
+            return true;
+    }
+    return false;
+}
+
+static void
+removeListenSocket(UA_MetricsExporter *me, uintptr_t connectionId) {
+    for(size_t i = 0; i < me->listenSocketsSize; i++) {
+        if(me->listenSockets[i] != connectionId)
+            continue;
+        me->listenSocketsSize--;
+        me->listenSockets[i] = me->listenSockets[me->listenSocketsSize];
+        return;
+    }
+}
+
+/* The context of the listen sockets is the exporter itself. Accepted
+ * connections inherit this context and replace it with their
+ * MetricsConnection. */
+static void
+metricsConnectionCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
+                          void *application, void **connectionContext,
+                          UA_ConnectionState state, const UA_KeyValueMap *params,
+                          UA_ByteString msg) {
+    UA_MetricsExporter *me = (UA_MetricsExporter*)application;
+
+    /* A new listen socket is announced */
+    if(*connectionContext == NULL) {
+        if(state == UA_CONNECTIONSTATE_CLOSING)
+            return;
+        if(me->listenSocketsSize == UA_METRICS_MAXLISTENSOCKETS || me->deleteFlag) {
+            cm->closeConnection(cm, connectionId);
+            return;
+        }
+        me->listenSockets[me->listenSocketsSize++] = connectionId;
+        *connectionContext = me;
+        return;
+    }
+
+    if(*connectionContext == me) {
+        /* The listen socket closes */
+        if(isListenSocket(me, connectionId)) {
+            if(state == UA_CONNECTIONSTATE_CLOSING) {
+                removeListenSocket(me, connectionId);
+                checkDelete(me);
+            }
+            return;
+        }
+
+        /* Accepted connection without a MetricsConnection. Either it was
+         * rejected below or a new connection is announced. */
+        if(state == UA_CONNECTIONSTATE_CLOSING)
+            return;
+        if(me->connectionsSize == UA_METRICS_MAXCONNECTIONS || me->deleteFlag) {
+            cm->closeConnection(cm, connectionId);
+            return;
+        }
+        MetricsConnection *conn = (MetricsConnection*)
+            UA_calloc(1, sizeof(MetricsConnection));
+        if(!conn) {
+            cm->closeConnection(cm, connectionId);
+            return;
+        }
+        conn->connectionId = connectionId;
+        LIST_INSERT_HEAD(&me->connections, conn, pointers);
+        me->connectionsSize++;
+        *connectionContext = conn;
+    }
+
+    MetricsConnection *conn = (MetricsConnection*)*connectionContext;
+    if(state == UA_CONNECTIONSTATE_CLOSING) {
+        LIST_REMOVE(conn, pointers);
+        me->connectionsSize--;
+        UA_ByteString_clear(&conn->request);
+        UA_free(conn);
+        checkDelete(me);
+        return;
+    }
+
+    if(msg.length > 0)
+        processReceived(me, conn, msg);
+}
+
+UA_MetricsExporter *
+UA_MetricsExporter_Prometheus_new(UA_Server *server,
+                                  const UA_String *listenAddress,
+                                  UA_UInt16 port) {
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    UA_EventLoop *el = config->eventLoop;
+    if(!el)
+        return NULL;
+
+    /* Find the TCP ConnectionManager */
+    UA_ConnectionManager *cm = NULL;
+    UA_String tcpString = UA_STRING("tcp");
+    for(UA_EventSource *es = el->eventSources; es != NULL; es = es->next) {
+        if(es->eventSourceType != UA_EVENTSOURCETYPE_CONNECTIONMANAGER)
+            continue;
+        UA_ConnectionManager *candidate = (UA_ConnectionManager*)es;
+        if(UA_String_equal(&tcpString, &candidate->protocol)) {
+            cm = candidate;
+            break;
+        }
+    }
+    if(!cm) {
+        UA_LOG_ERROR(config->logging, UA_LOGCATEGORY_SERVER,
+                     "Metrics\t| No TCP ConnectionManager in the EventLoop");
+        return NULL;
+    }
+
+    UA_MetricsExporter *me = (UA_MetricsExporter*)
+        UA_calloc(1, sizeof(UA_MetricsExporter));
+    if(!me)
+        return NULL;
+    me->server = server;
+    me->cm = cm;
+    me->logging = config->logging;
+    LIST_INIT(&me->connections);
+
+    /* Open the listen socket */
+    UA_KeyValuePair params[4];
+    size_t paramsSize = 3;
+    params[0].key = UA_QUALIFIEDNAME(0, "port");
+    UA_Variant_setScalar(&params[0].value, &port, &UA_TYPES[UA_TYPES_UINT16]);
+    UA_Boolean listen = true;
+    params[1].key = UA_QUALIFIEDNAME(0, "listen");
+    UA_Variant_setScalar(&params[1].value, &listen, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    UA_Boolean reuseaddr = config->tcpReuseAddr;
+    params[2].key = UA_QUALIFIEDNAME(0, "reuse");
+    UA_Variant_setScalar(&params[2].value, &reuseaddr, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    if(listenAddress && listenAddress->length > 0) {
+        params[3].key = UA_QUALIFIEDNAME(0, "address");
+        UA_Variant_setArray(&params[3].value, (void*)(uintptr_t)listenAddress,
+                            1, &UA_TYPES[UA_TYPES_STRING]);
+        paramsSize = 4;
+    }
+    UA_KeyValueMap paramsMap = {paramsSize, params};
+
+    UA_StatusCode res =
+        cm->openConnection(cm, &paramsMap, me, NULL, metricsConnectionCallback);
+    if(res != UA_STATUSCODE_GOOD || me->listenSocketsSize == 0) {
+        UA_LOG_ERROR(config->logging, UA_LOGCATEGORY_SERVER,
+                     "Metrics\t| Could not open the listen socket on port %u",
+                     (unsigned)port);
+        UA_MetricsExporter_delete(me);
+        return NULL;
+    }
+
+    UA_LOG_INFO(config->logging, UA_LOGCATEGORY_SERVER,
+                "Metrics\t| Serving the metrics on port %u", (unsigned)port);
+    return me;
+}
+
+void
+UA_MetricsExporter_delete(UA_MetricsExporter *me) {
+    if(!me)
+        return;
+    me->deleteFlag = true;
+
+    /* Close the sockets. The memory is released when the last socket has
+     * closed. Iterate over copies, as closing can call back right away. */
+    UA_ConnectionManager *cm = me->cm;
+    uintptr_t ids[UA_METRICS_MAXLISTENSOCKETS + UA_METRICS_MAXCONNECTIONS];
+    size_t idsSize = 0;
+    for(size_t i = 0; i < me->listenSocketsSize; i++)
+        ids[idsSize++] = me->listenSockets[i];
+    MetricsConnection *conn;
+    LIST_FOREACH(conn, &me->connections, pointers)
+        ids[idsSize++] = conn->connectionId;
+    for(size_t i = 0; i < idsSize; i++)
+        cm->closeConnection(cm, ids[i]);
+
+    /* The callback of the last socket might have freed the exporter already.
+     * That is only the case if sockets were open. */
+    if(idsSize == 0)
+        UA_free(me);
+}
@@ -14,11 +14,33 @@
 UA_StatusCode
 UA_Server_loadNodeset(UA_Server *server, const char *nodeset2XmlFilePath,
                       UA_NodeSetLoaderOptions *options) {
-    if(!NodesetLoader_loadFile(server,
-                               nodeset2XmlFilePath,
-                               (NodesetLoader_ExtensionInterface*)options)) {
-        return UA_STATUSCODE_BAD;
+    return UA_Server_loadNodesets(server, &nodeset2XmlFilePath, 1, options);
+}
+
+UA_StatusCode
+UA_Server_loadNodesets(UA_Server *server, const char **nodeset2XmlFilePaths,
+                       size_t nodesetsSize, UA_NodeSetLoaderOptions *options) {
+    /* Don't end the bulk load if the caller has already started it */
+    UA_Boolean bulkLoad =
+        (UA_Server_beginBulkLoad(server) == UA_STATUSCODE_GOOD);
+
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    for(size_t i = 0; i < nodesetsSize; i++) {
+        if(!NodesetLoader_loadFile(server, nodeset2XmlFilePaths[i],
+                                   (NodesetLoader_ExtensionInterface*)options)) {
+            UA_LOG_ERROR(UA_Server_getConfig(server)->logging,
+                         UA_LOGCATEGORY_SERVER,
+                         "Could not load the nodeset %s",
+                         nodeset2XmlFilePaths[i]);
+            res = UA_STATUSCODE_BAD;
+            break;
+        }
     }
 
-    return UA_STATUSCODE_GOOD;
+    if(bulkLoad) {
+        UA_StatusCode res2 = UA_Server_endBulkLoad(server);
+        if(res == UA_STATUSCODE_GOOD)
+            res = res2;
+    }
+    return res;
 }
@@ -9,6 +9,8 @@
 #include <open62541/util.h>
 #include <open62541/plugin/nodestore_default.h>
 
+#include <stdlib.h> /* qsort */
+
 #ifndef container_of
 #define container_of(ptr, type, member) \
     (type *)((uintptr_t)ptr - offsetof(type,member))
@@ -19,12 +21,31 @@
  *
  * - Tombstone or non-matching NodeId: continue searching
  * - Matching NodeId: Return the entry
- * - NULL: Abort the search */
+ * - NULL: Abort the search
+ *
+ * In the concurrent variant, readers (getNode/releaseNode) do not take a lock.
+ * Writers (all other methods) still have to be serialized by the caller. The
+ * table and the slot entries are published with atomic operations. Modified
+ * nodes are never changed in-situ: getEditNode returns a copy that is swapped
+ * into the table in releaseNode (copy-on-write). Entries and tables that are no
+ * longer reachable from the table are "retired". Retired memory is freed by a
+ * writer once no reader is inside a lookup (quiescent state) and the refCount
+ * of the entry has dropped to zero.
+ *
+ * After namespace 0 was created, the server calls compact. This moves the
+ * entries into a single contiguous block sorted by NodeId. Lookups of related
+ * nodes then touch neighboring memory and the per-allocation overhead of the
+ * heap is saved. Packed entries can still be edited (in-situ or via
+ * copy-on-write). Their memory is released only with the block. */
 
 typedef struct UA_NodeMapEntry {
-    struct UA_NodeMapEntry *orig; /* the version this is a copy from (or NULL) */
-    UA_UInt16 refCount; /* How many consumers have a reference to the node? */
+    struct UA_NodeMapEntry *orig; /* the version this is a copy from (or NULL).
+                                   * Retired entries use this as the link of
+                                   * the retired-list. */
+    UA_UInt32 refCount; /* How many consumers have a reference to the node? */
     UA_Boolean deleted; /* Node was marked as deleted and can be deleted when refCount == 0 */
+    UA_Boolean editCopy; /* Copy from getEditNode, replaces orig on release */
+    UA_Boolean packed; /* Memory is owned by a UA_NodeMapBlock */
     UA_Node node;
 } UA_NodeMapEntry;
 
@@ -36,17 +57,67 @@ typedef struct {
     UA_UInt32 nodeIdHash;
 } UA_NodeMapSlot;
 
-typedef struct {
-    UA_NodeMapSlot *slots;
+/* The slots are allocated together with the table header. So that size and
+ * slots can be exchanged in one atomic operation. */
+typedef struct UA_NodeMapTable {
+    struct UA_NodeMapTable *retiredNext;
     UA_UInt32 size;
-    UA_UInt32 count;
     UA_UInt32 sizePrimeIndex;
+    UA_NodeMapSlot *slots;
+} UA_NodeMapTable;
+
+/* Contiguous memory for packed entries */
+typedef struct UA_NodeMapBlock {
+    struct UA_NodeMapBlock *next;
+} UA_NodeMapBlock;
+
+typedef struct {
+    UA_NodeMapTable *table;
+    UA_UInt32 count;
 
     /* Maps ReferenceTypeIndex to the NodeId of the ReferenceType */
     UA_NodeId referenceTypeIds[UA_REFERENCETYPESET_MAX];
     UA_Byte referenceTypeCounter;
+
+    /* Concurrent variant */
+    UA_Boolean concurrent;
+    UA_UInt32 readers; /* Number of readers currently inside a lookup */
+    UA_NodeMapEntry *retiredEntries;
+    UA_NodeMapTable *retiredTables;
+
+    UA_NodeMapBlock *blocks;
 } UA_NodeMap;
 
+/*********************/
+/* Atomic Operations */
+/*********************/
+
+#if UA_MULTITHREADING >= 100 && defined(_WIN32)
+# define NODEMAP_LOAD(x) (*(void * volatile *)&(x))
+# define NODEMAP_LOAD32(x) ((UA_UInt32)InterlockedOr((volatile LONG*)&(x), 0))
+# define NODEMAP_INC(x) (void)InterlockedIncrement((volatile LONG*)&(x))
+# define NODEMAP_DEC(x) (void)InterlockedDecrement((volatile LONG*)&(x))
+# define NODEMAP_PUBLISH(x, v) (void)InterlockedExchangePointer((void * volatile *)&(x), (v))
+#elif UA_MULTITHREADING >= 100 && defined(__GNUC__)
+# define NODEMAP_LOAD(x) __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+# define NODEMAP_LOAD32(x) __atomic_load_n(&(x), __ATOMIC_SEQ_CST)
+# define NODEMAP_INC(x) (void)__atomic_add_fetch(&(x), 1, __ATOMIC_SEQ_CST)
+# define NODEMAP_DEC(x) (void)__atomic_sub_fetch(&(x), 1, __ATOMIC_SEQ_CST)
+# define NODEMAP_PUBLISH(x, v) (void)__atomic_exchange_n(&(x), (v), __ATOMIC_SEQ_CST)
+#else
+# define NODEMAP_LOAD(x) (x)
+# define NODEMAP_LOAD32(x) (x)
+# define NODEMAP_INC(x) (void)(++(x))
+# define NODEMAP_DEC(x) (void)(--(x))
+# define NODEMAP_PUBLISH(x, v) (void)((x) = (v))
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+# define NODEMAP_PREFETCH(p) __builtin_prefetch(p)
+#else
+# define NODEMAP_PREFETCH(p) (void)(p)
+#endif
+
 /*********************/
 /* HashMap Utilities */
 /*********************/
@@ -80,16 +151,15 @@ higher_prime_index(UA_UInt32 n) {
 
 /* Returns an empty slot or null if the nodeid exists or if no empty slot is found. */
 static UA_NodeMapSlot *
-findFreeSlot(const UA_NodeMap *ns, const UA_NodeId *nodeid) {
-    UA_UInt32 h = UA_NodeId_hash(nodeid);
-    UA_UInt32 size = ns->size;
+findFreeSlot(const UA_NodeMapTable *t, const UA_NodeId *nodeid, UA_UInt32 h) {
+    UA_UInt32 size = t->size;
     UA_UInt64 idx = mod(h, size); /* Use 64bit container to avoid overflow  */
     UA_UInt32 startIdx = (UA_UInt32)idx;
     UA_UInt32 hash2 = mod2(h, size);
 
     UA_NodeMapSlot *candidate = NULL;
     do {
-        UA_NodeMapSlot *slot = &ns->slots[(UA_UInt32)idx];
+        UA_NodeMapSlot *slot = &t->slots[(UA_UInt32)idx];
 
         if(slot->entry > UA_NODEMAP_TOMBSTONE) {
             /* A Node with the NodeId does already exist */
@@ -113,43 +183,91 @@ findFreeSlot(const UA_NodeMap *ns, const UA_NodeId *nodeid) {
     return candidate;
 }
 
+static UA_NodeMapTable *
+newTable(UA_UInt32 sizePrimeIndex) {
+    UA_UInt32 size = primes[sizePrimeIndex];
+    UA_NodeMapTable *t = (UA_NodeMapTable*)
+        UA_calloc(1, sizeof(UA_NodeMapTable) + (size * sizeof(UA_NodeMapSlot)));
+    if(!t)
+        return NULL;
+    t->size = size;
+    t->sizePrimeIndex = sizePrimeIndex;
+    t->slots = (UA_NodeMapSlot*)(uintptr_t)&t[1];
+    return t;
+}
+
+static void
+deleteNodeMapEntry(UA_NodeMapEntry *entry);
+
+/* Free the retired memory if no reader is inside a lookup. Readers increase
+ * the counter before they access the table. Retired memory is no longer
+ * reachable from the table. So if the counter is zero after the memory was
+ * retired, no reader can get hold of a pointer to it anymore. Retired entries
+ * are kept until the last reader has released them. */
+static void
+reclaimRetired(UA_NodeMap *ns) {
+    if(NODEMAP_LOAD32(ns->readers) != 0)
+        return;
+
+    while(ns->retiredTables) {
+        UA_NodeMapTable *t = ns->retiredTables;
+        ns->retiredTables = t->retiredNext;
+        UA_free(t);
+    }
+
+    UA_NodeMapEntry **next = &ns->retiredEntries;
+    while(*next) {
+        UA_NodeMapEntry *entry = *next;
+        if(NODEMAP_LOAD32(entry->refCount) > 0) {
+            next = &entry->orig;
+            continue;
+        }
+        *next = entry->orig;
+        deleteNodeMapEntry(entry);
+    }
+}
+
 /* The occupancy of the table after the call will be about 50% */
 static UA_StatusCode
 expand(UA_NodeMap *ns) {
-    UA_UInt32 osize = ns->size;
+    UA_NodeMapTable *ot = ns->table;
+    UA_UInt32 osize = ot->size;
     UA_UInt32 count = ns->count;
     /* Resize only when table after removal of unused elements is either too
        full or too empty */
     if(count * 2 < osize && (count * 8 > osize || osize <= UA_NODEMAP_MINSIZE))
         return UA_STATUSCODE_GOOD;
 
-    UA_NodeMapSlot *oslots = ns->slots;
-    UA_UInt32 nindex = higher_prime_index(count * 2);
-    UA_UInt32 nsize = primes[nindex];
-    UA_NodeMapSlot *nslots= (UA_NodeMapSlot*)UA_calloc(nsize, sizeof(UA_NodeMapSlot));
-    if(!nslots)
+    UA_NodeMapTable *nt = newTable(higher_prime_index(count * 2));
+    if(!nt)
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
-    ns->slots = nslots;
-    ns->size = nsize;
-    ns->sizePrimeIndex = nindex;
-
     /* recompute the position of every entry and insert the pointer */
     for(size_t i = 0, j = 0; i < osize && j < count; ++i) {
-        if(oslots[i].entry <= UA_NODEMAP_TOMBSTONE)
+        if(ot->slots[i].entry <= UA_NODEMAP_TOMBSTONE)
             continue;
-        UA_NodeMapSlot *s = findFreeSlot(ns, &oslots[i].entry->node.head.nodeId);
+        UA_NodeMapSlot *s = findFreeSlot(nt, &ot->slots[i].entry->node.head.nodeId,
+                                         ot->slots[i].nodeIdHash);
         UA_assert(s);
-        *s = oslots[i];
+        *s = ot->slots[i];
         ++j;
     }
 
-    UA_free(oslots);
+    /* Publish the new table. Readers might still use the old table. */
+    NODEMAP_PUBLISH(ns->table, nt);
+    if(ns->concurrent) {
+        ot->retiredNext = ns->retiredTables;
+        ns->retiredTables = ot;
+        reclaimRetired(ns);
+    } else {
+        UA_free(ot);
+    }
     return UA_STATUSCODE_GOOD;
 }
 
-static UA_NodeMapEntry *
-createEntry(UA_NodeClass nodeClass) {
+/* Returns zero for an unknown NodeClass */
+static size_t
+entrySize(UA_NodeClass nodeClass) {
     size_t size = sizeof(UA_NodeMapEntry) - sizeof(UA_Node);
     switch(nodeClass) {
     case UA_NODECLASS_OBJECT:
@@ -177,8 +295,16 @@ createEntry(UA_NodeClass nodeClass) {
         size += sizeof(UA_ViewNode);
         break;
     default:
-        return NULL;
+        return 0;
     }
+    return size;
+}
+
+static UA_NodeMapEntry *
+createEntry(UA_NodeClass nodeClass) {
+    size_t size = entrySize(nodeClass);
+    if(size == 0)
+        return NULL;
     UA_NodeMapEntry *entry = (UA_NodeMapEntry*)UA_calloc(1, size);
     if(!entry)
         return NULL;
@@ -189,7 +315,18 @@ createEntry(UA_NodeClass nodeClass) {
 static void
 deleteNodeMapEntry(UA_NodeMapEntry *entry) {
     UA_Node_clear(&entry->node);
-    UA_free(entry);
+    if(!entry->packed)
+        UA_free(entry);
+}
+
+/* Switch large reference arrays to a tree representation */
+static void
+switchReferenceKinds(UA_NodeMapEntry *entry) {
+    for(size_t i = 0; i < entry->node.head.referencesSize; i++) {
+        UA_NodeReferenceKind *rk = &entry->node.head.references[i];
+        if(rk->targetsSize > 16 && !rk->hasRefTree && !rk->isCompact)
+            UA_NodeReferenceKind_switch(rk);
+    }
 }
 
 static void
@@ -200,29 +337,43 @@ cleanupNodeMapEntry(UA_NodeMapEntry *entry) {
         deleteNodeMapEntry(entry);
         return;
     }
-    for(size_t i = 0; i < entry->node.head.referencesSize; i++) {
-        UA_NodeReferenceKind *rk = &entry->node.head.references[i];
-        if(rk->targetsSize > 16 && !rk->hasRefTree)
-            UA_NodeReferenceKind_switch(rk);
+    switchReferenceKinds(entry);
+}
+
+/* Removed or replaced entries are deleted once they are no longer used */
+static void
+retireEntry(UA_NodeMap *ns, UA_NodeMapEntry *entry) {
+    entry->deleted = true;
+    if(!ns->concurrent) {
+        cleanupNodeMapEntry(entry);
+        return;
     }
+    entry->orig = ns->retiredEntries;
+    ns->retiredEntries = entry;
+    reclaimRetired(ns);
 }
 
+/* The entry is loaded only once from the slot. The slot can be changed
+ * concurrently in the concurrent variant. */
 static UA_NodeMapSlot *
-findOccupiedSlot(const UA_NodeMap *ns, const UA_NodeId *nodeid) {
-    UA_UInt32 h = UA_NodeId_hash(nodeid);
-    UA_UInt32 size = ns->size;
+findOccupiedSlotHash(const UA_NodeMapTable *t, const UA_NodeId *nodeid,
+                     UA_UInt32 h, UA_NodeMapEntry **outEntry) {
+    UA_UInt32 size = t->size;
     UA_UInt64 idx = mod(h, size); /* Use 64bit container to avoid overflow */
     UA_UInt32 hash2 = mod2(h, size);
     UA_UInt32 startIdx = (UA_UInt32)idx;
 
     do {
-        UA_NodeMapSlot *slot= &ns->slots[(UA_UInt32)idx];
-        if(slot->entry > UA_NODEMAP_TOMBSTONE) {
+        UA_NodeMapSlot *slot= &t->slots[(UA_UInt32)idx];
+        UA_NodeMapEntry *entry = (UA_NodeMapEntry*)NODEMAP_LOAD(slot->entry);
+        if(entry > UA_NODEMAP_TOMBSTONE) {
             if(slot->nodeIdHash == h &&
-               UA_NodeId_equal(&slot->entry->node.head.nodeId, nodeid))
+               UA_NodeId_equal(&entry->node.head.nodeId, nodeid)) {
+                *outEntry = entry;
                 return slot;
+            }
         } else {
-            if(slot->entry == NULL)
+            if(entry == NULL)
                 return NULL; /* No further entry possible */
         }
 
@@ -234,6 +385,12 @@ findOccupiedSlot(const UA_NodeMap *ns, const UA_NodeId *nodeid) {
     return NULL;
 }
 
+static UA_NodeMapSlot *
+findOccupiedSlot(const UA_NodeMapTable *t, const UA_NodeId *nodeid,
+                 UA_NodeMapEntry **outEntry) {
+    return findOccupiedSlotHash(t, nodeid, UA_NodeId_hash(nodeid), outEntry);
+}
+
 /***********************/
 /* Interface functions */
 /***********************/
@@ -259,11 +416,76 @@ UA_NodeMap_getNode(void *context, const UA_NodeId *nodeid,
                    UA_ReferenceTypeSet references,
                    UA_BrowseDirection referenceDirections) {
     UA_NodeMap *ns = (UA_NodeMap*)context;
-    UA_NodeMapSlot *slot = findOccupiedSlot(ns, nodeid);
-    if(!slot)
-        return NULL;
-    ++slot->entry->refCount;
-    return &slot->entry->node;
+    UA_NodeMapEntry *entry;
+    if(!ns->concurrent) {
+        if(!findOccupiedSlot(ns->table, nodeid, &entry))
+            return NULL;
+        ++entry->refCount;
+        return &entry->node;
+    }
+
+    /* Lock-free lookup. The refCount is increased before leaving the
+     * quiescent section. */
+    NODEMAP_INC(ns->readers);
+    UA_NodeMapTable *t = (UA_NodeMapTable*)NODEMAP_LOAD(ns->table);
+    const UA_Node *node = NULL;
+    if(findOccupiedSlot(t, nodeid, &entry)) {
+        NODEMAP_INC(entry->refCount);
+        node = &entry->node;
+    }
+    NODEMAP_DEC(ns->readers);
+    return node;
+}
+
+/* The lookups are done in groups. First the hashes are computed and the first
+ * slot of every probe sequence is prefetched. Then the entries in these slots
+ * are prefetched. The memory accesses of the lookups in a group overlap
+ * instead of waiting for one cache miss after the other. */
+#define UA_NODEMAP_BATCHSIZE 16
+
+static void
+UA_NodeMap_getNodes(void *context, size_t nodesSize, const UA_NodeId **nodeIds,
+                    UA_UInt32 attributeMask, UA_ReferenceTypeSet references,
+                    UA_BrowseDirection referenceDirections,
+                    const UA_Node **outNodes) {
+    UA_NodeMap *ns = (UA_NodeMap*)context;
+    if(ns->concurrent)
+        NODEMAP_INC(ns->readers);
+    UA_NodeMapTable *t = (UA_NodeMapTable*)NODEMAP_LOAD(ns->table);
+
+    UA_UInt32 hashes[UA_NODEMAP_BATCHSIZE];
+    for(size_t i = 0; i < nodesSize; i += UA_NODEMAP_BATCHSIZE) {
+        size_t n = nodesSize - i;
+        if(n > UA_NODEMAP_BATCHSIZE)
+            n = UA_NODEMAP_BATCHSIZE;
+
+        for(size_t j = 0; j < n; j++) {
+            hashes[j] = UA_NodeId_hash(nodeIds[i+j]);
+            NODEMAP_PREFETCH(&t->slots[mod(hashes[j], t->size)]);
+        }
+
+        for(size_t j = 0; j < n; j++) {
+            UA_NodeMapSlot *slot = &t->slots[mod(hashes[j], t->size)];
+            UA_NodeMapEntry *entry = (UA_NodeMapEntry*)NODEMAP_LOAD(slot->entry);
+            if(entry > UA_NODEMAP_TOMBSTONE)
+                NODEMAP_PREFETCH(&entry->node.head.nodeId);
+        }
+
+        for(size_t j = 0; j < n; j++) {
+            UA_NodeMapEntry *entry;
+            outNodes[i+j] = NULL;
+            if(!findOccupiedSlotHash(t, nodeIds[i+j], hashes[j], &entry))
+                continue;
+            if(ns->concurrent)
+                NODEMAP_INC(entry->refCount);
+            else
+                ++entry->refCount;
+            outNodes[i+j] = &entry->node;
+        }
+    }
+
+    if(ns->concurrent)
+        NODEMAP_DEC(ns->readers);
 }
 
 static const UA_Node *
@@ -277,25 +499,53 @@ UA_NodeMap_getNodeFromPtr(void *context, UA_NodePointer ptr,
     return UA_NodeMap_getNode(context, &id, attributeMask, references, referenceDirections);
 }
 
+static UA_StatusCode
+UA_NodeMap_replaceNode(void *context, UA_Node *node);
+
 static void
 UA_NodeMap_releaseNode(void *context, const UA_Node *node) {
     if (!node)
         return;
+    UA_NodeMap *ns = (UA_NodeMap*)context;
     UA_NodeMapEntry *entry = container_of(node, UA_NodeMapEntry, node);
     UA_assert(&entry->node == node);
+
+    /* Publish the edited copy. The copy is deleted if this fails. The status
+     * is only returned from releaseEditNode. */
+    if(entry->editCopy) {
+        entry->editCopy = false;
+        UA_NodeMap_replaceNode(context, &entry->node);
+        return;
+    }
+
     UA_assert(entry->refCount > 0);
+    if(ns->concurrent) {
+        /* The entry is deleted by a writer */
+        NODEMAP_DEC(entry->refCount);
+        return;
+    }
     --entry->refCount;
     cleanupNodeMapEntry(entry);
 }
 
+static UA_StatusCode
+UA_NodeMap_releaseEditNode(void *context, UA_Node *node) {
+    UA_NodeMapEntry *entry = container_of(node, UA_NodeMapEntry, node);
+    if(!entry->editCopy) {
+        UA_NodeMap_releaseNode(context, node);
+        return UA_STATUSCODE_GOOD;
+    }
+    entry->editCopy = false;
+    return UA_NodeMap_replaceNode(context, node);
+}
+
 static UA_StatusCode
 UA_NodeMap_getNodeCopy(void *context, const UA_NodeId *nodeid,
                        UA_Node **outNode) {
     UA_NodeMap *ns = (UA_NodeMap*)context;
-    UA_NodeMapSlot *slot = findOccupiedSlot(ns, nodeid);
-    if(!slot)
+    UA_NodeMapEntry *entry;
+    if(!findOccupiedSlot(ns->table, nodeid, &entry))
         return UA_STATUSCODE_BADNODEIDUNKNOWN;
-    UA_NodeMapEntry *entry = slot->entry;
     UA_NodeMapEntry *newItem = createEntry(entry->node.head.nodeClass);
     if(!newItem)
         return UA_STATUSCODE_BADOUTOFMEMORY;
@@ -309,20 +559,47 @@ UA_NodeMap_getNodeCopy(void *context, const UA_NodeId *nodeid,
     return retval;
 }
 
+/* In the concurrent variant the nodes are not edited in-situ. Return a copy
+ * that replaces the original in releaseNode. */
+static UA_Node *
+UA_NodeMap_getEditNodeCopy(void *context, const UA_NodeId *nodeid,
+                           UA_UInt32 attributeMask,
+                           UA_ReferenceTypeSet references,
+                           UA_BrowseDirection referenceDirections) {
+    UA_Node *node = NULL;
+    UA_StatusCode res = UA_NodeMap_getNodeCopy(context, nodeid, &node);
+    if(res != UA_STATUSCODE_GOOD)
+        return NULL;
+    UA_NodeMapEntry *entry = container_of(node, UA_NodeMapEntry, node);
+    entry->editCopy = true;
+    return node;
+}
+
+static UA_Node *
+UA_NodeMap_getEditNodeCopyFromPtr(void *context, UA_NodePointer ptr,
+                                  UA_UInt32 attributeMask,
+                                  UA_ReferenceTypeSet references,
+                                  UA_BrowseDirection referenceDirections) {
+    if(!UA_NodePointer_isLocal(ptr))
+        return NULL;
+    UA_NodeId id = UA_NodePointer_toNodeId(ptr);
+    return UA_NodeMap_getEditNodeCopy(context, &id, attributeMask,
+                                      references, referenceDirections);
+}
+
 static UA_StatusCode
 UA_NodeMap_removeNode(void *context, const UA_NodeId *nodeid) {
     UA_NodeMap *ns = (UA_NodeMap*)context;
-    UA_NodeMapSlot *slot = findOccupiedSlot(ns, nodeid);
+    UA_NodeMapEntry *entry;
+    UA_NodeMapSlot *slot = findOccupiedSlot(ns->table, nodeid, &entry);
     if(!slot)
         return UA_STATUSCODE_BADNODEIDUNKNOWN;
 
-    UA_NodeMapEntry *entry = slot->entry;
-    slot->entry = UA_NODEMAP_TOMBSTONE;
-    entry->deleted = true;
-    cleanupNodeMapEntry(entry);
+    NODEMAP_PUBLISH(slot->entry, UA_NODEMAP_TOMBSTONE);
+    retireEntry(ns, entry);
     --ns->count;
     /* Downsize the hashmap if it is very empty */
-    if(ns->count * 8 < ns->size && ns->size > UA_NODEMAP_MINSIZE)
+    if(ns->count * 8 < ns->table->size && ns->table->size > UA_NODEMAP_MINSIZE)
         expand(ns); /* Can fail. Just continue with the bigger hashmap. */
     return UA_STATUSCODE_GOOD;
 }
@@ -335,13 +612,14 @@ static UA_StatusCode
 UA_NodeMap_insertNode(void *context, UA_Node *node,
                       UA_NodeId *addedNodeId) {
     UA_NodeMap *ns = (UA_NodeMap*)context;
-    if(ns->size * 3 <= ns->count * 4) {
+    if(ns->table->size * 3 <= ns->count * 4) {
         if(expand(ns) != UA_STATUSCODE_GOOD){
             deleteNodeMapEntry(container_of(node, UA_NodeMapEntry, node));
             return UA_STATUSCODE_BADINTERNALERROR;
         }
     }
 
+    UA_NodeMapTable *t = ns->table;
     UA_NodeMapSlot *slot;
     if(node->head.nodeId.identifierType == UA_NODEIDTYPE_NUMERIC &&
        node->head.nodeId.identifier.numeric == 0) {
@@ -352,7 +630,7 @@ UA_NodeMap_insertNode(void *context, UA_Node *node,
          * val, we will reach the starting id again. E.g. adding a nodeset will
          * create children while there are still other nodes which need to be
          * created. Thus the node ids may collide. */
-        UA_UInt32 size = ns->size;
+        UA_UInt32 size = t->size;
         UA_UInt64 identifier = mod(50000 + size+1, UA_UINT32_MAX); /* Use 64bit to
                                                                     * avoid overflow */
         UA_UInt32 increase = mod2(ns->count+1, size);
@@ -361,7 +639,8 @@ UA_NodeMap_insertNode(void *context, UA_Node *node,
 
         do {
             node->head.nodeId.identifier.numeric = (UA_UInt32)identifier;
-            slot = findFreeSlot(ns, &node->head.nodeId);
+            node->head.nodeIdHash = UA_NodeId_hash(&node->head.nodeId);
+            slot = findFreeSlot(t, &node->head.nodeId, node->head.nodeIdHash);
             if(slot)
                 break;
             identifier += increase;
@@ -376,7 +655,8 @@ UA_NodeMap_insertNode(void *context, UA_Node *node,
 #endif
         } while((UA_UInt32)identifier != startId);
     } else {
-        slot = findFreeSlot(ns, &node->head.nodeId);
+        node->head.nodeIdHash = UA_NodeId_hash(&node->head.nodeId);
+        slot = findFreeSlot(t, &node->head.nodeId, node->head.nodeIdHash);
     }
 
     if(!slot) {
@@ -415,10 +695,12 @@ UA_NodeMap_insertNode(void *context, UA_Node *node,
         ns->referenceTypeCounter++;
     }
 
-    /* Insert the node */
+    /* Insert the node. The entry is published after the hash is set. */
     UA_NodeMapEntry *newEntry = container_of(node, UA_NodeMapEntry, node);
-    slot->nodeIdHash = UA_NodeId_hash(&node->head.nodeId);
-    slot->entry = newEntry;
+    if(ns->concurrent)
+        switchReferenceKinds(newEntry);
+    slot->nodeIdHash = node->head.nodeIdHash;
+    NODEMAP_PUBLISH(slot->entry, newEntry);
     ++ns->count;
     return retval;
 }
@@ -428,24 +710,29 @@ UA_NodeMap_replaceNode(void *context, UA_Node *node) {
     UA_NodeMap *ns = (UA_NodeMap*)context;
     UA_NodeMapEntry *newEntry = container_of(node, UA_NodeMapEntry, node);
 
-    /* Find the node */
-    UA_NodeMapSlot *slot = findOccupiedSlot(ns, &node->head.nodeId);
+    /* Find the node. Copies keep the hash of the original. */
+    if(node->head.nodeIdHash == 0)
+        node->head.nodeIdHash = UA_NodeId_hash(&node->head.nodeId);
+    UA_NodeMapEntry *oldEntry;
+    UA_NodeMapSlot *slot = findOccupiedSlotHash(ns->table, &node->head.nodeId,
+                                                node->head.nodeIdHash, &oldEntry);
     if(!slot) {
         deleteNodeMapEntry(newEntry);
         return UA_STATUSCODE_BADNODEIDUNKNOWN;
     }
 
     /* The node was already updated since the copy was made? */
-    UA_NodeMapEntry *oldEntry = slot->entry;
     if(oldEntry != newEntry->orig) {
         deleteNodeMapEntry(newEntry);
         return UA_STATUSCODE_BADINTERNALERROR;
     }
 
     /* Replace the entry */
-    slot->entry = newEntry;
-    oldEntry->deleted = true;
-    cleanupNodeMapEntry(oldEntry);
+    newEntry->orig = NULL;
+    if(ns->concurrent)
+        switchReferenceKinds(newEntry);
+    NODEMAP_PUBLISH(slot->entry, newEntry);
+    retireEntry(ns, oldEntry);
     return UA_STATUSCODE_GOOD;
 }
 
@@ -461,16 +748,87 @@ static void
 UA_NodeMap_iterate(void *context, UA_NodestoreVisitor visitor,
                    void *visitorContext) {
     UA_NodeMap *ns = (UA_NodeMap*)context;
-    for(UA_UInt32 i = 0; i < ns->size; ++i) {
-        UA_NodeMapSlot *slot = &ns->slots[i];
-        if(slot->entry > UA_NODEMAP_TOMBSTONE) {
+    for(UA_UInt32 i = 0; i < ns->table->size; ++i) {
+        UA_NodeMapSlot *slot = &ns->table->slots[i];
+        UA_NodeMapEntry *entry = slot->entry;
+        if(entry > UA_NODEMAP_TOMBSTONE) {
             /* The visitor can delete the node. So refcount here. */
-            slot->entry->refCount++;
-            visitor(visitorContext, &slot->entry->node);
-            slot->entry->refCount--;
-            cleanupNodeMapEntry(slot->entry);
+            NODEMAP_INC(entry->refCount);
+            visitor(visitorContext, &entry->node);
+            NODEMAP_DEC(entry->refCount);
+            if(!ns->concurrent)
+                cleanupNodeMapEntry(entry);
         }
     }
+    if(ns->concurrent)
+        reclaimRetired(ns);
+}
+
+/* Align the packed entries to the largest member alignment */
+#define UA_NODEMAP_PACKALIGN(size) (((size) + 7) & ~(size_t)7)
+
+static int
+cmpSlotNodeId(const void *a, const void *b) {
+    const UA_NodeMapSlot *sa = *(UA_NodeMapSlot * const *)a;
+    const UA_NodeMapSlot *sb = *(UA_NodeMapSlot * const *)b;
+    return (int)UA_NodeId_order(&sa->entry->node.head.nodeId,
+                                &sb->entry->node.head.nodeId);
+}
+
+/* Must not run concurrently with readers. The moved entries are freed
+ * immediately. Entries that are currently in use or that have outstanding
+ * copies remain where they are. */
+static void
+UA_NodeMap_compact(void *context) {
+    UA_NodeMap *ns = (UA_NodeMap*)context;
+    UA_NodeMapTable *t = ns->table;
+
+    /* Collect the slots of the entries that can be moved */
+    UA_NodeMapSlot **move = (UA_NodeMapSlot**)
+        UA_malloc(sizeof(UA_NodeMapSlot*) * (ns->count + 1));
+    if(!move)
+        return; /* Can fail. Just continue without packing. */
+    size_t moveSize = 0;
+    size_t blockSize = 0;
+    for(UA_UInt32 i = 0; i < t->size; ++i) {
+        UA_NodeMapEntry *entry = t->slots[i].entry;
+        if(entry <= UA_NODEMAP_TOMBSTONE || entry->packed ||
+           entry->refCount > 0 || entry->editCopy)
+            continue;
+        move[moveSize++] = &t->slots[i];
+        blockSize += UA_NODEMAP_PACKALIGN(entrySize(entry->node.head.nodeClass));
+    }
+    if(moveSize == 0) {
+        UA_free(move);
+        return;
+    }
+
+    /* Sort by NodeId so that neighboring NodeIds are close in memory */
+    qsort(move, moveSize, sizeof(UA_NodeMapSlot*), cmpSlotNodeId);
+
+    UA_NodeMapBlock *block = (UA_NodeMapBlock*)
+        UA_malloc(UA_NODEMAP_PACKALIGN(sizeof(UA_NodeMapBlock)) + blockSize);
+    if(!block) {
+        UA_free(move);
+        return;
+    }
+    block->next = ns->blocks;
+    ns->blocks = block;
+
+    /* Move the entries. The node content (strings, references, etc.) is taken
+     * over without a deep copy. */
+    uintptr_t pos = (uintptr_t)block + UA_NODEMAP_PACKALIGN(sizeof(UA_NodeMapBlock));
+    for(size_t i = 0; i < moveSize; i++) {
+        UA_NodeMapEntry *entry = move[i]->entry;
+        size_t size = entrySize(entry->node.head.nodeClass);
+        UA_NodeMapEntry *packed = (UA_NodeMapEntry*)pos;
+        memcpy(packed, entry, size);
+        packed->packed = true;
+        move[i]->entry = packed;
+        UA_free(entry);
+        pos += UA_NODEMAP_PACKALIGN(size);
+    }
+    UA_free(move);
 }
 
 static void
@@ -480,8 +838,8 @@ UA_NodeMap_delete(void *context) {
         return;
 
     UA_NodeMap *ns = (UA_NodeMap*)context;
-    UA_UInt32 size = ns->size;
-    UA_NodeMapSlot *slots = ns->slots;
+    UA_UInt32 size = ns->table->size;
+    UA_NodeMapSlot *slots = ns->table->slots;
     for(UA_UInt32 i = 0; i < size; ++i) {
         if(slots[i].entry > UA_NODEMAP_TOMBSTONE) {
             /* On debugging builds, check that all nodes were release */
@@ -490,7 +848,19 @@ UA_NodeMap_delete(void *context) {
             deleteNodeMapEntry(slots[i].entry);
         }
     }
-    UA_free(ns->slots);
+    UA_free(ns->table);
+
+    /* No readers must remain. Delete the retired memory. */
+    UA_assert(ns->readers == 0);
+    reclaimRetired(ns);
+    UA_assert(ns->retiredEntries == NULL);
+
+    /* Free the memory of the packed entries */
+    while(ns->blocks) {
+        UA_NodeMapBlock *block = ns->blocks;
+        ns->blocks = block->next;
+        UA_free(block);
+    }
 
     /* Clean up the ReferenceTypes index array */
     for(size_t i = 0; i < ns->referenceTypeCounter; i++)
@@ -499,23 +869,18 @@ UA_NodeMap_delete(void *context) {
     UA_free(ns);
 }
 
-UA_StatusCode
-UA_Nodestore_HashMap(UA_Nodestore *ns) {
+static UA_StatusCode
+initNodeMap(UA_Nodestore *ns, UA_Boolean concurrent) {
     /* Allocate and initialize the nodemap */
-    UA_NodeMap *nodemap = (UA_NodeMap*)UA_malloc(sizeof(UA_NodeMap));
+    UA_NodeMap *nodemap = (UA_NodeMap*)UA_calloc(1, sizeof(UA_NodeMap));
     if(!nodemap)
         return UA_STATUSCODE_BADOUTOFMEMORY;
-    nodemap->sizePrimeIndex = higher_prime_index(UA_NODEMAP_MINSIZE);
-    nodemap->size = primes[nodemap->sizePrimeIndex];
-    nodemap->count = 0;
-    nodemap->slots = (UA_NodeMapSlot*)
-        UA_calloc(nodemap->size, sizeof(UA_NodeMapSlot));
-    if(!nodemap->slots) {
+    nodemap->table = newTable(higher_prime_index(UA_NODEMAP_MINSIZE));
+    if(!nodemap->table) {
         UA_free(nodemap);
         return UA_STATUSCODE_BADOUTOFMEMORY;
     }
-
-    nodemap->referenceTypeCounter = 0;
+    nodemap->concurrent = concurrent;
 
     /* Populate the nodestore */
     ns->context = nodemap;
@@ -524,13 +889,23 @@ UA_Nodestore_HashMap(UA_Nodestore *ns) {
     ns->deleteNode = UA_NodeMap_deleteNode;
     ns->getNode = UA_NodeMap_getNode;
     ns->getNodeFromPtr = UA_NodeMap_getNodeFromPtr;
+    ns->getNodes = UA_NodeMap_getNodes;
     ns->releaseNode = UA_NodeMap_releaseNode;
+    ns->releaseEditNode = UA_NodeMap_releaseEditNode;
     ns->getNodeCopy = UA_NodeMap_getNodeCopy;
     ns->insertNode = UA_NodeMap_insertNode;
     ns->replaceNode = UA_NodeMap_replaceNode;
     ns->removeNode = UA_NodeMap_removeNode;
     ns->getReferenceTypeId = UA_NodeMap_getReferenceTypeId;
     ns->iterate = UA_NodeMap_iterate;
+    ns->compact = UA_NodeMap_compact;
+    ns->concurrentReads = concurrent;
+
+    if(concurrent) {
+        ns->getEditNode = UA_NodeMap_getEditNodeCopy;
+        ns->getEditNodeFromPtr = UA_NodeMap_getEditNodeCopyFromPtr;
+        return UA_STATUSCODE_GOOD;
+    }
 
     /* All nodes are stored in RAM. Changes are made in-situ. GetEditNode is
      * identical to GetNode -- but the Node pointer is non-const. */
@@ -547,3 +922,13 @@ UA_Nodestore_HashMap(UA_Nodestore *ns) {
 
     return UA_STATUSCODE_GOOD;
 }
+
+UA_StatusCode
+UA_Nodestore_HashMap(UA_Nodestore *ns) {
+    return initNodeMap(ns, false);
+}
+
+UA_StatusCode
+UA_Nodestore_ConcurrentHashMap(UA_Nodestore *ns) {
+    return initNodeMap(ns, true);
+}
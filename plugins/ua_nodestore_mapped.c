@@ -0,0 +1,1009 @@
+/* This work is licensed under a Creative Commons CCZero 1.0 Universal License.
+ * See http://creativecommons.org/publicdomain/zero/1.0/ for more information. */
+
+#include <open62541/types.h>
+#include <open62541/plugin/nodestore_default.h>
+
+#ifdef UA_ARCHITECTURE_POSIX
+
+#include "ziptree.h"
+#include "open62541_queue.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifndef container_of
+#define container_of(ptr, type, member) \
+    (type *)((uintptr_t)ptr - offsetof(type,member))
+#endif
+
+/* The MappedFile Nodestore serves the nodes of an address space snapshot (see
+ * UA_Server_saveAddressSpaceSnapshot) from a memory-mapped file. When the file
+ * is opened, it is scanned once to build a compact hash index from the NodeId
+ * to the offset of the encoded node. Nodes are decoded on demand into a cache
+ * with least-recently-used eviction.
+ *
+ * Nodes that are added, edited or removed are kept in an in-memory overlay
+ * tree. The overlay takes precedence over the file. Removed file nodes are
+ * recorded as tombstones in the overlay. Editing a file node moves it from the
+ * cache into the overlay.
+ *
+ * ReferenceTypes from the file are moved to the overlay when they are first
+ * used. Then they get a ReferenceTypeIndex and are added to the subtype sets of
+ * their supertypes. The nodes of namespace 0 are created by the server. After
+ * the server created namespace 0 it calls ``compact``. Then all ReferenceTypes
+ * of the file are resolved and the references from namespace 0 nodes into the
+ * other namespaces are added from the file. The inverse HasTypeDefinition
+ * references of the type nodes are not added, so that the type nodes do not
+ * grow with the number of instances in the file.
+ *
+ * With UA_Nodestore_MappedFileNs0 the namespace 0 nodes are also served from
+ * the file and the server does not create them. The base ReferenceTypes are
+ * resolved when the file is opened with the same ReferenceTypeIndex the
+ * server uses (UA_REFERENCETYPEINDEX_*). Only the namespace 0 nodes the server
+ * edits during startup (data sources, method callbacks) end up in the overlay.
+ * All other namespace 0 nodes stay in the file until they are used. */
+
+typedef enum {
+    MAPPED_ENTRY_NEW = 0,  /* Not yet inserted */
+    MAPPED_ENTRY_OVERLAY,  /* Member of the overlay tree */
+    MAPPED_ENTRY_CACHED,   /* Decoded from the file, member of the cache */
+    MAPPED_ENTRY_DETACHED, /* No longer in a tree. Deleted when released. */
+    MAPPED_ENTRY_TOMBSTONE /* Overlay entry for a removed file node */
+} MappedEntryState;
+
+struct MappedEntry;
+typedef struct MappedEntry MappedEntry;
+
+struct MappedEntry {
+    ZIP_ENTRY(MappedEntry) zipfields;
+    TAILQ_ENTRY(MappedEntry) lruEntry; /* Only for cached entries */
+    MappedEntry *orig; /* The version this is a copy from (or NULL) */
+    UA_UInt32 nodeIdHash;
+    UA_UInt32 refCount; /* How many consumers have a reference to the node? */
+    UA_Byte state;
+    UA_Node node; /* Has to be the last entry. Allocated for the NodeClass. */
+};
+
+static enum ZIP_CMP
+cmpMappedEntry(const void *a, const void *b) {
+    const MappedEntry *aa = (const MappedEntry*)a;
+    const MappedEntry *bb = (const MappedEntry*)b;
+    if(aa->nodeIdHash < bb->nodeIdHash)
+        return ZIP_CMP_LESS;
+    if(aa->nodeIdHash > bb->nodeIdHash)
+        return ZIP_CMP_MORE;
+    return (enum ZIP_CMP)UA_NodeId_order(&aa->node.head.nodeId,
+                                         &bb->node.head.nodeId);
+}
+
+ZIP_HEAD(MappedTree, MappedEntry);
+typedef struct MappedTree MappedTree;
+ZIP_FUNCTIONS(MappedTree, MappedEntry, zipfields, MappedEntry, zipfields, cmpMappedEntry)
+
+/* Slot of the file index. Offset zero marks an empty slot (the file starts
+ * with the header). */
+typedef struct {
+    UA_UInt64 offset;
+    UA_UInt32 nodeIdHash;
+} MappedIndexSlot;
+
+TAILQ_HEAD(MappedLru, MappedEntry);
+typedef struct MappedLru MappedLru;
+
+typedef struct {
+    UA_Nodestore ns; /* Copy of the Nodestore for decoding */
+
+    MappedTree overlay;
+    MappedTree cache;
+    MappedLru lru; /* Most recently used first */
+    size_t cacheSize;
+    size_t cacheCapacity;
+
+    /* The mapped file */
+    UA_ByteString image;
+    const UA_DataTypeArray *customTypes;
+    MappedIndexSlot *index;
+    UA_UInt32 indexMask;
+    UA_UInt32 indexCount;
+
+    /* File nodes that are linked when compact is called */
+    UA_UInt64 *ns0Nodes;
+    size_t ns0NodesSize;
+    UA_UInt64 *refTypeNodes;
+    size_t refTypeNodesSize;
+    UA_Boolean linked;
+    UA_Boolean serveNs0; /* The namespace 0 nodes of the file are visible */
+
+    /* Maps ReferenceTypeIndex to the NodeId of the ReferenceType */
+    UA_NodeId referenceTypeIds[UA_REFERENCETYPESET_MAX];
+    UA_Byte referenceTypeCounter;
+} MappedContext;
+
+/***********/
+/* Entries */
+/***********/
+
+static size_t
+entrySize(UA_NodeClass nodeClass) {
+    size_t size = sizeof(MappedEntry) - sizeof(UA_Node);
+    switch(nodeClass) {
+    case UA_NODECLASS_OBJECT: return size + sizeof(UA_ObjectNode);
+    case UA_NODECLASS_VARIABLE: return size + sizeof(UA_VariableNode);
+    case UA_NODECLASS_METHOD: return size + sizeof(UA_MethodNode);
+    case UA_NODECLASS_OBJECTTYPE: return size + sizeof(UA_ObjectTypeNode);
+    case UA_NODECLASS_VARIABLETYPE: return size + sizeof(UA_VariableTypeNode);
+    case UA_NODECLASS_REFERENCETYPE: return size + sizeof(UA_ReferenceTypeNode);
+    case UA_NODECLASS_DATATYPE: return size + sizeof(UA_DataTypeNode);
+    case UA_NODECLASS_VIEW: return size + sizeof(UA_ViewNode);
+    default: return 0;
+    }
+}
+
+static MappedEntry *
+newEntry(UA_NodeClass nodeClass) {
+    size_t size = entrySize(nodeClass);
+    if(size == 0)
+        return NULL;
+    MappedEntry *entry = (MappedEntry*)UA_calloc(1, size);
+    if(!entry)
+        return NULL;
+    entry->node.head.nodeClass = nodeClass;
+    return entry;
+}
+
+static void
+deleteEntry(MappedEntry *entry) {
+    UA_Node_clear(&entry->node);
+    UA_free(entry);
+}
+
+/* The dummy is only used as a search key */
+static MappedEntry *
+findEntry(MappedTree *tree, const UA_NodeId *nodeId) {
+    MappedEntry dummy;
+    dummy.nodeIdHash = UA_NodeId_hash(nodeId);
+    dummy.node.head.nodeId = *nodeId;
+    return ZIP_FIND(MappedTree, tree, &dummy);
+}
+
+static void
+detachCached(MappedContext *ctx, MappedEntry *entry) {
+    ZIP_REMOVE(MappedTree, &ctx->cache, entry);
+    TAILQ_REMOVE(&ctx->lru, entry, lruEntry);
+    ctx->cacheSize--;
+    entry->state = MAPPED_ENTRY_DETACHED;
+    if(entry->refCount == 0)
+        deleteEntry(entry);
+}
+
+/* Evict unused entries, beginning with the least recently used */
+static void
+evictCached(MappedContext *ctx) {
+    MappedEntry *entry, *prev;
+    TAILQ_FOREACH_REVERSE_SAFE(entry, &ctx->lru, MappedLru, lruEntry, prev) {
+        if(ctx->cacheSize <= ctx->cacheCapacity)
+            return;
+        if(entry->refCount == 0)
+            detachCached(ctx, entry);
+    }
+}
+
+/**************/
+/* File Index */
+/**************/
+
+static UA_StatusCode
+decodeNodeIdAt(const MappedContext *ctx, UA_UInt64 offset, UA_NodeId *nodeId) {
+    /* Skip the NodeClass in front of the NodeId */
+    UA_ByteString view;
+    view.data = ctx->image.data + offset + 4;
+    view.length = ctx->image.length - (size_t)offset - 4;
+    return UA_decodeBinary(&view, nodeId, &UA_TYPES[UA_TYPES_NODEID], NULL);
+}
+
+/* Returns zero if the NodeId is not contained in the file. The namespace 0
+ * nodes of the file are not visible unless serveNs0 is set. Otherwise
+ * namespace 0 is created by the server. */
+static UA_UInt64
+indexLookup(const MappedContext *ctx, const UA_NodeId *nodeId) {
+    if(!ctx->index || (nodeId->namespaceIndex == 0 && !ctx->serveNs0))
+        return 0;
+    UA_UInt32 h = UA_NodeId_hash(nodeId);
+    for(UA_UInt32 i = h & ctx->indexMask; ctx->index[i].offset != 0;
+        i = (i + 1) & ctx->indexMask) {
+        if(ctx->index[i].nodeIdHash != h)
+            continue;
+        UA_NodeId id;
+        if(decodeNodeIdAt(ctx, ctx->index[i].offset, &id) != UA_STATUSCODE_GOOD)
+            continue;
+        UA_Boolean eq = UA_NodeId_equal(&id, nodeId);
+        UA_NodeId_clear(&id);
+        if(eq)
+            return ctx->index[i].offset;
+    }
+    return 0;
+}
+
+static void
+indexInsert(MappedIndexSlot *index, UA_UInt32 mask,
+            UA_UInt64 offset, UA_UInt32 nodeIdHash) {
+    UA_UInt32 i = nodeIdHash & mask;
+    while(index[i].offset != 0)
+        i = (i + 1) & mask;
+    index[i].offset = offset;
+    index[i].nodeIdHash = nodeIdHash;
+}
+
+/* Keep the load factor below 50% */
+static UA_StatusCode
+indexGrow(MappedContext *ctx) {
+    UA_UInt32 size = (ctx->index) ? (ctx->indexMask + 1) : 0;
+    if(ctx->indexCount * 2 < size)
+        return UA_STATUSCODE_GOOD;
+    UA_UInt32 nsize = (size == 0) ? 1024 : size * 2;
+    MappedIndexSlot *nindex = (MappedIndexSlot*)
+        UA_calloc(nsize, sizeof(MappedIndexSlot));
+    if(!nindex)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    for(UA_UInt32 i = 0; i < size; i++) {
+        if(ctx->index[i].offset != 0)
+            indexInsert(nindex, nsize - 1, ctx->index[i].offset,
+                        ctx->index[i].nodeIdHash);
+    }
+    UA_free(ctx->index);
+    ctx->index = nindex;
+    ctx->indexMask = nsize - 1;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Scan all nodes of the file once */
+static UA_StatusCode
+buildIndex(MappedContext *ctx) {
+    size_t offset = 0;
+    size_t nsSize = 0;
+    UA_String *namespaces = NULL;
+    UA_StatusCode res =
+        UA_AddressSpaceSnapshot_decodeHeader(&ctx->image, &offset,
+                                             &nsSize, &namespaces);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    UA_Array_delete(namespaces, nsSize, &UA_TYPES[UA_TYPES_STRING]);
+
+    while(true) {
+        size_t nodeOffset = offset;
+        UA_Node *node = NULL;
+        res = UA_AddressSpaceSnapshot_decodeNode(&ctx->image, &offset, NULL,
+                                                 ctx->customTypes, &node);
+        if(res != UA_STATUSCODE_GOOD || !node)
+            return res;
+
+        res = indexGrow(ctx);
+        if(res == UA_STATUSCODE_GOOD) {
+            indexInsert(ctx->index, ctx->indexMask, nodeOffset,
+                        UA_NodeId_hash(&node->head.nodeId));
+            ctx->indexCount++;
+        }
+
+        /* Remember the nodes that are linked after namespace 0 was created */
+        if(res == UA_STATUSCODE_GOOD && node->head.nodeId.namespaceIndex == 0 &&
+           !ctx->serveNs0) {
+            UA_UInt64 o = nodeOffset;
+            res = UA_Array_appendCopy((void**)&ctx->ns0Nodes, &ctx->ns0NodesSize,
+                                      &o, &UA_TYPES[UA_TYPES_UINT64]);
+        } else if(res == UA_STATUSCODE_GOOD &&
+                  node->head.nodeClass == UA_NODECLASS_REFERENCETYPE) {
+            UA_UInt64 o = nodeOffset;
+            res = UA_Array_appendCopy((void**)&ctx->refTypeNodes, &ctx->refTypeNodesSize,
+                                      &o, &UA_TYPES[UA_TYPES_UINT64]);
+        }
+
+        UA_Node_clear(node);
+        UA_free(node);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+}
+
+/*******************/
+/* ReferenceTypes  */
+/*******************/
+
+static UA_StatusCode
+assignReferenceTypeIndex(MappedContext *ctx, UA_ReferenceTypeNode *refNode) {
+    /* Reuse the index if the ReferenceType was known before */
+    UA_Byte index = 0;
+    for(; index < ctx->referenceTypeCounter; index++) {
+        if(UA_NodeId_equal(&ctx->referenceTypeIds[index], &refNode->head.nodeId))
+            break;
+    }
+    if(index == ctx->referenceTypeCounter) {
+        if(ctx->referenceTypeCounter >= UA_REFERENCETYPESET_MAX)
+            return UA_STATUSCODE_BADINTERNALERROR;
+        UA_StatusCode res =
+            UA_NodeId_copy(&refNode->head.nodeId, &ctx->referenceTypeIds[index]);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+        ctx->referenceTypeCounter++;
+    }
+    refNode->referenceTypeIndex = index;
+    refNode->subTypes = UA_REFTYPESET(index);
+    return UA_STATUSCODE_GOOD;
+}
+
+static const UA_Node *
+mappedGetNode(void *nsCtx, const UA_NodeId *nodeId, UA_UInt32 attributeMask,
+              UA_ReferenceTypeSet references, UA_BrowseDirection referenceDirections);
+
+static void
+mappedReleaseNode(void *nsCtx, const UA_Node *node);
+
+static void *
+addSubtypeToSupertype(void *context, UA_ReferenceTarget *t);
+
+/* Add the subtype set to all ReferenceTypes upwards in the hierarchy. The
+ * supertypes are moved to the overlay when they are retrieved. */
+typedef struct {
+    MappedContext *ctx;
+    UA_ReferenceTypeSet subTypes;
+} SubtypeContext;
+
+static void
+addSubtypeToSupertypes(SubtypeContext *sc, const UA_Node *node) {
+    for(size_t i = 0; i < node->head.referencesSize; i++) {
+        UA_NodeReferenceKind *rk = &node->head.references[i];
+        if(rk->referenceTypeIndex == UA_REFERENCETYPEINDEX_HASSUBTYPE && rk->isInverse)
+            UA_NodeReferenceKind_iterate(rk, addSubtypeToSupertype, sc);
+    }
+}
+
+static void *
+addSubtypeToSupertype(void *context, UA_ReferenceTarget *t) {
+    SubtypeContext *sc = (SubtypeContext*)context;
+    if(!UA_NodePointer_isLocal(t->targetId))
+        return NULL;
+    UA_NodeId id = UA_NodePointer_toNodeId(t->targetId);
+    const UA_Node *parent = mappedGetNode(sc->ctx, &id, 0, UA_REFERENCETYPESET_NONE,
+                                          UA_BROWSEDIRECTION_INVALID);
+    if(!parent)
+        return NULL;
+    if(parent->head.nodeClass == UA_NODECLASS_REFERENCETYPE) {
+        UA_ReferenceTypeNode *pn = (UA_ReferenceTypeNode*)(uintptr_t)parent;
+        pn->subTypes = UA_ReferenceTypeSet_union(pn->subTypes, sc->subTypes);
+        addSubtypeToSupertypes(sc, parent);
+    }
+    mappedReleaseNode(sc->ctx, parent);
+    return NULL;
+}
+
+/* Insert a ReferenceType decoded from the file into the overlay */
+static UA_StatusCode
+promoteReferenceType(MappedContext *ctx, MappedEntry *entry) {
+    UA_ReferenceTypeNode *refNode = &entry->node.referenceTypeNode;
+    UA_StatusCode res = assignReferenceTypeIndex(ctx, refNode);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    entry->state = MAPPED_ENTRY_OVERLAY;
+    ZIP_INSERT(MappedTree, &ctx->overlay, entry);
+    SubtypeContext sc = {ctx, refNode->subTypes};
+    addSubtypeToSupertypes(&sc, &entry->node);
+    return UA_STATUSCODE_GOOD;
+}
+
+/***********************/
+/* Interface functions */
+/***********************/
+
+/* Not yet inserted */
+static UA_Node *
+mappedNewNode(void *nsCtx, UA_NodeClass nodeClass) {
+    MappedEntry *entry = newEntry(nodeClass);
+    if(!entry)
+        return NULL;
+    return &entry->node;
+}
+
+/* Not yet inserted */
+static void
+mappedDeleteNode(void *nsCtx, UA_Node *node) {
+    deleteEntry(container_of(node, MappedEntry, node));
+}
+
+/* Decode a node from the file without adding it to a tree */
+static MappedEntry *
+decodeEntry(MappedContext *ctx, UA_UInt64 offset) {
+    size_t pos = (size_t)offset;
+    UA_Node *node = NULL;
+    UA_StatusCode res =
+        UA_AddressSpaceSnapshot_decodeNode(&ctx->image, &pos, &ctx->ns,
+                                           ctx->customTypes, &node);
+    if(res != UA_STATUSCODE_GOOD || !node)
+        return NULL;
+    MappedEntry *entry = container_of(node, MappedEntry, node);
+    entry->nodeIdHash = UA_NodeId_hash(&node->head.nodeId);
+    node->head.nodeIdHash = entry->nodeIdHash;
+    return entry;
+}
+
+static const UA_Node *
+mappedGetNode(void *nsCtx, const UA_NodeId *nodeId, UA_UInt32 attributeMask,
+              UA_ReferenceTypeSet references, UA_BrowseDirection referenceDirections) {
+    MappedContext *ctx = (MappedContext*)nsCtx;
+
+    /* The overlay takes precedence */
+    MappedEntry *entry = findEntry(&ctx->overlay, nodeId);
+    if(entry) {
+        if(entry->state == MAPPED_ENTRY_TOMBSTONE)
+            return NULL;
+        ++entry->refCount;
+        return &entry->node;
+    }
+
+    /* Cache hit */
+    entry = findEntry(&ctx->cache, nodeId);
+    if(entry) {
+        TAILQ_REMOVE(&ctx->lru, entry, lruEntry);
+        TAILQ_INSERT_HEAD(&ctx->lru, entry, lruEntry);
+        ++entry->refCount;
+        return &entry->node;
+    }
+
+    /* Decode from the file */
+    UA_UInt64 offset = indexLookup(ctx, nodeId);
+    if(offset == 0)
+        return NULL;
+    entry = decodeEntry(ctx, offset);
+    if(!entry)
+        return NULL;
+
+    /* ReferenceTypes need a ReferenceTypeIndex that is stable */
+    if(entry->node.head.nodeClass == UA_NODECLASS_REFERENCETYPE) {
+        if(promoteReferenceType(ctx, entry) != UA_STATUSCODE_GOOD) {
+            deleteEntry(entry);
+            return NULL;
+        }
+        ++entry->refCount;
+        return &entry->node;
+    }
+
+    entry->state = MAPPED_ENTRY_CACHED;
+    entry->refCount = 1;
+    ZIP_INSERT(MappedTree, &ctx->cache, entry);
+    TAILQ_INSERT_HEAD(&ctx->lru, entry, lruEntry);
+    ctx->cacheSize++;
+    evictCached(ctx);
+    return &entry->node;
+}
+
+static const UA_Node *
+mappedGetNodeFromPtr(void *nsCtx, UA_NodePointer ptr, UA_UInt32 attributeMask,
+                     UA_ReferenceTypeSet references,
+                     UA_BrowseDirection referenceDirections) {
+    if(!UA_NodePointer_isLocal(ptr))
+        return NULL;
+    UA_NodeId id = UA_NodePointer_toNodeId(ptr);
+    return mappedGetNode(nsCtx, &id, attributeMask, references, referenceDirections);
+}
+
+/* Edited nodes are moved to the overlay. So the changes persist. */
+static UA_Node *
+mappedGetEditNode(void *nsCtx, const UA_NodeId *nodeId, UA_UInt32 attributeMask,
+                  UA_ReferenceTypeSet references, UA_BrowseDirection referenceDirections) {
+    MappedContext *ctx = (MappedContext*)nsCtx;
+    const UA_Node *node = mappedGetNode(nsCtx, nodeId, attributeMask,
+                                        references, referenceDirections);
+    if(!node)
+        return NULL;
+    MappedEntry *entry = container_of(node, MappedEntry, node);
+    if(entry->state == MAPPED_ENTRY_CACHED) {
+        ZIP_REMOVE(MappedTree, &ctx->cache, entry);
+        TAILQ_REMOVE(&ctx->lru, entry, lruEntry);
+        ctx->cacheSize--;
+        entry->state = MAPPED_ENTRY_OVERLAY;
+        ZIP_INSERT(MappedTree, &ctx->overlay, entry);
+    }
+    return (UA_Node*)(uintptr_t)node;
+}
+
+static UA_Node *
+mappedGetEditNodeFromPtr(void *nsCtx, UA_NodePointer ptr, UA_UInt32 attributeMask,
+                         UA_ReferenceTypeSet references,
+                         UA_BrowseDirection referenceDirections) {
+    if(!UA_NodePointer_isLocal(ptr))
+        return NULL;
+    UA_NodeId id = UA_NodePointer_toNodeId(ptr);
+    return mappedGetEditNode(nsCtx, &id, attributeMask, references, referenceDirections);
+}
+
+static void
+mappedReleaseNode(void *nsCtx, const UA_Node *node) {
+    if(!node)
+        return;
+    MappedContext *ctx = (MappedContext*)nsCtx;
+    MappedEntry *entry = container_of(node, MappedEntry, node);
+    UA_assert(entry->refCount > 0);
+    --entry->refCount;
+    if(entry->refCount > 0)
+        return;
+    if(entry->state == MAPPED_ENTRY_DETACHED)
+        deleteEntry(entry);
+    else if(entry->state == MAPPED_ENTRY_CACHED)
+        evictCached(ctx);
+}
+
+static UA_StatusCode
+mappedGetNodeCopy(void *nsCtx, const UA_NodeId *nodeId, UA_Node **outNode) {
+    /* The copy replaces an overlay entry */
+    UA_Node *node = mappedGetEditNode(nsCtx, nodeId, UA_NODEATTRIBUTESMASK_ALL,
+                                      UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    if(!node)
+        return UA_STATUSCODE_BADNODEIDUNKNOWN;
+
+    MappedEntry *ne = newEntry(node->head.nodeClass);
+    if(!ne) {
+        mappedReleaseNode(nsCtx, node);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+
+    UA_StatusCode res = UA_Node_copy(node, &ne->node);
+    mappedReleaseNode(nsCtx, node);
+    if(res != UA_STATUSCODE_GOOD) {
+        deleteEntry(ne);
+        return res;
+    }
+
+    ne->orig = container_of(node, MappedEntry, node);
+    *outNode = &ne->node;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Remove the overlay entry. Deleted once it is no longer used. */
+static void
+removeOverlayEntry(MappedContext *ctx, MappedEntry *entry) {
+    ZIP_REMOVE(MappedTree, &ctx->overlay, entry);
+    entry->state = MAPPED_ENTRY_DETACHED;
+    if(entry->refCount == 0)
+        deleteEntry(entry);
+}
+
+static UA_StatusCode
+mappedInsertNode(void *nsCtx, UA_Node *node, UA_NodeId *addedNodeId) {
+    MappedContext *ctx = (MappedContext*)nsCtx;
+    MappedEntry *entry = container_of(node, MappedEntry, node);
+
+    /* Create a random NodeId until we find an unoccupied id */
+    if(node->head.nodeId.identifierType == UA_NODEIDTYPE_NUMERIC &&
+       node->head.nodeId.identifier.numeric == 0) {
+        do {
+            UA_UInt32 numId = UA_UInt32_random();
+#if SIZE_MAX <= UA_UINT32_MAX
+            if(numId >= (0x01 << 24))
+                numId = numId % (0x01 << 24);
+#endif
+            node->head.nodeId.identifier.numeric = numId;
+        } while(findEntry(&ctx->overlay, &node->head.nodeId) ||
+                indexLookup(ctx, &node->head.nodeId) != 0);
+    }
+
+    /* Ensure that the NodeId is unique. A tombstone is replaced. */
+    MappedEntry *existing = findEntry(&ctx->overlay, &node->head.nodeId);
+    if(existing && existing->state != MAPPED_ENTRY_TOMBSTONE) {
+        deleteEntry(entry);
+        return UA_STATUSCODE_BADNODEIDEXISTS;
+    }
+    if(!existing && indexLookup(ctx, &node->head.nodeId) != 0) {
+        deleteEntry(entry);
+        return UA_STATUSCODE_BADNODEIDEXISTS;
+    }
+
+    if(addedNodeId) {
+        UA_StatusCode res = UA_NodeId_copy(&node->head.nodeId, addedNodeId);
+        if(res != UA_STATUSCODE_GOOD) {
+            deleteEntry(entry);
+            return res;
+        }
+    }
+
+    if(node->head.nodeClass == UA_NODECLASS_REFERENCETYPE) {
+        UA_StatusCode res = assignReferenceTypeIndex(ctx, &node->referenceTypeNode);
+        if(res != UA_STATUSCODE_GOOD) {
+            deleteEntry(entry);
+            return res;
+        }
+    }
+
+    /* The overlay version shadows the cached version */
+    if(existing)
+        removeOverlayEntry(ctx, existing);
+    MappedEntry *cached = findEntry(&ctx->cache, &node->head.nodeId);
+    if(cached)
+        detachCached(ctx, cached);
+
+    entry->nodeIdHash = UA_NodeId_hash(&node->head.nodeId);
+    node->head.nodeIdHash = entry->nodeIdHash;
+    entry->state = MAPPED_ENTRY_OVERLAY;
+    ZIP_INSERT(MappedTree, &ctx->overlay, entry);
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+mappedReplaceNode(void *nsCtx, UA_Node *node) {
+    MappedContext *ctx = (MappedContext*)nsCtx;
+    MappedEntry *entry = container_of(node, MappedEntry, node);
+    MappedEntry *oldEntry = findEntry(&ctx->overlay, &node->head.nodeId);
+    if(!oldEntry || oldEntry->state == MAPPED_ENTRY_TOMBSTONE) {
+        deleteEntry(entry);
+        return UA_STATUSCODE_BADNODEIDUNKNOWN;
+    }
+
+    /* The node was already updated since the copy was made? */
+    if(oldEntry != entry->orig) {
+        deleteEntry(entry);
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    removeOverlayEntry(ctx, oldEntry);
+    entry->orig = NULL;
+    entry->nodeIdHash = UA_NodeId_hash(&node->head.nodeId);
+    entry->state = MAPPED_ENTRY_OVERLAY;
+    ZIP_INSERT(MappedTree, &ctx->overlay, entry);
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+mappedRemoveNode(void *nsCtx, const UA_NodeId *nodeId) {
+    MappedContext *ctx = (MappedContext*)nsCtx;
+    MappedEntry *entry = findEntry(&ctx->overlay, nodeId);
+    if(entry && entry->state == MAPPED_ENTRY_TOMBSTONE)
+        return UA_STATUSCODE_BADNODEIDUNKNOWN;
+    UA_Boolean inFile = (indexLookup(ctx, nodeId) != 0);
+    if(!entry && !inFile)
+        return UA_STATUSCODE_BADNODEIDUNKNOWN;
+
+    /* Hide the node in the file. The NodeId can point into the removed node.
+     * So the tombstone is prepared first. */
+    MappedEntry *tomb = NULL;
+    if(inFile) {
+        tomb = (MappedEntry*)
+            UA_calloc(1, sizeof(MappedEntry) - sizeof(UA_Node) + sizeof(UA_NodeHead));
+        if(!tomb)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        UA_StatusCode res = UA_NodeId_copy(nodeId, &tomb->node.head.nodeId);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_free(tomb);
+            return res;
+        }
+        tomb->nodeIdHash = UA_NodeId_hash(nodeId);
+        tomb->state = MAPPED_ENTRY_TOMBSTONE;
+        nodeId = &tomb->node.head.nodeId;
+    }
+
+    MappedEntry *cached = findEntry(&ctx->cache, nodeId);
+    if(cached)
+        detachCached(ctx, cached);
+    if(entry)
+        removeOverlayEntry(ctx, entry);
+    if(tomb)
+        ZIP_INSERT(MappedTree, &ctx->overlay, tomb);
+    return UA_STATUSCODE_GOOD;
+}
+
+static const UA_NodeId *
+mappedGetReferenceTypeId(void *nsCtx, UA_Byte refTypeIndex) {
+    MappedContext *ctx = (MappedContext*)nsCtx;
+    if(refTypeIndex >= ctx->referenceTypeCounter)
+        return NULL;
+    return &ctx->referenceTypeIds[refTypeIndex];
+}
+
+/* Collect the overlay NodeIds first. The visitor can remove nodes. */
+typedef struct {
+    UA_NodeId *ids;
+    size_t idsSize;
+} OverlayIds;
+
+static void *
+countOverlayEntry(void *data, MappedEntry *entry) {
+    if(entry->state != MAPPED_ENTRY_TOMBSTONE)
+        ((OverlayIds*)data)->idsSize++;
+    return NULL;
+}
+
+static void *
+collectOverlayEntry(void *data, MappedEntry *entry) {
+    OverlayIds *oi = (OverlayIds*)data;
+    if(entry->state != MAPPED_ENTRY_TOMBSTONE &&
+       UA_NodeId_copy(&entry->node.head.nodeId, &oi->ids[oi->idsSize]) ==
+       UA_STATUSCODE_GOOD)
+        oi->idsSize++;
+    return NULL;
+}
+
+static void
+visitNodeId(MappedContext *ctx, const UA_NodeId *id,
+            UA_NodestoreVisitor visitor, void *visitorCtx) {
+    const UA_Node *node = mappedGetNode(ctx, id, 0, UA_REFERENCETYPESET_NONE,
+                                        UA_BROWSEDIRECTION_INVALID);
+    if(!node)
+        return;
+    visitor(visitorCtx, node);
+    mappedReleaseNode(ctx, node);
+}
+
+static void
+mappedIterate(void *nsCtx, UA_NodestoreVisitor visitor, void *visitorCtx) {
+    MappedContext *ctx = (MappedContext*)nsCtx;
+
+    /* Overlay nodes */
+    OverlayIds oi = {NULL, 0};
+    ZIP_ITER(MappedTree, &ctx->overlay, countOverlayEntry, &oi);
+    size_t count = oi.idsSize;
+    if(count > 0) {
+        oi.ids = (UA_NodeId*)UA_Array_new(count, &UA_TYPES[UA_TYPES_NODEID]);
+        if(!oi.ids)
+            return;
+        oi.idsSize = 0;
+        ZIP_ITER(MappedTree, &ctx->overlay, collectOverlayEntry, &oi);
+        for(size_t i = 0; i < oi.idsSize; i++)
+            visitNodeId(ctx, &oi.ids[i], visitor, visitorCtx);
+        UA_Array_delete(oi.ids, count, &UA_TYPES[UA_TYPES_NODEID]);
+    }
+
+    /* File nodes that are not shadowed by the overlay */
+    for(UA_UInt32 i = 0; ctx->index && i <= ctx->indexMask; i++) {
+        if(ctx->index[i].offset == 0)
+            continue;
+        UA_NodeId id;
+        if(decodeNodeIdAt(ctx, ctx->index[i].offset, &id) != UA_STATUSCODE_GOOD)
+            continue;
+        if((id.namespaceIndex != 0 || ctx->serveNs0) && !findEntry(&ctx->overlay, &id))
+            visitNodeId(ctx, &id, visitor, visitorCtx);
+        UA_NodeId_clear(&id);
+    }
+}
+
+/* Add the references from a namespace 0 node in the file to the node created
+ * by the server. References within namespace 0 are created by the server. */
+static void *
+linkReferenceTarget(void *context, UA_ReferenceTarget *t) {
+    void **lc = (void**)context;
+    UA_Node *node = (UA_Node*)lc[0];
+    const UA_NodeReferenceKind *rk = (const UA_NodeReferenceKind*)lc[1];
+    UA_ExpandedNodeId en = UA_NodePointer_toExpandedNodeId(t->targetId);
+    if(en.nodeId.namespaceIndex == 0 && en.namespaceUri.length == 0)
+        return NULL;
+    UA_Node_addReference(node, rk->referenceTypeIndex, !rk->isInverse,
+                         &en, t->targetNameHash);
+    return NULL;
+}
+
+static void
+linkNs0Node(MappedContext *ctx, UA_UInt64 offset) {
+    UA_NodeId id;
+    if(decodeNodeIdAt(ctx, offset, &id) != UA_STATUSCODE_GOOD)
+        return;
+    MappedEntry *entry = findEntry(&ctx->overlay, &id);
+    UA_NodeId_clear(&id);
+    if(!entry || entry->state != MAPPED_ENTRY_OVERLAY)
+        return;
+
+    MappedEntry *fileEntry = decodeEntry(ctx, offset);
+    if(!fileEntry)
+        return;
+    for(size_t i = 0; i < fileEntry->node.head.referencesSize; i++) {
+        UA_NodeReferenceKind *rk = &fileEntry->node.head.references[i];
+        if(rk->isInverse &&
+           rk->referenceTypeIndex == UA_REFERENCETYPEINDEX_HASTYPEDEFINITION)
+            continue;
+        void *lc[2] = {&entry->node, rk};
+        UA_NodeReferenceKind_iterate(rk, linkReferenceTarget, lc);
+    }
+    deleteEntry(fileEntry);
+}
+
+/* Move all ReferenceTypes of the file to the overlay */
+static void
+resolveReferenceTypes(MappedContext *ctx) {
+    for(size_t i = 0; i < ctx->refTypeNodesSize; i++) {
+        UA_NodeId id;
+        if(decodeNodeIdAt(ctx, ctx->refTypeNodes[i], &id) != UA_STATUSCODE_GOOD)
+            continue;
+        const UA_Node *node = mappedGetNode(ctx, &id, 0, UA_REFERENCETYPESET_NONE,
+                                            UA_BROWSEDIRECTION_INVALID);
+        if(node)
+            mappedReleaseNode(ctx, node);
+        UA_NodeId_clear(&id);
+    }
+}
+
+/* Called by the server after namespace 0 was created */
+static void
+mappedCompact(void *nsCtx) {
+    MappedContext *ctx = (MappedContext*)nsCtx;
+    if(ctx->linked)
+        return;
+    ctx->linked = true;
+    resolveReferenceTypes(ctx);
+    for(size_t i = 0; i < ctx->ns0NodesSize; i++)
+        linkNs0Node(ctx, ctx->ns0Nodes[i]);
+}
+
+/* The base ReferenceTypes in the order of UA_REFERENCETYPEINDEX_* */
+static const UA_UInt32 baseReferenceTypes[] = {
+    UA_NS0ID_REFERENCES, UA_NS0ID_HASSUBTYPE, UA_NS0ID_AGGREGATES,
+    UA_NS0ID_HIERARCHICALREFERENCES, UA_NS0ID_NONHIERARCHICALREFERENCES,
+    UA_NS0ID_HASCHILD, UA_NS0ID_ORGANIZES, UA_NS0ID_HASEVENTSOURCE,
+    UA_NS0ID_HASMODELLINGRULE, UA_NS0ID_HASENCODING, UA_NS0ID_HASDESCRIPTION,
+    UA_NS0ID_HASTYPEDEFINITION, UA_NS0ID_GENERATESEVENT, UA_NS0ID_HASPROPERTY,
+    UA_NS0ID_HASCOMPONENT, UA_NS0ID_HASNOTIFIER, UA_NS0ID_HASORDEREDCOMPONENT,
+    UA_NS0ID_HASINTERFACE};
+
+/* Resolve the namespace 0 ReferenceTypes of the file. The references of the
+ * base ReferenceTypes use the base ReferenceTypes themselves. So placeholders
+ * with the fixed ReferenceTypeIndex are inserted first and replaced once the
+ * nodes could be decoded. Then the subtype sets of all ReferenceTypes are
+ * computed from scratch. */
+static UA_StatusCode
+resolveNs0ReferenceTypes(MappedContext *ctx) {
+    const size_t baseSize = sizeof(baseReferenceTypes) / sizeof(UA_UInt32);
+    for(size_t i = 0; i < baseSize; i++) {
+        MappedEntry *entry = newEntry(UA_NODECLASS_REFERENCETYPE);
+        if(!entry)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        entry->node.head.nodeId = UA_NODEID_NUMERIC(0, baseReferenceTypes[i]);
+        entry->nodeIdHash = UA_NodeId_hash(&entry->node.head.nodeId);
+        entry->node.head.nodeIdHash = entry->nodeIdHash;
+        entry->state = MAPPED_ENTRY_OVERLAY;
+        ZIP_INSERT(MappedTree, &ctx->overlay, entry);
+        UA_StatusCode res =
+            assignReferenceTypeIndex(ctx, &entry->node.referenceTypeNode);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+
+    for(size_t i = 0; i < baseSize; i++) {
+        UA_NodeId id = UA_NODEID_NUMERIC(0, baseReferenceTypes[i]);
+        UA_UInt64 offset = indexLookup(ctx, &id);
+        MappedEntry *entry = (offset != 0) ? decodeEntry(ctx, offset) : NULL;
+        if(!entry || entry->node.head.nodeClass != UA_NODECLASS_REFERENCETYPE) {
+            if(entry)
+                deleteEntry(entry);
+            return UA_STATUSCODE_BADDECODINGERROR;
+        }
+        MappedEntry *placeholder = findEntry(&ctx->overlay, &id);
+        ZIP_REMOVE(MappedTree, &ctx->overlay, placeholder);
+        deleteEntry(placeholder);
+        assignReferenceTypeIndex(ctx, &entry->node.referenceTypeNode);
+        entry->state = MAPPED_ENTRY_OVERLAY;
+        ZIP_INSERT(MappedTree, &ctx->overlay, entry);
+    }
+
+    resolveReferenceTypes(ctx);
+
+    for(UA_Byte i = 0; i < ctx->referenceTypeCounter; i++) {
+        MappedEntry *entry = findEntry(&ctx->overlay, &ctx->referenceTypeIds[i]);
+        if(entry && entry->state == MAPPED_ENTRY_OVERLAY)
+            entry->node.referenceTypeNode.subTypes = UA_REFTYPESET(i);
+    }
+    for(UA_Byte i = 0; i < ctx->referenceTypeCounter; i++) {
+        MappedEntry *entry = findEntry(&ctx->overlay, &ctx->referenceTypeIds[i]);
+        if(!entry || entry->state != MAPPED_ENTRY_OVERLAY)
+            continue;
+        SubtypeContext sc = {ctx, UA_REFTYPESET(i)};
+        addSubtypeToSupertypes(&sc, &entry->node);
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+/***********************/
+/* Nodestore Lifecycle */
+/***********************/
+
+static void *
+deleteEntryVisitor(void *data, MappedEntry *entry) {
+    deleteEntry(entry);
+    return NULL;
+}
+
+static void
+mappedClear(void *nsCtx) {
+    if(!nsCtx)
+        return;
+    MappedContext *ctx = (MappedContext*)nsCtx;
+    ZIP_ITER(MappedTree, &ctx->overlay, deleteEntryVisitor, NULL);
+    ZIP_ITER(MappedTree, &ctx->cache, deleteEntryVisitor, NULL);
+    for(size_t i = 0; i < ctx->referenceTypeCounter; i++)
+        UA_NodeId_clear(&ctx->referenceTypeIds[i]);
+    UA_free(ctx->index);
+    UA_free(ctx->ns0Nodes);
+    UA_free(ctx->refTypeNodes);
+    if(ctx->image.data)
+        munmap(ctx->image.data, ctx->image.length);
+    UA_free(ctx);
+}
+
+static UA_StatusCode
+openMappedFile(UA_Nodestore *ns, const char *path, size_t cacheSize,
+               const UA_DataTypeArray *customTypes, UA_Boolean serveNs0) {
+    MappedContext *ctx = (MappedContext*)UA_calloc(1, sizeof(MappedContext));
+    if(!ctx)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    ZIP_INIT(&ctx->overlay);
+    ZIP_INIT(&ctx->cache);
+    TAILQ_INIT(&ctx->lru);
+    ctx->cacheCapacity = cacheSize;
+    ctx->customTypes = customTypes;
+    ctx->serveNs0 = serveNs0;
+
+    /* Map the file */
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) {
+        UA_free(ctx);
+        return UA_STATUSCODE_BADNOTFOUND;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        UA_free(ctx);
+        return UA_STATUSCODE_BADDECODINGERROR;
+    }
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED) {
+        UA_free(ctx);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    ctx->image.data = (UA_Byte*)data;
+    ctx->image.length = (size_t)st.st_size;
+
+    UA_StatusCode res = buildIndex(ctx);
+    if(res != UA_STATUSCODE_GOOD) {
+        mappedClear(ctx);
+        return res;
+    }
+
+    /* Populate the nodestore */
+    ctx->ns.context = ctx;
+    ctx->ns.clear = mappedClear;
+    ctx->ns.newNode = mappedNewNode;
+    ctx->ns.deleteNode = mappedDeleteNode;
+    ctx->ns.getNode = mappedGetNode;
+    ctx->ns.getNodeFromPtr = mappedGetNodeFromPtr;
+    ctx->ns.getEditNode = mappedGetEditNode;
+    ctx->ns.getEditNodeFromPtr = mappedGetEditNodeFromPtr;
+    ctx->ns.releaseNode = mappedReleaseNode;
+    ctx->ns.getNodeCopy = mappedGetNodeCopy;
+    ctx->ns.insertNode = mappedInsertNode;
+    ctx->ns.replaceNode = mappedReplaceNode;
+    ctx->ns.removeNode = mappedRemoveNode;
+    ctx->ns.getReferenceTypeId = mappedGetReferenceTypeId;
+    ctx->ns.iterate = mappedIterate;
+    ctx->ns.compact = mappedCompact;
+
+    if(serveNs0) {
+        res = resolveNs0ReferenceTypes(ctx);
+        if(res != UA_STATUSCODE_GOOD) {
+            mappedClear(ctx);
+            return res;
+        }
+    }
+
+    *ns = ctx->ns;
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_Nodestore_MappedFile(UA_Nodestore *ns, const char *path, size_t cacheSize,
+                        const UA_DataTypeArray *customTypes) {
+    return openMappedFile(ns, path, cacheSize, customTypes, false);
+}
+
+UA_StatusCode
+UA_Nodestore_MappedFileNs0(UA_Nodestore *ns, const char *path, size_t cacheSize,
+                           const UA_DataTypeArray *customTypes) {
+    return openMappedFile(ns, path, cacheSize, customTypes, true);
+}
+
+#endif /* UA_ARCHITECTURE_POSIX */
@@ -8,7 +8,7 @@
 
 #include <open62541/types.h>
 #include <open62541/plugin/nodestore_default.h>
-#include "ziptree.h"
+#include "btree.h"
 
 #ifndef container_of
 #define container_of(ptr, type, member) \
@@ -19,8 +19,8 @@ struct NodeEntry;
 typedef struct NodeEntry NodeEntry;
 
 struct NodeEntry {
-    ZIP_ENTRY(NodeEntry) zipfields;
-    UA_UInt32 nodeIdHash;
+    UA_UInt32 nodeIdHash; /* First member. Used as the key of the NodeTree for
+                           * the entire NodeEntry. */
     UA_UInt16 refCount; /* How many consumers have a reference to the node? */
     UA_Boolean deleted; /* Node was marked as deleted and can be deleted when refCount == 0 */
     NodeEntry *orig;    /* If a copy is made to replace a node, track that we
@@ -45,7 +45,14 @@ cmpNodeId(const void *a, const void *b) {
     return (enum ZIP_CMP)UA_NodeId_order(&aa->nodeId, &bb->nodeId);
 }
 
-ZIP_HEAD(NodeTree, NodeEntry);
+/* The hash is stored in the B-tree nodes. Only entries with the same hash are
+ * accessed during the lookup. */
+static btree_rank
+rankNodeId(const NodeEntry *entry) {
+    return entry->nodeIdHash;
+}
+
+BTREE_HEAD(NodeTree, NodeEntry);
 typedef struct NodeTree NodeTree;
 
 typedef struct {
@@ -56,7 +63,7 @@ typedef struct {
     UA_Byte referenceTypeCounter;
 } ZipContext;
 
-ZIP_FUNCTIONS(NodeTree, NodeEntry, zipfields, NodeEntry, zipfields, cmpNodeId)
+BTREE_FUNCTIONS(NodeTree, NodeEntry, NodeEntry, nodeIdHash, cmpNodeId, rankNodeId)
 
 static NodeEntry *
 newEntry(UA_NodeClass nodeClass) {
@@ -114,7 +121,7 @@ cleanupEntry(NodeEntry *entry) {
     UA_NodeHead *head = (UA_NodeHead*)&entry->nodeId;
     for(size_t i = 0; i < head->referencesSize; i++) {
         UA_NodeReferenceKind *rk = &head->references[i];
-        if(rk->targetsSize > 16 && !rk->hasRefTree)
+        if(rk->targetsSize > 16 && !rk->hasRefTree && !rk->isCompact)
             UA_NodeReferenceKind_switch(rk);
     }
 }
@@ -147,7 +154,7 @@ zipNsGetNode(void *nsCtx, const UA_NodeId *nodeId,
     NodeEntry dummy;
     dummy.nodeIdHash = UA_NodeId_hash(nodeId);
     dummy.nodeId = *nodeId;
-    NodeEntry *entry = ZIP_FIND(NodeTree, &ns->root, &dummy);
+    NodeEntry *entry = BTREE_FIND(NodeTree, &ns->root, &dummy);
     if(!entry)
         return NULL;
     ++entry->refCount;
@@ -231,10 +238,10 @@ zipNsInsertNode(void *nsCtx, UA_Node *node, UA_NodeId *addedNodeId) {
             node->head.nodeId.identifier.numeric = numId;
             dummy.nodeId.identifier.numeric = numId;
             dummy.nodeIdHash = UA_NodeId_hash(&node->head.nodeId);
-        } while(ZIP_FIND(NodeTree, &ns->root, &dummy));
+        } while(BTREE_FIND(NodeTree, &ns->root, &dummy));
     } else {
         dummy.nodeIdHash = UA_NodeId_hash(&node->head.nodeId);
-        if(ZIP_FIND(NodeTree, &ns->root, &dummy)) { /* The nodeid exists */
+        if(BTREE_FIND(NodeTree, &ns->root, &dummy)) { /* The nodeid exists */
             deleteEntry(entry);
             return UA_STATUSCODE_BADNODEIDEXISTS;
         }
@@ -273,7 +280,17 @@ zipNsInsertNode(void *nsCtx, UA_Node *node, UA_NodeId *addedNodeId) {
 
     /* Insert the node */
     entry->nodeIdHash = dummy.nodeIdHash;
-    ZIP_INSERT(NodeTree, &ns->root, entry);
+    node->head.nodeIdHash = dummy.nodeIdHash;
+    if(BTREE_INSERT(NodeTree, &ns->root, entry) != 0) {
+        if(node->head.nodeClass == UA_NODECLASS_REFERENCETYPE) {
+            ns->referenceTypeCounter--;
+            UA_NodeId_clear(&ns->referenceTypeIds[ns->referenceTypeCounter]);
+        }
+        if(addedNodeId)
+            UA_NodeId_clear(addedNodeId);
+        deleteEntry(entry);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
     return UA_STATUSCODE_GOOD;
 }
 
@@ -298,11 +315,16 @@ zipNsReplaceNode(void *nsCtx, UA_Node *node) {
         return UA_STATUSCODE_BADINTERNALERROR;
     }
 
-    /* Replace */
+    /* Replace. Insert first, so that the old entry stays if the insert
+     * fails. Both entries have the same key until the old one is removed. */
     ZipContext *ns = (ZipContext*)nsCtx;
-    ZIP_REMOVE(NodeTree, &ns->root, oldEntry);
     entry->nodeIdHash = oldEntry->nodeIdHash;
-    ZIP_INSERT(NodeTree, &ns->root, entry);
+    if(BTREE_INSERT(NodeTree, &ns->root, entry) != 0) {
+        deleteEntry(entry);
+        zipNsReleaseNode(nsCtx, oldNode);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    BTREE_REMOVE(NodeTree, &ns->root, oldEntry);
     oldEntry->deleted = true;
 
     zipNsReleaseNode(nsCtx, oldNode);
@@ -315,10 +337,10 @@ zipNsRemoveNode(void *nsCtx, const UA_NodeId *nodeId) {
     NodeEntry dummy;
     dummy.nodeIdHash = UA_NodeId_hash(nodeId);
     dummy.nodeId = *nodeId;
-    NodeEntry *entry = ZIP_FIND(NodeTree, &ns->root, &dummy);
+    NodeEntry *entry = BTREE_FIND(NodeTree, &ns->root, &dummy);
     if(!entry)
         return UA_STATUSCODE_BADNODEIDUNKNOWN;
-    ZIP_REMOVE(NodeTree, &ns->root, entry);
+    BTREE_REMOVE(NodeTree, &ns->root, entry);
     entry->deleted = true;
     cleanupEntry(entry);
     return UA_STATUSCODE_GOOD;
@@ -351,7 +373,7 @@ zipNsIterate(void *nsCtx, UA_NodestoreVisitor visitor,
     d.visitor = visitor;
     d.visitorContext = visitorCtx;
     ZipContext *ns = (ZipContext*)nsCtx;
-    ZIP_ITER(NodeTree, &ns->root, nodeVisitor, &d);
+    BTREE_ITER(NodeTree, &ns->root, nodeVisitor, &d);
 }
 
 static void *
@@ -369,7 +391,8 @@ zipNsClear(void *nsCtx) {
     if (!nsCtx)
         return;
     ZipContext *ns = (ZipContext*)nsCtx;
-    ZIP_ITER(NodeTree, &ns->root, deleteNodeVisitor, NULL);
+    BTREE_ITER(NodeTree, &ns->root, deleteNodeVisitor, NULL);
+    BTREE_CLEAR(NodeTree, &ns->root);
 
     /* Clean up the ReferenceTypes index array */
     for(size_t i = 0; i < ns->referenceTypeCounter; i++)
@@ -385,7 +408,7 @@ UA_Nodestore_ZipTree(UA_Nodestore *ns) {
     if(!ctx)
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
-    ZIP_INIT(&ctx->root);
+    BTREE_INIT(&ctx->root);
     ctx->referenceTypeCounter = 0;
 
     /* Populate the nodestore */
@@ -63,9 +63,12 @@ UA_ClientConfig_copy(UA_ClientConfig const *src, UA_ClientConfig *dst){
 
     dst->sessionLocaleIdsSize = src->sessionLocaleIdsSize;
     dst->connectivityCheckInterval = src->connectivityCheckInterval;
+    dst->readCoalescingMaxNodes = src->readCoalescingMaxNodes;
+    dst->readCoalescingWindow = src->readCoalescingWindow;
     dst->certificateVerification = src->certificateVerification;
     dst->clientContext = src->clientContext;
     dst->customDataTypes = src->customDataTypes;
+    dst->dataTypeRegistry = src->dataTypeRegistry;
     dst->eventLoop = src->eventLoop;
     dst->externalEventLoop = src->externalEventLoop;
     dst->inactivityCallback = src->inactivityCallback;
@@ -75,6 +78,7 @@ UA_ClientConfig_copy(UA_ClientConfig const *src, UA_ClientConfig *dst){
         dst->certificateVerification.logging = dst->logging;
 #ifdef UA_ENABLE_SUBSCRIPTIONS
     dst->outStandingPublishRequests = src->outStandingPublishRequests;
+    dst->minOutStandingPublishRequests = src->minOutStandingPublishRequests;
 #endif
     dst->requestedSessionTimeout = src->requestedSessionTimeout;
     dst->secureChannelLifeTime = src->secureChannelLifeTime;
@@ -116,9 +120,11 @@ UA_Client_newWithConfig(const UA_ClientConfig *config) {
     UA_SecureChannel_init(&client->channel);
     client->channel.config = client->config.localConnectionConfig;
     client->connectStatus = UA_STATUSCODE_GOOD;
+    SIMPLEQ_INIT(&client->readBatches);
 
 #if UA_MULTITHREADING >= 100
     UA_LOCK_INIT(&client->clientMutex);
+    UA_LOCK_SETRANK(&client->clientMutex, UA_LOCKRANK_SERVICE);
 #endif
 
     return client;
@@ -185,6 +191,10 @@ UA_ClientConfig_clear(UA_ClientConfig *config) {
 
     /* Custom Data Types */
     UA_cleanupDataTypeWithCustom(config->customDataTypes);
+    if(config->dataTypeRegistry) {
+        UA_DataTypeRegistry_delete(config->dataTypeRegistry);
+        config->dataTypeRegistry = NULL;
+    }
 
 #ifdef UA_ENABLE_ENCRYPTION
     config->privateKeyPasswordCallback = NULL;
@@ -318,7 +328,9 @@ notifyClientState(UA_Client *client) {
 /* Raw Services */
 /****************/
 
-/* For both synchronous and asynchronous service calls */
+/* For both synchronous and asynchronous service calls. A non-zero *requestId
+ * was reserved beforehand and is used for the request. Otherwise a new
+ * RequestId is generated. */
 static UA_StatusCode
 sendRequest(UA_Client *client, const void *request,
             const UA_DataType *requestType, UA_UInt32 *requestId) {
@@ -352,7 +364,7 @@ sendRequest(UA_Client *client, const void *request,
         rr->timeoutHint = client->config.timeout;
 
     /* Generate the request id */
-    UA_UInt32 rqId = ++client->requestId;
+    UA_UInt32 rqId = (*requestId != 0) ? *requestId : ++client->requestId;
 
 #ifdef UA_ENABLE_TYPEDESCRIPTION
     UA_LOG_DEBUG_CHANNEL(client->config.logging, &client->channel,
@@ -385,16 +397,50 @@ sendRequest(UA_Client *client, const void *request,
 static const UA_NodeId
 serviceFaultId = {0, UA_NODEIDTYPE_NUMERIC, {UA_NS0ID_SERVICEFAULT_ENCODING_DEFAULTBINARY}};
 
-/* Look for the async callback in the linked list, execute and delete it */
+enum ZIP_CMP
+cmpAsyncServiceRequestId(const UA_UInt32 *a, const UA_UInt32 *b) {
+    if(*a == *b)
+        return ZIP_CMP_EQ;
+    return (*a < *b) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+}
+
+enum ZIP_CMP
+cmpAsyncServiceDeadline(const UA_DateTime *a, const UA_DateTime *b) {
+    if(*a == *b)
+        return ZIP_CMP_EQ;
+    return (*a < *b) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+}
+
+/* Enqueue the AsyncServiceCall in the list and both indexes. The deadline is
+ * computed from the start and the timeout. */
+static void
+addAsyncServiceCall(UA_Client *client, AsyncServiceCall *ac) {
+    ac->deadline = ac->start + ((UA_DateTime)ac->timeout * UA_DATETIME_MSEC);
+    LIST_INSERT_HEAD(&client->asyncServiceCalls, ac, pointers);
+    ZIP_INSERT(UA_AsyncServiceIdTree, &client->asyncServiceCallsById, ac);
+    ZIP_INSERT(UA_AsyncServiceTimeoutTree, &client->asyncServiceCallsByDeadline, ac);
+    client->asyncServiceCallsSize++;
+}
+
+static void
+removeAsyncServiceCall(UA_Client *client, AsyncServiceCall *ac) {
+    LIST_REMOVE(ac, pointers);
+    ZIP_REMOVE(UA_AsyncServiceIdTree, &client->asyncServiceCallsById, ac);
+    ZIP_REMOVE(UA_AsyncServiceTimeoutTree, &client->asyncServiceCallsByDeadline, ac);
+    client->asyncServiceCallsSize--;
+}
+
+static AsyncServiceCall *
+findAsyncServiceCall(UA_Client *client, UA_UInt32 requestId) {
+    return ZIP_FIND(UA_AsyncServiceIdTree, &client->asyncServiceCallsById, &requestId);
+}
+
+/* Look for the async callback in the index, execute and delete it */
 static UA_StatusCode
 processMSGResponse(UA_Client *client, UA_UInt32 requestId,
-                   const UA_ByteString *msg) {
+                   const UA_ByteString *msg, size_t msgSegments) {
     /* Find the callback */
-    AsyncServiceCall *ac;
-    LIST_FOREACH(ac, &client->asyncServiceCalls, pointers) {
-        if(ac->requestId == requestId)
-            break;
-    }
+    AsyncServiceCall *ac = findAsyncServiceCall(client, requestId);
 
     /* Part 6, 6.7.6: After the security validation is complete the receiver
      * shall verify the RequestId and the SequenceNumber. If these checks fail a
@@ -412,12 +458,14 @@ processMSGResponse(UA_Client *client, UA_UInt32 requestId,
     const UA_DataType *responseType = ac->responseType;
 
     /* Dequeue ac. We might disconnect the client (remove all ac) in the callback. */
-    LIST_REMOVE(ac, pointers);
+    removeAsyncServiceCall(client, ac);
 
     /* Decode the response type */
     size_t offset = 0;
     UA_NodeId responseTypeId;
-    UA_StatusCode retval = UA_NodeId_decodeBinary(msg, &offset, &responseTypeId);
+    UA_StatusCode retval =
+        UA_decodeBinarySegments(msg, msgSegments, &offset, &responseTypeId,
+                                &UA_TYPES[UA_TYPES_NODEID], NULL);
     if(retval != UA_STATUSCODE_GOOD)
         goto process;
 
@@ -453,7 +501,9 @@ processMSGResponse(UA_Client *client, UA_UInt32 requestId,
     UA_DecodeBinaryOptions opt;
     memset(&opt, 0, sizeof(UA_DecodeBinaryOptions));
     opt.customTypes = client->config.customDataTypes;
-    retval = UA_decodeBinaryInternal(msg, &offset, response, responseType, &opt);
+    opt.typeRegistry = client->config.dataTypeRegistry;
+    retval = UA_decodeBinarySegments(msg, msgSegments, &offset, response,
+                                     responseType, &opt);
 
  process:
     /* Process the received MSG response */
@@ -469,7 +519,12 @@ processMSGResponse(UA_Client *client, UA_UInt32 requestId,
     if(responseType != &UA_TYPES[UA_TYPES_ACTIVATESESSIONRESPONSE] &&
        (response->responseHeader.serviceResult == UA_STATUSCODE_BADSESSIONIDINVALID ||
         response->responseHeader.serviceResult == UA_STATUSCODE_BADSESSIONCLOSED)) {
-        /* Clean up the session information and reset the state */
+        /* Clean up the session information and reset the state. Keep the
+         * Subscriptions for a transfer to the next Session. */
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+        if(!client->config.noNewSession)
+            __Client_Subscriptions_hold(client);
+#endif
         cleanupSession(client);
 
         if(client->config.noNewSession) {
@@ -509,7 +564,7 @@ processMSGResponse(UA_Client *client, UA_UInt32 requestId,
 UA_StatusCode
 processServiceResponse(void *application, UA_SecureChannel *channel,
                        UA_MessageType messageType, UA_UInt32 requestId,
-                       UA_ByteString *message) {
+                       const UA_ByteString *message, size_t messageSegments) {
     UA_Client *client = (UA_Client*)application;
 
     if(!UA_SecureChannel_isConnected(channel)) {
@@ -544,7 +599,7 @@ processServiceResponse(void *application, UA_SecureChannel *channel,
     case UA_MESSAGETYPE_MSG:
         UA_LOG_DEBUG_CHANNEL(client->config.logging, channel, "Process MSG message "
                              "with RequestId %u", requestId);
-        return processMSGResponse(client, requestId, message);
+        return processMSGResponse(client, requestId, message, messageSegments);
     default:
         UA_LOG_TRACE_CHANNEL(client->config.logging, channel,
                              "Invalid message type");
@@ -615,10 +670,10 @@ __Client_Service(UA_Client *client, const void *request,
     if(ac.timeout == 0)
         ac.timeout = UA_UINT32_MAX; /* 0 -> unlimited */
 
-    LIST_INSERT_HEAD(&client->asyncServiceCalls, &ac, pointers);
+    addAsyncServiceCall(client, &ac);
 
     /* Time until which the request has to be answered */
-    UA_DateTime maxDate = ac.start + ((UA_DateTime)ac.timeout * UA_DATETIME_MSEC);
+    UA_DateTime maxDate = ac.deadline;
 
     /* Run the EventLoop until the request was processed, the request has timed
      * out or the client connection fails */
@@ -654,7 +709,7 @@ __Client_Service(UA_Client *client, const void *request,
         }
 
         /* Update the remaining timeout or break */
-        UA_DateTime now = ac.start = el->dateTime_nowMonotonic(el);
+        UA_DateTime now = el->dateTime_nowMonotonic(el);
         if(now > maxDate) {
             retval = UA_STATUSCODE_BADTIMEOUT;
             break;
@@ -663,7 +718,7 @@ __Client_Service(UA_Client *client, const void *request,
     }
 
     /* Detach from the internal async service list */
-    LIST_REMOVE(&ac, pointers);
+    removeAsyncServiceCall(client, &ac);
 
     /* Return the status code */
     respHeader->serviceResult = retval;
@@ -709,13 +764,22 @@ __Client_AsyncService_cancel(UA_Client *client, AsyncServiceCall *ac,
     UA_free(ac);
 }
 
+static void
+removeAllReadBatches(UA_Client *client, UA_StatusCode statusCode);
+
 void
 __Client_AsyncService_removeAll(UA_Client *client, UA_StatusCode statusCode) {
+    /* Fail the coalesced reads that were not sent yet */
+    removeAllReadBatches(client, statusCode);
+
     /* Make this function reentrant. One of the async callbacks could indirectly
      * operate on the list. Moving all elements to a local list before iterating
      * that. */
     UA_AsyncServiceList asyncServiceCalls = client->asyncServiceCalls;
     LIST_INIT(&client->asyncServiceCalls);
+    ZIP_INIT(&client->asyncServiceCallsById);
+    ZIP_INIT(&client->asyncServiceCallsByDeadline);
+    client->asyncServiceCallsSize = 0;
     if(asyncServiceCalls.lh_first)
         asyncServiceCalls.lh_first->pointers.le_prev = &asyncServiceCalls.lh_first;
 
@@ -731,26 +795,24 @@ UA_StatusCode
 UA_Client_modifyAsyncCallback(UA_Client *client, UA_UInt32 requestId,
                               void *userdata, UA_ClientAsyncServiceCallback callback) {
     UA_LOCK(&client->clientMutex);
-    AsyncServiceCall *ac;
     UA_StatusCode res = UA_STATUSCODE_BADNOTFOUND;
-    LIST_FOREACH(ac, &client->asyncServiceCalls, pointers) {
-        if(ac->requestId == requestId) {
-            ac->callback = callback;
-            ac->userdata = userdata;
-            res = UA_STATUSCODE_GOOD;
-            break;
-        }
+    AsyncServiceCall *ac = findAsyncServiceCall(client, requestId);
+    if(ac) {
+        ac->callback = callback;
+        ac->userdata = userdata;
+        res = UA_STATUSCODE_GOOD;
     }
     UA_UNLOCK(&client->clientMutex);
     return res;
 }
 
-UA_StatusCode
-__Client_AsyncService(UA_Client *client, const void *request,
-                      const UA_DataType *requestType,
-                      UA_ClientAsyncServiceCallback callback,
-                      const UA_DataType *responseType,
-                      void *userdata, UA_UInt32 *requestId) {
+static UA_StatusCode
+asyncService(UA_Client *client, const void *request,
+             const UA_DataType *requestType,
+             UA_ClientAsyncServiceCallback callback,
+             const UA_DataType *responseType,
+             void *userdata, UA_UInt32 reservedRequestId,
+             UA_UInt32 *requestId) {
     UA_LOCK_ASSERT(&client->clientMutex);
 
     /* Is the SecureChannel connected? */
@@ -766,6 +828,7 @@ __Client_AsyncService(UA_Client *client, const void *request,
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
     /* Call the service and set the requestId */
+    ac->requestId = reservedRequestId;
     UA_StatusCode retval = sendRequest(client, request, requestType, &ac->requestId);
     if(retval != UA_STATUSCODE_GOOD) {
         /* If sending failed, the status is set to closing. The SecureChannel is
@@ -790,7 +853,7 @@ __Client_AsyncService(UA_Client *client, const void *request,
     if(ac->timeout == 0)
         ac->timeout = UA_UINT32_MAX; /* 0 -> unlimited */
 
-    LIST_INSERT_HEAD(&client->asyncServiceCalls, ac, pointers);
+    addAsyncServiceCall(client, ac);
 
     /* Return the generated request id */
     if(requestId)
@@ -802,6 +865,267 @@ __Client_AsyncService(UA_Client *client, const void *request,
     return UA_STATUSCODE_GOOD;
 }
 
+UA_StatusCode
+__Client_AsyncService(UA_Client *client, const void *request,
+                      const UA_DataType *requestType,
+                      UA_ClientAsyncServiceCallback callback,
+                      const UA_DataType *responseType,
+                      void *userdata, UA_UInt32 *requestId) {
+    return asyncService(client, request, requestType, callback,
+                        responseType, userdata, 0, requestId);
+}
+
+/*******************/
+/* Coalesced Reads */
+/*******************/
+
+/* ReadRequest of the application within a combined request */
+typedef struct {
+    UA_ClientAsyncServiceCallback callback;
+    void *userdata;
+    size_t offset; /* Of the first operation in the combined request */
+    size_t size;
+} ReadBatchEntry;
+
+struct UA_ClientReadBatch {
+    SIMPLEQ_ENTRY(UA_ClientReadBatch) next;
+    UA_UInt32 requestId; /* Reserved when the batch is opened */
+    UA_ReadRequest request; /* Combined request */
+    size_t nodesCapacity;
+    size_t entriesSize;
+    ReadBatchEntry *entries;
+};
+
+static void
+ReadBatch_delete(UA_ClientReadBatch *batch) {
+    UA_ReadRequest_clear(&batch->request);
+    UA_free(batch->entries);
+    UA_free(batch);
+}
+
+/* Call the callbacks with the error status and delete the batch. The batch is
+ * no longer enqueued. */
+static void
+ReadBatch_fail(UA_Client *client, UA_ClientReadBatch *batch,
+               UA_StatusCode statusCode) {
+    UA_UNLOCK(&client->clientMutex);
+    for(size_t i = 0; i < batch->entriesSize; i++) {
+        ReadBatchEntry *e = &batch->entries[i];
+        if(!e->callback)
+            continue;
+        UA_ReadResponse response;
+        UA_ReadResponse_init(&response);
+        response.responseHeader.serviceResult = statusCode;
+        e->callback(client, e->userdata, batch->requestId, &response);
+        UA_ReadResponse_clear(&response);
+    }
+    UA_LOCK(&client->clientMutex);
+    ReadBatch_delete(batch);
+}
+
+static void flushReadBatches(UA_Client *client);
+
+/* Split up the combined response. The parts point into the combined response
+ * which is cleaned up after the callback returns. */
+static void
+ReadBatchCallback(UA_Client *client, void *userdata,
+                  UA_UInt32 requestId, UA_ReadResponse *rr) {
+    UA_ClientReadBatch *batch = (UA_ClientReadBatch*)userdata;
+    UA_StatusCode res = rr->responseHeader.serviceResult;
+    if(res == UA_STATUSCODE_GOOD &&
+       rr->resultsSize != batch->request.nodesToReadSize)
+        res = UA_STATUSCODE_BADINTERNALERROR;
+    UA_Boolean diagnostics =
+        (rr->diagnosticInfosSize == batch->request.nodesToReadSize);
+    for(size_t i = 0; i < batch->entriesSize; i++) {
+        ReadBatchEntry *e = &batch->entries[i];
+        if(!e->callback)
+            continue;
+        UA_ReadResponse part;
+        UA_ReadResponse_init(&part);
+        part.responseHeader = rr->responseHeader;
+        part.responseHeader.serviceResult = res;
+        if(res == UA_STATUSCODE_GOOD) {
+            part.results = &rr->results[e->offset];
+            part.resultsSize = e->size;
+            if(diagnostics) {
+                part.diagnosticInfos = &rr->diagnosticInfos[e->offset];
+                part.diagnosticInfosSize = e->size;
+            }
+        }
+        e->callback(client, e->userdata, requestId, &part);
+    }
+
+    /* A slot in the window is free. Send the next batch. */
+    UA_LOCK(&client->clientMutex);
+    client->readBatchesInFlight--;
+    ReadBatch_delete(batch);
+    flushReadBatches(client);
+    UA_UNLOCK(&client->clientMutex);
+}
+
+/* Send the enqueued batches as long as the window allows */
+static void
+flushReadBatches(UA_Client *client) {
+    UA_LOCK_ASSERT(&client->clientMutex);
+    UA_ClientReadBatch *batch;
+    while((batch = SIMPLEQ_FIRST(&client->readBatches))) {
+        if(client->config.readCoalescingWindow > 0 &&
+           client->readBatchesInFlight >= client->config.readCoalescingWindow)
+            break;
+        SIMPLEQ_REMOVE_HEAD(&client->readBatches, next);
+        if(client->readBatchOpen == batch)
+            client->readBatchOpen = NULL;
+        /* Adding the first request failed */
+        if(batch->entriesSize == 0) {
+            ReadBatch_delete(batch);
+            continue;
+        }
+        UA_StatusCode res =
+            asyncService(client, &batch->request, &UA_TYPES[UA_TYPES_READREQUEST],
+                         (UA_ClientAsyncServiceCallback)ReadBatchCallback,
+                         &UA_TYPES[UA_TYPES_READRESPONSE], batch,
+                         batch->requestId, NULL);
+        if(res != UA_STATUSCODE_GOOD) {
+            ReadBatch_fail(client, batch, res);
+            continue;
+        }
+        client->readBatchesInFlight++;
+    }
+}
+
+static void
+flushReadBatchesCallback(void *application, void *context) {
+    UA_Client *client = (UA_Client*)application;
+    UA_LOCK(&client->clientMutex);
+    client->readBatchFlushScheduled = false;
+    flushReadBatches(client);
+    UA_UNLOCK(&client->clientMutex);
+}
+
+static void
+removeAllReadBatches(UA_Client *client, UA_StatusCode statusCode) {
+    if(client->readBatchFlushScheduled) {
+        UA_EventLoop *el = client->config.eventLoop;
+        el->removeDelayedCallback(el, &client->readBatchFlush);
+        client->readBatchFlushScheduled = false;
+    }
+    client->readBatchOpen = NULL;
+    UA_ClientReadBatch *batch;
+    while((batch = SIMPLEQ_FIRST(&client->readBatches))) {
+        SIMPLEQ_REMOVE_HEAD(&client->readBatches, next);
+        ReadBatch_fail(client, batch, statusCode);
+    }
+}
+
+/* Only requests that differ in the operations alone can be combined */
+static UA_Boolean
+readCoalescable(UA_Client *client, const UA_ReadRequest *rr) {
+    const UA_RequestHeader *rh = &rr->requestHeader;
+    return (rr->nodesToReadSize > 0 &&
+            rr->nodesToReadSize <= client->config.readCoalescingMaxNodes &&
+            rh->requestHandle == 0 && rh->returnDiagnostics == 0 &&
+            rh->auditEntryId.length == 0 &&
+            rh->additionalHeader.encoding == UA_EXTENSIONOBJECT_ENCODED_NOBODY);
+}
+
+static UA_Boolean
+readBatchMatches(UA_Client *client, const UA_ClientReadBatch *batch,
+                 const UA_ReadRequest *rr) {
+    const UA_ReadRequest *br = &batch->request;
+    return (br->requestHeader.timeoutHint == rr->requestHeader.timeoutHint &&
+            br->timestampsToReturn == rr->timestampsToReturn &&
+            br->maxAge == rr->maxAge &&
+            br->nodesToReadSize + rr->nodesToReadSize <=
+            client->config.readCoalescingMaxNodes);
+}
+
+static UA_StatusCode
+coalesceRead(UA_Client *client, const UA_ReadRequest *rr,
+             UA_ClientAsyncServiceCallback callback,
+             void *userdata, UA_UInt32 *requestId) {
+    UA_LOCK_ASSERT(&client->clientMutex);
+
+    /* Is the SecureChannel connected? */
+    if(client->channel.state != UA_SECURECHANNELSTATE_OPEN) {
+        UA_LOG_ERROR(client->config.logging, UA_LOGCATEGORY_CLIENT,
+                     "SecureChannel must be connected to send request");
+        return UA_STATUSCODE_BADSERVERNOTCONNECTED;
+    }
+
+    /* Open a new batch if required. The previous batch is closed. */
+    UA_ClientReadBatch *batch = client->readBatchOpen;
+    if(!batch || !readBatchMatches(client, batch, rr)) {
+        batch = (UA_ClientReadBatch*)UA_calloc(1, sizeof(UA_ClientReadBatch));
+        if(!batch)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        batch->requestId = ++client->requestId;
+        batch->request.requestHeader.timeoutHint = rr->requestHeader.timeoutHint;
+        batch->request.timestampsToReturn = rr->timestampsToReturn;
+        batch->request.maxAge = rr->maxAge;
+        SIMPLEQ_INSERT_TAIL(&client->readBatches, batch, next);
+        client->readBatchOpen = batch;
+    }
+
+    /* Make room for the entry and the operations */
+    ReadBatchEntry *entries = (ReadBatchEntry*)
+        UA_realloc(batch->entries, (batch->entriesSize + 1) * sizeof(ReadBatchEntry));
+    if(!entries)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    batch->entries = entries;
+    UA_ReadRequest *br = &batch->request;
+    size_t needed = br->nodesToReadSize + rr->nodesToReadSize;
+    if(needed > batch->nodesCapacity) {
+        size_t cap = (batch->nodesCapacity == 0) ? 8 : batch->nodesCapacity;
+        while(cap < needed)
+            cap *= 2;
+        if(cap > client->config.readCoalescingMaxNodes)
+            cap = client->config.readCoalescingMaxNodes;
+        UA_ReadValueId *nodes = (UA_ReadValueId*)
+            UA_realloc(br->nodesToRead, cap * sizeof(UA_ReadValueId));
+        if(!nodes)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        br->nodesToRead = nodes;
+        batch->nodesCapacity = cap;
+    }
+
+    /* Copy the operations */
+    for(size_t i = 0; i < rr->nodesToReadSize; i++) {
+        UA_StatusCode res = UA_ReadValueId_copy(&rr->nodesToRead[i],
+                                                &br->nodesToRead[br->nodesToReadSize + i]);
+        if(res != UA_STATUSCODE_GOOD) {
+            for(size_t j = 0; j < i; j++)
+                UA_ReadValueId_clear(&br->nodesToRead[br->nodesToReadSize + j]);
+            return res;
+        }
+    }
+    ReadBatchEntry *e = &batch->entries[batch->entriesSize++];
+    e->callback = callback;
+    e->userdata = userdata;
+    e->offset = br->nodesToReadSize;
+    e->size = rr->nodesToReadSize;
+    br->nodesToReadSize += rr->nodesToReadSize;
+    if(requestId)
+        *requestId = batch->requestId;
+
+    /* The batch is full. Send right away if the window allows. */
+    if(br->nodesToReadSize >= client->config.readCoalescingMaxNodes) {
+        client->readBatchOpen = NULL;
+        flushReadBatches(client);
+    }
+
+    /* Flush in the next EventLoop cycle */
+    if(!SIMPLEQ_EMPTY(&client->readBatches) && !client->readBatchFlushScheduled) {
+        UA_EventLoop *el = client->config.eventLoop;
+        client->readBatchFlush.callback = flushReadBatchesCallback;
+        client->readBatchFlush.application = client;
+        client->readBatchFlush.context = NULL;
+        el->addDelayedCallback(el, &client->readBatchFlush);
+        client->readBatchFlushScheduled = true;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
 UA_StatusCode
 __UA_Client_AsyncService(UA_Client *client, const void *request,
                          const UA_DataType *requestType,
@@ -809,9 +1133,17 @@ __UA_Client_AsyncService(UA_Client *client, const void *request,
                          const UA_DataType *responseType,
                          void *userdata, UA_UInt32 *requestId) {
     UA_LOCK(&client->clientMutex);
-    UA_StatusCode res =
-        __Client_AsyncService(client, request, requestType, callback, responseType,
-                              userdata, requestId);
+    UA_StatusCode res;
+    if(client->config.readCoalescingMaxNodes > 1 &&
+       requestType == &UA_TYPES[UA_TYPES_READREQUEST] &&
+       responseType == &UA_TYPES[UA_TYPES_READRESPONSE] &&
+       readCoalescable(client, (const UA_ReadRequest*)request)) {
+        res = coalesceRead(client, (const UA_ReadRequest*)request,
+                           callback, userdata, requestId);
+    } else {
+        res = __Client_AsyncService(client, request, requestType, callback,
+                                    responseType, userdata, requestId);
+    }
     UA_UNLOCK(&client->clientMutex);
     return res;
 }
@@ -846,13 +1178,9 @@ UA_Client_cancelByRequestId(UA_Client *client, UA_UInt32 requestId,
                             UA_UInt32 *cancelCount) {
     UA_LOCK(&client->clientMutex);
     UA_StatusCode res = UA_STATUSCODE_BADNOTFOUND;
-    AsyncServiceCall *ac;
-    LIST_FOREACH(ac, &client->asyncServiceCalls, pointers) {
-        if(ac->requestId != requestId)
-            continue;
+    AsyncServiceCall *ac = findAsyncServiceCall(client, requestId);
+    if(ac)
         res = cancelByRequestHandle(client, ac->requestHandle, cancelCount);
-        break;
-    }
     UA_UNLOCK(&client->clientMutex);
     return res;
 }
@@ -923,13 +1251,15 @@ asyncServiceTimeoutCheck(UA_Client *client) {
     UA_AsyncServiceList asyncServiceCalls;
     AsyncServiceCall *ac, *ac_tmp;
     LIST_INIT(&asyncServiceCalls);
-    LIST_FOREACH_SAFE(ac, &client->asyncServiceCalls, pointers, ac_tmp) {
-        if(!ac->timeout)
-           continue;
-        if(ac->start + (UA_DateTime)(ac->timeout * UA_DATETIME_MSEC) <= now) {
-            LIST_REMOVE(ac, pointers);
-            LIST_INSERT_HEAD(&asyncServiceCalls, ac, pointers);
-        }
+
+    /* Take the expired calls from the front of the deadline index. The
+     * remaining calls are not visited. */
+    while((ac = ZIP_MIN(UA_AsyncServiceTimeoutTree,
+                        &client->asyncServiceCallsByDeadline))) {
+        if(ac->deadline > now)
+            break;
+        removeAsyncServiceCall(client, ac);
+        LIST_INSERT_HEAD(&asyncServiceCalls, ac, pointers);
     }
 
     /* Cancel and remove the elements from the local list */
@@ -1070,9 +1400,36 @@ UA_Client_run_iterate(UA_Client *client, UA_UInt32 timeout) {
 
 const UA_DataType *
 UA_Client_findDataType(UA_Client *client, const UA_NodeId *typeId) {
+    if(client->config.dataTypeRegistry) {
+        const UA_DataType *type =
+            UA_DataTypeRegistry_find(client->config.dataTypeRegistry, typeId);
+        if(type)
+            return type;
+    }
     return UA_findDataTypeWithCustom(typeId, client->config.customDataTypes);
 }
 
+UA_StatusCode
+UA_Client_addDataTypes(UA_Client *client, const UA_DataTypeSchemaHeader *schema) {
+    UA_LOCK(&client->clientMutex);
+    UA_DataTypeArray *types = NULL;
+    UA_StatusCode res =
+        UA_DataTypeArray_fromSchema(schema, client->config.customDataTypes, &types);
+    if(res == UA_STATUSCODE_GOOD && client->config.dataTypeRegistry)
+        res = UA_DataTypeRegistry_add(client->config.dataTypeRegistry, types);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_cleanupDataTypeWithCustom(types);
+        UA_UNLOCK(&client->clientMutex);
+        return res;
+    }
+
+    /* Prepend so that the new definitions are found first */
+    types->next = client->config.customDataTypes;
+    client->config.customDataTypes = types;
+    UA_UNLOCK(&client->clientMutex);
+    return UA_STATUSCODE_GOOD;
+}
+
 /*************************/
 /* Connection Attributes */
 /*************************/
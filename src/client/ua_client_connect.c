@@ -698,7 +698,14 @@ responseActivateSession(UA_Client *client, void *userdata,
 
     UA_ActivateSessionResponse *ar = (UA_ActivateSessionResponse*)response;
     if(ar->responseHeader.serviceResult != UA_STATUSCODE_GOOD) {
-        /* Activating the Session failed */
+        /* Activating the Session failed. Keep the Subscriptions if a new
+         * Session is created. They are transferred to the new Session. */
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+        if(!client->config.noNewSession &&
+           (ar->responseHeader.serviceResult == UA_STATUSCODE_BADSESSIONIDINVALID ||
+            ar->responseHeader.serviceResult == UA_STATUSCODE_BADSESSIONCLOSED))
+            __Client_Subscriptions_hold(client);
+#endif
         cleanupSession(client);
 
         /* Configuration option to not create a new Session */
@@ -743,8 +750,10 @@ responseActivateSession(UA_Client *client, void *userdata,
     notifyClientState(client);
 
     /* Immediately check if publish requests are outstanding - for example when
-     * an existing Session has been reattached / activated. */
+     * an existing Session has been reattached / activated. The Subscriptions
+     * of a lost Session are transferred to the new Session. */
 #ifdef UA_ENABLE_SUBSCRIPTIONS
+    __Client_Subscriptions_transfer(client);
     __Client_Subscriptions_backgroundPublish(client);
 #endif
 
@@ -1678,8 +1687,13 @@ initConnect(UA_Client *client) {
         return;
     }
 
-    /* Initialize the TCP connection */
+    /* Initialize the TCP connection. Or the shared-memory connection for a
+     * local server. Then the hostname is the name of the endpoint. */
     UA_String tcpString = UA_STRING("tcp");
+    UA_Boolean shm = (strncmp((const char*)client->config.endpointUrl.data,
+                              "opc.shm://", 10) == 0);
+    if(shm)
+        tcpString = UA_STRING("shm");
     for(UA_EventSource *es = client->config.eventLoop->eventSources;
         es != NULL; es = es->next) {
         /* Is this a usable connection manager? */
@@ -1702,6 +1716,10 @@ initConnect(UA_Client *client) {
         UA_KeyValueMap paramMap;
         paramMap.map = params;
         paramMap.mapSize = 3;
+        if(shm) {
+            paramMap.map = &params[1]; /* Only the address */
+            paramMap.mapSize = 1;
+        }
 
         /* Open the client TCP connection */
         UA_UNLOCK(&client->clientMutex);
@@ -2177,6 +2195,9 @@ cleanupSession(UA_Client *client) {
 
 #ifdef UA_ENABLE_SUBSCRIPTIONS
     client->currentlyOutStandingPublishRequests = 0;
+    client->targetOutStandingPublishRequests = 0;
+    client->publishRoundTrip = 0;
+    client->operationLimitsRead = false;
 #endif
 
     client->sessionState = UA_SESSIONSTATE_CLOSED;
@@ -2190,6 +2211,11 @@ disconnectSecureChannel(UA_Client *client, UA_Boolean sync) {
     /* Close the SecureChannel */
     closeSecureChannel(client);
 
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    /* Don't transfer the Subscriptions of a lost Session after reconnecting */
+    __Client_Subscriptions_clearHeld(client);
+#endif
+
     /* Manually set the status to closed to prevent an automatic reconnection */
     if(client->connectStatus == UA_STATUSCODE_GOOD)
         client->connectStatus = UA_STATUSCODE_BADCONNECTIONCLOSED;
@@ -0,0 +1,452 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "ua_client_internal.h"
+
+#define UA_CRAWL_NODESPERBROWSE 100
+#define UA_CRAWL_MAXINFLIGHT 4
+
+/****************/
+/* Browse Cache */
+/****************/
+
+typedef struct BrowseCacheEntry {
+    ZIP_ENTRY(BrowseCacheEntry) zipfields;
+    UA_UInt32 nodeIdHash;
+    UA_ReferenceDescription ref; /* The key is ref.nodeId.nodeId */
+} BrowseCacheEntry;
+
+static enum ZIP_CMP
+cmpBrowseCacheEntry(const void *a, const void *b) {
+    const BrowseCacheEntry *aa = (const BrowseCacheEntry*)a;
+    const BrowseCacheEntry *bb = (const BrowseCacheEntry*)b;
+    /* Compare the hash first. That is faster than the full NodeId. */
+    if(aa->nodeIdHash != bb->nodeIdHash)
+        return (aa->nodeIdHash < bb->nodeIdHash) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+    return (enum ZIP_CMP)UA_NodeId_order(&aa->ref.nodeId.nodeId,
+                                         &bb->ref.nodeId.nodeId);
+}
+
+typedef ZIP_HEAD(BrowseCacheTree, BrowseCacheEntry) BrowseCacheTree;
+ZIP_FUNCTIONS(BrowseCacheTree, BrowseCacheEntry, zipfields,
+              BrowseCacheEntry, zipfields, cmpBrowseCacheEntry)
+
+struct UA_ClientBrowseCache {
+    BrowseCacheTree nodes;
+    size_t nodesSize;
+};
+
+UA_ClientBrowseCache *
+UA_ClientBrowseCache_new(void) {
+    return (UA_ClientBrowseCache*)UA_calloc(1, sizeof(UA_ClientBrowseCache));
+}
+
+static void *
+deleteBrowseCacheEntry(void *context, BrowseCacheEntry *entry) {
+    UA_ReferenceDescription_clear(&entry->ref);
+    UA_free(entry);
+    return NULL;
+}
+
+void
+UA_ClientBrowseCache_delete(UA_ClientBrowseCache *cache) {
+    ZIP_ITER(BrowseCacheTree, &cache->nodes, deleteBrowseCacheEntry, NULL);
+    UA_free(cache);
+}
+
+size_t
+UA_ClientBrowseCache_size(const UA_ClientBrowseCache *cache) {
+    return cache->nodesSize;
+}
+
+static BrowseCacheEntry *
+findBrowseCacheEntry(const UA_ClientBrowseCache *cache, const UA_NodeId *nodeId) {
+    BrowseCacheEntry dummy;
+    dummy.nodeIdHash = UA_NodeId_hash(nodeId);
+    dummy.ref.nodeId.nodeId = *nodeId;
+    return ZIP_FIND(BrowseCacheTree, (BrowseCacheTree*)(uintptr_t)&cache->nodes,
+                    &dummy);
+}
+
+const UA_ReferenceDescription *
+UA_ClientBrowseCache_get(const UA_ClientBrowseCache *cache, const UA_NodeId *nodeId) {
+    BrowseCacheEntry *entry = findBrowseCacheEntry(cache, nodeId);
+    return (entry) ? &entry->ref : NULL;
+}
+
+/* The ReferenceDescription is moved into the cache */
+static UA_StatusCode
+addBrowseCacheEntry(UA_ClientBrowseCache *cache, UA_ReferenceDescription *ref) {
+    BrowseCacheEntry *entry = (BrowseCacheEntry*)UA_malloc(sizeof(BrowseCacheEntry));
+    if(!entry)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    entry->ref = *ref;
+    UA_ReferenceDescription_init(ref);
+    entry->nodeIdHash = UA_NodeId_hash(&entry->ref.nodeId.nodeId);
+    ZIP_INSERT(BrowseCacheTree, &cache->nodes, entry);
+    cache->nodesSize++;
+    return UA_STATUSCODE_GOOD;
+}
+
+void
+UA_Client_setBrowseCache(UA_Client *client, UA_ClientBrowseCache *cache) {
+    UA_LOCK(&client->clientMutex);
+    client->browseCache = cache;
+    UA_UNLOCK(&client->clientMutex);
+}
+
+UA_StatusCode
+UA_Client_readCachedAttribute(UA_Client *client, const UA_NodeId *nodeId,
+                              UA_AttributeId attributeId, void *out) {
+    UA_StatusCode res = UA_STATUSCODE_BADNOTFOUND;
+    UA_LOCK(&client->clientMutex);
+    if(!client->browseCache)
+        goto out;
+    BrowseCacheEntry *entry = findBrowseCacheEntry(client->browseCache, nodeId);
+    if(!entry || entry->ref.nodeClass == UA_NODECLASS_UNSPECIFIED)
+        goto out;
+    switch(attributeId) {
+    case UA_ATTRIBUTEID_NODECLASS:
+        *(UA_NodeClass*)out = entry->ref.nodeClass;
+        res = UA_STATUSCODE_GOOD;
+        break;
+    case UA_ATTRIBUTEID_BROWSENAME:
+        res = UA_QualifiedName_copy(&entry->ref.browseName, (UA_QualifiedName*)out);
+        break;
+    case UA_ATTRIBUTEID_DISPLAYNAME:
+        res = UA_LocalizedText_copy(&entry->ref.displayName, (UA_LocalizedText*)out);
+        break;
+    default:
+        break;
+    }
+ out:
+    UA_UNLOCK(&client->clientMutex);
+    return res;
+}
+
+/***********/
+/* Crawler */
+/***********/
+
+typedef struct {
+    UA_ClientBrowseCache *cache;
+    UA_ClientCrawlOptions options;
+
+    /* FIFO of the nodes to be browsed */
+    UA_NodeId *queue;
+    size_t queueStart;
+    size_t queueEnd;
+    size_t queueCapacity;
+
+    size_t inFlight;
+    size_t browseNextInFlight;
+    UA_StatusCode status; /* First error */
+    UA_Boolean detached;  /* Discard the results, free when idle */
+} UA_Crawl;
+
+static void
+UA_Crawl_delete(UA_Crawl *crawl) {
+    for(size_t i = crawl->queueStart; i < crawl->queueEnd; i++)
+        UA_NodeId_clear(&crawl->queue[i]);
+    UA_free(crawl->queue);
+    UA_NodeId_clear(&crawl->options.referenceTypeId);
+    UA_free(crawl);
+}
+
+static UA_StatusCode
+enqueueNode(UA_Crawl *crawl, const UA_NodeId *nodeId) {
+    if(crawl->queueEnd == crawl->queueCapacity) {
+        /* Move to the front before growing */
+        if(crawl->queueStart > crawl->queueCapacity / 2) {
+            size_t used = crawl->queueEnd - crawl->queueStart;
+            memmove(crawl->queue, &crawl->queue[crawl->queueStart],
+                    used * sizeof(UA_NodeId));
+            crawl->queueStart = 0;
+            crawl->queueEnd = used;
+        } else {
+            size_t newCapacity = (crawl->queueCapacity == 0) ?
+                64 : crawl->queueCapacity * 2;
+            UA_NodeId *newQueue = (UA_NodeId*)
+                UA_realloc(crawl->queue, newCapacity * sizeof(UA_NodeId));
+            if(!newQueue)
+                return UA_STATUSCODE_BADOUTOFMEMORY;
+            crawl->queue = newQueue;
+            crawl->queueCapacity = newCapacity;
+        }
+    }
+    UA_StatusCode res = UA_NodeId_copy(nodeId, &crawl->queue[crawl->queueEnd]);
+    if(res == UA_STATUSCODE_GOOD)
+        crawl->queueEnd++;
+    return res;
+}
+
+static void
+setCrawlStatus(UA_Crawl *crawl, UA_StatusCode res) {
+    if(crawl->status == UA_STATUSCODE_GOOD)
+        crawl->status = res;
+}
+
+/* Context of a Browse or BrowseNext request in flight */
+typedef struct {
+    UA_Crawl *crawl;
+    size_t nodesSize;
+    UA_NodeId *nodes; /* The browsed nodes. Empty for BrowseNext. */
+} UA_CrawlRequest;
+
+static void
+UA_CrawlRequest_delete(UA_CrawlRequest *cr) {
+    UA_Array_delete(cr->nodes, cr->nodesSize, &UA_TYPES[UA_TYPES_NODEID]);
+    UA_free(cr);
+}
+
+static void crawlDispatch(UA_Client *client, UA_Crawl *crawl);
+
+static void
+crawlBrowseNext(UA_Client *client, UA_Crawl *crawl,
+                UA_BrowseResult *results, size_t resultsSize);
+
+/* Add the discovered nodes to the cache and to the queue */
+static void
+crawlProcessResults(UA_Client *client, UA_CrawlRequest *cr,
+                    UA_BrowseResult *results, size_t resultsSize) {
+    UA_Crawl *crawl = cr->crawl;
+    for(size_t i = 0; i < resultsSize; i++) {
+        UA_BrowseResult *br = &results[i];
+
+        /* The server has too many open continuation points. Browse the node
+         * again after the pending BrowseNext requests have released them. */
+        if(br->statusCode == UA_STATUSCODE_BADNOCONTINUATIONPOINTS &&
+           i < cr->nodesSize && crawl->browseNextInFlight > 0) {
+            setCrawlStatus(crawl, enqueueNode(crawl, &cr->nodes[i]));
+            continue;
+        }
+
+        if(br->statusCode != UA_STATUSCODE_GOOD) {
+            UA_LOG_DEBUG(client->config.logging, UA_LOGCATEGORY_CLIENT,
+                         "Crawler: Browsing a node failed with StatusCode %s",
+                         UA_StatusCode_name(br->statusCode));
+            continue;
+        }
+
+        for(size_t j = 0; j < br->referencesSize; j++) {
+            UA_ReferenceDescription *ref = &br->references[j];
+            if(ref->nodeId.serverIndex != 0 || ref->nodeId.namespaceUri.length > 0)
+                continue; /* Not a local node */
+            if(findBrowseCacheEntry(crawl->cache, &ref->nodeId.nodeId))
+                continue; /* Known already */
+            UA_StatusCode res = enqueueNode(crawl, &ref->nodeId.nodeId);
+            if(res == UA_STATUSCODE_GOOD)
+                res = addBrowseCacheEntry(crawl->cache, ref);
+            setCrawlStatus(crawl, res);
+        }
+    }
+}
+
+static void
+crawlCallback(UA_Client *client, void *userdata,
+              UA_UInt32 requestId, void *response) {
+    UA_CrawlRequest *cr = (UA_CrawlRequest*)userdata;
+    UA_Crawl *crawl = cr->crawl;
+
+    UA_LOCK(&client->clientMutex);
+    crawl->inFlight--;
+    if(cr->nodesSize == 0)
+        crawl->browseNextInFlight--;
+
+    if(crawl->detached) {
+        if(crawl->inFlight == 0)
+            UA_Crawl_delete(crawl);
+        goto cleanup;
+    }
+
+    /* Browse and BrowseNext responses have the same layout */
+    UA_BrowseResponse *br = (UA_BrowseResponse*)response;
+    if(br->responseHeader.serviceResult != UA_STATUSCODE_GOOD) {
+        setCrawlStatus(crawl, br->responseHeader.serviceResult);
+    } else {
+        crawlBrowseNext(client, crawl, br->results, br->resultsSize);
+        crawlProcessResults(client, cr, br->results, br->resultsSize);
+    }
+
+    crawlDispatch(client, crawl);
+
+ cleanup:
+    UA_CrawlRequest_delete(cr);
+    UA_UNLOCK(&client->clientMutex);
+}
+
+/* Continue the results that were cut off by the server */
+static void
+crawlBrowseNext(UA_Client *client, UA_Crawl *crawl,
+                UA_BrowseResult *results, size_t resultsSize) {
+    size_t cpSize = 0;
+    for(size_t i = 0; i < resultsSize; i++) {
+        if(results[i].continuationPoint.length > 0)
+            cpSize++;
+    }
+    if(cpSize == 0)
+        return;
+
+    UA_CrawlRequest *cr = (UA_CrawlRequest*)UA_calloc(1, sizeof(UA_CrawlRequest));
+    if(!cr) {
+        setCrawlStatus(crawl, UA_STATUSCODE_BADOUTOFMEMORY);
+        return;
+    }
+    cr->crawl = crawl;
+
+    UA_BrowseNextRequest request;
+    UA_BrowseNextRequest_init(&request);
+    request.continuationPoints = (UA_ByteString*)
+        UA_Array_new(cpSize, &UA_TYPES[UA_TYPES_BYTESTRING]);
+    if(!request.continuationPoints) {
+        UA_free(cr);
+        setCrawlStatus(crawl, UA_STATUSCODE_BADOUTOFMEMORY);
+        return;
+    }
+    request.continuationPointsSize = cpSize;
+    size_t pos = 0;
+    for(size_t i = 0; i < resultsSize; i++) {
+        if(results[i].continuationPoint.length == 0)
+            continue;
+        request.continuationPoints[pos++] = results[i].continuationPoint;
+        UA_ByteString_init(&results[i].continuationPoint);
+    }
+
+    UA_StatusCode res =
+        __Client_AsyncService(client, &request, &UA_TYPES[UA_TYPES_BROWSENEXTREQUEST],
+                              crawlCallback, &UA_TYPES[UA_TYPES_BROWSENEXTRESPONSE],
+                              cr, NULL);
+    UA_BrowseNextRequest_clear(&request);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_free(cr);
+        setCrawlStatus(crawl, res);
+        return;
+    }
+    crawl->inFlight++;
+    crawl->browseNextInFlight++;
+}
+
+/* Browse the queued nodes until the limit of requests in flight is reached */
+static void
+crawlDispatch(UA_Client *client, UA_Crawl *crawl) {
+    UA_LOCK_ASSERT(&client->clientMutex);
+
+    while(crawl->status == UA_STATUSCODE_GOOD &&
+          crawl->inFlight < crawl->options.maxInFlight &&
+          crawl->queueStart < crawl->queueEnd) {
+        size_t size = crawl->queueEnd - crawl->queueStart;
+        if(size > crawl->options.nodesPerBrowse)
+            size = crawl->options.nodesPerBrowse;
+
+        UA_CrawlRequest *cr = (UA_CrawlRequest*)UA_calloc(1, sizeof(UA_CrawlRequest));
+        UA_BrowseDescription *bds = (UA_BrowseDescription*)
+            UA_Array_new(size, &UA_TYPES[UA_TYPES_BROWSEDESCRIPTION]);
+        UA_NodeId *nodes = (UA_NodeId*)UA_Array_new(size, &UA_TYPES[UA_TYPES_NODEID]);
+        if(!cr || !bds || !nodes) {
+            UA_free(cr);
+            UA_free(bds);
+            UA_free(nodes);
+            setCrawlStatus(crawl, UA_STATUSCODE_BADOUTOFMEMORY);
+            break;
+        }
+
+        /* Move the NodeIds out of the queue. The BrowseDescriptions point to
+         * them and to the shared ReferenceTypeId. */
+        memcpy(nodes, &crawl->queue[crawl->queueStart], size * sizeof(UA_NodeId));
+        crawl->queueStart += size;
+        for(size_t i = 0; i < size; i++) {
+            bds[i].nodeId = nodes[i];
+            bds[i].browseDirection = UA_BROWSEDIRECTION_FORWARD;
+            bds[i].referenceTypeId = crawl->options.referenceTypeId;
+            bds[i].includeSubtypes = true;
+            bds[i].resultMask = UA_BROWSERESULTMASK_ALL;
+        }
+        cr->crawl = crawl;
+        cr->nodes = nodes;
+        cr->nodesSize = size;
+
+        UA_BrowseRequest request;
+        UA_BrowseRequest_init(&request);
+        request.requestedMaxReferencesPerNode = crawl->options.maxReferencesPerNode;
+        request.nodesToBrowse = bds;
+        request.nodesToBrowseSize = size;
+        UA_StatusCode res =
+            __Client_AsyncService(client, &request, &UA_TYPES[UA_TYPES_BROWSEREQUEST],
+                                  crawlCallback, &UA_TYPES[UA_TYPES_BROWSERESPONSE],
+                                  cr, NULL);
+        UA_free(bds); /* Shallow */
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_CrawlRequest_delete(cr);
+            setCrawlStatus(crawl, res);
+            break;
+        }
+        crawl->inFlight++;
+    }
+}
+
+UA_StatusCode
+UA_Client_crawl(UA_Client *client, const UA_NodeId startNode,
+                UA_ClientBrowseCache *cache, const UA_ClientCrawlOptions *options) {
+    UA_Crawl *crawl = (UA_Crawl*)UA_calloc(1, sizeof(UA_Crawl));
+    if(!crawl)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    crawl->cache = cache;
+
+    /* Set the defaults */
+    if(options)
+        crawl->options = *options;
+    if(UA_NodeId_isNull(&crawl->options.referenceTypeId))
+        crawl->options.referenceTypeId =
+            UA_NODEID_NUMERIC(0, UA_NS0ID_HIERARCHICALREFERENCES);
+    if(crawl->options.nodesPerBrowse == 0)
+        crawl->options.nodesPerBrowse = UA_CRAWL_NODESPERBROWSE;
+    if(crawl->options.maxInFlight == 0)
+        crawl->options.maxInFlight = UA_CRAWL_MAXINFLIGHT;
+    UA_StatusCode res = UA_NodeId_copy(&crawl->options.referenceTypeId,
+                                       &crawl->options.referenceTypeId);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_free(crawl);
+        return res;
+    }
+
+    UA_LOCK(&client->clientMutex);
+
+    /* Start with the startNode (unless known already) */
+    UA_ReferenceDescription startRef;
+    UA_ReferenceDescription_init(&startRef);
+    res = UA_NodeId_copy(&startNode, &startRef.nodeId.nodeId);
+    if(res == UA_STATUSCODE_GOOD && !findBrowseCacheEntry(cache, &startNode)) {
+        res = enqueueNode(crawl, &startNode);
+        if(res == UA_STATUSCODE_GOOD)
+            res = addBrowseCacheEntry(cache, &startRef);
+    }
+    UA_ReferenceDescription_clear(&startRef);
+
+    if(res == UA_STATUSCODE_GOOD)
+        crawlDispatch(client, crawl);
+
+    /* Run the EventLoop until all requests have returned. Every request
+     * returns eventually, at the latest when it times out or the Session is
+     * closed. */
+    UA_EventLoop *el = client->config.eventLoop;
+    while(crawl->inFlight > 0) {
+        UA_UNLOCK(&client->clientMutex);
+        res = el->run(el, client->config.timeout);
+        UA_LOCK(&client->clientMutex);
+        if(res != UA_STATUSCODE_GOOD)
+            break;
+    }
+
+    if(crawl->inFlight > 0) {
+        /* Free when the remaining requests have returned */
+        crawl->detached = true;
+    } else {
+        if(res == UA_STATUSCODE_GOOD)
+            res = crawl->status;
+        UA_Crawl_delete(crawl);
+    }
+
+    UA_UNLOCK(&client->clientMutex);
+    return res;
+}
@@ -91,9 +91,236 @@ UA_Client_forEachChildNodeCall(UA_Client *client, UA_NodeId parentNodeId,
     return retval;
 }
 
-/*******************/
-/* Node Management */
-/*******************/
+/*************************/
+/* Data Type Definitions */
+/*************************/
+
+static UA_Boolean
+schemaContains(const UA_DataTypeSchemaHeader *schema, const UA_NodeId *id) {
+    for(size_t i = 0; i < schema->structureDataTypesSize; i++) {
+        if(UA_NodeId_equal(&schema->structureDataTypes[i].dataTypeId, id))
+            return true;
+    }
+    for(size_t i = 0; i < schema->enumDataTypesSize; i++) {
+        if(UA_NodeId_equal(&schema->enumDataTypes[i].dataTypeId, id))
+            return true;
+    }
+    for(size_t i = 0; i < schema->simpleDataTypesSize; i++) {
+        if(UA_NodeId_equal(&schema->simpleDataTypes[i].dataTypeId, id))
+            return true;
+    }
+    return false;
+}
+
+static UA_Boolean
+arrayContains(const UA_NodeId *ids, size_t idsSize, const UA_NodeId *id) {
+    for(size_t i = 0; i < idsSize; i++) {
+        if(UA_NodeId_equal(&ids[i], id))
+            return true;
+    }
+    return false;
+}
+
+/* Types of namespace zero are either generated or abstract types that are
+ * mapped to a builtin type */
+static UA_Boolean
+needsDefinition(UA_Client *client, const UA_DataTypeSchemaHeader *schema,
+                const UA_NodeId *queue, size_t queueSize,
+                const UA_NodeId *next, size_t nextSize, const UA_NodeId *id) {
+    return (id->namespaceIndex != 0 && !UA_Client_findDataType(client, id) &&
+            !schemaContains(schema, id) && !arrayContains(queue, queueSize, id) &&
+            !arrayContains(next, nextSize, id));
+}
+
+/* Follow the inverse HasSubtype references up to a standard-defined type */
+static UA_StatusCode
+getBuiltinSupertype(UA_Client *client, const UA_NodeId *typeId,
+                    UA_NodeId *baseType, UA_Byte *builtInType) {
+    UA_NodeId_init(baseType);
+    UA_NodeId current;
+    UA_StatusCode res = UA_NodeId_copy(typeId, &current);
+    for(size_t depth = 0; depth < 16 && res == UA_STATUSCODE_GOOD; depth++) {
+        UA_BrowseDescription bd;
+        UA_BrowseDescription_init(&bd);
+        bd.nodeId = current;
+        bd.browseDirection = UA_BROWSEDIRECTION_INVERSE;
+        bd.referenceTypeId = UA_NS0ID(HASSUBTYPE);
+        UA_BrowseRequest req;
+        UA_BrowseRequest_init(&req);
+        req.nodesToBrowse = &bd;
+        req.nodesToBrowseSize = 1;
+        UA_BrowseResponse resp = UA_Client_Service_browse(client, req);
+        UA_NodeId_clear(&current);
+        res = resp.responseHeader.serviceResult;
+        if(res == UA_STATUSCODE_GOOD &&
+           (resp.resultsSize != 1 || resp.results[0].referencesSize == 0))
+            res = UA_STATUSCODE_BADDATATYPEIDUNKNOWN;
+        if(res == UA_STATUSCODE_GOOD)
+            res = UA_NodeId_copy(&resp.results[0].references[0].nodeId.nodeId,
+                                 &current);
+        UA_BrowseResponse_clear(&resp);
+        if(res == UA_STATUSCODE_GOOD && depth == 0)
+            res = UA_NodeId_copy(&current, baseType);
+        if(res != UA_STATUSCODE_GOOD)
+            break;
+        if(current.namespaceIndex != 0 ||
+           current.identifierType != UA_NODEIDTYPE_NUMERIC)
+            continue;
+
+        /* Builtin types have the NodeIds 1 to 25 */
+        const UA_DataType *type = UA_findDataType(&current);
+        if(current.identifier.numeric >= UA_NS0ID_BOOLEAN &&
+           current.identifier.numeric <= UA_NS0ID_DIAGNOSTICINFO)
+            *builtInType = (UA_Byte)current.identifier.numeric;
+        else if(type && type->typeKind <= UA_DATATYPEKIND_DIAGNOSTICINFO)
+            *builtInType = (UA_Byte)(type->typeKind + 1);
+        else if(current.identifier.numeric == UA_NS0ID_ENUMERATION ||
+                (type && type->typeKind == UA_DATATYPEKIND_ENUM))
+            *builtInType = UA_NS0ID_INT32;
+        else
+            res = UA_STATUSCODE_BADNOTSUPPORTED;
+        UA_NodeId_clear(&current);
+        if(res != UA_STATUSCODE_GOOD)
+            UA_NodeId_clear(baseType);
+        return res;
+    }
+    UA_NodeId_clear(&current);
+    UA_NodeId_clear(baseType);
+    return (res != UA_STATUSCODE_GOOD) ? res : UA_STATUSCODE_BADDATATYPEIDUNKNOWN;
+}
+
+static UA_StatusCode
+addDefinition(UA_Client *client, UA_DataTypeSchemaHeader *schema,
+              const UA_NodeId *queue, size_t queueSize, size_t index,
+              const UA_DataValue *name, const UA_DataValue *def,
+              UA_NodeId **next, size_t *nextSize) {
+    const UA_NodeId *typeId = &queue[index];
+    if(!UA_Variant_hasScalarType(&name->value, &UA_TYPES[UA_TYPES_QUALIFIEDNAME]))
+        return (name->hasStatus) ? name->status : UA_STATUSCODE_BADNODEIDUNKNOWN;
+    const UA_QualifiedName *qn = (const UA_QualifiedName*)name->value.data;
+
+    /* Structure */
+    UA_StatusCode res;
+    if(UA_Variant_hasScalarType(&def->value, &UA_TYPES[UA_TYPES_STRUCTUREDEFINITION])) {
+        UA_StructureDescription sd;
+        sd.dataTypeId = *typeId;
+        sd.name = *qn;
+        sd.structureDefinition = *(UA_StructureDefinition*)def->value.data;
+        res = UA_Array_appendCopy((void**)&schema->structureDataTypes,
+                                  &schema->structureDataTypesSize, &sd,
+                                  &UA_TYPES[UA_TYPES_STRUCTUREDESCRIPTION]);
+        /* Read the definitions of the unknown field types next */
+        for(size_t i = 0; i < sd.structureDefinition.fieldsSize &&
+                res == UA_STATUSCODE_GOOD; i++) {
+            const UA_NodeId *ft = &sd.structureDefinition.fields[i].dataType;
+            if(needsDefinition(client, schema, queue, queueSize, *next, *nextSize, ft))
+                res = UA_Array_appendCopy((void**)next, nextSize, ft,
+                                          &UA_TYPES[UA_TYPES_NODEID]);
+        }
+        return res;
+    }
+
+    /* Enumeration */
+    if(UA_Variant_hasScalarType(&def->value, &UA_TYPES[UA_TYPES_ENUMDEFINITION])) {
+        UA_EnumDescription ed;
+        ed.dataTypeId = *typeId;
+        ed.name = *qn;
+        ed.enumDefinition = *(UA_EnumDefinition*)def->value.data;
+        ed.builtInType = UA_NS0ID_INT32;
+        return UA_Array_appendCopy((void**)&schema->enumDataTypes,
+                                   &schema->enumDataTypesSize, &ed,
+                                   &UA_TYPES[UA_TYPES_ENUMDESCRIPTION]);
+    }
+
+    /* Simple type without a definition */
+    UA_SimpleTypeDescription st;
+    st.dataTypeId = *typeId;
+    st.name = *qn;
+    res = getBuiltinSupertype(client, typeId, &st.baseDataType, &st.builtInType);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    res = UA_Array_appendCopy((void**)&schema->simpleDataTypes,
+                              &schema->simpleDataTypesSize, &st,
+                              &UA_TYPES[UA_TYPES_SIMPLETYPEDESCRIPTION]);
+    UA_NodeId_clear(&st.baseDataType);
+    return res;
+}
+
+UA_StatusCode
+UA_Client_readDataTypeSchema(UA_Client *client, size_t dataTypesSize,
+                             const UA_NodeId *dataTypes,
+                             UA_DataTypeSchemaHeader *schema) {
+    UA_DataTypeSchemaHeader_init(schema);
+    UA_NodeId *queue = NULL;
+    size_t queueSize = 0;
+    UA_StatusCode res = UA_Array_copy(dataTypes, dataTypesSize, (void**)&queue,
+                                      &UA_TYPES[UA_TYPES_NODEID]);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    queueSize = dataTypesSize;
+
+    /* Read the BrowseName and the DataTypeDefinition of all queued types in
+     * one request. The first request also reads the namespace array. */
+    UA_Boolean first = true;
+    while(queueSize > 0 && res == UA_STATUSCODE_GOOD) {
+        size_t rvisSize = (2 * queueSize) + ((first) ? 1 : 0);
+        UA_ReadValueId *rvis = (UA_ReadValueId*)
+            UA_Array_new(rvisSize, &UA_TYPES[UA_TYPES_READVALUEID]);
+        if(!rvis) {
+            res = UA_STATUSCODE_BADOUTOFMEMORY;
+            break;
+        }
+        for(size_t i = 0; i < queueSize; i++) {
+            rvis[2*i].nodeId = queue[i]; /* shallow */
+            rvis[2*i].attributeId = UA_ATTRIBUTEID_BROWSENAME;
+            rvis[2*i+1].nodeId = queue[i];
+            rvis[2*i+1].attributeId = UA_ATTRIBUTEID_DATATYPEDEFINITION;
+        }
+        if(first) {
+            rvis[rvisSize-1].nodeId = UA_NS0ID(SERVER_NAMESPACEARRAY);
+            rvis[rvisSize-1].attributeId = UA_ATTRIBUTEID_VALUE;
+        }
+        UA_ReadRequest req;
+        UA_ReadRequest_init(&req);
+        req.nodesToRead = rvis;
+        req.nodesToReadSize = rvisSize;
+        UA_ReadResponse resp = UA_Client_Service_read(client, req);
+        UA_free(rvis); /* The NodeIds are shallow copies */
+        res = resp.responseHeader.serviceResult;
+        if(res == UA_STATUSCODE_GOOD && resp.resultsSize != rvisSize)
+            res = UA_STATUSCODE_BADUNEXPECTEDERROR;
+
+        /* Take the namespace array */
+        if(res == UA_STATUSCODE_GOOD && first) {
+            UA_Variant *ns = &resp.results[rvisSize-1].value;
+            if(ns->type == &UA_TYPES[UA_TYPES_STRING] && !UA_Variant_isScalar(ns)) {
+                schema->namespaces = (UA_String*)ns->data;
+                schema->namespacesSize = ns->arrayLength;
+                ns->data = NULL;
+                ns->arrayLength = 0;
+            }
+        }
+
+        /* Add the definitions. Referenced types are queued for the next
+         * round. */
+        UA_NodeId *next = NULL;
+        size_t nextSize = 0;
+        for(size_t i = 0; i < queueSize && res == UA_STATUSCODE_GOOD; i++)
+            res = addDefinition(client, schema, queue, queueSize, i,
+                                &resp.results[2*i], &resp.results[2*i+1],
+                                &next, &nextSize);
+        UA_ReadResponse_clear(&resp);
+        UA_Array_delete(queue, queueSize, &UA_TYPES[UA_TYPES_NODEID]);
+        queue = next;
+        queueSize = nextSize;
+        first = false;
+    }
+
+    UA_Array_delete(queue, queueSize, &UA_TYPES[UA_TYPES_NODEID]);
+    if(res != UA_STATUSCODE_GOOD)
+        UA_DataTypeSchemaHeader_clear(schema);
+    return res;
+}
 
 UA_StatusCode
 UA_Client_addReference(UA_Client *client, const UA_NodeId sourceNodeId,
@@ -363,6 +590,15 @@ UA_StatusCode
 __UA_Client_readAttribute(UA_Client *client, const UA_NodeId *nodeId,
                           UA_AttributeId attributeId, void *out,
                           const UA_DataType *outDataType) {
+    /* Static attributes of crawled nodes */
+    if(attributeId == UA_ATTRIBUTEID_NODECLASS ||
+       attributeId == UA_ATTRIBUTEID_BROWSENAME ||
+       attributeId == UA_ATTRIBUTEID_DISPLAYNAME) {
+        if(UA_Client_readCachedAttribute(client, nodeId, attributeId,
+                                         out) == UA_STATUSCODE_GOOD)
+            return UA_STATUSCODE_GOOD;
+    }
+
     UA_ReadValueId item;
     UA_ReadValueId_init(&item);
     item.nodeId = *nodeId;
@@ -0,0 +1,332 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/client_highlevel_async.h>
+
+#include "ua_client_internal.h"
+
+#define UA_HISTORYREAD_NODESPERREQUEST 10
+#define UA_HISTORYREAD_MAXINFLIGHT 4
+
+/* A node that is read with a continuation point, or a node that is read again
+ * from the start (empty continuation point) */
+typedef struct {
+    size_t nodeIndex;
+    UA_ByteString continuationPoint;
+} HistoryReadPending;
+
+typedef struct {
+    HistoryReadPending *entries;
+    size_t size;
+    size_t capacity;
+} HistoryReadPendingList;
+
+typedef struct {
+    UA_ExtensionObject details;
+    UA_HistoryReadValueId *nodes;
+    size_t nodesSize;
+    UA_ClientHistoryReadOptions options;
+    UA_ClientHistoryReadSink sink;
+    UA_ClientHistoryReadDone done;
+    void *context;
+
+    size_t nextNode; /* Next node that was not read yet */
+    HistoryReadPendingList conts;   /* Continue with the continuation point */
+    HistoryReadPendingList retries; /* Failed with BadNoContinuationPoints */
+    HistoryReadPendingList release; /* Continuation points to release */
+
+    size_t inFlight;
+    size_t cpOpen; /* Continuation points held by the client */
+    UA_StatusCode status; /* First error */
+} UA_HistoryReadStream;
+
+static void
+HistoryReadPendingList_clear(HistoryReadPendingList *list) {
+    for(size_t i = 0; i < list->size; i++)
+        UA_ByteString_clear(&list->entries[i].continuationPoint);
+    UA_free(list->entries);
+    memset(list, 0, sizeof(HistoryReadPendingList));
+}
+
+/* The continuation point is moved into the list */
+static UA_StatusCode
+HistoryReadPendingList_push(HistoryReadPendingList *list, size_t nodeIndex,
+                            UA_ByteString *continuationPoint) {
+    if(list->size == list->capacity) {
+        size_t newCapacity = (list->capacity == 0) ? 16 : list->capacity * 2;
+        HistoryReadPending *entries = (HistoryReadPending*)
+            UA_realloc(list->entries, newCapacity * sizeof(HistoryReadPending));
+        if(!entries)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        list->entries = entries;
+        list->capacity = newCapacity;
+    }
+    HistoryReadPending *entry = &list->entries[list->size++];
+    entry->nodeIndex = nodeIndex;
+    UA_ByteString_init(&entry->continuationPoint);
+    if(continuationPoint) {
+        entry->continuationPoint = *continuationPoint;
+        UA_ByteString_init(continuationPoint);
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+UA_HistoryReadStream_delete(UA_HistoryReadStream *hs) {
+    UA_ExtensionObject_clear(&hs->details);
+    UA_Array_delete(hs->nodes, hs->nodesSize,
+                    &UA_TYPES[UA_TYPES_HISTORYREADVALUEID]);
+    HistoryReadPendingList_clear(&hs->conts);
+    HistoryReadPendingList_clear(&hs->retries);
+    HistoryReadPendingList_clear(&hs->release);
+    UA_free(hs);
+}
+
+static void
+setHistoryReadStatus(UA_HistoryReadStream *hs, UA_StatusCode res) {
+    if(hs->status == UA_STATUSCODE_GOOD)
+        hs->status = res;
+}
+
+/* Context of a HistoryRead request in flight */
+typedef struct {
+    UA_HistoryReadStream *hs;
+    UA_Boolean release;  /* Only releases continuation points */
+    size_t cpSize;       /* Continuation points sent in the request */
+    size_t nodesSize;
+    size_t *nodes;       /* Node index for each HistoryReadValueId */
+} UA_HistoryReadRequestContext;
+
+static void historyReadDispatch(UA_Client *client, UA_HistoryReadStream *hs);
+
+static void
+historyReadProcessResults(UA_Client *client, UA_HistoryReadStream *hs,
+                          UA_HistoryReadRequestContext *rc,
+                          UA_HistoryReadResponse *response) {
+    if(response->responseHeader.serviceResult != UA_STATUSCODE_GOOD) {
+        setHistoryReadStatus(hs, response->responseHeader.serviceResult);
+        return;
+    }
+    if(response->resultsSize != rc->nodesSize) {
+        setHistoryReadStatus(hs, UA_STATUSCODE_BADUNEXPECTEDERROR);
+        return;
+    }
+
+    for(size_t i = 0; i < response->resultsSize; i++) {
+        UA_HistoryReadResult *res = &response->results[i];
+        size_t nodeIndex = rc->nodes[i];
+
+        /* The server has too many open continuation points. Read the node
+         * again after the pending requests have released theirs. */
+        if(res->statusCode == UA_STATUSCODE_BADNOCONTINUATIONPOINTS &&
+           hs->cpOpen > 0) {
+            setHistoryReadStatus(hs, HistoryReadPendingList_push(&hs->retries,
+                                                                 nodeIndex, NULL));
+            continue;
+        }
+
+        /* Hand the result to the sink without holding the lock */
+        UA_UNLOCK(&client->clientMutex);
+        UA_Boolean more = hs->sink(client, hs->context, nodeIndex, res);
+        UA_LOCK(&client->clientMutex);
+
+        if(res->continuationPoint.length == 0)
+            continue;
+        hs->cpOpen++;
+        HistoryReadPendingList *list = (more && hs->status == UA_STATUSCODE_GOOD) ?
+            &hs->conts : &hs->release;
+        UA_StatusCode retval =
+            HistoryReadPendingList_push(list, nodeIndex, &res->continuationPoint);
+        if(retval != UA_STATUSCODE_GOOD) {
+            hs->cpOpen--; /* Dropped. The server frees it eventually. */
+            setHistoryReadStatus(hs, retval);
+        }
+    }
+}
+
+static void
+historyReadCallback(UA_Client *client, void *userdata,
+                    UA_UInt32 requestId, void *response) {
+    UA_HistoryReadRequestContext *rc = (UA_HistoryReadRequestContext*)userdata;
+    UA_HistoryReadStream *hs = rc->hs;
+
+    UA_LOCK(&client->clientMutex);
+    hs->inFlight--;
+    hs->cpOpen -= rc->cpSize;
+    if(!rc->release)
+        historyReadProcessResults(client, hs, rc,
+                                  (UA_HistoryReadResponse*)response);
+    UA_free(rc);
+
+    historyReadDispatch(client, hs);
+    if(hs->inFlight > 0) {
+        UA_UNLOCK(&client->clientMutex);
+        return;
+    }
+
+    /* All requests have returned and nothing is left to be sent */
+    UA_UNLOCK(&client->clientMutex);
+    if(hs->done)
+        hs->done(client, hs->context, hs->status);
+    UA_HistoryReadStream_delete(hs);
+}
+
+static UA_StatusCode
+sendHistoryRead(UA_Client *client, UA_HistoryReadStream *hs,
+                HistoryReadPendingList *list, size_t listSize,
+                size_t freshSize, UA_Boolean release) {
+    size_t size = listSize + freshSize;
+    UA_HistoryReadRequestContext *rc = (UA_HistoryReadRequestContext*)
+        UA_calloc(1, sizeof(UA_HistoryReadRequestContext) + size * sizeof(size_t));
+    UA_HistoryReadValueId *items = (UA_HistoryReadValueId*)
+        UA_calloc(size, sizeof(UA_HistoryReadValueId));
+    if(!rc || !items) {
+        UA_free(rc);
+        UA_free(items);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    rc->hs = hs;
+    rc->release = release;
+    rc->nodesSize = size;
+    rc->nodes = (size_t*)&rc[1]; /* Allocated behind the struct */
+
+    /* Shallow copies of the nodes. The pending entries are taken from the end
+     * of the list. Fresh nodes follow after them. */
+    for(size_t i = 0; i < listSize; i++) {
+        HistoryReadPending *p = &list->entries[list->size - listSize + i];
+        rc->nodes[i] = p->nodeIndex;
+        items[i] = hs->nodes[p->nodeIndex];
+        items[i].continuationPoint = p->continuationPoint;
+        if(p->continuationPoint.length > 0)
+            rc->cpSize++;
+    }
+    for(size_t i = 0; i < freshSize; i++) {
+        rc->nodes[listSize + i] = hs->nextNode + i;
+        items[listSize + i] = hs->nodes[hs->nextNode + i];
+    }
+
+    UA_HistoryReadRequest request;
+    UA_HistoryReadRequest_init(&request);
+    request.historyReadDetails = hs->details;
+    request.timestampsToReturn = hs->options.timestampsToReturn;
+    request.releaseContinuationPoints = release;
+    request.nodesToRead = items;
+    request.nodesToReadSize = size;
+    UA_StatusCode res =
+        __Client_AsyncService(client, &request, &UA_TYPES[UA_TYPES_HISTORYREADREQUEST],
+                              historyReadCallback,
+                              &UA_TYPES[UA_TYPES_HISTORYREADRESPONSE], rc, NULL);
+    UA_free(items); /* Shallow */
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_free(rc);
+        return res;
+    }
+
+    /* The continuation points were consumed by the request */
+    for(size_t i = list->size - listSize; i < list->size; i++)
+        UA_ByteString_clear(&list->entries[i].continuationPoint);
+    list->size -= listSize;
+    hs->nextNode += freshSize;
+    hs->inFlight++;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Send requests until the limit of requests in flight is reached. The open
+ * continuation points are served first to keep their number low. */
+static void
+historyReadDispatch(UA_Client *client, UA_HistoryReadStream *hs) {
+    UA_LOCK_ASSERT(&client->clientMutex);
+
+    while(hs->status == UA_STATUSCODE_GOOD &&
+          hs->inFlight < hs->options.maxInFlight) {
+        size_t space = hs->options.nodesPerRequest;
+        HistoryReadPendingList *list = (hs->conts.size > 0) ?
+            &hs->conts : &hs->retries;
+        size_t listSize = (list->size < space) ? list->size : space;
+        space -= listSize;
+        size_t freshSize = hs->nodesSize - hs->nextNode;
+        if(freshSize > space)
+            freshSize = space;
+        if(listSize + freshSize == 0)
+            break;
+        setHistoryReadStatus(hs, sendHistoryRead(client, hs, list, listSize,
+                                                 freshSize, false));
+    }
+
+    /* Release the remaining continuation points after an error */
+    if(hs->status != UA_STATUSCODE_GOOD) {
+        for(size_t i = 0; i < hs->conts.size; i++) {
+            HistoryReadPending *p = &hs->conts.entries[i];
+            if(HistoryReadPendingList_push(&hs->release, p->nodeIndex,
+                                           &p->continuationPoint) != UA_STATUSCODE_GOOD)
+                UA_ByteString_clear(&p->continuationPoint);
+        }
+        hs->conts.size = 0;
+    }
+
+    /* The release requests are not limited by maxInFlight */
+    if(hs->release.size > 0) {
+        UA_StatusCode res = sendHistoryRead(client, hs, &hs->release,
+                                            hs->release.size, 0, true);
+        if(res != UA_STATUSCODE_GOOD) {
+            hs->cpOpen -= hs->release.size;
+            HistoryReadPendingList_clear(&hs->release);
+            setHistoryReadStatus(hs, res);
+        }
+    }
+}
+
+UA_StatusCode
+UA_Client_HistoryRead_stream_async(UA_Client *client,
+                                   const UA_ExtensionObject *historyReadDetails,
+                                   const UA_HistoryReadValueId *nodesToRead,
+                                   size_t nodesToReadSize,
+                                   const UA_ClientHistoryReadOptions *options,
+                                   UA_ClientHistoryReadSink sink,
+                                   UA_ClientHistoryReadDone done, void *context) {
+    if(!historyReadDetails || !sink || nodesToReadSize == 0)
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+
+    UA_HistoryReadStream *hs = (UA_HistoryReadStream*)
+        UA_calloc(1, sizeof(UA_HistoryReadStream));
+    if(!hs)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    hs->sink = sink;
+    hs->done = done;
+    hs->context = context;
+
+    /* Set the defaults */
+    if(options)
+        hs->options = *options;
+    else
+        hs->options.timestampsToReturn = UA_TIMESTAMPSTORETURN_SOURCE;
+    if(hs->options.nodesPerRequest == 0)
+        hs->options.nodesPerRequest = UA_HISTORYREAD_NODESPERREQUEST;
+    if(hs->options.maxInFlight == 0)
+        hs->options.maxInFlight = UA_HISTORYREAD_MAXINFLIGHT;
+
+    UA_StatusCode res = UA_ExtensionObject_copy(historyReadDetails, &hs->details);
+    res |= UA_Array_copy(nodesToRead, nodesToReadSize, (void**)&hs->nodes,
+                         &UA_TYPES[UA_TYPES_HISTORYREADVALUEID]);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_HistoryReadStream_delete(hs);
+        return res;
+    }
+    hs->nodesSize = nodesToReadSize;
+
+    /* Continuation points from the user are not followed */
+    for(size_t i = 0; i < hs->nodesSize; i++)
+        UA_ByteString_clear(&hs->nodes[i].continuationPoint);
+
+    UA_LOCK(&client->clientMutex);
+    historyReadDispatch(client, hs);
+    if(hs->inFlight == 0) {
+        /* Nothing could be sent */
+        res = (hs->status != UA_STATUSCODE_GOOD) ?
+            hs->status : UA_STATUSCODE_BADINTERNALERROR;
+        UA_HistoryReadStream_delete(hs);
+    }
+    UA_UNLOCK(&client->clientMutex);
+    return res;
+}
@@ -58,6 +58,7 @@ typedef struct UA_Client_Subscription {
     UA_UInt32 maxKeepAliveCount;
     UA_Client_StatusChangeNotificationCallback statusChangeCallback;
     UA_Client_DeleteSubscriptionCallback deleteCallback;
+    UA_Client_DataChangeBatchCallback dataChangeBatchCallback;
     UA_UInt32 sequenceNumber;
     UA_DateTime lastActivity;
     MonitorItemsTree monitoredItems;
@@ -66,6 +67,17 @@ typedef struct UA_Client_Subscription {
 void
 __Client_Subscriptions_clear(UA_Client *client);
 
+/* Keep the Subscriptions of a lost Session. They are transferred to the next
+ * activated Session with __Client_Subscriptions_transfer. */
+void
+__Client_Subscriptions_hold(UA_Client *client);
+
+void
+__Client_Subscriptions_transfer(UA_Client *client);
+
+void
+__Client_Subscriptions_clearHeld(UA_Client *client);
+
 /* Exposed for fuzzing */
 UA_StatusCode
 __Client_preparePublishRequest(UA_Client *client, UA_PublishRequest *request);
@@ -82,6 +94,8 @@ __Client_Subscriptions_backgroundPublishInactivityCheck(UA_Client *client);
 
 typedef struct AsyncServiceCall {
     LIST_ENTRY(AsyncServiceCall) pointers;
+    ZIP_ENTRY(AsyncServiceCall) idTreeEntry;
+    ZIP_ENTRY(AsyncServiceCall) timeoutTreeEntry;
     UA_UInt32 requestId;     /* Unique id */
     UA_UInt32 requestHandle; /* Potentially non-unique if manually defined in
                               * the request header*/
@@ -90,6 +104,7 @@ typedef struct AsyncServiceCall {
     void *userdata;
     UA_DateTime start;
     UA_UInt32 timeout;
+    UA_DateTime deadline;    /* start + timeout */
     UA_Response *syncResponse; /* If non-null, then this is the synchronous
                                 * response to be filled. Set back to null to
                                 * indicate that the response was filled. */
@@ -97,9 +112,29 @@ typedef struct AsyncServiceCall {
 
 typedef LIST_HEAD(UA_AsyncServiceList, AsyncServiceCall) UA_AsyncServiceList;
 
+enum ZIP_CMP
+cmpAsyncServiceRequestId(const UA_UInt32 *a, const UA_UInt32 *b);
+
+enum ZIP_CMP
+cmpAsyncServiceDeadline(const UA_DateTime *a, const UA_DateTime *b);
+
+/* Index of the outstanding service calls by their RequestId and by their
+ * deadline. The calls are additionally kept in a list for iteration. */
+typedef ZIP_HEAD(UA_AsyncServiceIdTree, AsyncServiceCall) UA_AsyncServiceIdTree;
+ZIP_FUNCTIONS(UA_AsyncServiceIdTree, AsyncServiceCall, idTreeEntry,
+              UA_UInt32, requestId, cmpAsyncServiceRequestId)
+
+typedef ZIP_HEAD(UA_AsyncServiceTimeoutTree, AsyncServiceCall) UA_AsyncServiceTimeoutTree;
+ZIP_FUNCTIONS(UA_AsyncServiceTimeoutTree, AsyncServiceCall, timeoutTreeEntry,
+              UA_DateTime, deadline, cmpAsyncServiceDeadline)
+
 void
 __Client_AsyncService_removeAll(UA_Client *client, UA_StatusCode statusCode);
 
+/* Async ReadRequests of the application that are combined into one
+ * ReadRequest. See UA_ClientConfig::readCoalescingMaxNodes. */
+typedef struct UA_ClientReadBatch UA_ClientReadBatch;
+
 typedef struct CustomCallback {
     UA_UInt32 callbackId;
 
@@ -155,12 +190,32 @@ struct UA_Client {
 
     /* Async Service */
     UA_AsyncServiceList asyncServiceCalls;
+    UA_AsyncServiceIdTree asyncServiceCallsById;
+    UA_AsyncServiceTimeoutTree asyncServiceCallsByDeadline;
+    size_t asyncServiceCallsSize;
+
+    /* Coalesced reads that are not yet sent. The flush runs as a delayed
+     * callback in the next EventLoop cycle. */
+    SIMPLEQ_HEAD(, UA_ClientReadBatch) readBatches;
+    UA_ClientReadBatch *readBatchOpen; /* Last batch, accepts more requests */
+    UA_UInt32 readBatchesInFlight;
+    UA_DelayedCallback readBatchFlush;
+    UA_Boolean readBatchFlushScheduled;
+
+    /* Static attributes of the crawled nodes. Owned by the user. */
+    UA_ClientBrowseCache *browseCache;
 
     /* Subscriptions */
     LIST_HEAD(, UA_Client_NotificationsAckNumber) pendingNotificationsAcks;
     LIST_HEAD(, UA_Client_Subscription) subscriptions;
+    LIST_HEAD(, UA_Client_Subscription) heldSubscriptions; /* To be transferred */
     UA_UInt32 monitoredItemHandles;
     UA_UInt16 currentlyOutStandingPublishRequests;
+    UA_UInt16 targetOutStandingPublishRequests; /* 0 = not yet adapted. See
+                                                 * minOutStandingPublishRequests */
+    UA_DateTime publishRoundTrip; /* Smoothed, 0 = no sample yet */
+    UA_UInt32 maxMonitoredItemsPerCall; /* OperationLimit of the server */
+    UA_Boolean operationLimitsRead; /* Once per Session */
 
     /* Internal locking for thread-safety. Methods starting with UA_Client_ that
      * are marked with UA_THREADSAFE take the lock. The lock is released before
@@ -193,7 +248,7 @@ __Client_renewSecureChannel(UA_Client *client);
 UA_StatusCode
 processServiceResponse(void *application, UA_SecureChannel *channel,
                        UA_MessageType messageType, UA_UInt32 requestId,
-                       UA_ByteString *message);
+                       const UA_ByteString *message, size_t messageSegments);
 
 UA_StatusCode connectInternal(UA_Client *client, UA_Boolean async);
 UA_StatusCode connectSecureChannel(UA_Client *client, const char *endpointUrl);
@@ -0,0 +1,185 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "ua_client_internal.h"
+
+typedef struct {
+    UA_Client *client;
+    UA_DateTime nextConnect; /* Earliest time for a reconnection attempt */
+} UA_ClientPoolEntry;
+
+struct UA_ClientPool {
+    UA_EventLoop *eventLoop; /* Owned by the first client */
+    UA_Boolean connect; /* Reconnect the clients if the connection fails */
+    size_t clientsSize;
+    UA_ClientPoolEntry *clients;
+    size_t nextClient; /* Round-robin start for the client selection */
+};
+
+UA_ClientPool *
+UA_ClientPool_new(void) {
+    return (UA_ClientPool*)UA_calloc(1, sizeof(UA_ClientPool));
+}
+
+UA_StatusCode
+UA_ClientPool_addClient(UA_ClientPool *pool, UA_Client *client) {
+    UA_ClientConfig *cc = &client->config;
+    if(!cc->eventLoop)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    /* Replace the EventLoop with the shared one */
+    if(pool->eventLoop && cc->eventLoop != pool->eventLoop) {
+        if(cc->eventLoop->state != UA_EVENTLOOPSTATE_FRESH)
+            return UA_STATUSCODE_BADINVALIDSTATE;
+        if(!cc->externalEventLoop)
+            cc->eventLoop->free(cc->eventLoop);
+        cc->eventLoop = pool->eventLoop;
+        cc->externalEventLoop = true;
+    }
+
+    UA_ClientPoolEntry *clients = (UA_ClientPoolEntry*)
+        UA_realloc(pool->clients, sizeof(UA_ClientPoolEntry) * (pool->clientsSize + 1));
+    if(!clients)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    pool->clients = clients;
+    clients[pool->clientsSize].client = client;
+    clients[pool->clientsSize].nextConnect = 0;
+    pool->clientsSize++;
+    if(!pool->eventLoop)
+        pool->eventLoop = cc->eventLoop;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* The outstanding PublishRequests are long-polling and don't count as load */
+static size_t
+clientLoad(UA_Client *client) {
+    size_t load = client->asyncServiceCallsSize;
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    if(load >= client->currentlyOutStandingPublishRequests)
+        load -= client->currentlyOutStandingPublishRequests;
+#endif
+    return load;
+}
+
+UA_Client *
+UA_ClientPool_getClient(UA_ClientPool *pool) {
+    UA_Client *best = NULL;
+    size_t bestLoad = 0;
+    size_t bestIndex = 0;
+    for(size_t i = 0; i < pool->clientsSize; i++) {
+        /* Start after the last selected client. Clients with the same load are
+         * selected in turns. */
+        size_t index = (pool->nextClient + i) % pool->clientsSize;
+        UA_Client *client = pool->clients[index].client;
+        UA_LOCK(&client->clientMutex);
+        UA_Boolean activated = (client->sessionState == UA_SESSIONSTATE_ACTIVATED);
+        size_t load = clientLoad(client);
+        UA_UNLOCK(&client->clientMutex);
+        if(!activated)
+            continue;
+        if(!best || load < bestLoad) {
+            best = client;
+            bestLoad = load;
+            bestIndex = index;
+        }
+    }
+    if(best)
+        pool->nextClient = bestIndex + 1;
+    return best;
+}
+
+UA_StatusCode
+UA_ClientPool_connectAsync(UA_ClientPool *pool, const char *endpointUrl) {
+    pool->connect = true;
+    UA_StatusCode lastError = UA_STATUSCODE_BADINVALIDSTATE;
+    size_t connecting = 0;
+    for(size_t i = 0; i < pool->clientsSize; i++) {
+        UA_StatusCode res = UA_Client_connectAsync(pool->clients[i].client, endpointUrl);
+        if(res != UA_STATUSCODE_GOOD) {
+            lastError = res;
+            continue;
+        }
+        connecting++;
+    }
+    return (connecting > 0) ? UA_STATUSCODE_GOOD : lastError;
+}
+
+/* Retry the connection of clients that gave up. While the connectStatus is
+ * good, the client reconnects internally. The EndpointUrl remains in the
+ * client config. */
+static void
+reconnectClients(UA_ClientPool *pool) {
+    UA_EventLoop *el = pool->eventLoop;
+    UA_DateTime now = el->dateTime_nowMonotonic(el);
+    for(size_t i = 0; i < pool->clientsSize; i++) {
+        UA_ClientPoolEntry *entry = &pool->clients[i];
+        UA_SecureChannelState channelState;
+        UA_StatusCode connectStatus;
+        UA_Client_getState(entry->client, &channelState, NULL, &connectStatus);
+        if(connectStatus == UA_STATUSCODE_GOOD ||
+           channelState != UA_SECURECHANNELSTATE_CLOSED)
+            continue;
+        if(now < entry->nextConnect)
+            continue;
+        UA_ClientConfig *cc = &entry->client->config;
+        entry->nextConnect = now + ((UA_DateTime)cc->timeout * UA_DATETIME_MSEC);
+        UA_LOG_INFO(cc->logging, UA_LOGCATEGORY_CLIENT,
+                    "Client pool: Reconnect the client %u after %s",
+                    (unsigned)i, UA_StatusCode_name(connectStatus));
+        __UA_Client_connect(entry->client, true);
+    }
+}
+
+UA_StatusCode
+UA_ClientPool_run_iterate(UA_ClientPool *pool, UA_UInt32 timeout) {
+    if(pool->clientsSize == 0)
+        return UA_STATUSCODE_BADINVALIDSTATE;
+
+    /* Register the housekeeping of all clients and start the EventLoop */
+    for(size_t i = 0; i < pool->clientsSize; i++) {
+        UA_Client *client = pool->clients[i].client;
+        UA_LOCK(&client->clientMutex);
+        UA_StatusCode res = __UA_Client_startup(client);
+        UA_UNLOCK(&client->clientMutex);
+        UA_CHECK_STATUS(res, return res);
+    }
+
+    /* The shared EventLoop processes the network events of all clients */
+    UA_EventLoop *el = pool->eventLoop;
+    UA_StatusCode res = el->run(el, timeout);
+    UA_CHECK_STATUS(res, return res);
+
+    if(pool->connect)
+        reconnectClients(pool);
+
+    /* Good if at least one client is usable or on the way */
+    res = UA_STATUSCODE_BADNOTCONNECTED;
+    for(size_t i = 0; i < pool->clientsSize; i++) {
+        UA_StatusCode connectStatus;
+        UA_Client_getState(pool->clients[i].client, NULL, NULL, &connectStatus);
+        if(connectStatus == UA_STATUSCODE_GOOD)
+            return UA_STATUSCODE_GOOD;
+        res = connectStatus;
+    }
+    return res;
+}
+
+void
+UA_ClientPool_disconnect(UA_ClientPool *pool) {
+    pool->connect = false;
+    for(size_t i = 0; i < pool->clientsSize; i++)
+        UA_Client_disconnect(pool->clients[i].client);
+}
+
+void
+UA_ClientPool_delete(UA_ClientPool *pool) {
+    UA_ClientPool_disconnect(pool);
+
+    /* The first client owns the shared EventLoop and is deleted last */
+    for(size_t i = pool->clientsSize; i > 0; i--)
+        UA_Client_delete(pool->clients[i - 1].client);
+
+    UA_free(pool->clients);
+    UA_free(pool);
+}
@@ -62,6 +62,7 @@ ua_Subscriptions_create(UA_Client *client, UA_Client_Subscription *newSub,
     newSub->lastActivity = el->dateTime_nowMonotonic(el);
     newSub->publishingInterval = response->revisedPublishingInterval;
     newSub->maxKeepAliveCount = response->revisedMaxKeepAliveCount;
+    newSub->dataChangeBatchCallback = NULL;
     ZIP_INIT(&newSub->monitoredItems);
     LIST_INSERT_HEAD(&client->subscriptions, newSub, listEntry);
 
@@ -418,6 +419,20 @@ UA_Client_Subscriptions_deleteSingle(UA_Client *client, UA_UInt32 subscriptionId
     return retval;
 }
 
+UA_StatusCode
+UA_Client_Subscriptions_setDataChangeBatchCallback(UA_Client *client,
+    UA_UInt32 subscriptionId, UA_Client_DataChangeBatchCallback callback) {
+    UA_LOCK(&client->clientMutex);
+    UA_Client_Subscription *sub = findSubscription(client, subscriptionId);
+    if(!sub) {
+        UA_UNLOCK(&client->clientMutex);
+        return UA_STATUSCODE_BADSUBSCRIPTIONIDINVALID;
+    }
+    sub->dataChangeBatchCallback = callback;
+    UA_UNLOCK(&client->clientMutex);
+    return UA_STATUSCODE_GOOD;
+}
+
 /******************/
 /* MonitoredItems */
 /******************/
@@ -664,11 +679,16 @@ createDataChanges_async(UA_Client *client, const UA_CreateMonitoredItemsRequest
         return res;
     }
 
-    return __Client_AsyncService(client, &data->request,
-                                 &UA_TYPES[UA_TYPES_CREATEMONITOREDITEMSREQUEST],
-                                 ua_MonitoredItems_create_async_handler,
-                                 &UA_TYPES[UA_TYPES_CREATEMONITOREDITEMSRESPONSE],
-                                 data, requestId);
+    res = __Client_AsyncService(client, &data->request,
+                                &UA_TYPES[UA_TYPES_CREATEMONITOREDITEMSREQUEST],
+                                ua_MonitoredItems_create_async_handler,
+                                &UA_TYPES[UA_TYPES_CREATEMONITOREDITEMSRESPONSE],
+                                data, requestId);
+    if(res != UA_STATUSCODE_GOOD) {
+        MonitoredItems_CreateData_clear(client, data);
+        UA_free(data);
+    }
+    return res;
 }
 
 UA_CreateMonitoredItemsResponse
@@ -732,6 +752,303 @@ UA_Client_MonitoredItems_createDataChange(UA_Client *client, UA_UInt32 subscript
     return result;
 }
 
+/* Chunk size if the server does not define a limit */
+#define UA_BULKCREATE_CHUNKSIZE 1000
+
+/* Chunks that are in flight at the same time */
+#define UA_BULKCREATE_MAXINFLIGHT 8
+
+typedef struct {
+    UA_CreateMonitoredItemsRequest request;
+    void **contexts;
+    void **handlingCallbacks;
+    UA_Client_DeleteMonitoredItemCallback *deleteCallbacks;
+    UA_CreateMonitoredItemsResponse response; /* Merged results */
+
+    size_t chunkSize; /* 0 = not yet known */
+    size_t nextItem;
+    size_t inFlight;
+    UA_Boolean done;
+    UA_Boolean detached; /* Free when done. The sync caller has given up. */
+
+    UA_ClientAsyncServiceCallback userCallback;
+    void *userData;
+} MonitoredItems_BulkCreate;
+
+typedef struct {
+    MonitoredItems_BulkCreate *bulk;
+    size_t offset;
+    size_t size;
+} MonitoredItems_BulkChunk;
+
+static void
+MonitoredItems_BulkCreate_delete(MonitoredItems_BulkCreate *bulk) {
+    UA_CreateMonitoredItemsRequest_clear(&bulk->request);
+    UA_CreateMonitoredItemsResponse_clear(&bulk->response);
+    UA_free(bulk->contexts);
+    UA_free(bulk->handlingCallbacks);
+    UA_free(bulk->deleteCallbacks);
+    UA_free(bulk);
+}
+
+static void
+bulkCreateFail(MonitoredItems_BulkCreate *bulk, size_t offset, size_t size,
+               UA_StatusCode statusCode) {
+    for(size_t i = offset; i < offset + size; i++)
+        bulk->response.results[i].statusCode = statusCode;
+}
+
+static void
+bulkCreateDispatch(UA_Client *client, MonitoredItems_BulkCreate *bulk);
+
+static void
+bulkCreateChunkCallback(UA_Client *client, void *userdata,
+                        UA_UInt32 requestId, void *r) {
+    MonitoredItems_BulkChunk *chunk = (MonitoredItems_BulkChunk*)userdata;
+    MonitoredItems_BulkCreate *bulk = chunk->bulk;
+    UA_CreateMonitoredItemsResponse *response = (UA_CreateMonitoredItemsResponse*)r;
+
+    UA_LOCK(&client->clientMutex);
+
+    /* Move the results into the merged response */
+    UA_StatusCode res = response->responseHeader.serviceResult;
+    if(res == UA_STATUSCODE_GOOD && response->resultsSize != chunk->size)
+        res = UA_STATUSCODE_BADINTERNALERROR;
+    if(res == UA_STATUSCODE_GOOD) {
+        memcpy(&bulk->response.results[chunk->offset], response->results,
+               chunk->size * sizeof(UA_MonitoredItemCreateResult));
+        UA_free(response->results);
+        response->results = NULL;
+        response->resultsSize = 0;
+    } else {
+        bulkCreateFail(bulk, chunk->offset, chunk->size, res);
+    }
+
+    bulk->inFlight--;
+    UA_free(chunk);
+    bulkCreateDispatch(client, bulk);
+
+    UA_UNLOCK(&client->clientMutex);
+}
+
+/* Send chunks until the limit of chunks in flight is reached. Notify the user
+ * when the last chunk has returned. */
+static void
+bulkCreateDispatch(UA_Client *client, MonitoredItems_BulkCreate *bulk) {
+    UA_LOCK_ASSERT(&client->clientMutex);
+
+    size_t itemsSize = bulk->request.itemsToCreateSize;
+    while(bulk->inFlight < UA_BULKCREATE_MAXINFLIGHT && bulk->nextItem < itemsSize) {
+        size_t offset = bulk->nextItem;
+        size_t size = itemsSize - offset;
+        if(size > bulk->chunkSize)
+            size = bulk->chunkSize;
+        bulk->nextItem += size;
+
+        MonitoredItems_BulkChunk *chunk = (MonitoredItems_BulkChunk*)
+            UA_malloc(sizeof(MonitoredItems_BulkChunk));
+        if(!chunk) {
+            bulkCreateFail(bulk, offset, size, UA_STATUSCODE_BADOUTOFMEMORY);
+            continue;
+        }
+        chunk->bulk = bulk;
+        chunk->offset = offset;
+        chunk->size = size;
+
+        /* The request is copied internally. Point into the full request. */
+        UA_CreateMonitoredItemsRequest chunkRequest = bulk->request;
+        chunkRequest.itemsToCreate = &bulk->request.itemsToCreate[offset];
+        chunkRequest.itemsToCreateSize = size;
+        UA_StatusCode res =
+            createDataChanges_async(client, chunkRequest, &bulk->contexts[offset],
+                                    &bulk->handlingCallbacks[offset],
+                                    &bulk->deleteCallbacks[offset],
+                                    bulkCreateChunkCallback, chunk, NULL);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_free(chunk);
+            bulkCreateFail(bulk, offset, size, res);
+            continue;
+        }
+        bulk->inFlight++;
+    }
+
+    if(bulk->inFlight > 0 || bulk->done)
+        return;
+
+    /* All chunks have returned */
+    bulk->done = true;
+    if(bulk->userCallback) {
+        UA_UNLOCK(&client->clientMutex);
+        bulk->userCallback(client, bulk->userData, 0, &bulk->response);
+        UA_LOCK(&client->clientMutex);
+    }
+    if(bulk->userCallback || bulk->detached)
+        MonitoredItems_BulkCreate_delete(bulk);
+}
+
+static void
+bulkCreateStart(UA_Client *client, MonitoredItems_BulkCreate *bulk) {
+    bulk->chunkSize = client->maxMonitoredItemsPerCall;
+    if(bulk->chunkSize == 0)
+        bulk->chunkSize = UA_BULKCREATE_CHUNKSIZE;
+    bulkCreateDispatch(client, bulk);
+}
+
+static void
+bulkCreateReadLimitCallback(UA_Client *client, void *userdata,
+                            UA_UInt32 requestId, void *r) {
+    MonitoredItems_BulkCreate *bulk = (MonitoredItems_BulkCreate*)userdata;
+    UA_ReadResponse *response = (UA_ReadResponse*)r;
+
+    UA_LOCK(&client->clientMutex);
+
+    /* Servers without the OperationLimits object have no limit */
+    client->maxMonitoredItemsPerCall = 0;
+    if(response->responseHeader.serviceResult == UA_STATUSCODE_GOOD &&
+       response->resultsSize == 1 && response->results[0].hasValue &&
+       UA_Variant_hasScalarType(&response->results[0].value, &UA_TYPES[UA_TYPES_UINT32]))
+        client->maxMonitoredItemsPerCall = *(UA_UInt32*)response->results[0].value.data;
+    client->operationLimitsRead = true;
+
+    bulkCreateStart(client, bulk);
+
+    UA_UNLOCK(&client->clientMutex);
+}
+
+static UA_StatusCode
+createDataChangesBulk_async(UA_Client *client, const UA_CreateMonitoredItemsRequest *request,
+                            void **contexts, void **callbacks,
+                            UA_Client_DeleteMonitoredItemCallback *deleteCallbacks,
+                            UA_ClientAsyncServiceCallback createCallback, void *userdata,
+                            MonitoredItems_BulkCreate **outBulk) {
+    UA_LOCK_ASSERT(&client->clientMutex);
+
+    if(!request->itemsToCreateSize)
+        return UA_STATUSCODE_BADNOTHINGTODO;
+    if(!findSubscription(client, request->subscriptionId))
+        return UA_STATUSCODE_BADSUBSCRIPTIONIDINVALID;
+
+    MonitoredItems_BulkCreate *bulk = (MonitoredItems_BulkCreate*)
+        UA_calloc(1, sizeof(MonitoredItems_BulkCreate));
+    if(!bulk)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    bulk->userCallback = createCallback;
+    bulk->userData = userdata;
+
+    /* Copy the request and align the arrays */
+    size_t size = request->itemsToCreateSize;
+    UA_StatusCode res = UA_CreateMonitoredItemsRequest_copy(request, &bulk->request);
+    bulk->contexts = (void**)UA_calloc(size, sizeof(void*));
+    bulk->handlingCallbacks = (void**)UA_calloc(size, sizeof(void*));
+    bulk->deleteCallbacks = (UA_Client_DeleteMonitoredItemCallback*)
+        UA_calloc(size, sizeof(UA_Client_DeleteMonitoredItemCallback));
+    bulk->response.results = (UA_MonitoredItemCreateResult*)
+        UA_Array_new(size, &UA_TYPES[UA_TYPES_MONITOREDITEMCREATERESULT]);
+    if(res != UA_STATUSCODE_GOOD || !bulk->contexts || !bulk->handlingCallbacks ||
+       !bulk->deleteCallbacks || !bulk->response.results) {
+        MonitoredItems_BulkCreate_delete(bulk);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    bulk->response.resultsSize = size;
+    if(contexts)
+        memcpy(bulk->contexts, contexts, size * sizeof(void*));
+    if(callbacks)
+        memcpy(bulk->handlingCallbacks, callbacks, size * sizeof(void*));
+    if(deleteCallbacks)
+        memcpy(bulk->deleteCallbacks, deleteCallbacks,
+               size * sizeof(UA_Client_DeleteMonitoredItemCallback));
+    if(outBulk)
+        *outBulk = bulk;
+
+    /* The limit is known */
+    if(client->operationLimitsRead) {
+        bulkCreateStart(client, bulk);
+        return UA_STATUSCODE_GOOD;
+    }
+
+    /* Read the OperationLimit first */
+    UA_ReadValueId rvi;
+    UA_ReadValueId_init(&rvi);
+    rvi.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERCAPABILITIES_OPERATIONLIMITS_MAXMONITOREDITEMSPERCALL);
+    rvi.attributeId = UA_ATTRIBUTEID_VALUE;
+    UA_ReadRequest readRequest;
+    UA_ReadRequest_init(&readRequest);
+    readRequest.nodesToRead = &rvi;
+    readRequest.nodesToReadSize = 1;
+    res = __Client_AsyncService(client, &readRequest, &UA_TYPES[UA_TYPES_READREQUEST],
+                                bulkCreateReadLimitCallback,
+                                &UA_TYPES[UA_TYPES_READRESPONSE], bulk, NULL);
+    if(res != UA_STATUSCODE_GOOD) {
+        if(outBulk)
+            *outBulk = NULL;
+        MonitoredItems_BulkCreate_delete(bulk);
+    }
+    return res;
+}
+
+UA_CreateMonitoredItemsResponse
+UA_Client_MonitoredItems_createDataChangesBulk(UA_Client *client,
+                                               const UA_CreateMonitoredItemsRequest request,
+                                               void **contexts,
+                                               UA_Client_DataChangeNotificationCallback *callbacks,
+                                               UA_Client_DeleteMonitoredItemCallback *deleteCallbacks) {
+    UA_CreateMonitoredItemsResponse response;
+    UA_CreateMonitoredItemsResponse_init(&response);
+
+    UA_LOCK(&client->clientMutex);
+
+    /* Without a callback the bulk state is kept when done */
+    MonitoredItems_BulkCreate *bulk = NULL;
+    UA_StatusCode res =
+        createDataChangesBulk_async(client, &request, contexts, (void**)callbacks,
+                                    deleteCallbacks, NULL, NULL, &bulk);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_UNLOCK(&client->clientMutex);
+        response.responseHeader.serviceResult = res;
+        return response;
+    }
+
+    /* Run the EventLoop until all chunks have returned. Every chunk returns
+     * eventually, at the latest when it times out or the Session is closed. */
+    UA_EventLoop *el = client->config.eventLoop;
+    while(!bulk->done) {
+        UA_UNLOCK(&client->clientMutex);
+        res = el->run(el, client->config.timeout);
+        UA_LOCK(&client->clientMutex);
+        if(res != UA_STATUSCODE_GOOD)
+            break;
+    }
+
+    if(!bulk->done) {
+        /* Free when the remaining chunks have returned */
+        bulk->detached = true;
+        response.responseHeader.serviceResult = res;
+    } else {
+        response = bulk->response;
+        UA_CreateMonitoredItemsResponse_init(&bulk->response);
+        MonitoredItems_BulkCreate_delete(bulk);
+    }
+
+    UA_UNLOCK(&client->clientMutex);
+    return response;
+}
+
+UA_StatusCode
+UA_Client_MonitoredItems_createDataChangesBulk_async(UA_Client *client,
+                                                     const UA_CreateMonitoredItemsRequest request,
+                                                     void **contexts,
+                                                     UA_Client_DataChangeNotificationCallback *callbacks,
+                                                     UA_Client_DeleteMonitoredItemCallback *deleteCallbacks,
+                                                     UA_ClientAsyncServiceCallback createCallback,
+                                                     void *userdata) {
+    UA_LOCK(&client->clientMutex);
+    UA_StatusCode res =
+        createDataChangesBulk_async(client, &request, contexts, (void**)callbacks,
+                                    deleteCallbacks, createCallback, userdata, NULL);
+    UA_UNLOCK(&client->clientMutex);
+    return res;
+}
+
 UA_CreateMonitoredItemsResponse
 UA_Client_MonitoredItems_createEvents(UA_Client *client,
                                       const UA_CreateMonitoredItemsRequest request,
@@ -1052,11 +1369,138 @@ __nextSequenceNumber(UA_UInt32 sequenceNumber) {
     return nextSequenceNumber;
 }
 
+/* Sequence number a comes after b. Takes the wrap-around into account. */
+static UA_Boolean
+sequenceNumberAfter(UA_UInt32 a, UA_UInt32 b) {
+    return ((UA_Int32)(a - b) > 0);
+}
+
+static void
+addNotificationAck(UA_Client *client, UA_UInt32 subscriptionId,
+                   UA_UInt32 sequenceNumber) {
+    UA_Client_NotificationsAckNumber *tmpAck = (UA_Client_NotificationsAckNumber*)
+        UA_malloc(sizeof(UA_Client_NotificationsAckNumber));
+    if(!tmpAck) {
+        UA_LOG_WARNING(client->config.logging, UA_LOGCATEGORY_CLIENT,
+                       "Not enough memory to store the acknowledgement for a publish "
+                       "message on subscription %" PRIu32, subscriptionId);
+        return;
+    }
+    tmpAck->subAck.sequenceNumber = sequenceNumber;
+    tmpAck->subAck.subscriptionId = subscriptionId;
+    LIST_INSERT_HEAD(&client->pendingNotificationsAcks, tmpAck, listEntry);
+}
+
+static UA_Boolean
+processNotificationMessage(UA_Client *client, UA_Client_Subscription *sub,
+                           UA_ExtensionObject *msg);
+
+static void
+republishCallback(UA_Client *client, void *userdata,
+                  UA_UInt32 requestId, void *response) {
+    UA_RepublishRequest *req = (UA_RepublishRequest*)userdata;
+    UA_RepublishResponse *res = (UA_RepublishResponse*)response;
+
+    UA_LOCK(&client->clientMutex);
+
+    UA_Client_Subscription *sub = findSubscription(client, req->subscriptionId);
+    if(!sub || res->responseHeader.serviceResult != UA_STATUSCODE_GOOD) {
+        UA_LOG_WARNING(client->config.logging, UA_LOGCATEGORY_CLIENT,
+                       "Could not republish the NotificationMessage %" PRIu32
+                       " of Subscription %" PRIu32 " with StatusCode %s",
+                       req->retransmitSequenceNumber, req->subscriptionId,
+                       UA_StatusCode_name(res->responseHeader.serviceResult));
+        goto cleanup;
+    }
+
+    UA_NotificationMessage *msg = &res->notificationMessage;
+    for(size_t k = 0; k < msg->notificationDataSize; ++k) {
+        if(processNotificationMessage(client, sub, &msg->notificationData[k])) {
+            __Client_Subscription_deleteInternal(client, sub);
+            goto cleanup;
+        }
+    }
+    addNotificationAck(client, req->subscriptionId, req->retransmitSequenceNumber);
+
+ cleanup:
+    UA_RepublishRequest_delete(req);
+    UA_UNLOCK(&client->clientMutex);
+}
+
+/* Request a NotificationMessage from the retransmission queue of the server */
+static void
+requestRepublish(UA_Client *client, UA_UInt32 subscriptionId,
+                 UA_UInt32 sequenceNumber) {
+    UA_LOCK_ASSERT(&client->clientMutex);
+
+    UA_RepublishRequest *req = UA_RepublishRequest_new();
+    if(!req)
+        return;
+    req->subscriptionId = subscriptionId;
+    req->retransmitSequenceNumber = sequenceNumber;
+    UA_StatusCode res =
+        __Client_AsyncService(client, req, &UA_TYPES[UA_TYPES_REPUBLISHREQUEST],
+                              republishCallback, &UA_TYPES[UA_TYPES_REPUBLISHRESPONSE],
+                              req, NULL);
+    if(res != UA_STATUSCODE_GOOD)
+        UA_RepublishRequest_delete(req);
+}
+
+/* Resolve the MonitoredItems and hand over the entire notification */
+static void
+processDataChangeNotificationBatch(UA_Client *client, UA_Client_Subscription *sub,
+                                   UA_DataChangeNotification *dataChangeNotification) {
+    UA_LOCK_ASSERT(&client->clientMutex);
+
+    size_t size = dataChangeNotification->monitoredItemsSize;
+    if(size == 0)
+        return;
+
+    /* One allocation for both arrays */
+    void **monContexts = (void**)
+        UA_malloc(size * (sizeof(void*) + sizeof(UA_UInt32)));
+    if(!monContexts) {
+        UA_LOG_WARNING(client->config.logging, UA_LOGCATEGORY_CLIENT,
+                       "Not enough memory to process a DataChangeNotification "
+                       "on subscription %" PRIu32, sub->subscriptionId);
+        return;
+    }
+    UA_UInt32 *monIds = (UA_UInt32*)&monContexts[size];
+
+    for(size_t j = 0; j < size; ++j) {
+        UA_Client_MonitoredItem dummy;
+        dummy.clientHandle = dataChangeNotification->monitoredItems[j].clientHandle;
+        UA_Client_MonitoredItem *mon =
+            ZIP_FIND(MonitorItemsTree, &sub->monitoredItems, &dummy);
+        if(!mon || mon->isEventMonitoredItem) {
+            monIds[j] = 0;
+            monContexts[j] = NULL;
+            continue;
+        }
+        monIds[j] = mon->monitoredItemId;
+        monContexts[j] = mon->context;
+    }
+
+    UA_Client_DataChangeBatchCallback cb = sub->dataChangeBatchCallback;
+    void *subC = sub->context;
+    UA_UInt32 subId = sub->subscriptionId;
+    UA_UNLOCK(&client->clientMutex);
+    cb(client, subId, subC, dataChangeNotification, monIds, monContexts);
+    UA_LOCK(&client->clientMutex);
+
+    UA_free(monContexts);
+}
+
 static void
 processDataChangeNotification(UA_Client *client, UA_Client_Subscription *sub,
                               UA_DataChangeNotification *dataChangeNotification) {
     UA_LOCK_ASSERT(&client->clientMutex);
 
+    if(sub->dataChangeBatchCallback) {
+        processDataChangeNotificationBatch(client, sub, dataChangeNotification);
+        return;
+    }
+
     for(size_t j = 0; j < dataChangeNotification->monitoredItemsSize; ++j) {
         UA_MonitoredItemNotification *min = &dataChangeNotification->monitoredItems[j];
 
@@ -1133,20 +1577,23 @@ processEventNotification(UA_Client *client, UA_Client_Subscription *sub,
     }
 }
 
-static void
+/* Returns true if a StatusChangeNotification indicates that the Subscription
+ * no longer exists in the Session on the server. That is the case after a
+ * timeout or a transfer to another Session. */
+static UA_Boolean
 processNotificationMessage(UA_Client *client, UA_Client_Subscription *sub,
                            UA_ExtensionObject *msg) {
     UA_LOCK_ASSERT(&client->clientMutex);
 
     if(msg->encoding != UA_EXTENSIONOBJECT_DECODED)
-        return;
+        return false;
 
     /* Handle DataChangeNotification */
     if(msg->content.decoded.type == &UA_TYPES[UA_TYPES_DATACHANGENOTIFICATION]) {
         UA_DataChangeNotification *dataChangeNotification =
             (UA_DataChangeNotification *)msg->content.decoded.data;
         processDataChangeNotification(client, sub, dataChangeNotification);
-        return;
+        return false;
     }
 
     /* Handle EventNotification */
@@ -1154,28 +1601,100 @@ processNotificationMessage(UA_Client *client, UA_Client_Subscription *sub,
         UA_EventNotificationList *eventNotificationList =
             (UA_EventNotificationList *)msg->content.decoded.data;
         processEventNotification(client, sub, eventNotificationList);
-        return;
+        return false;
     }
 
     /* Handle StatusChangeNotification */
     if(msg->content.decoded.type == &UA_TYPES[UA_TYPES_STATUSCHANGENOTIFICATION]) {
+        UA_StatusChangeNotification *scn =
+            (UA_StatusChangeNotification*)msg->content.decoded.data;
+        UA_StatusCode status = scn->status;
         if(sub->statusChangeCallback) {
             void *subC = sub->context;
             UA_UInt32 subId = sub->subscriptionId;
             UA_UNLOCK(&client->clientMutex);
-            sub->statusChangeCallback(client, subId, subC,
-                                      (UA_StatusChangeNotification*)msg->content.decoded.data);
+            sub->statusChangeCallback(client, subId, subC, scn);
             UA_LOCK(&client->clientMutex);
         } else {
             UA_LOG_WARNING(client->config.logging, UA_LOGCATEGORY_CLIENT,
                            "Dropped a StatusChangeNotification since no "
                            "callback is registered");
         }
-        return;
+        return (status == UA_STATUSCODE_GOODSUBSCRIPTIONTRANSFERRED ||
+                UA_StatusCode_isBad(status));
     }
 
     UA_LOG_WARNING(client->config.logging, UA_LOGCATEGORY_CLIENT,
                    "Unknown notification message type");
+    return false;
+}
+
+/* Number of PublishRequests to keep in flight. Without adaptation this is the
+ * configured outStandingPublishRequests. */
+static UA_UInt16
+publishRequestsLimit(UA_Client *client) {
+    UA_UInt16 max = client->config.outStandingPublishRequests;
+    if(client->config.minOutStandingPublishRequests == 0)
+        return max;
+    if(client->targetOutStandingPublishRequests == 0)
+        client->targetOutStandingPublishRequests =
+            client->config.minOutStandingPublishRequests;
+    return (client->targetOutStandingPublishRequests < max) ?
+        client->targetOutStandingPublishRequests : max;
+}
+
+/* Adapt the target number of outstanding PublishRequests from a successful
+ * PublishResponse. A response with moreNotifications was sent right away by
+ * the server and measures the round-trip time. A keep-alive while other
+ * requests are still waiting in the server means there are too many. */
+static void
+adaptPublishRequests(UA_Client *client, const UA_PublishRequest *request,
+                     const UA_PublishResponse *response) {
+    UA_UInt16 min = client->config.minOutStandingPublishRequests;
+    UA_UInt16 max = client->config.outStandingPublishRequests;
+    if(min == 0)
+        return;
+    if(min > max)
+        min = max;
+
+    UA_UInt16 target = publishRequestsLimit(client);
+    if(response->moreNotifications) {
+        UA_EventLoop *el = client->config.eventLoop;
+        UA_DateTime rtt = el->dateTime_now(el) - request->requestHeader.timestamp;
+        if(rtt > 0)
+            client->publishRoundTrip = (client->publishRoundTrip == 0) ?
+                rtt : (client->publishRoundTrip * 7 + rtt) / 8;
+        target++;
+    } else if(response->notificationMessage.notificationDataSize == 0 &&
+              client->currentlyOutStandingPublishRequests > 0 && target > 0) {
+        target--;
+    }
+
+    /* Cover the round-trip time of the fastest subscription. One request
+     * has to wait in the server while the others are on the wire. */
+    UA_Double interval = 0.0;
+    UA_Client_Subscription *sub;
+    LIST_FOREACH(sub, &client->subscriptions, listEntry) {
+        if(interval == 0.0 || sub->publishingInterval < interval)
+            interval = sub->publishingInterval;
+    }
+    if(interval > 0.0 && client->publishRoundTrip > 0) {
+        UA_Double rttMs = (UA_Double)client->publishRoundTrip / UA_DATETIME_MSEC;
+        UA_Double needed = (rttMs / interval) + 2.0;
+        if(needed > (UA_Double)max)
+            needed = (UA_Double)max;
+        if(target < (UA_UInt16)needed)
+            target = (UA_UInt16)needed;
+    }
+
+    if(target < min)
+        target = min;
+    if(target > max)
+        target = max;
+    if(target != client->targetOutStandingPublishRequests)
+        UA_LOG_DEBUG(client->config.logging, UA_LOGCATEGORY_CLIENT,
+                     "Adapt the outstanding PublishRequests to %" PRIu16, target);
+    client->targetOutStandingPublishRequests = target;
 }
 
 static void
@@ -1185,7 +1704,9 @@ __Client_Subscriptions_processPublishResponse(UA_Client *client, UA_PublishReque
 
     UA_NotificationMessage *msg = &response->notificationMessage;
 
-    client->currentlyOutStandingPublishRequests--;
+    /* The counter was reset if the Session was cleaned up in the meantime */
+    if(client->currentlyOutStandingPublishRequests > 0)
+        client->currentlyOutStandingPublishRequests--;
 
     if(response->responseHeader.serviceResult == UA_STATUSCODE_BADTOOMANYPUBLISHREQUESTS) {
         if(client->config.outStandingPublishRequests > 1) {
@@ -1260,6 +1781,8 @@ __Client_Subscriptions_processPublishResponse(UA_Client *client, UA_PublishReque
     UA_EventLoop *el = client->config.eventLoop;
     sub->lastActivity = el->dateTime_nowMonotonic(el);
 
+    adaptPublishRequests(client, request, response);
+
     /* Detect missing message - OPC Unified Architecture, Part 4 5.13.1.1 e) */
     if(__nextSequenceNumber(sub->sequenceNumber) != msg->sequenceNumber) {
         UA_LOG_WARNING(client->config.logging, UA_LOGCATEGORY_CLIENT,
@@ -1276,28 +1799,36 @@ __Client_Subscriptions_processPublishResponse(UA_Client *client, UA_PublishReque
      * the sequence number of the next NotificationMessage that is to be sent =>
      * More than one consecutive keep-alive message or a NotificationMessage
      * following a keep-alive message will share the same sequence number. */
+
+    /* Republish the NotificationMessages that were sent but not received. For
+     * example when the PublishResponses were lost with the SecureChannel. Only
+     * the messages between the last received and the current one are
+     * requested. */
+    for(size_t i = 0; i < response->availableSequenceNumbersSize; i++) {
+        UA_UInt32 seq = response->availableSequenceNumbers[i];
+        if(sequenceNumberAfter(seq, sub->sequenceNumber) &&
+           sequenceNumberAfter(msg->sequenceNumber, seq))
+            requestRepublish(client, sub->subscriptionId, seq);
+    }
+
     if (msg->notificationDataSize)
         sub->sequenceNumber = msg->sequenceNumber;
 
     /* Process the notification messages */
-    for(size_t k = 0; k < msg->notificationDataSize; ++k)
-        processNotificationMessage(client, sub, &msg->notificationData[k]);
+    for(size_t k = 0; k < msg->notificationDataSize; ++k) {
+        if(processNotificationMessage(client, sub, &msg->notificationData[k])) {
+            /* The server has already removed the Subscription from the
+             * Session. Nothing to acknowledge. */
+            __Client_Subscription_deleteInternal(client, sub);
+            return;
+        }
+    }
 
     /* Add to the list of pending acks */
     for(size_t i = 0; i < response->availableSequenceNumbersSize; i++) {
         if(response->availableSequenceNumbers[i] != msg->sequenceNumber)
             continue;
-        UA_Client_NotificationsAckNumber *tmpAck = (UA_Client_NotificationsAckNumber*)
-            UA_malloc(sizeof(UA_Client_NotificationsAckNumber));
-        if(!tmpAck) {
-            UA_LOG_WARNING(client->config.logging, UA_LOGCATEGORY_CLIENT,
-                           "Not enough memory to store the acknowledgement for a publish "
-                           "message on subscription %" PRIu32, sub->subscriptionId);
-            break;
-        }
-        tmpAck->subAck.sequenceNumber = msg->sequenceNumber;
-        tmpAck->subAck.subscriptionId = sub->subscriptionId;
-        LIST_INSERT_HEAD(&client->pendingNotificationsAcks, tmpAck, listEntry);
+        addNotificationAck(client, sub->subscriptionId, msg->sequenceNumber);
         break;
     }
 }
@@ -1336,7 +1867,138 @@ __Client_Subscriptions_clear(UA_Client *client) {
     LIST_FOREACH_SAFE(sub, &client->subscriptions, listEntry, tmps)
         __Client_Subscription_deleteInternal(client, sub); /* force local removal */
 
-    client->monitoredItemHandles = 0;
+    /* The clientHandles of held MonitoredItems remain in use */
+    if(LIST_EMPTY(&client->heldSubscriptions))
+        client->monitoredItemHandles = 0;
+}
+
+void
+__Client_Subscriptions_hold(UA_Client *client) {
+    UA_LOCK_ASSERT(&client->clientMutex);
+    UA_Client_Subscription *sub;
+    while((sub = LIST_FIRST(&client->subscriptions))) {
+        LIST_REMOVE(sub, listEntry);
+        LIST_INSERT_HEAD(&client->heldSubscriptions, sub, listEntry);
+    }
+}
+
+void
+__Client_Subscriptions_clearHeld(UA_Client *client) {
+    UA_Client_Subscription *sub;
+    while((sub = LIST_FIRST(&client->heldSubscriptions)))
+        __Client_Subscription_deleteInternal(client, sub);
+    if(LIST_EMPTY(&client->subscriptions))
+        client->monitoredItemHandles = 0;
+}
+
+static void
+transferSubscriptionsCallback(UA_Client *client, void *userdata,
+                              UA_UInt32 requestId, void *response) {
+    UA_TransferSubscriptionsRequest *req = (UA_TransferSubscriptionsRequest*)userdata;
+    UA_TransferSubscriptionsResponse *res = (UA_TransferSubscriptionsResponse*)response;
+
+    UA_LOCK(&client->clientMutex);
+
+    if(res->responseHeader.serviceResult != UA_STATUSCODE_GOOD ||
+       res->resultsSize != req->subscriptionIdsSize) {
+        UA_LOG_WARNING(client->config.logging, UA_LOGCATEGORY_CLIENT,
+                       "TransferSubscriptions failed with StatusCode %s",
+                       UA_StatusCode_name(res->responseHeader.serviceResult));
+        goto cleanup;
+    }
+
+    for(size_t i = 0; i < res->resultsSize; i++) {
+        UA_TransferResult *tr = &res->results[i];
+        UA_Client_Subscription *sub;
+        LIST_FOREACH(sub, &client->heldSubscriptions, listEntry) {
+            if(sub->subscriptionId == req->subscriptionIds[i])
+                break;
+        }
+        if(!sub)
+            continue;
+        if(tr->statusCode != UA_STATUSCODE_GOOD) {
+            UA_LOG_WARNING(client->config.logging, UA_LOGCATEGORY_CLIENT,
+                           "Subscription %" PRIu32 " could not be transferred "
+                           "with StatusCode %s", sub->subscriptionId,
+                           UA_StatusCode_name(tr->statusCode));
+            continue; /* Deleted below */
+        }
+
+        /* Reattach */
+        LIST_REMOVE(sub, listEntry);
+        LIST_INSERT_HEAD(&client->subscriptions, sub, listEntry);
+        UA_EventLoop *el = client->config.eventLoop;
+        sub->lastActivity = el->dateTime_nowMonotonic(el);
+
+        /* Acknowledge the NotificationMessages that were already received.
+         * Republish the others. */
+        UA_UInt32 last = sub->sequenceNumber;
+        for(size_t j = 0; j < tr->availableSequenceNumbersSize; j++) {
+            UA_UInt32 seq = tr->availableSequenceNumbers[j];
+            if(!sequenceNumberAfter(seq, last)) {
+                addNotificationAck(client, sub->subscriptionId, seq);
+                continue;
+            }
+            requestRepublish(client, sub->subscriptionId, seq);
+            if(sequenceNumberAfter(seq, sub->sequenceNumber))
+                sub->sequenceNumber = seq;
+        }
+        UA_LOG_INFO(client->config.logging, UA_LOGCATEGORY_CLIENT,
+                    "Subscription %" PRIu32 " transferred to the new Session",
+                    sub->subscriptionId);
+    }
+
+ cleanup:
+    /* Remove the Subscriptions that could not be transferred */
+    __Client_Subscriptions_clearHeld(client);
+    UA_TransferSubscriptionsRequest_delete(req);
+
+    /* Send PublishRequests for the transferred Subscriptions */
+    __Client_Subscriptions_backgroundPublish(client);
+
+    UA_UNLOCK(&client->clientMutex);
+}
+
+void
+__Client_Subscriptions_transfer(UA_Client *client) {
+    UA_LOCK_ASSERT(&client->clientMutex);
+
+    size_t count = 0;
+    UA_Client_Subscription *sub;
+    LIST_FOREACH(sub, &client->heldSubscriptions, listEntry)
+        count++;
+    if(count == 0)
+        return;
+
+    UA_TransferSubscriptionsRequest *req = UA_TransferSubscriptionsRequest_new();
+    if(!req) {
+        __Client_Subscriptions_clearHeld(client);
+        return;
+    }
+    req->subscriptionIds = (UA_UInt32*)
+        UA_Array_new(count, &UA_TYPES[UA_TYPES_UINT32]);
+    if(!req->subscriptionIds) {
+        UA_TransferSubscriptionsRequest_delete(req);
+        __Client_Subscriptions_clearHeld(client);
+        return;
+    }
+    req->subscriptionIdsSize = count;
+    size_t i = 0;
+    LIST_FOREACH(sub, &client->heldSubscriptions, listEntry)
+        req->subscriptionIds[i++] = sub->subscriptionId;
+
+    /* The MonitoredItems are known. Don't resend the current values. */
+    req->sendInitialValues = false;
+
+    UA_StatusCode res =
+        __Client_AsyncService(client, req, &UA_TYPES[UA_TYPES_TRANSFERSUBSCRIPTIONSREQUEST],
+                              transferSubscriptionsCallback,
+                              &UA_TYPES[UA_TYPES_TRANSFERSUBSCRIPTIONSRESPONSE],
+                              req, NULL);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_TransferSubscriptionsRequest_delete(req);
+        __Client_Subscriptions_clearHeld(client);
+    }
 }
 
 void
@@ -1386,7 +2048,7 @@ __Client_Subscriptions_backgroundPublish(UA_Client *client) {
     if(!LIST_FIRST(&client->subscriptions))
         return;
 
-    while(client->currentlyOutStandingPublishRequests < client->config.outStandingPublishRequests) {
+    while(client->currentlyOutStandingPublishRequests < publishRequestsLimit(client)) {
         UA_PublishRequest *request = UA_PublishRequest_new();
         if(!request)
             return;
@@ -172,6 +172,43 @@ typedef struct {
 void
 UA_PubSubComponentHead_clear(UA_PubSubComponentHead *psch);
 
+/* Cycle statistics of a WriterGroup or ReaderGroup. The time spent in the
+ * security and transfer stages is accumulated during the cycle. The encoding
+ * stage is the remainder of the total cycle time. */
+typedef struct {
+    UA_UInt64 cycleCount;
+    UA_UInt64 overrunCount;
+    UA_UInt64 missedCycleCount;
+    UA_DateTime lastCycle;    /* Start of the last cycle (monotonic). Reset
+                               * to zero when the group is restarted. */
+    UA_DateTime lastInterval; /* Time between the last two cycles */
+    UA_DateTime securityTime; /* Accumulated in the current cycle */
+    UA_DateTime transferTime;
+    u64 min[UA_PUBSUBSTAGES];
+    UA_LatencyHistogram stages[UA_PUBSUBSTAGES];
+    size_t historyPos;
+    size_t historySize;
+    UA_DateTime history[UA_PUBSUB_CYCLEHISTORY];
+} UA_PubSubCycleStats;
+
+/* Record a cycle from start to end. The interval is the PublishingInterval
+ * of WriterGroups and zero for ReaderGroups. Returns true if the cycle
+ * started late (overrun). */
+UA_Boolean
+UA_PubSubCycleStats_record(UA_PubSubCycleStats *cs, UA_DateTime start,
+                           UA_DateTime end, UA_DateTime interval);
+
+/* Drop the stage times accumulated for a cycle that is not recorded */
+static UA_INLINE void
+UA_PubSubCycleStats_discard(UA_PubSubCycleStats *cs) {
+    cs->securityTime = 0;
+    cs->transferTime = 0;
+}
+
+void
+UA_PubSubCycleStats_get(const UA_PubSubCycleStats *cs,
+                        UA_PubSubCycleStatistics *stats);
+
 /**********************************************/
 /*            PublishedDataSet                */
 /**********************************************/
@@ -233,6 +270,10 @@ UA_SubscribedDataSet_remove(UA_PubSubManager *psm, UA_SubscribedDataSet *sds);
 /*               Connection                   */
 /**********************************************/
 
+/* Maximum number of NetworkMessages collected on the shared send channel of a
+ * PubSubConnection before they are sent out */
+#define UA_PUBSUBCONNECTION_SENDBATCH 64
+
 typedef struct UA_PubSubConnection {
     UA_PubSubComponentHead head;
     TAILQ_ENTRY(UA_PubSubConnection) listEntry;
@@ -254,6 +295,15 @@ typedef struct UA_PubSubConnection {
     size_t recvChannelsSize;
     uintptr_t sendChannel;
 
+    /* The NetworkMessages of all WriterGroups that are sent over the shared
+     * sendChannel during one EventLoop iteration are collected. They are sent
+     * out together from a delayed callback (with sendWithConnectionV). The
+     * order of the messages is retained. */
+    size_t sendBuffersSize;
+    UA_ByteString sendBuffers[UA_PUBSUBCONNECTION_SENDBATCH];
+    UA_DelayedCallback sendDc;
+    UA_Boolean sendDcPending;
+
     size_t writerGroupsSize;
     LIST_HEAD(, UA_WriterGroup) writerGroups;
 
@@ -287,10 +337,29 @@ UA_PubSubConnection_delete(UA_PubSubManager *psm, UA_PubSubConnection *c);
 UA_EventLoop *
 UA_PubSubConnection_getEL(UA_PubSubManager *psm, UA_PubSubConnection *c);
 
+/* Forward implementation-specific options (e.g. for txtime sending) from the
+ * connectionProperties to the parameters for opening a connection. The kvm
+ * array needs space for keysSize additional entries. */
+void
+UA_PubSubConnection_forwardProperties(const UA_PubSubConnection *c,
+                                      UA_KeyValueMap *kvm,
+                                      const char * const *keys, size_t keysSize);
+
 UA_StatusCode
 UA_PubSubConnection_setPubSubState(UA_PubSubManager *psm, UA_PubSubConnection *c,
                                    UA_PubSubState targetState);
 
+/* Queue a NetworkMessage for the shared sendChannel. Takes ownership of the
+ * buffer. Returns BadNotSupported if the ConnectionManager cannot send
+ * several buffers at once. The buffer is not consumed in that case. */
+UA_StatusCode
+UA_PubSubConnection_queueSend(UA_PubSubManager *psm, UA_PubSubConnection *c,
+                              UA_ByteString *buf);
+
+/* Send out the queued NetworkMessages right away */
+void
+UA_PubSubConnection_flushSend(UA_PubSubManager *psm, UA_PubSubConnection *c);
+
 /* Also used by the ReaderGroup ... */
 UA_StatusCode
 UA_PubSubConnection_decodeNetworkMessage(UA_PubSubManager *psm,
@@ -302,11 +371,6 @@ UA_PubSubConnection_decodeNetworkMessage(UA_PubSubManager *psm,
 /*              DataSetWriter                 */
 /**********************************************/
 
-typedef struct UA_DataSetWriterSample {
-    UA_Boolean valueChanged;
-    UA_DataValue value;
-} UA_DataSetWriterSample;
-
 typedef struct UA_DataSetWriter {
     UA_PubSubComponentHead head;
     LIST_ENTRY(UA_DataSetWriter) listEntry;
@@ -316,10 +380,18 @@ typedef struct UA_DataSetWriter {
     UA_PublishedDataSet *connectedDataSet;
     UA_ConfigurationVersionDataType connectedDataSetVersion;
 
-    /* Deltaframes */
-    UA_UInt16 deltaFrameCounter; /* count of sent deltaFrames */
+    /* Deltaframes. The last sent value of every field is retained. The bitset
+     * marks the fields that changed during the last sampling. It is walked
+     * word-by-word to collect the changed field indices for the DeltaFrame. */
+    UA_UInt16 deltaFrameCounter; /* messages sent since the last KeyFrame */
     size_t lastSamplesCount;
-    UA_DataSetWriterSample *lastSamples;
+    UA_DataValue *lastSamples;
+    UA_UInt32 *changedFields; /* bitset with one bit per field */
+
+    /* Escaped JSON keys of the fields. Prepared when the configuration is
+     * frozen in a WriterGroup with JSON encoding. */
+    size_t jsonFieldKeysSize;
+    UA_String *jsonFieldKeys;
 
     UA_UInt16 actualDataSetMessageSequenceCount;
     UA_Boolean configurationFrozen;
@@ -359,6 +431,9 @@ UA_DataSetWriter_remove(UA_PubSubManager *psm, UA_DataSetWriter *dsw);
 /*               WriterGroup                  */
 /**********************************************/
 
+/* Maximum number of NetworkMessages that are sent with a single call */
+#define UA_WRITERGROUP_SENDBATCH 16
+
 struct UA_WriterGroup {
     UA_PubSubComponentHead head;
     LIST_ENTRY(UA_WriterGroup) listEntry;
@@ -371,8 +446,16 @@ struct UA_WriterGroup {
     UA_UInt64 publishCallbackId; /* registered if != 0 */
     UA_NetworkMessageOffsetBuffer bufferedMessage;
     UA_UInt16 sequenceNumber; /* Increased after every sent message */
+
+    /* JSON NetworkMessage members before the DataSetMessages. Prepared when
+     * the configuration is frozen. The size of the last JSON message is used
+     * to allocate the next one without computing the size first. */
+    UA_String jsonHeader;
+    size_t jsonSizeHint;
+
     UA_Boolean configurationFrozen;
     UA_DateTime lastPublishTimeStamp;
+    UA_PubSubCycleStats cycleStats;
 
     /* The ConnectionManager pointer is stored in the Connection. The channels
      * are either stored here or in the Connection, but never both. */
@@ -380,9 +463,25 @@ struct UA_WriterGroup {
     uintptr_t sendChannel;
     UA_Boolean deleteFlag;
 
+    /* The NetworkMessages of a publish cycle are collected and sent out
+     * together if the ConnectionManager supports sendWithConnectionV */
+    UA_Boolean batchSend;
+    uintptr_t sendBuffersChannel;
+    size_t sendBuffersSize;
+    UA_ByteString sendBuffers[UA_WRITERGROUP_SENDBATCH];
+
+    /* Transmit time of the NetworkMessages in the current publish cycle. Set
+     * if a transmitTimeOffset is configured (0: send right away). */
+    UA_DateTime txtime;
+
     UA_UInt32 securityTokenId;
     UA_UInt32 nonceSequenceNumber; /* To be part of the MessageNonce */
     void *securityPolicyContext;
+
+    /* Context prepared with the key of the next SecurityTokenId. Swapped with
+     * the current context at the key rollover. */
+    UA_UInt32 nextSecurityTokenId;
+    void *nextSecurityPolicyContext;
 #ifdef UA_ENABLE_PUBSUB_SKS
     UA_PubSubKeyStorage *keyStorage; /* non-owning pointer to keyStorage*/
 #endif
@@ -410,6 +509,14 @@ UA_WriterGroup_setEncryptionKeys(UA_PubSubManager *psm, UA_WriterGroup *wg,
                                  const UA_ByteString encryptingKey,
                                  const UA_ByteString keyNonce);
 
+/* Prepare the context for the next key. The current key remains in use. */
+UA_StatusCode
+UA_WriterGroup_setNextEncryptionKeys(UA_PubSubManager *psm, UA_WriterGroup *wg,
+                                     UA_UInt32 securityTokenId,
+                                     const UA_ByteString signingKey,
+                                     const UA_ByteString encryptingKey,
+                                     const UA_ByteString keyNonce);
+
 UA_StatusCode
 UA_WriterGroupConfig_copy(const UA_WriterGroupConfig *src,
                           UA_WriterGroupConfig *dst);
@@ -424,6 +531,13 @@ UA_WriterGroup_setPubSubState(UA_PubSubManager *psm, UA_WriterGroup *wg,
 void
 UA_WriterGroup_publishCallback(UA_PubSubManager *psm, UA_WriterGroup *wg);
 
+/* Re-encode the DataSetMessage of the DataSetWriter in the offset table of a
+ * frozen RT WriterGroup. The other DataSetMessages are not touched. The new
+ * offset table is swapped in only after it was fully prepared. */
+UA_StatusCode
+UA_WriterGroup_updateDataSetWriterOffsets(UA_PubSubManager *psm, UA_WriterGroup *wg,
+                                          UA_DataSetWriter *dsw);
+
 /**********************************************/
 /*               DataSetField                 */
 /**********************************************/
@@ -458,10 +572,24 @@ UA_PubSubDataSetField_sampleValue(UA_PubSubManager *psm,
                                   UA_DataSetField *field,
                                   UA_DataValue *value);
 
+UA_DataValue **
+UA_PubSubDataSetField_getRTValueSource(UA_PubSubManager *psm,
+                                       UA_DataSetField *field);
+
 /**********************************************/
 /*               DataSetReader                */
 /**********************************************/
 
+/* Entry of the offset table to decode a field of a frozen RT message directly
+ * into the external value of the target variable */
+typedef struct {
+    UA_FieldTargetVariable *tv;
+    const UA_DataType *type;
+    size_t offset;     /* Position of the encoded value in the message */
+    size_t prefixSize; /* DataValue/Variant encoding bytes before the value */
+    UA_Byte prefix[2]; /* Expected encoding bytes */
+} UA_DataSetReaderDirectField;
+
 struct UA_DataSetReader {
     UA_PubSubComponentHead head;
     LIST_ENTRY(UA_DataSetReader) listEntry;
@@ -471,8 +599,20 @@ struct UA_DataSetReader {
 
     UA_NetworkMessageOffsetBuffer bufferedMessage;
 
+    /* Offset table prepared together with the bufferedMessage if all fields
+     * have a fixed size and are written to an external value. Then the field
+     * values are copied from the received message without decoding. */
+    UA_DataSetReaderDirectField *directFields;
+    size_t directFieldsSize;
+    size_t directHeaderOffset; /* Position of the DataSetMessage header */
+    size_t directMessageSize;
+
     /* MessageReceiveTimeout handling */
     UA_UInt64 msgRcvTimeoutTimerId;
+
+    /* Entry in the reader index of the ReaderGroup */
+    UA_DataSetReader *indexNext;
+    UA_UInt32 indexHash;
 };
 
 UA_DataSetReader *
@@ -497,6 +637,10 @@ UA_StatusCode
 UA_DataSetReader_prepareOffsetBuffer(Ctx *ctx, UA_DataSetReader *reader,
                                      UA_ByteString *buf);
 
+/* Clear the bufferedMessage and the offset table for direct decoding */
+void
+UA_DataSetReader_clearOffsetBuffer(UA_DataSetReader *dsr);
+
 void
 UA_DataSetReader_decodeAndProcessRT(UA_PubSubManager *psm, UA_DataSetReader *dsr,
                                     UA_ByteString buf);
@@ -541,6 +685,14 @@ struct UA_ReaderGroup {
 
     UA_Boolean configurationFrozen;
     UA_Boolean hasReceived; /* Received a message since the last _connect */
+    UA_PubSubCycleStats cycleStats;
+
+    /* Hash index of the readers by (PublisherId, WriterGroupId,
+     * DataSetWriterId). Built when the configuration is frozen. The number of
+     * buckets is a power of two. */
+    UA_DataSetReader **readerIndex;
+    size_t readerIndexSize;
+    size_t readerIndexCount;
 
     /* The ConnectionManager pointer is stored in the Connection. The channels 
      * are either stored here or in the Connection, but never both. */
@@ -552,6 +704,11 @@ struct UA_ReaderGroup {
     UA_UInt32 securityTokenId;
     UA_UInt32 nonceSequenceNumber; /* To be part of the MessageNonce */
     void *securityPolicyContext;
+
+    /* Context prepared with the key of the next SecurityTokenId. Messages
+     * from publishers that already rolled over are decrypted with it. */
+    UA_UInt32 nextSecurityTokenId;
+    void *nextSecurityPolicyContext;
 #ifdef UA_ENABLE_PUBSUB_SKS
     UA_PubSubKeyStorage *keyStorage;
 #endif
@@ -582,6 +739,14 @@ UA_ReaderGroup_setEncryptionKeys(UA_PubSubManager *psm, UA_ReaderGroup *rg,
                                  const UA_ByteString encryptingKey,
                                  const UA_ByteString keyNonce);
 
+/* Prepare the context for the next key. The current key remains in use. */
+UA_StatusCode
+UA_ReaderGroup_setNextEncryptionKeys(UA_PubSubManager *psm, UA_ReaderGroup *rg,
+                                     UA_UInt32 securityTokenId,
+                                     const UA_ByteString signingKey,
+                                     const UA_ByteString encryptingKey,
+                                     const UA_ByteString keyNonce);
+
 UA_StatusCode
 UA_ReaderGroupConfig_copy(const UA_ReaderGroupConfig *src,
                           UA_ReaderGroupConfig *dst);
@@ -601,6 +766,18 @@ UA_Boolean
 UA_ReaderGroup_process(UA_PubSubManager *psm, UA_ReaderGroup *rg,
                        UA_NetworkMessage *nm);
 
+/* Add/remove the reader to the index of a frozen ReaderGroup */
+void
+UA_ReaderGroup_indexReader(UA_ReaderGroup *rg, UA_DataSetReader *dsr);
+
+void
+UA_ReaderGroup_unindexReader(UA_ReaderGroup *rg, UA_DataSetReader *dsr);
+
+/* Is the NetworkMessage intended for one of the readers (in any state)? */
+UA_Boolean
+UA_ReaderGroup_hasMatchingReader(UA_PubSubManager *psm, UA_ReaderGroup *rg,
+                                 UA_NetworkMessage *nm);
+
 /* The buffer is the entire message. The ctx->pos points after the decoded
  * header. The ctx->end is modified to remove padding, etc. */
 UA_StatusCode
@@ -681,6 +858,10 @@ struct UA_PubSubManager {
     size_t reserveIdsSize;
     UA_ReserveIdTree reserveIds;
 
+    /* Statistics of the WriterGroup publish cycles */
+    size_t publishCycleCount;
+    size_t publishCycleOverrunCount;
+
 #ifdef UA_ENABLE_PUBSUB_SKS
     LIST_HEAD(, UA_PubSubKeyStorage) pubSubKeyList;
 
@@ -690,6 +871,10 @@ struct UA_PubSubManager {
 
 #ifndef UA_ENABLE_PUBSUB_INFORMATIONMODEL
     UA_UInt32 uniqueIdCount;
+#else
+    /* Creating the representation browses the new nodes internally. Only the
+     * explicitly browsed level is materialized. */
+    UA_Boolean materializing;
 #endif
 };
 
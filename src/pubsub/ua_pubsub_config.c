@@ -11,22 +11,33 @@
 #if defined(UA_ENABLE_PUBSUB) && defined(UA_ENABLE_PUBSUB_FILE_CONFIG)
 #include "../pubsub/ua_pubsub.h"
 
+/* The PublishedDataSets of the loaded configuration sorted by name. The
+ * DataSetWriters reference their PublishedDataSet by name. */
+typedef struct {
+    const UA_String *name;
+    size_t pos; /* Position in the configuration. The first match wins. */
+    UA_NodeId ident;
+} PdsIndexEntry;
+
+typedef struct {
+    size_t size;
+    PdsIndexEntry *entries;
+} PdsIndex;
+
 static UA_StatusCode
 createPubSubConnection(UA_PubSubManager *psm,
                        const UA_PubSubConnectionDataType *connection,
-                       UA_UInt32 pdsCount, UA_NodeId *pdsIdent);
+                       const PdsIndex *pdsIndex);
 
 static UA_StatusCode
 createWriterGroup(UA_PubSubManager *psm,
                   const UA_WriterGroupDataType *writerGroupParameters,
-                  UA_NodeId connectionIdent, UA_UInt32 pdsCount,
-                  const UA_NodeId *pdsIdent);
+                  UA_NodeId connectionIdent, const PdsIndex *pdsIndex);
 
 static UA_StatusCode
 createDataSetWriter(UA_PubSubManager *psm,
                     const UA_DataSetWriterDataType *dataSetWriterParameters,
-                    UA_NodeId writerGroupIdent, UA_UInt32 pdsCount,
-                    const UA_NodeId *pdsIdent);
+                    UA_NodeId writerGroupIdent, const PdsIndex *pdsIndex);
 
 static UA_StatusCode
 createReaderGroup(UA_PubSubManager *psm,
@@ -85,6 +96,33 @@ extractPubSubConfigFromExtensionObject(UA_PubSubManager *psm,
     return UA_STATUSCODE_GOOD;
 }
 
+static int
+cmpPdsIndexEntry(const void *a, const void *b) {
+    const PdsIndexEntry *ea = (const PdsIndexEntry*)a;
+    const PdsIndexEntry *eb = (const PdsIndexEntry*)b;
+    UA_Order o = UA_order(ea->name, eb->name, &UA_TYPES[UA_TYPES_STRING]);
+    if(o != UA_ORDER_EQ)
+        return (int)o;
+    return (ea->pos < eb->pos) ? -1 : (ea->pos > eb->pos) ? 1 : 0;
+}
+
+/* Binary search for the first entry with the name */
+static const UA_NodeId *
+PdsIndex_find(const PdsIndex *pdsIndex, const UA_String *name) {
+    size_t lo = 0, hi = pdsIndex->size;
+    while(lo < hi) {
+        size_t mid = lo + ((hi - lo) / 2);
+        if(UA_order(pdsIndex->entries[mid].name, name,
+                    &UA_TYPES[UA_TYPES_STRING]) == UA_ORDER_LESS)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if(lo == pdsIndex->size || !UA_String_equal(pdsIndex->entries[lo].name, name))
+        return NULL;
+    return &pdsIndex->entries[lo].ident;
+}
+
 /* Configures with given PubSubConfigurationDataType object */
 static UA_StatusCode
 updatePubSubConfig(UA_PubSubManager *psm,
@@ -100,43 +138,51 @@ updatePubSubConfig(UA_PubSubManager *psm,
     UA_PubSubManager_clear(psm);
 
     /* Configuration of Published DataSets: */
-    UA_UInt32 pdsCount = (UA_UInt32)configurationParameters->publishedDataSetsSize;
-    UA_NodeId *publishedDataSetIdent = (UA_NodeId*)UA_calloc(pdsCount, sizeof(UA_NodeId));
-    if(!publishedDataSetIdent)
+    PdsIndex pdsIndex;
+    pdsIndex.size = configurationParameters->publishedDataSetsSize;
+    pdsIndex.entries = (PdsIndexEntry*)UA_calloc(pdsIndex.size, sizeof(PdsIndexEntry));
+    if(!pdsIndex.entries && pdsIndex.size > 0)
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
     UA_StatusCode res = UA_STATUSCODE_GOOD;
 
-    for(UA_UInt32 i = 0; i < pdsCount; i++) {
+    for(size_t i = 0; i < pdsIndex.size; i++) {
         res = createPublishedDataSet(psm,
                                      &configurationParameters->publishedDataSets[i],
-                                     &publishedDataSetIdent[i]);
+                                     &pdsIndex.entries[i].ident);
         if(res != UA_STATUSCODE_GOOD) {
             UA_LOG_ERROR(psm->logging, UA_LOGCATEGORY_PUBSUB,
                          "[UA_PubSubManager_updatePubSubConfig] PDS creation failed");
-            UA_free(publishedDataSetIdent);
+            UA_free(pdsIndex.entries);
             return res;
         }
+        pdsIndex.entries[i].name = &configurationParameters->publishedDataSets[i].name;
+        pdsIndex.entries[i].pos = i;
     }
 
+    /* Sort by name for the lookup from the DataSetWriters. Otherwise loading
+     * large configurations is quadratic in the number of PublishedDataSets. */
+    if(pdsIndex.size > 1)
+        qsort(pdsIndex.entries, pdsIndex.size, sizeof(PdsIndexEntry), cmpPdsIndexEntry);
+
     /* Configuration of PubSub Connections: */
     if(configurationParameters->connectionsSize < 1) {
         UA_LOG_WARNING(psm->logging, UA_LOGCATEGORY_PUBSUB,
                        "[UA_PubSubManager_updatePubSubConfig] no connection in "
                        "UA_PubSubConfigurationDataType");
-        UA_free(publishedDataSetIdent);
+        UA_free(pdsIndex.entries);
         return UA_STATUSCODE_GOOD;
     }
 
     for(size_t i = 0; i < configurationParameters->connectionsSize; i++) {
         res = createPubSubConnection(psm,
                                      &configurationParameters->connections[i],
-                                     pdsCount, publishedDataSetIdent);
+                                     &pdsIndex);
         if(res != UA_STATUSCODE_GOOD)
             break;
     }
 
-    UA_free(publishedDataSetIdent);
+    UA_free(pdsIndex.entries);
 
     return res;
 }
@@ -146,15 +192,14 @@ updatePubSubConfig(UA_PubSubManager *psm,
 static UA_StatusCode
 createComponentsForConnection(UA_PubSubManager *psm,
                               const UA_PubSubConnectionDataType *connParams,
-                              UA_NodeId connectionIdent, UA_UInt32 pdsCount,
-                              const UA_NodeId *pdsIdent) {
+                              UA_NodeId connectionIdent, const PdsIndex *pdsIndex) {
     UA_LOCK_ASSERT(&psm->sc.server->serviceMutex);
 
     /* WriterGroups configuration */
     UA_StatusCode res = UA_STATUSCODE_GOOD;
     for(size_t i = 0; i < connParams->writerGroupsSize; i++) {
         res = createWriterGroup(psm, &connParams->writerGroups[i],
-                                connectionIdent, pdsCount, pdsIdent);
+                                connectionIdent, pdsIndex);
         if(res != UA_STATUSCODE_GOOD) {
             UA_LOG_ERROR(psm->logging, UA_LOGCATEGORY_PUBSUB,
                          "[UA_PubSubManager_createComponentsForConnection] "
@@ -181,11 +226,10 @@ createComponentsForConnection(UA_PubSubManager *psm,
  *
  * @param psm PubSubManager that shall be configured
  * @param connParams PubSub connection configuration
- * @param pdsCount Number of published DataSets
- * @param pdsIdent Array of NodeIds of the published DataSets */
+ * @param pdsIndex Index of the published DataSets */
 static UA_StatusCode
 createPubSubConnection(UA_PubSubManager *psm, const UA_PubSubConnectionDataType *connParams,
-                       UA_UInt32 pdsCount, UA_NodeId *pdsIdent) {
+                       const PdsIndex *pdsIndex) {
     UA_LOCK_ASSERT(&psm->sc.server->serviceMutex);
 
     UA_PubSubConnectionConfig config;
@@ -233,7 +277,7 @@ createPubSubConnection(UA_PubSubManager *psm, const UA_PubSubConnectionDataType
     if(res == UA_STATUSCODE_GOOD) {
         /* Configuration of all Components that belong to this connection: */
         res = createComponentsForConnection(psm, connParams, connectionIdent,
-                                            pdsCount, pdsIdent);
+                                            pdsIndex);
     } else {
         UA_LOG_ERROR(psm->logging, UA_LOGCATEGORY_PUBSUB,
                      "[UA_PubSubManager_createPubSubConnection] "
@@ -287,13 +331,11 @@ setWriterGroupEncodingType(UA_PubSubManager *psm,
  * @param psm PubSubManager that shall be configured
  * @param writerGroupParameters WriterGroup configuration
  * @param connectionIdent NodeId of the PubSub connection, the WriterGroup belongs to
- * @param pdsCount Number of published DataSets
- * @param pdsIdent Array of NodeIds of the published DataSets */
+ * @param pdsIndex Index of the published DataSets */
 static UA_StatusCode
 createWriterGroup(UA_PubSubManager *psm,
                   const UA_WriterGroupDataType *writerGroupParameters,
-                  UA_NodeId connectionIdent, UA_UInt32 pdsCount,
-                  const UA_NodeId *pdsIdent) {
+                  UA_NodeId connectionIdent, const PdsIndex *pdsIndex) {
     UA_LOCK_ASSERT(&psm->sc.server->serviceMutex);
 
     UA_WriterGroupConfig config;
@@ -331,7 +373,7 @@ createWriterGroup(UA_PubSubManager *psm,
     /* Configuration of all DataSetWriters that belong to this WriterGroup */
     for(size_t dsw = 0; dsw < writerGroupParameters->dataSetWritersSize; dsw++) {
         res = createDataSetWriter(psm, &writerGroupParameters->dataSetWriters[dsw],
-                                  writerGroupIdent, pdsCount, pdsIdent);
+                                  writerGroupIdent, pdsIndex);
         if(res != UA_STATUSCODE_GOOD) {
             UA_LOG_ERROR(psm->logging, UA_LOGCATEGORY_PUBSUB,
                          "[UA_PubSubManager_createWriterGroup] "
@@ -356,63 +398,36 @@ createWriterGroup(UA_PubSubManager *psm,
  * @param psm PubSubManager that shall be configured
  * @param writerGroupIdent NodeId of writerGroup, the DataSetWriter belongs to
  * @param dsWriterConfig WriterGroup configuration
- * @param pdsCount Number of published DataSets
- * @param pdsIdent Array of NodeIds of the published DataSets */
+ * @param pdsIndex Index of the published DataSets */
 static UA_StatusCode
 addDataSetWriterWithPdsReference(UA_PubSubManager *psm, UA_NodeId writerGroupIdent,
                                  const UA_DataSetWriterConfig *dsWriterConfig,
-                                 UA_UInt32 pdsCount, const UA_NodeId *pdsIdent,
-                                 UA_Boolean enable) {
+                                 const PdsIndex *pdsIndex, UA_Boolean enable) {
     UA_LOCK_ASSERT(&psm->sc.server->serviceMutex);
 
-    UA_NodeId dataSetWriterIdent;
-    UA_PublishedDataSetConfig pdsConfig;
-    UA_Boolean pdsFound = false;
-
-    UA_StatusCode res = UA_STATUSCODE_GOOD;
-    for(size_t pds = 0; pds < pdsCount && res == UA_STATUSCODE_GOOD; pds++) {
-        UA_PublishedDataSet *ds = UA_PublishedDataSet_find(psm, pdsIdent[pds]);
-        res = (ds) ?
-            UA_PublishedDataSetConfig_copy(&ds->config, &pdsConfig) : UA_STATUSCODE_BADNOTFOUND;
-        /* members of pdsConfig must be deleted manually */
-        if(res != UA_STATUSCODE_GOOD) {
-            UA_LOG_ERROR(psm->logging, UA_LOGCATEGORY_PUBSUB,
-                         "[UA_PubSubManager_addDataSetWriterWithPdsReference] "
-                         "Getting pdsConfig from NodeId failed.");
-            return res;
-        }
-
-        if(dsWriterConfig->dataSetName.length == pdsConfig.name.length &&
-           0 == strncmp((const char *)dsWriterConfig->dataSetName.data,
-                        (const char *)pdsConfig.name.data,
-                        dsWriterConfig->dataSetName.length)) {
-            /* DSWriter will only be created, if a matching PDS is found: */
-            res = UA_DataSetWriter_create(psm, writerGroupIdent, pdsIdent[pds],
-                                          dsWriterConfig, &dataSetWriterIdent);
-            if(res != UA_STATUSCODE_GOOD) {
-                UA_LOG_ERROR(psm->logging, UA_LOGCATEGORY_PUBSUB,
-                             "[UA_PubSubManager_addDataSetWriterWithPdsReference] "
-                             "Adding DataSetWriter failed");
-            } else {
-                pdsFound = true;
-                UA_DataSetWriter *dsw = UA_DataSetWriter_find(psm, dataSetWriterIdent);
-                if(enable && dsw)
-                    UA_DataSetWriter_setPubSubState(psm, dsw, UA_PUBSUBSTATE_OPERATIONAL);
-            }
-
-            UA_PublishedDataSetConfig_clear(&pdsConfig);
-            if(pdsFound)
-                break; /* break loop if corresponding publishedDataSet was found */
-        }
+    /* DSWriter will only be created, if a matching PDS is found */
+    const UA_NodeId *pdsIdent = PdsIndex_find(pdsIndex, &dsWriterConfig->dataSetName);
+    if(!pdsIdent) {
+        UA_LOG_ERROR(psm->logging, UA_LOGCATEGORY_PUBSUB,
+                     "[UA_PubSubManager_addDataSetWriterWithPdsReference] "
+                     "No matching DataSet found; no DataSetWriter created");
+        return UA_STATUSCODE_GOOD;
     }
 
-    if(!pdsFound) {
+    UA_NodeId dataSetWriterIdent;
+    UA_StatusCode res = UA_DataSetWriter_create(psm, writerGroupIdent, *pdsIdent,
+                                                dsWriterConfig, &dataSetWriterIdent);
+    if(res != UA_STATUSCODE_GOOD) {
         UA_LOG_ERROR(psm->logging, UA_LOGCATEGORY_PUBSUB,
                      "[UA_PubSubManager_addDataSetWriterWithPdsReference] "
-                     "No matching DataSet found; no DataSetWriter created");
+                     "Adding DataSetWriter failed");
+        return res;
     }
 
-    return res;
+    UA_DataSetWriter *dsw = UA_DataSetWriter_find(psm, dataSetWriterIdent);
+    if(enable && dsw)
+        UA_DataSetWriter_setPubSubState(psm, dsw, UA_PUBSUBSTATE_OPERATIONAL);
+    return UA_STATUSCODE_GOOD;
 }
 
 /* Creates DataSetWriter configuration from DataSetWriter object
@@ -420,13 +435,11 @@ addDataSetWriterWithPdsReference(UA_PubSubManager *psm, UA_NodeId writerGroupIde
  * @param psm PubSubManager that shall be configured
  * @param dataSetWriterParameters DataSetWriter Configuration
  * @param writerGroupIdent NodeId of writerGroup, the DataSetWriter belongs to
- * @param pdsCount Number of published DataSets
- * @param pdsIdent Array of NodeIds of the published DataSets */
+ * @param pdsIndex Index of the published DataSets */
 static UA_StatusCode
 createDataSetWriter(UA_PubSubManager *psm,
                     const UA_DataSetWriterDataType *dataSetWriterParameters,
-                    UA_NodeId writerGroupIdent, UA_UInt32 pdsCount,
-                    const UA_NodeId *pdsIdent) {
+                    UA_NodeId writerGroupIdent, const PdsIndex *pdsIndex) {
     UA_LOCK_ASSERT(&psm->sc.server->serviceMutex);
 
     UA_DataSetWriterConfig config;
@@ -441,7 +454,7 @@ createDataSetWriter(UA_PubSubManager *psm,
     config.dataSetWriterProperties.map = dataSetWriterParameters->dataSetWriterProperties;
 
     UA_StatusCode res = addDataSetWriterWithPdsReference(psm, writerGroupIdent, &config,
-                                                         pdsCount, pdsIdent,
+                                                         pdsIndex,
                                                          dataSetWriterParameters->enabled);
     if(res != UA_STATUSCODE_GOOD) {
         UA_LOG_ERROR(psm->logging, UA_LOGCATEGORY_PUBSUB,
@@ -899,7 +912,11 @@ generateDataSetWriterDataType(const UA_DataSetWriter *src,
     dst->keyFrameCount = src->config.keyFrameCount;
     dst->dataSetFieldContentMask = src->config.dataSetFieldContentMask;
     res |= UA_ExtensionObject_copy(&src->config.messageSettings, &dst->messageSettings);
-    res |= UA_String_copy(&src->config.dataSetName, &dst->dataSetName);
+    /* The DataSetWriter is loaded with the PublishedDataSet of that name */
+    const UA_String *dataSetName = &src->config.dataSetName;
+    if(UA_String_isEmpty(dataSetName) && src->connectedDataSet)
+        dataSetName = &src->connectedDataSet->config.name;
+    res |= UA_String_copy(dataSetName, &dst->dataSetName);
     if(res != UA_STATUSCODE_GOOD) {
         UA_DataSetWriterDataType_clear(dst);
         return res;
@@ -43,6 +43,7 @@ UA_PubSubConnection_decodeNetworkMessage(UA_PubSubManager *psm,
     ctx.pos = buffer.data;
     ctx.end = buffer.data + buffer.length;
     ctx.depth = 0;
+    ctx.segments = NULL;
     memset(&ctx.opts, 0, sizeof(UA_DecodeBinaryOptions));
     ctx.opts.customTypes = psm->sc.server->config.customDataTypes;
 
@@ -60,24 +61,22 @@ UA_PubSubConnection_decodeNetworkMessage(UA_PubSubManager *psm,
     UA_Boolean processed = false;
     UA_ReaderGroup *rg;
     LIST_FOREACH(rg, &connection->readerGroups, listEntry) {
-        UA_DataSetReader *reader;
-        LIST_FOREACH(reader, &rg->readers, listEntry) {
-            UA_StatusCode res = UA_DataSetReader_checkIdentifier(psm, reader, nm);
-            if(res != UA_STATUSCODE_GOOD)
-                continue;
-            processed = true;
-            rv = verifyAndDecryptNetworkMessage(psm->logging, buffer, &ctx, nm, rg);
-            if(rv != UA_STATUSCODE_GOOD) {
-                UA_NetworkMessage_clear(nm);
-                return rv;
-            }
-
-            /* break out of all loops when first verify & decrypt was successful */
-            goto loops_exit;
+        if(!UA_ReaderGroup_hasMatchingReader(psm, rg, nm))
+            continue;
+        processed = true;
+        UA_EventLoop *el = UA_PubSubConnection_getEL(psm, connection);
+        UA_DateTime begin = el->dateTime_nowMonotonic(el);
+        rv = verifyAndDecryptNetworkMessage(psm->logging, buffer, &ctx, nm, rg);
+        rg->cycleStats.securityTime += el->dateTime_nowMonotonic(el) - begin;
+        if(rv != UA_STATUSCODE_GOOD) {
+            UA_NetworkMessage_clear(nm);
+            return rv;
         }
+
+        /* Break out when the first verify & decrypt was successful */
+        break;
     }
 
-loops_exit:
     if(!processed) {
         UA_LOG_WARNING_PUBSUB(psm->logging, connection,
                               "Could not decode the received NetworkMessage "
@@ -295,7 +294,10 @@ UA_PubSubConnection_process(UA_PubSubManager *psm, UA_PubSubConnection *c,
     if(!nonRtRg)
         goto finish;
 
-    /* Decode the received message for the non-RT ReaderGroups */
+    /* Decode the received message for the non-RT ReaderGroups. The decoding
+     * is shared. But it is counted for the cycle of every ReaderGroup. */
+    UA_EventLoop *el = UA_PubSubConnection_getEL(psm, c);
+    UA_DateTime start = el->dateTime_nowMonotonic(el);
     UA_StatusCode res;
     UA_NetworkMessage nm;
     memset(&nm, 0, sizeof(UA_NetworkMessage));
@@ -315,17 +317,34 @@ UA_PubSubConnection_process(UA_PubSubManager *psm, UA_PubSubConnection *c,
 #endif
     }
 
-    if(res != UA_STATUSCODE_GOOD)
+    if(res != UA_STATUSCODE_GOOD) {
+        LIST_FOREACH(rg, &c->readerGroups, listEntry) {
+            if(rg->config.rtLevel != UA_PUBSUB_RT_FIXED_SIZE)
+                UA_PubSubCycleStats_discard(&rg->cycleStats);
+        }
         return;
+    }
 
-    /* Process the received message for the non-RT ReaderGroups */
+    /* Process the received message for the non-RT ReaderGroups. The
+     * processing time of the other ReaderGroups is not counted. */
+    UA_DateTime decoded = el->dateTime_nowMonotonic(el);
     LIST_FOREACH(rg, &c->readerGroups, listEntry) {
         if(rg->head.state != UA_PUBSUBSTATE_OPERATIONAL &&
            rg->head.state != UA_PUBSUBSTATE_PREOPERATIONAL)
             continue;
         if(rg->config.rtLevel == UA_PUBSUB_RT_FIXED_SIZE)
             continue;
-        processed |= UA_ReaderGroup_process(psm, rg, &nm);
+        UA_DateTime begin = el->dateTime_nowMonotonic(el);
+        UA_Boolean rgProcessed = UA_ReaderGroup_process(psm, rg, &nm);
+        UA_DateTime transfer = el->dateTime_nowMonotonic(el) - begin;
+        if(!rgProcessed) {
+            UA_PubSubCycleStats_discard(&rg->cycleStats);
+            continue;
+        }
+        rg->cycleStats.transferTime += transfer;
+        UA_PubSubCycleStats_record(&rg->cycleStats, start,
+                                   decoded + transfer, 0);
+        processed = true;
     }
     UA_NetworkMessage_clear(&nm);
 
@@ -357,6 +376,7 @@ UA_PubSubConnection_setPubSubState(UA_PubSubManager *psm, UA_PubSubConnection *c
         /* Disabled or Error */
         case UA_PUBSUBSTATE_ERROR:
         case UA_PUBSUBSTATE_DISABLED:
+            UA_PubSubConnection_flushSend(psm, c);
             UA_PubSubConnection_disconnect(c);
             c->head.state = targetState;
             break;
@@ -457,10 +477,104 @@ UA_PubSubConnection_getEL(UA_PubSubManager *psm, UA_PubSubConnection *c) {
     return psm->sc.server->config.eventLoop;
 }
 
+void
+UA_PubSubConnection_flushSend(UA_PubSubManager *psm, UA_PubSubConnection *c) {
+    UA_LOCK_ASSERT(&psm->sc.server->serviceMutex);
+    if(c->sendBuffersSize == 0)
+        return;
+    size_t count = c->sendBuffersSize;
+    c->sendBuffersSize = 0;
+    UA_StatusCode res = c->cm->
+        sendWithConnectionV(c->cm, c->sendChannel, &UA_KEYVALUEMAP_NULL,
+                            c->sendBuffers, count);
+    if(res == UA_STATUSCODE_GOOD)
+        return;
+
+    /* Failure, set the WriterGroups on the shared channel into an error mode */
+    UA_LOG_ERROR_PUBSUB(psm->logging, c, "Sending %u NetworkMessages failed "
+                        "with StatusCode %s", (unsigned)count,
+                        UA_StatusCode_name(res));
+    UA_WriterGroup *wg;
+    LIST_FOREACH(wg, &c->writerGroups, listEntry) {
+        if(wg->sendChannel == 0 && wg->head.state == UA_PUBSUBSTATE_OPERATIONAL)
+            UA_WriterGroup_setPubSubState(psm, wg, UA_PUBSUBSTATE_ERROR);
+    }
+    UA_PubSubConnection_setPubSubState(psm, c, UA_PUBSUBSTATE_ERROR);
+}
+
+static void
+delayedFlushSend(void *application, void *context) {
+    UA_PubSubManager *psm = (UA_PubSubManager*)application;
+    UA_PubSubConnection *c = (UA_PubSubConnection*)context;
+    UA_LOCK(&psm->sc.server->serviceMutex);
+    c->sendDcPending = false;
+    UA_PubSubConnection_flushSend(psm, c);
+    UA_UNLOCK(&psm->sc.server->serviceMutex);
+}
+
+UA_StatusCode
+UA_PubSubConnection_queueSend(UA_PubSubManager *psm, UA_PubSubConnection *c,
+                              UA_ByteString *buf) {
+    UA_LOCK_ASSERT(&psm->sc.server->serviceMutex);
+    if(!c->cm || !c->cm->sendWithConnectionV || c->sendChannel == 0)
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+
+    /* Send out a full batch */
+    if(c->sendBuffersSize == UA_PUBSUBCONNECTION_SENDBATCH)
+        UA_PubSubConnection_flushSend(psm, c);
+
+    /* Flush at the end of the current EventLoop iteration. The delayed
+     * callbacks are processed right after the cyclic callbacks. So all
+     * WriterGroups that are due in the same iteration are batched. */
+    if(!c->sendDcPending) {
+        UA_EventLoop *el = UA_PubSubConnection_getEL(psm, c);
+        c->sendDc.callback = delayedFlushSend;
+        c->sendDc.application = psm;
+        c->sendDc.context = c;
+        el->addDelayedCallback(el, &c->sendDc);
+        c->sendDcPending = true;
+    }
+
+    c->sendBuffers[c->sendBuffersSize++] = *buf;
+    UA_ByteString_init(buf);
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Free the queued NetworkMessages without sending */
+static void
+discardSend(UA_PubSubManager *psm, UA_PubSubConnection *c, uintptr_t channel) {
+    for(size_t i = 0; i < c->sendBuffersSize; i++)
+        c->cm->freeNetworkBuffer(c->cm, channel, &c->sendBuffers[i]);
+    c->sendBuffersSize = 0;
+    if(c->sendDcPending) {
+        UA_EventLoop *el = UA_PubSubConnection_getEL(psm, c);
+        el->removeDelayedCallback(el, &c->sendDc);
+        c->sendDc.callback = NULL;
+        c->sendDcPending = false;
+    }
+}
+
+void
+UA_PubSubConnection_forwardProperties(const UA_PubSubConnection *c,
+                                      UA_KeyValueMap *kvm,
+                                      const char * const *keys, size_t keysSize) {
+    for(size_t i = 0; i < keysSize; i++) {
+        UA_QualifiedName key = UA_QUALIFIEDNAME(0, (char*)(uintptr_t)keys[i]);
+        const UA_Variant *v = UA_KeyValueMap_get(&c->config.connectionProperties, key);
+        if(!v)
+            continue;
+        kvm->map[kvm->mapSize].key = key;
+        kvm->map[kvm->mapSize].value = *v;
+        kvm->mapSize++;
+    }
+}
+
 /***********************/
 /* Connection Handling */
 /***********************/
 
+static const char *txtimeProperties[2] = {"txtime-enable", "txtime-flags"};
+
 static UA_StatusCode
 UA_PubSubConnection_connectUDP(UA_PubSubManager *psm, UA_PubSubConnection *c,
                                UA_Boolean validate);
@@ -496,6 +610,7 @@ UA_PubSubConnection_detachConnection(UA_PubSubManager *psm,
     if(c->sendChannel == connectionId) {
         UA_LOG_INFO_PUBSUB(psm->logging, c, "Detach send-connection %S %u",
                            cm->protocol, (unsigned)connectionId);
+        discardSend(psm, c, connectionId);
         c->sendChannel = 0;
         return;
     }
@@ -621,8 +736,11 @@ PubSubChannelCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
     UA_PubSubConnection_setPubSubState(psm, psc, psc->head.state);
 
     /* Message received */
-    if(UA_LIKELY(recv && msg.length > 0))
+    if(UA_LIKELY(recv && msg.length > 0)) {
+        UA_MemoryCategory mc = UA_MemoryCategory_enter(UA_MEMORYCATEGORY_PUBSUB);
         UA_PubSubConnection_process(psm, psc, msg);
+        UA_MemoryCategory_leave(mc);
+    }
     
     UA_UNLOCK(&server->serviceMutex);
 }
@@ -681,7 +799,7 @@ UA_PubSubConnection_connectUDP(UA_PubSubManager *psm, UA_PubSubConnection *c,
     UA_Boolean listen = true;
     UA_Boolean reuse = true;
     UA_Boolean loopback = true;
-    UA_KeyValuePair kvp[7];
+    UA_KeyValuePair kvp[9];
     UA_KeyValueMap kvm = {5, kvp};
     kvp[0].key = UA_QUALIFIEDNAME(0, "port");
     UA_Variant_setScalar(&kvp[0].value, &port, &UA_TYPES[UA_TYPES_UINT16]);
@@ -707,6 +825,9 @@ UA_PubSubConnection_connectUDP(UA_PubSubManager *psm, UA_PubSubConnection *c,
         kvm.mapSize++;
     }
 
+    /* Forward the txtime configuration from the connection properties */
+    UA_PubSubConnection_forwardProperties(c, &kvm, txtimeProperties, 2);
+
     /* Open a recv connection */
     if(validate || (c->recvChannelsSize == 0 && c->readerGroupsSize > 0)) {
         UA_UNLOCK(&server->serviceMutex);
@@ -762,7 +883,7 @@ UA_PubSubConnection_connectETH(UA_PubSubManager *psm, UA_PubSubConnection *c,
     /* Set up the connection parameters.
      * TDOD: Complete the considered parameters. VID, PCP, etc. */
     UA_Boolean listen = true;
-    UA_KeyValuePair kvp[4];
+    UA_KeyValuePair kvp[9];
     UA_KeyValueMap kvm = {4, kvp};
     kvp[0].key = UA_QUALIFIEDNAME(0, "address");
     UA_Variant_setScalar(&kvp[0].value, &address, &UA_TYPES[UA_TYPES_STRING]);
@@ -774,6 +895,12 @@ UA_PubSubConnection_connectETH(UA_PubSubManager *psm, UA_PubSubConnection *c,
     kvp[3].key = UA_QUALIFIEDNAME(0, "validate");
     UA_Variant_setScalar(&kvp[3].value, &validate, &UA_TYPES[UA_TYPES_BOOLEAN]);
 
+    /* Forward the ring, polling and txtime configuration from the connection
+     * properties */
+    static const char *ethProperties[5] =
+        {"ring-frames", "qdisc-bypass", "busy-poll", "txtime-enable", "txtime-flags"};
+    UA_PubSubConnection_forwardProperties(c, &kvm, ethProperties, 5);
+
     /* Open recv channels */
     if(validate || (c->recvChannelsSize == 0 && c->readerGroupsSize > 0)) {
         UA_UNLOCK(&server->serviceMutex);
@@ -245,6 +245,62 @@ generateFieldMetaData(UA_PubSubManager *psm, UA_PublishedDataSet *pds,
     return UA_STATUSCODE_GOOD;
 }
 
+/* The DataSetFields of a PublishedDataSet in use can be changed if all frozen
+ * DataSetWriters are in WriterGroups with an offset table. Then only their
+ * DataSetMessages are re-encoded. */
+static UA_Boolean
+canUpdateInUse(UA_PubSubManager *psm, UA_PublishedDataSet *pds) {
+    UA_PubSubConnection *c;
+    TAILQ_FOREACH(c, &psm->connections, listEntry) {
+        UA_WriterGroup *wg;
+        LIST_FOREACH(wg, &c->writerGroups, listEntry) {
+            UA_DataSetWriter *dsw;
+            LIST_FOREACH(dsw, &wg->writers, listEntry) {
+                if(dsw->connectedDataSet != pds || !dsw->configurationFrozen)
+                    continue;
+                if(!wg->configurationFrozen || wg->bufferedMessage.offsetsSize == 0)
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
+/* Update the offset tables of the frozen WriterGroups that contain a
+ * DataSetMessage of the PublishedDataSet. Set the WriterGroup to the error
+ * state if the update fails and errorState is true. Otherwise the old offset
+ * table remains. */
+static UA_StatusCode
+updateInUse(UA_PubSubManager *psm, UA_PublishedDataSet *pds,
+            UA_Boolean errorState) {
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    UA_PubSubConnection *c;
+    TAILQ_FOREACH(c, &psm->connections, listEntry) {
+        UA_WriterGroup *wg;
+        LIST_FOREACH(wg, &c->writerGroups, listEntry) {
+            UA_DataSetWriter *dsw;
+            LIST_FOREACH(dsw, &wg->writers, listEntry) {
+                if(dsw->connectedDataSet != pds || !wg->configurationFrozen ||
+                   wg->bufferedMessage.offsetsSize == 0)
+                    continue;
+                UA_StatusCode res2 =
+                    UA_WriterGroup_updateDataSetWriterOffsets(psm, wg, dsw);
+                if(res2 != UA_STATUSCODE_GOOD) {
+                    UA_LOG_WARNING_PUBSUB(psm->logging, dsw, "Updating the offset "
+                                          "table failed with StatusCode %s",
+                                          UA_StatusCode_name(res2));
+                    res = res2;
+                    if(errorState) {
+                        UA_WriterGroup_setPubSubState(psm, wg, UA_PUBSUBSTATE_ERROR);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    return res;
+}
+
 UA_DataSetFieldResult
 UA_DataSetField_create(UA_PubSubManager *psm, const UA_NodeId publishedDataSet,
                        const UA_DataSetFieldConfig *fieldConfig,
@@ -264,7 +320,7 @@ UA_DataSetField_create(UA_PubSubManager *psm, const UA_NodeId publishedDataSet,
     }
 
     /* If currDS was found, psm != NULL */
-    if(currDS->configurationFreezeCounter > 0) {
+    if(currDS->configurationFreezeCounter > 0 && !canUpdateInUse(psm, currDS)) {
         UA_LOG_WARNING_PUBSUB(psm->logging, currDS,
                               "Adding DataSetField failed: PublishedDataSet already in use");
         result.result = UA_STATUSCODE_BADCONFIGURATIONERROR;
@@ -347,6 +403,17 @@ UA_DataSetField_create(UA_PubSubManager *psm, const UA_NodeId publishedDataSet,
     currDS->dataSetMetaData.configurationVersion.majorVersion =
         UA_PubSubConfigurationVersionTimeDifference(el->dateTime_now(el));
 
+    /* Update the offset tables where the PublishedDataSet is in use. Roll
+     * back if the field cannot be published. */
+    UA_StatusCode res = updateInUse(psm, currDS, false);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_DataSetField_remove(psm, newField);
+        if(fieldIdentifier)
+            UA_NodeId_clear(fieldIdentifier);
+        result.result = res;
+        return result;
+    }
+
     result.configurationVersion.majorVersion =
         currDS->dataSetMetaData.configurationVersion.majorVersion;
     result.configurationVersion.minorVersion =
@@ -371,7 +438,7 @@ UA_DataSetField_remove(UA_PubSubManager *psm, UA_DataSetField *currentField) {
         return result;
     }
 
-    if(pds->configurationFreezeCounter > 0) {
+    if(pds->configurationFreezeCounter > 0 && !canUpdateInUse(psm, pds)) {
         UA_LOG_WARNING_PUBSUB(psm->logging, pds,
                               "Remove DataSetField failed: PublishedDataSet is in use");
         result.result = UA_STATUSCODE_BADCONFIGURATIONERROR;
@@ -433,6 +500,10 @@ UA_DataSetField_remove(UA_PubSubManager *psm, UA_DataSetField *currentField) {
         pds->dataSetMetaData.fields = NULL;
     }
 
+    /* Update the offset tables where the PublishedDataSet is in use */
+    if(result.result == UA_STATUSCODE_GOOD)
+        result.result = updateInUse(psm, pds, true);
+
     result.configurationVersion.majorVersion =
         pds->dataSetMetaData.configurationVersion.majorVersion;
     result.configurationVersion.minorVersion =
@@ -487,13 +558,32 @@ UA_PubSubDataSetField_sampleValue(UA_PubSubManager *psm, UA_DataSetField *field,
     UA_PublishedVariableDataType *params = &field->config.field.variable.publishParameters;
 
     /* Read the value */
+    UA_Boolean readNode =
+        !field->config.field.variable.rtValueSource.rtFieldSourceEnabled;
     if(field->config.field.variable.rtValueSource.rtInformationModelNode) {
         const UA_VariableNode *rtNode = (const UA_VariableNode *)
             UA_NODESTORE_GET(psm->sc.server, &params->publishedVariable);
-        *value = **rtNode->valueBackend.backend.external.value;
-        value->value.storageType = UA_VARIANT_DATA_NODELETE;
+        if(rtNode->valueBackend.backendType == UA_VALUEBACKENDTYPE_MEMORY) {
+            /* Point into the memory region. With a seqlock the region is
+             * copied by the Read below. */
+            readNode = (rtNode->valueBackend.backend.memory.seqlock != NULL);
+            if(!readNode) {
+                UA_DataValue_init(value);
+                value->value.type = rtNode->valueBackend.backend.memory.type;
+                value->value.data = rtNode->valueBackend.backend.memory.data;
+                value->value.arrayLength = rtNode->valueBackend.backend.memory.arrayLength;
+                value->value.storageType = UA_VARIANT_DATA_NODELETE;
+                value->hasValue = true;
+            }
+        } else {
+            readNode = false;
+            *value = **rtNode->valueBackend.backend.external.value;
+            value->value.storageType = UA_VARIANT_DATA_NODELETE;
+        }
         UA_NODESTORE_RELEASE(psm->sc.server, (const UA_Node *) rtNode);
-    } else if(field->config.field.variable.rtValueSource.rtFieldSourceEnabled == false){
+    }
+
+    if(readNode) {
         UA_ReadValueId rvid;
         UA_ReadValueId_init(&rvid);
         rvid.nodeId = params->publishedVariable;
@@ -501,12 +591,33 @@ UA_PubSubDataSetField_sampleValue(UA_PubSubManager *psm, UA_DataSetField *field,
         rvid.indexRange = params->indexRange;
         *value = readWithSession(psm->sc.server, &psm->sc.server->adminSession,
                                  &rvid, UA_TIMESTAMPSTORETURN_BOTH);
-    } else {
+    } else if(!field->config.field.variable.rtValueSource.rtInformationModelNode) {
         *value = **field->config.field.variable.rtValueSource.staticValueSource;
         value->value.storageType = UA_VARIANT_DATA_NODELETE;
     }
 }
 
+/* Get the stable pointer to the value of an RT DataSetField. Returns NULL if
+ * the field has no external value source. */
+UA_DataValue **
+UA_PubSubDataSetField_getRTValueSource(UA_PubSubManager *psm,
+                                       UA_DataSetField *field) {
+    UA_DataSetVariableConfig *var = &field->config.field.variable;
+    if(!var->rtValueSource.rtInformationModelNode) {
+        return (var->rtValueSource.rtFieldSourceEnabled) ?
+            var->rtValueSource.staticValueSource : NULL;
+    }
+
+    UA_DataValue **source = NULL;
+    const UA_VariableNode *rtNode = (const UA_VariableNode *)
+        UA_NODESTORE_GET(psm->sc.server, &var->publishParameters.publishedVariable);
+    if(rtNode && rtNode->head.nodeClass == UA_NODECLASS_VARIABLE &&
+       rtNode->valueBackend.backendType == UA_VALUEBACKENDTYPE_EXTERNAL)
+        source = rtNode->valueBackend.backend.external.value;
+    UA_NODESTORE_RELEASE(psm->sc.server, (const UA_Node *)rtNode);
+    return source;
+}
+
 UA_AddPublishedDataSetResult
 UA_PublishedDataSet_create(UA_PubSubManager *psm,
                            const UA_PublishedDataSetConfig *publishedDataSetConfig,
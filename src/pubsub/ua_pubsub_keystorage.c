@@ -174,8 +174,9 @@ UA_PubSubKeyStorage_addKeyRolloverCallback(UA_PubSubManager *psm,
 }
 
 static UA_StatusCode
-splitCurrentKeyMaterial(UA_PubSubKeyStorage *ks, UA_ByteString *signingKey,
-                        UA_ByteString *encryptingKey, UA_ByteString *keyNonce) {
+splitKeyMaterial(UA_PubSubKeyStorage *ks, const UA_PubSubKeyListItem *item,
+                 UA_ByteString *signingKey, UA_ByteString *encryptingKey,
+                 UA_ByteString *keyNonce) {
     if(!ks)
         return UA_STATUSCODE_BADNOTFOUND;
 
@@ -184,7 +185,7 @@ splitCurrentKeyMaterial(UA_PubSubKeyStorage *ks, UA_ByteString *signingKey,
 
     UA_PubSubSecurityPolicy *policy = ks->policy;
 
-    UA_ByteString key = ks->currentItem->key;
+    UA_ByteString key = item->key;
 
     /*Check the main key length is the same according to policy*/
     if(key.length != policy->symmetricModule.secureChannelNonceLength)
@@ -211,31 +212,70 @@ splitCurrentKeyMaterial(UA_PubSubKeyStorage *ks, UA_ByteString *signingKey,
     return UA_STATUSCODE_GOOD;
 }
 
+/* Set the current key and prepare the next key (if it is already known). The
+ * prepared context is swapped in at the rollover without allocations. */
+static UA_StatusCode
+setWriterGroupKeys(UA_PubSubManager *psm, UA_WriterGroup *wg,
+                   UA_PubSubKeyStorage *ks) {
+    UA_ByteString signingKey, encryptKey, keyNonce;
+    UA_StatusCode retval = splitKeyMaterial(ks, ks->currentItem, &signingKey,
+                                            &encryptKey, &keyNonce);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    retval = UA_WriterGroup_setEncryptionKeys(psm, wg, ks->currentItem->keyID,
+                                              signingKey, encryptKey, keyNonce);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
+    UA_PubSubKeyListItem *next = TAILQ_NEXT(ks->currentItem, keyListEntry);
+    if(!next || splitKeyMaterial(ks, next, &signingKey, &encryptKey,
+                                 &keyNonce) != UA_STATUSCODE_GOOD)
+        return UA_STATUSCODE_GOOD;
+    UA_WriterGroup_setNextEncryptionKeys(psm, wg, next->keyID, signingKey,
+                                         encryptKey, keyNonce);
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+setReaderGroupKeys(UA_PubSubManager *psm, UA_ReaderGroup *rg,
+                   UA_PubSubKeyStorage *ks) {
+    UA_ByteString signingKey, encryptKey, keyNonce;
+    UA_StatusCode retval = splitKeyMaterial(ks, ks->currentItem, &signingKey,
+                                            &encryptKey, &keyNonce);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    retval = UA_ReaderGroup_setEncryptionKeys(psm, rg, ks->currentItem->keyID,
+                                              signingKey, encryptKey, keyNonce);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
+    UA_PubSubKeyListItem *next = TAILQ_NEXT(ks->currentItem, keyListEntry);
+    if(!next || splitKeyMaterial(ks, next, &signingKey, &encryptKey,
+                                 &keyNonce) != UA_STATUSCODE_GOOD)
+        return UA_STATUSCODE_GOOD;
+    UA_ReaderGroup_setNextEncryptionKeys(psm, rg, next->keyID, signingKey,
+                                         encryptKey, keyNonce);
+    return UA_STATUSCODE_GOOD;
+}
+
 static UA_StatusCode
 setPubSubGroupEncryptingKey(UA_PubSubManager *psm, UA_NodeId PubSubGroupId,
-                            UA_UInt32 securityTokenId, UA_ByteString signingKey,
-                            UA_ByteString encryptingKey, UA_ByteString keyNonce) {
+                            UA_PubSubKeyStorage *ks) {
     UA_LOCK_ASSERT(&psm->sc.server->serviceMutex);
     UA_WriterGroup *wg = UA_WriterGroup_find(psm, PubSubGroupId);
     if(wg)
-        return UA_WriterGroup_setEncryptionKeys(psm, wg, securityTokenId, signingKey,
-                                                encryptingKey, keyNonce);
+        return setWriterGroupKeys(psm, wg, ks);
 
     UA_ReaderGroup *rg = UA_ReaderGroup_find(psm, PubSubGroupId);
     if(rg)
-        return UA_ReaderGroup_setEncryptionKeys(psm, rg, securityTokenId, signingKey,
-                                                encryptingKey, keyNonce);
+        return setReaderGroupKeys(psm, rg, ks);
 
     return UA_STATUSCODE_BADNOTFOUND;
 }
 
 static UA_StatusCode
 setPubSubGroupEncryptingKeyForMatchingSecurityGroupId(UA_PubSubManager *psm,
-                                                      UA_String securityGroupId,
-                                                      UA_UInt32 securityTokenId,
-                                                      UA_ByteString signingKey,
-                                                      UA_ByteString encryptingKey,
-                                                      UA_ByteString keyNonce) {
+                                                      UA_PubSubKeyStorage *ks) {
     UA_LOCK_ASSERT(&psm->sc.server->serviceMutex);
 
     /* Key storage is the same for all reader / writer groups, channel context isn't
@@ -247,9 +287,8 @@ setPubSubGroupEncryptingKeyForMatchingSecurityGroupId(UA_PubSubManager *psm,
         /* For each writerGroup in server with matching SecurityGroupId */
         UA_WriterGroup *wg;
         LIST_FOREACH(wg, &c->writerGroups, listEntry) {
-            if(UA_String_equal(&wg->config.securityGroupId, &securityGroupId)) {
-                retval = UA_WriterGroup_setEncryptionKeys(psm, wg, securityTokenId,
-                                                          signingKey, encryptingKey, keyNonce);
+            if(UA_String_equal(&wg->config.securityGroupId, &ks->securityGroupID)) {
+                retval = setWriterGroupKeys(psm, wg, ks);
                 if(retval != UA_STATUSCODE_GOOD)
                     return retval;
             }
@@ -258,9 +297,8 @@ setPubSubGroupEncryptingKeyForMatchingSecurityGroupId(UA_PubSubManager *psm,
         /* For each readerGroup in server with matching SecurityGroupId */
         UA_ReaderGroup *rg;
         LIST_FOREACH(rg, &c->readerGroups, listEntry) {
-            if(UA_String_equal(&rg->config.securityGroupId, &securityGroupId)) {
-                retval = UA_ReaderGroup_setEncryptionKeys(psm, rg, securityTokenId,
-                                                          signingKey, encryptingKey, keyNonce);
+            if(UA_String_equal(&rg->config.securityGroupId, &ks->securityGroupID)) {
+                retval = setReaderGroupKeys(psm, rg, ks);
                 if(retval != UA_STATUSCODE_GOOD)
                     return retval;
             }
@@ -285,23 +323,14 @@ UA_PubSubKeyStorage_activateKeyToChannelContext(UA_PubSubManager *psm,
     if(!ks->policy && !(ks->keyListSize > 0))
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    UA_UInt32 securityTokenId = ks->currentItem->keyID;
-
-    /*DivideKeys in origin ByteString*/
-    UA_ByteString signingKey;
-    UA_ByteString encryptKey;
-    UA_ByteString keyNonce;
-    UA_StatusCode retval = splitCurrentKeyMaterial(ks, &signingKey,
-                                                   &encryptKey, &keyNonce);
-    if(retval != UA_STATUSCODE_GOOD)
-        return retval;
+    if(!ks->currentItem)
+        return UA_STATUSCODE_BADINTERNALERROR;
 
+    UA_StatusCode retval;
     if(!UA_NodeId_isNull(&pubSubGroupId))
-        retval = setPubSubGroupEncryptingKey(psm, pubSubGroupId, securityTokenId,
-                                             signingKey, encryptKey, keyNonce);
+        retval = setPubSubGroupEncryptingKey(psm, pubSubGroupId, ks);
     else
-        retval = setPubSubGroupEncryptingKeyForMatchingSecurityGroupId(
-            psm, securityGroupId, securityTokenId, signingKey, encryptKey, keyNonce);
+        retval = setPubSubGroupEncryptingKeyForMatchingSecurityGroupId(psm, ks);
 
     if(retval != UA_STATUSCODE_GOOD)
         UA_LOG_ERROR(psm->logging, UA_LOGCATEGORY_PUBSUB,
@@ -40,6 +40,83 @@ UA_PubSubComponentHead_clear(UA_PubSubComponentHead *psch) {
     memset(psch, 0, sizeof(UA_PubSubComponentHead));
 }
 
+static void
+recordStage(UA_PubSubCycleStats *cs, UA_PubSubStage stage, UA_DateTime duration) {
+    u64 d = (duration > 0) ? (u64)duration : 0;
+    if(cs->stages[stage].count == 0 || d < cs->min[stage])
+        cs->min[stage] = d;
+    UA_LatencyHistogram_record(&cs->stages[stage], d);
+}
+
+UA_Boolean
+UA_PubSubCycleStats_record(UA_PubSubCycleStats *cs, UA_DateTime start,
+                           UA_DateTime end, UA_DateTime interval) {
+    /* Jitter and overruns relative to the previous cycle */
+    UA_Boolean overrun = false;
+    if(cs->lastCycle != 0) {
+        UA_DateTime gap = start - cs->lastCycle;
+        if(interval > 0) {
+            recordStage(cs, UA_PUBSUBSTAGE_JITTER,
+                        (gap > interval) ? gap - interval : interval - gap);
+            if(gap > interval + interval / 2) {
+                overrun = true;
+                cs->overrunCount++;
+                cs->missedCycleCount += (u64)((gap + interval / 2) / interval) - 1;
+            }
+        } else {
+            if(cs->lastInterval != 0)
+                recordStage(cs, UA_PUBSUBSTAGE_JITTER, (gap > cs->lastInterval) ?
+                            gap - cs->lastInterval : cs->lastInterval - gap);
+            cs->lastInterval = gap;
+        }
+    }
+
+    /* Stage durations */
+    UA_DateTime total = end - start;
+    recordStage(cs, UA_PUBSUBSTAGE_ENCODING,
+                total - cs->securityTime - cs->transferTime);
+    recordStage(cs, UA_PUBSUBSTAGE_SECURITY, cs->securityTime);
+    recordStage(cs, UA_PUBSUBSTAGE_TRANSFER, cs->transferTime);
+    recordStage(cs, UA_PUBSUBSTAGE_TOTAL, total);
+    UA_PubSubCycleStats_discard(cs);
+
+    /* Ring buffer of the recent cycles */
+    cs->history[cs->historyPos] = start;
+    cs->historyPos = (cs->historyPos + 1) % UA_PUBSUB_CYCLEHISTORY;
+    if(cs->historySize < UA_PUBSUB_CYCLEHISTORY)
+        cs->historySize++;
+
+    cs->cycleCount++;
+    cs->lastCycle = start;
+    return overrun;
+}
+
+void
+UA_PubSubCycleStats_get(const UA_PubSubCycleStats *cs,
+                        UA_PubSubCycleStatistics *stats) {
+    memset(stats, 0, sizeof(UA_PubSubCycleStatistics));
+    stats->cycleCount = cs->cycleCount;
+    stats->overrunCount = cs->overrunCount;
+    stats->missedCycleCount = cs->missedCycleCount;
+    for(size_t i = 0; i < UA_PUBSUBSTAGES; i++) {
+        const UA_LatencyHistogram *h = &cs->stages[i];
+        if(h->count == 0)
+            continue;
+        UA_PubSubStageStatistics *ss = &stats->stages[i];
+        ss->min = (UA_Double)cs->min[i] / UA_DATETIME_MSEC;
+        ss->mean = ((UA_Double)h->sum / (UA_Double)h->count) / UA_DATETIME_MSEC;
+        ss->p99 = (UA_Double)UA_LatencyHistogram_percentile(h, 0.99) / UA_DATETIME_MSEC;
+        ss->max = (UA_Double)h->max / UA_DATETIME_MSEC;
+    }
+
+    /* Oldest first */
+    size_t first = (cs->historyPos + UA_PUBSUB_CYCLEHISTORY - cs->historySize) %
+        UA_PUBSUB_CYCLEHISTORY;
+    for(size_t i = 0; i < cs->historySize; i++)
+        stats->recentCycles[i] = cs->history[(first + i) % UA_PUBSUB_CYCLEHISTORY];
+    stats->recentCyclesSize = cs->historySize;
+}
+
 UA_StatusCode
 UA_PublisherId_copy(const UA_PublisherId *src,
                     UA_PublisherId *dst) {
@@ -570,4 +647,45 @@ UA_PubSubManager_new(UA_Server *server) {
     return &psm->sc;
 }
 
+void
+UA_PubSubManager_getStatistics(UA_Server *server, UA_PubSubStatistics *stats) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+    memset(stats, 0, sizeof(UA_PubSubStatistics));
+    UA_PubSubManager *psm = getPSM(server);
+    if(!psm)
+        return;
+    stats->publishCycleCount = psm->publishCycleCount;
+    stats->publishCycleOverrunCount = psm->publishCycleOverrunCount;
+}
+
+UA_StatusCode
+UA_Server_resetPubSubCycleStatistics(UA_Server *server, const UA_NodeId groupId) {
+    if(!server)
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+    UA_LOCK(&server->serviceMutex);
+    UA_PubSubManager *psm = getPSM(server);
+    UA_PubSubCycleStats *cs = NULL;
+    UA_WriterGroup *wg = UA_WriterGroup_find(psm, groupId);
+    if(wg) {
+        cs = &wg->cycleStats;
+    } else {
+        UA_ReaderGroup *rg = UA_ReaderGroup_find(psm, groupId);
+        if(rg)
+            cs = &rg->cycleStats;
+    }
+    if(!cs) {
+        UA_UNLOCK(&server->serviceMutex);
+        return UA_STATUSCODE_BADNOTFOUND;
+    }
+
+    /* Keep the last cycle for the jitter of the next cycle */
+    UA_DateTime lastCycle = cs->lastCycle;
+    UA_DateTime lastInterval = cs->lastInterval;
+    memset(cs, 0, sizeof(UA_PubSubCycleStats));
+    cs->lastCycle = lastCycle;
+    cs->lastInterval = lastInterval;
+    UA_UNLOCK(&server->serviceMutex);
+    return UA_STATUSCODE_GOOD;
+}
+
 #endif /* UA_ENABLE_PUBSUB */
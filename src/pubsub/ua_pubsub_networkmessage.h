@@ -62,9 +62,6 @@ typedef struct {
     size_t offsetsSize;
     UA_NetworkMessage *nm; /* The precomputed NetworkMessage for subscriber */
     size_t rawMessageLength;
-    UA_ByteString encryptBuffer; /* The precomputed message buffer is copied
-                                  * into the encrypt buffer for encryption and
-                                  * signing*/
     UA_Byte *payloadPosition; /* Payload Position of the message to encrypt*/
 } UA_NetworkMessageOffsetBuffer;
 
@@ -135,6 +132,36 @@ UA_NetworkMessage_decodePayload(Ctx *ctx, UA_NetworkMessage *dst);
 UA_StatusCode
 UA_NetworkMessage_decodeFooters(Ctx *ctx, UA_NetworkMessage *dst);
                           
+/* Constant JSON fragments of the NetworkMessages of a frozen WriterGroup.
+ * They are spliced in by the encoder instead of encoding the header and the
+ * field names for every message. Only for the default JSON options (reversible,
+ * no pretty-printing, quoted keys). */
+typedef struct {
+    UA_String header; /* Members of the NetworkMessage object before the
+                       * DataSetMessages (without the opening brace) */
+    const UA_String **fieldKeys; /* For every DataSetMessage the '"name":'
+                                  * fragments of its fields (or NULL) */
+} UA_NetworkMessageJsonTemplate;
+
+/* Encode the NetworkMessage members before the DataSetMessages */
+UA_StatusCode
+UA_NetworkMessage_encodeJsonHeader(const UA_NetworkMessage *src,
+                                   UA_String *header);
+
+/* Encode the field names as escaped JSON keys */
+UA_StatusCode
+UA_NetworkMessage_encodeJsonFieldKeys(const UA_String *fieldNames, size_t fieldNamesSize,
+                                      UA_String **fieldKeys);
+
+UA_StatusCode
+UA_NetworkMessage_encodeJsonTemplate(const UA_NetworkMessage *src,
+                                     const UA_NetworkMessageJsonTemplate *tmpl,
+                                     UA_Byte **bufPos, const UA_Byte *bufEnd);
+
+size_t
+UA_NetworkMessage_calcSizeJsonTemplate(const UA_NetworkMessage *src,
+                                       const UA_NetworkMessageJsonTemplate *tmpl);
+
 UA_StatusCode
 UA_NetworkMessage_encodeJsonInternal(const UA_NetworkMessage *src,
                                      UA_Byte **bufPos, const UA_Byte **bufEnd,
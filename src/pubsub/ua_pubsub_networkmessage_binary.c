@@ -57,6 +57,34 @@ static UA_Boolean UA_NetworkMessage_ExtendedFlags1Enabled(const UA_NetworkMessag
 static UA_Boolean UA_NetworkMessage_ExtendedFlags2Enabled(const UA_NetworkMessage* src);
 static UA_Boolean UA_DataSetMessageHeader_DataSetFlags2Enabled(const UA_DataSetMessageHeader* src);
 
+/* Fixed-size scalars of a builtin type whose binary encoding is identical to
+ * the memory layout are copied directly into the buffer */
+static UA_Boolean
+isCopyableScalar(const UA_Variant *v) {
+    return (v->type && v->type->overlayable &&
+            v->type->typeKind <= UA_DATATYPEKIND_DIAGNOSTICINFO &&
+            UA_Variant_isScalar(v));
+}
+
+static UA_StatusCode
+updateVariantField(const UA_Variant *v, UA_Byte *bufPos, const UA_Byte *bufEnd) {
+    if(isCopyableScalar(v) && (size_t)(bufEnd - bufPos) > v->type->memSize) {
+        *bufPos = (UA_Byte)(v->type->typeKind + 1); /* Variant encoding byte */
+        memcpy(bufPos + 1, v->data, v->type->memSize);
+        return UA_STATUSCODE_GOOD;
+    }
+    return UA_Variant_encodeBinary(v, &bufPos, bufEnd);
+}
+
+static UA_StatusCode
+updateRawField(const UA_Variant *v, UA_Byte *bufPos, const UA_Byte *bufEnd) {
+    if(isCopyableScalar(v) && (size_t)(bufEnd - bufPos) >= v->type->memSize) {
+        memcpy(bufPos, v->data, v->type->memSize);
+        return UA_STATUSCODE_GOOD;
+    }
+    return UA_encodeBinaryInternal(v->data, v->type, &bufPos, &bufEnd, NULL, NULL);
+}
+
 UA_StatusCode
 UA_NetworkMessage_updateBufferedMessage(UA_NetworkMessageOffsetBuffer *buffer) {
     UA_StatusCode rv = UA_STATUSCODE_GOOD;
@@ -77,20 +105,18 @@ UA_NetworkMessage_updateBufferedMessage(UA_NetworkMessageOffsetBuffer *buffer) {
                 rv = UA_DataValue_encodeBinary(*nmo->content.externalValue, &bufPos, bufEnd);
                 break;
             case UA_PUBSUB_OFFSETTYPE_PAYLOAD_VARIANT:
-                rv = UA_Variant_encodeBinary(&nmo->content.value.value, &bufPos, bufEnd);
+                rv = updateVariantField(&nmo->content.value.value, bufPos, bufEnd);
                 break;
             case UA_PUBSUB_OFFSETTYPE_PAYLOAD_VARIANT_EXTERNAL:
-                rv = UA_Variant_encodeBinary(&(*nmo->content.externalValue)->value, &bufPos, bufEnd);
+                rv = updateVariantField(&(*nmo->content.externalValue)->value,
+                                        bufPos, bufEnd);
                 break;
             case UA_PUBSUB_OFFSETTYPE_PAYLOAD_RAW:
-                rv = UA_encodeBinaryInternal(nmo->content.value.value.data,
-                                             nmo->content.value.value.type,
-                                             &bufPos, &bufEnd, NULL, NULL);
+                rv = updateRawField(&nmo->content.value.value, bufPos, bufEnd);
                 break;
             case UA_PUBSUB_OFFSETTYPE_PAYLOAD_RAW_EXTERNAL:
-                rv = UA_encodeBinaryInternal((*nmo->content.externalValue)->value.data,
-                                             (*nmo->content.externalValue)->value.type,
-                                             &bufPos, &bufEnd, NULL, NULL);
+                rv = updateRawField(&(*nmo->content.externalValue)->value,
+                                    bufPos, bufEnd);
                 break;
             default:
                 break; /* The other fields are assumed to not change between messages.
@@ -880,6 +906,7 @@ UA_NetworkMessage_decodeBinary(const UA_ByteString *src, UA_NetworkMessage *dst,
     ctx.pos = src->data;
     ctx.end = &src->data[src->length];
     ctx.depth = 0;
+    ctx.segments = NULL;
     if(options)
         ctx.opts = *options;
     else
@@ -1804,8 +1831,6 @@ UA_NetworkMessageOffsetBuffer_clear(UA_NetworkMessageOffsetBuffer *nmob) {
         UA_free(nmob->nm);
     }
 
-    UA_ByteString_clear(&nmob->encryptBuffer);
-
     if(nmob->offsetsSize == 0)
         return;
 
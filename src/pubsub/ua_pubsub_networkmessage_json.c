@@ -28,16 +28,42 @@ const char * UA_DECODEKEY_PAYLOAD = "Payload";
 const char * UA_DECODEKEY_DS_TYPE = "Type";
 
 /* -- json encoding/decoding -- */
+/* Field names are escaped like string values */
 static UA_StatusCode writeJsonKey_UA_String(CtxJson *ctx, UA_String *in) {
-    UA_STACKARRAY(char, out, in->length + 1);
-    memcpy(out, in->data, in->length);
-    out[in->length] = 0;
-    return writeJsonKey(ctx, out);
+    if(ctx->unquotedKeys) {
+        UA_STACKARRAY(char, out, in->length + 1);
+        memcpy(out, in->data, in->length);
+        out[in->length] = 0;
+        return writeJsonKey(ctx, out);
+    }
+    status ret = writeJsonBeforeElement(ctx, true);
+    ctx->commaNeeded[ctx->depth] = true;
+    ret |= encodeJsonJumpTable[UA_DATATYPEKIND_STRING](ctx, in, NULL);
+    ret |= writeChars(ctx, ":", 1);
+    if(ctx->prettyPrint)
+        ret |= writeChars(ctx, " ", 1);
+    return ret;
+}
+
+/* Use the precomputed key if available */
+static UA_StatusCode
+writeJsonFieldKey(CtxJson *ctx, const UA_DataSetMessage *src,
+                  const UA_String *fieldKeys, UA_UInt16 i) {
+    if(fieldKeys) {
+        status rv = writeJsonBeforeElement(ctx, true);
+        ctx->commaNeeded[ctx->depth] = true;
+        return rv | writeChars(ctx, (const char*)fieldKeys[i].data,
+                               fieldKeys[i].length);
+    }
+    if(src->data.keyFrameData.fieldNames)
+        return writeJsonKey_UA_String(ctx, &src->data.keyFrameData.fieldNames[i]);
+    return writeJsonKey(ctx, "");
 }
 
 static UA_StatusCode
 UA_DataSetMessage_encodeJson_internal(const UA_DataSetMessage* src,
                                       UA_UInt16 dataSetWriterId,
+                                      const UA_String *fieldKeys,
                                       CtxJson *ctx) {
     status rv = writeJsonObjStart(ctx);
 
@@ -96,10 +122,7 @@ UA_DataSetMessage_encodeJson_internal(const UA_DataSetMessage* src,
     if(src->header.fieldEncoding == UA_FIELDENCODING_VARIANT) {
         /* KEYFRAME VARIANT */
         for(UA_UInt16 i = 0; i < src->data.keyFrameData.fieldCount; i++) {
-            if(src->data.keyFrameData.fieldNames)
-                rv |= writeJsonKey_UA_String(ctx, &src->data.keyFrameData.fieldNames[i]);
-            else
-                rv |= writeJsonKey(ctx, "");
+            rv |= writeJsonFieldKey(ctx, src, fieldKeys, i);
             rv |= encodeJsonJumpTable[UA_DATATYPEKIND_VARIANT]
                 (ctx, &src->data.keyFrameData.dataSetFields[i].value, NULL);
             if(rv != UA_STATUSCODE_GOOD)
@@ -108,10 +131,7 @@ UA_DataSetMessage_encodeJson_internal(const UA_DataSetMessage* src,
     } else if(src->header.fieldEncoding == UA_FIELDENCODING_DATAVALUE) {
         /* KEYFRAME DATAVALUE */
         for(UA_UInt16 i = 0; i < src->data.keyFrameData.fieldCount; i++) {
-            if(src->data.keyFrameData.fieldNames)
-                rv |= writeJsonKey_UA_String(ctx, &src->data.keyFrameData.fieldNames[i]);
-            else
-                rv |= writeJsonKey(ctx, "");
+            rv |= writeJsonFieldKey(ctx, src, fieldKeys, i);
             rv |= encodeJsonJumpTable[UA_DATATYPEKIND_DATAVALUE]
                 (ctx, &src->data.keyFrameData.dataSetFields[i], NULL);
             if(rv != UA_STATUSCODE_GOOD)
@@ -126,13 +146,11 @@ UA_DataSetMessage_encodeJson_internal(const UA_DataSetMessage* src,
     return rv;
 }
 
+/* The NetworkMessage members before the DataSetMessages */
 static UA_StatusCode
-UA_NetworkMessage_encodeJson_internal(const UA_NetworkMessage* src, CtxJson *ctx) {
-    /* currently only ua-data is supported, no discovery message implemented */
-    if(src->networkMessageType != UA_NETWORKMESSAGE_DATASET)
-        return UA_STATUSCODE_BADNOTIMPLEMENTED;
-
-    status rv = writeJsonObjStart(ctx);
+UA_NetworkMessage_encodeJsonHeader_internal(const UA_NetworkMessage* src,
+                                            CtxJson *ctx) {
+    status rv = UA_STATUSCODE_GOOD;
 
     /* Table 91 – JSON NetworkMessage Definition
      * MessageId | String | A globally unique identifier for the message.
@@ -157,12 +175,29 @@ UA_NetworkMessage_encodeJson_internal(const UA_NetworkMessage* src, CtxJson *ctx
         return rv;
 
     /* DataSetClassId */
-    if(src->dataSetClassIdEnabled) {
+    if(src->dataSetClassIdEnabled)
         rv |= writeJsonObjElm(ctx, UA_DECODEKEY_DATASETCLASSID,
                               &src->dataSetClassId, &UA_TYPES[UA_TYPES_GUID]);
-        if(rv != UA_STATUSCODE_GOOD)
-            return rv;
+    return rv;
+}
+
+static UA_StatusCode
+UA_NetworkMessage_encodeJson_internal(const UA_NetworkMessage* src, CtxJson *ctx,
+                                      const UA_NetworkMessageJsonTemplate *tmpl) {
+    /* currently only ua-data is supported, no discovery message implemented */
+    if(src->networkMessageType != UA_NETWORKMESSAGE_DATASET)
+        return UA_STATUSCODE_BADNOTIMPLEMENTED;
+
+    status rv = writeJsonObjStart(ctx);
+    if(tmpl && tmpl->header.length > 0) {
+        /* Splice in the precomputed header */
+        rv |= writeChars(ctx, (const char*)tmpl->header.data, tmpl->header.length);
+        ctx->commaNeeded[ctx->depth] = true;
+    } else {
+        rv |= UA_NetworkMessage_encodeJsonHeader_internal(src, ctx);
     }
+    if(rv != UA_STATUSCODE_GOOD)
+        return rv;
 
     /* Payload: DataSetMessages */
     UA_Byte count = src->payloadHeader.dataSetPayloadHeader.count;
@@ -180,7 +215,9 @@ UA_NetworkMessage_encodeJson_internal(const UA_NetworkMessage* src, CtxJson *ctx
         for(UA_UInt16 i = 0; i < count; i++) {
             rv |= writeJsonBeforeElement(ctx, true);
             rv |= UA_DataSetMessage_encodeJson_internal(&dataSetMessages[i],
-                                                        dataSetWriterIds[i], ctx);
+                                                        dataSetWriterIds[i],
+                                                        (tmpl && tmpl->fieldKeys) ? tmpl->fieldKeys[i] : NULL,
+                                                        ctx);
             if(rv != UA_STATUSCODE_GOOD)
                 return rv;
             /* comma is needed if more dsm are present */
@@ -212,7 +249,7 @@ UA_NetworkMessage_encodeJsonInternal(const UA_NetworkMessage *src,
     ctx.useReversible = useReversible;
     ctx.calcOnly = false;
 
-    status ret = UA_NetworkMessage_encodeJson_internal(src, &ctx);
+    status ret = UA_NetworkMessage_encodeJson_internal(src, &ctx, NULL);
 
     *bufPos = ctx.pos;
     *bufEnd = ctx.end;
@@ -223,13 +260,12 @@ UA_StatusCode
 UA_NetworkMessage_encodeJson(const UA_NetworkMessage *src,
                              UA_ByteString *outBuf,
                              const UA_EncodeJsonOptions *options) {
+    /* The buffer grows during the encoding. So the message is encoded in a
+     * single pass without computing the length first. */
     UA_Boolean alloced = (outBuf->length == 0);
     UA_StatusCode ret = UA_STATUSCODE_GOOD;
     if(alloced) {
-        size_t length = UA_NetworkMessage_calcSizeJson(src, options);
-        if(length == 0)
-            return UA_STATUSCODE_BADENCODINGERROR;
-        ret = UA_ByteString_allocBuffer(outBuf, length);
+        ret = UA_ByteString_allocBuffer(outBuf, UA_JSON_ENCODING_INITIALSIZE);
         if(ret != UA_STATUSCODE_GOOD)
             return ret;
     }
@@ -240,6 +276,8 @@ UA_NetworkMessage_encodeJson(const UA_NetworkMessage *src,
     ctx.pos = outBuf->data;
     ctx.end = ctx.pos + outBuf->length;
     ctx.calcOnly = false;
+    if(alloced)
+        ctx.growBuf = outBuf;
     if(options) {
         ctx.useReversible = options->useReversible;
         ctx.namespacesSize = options->namespacesSize;
@@ -251,12 +289,15 @@ UA_NetworkMessage_encodeJson(const UA_NetworkMessage *src,
         ctx.stringNodeIds = options->stringNodeIds;
     }
 
-    ret = UA_NetworkMessage_encodeJson_internal(src, &ctx);
+    ret = UA_NetworkMessage_encodeJson_internal(src, &ctx, NULL);
 
     /* In case the buffer was supplied externally and is longer than the encoded
      * string */
-    if(UA_LIKELY(ret == UA_STATUSCODE_GOOD))
+    if(UA_LIKELY(ret == UA_STATUSCODE_GOOD)) {
         outBuf->length = (size_t)((uintptr_t)ctx.pos - (uintptr_t)outBuf->data);
+        if(alloced)
+            shrinkJsonBuffer(outBuf);
+    }
 
     if(alloced && ret != UA_STATUSCODE_GOOD)
         UA_String_clear(outBuf);
@@ -281,7 +322,7 @@ UA_NetworkMessage_calcSizeJsonInternal(const UA_NetworkMessage *src,
     ctx.useReversible = useReversible;
     ctx.calcOnly = true;
 
-    status ret = UA_NetworkMessage_encodeJson_internal(src, &ctx);
+    status ret = UA_NetworkMessage_encodeJson_internal(src, &ctx, NULL);
     if(ret != UA_STATUSCODE_GOOD)
         return 0;
     return (size_t)ctx.pos;
@@ -306,13 +347,109 @@ UA_NetworkMessage_calcSizeJson(const UA_NetworkMessage *src,
         ctx.stringNodeIds = options->stringNodeIds;
     }
 
-    status ret = UA_NetworkMessage_encodeJson_internal(src, &ctx);
+    status ret = UA_NetworkMessage_encodeJson_internal(src, &ctx, NULL);
     if(ret != UA_STATUSCODE_GOOD)
         return 0;
 
     return (size_t)ctx.pos;
 }
 
+UA_StatusCode
+UA_NetworkMessage_encodeJsonHeader(const UA_NetworkMessage *src,
+                                   UA_String *header) {
+    /* Compute the length. Open the NetworkMessage object so that the
+     * element separators are the same as within the full message. */
+    CtxJson ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.end = (const UA_Byte*)(uintptr_t)SIZE_MAX;
+    ctx.useReversible = true;
+    ctx.calcOnly = true;
+    ctx.depth = 1;
+    status ret = UA_NetworkMessage_encodeJsonHeader_internal(src, &ctx);
+    if(ret != UA_STATUSCODE_GOOD)
+        return ret;
+
+    ret = UA_ByteString_allocBuffer(header, (size_t)ctx.pos);
+    if(ret != UA_STATUSCODE_GOOD)
+        return ret;
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.pos = header->data;
+    ctx.end = header->data + header->length;
+    ctx.useReversible = true;
+    ctx.depth = 1;
+    ret = UA_NetworkMessage_encodeJsonHeader_internal(src, &ctx);
+    if(ret != UA_STATUSCODE_GOOD)
+        UA_String_clear(header);
+    return ret;
+}
+
+UA_StatusCode
+UA_NetworkMessage_encodeJsonFieldKeys(const UA_String *fieldNames, size_t fieldNamesSize,
+                                      UA_String **fieldKeys) {
+    UA_String *keys = (UA_String*)
+        UA_Array_new(fieldNamesSize, &UA_TYPES[UA_TYPES_STRING]);
+    if(!keys)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    /* Encode the name as an escaped JSON string followed by the colon */
+    UA_StatusCode ret = UA_STATUSCODE_GOOD;
+    for(size_t i = 0; i < fieldNamesSize; i++) {
+        CtxJson ctx;
+        memset(&ctx, 0, sizeof(ctx));
+        ctx.end = (const UA_Byte*)(uintptr_t)SIZE_MAX;
+        ctx.calcOnly = true;
+        ret = encodeJsonJumpTable[UA_DATATYPEKIND_STRING](&ctx, &fieldNames[i], NULL);
+        if(ret != UA_STATUSCODE_GOOD)
+            break;
+        ret = UA_ByteString_allocBuffer(&keys[i], (size_t)ctx.pos + 1);
+        if(ret != UA_STATUSCODE_GOOD)
+            break;
+        memset(&ctx, 0, sizeof(ctx));
+        ctx.pos = keys[i].data;
+        ctx.end = keys[i].data + keys[i].length;
+        ret = encodeJsonJumpTable[UA_DATATYPEKIND_STRING](&ctx, &fieldNames[i], NULL);
+        ret |= writeChars(&ctx, ":", 1);
+        if(ret != UA_STATUSCODE_GOOD)
+            break;
+    }
+
+    if(ret != UA_STATUSCODE_GOOD) {
+        UA_Array_delete(keys, fieldNamesSize, &UA_TYPES[UA_TYPES_STRING]);
+        return ret;
+    }
+    *fieldKeys = keys;
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_NetworkMessage_encodeJsonTemplate(const UA_NetworkMessage *src,
+                                     const UA_NetworkMessageJsonTemplate *tmpl,
+                                     UA_Byte **bufPos, const UA_Byte *bufEnd) {
+    CtxJson ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.pos = *bufPos;
+    ctx.end = bufEnd;
+    ctx.useReversible = true;
+    status ret = UA_NetworkMessage_encodeJson_internal(src, &ctx, tmpl);
+    *bufPos = ctx.pos;
+    return ret;
+}
+
+size_t
+UA_NetworkMessage_calcSizeJsonTemplate(const UA_NetworkMessage *src,
+                                       const UA_NetworkMessageJsonTemplate *tmpl) {
+    CtxJson ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.end = (const UA_Byte*)(uintptr_t)SIZE_MAX;
+    ctx.useReversible = true;
+    ctx.calcOnly = true;
+    status ret = UA_NetworkMessage_encodeJson_internal(src, &ctx, tmpl);
+    if(ret != UA_STATUSCODE_GOOD)
+        return 0;
+    return (size_t)ctx.pos;
+}
+
 /* decode json */
 static status
 MetaDataVersion_decodeJsonInternal(ParseCtx *ctx, void* cvd, const UA_DataType *type) {
@@ -559,17 +696,9 @@ UA_NetworkMessage_decodeJson(const UA_ByteString *src,
     /* Set up the context */
     cj5_token tokens[UA_JSON_MAXTOKENCOUNT];
     ParseCtx ctx;
-    memset(&ctx, 0, sizeof(ParseCtx));
-    ctx.tokens = tokens;
-    if(options) {
-        ctx.namespacesSize = options->namespacesSize;
-        ctx.namespaces = options->namespaces;
-        ctx.serverUrisSize = options->serverUrisSize;
-        ctx.serverUris = options->serverUris;
-        ctx.customTypes = options->customTypes;
-    }
+    ParseCtx_init(&ctx, options, tokens, UA_JSON_MAXTOKENCOUNT);
 
-    status ret = tokenize(&ctx, src, UA_JSON_MAXTOKENCOUNT, NULL);
+    status ret = tokenize(&ctx, src, NULL);
     if(ret != UA_STATUSCODE_GOOD)
         goto cleanup;
 
@@ -578,8 +707,6 @@ UA_NetworkMessage_decodeJson(const UA_ByteString *src,
         UA_NetworkMessage_clear(dst);
 
  cleanup:
-    /* Free token array on the heap */
-    if(ctx.tokens != tokens)
-        UA_free((void*)(uintptr_t)ctx.tokens);
+    ParseCtx_clearTokens(&ctx);
     return ret;
 }
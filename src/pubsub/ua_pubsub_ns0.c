@@ -608,12 +608,35 @@ addDataSetReaderConfig(UA_Server *server, UA_NodeId readerGroupId,
     return retVal;
 }
 
+/*************************************************/
+/*            Lazy Information Model             */
+/*************************************************/
+
+/* With the lazy information model, the first call for a component only
+ * reserves a NodeId. The representation is created with that NodeId once the
+ * parent node is browsed. */
+static UA_Boolean
+deferRepresentation(UA_Server *server, UA_NodeId *id) {
+    if(!server->config.pubSubConfig.lazyInformationModel || !UA_NodeId_isNull(id))
+        return false;
+    *id = UA_NODEID_GUID(1, UA_PubSubManager_generateUniqueGuid(getPSM(server)));
+    return true;
+}
+
+/* Use the reserved NodeId or generate a new one */
+static UA_NodeId
+representationId(const UA_NodeId *id) {
+    return (UA_NodeId_isNull(id)) ? UA_NODEID_NUMERIC(1, 0) : *id;
+}
+
 /*************************************************/
 /*            PubSubConnection                   */
 /*************************************************/
 
 UA_StatusCode
 addPubSubConnectionRepresentation(UA_Server *server, UA_PubSubConnection *connection) {
+    if(deferRepresentation(server, &connection->head.identifier))
+        return UA_STATUSCODE_GOOD;
     UA_StatusCode retVal = UA_STATUSCODE_GOOD;
     if(connection->config.name.length > 512)
         return UA_STATUSCODE_BADOUTOFMEMORY;
@@ -624,7 +647,7 @@ addPubSubConnectionRepresentation(UA_Server *server, UA_PubSubConnection *connec
     UA_ObjectAttributes attr = UA_ObjectAttributes_default;
     attr.displayName = UA_LOCALIZEDTEXT("", connectionName);
     retVal |= addNode_begin(server, UA_NODECLASS_OBJECT,
-                            UA_NODEID_NUMERIC(1, 0), /* Generate a new id */
+                            representationId(&connection->head.identifier),
                             UA_NS0ID(PUBLISHSUBSCRIBE),
                             UA_NS0ID(HASPUBSUBCONNECTION),
                             UA_QUALIFIEDNAME(0, connectionName),
@@ -844,6 +867,8 @@ removeConnectionAction(UA_Server *server,
 UA_StatusCode
 addDataSetReaderRepresentation(UA_Server *server, UA_DataSetReader *dataSetReader){
     UA_LOCK_ASSERT(&server->serviceMutex);
+    if(deferRepresentation(server, &dataSetReader->head.identifier))
+        return UA_STATUSCODE_GOOD;
 
     if(dataSetReader->config.name.length > 512)
         return UA_STATUSCODE_BADCONFIGURATIONERROR;
@@ -857,7 +882,8 @@ addDataSetReaderRepresentation(UA_Server *server, UA_DataSetReader *dataSetReade
 
     UA_ObjectAttributes object_attr = UA_ObjectAttributes_default;
     object_attr.displayName = UA_LOCALIZEDTEXT("", dsrName);
-    retVal = addNode(server, UA_NODECLASS_OBJECT, UA_NODEID_NUMERIC(1, 0), /* create an id */
+    retVal = addNode(server, UA_NODECLASS_OBJECT,
+                     representationId(&dataSetReader->head.identifier),
                      dataSetReader->linkedReaderGroup->head.identifier,
                      UA_NODEID_NUMERIC(0, UA_NS0ID_HASDATASETREADER),
                      UA_QUALIFIEDNAME(0, dsrName),
@@ -1029,6 +1055,8 @@ UA_StatusCode
 addPublishedDataItemsRepresentation(UA_Server *server,
                                     UA_PublishedDataSet *publishedDataSet) {
     UA_LOCK_ASSERT(&server->serviceMutex);
+    if(deferRepresentation(server, &publishedDataSet->head.identifier))
+        return UA_STATUSCODE_GOOD;
 
     UA_StatusCode retVal = UA_STATUSCODE_GOOD;
     if(publishedDataSet->config.name.length > 512)
@@ -1039,7 +1067,8 @@ addPublishedDataItemsRepresentation(UA_Server *server,
 
     UA_ObjectAttributes object_attr = UA_ObjectAttributes_default;
     object_attr.displayName = UA_LOCALIZEDTEXT("", pdsName);
-    retVal = addNode(server, UA_NODECLASS_OBJECT, UA_NODEID_NUMERIC(1, 0), /* Create a new id */
+    retVal = addNode(server, UA_NODECLASS_OBJECT,
+                     representationId(&publishedDataSet->head.identifier),
                      UA_NS0ID(PUBLISHSUBSCRIBE_PUBLISHEDDATASETS),
                      UA_NS0ID(HASCOMPONENT),
                      UA_QUALIFIEDNAME(0, pdsName),
@@ -1199,6 +1228,8 @@ UA_StatusCode
 addSubscribedDataSetRepresentation(UA_Server *server,
                                    UA_SubscribedDataSet *subscribedDataSet) {
     UA_LOCK_ASSERT(&server->serviceMutex);
+    if(deferRepresentation(server, &subscribedDataSet->head.identifier))
+        return UA_STATUSCODE_GOOD;
 
     UA_StatusCode ret = UA_STATUSCODE_GOOD;
     if(subscribedDataSet->config.name.length > 512)
@@ -1210,7 +1241,8 @@ addSubscribedDataSetRepresentation(UA_Server *server,
 
     UA_ObjectAttributes object_attr = UA_ObjectAttributes_default;
     object_attr.displayName = UA_LOCALIZEDTEXT("", sdsName);
-    addNode(server, UA_NODECLASS_OBJECT, UA_NODEID_NUMERIC(1, 0), /* Create a new id */
+    addNode(server, UA_NODECLASS_OBJECT,
+            representationId(&subscribedDataSet->head.identifier),
             UA_NS0ID(PUBLISHSUBSCRIBE_SUBSCRIBEDDATASETS),
             UA_NS0ID(HASCOMPONENT),
             UA_QUALIFIEDNAME(0, sdsName),
@@ -1275,6 +1307,102 @@ addSubscribedDataSetRepresentation(UA_Server *server,
     return ret;
 }
 
+/**********************************************/
+/*              Cycle Statistics              */
+/**********************************************/
+
+/* The statistics of a WriterGroup or ReaderGroup are encoded as an array of
+ * KeyValuePair. The node context points to the UA_PubSubCycleStats in the
+ * group. The variable is removed together with the group object. */
+#define UA_PUBSUBCYCLESTATISTICS_FIELDS (3 + (4 * UA_PUBSUBSTAGES))
+
+static const char *cycleStageNames[UA_PUBSUBSTAGES] = {
+    "Jitter", "Encoding", "Security", "Transfer", "Total"};
+
+static UA_StatusCode
+setCycleKeyValue(UA_KeyValuePair *kv, const char *stage, const char *key,
+                 const void *data, const UA_DataType *type) {
+    char name[32];
+    mp_snprintf(name, sizeof(name), "%s%s", stage, key);
+    kv->key = UA_QUALIFIEDNAME_ALLOC(0, name);
+    return UA_Variant_setScalarCopy(&kv->value, data, type);
+}
+
+static UA_StatusCode
+readCycleStatistics(UA_Server *server, const UA_NodeId *sessionId,
+                    void *sessionContext, const UA_NodeId *nodeId,
+                    void *nodeContext, UA_Boolean includeSourceTimeStamp,
+                    const UA_NumericRange *range, UA_DataValue *value) {
+    if(range) {
+        value->hasStatus = true;
+        value->status = UA_STATUSCODE_BADINDEXRANGEINVALID;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    UA_PubSubCycleStatistics stats;
+    UA_LOCK(&server->serviceMutex);
+    UA_PubSubCycleStats_get((UA_PubSubCycleStats*)nodeContext, &stats);
+    UA_UNLOCK(&server->serviceMutex);
+
+    UA_KeyValuePair *kv = (UA_KeyValuePair*)
+        UA_Array_new(UA_PUBSUBCYCLESTATISTICS_FIELDS, &UA_TYPES[UA_TYPES_KEYVALUEPAIR]);
+    if(!kv)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    const UA_DataType *u64 = &UA_TYPES[UA_TYPES_UINT64];
+    const UA_DataType *dur = &UA_TYPES[UA_TYPES_DURATION];
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    res |= setCycleKeyValue(&kv[0], "", "CycleCount", &stats.cycleCount, u64);
+    res |= setCycleKeyValue(&kv[1], "", "OverrunCount", &stats.overrunCount, u64);
+    res |= setCycleKeyValue(&kv[2], "", "MissedCycleCount",
+                            &stats.missedCycleCount, u64);
+    UA_KeyValuePair *skv = &kv[3];
+    for(size_t i = 0; i < UA_PUBSUBSTAGES; i++, skv += 4) {
+        const UA_PubSubStageStatistics *ss = &stats.stages[i];
+        res |= setCycleKeyValue(&skv[0], cycleStageNames[i], "Min", &ss->min, dur);
+        res |= setCycleKeyValue(&skv[1], cycleStageNames[i], "Mean", &ss->mean, dur);
+        res |= setCycleKeyValue(&skv[2], cycleStageNames[i], "P99", &ss->p99, dur);
+        res |= setCycleKeyValue(&skv[3], cycleStageNames[i], "Max", &ss->max, dur);
+    }
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_Array_delete(kv, UA_PUBSUBCYCLESTATISTICS_FIELDS,
+                        &UA_TYPES[UA_TYPES_KEYVALUEPAIR]);
+        return res;
+    }
+
+    UA_Variant_setArray(&value->value, kv, UA_PUBSUBCYCLESTATISTICS_FIELDS,
+                        &UA_TYPES[UA_TYPES_KEYVALUEPAIR]);
+    value->hasValue = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+addCycleStatisticsVariable(UA_Server *server, const UA_NodeId groupId,
+                           UA_PubSubCycleStats *cs) {
+    UA_UInt32 fields = UA_PUBSUBCYCLESTATISTICS_FIELDS;
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT("", "CycleStatistics");
+    attr.description = UA_LOCALIZEDTEXT("", "Cycle counters and stage "
+                                        "durations (vendor-specific)");
+    attr.dataType = UA_TYPES[UA_TYPES_KEYVALUEPAIR].typeId;
+    attr.valueRank = UA_VALUERANK_ONE_DIMENSION;
+    attr.arrayDimensions = &fields;
+    attr.arrayDimensionsSize = 1;
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ;
+    UA_NodeId newId;
+    UA_StatusCode res =
+        addNode(server, UA_NODECLASS_VARIABLE, UA_NODEID_NUMERIC(1, 0), groupId,
+                UA_NS0ID(HASCOMPONENT), UA_QUALIFIEDNAME(1, "CycleStatistics"),
+                UA_NS0ID(BASEDATAVARIABLETYPE), &attr,
+                &UA_TYPES[UA_TYPES_VARIABLEATTRIBUTES], cs, &newId);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    UA_DataSource ds = {readCycleStatistics, NULL};
+    res = setVariableNode_dataSource(server, newId, ds);
+    UA_NodeId_clear(&newId);
+    return res;
+}
+
 /**********************************************/
 /*               WriterGroup                  */
 /**********************************************/
@@ -1326,6 +1454,8 @@ writeContentMask(UA_Server *server, const UA_NodeId *sessionId,
 UA_StatusCode
 addWriterGroupRepresentation(UA_Server *server, UA_WriterGroup *writerGroup) {
     UA_LOCK_ASSERT(&server->serviceMutex);
+    if(deferRepresentation(server, &writerGroup->head.identifier))
+        return UA_STATUSCODE_GOOD;
 
     UA_StatusCode retVal = UA_STATUSCODE_GOOD;
     if(writerGroup->config.name.length > 512)
@@ -1337,7 +1467,7 @@ addWriterGroupRepresentation(UA_Server *server, UA_WriterGroup *writerGroup) {
     UA_ObjectAttributes object_attr = UA_ObjectAttributes_default;
     object_attr.displayName = UA_LOCALIZEDTEXT("", wgName);
     retVal = addNode(server, UA_NODECLASS_OBJECT,
-                     UA_NODEID_NUMERIC(1, 0), /* create a new id */
+                     representationId(&writerGroup->head.identifier),
                      writerGroup->linkedConnection->head.identifier, UA_NS0ID(HASCOMPONENT),
                      UA_QUALIFIEDNAME(0, wgName), UA_NS0ID(WRITERGROUPTYPE), &object_attr,
                      &UA_TYPES[UA_TYPES_OBJECTATTRIBUTES], NULL, &writerGroup->head.identifier);
@@ -1447,6 +1577,9 @@ addWriterGroupRepresentation(UA_Server *server, UA_WriterGroup *writerGroup) {
                          UA_NS0ID(HASCOMPONENT),
                          UA_NS0ID(WRITERGROUPTYPE_REMOVEDATASETWRITER), true);
     }
+
+    retVal |= addCycleStatisticsVariable(server, writerGroup->head.identifier,
+                                         &writerGroup->cycleStats);
     return retVal;
 }
 
@@ -1573,6 +1706,8 @@ addReserveIdsAction(UA_Server *server,
 UA_StatusCode
 addReaderGroupRepresentation(UA_Server *server, UA_ReaderGroup *readerGroup) {
     UA_LOCK_ASSERT(&server->serviceMutex);
+    if(deferRepresentation(server, &readerGroup->head.identifier))
+        return UA_STATUSCODE_GOOD;
     if(readerGroup->config.name.length > 512)
         return UA_STATUSCODE_BADCONFIGURATIONERROR;
     char rgName[513];
@@ -1582,7 +1717,8 @@ addReaderGroupRepresentation(UA_Server *server, UA_ReaderGroup *readerGroup) {
     UA_ObjectAttributes object_attr = UA_ObjectAttributes_default;
     object_attr.displayName = UA_LOCALIZEDTEXT("", rgName);
     UA_StatusCode retVal =
-        addNode(server, UA_NODECLASS_OBJECT, UA_NODEID_NUMERIC(1, 0), /* create an id */
+        addNode(server, UA_NODECLASS_OBJECT,
+                representationId(&readerGroup->head.identifier),
                 readerGroup->linkedConnection->head.identifier,
                 UA_NS0ID(HASCOMPONENT),
                 UA_QUALIFIEDNAME(0, rgName), UA_NS0ID(READERGROUPTYPE),
@@ -1621,6 +1757,9 @@ addReaderGroupRepresentation(UA_Server *server, UA_ReaderGroup *readerGroup) {
         retVal |= addRef(server, readerGroup->head.identifier, UA_NS0ID(HASCOMPONENT),
                          UA_NS0ID(READERGROUPTYPE_REMOVEDATASETREADER), true);
     }
+
+    retVal |= addCycleStatisticsVariable(server, readerGroup->head.identifier,
+                                         &readerGroup->cycleStats);
     return retVal;
 }
 
@@ -1767,6 +1906,8 @@ UA_StatusCode
 addDataSetWriterRepresentation(UA_Server *server, UA_DataSetWriter *dataSetWriter) {
 
     UA_LOCK_ASSERT(&server->serviceMutex);
+    if(deferRepresentation(server, &dataSetWriter->head.identifier))
+        return UA_STATUSCODE_GOOD;
 
     UA_StatusCode retVal = UA_STATUSCODE_GOOD;
     if(dataSetWriter->config.name.length > 512)
@@ -1779,7 +1920,8 @@ addDataSetWriterRepresentation(UA_Server *server, UA_DataSetWriter *dataSetWrite
     UA_ObjectAttributes object_attr = UA_ObjectAttributes_default;
     object_attr.displayName = UA_LOCALIZEDTEXT("", dswName);
     retVal =
-        addNode(server, UA_NODECLASS_OBJECT, UA_NODEID_NUMERIC(1, 0), /* create an id */
+        addNode(server, UA_NODECLASS_OBJECT,
+                representationId(&dataSetWriter->head.identifier),
                 dataSetWriter->linkedWriterGroup->head.identifier, UA_NS0ID(HASDATASETWRITER),
                 UA_QUALIFIEDNAME(0, dswName), UA_NS0ID(DATASETWRITERTYPE), &object_attr,
                 &UA_TYPES[UA_TYPES_OBJECTATTRIBUTES],
@@ -2532,4 +2674,161 @@ connectDataSetReaderToDataSet(UA_Server *server, UA_NodeId dsrId, UA_NodeId sdsI
     return retVal;
 }
 
+/*************************************************/
+/*            Lazy Information Model             */
+/*************************************************/
+
+static UA_Boolean
+isMaterialized(UA_Server *server, const UA_NodeId *id) {
+    const UA_Node *node = UA_NODESTORE_GET(server, id);
+    if(!node)
+        return false;
+    UA_NODESTORE_RELEASE(server, node);
+    return true;
+}
+
+/* The materialize functions first ensure that the nodes referenced by the
+ * representation exist */
+
+static void
+materializeConnection(UA_Server *server, UA_PubSubConnection *c) {
+    if(!isMaterialized(server, &c->head.identifier))
+        addPubSubConnectionRepresentation(server, c);
+}
+
+static void
+materializePublishedDataSet(UA_Server *server, UA_PublishedDataSet *pds) {
+    if(!isMaterialized(server, &pds->head.identifier))
+        addPublishedDataItemsRepresentation(server, pds);
+}
+
+static void
+materializeSubscribedDataSet(UA_Server *server, UA_SubscribedDataSet *sds) {
+    if(!isMaterialized(server, &sds->head.identifier))
+        addSubscribedDataSetRepresentation(server, sds);
+}
+
+static void
+materializeWriterGroup(UA_Server *server, UA_WriterGroup *wg) {
+    materializeConnection(server, wg->linkedConnection);
+    if(!isMaterialized(server, &wg->head.identifier))
+        addWriterGroupRepresentation(server, wg);
+}
+
+static void
+materializeReaderGroup(UA_Server *server, UA_ReaderGroup *rg) {
+    materializeConnection(server, rg->linkedConnection);
+    if(!isMaterialized(server, &rg->head.identifier))
+        addReaderGroupRepresentation(server, rg);
+}
+
+static void
+materializeDataSetWriter(UA_Server *server, UA_DataSetWriter *dsw) {
+    if(isMaterialized(server, &dsw->head.identifier))
+        return;
+    materializeWriterGroup(server, dsw->linkedWriterGroup);
+    if(dsw->connectedDataSet)
+        materializePublishedDataSet(server, dsw->connectedDataSet);
+    addDataSetWriterRepresentation(server, dsw);
+}
+
+static void
+materializeDataSetReader(UA_PubSubManager *psm, UA_DataSetReader *dsr) {
+    UA_Server *server = psm->sc.server;
+    if(isMaterialized(server, &dsr->head.identifier))
+        return;
+    materializeReaderGroup(server, dsr->linkedReaderGroup);
+    if(addDataSetReaderRepresentation(server, dsr) != UA_STATUSCODE_GOOD)
+        return;
+
+    /* Replay the connection to the StandaloneSubscribedDataSet */
+    UA_SubscribedDataSet *sds;
+    TAILQ_FOREACH(sds, &psm->subscribedDataSets, listEntry) {
+        if(sds->connectedReader != dsr)
+            continue;
+        materializeSubscribedDataSet(server, sds);
+        connectDataSetReaderToDataSet(server, dsr->head.identifier,
+                                      sds->head.identifier);
+        break;
+    }
+}
+
+static void
+materializeChildren(UA_PubSubManager *psm, const UA_NodeId *nodeId) {
+    UA_Server *server = psm->sc.server;
+
+    /* The PubSub folders in ns0 */
+    if(nodeId->namespaceIndex == 0) {
+        if(nodeId->identifierType != UA_NODEIDTYPE_NUMERIC)
+            return;
+        switch(nodeId->identifier.numeric) {
+        case UA_NS0ID_PUBLISHSUBSCRIBE: {
+            UA_PubSubConnection *c;
+            TAILQ_FOREACH(c, &psm->connections, listEntry)
+                materializeConnection(server, c);
+            break;
+        }
+        case UA_NS0ID_PUBLISHSUBSCRIBE_PUBLISHEDDATASETS: {
+            UA_PublishedDataSet *pds;
+            TAILQ_FOREACH(pds, &psm->publishedDataSets, listEntry)
+                materializePublishedDataSet(server, pds);
+            break;
+        }
+        case UA_NS0ID_PUBLISHSUBSCRIBE_SUBSCRIBEDDATASETS: {
+            UA_SubscribedDataSet *sds;
+            TAILQ_FOREACH(sds, &psm->subscribedDataSets, listEntry)
+                materializeSubscribedDataSet(server, sds);
+            break;
+        }
+        default:
+            break;
+        }
+        return;
+    }
+
+    /* Connections and groups. The DataSetWriters and DataSetReaders have no
+     * lazily created children. */
+    UA_PubSubConnection *c;
+    UA_WriterGroup *wg;
+    UA_ReaderGroup *rg;
+    UA_DataSetWriter *dsw;
+    UA_DataSetReader *dsr;
+    TAILQ_FOREACH(c, &psm->connections, listEntry) {
+        if(UA_NodeId_equal(nodeId, &c->head.identifier)) {
+            LIST_FOREACH(wg, &c->writerGroups, listEntry)
+                materializeWriterGroup(server, wg);
+            LIST_FOREACH(rg, &c->readerGroups, listEntry)
+                materializeReaderGroup(server, rg);
+            return;
+        }
+        LIST_FOREACH(wg, &c->writerGroups, listEntry) {
+            if(!UA_NodeId_equal(nodeId, &wg->head.identifier))
+                continue;
+            LIST_FOREACH(dsw, &wg->writers, listEntry)
+                materializeDataSetWriter(server, dsw);
+            return;
+        }
+        LIST_FOREACH(rg, &c->readerGroups, listEntry) {
+            if(!UA_NodeId_equal(nodeId, &rg->head.identifier))
+                continue;
+            LIST_FOREACH(dsr, &rg->readers, listEntry)
+                materializeDataSetReader(psm, dsr);
+            return;
+        }
+    }
+}
+
+void
+UA_PubSubManager_materialize(UA_Server *server, const UA_NodeId *nodeId) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+    if(!server->config.pubSubConfig.lazyInformationModel)
+        return;
+    UA_PubSubManager *psm = getPSM(server);
+    if(!psm || psm->materializing)
+        return;
+    psm->materializing = true;
+    materializeChildren(psm, nodeId);
+    psm->materializing = false;
+}
+
 #endif /* UA_ENABLE_PUBSUB_INFORMATIONMODEL */
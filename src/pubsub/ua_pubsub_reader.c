@@ -161,6 +161,9 @@ UA_DataSetReader_create(UA_PubSubManager *psm, UA_NodeId readerGroupIdentifier,
         return retVal;
     }
 
+    /* Add to the reader index if the ReaderGroup is frozen */
+    UA_ReaderGroup_indexReader(rg, dsr);
+
 #ifdef UA_ENABLE_PUBSUB_INFORMATIONMODEL
     retVal = addDataSetReaderRepresentation(psm->sc.server, dsr);
     if(retVal != UA_STATUSCODE_GOOD) {
@@ -295,13 +298,14 @@ UA_DataSetReader_remove(UA_PubSubManager *psm, UA_DataSetReader *dsr) {
         sds->connectedReader = NULL;
 
     /* Remove DataSetReader from group */
+    UA_ReaderGroup_unindexReader(rg, dsr);
     LIST_REMOVE(dsr, listEntry);
     rg->readersCount--;
 
     UA_LOG_INFO_PUBSUB(psm->logging, dsr, "DataSetReader deleted");
 
     UA_DataSetReaderConfig_clear(&dsr->config);
-    UA_NetworkMessageOffsetBuffer_clear(&dsr->bufferedMessage);
+    UA_DataSetReader_clearOffsetBuffer(dsr);
     UA_PubSubComponentHead_clear(&dsr->head);
     UA_free(dsr);
 
@@ -592,17 +596,17 @@ UA_DataSetReader_handleMessageReceiveTimeout(UA_PubSubManager *psm,
     UA_LOG_DEBUG_PUBSUB(psm->logging, dsr, "Message receive timeout occurred");
 
     UA_LOCK(&psm->sc.server->serviceMutex);
+    dsr->linkedReaderGroup->cycleStats.overrunCount++;
     UA_DataSetReader_setPubSubState(psm, dsr, UA_PUBSUBSTATE_ERROR,
                                     UA_STATUSCODE_BADTIMEOUT);
     UA_UNLOCK(&psm->sc.server->serviceMutex);
 }
 
-void
-UA_DataSetReader_process(UA_PubSubManager *psm, UA_DataSetReader *dsr,
-                         UA_DataSetMessage *msg) {
-    if(!dsr || !msg || !psm)
-        return;
-
+/* Check the state and the DataSetMessage header before the fields are
+ * processed. Resets the MessageReceiveTimeout. */
+static UA_Boolean
+UA_DataSetReader_checkDataSetMessage(UA_PubSubManager *psm, UA_DataSetReader *dsr,
+                                     const UA_DataSetMessageHeader *header) {
     UA_LOG_DEBUG_PUBSUB(psm->logging, dsr, "Received a network message");
 
     /* Received a (first) message for the Reader.
@@ -614,13 +618,13 @@ UA_DataSetReader_process(UA_PubSubManager *psm, UA_DataSetReader *dsr,
        dsr->head.state != UA_PUBSUBSTATE_PREOPERATIONAL) {
         UA_LOG_WARNING_PUBSUB(psm->logging, dsr,
                               "Received a network message but not operational");
-        return;
+        return false;
     }
 
-    if(!msg->header.dataSetMessageValid) {
+    if(!header->dataSetMessageValid) {
         UA_LOG_INFO_PUBSUB(psm->logging, dsr,
                            "DataSetMessage is discarded: message is not valid");
-        return;
+        return false;
     }
 
     /* TODO: Check ConfigurationVersion */
@@ -634,10 +638,10 @@ UA_DataSetReader_process(UA_PubSubManager *psm, UA_DataSetReader *dsr,
      *     }
      * } */
 
-    if(msg->header.dataSetMessageType != UA_DATASETMESSAGE_DATAKEYFRAME) {
+    if(header->dataSetMessageType != UA_DATASETMESSAGE_DATAKEYFRAME) {
         UA_LOG_WARNING_PUBSUB(psm->logging, dsr,
                               "DataSetMessage is discarded: Only keyframes are supported");
-        return;
+        return false;
     }
 
     /* Configure / Update the timeout callback */
@@ -656,6 +660,18 @@ UA_DataSetReader_process(UA_PubSubManager *psm, UA_DataSetReader *dsr,
         }
     }
 
+    return true;
+}
+
+void
+UA_DataSetReader_process(UA_PubSubManager *psm, UA_DataSetReader *dsr,
+                         UA_DataSetMessage *msg) {
+    if(!dsr || !msg || !psm)
+        return;
+
+    if(!UA_DataSetReader_checkDataSetMessage(psm, dsr, &msg->header))
+        return;
+
     /* Process message with raw encoding. We have no field-count information for
      * the message. */
     if(msg->header.fieldEncoding == UA_FIELDENCODING_RAWDATA) {
@@ -731,6 +747,141 @@ UA_DataSetReader_process(UA_PubSubManager *psm, UA_DataSetReader *dsr,
     }
 }
 
+void
+UA_DataSetReader_clearOffsetBuffer(UA_DataSetReader *dsr) {
+    UA_NetworkMessageOffsetBuffer_clear(&dsr->bufferedMessage);
+    UA_free(dsr->directFields);
+    dsr->directFields = NULL;
+    dsr->directFieldsSize = 0;
+    dsr->directHeaderOffset = 0;
+    dsr->directMessageSize = 0;
+}
+
+/* Fixed-size types where the binary encoding has the size of the memory
+ * representation */
+static UA_Boolean
+isDirectType(const UA_DataType *type) {
+    return (type->typeKind <= UA_DATATYPEKIND_DOUBLE ||
+            type->typeKind == UA_DATATYPEKIND_DATETIME ||
+            type->typeKind == UA_DATATYPEKIND_STATUSCODE);
+}
+
+/* Prepare the offset table to copy the field values out of the received
+ * messages without decoding. Only if every field is a scalar with a fixed size
+ * and is written to an external value. Otherwise the table remains empty and
+ * the messages are decoded. */
+static void
+UA_DataSetReader_prepareDirectFields(Ctx *ctx, UA_DataSetReader *dsr,
+                                     const UA_ByteString *buf, size_t nmSize) {
+    UA_NetworkMessage *nm = dsr->bufferedMessage.nm;
+    if(nm->payloadHeaderEnabled && nm->payloadHeader.dataSetPayloadHeader.count != 1)
+        return;
+    UA_DataSetMessage *dsm = nm->payload.dataSetPayload.dataSetMessages;
+    if(!dsm || dsm->header.dataSetMessageType != UA_DATASETMESSAGE_DATAKEYFRAME)
+        return;
+
+    UA_TargetVariables *tvs = &dsr->config.subscribedDataSet.subscribedDataSetTarget;
+    size_t fieldsSize = dsr->config.dataSetMetaData.fieldsSize;
+    if(fieldsSize == 0 || tvs->targetVariablesSize != fieldsSize)
+        return;
+    if(dsm->header.fieldEncoding != UA_FIELDENCODING_RAWDATA &&
+       dsm->data.keyFrameData.fieldCount != fieldsSize)
+        return;
+
+    UA_DataSetReaderDirectField *dfs = (UA_DataSetReaderDirectField*)
+        UA_calloc(fieldsSize, sizeof(UA_DataSetReaderDirectField));
+    if(!dfs)
+        return;
+
+    /* Set the types and targets */
+    for(size_t i = 0; i < fieldsSize; i++) {
+        UA_FieldMetaData *fmd = &dsr->config.dataSetMetaData.fields[i];
+        const UA_DataType *type =
+            UA_findDataTypeWithCustom(&fmd->dataType, ctx->opts.customTypes);
+        if(!type || !isDirectType(type) || fmd->valueRank > 0 ||
+           !tvs->targetVariables[i].externalDataValue)
+            goto abort;
+        dfs[i].tv = &tvs->targetVariables[i];
+        dfs[i].type = type;
+    }
+
+    /* Collect the offsets */
+    size_t field = 0;
+    UA_Boolean header = false;
+    UA_NetworkMessageOffsetBuffer *ob = &dsr->bufferedMessage;
+    for(size_t i = 0; i < ob->offsetsSize; i++) {
+        UA_NetworkMessageOffset *nmo = &ob->offsets[i];
+        switch(nmo->contentType) {
+        case UA_PUBSUB_OFFSETTYPE_NETWORKMESSAGE_FIELDENCDODING:
+            dsr->directHeaderOffset = nmo->offset;
+            header = true;
+            break;
+        case UA_PUBSUB_OFFSETTYPE_PAYLOAD_VARIANT:
+            if(field >= fieldsSize || nmo->offset + 1 > buf->length)
+                goto abort;
+            /* Scalar Variant with the builtin type id as the encoding byte */
+            dfs[field].prefix[0] = (UA_Byte)(dfs[field].type->typeKind + 1);
+            if(buf->data[nmo->offset] != dfs[field].prefix[0])
+                goto abort;
+            dfs[field].prefixSize = 1;
+            dfs[field].offset = nmo->offset + 1;
+            field++;
+            break;
+        case UA_PUBSUB_OFFSETTYPE_PAYLOAD_DATAVALUE:
+            if(field >= fieldsSize || nmo->offset + 2 > buf->length)
+                goto abort;
+            /* The value is encoded right after the DataValue mask. Take the
+             * mask from the first message. The value has to be present. */
+            dfs[field].prefix[0] = buf->data[nmo->offset];
+            if(!(dfs[field].prefix[0] & 0x01))
+                goto abort;
+            dfs[field].prefix[1] = (UA_Byte)(dfs[field].type->typeKind + 1);
+            dfs[field].prefixSize = 2;
+            dfs[field].offset = nmo->offset + 2;
+            field++;
+            break;
+        default:
+            break;
+        }
+    }
+    if(!header)
+        goto abort;
+
+    /* The raw fields are not counted in the offset buffer. They follow each
+     * other without padding and have to fill the payload exactly. */
+    if(dsm->header.fieldEncoding == UA_FIELDENCODING_RAWDATA) {
+        UA_ByteString *raw = &dsm->data.keyFrameData.rawFields;
+        if(!raw->data || raw->data < buf->data ||
+           raw->data + raw->length > buf->data + buf->length)
+            goto abort;
+        size_t offset = (size_t)(raw->data - buf->data);
+        for(; field < fieldsSize; field++) {
+            dfs[field].offset = offset;
+            offset += dfs[field].type->memSize;
+        }
+        if(offset != (size_t)(raw->data - buf->data) + raw->length)
+            goto abort;
+        if(offset > nmSize)
+            nmSize = offset;
+    }
+    if(field != fieldsSize)
+        goto abort;
+
+    /* Check the bounds */
+    for(size_t i = 0; i < fieldsSize; i++) {
+        if(dfs[i].offset + dfs[i].type->memSize > nmSize)
+            goto abort;
+    }
+
+    dsr->directFields = dfs;
+    dsr->directFieldsSize = fieldsSize;
+    dsr->directMessageSize = nmSize;
+    return;
+
+ abort:
+    UA_free(dfs);
+}
+
 UA_StatusCode
 UA_DataSetReader_prepareOffsetBuffer(Ctx *ctx, UA_DataSetReader *reader,
                                      UA_ByteString *buf) {
@@ -765,9 +916,70 @@ UA_DataSetReader_prepareOffsetBuffer(Ctx *ctx, UA_DataSetReader *reader,
 
     /* Set the offset buffer in the reader */
     reader->bufferedMessage.nm = nm;
+
+    /* Prepare the direct decoding into the external values */
+    UA_DataSetReader_prepareDirectFields(ctx, reader, buf, nmSize);
     return UA_STATUSCODE_GOOD;
 }
 
+/* Copy the field values of a frozen RT message directly into the external
+ * values of the target variables. Returns false if the message does not match
+ * the prepared layout. Then the message is decoded instead. */
+static UA_Boolean
+UA_DataSetReader_processDirect(UA_PubSubManager *psm, UA_DataSetReader *dsr,
+                               Ctx *ctx, const UA_ByteString *buf) {
+    if(buf->length < dsr->directMessageSize)
+        return false;
+
+    /* Check the encoding bytes before the values */
+    UA_DataSetReaderDirectField *dfs = dsr->directFields;
+    for(size_t i = 0; i < dsr->directFieldsSize; i++) {
+        if(dfs[i].prefixSize > 0 &&
+           memcmp(&buf->data[dfs[i].offset - dfs[i].prefixSize],
+                  dfs[i].prefix, dfs[i].prefixSize) != 0)
+            return false;
+    }
+
+    /* Decode and check the DataSetMessage header */
+    UA_DataSetMessageHeader header;
+    memset(&header, 0, sizeof(UA_DataSetMessageHeader));
+    ctx->pos = buf->data + dsr->directHeaderOffset;
+    if(UA_DataSetMessageHeader_decodeBinary(ctx, &header) != UA_STATUSCODE_GOOD)
+        return false;
+    if(!UA_DataSetReader_checkDataSetMessage(psm, dsr, &header))
+        return true;
+
+    /* Copy the values. Byte-swap if the encoding differs from the memory
+     * layout of the architecture. */
+    for(size_t i = 0; i < dsr->directFieldsSize; i++) {
+        UA_FieldTargetVariable *tv = dfs[i].tv;
+        if((*tv->externalDataValue)->value.type != dfs[i].type) {
+            UA_LOG_WARNING_PUBSUB(psm->logging, dsr, "Mismatching type");
+            continue;
+        }
+        if(tv->beforeWrite)
+            tv->beforeWrite(psm->sc.server, &dsr->head.identifier,
+                            &dsr->linkedReaderGroup->head.identifier,
+                            &tv->targetVariable.targetNodeId,
+                            tv->targetVariableContext, tv->externalDataValue);
+        void *dst = (*tv->externalDataValue)->value.data;
+        if(dfs[i].type->overlayable) {
+            memcpy(dst, &buf->data[dfs[i].offset], dfs[i].type->memSize);
+        } else {
+            size_t offset = dfs[i].offset;
+            UA_StatusCode res =
+                UA_decodeBinaryInternal(buf, &offset, dst, dfs[i].type, NULL);
+            (void)res; /* Fixed-size type within the checked bounds */
+        }
+        if(tv->afterWrite)
+            tv->afterWrite(psm->sc.server, &dsr->head.identifier,
+                           &dsr->linkedReaderGroup->head.identifier,
+                           &tv->targetVariable.targetNodeId,
+                           tv->targetVariableContext, tv->externalDataValue);
+    }
+    return true;
+}
+
 void
 UA_DataSetReader_decodeAndProcessRT(UA_PubSubManager *psm, UA_DataSetReader *dsr,
                                     UA_ByteString buf) {
@@ -776,9 +988,14 @@ UA_DataSetReader_decodeAndProcessRT(UA_PubSubManager *psm, UA_DataSetReader *dsr
     ctx.pos = buf.data;
     ctx.end = buf.data + buf.length;
     ctx.depth = 0;
+    ctx.segments = NULL;
     memset(&ctx.opts, 0, sizeof(UA_DecodeBinaryOptions));
     ctx.opts.customTypes = psm->sc.server->config.customDataTypes;
 
+    /* Copy the values directly into the external data values */
+    if(dsr->directFields && UA_DataSetReader_processDirect(psm, dsr, &ctx, &buf))
+        return;
+
     UA_StatusCode rv;
     if(!dsr->bufferedMessage.nm) {
         /* This is the first message being received for the RT fastpath.
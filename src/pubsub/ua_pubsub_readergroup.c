@@ -201,6 +201,10 @@ UA_ReaderGroup_remove(UA_PubSubManager *psm, UA_ReaderGroup *rg) {
         rg->config.securityPolicy->deleteContext(rg->securityPolicyContext);
         rg->securityPolicyContext = NULL;
     }
+    if(rg->config.securityPolicy && rg->nextSecurityPolicyContext) {
+        rg->config.securityPolicy->deleteContext(rg->nextSecurityPolicyContext);
+        rg->nextSecurityPolicyContext = NULL;
+    }
 
 #ifdef UA_ENABLE_PUBSUB_SKS
     if(rg->keyStorage) {
@@ -231,6 +235,166 @@ UA_ReaderGroup_remove(UA_PubSubManager *psm, UA_ReaderGroup *rg) {
     UA_PubSubConnection_setPubSubState(psm, connection, connection->head.state);
 }
 
+/****************/
+/* Reader Index */
+/****************/
+
+static UA_UInt32
+readerIndexHash(const UA_PublisherId *publisherId, UA_UInt16 writerGroupId,
+                UA_UInt16 dataSetWriterId) {
+    struct {
+        UA_UInt64 publisherId;
+        UA_UInt32 idType;
+        UA_UInt16 writerGroupId;
+        UA_UInt16 dataSetWriterId;
+    } key;
+    memset(&key, 0, sizeof(key));
+    key.idType = (UA_UInt32)publisherId->idType;
+    key.writerGroupId = writerGroupId;
+    key.dataSetWriterId = dataSetWriterId;
+    switch(publisherId->idType) {
+    case UA_PUBLISHERIDTYPE_BYTE:   key.publisherId = publisherId->id.byte; break;
+    case UA_PUBLISHERIDTYPE_UINT16: key.publisherId = publisherId->id.uint16; break;
+    case UA_PUBLISHERIDTYPE_UINT32: key.publisherId = publisherId->id.uint32; break;
+    case UA_PUBLISHERIDTYPE_UINT64: key.publisherId = publisherId->id.uint64; break;
+    case UA_PUBLISHERIDTYPE_STRING:
+        key.publisherId = UA_ByteString_hash(0, publisherId->id.string.data,
+                                             publisherId->id.string.length);
+        break;
+    default: break;
+    }
+    return UA_ByteString_hash(0, (const UA_Byte*)&key, sizeof(key));
+}
+
+static void
+insertIndexedReader(UA_ReaderGroup *rg, UA_DataSetReader *dsr) {
+    UA_DataSetReader **bucket =
+        &rg->readerIndex[dsr->indexHash & (rg->readerIndexSize - 1)];
+    dsr->indexNext = *bucket;
+    *bucket = dsr;
+    rg->readerIndexCount++;
+}
+
+static void
+UA_ReaderGroup_clearReaderIndex(UA_ReaderGroup *rg) {
+    UA_free(rg->readerIndex);
+    rg->readerIndex = NULL;
+    rg->readerIndexSize = 0;
+    rg->readerIndexCount = 0;
+}
+
+/* (Re)build the index with at least one bucket per reader. Without memory the
+ * index remains empty and the readers are searched linearly. */
+static void
+UA_ReaderGroup_buildReaderIndex(UA_ReaderGroup *rg) {
+    /* Only UADP messages carry the identifiers in the headers */
+    UA_ReaderGroup_clearReaderIndex(rg);
+    if(rg->config.encodingMimeType != UA_PUBSUB_ENCODING_UADP)
+        return;
+
+    size_t size = 8;
+    while(size < rg->readersCount)
+        size <<= 1;
+    rg->readerIndex = (UA_DataSetReader**)
+        UA_calloc(size, sizeof(UA_DataSetReader*));
+    if(!rg->readerIndex)
+        return;
+    rg->readerIndexSize = size;
+
+    UA_DataSetReader *dsr;
+    LIST_FOREACH(dsr, &rg->readers, listEntry) {
+        dsr->indexHash = readerIndexHash(&dsr->config.publisherId,
+                                         dsr->config.writerGroupId,
+                                         dsr->config.dataSetWriterId);
+        insertIndexedReader(rg, dsr);
+    }
+}
+
+void
+UA_ReaderGroup_indexReader(UA_ReaderGroup *rg, UA_DataSetReader *dsr) {
+    if(!rg->readerIndex)
+        return;
+
+    /* Grow the index. This also adds the new reader. */
+    if(rg->readerIndexCount >= rg->readerIndexSize * 2) {
+        UA_ReaderGroup_buildReaderIndex(rg);
+        return;
+    }
+
+    dsr->indexHash = readerIndexHash(&dsr->config.publisherId,
+                                     dsr->config.writerGroupId,
+                                     dsr->config.dataSetWriterId);
+    insertIndexedReader(rg, dsr);
+}
+
+void
+UA_ReaderGroup_unindexReader(UA_ReaderGroup *rg, UA_DataSetReader *dsr) {
+    if(!rg->readerIndex)
+        return;
+    UA_DataSetReader **cur =
+        &rg->readerIndex[dsr->indexHash & (rg->readerIndexSize - 1)];
+    for(; *cur; cur = &(*cur)->indexNext) {
+        if(*cur != dsr)
+            continue;
+        *cur = dsr->indexNext;
+        dsr->indexNext = NULL;
+        rg->readerIndexCount--;
+        return;
+    }
+}
+
+/* The index can be used if the NetworkMessage contains all identifiers.
+ * Otherwise the readers are matched linearly. */
+static UA_Boolean
+UA_ReaderGroup_canUseReaderIndex(const UA_ReaderGroup *rg,
+                                 const UA_NetworkMessage *nm) {
+    return (rg->readerIndex && nm->publisherIdEnabled &&
+            nm->groupHeaderEnabled && nm->groupHeader.writerGroupIdEnabled &&
+            nm->payloadHeaderEnabled);
+}
+
+/* Find the next reader for the DataSetWriterId, starting from the bucket head
+ * or after the last result */
+static UA_DataSetReader *
+UA_ReaderGroup_findIndexedReader(UA_PubSubManager *psm, UA_ReaderGroup *rg,
+                                 UA_NetworkMessage *nm, UA_UInt32 hash,
+                                 UA_UInt16 dataSetWriterId,
+                                 UA_DataSetReader *dsr) {
+    dsr = (dsr) ? dsr->indexNext :
+        rg->readerIndex[hash & (rg->readerIndexSize - 1)];
+    for(; dsr; dsr = dsr->indexNext) {
+        if(dsr->indexHash == hash &&
+           dsr->config.dataSetWriterId == dataSetWriterId &&
+           UA_DataSetReader_checkIdentifier(psm, dsr, nm) == UA_STATUSCODE_GOOD)
+            return dsr;
+    }
+    return NULL;
+}
+
+UA_Boolean
+UA_ReaderGroup_hasMatchingReader(UA_PubSubManager *psm, UA_ReaderGroup *rg,
+                                 UA_NetworkMessage *nm) {
+    if(UA_ReaderGroup_canUseReaderIndex(rg, nm)) {
+        UA_DataSetPayloadHeader *ph = &nm->payloadHeader.dataSetPayloadHeader;
+        for(UA_Byte i = 0; i < ph->count; i++) {
+            UA_UInt32 hash = readerIndexHash(&nm->publisherId,
+                                             nm->groupHeader.writerGroupId,
+                                             ph->dataSetWriterIds[i]);
+            if(UA_ReaderGroup_findIndexedReader(psm, rg, nm, hash,
+                                                ph->dataSetWriterIds[i], NULL))
+                return true;
+        }
+        return false;
+    }
+
+    UA_DataSetReader *dsr;
+    LIST_FOREACH(dsr, &rg->readers, listEntry) {
+        if(UA_DataSetReader_checkIdentifier(psm, dsr, nm) == UA_STATUSCODE_GOOD)
+            return true;
+    }
+    return false;
+}
+
 static UA_StatusCode
 UA_ReaderGroup_freezeConfiguration(UA_PubSubManager *psm, UA_ReaderGroup *rg) {
     UA_LOCK_ASSERT(&psm->sc.server->serviceMutex);
@@ -241,6 +405,9 @@ UA_ReaderGroup_freezeConfiguration(UA_PubSubManager *psm, UA_ReaderGroup *rg) {
     /* ReaderGroup freeze */
     rg->configurationFrozen = true;
 
+    /* Index the readers to dispatch the received DataSetMessages */
+    UA_ReaderGroup_buildReaderIndex(rg);
+
     /* Not rt, we don't have to adjust anything */
     if((rg->config.rtLevel & UA_PUBSUB_RT_FIXED_SIZE) == 0)
         return UA_STATUSCODE_GOOD;
@@ -316,7 +483,7 @@ UA_ReaderGroup_freezeConfiguration(UA_PubSubManager *psm, UA_ReaderGroup *rg) {
      * generated when the first message is received. So we know the exact
      * settings which headers are present, etc. Until then the ReaderGroup is
      * "PreOperational". */
-    UA_NetworkMessageOffsetBuffer_clear(&dsr->bufferedMessage);
+    UA_DataSetReader_clearOffsetBuffer(dsr);
     return UA_STATUSCODE_GOOD;
 }
 
@@ -326,9 +493,11 @@ UA_ReaderGroup_unfreezeConfiguration(UA_ReaderGroup *rg) {
         return;
     rg->configurationFrozen = false;
 
+    UA_ReaderGroup_clearReaderIndex(rg);
+
     UA_DataSetReader *dataSetReader;
     LIST_FOREACH(dataSetReader, &rg->readers, listEntry) {
-        UA_NetworkMessageOffsetBuffer_clear(&dataSetReader->bufferedMessage);
+        UA_DataSetReader_clearOffsetBuffer(dataSetReader);
     }
 }
 
@@ -359,6 +528,8 @@ UA_ReaderGroup_setPubSubState(UA_PubSubManager *psm, UA_ReaderGroup *rg,
         UA_ReaderGroup_unfreezeConfiguration(rg);
         UA_ReaderGroup_disconnect(rg);
         rg->hasReceived = false;
+        rg->cycleStats.lastCycle = 0;
+        rg->cycleStats.lastInterval = 0;
         break;
 
         /* Enabled */
@@ -410,6 +581,8 @@ UA_ReaderGroup_setPubSubState(UA_PubSubManager *psm, UA_ReaderGroup *rg,
         UA_ReaderGroup_unfreezeConfiguration(rg);
         UA_ReaderGroup_disconnect(rg);
         rg->hasReceived = false;
+        rg->cycleStats.lastCycle = 0;
+        rg->cycleStats.lastInterval = 0;
     }
 
     /* Only the top-level state update (if recursive calls are happening)
@@ -469,6 +642,17 @@ UA_ReaderGroup_setEncryptionKeys(UA_PubSubManager *psm, UA_ReaderGroup *rg,
         rg->nonceSequenceNumber = 1;
     }
 
+    /* Swap in the prepared context. The keys are already set. The old context
+     * is kept for the key after that. */
+    if(rg->nextSecurityPolicyContext && rg->nextSecurityTokenId != 0 &&
+       securityTokenId == rg->nextSecurityTokenId) {
+        void *ctx = rg->securityPolicyContext;
+        rg->securityPolicyContext = rg->nextSecurityPolicyContext;
+        rg->nextSecurityPolicyContext = ctx;
+        rg->nextSecurityTokenId = 0;
+        return UA_STATUSCODE_GOOD;
+    }
+
     /* Create a new context */
     if(!rg->securityPolicyContext) {
         return rg->config.securityPolicy->
@@ -483,6 +667,60 @@ UA_ReaderGroup_setEncryptionKeys(UA_PubSubManager *psm, UA_ReaderGroup *rg,
                         &encryptingKey, &keyNonce);
 }
 
+UA_StatusCode
+UA_ReaderGroup_setNextEncryptionKeys(UA_PubSubManager *psm, UA_ReaderGroup *rg,
+                                     UA_UInt32 securityTokenId,
+                                     const UA_ByteString signingKey,
+                                     const UA_ByteString encryptingKey,
+                                     const UA_ByteString keyNonce) {
+    UA_PubSubSecurityPolicy *sp = rg->config.securityPolicy;
+    if(!sp || rg->config.encodingMimeType == UA_PUBSUB_ENCODING_JSON)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    UA_StatusCode res;
+    if(!rg->nextSecurityPolicyContext)
+        res = sp->newContext(sp->policyContext, &signingKey, &encryptingKey,
+                             &keyNonce, &rg->nextSecurityPolicyContext);
+    else
+        res = sp->setSecurityKeys(rg->nextSecurityPolicyContext, &signingKey,
+                                  &encryptingKey, &keyNonce);
+    rg->nextSecurityTokenId = (res == UA_STATUSCODE_GOOD) ? securityTokenId : 0;
+    return res;
+}
+
+/* Route every DataSetMessage to the readers with the matching identifiers.
+ * The current reader might be deleted in a state callback. So the next reader
+ * is looked up before the processing. */
+static UA_Boolean
+UA_ReaderGroup_processIndexed(UA_PubSubManager *psm, UA_ReaderGroup *rg,
+                              UA_NetworkMessage *nm) {
+    UA_Boolean processed = false;
+    UA_DataSetPayloadHeader *ph = &nm->payloadHeader.dataSetPayloadHeader;
+    for(UA_Byte i = 0; i < ph->count; i++) {
+        /* The index was removed in a callback */
+        if(!rg->readerIndex)
+            break;
+        UA_UInt16 dswId = ph->dataSetWriterIds[i];
+        UA_UInt32 hash = readerIndexHash(&nm->publisherId,
+                                         nm->groupHeader.writerGroupId, dswId);
+        UA_DataSetReader *dsr =
+            UA_ReaderGroup_findIndexedReader(psm, rg, nm, hash, dswId, NULL);
+        while(dsr) {
+            UA_DataSetReader *next =
+                UA_ReaderGroup_findIndexedReader(psm, rg, nm, hash, dswId, dsr);
+            if(dsr->head.state == UA_PUBSUBSTATE_OPERATIONAL ||
+               dsr->head.state == UA_PUBSUBSTATE_PREOPERATIONAL) {
+                processed = true;
+                UA_LOG_TRACE_PUBSUB(psm->logging, rg, "Processing a NetworkMessage");
+                UA_DataSetReader_process(psm, dsr,
+                                         &nm->payload.dataSetPayload.dataSetMessages[i]);
+            }
+            dsr = next;
+        }
+    }
+    return processed;
+}
+
 UA_Boolean
 UA_ReaderGroup_process(UA_PubSubManager *psm, UA_ReaderGroup *rg,
                        UA_NetworkMessage *nm) {
@@ -495,6 +733,10 @@ UA_ReaderGroup_process(UA_PubSubManager *psm, UA_ReaderGroup *rg,
     rg->hasReceived = true;
     UA_ReaderGroup_setPubSubState(psm, rg, rg->head.state);
 
+    /* Dispatch the DataSetMessages with the reader index */
+    if(UA_ReaderGroup_canUseReaderIndex(rg, nm))
+        return UA_ReaderGroup_processIndexed(psm, rg, nm);
+
     /* Safe iteration. The current Reader might be deleted in the ReaderGroup
      * _setPubSubState callback. */
     UA_Boolean processed = false;
@@ -544,6 +786,9 @@ UA_ReaderGroup_process(UA_PubSubManager *psm, UA_ReaderGroup *rg,
 UA_Boolean
 UA_ReaderGroup_decodeAndProcessRT(UA_PubSubManager *psm, UA_ReaderGroup *rg,
                                   UA_ByteString buf) {
+    UA_EventLoop *el = UA_PubSubConnection_getEL(psm, rg->linkedConnection);
+    UA_DateTime start = el->dateTime_nowMonotonic(el);
+
     /* Received a (first) message for the ReaderGroup.
      * Transition from PreOperational to Operational. */
     rg->hasReceived = true;
@@ -555,6 +800,7 @@ UA_ReaderGroup_decodeAndProcessRT(UA_PubSubManager *psm, UA_ReaderGroup *rg,
     ctx.pos = buf.data;
     ctx.end = buf.data + buf.length;
     ctx.depth = 0;
+    ctx.segments = NULL;
     memset(&ctx.opts, 0, sizeof(UA_DecodeBinaryOptions));
     ctx.opts.customTypes = psm->sc.server->config.customDataTypes;
 
@@ -582,13 +828,17 @@ UA_ReaderGroup_decodeAndProcessRT(UA_PubSubManager *psm, UA_ReaderGroup *rg,
     }
 
     /* Decrypt the message. Keep pos right after the header. */
+    UA_DateTime begin = el->dateTime_nowMonotonic(el);
     rv = verifyAndDecryptNetworkMessage(psm->logging, buf, &ctx,
                                         &currentNetworkMessage, rg);
     if(rv != UA_STATUSCODE_GOOD) {
         UA_LOG_WARNING_PUBSUB(psm->logging, rg, "Subscribe failed. "
                               "Verify and decrypt network message failed.");
+        UA_PubSubCycleStats_discard(&rg->cycleStats);
         return false;
     }
+    UA_DateTime end = el->dateTime_nowMonotonic(el);
+    rg->cycleStats.securityTime += end - begin;
 
     /* Process the message for each reader */
     UA_DataSetReader *dsr;
@@ -607,10 +857,18 @@ UA_ReaderGroup_decodeAndProcessRT(UA_PubSubManager *psm, UA_ReaderGroup *rg,
         }
 
         /* Process the message */
+        begin = el->dateTime_nowMonotonic(el);
         UA_DataSetReader_decodeAndProcessRT(psm, dsr, buf);
+        end = el->dateTime_nowMonotonic(el);
+        rg->cycleStats.transferTime += end - begin;
         processed = true;
     }
 
+    /* Only messages for the ReaderGroup count as a cycle */
+    if(processed)
+        UA_PubSubCycleStats_record(&rg->cycleStats, start, end, 0);
+    else
+        UA_PubSubCycleStats_discard(&rg->cycleStats);
     return processed;
 }
 
@@ -696,7 +954,13 @@ verifyAndDecryptNetworkMessage(const UA_Logger *logger, UA_ByteString buffer,
     if(!doValidate && !doDecrypt)
         return UA_STATUSCODE_GOOD;
 
+    /* Select the context by the SecurityTokenId. The publisher might have
+     * rolled over to the next key already. */
     void *channelContext = rg->securityPolicyContext;
+    if(nm->securityHeader.securityTokenId != rg->securityTokenId &&
+       nm->securityHeader.securityTokenId == rg->nextSecurityTokenId &&
+       rg->nextSecurityTokenId != 0 && rg->nextSecurityPolicyContext)
+        channelContext = rg->nextSecurityPolicyContext;
     UA_PubSubSecurityPolicy *securityPolicy = rg->config.securityPolicy;
     UA_CHECK_MEM_ERROR(channelContext, return UA_STATUSCODE_BADINVALIDARGUMENT,
                        logger, UA_LOGCATEGORY_PUBSUB,
@@ -873,10 +1137,10 @@ ReaderGroupChannelCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
     }
 
     /* ReaderGroup with realtime processing */
+    UA_MemoryCategory mc = UA_MemoryCategory_enter(UA_MEMORYCATEGORY_PUBSUB);
     if(rg->config.rtLevel & UA_PUBSUB_RT_FIXED_SIZE) {
         UA_ReaderGroup_decodeAndProcessRT(psm, rg, msg);
-        UA_UNLOCK(&server->serviceMutex);
-        return;
+        goto finish;
     }
 
     /* Decode message */
@@ -894,13 +1158,15 @@ ReaderGroupChannelCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
     if(res != UA_STATUSCODE_GOOD) {
         UA_LOG_WARNING_PUBSUB(psm->logging, rg,
                               "Verify, decrypt and decode network message failed");
-        UA_UNLOCK(&server->serviceMutex);
-        return;
+        goto finish;
     }
 
     /* Process the decoded message */
     UA_ReaderGroup_process(psm, rg, &nm);
     UA_NetworkMessage_clear(&nm);
+
+ finish:
+    UA_MemoryCategory_leave(mc);
     UA_UNLOCK(&server->serviceMutex);
 }
 
@@ -1090,6 +1356,22 @@ UA_Server_getReaderGroupState(UA_Server *server, const UA_NodeId rgId,
     return ret;
 }
 
+UA_StatusCode
+UA_Server_getReaderGroupCycleStatistics(UA_Server *server, const UA_NodeId rgId,
+                                        UA_PubSubCycleStatistics *stats) {
+    if(!server || !stats)
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+    UA_LOCK(&server->serviceMutex);
+    UA_StatusCode ret = UA_STATUSCODE_BADNOTFOUND;
+    UA_ReaderGroup *rg = UA_ReaderGroup_find(getPSM(server), rgId);
+    if(rg) {
+        UA_PubSubCycleStats_get(&rg->cycleStats, stats);
+        ret = UA_STATUSCODE_GOOD;
+    }
+    UA_UNLOCK(&server->serviceMutex);
+    return ret;
+}
+
 #ifdef UA_ENABLE_PUBSUB_SKS
 UA_StatusCode
 UA_Server_setReaderGroupActivateKey(UA_Server *server,
@@ -57,6 +57,28 @@ UA_DataSetWriterConfig_clear(UA_DataSetWriterConfig *pdsConfig) {
     memset(pdsConfig, 0, sizeof(UA_DataSetWriterConfig));
 }
 
+#ifdef UA_ENABLE_JSON_ENCODING
+/* Escape the field names once. The JSON encoding splices them into every
+ * message. Without the keys, the field names are copied into every
+ * DataSetMessage instead. */
+static void
+prepareJsonFieldKeys(UA_DataSetWriter *dsw, UA_PublishedDataSet *pds) {
+    if(pds->fieldSize == 0)
+        return;
+    UA_STACKARRAY(UA_String, names, pds->fieldSize);
+    size_t i = 0;
+    UA_DataSetField *dsf;
+    TAILQ_FOREACH(dsf, &pds->fields, listEntry) {
+        names[i++] = dsf->config.field.variable.fieldNameAlias;
+    }
+    UA_StatusCode res =
+        UA_NetworkMessage_encodeJsonFieldKeys(names, pds->fieldSize,
+                                              &dsw->jsonFieldKeys);
+    if(res == UA_STATUSCODE_GOOD)
+        dsw->jsonFieldKeysSize = pds->fieldSize;
+}
+#endif
+
 static void
 UA_DataSetWriter_freezeConfiguration(UA_DataSetWriter *dsw) {
     if(dsw->configurationFrozen)
@@ -66,6 +88,10 @@ UA_DataSetWriter_freezeConfiguration(UA_DataSetWriter *dsw) {
     if(!pds) /* Skip for heartbeat writers */
         return;
     pds->configurationFreezeCounter++;
+#ifdef UA_ENABLE_JSON_ENCODING
+    if(dsw->linkedWriterGroup->config.encodingMimeType == UA_PUBSUB_ENCODING_JSON)
+        prepareJsonFieldKeys(dsw, pds);
+#endif
 }
 
 static void
@@ -73,6 +99,10 @@ UA_DataSetWriter_unfreezeConfiguration(UA_DataSetWriter *dsw) {
     if(!dsw->configurationFrozen)
         return;
     dsw->configurationFrozen = false;
+    UA_Array_delete(dsw->jsonFieldKeys, dsw->jsonFieldKeysSize,
+                    &UA_TYPES[UA_TYPES_STRING]);
+    dsw->jsonFieldKeys = NULL;
+    dsw->jsonFieldKeysSize = 0;
     UA_PublishedDataSet *pds = dsw->connectedDataSet;
     if(!pds) /* Skip for heartbeat writers */
         return;
@@ -134,6 +164,34 @@ UA_DataSetWriter_setPubSubState(UA_PubSubManager *psm, UA_DataSetWriter *dsw,
     return res;
 }
 
+/* (Re)initialize the store of the last sent values for deltaframes */
+static void
+clearLastSamples(UA_DataSetWriter *dsw) {
+    for(size_t i = 0; i < dsw->lastSamplesCount; i++)
+        UA_DataValue_clear(&dsw->lastSamples[i]);
+    UA_free(dsw->lastSamples);
+    UA_free(dsw->changedFields);
+    dsw->lastSamples = NULL;
+    dsw->changedFields = NULL;
+    dsw->lastSamplesCount = 0;
+}
+
+static UA_StatusCode
+initLastSamples(UA_DataSetWriter *dsw, size_t fieldSize) {
+    clearLastSamples(dsw);
+    if(fieldSize == 0)
+        return UA_STATUSCODE_GOOD;
+    dsw->lastSamples = (UA_DataValue*)UA_calloc(fieldSize, sizeof(UA_DataValue));
+    dsw->changedFields = (UA_UInt32*)
+        UA_calloc((fieldSize + 31) / 32, sizeof(UA_UInt32));
+    if(!dsw->lastSamples || !dsw->changedFields) {
+        clearLastSamples(dsw);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    dsw->lastSamplesCount = fieldSize;
+    return UA_STATUSCODE_GOOD;
+}
+
 UA_StatusCode
 UA_DataSetWriter_create(UA_PubSubManager *psm,
                         const UA_NodeId writerGroup, const UA_NodeId dataSet,
@@ -205,20 +263,12 @@ UA_DataSetWriter_create(UA_PubSubManager *psm,
         dsw->connectedDataSetVersion = pds->dataSetMetaData.configurationVersion;
 
         if(psm->sc.server->config.pubSubConfig.enableDeltaFrames) {
-            /* Initialize the queue for the last values */
-            if(pds->fieldSize > 0) {
-                dsw->lastSamples = (UA_DataSetWriterSample*)
-                    UA_calloc(pds->fieldSize, sizeof(UA_DataSetWriterSample));
-                if(!dsw->lastSamples) {
-                    UA_DataSetWriterConfig_clear(&dsw->config);
-                    UA_free(dsw);
-                    return UA_STATUSCODE_BADOUTOFMEMORY;
-                }
-                dsw->lastSamplesCount = pds->fieldSize;
-                for(size_t i = 0; i < dsw->lastSamplesCount; i++) {
-                    UA_DataValue_init(&dsw->lastSamples[i].value);
-                    dsw->lastSamples[i].valueChanged = false;
-                }
+            /* Initialize the store for the last values */
+            res = initLastSamples(dsw, pds->fieldSize);
+            if(res != UA_STATUSCODE_GOOD) {
+                UA_DataSetWriterConfig_clear(&dsw->config);
+                UA_free(dsw);
+                return res;
             }
         }
         /* Connect PublishedDataSet with DataSetWriter */
@@ -303,7 +353,14 @@ UA_DataSetWriter_prepareDataSet(UA_PubSubManager *psm, UA_DataSetWriter *dsw,
         }
         UA_NODESTORE_RELEASE(psm->sc.server, (const UA_Node *)rtNode);
 
-        /* TODO: Get the External Value Source from the node instead of from the config */
+        /* The values are encoded from the external value source of the node
+         * or from the static value source */
+        if(!UA_PubSubDataSetField_getRTValueSource(psm, dsf)) {
+            UA_LOG_ERROR_PUBSUB(psm->logging, dsw,
+                                "PubSub-RT configuration fail: PDS published-variable "
+                                "does not have an external data source");
+            return UA_STATUSCODE_BADNOTSUPPORTED;
+        }
 
         /* If direct-value-access is enabled, the pointers need to be set */
         if(wg->config.rtLevel & UA_PUBSUB_RT_DIRECT_VALUE_ACCESS &&
@@ -380,15 +437,8 @@ UA_DataSetWriter_remove(UA_PubSubManager *psm, UA_DataSetWriter *dsw) {
 
     UA_LOG_INFO_PUBSUB(psm->logging, dsw, "Writer deleted");
 
-    if(psm->sc.server->config.pubSubConfig.enableDeltaFrames) {
-        /* Delete lastSamples store */
-        for(size_t i = 0; i < dsw->lastSamplesCount; i++) {
-            UA_DataValue_clear(&dsw->lastSamples[i].value);
-        }
-        UA_free(dsw->lastSamples);
-        dsw->lastSamples = NULL;
-        dsw->lastSamplesCount = 0;
-    }
+    /* Delete lastSamples store */
+    clearLastSamples(dsw);
 
     UA_DataSetWriterConfig_clear(&dsw->config);
     UA_PubSubComponentHead_clear(&dsw->head);
@@ -401,57 +451,54 @@ UA_DataSetWriter_remove(UA_PubSubManager *psm, UA_DataSetWriter *dsw) {
 /*               PublishValues handling                  */
 /*********************************************************/
 
-/* Compare two variants. Internally used for value change detection. */
-static UA_Boolean
-valueChangedVariant(UA_Variant *oldValue, UA_Variant *newValue) {
-    if(!oldValue || !newValue)
-        return false;
-
-    size_t oldValueEncodingSize = UA_calcSizeBinary(oldValue, &UA_TYPES[UA_TYPES_VARIANT]);
-    size_t newValueEncodingSize = UA_calcSizeBinary(newValue, &UA_TYPES[UA_TYPES_VARIANT]);
-    if(oldValueEncodingSize == 0 || newValueEncodingSize == 0)
-        return false;
+static void
+applyFieldContentMask(const UA_DataSetWriter *dsw, UA_DataValue *dv) {
+    u64 mask = (u64)dsw->config.dataSetFieldContentMask;
+    if((mask & (u64)UA_DATASETFIELDCONTENTMASK_STATUSCODE) == 0)
+        dv->hasStatus = false;
+    if((mask & (u64)UA_DATASETFIELDCONTENTMASK_SOURCETIMESTAMP) == 0)
+        dv->hasSourceTimestamp = false;
+    if((mask & (u64)UA_DATASETFIELDCONTENTMASK_SOURCEPICOSECONDS) == 0)
+        dv->hasSourcePicoseconds = false;
+    if((mask & (u64)UA_DATASETFIELDCONTENTMASK_SERVERTIMESTAMP) == 0)
+        dv->hasServerTimestamp = false;
+    if((mask & (u64)UA_DATASETFIELDCONTENTMASK_SERVERPICOSECONDS) == 0)
+        dv->hasServerPicoseconds = false;
+}
 
-    if(oldValueEncodingSize != newValueEncodingSize)
-        return true;
+/* Sample all fields and compare with the last sent values. Changed fields
+ * replace the last sample and are marked in the bitset. Only the value and the
+ * (unmasked) status are compared. Timestamps change with every sample and do
+ * not justify sending a field. Returns the number of changed fields. */
+static size_t
+sampleChangedFields(UA_PubSubManager *psm, UA_DataSetWriter *dsw) {
+    size_t changed = 0;
+    size_t i = 0;
+    UA_DataSetField *dsf;
+    TAILQ_FOREACH(dsf, &dsw->connectedDataSet->fields, listEntry) {
+        if(i >= dsw->lastSamplesCount)
+            break;
 
-    UA_ByteString oldValueEncoding = UA_BYTESTRING_NULL;
-    UA_StatusCode res = UA_ByteString_allocBuffer(&oldValueEncoding, oldValueEncodingSize);
-    if(res != UA_STATUSCODE_GOOD)
-        return false;
+        UA_DataValue value;
+        UA_DataValue_init(&value);
+        UA_PubSubDataSetField_sampleValue(psm, dsf, &value);
+        applyFieldContentMask(dsw, &value);
 
-    UA_ByteString newValueEncoding = UA_BYTESTRING_NULL;
-    res = UA_ByteString_allocBuffer(&newValueEncoding, newValueEncodingSize);
-    if(res != UA_STATUSCODE_GOOD) {
-        UA_ByteString_clear(&oldValueEncoding);
-        return false;
+        UA_DataValue *ls = &dsw->lastSamples[i];
+        if(ls->hasStatus == value.hasStatus &&
+           (!value.hasStatus || ls->status == value.status) &&
+           UA_order(&ls->value, &value.value,
+                    &UA_TYPES[UA_TYPES_VARIANT]) == UA_ORDER_EQ) {
+            UA_DataValue_clear(&value);
+        } else {
+            UA_DataValue_clear(ls);
+            *ls = value; /* move */
+            dsw->changedFields[i >> 5] |= (UA_UInt32)1 << (i & 31);
+            changed++;
+        }
+        i++;
     }
-
-    UA_Byte *bufPosOldValue = oldValueEncoding.data;
-    const UA_Byte *bufEndOldValue = &oldValueEncoding.data[oldValueEncoding.length];
-    UA_Byte *bufPosNewValue = newValueEncoding.data;
-    const UA_Byte *bufEndNewValue = &newValueEncoding.data[newValueEncoding.length];
-
-    UA_Boolean compareResult = false; /* default */
-
-    res = UA_encodeBinaryInternal(oldValue, &UA_TYPES[UA_TYPES_VARIANT],
-                                  &bufPosOldValue, &bufEndOldValue, NULL, NULL);
-    if(res != UA_STATUSCODE_GOOD)
-        goto cleanup;
-
-    res = UA_encodeBinaryInternal(newValue, &UA_TYPES[UA_TYPES_VARIANT],
-                                  &bufPosNewValue, &bufEndNewValue, NULL, NULL);
-    if(res != UA_STATUSCODE_GOOD)
-        goto cleanup;
-
-    oldValueEncoding.length = (uintptr_t)bufPosOldValue - (uintptr_t)oldValueEncoding.data;
-    newValueEncoding.length = (uintptr_t)bufPosNewValue - (uintptr_t)newValueEncoding.data;
-    compareResult = !UA_ByteString_equal(&oldValueEncoding, &newValueEncoding);
-
- cleanup:
-    UA_ByteString_clear(&oldValueEncoding);
-    UA_ByteString_clear(&newValueEncoding);
-    return compareResult;
+    return changed;
 }
 
 static UA_StatusCode
@@ -473,11 +520,17 @@ UA_PubSubDataSetWriter_generateKeyFrameMessage(UA_PubSubManager *psm,
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
 #ifdef UA_ENABLE_JSON_ENCODING
-    dataSetMessage->data.keyFrameData.fieldNames = (UA_String *)
-        UA_Array_new(pds->fieldSize, &UA_TYPES[UA_TYPES_STRING]);
-    if(!dataSetMessage->data.keyFrameData.fieldNames) {
-        UA_DataSetMessage_clear(dataSetMessage);
-        return UA_STATUSCODE_BADOUTOFMEMORY;
+    /* Copy the field names only if no prepared JSON keys are available */
+    UA_Boolean copyNames =
+        (dsw->linkedWriterGroup->config.encodingMimeType == UA_PUBSUB_ENCODING_JSON &&
+         dsw->jsonFieldKeysSize != pds->fieldSize);
+    if(copyNames) {
+        dataSetMessage->data.keyFrameData.fieldNames = (UA_String *)
+            UA_Array_new(pds->fieldSize, &UA_TYPES[UA_TYPES_STRING]);
+        if(!dataSetMessage->data.keyFrameData.fieldNames) {
+            UA_DataSetMessage_clear(dataSetMessage);
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        }
     }
 #endif
 
@@ -487,45 +540,32 @@ UA_PubSubDataSetWriter_generateKeyFrameMessage(UA_PubSubManager *psm,
     TAILQ_FOREACH(dsf, &pds->fields, listEntry) {
 #ifdef UA_ENABLE_JSON_ENCODING
         /* Set the field name alias */
-        UA_String_copy(&dsf->config.field.variable.fieldNameAlias,
-                       &dataSetMessage->data.keyFrameData.fieldNames[counter]);
+        if(copyNames)
+            UA_String_copy(&dsf->config.field.variable.fieldNameAlias,
+                           &dataSetMessage->data.keyFrameData.fieldNames[counter]);
 #endif
 
         /* Sample the value */
         UA_DataValue *dfv = &dataSetMessage->data.keyFrameData.dataSetFields[counter];
         UA_PubSubDataSetField_sampleValue(psm, dsf, dfv);
 
-        /* Deactivate statuscode? */
-        if(((u64)dsw->config.dataSetFieldContentMask &
-            (u64)UA_DATASETFIELDCONTENTMASK_STATUSCODE) == 0)
-            dfv->hasStatus = false;
-
-        /* Deactivate timestamps */
-        if(((u64)dsw->config.dataSetFieldContentMask &
-            (u64)UA_DATASETFIELDCONTENTMASK_SOURCETIMESTAMP) == 0)
-            dfv->hasSourceTimestamp = false;
-        if(((u64)dsw->config.dataSetFieldContentMask &
-            (u64)UA_DATASETFIELDCONTENTMASK_SOURCEPICOSECONDS) == 0)
-            dfv->hasSourcePicoseconds = false;
-        if(((u64)dsw->config.dataSetFieldContentMask &
-            (u64)UA_DATASETFIELDCONTENTMASK_SERVERTIMESTAMP) == 0)
-            dfv->hasServerTimestamp = false;
-        if(((u64)dsw->config.dataSetFieldContentMask &
-            (u64)UA_DATASETFIELDCONTENTMASK_SERVERPICOSECONDS) == 0)
-            dfv->hasServerPicoseconds = false;
+        /* Deactivate statuscode and timestamps */
+        applyFieldContentMask(dsw, dfv);
 
-        if(psm->sc.server->config.pubSubConfig.enableDeltaFrames) {
-            /* Update lastValue store */
-            UA_DataValue_clear(&dsw->lastSamples[counter].value);
-            UA_DataValue_copy(dfv, &dsw->lastSamples[counter].value);
+        /* Update lastValue store */
+        if(counter < dsw->lastSamplesCount) {
+            UA_DataValue_clear(&dsw->lastSamples[counter]);
+            UA_DataValue_copy(dfv, &dsw->lastSamples[counter]);
         }
         counter++;
     }
     return UA_STATUSCODE_GOOD;
 }
 
-/* the input message is already initialized and that the method 
- * must not be called twice for the same message */
+/* The input message is already initialized and the method must not be called
+ * twice for the same message. If all fields have changed, a KeyFrame is
+ * generated instead. It is smaller than a DeltaFrame with all fields (no field
+ * indices) and restarts the KeyFrame interval. */
 static UA_StatusCode
 UA_PubSubDataSetWriter_generateDeltaFrameMessage(UA_PubSubManager *psm,
                                                  UA_DataSetMessage *dsm,
@@ -537,79 +577,51 @@ UA_PubSubDataSetWriter_generateDeltaFrameMessage(UA_PubSubManager *psm,
     /* Prepare DataSetMessageContent */
     dsm->header.dataSetMessageValid = true;
     dsm->header.dataSetMessageType = UA_DATASETMESSAGE_DATADELTAFRAME;
-    if(pds->fieldSize == 0)
-        return UA_STATUSCODE_GOOD;
 
-    UA_DataSetField *dsf;
-    UA_UInt16 counter = 0;
-    TAILQ_FOREACH(dsf, &pds->fields, listEntry) {
-        /* Sample the value */
-        UA_DataValue value;
-        UA_DataValue_init(&value);
-        UA_PubSubDataSetField_sampleValue(psm, dsf, &value);
-
-        /* Check if the value has changed */
-        UA_DataSetWriterSample *ls = &dsw->lastSamples[counter];
-        if(valueChangedVariant(&ls->value.value, &value.value)) {
-            /* increase fieldCount for current delta message */
-            dsm->data.deltaFrameData.fieldCount++;
-            ls->valueChanged = true;
-
-            /* Update last stored sample */
-            UA_DataValue_clear(&ls->value);
-            ls->value = value;
-        } else {
-            UA_DataValue_clear(&value);
-            ls->valueChanged = false;
-        }
+    /* Sample and mark the changed fields */
+    size_t changed = sampleChangedFields(psm, dsw);
+    if(changed == 0)
+        return UA_STATUSCODE_GOOD;
 
-        counter++;
+    size_t words = (dsw->lastSamplesCount + 31) / 32;
+    if(changed == pds->fieldSize) {
+        memset(dsw->changedFields, 0, words * sizeof(UA_UInt32));
+        dsm->header.dataSetMessageType = UA_DATASETMESSAGE_DATAKEYFRAME;
+        dsm->data.keyFrameData.dataSetMetaDataType = &pds->dataSetMetaData;
+        UA_StatusCode res =
+            UA_Array_copy(dsw->lastSamples, dsw->lastSamplesCount,
+                          (void**)&dsm->data.keyFrameData.dataSetFields,
+                          &UA_TYPES[UA_TYPES_DATAVALUE]);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+        dsm->data.keyFrameData.fieldCount = (UA_UInt16)dsw->lastSamplesCount;
+        return UA_STATUSCODE_GOOD;
     }
 
     /* Allocate DeltaFrameFields */
     UA_DataSetMessage_DeltaFrameField *deltaFields = (UA_DataSetMessage_DeltaFrameField *)
-        UA_calloc(counter, sizeof(UA_DataSetMessage_DeltaFrameField));
+        UA_calloc(changed, sizeof(UA_DataSetMessage_DeltaFrameField));
     if(!deltaFields)
         return UA_STATUSCODE_BADOUTOFMEMORY;
-
     dsm->data.deltaFrameData.deltaFrameFields = deltaFields;
-    dsm->data.deltaFrameData.fieldCount = counter;
-
-    size_t currentDeltaField = 0;
-    for(size_t i = 0; i < pds->fieldSize; i++) {
-        if(!dsw->lastSamples[i].valueChanged)
-            continue;
-
-        UA_DataSetMessage_DeltaFrameField *dff = &deltaFields[currentDeltaField];
-
-        dff->fieldIndex = (UA_UInt16) i;
-        UA_DataValue_copy(&dsw->lastSamples[i].value, &dff->fieldValue);
-
-        /* Reset the changed flag */
-        dsw->lastSamples[i].valueChanged = false;
-
-        /* Deactivate statuscode? */
-        if(((u64)dsw->config.dataSetFieldContentMask &
-            (u64)UA_DATASETFIELDCONTENTMASK_STATUSCODE) == 0)
-            dff->fieldValue.hasStatus = false;
-
-        /* Deactivate timestamps? */
-        if(((u64)dsw->config.dataSetFieldContentMask &
-            (u64)UA_DATASETFIELDCONTENTMASK_SOURCETIMESTAMP) == 0)
-            dff->fieldValue.hasSourceTimestamp = false;
-        if(((u64)dsw->config.dataSetFieldContentMask &
-            (u64)UA_DATASETFIELDCONTENTMASK_SOURCEPICOSECONDS) == 0)
-            dff->fieldValue.hasServerPicoseconds = false;
-        if(((u64)dsw->config.dataSetFieldContentMask &
-            (u64)UA_DATASETFIELDCONTENTMASK_SERVERTIMESTAMP) == 0)
-            dff->fieldValue.hasServerTimestamp = false;
-        if(((u64)dsw->config.dataSetFieldContentMask &
-            (u64)UA_DATASETFIELDCONTENTMASK_SERVERPICOSECONDS) == 0)
-            dff->fieldValue.hasServerPicoseconds = false;
-
-        currentDeltaField++;
+    dsm->data.deltaFrameData.fieldCount = (UA_UInt16)changed;
+
+    /* Collect the changed fields from the bitset. Unchanged ranges of 32
+     * fields are skipped with a single comparison. */
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    size_t pos = 0;
+    for(size_t w = 0; w < words; w++) {
+        UA_UInt32 bits = dsw->changedFields[w];
+        dsw->changedFields[w] = 0;
+        for(size_t i = w * 32; bits != 0; i++, bits >>= 1) {
+            if(!(bits & 1))
+                continue;
+            UA_DataSetMessage_DeltaFrameField *dff = &deltaFields[pos++];
+            dff->fieldIndex = (UA_UInt16)i;
+            res |= UA_DataValue_copy(&dsw->lastSamples[i], &dff->fieldValue);
+        }
     }
-    return UA_STATUSCODE_GOOD;
+    return res;
 }
 
 /* Generate a DataSetMessage for the given writer. */
@@ -788,20 +800,10 @@ UA_DataSetWriter_generateDataSetMessage(UA_PubSubManager *psm,
            pds->dataSetMetaData.configurationVersion.majorVersion ||
            dsw->connectedDataSetVersion.minorVersion !=
            pds->dataSetMetaData.configurationVersion.minorVersion) {
-            /* Remove old samples */
-            for(size_t i = 0; i < dsw->lastSamplesCount; i++)
-                UA_DataValue_clear(&dsw->lastSamples[i].value);
-
-            /* Realloc PDS dependent memory */
-            dsw->lastSamplesCount = pds->fieldSize;
-            UA_DataSetWriterSample *newSamplesArray = (UA_DataSetWriterSample * )
-                UA_realloc(dsw->lastSamples,
-                           sizeof(UA_DataSetWriterSample) * dsw->lastSamplesCount);
-            if(!newSamplesArray)
-                return UA_STATUSCODE_BADOUTOFMEMORY;
-            dsw->lastSamples = newSamplesArray;
-            memset(dsw->lastSamples, 0,
-                   sizeof(UA_DataSetWriterSample) * dsw->lastSamplesCount);
+            /* Reallocate PDS dependent memory */
+            UA_StatusCode res = initLastSamples(dsw, pds->fieldSize);
+            if(res != UA_STATUSCODE_GOOD)
+                return res;
 
             dsw->connectedDataSetVersion =
                 pds->dataSetMetaData.configurationVersion;
@@ -812,12 +814,19 @@ UA_DataSetWriter_generateDataSetMessage(UA_PubSubManager *psm,
 
         /* The standard defines: if a PDS contains only one fields no delta messages
          * should be generated because they need more memory than a keyframe with 1
-         * field. */
-        if(pds->fieldSize > 1 && dsw->deltaFrameCounter > 0 &&
-           dsw->deltaFrameCounter <= dsw->config.keyFrameCount) {
-            UA_PubSubDataSetWriter_generateDeltaFrameMessage(psm, dataSetMessage, dsw);
-            dsw->deltaFrameCounter++;
-            return UA_STATUSCODE_GOOD;
+         * field. The KeyFrameCount is the number of messages per KeyFrame
+         * interval (including the KeyFrame). So 1 means KeyFrames only. */
+        if(pds->fieldSize > 1 && pds->fieldSize == dsw->lastSamplesCount &&
+           dsw->deltaFrameCounter > 0 &&
+           dsw->deltaFrameCounter < dsw->config.keyFrameCount) {
+            UA_StatusCode res =
+                UA_PubSubDataSetWriter_generateDeltaFrameMessage(psm, dataSetMessage, dsw);
+            if(dataSetMessage->header.dataSetMessageType ==
+               UA_DATASETMESSAGE_DATAKEYFRAME)
+                dsw->deltaFrameCounter = 1; /* Restart the interval */
+            else
+                dsw->deltaFrameCounter++;
+            return res;
         }
 
         dsw->deltaFrameCounter = 1;
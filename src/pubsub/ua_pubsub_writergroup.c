@@ -25,9 +25,9 @@
 #define UA_MAX_STACKBUF 128 /* Max size of network messages on the stack */
 
 static UA_StatusCode
-encryptAndSign(UA_WriterGroup *wg, const UA_NetworkMessage *nm,
-               UA_Byte *signStart, UA_Byte *encryptStart,
-               UA_Byte *msgEnd);
+encryptAndSign(UA_PubSubManager *psm, UA_WriterGroup *wg,
+               const UA_NetworkMessage *nm, UA_Byte *signStart,
+               UA_Byte *encryptStart, UA_Byte *msgEnd);
 
 static UA_StatusCode
 generateNetworkMessage(UA_PubSubConnection *connection, UA_WriterGroup *wg,
@@ -65,7 +65,9 @@ UA_WriterGroup_publishCallback_server(UA_Server *server, UA_WriterGroup *wg) {
                               "Cannot publish -- PubSub not configured for the server");
         return;
     }
+    UA_MemoryCategory mc = UA_MemoryCategory_enter(UA_MEMORYCATEGORY_PUBSUB);
     UA_WriterGroup_publishCallback(psm, wg);
+    UA_MemoryCategory_leave(mc);
 }
 
 UA_StatusCode
@@ -76,6 +78,17 @@ UA_WriterGroup_addPublishCallback(UA_PubSubManager *psm, UA_WriterGroup *wg) {
     if(wg->publishCallbackId != 0)
         return UA_STATUSCODE_GOOD;
 
+    /* With a transmit time offset, the publish cycles are aligned to multiples
+     * of the publishingInterval on the monotonic clock. The timestamps of the
+     * monotonic clock are offset by the unix epoch. */
+    UA_DateTime baseTime = UA_DATETIME_UNIX_EPOCH;
+    UA_DateTime *bt = NULL;
+    UA_TimerPolicy policy = UA_TIMERPOLICY_CURRENTTIME;
+    if(wg->config.transmitTimeOffset > 0.0) {
+        bt = &baseTime;
+        policy = UA_TIMERPOLICY_BASETIME;
+    }
+
     UA_StatusCode retval = UA_STATUSCODE_GOOD;
     if(wg->config.pubsubManagerCallback.addCustomCallback) {
         /* Use configured mechanism for cyclic callbacks */
@@ -83,16 +96,13 @@ UA_WriterGroup_addPublishCallback(UA_PubSubManager *psm, UA_WriterGroup *wg) {
             addCustomCallback(psm->sc.server, wg->head.identifier,
                               (UA_ServerCallback)UA_WriterGroup_publishCallback_server,
                               wg, wg->config.publishingInterval,
-                              NULL, UA_TIMERPOLICY_CURRENTTIME,
-                              &wg->publishCallbackId);
+                              bt, policy, &wg->publishCallbackId);
     } else {
         /* Use EventLoop for cyclic callbacks */
         UA_EventLoop *el = UA_PubSubConnection_getEL(psm, wg->linkedConnection);
         retval = el->addTimer(el, (UA_Callback)UA_WriterGroup_publishCallback,
                               psm, wg, wg->config.publishingInterval,
-                              NULL /* TODO: use basetime */,
-                              UA_TIMERPOLICY_CURRENTTIME,
-                              &wg->publishCallbackId);
+                              bt, policy, &wg->publishCallbackId);
     }
 
     return retval;
@@ -110,6 +120,8 @@ UA_WriterGroup_removePublishCallback(UA_PubSubManager *psm, UA_WriterGroup *wg)
         el->removeTimer(el, wg->publishCallbackId);
     }
     wg->publishCallbackId = 0;
+    wg->cycleStats.lastCycle = 0;
+    wg->cycleStats.lastInterval = 0;
 }
 
 UA_StatusCode
@@ -142,6 +154,12 @@ UA_WriterGroup_create(UA_PubSubManager *psm, const UA_NodeId connection,
         }
     }
 
+    /* The transmit time has to be within the publishing cycle */
+    if(writerGroupConfig->transmitTimeOffset < 0.0 ||
+       (writerGroupConfig->transmitTimeOffset > 0.0 &&
+        writerGroupConfig->transmitTimeOffset >= writerGroupConfig->publishingInterval))
+        return UA_STATUSCODE_BADCONFIGURATIONERROR;
+
     /* Allocate new WriterGroup */
     UA_WriterGroup *newWriterGroup = (UA_WriterGroup*)UA_calloc(1, sizeof(UA_WriterGroup));
     if(!newWriterGroup)
@@ -266,6 +284,10 @@ UA_WriterGroup_remove(UA_PubSubManager *psm, UA_WriterGroup *wg) {
         wg->config.securityPolicy->deleteContext(wg->securityPolicyContext);
         wg->securityPolicyContext = NULL;
     }
+    if(wg->config.securityPolicy && wg->nextSecurityPolicyContext) {
+        wg->config.securityPolicy->deleteContext(wg->nextSecurityPolicyContext);
+        wg->nextSecurityPolicyContext = NULL;
+    }
 
 #ifdef UA_ENABLE_PUBSUB_SKS
     if(wg->keyStorage) {
@@ -297,6 +319,40 @@ UA_WriterGroup_remove(UA_PubSubManager *psm, UA_WriterGroup *wg) {
     UA_PubSubConnection_setPubSubState(psm, connection, connection->head.state);
 }
 
+/* Let the offset of a payload field point to the external value source of the
+ * DataSetField. The values are encoded from there in every publish cycle. So
+ * no sampling (and no Read) is needed. */
+static UA_StatusCode
+setExternalValueSource(UA_PubSubManager *psm, UA_WriterGroup *wg,
+                       UA_DataSetField *dsf, UA_NetworkMessageOffset *nmo) {
+    /* Direct value access uses the static value source. Otherwise resolve the
+     * external value of the published node. */
+    UA_DataValue **source = (wg->config.rtLevel & UA_PUBSUB_RT_DIRECT_VALUE_ACCESS) ?
+        dsf->config.field.variable.rtValueSource.staticValueSource :
+        UA_PubSubDataSetField_getRTValueSource(psm, dsf);
+    if(!source) {
+        UA_LOG_WARNING_PUBSUB(psm->logging, wg,
+                              "PubSub-RT configuration fail: PDS contains "
+                              "field without external data source.");
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+    }
+
+    /* Set the external value soure in the offset buffer */
+    UA_DataValue_clear(&nmo->content.value);
+    nmo->content.externalValue = source;
+
+    /* Update the content type to _EXTERNAL */
+    nmo->contentType = (UA_NetworkMessageOffsetType)(nmo->contentType + 1);
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_Boolean
+isPayloadOffset(UA_NetworkMessageOffsetType contentType) {
+    return (contentType == UA_PUBSUB_OFFSETTYPE_PAYLOAD_DATAVALUE ||
+            contentType == UA_PUBSUB_OFFSETTYPE_PAYLOAD_VARIANT ||
+            contentType == UA_PUBSUB_OFFSETTYPE_PAYLOAD_RAW);
+}
+
 static UA_StatusCode
 UA_WriterGroup_freezeConfiguration(UA_PubSubManager *psm, UA_WriterGroup *wg) {
     UA_LOCK_ASSERT(&psm->sc.server->serviceMutex);
@@ -307,6 +363,20 @@ UA_WriterGroup_freezeConfiguration(UA_PubSubManager *psm, UA_WriterGroup *wg) {
     /* Freeze the WriterGroup */
     wg->configurationFrozen = true;
 
+#ifdef UA_ENABLE_JSON_ENCODING
+    /* Prepare the constant JSON NetworkMessage header. Fall back to encoding
+     * the header for every message if this fails. */
+    if(wg->config.encodingMimeType == UA_PUBSUB_ENCODING_JSON) {
+        UA_NetworkMessage nm;
+        memset(&nm, 0, sizeof(UA_NetworkMessage));
+        nm.version = 1;
+        nm.networkMessageType = UA_NETWORKMESSAGE_DATASET;
+        nm.publisherIdEnabled = true;
+        nm.publisherId = wg->linkedConnection->config.publisherId;
+        UA_NetworkMessage_encodeJsonHeader(&nm, &wg->jsonHeader);
+    }
+#endif
+
     /* Offset table enabled? */
     if((wg->config.rtLevel & UA_PUBSUB_RT_FIXED_SIZE) == 0)
         return UA_STATUSCODE_GOOD;
@@ -380,46 +450,32 @@ UA_WriterGroup_freezeConfiguration(UA_PubSubManager *psm, UA_WriterGroup *wg) {
         wg->bufferedMessage.payloadPosition = payloadPosition;
         wg->bufferedMessage.nm = (UA_NetworkMessage *)UA_calloc(1,sizeof(UA_NetworkMessage));
         wg->bufferedMessage.nm->securityHeader = networkMessage.securityHeader;
-        UA_ByteString_allocBuffer(&wg->bufferedMessage.encryptBuffer, msgSize);
     }
 
     if(wg->config.securityMode <= UA_MESSAGESECURITYMODE_NONE)
         UA_NetworkMessage_encodeBinaryWithEncryptStart(&networkMessage, &bufPos, bufEnd, NULL);
 
-    /* Post-processing of the OffsetBuffer to set the external data source from
-     * the DataSetField configuration */
-    if(wg->config.rtLevel & UA_PUBSUB_RT_DIRECT_VALUE_ACCESS) {
-        size_t fieldPos = 0;
-        LIST_FOREACH(dsw, &wg->writers, listEntry) {
-            UA_PublishedDataSet *pds = dsw->connectedDataSet;
-            if(!pds)
-                continue;
-
-            /* Loop over all DataSetFields */
-            UA_DataSetField *dsf;
-            TAILQ_FOREACH(dsf, &pds->fields, listEntry) {
-                UA_NetworkMessageOffsetType contentType;
-                /* Move forward to the next payload-type offset field */
-                do {
-                    fieldPos++;
-                    contentType = wg->bufferedMessage.offsets[fieldPos].contentType;
-                } while(contentType != UA_PUBSUB_OFFSETTYPE_PAYLOAD_DATAVALUE &&
-                        contentType != UA_PUBSUB_OFFSETTYPE_PAYLOAD_VARIANT &&
-                        contentType != UA_PUBSUB_OFFSETTYPE_PAYLOAD_RAW);
-                UA_assert(fieldPos < wg->bufferedMessage.offsetsSize);
-
-                if(!dsf->config.field.variable.rtValueSource.rtFieldSourceEnabled)
-                    continue;
-
-                /* Set the external value soure in the offset buffer */
-                UA_DataValue_clear(&wg->bufferedMessage.offsets[fieldPos].content.value);
-                wg->bufferedMessage.offsets[fieldPos].content.externalValue =
-                    dsf->config.field.variable.rtValueSource.staticValueSource;
-
-                /* Update the content type to _EXTERNAL */
-                wg->bufferedMessage.offsets[fieldPos].contentType =
-                    (UA_NetworkMessageOffsetType)(contentType + 1);
-            }
+    /* Post-processing of the OffsetBuffer to set the external data source of
+     * every DataSetField. The values are encoded from there in every publish
+     * cycle. So no sampling (and no Read) is needed. */
+    size_t fieldPos = 0;
+    LIST_FOREACH(dsw, &wg->writers, listEntry) {
+        UA_PublishedDataSet *pds = dsw->connectedDataSet;
+        if(!pds)
+            continue;
+
+        /* Loop over all DataSetFields */
+        UA_DataSetField *dsf;
+        TAILQ_FOREACH(dsf, &pds->fields, listEntry) {
+            /* Move forward to the next payload-type offset field */
+            do {
+                fieldPos++;
+            } while(!isPayloadOffset(wg->bufferedMessage.offsets[fieldPos].contentType));
+            UA_assert(fieldPos < wg->bufferedMessage.offsetsSize);
+            res = setExternalValueSource(psm, wg, dsf,
+                                         &wg->bufferedMessage.offsets[fieldPos]);
+            if(res != UA_STATUSCODE_GOOD)
+                goto cleanup;
         }
     }
 
@@ -440,6 +496,183 @@ UA_WriterGroup_unfreezeConfiguration(UA_PubSubManager *psm, UA_WriterGroup *wg)
         return;
     wg->configurationFrozen = false;
     UA_NetworkMessageOffsetBuffer_clear(&wg->bufferedMessage);
+    UA_String_clear(&wg->jsonHeader);
+    wg->jsonSizeHint = 0;
+}
+
+UA_StatusCode
+UA_WriterGroup_updateDataSetWriterOffsets(UA_PubSubManager *psm, UA_WriterGroup *wg,
+                                          UA_DataSetWriter *dsw) {
+    UA_LOCK_ASSERT(&psm->sc.server->serviceMutex);
+
+    UA_NetworkMessageOffsetBuffer *old = &wg->bufferedMessage;
+    if(!wg->configurationFrozen || old->offsetsSize == 0)
+        return UA_STATUSCODE_BADINVALIDSTATE;
+
+    /* Position of the DataSetMessage in the NetworkMessage */
+    size_t dsmIndex = 0;
+    UA_DataSetWriter *tmp;
+    LIST_FOREACH(tmp, &wg->writers, listEntry) {
+        if(tmp == dsw)
+            break;
+        dsmIndex++;
+    }
+    if(!tmp)
+        return UA_STATUSCODE_BADNOTFOUND;
+
+    /* Every DataSetMessage starts with a FieldEncoding offset. Find the byte
+     * range and the range in the offset table of the old DataSetMessage. */
+    size_t dsmCount = 0;
+    size_t firstDsm = 0, oStart = 0, oEnd = old->offsetsSize;
+    for(size_t i = 0; i < old->offsetsSize; i++) {
+        if(old->offsets[i].contentType != UA_PUBSUB_OFFSETTYPE_NETWORKMESSAGE_FIELDENCDODING)
+            continue;
+        if(dsmCount == 0)
+            firstDsm = i;
+        if(dsmCount == dsmIndex)
+            oStart = i;
+        else if(dsmCount == dsmIndex + 1)
+            oEnd = i;
+        dsmCount++;
+    }
+    if(dsmIndex >= dsmCount)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    /* The signature and security footer follow the last DataSetMessage */
+    size_t tail = 0;
+    if(wg->config.securityMode > UA_MESSAGESECURITYMODE_NONE) {
+        UA_PubSubSecurityPolicy *sp = wg->config.securityPolicy;
+        tail += sp->symmetricModule.cryptoModule.
+            signatureAlgorithm.getLocalSignatureSize(sp->policyContext);
+        if(old->nm && old->nm->securityHeader.securityFooterEnabled)
+            tail += old->nm->securityHeader.securityFooterSize;
+    }
+    size_t start = old->offsets[oStart].offset;
+    size_t end = (oEnd < old->offsetsSize) ?
+        old->offsets[oEnd].offset : old->buffer.length - tail;
+
+    /* Generate the new DataSetMessage and its offsets relative to the start
+     * of the DataSetMessage */
+    UA_DataSetMessage dsm;
+    UA_StatusCode res = UA_DataSetWriter_prepareDataSet(psm, dsw, &dsm);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    UA_NetworkMessageOffsetBuffer dsmOffsets;
+    memset(&dsmOffsets, 0, sizeof(UA_NetworkMessageOffsetBuffer));
+    UA_NetworkMessageOffsetBuffer nmob;
+    memset(&nmob, 0, sizeof(UA_NetworkMessageOffsetBuffer));
+    size_t dsmSize = UA_DataSetMessage_calcSizeBinary(&dsm, &dsmOffsets, 0);
+    if(dsmSize == 0 || (dsmCount > 1 && dsmSize > UA_UINT16_MAX)) {
+        res = UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+        goto cleanup;
+    }
+
+    /* Splice the new DataSetMessage into a copy of the buffered message */
+    res = UA_ByteString_allocBuffer(&nmob.buffer, old->buffer.length - (end - start) + dsmSize);
+    if(res != UA_STATUSCODE_GOOD)
+        goto cleanup;
+    memcpy(nmob.buffer.data, old->buffer.data, start);
+    UA_Byte *bufPos = &nmob.buffer.data[start];
+    res = UA_DataSetMessage_encodeBinary(&dsm, &bufPos, &nmob.buffer.data[start + dsmSize]);
+    if(res != UA_STATUSCODE_GOOD)
+        goto cleanup;
+    memcpy(&nmob.buffer.data[start + dsmSize], &old->buffer.data[end],
+           old->buffer.length - end);
+
+    /* Update the DataSetMessage size in the payload header */
+    if(dsmCount > 1) {
+        UA_UInt16 sz = (UA_UInt16)dsmSize;
+        bufPos = &nmob.buffer.data[old->offsets[firstDsm].offset -
+                                   (2 * (dsmCount - dsmIndex))];
+        res = UA_UInt16_encodeBinary(&sz, &bufPos, &nmob.buffer.data[nmob.buffer.length]);
+        if(res != UA_STATUSCODE_GOOD)
+            goto cleanup;
+    }
+
+    /* Resolve the external value sources of the new offsets */
+    UA_PublishedDataSet *pds = dsw->connectedDataSet;
+    if(pds) {
+        size_t fieldPos = 0;
+        UA_DataSetField *dsf;
+        TAILQ_FOREACH(dsf, &pds->fields, listEntry) {
+            do {
+                fieldPos++;
+            } while(!isPayloadOffset(dsmOffsets.offsets[fieldPos].contentType));
+            UA_assert(fieldPos < dsmOffsets.offsetsSize);
+            res = setExternalValueSource(psm, wg, dsf, &dsmOffsets.offsets[fieldPos]);
+            if(res != UA_STATUSCODE_GOOD)
+                goto cleanup;
+        }
+    }
+
+    /* Assemble the new offset table. The offsets of the unchanged
+     * DataSetMessages are moved over (with their content). The sequence number
+     * of the DataSetMessage continues from the old value. */
+    nmob.offsetsSize = old->offsetsSize - (oEnd - oStart) + dsmOffsets.offsetsSize;
+    nmob.offsets = (UA_NetworkMessageOffset*)
+        UA_malloc(sizeof(UA_NetworkMessageOffset) * nmob.offsetsSize);
+    if(!nmob.offsets) {
+        res = UA_STATUSCODE_BADOUTOFMEMORY;
+        goto cleanup;
+    }
+    memcpy(nmob.offsets, old->offsets, sizeof(UA_NetworkMessageOffset) * oStart);
+    UA_NetworkMessageOffset *nmo = &nmob.offsets[oStart];
+    for(size_t i = 0; i < dsmOffsets.offsetsSize; i++, nmo++) {
+        *nmo = dsmOffsets.offsets[i];
+        nmo->offset += start;
+        if(nmo->contentType != UA_PUBSUB_OFFSETTYPE_DATASETMESSAGE_SEQUENCENUMBER)
+            continue;
+        for(size_t j = oStart; j < oEnd; j++) {
+            if(old->offsets[j].contentType ==
+               UA_PUBSUB_OFFSETTYPE_DATASETMESSAGE_SEQUENCENUMBER)
+                nmo->content.sequenceNumber = old->offsets[j].content.sequenceNumber;
+        }
+    }
+    for(size_t i = oEnd; i < old->offsetsSize; i++, nmo++) {
+        *nmo = old->offsets[i];
+        nmo->offset = nmo->offset - end + start + dsmSize;
+    }
+
+    /* The NetworkMessage for the encryption and the raw message length (only
+     * used for decoding) are taken over */
+    nmob.nm = old->nm;
+    nmob.rawMessageLength = old->rawMessageLength;
+    if(old->payloadPosition)
+        nmob.payloadPosition = nmob.buffer.data + (old->payloadPosition - old->buffer.data);
+
+    /* Clean up the replaced offsets of the old DataSetMessage. The FieldEncoding
+     * offset points into the (already cleared) DataSetMessage. */
+    for(size_t i = oStart; i < oEnd; i++) {
+        UA_NetworkMessageOffset *o = &old->offsets[i];
+        if(o->contentType == UA_PUBSUB_OFFSETTYPE_NETWORKMESSAGE_FIELDENCDODING)
+            o->content.value.value.data = NULL;
+        if(isPayloadOffset(o->contentType) ||
+           o->contentType == UA_PUBSUB_OFFSETTYPE_NETWORKMESSAGE_FIELDENCDODING)
+            UA_DataValue_clear(&o->content.value);
+    }
+
+    /* Swap in the new buffered message. The publish callback runs with the
+     * same lock and never sees a partially updated offset table. */
+    UA_ByteString_clear(&old->buffer);
+    UA_free(old->offsets);
+    *old = nmob;
+    memset(&nmob, 0, sizeof(UA_NetworkMessageOffsetBuffer));
+    UA_free(dsmOffsets.offsets);
+    dsmOffsets.offsets = NULL;
+    dsmOffsets.offsetsSize = 0;
+
+    UA_LOG_DEBUG_PUBSUB(psm->logging, wg, "Updated the offset table of the "
+                        "DataSetMessage at position %u", (unsigned)dsmIndex);
+
+ cleanup:
+    UA_free(nmob.offsets);
+    nmob.offsets = NULL;
+    nmob.offsetsSize = 0;
+    UA_NetworkMessageOffsetBuffer_clear(&nmob);
+    UA_NetworkMessageOffsetBuffer_clear(&dsmOffsets);
+    UA_DataSetMessage_clear(&dsm);
+    return res;
 }
 
 UA_StatusCode
@@ -497,7 +730,16 @@ UA_WriterGroup_setEncryptionKeys(UA_PubSubManager *psm, UA_WriterGroup *wg,
     }
 
     UA_StatusCode res = UA_STATUSCODE_BAD;
-    if(!wg->securityPolicyContext) {
+    if(wg->nextSecurityPolicyContext && wg->nextSecurityTokenId != 0 &&
+       securityTokenId == wg->nextSecurityTokenId) {
+        /* Swap in the prepared context. The keys are already set. The old
+         * context is kept for the key after that. */
+        void *ctx = wg->securityPolicyContext;
+        wg->securityPolicyContext = wg->nextSecurityPolicyContext;
+        wg->nextSecurityPolicyContext = ctx;
+        wg->nextSecurityTokenId = 0;
+        res = UA_STATUSCODE_GOOD;
+    } else if(!wg->securityPolicyContext) {
         /* Create a new context */
         res = wg->config.securityPolicy->
             newContext(wg->config.securityPolicy->policyContext,
@@ -514,6 +756,27 @@ UA_WriterGroup_setEncryptionKeys(UA_PubSubManager *psm, UA_WriterGroup *wg,
         UA_WriterGroup_setPubSubState(psm, wg, wg->head.state) : res;
 }
 
+UA_StatusCode
+UA_WriterGroup_setNextEncryptionKeys(UA_PubSubManager *psm, UA_WriterGroup *wg,
+                                     UA_UInt32 securityTokenId,
+                                     const UA_ByteString signingKey,
+                                     const UA_ByteString encryptingKey,
+                                     const UA_ByteString keyNonce) {
+    UA_PubSubSecurityPolicy *sp = wg->config.securityPolicy;
+    if(!sp || wg->config.encodingMimeType == UA_PUBSUB_ENCODING_JSON)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    UA_StatusCode res;
+    if(!wg->nextSecurityPolicyContext)
+        res = sp->newContext(sp->policyContext, &signingKey, &encryptingKey,
+                             &keyNonce, &wg->nextSecurityPolicyContext);
+    else
+        res = sp->setSecurityKeys(wg->nextSecurityPolicyContext, &signingKey,
+                                  &encryptingKey, &keyNonce);
+    wg->nextSecurityTokenId = (res == UA_STATUSCODE_GOOD) ? securityTokenId : 0;
+    return res;
+}
+
 void
 UA_WriterGroupConfig_clear(UA_WriterGroupConfig *writerGroupConfig) {
     UA_String_clear(&writerGroupConfig->name);
@@ -650,9 +913,9 @@ UA_WriterGroup_setPubSubState(UA_PubSubManager *psm, UA_WriterGroup *wg,
 }
 
 static UA_StatusCode
-encryptAndSign(UA_WriterGroup *wg, const UA_NetworkMessage *nm,
-               UA_Byte *signStart, UA_Byte *encryptStart,
-               UA_Byte *msgEnd) {
+encryptAndSignMessage(UA_WriterGroup *wg, const UA_NetworkMessage *nm,
+                      UA_Byte *signStart, UA_Byte *encryptStart,
+                      UA_Byte *msgEnd) {
     UA_StatusCode rv;
     void *channelContext = wg->securityPolicyContext;
 
@@ -688,9 +951,25 @@ encryptAndSign(UA_WriterGroup *wg, const UA_NetworkMessage *nm,
     return UA_STATUSCODE_GOOD;
 }
 
+/* Counts the time towards the security stage of the publish cycle */
 static UA_StatusCode
-encodeNetworkMessage(UA_WriterGroup *wg, UA_NetworkMessage *nm,
-                     UA_ByteString *buf) {
+encryptAndSign(UA_PubSubManager *psm, UA_WriterGroup *wg,
+               const UA_NetworkMessage *nm, UA_Byte *signStart,
+               UA_Byte *encryptStart, UA_Byte *msgEnd) {
+    if(!nm->securityHeader.networkMessageEncrypted &&
+       !nm->securityHeader.networkMessageSigned)
+        return UA_STATUSCODE_GOOD;
+    UA_EventLoop *el = UA_PubSubConnection_getEL(psm, wg->linkedConnection);
+    UA_DateTime begin = el->dateTime_nowMonotonic(el);
+    UA_StatusCode rv =
+        encryptAndSignMessage(wg, nm, signStart, encryptStart, msgEnd);
+    wg->cycleStats.securityTime += el->dateTime_nowMonotonic(el) - begin;
+    return rv;
+}
+
+static UA_StatusCode
+encodeNetworkMessage(UA_PubSubManager *psm, UA_WriterGroup *wg,
+                     UA_NetworkMessage *nm, UA_ByteString *buf) {
     UA_Byte *bufPos = buf->data;
     UA_Byte *bufEnd = &buf->data[buf->length];
 
@@ -707,16 +986,75 @@ encodeNetworkMessage(UA_WriterGroup *wg, UA_NetworkMessage *nm,
 
     /* Encrypt and Sign the message */
     UA_Byte *footerEnd = bufPos;
-    return encryptAndSign(wg, nm, networkMessageStart, payloadStart, footerEnd);
+    return encryptAndSign(psm, wg, nm, networkMessageStart, payloadStart, footerEnd);
 }
 
+/* Set the transmit time of the current publish cycle as send parameter */
 static void
-sendNetworkMessageBuffer(UA_PubSubManager *psm, UA_WriterGroup *wg, 
-                         UA_PubSubConnection *connection, uintptr_t connectionId,
-                         UA_ByteString *buffer) {
+setSendParams(UA_WriterGroup *wg, UA_KeyValuePair *kvp, UA_KeyValueMap *kvm) {
+    kvm->map = kvp;
+    kvm->mapSize = 0;
+    if(wg->txtime == 0)
+        return;
+    kvp->key = UA_QUALIFIEDNAME(0, "txtime");
+    UA_Variant_setScalar(&kvp->value, &wg->txtime, &UA_TYPES[UA_TYPES_DATETIME]);
+    kvm->mapSize = 1;
+}
+
+/* Send out the collected NetworkMessages */
+static void
+flushNetworkMessageBuffers(UA_PubSubManager *psm, UA_WriterGroup *wg,
+                           UA_PubSubConnection *connection) {
+    if(wg->sendBuffersSize == 0)
+        return;
+    UA_KeyValuePair kvp;
+    UA_KeyValueMap kvm;
+    setSendParams(wg, &kvp, &kvm);
+    UA_StatusCode res = connection->cm->
+        sendWithConnectionV(connection->cm, wg->sendBuffersChannel,
+                            &kvm, wg->sendBuffers, wg->sendBuffersSize);
+    wg->sendBuffersSize = 0;
+
+    /* Failure, set the WriterGroup into an error mode */
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_LOG_ERROR_PUBSUB(psm->logging, wg,
+                            "Sending NetworkMessage failed");
+        UA_WriterGroup_setPubSubState(psm, wg, UA_PUBSUBSTATE_ERROR);
+        UA_PubSubConnection_setPubSubState(psm, connection, UA_PUBSUBSTATE_ERROR);
+    }
+}
+
+static void
+sendNetworkMessageBufferInternal(UA_PubSubManager *psm, UA_WriterGroup *wg,
+                                 UA_PubSubConnection *connection,
+                                 uintptr_t connectionId, UA_ByteString *buffer) {
+    /* Messages over the shared channel of the connection are collected across
+     * all WriterGroups that publish in the same EventLoop iteration. Not if
+     * the WriterGroup has its own transmit time. */
+    if(wg->batchSend && wg->txtime == 0 && connectionId == connection->sendChannel &&
+       UA_PubSubConnection_queueSend(psm, connection, buffer) == UA_STATUSCODE_GOOD) {
+        wg->sequenceNumber++;
+        return;
+    }
+
+    /* Collect the buffer and send it out together with the other
+     * NetworkMessages of the publish cycle */
+    if(wg->batchSend && connection->cm->sendWithConnectionV) {
+        if(wg->sendBuffersSize == UA_WRITERGROUP_SENDBATCH ||
+           (wg->sendBuffersSize > 0 && wg->sendBuffersChannel != connectionId))
+            flushNetworkMessageBuffers(psm, wg, connection);
+        wg->sendBuffers[wg->sendBuffersSize++] = *buffer;
+        wg->sendBuffersChannel = connectionId;
+        UA_ByteString_init(buffer);
+        wg->sequenceNumber++;
+        return;
+    }
+
+    UA_KeyValuePair kvp;
+    UA_KeyValueMap kvm;
+    setSendParams(wg, &kvp, &kvm);
     UA_StatusCode res = connection->cm->
-        sendWithConnection(connection->cm, connectionId,
-                           &UA_KEYVALUEMAP_NULL, buffer);
+        sendWithConnection(connection->cm, connectionId, &kvm, buffer);
 
     /* Failure, set the WriterGroup into an error mode */
     if(res != UA_STATUSCODE_GOOD) {
@@ -731,10 +1069,31 @@ sendNetworkMessageBuffer(UA_PubSubManager *psm, UA_WriterGroup *wg,
     wg->sequenceNumber++;
 }
 
+/* Counts the time towards the transfer stage of the publish cycle */
+static void
+sendNetworkMessageBuffer(UA_PubSubManager *psm, UA_WriterGroup *wg,
+                         UA_PubSubConnection *connection, uintptr_t connectionId,
+                         UA_ByteString *buffer) {
+    UA_EventLoop *el = UA_PubSubConnection_getEL(psm, connection);
+    UA_DateTime begin = el->dateTime_nowMonotonic(el);
+    sendNetworkMessageBufferInternal(psm, wg, connection, connectionId, buffer);
+    wg->cycleStats.transferTime += el->dateTime_nowMonotonic(el) - begin;
+}
+
+/* Record the publish cycle in the statistics */
+static void
+recordPublishCycle(UA_PubSubManager *psm, UA_WriterGroup *wg, UA_EventLoop *el,
+                   UA_DateTime start, UA_DateTime interval) {
+    UA_DateTime end = el->dateTime_nowMonotonic(el);
+    if(UA_PubSubCycleStats_record(&wg->cycleStats, start, end, interval))
+        psm->publishCycleOverrunCount++;
+}
+
 #ifdef UA_ENABLE_JSON_ENCODING
 static UA_StatusCode
 sendNetworkMessageJson(UA_PubSubManager *psm, UA_PubSubConnection *connection, UA_WriterGroup *wg,
-                       UA_DataSetMessage *dsm, UA_UInt16 *writerIds, UA_Byte dsmCount) {
+                       UA_DataSetMessage *dsm, UA_UInt16 *writerIds,
+                       const UA_String **fieldKeys, UA_Byte dsmCount) {
     /* Prepare the NetworkMessage */
     UA_NetworkMessage nm;
     memset(&nm, 0, sizeof(UA_NetworkMessage));
@@ -747,8 +1106,11 @@ sendNetworkMessageJson(UA_PubSubManager *psm, UA_PubSubConnection *connection, U
     nm.publisherIdEnabled = true;
     nm.publisherId = connection->config.publisherId;
 
-    /* Compute the message length */
-    size_t msgSize = UA_NetworkMessage_calcSizeJsonInternal(&nm, NULL, 0, NULL, 0, true);
+    /* Splice in the header and field keys prepared in the frozen
+     * configuration */
+    UA_NetworkMessageJsonTemplate tmpl;
+    tmpl.header = wg->jsonHeader;
+    tmpl.fieldKeys = fieldKeys;
 
     UA_ConnectionManager *cm = connection->cm;
     if(!cm)
@@ -763,20 +1125,34 @@ sendNetworkMessageJson(UA_PubSubManager *psm, UA_PubSubConnection *connection, U
         return UA_STATUSCODE_BADINTERNALERROR;
     }
 
-    /* Allocate the buffer */
+    /* Allocate the buffer with headroom over the size of the last message.
+     * The exact size is computed only if the message does not fit. */
+    size_t msgSize = wg->jsonSizeHint + (wg->jsonSizeHint / 4);
+    if(msgSize == 0)
+        msgSize = UA_NetworkMessage_calcSizeJsonTemplate(&nm, &tmpl);
     UA_ByteString buf;
     UA_StatusCode res = cm->allocNetworkBuffer(cm, sendChannel, &buf, msgSize);
     UA_CHECK_STATUS(res, return res);
 
     /* Encode the message */
     UA_Byte *bufPos = buf.data;
-    const UA_Byte *bufEnd = &buf.data[msgSize];
-    res = UA_NetworkMessage_encodeJsonInternal(&nm, &bufPos, &bufEnd, NULL, 0, NULL, 0, true);
+    res = UA_NetworkMessage_encodeJsonTemplate(&nm, &tmpl, &bufPos,
+                                               &buf.data[msgSize]);
+    if(res == UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED) {
+        cm->freeNetworkBuffer(cm, sendChannel, &buf);
+        msgSize = UA_NetworkMessage_calcSizeJsonTemplate(&nm, &tmpl);
+        res = cm->allocNetworkBuffer(cm, sendChannel, &buf, msgSize);
+        UA_CHECK_STATUS(res, return res);
+        bufPos = buf.data;
+        res = UA_NetworkMessage_encodeJsonTemplate(&nm, &tmpl, &bufPos,
+                                                   &buf.data[msgSize]);
+    }
     if(res != UA_STATUSCODE_GOOD) {
         cm->freeNetworkBuffer(cm, sendChannel, &buf);
         return res;
     }
-    UA_assert(bufPos == bufEnd);
+    buf.length = (size_t)(bufPos - buf.data);
+    wg->jsonSizeHint = buf.length;
 
     /* Send the prepared messages */
     sendNetworkMessageBuffer(psm, wg, connection, sendChannel, &buf);
@@ -923,7 +1299,7 @@ sendNetworkMessageBinary(UA_PubSubManager *psm, UA_PubSubConnection *connection,
     UA_CHECK_STATUS(rv, return rv);
 
     /* Encode and encrypt the message */
-    rv = encodeNetworkMessage(wg, &nm, &buf);
+    rv = encodeNetworkMessage(psm, wg, &nm, &buf);
     if(rv != UA_STATUSCODE_GOOD) {
         cm->freeNetworkBuffer(cm, sendChannel, &buf);
         UA_free(nm.payload.dataSetPayload.sizes);
@@ -937,55 +1313,12 @@ sendNetworkMessageBinary(UA_PubSubManager *psm, UA_PubSubConnection *connection,
     return UA_STATUSCODE_GOOD;
 }
 
-static void
-sampleOffsetPublishingValues(UA_PubSubManager *psm, UA_WriterGroup *wg) {
-    size_t fieldPos = 0;
-    UA_DataSetWriter *dsw;
-    LIST_FOREACH(dsw, &wg->writers, listEntry) {
-        UA_PublishedDataSet *pds = dsw->connectedDataSet;
-        if(!pds)
-            continue;
-
-        /* Loop over the fields */
-        UA_DataSetField *dsf;
-        TAILQ_FOREACH(dsf, &pds->fields, listEntry) {
-            /* Get the matching offset table entry */
-            UA_NetworkMessageOffsetType contentType;
-            do {
-                fieldPos++;
-                contentType = wg->bufferedMessage.offsets[fieldPos].contentType;
-            } while(contentType != UA_PUBSUB_OFFSETTYPE_PAYLOAD_DATAVALUE &&
-                    contentType != UA_PUBSUB_OFFSETTYPE_PAYLOAD_DATAVALUE_EXTERNAL &&
-                    contentType != UA_PUBSUB_OFFSETTYPE_PAYLOAD_VARIANT &&
-                    contentType != UA_PUBSUB_OFFSETTYPE_PAYLOAD_VARIANT_EXTERNAL &&
-                    contentType != UA_PUBSUB_OFFSETTYPE_PAYLOAD_RAW &&
-                    contentType != UA_PUBSUB_OFFSETTYPE_PAYLOAD_RAW_EXTERNAL);
-
-            /* External data source is never sampled, but accessed directly in
-             * the encoding */
-            if(contentType == UA_PUBSUB_OFFSETTYPE_PAYLOAD_DATAVALUE_EXTERNAL ||
-               contentType == UA_PUBSUB_OFFSETTYPE_PAYLOAD_VARIANT_EXTERNAL ||
-               contentType == UA_PUBSUB_OFFSETTYPE_PAYLOAD_RAW_EXTERNAL)
-                continue;
-
-            /* Sample the value into the offset table */
-            UA_DataValue *dfv = &wg->bufferedMessage.offsets[fieldPos].content.value;
-            UA_DataValue_clear(dfv);
-            UA_PubSubDataSetField_sampleValue(psm, dsf, dfv);
-        }
-    }
-}
-
 static void
 publishWithOffsets(UA_PubSubManager *psm, UA_WriterGroup *wg,
                    UA_PubSubConnection *connection) {
     UA_assert(wg->configurationFrozen);
 
-    /* Fixed size but no direct value access. Sample to get recent values into
-     * the offset buffer structure. */
-    if((wg->config.rtLevel & UA_PUBSUB_RT_DIRECT_VALUE_ACCESS) == 0)
-        sampleOffsetPublishingValues(psm, wg);
-
+    /* Encode the current values from the external data sources */
     UA_StatusCode res =
         UA_NetworkMessage_updateBufferedMessage(&wg->bufferedMessage);
 
@@ -995,31 +1328,7 @@ publishWithOffsets(UA_PubSubManager *psm, UA_WriterGroup *wg,
         return;
     }
 
-    UA_ByteString *buf = &wg->bufferedMessage.buffer;
-
-    /* Send the encrypted buffered message if PubSub encryption is enabled */
-    if(wg->config.securityMode > UA_MESSAGESECURITYMODE_NONE) {
-        size_t sigSize = wg->config.securityPolicy->symmetricModule.cryptoModule.
-            signatureAlgorithm.getLocalSignatureSize(wg->securityPolicyContext);
-
-        UA_Byte payloadOffset = (UA_Byte)(wg->bufferedMessage.payloadPosition -
-                                          wg->bufferedMessage.buffer.data);
-        memcpy(wg->bufferedMessage.encryptBuffer.data,
-               wg->bufferedMessage.buffer.data,
-               wg->bufferedMessage.buffer.length);
-        res = encryptAndSign(wg, wg->bufferedMessage.nm,
-                             wg->bufferedMessage.encryptBuffer.data,
-                             wg->bufferedMessage.encryptBuffer.data + payloadOffset,
-                             wg->bufferedMessage.encryptBuffer.data +
-                             wg->bufferedMessage.encryptBuffer.length - sigSize);
-
-        if(res != UA_STATUSCODE_GOOD) {
-            UA_LOG_ERROR_PUBSUB(psm->logging, wg, "PubSub Encryption failed");
-            return;
-        }
-
-        buf = &wg->bufferedMessage.encryptBuffer;
-    }
+    const UA_ByteString *buf = &wg->bufferedMessage.buffer;
 
     UA_ConnectionManager *cm = connection->cm;
     if(!cm)
@@ -1034,7 +1343,9 @@ publishWithOffsets(UA_PubSubManager *psm, UA_WriterGroup *wg,
         return;
     }
 
-    /* Copy into the network buffer */
+    /* Copy into the network buffer. This is the only copy of the message. The
+     * buffered message is kept unchanged as the template for the next cycle.
+     * So encryption and signing happens in-place in the network buffer. */
     UA_ByteString outBuf;
     res = cm->allocNetworkBuffer(cm, sendChannel, &outBuf, buf->length);
     if(res != UA_STATUSCODE_GOOD) {
@@ -1042,12 +1353,30 @@ publishWithOffsets(UA_PubSubManager *psm, UA_WriterGroup *wg,
         return;
     }
     memcpy(outBuf.data, buf->data, buf->length);
+
+    /* Encrypt and sign if PubSub encryption is enabled */
+    if(wg->config.securityMode > UA_MESSAGESECURITYMODE_NONE) {
+        size_t sigSize = wg->config.securityPolicy->symmetricModule.cryptoModule.
+            signatureAlgorithm.getLocalSignatureSize(wg->securityPolicyContext);
+        size_t payloadOffset = (size_t)(wg->bufferedMessage.payloadPosition -
+                                        buf->data);
+        res = encryptAndSign(psm, wg, wg->bufferedMessage.nm, outBuf.data,
+                             outBuf.data + payloadOffset,
+                             outBuf.data + outBuf.length - sigSize);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_LOG_ERROR_PUBSUB(psm->logging, wg, "PubSub Encryption failed");
+            cm->freeNetworkBuffer(cm, sendChannel, &outBuf);
+            return;
+        }
+    }
+
     sendNetworkMessageBuffer(psm, wg, connection, sendChannel, &outBuf);
 }
 
 static void
 sendNetworkMessage(UA_PubSubManager *psm, UA_WriterGroup *wg, UA_PubSubConnection *connection,
-                   UA_DataSetMessage *dsm, UA_UInt16 *writerIds, UA_Byte dsmCount) {
+                   UA_DataSetMessage *dsm, UA_UInt16 *writerIds,
+                   const UA_String **fieldKeys, UA_Byte dsmCount) {
     UA_StatusCode res = UA_STATUSCODE_GOOD;
     switch(wg->config.encodingMimeType) {
     case UA_PUBSUB_ENCODING_UADP:
@@ -1055,7 +1384,8 @@ sendNetworkMessage(UA_PubSubManager *psm, UA_WriterGroup *wg, UA_PubSubConnectio
         break;
 #ifdef UA_ENABLE_JSON_ENCODING
     case UA_PUBSUB_ENCODING_JSON:
-        res = sendNetworkMessageJson(psm, connection, wg, dsm, writerIds, dsmCount);
+        res = sendNetworkMessageJson(psm, connection, wg, dsm, writerIds,
+                                     fieldKeys, dsmCount);
         break;
 #endif
     default:
@@ -1092,13 +1422,41 @@ UA_WriterGroup_publishCallback(UA_PubSubManager *psm, UA_WriterGroup *wg) {
         return;
     }
 
+    /* Count the cycle. An overrun is recorded if the cycle starts more than
+     * half an interval late relative to the previous cycle. The cycle is
+     * recorded in the statistics when it is finished. */
+    UA_EventLoop *el = UA_PubSubConnection_getEL(psm, connection);
+    UA_DateTime now = el->dateTime_nowMonotonic(el);
+    UA_DateTime interval = (UA_DateTime)
+        (wg->config.publishingInterval * UA_DATETIME_MSEC);
+    if(interval == 0)
+        interval = 1;
+    psm->publishCycleCount++;
+
+    /* Compute the transmit time at the configured offset into the current
+     * publish cycle. The cycles are aligned to the monotonic clock. */
+    wg->txtime = 0;
+    if(wg->config.transmitTimeOffset > 0.0 &&
+       wg->config.transmitTimeOffset < wg->config.publishingInterval) {
+        UA_DateTime phase = (now - UA_DATETIME_UNIX_EPOCH) % interval;
+        if(phase < 0)
+            phase += interval;
+        wg->txtime = now - phase + (UA_DateTime)
+            (wg->config.transmitTimeOffset * UA_DATETIME_MSEC);
+        if(wg->txtime <= now)
+            UA_LOG_WARNING_PUBSUB(psm->logging, wg, "Publish callback started "
+                                  "after the transmit time of the cycle");
+    }
+
     /* Realtime path - update the buffer message and send directly */
     if(wg->config.rtLevel & UA_PUBSUB_RT_FIXED_SIZE) {
         publishWithOffsets(psm, wg, connection);
+        recordPublishCycle(psm, wg, el, now, interval);
         return;
     }
 
     UA_LOCK(&psm->sc.server->serviceMutex);
+    wg->batchSend = true;
 
     /* How many DSM can be sent in one NM? */
     UA_Byte maxDSM = (UA_Byte)wg->config.maxEncapsulatedDataSetMessageCount;
@@ -1113,12 +1471,12 @@ UA_WriterGroup_publishCallback(UA_PubSubManager *psm, UA_WriterGroup *wg) {
      * "batching". */
     size_t dsmCount = 0;
     UA_STACKARRAY(UA_UInt16, dsWriterIds, wg->writersCount);
+    UA_STACKARRAY(const UA_String*, dsFieldKeys, wg->writersCount);
     UA_STACKARRAY(UA_DataSetMessage, dsmStore, wg->writersCount);
 
     size_t enabledWriters = 0;
 
     UA_DataSetWriter *dsw;
-    UA_EventLoop *el = UA_PubSubConnection_getEL(psm, wg->linkedConnection);
     LIST_FOREACH(dsw, &wg->writers, listEntry) {
         if(dsw->head.state != UA_PUBSUBSTATE_OPERATIONAL)
             continue;
@@ -1130,6 +1488,7 @@ UA_WriterGroup_publishCallback(UA_PubSubManager *psm, UA_WriterGroup *wg) {
 
         /* Generate the DSM */
         dsWriterIds[dsmCount] = dsw->config.dataSetWriterId;
+        dsFieldKeys[dsmCount] = dsw->jsonFieldKeys;
         UA_StatusCode res =
             UA_DataSetWriter_generateDataSetMessage(psm, &dsmStore[dsmCount], dsw);
         if(res != UA_STATUSCODE_GOOD) {
@@ -1143,7 +1502,7 @@ UA_WriterGroup_publishCallback(UA_PubSubManager *psm, UA_WriterGroup *wg) {
         if(pds && pds->promotedFieldsCount > 0) {
             wg->lastPublishTimeStamp = el->dateTime_nowMonotonic(el);
             sendNetworkMessage(psm, wg, connection, &dsmStore[dsmCount],
-                               &dsWriterIds[dsmCount], 1);
+                               &dsWriterIds[dsmCount], &dsFieldKeys[dsmCount], 1);
 
             /* Clean up the current store entry */
             if(wg->config.rtLevel & UA_PUBSUB_RT_DIRECT_VALUE_ACCESS &&
@@ -1164,6 +1523,8 @@ UA_WriterGroup_publishCallback(UA_PubSubManager *psm, UA_WriterGroup *wg) {
     if(enabledWriters == 0) {
         UA_LOG_WARNING_PUBSUB(psm->logging, wg,
                               "Cannot publish -- No Writers are enabled");
+        wg->batchSend = false;
+        recordPublishCycle(psm, wg, el, now, interval);
         UA_UNLOCK(&psm->sc.server->serviceMutex);
         return;
     }
@@ -1176,7 +1537,7 @@ UA_WriterGroup_publishCallback(UA_PubSubManager *psm, UA_WriterGroup *wg) {
         wg->lastPublishTimeStamp = el->dateTime_nowMonotonic(el);
         /* Send the batched messages */
         sendNetworkMessage(psm, wg, connection, &dsmStore[i],
-                           &dsWriterIds[i], nmDsmCount);
+                           &dsWriterIds[i], &dsFieldKeys[i], nmDsmCount);
     }
 
     /* Clean up DSM */
@@ -1190,6 +1551,13 @@ UA_WriterGroup_publishCallback(UA_PubSubManager *psm, UA_WriterGroup *wg) {
         UA_DataSetMessage_clear(&dsmStore[i]);
     }
 
+    /* Send out the collected NetworkMessages */
+    UA_DateTime flushStart = el->dateTime_nowMonotonic(el);
+    flushNetworkMessageBuffers(psm, wg, connection);
+    wg->cycleStats.transferTime += el->dateTime_nowMonotonic(el) - flushStart;
+    wg->batchSend = false;
+
+    recordPublishCycle(psm, wg, el, now, interval);
     UA_UNLOCK(&psm->sc.server->serviceMutex);
 }
 
@@ -1338,7 +1706,7 @@ UA_WriterGroup_connectUDPUnicast(UA_PubSubManager *psm, UA_WriterGroup *wg,
 
     /* Set up the connection parameters */
     UA_Boolean listen = false;
-    UA_KeyValuePair kvp[5];
+    UA_KeyValuePair kvp[7];
     UA_KeyValueMap kvm = {4, kvp};
     kvp[0].key = UA_QUALIFIEDNAME(0, "address");
     UA_Variant_setScalar(&kvp[0].value, &address, &UA_TYPES[UA_TYPES_STRING]);
@@ -1355,6 +1723,11 @@ UA_WriterGroup_connectUDPUnicast(UA_PubSubManager *psm, UA_WriterGroup *wg,
         kvm.mapSize++;
     }
 
+    /* Forward the txtime configuration from the connection properties */
+    static const char *txtimeProperties[2] = {"txtime-enable", "txtime-flags"};
+    UA_PubSubConnection_forwardProperties(wg->linkedConnection, &kvm,
+                                          txtimeProperties, 2);
+
     /* Connect */
     UA_ConnectionManager *cm = wg->linkedConnection->cm;
     UA_UNLOCK(&server->serviceMutex);
@@ -1400,8 +1773,10 @@ UA_WriterGroup_connectMQTT(UA_PubSubManager *psm, UA_WriterGroup *wg,
     /* Set up the connection parameters.
      * TODO: Complete the MQTT parameters. */
     UA_Boolean listen = false;
-    UA_KeyValuePair kvp[5];
-    UA_KeyValueMap kvm = {5, kvp};
+    UA_Byte qos = (transportSettings->requestedDeliveryGuarantee ==
+                   UA_BROKERTRANSPORTQUALITYOFSERVICE_ATLEASTONCE) ? 1 : 0;
+    UA_KeyValuePair kvp[6];
+    UA_KeyValueMap kvm = {6, kvp};
     kvp[0].key = UA_QUALIFIEDNAME(0, "address");
     UA_Variant_setScalar(&kvp[0].value, &address, &UA_TYPES[UA_TYPES_STRING]);
     kvp[1].key = UA_QUALIFIEDNAME(0, "subscribe");
@@ -1413,6 +1788,8 @@ UA_WriterGroup_connectMQTT(UA_PubSubManager *psm, UA_WriterGroup *wg,
                          &UA_TYPES[UA_TYPES_STRING]);
     kvp[4].key = UA_QUALIFIEDNAME(0, "validate");
     UA_Variant_setScalar(&kvp[4].value, &validate, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    kvp[5].key = UA_QUALIFIEDNAME(0, "qos");
+    UA_Variant_setScalar(&kvp[5].value, &qos, &UA_TYPES[UA_TYPES_BYTE]);
 
     /* Connect */
     UA_UNLOCK(&server->serviceMutex);
@@ -1640,6 +2017,22 @@ UA_Server_getWriterGroupLastPublishTimestamp(UA_Server *server,
     return UA_STATUSCODE_GOOD;
 }
 
+UA_StatusCode
+UA_Server_getWriterGroupCycleStatistics(UA_Server *server, const UA_NodeId wgId,
+                                        UA_PubSubCycleStatistics *stats) {
+    if(!server || !stats)
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+    UA_LOCK(&server->serviceMutex);
+    UA_StatusCode ret = UA_STATUSCODE_BADNOTFOUND;
+    UA_WriterGroup *wg = UA_WriterGroup_find(getPSM(server), wgId);
+    if(wg) {
+        UA_PubSubCycleStats_get(&wg->cycleStats, stats);
+        ret = UA_STATUSCODE_GOOD;
+    }
+    UA_UNLOCK(&server->serviceMutex);
+    return ret;
+}
+
 UA_StatusCode
 UA_Server_setWriterGroupEncryptionKeys(UA_Server *server, const UA_NodeId writerGroup,
                                        UA_UInt32 securityTokenId,
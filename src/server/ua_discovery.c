@@ -47,6 +47,75 @@ UA_DiscoveryManager_setState(UA_DiscoveryManager *dm,
         dm->sc.notifyState(&dm->sc, state);
 }
 
+enum ZIP_CMP
+cmpRegisteredServerUri(const UA_String *a, const UA_String *b) {
+    if(a->length != b->length)
+        return (a->length < b->length) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+    if(a->length == 0)
+        return ZIP_CMP_EQ;
+    int c = memcmp(a->data, b->data, a->length);
+    if(c == 0)
+        return ZIP_CMP_EQ;
+    return (c < 0) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+}
+
+enum ZIP_CMP
+cmpRegisteredServerLastSeen(const UA_DateTime *a, const UA_DateTime *b) {
+    if(*a == *b)
+        return ZIP_CMP_EQ;
+    return (*a < *b) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+}
+
+registeredServer *
+UA_DiscoveryManager_findRegisteredServer(UA_DiscoveryManager *dm,
+                                         const UA_String *serverUri) {
+    return ZIP_FIND(RegisteredServerUriTree, &dm->registeredServersByUri, serverUri);
+}
+
+static void
+clearFindServersCache(UA_DiscoveryManager *dm) {
+    UA_Array_delete(dm->findServersCache, dm->findServersCacheSize,
+                    &UA_TYPES[UA_TYPES_APPLICATIONDESCRIPTION]);
+    dm->findServersCache = NULL;
+    dm->findServersCacheSize = 0;
+    dm->findServersCacheValid = false;
+}
+
+void
+UA_DiscoveryManager_linkRegisteredServer(UA_DiscoveryManager *dm,
+                                         registeredServer *rs) {
+    LIST_INSERT_HEAD(&dm->registeredServers, rs, pointers);
+    ZIP_INSERT(RegisteredServerUriTree, &dm->registeredServersByUri, rs);
+    ZIP_INSERT(RegisteredServerExpiryTree, &dm->registeredServersByExpiry, rs);
+#ifdef UA_ENABLE_DISCOVERY_SEMAPHORE
+    if(rs->registeredServer.semaphoreFilePath.length > 0)
+        LIST_INSERT_HEAD(&dm->registeredSemaphores, rs, semaphorePointers);
+#endif
+    dm->registeredServersSize++;
+    clearFindServersCache(dm);
+}
+
+void
+UA_DiscoveryManager_unlinkRegisteredServer(UA_DiscoveryManager *dm,
+                                           registeredServer *rs) {
+    LIST_REMOVE(rs, pointers);
+    ZIP_REMOVE(RegisteredServerUriTree, &dm->registeredServersByUri, rs);
+    ZIP_REMOVE(RegisteredServerExpiryTree, &dm->registeredServersByExpiry, rs);
+#ifdef UA_ENABLE_DISCOVERY_SEMAPHORE
+    if(rs->registeredServer.semaphoreFilePath.length > 0)
+        LIST_REMOVE(rs, semaphorePointers);
+#endif
+    dm->registeredServersSize--;
+    clearFindServersCache(dm);
+}
+
+static void
+removeRegisteredServer(UA_DiscoveryManager *dm, registeredServer *rs) {
+    UA_DiscoveryManager_unlinkRegisteredServer(dm, rs);
+    UA_RegisteredServer_clear(&rs->registeredServer);
+    UA_free(rs);
+}
+
 static UA_StatusCode
 UA_DiscoveryManager_clear(struct UA_ServerComponent *sc) {
     UA_DiscoveryManager *dm = (UA_DiscoveryManager*)sc;
@@ -60,10 +129,9 @@ UA_DiscoveryManager_clear(struct UA_ServerComponent *sc) {
 
     registeredServer *rs, *rs_tmp;
     LIST_FOREACH_SAFE(rs, &dm->registeredServers, pointers, rs_tmp) {
-        LIST_REMOVE(rs, pointers);
-        UA_RegisteredServer_clear(&rs->registeredServer);
-        UA_free(rs);
+        removeRegisteredServer(dm, rs);
     }
+    clearFindServersCache(dm);
 
 # ifdef UA_ENABLE_DISCOVERY_MULTICAST
     serverOnNetwork *son, *son_tmp;
@@ -76,6 +144,7 @@ UA_DiscoveryManager_clear(struct UA_ServerComponent *sc) {
     }
 
     UA_String_clear(&dm->selfFqdnMdnsRecord);
+    mdns_clear_ptr_records(dm);
 
     for(size_t i = 0; i < SERVER_ON_NETWORK_HASH_SIZE; i++) {
         serverOnNetwork_hash_entry* currHash = dm->serverOnNetworkHash[i];
@@ -93,58 +162,53 @@ UA_DiscoveryManager_clear(struct UA_ServerComponent *sc) {
 /* Cleanup server registration: If the semaphore file path is set, then it just
  * checks the existence of the file. When it is deleted, the registration is
  * removed. If there is no semaphore file, then the registration will be removed
- * if it is older than 60 minutes. */
+ * if it is older than 60 minutes. The registrations are ordered by the time
+ * they were last seen. So only the timed out registrations are visited. */
 static void
 UA_DiscoveryManager_cleanupTimedOut(UA_Server *server, void *data) {
     UA_EventLoop *el = server->config.eventLoop;
     UA_DiscoveryManager *dm = (UA_DiscoveryManager*)data;
 
-    /* TimedOut gives the last DateTime at which we must have seen the
-     * registered server. Otherwise it is timed out. */
-    UA_DateTime timedOut = el->dateTime_nowMonotonic(el);
-    if(server->config.discoveryCleanupTimeout)
-        timedOut -= server->config.discoveryCleanupTimeout * UA_DATETIME_SEC;
-
-    registeredServer *current, *temp;
-    LIST_FOREACH_SAFE(current, &dm->registeredServers, pointers, temp) {
-        UA_Boolean semaphoreDeleted = false;
-
 #ifdef UA_ENABLE_DISCOVERY_SEMAPHORE
-        if(current->registeredServer.semaphoreFilePath.length) {
-            size_t fpSize = current->registeredServer.semaphoreFilePath.length+1;
-            char* filePath = (char *)UA_malloc(fpSize);
-            if(filePath) {
-                memcpy(filePath, current->registeredServer.semaphoreFilePath.data,
-                       current->registeredServer.semaphoreFilePath.length );
-                filePath[current->registeredServer.semaphoreFilePath.length] = '\0';
-                semaphoreDeleted = UA_fileExists(filePath) == false;
-                UA_free(filePath);
-            } else {
-                UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_SERVER,
-                             "Cannot check registration semaphore. Out of memory");
-            }
+    registeredServer *current, *temp;
+    LIST_FOREACH_SAFE(current, &dm->registeredSemaphores, semaphorePointers, temp) {
+        size_t fpSize = current->registeredServer.semaphoreFilePath.length+1;
+        char* filePath = (char *)UA_malloc(fpSize);
+        if(!filePath) {
+            UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_SERVER,
+                         "Cannot check registration semaphore. Out of memory");
+            continue;
         }
+        memcpy(filePath, current->registeredServer.semaphoreFilePath.data,
+               current->registeredServer.semaphoreFilePath.length );
+        filePath[current->registeredServer.semaphoreFilePath.length] = '\0';
+        UA_Boolean semaphoreDeleted = UA_fileExists(filePath) == false;
+        UA_free(filePath);
+        if(!semaphoreDeleted)
+            continue;
+        UA_LOG_INFO(server->config.logging, UA_LOGCATEGORY_SERVER,
+                    "Registration of server with URI %S is removed because "
+                    "the semaphore file '%S' was deleted",
+                    current->registeredServer.serverUri,
+                    current->registeredServer.semaphoreFilePath);
+        removeRegisteredServer(dm, current);
+    }
 #endif
 
-        if(semaphoreDeleted ||
-           (server->config.discoveryCleanupTimeout &&
-            current->lastSeen < timedOut)) {
-            if(semaphoreDeleted) {
-                UA_LOG_INFO(server->config.logging, UA_LOGCATEGORY_SERVER,
-                            "Registration of server with URI %S is removed because "
-                            "the semaphore file '%S' was deleted",
-                            current->registeredServer.serverUri,
-                            current->registeredServer.semaphoreFilePath);
-            } else {
-                // cppcheck-suppress unreadVariable
-                UA_LOG_INFO(server->config.logging, UA_LOGCATEGORY_SERVER,
-                            "Registration of server with URI %S has timed out "
-                            "and is removed", current->registeredServer.serverUri);
-            }
-            LIST_REMOVE(current, pointers);
-            UA_RegisteredServer_clear(&current->registeredServer);
-            UA_free(current);
-            dm->registeredServersSize--;
+    if(server->config.discoveryCleanupTimeout) {
+        /* TimedOut gives the last DateTime at which we must have seen the
+         * registered server. Otherwise it is timed out. */
+        UA_DateTime timedOut = el->dateTime_nowMonotonic(el) -
+            server->config.discoveryCleanupTimeout * UA_DATETIME_SEC;
+        registeredServer *oldest;
+        while((oldest = ZIP_MIN(RegisteredServerExpiryTree,
+                                &dm->registeredServersByExpiry)) &&
+              oldest->lastSeen < timedOut) {
+            // cppcheck-suppress unreadVariable
+            UA_LOG_INFO(server->config.logging, UA_LOGCATEGORY_SERVER,
+                        "Registration of server with URI %S has timed out "
+                        "and is removed", oldest->registeredServer.serverUri);
+            removeRegisteredServer(dm, oldest);
         }
     }
 
@@ -27,10 +27,32 @@ typedef struct UA_DiscoveryManager UA_DiscoveryManager;
 
 typedef struct registeredServer {
     LIST_ENTRY(registeredServer) pointers;
+    ZIP_ENTRY(registeredServer) uriTreeEntry;
+    ZIP_ENTRY(registeredServer) expiryTreeEntry;
+#ifdef UA_ENABLE_DISCOVERY_SEMAPHORE
+    LIST_ENTRY(registeredServer) semaphorePointers;
+#endif
     UA_RegisteredServer registeredServer;
     UA_DateTime lastSeen;
 } registeredServer;
 
+enum ZIP_CMP
+cmpRegisteredServerUri(const UA_String *a, const UA_String *b);
+
+enum ZIP_CMP
+cmpRegisteredServerLastSeen(const UA_DateTime *a, const UA_DateTime *b);
+
+/* Index of the registered servers by their ServerUri and by the time they were
+ * last seen (the oldest registration times out first). The registered servers
+ * are additionally kept in a list for iteration. */
+typedef ZIP_HEAD(RegisteredServerUriTree, registeredServer) RegisteredServerUriTree;
+ZIP_FUNCTIONS(RegisteredServerUriTree, registeredServer, uriTreeEntry,
+              UA_String, registeredServer.serverUri, cmpRegisteredServerUri)
+
+typedef ZIP_HEAD(RegisteredServerExpiryTree, registeredServer) RegisteredServerExpiryTree;
+ZIP_FUNCTIONS(RegisteredServerExpiryTree, registeredServer, expiryTreeEntry,
+              UA_DateTime, lastSeen, cmpRegisteredServerLastSeen)
+
 /* Store async register service calls. So we can cancel outstanding requests
  * during shutdown. */
 typedef struct {
@@ -68,6 +90,7 @@ typedef struct serverOnNetwork {
     UA_DateTime lastSeen;
     UA_Boolean txtSet;
     UA_Boolean srvSet;
+    UA_UInt32 txtHash; /* Hash of the last TXT record data */
     char* pathTmp;
 } serverOnNetwork;
 
@@ -77,6 +100,20 @@ typedef struct serverOnNetwork_hash_entry {
     struct serverOnNetwork_hash_entry* next;
 } serverOnNetwork_hash_entry;
 
+/* The published PTR records "_opcua-tcp._tcp.local. PTR [domain]". They all
+ * share the same name in the mDNS daemon. So they are hashed by their domain
+ * instead of searching them in the daemon. */
+#define MDNS_PTR_RECORD_HASH_SIZE 256
+typedef struct mdnsPtrRecord {
+    LIST_ENTRY(mdnsPtrRecord) pointers;
+    mdns_record_t *record;
+    UA_String domain;
+} mdnsPtrRecord;
+
+/* Maximum number of mDNS packets sent per cycle of the DiscoveryManager. The
+ * remaining packets stay queued in the daemon for the next cycle. */
+#define UA_MDNS_MAXPACKETSPERCYCLE 32
+
 #endif
 
 struct UA_DiscoveryManager {
@@ -89,6 +126,20 @@ struct UA_DiscoveryManager {
 
     LIST_HEAD(, registeredServer) registeredServers;
     size_t registeredServersSize;
+    RegisteredServerUriTree registeredServersByUri;
+    RegisteredServerExpiryTree registeredServersByExpiry;
+#ifdef UA_ENABLE_DISCOVERY_SEMAPHORE
+    /* Only the registrations with a semaphore file are checked periodically */
+    LIST_HEAD(, registeredServer) registeredSemaphores;
+#endif
+
+    /* The ApplicationDescriptions of the registered servers for a FindServers
+     * request without filter. Built on demand and dropped whenever the set of
+     * registered servers changes. */
+    UA_ApplicationDescription *findServersCache;
+    size_t findServersCacheSize;
+    UA_Boolean findServersCacheValid;
+
     UA_Server_registerServerCallback registerServerCallback;
     void* registerServerCallbackData;
 
@@ -112,6 +163,8 @@ struct UA_DiscoveryManager {
     /* hash mapping domain name to serverOnNetwork list entry */
     struct serverOnNetwork_hash_entry* serverOnNetworkHash[SERVER_ON_NETWORK_HASH_SIZE];
 
+    LIST_HEAD(, mdnsPtrRecord) mdnsPtrRecords[MDNS_PTR_RECORD_HASH_SIZE];
+
     UA_Server_serverOnNetworkCallback serverOnNetworkCallback;
     void *serverOnNetworkCallbackData;
 
@@ -123,6 +176,21 @@ void
 UA_DiscoveryManager_setState(UA_DiscoveryManager *dm,
                              UA_LifecycleState state);
 
+registeredServer *
+UA_DiscoveryManager_findRegisteredServer(UA_DiscoveryManager *dm,
+                                         const UA_String *serverUri);
+
+/* Add the registered server to the list and the indexes */
+void
+UA_DiscoveryManager_linkRegisteredServer(UA_DiscoveryManager *dm,
+                                         registeredServer *rs);
+
+/* Remove the registered server from the list and the indexes. The entry is not
+ * freed. */
+void
+UA_DiscoveryManager_unlinkRegisteredServer(UA_DiscoveryManager *dm,
+                                           registeredServer *rs);
+
 #ifdef UA_ENABLE_DISCOVERY_MULTICAST
 
 /* Sends out a new mDNS package for the given server data. This Method is
@@ -168,6 +236,10 @@ mdns_record_t *
 mdns_find_record(mdns_daemon_t *mdnsDaemon, unsigned short type,
                  const char *host, const char *rdname);
 
+/* Remove all entries of the PTR record hash. The records themselves belong to
+ * the mDNS daemon. */
+void mdns_clear_ptr_records(UA_DiscoveryManager *dm);
+
 #endif /* UA_ENABLE_DISCOVERY_MULTICAST */
 
 #endif /* UA_ENABLE_DISCOVERY */
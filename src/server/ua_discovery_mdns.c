@@ -96,6 +96,7 @@ UA_DiscoveryManager_addEntryToServersOnNetwork(UA_DiscoveryManager *dm,
     listEntry->pathTmp = NULL;
     listEntry->txtSet = false;
     listEntry->srvSet = false;
+    listEntry->txtHash = 0;
     UA_ServerOnNetwork_init(&listEntry->serverOnNetwork);
     listEntry->serverOnNetwork.recordId = dm->serverOnNetworkRecordIdCounter;
     UA_StatusCode res = UA_String_copy(&serverName, &listEntry->serverOnNetwork.serverName);
@@ -248,6 +249,7 @@ static void
 setTxt(UA_DiscoveryManager *dm, const struct resource *r,
        struct serverOnNetwork *entry) {
     entry->txtSet = true;
+    entry->txtHash = UA_ByteString_hash(0, r->rdata, r->rdlength);
     xht_t *x = txt2sd(r->rdata, r->rdlength);
     char *path = (char *) xht_get(x, "path");
     char *caps = (char *) xht_get(x, "caps");
@@ -274,6 +276,13 @@ setTxt(UA_DiscoveryManager *dm, const struct resource *r,
     }
 
     if(caps && strlen(caps) > 0) {
+        /* Replace the capabilities of an earlier TXT record */
+        UA_Array_delete(entry->serverOnNetwork.serverCapabilities,
+                        entry->serverOnNetwork.serverCapabilitiesSize,
+                        &UA_TYPES[UA_TYPES_STRING]);
+        entry->serverOnNetwork.serverCapabilities = NULL;
+        entry->serverOnNetwork.serverCapabilitiesSize = 0;
+
         /* count comma in caps */
         size_t capsCount = 1;
         for(size_t i = 0; caps[i]; i++) {
@@ -392,6 +401,20 @@ mdns_record_received(const struct resource *r, void *data) {
 
     /* TXT and SRV are already set */
     if(entry->txtSet && entry->srvSet) {
+        /* Only a changed TXT record is parsed again. The path is part of the
+         * DiscoveryUrl and is kept. */
+        if(r->type == QTYPE_TXT &&
+           UA_ByteString_hash(0, r->rdata, r->rdlength) != entry->txtHash) {
+            UA_Boolean srvSet = entry->srvSet;
+            entry->srvSet = false; /* Don't append the path once more */
+            setTxt(dm, r, entry);
+            entry->srvSet = srvSet;
+            if(entry->pathTmp) {
+                UA_free(entry->pathTmp);
+                entry->pathTmp = NULL;
+            }
+        }
+
         // call callback for every mdns package we received.
         // This will also call the callback multiple times
         if(dm->serverOnNetworkCallback)
@@ -502,6 +525,55 @@ mdns_find_record(mdns_daemon_t *mdnsDaemon, unsigned short type,
     return NULL;
 }
 
+static UA_UInt32
+mdns_ptr_hash(const char *domain) {
+    return UA_ByteString_hash(0, (const UA_Byte*)domain, strlen(domain)) %
+        MDNS_PTR_RECORD_HASH_SIZE;
+}
+
+static mdnsPtrRecord *
+mdns_ptr_lookup(UA_DiscoveryManager *dm, const char *domain) {
+    UA_String domainStr = {strlen(domain), (UA_Byte*)(uintptr_t)domain};
+    mdnsPtrRecord *pr;
+    LIST_FOREACH(pr, &dm->mdnsPtrRecords[mdns_ptr_hash(domain)], pointers) {
+        if(UA_String_equal(&pr->domain, &domainStr))
+            return pr;
+    }
+    return NULL;
+}
+
+static UA_StatusCode
+mdns_ptr_add(UA_DiscoveryManager *dm, const char *domain, mdns_record_t *record) {
+    mdnsPtrRecord *pr = (mdnsPtrRecord*)UA_malloc(sizeof(mdnsPtrRecord));
+    if(!pr)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    pr->domain = UA_STRING_ALLOC(domain);
+    if(!pr->domain.data) {
+        UA_free(pr);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    pr->record = record;
+    LIST_INSERT_HEAD(&dm->mdnsPtrRecords[mdns_ptr_hash(domain)], pr, pointers);
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+mdns_ptr_remove(mdnsPtrRecord *pr) {
+    LIST_REMOVE(pr, pointers);
+    UA_String_clear(&pr->domain);
+    UA_free(pr);
+}
+
+void
+mdns_clear_ptr_records(UA_DiscoveryManager *dm) {
+    for(size_t i = 0; i < MDNS_PTR_RECORD_HASH_SIZE; i++) {
+        mdnsPtrRecord *pr, *pr_tmp;
+        LIST_FOREACH_SAFE(pr, &dm->mdnsPtrRecords[i], pointers, pr_tmp) {
+            mdns_ptr_remove(pr);
+        }
+    }
+}
+
 /* set record in the given interface */
 static void
 mdns_set_address_record_if(UA_DiscoveryManager *dm, const char *fullServiceDomain,
@@ -774,8 +846,15 @@ UA_DiscoveryManager_sendMulticastMessages(UA_DiscoveryManager *dm) {
     struct message mm;
     memset(&mm, 0, sizeof(struct message));
 
+    /* The daemon packs the queued answers into as few packets as possible.
+     * Send at most UA_MDNS_MAXPACKETSPERCYCLE packets. The rest is sent in the
+     * next cycle. This spreads the answers to a burst of queries (e.g. after
+     * a power-up of the segment) over time. */
     unsigned short sport = 0;
-    while(mdnsd_out(dm->mdnsDaemon, &mm, &ip, &sport) > 0) {
+    size_t packets = 0;
+    while(packets < UA_MDNS_MAXPACKETSPERCYCLE &&
+          mdnsd_out(dm->mdnsDaemon, &mm, &ip, &sport) > 0) {
+        packets++;
         int len = message_packet_len(&mm);
         char* buf = (char*)message_packet(&mm);
         if(len <= 0)
@@ -986,6 +1065,7 @@ UA_DiscoveryManager_stopMulticast(UA_DiscoveryManager *dm) {
         mdnsd_free(dm->mdnsDaemon);
         dm->mdnsDaemon = NULL;
     }
+    mdns_clear_ptr_records(dm);
 
     /* Close the socket */
     if(dm->cm) {
@@ -1254,13 +1334,18 @@ UA_Discovery_addRecord(UA_DiscoveryManager *dm, const UA_String servername,
     /* check if there is already a PTR entry for the given service. */
 
     /* _opcua-tcp._tcp.local. PTR [servername]-[hostname]._opcua-tcp._tcp.local. */
-    mdns_record_t *r =
-        mdns_find_record(dm->mdnsDaemon, QTYPE_PTR,
-                         "_opcua-tcp._tcp.local.", fullServiceDomain);
-    if(!r) {
+    mdns_record_t *r;
+    if(!mdns_ptr_lookup(dm, fullServiceDomain)) {
         r = mdnsd_shared(dm->mdnsDaemon, "_opcua-tcp._tcp.local.",
                          QTYPE_PTR, 600);
         mdnsd_set_host(dm->mdnsDaemon, r, fullServiceDomain);
+        /* Withdraw the record if it cannot be tracked. Otherwise the next
+         * call would not find it and add a duplicate. */
+        retval = mdns_ptr_add(dm, fullServiceDomain, r);
+        if(retval != UA_STATUSCODE_GOOD) {
+            mdnsd_done(dm->mdnsDaemon, r);
+            return retval;
+        }
     }
 
     /* The first 63 characters of the hostname (or less) */
@@ -1325,9 +1410,15 @@ UA_Discovery_removeRecord(UA_DiscoveryManager *dm, const UA_String servername,
         return retval;
 
     /* _opcua-tcp._tcp.local. PTR [servername]-[hostname]._opcua-tcp._tcp.local. */
-    mdns_record_t *r =
-        mdns_find_record(dm->mdnsDaemon, QTYPE_PTR,
-                         "_opcua-tcp._tcp.local.", fullServiceDomain);
+    mdns_record_t *r = NULL;
+    mdnsPtrRecord *pr = mdns_ptr_lookup(dm, fullServiceDomain);
+    if(pr) {
+        r = pr->record;
+        mdns_ptr_remove(pr);
+    } else {
+        r = mdns_find_record(dm->mdnsDaemon, QTYPE_PTR,
+                             "_opcua-tcp._tcp.local.", fullServiceDomain);
+    }
     if(!r) {
         UA_LOG_WARNING(dm->sc.server->config.logging, UA_LOGCATEGORY_DISCOVERY,
                        "Multicast DNS: could not remove record. "
@@ -14,6 +14,8 @@
 #include "ua_server_internal.h"
 #include "../ua_types_encoding_binary.h"
 
+#include <stdlib.h> /* qsort */
+
 /*********************/
 /* ReferenceType Set */
 /*********************/
@@ -301,10 +303,270 @@ removeTreeEntry(void *context, UA_ReferenceTargetTreeElem *elem) {
     return NULL;
 }
 
+/* The compact representation holds three UInt32 arrays of length targetsSize in
+ * one allocation */
+#define COMPACT_IDS(rk) ((rk)->targets.compact)
+#define COMPACT_NAMEHASHES(rk) (&(rk)->targets.compact[(rk)->targetsSize])
+#define COMPACT_NAMEORDER(rk) (&(rk)->targets.compact[2 * (rk)->targetsSize])
+
+/* Returned from findTarget for the compact representation */
+static const UA_ReferenceTarget compactPlaceholder = {{0}, 0};
+
+/* Can the target be stored in the compact representation? The target
+ * generated from the numeric identifier has to be an immediate NodePointer. */
+static UA_Boolean
+compactTargetId(UA_NodePointer target, UA_UInt16 ns, UA_UInt32 *outId) {
+    if(!UA_NodePointer_isLocal(target))
+        return false;
+    UA_NodeId id = UA_NodePointer_toNodeId(target);
+    if(id.identifierType != UA_NODEIDTYPE_NUMERIC || id.namespaceIndex != ns)
+        return false;
+    UA_NodePointer np = UA_NodePointer_fromNodeId(&id);
+    if((np.immediate & UA_NODEPOINTER_MASK) != UA_NODEPOINTER_TAG_IMMEDIATE)
+        return false;
+    *outId = id.identifier.numeric;
+    return true;
+}
+
+static void
+compactTarget(const UA_NodeReferenceKind *rk, size_t pos, UA_ReferenceTarget *t) {
+    UA_NodeId id = UA_NODEID_NUMERIC(rk->compactNamespace, COMPACT_IDS(rk)[pos]);
+    t->targetId = UA_NodePointer_fromNodeId(&id); /* immediate */
+    t->targetNameHash = COMPACT_NAMEHASHES(rk)[pos];
+}
+
+/* Position of the first target with an identifier >= id */
+static size_t
+compactLowerBound(const UA_NodeReferenceKind *rk, UA_UInt32 id) {
+    const UA_UInt32 *ids = COMPACT_IDS(rk);
+    size_t lo = 0, hi = rk->targetsSize;
+    while(lo < hi) {
+        size_t mid = lo + ((hi - lo) / 2);
+        if(ids[mid] < id)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+size_t
+UA_NodeReferenceKind_compactUpperBound(const UA_NodeReferenceKind *rk,
+                                       const UA_NodeId *id) {
+    UA_assert(rk->isCompact);
+    if(id->identifierType != UA_NODEIDTYPE_NUMERIC ||
+       id->namespaceIndex != rk->compactNamespace)
+        return rk->targetsSize;
+    size_t pos = compactLowerBound(rk, id->identifier.numeric);
+    if(pos < rk->targetsSize && COMPACT_IDS(rk)[pos] == id->identifier.numeric)
+        pos++;
+    return pos;
+}
+
+void *
+UA_NodeReferenceKind_iterateCompact(const UA_NodeReferenceKind *rk, size_t pos,
+                                    UA_NodeReferenceKind_iterateCallback callback,
+                                    void *context) {
+    UA_assert(rk->isCompact);
+    UA_ReferenceTarget t;
+    for(; pos < rk->targetsSize; pos++) {
+        compactTarget(rk, pos, &t);
+        void *res = callback(context, &t);
+        if(res)
+            return res;
+    }
+    return NULL;
+}
+
+void *
+UA_NodeReferenceKind_iterateCompactName(const UA_NodeReferenceKind *rk,
+                                        UA_UInt32 nameHash,
+                                        UA_NodeReferenceKind_iterateCallback callback,
+                                        void *context) {
+    UA_assert(rk->isCompact);
+    const UA_UInt32 *hashes = COMPACT_NAMEHASHES(rk);
+    const UA_UInt32 *order = COMPACT_NAMEORDER(rk);
+
+    /* Find the first position in the name order with the hash */
+    size_t lo = 0, hi = rk->targetsSize;
+    while(lo < hi) {
+        size_t mid = lo + ((hi - lo) / 2);
+        if(hashes[order[mid]] < nameHash)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    UA_ReferenceTarget t;
+    for(; lo < rk->targetsSize && hashes[order[lo]] == nameHash; lo++) {
+        compactTarget(rk, order[lo], &t);
+        void *res = callback(context, &t);
+        if(res)
+            return res;
+    }
+    return NULL;
+}
+
+typedef struct {
+    UA_UInt64 *pairs;
+    size_t pairsSize;
+    UA_UInt16 ns;
+} CompactCollectContext;
+
+/* Collect the targets as (identifier, BrowseName hash) pairs */
+static void *
+collectCompactTarget(void *context, UA_ReferenceTarget *t) {
+    CompactCollectContext *cc = (CompactCollectContext*)context;
+    if(cc->pairsSize == 0) {
+        if(!UA_NodePointer_isLocal(t->targetId))
+            return (void*)0x01;
+        cc->ns = UA_NodePointer_toNodeId(t->targetId).namespaceIndex;
+    }
+    UA_UInt32 id;
+    if(!compactTargetId(t->targetId, cc->ns, &id))
+        return (void*)0x01;
+    cc->pairs[cc->pairsSize++] = (((UA_UInt64)id) << 32) | t->targetNameHash;
+    return NULL;
+}
+
+static int
+cmpUInt64(const void *a, const void *b) {
+    UA_UInt64 aa = *(const UA_UInt64*)a;
+    UA_UInt64 bb = *(const UA_UInt64*)b;
+    if(aa == bb)
+        return 0;
+    return (aa < bb) ? -1 : 1;
+}
+
+UA_StatusCode
+UA_NodeReferenceKind_switchCompact(UA_NodeReferenceKind *rk) {
+    UA_assert(rk->targetsSize > 0);
+    if(rk->isCompact)
+        return UA_STATUSCODE_GOOD;
+    if(rk->targetsSize > UA_UINT32_MAX)
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+
+    /* Collect the targets */
+    size_t size = rk->targetsSize;
+    CompactCollectContext cc;
+    cc.pairsSize = 0;
+    cc.ns = 0;
+    cc.pairs = (UA_UInt64*)UA_malloc(sizeof(UA_UInt64) * size);
+    if(!cc.pairs)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    if(UA_NodeReferenceKind_iterate(rk, collectCompactTarget, &cc)) {
+        UA_free(cc.pairs);
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+    }
+    UA_UInt32 *compact = (UA_UInt32*)UA_malloc(sizeof(UA_UInt32) * 3 * size);
+    if(!compact) {
+        UA_free(cc.pairs);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+
+    /* Sort by the identifier */
+    qsort(cc.pairs, size, sizeof(UA_UInt64), cmpUInt64);
+    UA_UInt32 *ids = compact;
+    UA_UInt32 *hashes = &compact[size];
+    UA_UInt32 *order = &compact[2 * size];
+    for(size_t i = 0; i < size; i++) {
+        ids[i] = (UA_UInt32)(cc.pairs[i] >> 32);
+        hashes[i] = (UA_UInt32)cc.pairs[i];
+    }
+
+    /* Sort the positions by the BrowseName hash */
+    for(size_t i = 0; i < size; i++)
+        cc.pairs[i] = (((UA_UInt64)hashes[i]) << 32) | (UA_UInt32)i;
+    qsort(cc.pairs, size, sizeof(UA_UInt64), cmpUInt64);
+    for(size_t i = 0; i < size; i++)
+        order[i] = (UA_UInt32)cc.pairs[i];
+    UA_free(cc.pairs);
+
+    /* Remove the previous representation */
+    if(rk->hasRefTree) {
+        ZIP_ITER(UA_ReferenceIdTree, (UA_ReferenceIdTree*)&rk->targets.tree.idRoot,
+                 removeTreeEntry, NULL);
+    } else {
+        for(size_t i = 0; i < size; i++)
+            UA_NodePointer_clear(&rk->targets.array[i].targetId);
+        UA_free(rk->targets.array);
+    }
+
+    rk->targets.compact = compact;
+    rk->hasRefTree = false;
+    rk->isCompact = true;
+    rk->compactNamespace = cc.ns;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Remove the target at the position. Moves the arrays within the allocation
+ * and cannot fail. Frees the allocation when the last target is removed. */
+static void
+compactRemove(UA_NodeReferenceKind *rk, size_t pos) {
+    size_t n = rk->targetsSize;
+    UA_UInt32 *c = rk->targets.compact;
+    if(n == 1) {
+        UA_free(c);
+        rk->targets.compact = NULL;
+        rk->targetsSize = 0;
+        return;
+    }
+
+    /* Identifiers */
+    memmove(&c[pos], &c[pos+1], sizeof(UA_UInt32) * (n - 1 - pos));
+
+    /* BrowseName hashes from offset n to n-1 */
+    memmove(&c[n-1], &c[n], sizeof(UA_UInt32) * pos);
+    memmove(&c[n-1+pos], &c[n+pos+1], sizeof(UA_UInt32) * (n - 1 - pos));
+
+    /* Name order from offset 2n to 2n-2. Skip the removed position and shift
+     * the positions behind it. The target index is never behind the source
+     * index. */
+    size_t j = 0;
+    for(size_t k = 0; k < n; k++) {
+        UA_UInt32 o = c[2*n + k];
+        if(o == pos)
+            continue;
+        c[2*n - 2 + j] = (o > pos) ? o - 1 : o;
+        j++;
+    }
+
+    rk->targetsSize = n - 1;
+    UA_UInt32 *shrunk = (UA_UInt32*)
+        UA_realloc(c, sizeof(UA_UInt32) * 3 * (n - 1));
+    if(shrunk)
+        rk->targets.compact = shrunk; /* Realloc allowed to fail */
+}
+
 UA_StatusCode
 UA_NodeReferenceKind_switch(UA_NodeReferenceKind *rk) {
     UA_assert(rk->targetsSize > 0);
 
+    if(rk->isCompact) {
+        /* From compact to tree */
+        UA_NodeReferenceKind newRk = *rk;
+        newRk.isCompact = false;
+        newRk.hasRefTree = true;
+        newRk.targets.tree.idRoot = NULL;
+        newRk.targets.tree.nameRoot = NULL;
+        newRk.targetsSize = 0;
+        UA_ReferenceTarget t;
+        for(size_t i = 0; i < rk->targetsSize; i++) {
+            compactTarget(rk, i, &t);
+            UA_StatusCode res = addReferenceTarget(&newRk, t.targetId,
+                                                   t.targetNameHash);
+            if(res != UA_STATUSCODE_GOOD) {
+                ZIP_ITER(UA_ReferenceIdTree,
+                         (UA_ReferenceIdTree*)&newRk.targets.tree.idRoot,
+                         removeTreeEntry, NULL);
+                return res;
+            }
+        }
+        UA_free(rk->targets.compact);
+        *rk = newRk;
+        return UA_STATUSCODE_GOOD;
+    }
+
     if(rk->hasRefTree) {
         /* From tree to array */
         UA_ReferenceTarget *array = (UA_ReferenceTarget*)
@@ -346,6 +608,8 @@ void *
 UA_NodeReferenceKind_iterate(UA_NodeReferenceKind *rk,
                              UA_NodeReferenceKind_iterateCallback callback,
                              void *context) {
+    if(rk->isCompact)
+        return UA_NodeReferenceKind_iterateCompact(rk, 0, callback, context);
     if(rk->hasRefTree)
         return ZIP_ITER(UA_ReferenceIdTree,
                         (UA_ReferenceIdTree*)&rk->targets.tree.idRoot,
@@ -362,7 +626,15 @@ const UA_ReferenceTarget *
 UA_NodeReferenceKind_findTarget(const UA_NodeReferenceKind *rk,
                                 const UA_ExpandedNodeId *targetId) {
     UA_NodePointer targetP = UA_NodePointer_fromExpandedNodeId(targetId);
-    if(rk->hasRefTree) {
+    if(rk->isCompact) {
+        /* Binary search for the numeric identifier */
+        UA_UInt32 id;
+        if(!compactTargetId(targetP, rk->compactNamespace, &id))
+            return NULL;
+        size_t pos = compactLowerBound(rk, id);
+        if(pos < rk->targetsSize && COMPACT_IDS(rk)[pos] == id)
+            return &compactPlaceholder;
+    } else if(rk->hasRefTree) {
         /* Return from the tree */
         UA_ReferenceTargetTreeElem tmpTarget;
         tmpTarget.target.targetId = targetP;
@@ -408,6 +680,9 @@ void UA_Node_clear(UA_Node *node) {
         UA_free(lt);
     }
 
+    UA_free(head->roleMasks);
+    head->roleMasks = NULL;
+
     /* Delete unique content of the nodeclass */
     switch(head->nodeClass) {
     case UA_NODECLASS_OBJECT:
@@ -476,6 +751,11 @@ UA_VariableNode_copy(const UA_VariableNode *src, UA_VariableNode *dst) {
     dst->minimumSamplingInterval = src->minimumSamplingInterval;
     dst->historizing = src->historizing;
     dst->isDynamic = src->isDynamic;
+#if UA_MULTITHREADING >= 100
+    dst->async = src->async;
+#endif
+    dst->readBatch = src->readBatch;
+    dst->readBatchDevice = src->readBatchDevice;
     return UA_CommonVariableNode_copy(src, dst);
 }
 
@@ -576,12 +856,21 @@ UA_Node_copy(const UA_Node *src, UA_Node *dst) {
         dsthead->description= newEntry;
     }
 
+    dsthead->nodeIdHash = srchead->nodeIdHash;
     dsthead->writeMask = srchead->writeMask;
     dsthead->context = srchead->context;
     dsthead->constructed = srchead->constructed;
 #ifdef UA_ENABLE_SUBSCRIPTIONS
     dsthead->monitoredItems = srchead->monitoredItems;
 #endif
+    dsthead->roleMasks = NULL;
+    if(srchead->roleMasks) {
+        dsthead->roleMasks = (UA_NodeRoleMasks*)UA_malloc(sizeof(UA_NodeRoleMasks));
+        if(dsthead->roleMasks)
+            *dsthead->roleMasks = *srchead->roleMasks;
+        else
+            retval |= UA_STATUSCODE_BADOUTOFMEMORY;
+    }
     if(retval != UA_STATUSCODE_GOOD) {
         UA_Node_clear(dst);
         return retval;
@@ -606,7 +895,18 @@ UA_Node_copy(const UA_Node *src, UA_Node *dst) {
             drefs->hasRefTree = srefs->hasRefTree; /* initially empty */
 
             /* Copy all the targets */
-            if(!srefs->hasRefTree) {
+            if(srefs->isCompact) {
+                size_t len = sizeof(UA_UInt32) * 3 * srefs->targetsSize;
+                drefs->targets.compact = (UA_UInt32*)UA_malloc(len);
+                if(!drefs->targets.compact) {
+                    UA_Node_clear(dst);
+                    return UA_STATUSCODE_BADOUTOFMEMORY;
+                }
+                memcpy(drefs->targets.compact, srefs->targets.compact, len);
+                drefs->isCompact = true;
+                drefs->compactNamespace = srefs->compactNamespace;
+                drefs->targetsSize = srefs->targetsSize;
+            } else if(!srefs->hasRefTree) {
                 drefs->targets.array = (UA_ReferenceTarget*)
                     UA_malloc(sizeof(UA_ReferenceTarget) * srefs->targetsSize);
                 if(!drefs->targets.array) {
@@ -1002,9 +1302,28 @@ UA_Node_addReference(UA_Node *node, UA_Byte refTypeIndex, UA_Boolean isForward,
         if(found)
             return UA_STATUSCODE_BADDUPLICATEREFERENCENOTALLOWED;
 
+        /* The compact representation is not modified. Switch to the tree
+         * first. */
+        UA_StatusCode res;
+        if(refs->isCompact) {
+            res = UA_NodeReferenceKind_switch(refs);
+            if(res != UA_STATUSCODE_GOOD)
+                return res;
+        }
+
         /* Add to existing ReferenceKind */
-        return addReferenceTarget(refs, UA_NodePointer_fromExpandedNodeId(targetNodeId),
-                                  targetBrowseNameHash);
+        res = addReferenceTarget(refs, UA_NodePointer_fromExpandedNodeId(targetNodeId),
+                                 targetBrowseNameHash);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+
+        /* Switch wide ReferenceKinds to the tree representation. That gives
+         * every node with many children an index by the target BrowseName
+         * hash, independent of the nodestore implementation. The switch keeps
+         * the array if it fails. */
+        if(!refs->hasRefTree && refs->targetsSize > UA_NODE_REFTREE_THRESHOLD)
+            UA_NodeReferenceKind_switch(refs);
+        return UA_STATUSCODE_GOOD;
     }
 
     /* Add new ReferenceKind for the target */
@@ -1025,6 +1344,21 @@ UA_Node_deleteReference(UA_Node *node, UA_Byte refTypeIndex, UA_Boolean isForwar
         if(refTypeIndex != refs->referenceTypeIndex)
             continue;
 
+        /* Remove from the compact representation */
+        if(refs->isCompact) {
+            UA_UInt32 id;
+            UA_NodePointer targetP = UA_NodePointer_fromExpandedNodeId(targetNodeId);
+            if(!compactTargetId(targetP, refs->compactNamespace, &id))
+                continue;
+            size_t pos = compactLowerBound(refs, id);
+            if(pos == refs->targetsSize || COMPACT_IDS(refs)[pos] != id)
+                continue;
+            compactRemove(refs, pos);
+            if(refs->targetsSize > 0)
+                return UA_STATUSCODE_GOOD;
+            goto remove_kind;
+        }
+
         /* Cast out the const qualifier (hack!) */
         UA_ReferenceTarget *target = (UA_ReferenceTarget*)(uintptr_t)
             UA_NodeReferenceKind_findTarget(refs, targetNodeId);
@@ -1065,6 +1399,7 @@ UA_Node_deleteReference(UA_Node *node, UA_Byte refTypeIndex, UA_Boolean isForwar
         }
 
         /* No targets remaining. Remove the ReferenceKind. */
+    remove_kind:
         head->referencesSize--;
         if(head->referencesSize > 0) {
             /* No target for the ReferenceType remaining. Remove and shrink down
@@ -1098,7 +1433,9 @@ UA_Node_deleteReferencesSubset(UA_Node *node, const UA_ReferenceTypeSet *keepSet
 
         /* Remove all target entries. Don't remove entries from browseName tree.
          * The entire ReferenceKind will be removed anyway. */
-        if(!refs->hasRefTree) {
+        if(refs->isCompact) {
+            UA_free(refs->targets.compact);
+        } else if(!refs->hasRefTree) {
             for(size_t j = 0; j < refs->targetsSize; j++)
                 UA_NodePointer_clear(&refs->targets.array[j].targetId);
             UA_free(refs->targets.array);
@@ -60,15 +60,73 @@ setupNs1Uri(UA_Server *server) {
     }
 }
 
+#define UA_NAMESPACESHASH_MINCAPACITY 16
+
+static size_t
+namespacesHashSlot(const UA_Server *server, const UA_String *uri) {
+    return UA_ByteString_hash(0, uri->data, uri->length) &
+        (server->namespacesHashCapacity - 1);
+}
+
+static void
+insertNamespacesHash(UA_Server *server, size_t nsIndex) {
+    size_t mask = server->namespacesHashCapacity - 1;
+    size_t slot = namespacesHashSlot(server, &server->namespaces[nsIndex]);
+    while(server->namespacesHash[slot] != 0)
+        slot = (slot + 1) & mask;
+    server->namespacesHash[slot] = (UA_UInt32)nsIndex + 1;
+}
+
+/* Keep the load factor below one half. Rebuild the table when it grows. */
+static UA_StatusCode
+reserveNamespacesHash(UA_Server *server, size_t entries) {
+    if(entries * 2 <= server->namespacesHashCapacity)
+        return UA_STATUSCODE_GOOD;
+    size_t capacity = (server->namespacesHashCapacity > 0) ?
+        server->namespacesHashCapacity : UA_NAMESPACESHASH_MINCAPACITY;
+    while(entries * 2 > capacity)
+        capacity *= 2;
+    UA_UInt32 *hash = (UA_UInt32*)UA_calloc(capacity, sizeof(UA_UInt32));
+    UA_CHECK_MEM(hash, return UA_STATUSCODE_BADOUTOFMEMORY);
+    UA_free(server->namespacesHash);
+    server->namespacesHash = hash;
+    server->namespacesHashCapacity = capacity;
+    for(size_t i = 2; i < server->namespacesSize; i++)
+        insertNamespacesHash(server, i);
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Returns namespacesSize if the namespace is not found */
+static size_t
+findNamespace(const UA_Server *server, const UA_String *uri) {
+    for(size_t i = 0; i < 2 && i < server->namespacesSize; i++) {
+        if(UA_String_equal(uri, &server->namespaces[i]))
+            return i;
+    }
+    if(server->namespacesHashCapacity == 0)
+        return server->namespacesSize;
+    size_t mask = server->namespacesHashCapacity - 1;
+    for(size_t slot = namespacesHashSlot(server, uri);
+        server->namespacesHash[slot] != 0; slot = (slot + 1) & mask) {
+        size_t nsIndex = server->namespacesHash[slot] - 1;
+        if(UA_String_equal(uri, &server->namespaces[nsIndex]))
+            return nsIndex;
+    }
+    return server->namespacesSize;
+}
+
 UA_UInt16 addNamespace(UA_Server *server, const UA_String name) {
     /* ensure that the uri for ns1 is set up from the app description */
     setupNs1Uri(server);
 
     /* Check if the namespace already exists in the server's namespace array */
-    for(size_t i = 0; i < server->namespacesSize; ++i) {
-        if(UA_String_equal(&name, &server->namespaces[i]))
-            return (UA_UInt16) i;
-    }
+    size_t found = findNamespace(server, &name);
+    if(found < server->namespacesSize)
+        return (UA_UInt16)found;
+
+    /* Make room in the lookup table */
+    UA_StatusCode retval = reserveNamespacesHash(server, server->namespacesSize - 1);
+    UA_CHECK_STATUS(retval, return 0);
 
     /* Make the array bigger */
     UA_String *newNS = (UA_String*)UA_realloc(server->namespaces,
@@ -78,10 +136,11 @@ UA_UInt16 addNamespace(UA_Server *server, const UA_String name) {
     server->namespaces = newNS;
 
     /* Copy the namespace string */
-    UA_StatusCode retval = UA_String_copy(&name, &server->namespaces[server->namespacesSize]);
+    retval = UA_String_copy(&name, &server->namespaces[server->namespacesSize]);
     UA_CHECK_STATUS(retval, return 0);
 
     /* Announce the change (otherwise, the array appears unchanged) */
+    insertNamespacesHash(server, server->namespacesSize);
     ++server->namespacesSize;
     return (UA_UInt16)(server->namespacesSize - 1);
 }
@@ -100,6 +159,8 @@ UA_UInt16 UA_Server_addNamespace(UA_Server *server, const char* name) {
 UA_ServerConfig*
 UA_Server_getConfig(UA_Server *server) {
     UA_CHECK_MEM(server, return NULL);
+    /* The config can be modified through the returned pointer */
+    server->endpointsEpoch++;
     return &server->config;
 }
 
@@ -108,15 +169,11 @@ getNamespaceByName(UA_Server *server, const UA_String namespaceUri,
                    size_t *foundIndex) {
     /* ensure that the uri for ns1 is set up from the app description */
     setupNs1Uri(server);
-    UA_StatusCode res = UA_STATUSCODE_BADNOTFOUND;
-    for(size_t idx = 0; idx < server->namespacesSize; idx++) {
-        if(UA_String_equal(&server->namespaces[idx], &namespaceUri)) {
-            (*foundIndex) = idx;
-            res = UA_STATUSCODE_GOOD;
-            break;
-        }
-    }
-    return res;
+    size_t idx = findNamespace(server, &namespaceUri);
+    if(idx >= server->namespacesSize)
+        return UA_STATUSCODE_BADNOTFOUND;
+    *foundIndex = idx;
+    return UA_STATUSCODE_GOOD;
 }
 
 UA_StatusCode
@@ -422,6 +479,7 @@ UA_Server_delete(UA_Server *server) {
         UA_Server_removeSession(server, current, UA_SHUTDOWNREASON_CLOSE);
     }
     UA_Array_delete(server->namespaces, server->namespacesSize, &UA_TYPES[UA_TYPES_STRING]);
+    UA_free(server->namespacesHash);
 
 #ifdef UA_ENABLE_SUBSCRIPTIONS
     /* Remove subscriptions without a session */
@@ -439,13 +497,23 @@ UA_Server_delete(UA_Server *server) {
 #if UA_MULTITHREADING >= 100
     UA_AsyncManager_clear(&server->asyncManager, server);
 #endif
+#ifdef UA_REQUEST_EXECUTOR
+    UA_RequestExecutor_clear(&server->requestExecutor);
+#endif
+#if UA_MULTITHREADING >= 200 && defined(UA_ARCHITECTURE_POSIX)
+    UA_ParallelReadPool_clear(&server->parallelReadPool);
+#endif
 
     /* Clean up the Admin Session */
     UA_Session_clear(&server->adminSession, server);
 #ifdef UA_ENABLE_SUBSCRIPTIONS
     server->adminSubscription = NULL;
     UA_assert(server->monitoredItemsSize == 0);
+    UA_assert(LIST_EMPTY(&server->samplingGroups));
+    UA_assert(TAILQ_EMPTY(&server->initialSamples));
+    UA_assert(LIST_EMPTY(&server->publishGroups));
     UA_assert(server->subscriptionsSize == 0);
+    UA_NotificationPool_clear(&server->notificationPool);
 #endif
 
     /* Remove all server components (all stopped by now) */
@@ -457,6 +525,30 @@ UA_Server_delete(UA_Server *server) {
         UA_free(top);
     }
 
+    /* Remembered certificates of the SecureChannels */
+    UA_CertificateCache_clear(&server->certificateCache);
+
+    clearTypeHierarchy(server);
+    clearBrowsePathCache(server);
+    clearEndpointsCache(server);
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    clearEventRouteCache(server);
+#endif
+#ifdef UA_ENABLE_METHODCALLS
+    clearMethodCallCache(server);
+#endif
+    UA_Array_delete(server->bulkLoadNodes, server->bulkLoadNodesSize,
+                    &UA_TYPES[UA_TYPES_NODEID]);
+
+    /* Release the nodes held by the value handles */
+    clearValueHandles(server);
+
+    /* Values retired while nodes were pinned for Read responses */
+    UA_Array_delete(server->retiredValues, server->retiredValuesSize,
+                    &UA_TYPES[UA_TYPES_DATAVALUE]);
+
+    UA_Arena_clear(&server->requestArena);
+
     UA_UNLOCK(&server->serviceMutex); /* The timer has its own mutex */
 
     /* Clean up the config */
@@ -468,21 +560,15 @@ UA_Server_delete(UA_Server *server) {
 
     UA_GDSTransaction_clear(&server->transaction);
 
+#ifdef UA_ENABLE_DIAGNOSTICS
+    UA_free(server->serviceStats);
+#endif
+
     /* Delete the server itself and return */
     UA_free(server);
     return UA_STATUSCODE_GOOD;
 }
 
-/* Regular house-keeping tasks. Removing unused and timed-out channels and
- * sessions. */
-static void
-serverHouseKeeping(UA_Server *server, void *_) {
-    UA_LOCK(&server->serviceMutex);
-    UA_EventLoop *el = server->config.eventLoop;
-    UA_Server_cleanupSessions(server, el->dateTime_nowMonotonic(el));
-    UA_UNLOCK(&server->serviceMutex);
-}
-
 /********************/
 /* Server Lifecycle */
 /********************/
@@ -510,6 +596,7 @@ UA_Server_init(UA_Server *server) {
 #endif
 
     UA_LOCK_INIT(&server->serviceMutex);
+    UA_LOCK_SETRANK(&server->serviceMutex, UA_LOCKRANK_SERVICE);
     UA_LOCK(&server->serviceMutex);
 
     /* Initialize the adminSession */
@@ -537,6 +624,8 @@ UA_Server_init(UA_Server *server) {
 
     /* Initialize Session Management */
     LIST_INIT(&server->sessions);
+    ZIP_INIT(&server->sessionsByToken);
+    ZIP_INIT(&server->sessionsById);
     server->sessionCount = 0;
 
     /* Initialize SecureChannel */
@@ -545,14 +634,43 @@ UA_Server_init(UA_Server *server) {
     server->lastChannelId = STARTCHANNELID;
     server->lastTokenId = STARTTOKENID;
 
+    /* Initialize the BrowsePath cache */
+    TAILQ_INIT(&server->browsePathCache.lru);
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    TAILQ_INIT(&server->initialSamples);
+#endif
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    TAILQ_INIT(&server->eventRouteCache.lru);
+#endif
+#ifdef UA_ENABLE_METHODCALLS
+    TAILQ_INIT(&server->methodCallCache.lru);
+#endif
+
 #if UA_MULTITHREADING >= 100
     UA_AsyncManager_init(&server->asyncManager, server);
 #endif
+#ifdef UA_REQUEST_EXECUTOR
+    UA_RequestExecutor_init(&server->requestExecutor);
+#endif
+#if UA_MULTITHREADING >= 200 && defined(UA_ARCHITECTURE_POSIX)
+    UA_ParallelReadPool_init(&server->parallelReadPool);
+#endif
+
+    /* Initialize the service statistics */
+#ifdef UA_ENABLE_DIAGNOSTICS
+    server->serviceStats = (UA_ServiceStats*)
+        UA_calloc(serviceDescriptionsSize, sizeof(UA_ServiceStats));
+    UA_CHECK_MEM(server->serviceStats, goto cleanup);
+#endif
 
     /* Initialize namespace 0*/
     res = initNS0(server);
     UA_CHECK_STATUS(res, goto cleanup);
 
+    /* Pack the namespace 0 nodes in the Nodestore */
+    if(server->config.nodestore.compact)
+        server->config.nodestore.compact(server->config.nodestore.context);
+
 #ifdef UA_ENABLE_NODESET_INJECTOR
     UA_UNLOCK(&server->serviceMutex);
     res = UA_Server_injectNodesets(server);
@@ -563,6 +681,9 @@ UA_Server_init(UA_Server *server) {
     /* Initialize the binay protocol support */
     addServerComponent(server, UA_BinaryProtocolManager_new(server), NULL);
 
+    /* Initialize the replication to a standby server */
+    addServerComponent(server, UA_ReplicationManager_new(server), NULL);
+
     /* Initialized Discovery */
 #ifdef UA_ENABLE_DISCOVERY
     addServerComponent(server, UA_DiscoveryManager_new(), NULL);
@@ -761,6 +882,7 @@ UA_Server_updateCertificate(UA_Server *server,
         UA_String_clear(&ed->serverCertificate);
         UA_String_copy(&certificate, &ed->serverCertificate);
     }
+    server->endpointsEpoch++;
 
     UA_DelayedCallback *dc = (UA_DelayedCallback*)UA_calloc(1, sizeof(UA_DelayedCallback));
     if(!dc)
@@ -887,8 +1009,15 @@ verifyServerApplicationURI(const UA_Server *server) {
 
 UA_ServerStatistics
 UA_Server_getStatistics(UA_Server *server) {
+    UA_LOCK(&server->serviceMutex);
     UA_ServerStatistics stat;
     stat.scs = server->secureChannelStatistics;
+    stat.scs.certificateCacheHitCount = server->certificateCache.hits;
+    UA_SecureChannel *channel;
+    TAILQ_FOREACH(channel, &server->channels, serverEntry) {
+        stat.scs.securedChunksSentCount += channel->securedChunksSent;
+        stat.scs.securedChunksReceivedCount += channel->securedChunksReceived;
+    }
     UA_ServerDiagnosticsSummaryDataType *sds = &server->serverDiagnosticsSummary;
     stat.ss.currentSessionCount = server->activeSessionCount;
     stat.ss.cumulatedSessionCount = sds->cumulatedSessionCount;
@@ -896,9 +1025,173 @@ UA_Server_getStatistics(UA_Server *server) {
     stat.ss.rejectedSessionCount = sds->rejectedSessionCount;
     stat.ss.sessionTimeoutCount = sds->sessionTimeoutCount;
     stat.ss.sessionAbortCount = sds->sessionAbortCount;
+    stat.ss.sessionLookupCount = server->sessionLookupCount;
+    stat.ss.sessionLookupSteps = server->sessionLookupSteps;
+    memset(&stat.ns, 0, sizeof(UA_NotificationStatistics));
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    UA_NotificationPool *pool = &server->notificationPool;
+    stat.ns.notificationCount = pool->notificationsInUse;
+    stat.ns.notificationHighWaterMark = pool->notificationsHighWaterMark;
+    stat.ns.notificationPoolSize = pool->freeNotificationsSize;
+    stat.ns.retransmissionCount = pool->entriesInUse;
+    stat.ns.retransmissionHighWaterMark = pool->entriesHighWaterMark;
+    stat.ns.retransmissionPoolSize = pool->freeEntriesSize;
+    stat.ns.subscriptionCount = server->subscriptionsSize;
+    stat.ns.monitoredItemCount = server->monitoredItemsSize;
+#endif
+    memset(&stat.ps, 0, sizeof(UA_PubSubStatistics));
+#ifdef UA_ENABLE_PUBSUB
+    UA_PubSubManager_getStatistics(server, &stat.ps);
+#endif
+    UA_UNLOCK(&server->serviceMutex);
     return stat;
 }
 
+static void
+countNode(void *visitorCtx, const UA_Node *node) {
+    (void)node;
+    (*(size_t*)visitorCtx)++;
+}
+
+static void
+setReportEntry(UA_MemoryReportEntry *entry, size_t objects,
+               const UA_MemoryStatistics *ms) {
+    entry->objects = objects;
+    entry->bytesInUse = ms->bytesInUse;
+    entry->blocksInUse = ms->blocksInUse;
+    entry->bytesPerObject = (objects > 0) ? ms->bytesInUse / objects : 0;
+}
+
+UA_StatusCode
+UA_Server_getMemoryReport(UA_Server *server, UA_MemoryReport *report) {
+    memset(report, 0, sizeof(UA_MemoryReport));
+    UA_LOCK(&server->serviceMutex);
+
+    /* Count the objects */
+    size_t nodes = 0;
+    server->config.nodestore.iterate(server->config.nodestore.context,
+                                     countNode, &nodes);
+    size_t subscriptions = 0;
+    size_t monitoredItems = 0;
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    subscriptions = server->subscriptionsSize;
+    monitoredItems = server->monitoredItemsSize;
+#endif
+
+    /* Get the statistics per category */
+    UA_StatusCode res = UA_STATUSCODE_BADNOTSUPPORTED;
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+    UA_Allocator *a = UA_Allocator_get();
+    if(a && a->getStatistics) {
+        res = UA_STATUSCODE_GOOD;
+        for(size_t i = 0; i < UA_MEMORYCATEGORIES; i++)
+            res |= a->getStatistics(a, (UA_MemoryCategory)i, &report->categories[i]);
+    }
+#endif
+
+    setReportEntry(&report->sessions, server->sessionCount,
+                   &report->categories[UA_MEMORYCATEGORY_SESSIONS]);
+    setReportEntry(&report->subscriptions, subscriptions,
+                   &report->categories[UA_MEMORYCATEGORY_SUBSCRIPTIONS]);
+    setReportEntry(&report->monitoredItems, monitoredItems,
+                   &report->categories[UA_MEMORYCATEGORY_MONITOREDITEMS]);
+    setReportEntry(&report->nodes, nodes,
+                   &report->categories[UA_MEMORYCATEGORY_NODESTORE]);
+    UA_UNLOCK(&server->serviceMutex);
+    return res;
+}
+
+#ifdef UA_ENABLE_DIAGNOSTICS
+
+void
+UA_ServiceStats_get(const UA_ServiceStats *ss, UA_ServiceStatistics *stats) {
+    const UA_LatencyHistogram *h = &ss->latency;
+    memset(stats, 0, sizeof(UA_ServiceStatistics));
+    stats->requestCount = ss->requestCount;
+    stats->errorCount = ss->errorCount;
+    stats->operationCount = ss->operationCount;
+    stats->asyncCount = ss->asyncCount;
+    stats->queueDepthHighWaterMark = ss->queueDepthHighWaterMark;
+    if(h->count == 0)
+        return;
+    stats->latencyMean = ((UA_Double)h->sum / (UA_Double)h->count) / UA_DATETIME_MSEC;
+    stats->latencyP50 = (UA_Double)UA_LatencyHistogram_percentile(h, 0.5) / UA_DATETIME_MSEC;
+    stats->latencyP90 = (UA_Double)UA_LatencyHistogram_percentile(h, 0.9) / UA_DATETIME_MSEC;
+    stats->latencyP99 = (UA_Double)UA_LatencyHistogram_percentile(h, 0.99) / UA_DATETIME_MSEC;
+    stats->latencyP999 = (UA_Double)UA_LatencyHistogram_percentile(h, 0.999) / UA_DATETIME_MSEC;
+    stats->latencyMax = (UA_Double)h->max / UA_DATETIME_MSEC;
+}
+
+static void
+mergeServiceStats(UA_ServiceStats *dst, const UA_ServiceStats *src) {
+    dst->requestCount += src->requestCount;
+    dst->errorCount += src->errorCount;
+    dst->operationCount += src->operationCount;
+    dst->asyncCount += src->asyncCount;
+    if(src->queueDepthHighWaterMark > dst->queueDepthHighWaterMark)
+        dst->queueDepthHighWaterMark = src->queueDepthHighWaterMark;
+    UA_LatencyHistogram_merge(&dst->latency, &src->latency);
+}
+
+UA_StatusCode
+UA_Server_getServiceStatistics(UA_Server *server, const UA_DataType *requestType,
+                               UA_ServiceStatistics *stats) {
+    UA_LOCK(&server->serviceMutex);
+
+    /* Combine the statistics of all services */
+    if(!requestType) {
+        UA_ServiceStats *all = (UA_ServiceStats*)UA_calloc(1, sizeof(UA_ServiceStats));
+        if(!all) {
+            UA_UNLOCK(&server->serviceMutex);
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        }
+        for(size_t i = 0; i < serviceDescriptionsSize; i++)
+            mergeServiceStats(all, &server->serviceStats[i]);
+        UA_ServiceStats_get(all, stats);
+        UA_free(all);
+        UA_UNLOCK(&server->serviceMutex);
+        return UA_STATUSCODE_GOOD;
+    }
+
+    for(size_t i = 0; i < serviceDescriptionsSize; i++) {
+        if(serviceDescriptions[i].requestType != requestType)
+            continue;
+        UA_ServiceStats_get(&server->serviceStats[i], stats);
+        UA_UNLOCK(&server->serviceMutex);
+        return UA_STATUSCODE_GOOD;
+    }
+
+    UA_UNLOCK(&server->serviceMutex);
+    return UA_STATUSCODE_BADSERVICEUNSUPPORTED;
+}
+
+UA_StatusCode
+UA_Server_getSessionServiceStatistics(UA_Server *server, const UA_NodeId *sessionId,
+                                      UA_ServiceStatistics *stats) {
+    UA_LOCK(&server->serviceMutex);
+    UA_Session *session = getSessionById(server, sessionId);
+    if(!session) {
+        UA_UNLOCK(&server->serviceMutex);
+        return UA_STATUSCODE_BADSESSIONIDINVALID;
+    }
+    UA_ServiceStats_get(&session->serviceStats, stats);
+    UA_UNLOCK(&server->serviceMutex);
+    return UA_STATUSCODE_GOOD;
+}
+
+void
+UA_Server_resetServiceStatistics(UA_Server *server) {
+    UA_LOCK(&server->serviceMutex);
+    memset(server->serviceStats, 0, serviceDescriptionsSize * sizeof(UA_ServiceStats));
+    session_list_entry *sentry;
+    LIST_FOREACH(sentry, &server->sessions, pointers) {
+        memset(&sentry->session.serviceStats, 0, sizeof(UA_ServiceStats));
+    }
+    UA_UNLOCK(&server->serviceMutex);
+}
+
+#endif /* UA_ENABLE_DIAGNOSTICS */
+
 /********************/
 /* Main Server Loop */
 /********************/
@@ -975,6 +1268,9 @@ UA_Server_run_startup(UA_Server *server) {
                        config->logging, UA_LOGCATEGORY_SERVER,
                        "An EventLoop must be configured");
 
+    /* Pin the thread before the EventLoop maps its buffers */
+    applyThreadPlacement(server, &config->eventLoopPlacement, "EventLoop thread");
+
     if(el->state != UA_EVENTLOOPSTATE_STARTED) {
         retVal = el->start(el);
         UA_CHECK_STATUS(retVal, return retVal); /* Errors are logged internally */
@@ -991,6 +1287,9 @@ UA_Server_run_startup(UA_Server *server) {
     /* Add regulare callback for async operation processing */
     UA_AsyncManager_start(&server->asyncManager, server);
 #endif
+#ifdef UA_REQUEST_EXECUTOR
+    UA_RequestExecutor_start(&server->requestExecutor, server);
+#endif
 
     /* Are there enough SecureChannels possible for the max number of sessions? */
     if(config->maxSecureChannels != 0 &&
@@ -1000,13 +1299,6 @@ UA_Server_run_startup(UA_Server *server) {
                        "maximum Sessions count");
     }
 
-    /* Add a regular callback for housekeeping tasks. With a 1s interval. */
-    retVal = addRepeatedCallback(server, serverHouseKeeping,
-                                 NULL, 1000.0, &server->houseKeepingCallbackId);
-    UA_CHECK_STATUS_ERROR(retVal, UA_UNLOCK(&server->serviceMutex); return retVal,
-                          config->logging, UA_LOGCATEGORY_SERVER,
-                          "Could not create the server housekeeping task");
-
     /* Ensure that the uri for ns1 is set up from the app description */
     UA_String_clear(&server->namespaces[1]);
     setupNs1Uri(server);
@@ -1126,12 +1418,6 @@ UA_Server_run_shutdown(UA_Server *server) {
     UA_AsyncManager_stop(&server->asyncManager, server);
 #endif
 
-    /* Stop the regular housekeeping tasks */
-    if(server->houseKeepingCallbackId != 0) {
-        removeCallback(server, server->houseKeepingCallbackId);
-        server->houseKeepingCallbackId = 0;
-    }
-
     /* Stop all ServerComponents */
     ZIP_ITER(UA_ServerComponentTree, &server->serverComponents,
              stopServerComponent, NULL);
@@ -1143,6 +1429,9 @@ UA_Server_run_shutdown(UA_Server *server) {
 
     /* Only stop the EventLoop if it is coupled to the server lifecycle  */
     if(server->config.externalEventLoop) {
+#ifdef UA_REQUEST_EXECUTOR
+        UA_RequestExecutor_stop(&server->requestExecutor, server);
+#endif
         UA_UNLOCK(&server->serviceMutex);
         return UA_STATUSCODE_GOOD;
     }
@@ -1167,6 +1456,11 @@ UA_Server_run_shutdown(UA_Server *server) {
         UA_LOCK(&server->serviceMutex);
     }
 
+#ifdef UA_REQUEST_EXECUTOR
+    /* Stop the request workers after the SecureChannels are closed */
+    UA_RequestExecutor_stop(&server->requestExecutor, server);
+#endif
+
     /* Set server lifecycle state to stopped if not already the case */
     setServerLifecycleState(server, UA_LIFECYCLESTATE_STOPPED);
 
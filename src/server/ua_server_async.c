@@ -10,11 +10,61 @@
 
 #if UA_MULTITHREADING >= 100
 
+static const UA_DataType *
+asyncOperationRequestType(UA_AsyncOperationType type) {
+    switch(type) {
+    case UA_ASYNCOPERATIONTYPE_CALL: return &UA_TYPES[UA_TYPES_CALLMETHODREQUEST];
+    case UA_ASYNCOPERATIONTYPE_READ: return &UA_TYPES[UA_TYPES_READVALUEID];
+    case UA_ASYNCOPERATIONTYPE_WRITE: return &UA_TYPES[UA_TYPES_WRITEVALUE];
+    default: return NULL;
+    }
+}
+
+static const UA_DataType *
+asyncOperationResultType(UA_AsyncOperationType type) {
+    switch(type) {
+    case UA_ASYNCOPERATIONTYPE_CALL: return &UA_TYPES[UA_TYPES_CALLMETHODRESULT];
+    case UA_ASYNCOPERATIONTYPE_READ: return &UA_TYPES[UA_TYPES_DATAVALUE];
+    case UA_ASYNCOPERATIONTYPE_WRITE: return &UA_TYPES[UA_TYPES_STATUSCODE];
+    default: return NULL;
+    }
+}
+
+static const UA_DataType *
+asyncResponseType(UA_AsyncOperationType type) {
+    switch(type) {
+    case UA_ASYNCOPERATIONTYPE_CALL: return &UA_TYPES[UA_TYPES_CALLRESPONSE];
+    case UA_ASYNCOPERATIONTYPE_READ: return &UA_TYPES[UA_TYPES_READRESPONSE];
+    case UA_ASYNCOPERATIONTYPE_WRITE: return &UA_TYPES[UA_TYPES_WRITERESPONSE];
+    default: return NULL;
+    }
+}
+
 static void
-UA_AsyncOperation_delete(UA_AsyncOperation *ar) {
-    UA_CallMethodRequest_clear(&ar->request);
-    UA_CallMethodResult_clear(&ar->response);
-    UA_free(ar);
+UA_AsyncOperation_delete(UA_AsyncOperation *ao) {
+    UA_clear(&ao->request, asyncOperationRequestType(ao->type));
+    UA_clear(&ao->response, asyncOperationResultType(ao->type));
+    UA_free(ao);
+}
+
+/* Set the result of an operation that was not (successfully) executed */
+static void
+setAsyncOperationStatus(UA_AsyncOperation *ao, UA_StatusCode status) {
+    switch(ao->type) {
+    case UA_ASYNCOPERATIONTYPE_CALL:
+        ao->response.callMethodResult.statusCode = status;
+        break;
+    case UA_ASYNCOPERATIONTYPE_READ:
+        UA_DataValue_clear(&ao->response.readResult);
+        ao->response.readResult.hasStatus = true;
+        ao->response.readResult.status = status;
+        break;
+    case UA_ASYNCOPERATIONTYPE_WRITE:
+        ao->response.writeResult = status;
+        break;
+    default:
+        break;
+    }
 }
 
 static void
@@ -49,8 +99,8 @@ UA_AsyncManager_sendAsyncResponse(UA_AsyncManager *am, UA_Server *server,
 
     /* Send the Response */
     UA_StatusCode res =
-        sendResponse(server, channel, ar->requestId,
-                     (UA_Response*)&ar->response, &UA_TYPES[UA_TYPES_CALLRESPONSE]);
+        sendResponse(server, channel, ar->requestId, (UA_Response*)&ar->response,
+                     asyncResponseType(ar->operationType));
     if(res != UA_STATUSCODE_GOOD) {
         UA_LOG_WARNING_SESSION(server->config.logging, session,
                                "Async Response for Req# %" PRIu32 " failed "
@@ -78,9 +128,35 @@ integrateOperationResult(UA_AsyncManager *am, UA_Server *server,
                  "Return result in the server thread with %" PRIu32 " remaining",
                  ar->opCountdown);
 
-    /* Move the UA_CallMethodResult to UA_CallResponse */
-    ar->response.callResponse.results[ao->index] = ao->response;
-    UA_CallMethodResult_init(&ao->response);
+    /* Move the operation result into the response */
+    switch(ar->operationType) {
+    case UA_ASYNCOPERATIONTYPE_CALL:
+        ar->response.callResponse.results[ao->index] = ao->response.callMethodResult;
+        UA_CallMethodResult_init(&ao->response.callMethodResult);
+        break;
+    case UA_ASYNCOPERATIONTYPE_READ: {
+        /* User-managed workers read with their own TimestampsToReturn */
+        UA_DataValue *dv = &ao->response.readResult;
+        if(ar->timestampsToReturn == UA_TIMESTAMPSTORETURN_SOURCE ||
+           ar->timestampsToReturn == UA_TIMESTAMPSTORETURN_NEITHER) {
+            dv->hasServerTimestamp = false;
+            dv->hasServerPicoseconds = false;
+        }
+        if(ar->timestampsToReturn == UA_TIMESTAMPSTORETURN_SERVER ||
+           ar->timestampsToReturn == UA_TIMESTAMPSTORETURN_NEITHER) {
+            dv->hasSourceTimestamp = false;
+            dv->hasSourcePicoseconds = false;
+        }
+        ar->response.readResponse.results[ao->index] = *dv;
+        UA_DataValue_init(dv);
+        break;
+    }
+    case UA_ASYNCOPERATIONTYPE_WRITE:
+        ar->response.writeResponse.results[ao->index] = ao->response.writeResult;
+        break;
+    default:
+        break;
+    }
 
     /* Done with all operations -> send the response */
     UA_Boolean done = (ar->opCountdown == 0);
@@ -134,7 +210,7 @@ checkTimeouts(UA_Server *server, void *_) {
             break;
 
         /* Mark as timed out and put it into the result queue */
-        op->response.statusCode = UA_STATUSCODE_BADTIMEOUT;
+        setAsyncOperationStatus(op, UA_STATUSCODE_BADTIMEOUT);
         TAILQ_REMOVE(&am->dispatchedQueue, op, pointers);
         TAILQ_INSERT_TAIL(&am->resultQueue, op, pointers);
         UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
@@ -148,7 +224,7 @@ checkTimeouts(UA_Server *server, void *_) {
             break;
 
         /* Mark as timed out and put it into the result queue */
-        op->response.statusCode = UA_STATUSCODE_BADTIMEOUT;
+        setAsyncOperationStatus(op, UA_STATUSCODE_BADTIMEOUT);
         TAILQ_REMOVE(&am->newQueue, op, pointers);
         TAILQ_INSERT_TAIL(&am->resultQueue, op, pointers);
         UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
@@ -163,6 +239,226 @@ checkTimeouts(UA_Server *server, void *_) {
     UA_UNLOCK(&server->serviceMutex);
 }
 
+/* Integrate the results returned by the workers */
+static void
+processScheduledResults(UA_Server *server, void *_) {
+    UA_AsyncManager *am = &server->asyncManager;
+    UA_LOCK(&server->serviceMutex);
+    UA_LOCK(&am->queueLock);
+    am->resultCallbackScheduled = false;
+    UA_UNLOCK(&am->queueLock);
+    processAsyncResults(server);
+    UA_UNLOCK(&server->serviceMutex);
+}
+
+/* Integrate the results in the next EventLoop cycle. The EventLoop is woken up
+ * if it waits for network events or timers. So the response does not wait for
+ * the checkTimeouts interval. Call with the queueLock held. Returns whether
+ * scheduleResultsWakeup has to be called after releasing the queueLock. */
+static UA_Boolean
+scheduleResults(UA_AsyncManager *am) {
+    UA_LOCK_ASSERT(&am->queueLock);
+    if(am->resultCallbackScheduled)
+        return false;
+    am->resultCallbackScheduled = true;
+    return true;
+}
+
+static void
+scheduleResultsWakeup(UA_Server *server) {
+    UA_EventLoop *el = server->config.eventLoop;
+    el->addDelayedCallback(el, &server->asyncManager.resultCallback);
+    el->cancel(el);
+}
+
+static void
+unscheduleResults(UA_AsyncManager *am, UA_Server *server) {
+    UA_EventLoop *el = server->config.eventLoop;
+    UA_LOCK(&am->queueLock);
+    if(am->resultCallbackScheduled) {
+        el->removeDelayedCallback(el, &am->resultCallback);
+        am->resultCallbackScheduled = false;
+    }
+    UA_UNLOCK(&am->queueLock);
+}
+
+/*******************/
+/* Built-in Workers */
+/*******************/
+
+#ifdef UA_ARCHITECTURE_POSIX
+
+/* Take from the head of the own queue. Otherwise steal from the tail of the
+ * other queues. */
+static UA_AsyncOperation *
+takeAsyncOperation(UA_AsyncManager *am, size_t index) {
+    UA_AsyncOperation *ao = NULL;
+    for(size_t i = 0; i < am->workersSize && !ao; i++) {
+        UA_AsyncWorker *w = &am->workers[(index + i) % am->workersSize];
+        UA_LOCK(&w->lock);
+        ao = (i == 0) ? TAILQ_FIRST(&w->queue) :
+            TAILQ_LAST(&w->queue, UA_AsyncOperationQueue);
+        if(ao)
+            TAILQ_REMOVE(&w->queue, ao, pointers);
+        UA_UNLOCK(&w->lock);
+    }
+    if(ao) {
+        pthread_mutex_lock(&am->idleMutex);
+        am->pendingOps--;
+        pthread_mutex_unlock(&am->idleMutex);
+    }
+    return ao;
+}
+
+/* Execute with the admin session. The access rights of the requesting session
+ * were checked before the operation was enqueued. The callbacks of the
+ * DataSources and methods are executed without holding the service lock. */
+static void
+executeAsyncOperation(UA_Server *server, UA_AsyncOperation *ao) {
+    UA_AsyncResponse *ar = ao->parent;
+    UA_EventLoop *el = server->config.eventLoop;
+    if(server->config.asyncOperationTimeout > 0.0 &&
+       el->dateTime_nowMonotonic(el) > ar->timeout) {
+        setAsyncOperationStatus(ao, UA_STATUSCODE_BADTIMEOUT);
+        return;
+    }
+
+    UA_LOCK(&server->serviceMutex);
+    switch(ao->type) {
+#ifdef UA_ENABLE_METHODCALLS
+    case UA_ASYNCOPERATIONTYPE_CALL:
+        Operation_CallMethod(server, &server->adminSession, NULL,
+                             &ao->request.callMethodRequest,
+                             &ao->response.callMethodResult);
+        break;
+#endif
+    case UA_ASYNCOPERATIONTYPE_READ:
+        ao->response.readResult =
+            readWithSession(server, &server->adminSession,
+                            &ao->request.readValueId, ar->timestampsToReturn);
+        break;
+    case UA_ASYNCOPERATIONTYPE_WRITE:
+        Operation_Write(server, &server->adminSession, NULL,
+                        &ao->request.writeValue, &ao->response.writeResult);
+        break;
+    default:
+        setAsyncOperationStatus(ao, UA_STATUSCODE_BADINTERNALERROR);
+        break;
+    }
+    UA_UNLOCK(&server->serviceMutex);
+}
+
+static void *
+asyncWorkerLoop(void *data) {
+    UA_AsyncWorker *w = (UA_AsyncWorker*)data;
+    UA_Server *server = w->server;
+    UA_AsyncManager *am = &server->asyncManager;
+    applyThreadPlacement(server, &server->config.asyncOperationWorkerPlacement,
+                         "async operation worker");
+    while(true) {
+        /* Wait for work */
+        pthread_mutex_lock(&am->idleMutex);
+        while(am->pendingOps == 0 && !am->stopWorkers)
+            pthread_cond_wait(&am->idleCondition, &am->idleMutex);
+        UA_Boolean stop = am->stopWorkers;
+        pthread_mutex_unlock(&am->idleMutex);
+        if(stop)
+            break;
+
+        /* Another worker might have taken the operation */
+        UA_AsyncOperation *ao = takeAsyncOperation(am, w->index);
+        if(!ao)
+            continue;
+
+        executeAsyncOperation(server, ao);
+
+        /* Hand the result to the server thread */
+        UA_LOCK(&am->queueLock);
+        TAILQ_INSERT_TAIL(&am->resultQueue, ao, pointers);
+        UA_Boolean schedule = scheduleResults(am);
+        UA_UNLOCK(&am->queueLock);
+        if(schedule)
+            scheduleResultsWakeup(server);
+    }
+    return NULL;
+}
+
+static void
+startWorkers(UA_AsyncManager *am, UA_Server *server) {
+    size_t workers = server->config.asyncOperationWorkers;
+    if(workers == 0)
+        return;
+    am->workers = (UA_AsyncWorker*)UA_calloc(workers, sizeof(UA_AsyncWorker));
+    if(!am->workers) {
+        UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_SERVER,
+                     "Could not allocate the async operation workers");
+        return;
+    }
+    am->workersSize = workers;
+    am->nextWorker = 0;
+    am->pendingOps = 0;
+    am->stopWorkers = false;
+    for(size_t i = 0; i < workers; i++) {
+        UA_AsyncWorker *w = &am->workers[i];
+        UA_LOCK_INIT(&w->lock);
+        UA_LOCK_SETRANK(&w->lock, UA_LOCKRANK_ASYNCWORKER);
+        TAILQ_INIT(&w->queue);
+        w->server = server;
+        w->index = i;
+    }
+    for(size_t i = 0; i < workers; i++) {
+        UA_AsyncWorker *w = &am->workers[i];
+        w->started = (pthread_create(&w->thread, NULL, asyncWorkerLoop, w) == 0);
+        if(!w->started)
+            UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
+                           "Could not start async operation worker %u",
+                           (unsigned)i);
+    }
+}
+
+/* The operations remaining in the worker queues are returned with
+ * BadShutdown */
+static void
+stopWorkers(UA_AsyncManager *am, UA_Server *server) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+    if(am->workersSize == 0)
+        return;
+
+    /* Wait for the workers. They need the service lock to finish the current
+     * operation. */
+    pthread_mutex_lock(&am->idleMutex);
+    am->stopWorkers = true;
+    pthread_cond_broadcast(&am->idleCondition);
+    pthread_mutex_unlock(&am->idleMutex);
+    UA_UNLOCK(&server->serviceMutex);
+    for(size_t i = 0; i < am->workersSize; i++) {
+        if(am->workers[i].started)
+            pthread_join(am->workers[i].thread, NULL);
+    }
+    UA_LOCK(&server->serviceMutex);
+
+    UA_LOCK(&am->queueLock);
+    for(size_t i = 0; i < am->workersSize; i++) {
+        UA_AsyncWorker *w = &am->workers[i];
+        UA_AsyncOperation *ao, *ao_tmp;
+        TAILQ_FOREACH_SAFE(ao, &w->queue, pointers, ao_tmp) {
+            TAILQ_REMOVE(&w->queue, ao, pointers);
+            setAsyncOperationStatus(ao, UA_STATUSCODE_BADSHUTDOWN);
+            TAILQ_INSERT_TAIL(&am->resultQueue, ao, pointers);
+        }
+        UA_LOCK_DESTROY(&w->lock);
+    }
+    UA_UNLOCK(&am->queueLock);
+    UA_free(am->workers);
+    am->workers = NULL;
+    am->workersSize = 0;
+    am->pendingOps = 0;
+
+    processAsyncResults(server);
+}
+
+#endif /* UA_ARCHITECTURE_POSIX */
+
 void
 UA_AsyncManager_init(UA_AsyncManager *am, UA_Server *server) {
     memset(am, 0, sizeof(UA_AsyncManager));
@@ -171,6 +467,14 @@ UA_AsyncManager_init(UA_AsyncManager *am, UA_Server *server) {
     TAILQ_INIT(&am->dispatchedQueue);
     TAILQ_INIT(&am->resultQueue);
     UA_LOCK_INIT(&am->queueLock);
+    UA_LOCK_SETRANK(&am->queueLock, UA_LOCKRANK_ASYNCQUEUE);
+    am->resultCallback.callback = (UA_Callback)processScheduledResults;
+    am->resultCallback.application = server;
+    am->resultCallback.context = NULL;
+#ifdef UA_ARCHITECTURE_POSIX
+    pthread_mutex_init(&am->idleMutex, NULL);
+    pthread_cond_init(&am->idleCondition, NULL);
+#endif
 }
 
 void UA_AsyncManager_start(UA_AsyncManager *am, UA_Server *server) {
@@ -178,18 +482,29 @@ void UA_AsyncManager_start(UA_AsyncManager *am, UA_Server *server) {
      * responses at a 100ms interval. */
     addRepeatedCallback(server, (UA_ServerCallback)checkTimeouts,
                         NULL, 100.0, &am->checkTimeoutCallbackId);
+#ifdef UA_ARCHITECTURE_POSIX
+    startWorkers(am, server);
+#endif
 }
 
 void UA_AsyncManager_stop(UA_AsyncManager *am, UA_Server *server) {
     /* Add a regular callback for checking timeouts and sending finished
      * responses at a 100ms interval. */
     removeCallback(server, am->checkTimeoutCallbackId);
+#ifdef UA_ARCHITECTURE_POSIX
+    stopWorkers(am, server);
+#endif
+    unscheduleResults(am, server);
+    processAsyncResults(server);
 }
 
 void
 UA_AsyncManager_clear(UA_AsyncManager *am, UA_Server *server) {
     UA_AsyncOperation *ar, *ar_tmp;
 
+    /* Results returned after the server was stopped */
+    unscheduleResults(am, server);
+
     /* Clean up queues */
     UA_LOCK(&am->queueLock);
     TAILQ_FOREACH_SAFE(ar, &am->newQueue, pointers, ar_tmp) {
@@ -214,6 +529,10 @@ UA_AsyncManager_clear(UA_AsyncManager *am, UA_Server *server) {
 
     /* Delete all locks */
     UA_LOCK_DESTROY(&am->queueLock);
+#ifdef UA_ARCHITECTURE_POSIX
+    pthread_mutex_destroy(&am->idleMutex);
+    pthread_cond_destroy(&am->idleCondition);
+#endif
 }
 
 UA_StatusCode
@@ -237,6 +556,7 @@ UA_AsyncManager_createAsyncResponse(UA_AsyncManager *am, UA_Server *server,
     am->asyncResponsesCount += 1;
     newentry->requestId = requestId;
     newentry->requestHandle = requestHandle;
+    newentry->operationType = operationType;
     newentry->timeout = el->dateTime_nowMonotonic(el);
     if(server->config.asyncOperationTimeout > 0.0)
         newentry->timeout += (UA_DateTime)
@@ -252,16 +572,16 @@ void
 UA_AsyncManager_removeAsyncResponse(UA_AsyncManager *am, UA_AsyncResponse *ar) {
     TAILQ_REMOVE(&am->asyncResponses, ar, pointers);
     am->asyncResponsesCount -= 1;
-    UA_CallResponse_clear(&ar->response.callResponse);
+    UA_clear(&ar->response, asyncResponseType(ar->operationType));
     UA_NodeId_clear(&ar->sessionId);
     UA_free(ar);
 }
 
-/* Enqueue next MethodRequest */
+/* Enqueue the next operation */
 UA_StatusCode
 UA_AsyncManager_createAsyncOp(UA_AsyncManager *am, UA_Server *server,
                               UA_AsyncResponse *ar, size_t opIndex,
-                              const UA_CallMethodRequest *opRequest) {
+                              const void *opRequest) {
     if(server->config.maxAsyncOperationQueueSize != 0 &&
        am->opsCount >= server->config.maxAsyncOperationQueueSize) {
         UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
@@ -277,18 +597,54 @@ UA_AsyncManager_createAsyncOp(UA_AsyncManager *am, UA_Server *server,
         return UA_STATUSCODE_BADOUTOFMEMORY;
     }
 
-    UA_StatusCode result = UA_CallMethodRequest_copy(opRequest, &ao->request);
+    UA_StatusCode result =
+        UA_copy(opRequest, &ao->request, asyncOperationRequestType(ar->operationType));
     if(result != UA_STATUSCODE_GOOD) {
         UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_SERVER,
-                     "UA_Server_SetAsyncMethodResult: UA_CallMethodRequest_copy failed.");
+                     "UA_Server_SetNextAsyncMethod: Copying the request failed.");
         UA_free(ao);
         return result;
     }
 
-    UA_CallMethodResult_init(&ao->response);
+    ao->type = ar->operationType;
     ao->index = opIndex;
     ao->parent = ar;
 
+    /* Hand over to the executor. The operation is dispatched before, as the
+     * executor can set the result right away. */
+    if(am->executor) {
+        UA_LOCK(&am->queueLock);
+        TAILQ_INSERT_TAIL(&am->dispatchedQueue, ao, pointers);
+        am->opsCount++;
+        ar->opCountdown++;
+        UA_UNLOCK(&am->queueLock);
+        am->executor(server, am->executorContext, ao->type, &ao->request,
+                     ao, ar->timeout);
+        return UA_STATUSCODE_GOOD;
+    }
+
+#ifdef UA_ARCHITECTURE_POSIX
+    /* Distribute round-robin over the queues of the built-in workers */
+    if(am->workersSize > 0) {
+        UA_LOCK(&am->queueLock);
+        am->opsCount++;
+        ar->opCountdown++;
+        UA_UNLOCK(&am->queueLock);
+
+        UA_AsyncWorker *w = &am->workers[am->nextWorker];
+        am->nextWorker = (am->nextWorker + 1) % am->workersSize;
+        UA_LOCK(&w->lock);
+        TAILQ_INSERT_TAIL(&w->queue, ao, pointers);
+        UA_UNLOCK(&w->lock);
+
+        pthread_mutex_lock(&am->idleMutex);
+        am->pendingOps++;
+        pthread_cond_signal(&am->idleCondition);
+        pthread_mutex_unlock(&am->idleMutex);
+        return UA_STATUSCODE_GOOD;
+    }
+#endif
+
     UA_LOCK(&am->queueLock);
     TAILQ_INSERT_TAIL(&am->newQueue, ao, pointers);
     am->opsCount++;
@@ -301,7 +657,7 @@ UA_AsyncManager_createAsyncOp(UA_AsyncManager *am, UA_Server *server,
     return UA_STATUSCODE_GOOD;
 }
 
-/* Get and remove next Method Call Request */
+/* Get and remove the next operation */
 UA_Boolean
 UA_Server_getAsyncOperationNonBlocking(UA_Server *server, UA_AsyncOperationType *type,
                                        const UA_AsyncOperationRequest **request,
@@ -315,8 +671,8 @@ UA_Server_getAsyncOperationNonBlocking(UA_Server *server, UA_AsyncOperationType
     if(ao) {
         TAILQ_REMOVE(&am->newQueue, ao, pointers);
         TAILQ_INSERT_TAIL(&am->dispatchedQueue, ao, pointers);
-        *type = UA_ASYNCOPERATIONTYPE_CALL;
-        *request = (UA_AsyncOperationRequest*)&ao->request;
+        *type = ao->type;
+        *request = &ao->request;
         *context = (void*)ao;
         if(timeout)
             *timeout = ao->parent->timeout;
@@ -327,7 +683,7 @@ UA_Server_getAsyncOperationNonBlocking(UA_Server *server, UA_AsyncOperationType
     return bRV;
 }
 
-/* Worker submits Method Call Response */
+/* Worker submits the operation result */
 void
 UA_Server_setAsyncOperationResult(UA_Server *server,
                                   const UA_AsyncOperationResponse *response,
@@ -363,23 +719,39 @@ UA_Server_setAsyncOperationResult(UA_Server *server,
 
     /* Copy the result into the internal AsyncOperation */
     UA_StatusCode result =
-        UA_CallMethodResult_copy(&response->callMethodResult, &ao->response);
+        UA_copy(response, &ao->response,
+                asyncOperationResultType(ao->type));
     if(result != UA_STATUSCODE_GOOD) {
         UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
-                       "UA_Server_SetAsyncMethodResult: UA_CallMethodResult_copy failed.");
-        ao->response.statusCode = UA_STATUSCODE_BADOUTOFMEMORY;
+                       "UA_Server_SetAsyncMethodResult: Copying the result failed.");
+        setAsyncOperationStatus(ao, UA_STATUSCODE_BADOUTOFMEMORY);
     }
 
     /* Move to the result queue */
     TAILQ_REMOVE(&am->dispatchedQueue, ao, pointers);
     TAILQ_INSERT_TAIL(&am->resultQueue, ao, pointers);
+    UA_Boolean schedule = scheduleResults(am);
 
     UA_UNLOCK(&am->queueLock);
 
+    /* Send the response without waiting for the checkTimeouts interval */
+    if(schedule)
+        scheduleResultsWakeup(server);
+
     UA_LOG_DEBUG(server->config.logging, UA_LOGCATEGORY_SERVER,
                  "Set the result from the worker thread");
 }
 
+void
+UA_Server_setAsyncOperationExecutor(UA_Server *server,
+                                    UA_Server_AsyncOperationExecutor executor,
+                                    void *executorContext) {
+    UA_LOCK(&server->serviceMutex);
+    server->asyncManager.executor = executor;
+    server->asyncManager.executorContext = executorContext;
+    UA_UNLOCK(&server->serviceMutex);
+}
+
 /******************/
 /* Server Methods */
 /******************/
@@ -398,7 +770,41 @@ UA_Server_setMethodNodeAsync(UA_Server *server, const UA_NodeId id,
             node->methodNode.async = isAsync;
         else
             res = UA_STATUSCODE_BADNODECLASSINVALID;
-        UA_NODESTORE_RELEASE(server, node);
+        UA_StatusCode releaseRes = UA_NODESTORE_RELEASE_EDIT(server, node);
+        if(res == UA_STATUSCODE_GOOD)
+            res = releaseRes;
+    } else {
+        res = UA_STATUSCODE_BADNODEIDINVALID;
+    }
+    UA_UNLOCK(&server->serviceMutex);
+    return res;
+}
+
+UA_StatusCode
+UA_Server_setVariableNodeAsync(UA_Server *server, const UA_NodeId id,
+                               UA_Boolean isAsync) {
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    UA_LOCK(&server->serviceMutex);
+    UA_Node *node =
+        UA_NODESTORE_GET_EDIT_SELECTIVE(server, &id, UA_NODEATTRIBUTESMASK_NONE,
+                                        UA_REFERENCETYPESET_NONE,
+                                        UA_BROWSEDIRECTION_INVALID);
+    if(node) {
+        UA_Boolean wasAsync = false;
+        if(node->head.nodeClass == UA_NODECLASS_VARIABLE) {
+            wasAsync = node->variableNode.async;
+            node->variableNode.async = isAsync;
+        } else {
+            res = UA_STATUSCODE_BADNODECLASSINVALID;
+        }
+        UA_StatusCode releaseRes = UA_NODESTORE_RELEASE_EDIT(server, node);
+        if(res == UA_STATUSCODE_GOOD)
+            res = releaseRes;
+        /* Count only if the change was published */
+        if(res == UA_STATUSCODE_GOOD && isAsync && !wasAsync)
+            server->asyncManager.asyncVariablesCount++;
+        else if(res == UA_STATUSCODE_GOOD && !isAsync && wasAsync)
+            server->asyncManager.asyncVariablesCount--;
     } else {
         res = UA_STATUSCODE_BADNODEIDINVALID;
     }
@@ -410,6 +816,7 @@ UA_StatusCode
 UA_Server_processServiceOperationsAsync(UA_Server *server, UA_Session *session,
                                         UA_UInt32 requestId, UA_UInt32 requestHandle,
                                         UA_AsyncServiceOperation operationCallback,
+                                        const void *context,
                                         const size_t *requestOperations,
                                         const UA_DataType *requestOperationsType,
                                         size_t *responseOperations,
@@ -430,7 +837,7 @@ UA_Server_processServiceOperationsAsync(UA_Server *server, UA_Session *session,
     uintptr_t respOp = (uintptr_t)*respPos;
     uintptr_t reqOp = *(uintptr_t*)((uintptr_t)requestOperations + sizeof(size_t));
     for(size_t i = 0; i < ops; i++) {
-        operationCallback(server, session, requestId, requestHandle,
+        operationCallback(server, session, context, requestId, requestHandle,
                           i, (void*)reqOp, (void*)respOp, ar);
         reqOp += requestOperationsType->memSize;
         respOp += responseOperationsType->memSize;
@@ -454,7 +861,7 @@ UA_AsyncManager_cancel(UA_Server *server, UA_Session *session, UA_UInt32 request
             continue;
 
         /* Set status and put it into the result queue */
-        op->response.statusCode = UA_STATUSCODE_BADREQUESTCANCELLEDBYCLIENT;
+        setAsyncOperationStatus(op, UA_STATUSCODE_BADREQUESTCANCELLEDBYCLIENT);
         TAILQ_REMOVE(&am->dispatchedQueue, op, pointers);
         TAILQ_INSERT_TAIL(&am->resultQueue, op, pointers);
 
@@ -470,7 +877,7 @@ UA_AsyncManager_cancel(UA_Server *server, UA_Session *session, UA_UInt32 request
             continue;
 
         /* Mark as timed out and put it into the result queue */
-        op->response.statusCode = UA_STATUSCODE_BADREQUESTCANCELLEDBYCLIENT;
+        setAsyncOperationStatus(op, UA_STATUSCODE_BADREQUESTCANCELLEDBYCLIENT);
         TAILQ_REMOVE(&am->newQueue, op, pointers);
         TAILQ_INSERT_TAIL(&am->resultQueue, op, pointers);
 
@@ -478,6 +885,33 @@ UA_AsyncManager_cancel(UA_Server *server, UA_Session *session, UA_UInt32 request
             serviceResult = UA_STATUSCODE_BADREQUESTCANCELLEDBYCLIENT;
     }
 
+#ifdef UA_ARCHITECTURE_POSIX
+    /* Idem for the ops in the queues of the built-in workers. Ops that are
+     * currently executed are not cancelled. */
+    size_t removed = 0;
+    for(size_t i = 0; i < am->workersSize; i++) {
+        UA_AsyncWorker *w = &am->workers[i];
+        UA_LOCK(&w->lock);
+        TAILQ_FOREACH_SAFE(op, &w->queue, pointers, op_tmp) {
+            if(op->parent->requestHandle != requestHandle ||
+               !UA_NodeId_equal(&session->sessionId, &op->parent->sessionId))
+                continue;
+            setAsyncOperationStatus(op, UA_STATUSCODE_BADREQUESTCANCELLEDBYCLIENT);
+            TAILQ_REMOVE(&w->queue, op, pointers);
+            TAILQ_INSERT_TAIL(&am->resultQueue, op, pointers);
+            op->parent->response.callResponse.responseHeader.
+                serviceResult = UA_STATUSCODE_BADREQUESTCANCELLEDBYCLIENT;
+            removed++;
+        }
+        UA_UNLOCK(&w->lock);
+    }
+    if(removed > 0) {
+        pthread_mutex_lock(&am->idleMutex);
+        am->pendingOps -= removed;
+        pthread_mutex_unlock(&am->idleMutex);
+    }
+#endif
+
     UA_UNLOCK(&am->queueLock);
 
     /* Process messages that have all ops completed */
@@ -29,8 +29,9 @@ typedef struct UA_AsyncResponse UA_AsyncResponse;
 /* A single operation (of a larger request) */
 typedef struct UA_AsyncOperation {
     TAILQ_ENTRY(UA_AsyncOperation) pointers;
-    UA_CallMethodRequest request;
-    UA_CallMethodResult response;
+    UA_AsyncOperationType type;
+    UA_AsyncOperationRequest request;
+    UA_AsyncOperationResponse response;
     size_t index;             /* Index of the operation in the array of ops in
                                * request/response */
     UA_AsyncResponse *parent; /* Always non-NULL. The parent is only removed
@@ -44,6 +45,7 @@ struct UA_AsyncResponse {
     UA_UInt32 requestHandle;
     UA_DateTime    timeout;
     UA_AsyncOperationType operationType;
+    UA_TimestampsToReturn timestampsToReturn; /* For read operations */
     union {
         UA_CallResponse callResponse;
         UA_ReadResponse readResponse;
@@ -55,6 +57,20 @@ struct UA_AsyncResponse {
 
 typedef TAILQ_HEAD(UA_AsyncOperationQueue, UA_AsyncOperation) UA_AsyncOperationQueue;
 
+#ifdef UA_ARCHITECTURE_POSIX
+/* Built-in worker thread. Every worker has its own queue of operations. Idle
+ * workers steal operations from the end of the other queues. */
+typedef struct {
+    UA_Lock lock; /* Protects the queue. Never take another lock while holding
+                   * it. */
+    UA_AsyncOperationQueue queue;
+    pthread_t thread;
+    UA_Boolean started;
+    UA_Server *server;
+    size_t index;
+} UA_AsyncWorker;
+#endif
+
 typedef struct {
     /* Requests / Responses */
     TAILQ_HEAD(, UA_AsyncResponse) asyncResponses;
@@ -71,9 +87,35 @@ typedef struct {
                                              * returned, we search for the op here to see if it
                                              * is still "alive" (not timed out). */
     UA_AsyncOperationQueue resultQueue;     /* Results to be integrated */
-    size_t opsCount; /* How many operations are transient (in one of the three queues)? */
+    size_t opsCount; /* How many operations are transient (in one of the
+                      * queues or executed by a built-in worker)? */
 
     UA_UInt64 checkTimeoutCallbackId; /* Registered repeated callbacks */
+
+    /* Read and Write requests only take the async path if there are variables
+     * with the async flag */
+    size_t asyncVariablesCount;
+
+    /* Push new operations to the application-provided executor */
+    UA_Server_AsyncOperationExecutor executor;
+    void *executorContext;
+
+    /* Integrate the results in the next EventLoop cycle. Protected by the
+     * queueLock. */
+    UA_DelayedCallback resultCallback;
+    UA_Boolean resultCallbackScheduled;
+
+#ifdef UA_ARCHITECTURE_POSIX
+    /* Built-in workers. Operations are distributed round-robin over their
+     * queues instead of the newQueue. */
+    UA_AsyncWorker *workers;
+    size_t workersSize;
+    size_t nextWorker;
+    pthread_mutex_t idleMutex; /* Idle workers wait for pendingOps > 0 */
+    pthread_cond_t idleCondition;
+    size_t pendingOps;         /* Operations in the worker queues */
+    UA_Boolean stopWorkers;
+#endif
 } UA_AsyncManager;
 
 void UA_AsyncManager_init(UA_AsyncManager *am, UA_Server *server);
@@ -93,10 +135,11 @@ UA_AsyncManager_createAsyncResponse(UA_AsyncManager *am, UA_Server *server,
 void
 UA_AsyncManager_removeAsyncResponse(UA_AsyncManager *am, UA_AsyncResponse *ar);
 
+/* The operation request has the type of the ar->operationType */
 UA_StatusCode
 UA_AsyncManager_createAsyncOp(UA_AsyncManager *am, UA_Server *server,
                               UA_AsyncResponse *ar, size_t opIndex,
-                              const UA_CallMethodRequest *opRequest);
+                              const void *opRequest);
 
 /* Send out the response with status set. Also removes all outstanding
  * operations from the dispatch queue. The queuelock needs to be taken before
@@ -105,6 +148,7 @@ UA_UInt32
 UA_AsyncManager_cancel(UA_Server *server, UA_Session *session, UA_UInt32 requestHandle);
 
 typedef void (*UA_AsyncServiceOperation)(UA_Server *server, UA_Session *session,
+                                         const void *context,
                                          UA_UInt32 requestId, UA_UInt32 requestHandle,
                                          size_t opIndex, const void *requestOperation,
                                          void *responseOperation, UA_AsyncResponse **ar);
@@ -115,6 +159,7 @@ UA_StatusCode
 UA_Server_processServiceOperationsAsync(UA_Server *server, UA_Session *session,
                                         UA_UInt32 requestId, UA_UInt32 requestHandle,
                                         UA_AsyncServiceOperation operationCallback,
+                                        const void *context,
                                         const size_t *requestOperations,
                                         const UA_DataType *requestOperationsType,
                                         size_t *responseOperations,
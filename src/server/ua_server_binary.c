@@ -66,7 +66,6 @@ typedef struct reverse_connect_context {
 typedef struct {
     UA_ServerComponent sc;
     const UA_Logger *logging; /* shortcut */
-    UA_UInt64 houseKeepingCallbackId;
 
     UA_ServerConnection serverConnections[UA_MAXSERVERCONNECTIONS];
     size_t serverConnectionsSize;
@@ -77,6 +76,11 @@ typedef struct {
     /* SecureChannels */
     TAILQ_HEAD(, UA_SecureChannel) channels;
 
+    /* Token bucket for new SecureChannel handshakes (see
+     * maxHandshakesPerSecond in the server config) */
+    UA_Double handshakeTokens;
+    UA_DateTime handshakeRefill;
+
     /* Reverse Connections */
     LIST_HEAD(, reverse_connect_context) reverseConnects;
     UA_UInt64 reverseConnectsCheckHandle;
@@ -116,6 +120,19 @@ deleteServerSecureChannel(UA_BinaryProtocolManager *bpm,
     while(channel->sessions)
         UA_Session_detachFromSecureChannel(channel->sessions);
 
+#ifdef UA_REQUEST_EXECUTOR
+    /* Drop the requests that are not yet processed by the workers */
+    if(bpm->sc.server->requestExecutor.enabled)
+        UA_RequestExecutor_cancel(&bpm->sc.server->requestExecutor, channel);
+#endif
+
+    /* Stop the timeout timer */
+    if(channel->timeoutCallbackId != 0) {
+        UA_EventLoop *el = bpm->sc.server->config.eventLoop;
+        el->removeTimer(el, channel->timeoutCallbackId);
+        channel->timeoutCallbackId = 0;
+    }
+
     /* Detach the channel from the server list */
     TAILQ_REMOVE(&bpm->sc.server->channels, channel, serverEntry);
     TAILQ_REMOVE(&bpm->channels, channel, componentEntry);
@@ -125,6 +142,8 @@ deleteServerSecureChannel(UA_BinaryProtocolManager *bpm,
     /* Update the statistics */
     UA_SecureChannelStatistics *scs = &bpm->sc.server->secureChannelStatistics;
     scs->currentChannelCount--;
+    scs->securedChunksSentCount += channel->securedChunksSent;
+    scs->securedChunksReceivedCount += channel->securedChunksReceived;
     switch(channel->shutdownReason) {
     case UA_SHUTDOWNREASON_CLOSE:
         UA_LOG_INFO_CHANNEL(bpm->logging, channel, "SecureChannel closed");
@@ -179,14 +198,14 @@ sendServiceFault(UA_Server *server, UA_SecureChannel *channel,
 }
 
 /* This is not an ERR message, the connection is not closed afterwards */
-static UA_StatusCode
+UA_StatusCode
 decodeHeaderSendServiceFault(UA_Server *server, UA_SecureChannel *channel,
-                             const UA_ByteString *msg, size_t offset,
-                             const UA_DataType *responseType, UA_UInt32 requestId,
-                             UA_StatusCode error) {
+                             const UA_ByteString *msg, size_t msgSegments,
+                             size_t offset, const UA_DataType *responseType,
+                             UA_UInt32 requestId, UA_StatusCode error) {
     UA_RequestHeader requestHeader;
     UA_StatusCode retval =
-        UA_decodeBinaryInternal(msg, &offset, &requestHeader,
+        UA_decodeBinarySegments(msg, msgSegments, &offset, &requestHeader,
                                 &UA_TYPES[UA_TYPES_REQUESTHEADER], NULL);
     if(retval != UA_STATUSCODE_GOOD)
         return retval;
@@ -265,12 +284,65 @@ processHEL(UA_Server *server, UA_SecureChannel *channel, const UA_ByteString *ms
     }
 
     ack_msg.length = ackHeader.messageSize;
+    UA_SecureChannel_capture(channel, true, ack_msg.data, ack_msg.length);
     retval = cm->sendWithConnection(cm, channel->connectionId, &UA_KEYVALUEMAP_NULL, &ack_msg);
     if(retval == UA_STATUSCODE_GOOD)
         channel->state = UA_SECURECHANNELSTATE_ACK_SENT;
     return retval;
 }
 
+/* Every SecureChannel has a one-shot timer at the expiry of its SecurityToken.
+ * Renewing the token only moves the expiry forward. So the timer is re-armed
+ * lazily when it fires for a channel that is still valid. Only the channels
+ * that are about to time out are visited. */
+static void scheduleChannelTimeout(UA_Server *server, UA_SecureChannel *channel);
+
+static void
+channelTimeoutCallback(UA_Server *server, UA_SecureChannel *channel) {
+    UA_LOCK(&server->serviceMutex);
+    channel->timeoutCallbackId = 0;
+    UA_EventLoop *el = server->config.eventLoop;
+    if(UA_SecureChannel_checkTimeout(channel, el->dateTime_nowMonotonic(el))) {
+        UA_LOG_INFO_CHANNEL(server->config.logging, channel,
+                            "SecureChannel has timed out");
+        UA_SecureChannel_shutdown(channel, UA_SHUTDOWNREASON_TIMEOUT);
+    } else {
+        scheduleChannelTimeout(server, channel);
+    }
+    UA_UNLOCK(&server->serviceMutex);
+}
+
+static void
+scheduleChannelTimeout(UA_Server *server, UA_SecureChannel *channel) {
+    UA_EventLoop *el = server->config.eventLoop;
+    if(channel->timeoutCallbackId != 0) {
+        el->removeTimer(el, channel->timeoutCallbackId);
+        channel->timeoutCallbackId = 0;
+    }
+
+    /* The earlier of the current and the new SecurityToken. The channel times
+     * out once the date has passed. */
+    UA_DateTime date = channel->securityToken.createdAt +
+        (UA_DateTime)(channel->securityToken.revisedLifetime * UA_DATETIME_MSEC);
+    if(channel->renewState == UA_SECURECHANNELRENEWSTATE_NEWTOKEN_SERVER) {
+        UA_DateTime altDate = channel->altSecurityToken.createdAt +
+            (UA_DateTime)(channel->altSecurityToken.revisedLifetime * UA_DATETIME_MSEC);
+        if(altDate < date)
+            date = altDate;
+    }
+    date++;
+
+    UA_StatusCode res =
+        el->addTimer(el, (UA_Callback)channelTimeoutCallback, server, channel,
+                     0.0, &date, UA_TIMERPOLICY_ONCE, &channel->timeoutCallbackId);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_LOG_WARNING_CHANNEL(server->config.logging, channel,
+                               "Cannot schedule the timeout. "
+                               "Closing the SecureChannel.");
+        UA_SecureChannel_shutdown(channel, UA_SHUTDOWNREASON_ABORT);
+    }
+}
+
 /* OPN -> Open up/renew the securechannel */
 static UA_StatusCode
 processOPN(UA_Server *server, UA_SecureChannel *channel,
@@ -278,6 +350,15 @@ processOPN(UA_Server *server, UA_SecureChannel *channel,
     if(channel->state != UA_SECURECHANNELSTATE_ACK_SENT &&
        channel->state != UA_SECURECHANNELSTATE_OPEN)
         return UA_STATUSCODE_BADINTERNALERROR;
+
+#if UA_MULTITHREADING >= 200
+    /* The request was decrypted by a worker thread */
+    if(channel->handshakeOffloaded) {
+        server->secureChannelStatistics.asyncHandshakeCount++;
+        channel->handshakeOffloaded = false;
+    }
+#endif
+
     /* Decode the request */
     UA_NodeId requestType;
     UA_OpenSecureChannelRequest openSecureChannelRequest;
@@ -321,6 +402,9 @@ processOPN(UA_Server *server, UA_SecureChannel *channel,
         return openScResponse.responseHeader.serviceResult;
     }
 
+    /* The new SecurityToken can expire earlier than the current one */
+    scheduleChannelTimeout(server, channel);
+
     /* Send the response */
     retval = UA_SecureChannel_sendAsymmetricOPNMessage(channel, requestId, &openScResponse,
                                                        &UA_TYPES[UA_TYPES_OPENSECURECHANNELRESPONSE]);
@@ -342,6 +426,10 @@ sendResponse(UA_Server *server, UA_SecureChannel *channel, UA_UInt32 requestId,
     if(!channel)
         return UA_STATUSCODE_BADINTERNALERROR;
 
+    /* Take the encoded body set by the service */
+    const UA_ByteString *encodedBody = channel->encodedResponseBody;
+    channel->encodedResponseBody = NULL;
+
     /* If the overall service call failed, answer with a ServiceFault */
     if(response->responseHeader.serviceResult != UA_STATUSCODE_GOOD)
         return sendServiceFault(server, channel, requestId,
@@ -368,8 +456,17 @@ sendResponse(UA_Server *server, UA_SecureChannel *channel, UA_UInt32 requestId,
     if(retval != UA_STATUSCODE_GOOD)
         return retval;
 
-    /* Encode the response */
-    retval = UA_MessageContext_encode(&mc, response, responseType);
+    /* Encode the response. With an encoded body only the ResponseHeader is
+     * encoded and the body is appended. */
+    if(encodedBody) {
+        retval = UA_MessageContext_encode(&mc, &response->responseHeader,
+                                          &UA_TYPES[UA_TYPES_RESPONSEHEADER]);
+        if(retval != UA_STATUSCODE_GOOD)
+            return retval;
+        retval = UA_MessageContext_encodeRaw(&mc, encodedBody);
+    } else {
+        retval = UA_MessageContext_encode(&mc, response, responseType);
+    }
     if(retval != UA_STATUSCODE_GOOD)
         return retval;
 
@@ -393,7 +490,7 @@ getBoundSession(UA_Server *server, const UA_SecureChannel *channel,
             continue;
 
         /* Has the session timed out? */
-        if(s->validTill < nowMonotonic) {
+        if(UA_UNLIKELY(s->validTill < nowMonotonic)) {
             server->serverDiagnosticsSummary.rejectedSessionCount++;
             return UA_STATUSCODE_BADSESSIONCLOSED;
         }
@@ -416,15 +513,17 @@ getBoundSession(UA_Server *server, const UA_SecureChannel *channel,
 }
 
 static UA_StatusCode
-processMSG(UA_Server *server, UA_SecureChannel *channel,
-           UA_UInt32 requestId, const UA_ByteString *msg) {
-    if(channel->state != UA_SECURECHANNELSTATE_OPEN)
+processMSG(UA_Server *server, UA_SecureChannel *channel, UA_UInt32 requestId,
+           const UA_ByteString *msg, size_t msgSegments) {
+    if(UA_UNLIKELY(channel->state != UA_SECURECHANNELSTATE_OPEN))
         return UA_STATUSCODE_BADINTERNALERROR;
     /* Decode the nodeid */
     size_t offset = 0;
     UA_NodeId requestTypeId;
-    UA_StatusCode retval = UA_NodeId_decodeBinary(msg, &offset, &requestTypeId);
-    if(retval != UA_STATUSCODE_GOOD)
+    UA_StatusCode retval =
+        UA_decodeBinarySegments(msg, msgSegments, &offset, &requestTypeId,
+                                &UA_TYPES[UA_TYPES_NODEID], NULL);
+    if(UA_UNLIKELY(retval != UA_STATUSCODE_GOOD))
         return retval;
     if(requestTypeId.namespaceIndex != 0 ||
        requestTypeId.identifierType != UA_NODEIDTYPE_NUMERIC)
@@ -432,7 +531,7 @@ processMSG(UA_Server *server, UA_SecureChannel *channel,
 
     /* Get the service pointers */
     UA_ServiceDescription *sd = getServiceDescription(requestTypeId.identifier.numeric);
-    if(!sd) {
+    if(UA_UNLIKELY(!sd)) {
         if(requestTypeId.identifier.numeric ==
            UA_NS0ID_CREATESUBSCRIPTIONREQUEST_ENCODING_DEFAULTBINARY) {
             UA_LOG_INFO_CHANNEL(server->config.logging, channel,
@@ -443,24 +542,56 @@ processMSG(UA_Server *server, UA_SecureChannel *channel,
                                 "Unknown request with type identifier %" PRIi32,
                                 requestTypeId.identifier.numeric);
         }
-        return decodeHeaderSendServiceFault(server, channel, msg, offset,
+        return decodeHeaderSendServiceFault(server, channel, msg, msgSegments, offset,
                                             &UA_TYPES[UA_TYPES_SERVICEFAULT],
                                             requestId, UA_STATUSCODE_BADSERVICEUNSUPPORTED);
     }
 
+#ifdef UA_REQUEST_EXECUTOR
+    /* Hand the request to the workers. Only the AuthenticationToken (at the
+     * beginning of the RequestHeader) is decoded to select the serial queue. */
+    if(server->requestExecutor.enabled) {
+        size_t tokenOffset = offset;
+        UA_NodeId token;
+        retval = UA_decodeBinarySegments(msg, msgSegments, &tokenOffset, &token,
+                                         &UA_TYPES[UA_TYPES_NODEID], NULL);
+        if(retval != UA_STATUSCODE_GOOD)
+            return retval;
+        retval = UA_RequestExecutor_dispatch(&server->requestExecutor, channel,
+                                             requestId, sd, &token, msg,
+                                             msgSegments, offset);
+        UA_NodeId_clear(&token);
+        return retval;
+    }
+#endif
+
     /* Decode the request */
     UA_Request request;
     size_t requestPos = offset; /* Store the offset (for sendServiceFault) */
     UA_DecodeBinaryOptions opt;
     memset(&opt, 0, sizeof(UA_DecodeBinaryOptions));
     opt.customTypes = server->config.customDataTypes;
-    retval = UA_decodeBinaryInternal(msg, &offset, &request, sd->requestType, &opt);
-    if(retval != UA_STATUSCODE_GOOD) {
+    UA_Arena *arena = NULL;
+    if(server->config.requestArenaSize > 0) {
+        arena = &server->requestArena;
+        arena->blockSize = server->config.requestArenaSize;
+        opt.callocContext = arena;
+        opt.calloc = UA_Arena_calloc;
+        opt.borrowStrings = true; /* The message outlives the request */
+    }
+    UA_MemoryCategory mc = UA_MemoryCategory_enter(UA_MEMORYCATEGORY_ENCODING);
+    retval = UA_decodeBinarySegments(msg, msgSegments, &offset, &request,
+                                     sd->requestType, &opt);
+    UA_MemoryCategory_leave(mc);
+    if(UA_UNLIKELY(retval != UA_STATUSCODE_GOOD)) {
         UA_LOG_DEBUG_CHANNEL(server->config.logging, channel,
                              "Could not decode the request with StatusCode %s",
                              UA_StatusCode_name(retval));
-        return decodeHeaderSendServiceFault(server, channel, msg, requestPos,
-                                            sd->responseType, requestId, retval);
+        if(arena)
+            UA_Arena_reset(arena);
+        return decodeHeaderSendServiceFault(server, channel, msg, msgSegments,
+                                            requestPos, sd->responseType,
+                                            requestId, retval);
     }
 
     /* Initialize the response */
@@ -468,19 +599,38 @@ processMSG(UA_Server *server, UA_SecureChannel *channel,
     UA_init(&response, sd->responseType);
     response.responseHeader.requestHandle = request.requestHeader.requestHandle;
 
-    /* Process the request */
+    /* Process the request. The values in the response to a Read request can
+     * point into the nodes (which are pinned until the response was encoded)
+     * instead of being copied. */
     UA_LOCK(&server->serviceMutex);
+    channel->pinNodes = (sd->requestType == &UA_TYPES[UA_TYPES_READREQUEST]);
     UA_Boolean async =
         UA_Server_processRequest(server, channel, requestId, sd, &request, &response);
+    channel->pinNodes = false;
+
+    /* Encode the response before releasing the pinned nodes. Keep the lock so
+     * that the values are not modified in-place while they are encoded. The
+     * same holds for an encoded response body taken from a server cache. */
+    UA_Boolean pinned = (channel->pinnedNodesSize > 0 ||
+                         channel->encodedResponseBody != NULL);
+    if(pinned) {
+        UA_assert(!async);
+        retval = sendResponse(server, channel, requestId, &response, sd->responseType);
+        releasePinnedNodes(server, channel);
+    }
     UA_UNLOCK(&server->serviceMutex);
 
     /* Send response if not async */
-    if(UA_LIKELY(!async)) {
+    if(UA_LIKELY(!async && !pinned)) {
         retval = sendResponse(server, channel, requestId, &response, sd->responseType);
     }
 
-    /* Clean up */
-    UA_clear(&request, sd->requestType);
+    /* Clean up. Requests decoded into the arena have no individual
+     * allocations. */
+    if(arena)
+        UA_Arena_reset(arena);
+    else
+        UA_clear(&request, sd->requestType);
     UA_clear(&response, sd->responseType);
     return retval;
 }
@@ -489,7 +639,7 @@ processMSG(UA_Server *server, UA_SecureChannel *channel,
 static UA_StatusCode
 processSecureChannelMessage(void *application, UA_SecureChannel *channel,
                             UA_MessageType messagetype, UA_UInt32 requestId,
-                            UA_ByteString *message) {
+                            const UA_ByteString *message, size_t messageSegments) {
     UA_Server *server = (UA_Server*)application;
 
     UA_StatusCode retval = UA_STATUSCODE_GOOD;
@@ -504,7 +654,7 @@ processSecureChannelMessage(void *application, UA_SecureChannel *channel,
         break;
     case UA_MESSAGETYPE_MSG:
         UA_LOG_TRACE_CHANNEL(server->config.logging, channel, "Process a MSG");
-        retval = processMSG(server, channel, requestId, message);
+        retval = processMSG(server, channel, requestId, message, messageSegments);
         break;
     case UA_MESSAGETYPE_CLO:
         UA_LOG_TRACE_CHANNEL(server->config.logging, channel, "Process a CLO");
@@ -515,7 +665,7 @@ processSecureChannelMessage(void *application, UA_SecureChannel *channel,
         retval = UA_STATUSCODE_BADTCPMESSAGETYPEINVALID;
         break;
     }
-    if(retval != UA_STATUSCODE_GOOD) {
+    if(UA_UNLIKELY(retval != UA_STATUSCODE_GOOD)) {
         if(!UA_SecureChannel_isConnected(channel)) {
             UA_LOG_INFO_CHANNEL(server->config.logging, channel,
                                 "Processing the message failed. Channel already closed "
@@ -566,12 +716,56 @@ purgeFirstChannelWithoutSession(UA_BinaryProtocolManager *bpm) {
     return false;
 }
 
+/* Take a token for a new handshake. Refill the bucket according to the time
+ * passed since the last handshake. */
+static UA_Boolean
+takeHandshakeToken(UA_Server *server) {
+    const UA_ServerConfig *config = &server->config;
+    if(config->maxHandshakesPerSecond == 0)
+        return true;
+    UA_ServerComponent *sc = getServerComponentByName(server, UA_STRING("binary"));
+    if(!sc)
+        return true;
+    UA_BinaryProtocolManager *bpm = (UA_BinaryProtocolManager*)sc;
+
+    UA_Double burst = (config->maxHandshakeBurst > 0) ?
+        (UA_Double)config->maxHandshakeBurst :
+        (UA_Double)config->maxHandshakesPerSecond;
+    UA_EventLoop *el = config->eventLoop;
+    UA_DateTime now = el->dateTime_nowMonotonic(el);
+    if(bpm->handshakeRefill == 0) {
+        bpm->handshakeTokens = burst; /* Start with a full bucket */
+    } else {
+        bpm->handshakeTokens += (UA_Double)(now - bpm->handshakeRefill) *
+            (UA_Double)config->maxHandshakesPerSecond / (UA_Double)UA_DATETIME_SEC;
+        if(bpm->handshakeTokens > burst)
+            bpm->handshakeTokens = burst;
+    }
+    bpm->handshakeRefill = now;
+
+    if(bpm->handshakeTokens < 1.0)
+        return false;
+    bpm->handshakeTokens -= 1.0;
+    return true;
+}
+
 static UA_StatusCode
 configServerSecureChannel(void *application, UA_SecureChannel *channel,
                           const UA_AsymmetricAlgorithmSecurityHeader *asymHeader) {
+    UA_Server *const server = (UA_Server *const) application;
+
+    /* Limit the rate of new handshakes. This is checked before the asymmetric
+     * cryptography of the OPN request is applied. */
+    if(!takeHandshakeToken(server)) {
+        server->secureChannelStatistics.handshakeRejectCount++;
+        UA_LOG_WARNING_CHANNEL(server->config.logging, channel,
+                               "Rejecting the handshake. Too many new "
+                               "SecureChannels are opened at the same time.");
+        return UA_STATUSCODE_BADTCPSERVERTOOBUSY;
+    }
+
     /* Iterate over available endpoints and choose the correct one */
     UA_SecurityPolicy *securityPolicy = NULL;
-    UA_Server *const server = (UA_Server *const) application;
     for(size_t i = 0; i < server->config.securityPoliciesSize; ++i) {
         UA_SecurityPolicy *policy = &server->config.securityPolicies[i];
         if(!UA_ByteString_equal(&asymHeader->securityPolicyUri, &policy->policyUri))
@@ -639,10 +833,19 @@ createServerSecureChannel(UA_BinaryProtocolManager *bpm, UA_ConnectionManager *c
     /* Set up the new SecureChannel */
     UA_SecureChannel_init(channel);
     channel->config = connConfig;
+#if UA_MULTITHREADING >= 200
+    channel->parallelDecryptThreshold = config->parallelDecryptThreshold;
+    channel->parallelDecryptThreads = config->parallelDecryptThreads;
+    channel->asyncHandshake = config->asyncHandshake;
+#endif
     channel->certificateVerification = &config->secureChannelPKI;
+    channel->certificateCache = &server->certificateCache;
+    server->certificateCache.ttl =
+        (UA_DateTime)config->certificateCacheTtl * UA_DATETIME_MSEC;
     channel->processOPNHeader = configServerSecureChannel;
     channel->connectionManager = cm;
     channel->connectionId = connectionId;
+    channel->capture = config->packetCapture;
 
     /* Set the SecureChannel identifier already here. So we get the right
      * identifier for logging right away. The rest of the SecurityToken is set
@@ -662,6 +865,7 @@ createServerSecureChannel(UA_BinaryProtocolManager *bpm, UA_ConnectionManager *c
     /* Add to the server's list */
     TAILQ_INSERT_TAIL(&server->channels, channel, serverEntry);
     TAILQ_INSERT_TAIL(&bpm->channels, channel, componentEntry);
+    scheduleChannelTimeout(server, channel);
 
     /* Update the statistics */
     server->secureChannelStatistics.currentChannelCount++;
@@ -690,6 +894,7 @@ addDiscoveryUrl(UA_Server *server, const UA_String hostname, UA_UInt16 port) {
         UA_Array_appendCopy((void **)&server->config.applicationDescription.discoveryUrls,
                             &server->config.applicationDescription.discoveryUrlsSize,
                             &discoveryServerUrl, &UA_TYPES[UA_TYPES_STRING]);
+    server->endpointsEpoch++;
     if(res == UA_STATUSCODE_GOOD) {
         UA_LOG_INFO(server->config.logging, UA_LOGCATEGORY_SERVER,
                     "New DiscoveryUrl added: %S", discoveryServerUrl);
@@ -700,12 +905,12 @@ addDiscoveryUrl(UA_Server *server, const UA_String hostname, UA_UInt16 port) {
 }
 
 /* Callback of a TCP socket (server socket or an active connection) */
-void
-serverNetworkCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
-                      void *application, void **connectionContext,
-                      UA_ConnectionState state,
-                      const UA_KeyValueMap *params,
-                      UA_ByteString msg) {
+static void
+serverNetworkCallbackInternal(UA_ConnectionManager *cm, uintptr_t connectionId,
+                            void *application, void **connectionContext,
+                            UA_ConnectionState state,
+                            const UA_KeyValueMap *params,
+                            UA_ByteString msg) {
     UA_BinaryProtocolManager *bpm = (UA_BinaryProtocolManager*)application;
 
     /* A server socket that is not yet registered in the server. Register it and
@@ -816,7 +1021,7 @@ serverNetworkCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
     retval = UA_SecureChannel_processBuffer(channel, bpm->sc.server,
                                             processSecureChannelMessage,
                                             &msg, nowMonotonic);
-    if(retval != UA_STATUSCODE_GOOD) {
+    if(UA_UNLIKELY(retval != UA_STATUSCODE_GOOD)) {
         UA_LOG_WARNING_CHANNEL(bpm->logging, channel,
                                "Processing the message failed with error %s",
                                UA_StatusCode_name(retval));
@@ -830,6 +1035,34 @@ serverNetworkCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
     }
 }
 
+/* Without the request executor, the service lock is only taken for the
+ * processing of MSG requests. With the executor, the workers send responses
+ * while holding the service lock. So also the network input of the
+ * SecureChannels (which can send the OPN responses, errors, etc.) is processed
+ * with the lock held. The requests are then only dispatched to the workers.
+ *
+ * The announcement of a new listen socket (without a context yet) is called
+ * synchronously from openConnection with the service lock already held. */
+void
+serverNetworkCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
+                      void *application, void **connectionContext,
+                      UA_ConnectionState state,
+                      const UA_KeyValueMap *params,
+                      UA_ByteString msg) {
+#ifdef UA_REQUEST_EXECUTOR
+    UA_Server *server = ((UA_BinaryProtocolManager*)application)->sc.server;
+    if(server->requestExecutor.enabled && *connectionContext != NULL) {
+        UA_LOCK(&server->serviceMutex);
+        serverNetworkCallbackInternal(cm, connectionId, application,
+                                    connectionContext, state, params, msg);
+        UA_UNLOCK(&server->serviceMutex);
+        return;
+    }
+#endif
+    serverNetworkCallbackInternal(cm, connectionId, application,
+                                connectionContext, state, params, msg);
+}
+
 static UA_StatusCode
 createServerConnection(UA_BinaryProtocolManager *bpm, const UA_String *serverUrl) {
     UA_Server *server = bpm->sc.server;
@@ -845,6 +1078,34 @@ createServerConnection(UA_BinaryProtocolManager *bpm, const UA_String *serverUrl
     if(res != UA_STATUSCODE_GOOD)
         return res;
 
+    /* Shared-memory endpoint for local clients. The hostname is the name of
+     * the endpoint. */
+    UA_Boolean listen = true;
+    UA_String shmString = UA_STRING("shm");
+    if(serverUrl->length > 10 &&
+       strncmp((const char*)serverUrl->data, "opc.shm://", 10) == 0) {
+        for(UA_EventSource *es = config->eventLoop->eventSources;
+            es != NULL; es = es->next) {
+            if(es->eventSourceType != UA_EVENTSOURCETYPE_CONNECTIONMANAGER)
+                continue;
+            UA_ConnectionManager *cm = (UA_ConnectionManager*)es;
+            if(!UA_String_equal(&shmString, &cm->protocol))
+                continue;
+
+            UA_KeyValuePair params[2];
+            params[0].key = UA_QUALIFIEDNAME(0, "address");
+            UA_Variant_setScalar(&params[0].value, &hostname, &UA_TYPES[UA_TYPES_STRING]);
+            params[1].key = UA_QUALIFIEDNAME(0, "listen");
+            UA_Variant_setScalar(&params[1].value, &listen, &UA_TYPES[UA_TYPES_BOOLEAN]);
+            UA_KeyValueMap paramsMap = {2, params};
+
+            res = cm->openConnection(cm, &paramsMap, bpm, NULL, serverNetworkCallback);
+            if(res == UA_STATUSCODE_GOOD)
+                return res;
+        }
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
     UA_String tcpString = UA_STRING("tcp");
     for(UA_EventSource *es = config->eventLoop->eventSources;
         es != NULL; es = es->next) {
@@ -862,7 +1123,6 @@ createServerConnection(UA_BinaryProtocolManager *bpm, const UA_String *serverUrl
         params[0].key = UA_QUALIFIEDNAME(0, "port");
         UA_Variant_setScalar(&params[0].value, &port, &UA_TYPES[UA_TYPES_UINT16]);
 
-        UA_Boolean listen = true;
         params[1].key = UA_QUALIFIEDNAME(0, "listen");
         UA_Variant_setScalar(&params[1].value, &listen, &UA_TYPES[UA_TYPES_BOOLEAN]);
 
@@ -890,26 +1150,6 @@ createServerConnection(UA_BinaryProtocolManager *bpm, const UA_String *serverUrl
     return UA_STATUSCODE_BADINTERNALERROR;
 }
 
-/* Remove timed out SecureChannels */
-static void
-secureChannelHouseKeeping(UA_Server *server, void *context) {
-    UA_BinaryProtocolManager *bpm = (UA_BinaryProtocolManager*)context;
-    UA_LOCK(&server->serviceMutex);
-
-    UA_EventLoop *el = server->config.eventLoop;
-    UA_DateTime nowMonotonic = el->dateTime_nowMonotonic(el);
-
-    UA_SecureChannel *channel;
-    TAILQ_FOREACH(channel, &bpm->channels, componentEntry) {
-        UA_Boolean timeout = UA_SecureChannel_checkTimeout(channel, nowMonotonic);
-        if(timeout) {
-            UA_LOG_INFO_CHANNEL(bpm->logging, channel, "SecureChannel has timed out");
-            UA_SecureChannel_shutdown(channel, UA_SHUTDOWNREASON_TIMEOUT);
-        }
-    }
-    UA_UNLOCK(&server->serviceMutex);
-}
-
 /**********************/
 /* Reverse Connection */
 /**********************/
@@ -1166,11 +1406,12 @@ UA_Server_removeReverseConnect(UA_Server *server, UA_UInt64 handle) {
     return result;
 }
 
-void
-serverReverseConnectCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
-                             void *application, void **connectionContext,
-                             UA_ConnectionState state, const UA_KeyValueMap *params,
-                             UA_ByteString msg) {
+static void
+serverReverseConnectCallbackInternal(UA_ConnectionManager *cm, uintptr_t connectionId,
+                                     void *application, void **connectionContext,
+                                     UA_ConnectionState state,
+                                     const UA_KeyValueMap *params,
+                                     UA_ByteString msg) {
     (void)params;
     UA_BinaryProtocolManager *bpm = (UA_BinaryProtocolManager*)application;
     UA_LOG_DEBUG(bpm->logging, UA_LOGCATEGORY_SERVER,
@@ -1281,6 +1522,28 @@ serverReverseConnectCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
     setReverseConnectState(bpm->sc.server, context, context->channel->state);
 }
 
+/* See serverNetworkCallback for the locking with the request executor. The
+ * OPENING callback is called synchronously from attemptReverseConnect with the
+ * service lock already held. */
+void
+serverReverseConnectCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
+                             void *application, void **connectionContext,
+                             UA_ConnectionState state, const UA_KeyValueMap *params,
+                             UA_ByteString msg) {
+#ifdef UA_REQUEST_EXECUTOR
+    UA_Server *server = ((UA_BinaryProtocolManager*)application)->sc.server;
+    if(server->requestExecutor.enabled && state != UA_CONNECTIONSTATE_OPENING) {
+        UA_LOCK(&server->serviceMutex);
+        serverReverseConnectCallbackInternal(cm, connectionId, application,
+                                             connectionContext, state, params, msg);
+        UA_UNLOCK(&server->serviceMutex);
+        return;
+    }
+#endif
+    serverReverseConnectCallbackInternal(cm, connectionId, application,
+                                         connectionContext, state, params, msg);
+}
+
 /***************************/
 /* Binary Protocol Manager */
 /***************************/
@@ -1290,12 +1553,7 @@ UA_BinaryProtocolManager_start(UA_ServerComponent *sc, UA_Server *server) {
     UA_BinaryProtocolManager *bpm = (UA_BinaryProtocolManager*)sc;
 
     UA_ServerConfig *config = &server->config;
-    
-    UA_StatusCode retVal =
-        addRepeatedCallback(server, secureChannelHouseKeeping,
-                            bpm, 1000.0, &bpm->houseKeepingCallbackId);
-    if(retVal != UA_STATUSCODE_GOOD)
-        return retVal;
+    UA_StatusCode retVal = UA_STATUSCODE_GOOD;
 
     /* Open server sockets */
     UA_Boolean haveServerSocket = false;
@@ -1347,6 +1605,7 @@ UA_BinaryProtocolManager_start(UA_ServerComponent *sc, UA_Server *server) {
                 UA_Array_appendCopy((void**)&config->applicationDescription.discoveryUrls,
                                     &config->applicationDescription.discoveryUrlsSize,
                                     &config->serverUrls[i], &UA_TYPES[UA_TYPES_STRING]);
+            server->endpointsEpoch++;
             (void)retVal;
         }
     }
@@ -1361,10 +1620,6 @@ static void
 UA_BinaryProtocolManager_stop(UA_ServerComponent *comp) {
     UA_BinaryProtocolManager *bpm = (UA_BinaryProtocolManager*)comp;
 
-    /* Stop the Housekeeping Task */
-    removeCallback(bpm->sc.server, bpm->houseKeepingCallbackId);
-    bpm->houseKeepingCallbackId = 0;
-
     /* Stop the regular retry callback */
     setReverseConnectRetryCallback(bpm, false);
 
@@ -10,6 +10,13 @@
 
 #include "ua_server_internal.h"
 
+static void
+clearThreadPlacement(UA_ThreadPlacement *tp) {
+    UA_free(tp->cpus);
+    UA_free(tp->numaNodes);
+    memset(tp, 0, sizeof(UA_ThreadPlacement));
+}
+
 void
 UA_ServerConfig_clear(UA_ServerConfig *config) {
     if(!config)
@@ -41,12 +48,23 @@ UA_ServerConfig_clear(UA_ServerConfig *config) {
         el->free(el);
         config->eventLoop = NULL;
     }
+    clearThreadPlacement(&config->eventLoopPlacement);
+#if UA_MULTITHREADING >= 200
+    clearThreadPlacement(&config->requestWorkerPlacement);
+#endif
+#if UA_MULTITHREADING >= 100
+    clearThreadPlacement(&config->asyncOperationWorkerPlacement);
+#endif
 
     /* Networking */
     UA_Array_delete(config->serverUrls, config->serverUrlsSize,
                     &UA_TYPES[UA_TYPES_STRING]);
     config->serverUrls = NULL;
     config->serverUrlsSize = 0;
+    if(config->packetCapture) {
+        config->packetCapture->clear(config->packetCapture);
+        config->packetCapture = NULL;
+    }
 
     /* Security Policies */
     for(size_t i = 0; i < config->securityPoliciesSize; ++i) {
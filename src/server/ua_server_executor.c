@@ -0,0 +1,334 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "ua_server_internal.h"
+
+#ifdef UA_REQUEST_EXECUTOR
+
+#define UA_REQUESTEXECUTOR_MAXWORKERS 256
+
+static void
+deleteRequestQueue(UA_RequestQueue *q) {
+    UA_RequestJob *job, *job_tmp;
+    TAILQ_FOREACH_SAFE(job, &q->jobs, pointers, job_tmp) {
+        TAILQ_REMOVE(&q->jobs, job, pointers);
+        UA_free(job);
+    }
+    LIST_REMOVE(q, listEntry);
+    UA_NodeId_clear(&q->authenticationToken);
+    UA_free(q);
+}
+
+/* Called with the executor mutex held */
+static UA_RequestQueue *
+getRequestQueue(UA_RequestExecutor *re, UA_SecureChannel *channel,
+                const UA_NodeId *authenticationToken) {
+    UA_RequestQueue *q;
+    LIST_FOREACH(q, &re->queues, listEntry) {
+        if(q->channel == channel && !q->cancelled &&
+           UA_NodeId_equal(&q->authenticationToken, authenticationToken))
+            return q;
+    }
+
+    q = (UA_RequestQueue*)UA_calloc(1, sizeof(UA_RequestQueue));
+    if(!q)
+        return NULL;
+    if(UA_NodeId_copy(authenticationToken, &q->authenticationToken) != UA_STATUSCODE_GOOD) {
+        UA_free(q);
+        return NULL;
+    }
+    q->channel = channel;
+    TAILQ_INIT(&q->jobs);
+    LIST_INSERT_HEAD(&re->queues, q, listEntry);
+    return q;
+}
+
+UA_StatusCode
+UA_RequestExecutor_dispatch(UA_RequestExecutor *re, UA_SecureChannel *channel,
+                            UA_UInt32 requestId, UA_ServiceDescription *sd,
+                            const UA_NodeId *authenticationToken,
+                            const UA_ByteString *msg, size_t msgSegments,
+                            size_t offset) {
+    /* Copy the message. The chunks are released when the callback returns. */
+    size_t length = 0;
+    for(size_t i = 0; i < msgSegments; i++)
+        length += msg[i].length;
+    UA_RequestJob *job = (UA_RequestJob*)UA_malloc(sizeof(UA_RequestJob) + length);
+    if(!job)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    job->requestId = requestId;
+    job->sd = sd;
+    job->offset = offset;
+    job->message.data = (UA_Byte*)&job[1];
+    job->message.length = length;
+    UA_Byte *pos = job->message.data;
+    for(size_t i = 0; i < msgSegments; i++) {
+        if(msg[i].length == 0)
+            continue;
+        memcpy(pos, msg[i].data, msg[i].length);
+        pos += msg[i].length;
+    }
+
+    pthread_mutex_lock(&re->mutex);
+    if(re->workersSize == 0 || re->stopWorkers) {
+        pthread_mutex_unlock(&re->mutex);
+        UA_free(job);
+        return UA_STATUSCODE_BADSHUTDOWN;
+    }
+    UA_RequestQueue *q = getRequestQueue(re, channel, authenticationToken);
+    if(!q) {
+        pthread_mutex_unlock(&re->mutex);
+        UA_free(job);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    TAILQ_INSERT_TAIL(&q->jobs, job, pointers);
+
+    /* The queue becomes ready unless a worker already processes it. The
+     * worker puts it back into the ready list when it is done. */
+    if(!q->ready && !q->busy) {
+        q->ready = true;
+        TAILQ_INSERT_TAIL(&re->readyQueues, q, readyEntry);
+        pthread_cond_signal(&re->condition);
+    }
+    pthread_mutex_unlock(&re->mutex);
+    return UA_STATUSCODE_GOOD;
+}
+
+void
+UA_RequestExecutor_cancel(UA_RequestExecutor *re, UA_SecureChannel *channel) {
+    pthread_mutex_lock(&re->mutex);
+    UA_RequestQueue *q, *q_tmp;
+    LIST_FOREACH_SAFE(q, &re->queues, listEntry, q_tmp) {
+        if(q->channel != channel || q->cancelled)
+            continue;
+        q->cancelled = true;
+        if(q->ready) {
+            TAILQ_REMOVE(&re->readyQueues, q, readyEntry);
+            q->ready = false;
+        }
+        /* The worker deletes the queue when it is done */
+        if(q->busy)
+            continue;
+        deleteRequestQueue(q);
+    }
+    pthread_mutex_unlock(&re->mutex);
+}
+
+/* Same as processMSG. But the request is decoded before the service lock is
+ * taken. And the response is sent with the lock held. */
+static void
+processRequestJob(UA_Server *server, UA_RequestWorker *w,
+                  UA_RequestQueue *q, UA_RequestJob *job) {
+    UA_ServiceDescription *sd = job->sd;
+
+    /* Decode the request */
+    UA_DecodeBinaryOptions opt;
+    memset(&opt, 0, sizeof(UA_DecodeBinaryOptions));
+    opt.customTypes = server->config.customDataTypes;
+    UA_Arena *arena = NULL;
+    if(server->config.requestArenaSize > 0) {
+        arena = &w->arena;
+        arena->blockSize = server->config.requestArenaSize;
+        opt.callocContext = arena;
+        opt.calloc = UA_Arena_calloc;
+        opt.borrowStrings = true; /* The job outlives the request */
+    }
+    UA_Request request;
+    size_t offset = job->offset;
+    UA_MemoryCategory mc = UA_MemoryCategory_enter(UA_MEMORYCATEGORY_ENCODING);
+    UA_StatusCode decodeRes =
+        UA_decodeBinarySegments(&job->message, 1, &offset, &request,
+                                sd->requestType, &opt);
+    UA_MemoryCategory_leave(mc);
+
+    UA_LOCK(&server->serviceMutex);
+
+    /* The SecureChannel was removed in the meantime */
+    UA_SecureChannel *channel = q->channel;
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    UA_Response response;
+    if(q->cancelled || channel->state != UA_SECURECHANNELSTATE_OPEN)
+        goto unlock;
+
+    if(decodeRes != UA_STATUSCODE_GOOD) {
+        UA_LOG_DEBUG_CHANNEL(server->config.logging, channel,
+                             "Could not decode the request with StatusCode %s",
+                             UA_StatusCode_name(decodeRes));
+        res = decodeHeaderSendServiceFault(server, channel, &job->message, 1,
+                                           job->offset, sd->responseType,
+                                           job->requestId, decodeRes);
+        goto unlock;
+    }
+
+    /* Process the request and send the response */
+    UA_init(&response, sd->responseType);
+    response.responseHeader.requestHandle = request.requestHeader.requestHandle;
+    channel->pinNodes = (sd->requestType == &UA_TYPES[UA_TYPES_READREQUEST]);
+    UA_Boolean async =
+        UA_Server_processRequest(server, channel, job->requestId,
+                                 sd, &request, &response);
+    channel->pinNodes = false;
+    if(!async)
+        res = sendResponse(server, channel, job->requestId,
+                           &response, sd->responseType);
+    if(channel->pinnedNodesSize > 0)
+        releasePinnedNodes(server, channel);
+    UA_clear(&response, sd->responseType);
+
+ unlock:
+    /* Close the SecureChannel as processSecureChannelMessage does */
+    if(res != UA_STATUSCODE_GOOD && UA_SecureChannel_isConnected(channel)) {
+        UA_LOG_INFO_CHANNEL(server->config.logging, channel,
+                            "Processing the message failed with StatusCode %s. "
+                            "Closing the channel.", UA_StatusCode_name(res));
+        UA_TcpErrorMessage errMsg;
+        UA_TcpErrorMessage_init(&errMsg);
+        errMsg.error = res;
+        UA_SecureChannel_sendError(channel, &errMsg);
+        UA_SecureChannel_shutdown(channel, UA_SHUTDOWNREASON_CLOSE);
+    }
+    UA_UNLOCK(&server->serviceMutex);
+
+    /* Clean up. Requests decoded into the arena have no individual
+     * allocations. */
+    if(arena)
+        UA_Arena_reset(arena);
+    else if(decodeRes == UA_STATUSCODE_GOOD)
+        UA_clear(&request, sd->requestType);
+}
+
+static void *
+requestWorkerLoop(void *data) {
+    UA_RequestWorker *w = (UA_RequestWorker*)data;
+    UA_Server *server = w->server;
+    UA_RequestExecutor *re = &server->requestExecutor;
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+    UA_mallocSingleton = w->mallocSingleton;
+    UA_freeSingleton = w->freeSingleton;
+    UA_callocSingleton = w->callocSingleton;
+    UA_reallocSingleton = w->reallocSingleton;
+#endif
+    applyThreadPlacement(server, &server->config.requestWorkerPlacement,
+                         "request worker");
+
+    pthread_mutex_lock(&re->mutex);
+    while(true) {
+        /* Wait for work */
+        while(TAILQ_EMPTY(&re->readyQueues) && !re->stopWorkers)
+            pthread_cond_wait(&re->condition, &re->mutex);
+        if(re->stopWorkers)
+            break;
+
+        /* Take the first job of the next ready queue */
+        UA_RequestQueue *q = TAILQ_FIRST(&re->readyQueues);
+        TAILQ_REMOVE(&re->readyQueues, q, readyEntry);
+        q->ready = false;
+        q->busy = true;
+        UA_RequestJob *job = TAILQ_FIRST(&q->jobs);
+        TAILQ_REMOVE(&q->jobs, job, pointers);
+        pthread_mutex_unlock(&re->mutex);
+
+        processRequestJob(server, w, q, job);
+        UA_free(job);
+
+        /* Put the queue back into the ready list or delete it */
+        pthread_mutex_lock(&re->mutex);
+        q->busy = false;
+        if(q->cancelled || TAILQ_EMPTY(&q->jobs)) {
+            deleteRequestQueue(q);
+        } else {
+            q->ready = true;
+            TAILQ_INSERT_TAIL(&re->readyQueues, q, readyEntry);
+        }
+    }
+    pthread_mutex_unlock(&re->mutex);
+    return NULL;
+}
+
+void
+UA_RequestExecutor_init(UA_RequestExecutor *re) {
+    memset(re, 0, sizeof(UA_RequestExecutor));
+    pthread_mutex_init(&re->mutex, NULL);
+    pthread_cond_init(&re->condition, NULL);
+    LIST_INIT(&re->queues);
+    TAILQ_INIT(&re->readyQueues);
+}
+
+void
+UA_RequestExecutor_start(UA_RequestExecutor *re, UA_Server *server) {
+    size_t workers = server->config.requestWorkers;
+    re->enabled = (workers > 0);
+    if(workers == 0)
+        return;
+    if(workers > UA_REQUESTEXECUTOR_MAXWORKERS)
+        workers = UA_REQUESTEXECUTOR_MAXWORKERS;
+    re->workers = (UA_RequestWorker*)UA_calloc(workers, sizeof(UA_RequestWorker));
+    if(!re->workers) {
+        UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_SERVER,
+                     "Could not allocate the request workers");
+        return;
+    }
+    re->workersSize = workers;
+    re->stopWorkers = false;
+    size_t started = 0;
+    for(size_t i = 0; i < workers; i++) {
+        UA_RequestWorker *w = &re->workers[i];
+        w->server = server;
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+        w->mallocSingleton = UA_mallocSingleton;
+        w->freeSingleton = UA_freeSingleton;
+        w->callocSingleton = UA_callocSingleton;
+        w->reallocSingleton = UA_reallocSingleton;
+#endif
+        w->started = (pthread_create(&w->thread, NULL, requestWorkerLoop, w) == 0);
+        if(w->started)
+            started++;
+    }
+    if(started < workers)
+        UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
+                       "Could only start %u of %u request workers",
+                       (unsigned)started, (unsigned)workers);
+}
+
+/* The remaining jobs are dropped. The SecureChannels are closed during the
+ * shutdown anyway. */
+void
+UA_RequestExecutor_stop(UA_RequestExecutor *re, UA_Server *server) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+    if(re->workersSize == 0)
+        return;
+
+    /* Wait for the workers. They need the service lock to finish the current
+     * job. */
+    pthread_mutex_lock(&re->mutex);
+    re->stopWorkers = true;
+    pthread_cond_broadcast(&re->condition);
+    pthread_mutex_unlock(&re->mutex);
+    UA_UNLOCK(&server->serviceMutex);
+    for(size_t i = 0; i < re->workersSize; i++) {
+        if(re->workers[i].started)
+            pthread_join(re->workers[i].thread, NULL);
+    }
+    UA_LOCK(&server->serviceMutex);
+
+    pthread_mutex_lock(&re->mutex);
+    while(!LIST_EMPTY(&re->queues))
+        deleteRequestQueue(LIST_FIRST(&re->queues));
+    TAILQ_INIT(&re->readyQueues);
+    for(size_t i = 0; i < re->workersSize; i++)
+        UA_Arena_clear(&re->workers[i].arena);
+    UA_free(re->workers);
+    re->workers = NULL;
+    re->workersSize = 0;
+    pthread_mutex_unlock(&re->mutex);
+}
+
+void
+UA_RequestExecutor_clear(UA_RequestExecutor *re) {
+    pthread_mutex_destroy(&re->mutex);
+    pthread_cond_destroy(&re->condition);
+}
+
+#endif /* UA_REQUEST_EXECUTOR */
@@ -0,0 +1,116 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef UA_SERVER_EXECUTOR_H_
+#define UA_SERVER_EXECUTOR_H_
+
+#include <open62541/server.h>
+
+#include "open62541_queue.h"
+#include "ua_services.h"
+#include "../ua_securechannel.h"
+#include "../util/ua_util_internal.h"
+
+_UA_BEGIN_DECLS
+
+#if UA_MULTITHREADING >= 200 && defined(UA_ARCHITECTURE_POSIX)
+#define UA_REQUEST_EXECUTOR
+
+/* Request Executor
+ * ----------------
+ * Service requests are processed by a pool of worker threads instead of the
+ * EventLoop. The EventLoop copies the received message into a job and appends
+ * it to the serial queue of the (SecureChannel, AuthenticationToken) pair. So
+ * the requests of a Session are processed one after the other in the order
+ * they were received. Only one worker at a time takes jobs from a queue. The
+ * queues with pending jobs are kept in a ready list. Queues exist only as long
+ * as they have jobs.
+ *
+ * The workers decode the request without holding the service lock. The
+ * service is executed and the response is sent with the service lock held.
+ * In turn, the EventLoop holds the service lock while it processes the
+ * network input of the SecureChannels (see serverNetworkCallback). So the
+ * messages sent on a SecureChannel are never interleaved. */
+
+typedef struct UA_RequestJob {
+    TAILQ_ENTRY(UA_RequestJob) pointers;
+    UA_UInt32 requestId;
+    UA_ServiceDescription *sd;
+    size_t offset;   /* Start of the request in the message */
+    UA_ByteString message; /* Allocated together with the job */
+} UA_RequestJob;
+
+typedef TAILQ_HEAD(UA_RequestJobQueue, UA_RequestJob) UA_RequestJobQueue;
+
+typedef struct UA_RequestQueue {
+    LIST_ENTRY(UA_RequestQueue) listEntry;
+    TAILQ_ENTRY(UA_RequestQueue) readyEntry;
+    UA_SecureChannel *channel;
+    UA_NodeId authenticationToken;
+    UA_RequestJobQueue jobs;
+    UA_Boolean ready;     /* In the ready list */
+    UA_Boolean busy;      /* A worker processes the first job */
+    UA_Boolean cancelled; /* The SecureChannel was removed. Written with both
+                           * the serviceMutex and the executor mutex held. */
+} UA_RequestQueue;
+
+typedef struct {
+    pthread_t thread;
+    UA_Boolean started;
+    UA_Server *server;
+    UA_Arena arena; /* Decoding arena if config.requestArenaSize > 0 */
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+    /* The allocator is thread-local. Use the same as the server thread. */
+    void * (*mallocSingleton)(size_t size);
+    void (*freeSingleton)(void *ptr);
+    void * (*callocSingleton)(size_t nelem, size_t elsize);
+    void * (*reallocSingleton)(void *ptr, size_t size);
+#endif
+} UA_RequestWorker;
+
+typedef struct {
+    /* Protects the queues. Can be taken while holding the serviceMutex. Never
+     * take the serviceMutex when the executor mutex is already acquired
+     * (deadlock)! */
+    pthread_mutex_t mutex;
+    pthread_cond_t condition; /* Idle workers wait for ready queues */
+    LIST_HEAD(, UA_RequestQueue) queues;
+    TAILQ_HEAD(, UA_RequestQueue) readyQueues;
+    UA_Boolean stopWorkers;
+
+    /* Set in UA_RequestExecutor_start. Requests are dispatched to the workers
+     * only if enabled. */
+    UA_Boolean enabled;
+    UA_RequestWorker *workers;
+    size_t workersSize;
+} UA_RequestExecutor;
+
+void UA_RequestExecutor_init(UA_RequestExecutor *re);
+void UA_RequestExecutor_start(UA_RequestExecutor *re, UA_Server *server);
+void UA_RequestExecutor_stop(UA_RequestExecutor *re, UA_Server *server);
+void UA_RequestExecutor_clear(UA_RequestExecutor *re);
+
+/* Copy the message into a job for the serial queue of the
+ * AuthenticationToken. The offset points to the start of the request (after
+ * the NodeId of the request type). Returns BadShutdown if the workers are
+ * stopped. */
+UA_StatusCode
+UA_RequestExecutor_dispatch(UA_RequestExecutor *re, UA_SecureChannel *channel,
+                            UA_UInt32 requestId, UA_ServiceDescription *sd,
+                            const UA_NodeId *authenticationToken,
+                            const UA_ByteString *msg, size_t msgSegments,
+                            size_t offset);
+
+/* Remove the pending jobs of the SecureChannel. A job that is currently
+ * decoded by a worker is dropped when the worker takes the service lock.
+ * Called with the serviceMutex held before the SecureChannel is freed. */
+void
+UA_RequestExecutor_cancel(UA_RequestExecutor *re, UA_SecureChannel *channel);
+
+#endif /* UA_MULTITHREADING >= 200 && UA_ARCHITECTURE_POSIX */
+
+_UA_END_DECLS
+
+#endif /* UA_SERVER_EXECUTOR_H_ */
@@ -26,6 +26,7 @@
 #include "ua_session.h"
 #include "ua_services.h"
 #include "ua_server_async.h"
+#include "ua_server_executor.h"
 #include "../util/ua_util_internal.h"
 #include "ziptree.h"
 
@@ -168,9 +169,230 @@ getServerComponentByName(UA_Server *server, UA_String name);
 typedef struct session_list_entry {
     UA_DelayedCallback cleanupCallback;
     LIST_ENTRY(session_list_entry) pointers;
+    ZIP_ENTRY(session_list_entry) tokenTreeEntry;
+    ZIP_ENTRY(session_list_entry) idTreeEntry;
+    UA_UInt64 timeoutCallbackId; /* One-shot timer at validTill */
     UA_Session session;
 } session_list_entry;
 
+enum ZIP_CMP
+cmpSessionNodeId(const UA_NodeId *a, const UA_NodeId *b);
+
+/* Index of the sessions by their AuthenticationToken and SessionId. The
+ * sessions are additionally kept in a list for iteration. */
+typedef ZIP_HEAD(UA_SessionTokenTree, session_list_entry) UA_SessionTokenTree;
+ZIP_FUNCTIONS(UA_SessionTokenTree, session_list_entry, tokenTreeEntry,
+              UA_NodeId, session.authenticationToken, cmpSessionNodeId)
+
+typedef ZIP_HEAD(UA_SessionIdTree, session_list_entry) UA_SessionIdTree;
+ZIP_FUNCTIONS(UA_SessionIdTree, session_list_entry, idTreeEntry,
+              UA_NodeId, session.sessionId, cmpSessionNodeId)
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
+/* Index of the conditions by their ConditionId and of the condition sources.
+ * The tree functions are defined in ua_subscription_alarms_conditions.c. */
+struct UA_Condition;
+struct UA_ConditionWatch;
+typedef ZIP_HEAD(UA_ConditionIdTree, UA_Condition) UA_ConditionIdTree;
+typedef ZIP_HEAD(UA_ConditionSourceTree, UA_ConditionSource) UA_ConditionSourceTree;
+typedef ZIP_HEAD(UA_ConditionWatchTree, UA_ConditionWatch) UA_ConditionWatchTree;
+#endif
+
+/* Cache of the HasSubtype hierarchy for O(1) subtype checks in isNodeInTree.
+ * Every node with HasSubtype references gets the interval [pre, post] of an
+ * Euler tour over the hierarchy. A node is a supertype of a leaf if the
+ * interval of the leaf is contained in its interval. The cache is invalidated
+ * when HasSubtype references are added or deleted and rebuilt lazily. */
+typedef struct {
+    UA_NodeId nodeId;
+    UA_UInt32 hash;
+    UA_Boolean used;
+    UA_UInt16 depth;
+    UA_UInt32 parent; /* Entry indices or UA_UINT32_MAX */
+    UA_UInt32 firstChild;
+    UA_UInt32 nextSibling;
+    UA_UInt32 pre;  /* 0 if not reachable from a root (cycle) */
+    UA_UInt32 post;
+} UA_TypeHierarchyEntry;
+
+typedef struct {
+    UA_Boolean valid;
+    size_t walks; /* Lookups without the cache since the invalidation */
+    size_t capacity; /* Power of two */
+    UA_TypeHierarchyEntry *entries;
+} UA_TypeHierarchy;
+
+void
+invalidateTypeHierarchy(UA_Server *server);
+
+void
+clearTypeHierarchy(UA_Server *server);
+
+/* LRU cache of TranslateBrowsePath results. The results depend only on the
+ * references between nodes. The cache is emptied when the hierarchyEpoch of
+ * the server has changed since the entries were added. */
+#define UA_BROWSEPATHCACHE_SIZE 4096
+#define UA_BROWSEPATHCACHE_BUCKETS 1024 /* Power of two */
+
+typedef struct UA_BrowsePathCacheEntry {
+    TAILQ_ENTRY(UA_BrowsePathCacheEntry) lruEntry; /* Most recent first */
+    LIST_ENTRY(UA_BrowsePathCacheEntry) bucketEntry;
+    UA_UInt32 hash;
+    UA_UInt32 nodeClassMask;
+    UA_BrowsePath path;
+    UA_BrowsePathResult result;
+} UA_BrowsePathCacheEntry;
+
+typedef TAILQ_HEAD(UA_BrowsePathCacheLru, UA_BrowsePathCacheEntry)
+    UA_BrowsePathCacheLru;
+
+typedef struct {
+    UA_UInt32 epoch;
+    size_t size;
+    UA_BrowsePathCacheLru lru;
+    LIST_HEAD(, UA_BrowsePathCacheEntry) buckets[UA_BROWSEPATHCACHE_BUCKETS];
+} UA_BrowsePathCache;
+
+void
+clearBrowsePathCache(UA_Server *server);
+
+/* Cache of encoded EndpointDescription arrays returned by GetEndpoints. The
+ * arrays depend on the requested EndpointUrl and ProfileUris. The cache is
+ * emptied when the endpointsEpoch of the server has changed since the entries
+ * were added. */
+#define UA_ENDPOINTSCACHE_SIZE 4
+
+typedef struct {
+    UA_String endpointUrl;
+    UA_String *profileUris;
+    size_t profileUrisSize;
+    UA_ByteString encoded; /* Array length followed by the encoded elements */
+} UA_EndpointsCacheEntry;
+
+typedef struct {
+    UA_UInt32 epoch;
+    size_t size;
+    size_t next; /* Entry that is replaced next if the cache is full */
+    UA_EndpointsCacheEntry entries[UA_ENDPOINTSCACHE_SIZE];
+} UA_EndpointsCache;
+
+void
+clearEndpointsCache(UA_Server *server);
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+/* LRU cache of the event routes from a source node to the Event-MonitoredItems
+ * that receive its events. The route depends on the references (see
+ * hierarchyEpoch) and on the registered Event-MonitoredItems (see
+ * eventMonitoredItemsEpoch). The cache is emptied when one of them changes. */
+#define UA_EVENTROUTECACHE_SIZE 1024
+#define UA_EVENTROUTECACHE_BUCKETS 256 /* Power of two */
+
+typedef struct UA_EventRoute {
+    TAILQ_ENTRY(UA_EventRoute) lruEntry; /* Most recent first */
+    LIST_ENTRY(UA_EventRoute) bucketEntry;
+    UA_UInt32 hash;
+    UA_NodeId origin;
+    UA_StatusCode originStatus; /* Origin exists and is in the ObjectsFolder */
+    size_t emitNodesSize; /* Object nodes the event propagates to */
+    UA_NodeId *emitNodes;
+    size_t monitoredItemsSize;
+    UA_MonitoredItem **monitoredItems;
+    size_t refCount; /* Events currently emitted along the route */
+    UA_Boolean detached; /* Removed from the cache, free after the release */
+} UA_EventRoute;
+
+typedef TAILQ_HEAD(UA_EventRouteLru, UA_EventRoute) UA_EventRouteLru;
+
+typedef struct {
+    UA_UInt32 hierarchyEpoch;
+    UA_UInt32 monitoredItemsEpoch;
+    size_t size;
+    UA_EventRouteLru lru;
+    LIST_HEAD(, UA_EventRoute) buckets[UA_EVENTROUTECACHE_BUCKETS];
+} UA_EventRouteCache;
+
+void
+clearEventRouteCache(UA_Server *server);
+#endif
+
+#ifdef UA_ENABLE_METHODCALLS
+/* LRU cache of the (object, method) pairs of the Call service. An entry holds
+ * whether the method may be called on the object and the argument definitions
+ * of the method. It depends on the references (see hierarchyEpoch) and on the
+ * values of the argument variables (see methodArgumentsEpoch). The cache is
+ * emptied when one of them changes. */
+#define UA_METHODCALLCACHE_SIZE 1024
+#define UA_METHODCALLCACHE_BUCKETS 256 /* Power of two */
+
+typedef struct UA_MethodCallCacheEntry {
+    TAILQ_ENTRY(UA_MethodCallCacheEntry) lruEntry; /* Most recent first */
+    LIST_ENTRY(UA_MethodCallCacheEntry) bucketEntry;
+    UA_UInt32 hash;
+    UA_NodeId objectId;
+    UA_NodeId methodId;
+    UA_StatusCode relationStatus; /* Good or BadMethodInvalid */
+    UA_Boolean hasInputArguments;
+    UA_StatusCode inputArgumentsStatus; /* Bad if the definition is malformed */
+    size_t inputArgumentsSize;
+    UA_Argument *inputArguments;
+    size_t outputArgumentsSize;
+} UA_MethodCallCacheEntry;
+
+typedef TAILQ_HEAD(UA_MethodCallCacheLru, UA_MethodCallCacheEntry)
+    UA_MethodCallCacheLru;
+
+typedef struct {
+    UA_UInt32 hierarchyEpoch;
+    UA_UInt32 argumentsEpoch;
+    size_t size;
+    UA_MethodCallCacheLru lru;
+    LIST_HEAD(, UA_MethodCallCacheEntry) buckets[UA_METHODCALLCACHE_BUCKETS];
+} UA_MethodCallCache;
+
+void
+clearMethodCallCache(UA_Server *server);
+#endif
+
+/* Handle for the local access to the value of a VariableNode (see
+ * UA_Server_getValueHandle). The node is held with a reference from the
+ * Nodestore. It is valid as long as the nodestoreChanges counter is unchanged.
+ * Otherwise the NodeId is resolved again. */
+struct UA_ValueHandle {
+    LIST_ENTRY(UA_ValueHandle) listEntry;
+    UA_NodeId nodeId;
+    const UA_Node *node; /* NULL if not resolved */
+    UA_UInt32 nodestoreChanges;
+};
+
+void
+clearValueHandles(UA_Server *server);
+
+#if UA_MULTITHREADING >= 200 && defined(UA_ARCHITECTURE_POSIX)
+#define UA_PARALLELREAD_MAXTHREADS 64
+
+struct ParallelReadSlice;
+
+/* Worker threads for readParallel. The threads are started on demand and
+ * live until the server is deleted. The requesting thread publishes the
+ * slices of a request and takes part in processing them. Only one request at
+ * a time uses the pool. */
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t workCondition; /* Idle workers wait for slices */
+    pthread_cond_t doneCondition; /* Wait until all slices are processed */
+    pthread_t threads[UA_PARALLELREAD_MAXTHREADS - 1];
+    size_t threadsSize;
+    UA_Boolean stopWorkers;
+    struct ParallelReadSlice *slices;
+    size_t slicesSize; /* 0 -> the pool is unused */
+    size_t nextSlice;
+    size_t pendingSlices;
+} UA_ParallelReadPool;
+
+void UA_ParallelReadPool_init(UA_ParallelReadPool *pool);
+void UA_ParallelReadPool_clear(UA_ParallelReadPool *pool);
+#endif
+
 struct UA_Server {
     /* Config */
     UA_ServerConfig config;
@@ -181,7 +403,6 @@ struct UA_Server {
                           * down once the time has been reached */
 
     UA_LifecycleState state;
-    UA_UInt64 houseKeepingCallbackId;
 
     UA_UInt64 serverComponentIds; /* Counter to assign ids from */
     UA_ServerComponentTree serverComponents;
@@ -189,9 +410,17 @@ struct UA_Server {
 #if UA_MULTITHREADING >= 100
     UA_AsyncManager asyncManager;
 #endif
+#ifdef UA_REQUEST_EXECUTOR
+    UA_RequestExecutor requestExecutor;
+#endif
+#if UA_MULTITHREADING >= 200 && defined(UA_ARCHITECTURE_POSIX)
+    UA_ParallelReadPool parallelReadPool;
+#endif
 
     /* Session Management */
     LIST_HEAD(session_list, session_list_entry) sessions;
+    UA_SessionTokenTree sessionsByToken;
+    UA_SessionIdTree sessionsById;
     UA_UInt32 sessionCount;
     UA_UInt32 activeSessionCount;
 
@@ -208,10 +437,62 @@ struct UA_Server {
     size_t namespacesSize;
     UA_String *namespaces;
 
+    /* Open-addressing hash table of the namespaces from index 2 on. The
+     * entries are the namespace index plus one (zero for an empty slot). The
+     * first two namespaces are compared directly, as the URI of namespace 1
+     * can change until the server is started. */
+    UA_UInt32 *namespacesHash;
+    size_t namespacesHashCapacity; /* Power of two */
+
+    /* Cached HasSubtype hierarchy */
+    UA_TypeHierarchy typeHierarchy;
+
+    /* Incremented when references are added or deleted and when nodes are
+     * inserted or removed. Cached BrowsePath results are stale if the counter
+     * changed. */
+    UA_UInt32 hierarchyEpoch;
+    UA_BrowsePathCache browsePathCache;
+
+    /* Incremented when the configuration that goes into the EndpointDescription
+     * array changes (certificates, DiscoveryUrls, ...) */
+    UA_UInt32 endpointsEpoch;
+    UA_EndpointsCache endpointsCache;
+
+#ifdef UA_ENABLE_METHODCALLS
+    /* Incremented when the value of a variable with Argument definitions is
+     * written */
+    UA_UInt32 methodArgumentsEpoch;
+    UA_MethodCallCache methodCallCache;
+#endif
+
+    /* Incremented for every modification through the UA_NODESTORE_* macros.
+     * Nodes that were retrieved in advance are stale if the counter changed. */
+    UA_UInt32 nodestoreChanges;
+
+    /* Value handles of the local API */
+    LIST_HEAD(, UA_ValueHandle) valueHandles;
+
+    /* Nodes pinned for Read responses that are not yet encoded (see
+     * processMSG). As long as nodes are pinned, values replaced by a Write are
+     * retired instead of freed. */
+    size_t pinnedNodesCount;
+    UA_DataValue *retiredValues;
+    size_t retiredValuesSize;
+
     /* For bootstrapping, omit some consistency checks, creating a reference to
      * the parent and member instantiation */
     UA_Boolean bootstrapNS0;
 
+    /* Set once a DataSource with a batch read callback was added. Only then
+     * are the value reads collected for the batches. */
+    UA_Boolean dataSourceBatchRead;
+
+    /* Nodes added between UA_Server_beginBulkLoad and _endBulkLoad. Their
+     * type-check and constructors are deferred. */
+    UA_Boolean bulkLoad;
+    size_t bulkLoadNodesSize;
+    UA_NodeId *bulkLoadNodes;
+
     /* Subscriptions */
 #ifdef UA_ENABLE_SUBSCRIPTIONS
     /* The admin session is initialized with a special subscription. This
@@ -225,9 +506,29 @@ struct UA_Server {
                                                  * server. They may be detached
                                                  * from a session. */
     UA_UInt32 lastSubscriptionId; /* To generate unique SubscriptionIds */
+    LIST_HEAD(, UA_SamplingGroup) samplingGroups; /* Cyclic sampling callbacks
+                                                   * by sampling interval */
+    TAILQ_HEAD(, UA_MonitoredItem) initialSamples; /* Deferred first samples of
+                                                    * batch-created items */
+    UA_UInt64 initialSamplesCallbackId;
+    LIST_HEAD(, UA_PublishGroup) publishGroups; /* Publish callbacks by
+                                                 * publishing interval */
+    UA_NotificationPool notificationPool;
+    size_t retransmissionQueueBytes; /* Encoded retransmission messages of all
+                                      * subscriptions */
+
+# ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    /* Incremented when Event-MonitoredItems are attached to or detached from
+     * their node */
+    UA_UInt32 eventMonitoredItemsEpoch;
+    UA_EventRouteCache eventRouteCache;
+# endif
 
 # ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
     LIST_HEAD(, UA_ConditionSource) conditionSources;
+    UA_ConditionSourceTree conditionSourceTree;
+    UA_ConditionIdTree conditionIdTree; /* All conditions */
+    UA_ConditionWatchTree conditionWatchTree; /* Nodes evaluated by limit alarms */
     UA_NodeId refreshEvents[2];
 # endif
 #endif
@@ -236,12 +537,29 @@ struct UA_Server {
     UA_Lock serviceMutex;
 #endif
 
+    /* Memory for decoding requests if config.requestArenaSize is set. Requests
+     * are decoded in the network callback of the EventLoop. So the arena is
+     * not used from two threads at the same time. */
+    UA_Arena requestArena;
+
     /* Statistics */
     UA_SecureChannelStatistics secureChannelStatistics;
     UA_ServerDiagnosticsSummaryDataType serverDiagnosticsSummary;
+    size_t sessionLookupCount; /* Lookups by AuthenticationToken or SessionId */
+    size_t sessionLookupSteps; /* Tree nodes visited during the lookups */
+#ifdef UA_ENABLE_DIAGNOSTICS
+    UA_ServiceStats *serviceStats; /* Same indices as the serviceDescriptions */
+#endif
+
+    /* Recently verified certificates of the SecureChannels */
+    UA_CertificateCache certificateCache;
 
     /* Transaction for certificate management */
     UA_GDSTransaction transaction;
+
+    /* ServerComponent for the replication to a standby server. Set during the
+     * lifetime of the component. */
+    struct UA_ReplicationManager *replication;
 };
 
 /***********************/
@@ -278,6 +596,13 @@ UA_StatusCode
 sendServiceFault(UA_Server *server, UA_SecureChannel *channel, UA_UInt32 requestId,
                  UA_UInt32 requestHandle, UA_StatusCode statusCode);
 
+/* Decode the RequestHeader at the offset to send a ServiceFault */
+UA_StatusCode
+decodeHeaderSendServiceFault(UA_Server *server, UA_SecureChannel *channel,
+                             const UA_ByteString *msg, size_t msgSegments,
+                             size_t offset, const UA_DataType *responseType,
+                             UA_UInt32 requestId, UA_StatusCode error);
+
 /* Gets the a pointer to the context of a security policy supported by the
  * server matched by the security policy uri. */
 UA_SecurityPolicy *
@@ -312,8 +637,14 @@ UA_StatusCode
 UA_Server_removeSessionByToken(UA_Server *server, const UA_NodeId *token,
                                UA_ShutdownReason shutdownReason);
 
-void
-UA_Server_cleanupSessions(UA_Server *server, UA_DateTime nowMonotonic);
+/* Adds a Session with the SessionId and AuthenticationToken of a replicated
+ * Session (see ua_server_replication.c). The Session is not attached to a
+ * SecureChannel. */
+UA_StatusCode
+UA_Server_restoreSession(UA_Server *server, const UA_NodeId *sessionId,
+                         const UA_NodeId *token, UA_Double timeout,
+                         UA_Session **session);
+
 
 UA_Session *
 getSessionByToken(UA_Server *server, const UA_NodeId *token);
@@ -340,14 +671,50 @@ UA_Server_editNode(UA_Server *server, UA_Session *session, const UA_NodeId *node
 /* Utility Functions */
 /*********************/
 
+typedef enum {
+    UA_ROLEPERMISSION_BROWSE,
+    UA_ROLEPERMISSION_READ,
+    UA_ROLEPERMISSION_WRITE,
+    UA_ROLEPERMISSION_CALL
+} UA_RolePermission;
+
+/* Check the roles of the session against the role masks of the node. The
+ * local admin session has all rights. A session can be NULL (e.g. for a
+ * detached Subscription) and then has no roles. */
+static UA_INLINE UA_Boolean
+checkRolePermission(UA_Server *server, const UA_Session *session,
+                    const UA_NodeHead *head, UA_RolePermission permission) {
+    const UA_NodeRoleMasks *rm = head->roleMasks;
+    if(!rm || session == &server->adminSession)
+        return true;
+    UA_UInt64 roles = (session) ? session->roles : 0;
+    switch(permission) {
+    case UA_ROLEPERMISSION_BROWSE: return (roles & rm->browse) != 0;
+    case UA_ROLEPERMISSION_READ: return (roles & rm->read) != 0;
+    case UA_ROLEPERMISSION_WRITE: return (roles & rm->write) != 0;
+    default: return (roles & rm->call) != 0;
+    }
+}
+
 void setServerLifecycleState(UA_Server *server, UA_LifecycleState state);
 
 void setupNs1Uri(UA_Server *server);
 UA_UInt16 addNamespace(UA_Server *server, const UA_String name);
 
+/* Pin the calling thread according to the placement. The role is used for the
+ * log output. Failures are logged but not returned. */
+void
+applyThreadPlacement(UA_Server *server, const UA_ThreadPlacement *tp,
+                     const char *role);
+
 UA_Boolean
 UA_Node_hasSubTypeOrInstances(const UA_NodeHead *head);
 
+/* Add the ReferenceTypeIndex of the node to the subtype sets of all
+ * ReferenceTypes upwards in the HasSubtype hierarchy */
+UA_StatusCode
+setReferenceTypeSubtypes(UA_Server *server, const UA_ReferenceTypeNode *node);
+
 /* Recursively searches "upwards" in the tree following specific reference types */
 UA_Boolean
 isNodeInTree(UA_Server *server, const UA_NodeId *leafNode,
@@ -392,6 +759,11 @@ UA_getConditionId(UA_Server *server, const UA_NodeId *conditionNodeId,
 void
 UA_ConditionList_delete(UA_Server *server);
 
+/* Evaluate the limit alarms that watch the node after its value was written */
+void
+UA_ConditionList_afterWrite(UA_Server *server, const UA_NodeId *nodeId,
+                            const UA_Variant *value);
+
 UA_Boolean
 isConditionOrBranch(UA_Server *server,
                     const UA_NodeId *condition,
@@ -432,6 +804,30 @@ UA_Server_processServiceOperations(UA_Server *server, UA_Session *session,
                                    const UA_DataType *responseOperationsType)
     UA_FUNC_ATTR_WARN_UNUSED_RESULT;
 
+/* Service operation that gets the node (or NULL if not found) resolved by the
+ * caller. The node is released by the caller. */
+typedef void (*UA_ServiceOperationWithNode)(UA_Server *server, UA_Session *session,
+                                            const void *context,
+                                            const void *requestOperation,
+                                            const UA_Node *node,
+                                            void *responseOperation);
+
+/* Same as UA_Server_processServiceOperations. But if the Nodestore implements
+ * getNodes, the nodes of the operations are resolved in batches. The NodeId is
+ * located at nodeIdOffset in the request operation. Otherwise
+ * operationCallback is used for the individual operations. */
+UA_StatusCode
+UA_Server_processServiceOperationsWithNodes(UA_Server *server, UA_Session *session,
+                                            UA_ServiceOperation operationCallback,
+                                            UA_ServiceOperationWithNode nodeCallback,
+                                            const void *context,
+                                            const size_t *requestOperations,
+                                            const UA_DataType *requestOperationsType,
+                                            size_t nodeIdOffset,
+                                            size_t *responseOperations,
+                                            const UA_DataType *responseOperationsType)
+    UA_FUNC_ATTR_WARN_UNUSED_RESULT;
+
 /******************************************/
 /* Internal function calls, without locks */
 /******************************************/
@@ -475,6 +871,12 @@ void
 Operation_Write(UA_Server *server, UA_Session *session, void *context,
                 const UA_WriteValue *wv, UA_StatusCode *result);
 
+#ifdef UA_ENABLE_METHODCALLS
+void
+Operation_CallMethod(UA_Server *server, UA_Session *session, void *context,
+                     const UA_CallMethodRequest *request, UA_CallMethodResult *result);
+#endif
+
 UA_StatusCode
 writeAttribute(UA_Server *server, UA_Session *session,
                const UA_NodeId *nodeId, const UA_AttributeId attributeId,
@@ -516,6 +918,60 @@ readWithSession(UA_Server *server, UA_Session *session,
                 const UA_ReadValueId *item,
                 UA_TimestampsToReturn timestampsToReturn);
 
+/* Read the same ReadValueId for several Sessions with a single lookup of the
+ * node. If the value is stored in the node (no callback), it is read only once
+ * and copied for every Session with read access. Otherwise every Session reads
+ * on its own. A NULL Session results in BadUserAccessDenied. */
+void
+readShared(UA_Server *server, const UA_ReadValueId *rvi,
+           UA_TimestampsToReturn timestampsToReturn, size_t sessionsSize,
+           UA_Session **sessions, UA_DataValue *results);
+
+/* Value reads of DataSources with a batch read callback. The reads are
+ * collected and then forwarded in one callback per device. */
+typedef struct {
+    const UA_Node *node; /* Kept until the batch is read */
+    UA_Session *session;
+    UA_TimestampsToReturn timestampsToReturn;
+    UA_NumericRange range; /* No dimensions if the entire value is read */
+    UA_DataValue *value;
+} UA_DataSourceBatchOp;
+
+typedef struct {
+    size_t opsSize;
+    size_t opsCapacity;
+    UA_DataSourceBatchOp *ops;
+} UA_DataSourceBatch;
+
+/* Defer the read of the value to the batch if the node has a DataSource with a
+ * batch read callback. Then the batch takes over the node (and releases it
+ * when the batch is read) and the result is written to the DataValue by
+ * readDataSourceBatch. Returns false if the read is not deferred. */
+UA_Boolean
+deferDataSourceRead(UA_Server *server, UA_DataSourceBatch *batch,
+                    UA_Session *session, const UA_Node *node,
+                    const UA_ReadValueId *rvi,
+                    UA_TimestampsToReturn timestampsToReturn, UA_DataValue *v);
+
+/* Read the deferred values and clean up the batch */
+void
+readDataSourceBatch(UA_Server *server, UA_DataSourceBatch *batch);
+
+#if UA_MULTITHREADING >= 200 && defined(UA_ARCHITECTURE_POSIX)
+typedef struct {
+    UA_Session *session; /* NULL -> BadUserAccessDenied */
+    const UA_ReadValueId *rvi;
+    UA_TimestampsToReturn timestampsToReturn;
+} UA_ReadOperation;
+
+/* Read in parallel worker threads (see config.parallelReadThreads) while the
+ * service lock is held. The results array must be initialized. Operations
+ * with a value callback are read afterwards by the calling thread. */
+UA_StatusCode
+readParallel(UA_Server *server, size_t opsSize, const UA_ReadOperation *ops,
+             UA_DataValue *results);
+#endif
+
 UA_StatusCode
 readWithReadValue(UA_Server *server, const UA_NodeId *nodeId,
                   const UA_AttributeId attributeId, void *v);
@@ -544,12 +1000,25 @@ triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
              const UA_NodeId origin, UA_ByteString *outEventId,
              const UA_Boolean deleteEventNode);
 
-/* Filters the given event with the given filter and writes the results into a
- * notification */
+UA_StatusCode
+triggerEventFields(UA_Server *server, const UA_NodeId eventType,
+                   const UA_NodeId origin, const UA_KeyValueMap *fields,
+                   UA_ByteString *outEventId);
+
+/* Filters the given event with the given filter and writes the selected fields
+ * into the EventFieldList. The cache is optional and kept between the events of
+ * a MonitoredItem. */
 UA_StatusCode
 filterEvent(UA_Server *server, UA_Session *session,
             const UA_NodeId *eventNode, UA_EventFilter *filter,
-            UA_EventFieldList *efl, UA_EventFilterResult *result);
+            UA_EventFilterCache *cache, UA_EventFieldList *efl);
+
+/* Same as filterEvent for an event that is not represented as a node. The
+ * fields are keyed by their BrowsePath. See UA_Server_triggerEventFields. */
+UA_StatusCode
+filterEventFields(UA_Server *server, UA_Session *session,
+                  const UA_KeyValueMap *eventFields, UA_EventFilter *filter,
+                  UA_EventFilterCache *cache, UA_EventFieldList *efl);
 
 #endif /* UA_ENABLE_SUBSCRIPTIONS_EVENTS */
 
@@ -601,9 +1070,35 @@ UA_ServerComponent * UA_DiscoveryManager_new(void);
 
 UA_ServerComponent * UA_BinaryProtocolManager_new(UA_Server *server);
 
+/* Replication of the Session and Subscription state to a standby server (see
+ * UA_Server_setReplicationCallback). The hooks return right away if no
+ * replication callback is set. */
+UA_ServerComponent * UA_ReplicationManager_new(UA_Server *server);
+
+void replicateSession(UA_Server *server, const UA_Session *session);
+void replicateSessionRemoved(UA_Server *server, const UA_Session *session);
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+void replicateSubscription(UA_Server *server, const UA_Subscription *sub);
+void replicateSubscriptionRemoved(UA_Server *server, const UA_Subscription *sub);
+void replicateSequenceNumber(UA_Server *server, const UA_Subscription *sub);
+void replicateMonitoredItem(UA_Server *server, const UA_MonitoredItem *mon);
+void replicateMonitoredItemRemoved(UA_Server *server, const UA_MonitoredItem *mon);
+#endif
+
 
 #ifdef UA_ENABLE_PUBSUB
 UA_ServerComponent * UA_PubSubManager_new(UA_Server *server);
+
+void
+UA_PubSubManager_getStatistics(UA_Server *server, UA_PubSubStatistics *stats);
+
+#ifdef UA_ENABLE_PUBSUB_INFORMATIONMODEL
+/* With the lazy PubSub information model, create the representation of the
+ * PubSub components below the node before it is browsed */
+void
+UA_PubSubManager_materialize(UA_Server *server, const UA_NodeId *nodeId);
+#endif
 #endif
 
 /***********/
@@ -654,6 +1149,33 @@ RefTree_contains(RefTree *rt, const UA_ExpandedNodeId *target);
 UA_Boolean
 RefTree_containsNodeId(RefTree *rt, const UA_NodeId *target);
 
+/* Number of targets in a ReferenceKind above which the array is switched to
+ * the tree representation */
+#define UA_NODE_REFTREE_THRESHOLD 16
+
+/* Access to the compact representation of a ReferenceKind (rk->isCompact). The
+ * targets passed to the callback are temporaries with an immediate
+ * NodePointer. */
+
+/* Iterate in the order of the numeric identifiers, starting at the position */
+void *
+UA_NodeReferenceKind_iterateCompact(const UA_NodeReferenceKind *rk, size_t pos,
+                                    UA_NodeReferenceKind_iterateCallback callback,
+                                    void *context);
+
+/* Iterate over the targets with the BrowseName hash */
+void *
+UA_NodeReferenceKind_iterateCompactName(const UA_NodeReferenceKind *rk,
+                                        UA_UInt32 nameHash,
+                                        UA_NodeReferenceKind_iterateCallback callback,
+                                        void *context);
+
+/* Position of the first target after the NodeId. Returns targetsSize if the
+ * NodeId cannot be part of the compact representation. */
+size_t
+UA_NodeReferenceKind_compactUpperBound(const UA_NodeReferenceKind *rk,
+                                       const UA_NodeId *id);
+
 /***************************************/
 /* Check Information Model Consistency */
 /***************************************/
@@ -670,6 +1192,11 @@ UA_StatusCode
 readValueAttribute(UA_Server *server, UA_Session *session,
                    const UA_VariableNode *vn, UA_DataValue *v);
 
+/* Release the nodes pinned for the Read response of the SecureChannel. The
+ * retired values are freed once no more nodes are pinned. */
+void
+releasePinnedNodes(UA_Server *server, UA_SecureChannel *channel);
+
 /* Test whether the value matches a variable definition given by
  * - datatype
  * - valuerank
@@ -785,6 +1312,15 @@ UA_StatusCode initNS0(UA_Server *server);
 #ifdef UA_ENABLE_DIAGNOSTICS
 void createSessionObject(UA_Server *server, UA_Session *session);
 
+UA_StatusCode createServiceStatisticsObject(UA_Server *server);
+
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+UA_StatusCode createMemoryStatisticsObject(UA_Server *server);
+#endif
+
+void
+UA_ServiceStats_get(const UA_ServiceStats *ss, UA_ServiceStatistics *stats);
+
 void createSubscriptionObject(UA_Server *server, UA_Session *session,
                               UA_Subscription *sub);
 
@@ -836,6 +1372,8 @@ UA_NODESTORE_GET(UA_Server *server, const UA_NodeId *nodeId) {
 /* Get the editable node with all attributes and references */
 static UA_INLINE UA_Node *
 UA_NODESTORE_GET_EDIT(UA_Server *server, const UA_NodeId *nodeId) {
+    UA_LOCK_ASSERT_EXCLUSIVE(&server->serviceMutex);
+    server->nodestoreChanges++;
     return server->config.nodestore.
         getEditNode(server->config.nodestore.context, nodeId,
                     UA_NODEATTRIBUTESMASK_ALL, UA_REFERENCETYPESET_ALL,
@@ -854,9 +1392,16 @@ UA_NODESTORE_GETFROMREF(UA_Server *server, UA_NodePointer target) {
     server->config.nodestore.getNode(server->config.nodestore.context,      \
                                      nodeid, attrMask, refs, refDirs)
 
-#define UA_NODESTORE_GET_EDIT_SELECTIVE(server, nodeid, attrMask, refs, refDirs) \
-    server->config.nodestore.getEditNode(server->config.nodestore.context,       \
-                                         nodeid, attrMask, refs, refDirs)
+static UA_INLINE UA_Node *
+UA_NODESTORE_GET_EDIT_SELECTIVE(UA_Server *server, const UA_NodeId *nodeId,
+                                UA_UInt32 attrMask, UA_ReferenceTypeSet refs,
+                                UA_BrowseDirection refDirs) {
+    UA_LOCK_ASSERT_EXCLUSIVE(&server->serviceMutex);
+    server->nodestoreChanges++;
+    return server->config.nodestore.
+        getEditNode(server->config.nodestore.context, nodeId,
+                    attrMask, refs, refDirs);
+}
 
 #define UA_NODESTORE_GETFROMREF_SELECTIVE(server, target, attrMask, refs, refDirs) \
     server->config.nodestore.getNodeFromPtr(server->config.nodestore.context,      \
@@ -865,19 +1410,35 @@ UA_NODESTORE_GETFROMREF(UA_Server *server, UA_NodePointer target) {
 #define UA_NODESTORE_RELEASE(server, node)                              \
     server->config.nodestore.releaseNode(server->config.nodestore.context, node)
 
+/* Release a node from UA_NODESTORE_GET_EDIT. Returns a non-good status if the
+ * changes could not be published. */
+static UA_INLINE UA_StatusCode
+UA_NODESTORE_RELEASE_EDIT(UA_Server *server, UA_Node *node) {
+    UA_Nodestore *ns = &server->config.nodestore;
+    if(!node)
+        return UA_STATUSCODE_GOOD;
+    if(ns->releaseEditNode)
+        return ns->releaseEditNode(ns->context, node);
+    ns->releaseNode(ns->context, node);
+    return UA_STATUSCODE_GOOD;
+}
+
 #define UA_NODESTORE_GETCOPY(server, nodeid, outnode)                      \
     server->config.nodestore.getNodeCopy(server->config.nodestore.context, \
                                          nodeid, outnode)
 
-#define UA_NODESTORE_INSERT(server, node, addedNodeId)                    \
-    server->config.nodestore.insertNode(server->config.nodestore.context, \
-                                        node, addedNodeId)
+#define UA_NODESTORE_INSERT(server, node, addedNodeId)                     \
+    (server->nodestoreChanges++, server->hierarchyEpoch++,                 \
+     server->config.nodestore.insertNode(server->config.nodestore.context, \
+                                         node, addedNodeId))
 
 #define UA_NODESTORE_REPLACE(server, node)                              \
-    server->config.nodestore.replaceNode(server->config.nodestore.context, node)
+    (server->nodestoreChanges++,                                        \
+     server->config.nodestore.replaceNode(server->config.nodestore.context, node))
 
 #define UA_NODESTORE_REMOVE(server, nodeId)                             \
-    server->config.nodestore.removeNode(server->config.nodestore.context, nodeId)
+    (server->nodestoreChanges++, server->hierarchyEpoch++,              \
+     server->config.nodestore.removeNode(server->config.nodestore.context, nodeId))
 
 #define UA_NODESTORE_GETREFERENCETYPEID(server, index)                  \
     server->config.nodestore.getReferenceTypeId(server->config.nodestore.context, \
@@ -908,22 +908,34 @@ UA_StatusCode
 initNS0(UA_Server *server) {
     UA_LOCK_ASSERT(&server->serviceMutex);
 
-    /* Initialize base nodes which are always required an cannot be created
-     * through the NS compiler */
-    server->bootstrapNS0 = true;
-    UA_StatusCode retVal = createNS0_base(server);
+    /* The Nodestore can already contain namespace 0 (e.g. served from an
+     * address space snapshot). Then only the data sources, callbacks and
+     * server-specific values below are set up. */
+    UA_StatusCode retVal = UA_STATUSCODE_GOOD;
+    UA_NodeId serverId = UA_NS0ID(SERVER);
+    const UA_Node *serverNode =
+        UA_NODESTORE_GET_SELECTIVE(server, &serverId, 0, UA_REFERENCETYPESET_NONE,
+                                   UA_BROWSEDIRECTION_INVALID);
+    if(serverNode) {
+        UA_NODESTORE_RELEASE(server, serverNode);
+    } else {
+        /* Initialize base nodes which are always required an cannot be
+         * created through the NS compiler */
+        server->bootstrapNS0 = true;
+        retVal = createNS0_base(server);
 
 #ifdef UA_GENERATED_NAMESPACE_ZERO
-    UA_UNLOCK(&server->serviceMutex);
-    /* Load nodes and references generated from the XML ns0 definition */
-    retVal |= namespace0_generated(server);
-    UA_LOCK(&server->serviceMutex);
+        UA_UNLOCK(&server->serviceMutex);
+        /* Load nodes and references generated from the XML ns0 definition */
+        retVal |= namespace0_generated(server);
+        UA_LOCK(&server->serviceMutex);
 #else
-    /* Create a minimal server object */
-    retVal |= minimalServerObject(server);
+        /* Create a minimal server object */
+        retVal |= minimalServerObject(server);
 #endif
 
-    server->bootstrapNS0 = false;
+        server->bootstrapNS0 = false;
+    }
 
     if(retVal != UA_STATUSCODE_GOOD) {
         UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_SERVER,
@@ -1193,6 +1205,14 @@ initNS0(UA_Server *server) {
     UA_DataSource sessionSecDiagSummary = {readSessionSecurityDiagnostics, NULL};
     retVal |= setVariableNode_dataSource(server, UA_NS0ID(SERVER_SERVERDIAGNOSTICS_SESSIONSDIAGNOSTICSSUMMARY_SESSIONSECURITYDIAGNOSTICSARRAY), sessionSecDiagSummary);
 
+    /* ServerDiagnostics - ServiceStatistics (vendor-specific) */
+    retVal |= createServiceStatisticsObject(server);
+
+    /* ServerDiagnostics - MemoryStatistics (vendor-specific) */
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+    retVal |= createMemoryStatisticsObject(server);
+#endif
+
 #else
     /* Removing these NodeIds make Server Object to be non-complaint with UA
      * 1.03 in CTT (Base Inforamtion/Base Info Core Structure/ 001.js) In the
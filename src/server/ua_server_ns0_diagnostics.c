@@ -9,6 +9,7 @@
 #include "ua_session.h"
 #include "ua_subscription.h"
 #include "itoa.h"
+#include "mp_printf.h"
 
 #ifdef UA_ENABLE_DIAGNOSTICS
 
@@ -273,6 +274,19 @@ setSessionSubscriptionDiagnostics(UA_Server *server, UA_Session *session,
 static void
 setSessionDiagnostics(UA_Session *session, UA_SessionDiagnosticsDataType *sd) {
     UA_SessionDiagnosticsDataType_copy(&session->diagnostics, sd);
+
+    /* Fold in the request counters */
+    const UA_ServiceCounterDataType *counters = session->serviceCounters;
+    if(counters) {
+        sd->totalRequestCount = counters[serviceDescriptionsSize];
+        for(size_t i = 0; i < serviceDescriptionsSize; i++) {
+            if(serviceDescriptions[i].counterOffset == 0)
+                continue;
+            UA_ServiceCounterDataType *serviceCounter = (UA_ServiceCounterDataType*)
+                ((uintptr_t)sd + serviceDescriptions[i].counterOffset);
+            *serviceCounter = counters[i];
+        }
+    }
     UA_NodeId_copy(&session->sessionId, &sd->sessionId);
     UA_String_copy(&session->sessionName, &sd->sessionName);
     UA_ApplicationDescription_copy(&session->clientDescription,
@@ -478,6 +492,282 @@ readSessionSecurityDiagnostics(UA_Server *server,
     return UA_STATUSCODE_GOOD;
 }
 
+/**********************/
+/* Service Statistics */
+/**********************/
+
+/* The statistics are encoded as an array of KeyValuePair. The keys are the
+ * member names of UA_ServiceStatistics. */
+#define UA_SERVICESTATISTICS_FIELDS 11
+
+static UA_StatusCode
+setKeyValue(UA_KeyValuePair *kv, const char *key, const void *data,
+            const UA_DataType *type) {
+    kv->key = UA_QUALIFIEDNAME_ALLOC(0, key);
+    return UA_Variant_setScalarCopy(&kv->value, data, type);
+}
+
+static UA_StatusCode
+writeServiceStatistics(const UA_ServiceStats *ss, UA_DataValue *value) {
+    UA_ServiceStatistics stats;
+    UA_ServiceStats_get(ss, &stats);
+    UA_UInt64 queueDepth = stats.queueDepthHighWaterMark;
+
+    UA_KeyValuePair *kv = (UA_KeyValuePair*)
+        UA_Array_new(UA_SERVICESTATISTICS_FIELDS, &UA_TYPES[UA_TYPES_KEYVALUEPAIR]);
+    if(!kv)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    const UA_DataType *u64 = &UA_TYPES[UA_TYPES_UINT64];
+    const UA_DataType *dur = &UA_TYPES[UA_TYPES_DURATION];
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    res |= setKeyValue(&kv[0], "RequestCount", &stats.requestCount, u64);
+    res |= setKeyValue(&kv[1], "ErrorCount", &stats.errorCount, u64);
+    res |= setKeyValue(&kv[2], "OperationCount", &stats.operationCount, u64);
+    res |= setKeyValue(&kv[3], "AsyncCount", &stats.asyncCount, u64);
+    res |= setKeyValue(&kv[4], "QueueDepthHighWaterMark", &queueDepth, u64);
+    res |= setKeyValue(&kv[5], "LatencyMean", &stats.latencyMean, dur);
+    res |= setKeyValue(&kv[6], "LatencyP50", &stats.latencyP50, dur);
+    res |= setKeyValue(&kv[7], "LatencyP90", &stats.latencyP90, dur);
+    res |= setKeyValue(&kv[8], "LatencyP99", &stats.latencyP99, dur);
+    res |= setKeyValue(&kv[9], "LatencyP999", &stats.latencyP999, dur);
+    res |= setKeyValue(&kv[10], "LatencyMax", &stats.latencyMax, dur);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_Array_delete(kv, UA_SERVICESTATISTICS_FIELDS,
+                        &UA_TYPES[UA_TYPES_KEYVALUEPAIR]);
+        return res;
+    }
+
+    UA_Variant_setArray(&value->value, kv, UA_SERVICESTATISTICS_FIELDS,
+                        &UA_TYPES[UA_TYPES_KEYVALUEPAIR]);
+    value->hasValue = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* The node context points to the UA_ServiceStats in the server */
+static UA_StatusCode
+readServiceStatistics(UA_Server *server, const UA_NodeId *sessionId,
+                      void *sessionContext, const UA_NodeId *nodeId,
+                      void *nodeContext, UA_Boolean sourceTimestamp,
+                      const UA_NumericRange *range, UA_DataValue *value) {
+    if(range) {
+        value->hasStatus = true;
+        value->status = UA_STATUSCODE_BADINDEXRANGEINVALID;
+        return UA_STATUSCODE_GOOD;
+    }
+    UA_LOCK(&server->serviceMutex);
+    UA_StatusCode res = writeServiceStatistics((UA_ServiceStats*)nodeContext, value);
+    UA_UNLOCK(&server->serviceMutex);
+    return res;
+}
+
+/* The node context points to the session. The variable is removed together
+ * with the session object. But check that the session is still alive. */
+static UA_StatusCode
+readSessionServiceStatistics(UA_Server *server, const UA_NodeId *sessionId,
+                             void *sessionContext, const UA_NodeId *nodeId,
+                             void *nodeContext, UA_Boolean sourceTimestamp,
+                             const UA_NumericRange *range, UA_DataValue *value) {
+    if(range) {
+        value->hasStatus = true;
+        value->status = UA_STATUSCODE_BADINDEXRANGEINVALID;
+        return UA_STATUSCODE_GOOD;
+    }
+    UA_LOCK(&server->serviceMutex);
+    UA_StatusCode res = UA_STATUSCODE_BADINTERNALERROR;
+    session_list_entry *sentry;
+    LIST_FOREACH(sentry, &server->sessions, pointers) {
+        if(&sentry->session != nodeContext)
+            continue;
+        res = writeServiceStatistics(&sentry->session.serviceStats, value);
+        break;
+    }
+    UA_UNLOCK(&server->serviceMutex);
+    return res;
+}
+
+/* The nodes of a server-wide address space snapshot can already exist. Then
+ * only the DataSource and the context are attached again. */
+static UA_Boolean
+nodeExists(UA_Server *server, const UA_NodeId *nodeId) {
+    const UA_Node *node =
+        UA_NODESTORE_GET_SELECTIVE(server, nodeId, UA_NODEATTRIBUTESMASK_NONE,
+                                   UA_REFERENCETYPESET_NONE,
+                                   UA_BROWSEDIRECTION_INVALID);
+    if(!node)
+        return false;
+    UA_NODESTORE_RELEASE(server, node);
+    return true;
+}
+
+/* Variable with an array of KeyValuePair */
+static UA_StatusCode
+addStatisticsVariable(UA_Server *server, const UA_NodeId nodeId,
+                      const UA_NodeId parentId, const char *name,
+                      UA_UInt32 fields, const UA_DataSource ds, void *context) {
+    if(!UA_NodeId_isNull(&nodeId) && nodeExists(server, &nodeId)) {
+        UA_StatusCode res = setNodeContext(server, nodeId, context);
+        return res | setVariableNode_dataSource(server, nodeId, ds);
+    }
+
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT("", (char*)(uintptr_t)name);
+    attr.dataType = UA_TYPES[UA_TYPES_KEYVALUEPAIR].typeId;
+    attr.valueRank = UA_VALUERANK_ONE_DIMENSION;
+    attr.arrayDimensions = &fields;
+    attr.arrayDimensionsSize = 1;
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ;
+    UA_NodeId newId;
+    UA_StatusCode res =
+        addNode(server, UA_NODECLASS_VARIABLE, nodeId, parentId,
+                UA_NS0ID(HASCOMPONENT), UA_QUALIFIEDNAME(1, (char*)(uintptr_t)name),
+                UA_NS0ID(BASEDATAVARIABLETYPE), &attr,
+                &UA_TYPES[UA_TYPES_VARIABLEATTRIBUTES], context, &newId);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    res = setVariableNode_dataSource(server, newId, ds);
+    UA_NodeId_clear(&newId);
+    return res;
+}
+
+UA_StatusCode
+createServiceStatisticsObject(UA_Server *server) {
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    UA_NodeId objectId = UA_NODEID_STRING(1, "ServiceStatistics");
+    if(!nodeExists(server, &objectId)) {
+        UA_ObjectAttributes oattr = UA_ObjectAttributes_default;
+        oattr.displayName = UA_LOCALIZEDTEXT("", "ServiceStatistics");
+        oattr.description = UA_LOCALIZEDTEXT("", "Request counters and latencies "
+                                             "per service (vendor-specific)");
+        res = addNode(server, UA_NODECLASS_OBJECT, objectId,
+                      UA_NS0ID(SERVER_SERVERDIAGNOSTICS), UA_NS0ID(HASCOMPONENT),
+                      UA_QUALIFIEDNAME(1, "ServiceStatistics"), UA_NS0ID(FOLDERTYPE),
+                      &oattr, &UA_TYPES[UA_TYPES_OBJECTATTRIBUTES], NULL, NULL);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+
+    /* One variable per service. The name is the request type without the
+     * "Request" suffix. */
+    UA_DataSource ds = {readServiceStatistics, NULL};
+    char name[64];
+    char idName[96];
+    for(size_t i = 0; i < serviceDescriptionsSize; i++) {
+        const UA_DataType *rt = serviceDescriptions[i].requestType;
+#ifdef UA_ENABLE_TYPEDESCRIPTION
+        size_t len = strlen(rt->typeName);
+        if(len > 7 && strcmp(&rt->typeName[len - 7], "Request") == 0)
+            len -= 7;
+        if(len >= sizeof(name))
+            len = sizeof(name) - 1;
+        memcpy(name, rt->typeName, len);
+        name[len] = 0;
+#else
+        mp_snprintf(name, sizeof(name), "Service%u",
+                    (unsigned)rt->binaryEncodingId.identifier.numeric);
+#endif
+        mp_snprintf(idName, sizeof(idName), "ServiceStatistics.%s", name);
+        res |= addStatisticsVariable(server, UA_NODEID_STRING(1, idName),
+                                     objectId, name, UA_SERVICESTATISTICS_FIELDS,
+                                     ds, &server->serviceStats[i]);
+    }
+    return res;
+}
+
+/*********************/
+/* Memory Statistics */
+/*********************/
+
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+
+/* The members of UA_MemoryStatistics */
+#define UA_MEMORYSTATISTICS_FIELDS 5
+
+/* The node context is the memory category */
+static UA_StatusCode
+readMemoryStatistics(UA_Server *server, const UA_NodeId *sessionId,
+                     void *sessionContext, const UA_NodeId *nodeId,
+                     void *nodeContext, UA_Boolean sourceTimestamp,
+                     const UA_NumericRange *range, UA_DataValue *value) {
+    if(range) {
+        value->hasStatus = true;
+        value->status = UA_STATUSCODE_BADINDEXRANGEINVALID;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    /* No allocator plugin with statistics */
+    UA_MemoryStatistics ms;
+    UA_Allocator *a = UA_Allocator_get();
+    if(!a || !a->getStatistics ||
+       a->getStatistics(a, (UA_MemoryCategory)(uintptr_t)nodeContext,
+                        &ms) != UA_STATUSCODE_GOOD) {
+        value->hasStatus = true;
+        value->status = UA_STATUSCODE_BADNOTSUPPORTED;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    UA_KeyValuePair *kv = (UA_KeyValuePair*)
+        UA_Array_new(UA_MEMORYSTATISTICS_FIELDS, &UA_TYPES[UA_TYPES_KEYVALUEPAIR]);
+    if(!kv)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    const UA_DataType *u64 = &UA_TYPES[UA_TYPES_UINT64];
+    UA_UInt64 bytesInUse = ms.bytesInUse;
+    UA_UInt64 blocksInUse = ms.blocksInUse;
+    UA_UInt64 bytesReserved = ms.bytesReserved;
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    res |= setKeyValue(&kv[0], "BytesInUse", &bytesInUse, u64);
+    res |= setKeyValue(&kv[1], "BlocksInUse", &blocksInUse, u64);
+    res |= setKeyValue(&kv[2], "BytesReserved", &bytesReserved, u64);
+    res |= setKeyValue(&kv[3], "Allocations", &ms.allocations, u64);
+    res |= setKeyValue(&kv[4], "Frees", &ms.frees, u64);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_Array_delete(kv, UA_MEMORYSTATISTICS_FIELDS,
+                        &UA_TYPES[UA_TYPES_KEYVALUEPAIR]);
+        return res;
+    }
+
+    UA_Variant_setArray(&value->value, kv, UA_MEMORYSTATISTICS_FIELDS,
+                        &UA_TYPES[UA_TYPES_KEYVALUEPAIR]);
+    value->hasValue = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+static const char *memoryCategoryNodeNames[UA_MEMORYCATEGORIES] =
+    {"Default", "Nodestore", "Subscriptions", "SecureChannel", "PubSub", "Encoding",
+     "Sessions", "MonitoredItems"};
+
+UA_StatusCode
+createMemoryStatisticsObject(UA_Server *server) {
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    UA_NodeId objectId = UA_NODEID_STRING(1, "MemoryStatistics");
+    if(!nodeExists(server, &objectId)) {
+        UA_ObjectAttributes oattr = UA_ObjectAttributes_default;
+        oattr.displayName = UA_LOCALIZEDTEXT("", "MemoryStatistics");
+        oattr.description = UA_LOCALIZEDTEXT("", "Memory usage per category of "
+                                             "the allocator plugin (vendor-specific)");
+        res = addNode(server, UA_NODECLASS_OBJECT, objectId,
+                      UA_NS0ID(SERVER_SERVERDIAGNOSTICS), UA_NS0ID(HASCOMPONENT),
+                      UA_QUALIFIEDNAME(1, "MemoryStatistics"), UA_NS0ID(FOLDERTYPE),
+                      &oattr, &UA_TYPES[UA_TYPES_OBJECTATTRIBUTES], NULL, NULL);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+
+    UA_DataSource ds = {readMemoryStatistics, NULL};
+    char idName[64];
+    for(size_t i = 0; i < UA_MEMORYCATEGORIES; i++) {
+        const char *name = memoryCategoryNodeNames[i];
+        mp_snprintf(idName, sizeof(idName), "MemoryStatistics.%s", name);
+        res |= addStatisticsVariable(server, UA_NODEID_STRING(1, idName),
+                                     objectId, name, UA_MEMORYSTATISTICS_FIELDS,
+                                     ds, (void*)i);
+    }
+    return res;
+}
+
+#endif /* UA_ENABLE_MALLOC_SINGLETON */
+
 void
 createSessionObject(UA_Server *server, UA_Session *session) {
     UA_ExpandedNodeId *children = NULL;
@@ -515,6 +805,13 @@ createSessionObject(UA_Server *server, UA_Session *session) {
         setVariableNode_dataSource(server, children[i].nodeId, sessionDiagSource);
     }
 
+    /* Add the vendor-specific service statistics of the session */
+    UA_DataSource statisticsSource = {readSessionServiceStatistics, NULL};
+    res = addStatisticsVariable(server, UA_NODEID_NUMERIC(1, 0),
+                                session->sessionId, "ServiceStatistics",
+                                UA_SERVICESTATISTICS_FIELDS,
+                                statisticsSource, session);
+
  cleanup:
     if(res != UA_STATUSCODE_GOOD) {
         UA_LOG_WARNING_SESSION(server->config.logging, session,
@@ -0,0 +1,928 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "ua_server_internal.h"
+#include "../ua_types_encoding_binary.h"
+
+/* The state of the Sessions, Subscriptions and MonitoredItems is replicated as
+ * a sequence of records. Every record starts with a Byte tag, followed by the
+ * binary encoded fields:
+ *
+ * - RESET: Drop the shadow state (the start of a full state)
+ * - SESSION: NodeId sessionId, NodeId authenticationToken, String sessionName,
+ *   ByteString serverNonce, Double timeout, ApplicationDescription client,
+ *   String clientUserId, UInt64 roles, UInt32 localeIdsSize, String[]
+ * - SESSIONREMOVED: NodeId sessionId
+ * - SUBSCRIPTION: UInt32 subscriptionId, NodeId sessionId (null if detached),
+ *   Double publishingInterval, UInt32 lifeTimeCount, UInt32 maxKeepAliveCount,
+ *   UInt32 notificationsPerPublish, Byte priority, Boolean publishingEnabled,
+ *   UInt32 nextSequenceNumber
+ * - SUBSCRIPTIONREMOVED: UInt32 subscriptionId
+ * - SEQUENCENUMBER: UInt32 subscriptionId, UInt32 nextSequenceNumber
+ * - MONITOREDITEM: UInt32 subscriptionId, UInt32 monitoredItemId,
+ *   UInt32 timestampsToReturn, MonitoredItemCreateRequest (with the revised
+ *   parameters)
+ * - MONITOREDITEMREMOVED: UInt32 subscriptionId, UInt32 monitoredItemId
+ *
+ * A record for an existing entity replaces it. The standby keeps the records
+ * in a shadow state and creates the entities only when it takes over. */
+
+#define UA_REPLICATION_INITIALSIZE 1024
+
+typedef enum {
+    UA_REPLICATIONRECORD_RESET = 0,
+    UA_REPLICATIONRECORD_SESSION,
+    UA_REPLICATIONRECORD_SESSIONREMOVED,
+    UA_REPLICATIONRECORD_SUBSCRIPTION,
+    UA_REPLICATIONRECORD_SUBSCRIPTIONREMOVED,
+    UA_REPLICATIONRECORD_SEQUENCENUMBER,
+    UA_REPLICATIONRECORD_MONITOREDITEM,
+    UA_REPLICATIONRECORD_MONITOREDITEMREMOVED
+} UA_ReplicationRecord;
+
+/****************/
+/* Shadow State */
+/****************/
+
+typedef struct ShadowSession {
+    ZIP_ENTRY(ShadowSession) treeEntry;
+    UA_NodeId sessionId;
+    UA_NodeId authenticationToken;
+    UA_String sessionName;
+    UA_ByteString serverNonce;
+    UA_Double timeout;
+    UA_ApplicationDescription clientDescription;
+    UA_String clientUserId;
+    UA_UInt64 roles;
+    size_t localeIdsSize;
+    UA_String *localeIds;
+} ShadowSession;
+
+typedef ZIP_HEAD(ShadowSessionTree, ShadowSession) ShadowSessionTree;
+ZIP_FUNCTIONS(ShadowSessionTree, ShadowSession, treeEntry,
+              UA_NodeId, sessionId, cmpSessionNodeId)
+
+static void
+ShadowSession_delete(ShadowSession *ss) {
+    UA_NodeId_clear(&ss->sessionId);
+    UA_NodeId_clear(&ss->authenticationToken);
+    UA_String_clear(&ss->sessionName);
+    UA_ByteString_clear(&ss->serverNonce);
+    UA_ApplicationDescription_clear(&ss->clientDescription);
+    UA_String_clear(&ss->clientUserId);
+    UA_Array_delete(ss->localeIds, ss->localeIdsSize, &UA_TYPES[UA_TYPES_STRING]);
+    UA_free(ss);
+}
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+
+static enum ZIP_CMP
+cmpShadowId(const UA_UInt32 *a, const UA_UInt32 *b) {
+    if(*a == *b)
+        return ZIP_CMP_EQ;
+    return (*a < *b) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+}
+
+typedef struct ShadowMonitoredItem {
+    ZIP_ENTRY(ShadowMonitoredItem) treeEntry;
+    UA_UInt32 monitoredItemId;
+    UA_TimestampsToReturn timestampsToReturn;
+    UA_MonitoredItemCreateRequest request;
+} ShadowMonitoredItem;
+
+typedef ZIP_HEAD(ShadowMonitoredItemTree, ShadowMonitoredItem)
+    ShadowMonitoredItemTree;
+ZIP_FUNCTIONS(ShadowMonitoredItemTree, ShadowMonitoredItem, treeEntry,
+              UA_UInt32, monitoredItemId, cmpShadowId)
+
+typedef struct ShadowSubscription {
+    ZIP_ENTRY(ShadowSubscription) treeEntry;
+    UA_UInt32 subscriptionId;
+    UA_NodeId sessionId;
+    UA_Double publishingInterval;
+    UA_UInt32 lifeTimeCount;
+    UA_UInt32 maxKeepAliveCount;
+    UA_UInt32 notificationsPerPublish;
+    UA_Byte priority;
+    UA_Boolean publishingEnabled;
+    UA_UInt32 nextSequenceNumber;
+    ShadowMonitoredItemTree monitoredItems;
+} ShadowSubscription;
+
+typedef ZIP_HEAD(ShadowSubscriptionTree, ShadowSubscription) ShadowSubscriptionTree;
+ZIP_FUNCTIONS(ShadowSubscriptionTree, ShadowSubscription, treeEntry,
+              UA_UInt32, subscriptionId, cmpShadowId)
+
+static void
+ShadowMonitoredItem_delete(ShadowMonitoredItem *smon) {
+    UA_MonitoredItemCreateRequest_clear(&smon->request);
+    UA_free(smon);
+}
+
+static void
+ShadowSubscription_delete(ShadowSubscription *ssub) {
+    ShadowMonitoredItem *smon;
+    while((smon = ZIP_MIN(ShadowMonitoredItemTree, &ssub->monitoredItems))) {
+        ZIP_REMOVE(ShadowMonitoredItemTree, &ssub->monitoredItems, smon);
+        ShadowMonitoredItem_delete(smon);
+    }
+    UA_NodeId_clear(&ssub->sessionId);
+    UA_free(ssub);
+}
+
+#endif /* UA_ENABLE_SUBSCRIPTIONS */
+
+/***********************/
+/* Replication Manager */
+/***********************/
+
+typedef struct {
+    UA_ByteString buf;
+    UA_Byte *pos;
+    const UA_Byte *end;
+    UA_StatusCode res;
+} ReplicationWriter;
+
+typedef struct UA_ReplicationManager {
+    UA_ServerComponent sc;
+
+    /* Primary: Records for the callback that are not yet delivered. They are
+     * flushed from a delayed callback, outside of the service mutex. */
+    UA_Server_ReplicationCallback callback;
+    void *callbackContext;
+    ReplicationWriter pending;
+    UA_DelayedCallback flushCallback;
+    UA_Boolean flushRegistered;
+
+    /* Standby: Shadow state from the applied records */
+    ShadowSessionTree sessions;
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    ShadowSubscriptionTree subscriptions;
+#endif
+} UA_ReplicationManager;
+
+static void
+clearShadowState(UA_ReplicationManager *rm) {
+    ShadowSession *ss;
+    while((ss = ZIP_MIN(ShadowSessionTree, &rm->sessions))) {
+        ZIP_REMOVE(ShadowSessionTree, &rm->sessions, ss);
+        ShadowSession_delete(ss);
+    }
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    ShadowSubscription *ssub;
+    while((ssub = ZIP_MIN(ShadowSubscriptionTree, &rm->subscriptions))) {
+        ZIP_REMOVE(ShadowSubscriptionTree, &rm->subscriptions, ssub);
+        ShadowSubscription_delete(ssub);
+    }
+#endif
+}
+
+/************/
+/* Encoding */
+/************/
+
+/* Grow the buffer when the end is reached. The encoding continues at the same
+ * offset in the reallocated buffer. */
+static UA_StatusCode
+growReplicationBuffer(void *handle, UA_Byte **bufPos, const UA_Byte **bufEnd) {
+    ReplicationWriter *w = (ReplicationWriter*)handle;
+    size_t used = (size_t)(*bufPos - w->buf.data);
+    size_t newLength = w->buf.length * 2;
+    UA_Byte *newData = (UA_Byte*)UA_realloc(w->buf.data, newLength);
+    if(!newData)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    w->buf.data = newData;
+    w->buf.length = newLength;
+    *bufPos = newData + used;
+    *bufEnd = newData + newLength;
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+initReplicationWriter(ReplicationWriter *w) {
+    memset(w, 0, sizeof(ReplicationWriter));
+    w->buf.data = (UA_Byte*)UA_malloc(UA_REPLICATION_INITIALSIZE);
+    if(!w->buf.data) {
+        w->res = UA_STATUSCODE_BADOUTOFMEMORY;
+        return;
+    }
+    w->buf.length = UA_REPLICATION_INITIALSIZE;
+    w->pos = w->buf.data;
+    w->end = w->buf.data + w->buf.length;
+}
+
+static void
+writeValue(ReplicationWriter *w, const void *p, const UA_DataType *type) {
+    if(w->res != UA_STATUSCODE_GOOD)
+        return;
+    w->res = UA_encodeBinaryInternal(p, type, &w->pos, &w->end,
+                                     growReplicationBuffer, w);
+}
+
+static void
+writeUInt32(ReplicationWriter *w, UA_UInt32 v) {
+    writeValue(w, &v, &UA_TYPES[UA_TYPES_UINT32]);
+}
+
+static void
+writeTag(ReplicationWriter *w, UA_ReplicationRecord tag) {
+    UA_Byte b = (UA_Byte)tag;
+    writeValue(w, &b, &UA_TYPES[UA_TYPES_BYTE]);
+}
+
+static void
+encodeSession(ReplicationWriter *w, const UA_Session *session) {
+    writeTag(w, UA_REPLICATIONRECORD_SESSION);
+    writeValue(w, &session->sessionId, &UA_TYPES[UA_TYPES_NODEID]);
+    writeValue(w, &session->authenticationToken, &UA_TYPES[UA_TYPES_NODEID]);
+    writeValue(w, &session->sessionName, &UA_TYPES[UA_TYPES_STRING]);
+    writeValue(w, &session->serverNonce, &UA_TYPES[UA_TYPES_BYTESTRING]);
+    writeValue(w, &session->timeout, &UA_TYPES[UA_TYPES_DOUBLE]);
+    writeValue(w, &session->clientDescription,
+               &UA_TYPES[UA_TYPES_APPLICATIONDESCRIPTION]);
+    writeValue(w, &session->clientUserIdOfSession, &UA_TYPES[UA_TYPES_STRING]);
+    writeValue(w, &session->roles, &UA_TYPES[UA_TYPES_UINT64]);
+    writeUInt32(w, (UA_UInt32)session->localeIdsSize);
+    for(size_t i = 0; i < session->localeIdsSize; i++)
+        writeValue(w, &session->localeIds[i], &UA_TYPES[UA_TYPES_STRING]);
+}
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+
+static void
+encodeSubscription(ReplicationWriter *w, const UA_Subscription *sub) {
+    UA_Boolean publishingEnabled = (sub->state == UA_SUBSCRIPTIONSTATE_ENABLED);
+    writeTag(w, UA_REPLICATIONRECORD_SUBSCRIPTION);
+    writeUInt32(w, sub->subscriptionId);
+    writeValue(w, (sub->session) ? &sub->session->sessionId : &UA_NODEID_NULL,
+               &UA_TYPES[UA_TYPES_NODEID]);
+    writeValue(w, &sub->publishingInterval, &UA_TYPES[UA_TYPES_DOUBLE]);
+    writeUInt32(w, sub->lifeTimeCount);
+    writeUInt32(w, sub->maxKeepAliveCount);
+    writeUInt32(w, sub->notificationsPerPublish);
+    writeValue(w, &sub->priority, &UA_TYPES[UA_TYPES_BYTE]);
+    writeValue(w, &publishingEnabled, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    writeUInt32(w, sub->nextSequenceNumber);
+}
+
+static void
+encodeMonitoredItem(ReplicationWriter *w, const UA_MonitoredItem *mon) {
+    /* Shallow copy. The request is only encoded. */
+    UA_MonitoredItemCreateRequest request;
+    request.itemToMonitor = mon->itemToMonitor;
+    request.monitoringMode = mon->monitoringMode;
+    request.requestedParameters = mon->parameters;
+
+    writeTag(w, UA_REPLICATIONRECORD_MONITOREDITEM);
+    writeUInt32(w, mon->subscription->subscriptionId);
+    writeUInt32(w, mon->monitoredItemId);
+    writeUInt32(w, (UA_UInt32)mon->timestampsToReturn);
+    writeValue(w, &request, &UA_TYPES[UA_TYPES_MONITOREDITEMCREATEREQUEST]);
+}
+
+#endif /* UA_ENABLE_SUBSCRIPTIONS */
+
+/* Encode all activated Sessions with their Subscriptions and MonitoredItems */
+static void
+encodeState(UA_Server *server, ReplicationWriter *w) {
+    writeTag(w, UA_REPLICATIONRECORD_RESET);
+
+    session_list_entry *sentry;
+    LIST_FOREACH(sentry, &server->sessions, pointers) {
+        if(sentry->session.activated)
+            encodeSession(w, &sentry->session);
+    }
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    UA_Subscription *sub;
+    LIST_FOREACH(sub, &server->subscriptions, serverListEntry) {
+        /* The original of a transferred Subscription is about to be removed */
+        if(sub == server->adminSubscription ||
+           sub->statusChange == UA_STATUSCODE_GOODSUBSCRIPTIONTRANSFERRED)
+            continue;
+        encodeSubscription(w, sub);
+        UA_MonitoredItem *mon;
+        LIST_FOREACH(mon, &sub->monitoredItems, listEntry) {
+            encodeMonitoredItem(w, mon);
+        }
+    }
+#endif
+}
+
+/* Deliver the pending records to the callback */
+static void
+flushReplication(UA_Server *server, UA_ReplicationManager *rm) {
+    UA_LOCK(&server->serviceMutex);
+    rm->flushRegistered = false;
+    ReplicationWriter w = rm->pending;
+    memset(&rm->pending, 0, sizeof(ReplicationWriter));
+
+    /* Records were lost. Send the full state to resynchronize the standby. */
+    if(w.res != UA_STATUSCODE_GOOD) {
+        UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
+                       "Replication | Could not encode the delta with "
+                       "StatusCode %s. Sending the full state instead.",
+                       UA_StatusCode_name(w.res));
+        UA_ByteString_clear(&w.buf);
+        initReplicationWriter(&w);
+        encodeState(server, &w);
+    }
+
+    UA_Server_ReplicationCallback callback = rm->callback;
+    void *context = rm->callbackContext;
+    UA_UNLOCK(&server->serviceMutex);
+
+    if(callback && w.res == UA_STATUSCODE_GOOD && w.pos != w.buf.data) {
+        UA_ByteString delta = {(size_t)(w.pos - w.buf.data), w.buf.data};
+        callback(server, context, &delta);
+    }
+    UA_ByteString_clear(&w.buf);
+}
+
+/* Returns NULL if no callback is set. Otherwise the records are appended to
+ * the pending delta. */
+static ReplicationWriter *
+getReplicationWriter(UA_Server *server) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+    UA_ReplicationManager *rm = server->replication;
+    if(!rm || !rm->callback || rm->sc.state != UA_LIFECYCLESTATE_STARTED)
+        return NULL;
+    if(!rm->pending.buf.data && rm->pending.res == UA_STATUSCODE_GOOD)
+        initReplicationWriter(&rm->pending);
+    if(!rm->flushRegistered) {
+        UA_EventLoop *el = server->config.eventLoop;
+        el->addDelayedCallback(el, &rm->flushCallback);
+        rm->flushRegistered = true;
+    }
+    return &rm->pending;
+}
+
+void
+replicateSession(UA_Server *server, const UA_Session *session) {
+    ReplicationWriter *w = getReplicationWriter(server);
+    if(w)
+        encodeSession(w, session);
+}
+
+void
+replicateSessionRemoved(UA_Server *server, const UA_Session *session) {
+    if(!session->activated)
+        return; /* Was never replicated */
+    ReplicationWriter *w = getReplicationWriter(server);
+    if(!w)
+        return;
+    writeTag(w, UA_REPLICATIONRECORD_SESSIONREMOVED);
+    writeValue(w, &session->sessionId, &UA_TYPES[UA_TYPES_NODEID]);
+}
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+
+void
+replicateSubscription(UA_Server *server, const UA_Subscription *sub) {
+    if(sub == server->adminSubscription)
+        return;
+    ReplicationWriter *w = getReplicationWriter(server);
+    if(w)
+        encodeSubscription(w, sub);
+}
+
+void
+replicateSubscriptionRemoved(UA_Server *server, const UA_Subscription *sub) {
+    if(sub == server->adminSubscription)
+        return;
+    ReplicationWriter *w = getReplicationWriter(server);
+    if(!w)
+        return;
+    writeTag(w, UA_REPLICATIONRECORD_SUBSCRIPTIONREMOVED);
+    writeUInt32(w, sub->subscriptionId);
+}
+
+void
+replicateSequenceNumber(UA_Server *server, const UA_Subscription *sub) {
+    if(sub == server->adminSubscription)
+        return;
+    ReplicationWriter *w = getReplicationWriter(server);
+    if(!w)
+        return;
+    writeTag(w, UA_REPLICATIONRECORD_SEQUENCENUMBER);
+    writeUInt32(w, sub->subscriptionId);
+    writeUInt32(w, sub->nextSequenceNumber);
+}
+
+void
+replicateMonitoredItem(UA_Server *server, const UA_MonitoredItem *mon) {
+    if(!mon->subscription || mon->subscription == server->adminSubscription)
+        return;
+    ReplicationWriter *w = getReplicationWriter(server);
+    if(w)
+        encodeMonitoredItem(w, mon);
+}
+
+void
+replicateMonitoredItemRemoved(UA_Server *server, const UA_MonitoredItem *mon) {
+    if(!mon->subscription || mon->subscription == server->adminSubscription)
+        return;
+    ReplicationWriter *w = getReplicationWriter(server);
+    if(!w)
+        return;
+    writeTag(w, UA_REPLICATIONRECORD_MONITOREDITEMREMOVED);
+    writeUInt32(w, mon->subscription->subscriptionId);
+    writeUInt32(w, mon->monitoredItemId);
+}
+
+#endif /* UA_ENABLE_SUBSCRIPTIONS */
+
+/************/
+/* Decoding */
+/************/
+
+typedef struct {
+    const UA_ByteString *buf;
+    size_t offset;
+    UA_DecodeBinaryOptions opts;
+    UA_StatusCode res;
+} ReplicationReader;
+
+static void
+readValue(ReplicationReader *r, void *p, const UA_DataType *type) {
+    if(r->res != UA_STATUSCODE_GOOD) {
+        memset(p, 0, type->memSize);
+        return;
+    }
+    r->res = UA_decodeBinaryInternal(r->buf, &r->offset, p, type, &r->opts);
+}
+
+static UA_UInt32
+readUInt32(ReplicationReader *r) {
+    UA_UInt32 v = 0;
+    readValue(r, &v, &UA_TYPES[UA_TYPES_UINT32]);
+    return v;
+}
+
+static void
+applySession(UA_ReplicationManager *rm, ReplicationReader *r) {
+    ShadowSession *ss = (ShadowSession*)UA_calloc(1, sizeof(ShadowSession));
+    if(!ss) {
+        r->res = UA_STATUSCODE_BADOUTOFMEMORY;
+        return;
+    }
+    readValue(r, &ss->sessionId, &UA_TYPES[UA_TYPES_NODEID]);
+    readValue(r, &ss->authenticationToken, &UA_TYPES[UA_TYPES_NODEID]);
+    readValue(r, &ss->sessionName, &UA_TYPES[UA_TYPES_STRING]);
+    readValue(r, &ss->serverNonce, &UA_TYPES[UA_TYPES_BYTESTRING]);
+    readValue(r, &ss->timeout, &UA_TYPES[UA_TYPES_DOUBLE]);
+    readValue(r, &ss->clientDescription, &UA_TYPES[UA_TYPES_APPLICATIONDESCRIPTION]);
+    readValue(r, &ss->clientUserId, &UA_TYPES[UA_TYPES_STRING]);
+    readValue(r, &ss->roles, &UA_TYPES[UA_TYPES_UINT64]);
+
+    /* Every String takes at least four bytes */
+    UA_UInt32 localeIdsSize = readUInt32(r);
+    if(r->res == UA_STATUSCODE_GOOD && localeIdsSize > 0) {
+        if(localeIdsSize > (r->buf->length - r->offset) / 4) {
+            r->res = UA_STATUSCODE_BADDECODINGERROR;
+        } else {
+            ss->localeIds = (UA_String*)
+                UA_Array_new(localeIdsSize, &UA_TYPES[UA_TYPES_STRING]);
+            if(!ss->localeIds)
+                r->res = UA_STATUSCODE_BADOUTOFMEMORY;
+            else
+                ss->localeIdsSize = localeIdsSize;
+        }
+    }
+    for(size_t i = 0; i < ss->localeIdsSize; i++)
+        readValue(r, &ss->localeIds[i], &UA_TYPES[UA_TYPES_STRING]);
+
+    if(r->res != UA_STATUSCODE_GOOD) {
+        ShadowSession_delete(ss);
+        return;
+    }
+
+    /* Replace the previous version */
+    ShadowSession *old = ZIP_FIND(ShadowSessionTree, &rm->sessions, &ss->sessionId);
+    if(old) {
+        ZIP_REMOVE(ShadowSessionTree, &rm->sessions, old);
+        ShadowSession_delete(old);
+    }
+    ZIP_INSERT(ShadowSessionTree, &rm->sessions, ss);
+}
+
+static void
+applySessionRemoved(UA_ReplicationManager *rm, ReplicationReader *r) {
+    UA_NodeId sessionId;
+    readValue(r, &sessionId, &UA_TYPES[UA_TYPES_NODEID]);
+    if(r->res != UA_STATUSCODE_GOOD)
+        return;
+    ShadowSession *ss = ZIP_FIND(ShadowSessionTree, &rm->sessions, &sessionId);
+    if(ss) {
+        ZIP_REMOVE(ShadowSessionTree, &rm->sessions, ss);
+        ShadowSession_delete(ss);
+    }
+    UA_NodeId_clear(&sessionId);
+}
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+
+static void
+applySubscription(UA_ReplicationManager *rm, ReplicationReader *r) {
+    ShadowSubscription *ssub = (ShadowSubscription*)
+        UA_calloc(1, sizeof(ShadowSubscription));
+    if(!ssub) {
+        r->res = UA_STATUSCODE_BADOUTOFMEMORY;
+        return;
+    }
+    ssub->subscriptionId = readUInt32(r);
+    readValue(r, &ssub->sessionId, &UA_TYPES[UA_TYPES_NODEID]);
+    readValue(r, &ssub->publishingInterval, &UA_TYPES[UA_TYPES_DOUBLE]);
+    ssub->lifeTimeCount = readUInt32(r);
+    ssub->maxKeepAliveCount = readUInt32(r);
+    ssub->notificationsPerPublish = readUInt32(r);
+    readValue(r, &ssub->priority, &UA_TYPES[UA_TYPES_BYTE]);
+    readValue(r, &ssub->publishingEnabled, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    ssub->nextSequenceNumber = readUInt32(r);
+    if(r->res != UA_STATUSCODE_GOOD) {
+        ShadowSubscription_delete(ssub);
+        return;
+    }
+
+    /* Replace the previous version. The MonitoredItems are kept. */
+    ShadowSubscription *old =
+        ZIP_FIND(ShadowSubscriptionTree, &rm->subscriptions, &ssub->subscriptionId);
+    if(old) {
+        ZIP_REMOVE(ShadowSubscriptionTree, &rm->subscriptions, old);
+        ssub->monitoredItems = old->monitoredItems;
+        ZIP_INIT(&old->monitoredItems);
+        ShadowSubscription_delete(old);
+    }
+    ZIP_INSERT(ShadowSubscriptionTree, &rm->subscriptions, ssub);
+}
+
+static void
+applySubscriptionRemoved(UA_ReplicationManager *rm, ReplicationReader *r) {
+    UA_UInt32 subscriptionId = readUInt32(r);
+    if(r->res != UA_STATUSCODE_GOOD)
+        return;
+    ShadowSubscription *ssub =
+        ZIP_FIND(ShadowSubscriptionTree, &rm->subscriptions, &subscriptionId);
+    if(ssub) {
+        ZIP_REMOVE(ShadowSubscriptionTree, &rm->subscriptions, ssub);
+        ShadowSubscription_delete(ssub);
+    }
+}
+
+static void
+applySequenceNumber(UA_ReplicationManager *rm, ReplicationReader *r) {
+    UA_UInt32 subscriptionId = readUInt32(r);
+    UA_UInt32 nextSequenceNumber = readUInt32(r);
+    if(r->res != UA_STATUSCODE_GOOD)
+        return;
+    ShadowSubscription *ssub =
+        ZIP_FIND(ShadowSubscriptionTree, &rm->subscriptions, &subscriptionId);
+    if(ssub)
+        ssub->nextSequenceNumber = nextSequenceNumber;
+}
+
+static void
+applyMonitoredItem(UA_ReplicationManager *rm, ReplicationReader *r) {
+    ShadowMonitoredItem *smon = (ShadowMonitoredItem*)
+        UA_calloc(1, sizeof(ShadowMonitoredItem));
+    if(!smon) {
+        r->res = UA_STATUSCODE_BADOUTOFMEMORY;
+        return;
+    }
+    UA_UInt32 subscriptionId = readUInt32(r);
+    smon->monitoredItemId = readUInt32(r);
+    smon->timestampsToReturn = (UA_TimestampsToReturn)readUInt32(r);
+    readValue(r, &smon->request, &UA_TYPES[UA_TYPES_MONITOREDITEMCREATEREQUEST]);
+    ShadowSubscription *ssub =
+        ZIP_FIND(ShadowSubscriptionTree, &rm->subscriptions, &subscriptionId);
+    if(r->res != UA_STATUSCODE_GOOD || !ssub) {
+        ShadowMonitoredItem_delete(smon);
+        return;
+    }
+
+    /* Replace the previous version */
+    ShadowMonitoredItem *old = ZIP_FIND(ShadowMonitoredItemTree,
+                                        &ssub->monitoredItems, &smon->monitoredItemId);
+    if(old) {
+        ZIP_REMOVE(ShadowMonitoredItemTree, &ssub->monitoredItems, old);
+        ShadowMonitoredItem_delete(old);
+    }
+    ZIP_INSERT(ShadowMonitoredItemTree, &ssub->monitoredItems, smon);
+}
+
+static void
+applyMonitoredItemRemoved(UA_ReplicationManager *rm, ReplicationReader *r) {
+    UA_UInt32 subscriptionId = readUInt32(r);
+    UA_UInt32 monitoredItemId = readUInt32(r);
+    if(r->res != UA_STATUSCODE_GOOD)
+        return;
+    ShadowSubscription *ssub =
+        ZIP_FIND(ShadowSubscriptionTree, &rm->subscriptions, &subscriptionId);
+    if(!ssub)
+        return;
+    ShadowMonitoredItem *smon =
+        ZIP_FIND(ShadowMonitoredItemTree, &ssub->monitoredItems, &monitoredItemId);
+    if(smon) {
+        ZIP_REMOVE(ShadowMonitoredItemTree, &ssub->monitoredItems, smon);
+        ShadowMonitoredItem_delete(smon);
+    }
+}
+
+#endif /* UA_ENABLE_SUBSCRIPTIONS */
+
+/************/
+/* Takeover */
+/************/
+
+static void
+restoreSession(UA_Server *server, ShadowSession *ss) {
+    UA_Session *session = NULL;
+    UA_StatusCode res =
+        UA_Server_restoreSession(server, &ss->sessionId, &ss->authenticationToken,
+                                 ss->timeout, &session);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
+                       "Replication | Could not restore the Session %N "
+                       "with StatusCode %s", ss->sessionId, UA_StatusCode_name(res));
+        return;
+    }
+
+    /* Move the content over */
+    session->sessionName = ss->sessionName;
+    UA_String_init(&ss->sessionName);
+    session->serverNonce = ss->serverNonce;
+    UA_ByteString_init(&ss->serverNonce);
+    session->clientDescription = ss->clientDescription;
+    UA_ApplicationDescription_init(&ss->clientDescription);
+    session->clientUserIdOfSession = ss->clientUserId;
+    UA_String_init(&ss->clientUserId);
+    session->localeIds = ss->localeIds;
+    session->localeIdsSize = ss->localeIdsSize;
+    ss->localeIds = NULL;
+    ss->localeIdsSize = 0;
+    session->roles = ss->roles;
+
+    /* The client can activate the Session on a new SecureChannel. The
+     * AccessControl plugin sets up the session context at that point. */
+    session->activated = true;
+    server->activeSessionCount++;
+}
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+
+static void
+restoreSubscription(UA_Server *server, ShadowSubscription *ssub) {
+    /* The Session must have been restored. Detached Subscriptions (without a
+     * Session) can be transferred by the client. */
+    UA_Session *session = NULL;
+    if(!UA_NodeId_isNull(&ssub->sessionId)) {
+        session = getSessionById(server, &ssub->sessionId);
+        if(!session) {
+            UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
+                           "Replication | The Session of the Subscription %"
+                           PRIu32 " was not restored", ssub->subscriptionId);
+            return;
+        }
+    }
+
+    UA_Subscription *sub = UA_Subscription_new();
+    if(!sub)
+        return;
+    sub->subscriptionId = ssub->subscriptionId;
+    sub->publishingInterval = ssub->publishingInterval;
+    sub->lifeTimeCount = ssub->lifeTimeCount;
+    sub->maxKeepAliveCount = ssub->maxKeepAliveCount;
+    sub->notificationsPerPublish = ssub->notificationsPerPublish;
+    sub->priority = ssub->priority;
+    sub->nextSequenceNumber = ssub->nextSequenceNumber;
+    UA_StatusCode res =
+        UA_Server_restoreSubscription(server, session, sub, ssub->publishingEnabled);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
+                       "Replication | Could not restore the Subscription %"
+                       PRIu32 " with StatusCode %s", ssub->subscriptionId,
+                       UA_StatusCode_name(res));
+        return;
+    }
+
+    /* The MonitoredItems are created in the order of their identifiers */
+    if(!session)
+        session = &server->adminSession;
+    for(ShadowMonitoredItem *smon =
+            ZIP_MIN(ShadowMonitoredItemTree, &ssub->monitoredItems);
+        smon; smon = ZIP_MIN(ShadowMonitoredItemTree, &ssub->monitoredItems)) {
+        ZIP_REMOVE(ShadowMonitoredItemTree, &ssub->monitoredItems, smon);
+        res = UA_Server_restoreMonitoredItem(server, session, sub,
+                                             smon->monitoredItemId,
+                                             smon->timestampsToReturn,
+                                             &smon->request);
+        if(res != UA_STATUSCODE_GOOD)
+            UA_LOG_WARNING_SUBSCRIPTION(server->config.logging, sub,
+                                        "Replication | Could not restore the "
+                                        "MonitoredItem %" PRIu32 " with "
+                                        "StatusCode %s", smon->monitoredItemId,
+                                        UA_StatusCode_name(res));
+        ShadowMonitoredItem_delete(smon);
+    }
+}
+
+#endif /* UA_ENABLE_SUBSCRIPTIONS */
+
+/***********************/
+/* Component Lifecycle */
+/***********************/
+
+static void
+setReplicationManagerState(UA_ReplicationManager *rm, UA_LifecycleState state) {
+    if(state == rm->sc.state)
+        return;
+    rm->sc.state = state;
+    if(rm->sc.notifyState)
+        rm->sc.notifyState(&rm->sc, state);
+}
+
+static UA_StatusCode
+UA_ReplicationManager_start(UA_ServerComponent *sc, UA_Server *server) {
+    setReplicationManagerState((UA_ReplicationManager*)sc, UA_LIFECYCLESTATE_STARTED);
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Pending records are dropped. The standby needs to be resynchronized with
+ * the full state when the server is started again. */
+static void
+UA_ReplicationManager_stop(UA_ServerComponent *sc) {
+    UA_ReplicationManager *rm = (UA_ReplicationManager*)sc;
+    if(rm->flushRegistered) {
+        UA_EventLoop *el = sc->server->config.eventLoop;
+        el->removeDelayedCallback(el, &rm->flushCallback);
+        rm->flushRegistered = false;
+    }
+    UA_ByteString_clear(&rm->pending.buf);
+    memset(&rm->pending, 0, sizeof(ReplicationWriter));
+    setReplicationManagerState(rm, UA_LIFECYCLESTATE_STOPPED);
+}
+
+static UA_StatusCode
+UA_ReplicationManager_clear(UA_ServerComponent *sc) {
+    if(sc->state != UA_LIFECYCLESTATE_STOPPED) {
+        UA_LOG_ERROR(sc->server->config.logging, UA_LOGCATEGORY_SERVER,
+                     "Cannot delete the ReplicationManager because "
+                     "it is not stopped");
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+    UA_ReplicationManager *rm = (UA_ReplicationManager*)sc;
+    UA_ByteString_clear(&rm->pending.buf);
+    clearShadowState(rm);
+    if(sc->server->replication == rm)
+        sc->server->replication = NULL;
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_ServerComponent *
+UA_ReplicationManager_new(UA_Server *server) {
+    UA_ReplicationManager *rm = (UA_ReplicationManager*)
+        UA_calloc(1, sizeof(UA_ReplicationManager));
+    if(!rm)
+        return NULL;
+
+    rm->flushCallback.callback = (UA_Callback)flushReplication;
+    rm->flushCallback.application = server;
+    rm->flushCallback.context = rm;
+
+    rm->sc.name = UA_STRING("replication");
+    rm->sc.start = UA_ReplicationManager_start;
+    rm->sc.stop = UA_ReplicationManager_stop;
+    rm->sc.clear = UA_ReplicationManager_clear;
+    rm->sc.server = server;
+
+    server->replication = rm;
+    return &rm->sc;
+}
+
+/**************/
+/* Public API */
+/**************/
+
+UA_StatusCode
+UA_Server_setReplicationCallback(UA_Server *server,
+                                 UA_Server_ReplicationCallback callback,
+                                 void *context) {
+    UA_LOCK(&server->serviceMutex);
+    UA_ReplicationManager *rm = server->replication;
+    if(!rm) {
+        UA_UNLOCK(&server->serviceMutex);
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+    rm->callback = callback;
+    rm->callbackContext = context;
+    UA_UNLOCK(&server->serviceMutex);
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_Server_getReplicationState(UA_Server *server, UA_ByteString *state) {
+    ReplicationWriter w;
+    initReplicationWriter(&w);
+    if(w.res != UA_STATUSCODE_GOOD)
+        return w.res;
+    UA_LOCK(&server->serviceMutex);
+    encodeState(server, &w);
+    UA_UNLOCK(&server->serviceMutex);
+
+    if(w.res != UA_STATUSCODE_GOOD) {
+        UA_ByteString_clear(&w.buf);
+        return w.res;
+    }
+
+    /* Shrink to the used size */
+    state->length = (size_t)(w.pos - w.buf.data);
+    state->data = (UA_Byte*)UA_realloc(w.buf.data, state->length);
+    if(!state->data)
+        state->data = w.buf.data;
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_Server_applyReplicationDelta(UA_Server *server, const UA_ByteString *delta) {
+    ReplicationReader r;
+    memset(&r, 0, sizeof(ReplicationReader));
+    r.buf = delta;
+
+    UA_LOCK(&server->serviceMutex);
+    UA_ReplicationManager *rm = server->replication;
+    if(!rm) {
+        UA_UNLOCK(&server->serviceMutex);
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    while(r.res == UA_STATUSCODE_GOOD && r.offset < delta->length) {
+        UA_Byte tag = delta->data[r.offset++];
+        switch(tag) {
+        case UA_REPLICATIONRECORD_RESET:
+            clearShadowState(rm);
+            break;
+        case UA_REPLICATIONRECORD_SESSION:
+            applySession(rm, &r);
+            break;
+        case UA_REPLICATIONRECORD_SESSIONREMOVED:
+            applySessionRemoved(rm, &r);
+            break;
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+        case UA_REPLICATIONRECORD_SUBSCRIPTION:
+            applySubscription(rm, &r);
+            break;
+        case UA_REPLICATIONRECORD_SUBSCRIPTIONREMOVED:
+            applySubscriptionRemoved(rm, &r);
+            break;
+        case UA_REPLICATIONRECORD_SEQUENCENUMBER:
+            applySequenceNumber(rm, &r);
+            break;
+        case UA_REPLICATIONRECORD_MONITOREDITEM:
+            applyMonitoredItem(rm, &r);
+            break;
+        case UA_REPLICATIONRECORD_MONITOREDITEMREMOVED:
+            applyMonitoredItemRemoved(rm, &r);
+            break;
+#endif
+        default:
+            r.res = UA_STATUSCODE_BADDECODINGERROR;
+            break;
+        }
+    }
+
+    UA_UNLOCK(&server->serviceMutex);
+    return r.res;
+}
+
+UA_StatusCode
+UA_Server_takeOverReplication(UA_Server *server) {
+    UA_LOCK(&server->serviceMutex);
+    UA_ReplicationManager *rm = server->replication;
+    if(!rm) {
+        UA_UNLOCK(&server->serviceMutex);
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    /* Restore the Sessions first. The Subscriptions are attached to them. */
+    ShadowSession *ss;
+    while((ss = ZIP_MIN(ShadowSessionTree, &rm->sessions))) {
+        ZIP_REMOVE(ShadowSessionTree, &rm->sessions, ss);
+        restoreSession(server, ss);
+        ShadowSession_delete(ss);
+    }
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    ShadowSubscription *ssub;
+    while((ssub = ZIP_MIN(ShadowSubscriptionTree, &rm->subscriptions))) {
+        ZIP_REMOVE(ShadowSubscriptionTree, &rm->subscriptions, ssub);
+        restoreSubscription(server, ssub);
+        ShadowSubscription_delete(ssub);
+    }
+#endif
+
+    UA_LOG_INFO(server->config.logging, UA_LOGCATEGORY_SERVER,
+                "Replication | Took over the replicated Sessions and Subscriptions");
+    UA_UNLOCK(&server->serviceMutex);
+    return UA_STATUSCODE_GOOD;
+}
@@ -0,0 +1,592 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "ua_server_internal.h"
+#include "../ua_types_encoding_binary.h"
+
+/* The snapshot is a sequence of binary encoded values:
+ *
+ * - Header: UInt32 magic, UInt32 version
+ * - Namespace array: UInt32 count, String[count]
+ * - Nodes: UInt32 nodeClass, then the node content (see encodeNode). The
+ *   ReferenceTypes are written first. So their index is known when the
+ *   references of the following nodes are restored.
+ * - Terminator: UInt32 UA_NODECLASS_UNSPECIFIED */
+
+#define UA_SNAPSHOT_MAGIC 0x53534155 /* "UASS" */
+#define UA_SNAPSHOT_VERSION 1
+#define UA_SNAPSHOT_INITIALSIZE (1u << 16)
+
+/************/
+/* Encoding */
+/************/
+
+typedef struct {
+    UA_Server *server;
+    UA_ByteString buf;
+    UA_Byte *pos;
+    const UA_Byte *end;
+    UA_Boolean referenceTypes; /* Encode only (or no) ReferenceTypes */
+    UA_StatusCode res;
+} SnapshotWriter;
+
+/* Grow the buffer when the end is reached. The encoding continues at the same
+ * offset in the reallocated buffer. */
+static UA_StatusCode
+growSnapshotBuffer(void *handle, UA_Byte **bufPos, const UA_Byte **bufEnd) {
+    SnapshotWriter *w = (SnapshotWriter*)handle;
+    size_t used = (size_t)(*bufPos - w->buf.data);
+    size_t newLength = w->buf.length * 2;
+    UA_Byte *newData = (UA_Byte*)UA_realloc(w->buf.data, newLength);
+    if(!newData)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    w->buf.data = newData;
+    w->buf.length = newLength;
+    *bufPos = newData + used;
+    *bufEnd = newData + newLength;
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+writeValue(SnapshotWriter *w, const void *p, const UA_DataType *type) {
+    if(w->res != UA_STATUSCODE_GOOD)
+        return;
+    w->res = UA_encodeBinaryInternal(p, type, &w->pos, &w->end,
+                                     growSnapshotBuffer, w);
+}
+
+static void
+writeUInt32(SnapshotWriter *w, UA_UInt32 v) {
+    writeValue(w, &v, &UA_TYPES[UA_TYPES_UINT32]);
+}
+
+static void
+writeLocalizedTextList(SnapshotWriter *w, const UA_LocalizedTextListEntry *lt) {
+    UA_UInt32 count = 0;
+    for(const UA_LocalizedTextListEntry *e = lt; e; e = e->next)
+        count++;
+    writeUInt32(w, count);
+    for(; lt; lt = lt->next)
+        writeValue(w, &lt->localizedText, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+}
+
+/* Values from a DataSource or an external value backend are not stored */
+static void
+writeVariableAttributes(SnapshotWriter *w, const UA_VariableNode *vn) {
+    writeValue(w, &vn->dataType, &UA_TYPES[UA_TYPES_NODEID]);
+    writeValue(w, &vn->valueRank, &UA_TYPES[UA_TYPES_INT32]);
+    writeUInt32(w, (UA_UInt32)vn->arrayDimensionsSize);
+    for(size_t i = 0; i < vn->arrayDimensionsSize; i++)
+        writeUInt32(w, vn->arrayDimensions[i]);
+    UA_DataValue empty;
+    UA_DataValue_init(&empty);
+    const UA_DataValue *value = &empty;
+    if(vn->valueSource == UA_VALUESOURCE_DATA &&
+       vn->valueBackend.backendType != UA_VALUEBACKENDTYPE_EXTERNAL &&
+       vn->valueBackend.backendType != UA_VALUEBACKENDTYPE_MEMORY)
+        value = &vn->value.data.value;
+    writeValue(w, value, &UA_TYPES[UA_TYPES_DATAVALUE]);
+}
+
+static void *
+writeReferenceTarget(void *context, UA_ReferenceTarget *t) {
+    SnapshotWriter *w = (SnapshotWriter*)context;
+    UA_ExpandedNodeId en = UA_NodePointer_toExpandedNodeId(t->targetId);
+    writeValue(w, &en, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
+    writeUInt32(w, t->targetNameHash);
+    return NULL;
+}
+
+static void
+encodeNode(void *context, const UA_Node *node) {
+    SnapshotWriter *w = (SnapshotWriter*)context;
+    const UA_NodeHead *head = &node->head;
+    if(w->referenceTypes != (head->nodeClass == UA_NODECLASS_REFERENCETYPE))
+        return;
+
+    writeUInt32(w, (UA_UInt32)head->nodeClass);
+    writeValue(w, &head->nodeId, &UA_TYPES[UA_TYPES_NODEID]);
+    writeValue(w, &head->browseName, &UA_TYPES[UA_TYPES_QUALIFIEDNAME]);
+    writeLocalizedTextList(w, head->displayName);
+    writeLocalizedTextList(w, head->description);
+    writeUInt32(w, head->writeMask);
+
+    switch(head->nodeClass) {
+    case UA_NODECLASS_OBJECT:
+        writeValue(w, &node->objectNode.eventNotifier, &UA_TYPES[UA_TYPES_BYTE]);
+        break;
+    case UA_NODECLASS_VARIABLE:
+        writeVariableAttributes(w, &node->variableNode);
+        writeValue(w, &node->variableNode.accessLevel, &UA_TYPES[UA_TYPES_BYTE]);
+        writeValue(w, &node->variableNode.minimumSamplingInterval,
+                   &UA_TYPES[UA_TYPES_DOUBLE]);
+        writeValue(w, &node->variableNode.historizing, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        writeValue(w, &node->variableNode.isDynamic, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    case UA_NODECLASS_VARIABLETYPE:
+        writeVariableAttributes(w, (const UA_VariableNode*)&node->variableTypeNode);
+        writeValue(w, &node->variableTypeNode.isAbstract, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    case UA_NODECLASS_METHOD:
+        writeValue(w, &node->methodNode.executable, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    case UA_NODECLASS_OBJECTTYPE:
+        writeValue(w, &node->objectTypeNode.isAbstract, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    case UA_NODECLASS_REFERENCETYPE:
+        writeValue(w, &node->referenceTypeNode.isAbstract, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        writeValue(w, &node->referenceTypeNode.symmetric, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        writeValue(w, &node->referenceTypeNode.inverseName,
+                   &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+        break;
+    case UA_NODECLASS_DATATYPE:
+        writeValue(w, &node->dataTypeNode.isAbstract, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    case UA_NODECLASS_VIEW:
+        writeValue(w, &node->viewNode.eventNotifier, &UA_TYPES[UA_TYPES_BYTE]);
+        writeValue(w, &node->viewNode.containsNoLoops, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    default:
+        w->res = UA_STATUSCODE_BADINTERNALERROR;
+        return;
+    }
+
+    /* The ReferenceTypeIndex is local to the server instance. Store the NodeId
+     * of the ReferenceType instead. */
+    writeUInt32(w, (UA_UInt32)head->referencesSize);
+    for(size_t i = 0; i < head->referencesSize; i++) {
+        UA_NodeReferenceKind *rk = &head->references[i];
+        const UA_NodeId *refTypeId =
+            UA_NODESTORE_GETREFERENCETYPEID(w->server, rk->referenceTypeIndex);
+        if(!refTypeId) {
+            w->res = UA_STATUSCODE_BADINTERNALERROR;
+            return;
+        }
+        writeValue(w, refTypeId, &UA_TYPES[UA_TYPES_NODEID]);
+        writeValue(w, &rk->isInverse, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        writeUInt32(w, (UA_UInt32)rk->targetsSize);
+        UA_NodeReferenceKind_iterate(rk, writeReferenceTarget, w);
+    }
+}
+
+UA_StatusCode
+UA_Server_saveAddressSpaceSnapshot(UA_Server *server, UA_ByteString *snapshot) {
+    SnapshotWriter w;
+    memset(&w, 0, sizeof(SnapshotWriter));
+    w.server = server;
+    w.buf.data = (UA_Byte*)UA_malloc(UA_SNAPSHOT_INITIALSIZE);
+    if(!w.buf.data)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    w.buf.length = UA_SNAPSHOT_INITIALSIZE;
+    w.pos = w.buf.data;
+    w.end = w.buf.data + w.buf.length;
+
+    UA_LOCK(&server->serviceMutex);
+    setupNs1Uri(server);
+
+    writeUInt32(&w, UA_SNAPSHOT_MAGIC);
+    writeUInt32(&w, UA_SNAPSHOT_VERSION);
+    writeUInt32(&w, (UA_UInt32)server->namespacesSize);
+    for(size_t i = 0; i < server->namespacesSize; i++)
+        writeValue(&w, &server->namespaces[i], &UA_TYPES[UA_TYPES_STRING]);
+
+    /* ReferenceTypes first */
+    w.referenceTypes = true;
+    server->config.nodestore.iterate(server->config.nodestore.context, encodeNode, &w);
+    w.referenceTypes = false;
+    server->config.nodestore.iterate(server->config.nodestore.context, encodeNode, &w);
+    writeUInt32(&w, (UA_UInt32)UA_NODECLASS_UNSPECIFIED);
+
+    UA_UNLOCK(&server->serviceMutex);
+
+    if(w.res != UA_STATUSCODE_GOOD) {
+        UA_ByteString_clear(&w.buf);
+        return w.res;
+    }
+
+    /* Shrink to the used size */
+    snapshot->length = (size_t)(w.pos - w.buf.data);
+    snapshot->data = (UA_Byte*)UA_realloc(w.buf.data, snapshot->length);
+    if(!snapshot->data)
+        snapshot->data = w.buf.data;
+    return UA_STATUSCODE_GOOD;
+}
+
+/************/
+/* Decoding */
+/************/
+
+typedef struct {
+    const UA_Nodestore *ns;
+    const UA_ByteString *buf;
+    size_t offset;
+    UA_DecodeBinaryOptions opts;
+    UA_StatusCode res;
+} SnapshotReader;
+
+static void
+readValue(SnapshotReader *r, void *p, const UA_DataType *type) {
+    if(r->res != UA_STATUSCODE_GOOD) {
+        memset(p, 0, type->memSize);
+        return;
+    }
+    r->res = UA_decodeBinaryInternal(r->buf, &r->offset, p, type, &r->opts);
+}
+
+static UA_UInt32
+readUInt32(SnapshotReader *r) {
+    UA_UInt32 v = 0;
+    readValue(r, &v, &UA_TYPES[UA_TYPES_UINT32]);
+    return v;
+}
+
+/* Restore the original order. Insertion prepends to the list. */
+static void
+readLocalizedTextList(SnapshotReader *r, UA_NodeHead *head, UA_Boolean displayName) {
+    UA_UInt32 count = readUInt32(r);
+    if(r->res != UA_STATUSCODE_GOOD)
+        return;
+    if(count > r->buf->length - r->offset) {
+        r->res = UA_STATUSCODE_BADDECODINGERROR;
+        return;
+    }
+    UA_LocalizedText *lts = (UA_LocalizedText*)
+        UA_Array_new(count, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+    if(!lts && count > 0) {
+        r->res = UA_STATUSCODE_BADOUTOFMEMORY;
+        return;
+    }
+    for(UA_UInt32 i = 0; i < count; i++)
+        readValue(r, &lts[i], &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+    for(UA_UInt32 i = count; i > 0 && r->res == UA_STATUSCODE_GOOD; i--) {
+        r->res = (displayName) ?
+            UA_Node_insertOrUpdateDisplayName(head, &lts[i-1]) :
+            UA_Node_insertOrUpdateDescription(head, &lts[i-1]);
+    }
+    UA_Array_delete(lts, count, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+}
+
+static void
+readVariableAttributes(SnapshotReader *r, UA_VariableNode *vn) {
+    readValue(r, &vn->dataType, &UA_TYPES[UA_TYPES_NODEID]);
+    readValue(r, &vn->valueRank, &UA_TYPES[UA_TYPES_INT32]);
+    UA_UInt32 dimsSize = readUInt32(r);
+    if(r->res != UA_STATUSCODE_GOOD)
+        return;
+    if(dimsSize > 0) {
+        if(dimsSize > r->buf->length - r->offset) {
+            r->res = UA_STATUSCODE_BADDECODINGERROR;
+            return;
+        }
+        vn->arrayDimensions = (UA_UInt32*)
+            UA_Array_new(dimsSize, &UA_TYPES[UA_TYPES_UINT32]);
+        if(!vn->arrayDimensions) {
+            r->res = UA_STATUSCODE_BADOUTOFMEMORY;
+            return;
+        }
+        vn->arrayDimensionsSize = dimsSize;
+        for(UA_UInt32 i = 0; i < dimsSize; i++)
+            vn->arrayDimensions[i] = readUInt32(r);
+    }
+    vn->valueSource = UA_VALUESOURCE_DATA;
+    readValue(r, &vn->value.data.value, &UA_TYPES[UA_TYPES_DATAVALUE]);
+}
+
+static UA_Byte
+lookupReferenceTypeIndex(const UA_Nodestore *ns, const UA_NodeId *refTypeId,
+                         UA_StatusCode *res) {
+    const UA_Node *refType =
+        ns->getNode(ns->context, refTypeId, 0, UA_REFERENCETYPESET_NONE,
+                    UA_BROWSEDIRECTION_INVALID);
+    if(!refType)
+        goto invalid;
+    if(refType->head.nodeClass != UA_NODECLASS_REFERENCETYPE) {
+        ns->releaseNode(ns->context, refType);
+        goto invalid;
+    }
+    UA_Byte refTypeIndex = refType->referenceTypeNode.referenceTypeIndex;
+    ns->releaseNode(ns->context, refType);
+    return refTypeIndex;
+
+ invalid:
+    *res = UA_STATUSCODE_BADREFERENCETYPEIDINVALID;
+    return 0;
+}
+
+static void
+readReferences(SnapshotReader *r, UA_Node *node) {
+    UA_UInt32 kindsSize = readUInt32(r);
+    for(UA_UInt32 i = 0; i < kindsSize && r->res == UA_STATUSCODE_GOOD; i++) {
+        UA_NodeId refTypeId;
+        UA_Boolean isInverse = false;
+        readValue(r, &refTypeId, &UA_TYPES[UA_TYPES_NODEID]);
+        readValue(r, &isInverse, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        UA_UInt32 targetsSize = readUInt32(r);
+        UA_Byte refTypeIndex = 0;
+        if(r->res == UA_STATUSCODE_GOOD && r->ns)
+            refTypeIndex = lookupReferenceTypeIndex(r->ns, &refTypeId, &r->res);
+        UA_NodeId_clear(&refTypeId);
+        for(UA_UInt32 j = 0; j < targetsSize && r->res == UA_STATUSCODE_GOOD; j++) {
+            UA_ExpandedNodeId target;
+            readValue(r, &target, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
+            UA_UInt32 targetNameHash = readUInt32(r);
+            if(r->res == UA_STATUSCODE_GOOD && r->ns) /* Skip without Nodestore */
+                r->res = UA_Node_addReference(node, refTypeIndex, !isInverse,
+                                              &target, targetNameHash);
+            UA_ExpandedNodeId_clear(&target);
+        }
+    }
+}
+
+/* Decode the next node. Returns NULL at the end of the snapshot or if decoding
+ * fails (r->res is set). */
+static UA_Node *
+decodeNode(SnapshotReader *r) {
+    UA_NodeClass nodeClass = (UA_NodeClass)readUInt32(r);
+    if(r->res != UA_STATUSCODE_GOOD || nodeClass == UA_NODECLASS_UNSPECIFIED)
+        return NULL;
+
+    UA_Node *node = (r->ns) ?
+        r->ns->newNode(r->ns->context, nodeClass) :
+        (UA_Node*)UA_calloc(1, sizeof(UA_Node));
+    if(!node) {
+        r->res = UA_STATUSCODE_BADDECODINGERROR;
+        return NULL;
+    }
+    node->head.nodeClass = nodeClass;
+
+    UA_NodeHead *head = &node->head;
+    readValue(r, &head->nodeId, &UA_TYPES[UA_TYPES_NODEID]);
+    readValue(r, &head->browseName, &UA_TYPES[UA_TYPES_QUALIFIEDNAME]);
+    readLocalizedTextList(r, head, true);
+    readLocalizedTextList(r, head, false);
+    head->writeMask = readUInt32(r);
+
+    switch(nodeClass) {
+    case UA_NODECLASS_OBJECT:
+        readValue(r, &node->objectNode.eventNotifier, &UA_TYPES[UA_TYPES_BYTE]);
+        break;
+    case UA_NODECLASS_VARIABLE:
+        readVariableAttributes(r, &node->variableNode);
+        readValue(r, &node->variableNode.accessLevel, &UA_TYPES[UA_TYPES_BYTE]);
+        readValue(r, &node->variableNode.minimumSamplingInterval,
+                  &UA_TYPES[UA_TYPES_DOUBLE]);
+        readValue(r, &node->variableNode.historizing, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        readValue(r, &node->variableNode.isDynamic, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    case UA_NODECLASS_VARIABLETYPE:
+        readVariableAttributes(r, (UA_VariableNode*)&node->variableTypeNode);
+        readValue(r, &node->variableTypeNode.isAbstract, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    case UA_NODECLASS_METHOD:
+        readValue(r, &node->methodNode.executable, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    case UA_NODECLASS_OBJECTTYPE:
+        readValue(r, &node->objectTypeNode.isAbstract, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    case UA_NODECLASS_REFERENCETYPE:
+        readValue(r, &node->referenceTypeNode.isAbstract, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        readValue(r, &node->referenceTypeNode.symmetric, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        readValue(r, &node->referenceTypeNode.inverseName,
+                  &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+        break;
+    case UA_NODECLASS_DATATYPE:
+        readValue(r, &node->dataTypeNode.isAbstract, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    case UA_NODECLASS_VIEW:
+        readValue(r, &node->viewNode.eventNotifier, &UA_TYPES[UA_TYPES_BYTE]);
+        readValue(r, &node->viewNode.containsNoLoops, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    default:
+        r->res = UA_STATUSCODE_BADDECODINGERROR;
+        break;
+    }
+
+    readReferences(r, node);
+    if(r->res != UA_STATUSCODE_GOOD) {
+        if(r->ns) {
+            r->ns->deleteNode(r->ns->context, node);
+        } else {
+            UA_Node_clear(node);
+            UA_free(node);
+        }
+        return NULL;
+    }
+
+    /* Constructors are not called for restored nodes */
+    head->constructed = true;
+    return node;
+}
+
+static void *
+mergeReferenceTarget(void *context, UA_ReferenceTarget *t) {
+    void **ctx = (void**)context;
+    UA_Node *node = (UA_Node*)ctx[0];
+    const UA_NodeReferenceKind *rk = (const UA_NodeReferenceKind*)ctx[1];
+    UA_ExpandedNodeId en = UA_NodePointer_toExpandedNodeId(t->targetId);
+    UA_StatusCode res =
+        UA_Node_addReference(node, rk->referenceTypeIndex, !rk->isInverse,
+                             &en, t->targetNameHash);
+    if(res != UA_STATUSCODE_GOOD && res != UA_STATUSCODE_BADDUPLICATEREFERENCENOTALLOWED)
+        return (void*)(uintptr_t)0x01;
+    return NULL;
+}
+
+/* The node exists already (e.g. in namespace 0). Keep the attributes and the
+ * callbacks of the existing node. Only add the references from the snapshot
+ * that are missing. */
+static UA_StatusCode
+mergeReferences(UA_Server *server, const UA_Node *restored) {
+    UA_Node *node = UA_NODESTORE_GET_EDIT(server, &restored->head.nodeId);
+    if(!node)
+        return UA_STATUSCODE_BADNODEIDUNKNOWN;
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    for(size_t i = 0; i < restored->head.referencesSize; i++) {
+        UA_NodeReferenceKind *rk = &restored->head.references[i];
+        void *ctx[2] = {node, rk};
+        if(UA_NodeReferenceKind_iterate(rk, mergeReferenceTarget, ctx)) {
+            res = UA_STATUSCODE_BADOUTOFMEMORY;
+            break;
+        }
+    }
+    UA_StatusCode releaseRes = UA_NODESTORE_RELEASE_EDIT(server, node);
+    return (res != UA_STATUSCODE_GOOD) ? res : releaseRes;
+}
+
+UA_StatusCode
+UA_AddressSpaceSnapshot_decodeHeader(const UA_ByteString *snapshot, size_t *offset,
+                                     size_t *namespacesSize, UA_String **namespaces) {
+    SnapshotReader r;
+    memset(&r, 0, sizeof(SnapshotReader));
+    r.buf = snapshot;
+    r.offset = *offset;
+    if(readUInt32(&r) != UA_SNAPSHOT_MAGIC || readUInt32(&r) != UA_SNAPSHOT_VERSION)
+        return UA_STATUSCODE_BADDECODINGERROR;
+
+    UA_UInt32 nsSize = readUInt32(&r);
+    if(r.res != UA_STATUSCODE_GOOD)
+        return r.res;
+    if(nsSize > snapshot->length - r.offset)
+        return UA_STATUSCODE_BADDECODINGERROR;
+    UA_String *ns = (UA_String*)UA_Array_new(nsSize, &UA_TYPES[UA_TYPES_STRING]);
+    if(!ns && nsSize > 0)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    for(UA_UInt32 i = 0; i < nsSize; i++)
+        readValue(&r, &ns[i], &UA_TYPES[UA_TYPES_STRING]);
+    if(r.res != UA_STATUSCODE_GOOD) {
+        UA_Array_delete(ns, nsSize, &UA_TYPES[UA_TYPES_STRING]);
+        return r.res;
+    }
+
+    *offset = r.offset;
+    *namespaces = ns;
+    *namespacesSize = nsSize;
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_AddressSpaceSnapshot_decodeNode(const UA_ByteString *snapshot, size_t *offset,
+                                   const UA_Nodestore *ns,
+                                   const UA_DataTypeArray *customTypes,
+                                   UA_Node **outNode) {
+    SnapshotReader r;
+    memset(&r, 0, sizeof(SnapshotReader));
+    r.ns = ns;
+    r.buf = snapshot;
+    r.offset = *offset;
+    r.opts.customTypes = customTypes;
+    *outNode = decodeNode(&r);
+    if(r.res == UA_STATUSCODE_GOOD)
+        *offset = r.offset;
+    return r.res;
+}
+
+/* The NamespaceIndex in the nodes must map to the same URI */
+static UA_StatusCode
+loadNamespaces(UA_Server *server, size_t nsSize, const UA_String *ns) {
+    for(size_t i = 0; i < nsSize; i++) {
+        if(i < server->namespacesSize) {
+            if(!UA_String_equal(&ns[i], &server->namespaces[i]))
+                return UA_STATUSCODE_BADINVALIDSTATE;
+        } else if(addNamespace(server, ns[i]) != i) {
+            return UA_STATUSCODE_BADINVALIDSTATE;
+        }
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_Server_loadAddressSpaceSnapshot(UA_Server *server, const UA_ByteString *snapshot) {
+    size_t offset = 0;
+    size_t nsSize = 0;
+    UA_String *ns = NULL;
+    UA_StatusCode res =
+        UA_AddressSpaceSnapshot_decodeHeader(snapshot, &offset, &nsSize, &ns);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    UA_LOCK(&server->serviceMutex);
+    setupNs1Uri(server);
+    res = loadNamespaces(server, nsSize, ns);
+    UA_Array_delete(ns, nsSize, &UA_TYPES[UA_TYPES_STRING]);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_UNLOCK(&server->serviceMutex);
+        return res;
+    }
+
+    /* Remember the new ReferenceTypes to update the subtype hierarchy */
+    UA_NodeId *newRefTypes = NULL;
+    size_t newRefTypesSize = 0;
+
+    UA_Node *node;
+    while(true) {
+        res = UA_AddressSpaceSnapshot_decodeNode(snapshot, &offset,
+                                                 &server->config.nodestore,
+                                                 server->config.customDataTypes,
+                                                 &node);
+        if(res != UA_STATUSCODE_GOOD || !node)
+            break;
+
+        UA_NodeId id = node->head.nodeId;
+        const UA_Node *existing = UA_NODESTORE_GET(server, &id);
+        if(existing) {
+            UA_NODESTORE_RELEASE(server, existing);
+            res = mergeReferences(server, node);
+            UA_NODESTORE_DELETE(server, node);
+            if(res != UA_STATUSCODE_GOOD)
+                break;
+            continue;
+        }
+
+        /* Insert without the type checks of the AddNodes service */
+        UA_Boolean isRefType = (node->head.nodeClass == UA_NODECLASS_REFERENCETYPE);
+        if(isRefType) {
+            res = UA_Array_appendCopy((void**)&newRefTypes, &newRefTypesSize,
+                                      &id, &UA_TYPES[UA_TYPES_NODEID]);
+            if(res != UA_STATUSCODE_GOOD) {
+                UA_NODESTORE_DELETE(server, node);
+                break;
+            }
+        }
+        res = UA_NODESTORE_INSERT(server, node, NULL);
+        if(res != UA_STATUSCODE_GOOD)
+            break;
+    }
+
+    /* Add the new ReferenceTypes to the subtype sets of their supertypes */
+    for(size_t i = 0; i < newRefTypesSize && res == UA_STATUSCODE_GOOD; i++) {
+        const UA_Node *refType = UA_NODESTORE_GET(server, &newRefTypes[i]);
+        if(!refType)
+            continue;
+        res = setReferenceTypeSubtypes(server, &refType->referenceTypeNode);
+        UA_NODESTORE_RELEASE(server, refType);
+    }
+    UA_Array_delete(newRefTypes, newRefTypesSize, &UA_TYPES[UA_TYPES_NODEID]);
+
+    /* The restored nodes bring their HasSubtype references along */
+    invalidateTypeHierarchy(server);
+
+    UA_UNLOCK(&server->serviceMutex);
+    return res;
+}
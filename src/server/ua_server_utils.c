@@ -12,6 +12,14 @@
 
 #include "ua_server_internal.h"
 
+#include "mp_printf.h"
+
+#if defined(__linux__)
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#endif
+
 const UA_DataType *
 UA_Server_findDataType(UA_Server *server, const UA_NodeId *typeId) {
     return UA_findDataTypeWithCustom(typeId, server->config.customDataTypes);
@@ -266,6 +274,66 @@ getAllInterfaceChildNodeIds(UA_Server *server, const UA_NodeId *objectNode,
     return UA_STATUSCODE_GOOD;
 }
 
+#if defined(__linux__)
+/* Add the CPUs of a NUMA node to the set. The sysfs cpulist has the format
+ * "0-3,8-11". */
+static UA_Boolean
+addNumaNodeCpus(cpu_set_t *set, UA_UInt32 node) {
+    char path[64];
+    mp_snprintf(path, sizeof(path),
+                "/sys/devices/system/node/node%u/cpulist", (unsigned)node);
+    FILE *f = fopen(path, "r");
+    if(!f)
+        return false;
+    char line[1024];
+    char *res = fgets(line, sizeof(line), f);
+    fclose(f);
+    if(!res)
+        return false;
+
+    char *pos = line;
+    while(*pos >= '0' && *pos <= '9') {
+        unsigned long first = strtoul(pos, &pos, 10);
+        unsigned long last = first;
+        if(*pos == '-')
+            last = strtoul(pos + 1, &pos, 10);
+        for(unsigned long cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++)
+            CPU_SET(cpu, set);
+        if(*pos != ',')
+            break;
+        pos++;
+    }
+    return true;
+}
+#endif
+
+void
+applyThreadPlacement(UA_Server *server, const UA_ThreadPlacement *tp,
+                     const char *role) {
+    if(tp->cpusSize == 0 && tp->numaNodesSize == 0)
+        return;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for(size_t i = 0; i < tp->cpusSize; i++) {
+        if(tp->cpus[i] < CPU_SETSIZE)
+            CPU_SET(tp->cpus[i], &set);
+    }
+    for(size_t i = 0; i < tp->numaNodesSize; i++) {
+        if(!addNumaNodeCpus(&set, tp->numaNodes[i]))
+            UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
+                           "Unknown NUMA node %u for the placement of the %s",
+                           (unsigned)tp->numaNodes[i], role);
+    }
+    if(CPU_COUNT(&set) == 0 || sched_setaffinity(0, sizeof(cpu_set_t), &set) != 0)
+        UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
+                       "Could not pin the %s to the configured CPUs", role);
+#else
+    UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
+                   "Thread placement for the %s is only supported on Linux", role);
+#endif
+}
+
 /* Get the node, make the changes and release */
 UA_StatusCode
 UA_Server_editNode(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId,
@@ -277,9 +345,11 @@ UA_Server_editNode(UA_Server *server, UA_Session *session, const UA_NodeId *node
                                         references, referenceDirections);
     if(!node)
         return UA_STATUSCODE_BADNODEIDUNKNOWN;
+    UA_MemoryCategory mc = UA_MemoryCategory_enter(UA_MEMORYCATEGORY_NODESTORE);
     UA_StatusCode retval = callback(server, session, node, data);
-    UA_NODESTORE_RELEASE(server, node);
-    return retval;
+    UA_StatusCode releaseRes = UA_NODESTORE_RELEASE_EDIT(server, node);
+    UA_MemoryCategory_leave(mc);
+    return (retval != UA_STATUSCODE_GOOD) ? retval : releaseRes;
 }
 
 UA_StatusCode
@@ -311,6 +381,79 @@ UA_Server_processServiceOperations(UA_Server *server, UA_Session *session,
     return UA_STATUSCODE_GOOD;
 }
 
+#define UA_SERVICEOPERATIONS_BATCHSIZE 64
+
+UA_StatusCode
+UA_Server_processServiceOperationsWithNodes(UA_Server *server, UA_Session *session,
+                                            UA_ServiceOperation operationCallback,
+                                            UA_ServiceOperationWithNode nodeCallback,
+                                            const void *context,
+                                            const size_t *requestOperations,
+                                            const UA_DataType *requestOperationsType,
+                                            size_t nodeIdOffset,
+                                            size_t *responseOperations,
+                                            const UA_DataType *responseOperationsType) {
+    UA_Nodestore *ns = &server->config.nodestore;
+    size_t ops = *requestOperations;
+    if(!ns->getNodes || ops < 2)
+        return UA_Server_processServiceOperations(server, session, operationCallback,
+                                                  context, requestOperations,
+                                                  requestOperationsType,
+                                                  responseOperations,
+                                                  responseOperationsType);
+
+    /* No padding after size_t */
+    void **respPos = (void**)((uintptr_t)responseOperations + sizeof(size_t));
+    *respPos = UA_Array_new(ops, responseOperationsType);
+    if(!(*respPos))
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    *responseOperations = ops;
+    uintptr_t respOp = (uintptr_t)*respPos;
+    /* No padding after size_t */
+    uintptr_t reqOp = *(uintptr_t*)((uintptr_t)requestOperations + sizeof(size_t));
+
+    const UA_NodeId *ids[UA_SERVICEOPERATIONS_BATCHSIZE];
+    const UA_Node *nodes[UA_SERVICEOPERATIONS_BATCHSIZE];
+    size_t resolved = 0; /* Index of the first operation without node */
+    size_t next = 0; /* Position of the node for the current operation */
+    UA_UInt32 changes = 0;
+    for(size_t i = 0; i < ops; i++) {
+        /* Callbacks of an operation (e.g. the value source) modified the
+         * nodestore. Resolve the remaining nodes again. */
+        if(i < resolved && changes != server->nodestoreChanges) {
+            for(size_t j = next; j < resolved - i + next; j++) {
+                if(nodes[j])
+                    UA_NODESTORE_RELEASE(server, nodes[j]);
+            }
+            resolved = i;
+        }
+
+        /* Resolve the nodes of the next batch */
+        if(resolved == i) {
+            size_t n = ops - i;
+            if(n > UA_SERVICEOPERATIONS_BATCHSIZE)
+                n = UA_SERVICEOPERATIONS_BATCHSIZE;
+            for(size_t j = 0; j < n; j++)
+                ids[j] = (const UA_NodeId*)(reqOp + (j * requestOperationsType->memSize) +
+                                            nodeIdOffset);
+            ns->getNodes(ns->context, n, ids, UA_NODEATTRIBUTESMASK_ALL,
+                         UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH, nodes);
+            resolved = i + n;
+            next = 0;
+            changes = server->nodestoreChanges;
+        }
+
+        nodeCallback(server, session, context, (void*)reqOp, nodes[next], (void*)respOp);
+        if(nodes[next])
+            UA_NODESTORE_RELEASE(server, nodes[next]);
+        next++;
+        reqOp += requestOperationsType->memSize;
+        respOp += responseOperationsType->memSize;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
 /* A few global NodeId definitions */
 const UA_NodeId subtypeId = {0, UA_NODEIDTYPE_NUMERIC, {UA_NS0ID_HASSUBTYPE}};
 const UA_NodeId hierarchicalReferences = {0, UA_NODEIDTYPE_NUMERIC, {UA_NS0ID_HIERARCHICALREFERENCES}};
@@ -160,6 +160,9 @@ UA_ServiceDescription serviceDescriptions[] = {
     {0, UA_SERVICECOUNTER_OFFSET_NONE(false), NULL, NULL, NULL}
 };
 
+const size_t serviceDescriptionsSize =
+    (sizeof(serviceDescriptions) / sizeof(UA_ServiceDescription)) - 1;
+
 UA_ServiceDescription *
 getServiceDescription(UA_UInt32 requestTypeId) {
     for(size_t i = 0; serviceDescriptions[i].requestTypeId > 0; i++) {
@@ -272,11 +275,125 @@ processServiceInternal(UA_Server *server, UA_SecureChannel *channel, UA_Session
     }
 #endif
 
+    /* Read and write requests take the async path only if there are async
+     * variables */
+#if UA_MULTITHREADING >= 100
+    if(server->asyncManager.asyncVariablesCount > 0) {
+        UA_Boolean finished = true;
+        if(sd->requestType == &UA_TYPES[UA_TYPES_READREQUEST]) {
+            Service_ReadAsync(server, session, requestId, &request->readRequest,
+                              &response->readResponse, &finished);
+            return !finished;
+        }
+        if(sd->requestType == &UA_TYPES[UA_TYPES_WRITEREQUEST]) {
+            Service_WriteAsync(server, session, requestId, &request->writeRequest,
+                               &response->writeResponse, &finished);
+            return !finished;
+        }
+    }
+#endif
+
     /* Execute the synchronous service call */
     sd->serviceCallback(server, session, request, response);
     return false;
 }
 
+#ifdef UA_ENABLE_DIAGNOSTICS
+
+/* The number of operations is the length of the first array in the request.
+ * The request types have no optional members. */
+static size_t
+countOperations(const UA_DataType *requestType, const UA_Request *request) {
+    uintptr_t ptr = (uintptr_t)request;
+    for(size_t i = 0; i < requestType->membersSize; i++) {
+        const UA_DataTypeMember *m = &requestType->members[i];
+        ptr += m->padding;
+        if(m->isArray)
+            return *(size_t*)ptr;
+        ptr += m->memberType->memSize;
+    }
+    return 1;
+}
+
+static void
+recordServiceStats(UA_ServiceStats *ss, UA_StatusCode serviceResult,
+                   size_t operations, UA_Boolean async, size_t queueDepth,
+                   UA_DateTime latency) {
+    ss->requestCount++;
+    if(serviceResult != UA_STATUSCODE_GOOD)
+        ss->errorCount++;
+    ss->operationCount += operations;
+    if(async) {
+        ss->asyncCount++;
+        if(queueDepth > ss->queueDepthHighWaterMark)
+            ss->queueDepthHighWaterMark = queueDepth;
+        return;
+    }
+    UA_LatencyHistogram_record(&ss->latency, (latency > 0) ? (u64)latency : 0);
+}
+
+static void
+updateServiceStats(UA_Server *server, UA_Session *session,
+                   const UA_ServiceDescription *sd, const UA_Request *request,
+                   const UA_Response *response, UA_Boolean async,
+                   UA_DateTime latency) {
+    /* The depth of the queue where the request waits for its response */
+    size_t queueDepth = 0;
+    if(async) {
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+        if(sd->requestType == &UA_TYPES[UA_TYPES_PUBLISHREQUEST] && session)
+            queueDepth = session->responseQueueSize;
+#endif
+#if UA_MULTITHREADING >= 100
+        if(sd->requestType != &UA_TYPES[UA_TYPES_PUBLISHREQUEST])
+            queueDepth = server->asyncManager.asyncResponsesCount;
+#endif
+    }
+
+    UA_StatusCode serviceResult = response->responseHeader.serviceResult;
+    size_t operations = countOperations(sd->requestType, request);
+    if(server->serviceStats) {
+        UA_ServiceStats *ss = &server->serviceStats[sd - serviceDescriptions];
+        recordServiceStats(ss, serviceResult, operations, async, queueDepth, latency);
+    }
+    if(session)
+        recordServiceStats(&session->serviceStats, serviceResult, operations,
+                           async, queueDepth, latency);
+}
+
+#endif /* UA_ENABLE_DIAGNOSTICS */
+
+/* Memory category for the allocations during the service */
+static UA_MemoryCategory
+serviceMemoryCategory(const UA_ServiceDescription *sd) {
+    switch(sd->requestTypeId) {
+    case UA_NS0ID_CREATESUBSCRIPTIONREQUEST_ENCODING_DEFAULTBINARY:
+    case UA_NS0ID_MODIFYSUBSCRIPTIONREQUEST_ENCODING_DEFAULTBINARY:
+    case UA_NS0ID_SETPUBLISHINGMODEREQUEST_ENCODING_DEFAULTBINARY:
+    case UA_NS0ID_PUBLISHREQUEST_ENCODING_DEFAULTBINARY:
+    case UA_NS0ID_REPUBLISHREQUEST_ENCODING_DEFAULTBINARY:
+    case UA_NS0ID_TRANSFERSUBSCRIPTIONSREQUEST_ENCODING_DEFAULTBINARY:
+    case UA_NS0ID_DELETESUBSCRIPTIONSREQUEST_ENCODING_DEFAULTBINARY:
+        return UA_MEMORYCATEGORY_SUBSCRIPTIONS;
+    case UA_NS0ID_CREATEMONITOREDITEMSREQUEST_ENCODING_DEFAULTBINARY:
+    case UA_NS0ID_MODIFYMONITOREDITEMSREQUEST_ENCODING_DEFAULTBINARY:
+    case UA_NS0ID_SETMONITORINGMODEREQUEST_ENCODING_DEFAULTBINARY:
+    case UA_NS0ID_SETTRIGGERINGREQUEST_ENCODING_DEFAULTBINARY:
+    case UA_NS0ID_DELETEMONITOREDITEMSREQUEST_ENCODING_DEFAULTBINARY:
+        return UA_MEMORYCATEGORY_MONITOREDITEMS;
+    case UA_NS0ID_CREATESESSIONREQUEST_ENCODING_DEFAULTBINARY:
+    case UA_NS0ID_ACTIVATESESSIONREQUEST_ENCODING_DEFAULTBINARY:
+        return UA_MEMORYCATEGORY_SESSIONS;
+    case UA_NS0ID_ADDNODESREQUEST_ENCODING_DEFAULTBINARY:
+    case UA_NS0ID_ADDREFERENCESREQUEST_ENCODING_DEFAULTBINARY:
+    case UA_NS0ID_DELETENODESREQUEST_ENCODING_DEFAULTBINARY:
+    case UA_NS0ID_DELETEREFERENCESREQUEST_ENCODING_DEFAULTBINARY:
+        return UA_MEMORYCATEGORY_NODESTORE;
+    default:
+        return UA_MEMORYCATEGORY_DEFAULT;
+    }
+}
+
 UA_Boolean
 UA_Server_processRequest(UA_Server *server, UA_SecureChannel *channel,
                          UA_UInt32 requestId, UA_ServiceDescription *sd,
@@ -306,21 +423,34 @@ UA_Server_processRequest(UA_Server *server, UA_SecureChannel *channel,
     response->responseHeader.serviceResult = UA_STATUSCODE_GOOD;
 
     /* Process the service */
+#ifdef UA_ENABLE_DIAGNOSTICS
+    UA_EventLoop *el = server->config.eventLoop;
+    UA_DateTime start = el->dateTime_nowMonotonic(el);
+#endif
+    UA_MemoryCategory mc = UA_MemoryCategory_enter(serviceMemoryCategory(sd));
     UA_Boolean async =
         processServiceInternal(server, channel, session, requestId, sd, request, response);
+    UA_MemoryCategory_leave(mc);
 
     /* Update the service statistics */
 #ifdef UA_ENABLE_DIAGNOSTICS
+    updateServiceStats(server, session, sd, request, response, async,
+                       el->dateTime_nowMonotonic(el) - start);
     if(session) {
-        session->diagnostics.totalRequestCount.totalCount++;
-        if(response->responseHeader.serviceResult != UA_STATUSCODE_GOOD)
-            session->diagnostics.totalRequestCount.errorCount++;
-        if(sd->counterOffset != 0) {
-            UA_ServiceCounterDataType *serviceCounter = (UA_ServiceCounterDataType*)
-                (((uintptr_t)&session->diagnostics) + sd->counterOffset);
+        if(UA_UNLIKELY(!session->serviceCounters))
+            session->serviceCounters = (UA_ServiceCounterDataType*)
+                UA_calloc(serviceDescriptionsSize + 1, sizeof(UA_ServiceCounterDataType));
+        if(session->serviceCounters) {
+            UA_ServiceCounterDataType *total =
+                &session->serviceCounters[serviceDescriptionsSize];
+            UA_ServiceCounterDataType *serviceCounter =
+                &session->serviceCounters[sd - serviceDescriptions];
+            total->totalCount++;
             serviceCounter->totalCount++;
-            if(response->responseHeader.serviceResult != UA_STATUSCODE_GOOD)
+            if(response->responseHeader.serviceResult != UA_STATUSCODE_GOOD) {
+                total->errorCount++;
                 serviceCounter->errorCount++;
+            }
         }
     }
 #endif
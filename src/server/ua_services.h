@@ -37,6 +37,11 @@ typedef struct {
     const UA_DataType *responseType;
 } UA_ServiceDescription;
 
+/* The table of all services. Terminated by an entry with requestTypeId 0. The
+ * server-wide service statistics use the same indices. */
+extern UA_ServiceDescription serviceDescriptions[];
+extern const size_t serviceDescriptionsSize;
+
 /* Returns NULL if none found */
 UA_ServiceDescription * getServiceDescription(UA_UInt32 requestTypeId);
 
@@ -142,6 +147,16 @@ void Service_Write(UA_Server *server, UA_Session *session,
                    const UA_WriteRequest *request,
                    UA_WriteResponse *response);
 
+#if UA_MULTITHREADING >= 100
+void Service_ReadAsync(UA_Server *server, UA_Session *session, UA_UInt32 requestId,
+                       const UA_ReadRequest *request, UA_ReadResponse *response,
+                       UA_Boolean *finished);
+
+void Service_WriteAsync(UA_Server *server, UA_Session *session, UA_UInt32 requestId,
+                        const UA_WriteRequest *request, UA_WriteResponse *response,
+                        UA_Boolean *finished);
+#endif
+
 #ifdef UA_ENABLE_HISTORIZING
 void Service_HistoryRead(UA_Server *server, UA_Session *session,
                          const UA_HistoryReadRequest *request,
@@ -23,10 +23,64 @@
 #include "../ua_types_encoding_binary.h"
 #include "ua_services.h"
 
+#include <stdlib.h> /* qsort */
+
 #ifdef UA_ENABLE_HISTORIZING
 #include <open62541/plugin/historydatabase.h>
 #endif
 
+/* Large Read requests can be processed by parallel worker threads (see
+ * Service_ReadParallel). The workers run while the thread that processes the
+ * request holds the service lock. They don't release the lock around the
+ * access control callbacks. */
+#if UA_MULTITHREADING >= 200 && defined(UA_ARCHITECTURE_POSIX)
+#define UA_PARALLEL_READ
+#include <pthread.h>
+static UA_THREAD_LOCAL UA_Boolean parallelReadWorker = false;
+#define IN_PARALLEL_READ parallelReadWorker
+#else
+#define IN_PARALLEL_READ false
+#endif
+
+/* The local Read API holds the service lock in shared mode (see
+ * lockForRead). The lock is re-acquired after a callback in the mode it was
+ * held before. */
+static UA_Boolean
+unlockForCallback(UA_Server *server) {
+    if(IN_PARALLEL_READ)
+        return false;
+    UA_Boolean shared = UA_LOCK_ISSHARED(&server->serviceMutex);
+    UA_UNLOCK(&server->serviceMutex);
+    return shared;
+}
+
+static void
+lockAfterCallback(UA_Server *server, UA_Boolean shared) {
+    if(IN_PARALLEL_READ)
+        return;
+    if(shared) {
+        UA_LOCK_SHARED(&server->serviceMutex);
+    } else {
+        UA_LOCK(&server->serviceMutex);
+    }
+}
+
+#define UNLOCK_FOR_CALLBACK(server) \
+    UA_Boolean relockShared = unlockForCallback(server)
+#define LOCK_AFTER_CALLBACK(server) lockAfterCallback(server, relockShared)
+
+/* Readers share the service lock if the Nodestore can be accessed by several
+ * readers at the same time. The reference counting of the other Nodestores
+ * requires the exclusive lock. */
+static void
+lockForRead(UA_Server *server) {
+    if(server->config.nodestore.concurrentReads) {
+        UA_LOCK_SHARED(&server->serviceMutex);
+    } else {
+        UA_LOCK(&server->serviceMutex);
+    }
+}
+
 static const UA_NodeAttributesMask attr2mask[28] = {
     UA_NODEATTRIBUTESMASK_NODEID,
     UA_NODEATTRIBUTESMASK_NODECLASS,
@@ -71,6 +125,40 @@ attributeId2AttributeMask(UA_AttributeId id) {
 /* Session for read operations can be NULL. For example for a MonitoredItem
  * where the underlying Subscription was detached during CloseSession. */
 
+/* Returns the slot for the cached decisions on the node. The slot is reset if
+ * it holds another node or decisions from an earlier epoch. Returns NULL if
+ * the decisions are not cached. The cache is not part of the observable state
+ * of the Session. Hence the const-cast.
+ *
+ * The parallel Read workers share the Session of the request. They don't use
+ * the cache, as the slots are modified without synchronization. */
+static UA_AccessDecision *
+getAccessDecision(UA_Server *server, const UA_Session *session,
+                  const UA_NodeId *nodeId, UA_UInt32 epoch) {
+    const UA_AccessControl *ac = &server->config.accessControl;
+    if(!session || ac->decisionCacheSize == 0 || epoch != ac->decisionEpoch ||
+       IN_PARALLEL_READ)
+        return NULL;
+    UA_Session *s = (UA_Session*)(uintptr_t)session;
+    if(!s->decisionCache) {
+        s->decisionCache = (UA_AccessDecision*)
+            UA_calloc(ac->decisionCacheSize, sizeof(UA_AccessDecision));
+        if(!s->decisionCache)
+            return NULL;
+        s->decisionCacheSize = ac->decisionCacheSize;
+    }
+    UA_AccessDecision *d =
+        &s->decisionCache[UA_NodeId_hash(nodeId) % s->decisionCacheSize];
+    if(d->epoch == epoch && UA_NodeId_equal(&d->nodeId, nodeId))
+        return d;
+    UA_NodeId_clear(&d->nodeId);
+    d->valid = 0;
+    d->epoch = epoch;
+    if(UA_NodeId_copy(nodeId, &d->nodeId) != UA_STATUSCODE_GOOD)
+        return NULL;
+    return d;
+}
+
 static UA_UInt32
 getUserWriteMask(UA_Server *server, const UA_Session *session,
                  const UA_NodeHead *head) {
@@ -78,14 +166,26 @@ getUserWriteMask(UA_Server *server, const UA_Session *session,
         return 0xFFFFFFFF; /* the local admin user has all rights */
     UA_UInt32 mask = head->writeMask;
     UA_LOCK_ASSERT(&server->serviceMutex);
-    UA_UNLOCK(&server->serviceMutex);
-    mask &= server->config.accessControl.
+    UA_UInt32 epoch = server->config.accessControl.decisionEpoch;
+    UA_AccessDecision *d = getAccessDecision(server, session, &head->nodeId, epoch);
+    if(!checkRolePermission(server, session, head, UA_ROLEPERMISSION_WRITE))
+        return 0;
+    if(d && (d->valid & UA_ACCESSDECISION_RIGHTSMASK))
+        return mask & d->userRightsMask;
+    UNLOCK_FOR_CALLBACK(server);
+    UA_UInt32 rights = server->config.accessControl.
         getUserRightsMask(server, &server->config.accessControl,
                           session ? &session->sessionId : NULL,
                           session ? session->context : NULL,
                           &head->nodeId, head->context);
-    UA_LOCK(&server->serviceMutex);
-    return mask;
+    LOCK_AFTER_CALLBACK(server);
+    /* Look up the slot again. It may have been reused without the lock. */
+    d = getAccessDecision(server, session, &head->nodeId, epoch);
+    if(d) {
+        d->userRightsMask = rights;
+        d->valid |= UA_ACCESSDECISION_RIGHTSMASK;
+    }
+    return mask & rights;
 }
 
 static UA_Byte
@@ -95,14 +195,27 @@ getUserAccessLevel(UA_Server *server, const UA_Session *session,
         return 0xFF; /* the local admin user has all rights */
     UA_Byte retval = node->accessLevel;
     UA_LOCK_ASSERT(&server->serviceMutex);
-    UA_UNLOCK(&server->serviceMutex);
-    retval &= server->config.accessControl.
+    UA_UInt32 epoch = server->config.accessControl.decisionEpoch;
+    UA_AccessDecision *d = getAccessDecision(server, session, &node->head.nodeId, epoch);
+    if(!checkRolePermission(server, session, &node->head, UA_ROLEPERMISSION_READ))
+        retval &= (UA_Byte)~(UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_HISTORYREAD);
+    if(!checkRolePermission(server, session, &node->head, UA_ROLEPERMISSION_WRITE))
+        retval &= (UA_Byte)~(UA_ACCESSLEVELMASK_WRITE | UA_ACCESSLEVELMASK_HISTORYWRITE);
+    if(d && (d->valid & UA_ACCESSDECISION_ACCESSLEVEL))
+        return retval & d->userAccessLevel;
+    UNLOCK_FOR_CALLBACK(server);
+    UA_Byte userAccessLevel = server->config.accessControl.
         getUserAccessLevel(server, &server->config.accessControl,
                            session ? &session->sessionId : NULL,
                            session ? session->context : NULL,
                            &node->head.nodeId, node->head.context);
-    UA_LOCK(&server->serviceMutex);
-    return retval;
+    LOCK_AFTER_CALLBACK(server);
+    d = getAccessDecision(server, session, &node->head.nodeId, epoch);
+    if(d) {
+        d->userAccessLevel = userAccessLevel;
+        d->valid |= UA_ACCESSDECISION_ACCESSLEVEL;
+    }
+    return retval & userAccessLevel;
 }
 
 static UA_Boolean
@@ -111,16 +224,26 @@ getUserExecutable(UA_Server *server, const UA_Session *session,
     if(session == &server->adminSession)
         return true; /* the local admin user has all rights */
     UA_LOCK_ASSERT(&server->serviceMutex);
-    UA_UNLOCK(&server->serviceMutex);
-    UA_Boolean userExecutable = node->executable;
-    userExecutable &=
+    UA_UInt32 epoch = server->config.accessControl.decisionEpoch;
+    UA_AccessDecision *d = getAccessDecision(server, session, &node->head.nodeId, epoch);
+    if(!checkRolePermission(server, session, &node->head, UA_ROLEPERMISSION_CALL))
+        return false;
+    if(d && (d->valid & UA_ACCESSDECISION_EXECUTABLE))
+        return node->executable & d->userExecutable;
+    UNLOCK_FOR_CALLBACK(server);
+    UA_Boolean userExecutable =
         server->config.accessControl.
         getUserExecutable(server, &server->config.accessControl,
                           session ? &session->sessionId : NULL,
                           session ? session->context : NULL,
                           &node->head.nodeId, node->head.context);
-    UA_LOCK(&server->serviceMutex);
-    return userExecutable;
+    LOCK_AFTER_CALLBACK(server);
+    d = getAccessDecision(server, session, &node->head.nodeId, epoch);
+    if(d) {
+        d->userExecutable = userExecutable;
+        d->valid |= UA_ACCESSDECISION_EXECUTABLE;
+    }
+    return node->executable & userExecutable;
 }
 
 /****************/
@@ -150,20 +273,70 @@ readIsAbstractAttribute(const UA_Node *node, UA_Variant *v) {
     return UA_Variant_setScalarCopy(v, isAbstract, &UA_TYPES[UA_TYPES_BOOLEAN]);
 }
 
+/* Keep a reference to the node until the response to the Read request that is
+ * currently processed was encoded (see processMSG). Then the response can point
+ * into the node instead of holding a copy of the value. */
+static UA_Boolean
+pinNode(UA_Server *server, UA_SecureChannel *channel, const UA_Node *node) {
+    if(channel->pinnedNodesSize == channel->pinnedNodesCapacity) {
+        size_t cap = (channel->pinnedNodesCapacity > 0) ?
+            channel->pinnedNodesCapacity * 2 : 16;
+        const void **pinned = (const void**)
+            UA_realloc((void*)channel->pinnedNodes, cap * sizeof(void*));
+        if(!pinned)
+            return false;
+        channel->pinnedNodes = pinned;
+        channel->pinnedNodesCapacity = cap;
+    }
+    channel->pinnedNodes[channel->pinnedNodesSize++] = node;
+    server->pinnedNodesCount++;
+    return true;
+}
+
+void
+releasePinnedNodes(UA_Server *server, UA_SecureChannel *channel) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+    for(size_t i = 0; i < channel->pinnedNodesSize; i++)
+        UA_NODESTORE_RELEASE(server, (const UA_Node*)channel->pinnedNodes[i]);
+    UA_assert(server->pinnedNodesCount >= channel->pinnedNodesSize);
+    server->pinnedNodesCount -= channel->pinnedNodesSize;
+    channel->pinnedNodesSize = 0;
+    if(server->pinnedNodesCount > 0 || server->retiredValuesSize == 0)
+        return;
+    UA_Array_delete(server->retiredValues, server->retiredValuesSize,
+                    &UA_TYPES[UA_TYPES_DATAVALUE]);
+    server->retiredValues = NULL;
+    server->retiredValuesSize = 0;
+}
+
 static UA_StatusCode
 readValueAttributeFromNode(UA_Server *server, UA_Session *session,
                            const UA_VariableNode *vn, UA_DataValue *v,
                            UA_NumericRange *rangeptr) {
     UA_LOCK_ASSERT(&server->serviceMutex);
+
+    /* Pinning is only enabled while a Read request from the SecureChannel is
+     * processed. Otherwise the value has to be copied. */
+    UA_SecureChannel *channel = (session) ? session->channel : NULL;
+    UA_Boolean pin = (!rangeptr && channel && channel->pinNodes &&
+                      !IN_PARALLEL_READ);
+
     /* Update the value by the user callback */
+    UA_Boolean owned = false;
     if(vn->value.data.callback.onRead) {
-        UA_UNLOCK(&server->serviceMutex);
+        UNLOCK_FOR_CALLBACK(server);
         vn->value.data.callback.onRead(server,
                                        session ? &session->sessionId : NULL,
                                        session ? session->context : NULL,
                                        &vn->head.nodeId, vn->head.context, rangeptr,
                                        &vn->value.data.value);
-        UA_LOCK(&server->serviceMutex);
+        LOCK_AFTER_CALLBACK(server);
+        owned = true;
+    }
+
+    /* Get an own reference to the node. Either to see the value updated by the
+     * callback or to pin the node for the response. */
+    if(owned || pin) {
         vn = (const UA_VariableNode*)
             UA_NODESTORE_GET_SELECTIVE(server, &vn->head.nodeId,
                                        UA_NODEATTRIBUTESMASK_VALUE,
@@ -171,6 +344,15 @@ readValueAttributeFromNode(UA_Server *server, UA_Session *session,
                                        UA_BROWSEDIRECTION_INVALID);
         if(!vn)
             return UA_STATUSCODE_BADNODEIDUNKNOWN;
+        owned = true;
+    }
+
+    /* Point into the pinned node. The response is encoded before the node is
+     * released. */
+    if(pin && pinNode(server, channel, (const UA_Node*)vn)) {
+        *v = vn->value.data.value;
+        v->value.storageType = UA_VARIANT_DATA_NODELETE;
+        return UA_STATUSCODE_GOOD;
     }
 
     /* Set the result */
@@ -184,7 +366,7 @@ readValueAttributeFromNode(UA_Server *server, UA_Session *session,
     }
 
     /* Clean up */
-    if(vn->value.data.callback.onRead)
+    if(owned)
         UA_NODESTORE_RELEASE(server, (const UA_Node *)vn);
     return retval;
 }
@@ -201,14 +383,14 @@ readValueAttributeFromDataSource(UA_Server *server, UA_Session *session,
                                   timestamps == UA_TIMESTAMPSTORETURN_BOTH);
     UA_DataValue v2;
     UA_DataValue_init(&v2);
-    UA_UNLOCK(&server->serviceMutex);
+    UNLOCK_FOR_CALLBACK(server);
     UA_StatusCode retval = vn->value.dataSource.
         read(server,
              session ? &session->sessionId : NULL,
              session ? session->context : NULL,
              &vn->head.nodeId, vn->head.context,
              sourceTimeStamp, rangeptr, &v2);
-    UA_LOCK(&server->serviceMutex);
+    LOCK_AFTER_CALLBACK(server);
     if(v2.hasValue && v2.value.storageType == UA_VARIANT_DATA_NODELETE) {
         retval = UA_DataValue_copy(&v2, v);
         UA_DataValue_clear(&v2);
@@ -218,6 +400,63 @@ readValueAttributeFromDataSource(UA_Server *server, UA_Session *session,
     return retval;
 }
 
+/* Variant that points into the memory region of the value backend */
+static void
+wrapMemoryValue(const UA_VariableNode *vn, UA_Variant *v) {
+    UA_Variant_init(v);
+    v->type = vn->valueBackend.backend.memory.type;
+    v->data = vn->valueBackend.backend.memory.data;
+    v->arrayLength = vn->valueBackend.backend.memory.arrayLength;
+    v->storageType = UA_VARIANT_DATA_NODELETE;
+}
+
+#define UA_MEMORYBACKEND_READRETRIES 64
+
+static UA_StatusCode
+readValueAttributeFromMemory(UA_Server *server, UA_Session *session,
+                             const UA_VariableNode *vn, UA_DataValue *v,
+                             UA_NumericRange *rangeptr) {
+    volatile size_t *seqlock = vn->valueBackend.backend.memory.seqlock;
+    UA_Variant mem;
+    wrapMemoryValue(vn, &mem);
+
+    /* Without a seqlock, the response of a Read request points into the
+     * region. The node is pinned until the response is encoded. */
+    UA_SecureChannel *channel = (session) ? session->channel : NULL;
+    if(!seqlock && !rangeptr && channel && channel->pinNodes && !IN_PARALLEL_READ) {
+        const UA_Node *pinned =
+            UA_NODESTORE_GET_SELECTIVE(server, &vn->head.nodeId,
+                                       UA_NODEATTRIBUTESMASK_VALUE,
+                                       UA_REFERENCETYPESET_NONE,
+                                       UA_BROWSEDIRECTION_INVALID);
+        if(pinned && pinNode(server, channel, pinned)) {
+            v->value = mem;
+            v->hasValue = true;
+            return UA_STATUSCODE_GOOD;
+        }
+        if(pinned)
+            UA_NODESTORE_RELEASE(server, pinned);
+    }
+
+    /* Copy the region. Retry if a write was ongoing. */
+    for(size_t i = 0; i < UA_MEMORYBACKEND_READRETRIES; i++) {
+        size_t seq = (seqlock) ? UA_atomic_addSize(seqlock, 0) : 0;
+        if(seq & 1)
+            continue;
+        UA_StatusCode res = (rangeptr) ?
+            UA_Variant_copyRange(&mem, &v->value, *rangeptr) :
+            UA_Variant_copy(&mem, &v->value);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+        if(!seqlock || UA_atomic_addSize(seqlock, 0) == seq) {
+            v->hasValue = true;
+            return UA_STATUSCODE_GOOD;
+        }
+        UA_Variant_clear(&v->value);
+    }
+    return UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+}
+
 static UA_StatusCode
 readValueAttributeComplete(UA_Server *server, UA_Session *session,
                            const UA_VariableNode *vn, UA_TimestampsToReturn timestamps,
@@ -225,11 +464,13 @@ readValueAttributeComplete(UA_Server *server, UA_Session *session,
     UA_EventLoop *el = server->config.eventLoop;
 
     /* Compute the index range */
+    UA_NumericRangeDimension rangeBuf[UA_NUMERICRANGE_BUFDIMS];
     UA_NumericRange range;
     UA_NumericRange *rangeptr = NULL;
     UA_StatusCode retval = UA_STATUSCODE_GOOD;
     if(indexRange && indexRange->length > 0) {
-        retval = UA_NumericRange_parse(&range, *indexRange);
+        retval = UA_NumericRange_parseInto(&range, rangeBuf,
+                                           UA_NUMERICRANGE_BUFDIMS, *indexRange);
         if(retval != UA_STATUSCODE_GOOD)
             return retval;
         rangeptr = &range;
@@ -265,6 +506,9 @@ readValueAttributeComplete(UA_Server *server, UA_Session *session,
             else
                 retval = UA_DataValue_copy(*vn->valueBackend.backend.external.value, v);
             break;
+        case UA_VALUEBACKENDTYPE_MEMORY:
+            retval = readValueAttributeFromMemory(server, session, vn, v, rangeptr);
+            break;
         case UA_VALUEBACKENDTYPE_NONE:
             /* Read the value */
             if(vn->valueSource == UA_VALUESOURCE_DATA)
@@ -284,7 +528,7 @@ readValueAttributeComplete(UA_Server *server, UA_Session *session,
     }
 
     /* Clean up */
-    if(rangeptr)
+    if(rangeptr && range.dimensions != rangeBuf)
         UA_free(range.dimensions);
     return retval;
 }
@@ -372,6 +616,10 @@ getStructureDefinition(const UA_DataType *type, UA_StructureDefinition *def) {
 }
 #endif
 
+static void
+finishRead(UA_Server *server, UA_TimestampsToReturn timestampsToReturn,
+           UA_StatusCode retval, UA_DataValue *v);
+
 /* Returns a datavalue that may point into the node via the
  * UA_VARIANT_DATA_NODELETE tag. Don't access the returned DataValue once the
  * node has been released! */
@@ -402,6 +650,14 @@ ReadWithNode(const UA_Node *node, UA_Server *server, UA_Session *session,
         return;
     }
 
+    /* The Value is checked with the UserAccessLevel */
+    if(id->attributeId != UA_ATTRIBUTEID_VALUE &&
+       !checkRolePermission(server, session, &node->head, UA_ROLEPERMISSION_BROWSE)) {
+        v->hasStatus = true;
+        v->status = UA_STATUSCODE_BADUSERACCESSDENIED;
+        return;
+    }
+
     /* Read the attribute */
     UA_StatusCode retval = UA_STATUSCODE_GOOD;
     switch(id->attributeId) {
@@ -586,6 +842,13 @@ ReadWithNode(const UA_Node *node, UA_Server *server, UA_Session *session,
         retval = UA_STATUSCODE_BADATTRIBUTEIDINVALID;
     }
 
+    finishRead(server, timestampsToReturn, retval, v);
+}
+
+/* Set the status and the timestamps of the read result */
+static void
+finishRead(UA_Server *server, UA_TimestampsToReturn timestampsToReturn,
+           UA_StatusCode retval, UA_DataValue *v) {
     /* Reading has failed? */
     if(retval == UA_STATUSCODE_GOOD) {
         v->hasValue = true;
@@ -614,6 +877,285 @@ ReadWithNode(const UA_Node *node, UA_Server *server, UA_Session *session,
     }
 }
 
+/* The value is stored in the node and read without a callback */
+static UA_Boolean
+isInternalValue(const UA_VariableNode *vn) {
+    switch(vn->valueBackend.backendType) {
+    case UA_VALUEBACKENDTYPE_INTERNAL:
+        return !vn->value.data.callback.onRead;
+    case UA_VALUEBACKENDTYPE_NONE:
+        return (vn->valueSource == UA_VALUESOURCE_DATA &&
+                !vn->value.data.callback.onRead);
+    default:
+        return false;
+    }
+}
+
+void
+readShared(UA_Server *server, const UA_ReadValueId *rvi,
+           UA_TimestampsToReturn timestampsToReturn, size_t sessionsSize,
+           UA_Session **sessions, UA_DataValue *results) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+    const UA_Node *node =
+        UA_NODESTORE_GET_SELECTIVE(server, &rvi->nodeId,
+                                   attributeId2AttributeMask((UA_AttributeId)rvi->attributeId),
+                                   UA_REFERENCETYPESET_NONE,
+                                   UA_BROWSEDIRECTION_INVALID);
+
+    /* Only the value of a variable from the node itself is independent of
+     * the Session that reads it */
+    UA_Boolean shareable = (node && rvi->attributeId == UA_ATTRIBUTEID_VALUE &&
+                            node->head.nodeClass == UA_NODECLASS_VARIABLE &&
+                            isInternalValue(&node->variableNode));
+    size_t shared = sessionsSize; /* Index of the result to copy */
+    for(size_t i = 0; i < sessionsSize; i++) {
+        UA_Session *session = sessions[i];
+        UA_DataValue *dv = &results[i];
+        if(!session) {
+            dv->hasStatus = true;
+            dv->status = UA_STATUSCODE_BADUSERACCESSDENIED;
+            continue;
+        }
+        if(!node) {
+            dv->hasStatus = true;
+            dv->status = UA_STATUSCODE_BADNODEIDUNKNOWN;
+            continue;
+        }
+
+        /* Copy the value if the Session has the access rights */
+        if(shared < sessionsSize &&
+           (session == sessions[shared] ||
+            (getUserAccessLevel(server, session, &node->variableNode) &
+             UA_ACCESSLEVELMASK_READ))) {
+            if(UA_DataValue_copy(&results[shared], dv) == UA_STATUSCODE_GOOD)
+                continue;
+            UA_DataValue_clear(dv);
+        }
+
+        ReadWithNode(node, server, session, timestampsToReturn, rvi, dv);
+        if(shareable && shared == sessionsSize &&
+           !(dv->hasStatus && dv->status == UA_STATUSCODE_BADUSERACCESSDENIED))
+            shared = i;
+    }
+
+    if(node)
+        UA_NODESTORE_RELEASE(server, node);
+}
+
+/************************/
+/* DataSource Batch Read */
+/************************/
+
+/* The value comes from a DataSource that can be read in batches */
+static UA_Boolean
+isBatchDataSource(const UA_VariableNode *vn) {
+    if(!vn->readBatch)
+        return false;
+    if(vn->valueBackend.backendType == UA_VALUEBACKENDTYPE_DATA_SOURCE_CALLBACK)
+        return true;
+    return (vn->valueBackend.backendType == UA_VALUEBACKENDTYPE_NONE &&
+            vn->valueSource == UA_VALUESOURCE_DATASOURCE);
+}
+
+UA_Boolean
+deferDataSourceRead(UA_Server *server, UA_DataSourceBatch *batch,
+                    UA_Session *session, const UA_Node *node,
+                    const UA_ReadValueId *rvi,
+                    UA_TimestampsToReturn timestampsToReturn, UA_DataValue *v) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+
+    /* Only the value of variables with a batch DataSource is deferred. All
+     * other cases (also the errors) are handled by ReadWithNode. */
+    if(!server->dataSourceBatchRead || !session || !node ||
+       rvi->attributeId != UA_ATTRIBUTEID_VALUE ||
+       node->head.nodeClass != UA_NODECLASS_VARIABLE ||
+       !isBatchDataSource(&node->variableNode))
+        return false;
+    if(rvi->dataEncoding.name.length > 0 &&
+       !UA_String_equal(&binEncoding, &rvi->dataEncoding.name))
+        return false;
+    if(!(getUserAccessLevel(server, session, &node->variableNode) &
+         UA_ACCESSLEVELMASK_READ))
+        return false;
+
+    /* Grow the array of operations */
+    if(batch->opsSize == batch->opsCapacity) {
+        size_t cap = (batch->opsCapacity == 0) ? 16 : batch->opsCapacity * 2;
+        UA_DataSourceBatchOp *ops = (UA_DataSourceBatchOp*)
+            UA_realloc(batch->ops, cap * sizeof(UA_DataSourceBatchOp));
+        if(!ops)
+            return false;
+        batch->ops = ops;
+        batch->opsCapacity = cap;
+    }
+
+    UA_DataSourceBatchOp *op = &batch->ops[batch->opsSize];
+    memset(&op->range, 0, sizeof(UA_NumericRange));
+    if(rvi->indexRange.length > 0 &&
+       UA_NumericRange_parse(&op->range, rvi->indexRange) != UA_STATUSCODE_GOOD)
+        return false;
+    op->node = node;
+    op->session = session;
+    op->timestampsToReturn = timestampsToReturn;
+    op->value = v;
+    batch->opsSize++;
+    return true;
+}
+
+/* Sort the operations into batches with the same callback, device, session
+ * and source timestamp flag. Keep the order of the results within a batch. */
+static int
+cmpDataSourceBatchOp(const void *a, const void *b) {
+    const UA_DataSourceBatchOp *opA = (const UA_DataSourceBatchOp*)a;
+    const UA_DataSourceBatchOp *opB = (const UA_DataSourceBatchOp*)b;
+    const UA_VariableNode *vnA = &opA->node->variableNode;
+    const UA_VariableNode *vnB = &opB->node->variableNode;
+    uintptr_t keysA[4] = {(uintptr_t)vnA->readBatch, (uintptr_t)vnA->readBatchDevice,
+                          (uintptr_t)opA->session, (uintptr_t)opA->value};
+    uintptr_t keysB[4] = {(uintptr_t)vnB->readBatch, (uintptr_t)vnB->readBatchDevice,
+                          (uintptr_t)opB->session, (uintptr_t)opB->value};
+    for(size_t i = 0; i < 4; i++) {
+        if(keysA[i] != keysB[i])
+            return (keysA[i] < keysB[i]) ? -1 : 1;
+    }
+    return 0;
+}
+
+static UA_Boolean
+includeSourceTimestamp(UA_TimestampsToReturn ttr) {
+    return (ttr == UA_TIMESTAMPSTORETURN_SOURCE || ttr == UA_TIMESTAMPSTORETURN_BOTH);
+}
+
+static UA_Boolean
+sameDataSourceBatch(const UA_DataSourceBatchOp *a, const UA_DataSourceBatchOp *b) {
+    const UA_VariableNode *vnA = &a->node->variableNode;
+    const UA_VariableNode *vnB = &b->node->variableNode;
+    return (vnA->readBatch == vnB->readBatch &&
+            vnA->readBatchDevice == vnB->readBatchDevice &&
+            a->session == b->session &&
+            includeSourceTimestamp(a->timestampsToReturn) ==
+            includeSourceTimestamp(b->timestampsToReturn));
+}
+
+void
+readDataSourceBatch(UA_Server *server, UA_DataSourceBatch *batch) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+    if(batch->opsSize == 0)
+        goto cleanup;
+
+    qsort(batch->ops, batch->opsSize, sizeof(UA_DataSourceBatchOp),
+          cmpDataSourceBatchOp);
+
+    UA_DataSourceReadItem *items = (UA_DataSourceReadItem*)
+        UA_malloc(batch->opsSize * sizeof(UA_DataSourceReadItem));
+
+    UA_EventLoop *el = server->config.eventLoop;
+    for(size_t i = 0; i < batch->opsSize;) {
+        /* Find the operations of the batch */
+        UA_DataSourceBatchOp *first = &batch->ops[i];
+        size_t n = 1;
+        while(i + n < batch->opsSize && sameDataSourceBatch(first, &batch->ops[i + n]))
+            n++;
+
+        /* Read the values */
+        UA_StatusCode res = UA_STATUSCODE_BADOUTOFMEMORY;
+        if(items) {
+            for(size_t j = 0; j < n; j++) {
+                UA_DataSourceBatchOp *op = &batch->ops[i + j];
+                items[j].nodeId = &op->node->head.nodeId;
+                items[j].nodeContext = op->node->head.context;
+                items[j].range = (op->range.dimensionsSize > 0) ? &op->range : NULL;
+                items[j].value = op->value;
+            }
+            const UA_VariableNode *vn = &first->node->variableNode;
+            UA_Session *session = first->session;
+            UNLOCK_FOR_CALLBACK(server);
+            res = vn->readBatch(server, &session->sessionId, session->context,
+                                vn->readBatchDevice,
+                                includeSourceTimestamp(first->timestampsToReturn),
+                                n, items);
+            LOCK_AFTER_CALLBACK(server);
+        }
+
+        /* Set the results as in readValueAttributeComplete and ReadWithNode */
+        for(size_t j = 0; j < n; j++) {
+            UA_DataSourceBatchOp *op = &batch->ops[i + j];
+            UA_DataValue *v = op->value;
+            UA_StatusCode retval = res;
+            if(retval != UA_STATUSCODE_GOOD) {
+                UA_DataValue_init(v);
+            } else if(v->hasValue && v->value.storageType == UA_VARIANT_DATA_NODELETE) {
+                UA_DataValue v2 = *v;
+                retval = UA_DataValue_copy(&v2, v);
+                UA_DataValue_clear(&v2);
+            }
+            if(!v->hasSourceTimestamp) {
+                v->sourceTimestamp = el->dateTime_now(el);
+                v->hasSourceTimestamp = true;
+            }
+            finishRead(server, op->timestampsToReturn, retval, v);
+        }
+        i += n;
+    }
+    UA_free(items);
+
+ cleanup:
+    for(size_t i = 0; i < batch->opsSize; i++) {
+        UA_NODESTORE_RELEASE(server, batch->ops[i].node);
+        UA_free(batch->ops[i].range.dimensions);
+    }
+    UA_free(batch->ops);
+    memset(batch, 0, sizeof(UA_DataSourceBatch));
+}
+
+/* The node was resolved in a batch with the other operations of the request */
+static void
+Operation_ReadWithNode(UA_Server *server, UA_Session *session, UA_TimestampsToReturn *ttr,
+                       const UA_ReadValueId *rvi, const UA_Node *node, UA_DataValue *dv) {
+    if(!node) {
+        dv->hasStatus = true;
+        dv->status = UA_STATUSCODE_BADNODEIDUNKNOWN;
+        return;
+    }
+    ReadWithNode(node, server, session, *ttr, rvi, dv);
+}
+
+/* Read with the DataSource batches. The nodes are resolved one after the
+ * other. */
+static UA_StatusCode
+Service_ReadBatch(UA_Server *server, UA_Session *session,
+                  const UA_ReadRequest *request, UA_ReadResponse *response) {
+    size_t opsSize = request->nodesToReadSize;
+    if(opsSize == 0)
+        return UA_STATUSCODE_BADNOTHINGTODO;
+    response->results = (UA_DataValue*)
+        UA_Array_new(opsSize, &UA_TYPES[UA_TYPES_DATAVALUE]);
+    if(!response->results)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    response->resultsSize = opsSize;
+
+    UA_DataSourceBatch batch;
+    memset(&batch, 0, sizeof(UA_DataSourceBatch));
+    for(size_t i = 0; i < opsSize; i++) {
+        const UA_ReadValueId *rvi = &request->nodesToRead[i];
+        const UA_Node *node =
+            UA_NODESTORE_GET_SELECTIVE(server, &rvi->nodeId,
+                                       attributeId2AttributeMask((UA_AttributeId)rvi->attributeId),
+                                       UA_REFERENCETYPESET_NONE,
+                                       UA_BROWSEDIRECTION_INVALID);
+        if(deferDataSourceRead(server, &batch, session, node, rvi,
+                               request->timestampsToReturn, &response->results[i]))
+            continue;
+        Operation_ReadWithNode(server, session,
+                               (UA_TimestampsToReturn*)(uintptr_t)&request->timestampsToReturn,
+                               rvi, node, &response->results[i]);
+        if(node)
+            UA_NODESTORE_RELEASE(server, node);
+    }
+    readDataSourceBatch(server, &batch);
+    return UA_STATUSCODE_GOOD;
+}
+
 void
 Operation_Read(UA_Server *server, UA_Session *session, UA_TimestampsToReturn *ttr,
                const UA_ReadValueId *rvi, UA_DataValue *dv) {
@@ -634,6 +1176,274 @@ Operation_Read(UA_Server *server, UA_Session *session, UA_TimestampsToReturn *tt
     UA_NODESTORE_RELEASE(server, node);
 }
 
+#ifdef UA_PARALLEL_READ
+
+#define UA_PARALLELREAD_DEFAULTTHREADS 4
+#define UA_PARALLELREAD_BATCHSIZE 64
+
+typedef struct ParallelReadSlice {
+    UA_Server *server;
+    const UA_ReadOperation *ops;
+    const UA_Node **nodes;
+    UA_DataValue *results;
+    size_t begin;
+    size_t end;
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+    /* The allocator is thread-local. Use the same as the requesting thread. */
+    void * (*mallocSingleton)(size_t size);
+    void (*freeSingleton)(void *ptr);
+    void * (*callocSingleton)(size_t nelem, size_t elsize);
+    void * (*reallocSingleton)(void *ptr, size_t size);
+    UA_MemoryCategory memoryCategory;
+#endif
+} ParallelReadSlice;
+
+/* Operations that call a value callback run in the requesting thread after the
+ * workers are done. The callbacks can call back into the server API. */
+static UA_Boolean
+isParallelReadOperation(const UA_ReadValueId *rvi, const UA_Node *node) {
+    if(!node || rvi->attributeId != UA_ATTRIBUTEID_VALUE ||
+       (node->head.nodeClass != UA_NODECLASS_VARIABLE &&
+        node->head.nodeClass != UA_NODECLASS_VARIABLETYPE))
+        return true;
+    return isInternalValue(&node->variableNode);
+}
+
+static void
+processParallelReadSlice(ParallelReadSlice *slice) {
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+    UA_mallocSingleton = slice->mallocSingleton;
+    UA_freeSingleton = slice->freeSingleton;
+    UA_callocSingleton = slice->callocSingleton;
+    UA_reallocSingleton = slice->reallocSingleton;
+    UA_memoryCategory = slice->memoryCategory;
+#endif
+    parallelReadWorker = true;
+    for(size_t i = slice->begin; i < slice->end; i++) {
+        const UA_ReadOperation *op = &slice->ops[i];
+        if(!isParallelReadOperation(op->rvi, slice->nodes[i]))
+            continue;
+        if(!op->session) {
+            slice->results[i].hasStatus = true;
+            slice->results[i].status = UA_STATUSCODE_BADUSERACCESSDENIED;
+            continue;
+        }
+        if(!slice->nodes[i]) {
+            slice->results[i].hasStatus = true;
+            slice->results[i].status = UA_STATUSCODE_BADNODEIDUNKNOWN;
+            continue;
+        }
+        ReadWithNode(slice->nodes[i], slice->server, op->session,
+                     op->timestampsToReturn, op->rvi, &slice->results[i]);
+    }
+    parallelReadWorker = false;
+}
+
+/* Take slices until none are left. Called with the pool mutex held. */
+static void
+processParallelReadSlices(UA_ParallelReadPool *pool) {
+    while(pool->nextSlice < pool->slicesSize) {
+        ParallelReadSlice *slice = &pool->slices[pool->nextSlice++];
+        pthread_mutex_unlock(&pool->mutex);
+        processParallelReadSlice(slice);
+        pthread_mutex_lock(&pool->mutex);
+        pool->pendingSlices--;
+        if(pool->pendingSlices == 0)
+            pthread_cond_broadcast(&pool->doneCondition);
+    }
+}
+
+static void *
+parallelReadWorkerLoop(void *data) {
+    UA_ParallelReadPool *pool = (UA_ParallelReadPool*)data;
+    pthread_mutex_lock(&pool->mutex);
+    while(!pool->stopWorkers) {
+        processParallelReadSlices(pool);
+        pthread_cond_wait(&pool->workCondition, &pool->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return NULL;
+}
+
+void
+UA_ParallelReadPool_init(UA_ParallelReadPool *pool) {
+    memset(pool, 0, sizeof(UA_ParallelReadPool));
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->workCondition, NULL);
+    pthread_cond_init(&pool->doneCondition, NULL);
+}
+
+void
+UA_ParallelReadPool_clear(UA_ParallelReadPool *pool) {
+    pthread_mutex_lock(&pool->mutex);
+    pool->stopWorkers = true;
+    pthread_cond_broadcast(&pool->workCondition);
+    pthread_mutex_unlock(&pool->mutex);
+    for(size_t i = 0; i < pool->threadsSize; i++)
+        pthread_join(pool->threads[i], NULL);
+    pool->threadsSize = 0;
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->workCondition);
+    pthread_cond_destroy(&pool->doneCondition);
+}
+
+/* Process the slices with the requesting thread and the worker threads of the
+ * pool. Additional workers are started if the pool has fewer than
+ * slicesSize-1. Slices are processed by the requesting thread alone if no
+ * worker could be started. */
+static void
+runParallelReadSlices(UA_ParallelReadPool *pool, ParallelReadSlice *slices,
+                      size_t slicesSize) {
+    pthread_mutex_lock(&pool->mutex);
+    while(pool->slicesSize > 0)
+        pthread_cond_wait(&pool->doneCondition, &pool->mutex);
+    while(pool->threadsSize < slicesSize - 1) {
+        if(pthread_create(&pool->threads[pool->threadsSize], NULL,
+                          parallelReadWorkerLoop, pool) != 0)
+            break;
+        pool->threadsSize++;
+    }
+    pool->slices = slices;
+    pool->slicesSize = slicesSize;
+    pool->nextSlice = 0;
+    pool->pendingSlices = slicesSize;
+    pthread_cond_broadcast(&pool->workCondition);
+
+    processParallelReadSlices(pool);
+    while(pool->pendingSlices > 0)
+        pthread_cond_wait(&pool->doneCondition, &pool->mutex);
+
+    pool->slices = NULL;
+    pool->slicesSize = 0;
+    pthread_cond_broadcast(&pool->doneCondition);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+/* The nodes of all operations are resolved up front. The operations are then
+ * split into contiguous slices for the worker threads. The requesting thread
+ * keeps the service lock and processes slices as well. So the workers
+ * neither touch the nodestore nor compete with other writers. The operations
+ * with value callbacks are processed last in the normal way. */
+UA_StatusCode
+readParallel(UA_Server *server, size_t opsSize, const UA_ReadOperation *ops,
+             UA_DataValue *results) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+    const UA_Node **nodes = (const UA_Node**)UA_calloc(opsSize, sizeof(UA_Node*));
+    if(!nodes)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    /* Resolve the nodes */
+    UA_Nodestore *ns = &server->config.nodestore;
+    const UA_NodeId *ids[UA_PARALLELREAD_BATCHSIZE];
+    for(size_t i = 0; i < opsSize; i += UA_PARALLELREAD_BATCHSIZE) {
+        size_t n = opsSize - i;
+        if(n > UA_PARALLELREAD_BATCHSIZE)
+            n = UA_PARALLELREAD_BATCHSIZE;
+        if(!ns->getNodes) {
+            for(size_t j = 0; j < n; j++) {
+                const UA_ReadValueId *rvi = ops[i + j].rvi;
+                nodes[i + j] = UA_NODESTORE_GET_SELECTIVE(server, &rvi->nodeId,
+                               attributeId2AttributeMask((UA_AttributeId)rvi->attributeId),
+                               UA_REFERENCETYPESET_NONE, UA_BROWSEDIRECTION_INVALID);
+            }
+            continue;
+        }
+        for(size_t j = 0; j < n; j++)
+            ids[j] = &ops[i + j].rvi->nodeId;
+        ns->getNodes(ns->context, n, ids, UA_NODEATTRIBUTESMASK_ALL,
+                     UA_REFERENCETYPESET_NONE, UA_BROWSEDIRECTION_INVALID,
+                     &nodes[i]);
+    }
+    UA_UInt32 changes = server->nodestoreChanges;
+
+    /* Split into slices */
+    size_t threads = server->config.parallelReadThreads;
+    if(threads == 0)
+        threads = UA_PARALLELREAD_DEFAULTTHREADS;
+    if(threads > UA_PARALLELREAD_MAXTHREADS)
+        threads = UA_PARALLELREAD_MAXTHREADS;
+    if(threads > opsSize)
+        threads = opsSize;
+    ParallelReadSlice slices[UA_PARALLELREAD_MAXTHREADS];
+    size_t sliceSize = (opsSize + threads - 1) / threads;
+    for(size_t t = 0; t < threads; t++) {
+        ParallelReadSlice *slice = &slices[t];
+        slice->server = server;
+        slice->ops = ops;
+        slice->nodes = nodes;
+        slice->results = results;
+        slice->begin = t * sliceSize;
+        slice->end = slice->begin + sliceSize;
+        if(slice->end > opsSize)
+            slice->end = opsSize;
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+        slice->mallocSingleton = UA_mallocSingleton;
+        slice->freeSingleton = UA_freeSingleton;
+        slice->callocSingleton = UA_callocSingleton;
+        slice->reallocSingleton = UA_reallocSingleton;
+        slice->memoryCategory = UA_memoryCategory;
+#endif
+    }
+    runParallelReadSlices(&server->parallelReadPool, slices, threads);
+
+    /* Process the remaining operations with value callbacks. Resolve the node
+     * again if a callback has modified the nodestore. */
+    for(size_t i = 0; i < opsSize; i++) {
+        const UA_ReadOperation *op = &ops[i];
+        if(isParallelReadOperation(op->rvi, nodes[i]))
+            continue;
+        if(changes != server->nodestoreChanges) {
+            UA_NODESTORE_RELEASE(server, nodes[i]);
+            nodes[i] = NULL;
+            results[i] = readWithSession(server, op->session, op->rvi,
+                                         op->timestampsToReturn);
+            continue;
+        }
+        if(!op->session) {
+            results[i].hasStatus = true;
+            results[i].status = UA_STATUSCODE_BADUSERACCESSDENIED;
+            continue;
+        }
+        ReadWithNode(nodes[i], server, op->session, op->timestampsToReturn,
+                     op->rvi, &results[i]);
+    }
+
+    /* Release the nodes */
+    for(size_t i = 0; i < opsSize; i++) {
+        if(nodes[i])
+            UA_NODESTORE_RELEASE(server, nodes[i]);
+    }
+    UA_free(nodes);
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+Service_ReadParallel(UA_Server *server, UA_Session *session,
+                     const UA_ReadRequest *request, UA_ReadResponse *response) {
+    size_t opsSize = request->nodesToReadSize;
+    UA_ReadOperation *ops = (UA_ReadOperation*)
+        UA_malloc(opsSize * sizeof(UA_ReadOperation));
+    if(!ops)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    response->results = (UA_DataValue*)
+        UA_Array_new(opsSize, &UA_TYPES[UA_TYPES_DATAVALUE]);
+    if(!response->results) {
+        UA_free(ops);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    response->resultsSize = opsSize;
+    for(size_t i = 0; i < opsSize; i++) {
+        ops[i].session = session;
+        ops[i].rvi = &request->nodesToRead[i];
+        ops[i].timestampsToReturn = request->timestampsToReturn;
+    }
+    UA_StatusCode res = readParallel(server, opsSize, ops, response->results);
+    UA_free(ops);
+    return res;
+}
+
+#endif /* UA_PARALLEL_READ */
+
 void
 Service_Read(UA_Server *server, UA_Session *session,
              const UA_ReadRequest *request, UA_ReadResponse *response) {
@@ -661,16 +1471,169 @@ Service_Read(UA_Server *server, UA_Session *session,
 
     UA_LOCK_ASSERT(&server->serviceMutex);
 
+    /* Collect the reads of DataSources with a batch callback */
+    if(server->dataSourceBatchRead && request->nodesToReadSize > 1) {
+        response->responseHeader.serviceResult =
+            Service_ReadBatch(server, session, request, response);
+        return;
+    }
+
+#ifdef UA_PARALLEL_READ
+    /* Process large requests in parallel worker threads */
+    if(server->config.parallelReadThreshold > 0 &&
+       request->nodesToReadSize >= server->config.parallelReadThreshold) {
+        response->responseHeader.serviceResult =
+            Service_ReadParallel(server, session, request, response);
+        return;
+    }
+#endif
+
+    response->responseHeader.serviceResult =
+        UA_Server_processServiceOperationsWithNodes(server, session,
+                                                    (UA_ServiceOperation)Operation_Read,
+                                                    (UA_ServiceOperationWithNode)
+                                                    Operation_ReadWithNode,
+                                                    &request->timestampsToReturn,
+                                                    &request->nodesToReadSize,
+                                                    &UA_TYPES[UA_TYPES_READVALUEID],
+                                                    offsetof(UA_ReadValueId, nodeId),
+                                                    &response->resultsSize,
+                                                    &UA_TYPES[UA_TYPES_DATAVALUE]);
+}
+
+#if UA_MULTITHREADING >= 100
+
+/* Only the value attribute of variables with a DataSource is processed
+ * asynchronously */
+static UA_Boolean
+isAsyncValueOperation(const UA_Node *node, UA_UInt32 attributeId) {
+    if(attributeId != UA_ATTRIBUTEID_VALUE ||
+       node->head.nodeClass != UA_NODECLASS_VARIABLE ||
+       !node->variableNode.async)
+        return false;
+    const UA_VariableNode *vn = &node->variableNode;
+    if(vn->valueBackend.backendType == UA_VALUEBACKENDTYPE_DATA_SOURCE_CALLBACK)
+        return true;
+    return (vn->valueBackend.backendType == UA_VALUEBACKENDTYPE_NONE &&
+            vn->valueSource == UA_VALUESOURCE_DATASOURCE);
+}
+
+/* Check the access rights of the session before the operation is enqueued. The
+ * workers execute with the admin session. */
+static UA_StatusCode
+enqueueAsyncValueOperation(UA_Server *server, UA_Session *session,
+                           const UA_VariableNode *vn, UA_Byte accessMask,
+                           UA_AsyncOperationType type, UA_UInt32 requestId,
+                           UA_UInt32 requestHandle, size_t opIndex,
+                           const void *opRequest, UA_AsyncResponse **ar) {
+    if(!(getUserAccessLevel(server, session, vn) & accessMask))
+        return UA_STATUSCODE_BADUSERACCESSDENIED;
+
+    /* No AsyncResponse allocated so far */
+    if(!*ar) {
+        UA_StatusCode res =
+            UA_AsyncManager_createAsyncResponse(&server->asyncManager, server,
+                                                &session->sessionId, requestId,
+                                                requestHandle, type, ar);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+
+    return UA_AsyncManager_createAsyncOp(&server->asyncManager, server,
+                                         *ar, opIndex, opRequest);
+}
+
+static void
+Operation_ReadAsync(UA_Server *server, UA_Session *session,
+                    const UA_TimestampsToReturn *ttr, UA_UInt32 requestId,
+                    UA_UInt32 requestHandle, size_t opIndex,
+                    const UA_ReadValueId *rvi, UA_DataValue *dv,
+                    UA_AsyncResponse **ar) {
+    const UA_Node *node =
+        UA_NODESTORE_GET_SELECTIVE(server, &rvi->nodeId,
+                                   attributeId2AttributeMask((UA_AttributeId)rvi->attributeId),
+                                   UA_REFERENCETYPESET_NONE,
+                                   UA_BROWSEDIRECTION_INVALID);
+    if(!node) {
+        dv->hasStatus = true;
+        dv->status = UA_STATUSCODE_BADNODEIDUNKNOWN;
+        return;
+    }
+
+    /* Synchronous execution */
+    if(!isAsyncValueOperation(node, rvi->attributeId)) {
+        ReadWithNode(node, server, session, *ttr, rvi, dv);
+        UA_NODESTORE_RELEASE(server, node);
+        return;
+    }
+
+    /* <-- Async read --> */
+    UA_StatusCode res =
+        enqueueAsyncValueOperation(server, session, &node->variableNode,
+                                   UA_ACCESSLEVELMASK_READ, UA_ASYNCOPERATIONTYPE_READ,
+                                   requestId, requestHandle, opIndex, rvi, ar);
+    if(*ar)
+        (*ar)->timestampsToReturn = *ttr;
+    if(res != UA_STATUSCODE_GOOD) {
+        dv->hasStatus = true;
+        dv->status = res;
+    }
+    UA_NODESTORE_RELEASE(server, node);
+}
+
+void
+Service_ReadAsync(UA_Server *server, UA_Session *session, UA_UInt32 requestId,
+                  const UA_ReadRequest *request, UA_ReadResponse *response,
+                  UA_Boolean *finished) {
+    UA_LOG_DEBUG_SESSION(server->config.logging, session, "Processing ReadRequestAsync");
+    UA_LOCK_ASSERT(&server->serviceMutex);
+
+    if(request->timestampsToReturn > UA_TIMESTAMPSTORETURN_NEITHER) {
+        response->responseHeader.serviceResult = UA_STATUSCODE_BADTIMESTAMPSTORETURNINVALID;
+        return;
+    }
+
+    if(request->maxAge < 0) {
+        response->responseHeader.serviceResult = UA_STATUSCODE_BADMAXAGEINVALID;
+        return;
+    }
+
+    if(server->config.maxNodesPerRead != 0 &&
+       request->nodesToReadSize > server->config.maxNodesPerRead) {
+        response->responseHeader.serviceResult = UA_STATUSCODE_BADTOOMANYOPERATIONS;
+        return;
+    }
+
+    /* The results can outlive the request. Don't pin the nodes. */
+    if(session->channel)
+        session->channel->pinNodes = false;
+
+    UA_AsyncResponse *ar = NULL;
     response->responseHeader.serviceResult =
-        UA_Server_processServiceOperations(server, session,
-                                           (UA_ServiceOperation)Operation_Read,
-                                           &request->timestampsToReturn,
-                                           &request->nodesToReadSize,
-                                           &UA_TYPES[UA_TYPES_READVALUEID],
-                                           &response->resultsSize,
-                                           &UA_TYPES[UA_TYPES_DATAVALUE]);
+        UA_Server_processServiceOperationsAsync(server, session, requestId,
+                  request->requestHeader.requestHandle,
+                  (UA_AsyncServiceOperation)Operation_ReadAsync,
+                  &request->timestampsToReturn,
+                  &request->nodesToReadSize, &UA_TYPES[UA_TYPES_READVALUEID],
+                  &response->resultsSize, &UA_TYPES[UA_TYPES_DATAVALUE], &ar);
+
+    if(ar) {
+        if(ar->opCountdown > 0) {
+            /* Move all results to the AsyncResponse. The async operation
+             * results will be overwritten when the workers return results. */
+            ar->response.readResponse = *response;
+            UA_ReadResponse_init(response);
+            *finished = false;
+        } else {
+            /* If there is a new AsyncResponse, ensure it has at least one
+             * pending operation */
+            UA_AsyncManager_removeAsyncResponse(&server->asyncManager, ar);
+        }
+    }
 }
 
+#endif /* UA_MULTITHREADING >= 100 */
+
 UA_DataValue
 readWithSession(UA_Server *server, UA_Session *session,
                 const UA_ReadValueId *item,
@@ -732,7 +1695,7 @@ readWithReadValue(UA_Server *server, const UA_NodeId *nodeId,
 UA_DataValue
 UA_Server_read(UA_Server *server, const UA_ReadValueId *item,
                UA_TimestampsToReturn timestamps) {
-    UA_LOCK(&server->serviceMutex);
+    lockForRead(server);
     UA_DataValue dv = readWithSession(server, &server->adminSession, item, timestamps);
     UA_UNLOCK(&server->serviceMutex);
     return dv;
@@ -743,7 +1706,7 @@ UA_Server_read(UA_Server *server, const UA_ReadValueId *item,
 UA_StatusCode
 __UA_Server_read(UA_Server *server, const UA_NodeId *nodeId,
                  const UA_AttributeId attributeId, void *v) {
-   UA_LOCK(&server->serviceMutex);
+   lockForRead(server);
    UA_StatusCode retval = readWithReadValue(server, nodeId, attributeId, v);
    UA_UNLOCK(&server->serviceMutex);
    return retval;
@@ -1320,14 +2283,46 @@ writeDataTypeAttribute(UA_Server *server, UA_Session *session,
     return UA_STATUSCODE_GOOD;
 }
 
+/* Pinned nodes can be referenced by a Read response that is not yet encoded
+ * (see pinNode). Then the replaced value is retired instead of freed. */
+static UA_StatusCode
+retireValue(UA_Server *server, UA_DataValue *value) {
+    if(server->pinnedNodesCount == 0) {
+        UA_DataValue_clear(value);
+        return UA_STATUSCODE_GOOD;
+    }
+    UA_DataValue *retired = (UA_DataValue*)
+        UA_realloc(server->retiredValues,
+                   (server->retiredValuesSize + 1) * sizeof(UA_DataValue));
+    if(!retired)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    retired[server->retiredValuesSize] = *value;
+    server->retiredValues = retired;
+    server->retiredValuesSize++;
+    UA_DataValue_init(value);
+    return UA_STATUSCODE_GOOD;
+}
+
 static UA_StatusCode
-writeValueAttributeWithoutRange(UA_VariableNode *node, const UA_DataValue *value) {
+writeValueAttributeWithoutRange(UA_Server *server, UA_VariableNode *node,
+                                const UA_DataValue *value) {
     UA_DataValue *oldValue = &node->value.data.value;
     UA_DataValue tmpValue = *value;
 
+    /* Share large arrays between the node, the read responses and the
+     * notifications */
+    UA_Boolean share = (server->config.sharedValueThreshold > 0 &&
+                        value->hasValue && value->value.type &&
+                        !UA_Variant_isScalar(&value->value) &&
+                        value->value.arrayLength * value->value.type->memSize >=
+                        server->config.sharedValueThreshold);
+
     /* If possible memcpy the new value over the old value without
-     * a malloc. For this the value needs to be "pointerfree". */
-    if(oldValue->hasValue && oldValue->value.type && oldValue->value.type->pointerFree &&
+     * a malloc. For this the value needs to be "pointerfree". Shared values
+     * are immutable and always replaced. */
+    if(!share && oldValue->hasValue &&
+       oldValue->value.storageType == UA_VARIANT_DATA &&
+       oldValue->value.type && oldValue->value.type->pointerFree &&
        value->hasValue && value->value.type && value->value.type->pointerFree &&
        oldValue->value.type->memSize == value->value.type->memSize) {
         size_t oSize = 1;
@@ -1361,13 +2356,23 @@ writeValueAttributeWithoutRange(UA_VariableNode *node, const UA_DataValue *value
     UA_StatusCode retval = UA_Variant_copy(&value->value, &tmpValue.value);
     if(retval != UA_STATUSCODE_GOOD)
         return retval;
-    UA_DataValue_clear(&node->value.data.value);
+
+    /* Keep the private copy if sharing fails */
+    if(share)
+        UA_Variant_share(&tmpValue.value);
+
+    retval = retireValue(server, &node->value.data.value);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_Variant_clear(&tmpValue.value);
+        return retval;
+    }
     node->value.data.value = tmpValue;
     return UA_STATUSCODE_GOOD;
 }
 
 static UA_StatusCode
-writeValueAttributeWithRange(UA_VariableNode *node, const UA_DataValue *value,
+writeValueAttributeWithRange(UA_Server *server, UA_VariableNode *node,
+                             const UA_DataValue *value,
                              const UA_NumericRange *rangeptr) {
     /* Value on both sides? */
     if(value->status != node->value.data.value.status ||
@@ -1389,10 +2394,28 @@ writeValueAttributeWithRange(UA_VariableNode *node, const UA_DataValue *value,
                         &v->type->typeId))
         return UA_STATUSCODE_BADTYPEMISMATCH;
 
-    /* Write the value */
-    UA_StatusCode retval =
-        UA_Variant_setRangeCopy(&node->value.data.value.value,
-                                v->data, v->arrayLength, *rangeptr);
+    /* Write the value. Writing the range frees the overwritten members. So
+     * write into a copy if the node might be pinned. */
+    UA_StatusCode retval;
+    if(server->pinnedNodesCount == 0 ||
+       (v->type->pointerFree &&
+        node->value.data.value.value.storageType != UA_VARIANT_DATA_SHARED)) {
+        retval = UA_Variant_setRangeCopy(&node->value.data.value.value,
+                                         v->data, v->arrayLength, *rangeptr);
+    } else {
+        UA_DataValue tmpValue = node->value.data.value;
+        retval = UA_Variant_copy(&node->value.data.value.value, &tmpValue.value);
+        if(retval == UA_STATUSCODE_GOOD)
+            retval = UA_Variant_setRangeCopy(&tmpValue.value, v->data,
+                                             v->arrayLength, *rangeptr);
+        if(retval == UA_STATUSCODE_GOOD)
+            retval = retireValue(server, &node->value.data.value);
+        if(retval != UA_STATUSCODE_GOOD) {
+            UA_Variant_clear(&tmpValue.value);
+            return retval;
+        }
+        node->value.data.value = tmpValue;
+    }
     if(retval != UA_STATUSCODE_GOOD)
         return retval;
 
@@ -1406,6 +2429,49 @@ writeValueAttributeWithRange(UA_VariableNode *node, const UA_DataValue *value,
     return UA_STATUSCODE_GOOD;
 }
 
+/* Copy the value into the memory region of the value backend. The size of the
+ * region is fixed. So only values of the same type and length are accepted. */
+static UA_StatusCode
+writeValueAttributeToMemory(UA_VariableNode *node, const UA_Variant *value,
+                            const UA_NumericRange *rangeptr) {
+    const UA_DataType *type = node->valueBackend.backend.memory.type;
+    size_t length = node->valueBackend.backend.memory.arrayLength;
+    if(!value->type || value->type != type)
+        return UA_STATUSCODE_BADTYPEMISMATCH;
+
+    UA_Variant mem;
+    wrapMemoryValue(node, &mem);
+    if(!rangeptr) {
+        if(length == 0) {
+            if(!UA_Variant_isScalar(value))
+                return UA_STATUSCODE_BADTYPEMISMATCH;
+        } else if(UA_Variant_isScalar(value) || value->arrayLength != length) {
+            return UA_STATUSCODE_BADOUTOFRANGE;
+        }
+    }
+
+    /* Make scalar a one-entry array for range matching */
+    UA_Variant editableValue;
+    if(rangeptr && UA_Variant_isScalar(value)) {
+        editableValue = *value;
+        editableValue.arrayLength = 1;
+        value = &editableValue;
+    }
+
+    volatile size_t *seqlock = node->valueBackend.backend.memory.seqlock;
+    if(seqlock)
+        UA_atomic_addSize(seqlock, 1);
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    if(!rangeptr)
+        memcpy(mem.data, value->data, type->memSize * ((length > 0) ? length : 1));
+    else
+        res = UA_Variant_setRangeCopy(&mem, value->data, value->arrayLength,
+                                      *rangeptr);
+    if(seqlock)
+        UA_atomic_addSize(seqlock, 1);
+    return res;
+}
+
 static UA_StatusCode
 writeNodeValueAttribute(UA_Server *server, UA_Session *session,
                         UA_VariableNode *node, const UA_DataValue *value,
@@ -1415,12 +2481,14 @@ writeNodeValueAttribute(UA_Server *server, UA_Session *session,
     UA_LOCK_ASSERT(&server->serviceMutex);
 
     /* Parse the range */
+    UA_NumericRangeDimension rangeBuf[UA_NUMERICRANGE_BUFDIMS];
     UA_NumericRange range;
-    range.dimensions = NULL;
+    range.dimensions = rangeBuf;
     UA_NumericRange *rangeptr = NULL;
     UA_StatusCode retval = UA_STATUSCODE_GOOD;
     if(indexRange && indexRange->length > 0) {
-        retval = UA_NumericRange_parse(&range, *indexRange);
+        retval = UA_NumericRange_parseInto(&range, rangeBuf,
+                                           UA_NUMERICRANGE_BUFDIMS, *indexRange);
         if(retval != UA_STATUSCODE_GOOD)
             return retval;
         rangeptr = &range;
@@ -1451,7 +2519,7 @@ writeNodeValueAttribute(UA_Server *server, UA_Session *session,
                                      "Writing the value of Node %N failed with the "
                                      "following reason: %s", node->head.nodeId, reason);
             }
-            if(rangeptr && rangeptr->dimensions != NULL)
+            if(rangeptr && rangeptr->dimensions != rangeBuf)
                 UA_free(rangeptr->dimensions);
             return UA_STATUSCODE_BADTYPEMISMATCH;
         }
@@ -1474,9 +2542,10 @@ writeNodeValueAttribute(UA_Server *server, UA_Session *session,
         if(node->valueSource == UA_VALUESOURCE_DATA) {
             /* Write into the in-situ DataValue */
             if(!rangeptr)
-                retval = writeValueAttributeWithoutRange(node, &adjustedValue);
+                retval = writeValueAttributeWithoutRange(server, node, &adjustedValue);
             else
-                retval = writeValueAttributeWithRange(node, &adjustedValue, rangeptr);
+                retval = writeValueAttributeWithRange(server, node, &adjustedValue,
+                                                      rangeptr);
 
             /* Callback after writing */
             if(retval == UA_STATUSCODE_GOOD &&
@@ -1515,12 +2584,24 @@ writeNodeValueAttribute(UA_Server *server, UA_Session *session,
         }
         break;
 
+    case UA_VALUEBACKENDTYPE_MEMORY:
+        retval = writeValueAttributeToMemory(node, &adjustedValue.value, rangeptr);
+        break;
+
     case UA_VALUEBACKENDTYPE_INTERNAL:
     case UA_VALUEBACKENDTYPE_DATA_SOURCE_CALLBACK:
     default:
         break;
     }
 
+#ifdef UA_ENABLE_METHODCALLS
+    /* Invalidate the argument definitions cached for the Call service */
+    if(retval == UA_STATUSCODE_GOOD &&
+       (adjustedValue.value.type == &UA_TYPES[UA_TYPES_ARGUMENT] ||
+        UA_NodeId_equal(&node->dataType, &UA_TYPES[UA_TYPES_ARGUMENT].typeId)))
+        server->methodArgumentsEpoch++;
+#endif
+
     /* Write into the historical data backend. Not that the historical data
      * backend can be configured to "poll" data like a MonitoredItem also. */
 #ifdef UA_ENABLE_HISTORIZING
@@ -1537,7 +2618,7 @@ writeNodeValueAttribute(UA_Server *server, UA_Session *session,
 #endif
 
     /* Clean up */
-    if(rangeptr && rangeptr->dimensions != NULL)
+    if(rangeptr && rangeptr->dimensions != rangeBuf)
         UA_free(rangeptr->dimensions);
     return retval;
 }
@@ -1616,15 +2697,17 @@ updateLocalizedText(const UA_LocalizedText *source, UA_LocalizedText *target) {
     return UA_STATUSCODE_GOOD;
 }
 
-/* Trigger sampling if a MonitoredItem surveils the attribute with no sampling
- * interval */
+/* Trigger sampling if a MonitoredItem surveils one of the written attributes
+ * with no sampling interval. The attributes are a bitmask indexed by the
+ * AttributeId. */
 #ifdef UA_ENABLE_SUBSCRIPTIONS
 static void
 triggerImmediateDataChange(UA_Server *server, UA_Session *session,
-                           UA_Node *node, const UA_WriteValue *wvalue) {
+                           UA_Node *node, UA_UInt32 writtenAttributes) {
     UA_MonitoredItem *mon = node->head.monitoredItems;
     for(; mon != NULL; mon = mon->sampling.nodeListNext) {
-        if(mon->itemToMonitor.attributeId != wvalue->attributeId)
+        if(mon->itemToMonitor.attributeId >= 32 ||
+           !(writtenAttributes & ((UA_UInt32)1 << mon->itemToMonitor.attributeId)))
             continue;
         UA_DataValue value;
         UA_DataValue_init(&value);
@@ -1638,8 +2721,8 @@ triggerImmediateDataChange(UA_Server *server, UA_Session *session,
 /* This function implements the main part of the write service and operates on a
    copy of the node (not in single-threaded mode). */
 static UA_StatusCode
-copyAttributeIntoNode(UA_Server *server, UA_Session *session,
-                      UA_Node *node, const UA_WriteValue *wvalue) {
+writeAttributeIntoNode(UA_Server *server, UA_Session *session,
+                       UA_Node *node, const UA_WriteValue *wvalue) {
     UA_assert(session != NULL);
     const void *value = wvalue->value.value.data;
     UA_UInt32 userWriteMask = getUserWriteMask(server, session, &node->head);
@@ -1799,14 +2882,35 @@ copyAttributeIntoNode(UA_Server *server, UA_Session *session,
         return retval;
     }
 
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+copyAttributeIntoNode(UA_Server *server, UA_Session *session,
+                      UA_Node *node, const UA_WriteValue *wvalue) {
+    UA_StatusCode retval = writeAttributeIntoNode(server, session, node, wvalue);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
     /* Trigger MonitoredItems with no SamplingInterval */
 #ifdef UA_ENABLE_SUBSCRIPTIONS
-    triggerImmediateDataChange(server, session, node, wvalue);
+    triggerImmediateDataChange(server, session, node,
+                               (UA_UInt32)1 << wvalue->attributeId);
 #endif
 
     return UA_STATUSCODE_GOOD;
 }
 
+static void
+afterWrite(UA_Server *server, const UA_WriteValue *wv, UA_StatusCode result) {
+#ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
+    /* Evaluate the limit alarms with the node as input */
+    if(result == UA_STATUSCODE_GOOD && wv->attributeId == UA_ATTRIBUTEID_VALUE &&
+       wv->indexRange.length == 0 && ZIP_ROOT(&server->conditionWatchTree))
+        UA_ConditionList_afterWrite(server, &wv->nodeId, &wv->value.value);
+#endif
+}
+
 void
 Operation_Write(UA_Server *server, UA_Session *session, void *context,
                 const UA_WriteValue *wv, UA_StatusCode *result) {
@@ -1815,6 +2919,125 @@ Operation_Write(UA_Server *server, UA_Session *session, void *context,
                                  UA_REFERENCETYPESET_NONE, UA_BROWSEDIRECTION_INVALID,
                                  (UA_EditNodeCallback)copyAttributeIntoNode,
                                  (void*)(uintptr_t)wv);
+    afterWrite(server, wv, *result);
+}
+
+/* Batched Write
+ * ~~~~~~~~~~~~~
+ * The WriteValues of a request are grouped by their target node. Each node is
+ * retrieved for editing once and the MonitoredItems of the node without
+ * sampling interval are sampled once after all writes to the node. The groups
+ * are processed in the order of the first write to their node. Within a group,
+ * the writes are applied in the order of the request. */
+
+typedef struct {
+    UA_UInt32 hash;
+    size_t index; /* Position in the request */
+    size_t group; /* Position of the first write to the same node */
+    const UA_NodeId *nodeId;
+} UA_WriteOrder;
+
+static int
+cmpWriteOrderNode(const void *a, const void *b) {
+    const UA_WriteOrder *wa = (const UA_WriteOrder*)a;
+    const UA_WriteOrder *wb = (const UA_WriteOrder*)b;
+    if(wa->hash != wb->hash)
+        return (wa->hash < wb->hash) ? -1 : 1;
+    UA_Order o = UA_NodeId_order(wa->nodeId, wb->nodeId);
+    if(o != UA_ORDER_EQ)
+        return (int)o;
+    return (wa->index < wb->index) ? -1 : 1;
+}
+
+static int
+cmpWriteOrderGroup(const void *a, const void *b) {
+    const UA_WriteOrder *wa = (const UA_WriteOrder*)a;
+    const UA_WriteOrder *wb = (const UA_WriteOrder*)b;
+    if(wa->group != wb->group)
+        return (wa->group < wb->group) ? -1 : 1;
+    return (wa->index < wb->index) ? -1 : 1;
+}
+
+typedef struct {
+    const UA_WriteValue *nodesToWrite;
+    UA_StatusCode *results;
+    const UA_WriteOrder *ops;
+    size_t opsSize;
+} UA_WriteGroup;
+
+static UA_StatusCode
+copyAttributesIntoNode(UA_Server *server, UA_Session *session,
+                       UA_Node *node, UA_WriteGroup *wg) {
+    UA_UInt32 writtenAttributes = 0;
+    for(size_t i = 0; i < wg->opsSize; i++) {
+        size_t index = wg->ops[i].index;
+        const UA_WriteValue *wv = &wg->nodesToWrite[index];
+        wg->results[index] = writeAttributeIntoNode(server, session, node, wv);
+        if(wg->results[index] == UA_STATUSCODE_GOOD)
+            writtenAttributes |= (UA_UInt32)1 << wv->attributeId;
+    }
+
+    /* Trigger MonitoredItems with no SamplingInterval */
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    if(writtenAttributes != 0)
+        triggerImmediateDataChange(server, session, node, writtenAttributes);
+#endif
+
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+writeGrouped(UA_Server *server, UA_Session *session,
+             const UA_WriteRequest *request, UA_WriteResponse *response) {
+    size_t ops = request->nodesToWriteSize;
+    UA_WriteOrder *order = (UA_WriteOrder*)UA_malloc(sizeof(UA_WriteOrder) * ops);
+    if(!order)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    response->results = (UA_StatusCode*)
+        UA_Array_new(ops, &UA_TYPES[UA_TYPES_STATUSCODE]);
+    if(!response->results) {
+        UA_free(order);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    response->resultsSize = ops;
+
+    /* Sort by the target node. Then sort the groups by their first write. */
+    for(size_t i = 0; i < ops; i++) {
+        order[i].nodeId = &request->nodesToWrite[i].nodeId;
+        order[i].hash = UA_NodeId_hash(order[i].nodeId);
+        order[i].index = i;
+    }
+    qsort(order, ops, sizeof(UA_WriteOrder), cmpWriteOrderNode);
+    for(size_t i = 0; i < ops; i++) {
+        order[i].group = (i > 0 && order[i].hash == order[i-1].hash &&
+                          UA_NodeId_equal(order[i].nodeId, order[i-1].nodeId)) ?
+            order[i-1].group : order[i].index;
+    }
+    qsort(order, ops, sizeof(UA_WriteOrder), cmpWriteOrderGroup);
+
+    /* Edit each node once */
+    UA_WriteGroup wg;
+    wg.nodesToWrite = request->nodesToWrite;
+    wg.results = response->results;
+    for(size_t i = 0; i < ops; i += wg.opsSize) {
+        wg.ops = &order[i];
+        wg.opsSize = 1;
+        while(i + wg.opsSize < ops && order[i + wg.opsSize].group == order[i].group)
+            wg.opsSize++;
+        UA_StatusCode res =
+            UA_Server_editNode(server, session, order[i].nodeId, UA_NODEATTRIBUTESMASK_ALL,
+                               UA_REFERENCETYPESET_NONE, UA_BROWSEDIRECTION_INVALID,
+                               (UA_EditNodeCallback)copyAttributesIntoNode, &wg);
+        for(size_t j = 0; j < wg.opsSize; j++) {
+            size_t index = wg.ops[j].index;
+            if(res != UA_STATUSCODE_GOOD)
+                response->results[index] = res;
+            afterWrite(server, &request->nodesToWrite[index], response->results[index]);
+        }
+    }
+
+    UA_free(order);
+    return UA_STATUSCODE_GOOD;
 }
 
 void
@@ -1824,7 +3047,7 @@ Service_Write(UA_Server *server, UA_Session *session,
     UA_assert(session != NULL);
     UA_LOG_DEBUG_SESSION(server->config.logging, session,
                          "Processing WriteRequest");
-    UA_LOCK_ASSERT(&server->serviceMutex);
+    UA_LOCK_ASSERT_EXCLUSIVE(&server->serviceMutex);
 
     if(server->config.maxNodesPerWrite != 0 &&
        request->nodesToWriteSize > server->config.maxNodesPerWrite) {
@@ -1832,6 +3055,13 @@ Service_Write(UA_Server *server, UA_Session *session,
         return;
     }
 
+    /* Group the writes by the target node */
+    if(request->nodesToWriteSize > 1) {
+        response->responseHeader.serviceResult =
+            writeGrouped(server, session, request, response);
+        return;
+    }
+
     response->responseHeader.serviceResult =
         UA_Server_processServiceOperations(server, session,
                                            (UA_ServiceOperation)Operation_Write, NULL,
@@ -1841,6 +3071,74 @@ Service_Write(UA_Server *server, UA_Session *session,
                                            &UA_TYPES[UA_TYPES_STATUSCODE]);
 }
 
+#if UA_MULTITHREADING >= 100
+
+static void
+Operation_WriteAsync(UA_Server *server, UA_Session *session, const void *context,
+                     UA_UInt32 requestId, UA_UInt32 requestHandle, size_t opIndex,
+                     const UA_WriteValue *wv, UA_StatusCode *result,
+                     UA_AsyncResponse **ar) {
+    const UA_Node *node =
+        UA_NODESTORE_GET_SELECTIVE(server, &wv->nodeId,
+                                   UA_NODEATTRIBUTESMASK_NODECLASS |
+                                   UA_NODEATTRIBUTESMASK_ACCESSLEVEL |
+                                   UA_NODEATTRIBUTESMASK_VALUE,
+                                   UA_REFERENCETYPESET_NONE,
+                                   UA_BROWSEDIRECTION_INVALID);
+    if(!node) {
+        *result = UA_STATUSCODE_BADNODEIDUNKNOWN;
+        return;
+    }
+
+    /* Synchronous execution */
+    if(!isAsyncValueOperation(node, wv->attributeId)) {
+        UA_NODESTORE_RELEASE(server, node);
+        Operation_Write(server, session, NULL, wv, result);
+        return;
+    }
+
+    /* <-- Async write --> */
+    *result = enqueueAsyncValueOperation(server, session, &node->variableNode,
+                                         UA_ACCESSLEVELMASK_WRITE,
+                                         UA_ASYNCOPERATIONTYPE_WRITE, requestId,
+                                         requestHandle, opIndex, wv, ar);
+    UA_NODESTORE_RELEASE(server, node);
+}
+
+void
+Service_WriteAsync(UA_Server *server, UA_Session *session, UA_UInt32 requestId,
+                   const UA_WriteRequest *request, UA_WriteResponse *response,
+                   UA_Boolean *finished) {
+    UA_LOG_DEBUG_SESSION(server->config.logging, session, "Processing WriteRequestAsync");
+    UA_LOCK_ASSERT(&server->serviceMutex);
+
+    if(server->config.maxNodesPerWrite != 0 &&
+       request->nodesToWriteSize > server->config.maxNodesPerWrite) {
+        response->responseHeader.serviceResult = UA_STATUSCODE_BADTOOMANYOPERATIONS;
+        return;
+    }
+
+    UA_AsyncResponse *ar = NULL;
+    response->responseHeader.serviceResult =
+        UA_Server_processServiceOperationsAsync(server, session, requestId,
+                  request->requestHeader.requestHandle,
+                  (UA_AsyncServiceOperation)Operation_WriteAsync, NULL,
+                  &request->nodesToWriteSize, &UA_TYPES[UA_TYPES_WRITEVALUE],
+                  &response->resultsSize, &UA_TYPES[UA_TYPES_STATUSCODE], &ar);
+
+    if(ar) {
+        if(ar->opCountdown > 0) {
+            ar->response.writeResponse = *response;
+            UA_WriteResponse_init(response);
+            *finished = false;
+        } else {
+            UA_AsyncManager_removeAsyncResponse(&server->asyncManager, ar);
+        }
+    }
+}
+
+#endif /* UA_MULTITHREADING >= 100 */
+
 UA_StatusCode
 UA_Server_write(UA_Server *server, const UA_WriteValue *value) {
     UA_StatusCode res = UA_STATUSCODE_GOOD;
@@ -1889,6 +3187,206 @@ writeAttribute(UA_Server *server, UA_Session *session,
     return res;
 }
 
+/* Value Handles
+ * ~~~~~~~~~~~~~
+ * The handle holds a reference to the node from the Nodestore. Every access
+ * re-resolves the NodeId if the Nodestore was modified in the meantime. Some
+ * Nodestores edit a copy of the node. Then the reference points to the
+ * previous version after a write. */
+
+static UA_StatusCode
+resolveValueHandle(UA_Server *server, UA_ValueHandle *h) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+    if(h->node && h->nodestoreChanges == server->nodestoreChanges)
+        return UA_STATUSCODE_GOOD;
+    if(h->node)
+        UA_NODESTORE_RELEASE(server, h->node);
+    h->node = UA_NODESTORE_GET_SELECTIVE(server, &h->nodeId, UA_NODEATTRIBUTESMASK_ALL,
+                                         UA_REFERENCETYPESET_NONE,
+                                         UA_BROWSEDIRECTION_INVALID);
+    if(!h->node)
+        return UA_STATUSCODE_BADNODEIDUNKNOWN;
+    h->nodestoreChanges = server->nodestoreChanges;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* The value is stored in the node without callbacks. And it is a scalar of
+ * exactly the given type. */
+static UA_Boolean
+isPlainScalarValue(const UA_Node *node, const UA_DataType *type) {
+    if(node->head.nodeClass != UA_NODECLASS_VARIABLE)
+        return false;
+    const UA_VariableNode *vn = &node->variableNode;
+    if(vn->valueBackend.backendType != UA_VALUEBACKENDTYPE_NONE ||
+       vn->valueSource != UA_VALUESOURCE_DATA)
+        return false;
+    const UA_DataValue *dv = &vn->value.data.value;
+    return (dv->hasValue && dv->value.type == type &&
+            UA_Variant_isScalar(&dv->value));
+}
+
+UA_StatusCode
+UA_Server_getValueHandle(UA_Server *server, const UA_NodeId nodeId,
+                         UA_ValueHandle **outHandle) {
+    UA_ValueHandle *h = (UA_ValueHandle*)UA_calloc(1, sizeof(UA_ValueHandle));
+    if(!h)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_StatusCode res = UA_NodeId_copy(&nodeId, &h->nodeId);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_free(h);
+        return res;
+    }
+
+    UA_LOCK(&server->serviceMutex);
+    res = resolveValueHandle(server, h);
+    if(res == UA_STATUSCODE_GOOD &&
+       h->node->head.nodeClass != UA_NODECLASS_VARIABLE) {
+        UA_NODESTORE_RELEASE(server, h->node);
+        res = UA_STATUSCODE_BADNODECLASSINVALID;
+    }
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_UNLOCK(&server->serviceMutex);
+        UA_NodeId_clear(&h->nodeId);
+        UA_free(h);
+        return res;
+    }
+    LIST_INSERT_HEAD(&server->valueHandles, h, listEntry);
+    UA_UNLOCK(&server->serviceMutex);
+
+    *outHandle = h;
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+deleteValueHandle(UA_Server *server, UA_ValueHandle *h) {
+    LIST_REMOVE(h, listEntry);
+    if(h->node)
+        UA_NODESTORE_RELEASE(server, h->node);
+    UA_NodeId_clear(&h->nodeId);
+    UA_free(h);
+}
+
+void
+UA_Server_releaseValueHandle(UA_Server *server, UA_ValueHandle *handle) {
+    if(!handle)
+        return;
+    UA_LOCK(&server->serviceMutex);
+    deleteValueHandle(server, handle);
+    UA_UNLOCK(&server->serviceMutex);
+}
+
+void
+clearValueHandles(UA_Server *server) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+    UA_ValueHandle *h, *h_tmp;
+    LIST_FOREACH_SAFE(h, &server->valueHandles, listEntry, h_tmp) {
+        deleteValueHandle(server, h);
+    }
+}
+
+UA_StatusCode
+UA_Server_readValueHandle(UA_Server *server, UA_ValueHandle *handle,
+                          const UA_DataType *type, void *outValue) {
+    UA_LOCK(&server->serviceMutex);
+    UA_StatusCode res = resolveValueHandle(server, handle);
+    if(res != UA_STATUSCODE_GOOD)
+        goto out;
+
+    /* Copy directly out of the node */
+    const UA_VariableNode *vn = &handle->node->variableNode;
+    if(isPlainScalarValue(handle->node, type) && !vn->value.data.callback.onRead) {
+        const UA_DataValue *dv = &vn->value.data.value;
+        if(dv->hasStatus && dv->status != UA_STATUSCODE_GOOD) {
+            res = dv->status;
+            goto out;
+        }
+        res = UA_copy(dv->value.data, outValue, type);
+        goto out;
+    }
+
+    /* Use the Read service */
+    UA_Variant v;
+    res = readWithReadValue(server, &handle->nodeId, UA_ATTRIBUTEID_VALUE, &v);
+    if(res != UA_STATUSCODE_GOOD)
+        goto out;
+    if(!UA_Variant_hasScalarType(&v, type) ||
+       v.storageType != UA_VARIANT_DATA) {
+        UA_Variant_clear(&v);
+        res = UA_STATUSCODE_BADTYPEMISMATCH;
+        goto out;
+    }
+    memcpy(outValue, v.data, type->memSize);
+    UA_free(v.data);
+
+ out:
+    UA_UNLOCK(&server->serviceMutex);
+    return res;
+}
+
+UA_StatusCode
+UA_Server_writeValueHandle(UA_Server *server, UA_ValueHandle *handle,
+                           const UA_DataType *type, const void *value) {
+    UA_LOCK(&server->serviceMutex);
+    UA_StatusCode res = resolveValueHandle(server, handle);
+    if(res != UA_STATUSCODE_GOOD)
+        goto out;
+
+    /* Use the Write service if the type checks cannot be skipped or if
+     * callbacks are involved */
+    const UA_VariableNode *vn = &handle->node->variableNode;
+    if(!isPlainScalarValue(handle->node, type) || !type->pointerFree ||
+       vn->value.data.value.value.storageType != UA_VARIANT_DATA ||
+       vn->value.data.callback.onWrite
+#ifdef UA_ENABLE_HISTORIZING
+       || server->config.historyDatabase.setValue
+#endif
+       ) {
+        res = writeAttribute(server, &server->adminSession, &handle->nodeId,
+                             UA_ATTRIBUTEID_VALUE, value, type);
+        goto out;
+    }
+
+    /* Overwrite the value in place */
+    UA_UInt32 changes = server->nodestoreChanges;
+    UA_Node *node =
+        UA_NODESTORE_GET_EDIT_SELECTIVE(server, &handle->nodeId,
+                                        UA_NODEATTRIBUTESMASK_ALL,
+                                        UA_REFERENCETYPESET_NONE,
+                                        UA_BROWSEDIRECTION_INVALID);
+    if(!node) {
+        res = UA_STATUSCODE_BADNODEIDUNKNOWN;
+        goto out;
+    }
+    UA_DataValue dv;
+    UA_DataValue_init(&dv);
+    dv.hasValue = true;
+    UA_Variant_setScalar(&dv.value, (void*)(uintptr_t)value, type);
+    res = writeValueAttributeWithoutRange(server, &node->variableNode, &dv);
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    if(res == UA_STATUSCODE_GOOD)
+        triggerImmediateDataChange(server, &server->adminSession, node,
+                                   (UA_UInt32)1 << UA_ATTRIBUTEID_VALUE);
+#endif
+    UA_Boolean inPlace = (node == handle->node);
+    UA_StatusCode releaseRes = UA_NODESTORE_RELEASE_EDIT(server, node);
+    if(res == UA_STATUSCODE_GOOD)
+        res = releaseRes;
+
+    /* The Nodestore edits the node in place. Keep the handle valid if there
+     * was no other modification. */
+    if(inPlace && server->nodestoreChanges == changes + 1)
+        handle->nodestoreChanges = server->nodestoreChanges;
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
+    if(res == UA_STATUSCODE_GOOD && ZIP_ROOT(&server->conditionWatchTree))
+        UA_ConditionList_afterWrite(server, &handle->nodeId, &dv.value);
+#endif
+
+ out:
+    UA_UNLOCK(&server->serviceMutex);
+    return res;
+}
+
 #ifdef UA_ENABLE_HISTORIZING
 typedef void
  (*UA_HistoryDatabase_readFunc)(UA_Server *server, void *hdbContext,
@@ -146,22 +146,59 @@ void Service_FindServers(UA_Server *server, UA_Session *session,
                                        &response->servers[pos++]);
 
     registeredServer *current;
-    LIST_FOREACH(current, &dm->registeredServers, pointers) {
-        UA_Boolean usable = (request->serverUrisSize == 0);
-        if(!usable) {
-            /* If client only requested a specific set of servers */
-            for(size_t i = 0; i < request->serverUrisSize; i++) {
-                if(UA_String_equal(&current->registeredServer.serverUri,
-                                   &request->serverUris[i])) {
-                    usable = true;
+    if(request->serverUrisSize > 0) {
+        /* If client only requested a specific set of servers */
+        for(size_t i = 0; i < request->serverUrisSize && pos < maxResults; i++) {
+            current = UA_DiscoveryManager_findRegisteredServer(dm, &request->serverUris[i]);
+            if(!current)
+                continue;
+            /* Skip duplicates in the request */
+            UA_Boolean duplicate = false;
+            for(size_t j = 0; j < i; j++) {
+                if(UA_String_equal(&request->serverUris[j], &request->serverUris[i])) {
+                    duplicate = true;
                     break;
                 }
             }
+            if(!duplicate)
+                setApplicationDescriptionFromRegisteredServer(request, &response->servers[pos++],
+                                                              &current->registeredServer);
         }
-
-        if(usable)
+    } else if(request->localeIdsSize > 0) {
+        /* The ApplicationName depends on the requested locales */
+        LIST_FOREACH(current, &dm->registeredServers, pointers) {
             setApplicationDescriptionFromRegisteredServer(request, &response->servers[pos++],
                                                           &current->registeredServer);
+        }
+    } else {
+        /* Without a filter the response only changes with the registrations */
+        if(!dm->findServersCacheValid) {
+            UA_FindServersRequest noFilter;
+            UA_FindServersRequest_init(&noFilter);
+            dm->findServersCache = (UA_ApplicationDescription*)
+                UA_Array_new(dm->registeredServersSize,
+                             &UA_TYPES[UA_TYPES_APPLICATIONDESCRIPTION]);
+            if(dm->findServersCache || dm->registeredServersSize == 0) {
+                size_t cachePos = 0;
+                LIST_FOREACH(current, &dm->registeredServers, pointers) {
+                    setApplicationDescriptionFromRegisteredServer(&noFilter,
+                                                                  &dm->findServersCache[cachePos++],
+                                                                  &current->registeredServer);
+                }
+                dm->findServersCacheSize = cachePos;
+                dm->findServersCacheValid = true;
+            }
+        }
+        if(dm->findServersCacheValid) {
+            for(size_t i = 0; i < dm->findServersCacheSize; i++)
+                UA_ApplicationDescription_copy(&dm->findServersCache[i],
+                                               &response->servers[pos++]);
+        } else {
+            LIST_FOREACH(current, &dm->registeredServers, pointers) {
+                setApplicationDescriptionFromRegisteredServer(request, &response->servers[pos++],
+                                                              &current->registeredServer);
+            }
+        }
     }
 
     /* Set the final size */
@@ -459,6 +496,111 @@ setCurrentEndPointsArray(UA_Server *server, const UA_String endpointUrl,
     return retval;
 }
 
+static void
+clearEndpointsCacheEntry(UA_EndpointsCacheEntry *e) {
+    UA_String_clear(&e->endpointUrl);
+    UA_Array_delete(e->profileUris, e->profileUrisSize, &UA_TYPES[UA_TYPES_STRING]);
+    UA_ByteString_clear(&e->encoded);
+    memset(e, 0, sizeof(UA_EndpointsCacheEntry));
+}
+
+void
+clearEndpointsCache(UA_Server *server) {
+    UA_EndpointsCache *ec = &server->endpointsCache;
+    for(size_t i = 0; i < ec->size; i++)
+        clearEndpointsCacheEntry(&ec->entries[i]);
+    ec->size = 0;
+    ec->next = 0;
+}
+
+static UA_Boolean
+endpointsCacheEntryMatches(const UA_EndpointsCacheEntry *e,
+                           const UA_GetEndpointsRequest *request) {
+    if(!UA_String_equal(&e->endpointUrl, &request->endpointUrl) ||
+       e->profileUrisSize != request->profileUrisSize)
+        return false;
+    for(size_t i = 0; i < e->profileUrisSize; i++) {
+        if(!UA_String_equal(&e->profileUris[i], &request->profileUris[i]))
+            return false;
+    }
+    return true;
+}
+
+/* Encode the array length and the elements as in the GetEndpointsResponse */
+static UA_StatusCode
+encodeEndpointsArray(const UA_EndpointDescription *eds, size_t edsSize,
+                     UA_ByteString *encoded) {
+    const UA_DataType *edType = &UA_TYPES[UA_TYPES_ENDPOINTDESCRIPTION];
+    size_t len = 4;
+    for(size_t i = 0; i < edsSize; i++)
+        len += UA_calcSizeBinary(&eds[i], edType);
+    UA_StatusCode res = UA_ByteString_allocBuffer(encoded, len);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    UA_Byte *pos = encoded->data;
+    const UA_Byte *end = &encoded->data[len];
+    UA_Int32 signedSize = (UA_Int32)edsSize;
+    res = UA_encodeBinaryInternal(&signedSize, &UA_TYPES[UA_TYPES_INT32],
+                                  &pos, &end, NULL, NULL);
+    for(size_t i = 0; i < edsSize && res == UA_STATUSCODE_GOOD; i++)
+        res = UA_encodeBinaryInternal(&eds[i], edType, &pos, &end, NULL, NULL);
+    if(res != UA_STATUSCODE_GOOD)
+        UA_ByteString_clear(encoded);
+    return res;
+}
+
+/* Returns the encoded EndpointDescription array for the request. Build and add
+ * to the cache if not found. Returns NULL if the array cannot be built. Then
+ * the caller falls back to setCurrentEndPointsArray to get the StatusCode. */
+static const UA_ByteString *
+getCachedEndpoints(UA_Server *server, const UA_GetEndpointsRequest *request) {
+    UA_EndpointsCache *ec = &server->endpointsCache;
+    if(ec->epoch != server->endpointsEpoch) {
+        clearEndpointsCache(server);
+        ec->epoch = server->endpointsEpoch;
+    }
+
+    for(size_t i = 0; i < ec->size; i++) {
+        if(endpointsCacheEntryMatches(&ec->entries[i], request))
+            return &ec->entries[i].encoded;
+    }
+
+    /* Build and encode the array */
+    UA_EndpointsCacheEntry e;
+    memset(&e, 0, sizeof(UA_EndpointsCacheEntry));
+    UA_EndpointDescription *eds = NULL;
+    size_t edsSize = 0;
+    UA_StatusCode res =
+        setCurrentEndPointsArray(server, request->endpointUrl,
+                                 request->profileUris, request->profileUrisSize,
+                                 &eds, &edsSize);
+    if(res != UA_STATUSCODE_GOOD)
+        return NULL;
+    res = encodeEndpointsArray(eds, edsSize, &e.encoded);
+    UA_Array_delete(eds, edsSize, &UA_TYPES[UA_TYPES_ENDPOINTDESCRIPTION]);
+    res |= UA_String_copy(&request->endpointUrl, &e.endpointUrl);
+    res |= UA_Array_copy(request->profileUris, request->profileUrisSize,
+                         (void**)&e.profileUris, &UA_TYPES[UA_TYPES_STRING]);
+    e.profileUrisSize = request->profileUrisSize;
+    if(res != UA_STATUSCODE_GOOD) {
+        clearEndpointsCacheEntry(&e);
+        return NULL;
+    }
+
+    /* Insert. Replace the oldest entry if the cache is full. */
+    size_t slot = ec->size;
+    if(slot < UA_ENDPOINTSCACHE_SIZE) {
+        ec->size++;
+    } else {
+        slot = ec->next;
+        ec->next = (ec->next + 1) % UA_ENDPOINTSCACHE_SIZE;
+        clearEndpointsCacheEntry(&ec->entries[slot]);
+    }
+    ec->entries[slot] = e;
+    return &ec->entries[slot].encoded;
+}
+
 void
 Service_GetEndpoints(UA_Server *server, UA_Session *session,
                      const UA_GetEndpointsRequest *request,
@@ -476,14 +618,22 @@ Service_GetEndpoints(UA_Server *server, UA_Session *session,
                              "Processing GetEndpointsRequest with an empty endpointUrl");
     }
 
-    response->responseHeader.serviceResult =
-        setCurrentEndPointsArray(server, request->endpointUrl,
-                                 request->profileUris, request->profileUrisSize,
-                                 &response->endpoints, &response->endpointsSize);
+    /* Answer with the encoded array from the cache. It is appended to the
+     * ResponseHeader by sendResponse. Connection storms where every client
+     * requests the same endpoints don't rebuild and re-encode the array. */
+    UA_SecureChannel *channel = session->channel;
+    const UA_ByteString *encoded = getCachedEndpoints(server, request);
+    if(encoded) {
+        channel->encodedResponseBody = encoded;
+    } else {
+        response->responseHeader.serviceResult =
+            setCurrentEndPointsArray(server, request->endpointUrl,
+                                     request->profileUris, request->profileUrisSize,
+                                     &response->endpoints, &response->endpointsSize);
+    }
 
     /* Check if the ServerUrl is already present in the DiscoveryUrl array.
      * Add if not already there. */
-    UA_SecureChannel *channel = session->channel;
     for(size_t i = 0; i < server->config.applicationDescription.discoveryUrlsSize; i++) {
         if(UA_String_equal(&channel->endpointUrl,
                            &server->config.applicationDescription.discoveryUrls[i])) {
@@ -498,6 +648,7 @@ Service_GetEndpoints(UA_Server *server, UA_Session *session,
     retval = UA_Array_appendCopy((void**)&server->config.applicationDescription.discoveryUrls,
                         &server->config.applicationDescription.discoveryUrlsSize,
                         &request->endpointUrl, &UA_TYPES[UA_TYPES_STRING]);
+    server->endpointsEpoch++;
     if(retval != UA_STATUSCODE_GOOD)
         UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_SERVER,
                      "Error adding the ServerUrl to theDiscoverUrl list.");
@@ -529,11 +680,8 @@ process_RegisterServer(UA_Server *server, UA_Session *session,
     }
 
     /* Find the server from the request in the registered list */
-    registeredServer *rs = NULL;
-    LIST_FOREACH(rs, &dm->registeredServers, pointers) {
-        if(UA_String_equal(&rs->registeredServer.serverUri, &requestServer->serverUri))
-            break;
-    }
+    registeredServer *rs =
+        UA_DiscoveryManager_findRegisteredServer(dm, &requestServer->serverUri);
 
     UA_MdnsDiscoveryConfiguration *mdnsConfig = NULL;
 
@@ -633,11 +781,14 @@ process_RegisterServer(UA_Server *server, UA_Session *session,
             UA_LOCK(&server->serviceMutex);
         }
 
-        // server found, remove from list
-        LIST_REMOVE(rs, pointers);
-        UA_RegisteredServer_clear(&rs->registeredServer);
-        UA_free(rs);
-        dm->registeredServersSize--;
+        // server found, remove from list. The callback has released the
+        // lock. Look up the entry again.
+        rs = UA_DiscoveryManager_findRegisteredServer(dm, &requestServer->serverUri);
+        if(rs) {
+            UA_DiscoveryManager_unlinkRegisteredServer(dm, rs);
+            UA_RegisteredServer_clear(&rs->registeredServer);
+            UA_free(rs);
+        }
         responseHeader->serviceResult = UA_STATUSCODE_GOOD;
         return;
     }
@@ -649,15 +800,14 @@ process_RegisterServer(UA_Server *server, UA_Session *session,
                              "Registering new server: %S",
                              requestServer->serverUri);
 
-        rs = (registeredServer*)UA_malloc(sizeof(registeredServer));
+        rs = (registeredServer*)UA_calloc(1, sizeof(registeredServer));
         if(!rs) {
             responseHeader->serviceResult = UA_STATUSCODE_BADOUTOFMEMORY;
             return;
         }
-
-        LIST_INSERT_HEAD(&dm->registeredServers, rs, pointers);
-        dm->registeredServersSize++;
     } else {
+        /* Remove from the indexes while the entry is updated */
+        UA_DiscoveryManager_unlinkRegisteredServer(dm, rs);
         UA_RegisteredServer_clear(&rs->registeredServer);
     }
 
@@ -675,8 +825,14 @@ process_RegisterServer(UA_Server *server, UA_Session *session,
     // copy the data from the request into the list
     UA_EventLoop *el = server->config.eventLoop;
     UA_DateTime nowMonotonic = el->dateTime_nowMonotonic(el);
-    UA_RegisteredServer_copy(requestServer, &rs->registeredServer);
+    retval = UA_RegisteredServer_copy(requestServer, &rs->registeredServer);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_free(rs);
+        responseHeader->serviceResult = retval;
+        return;
+    }
     rs->lastSeen = nowMonotonic;
+    UA_DiscoveryManager_linkRegisteredServer(dm, rs);
     responseHeader->serviceResult = retval;
 }
 
@@ -63,25 +63,35 @@ getArgumentsVariableNode(UA_Server *server, const UA_NodeHead *head,
     return NULL;
 }
 
-/* inputArgumentResults has the length request->inputArgumentsSize */
+/* Copy the argument definitions from the "InputArguments" node. A scalar
+ * argument value is interpreted as an array of length 1. */
 static UA_StatusCode
-checkAdjustArguments(UA_Server *server, UA_Session *session,
-                     const UA_VariableNode *argRequirements, size_t argsSize,
-                     UA_Variant *args, UA_StatusCode *inputArgumentResults) {
+copyArgumentDefinitions(const UA_VariableNode *argRequirements,
+                        UA_Argument **argReqs, size_t *argReqsSize) {
     /* Verify that we have a Variant containing UA_Argument (scalar or array) in
      * the "InputArguments" node */
     if(argRequirements->valueSource != UA_VALUESOURCE_DATA)
         return UA_STATUSCODE_BADINTERNALERROR;
     if(!argRequirements->value.data.value.hasValue)
         return UA_STATUSCODE_BADINTERNALERROR;
-    if(argRequirements->value.data.value.value.type != &UA_TYPES[UA_TYPES_ARGUMENT])
+    const UA_Variant *v = &argRequirements->value.data.value.value;
+    if(v->type != &UA_TYPES[UA_TYPES_ARGUMENT])
         return UA_STATUSCODE_BADINTERNALERROR;
+    size_t size = (UA_Variant_isScalar(v)) ? 1 : v->arrayLength;
+    UA_StatusCode res = UA_Array_copy(v->data, size, (void**)argReqs,
+                                      &UA_TYPES[UA_TYPES_ARGUMENT]);
+    if(res == UA_STATUSCODE_GOOD)
+        *argReqsSize = size;
+    return res;
+}
 
-    /* Verify the number of arguments. A scalar argument value is interpreted as
-     * an array of length 1. */
-    size_t argReqsSize = argRequirements->value.data.value.value.arrayLength;
-    if(UA_Variant_isScalar(&argRequirements->value.data.value.value))
-        argReqsSize = 1;
+/* inputArgumentResults has the length request->inputArgumentsSize */
+static UA_StatusCode
+checkAdjustArguments(UA_Server *server, UA_Session *session,
+                     const UA_Argument *argReqs, size_t argReqsSize,
+                     size_t argsSize, UA_Variant *args,
+                     UA_StatusCode *inputArgumentResults) {
+    /* Verify the number of arguments */
     if(argReqsSize > argsSize)
         return UA_STATUSCODE_BADARGUMENTSMISSING;
     if(argReqsSize < argsSize)
@@ -89,7 +99,6 @@ checkAdjustArguments(UA_Server *server, UA_Session *session,
 
     /* Type-check every argument against the definition */
     UA_StatusCode retval = UA_STATUSCODE_GOOD;
-    UA_Argument *argReqs = (UA_Argument*)argRequirements->value.data.value.value.data;
     const char *reason;
     for(size_t i = 0; i < argReqsSize; ++i) {
         /* Incompatible value. Try to correct the type if possible. */
@@ -197,40 +206,18 @@ checkFunctionalGroupMethodReference(UA_Server *server, const UA_NodeHead *h,
     return UA_STATUSCODE_GOOD;
 }
 
-static void
-callWithMethodAndObject(UA_Server *server, UA_Session *session,
-                        const UA_CallMethodRequest *request, UA_CallMethodResult *result,
-                        const UA_MethodNode *method, const UA_ObjectNode *object) {
-    UA_LOCK_ASSERT(&server->serviceMutex);
-
-    /* Verify the object's NodeClass */
-    if(object->head.nodeClass != UA_NODECLASS_OBJECT &&
-       object->head.nodeClass != UA_NODECLASS_OBJECTTYPE) {
-        result->statusCode = UA_STATUSCODE_BADNODECLASSINVALID;
-        return;
-    }
-
-    /* Verify the method's NodeClass */
-    if(method->head.nodeClass != UA_NODECLASS_METHOD) {
-        result->statusCode = UA_STATUSCODE_BADNODECLASSINVALID;
-        return;
-    }
-
-    /* Is there a method to execute? */
-    if(!method->method) {
-        result->statusCode = UA_STATUSCODE_BADINTERNALERROR;
-        return;
-    }
-
-    /* Verify method/object relations. Object must have a hasComponent or a
-     * subtype of hasComponent reference to the method node. Therefore, check
-     * every reference between the parent object and the method node if there is
-     * a hasComponent (or subtype) reference */
-    UA_ExpandedNodeId methodId = UA_EXPANDEDNODEID_NODEID(request->methodId);
+/* Verify method/object relations. Object must have a hasComponent or a subtype
+ * of hasComponent reference to the method node. Therefore, check every
+ * reference between the parent object and the method node if there is a
+ * hasComponent (or subtype) reference. */
+static UA_StatusCode
+checkMethodObjectRelation(UA_Server *server, const UA_ObjectNode *object,
+                          const UA_NodeId *methodNodeId) {
+    UA_ExpandedNodeId methodId = UA_EXPANDEDNODEID_NODEID(*methodNodeId);
     UA_ReferenceTypeSet hasComponentRefs;
-    result->statusCode = referenceTypeIndices(server, &hasComponentNodeId,
-                                              &hasComponentRefs, true);
-    UA_CHECK_STATUS(result->statusCode, return);
+    UA_StatusCode res = referenceTypeIndices(server, &hasComponentNodeId,
+                                             &hasComponentRefs, true);
+    UA_CHECK_STATUS(res, return res);
     UA_Boolean found = checkMethodReference(&object->head, hasComponentRefs, &methodId);
 
     if(!found) {
@@ -256,14 +243,176 @@ callWithMethodAndObject(UA_Server *server, UA_Session *session,
          * ParameterSet and MethodSet) in (Functional) groups for instance
          * Configuration or Identification. The same Property, Parameter or
          * Method can be referenced from more than one FunctionalGroup. */
-        result->statusCode =
-            checkFunctionalGroupMethodReference(server, &object->head, &methodId, &found);
-        if(!found && result->statusCode == UA_STATUSCODE_GOOD)
-            result->statusCode = UA_STATUSCODE_BADMETHODINVALID;
-        UA_CHECK_STATUS(result->statusCode, return);
+        res = checkFunctionalGroupMethodReference(server, &object->head, &methodId, &found);
+        if(!found && res == UA_STATUSCODE_GOOD)
+            res = UA_STATUSCODE_BADMETHODINVALID;
     }
+    return res;
+}
+
+/********************/
+/* MethodCall Cache */
+/********************/
+
+static void
+freeMethodCallCacheEntry(UA_MethodCallCacheEntry *e) {
+    UA_NodeId_clear(&e->objectId);
+    UA_NodeId_clear(&e->methodId);
+    UA_Array_delete(e->inputArguments, e->inputArgumentsSize,
+                    &UA_TYPES[UA_TYPES_ARGUMENT]);
+    UA_free(e);
+}
+
+void
+clearMethodCallCache(UA_Server *server) {
+    UA_MethodCallCache *mcc = &server->methodCallCache;
+    UA_MethodCallCacheEntry *e, *e_tmp;
+    TAILQ_FOREACH_SAFE(e, &mcc->lru, lruEntry, e_tmp) {
+        TAILQ_REMOVE(&mcc->lru, e, lruEntry);
+        LIST_REMOVE(e, bucketEntry);
+        freeMethodCallCacheEntry(e);
+    }
+    mcc->size = 0;
+}
+
+/* Empty the cache if the references or the argument definitions have changed
+ * since the entries were added */
+static void
+checkMethodCallCacheEpoch(UA_Server *server) {
+    UA_MethodCallCache *mcc = &server->methodCallCache;
+    if(mcc->hierarchyEpoch == server->hierarchyEpoch &&
+       mcc->argumentsEpoch == server->methodArgumentsEpoch)
+        return;
+    clearMethodCallCache(server);
+    mcc->hierarchyEpoch = server->hierarchyEpoch;
+    mcc->argumentsEpoch = server->methodArgumentsEpoch;
+}
+
+static UA_StatusCode
+resolveMethodCallCacheEntry(UA_Server *server, UA_MethodCallCacheEntry *e,
+                            const UA_MethodNode *method, const UA_ObjectNode *object) {
+    e->relationStatus = checkMethodObjectRelation(server, object, &method->head.nodeId);
+    if(e->relationStatus != UA_STATUSCODE_GOOD)
+        return (e->relationStatus == UA_STATUSCODE_BADMETHODINVALID) ?
+            UA_STATUSCODE_GOOD : e->relationStatus;
+
+    const UA_VariableNode *inputArguments =
+        getArgumentsVariableNode(server, &method->head, UA_STRING("InputArguments"));
+    if(inputArguments) {
+        e->hasInputArguments = true;
+        e->inputArgumentsStatus =
+            copyArgumentDefinitions(inputArguments, &e->inputArguments,
+                                    &e->inputArgumentsSize);
+        UA_NODESTORE_RELEASE(server, (const UA_Node*)inputArguments);
+        if(e->inputArgumentsStatus == UA_STATUSCODE_BADOUTOFMEMORY)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+
+    const UA_VariableNode *outputArguments =
+        getArgumentsVariableNode(server, &method->head, UA_STRING("OutputArguments"));
+    if(outputArguments) {
+        e->outputArgumentsSize = outputArguments->value.data.value.value.arrayLength;
+        UA_NODESTORE_RELEASE(server, (const UA_Node*)outputArguments);
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Returns the cache entry for the (object, method) pair. The entry is only
+ * valid until the server lock is released. */
+static UA_MethodCallCacheEntry *
+getMethodCallCacheEntry(UA_Server *server, const UA_MethodNode *method,
+                        const UA_ObjectNode *object, UA_StatusCode *res) {
+    checkMethodCallCacheEpoch(server);
+    UA_MethodCallCache *mcc = &server->methodCallCache;
+    UA_UInt32 objectHash = UA_NodeId_hash(&object->head.nodeId);
+    UA_UInt32 hash = UA_ByteString_hash(UA_NodeId_hash(&method->head.nodeId),
+                                        (const UA_Byte*)&objectHash,
+                                        sizeof(UA_UInt32));
+    UA_MethodCallCacheEntry *e;
+    LIST_FOREACH(e, &mcc->buckets[hash & (UA_METHODCALLCACHE_BUCKETS - 1)],
+                 bucketEntry) {
+        if(e->hash != hash ||
+           !UA_NodeId_equal(&e->methodId, &method->head.nodeId) ||
+           !UA_NodeId_equal(&e->objectId, &object->head.nodeId))
+            continue;
+        /* Move to the front of the LRU list */
+        TAILQ_REMOVE(&mcc->lru, e, lruEntry);
+        TAILQ_INSERT_HEAD(&mcc->lru, e, lruEntry);
+        return e;
+    }
+
+    /* Resolve a new entry */
+    e = (UA_MethodCallCacheEntry*)UA_calloc(1, sizeof(UA_MethodCallCacheEntry));
+    if(!e) {
+        *res = UA_STATUSCODE_BADOUTOFMEMORY;
+        return NULL;
+    }
+    *res = UA_NodeId_copy(&object->head.nodeId, &e->objectId);
+    *res |= UA_NodeId_copy(&method->head.nodeId, &e->methodId);
+    if(*res == UA_STATUSCODE_GOOD)
+        *res = resolveMethodCallCacheEntry(server, e, method, object);
+    if(*res != UA_STATUSCODE_GOOD) {
+        /* Don't cache errors that may be transient (e.g. out-of-memory) */
+        freeMethodCallCacheEntry(e);
+        return NULL;
+    }
+
+    /* Evict the least recently used entry */
+    if(mcc->size >= UA_METHODCALLCACHE_SIZE) {
+        UA_MethodCallCacheEntry *last = TAILQ_LAST(&mcc->lru, UA_MethodCallCacheLru);
+        TAILQ_REMOVE(&mcc->lru, last, lruEntry);
+        LIST_REMOVE(last, bucketEntry);
+        freeMethodCallCacheEntry(last);
+        mcc->size--;
+    }
+
+    e->hash = hash;
+    TAILQ_INSERT_HEAD(&mcc->lru, e, lruEntry);
+    LIST_INSERT_HEAD(&mcc->buckets[hash & (UA_METHODCALLCACHE_BUCKETS - 1)],
+                     e, bucketEntry);
+    mcc->size++;
+    return e;
+}
+
+static void
+callWithMethodAndObject(UA_Server *server, UA_Session *session,
+                        const UA_CallMethodRequest *request, UA_CallMethodResult *result,
+                        const UA_MethodNode *method, const UA_ObjectNode *object) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+
+    /* Verify the object's NodeClass */
+    if(object->head.nodeClass != UA_NODECLASS_OBJECT &&
+       object->head.nodeClass != UA_NODECLASS_OBJECTTYPE) {
+        result->statusCode = UA_STATUSCODE_BADNODECLASSINVALID;
+        return;
+    }
+
+    /* Verify the method's NodeClass */
+    if(method->head.nodeClass != UA_NODECLASS_METHOD) {
+        result->statusCode = UA_STATUSCODE_BADNODECLASSINVALID;
+        return;
+    }
+
+    /* Is there a method to execute? */
+    if(!method->method) {
+        result->statusCode = UA_STATUSCODE_BADINTERNALERROR;
+        return;
+    }
+
+    /* Verify method/object relations. The result is cached together with the
+     * argument definitions until the references change. */
+    UA_MethodCallCacheEntry *e =
+        getMethodCallCacheEntry(server, method, object, &result->statusCode);
+    if(!e)
+        return;
+    result->statusCode = e->relationStatus;
+    UA_CHECK_STATUS(result->statusCode, return);
 
     /* Verify access rights */
+    if(!checkRolePermission(server, session, &method->head, UA_ROLEPERMISSION_CALL)) {
+        result->statusCode = UA_STATUSCODE_BADUSERACCESSDENIED;
+        return;
+    }
     UA_Boolean executable = method->executable;
     if(session != &server->adminSession) {
         UA_UNLOCK(&server->serviceMutex);
@@ -304,14 +453,20 @@ callWithMethodAndObject(UA_Server *server, UA_Session *session,
     }
     result->inputArgumentResultsSize = request->inputArgumentsSize;
 
+    /* Get the cache entry again. The lock was released for the access
+     * control callback. */
+    e = getMethodCallCacheEntry(server, method, object, &result->statusCode);
+    if(!e)
+        return;
+
     /* Type-check the input arguments */
-    const UA_VariableNode *inputArguments =
-        getArgumentsVariableNode(server, &method->head, UA_STRING("InputArguments"));
-    if(inputArguments) {
-        result->statusCode =
-            checkAdjustArguments(server, session, inputArguments, request->inputArgumentsSize,
-                                 mutableInputArgs, result->inputArgumentResults);
-        UA_NODESTORE_RELEASE(server, (const UA_Node*)inputArguments);
+    if(e->hasInputArguments) {
+        result->statusCode = e->inputArgumentsStatus;
+        if(result->statusCode == UA_STATUSCODE_GOOD)
+            result->statusCode =
+                checkAdjustArguments(server, session, e->inputArguments,
+                                     e->inputArgumentsSize, request->inputArgumentsSize,
+                                     mutableInputArgs, result->inputArgumentResults);
     } else {
         if(request->inputArgumentsSize > 0) {
             result->statusCode = UA_STATUSCODE_BADTOOMANYARGUMENTS;
@@ -331,14 +486,8 @@ callWithMethodAndObject(UA_Server *server, UA_Session *session,
     if(result->statusCode != UA_STATUSCODE_GOOD)
         return;
 
-    /* Get the output arguments node */
-    const UA_VariableNode *outputArguments =
-        getArgumentsVariableNode(server, &method->head, UA_STRING("OutputArguments"));
-
     /* Allocate the output arguments array */
-    size_t outputArgsSize = 0;
-    if(outputArguments)
-        outputArgsSize = outputArguments->value.data.value.value.arrayLength;
+    size_t outputArgsSize = e->outputArgumentsSize;
     result->outputArguments = (UA_Variant*)
         UA_Array_new(outputArgsSize, &UA_TYPES[UA_TYPES_VARIANT]);
     if(!result->outputArguments) {
@@ -347,9 +496,6 @@ callWithMethodAndObject(UA_Server *server, UA_Session *session,
     }
     result->outputArgumentsSize = outputArgsSize;
 
-    /* Release the output arguments node */
-    UA_NODESTORE_RELEASE(server, (const UA_Node*)outputArguments);
-
     /* Call the method */
     UA_UNLOCK(&server->serviceMutex);
     result->statusCode = method->method(server, &session->sessionId, session->context,
@@ -364,8 +510,8 @@ callWithMethodAndObject(UA_Server *server, UA_Session *session,
 #if UA_MULTITHREADING >= 100
 
 static void
-Operation_CallMethodAsync(UA_Server *server, UA_Session *session, UA_UInt32 requestId,
-                          UA_UInt32 requestHandle, size_t opIndex,
+Operation_CallMethodAsync(UA_Server *server, UA_Session *session, const void *context,
+                          UA_UInt32 requestId, UA_UInt32 requestHandle, size_t opIndex,
                           UA_CallMethodRequest *opRequest, UA_CallMethodResult *opResult,
                           UA_AsyncResponse **ar) {
     /* Get the method node. We only need the nodeClass and executable attribute.
@@ -442,7 +588,7 @@ Service_CallAsync(UA_Server *server, UA_Session *session, UA_UInt32 requestId,
     response->responseHeader.serviceResult =
         UA_Server_processServiceOperationsAsync(server, session, requestId,
                   request->requestHeader.requestHandle,
-                  (UA_AsyncServiceOperation)Operation_CallMethodAsync,
+                  (UA_AsyncServiceOperation)Operation_CallMethodAsync, NULL,
                   &request->methodsToCallSize, &UA_TYPES[UA_TYPES_CALLMETHODREQUEST],
                   &response->resultsSize, &UA_TYPES[UA_TYPES_CALLMETHODRESULT], &ar);
 
@@ -462,7 +608,7 @@ Service_CallAsync(UA_Server *server, UA_Session *session, UA_UInt32 requestId,
 }
 #endif
 
-static void
+void
 Operation_CallMethod(UA_Server *server, UA_Session *session, void *context,
                      const UA_CallMethodRequest *request, UA_CallMethodResult *result) {
     /* Get the method node. We only need the nodeClass and executable attribute.
@@ -25,21 +25,48 @@
 
 #ifdef UA_ENABLE_SUBSCRIPTIONS /* conditional compilation */
 
+/* Lookups that are shared between the items of a CreateMonitoredItems
+ * request. Adjacent items often monitor the same variable (e.g. with different
+ * index ranges or deadbands). */
+typedef struct {
+    UA_NodeId nodeId; /* The node of the cached lookups */
 #ifdef UA_ENABLE_DA
+    UA_Boolean euRangeKnown;
+    UA_StatusCode euRangeRes;
+    UA_Range euRange;
+#endif
+    UA_Boolean minSamplingKnown;
+    UA_Boolean isVariable;
+    UA_Double minimumSamplingInterval;
+} MonitoredItemLookupCache;
 
-/* Translate a percentage deadband into an absolute deadband based on the
- * UARange property of the variable */
-static UA_StatusCode
-setAbsoluteFromPercentageDeadband(UA_Server *server, UA_Session *session,
-                                  const UA_MonitoredItem *mon, UA_DataChangeFilter *filter) {
-    /* A valid deadband? */
-    if(filter->deadbandValue < 0.0 || filter->deadbandValue > 100.0)
-        return UA_STATUSCODE_BADMONITOREDITEMFILTERUNSUPPORTED;
+/* Reset the cache if the node changes */
+static void
+MonitoredItemLookupCache_use(MonitoredItemLookupCache *cache,
+                             const UA_NodeId *nodeId) {
+    if(UA_NodeId_equal(&cache->nodeId, nodeId))
+        return;
+    UA_NodeId_clear(&cache->nodeId);
+    memset(cache, 0, sizeof(MonitoredItemLookupCache));
+    if(UA_NodeId_copy(nodeId, &cache->nodeId) != UA_STATUSCODE_GOOD)
+        UA_NodeId_init(&cache->nodeId); /* The lookups are not cached */
+}
 
+static void
+MonitoredItemLookupCache_clear(MonitoredItemLookupCache *cache) {
+    UA_NodeId_clear(&cache->nodeId);
+    memset(cache, 0, sizeof(MonitoredItemLookupCache));
+}
+
+#ifdef UA_ENABLE_DA
+
+/* Look up the EURange property of the variable */
+static UA_StatusCode
+lookupEURange(UA_Server *server, UA_Session *session,
+              const UA_NodeId *nodeId, UA_Range *range) {
     /* Browse for the percent range */
     UA_QualifiedName qn = UA_QUALIFIEDNAME(0, "EURange");
-    UA_BrowsePathResult bpr =
-        browseSimplifiedBrowsePath(server, mon->itemToMonitor.nodeId, 1, &qn);
+    UA_BrowsePathResult bpr = browseSimplifiedBrowsePath(server, *nodeId, 1, &qn);
     if(bpr.statusCode != UA_STATUSCODE_GOOD || bpr.targetsSize < 1) {
         UA_BrowsePathResult_clear(&bpr);
         return UA_STATUSCODE_BADMONITOREDITEMFILTERUNSUPPORTED;
@@ -58,18 +85,44 @@ setAbsoluteFromPercentageDeadband(UA_Server *server, UA_Session *session,
         UA_DataValue_clear(&rangeVal);
         return UA_STATUSCODE_BADMONITOREDITEMFILTERUNSUPPORTED;
     }
+    *range = *(UA_Range*)rangeVal.value.data;
+    UA_DataValue_clear(&rangeVal);
+    return UA_STATUSCODE_GOOD;
+}
 
-    /* Compute the abs deadband */
-    UA_Range *euRange = (UA_Range*)rangeVal.value.data;
-    UA_Double absDeadband = (filter->deadbandValue/100.0) * (euRange->high - euRange->low);
+/* Translate a percentage deadband into an absolute deadband based on the
+ * UARange property of the variable */
+static UA_StatusCode
+setAbsoluteFromPercentageDeadband(UA_Server *server, UA_Session *session,
+                                  const UA_MonitoredItem *mon, UA_DataChangeFilter *filter,
+                                  MonitoredItemLookupCache *cache) {
+    /* A valid deadband? */
+    if(filter->deadbandValue < 0.0 || filter->deadbandValue > 100.0)
+        return UA_STATUSCODE_BADMONITOREDITEMFILTERUNSUPPORTED;
 
-    UA_DataValue_clear(&rangeVal);
+    /* Look up the EURange or take it from the cache */
+    UA_Range euRange;
+    UA_StatusCode res;
+    if(cache && cache->euRangeKnown) {
+        res = cache->euRangeRes;
+        euRange = cache->euRange;
+    } else {
+        res = lookupEURange(server, session, &mon->itemToMonitor.nodeId, &euRange);
+        if(cache) {
+            cache->euRangeKnown = true;
+            cache->euRangeRes = res;
+            cache->euRange = euRange;
+        }
+    }
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    /* Compute the abs deadband */
+    UA_Double absDeadband = (filter->deadbandValue/100.0) * (euRange.high - euRange.low);
 
     /* EURange invalid or NaN? */
-    if(absDeadband < 0.0 || absDeadband != absDeadband) {
-        UA_DataValue_clear(&rangeVal);
+    if(absDeadband < 0.0 || absDeadband != absDeadband)
         return UA_STATUSCODE_BADMONITOREDITEMFILTERUNSUPPORTED;
-    }
 
     /* Adjust the original filter */
     filter->deadbandType = UA_DEADBANDTYPE_ABSOLUTE;
@@ -218,7 +271,8 @@ checkAdjustMonitoredItemParams(UA_Server *server, UA_Session *session,
                                const UA_MonitoredItem *mon,
                                const UA_DataType* valueType,
                                UA_MonitoringParameters *params,
-                               UA_ExtensionObject *filterResult) {
+                               UA_ExtensionObject *filterResult,
+                               MonitoredItemLookupCache *cache) {
     UA_LOCK_ASSERT(&server->serviceMutex);
 
     /* Check the filter */
@@ -266,7 +320,8 @@ checkAdjustMonitoredItemParams(UA_Server *server, UA_Session *session,
                 /* If percentage deadband is supported, look up the range values
                  * and precompute as if it was an absolute deadband. */
                 UA_StatusCode res =
-                    setAbsoluteFromPercentageDeadband(server, session, mon, filter);
+                    setAbsoluteFromPercentageDeadband(server, session, mon,
+                                                      filter, cache);
                 if(res != UA_STATUSCODE_GOOD)
                     return res;
                 break;
@@ -281,22 +336,36 @@ checkAdjustMonitoredItemParams(UA_Server *server, UA_Session *session,
     /* Read the minimum sampling interval for the variable. The sampling
      * interval of the MonitoredItem must not be less than that. */
     if(mon->itemToMonitor.attributeId == UA_ATTRIBUTEID_VALUE) {
-        const UA_Node *node = UA_NODESTORE_GET(server, &mon->itemToMonitor.nodeId);
-        if(node) {
-            const UA_VariableNode *vn = &node->variableNode;
-            if(node->head.nodeClass == UA_NODECLASS_VARIABLE) {
-                /* Take into account if the publishing interval is used for sampling */
-                UA_Double samplingInterval = params->samplingInterval;
-                if(samplingInterval < 0 && mon->subscription)
-                    samplingInterval = mon->subscription->publishingInterval;
-                /* Adjust if smaller than the allowed minimum for the variable */
-                if(samplingInterval < vn->minimumSamplingInterval)
-                    params->samplingInterval = vn->minimumSamplingInterval;
+        UA_Boolean isVariable = false;
+        UA_Double minimumSamplingInterval = 0.0;
+        if(cache && cache->minSamplingKnown) {
+            isVariable = cache->isVariable;
+            minimumSamplingInterval = cache->minimumSamplingInterval;
+        } else {
+            const UA_Node *node = UA_NODESTORE_GET(server, &mon->itemToMonitor.nodeId);
+            if(node) {
+                isVariable = (node->head.nodeClass == UA_NODECLASS_VARIABLE);
+                if(isVariable)
+                    minimumSamplingInterval = node->variableNode.minimumSamplingInterval;
+                UA_NODESTORE_RELEASE(server, node);
+            }
+            if(cache) {
+                cache->minSamplingKnown = true;
+                cache->isVariable = isVariable;
+                cache->minimumSamplingInterval = minimumSamplingInterval;
             }
-            UA_NODESTORE_RELEASE(server, node);
+        }
+        if(isVariable) {
+            /* Take into account if the publishing interval is used for sampling */
+            UA_Double samplingInterval = params->samplingInterval;
+            if(samplingInterval < 0 && mon->subscription)
+                samplingInterval = mon->subscription->publishingInterval;
+            /* Adjust if smaller than the allowed minimum for the variable */
+            if(samplingInterval < minimumSamplingInterval)
+                params->samplingInterval = minimumSamplingInterval;
         }
     }
-        
+
 
     /* A negative number indicates that the sampling interval is the publishing
      * interval of the Subscription. Note that the sampling interval selected
@@ -346,6 +415,8 @@ struct createMonContext {
     UA_Subscription *sub;
     UA_TimestampsToReturn timestampsToReturn;
     UA_LocalMonitoredItem *localMon; /* used if non-null */
+    MonitoredItemLookupCache *cache; /* used if non-null */
+    UA_Boolean batch; /* Defer the initial samples */
 };
 
 static void
@@ -458,9 +529,12 @@ Operation_CreateMonitoredItem(UA_Server *server, UA_Session *session,
                                               &newMon->itemToMonitor);
     result->statusCode |= UA_MonitoringParameters_copy(&request->requestedParameters,
                                                        &newMon->parameters);
+    if(cmc->cache)
+        MonitoredItemLookupCache_use(cmc->cache, &request->itemToMonitor.nodeId);
     result->statusCode |= checkAdjustMonitoredItemParams(server, session, newMon,
                                                          valueType, &newMon->parameters,
-                                                         &result->filterResult);
+                                                         &result->filterResult,
+                                                         cmc->cache);
     if(result->statusCode != UA_STATUSCODE_GOOD) {
         UA_LOG_INFO_SUBSCRIPTION(server->config.logging, cmc->sub,
                                  "Could not create a MonitoredItem "
@@ -478,6 +552,7 @@ Operation_CreateMonitoredItem(UA_Server *server, UA_Session *session,
     UA_Server_registerMonitoredItem(server, newMon);
 
     /* Activate the MonitoredItem */
+    newMon->deferInitialSample = cmc->batch;
     result->statusCode = UA_MonitoredItem_setMonitoringMode(server, newMon,
                                                             request->monitoringMode);
     if(result->statusCode != UA_STATUSCODE_GOOD) {
@@ -490,6 +565,20 @@ Operation_CreateMonitoredItem(UA_Server *server, UA_Session *session,
     result->revisedQueueSize = newMon->parameters.queueSize;
     result->monitoredItemId = newMon->monitoredItemId;
 
+    /* Forward to the standby server */
+    replicateMonitoredItem(server, newMon);
+
+    /* Only a summary is logged for batches */
+    if(cmc->batch) {
+        UA_LOG_DEBUG_SUBSCRIPTION(server->config.logging, cmc->sub,
+                                  "MonitoredItem %" PRIi32 " | "
+                                  "Created the MonitoredItem "
+                                  "(Sampling Interval: %.2fms, Queue Size: %lu)",
+                                  newMon->monitoredItemId,
+                                  newMon->parameters.samplingInterval,
+                                  (unsigned long)newMon->parameters.queueSize);
+        return;
+    }
     UA_LOG_INFO_SUBSCRIPTION(server->config.logging, cmc->sub,
                              "MonitoredItem %" PRIi32 " | "
                              "Created the MonitoredItem "
@@ -531,11 +620,18 @@ Service_CreateMonitoredItems(UA_Server *server, UA_Session *session,
     /* Reset the lifetime counter of the Subscription */
     Subscription_resetLifetime(sub);
 
-    /* Call the service */
+    /* Call the service. Large requests are processed as a batch. The node
+     * lookups are shared between adjacent items on the same node and the
+     * initial samples are taken in the next EventLoop iterations. */
+    MonitoredItemLookupCache cache;
+    memset(&cache, 0, sizeof(MonitoredItemLookupCache));
     struct createMonContext cmc;
     cmc.timestampsToReturn = request->timestampsToReturn;
     cmc.sub = sub;
     cmc.localMon = NULL;
+    cmc.cache = &cache;
+    cmc.batch = (server->config.monitoredItemsBatchThreshold > 0 &&
+                 request->itemsToCreateSize >= server->config.monitoredItemsBatchThreshold);
 
     response->responseHeader.serviceResult =
         UA_Server_processServiceOperations(server, session,
@@ -544,14 +640,56 @@ Service_CreateMonitoredItems(UA_Server *server, UA_Session *session,
                                            &UA_TYPES[UA_TYPES_MONITOREDITEMCREATEREQUEST],
                                            &response->resultsSize,
                                            &UA_TYPES[UA_TYPES_MONITOREDITEMCREATERESULT]);
+    MonitoredItemLookupCache_clear(&cache);
+
+    if(cmc.batch) {
+        UA_LOG_INFO_SUBSCRIPTION(server->config.logging, sub,
+                                 "Created a batch of %lu MonitoredItems",
+                                 (unsigned long)request->itemsToCreateSize);
+    }
 }
 
-UA_MonitoredItemCreateResult
-UA_Server_createDataChangeMonitoredItem(UA_Server *server,
-                                        UA_TimestampsToReturn timestampsToReturn,
-                                        const UA_MonitoredItemCreateRequest item,
-                                        void *monitoredItemContext,
-                                        UA_Server_DataChangeNotificationCallback callback) {
+UA_StatusCode
+UA_Server_restoreMonitoredItem(UA_Server *server, UA_Session *session,
+                               UA_Subscription *sub, UA_UInt32 monitoredItemId,
+                               UA_TimestampsToReturn timestampsToReturn,
+                               const UA_MonitoredItemCreateRequest *request) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+
+    /* The MonitoredItemId must be unused */
+    if(monitoredItemId == 0 || UA_Subscription_getMonitoredItem(sub, monitoredItemId))
+        return UA_STATUSCODE_BADMONITOREDITEMIDINVALID;
+
+    struct createMonContext cmc;
+    cmc.timestampsToReturn = timestampsToReturn;
+    cmc.sub = sub;
+    cmc.localMon = NULL;
+    cmc.cache = NULL;
+    cmc.batch = false;
+
+    /* The MonitoredItemId is assigned from the counter of the Subscription */
+    UA_UInt32 lastMonitoredItemId = sub->lastMonitoredItemId;
+    sub->lastMonitoredItemId = monitoredItemId - 1;
+
+    UA_MonitoredItemCreateResult result;
+    UA_MonitoredItemCreateResult_init(&result);
+    Operation_CreateMonitoredItem(server, session, &cmc, request, &result);
+    UA_StatusCode res = result.statusCode;
+    UA_MonitoredItemCreateResult_clear(&result);
+
+    if(lastMonitoredItemId > monitoredItemId)
+        sub->lastMonitoredItemId = lastMonitoredItemId;
+    else
+        sub->lastMonitoredItemId = monitoredItemId;
+    return res;
+}
+
+static UA_MonitoredItemCreateResult
+createLocalDataChangeMonitoredItem(UA_Server *server,
+                                   UA_TimestampsToReturn timestampsToReturn,
+                                   const UA_MonitoredItemCreateRequest item,
+                                   void *monitoredItemContext,
+                                   UA_Server_DataChangeNotificationCallback callback) {
     UA_MonitoredItemCreateResult result;
     UA_MonitoredItemCreateResult_init(&result);
 
@@ -578,6 +716,8 @@ UA_Server_createDataChangeMonitoredItem(UA_Server *server,
     struct createMonContext cmc;
     cmc.sub = server->adminSubscription;
     cmc.localMon = localMon;
+    cmc.cache = NULL;
+    cmc.batch = false;
     cmc.timestampsToReturn = timestampsToReturn;
 
     UA_LOCK(&server->serviceMutex);
@@ -591,11 +731,11 @@ UA_Server_createDataChangeMonitoredItem(UA_Server *server,
     return result;
 }
 
-UA_MonitoredItemCreateResult
-UA_Server_createEventMonitoredItemEx(UA_Server *server,
-                                     const UA_MonitoredItemCreateRequest item,
-                                     void *monitoredItemContext,
-                                     UA_Server_EventNotificationCallback callback) {
+static UA_MonitoredItemCreateResult
+createLocalEventMonitoredItem(UA_Server *server,
+                              const UA_MonitoredItemCreateRequest item,
+                              void *monitoredItemContext,
+                              UA_Server_EventNotificationCallback callback) {
     UA_MonitoredItemCreateResult result;
     UA_MonitoredItemCreateResult_init(&result);
 
@@ -662,6 +802,8 @@ UA_Server_createEventMonitoredItemEx(UA_Server *server,
     struct createMonContext cmc;
     cmc.sub = server->adminSubscription;
     cmc.localMon = localMon;
+    cmc.cache = NULL;
+    cmc.batch = false;
     cmc.timestampsToReturn = UA_TIMESTAMPSTORETURN_NEITHER;
 
     UA_LOCK(&server->serviceMutex);
@@ -676,6 +818,34 @@ UA_Server_createEventMonitoredItemEx(UA_Server *server,
     return result;
 }
 
+/* The local MonitoredItem structure is preallocated. Attribute it to the
+ * memory category of the MonitoredItems as well. */
+UA_MonitoredItemCreateResult
+UA_Server_createDataChangeMonitoredItem(UA_Server *server,
+                                        UA_TimestampsToReturn timestampsToReturn,
+                                        const UA_MonitoredItemCreateRequest item,
+                                        void *monitoredItemContext,
+                                        UA_Server_DataChangeNotificationCallback callback) {
+    UA_MemoryCategory mc = UA_MemoryCategory_enter(UA_MEMORYCATEGORY_MONITOREDITEMS);
+    UA_MonitoredItemCreateResult result =
+        createLocalDataChangeMonitoredItem(server, timestampsToReturn, item,
+                                           monitoredItemContext, callback);
+    UA_MemoryCategory_leave(mc);
+    return result;
+}
+
+UA_MonitoredItemCreateResult
+UA_Server_createEventMonitoredItemEx(UA_Server *server,
+                                     const UA_MonitoredItemCreateRequest item,
+                                     void *monitoredItemContext,
+                                     UA_Server_EventNotificationCallback callback) {
+    UA_MemoryCategory mc = UA_MemoryCategory_enter(UA_MEMORYCATEGORY_MONITOREDITEMS);
+    UA_MonitoredItemCreateResult result =
+        createLocalEventMonitoredItem(server, item, monitoredItemContext, callback);
+    UA_MemoryCategory_leave(mc);
+    return result;
+}
+
 UA_MonitoredItemCreateResult
 UA_Server_createEventMonitoredItem(UA_Server *server, const UA_NodeId nodeId,
                                    const UA_EventFilter filter, void *monitoredItemContext,
@@ -718,7 +888,7 @@ Operation_ModifyMonitoredItem(UA_Server *server, UA_Session *session, UA_Subscri
      * MonitoredItem untouched. */
     result->statusCode =
         checkAdjustMonitoredItemParams(server, session, mon, v.value.type,
-                                       &params, &result->filterResult);
+                                       &params, &result->filterResult, NULL);
     UA_DataValue_clear(&v);
     if(result->statusCode != UA_STATUSCODE_GOOD) {
         UA_MonitoringParameters_clear(&params);
@@ -731,6 +901,10 @@ Operation_ModifyMonitoredItem(UA_Server *server, UA_Session *session, UA_Subscri
     /* Move over the new settings */
     UA_MonitoringParameters_clear(&mon->parameters);
     mon->parameters = params;
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    if(mon->cold)
+        UA_EventFilterCache_clear(&mon->cold->eventFilterCache);
+#endif
 
     /* Re-register the callback if necessary */
     if(oldSamplingInterval != mon->parameters.samplingInterval) {
@@ -764,6 +938,9 @@ Operation_ModifyMonitoredItem(UA_Server *server, UA_Session *session, UA_Subscri
     if(result->revisedSamplingInterval < 0.0 && mon->subscription)
         result->revisedSamplingInterval = mon->subscription->publishingInterval;
 
+    /* Forward the new settings to the standby server */
+    replicateMonitoredItem(server, mon);
+
     UA_LOG_INFO_SUBSCRIPTION(server->config.logging, sub,
                              "MonitoredItem %" PRIi32 " | "
                              "Modified the MonitoredItem "
@@ -827,6 +1004,8 @@ Operation_SetMonitoringMode(UA_Server *server, UA_Session *session,
         return;
     }
     *result = UA_MonitoredItem_setMonitoringMode(server, mon, smc->monitoringMode);
+    if(*result == UA_STATUSCODE_GOOD)
+        replicateMonitoredItem(server, mon);
 }
 
 void
@@ -876,6 +1055,7 @@ Operation_DeleteMonitoredItem(UA_Server *server, UA_Session *session, UA_Subscri
         *result = UA_STATUSCODE_BADMONITOREDITEMIDINVALID;
         return;
     }
+    replicateMonitoredItemRemoved(server, mon);
     UA_MonitoredItem_delete(server, mon);
 }
 
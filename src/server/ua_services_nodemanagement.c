@@ -69,8 +69,7 @@ setNodeContext(UA_Server *server, UA_NodeId nodeId, void *nodeContext) {
     if(!node)
         return UA_STATUSCODE_BADNODEIDINVALID;
     node->head.context = nodeContext;
-    UA_NODESTORE_RELEASE(server, node);
-    return UA_STATUSCODE_GOOD;
+    return UA_NODESTORE_RELEASE_EDIT(server, node);
 }
 
 UA_StatusCode
@@ -82,6 +81,37 @@ UA_Server_setNodeContext(UA_Server *server, UA_NodeId nodeId,
     return retval;
 }
 
+static UA_StatusCode
+setNodeRoleMasks(UA_Server *server, UA_Session *session,
+                 UA_Node *node, const UA_NodeRoleMasks *roleMasks) {
+    if(!roleMasks) {
+        UA_free(node->head.roleMasks);
+        node->head.roleMasks = NULL;
+        return UA_STATUSCODE_GOOD;
+    }
+    if(!node->head.roleMasks) {
+        node->head.roleMasks = (UA_NodeRoleMasks*)UA_malloc(sizeof(UA_NodeRoleMasks));
+        if(!node->head.roleMasks)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    *node->head.roleMasks = *roleMasks;
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_Server_setNodeRoleMasks(UA_Server *server, const UA_NodeId nodeId,
+                           const UA_NodeRoleMasks *roleMasks) {
+    UA_LOCK(&server->serviceMutex);
+    UA_StatusCode retval =
+        UA_Server_editNode(server, &server->adminSession, &nodeId,
+                           UA_NODEATTRIBUTESMASK_NONE, UA_REFERENCETYPESET_NONE,
+                           UA_BROWSEDIRECTION_INVALID,
+                           (UA_EditNodeCallback)setNodeRoleMasks,
+                           (void*)(uintptr_t)roleMasks);
+    UA_UNLOCK(&server->serviceMutex);
+    return retval;
+}
+
 static UA_StatusCode
 checkSetIsDynamicVariable(UA_Server *server, UA_Session *session,
                           const UA_NodeId *nodeId);
@@ -460,44 +490,49 @@ useVariableTypeAttributes(UA_Server *server, UA_Session *session,
     return retval;
 }
 
-/* Search for an instance of "browseName" in node searchInstance. Used during
- * copyChildNodes to find overwritable/mergable nodes. Does not touch
- * outInstanceNodeId if no child is found. */
-static UA_StatusCode
-findChildByBrowsename(UA_Server *server, UA_Session *session,
-                      const UA_NodeId *searchInstance,
-                      const UA_QualifiedName *browseName,
-                      UA_NodeId *outInstanceNodeId) {
+/* Browse the aggregated children (with their BrowseName) of a node */
+static void
+browseAggregatedChildren(UA_Server *server, UA_Session *session,
+                         const UA_NodeId *nodeId, UA_UInt32 resultMask,
+                         UA_BrowseResult *br) {
     UA_BrowseDescription bd;
     UA_BrowseDescription_init(&bd);
-    bd.nodeId = *searchInstance;
+    bd.nodeId = *nodeId;
     bd.referenceTypeId = UA_NS0ID(AGGREGATES);
     bd.includeSubtypes = true;
     bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
     bd.nodeClassMask = UA_NODECLASS_OBJECT | UA_NODECLASS_VARIABLE | UA_NODECLASS_METHOD;
-    bd.resultMask = UA_BROWSERESULTMASK_BROWSENAME;
+    bd.resultMask = resultMask | UA_BROWSERESULTMASK_BROWSENAME;
 
-    UA_BrowseResult br;
-    UA_BrowseResult_init(&br);
     UA_UInt32 maxrefs = 0;
-    Operation_Browse(server, session, &maxrefs, &bd, &br);
-    if(br.statusCode != UA_STATUSCODE_GOOD)
-        return br.statusCode;
+    Operation_Browse(server, session, &maxrefs, &bd, br);
+}
 
-    UA_StatusCode retval = UA_STATUSCODE_GOOD;
-    for(size_t i = 0; i < br.referencesSize; ++i) {
-        UA_ReferenceDescription *rd = &br.references[i];
+/* Search for an instance of "browseName" in the browsed children of the
+ * instance. Used during copyChildNodes to find overwritable/mergable nodes. */
+static const UA_NodeId *
+findChildByBrowsename(const UA_BrowseResult *children,
+                      const UA_QualifiedName *browseName) {
+    for(size_t i = 0; i < children->referencesSize; ++i) {
+        const UA_ReferenceDescription *rd = &children->references[i];
         if(rd->browseName.namespaceIndex == browseName->namespaceIndex &&
-           UA_String_equal(&rd->browseName.name, &browseName->name)) {
-            retval = UA_NodeId_copy(&rd->nodeId.nodeId, outInstanceNodeId);
-            break;
-        }
+           UA_String_equal(&rd->browseName.name, &browseName->name))
+            return &rd->nodeId.nodeId;
     }
-
-    UA_BrowseResult_clear(&br);
-    return retval;
+    return NULL;
 }
 
+/* State shared by the children copied into one destination node. The existing
+ * children of the destination are browsed once up front instead of once per
+ * child of the source. Whether the HasModellingRule references are kept on the
+ * copies also depends only on the destination and is computed on first use. */
+typedef struct {
+    const UA_NodeId *destination;
+    UA_BrowseResult existing;
+    UA_Boolean keepModellingRulesChecked;
+    UA_Boolean keepModellingRules;
+} CopyChildrenContext;
+
 static const UA_ExpandedNodeId mandatoryId =
     {{0, UA_NODEIDTYPE_NUMERIC, {UA_NS0ID_MODELLINGRULE_MANDATORY}}, {0, NULL}, 0};
 
@@ -597,25 +632,22 @@ addInterfaceChildren(UA_Server *server, UA_Session *session,
 }
 
 static UA_StatusCode
-copyChild(UA_Server *server, UA_Session *session,
-          const UA_NodeId *destinationNodeId,
+copyChild(UA_Server *server, UA_Session *session, CopyChildrenContext *ctx,
           const UA_ReferenceDescription *rd) {
     UA_assert(session);
     UA_LOCK_ASSERT(&server->serviceMutex);
 
-    /* Is there an existing child with the browsename? */
-    UA_NodeId existingChild = UA_NODEID_NULL;
-    UA_StatusCode retval = findChildByBrowsename(server, session, destinationNodeId,
-                                                 &rd->browseName, &existingChild);
-    if(retval != UA_STATUSCODE_GOOD)
-        return retval;
+    const UA_NodeId *destinationNodeId = ctx->destination;
+    UA_StatusCode retval = UA_STATUSCODE_GOOD;
 
-    /* Have a child with that browseName. Deep-copy missing members. */
-    if(!UA_NodeId_isNull(&existingChild)) {
+    /* Is there an existing child with the browsename? Have a child with that
+     * browseName. Deep-copy missing members. */
+    const UA_NodeId *existingChild =
+        findChildByBrowsename(&ctx->existing, &rd->browseName);
+    if(existingChild) {
         if(rd->nodeClass == UA_NODECLASS_VARIABLE ||
            rd->nodeClass == UA_NODECLASS_OBJECT)
-            retval = copyAllChildren(server, session, &rd->nodeId.nodeId, &existingChild);
-        UA_NodeId_clear(&existingChild);
+            retval = copyAllChildren(server, session, &rd->nodeId.nodeId, existingChild);
         return retval;
     }
 
@@ -694,15 +726,19 @@ copyChild(UA_Server *server, UA_Session *session,
          * addnode_finish. That way, we can call addnode_finish also on children that were
          * manually added by the user during addnode_begin and addnode_finish. */
         /* For now we keep all the modelling rule references and delete all others */
-        const UA_NodeId nodeId_typesFolder= UA_NS0ID(TYPESFOLDER);
-        const UA_ReferenceTypeSet reftypes_aggregates =
-            UA_REFTYPESET(UA_REFERENCETYPEINDEX_AGGREGATES);
-        UA_ReferenceTypeSet reftypes_skipped;
         /* Check if the hasModellingRule-reference is required (configured or node in an
             instance declaration) */
-        if(server->config.modellingRulesOnInstances ||
-           isNodeInTree(server, destinationNodeId,
-                        &nodeId_typesFolder, &reftypes_aggregates)) {
+        if(!ctx->keepModellingRulesChecked) {
+            const UA_NodeId nodeId_typesFolder= UA_NS0ID(TYPESFOLDER);
+            const UA_ReferenceTypeSet reftypes_aggregates =
+                UA_REFTYPESET(UA_REFERENCETYPEINDEX_AGGREGATES);
+            ctx->keepModellingRules = server->config.modellingRulesOnInstances ||
+                isNodeInTree(server, destinationNodeId,
+                             &nodeId_typesFolder, &reftypes_aggregates);
+            ctx->keepModellingRulesChecked = true;
+        }
+        UA_ReferenceTypeSet reftypes_skipped;
+        if(ctx->keepModellingRules) {
             reftypes_skipped = UA_REFTYPESET(UA_REFERENCETYPEINDEX_HASMODELLINGRULE);
         } else {
             UA_ReferenceTypeSet_init(&reftypes_skipped);
@@ -765,31 +801,45 @@ static UA_StatusCode
 copyAllChildren(UA_Server *server, UA_Session *session,
                 const UA_NodeId *source, const UA_NodeId *destination) {
     /* Browse to get all children of the source */
-    UA_BrowseDescription bd;
-    UA_BrowseDescription_init(&bd);
-    bd.nodeId = *source;
-    bd.referenceTypeId = UA_NS0ID(AGGREGATES);
-    bd.includeSubtypes = true;
-    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
-    bd.nodeClassMask = UA_NODECLASS_OBJECT | UA_NODECLASS_VARIABLE | UA_NODECLASS_METHOD;
-    bd.resultMask = UA_BROWSERESULTMASK_REFERENCETYPEID | UA_BROWSERESULTMASK_NODECLASS |
-        UA_BROWSERESULTMASK_BROWSENAME | UA_BROWSERESULTMASK_TYPEDEFINITION;
-
     UA_BrowseResult br;
     UA_BrowseResult_init(&br);
-    UA_UInt32 maxrefs = 0;
-    Operation_Browse(server, session, &maxrefs, &bd, &br);
-    if(br.statusCode != UA_STATUSCODE_GOOD)
-        return br.statusCode;
+    browseAggregatedChildren(server, session, source,
+                             UA_BROWSERESULTMASK_REFERENCETYPEID |
+                             UA_BROWSERESULTMASK_NODECLASS |
+                             UA_BROWSERESULTMASK_TYPEDEFINITION, &br);
+    if(br.statusCode != UA_STATUSCODE_GOOD || br.referencesSize == 0) {
+        UA_StatusCode res = br.statusCode;
+        UA_BrowseResult_clear(&br);
+        return res;
+    }
 
-    UA_StatusCode retval = UA_STATUSCODE_GOOD;
-    for(size_t i = 0; i < br.referencesSize; ++i) {
+    /* Browse the children already present in the destination */
+    CopyChildrenContext ctx;
+    memset(&ctx, 0, sizeof(CopyChildrenContext));
+    ctx.destination = destination;
+    browseAggregatedChildren(server, session, destination, 0, &ctx.existing);
+    UA_StatusCode retval = ctx.existing.statusCode;
+
+    for(size_t i = 0; i < br.referencesSize && retval == UA_STATUSCODE_GOOD; ++i) {
         UA_ReferenceDescription *rd = &br.references[i];
-        retval = copyChild(server, session, destination, rd);
+
+        /* The BrowseName was already used by an earlier child of the source.
+         * Browse again to find the child created for it. */
+        for(size_t j = 0; j < i; ++j) {
+            if(!UA_QualifiedName_equal(&br.references[j].browseName, &rd->browseName))
+                continue;
+            UA_BrowseResult_clear(&ctx.existing);
+            browseAggregatedChildren(server, session, destination, 0, &ctx.existing);
+            retval = ctx.existing.statusCode;
+            break;
+        }
         if(retval != UA_STATUSCODE_GOOD)
             break;
+
+        retval = copyChild(server, session, &ctx, rd);
     }
 
+    UA_BrowseResult_clear(&ctx.existing);
     UA_BrowseResult_clear(&br);
     return retval;
 }
@@ -1021,11 +1071,9 @@ addNode_addRefs(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId,
     return retval;
 }
 
-/* Create the node and add it to the nodestore. But don't typecheck and add
- * references so far */
-UA_StatusCode
-addNode_raw(UA_Server *server, UA_Session *session, void *nodeContext,
-            const UA_AddNodesItem *item, UA_NodeId *outNewNodeId) {
+static UA_StatusCode
+addNode_rawInternal(UA_Server *server, UA_Session *session, void *nodeContext,
+                    const UA_AddNodesItem *item, UA_NodeId *outNewNodeId) {
     /* Do not check access for server */
     if(session != &server->adminSession && server->config.accessControl.allowAddNode) {
         UA_LOCK_ASSERT(&server->serviceMutex);
@@ -1173,6 +1221,18 @@ checkSetBrowseName(UA_Server *server, UA_Session *session, UA_AddNodesItem *item
     return retval;
 }
 
+/* Create the node and add it to the nodestore. But don't typecheck and add
+ * references so far */
+UA_StatusCode
+addNode_raw(UA_Server *server, UA_Session *session, void *nodeContext,
+            const UA_AddNodesItem *item, UA_NodeId *outNewNodeId) {
+    UA_MemoryCategory mc = UA_MemoryCategory_enter(UA_MEMORYCATEGORY_NODESTORE);
+    UA_StatusCode res =
+        addNode_rawInternal(server, session, nodeContext, item, outNewNodeId);
+    UA_MemoryCategory_leave(mc);
+    return res;
+}
+
 /* Prepare the node, then add it to the nodestore */
 static UA_StatusCode
 Operation_addNode_begin(UA_Server *server, UA_Session *session, void *nodeContext,
@@ -1347,7 +1407,7 @@ addReferenceTypeSubtype(UA_Server *server, UA_Session *session,
     return UA_STATUSCODE_GOOD;
 }
 
-static UA_StatusCode
+UA_StatusCode
 setReferenceTypeSubtypes(UA_Server *server, const UA_ReferenceTypeNode *node) {
     /* Get the ReferenceTypes upwards in the hierarchy */
     size_t parentsSize = 0;
@@ -1385,8 +1445,8 @@ setVariableNodeDynamic(UA_Server *server, const UA_NodeId *nodeId,
         ((UA_VariableNode*)node)->isDynamic = isDynamic;
     else
         res = UA_STATUSCODE_BADINTERNALERROR;
-    UA_NODESTORE_RELEASE(server, node);
-    return res;
+    UA_StatusCode releaseRes = UA_NODESTORE_RELEASE_EDIT(server, node);
+    return (res != UA_STATUSCODE_GOOD) ? res : releaseRes;
 }
 
 static UA_StatusCode
@@ -1447,6 +1507,7 @@ UA_StatusCode
 addNode_finish(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId) {
     /* Get the node */
     const UA_Node *type = NULL;
+    UA_Boolean deferred = false;
     const UA_Node *node = UA_NODESTORE_GET(server, nodeId);
     if(!node)
         return UA_STATUSCODE_BADNODEIDUNKNOWN;
@@ -1499,9 +1560,21 @@ addNode_finish(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId)
         }
     }
 
+    /* During a bulk load, remember the node for the deferred type-check and
+     * constructor calls */
+    deferred = server->bulkLoad;
+    if(deferred) {
+        retval = UA_Array_appendCopy((void**)&server->bulkLoadNodes,
+                                     &server->bulkLoadNodesSize, nodeId,
+                                     &UA_TYPES[UA_TYPES_NODEID]);
+        if(retval != UA_STATUSCODE_GOOD)
+            goto cleanup;
+    }
+
     /* Initialize and typecheck the variable */
-    if(node->head.nodeClass == UA_NODECLASS_VARIABLE ||
-       node->head.nodeClass == UA_NODECLASS_VARIABLETYPE) {
+    if(!deferred &&
+       (node->head.nodeClass == UA_NODECLASS_VARIABLE ||
+        node->head.nodeClass == UA_NODECLASS_VARIABLETYPE)) {
         /* Use attributes from the type. The value and value constraints are the
          * same for the variable and variabletype attribute structs. */
         retval = useVariableTypeAttributes(server, session,
@@ -1565,6 +1638,8 @@ addNode_finish(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId)
     }
 
     /* Call the constructor(s) */
+    if(deferred)
+        goto cleanup;
  constructor:
     if(!node->head.constructed)
         retval = recursiveCallConstructors(server, session, nodeId, type);
@@ -1608,7 +1683,7 @@ Service_AddNodes(UA_Server *server, UA_Session *session,
                  const UA_AddNodesRequest *request,
                  UA_AddNodesResponse *response) {
     UA_LOG_DEBUG_SESSION(server->config.logging, session, "Processing AddNodesRequest");
-    UA_LOCK_ASSERT(&server->serviceMutex);
+    UA_LOCK_ASSERT_EXCLUSIVE(&server->serviceMutex);
 
     if(server->config.maxNodesPerNodeManagement != 0 &&
        request->nodesToAddSize > server->config.maxNodesPerNodeManagement) {
@@ -1718,6 +1793,362 @@ UA_Server_addNode_finish(UA_Server *server, const UA_NodeId nodeId) {
     return retval;
 }
 
+/*************/
+/* Bulk Load */
+/*************/
+
+UA_StatusCode
+UA_Server_beginBulkLoad(UA_Server *server) {
+    UA_LOCK(&server->serviceMutex);
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    if(server->bulkLoad)
+        res = UA_STATUSCODE_BADINVALIDSTATE;
+    server->bulkLoad = true;
+    UA_UNLOCK(&server->serviceMutex);
+    return res;
+}
+
+/* The deferred type-check of addNode_finish. Removes the node if the check
+ * fails. */
+static UA_StatusCode
+bulkLoadTypeCheck(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId) {
+    const UA_Node *node = UA_NODESTORE_GET(server, nodeId);
+    if(!node)
+        return UA_STATUSCODE_GOOD; /* Removed in the meantime */
+    if(node->head.nodeClass != UA_NODECLASS_VARIABLE &&
+       node->head.nodeClass != UA_NODECLASS_VARIABLETYPE) {
+        UA_NODESTORE_RELEASE(server, node);
+        return UA_STATUSCODE_GOOD;
+    }
+
+    const UA_Node *type = getNodeType(server, &node->head);
+    if(!type) {
+        UA_NODESTORE_RELEASE(server, node);
+        return UA_STATUSCODE_GOOD; /* Only allowed during bootstrapping */
+    }
+
+    UA_StatusCode res = useVariableTypeAttributes(server, session,
+                                                  &node->variableNode,
+                                                  &type->variableTypeNode);
+    UA_NODESTORE_RELEASE(server, node);
+    if(res == UA_STATUSCODE_GOOD) {
+        /* Get the node again, it might have been updated */
+        node = UA_NODESTORE_GET(server, nodeId);
+        if(!node) {
+            res = UA_STATUSCODE_BADINTERNALERROR;
+        } else {
+            res = typeCheckVariableNode(server, session, &node->variableNode,
+                                        &type->variableTypeNode);
+            UA_NODESTORE_RELEASE(server, node);
+        }
+    }
+    UA_NODESTORE_RELEASE(server, type);
+
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_LOG_INFO_SESSION(server->config.logging, session,
+                            "AddNode (%N): Type-checking failed with error code %s",
+                            *nodeId, UA_StatusCode_name(res));
+        deleteNode(server, *nodeId, true);
+    }
+    return res;
+}
+
+static UA_StatusCode
+bulkLoadConstruct(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId) {
+    const UA_Node *node = UA_NODESTORE_GET(server, nodeId);
+    if(!node)
+        return UA_STATUSCODE_GOOD; /* Removed in the meantime */
+    if(node->head.constructed) {
+        UA_NODESTORE_RELEASE(server, node);
+        return UA_STATUSCODE_GOOD;
+    }
+
+    const UA_Node *type = NULL;
+    if(node->head.nodeClass == UA_NODECLASS_VARIABLE ||
+       node->head.nodeClass == UA_NODECLASS_VARIABLETYPE ||
+       node->head.nodeClass == UA_NODECLASS_OBJECT)
+        type = getNodeType(server, &node->head);
+    UA_NODESTORE_RELEASE(server, node);
+
+    UA_StatusCode res = recursiveCallConstructors(server, session, nodeId, type);
+    if(type)
+        UA_NODESTORE_RELEASE(server, type);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_LOG_INFO_SESSION(server->config.logging, session,
+                            "AddNode (%N): Calling the node constructor(s) "
+                            "failed with error code %s",
+                            *nodeId, UA_StatusCode_name(res));
+        deleteNode(server, *nodeId, true);
+    }
+    return res;
+}
+
+/* Collect the nodes with wide ReferenceKinds that are not yet compact */
+static void
+bulkLoadCollectWide(void *context, const UA_Node *node) {
+    RefTree *wide = (RefTree*)context;
+    for(size_t i = 0; i < node->head.referencesSize; i++) {
+        const UA_NodeReferenceKind *rk = &node->head.references[i];
+        if(rk->isCompact || rk->targetsSize <= UA_NODE_REFTREE_THRESHOLD)
+            continue;
+        UA_StatusCode res = RefTree_addNodeId(wide, &node->head.nodeId, NULL);
+        (void)res; /* Compacting is optional */
+        return;
+    }
+}
+
+static UA_StatusCode
+bulkLoadCompactNode(UA_Server *server, UA_Session *session,
+                    UA_Node *node, void *context) {
+    (void)server;
+    (void)session;
+    (void)context;
+    for(size_t i = 0; i < node->head.referencesSize; i++) {
+        UA_NodeReferenceKind *rk = &node->head.references[i];
+        if(!rk->isCompact && rk->targetsSize > UA_NODE_REFTREE_THRESHOLD)
+            UA_NodeReferenceKind_switchCompact(rk); /* Keeps the tree on error */
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Switch the wide ReferenceKinds to the compact representation. The targets of
+ * bulk-loaded models are mostly static afterwards. Adding a target switches
+ * back to the tree. */
+static void
+bulkLoadCompactReferences(UA_Server *server) {
+    RefTree wide;
+    if(RefTree_init(&wide) != UA_STATUSCODE_GOOD)
+        return;
+    server->config.nodestore.iterate(server->config.nodestore.context,
+                                     bulkLoadCollectWide, &wide);
+    for(size_t i = 0; i < wide.size; i++)
+        UA_Server_editNode(server, &server->adminSession, &wide.targets[i].nodeId,
+                           0, UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH,
+                           bulkLoadCompactNode, NULL);
+    RefTree_clear(&wide);
+}
+
+UA_StatusCode
+UA_Server_endBulkLoad(UA_Server *server) {
+    UA_LOCK(&server->serviceMutex);
+    if(!server->bulkLoad) {
+        UA_UNLOCK(&server->serviceMutex);
+        return UA_STATUSCODE_BADINVALIDSTATE;
+    }
+    server->bulkLoad = false;
+
+    /* Type-check all nodes first. Then call the constructors. Parents are
+     * added before their children. So the constructors of the children are
+     * called as part of the parent and are skipped afterwards. */
+    UA_Session *session = &server->adminSession;
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    for(size_t i = 0; i < server->bulkLoadNodesSize; i++) {
+        UA_StatusCode res2 = bulkLoadTypeCheck(server, session, &server->bulkLoadNodes[i]);
+        if(res == UA_STATUSCODE_GOOD)
+            res = res2;
+    }
+    for(size_t i = 0; i < server->bulkLoadNodesSize; i++) {
+        UA_StatusCode res2 = bulkLoadConstruct(server, session, &server->bulkLoadNodes[i]);
+        if(res == UA_STATUSCODE_GOOD)
+            res = res2;
+    }
+    bulkLoadCompactReferences(server);
+
+    UA_Array_delete(server->bulkLoadNodes, server->bulkLoadNodesSize,
+                    &UA_TYPES[UA_TYPES_NODEID]);
+    server->bulkLoadNodes = NULL;
+    server->bulkLoadNodesSize = 0;
+    UA_UNLOCK(&server->serviceMutex);
+    return res;
+}
+
+/**************/
+/* Node Table */
+/**************/
+
+static UA_NodeId
+nodeTableNodeId(const UA_NodeTableNodeId *id, const UA_UInt16 *ns) {
+    return UA_NODEID_NUMERIC(ns[id->namespaceIndex], id->identifier);
+}
+
+static UA_LocalizedText
+nodeTableText(const UA_NodeTable *table, const char * const *pool,
+              UA_UInt32 locale, UA_UInt32 text) {
+    UA_LocalizedText lt;
+    lt.locale = UA_STRING((char*)(uintptr_t)table->strings[locale]);
+    lt.text = UA_STRING((char*)(uintptr_t)pool[text]);
+    return lt;
+}
+
+/* Add the node from the table columns. The attributes are set on the
+ * attribute struct for the NodeClass. The strings and array dimensions point
+ * into the (static) table and are copied into the node. */
+static UA_StatusCode
+addNodeTableEntry_begin(UA_Server *server, const UA_NodeTable *table,
+                        const UA_NodeTableEntry *e, UA_UInt16 *ns) {
+    union {
+        UA_ObjectAttributes object;
+        UA_VariableAttributes variable;
+        UA_MethodAttributes method;
+        UA_ObjectTypeAttributes objectType;
+        UA_VariableTypeAttributes variableType;
+        UA_ReferenceTypeAttributes referenceType;
+        UA_DataTypeAttributes dataType;
+        UA_ViewAttributes view;
+    } attr;
+
+    const UA_DataType *attrType;
+    UA_UInt32 *dims = (UA_UInt32*)(uintptr_t)&table->arrayDimensions[e->arrayDimensions];
+    size_t dimsSize = (e->valueRank > 0) ? (size_t)e->valueRank : 0;
+    UA_Boolean isAbstract = (e->flags & UA_NODETABLE_ISABSTRACT) != 0;
+    switch(e->nodeClass) {
+    case UA_NODECLASS_OBJECT:
+        attr.object = UA_ObjectAttributes_default;
+        attr.object.eventNotifier = e->eventNotifier;
+        attrType = &UA_TYPES[UA_TYPES_OBJECTATTRIBUTES];
+        break;
+    case UA_NODECLASS_VARIABLE:
+        attr.variable = UA_VariableAttributes_default;
+        attr.variable.dataType = nodeTableNodeId(&e->dataType, ns);
+        attr.variable.valueRank = e->valueRank;
+        attr.variable.arrayDimensionsSize = dimsSize;
+        attr.variable.arrayDimensions = (dimsSize > 0) ? dims : NULL;
+        attr.variable.accessLevel = e->accessLevel;
+        attr.variable.userAccessLevel = e->userAccessLevel;
+        attr.variable.minimumSamplingInterval = e->minimumSamplingInterval;
+        attr.variable.historizing = (e->flags & UA_NODETABLE_HISTORIZING) != 0;
+        attrType = &UA_TYPES[UA_TYPES_VARIABLEATTRIBUTES];
+        break;
+    case UA_NODECLASS_METHOD:
+        attr.method = UA_MethodAttributes_default;
+        attr.method.executable = (e->flags & UA_NODETABLE_EXECUTABLE) != 0;
+        attr.method.userExecutable = (e->flags & UA_NODETABLE_USEREXECUTABLE) != 0;
+        attrType = &UA_TYPES[UA_TYPES_METHODATTRIBUTES];
+        break;
+    case UA_NODECLASS_OBJECTTYPE:
+        attr.objectType = UA_ObjectTypeAttributes_default;
+        attr.objectType.isAbstract = isAbstract;
+        attrType = &UA_TYPES[UA_TYPES_OBJECTTYPEATTRIBUTES];
+        break;
+    case UA_NODECLASS_VARIABLETYPE:
+        attr.variableType = UA_VariableTypeAttributes_default;
+        attr.variableType.dataType = nodeTableNodeId(&e->dataType, ns);
+        attr.variableType.valueRank = e->valueRank;
+        attr.variableType.arrayDimensionsSize = dimsSize;
+        attr.variableType.arrayDimensions = (dimsSize > 0) ? dims : NULL;
+        attr.variableType.isAbstract = isAbstract;
+        attrType = &UA_TYPES[UA_TYPES_VARIABLETYPEATTRIBUTES];
+        break;
+    case UA_NODECLASS_REFERENCETYPE:
+        attr.referenceType = UA_ReferenceTypeAttributes_default;
+        attr.referenceType.isAbstract = isAbstract;
+        attr.referenceType.symmetric = (e->flags & UA_NODETABLE_SYMMETRIC) != 0;
+        if(e->inverseName != 0)
+            attr.referenceType.inverseName =
+                nodeTableText(table, table->strings, 0, e->inverseName);
+        attrType = &UA_TYPES[UA_TYPES_REFERENCETYPEATTRIBUTES];
+        break;
+    case UA_NODECLASS_DATATYPE:
+        attr.dataType = UA_DataTypeAttributes_default;
+        attr.dataType.isAbstract = isAbstract;
+        attrType = &UA_TYPES[UA_TYPES_DATATYPEATTRIBUTES];
+        break;
+    case UA_NODECLASS_VIEW:
+        attr.view = UA_ViewAttributes_default;
+        attr.view.containsNoLoops = (e->flags & UA_NODETABLE_CONTAINSNOLOOPS) != 0;
+        attr.view.eventNotifier = e->eventNotifier;
+        attrType = &UA_TYPES[UA_TYPES_VIEWATTRIBUTES];
+        break;
+    default:
+        return UA_STATUSCODE_BADNODECLASSINVALID;
+    }
+
+    /* The common attributes are at the beginning of all attribute structs */
+    UA_NodeAttributes *na = (UA_NodeAttributes*)&attr;
+    na->displayName = nodeTableText(table, table->strings,
+                                    e->displayNameLocale, e->displayName);
+    if(table->descriptions && e->description != 0)
+        na->description = nodeTableText(table, table->descriptions, 0, e->description);
+    na->writeMask = e->writeMask;
+    na->userWriteMask = e->userWriteMask;
+
+    UA_QualifiedName browseName =
+        UA_QUALIFIEDNAME(ns[e->browseNameNamespace],
+                         (char*)(uintptr_t)table->strings[e->browseName]);
+    UA_StatusCode res =
+        addNode_begin(server, (UA_NodeClass)e->nodeClass,
+                      nodeTableNodeId(&e->nodeId, ns),
+                      nodeTableNodeId(&e->parentNodeId, ns),
+                      nodeTableNodeId(&e->referenceTypeId, ns), browseName,
+                      nodeTableNodeId(&e->typeDefinition, ns), &attr, attrType,
+                      NULL, NULL);
+
+    /* Add the references to the nodes from earlier in the table */
+    UA_AddReferencesItem item;
+    UA_AddReferencesItem_init(&item);
+    item.sourceNodeId = nodeTableNodeId(&e->nodeId, ns);
+    for(size_t i = 0; i < e->referencesSize; i++) {
+        const UA_NodeTableReference *r = &table->references[e->referencesOffset + i];
+        item.referenceTypeId = nodeTableNodeId(&r->referenceTypeId, ns);
+        item.targetNodeId.nodeId = nodeTableNodeId(&r->targetId, ns);
+        item.isForward = r->isForward;
+        UA_StatusCode res2 = UA_STATUSCODE_GOOD;
+        Operation_addReference(server, &server->adminSession, NULL, &item, &res2);
+        res |= res2;
+    }
+    return res;
+}
+
+static UA_StatusCode
+addNodeTableEntry_finish(UA_Server *server, const UA_NodeTableEntry *e,
+                         UA_UInt16 *ns) {
+    if(e->finish) {
+        UA_UNLOCK(&server->serviceMutex);
+        UA_StatusCode res = e->finish(server, ns);
+        UA_LOCK(&server->serviceMutex);
+        return res;
+    }
+    UA_NodeId id = nodeTableNodeId(&e->nodeId, ns);
+    return addNode_finish(server, &server->adminSession, &id);
+}
+
+UA_StatusCode
+UA_Server_addNodeTable(UA_Server *server, const UA_NodeTable *table,
+                       UA_UInt16 *ns) {
+    UA_LOCK(&server->serviceMutex);
+    UA_Boolean bulkLoad = !server->bulkLoad;
+    server->bulkLoad = true;
+
+    /* The status codes are or'ed like in the code generated per node */
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    for(size_t i = 0; i < table->nodesSize; i++) {
+        const UA_NodeTableEntry *e = &table->nodes[i];
+        if(e->begin) {
+            UA_UNLOCK(&server->serviceMutex);
+            res |= e->begin(server, ns);
+            UA_LOCK(&server->serviceMutex);
+        } else {
+            res |= addNodeTableEntry_begin(server, table, e, ns);
+        }
+
+        /* The _begin phase of other nodes might depend on the subtyping
+         * information of the ReferenceType to be complete */
+        if(e->nodeClass == UA_NODECLASS_REFERENCETYPE)
+            res |= addNodeTableEntry_finish(server, e, ns);
+    }
+
+    for(size_t i = table->nodesSize; i > 0; i--) {
+        const UA_NodeTableEntry *e = &table->nodes[i-1];
+        if(e->nodeClass != UA_NODECLASS_REFERENCETYPE)
+            res |= addNodeTableEntry_finish(server, e, ns);
+    }
+    UA_UNLOCK(&server->serviceMutex);
+
+    if(bulkLoad)
+        res |= UA_Server_endBulkLoad(server);
+    return res;
+}
+
 /****************/
 /* Delete Nodes */
 /****************/
@@ -1730,6 +2161,7 @@ struct RemoveIncomingContext {
     UA_Server *server;
     UA_Session *session;
     UA_DeleteReferencesItem *item;
+    RefTree *deleteSet;
 };
 
 static void *
@@ -1739,14 +2171,19 @@ removeIncomingReferencesCallback(void *context, UA_ReferenceTarget *t) {
         return NULL;
     UA_StatusCode dummy;
     ctx->item->sourceNodeId = UA_NodePointer_toNodeId(t->targetId);
+    /* The referencing node is removed as well. Don't edit (copy and replace)
+     * it only to remove the reference. */
+    if(ctx->deleteSet && RefTree_containsNodeId(ctx->deleteSet, &ctx->item->sourceNodeId))
+        return NULL;
     Operation_deleteReference(ctx->server, ctx->session, NULL, ctx->item, &dummy);
     return NULL;
 }
 
-/* Remove references to this node (in the other nodes) */
+/* Remove references to this node (in the other nodes). Nodes contained in the
+ * deleteSet (if defined) are skipped. */
 static void
 removeIncomingReferences(UA_Server *server, UA_Session *session,
-                         const UA_NodeHead *head) {
+                         const UA_NodeHead *head, RefTree *deleteSet) {
     UA_DeleteReferencesItem item;
     UA_DeleteReferencesItem_init(&item);
     item.targetNodeId.nodeId = head->nodeId;
@@ -1756,6 +2193,7 @@ removeIncomingReferences(UA_Server *server, UA_Session *session,
     ctx.server = server;
     ctx.session = session;
     ctx.item = &item;
+    ctx.deleteSet = deleteSet;
 
     for(size_t i = 0; i < head->referencesSize; ++i) {
         UA_NodeReferenceKind *rk = &head->references[i];
@@ -1936,15 +2374,18 @@ static void
 deleteNodeSet(UA_Server *server, UA_Session *session,
               const UA_ReferenceTypeSet *hierarchRefsSet,
               UA_Boolean removeTargetRefs, RefTree *refTree) {
-    /* Delete the nodes based on the RefTree entries */
+    /* Delete the nodes based on the RefTree entries. References between
+     * members of the set disappear with the nodes. Only the nodes outside of
+     * the set are edited to remove their references into the set. */
     for(size_t i = refTree->size; i > 0; --i) {
-        const UA_Node *member = UA_NODESTORE_GET(server, &refTree->targets[i-1].nodeId);
+        const UA_NodeId *memberId = &refTree->targets[i-1].nodeId;
+        const UA_Node *member = UA_NODESTORE_GET(server, memberId);
         if(!member)
             continue;
-        UA_NODESTORE_RELEASE(server, member);
         if(removeTargetRefs)
-            removeIncomingReferences(server, session, &member->head);
-        UA_NODESTORE_REMOVE(server, &member->head.nodeId);
+            removeIncomingReferences(server, session, &member->head, refTree);
+        UA_NODESTORE_RELEASE(server, member);
+        UA_NODESTORE_REMOVE(server, memberId);
     }
 }
 
@@ -2028,7 +2469,7 @@ Service_DeleteNodes(UA_Server *server, UA_Session *session,
                     UA_DeleteNodesResponse *response) {
     UA_LOG_DEBUG_SESSION(server->config.logging, session,
                          "Processing DeleteNodesRequest");
-    UA_LOCK_ASSERT(&server->serviceMutex);
+    UA_LOCK_ASSERT_EXCLUSIVE(&server->serviceMutex);
 
     if(server->config.maxNodesPerNodeManagement != 0 &&
        request->nodesToDeleteSize > server->config.maxNodesPerNodeManagement) {
@@ -2116,6 +2557,10 @@ Operation_addReference(UA_Server *server, UA_Session *session, void *context,
     UA_Byte refTypeIndex = refType->referenceTypeNode.referenceTypeIndex;
     UA_NODESTORE_RELEASE(server, refType);
 
+    server->hierarchyEpoch++;
+    if(refTypeIndex == UA_REFERENCETYPEINDEX_HASSUBTYPE)
+        invalidateTypeHierarchy(server);
+
     /* Get the source and target node (editable). Include only the BrowseName
      * and the relevant ReferenceType and direction. Don't modify the target
      * node if it lives on a different server. */
@@ -2150,8 +2595,7 @@ Operation_addReference(UA_Server *server, UA_Session *session, void *context,
                                         item->isForward ?
                                         UA_BROWSEDIRECTION_FORWARD : UA_BROWSEDIRECTION_INVERSE);
     if(!sourceNode) {
-        if(targetNode)
-            UA_NODESTORE_RELEASE(server, targetNode);
+        UA_NODESTORE_RELEASE_EDIT(server, targetNode);
         *retval = UA_STATUSCODE_BADSOURCENODEIDINVALID;
         return;
     }
@@ -2191,10 +2635,12 @@ Operation_addReference(UA_Server *server, UA_Session *session, void *context,
             UA_Node_deleteReference(sourceNode, refTypeIndex, item->isForward, &item->targetNodeId);
     }
 
- cleanup:
-    if(targetNode)
-        UA_NODESTORE_RELEASE(server, targetNode);
-    UA_NODESTORE_RELEASE(server, sourceNode);
+ cleanup: {
+        UA_StatusCode targetRes = UA_NODESTORE_RELEASE_EDIT(server, targetNode);
+        UA_StatusCode sourceRes = UA_NODESTORE_RELEASE_EDIT(server, sourceNode);
+        if(*retval == UA_STATUSCODE_GOOD)
+            *retval = (sourceRes != UA_STATUSCODE_GOOD) ? sourceRes : targetRes;
+    }
 }
 
 void
@@ -2203,7 +2649,7 @@ Service_AddReferences(UA_Server *server, UA_Session *session,
                       UA_AddReferencesResponse *response) {
     UA_LOG_DEBUG_SESSION(server->config.logging, session,
                          "Processing AddReferencesRequest");
-    UA_LOCK_ASSERT(&server->serviceMutex);
+    UA_LOCK_ASSERT_EXCLUSIVE(&server->serviceMutex);
     UA_assert(session);
 
     if(server->config.maxNodesPerNodeManagement != 0 &&
@@ -2280,6 +2726,10 @@ Operation_deleteReference(UA_Server *server, UA_Session *session, void *context,
     UA_Byte refTypeIndex = refType->referenceTypeNode.referenceTypeIndex;
     UA_NODESTORE_RELEASE(server, refType);
 
+    server->hierarchyEpoch++;
+    if(refTypeIndex == UA_REFERENCETYPEINDEX_HASSUBTYPE)
+        invalidateTypeHierarchy(server);
+
     // TODO: Check consistency constraints, remove the references.
 
     /* Delete the reference in this direction */
@@ -2290,10 +2740,12 @@ Operation_deleteReference(UA_Server *server, UA_Session *session, void *context,
                                         UA_BROWSEDIRECTION_FORWARD : UA_BROWSEDIRECTION_INVERSE);
     if(firstNode) {
         *retval = UA_Node_deleteReference(firstNode, refTypeIndex, item->isForward, &item->targetNodeId);
+        UA_StatusCode releaseRes = UA_NODESTORE_RELEASE_EDIT(server, firstNode);
+        if(*retval == UA_STATUSCODE_GOOD)
+            *retval = releaseRes;
     } else {
         *retval = UA_STATUSCODE_BADNODEIDUNKNOWN;
     }
-    UA_NODESTORE_RELEASE(server, firstNode);
     if(*retval != UA_STATUSCODE_GOOD)
         return;
 
@@ -2312,7 +2764,9 @@ Operation_deleteReference(UA_Server *server, UA_Session *session, void *context,
                                             UA_BROWSEDIRECTION_FORWARD : UA_BROWSEDIRECTION_INVERSE);
         if(secondNode) {
             *retval = UA_Node_deleteReference(secondNode, refTypeIndex, !item->isForward, &target2);
-            UA_NODESTORE_RELEASE(server, secondNode);
+            UA_StatusCode releaseRes = UA_NODESTORE_RELEASE_EDIT(server, secondNode);
+            if(*retval == UA_STATUSCODE_GOOD)
+                *retval = releaseRes;
         }
     }
 }
@@ -2323,7 +2777,7 @@ Service_DeleteReferences(UA_Server *server, UA_Session *session,
                          UA_DeleteReferencesResponse *response) {
     UA_LOG_DEBUG_SESSION(server->config.logging, session,
                          "Processing DeleteReferencesRequest");
-    UA_LOCK_ASSERT(&server->serviceMutex);
+    UA_LOCK_ASSERT_EXCLUSIVE(&server->serviceMutex);
 
     if(server->config.maxNodesPerNodeManagement != 0 &&
        request->referencesToDeleteSize > server->config.maxNodesPerNodeManagement) {
@@ -2502,6 +2956,39 @@ UA_Server_setVariableNode_dataSource(UA_Server *server, const UA_NodeId nodeId,
     return retval;
 }
 
+typedef struct {
+    UA_DataSourceReadBatchCallback readBatch;
+    void *device;
+} ReadBatchSettings;
+
+static UA_StatusCode
+setDataSourceReadBatch(UA_Server *server, UA_Session *session,
+                       UA_VariableNode *node, const ReadBatchSettings *settings) {
+    if(node->head.nodeClass != UA_NODECLASS_VARIABLE)
+        return UA_STATUSCODE_BADNODECLASSINVALID;
+    node->readBatch = settings->readBatch;
+    node->readBatchDevice = settings->device;
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_Server_setVariableNode_dataSourceReadBatch(UA_Server *server,
+                                              const UA_NodeId nodeId,
+                                              UA_DataSourceReadBatchCallback readBatch,
+                                              void *device) {
+    ReadBatchSettings settings = {readBatch, device};
+    UA_LOCK(&server->serviceMutex);
+    UA_StatusCode retval =
+        UA_Server_editNode(server, &server->adminSession, &nodeId,
+                           UA_NODEATTRIBUTESMASK_VALUE, UA_REFERENCETYPESET_NONE,
+                           UA_BROWSEDIRECTION_INVALID,
+                           (UA_EditNodeCallback)setDataSourceReadBatch, &settings);
+    if(retval == UA_STATUSCODE_GOOD && readBatch)
+        server->dataSourceBatchRead = true;
+    UA_UNLOCK(&server->serviceMutex);
+    return retval;
+}
+
 /******************************/
 /* Set External Value Source  */
 /******************************/
@@ -2520,6 +3007,19 @@ setExternalValueSource(UA_Server *server, UA_Session *session,
     return UA_STATUSCODE_GOOD;
 }
 
+/******************************/
+/* Set Memory Value Backend   */
+/******************************/
+static UA_StatusCode
+setMemoryValueBackend(UA_Server *server, UA_Session *session,
+                      UA_VariableNode *node, const UA_ValueBackend *valueBackend) {
+    if(node->head.nodeClass != UA_NODECLASS_VARIABLE)
+        return UA_STATUSCODE_BADNODECLASSINVALID;
+    node->valueBackend.backendType = UA_VALUEBACKENDTYPE_MEMORY;
+    node->valueBackend.backend.memory = valueBackend->backend.memory;
+    return UA_STATUSCODE_GOOD;
+}
+
 /****************************/
 /* Set Data Source Callback */
 /****************************/
@@ -2564,6 +3064,20 @@ UA_Server_setVariableNode_valueBackend(UA_Server *server, const UA_NodeId nodeId
                 /* cast away const because callback uses const anyway */
                                         (UA_ValueCallback *)(uintptr_t) &valueBackend);
             break;
+        case UA_VALUEBACKENDTYPE_MEMORY:
+            /* The region is copied with memcpy */
+            if(!valueBackend.backend.memory.data ||
+               !valueBackend.backend.memory.type ||
+               !valueBackend.backend.memory.type->pointerFree) {
+                retval = UA_STATUSCODE_BADINVALIDARGUMENT;
+                break;
+            }
+            retval = UA_Server_editNode(server, &server->adminSession, &nodeId,
+                                        UA_NODEATTRIBUTESMASK_VALUE, UA_REFERENCETYPESET_NONE,
+                                        UA_BROWSEDIRECTION_INVALID,
+                                        (UA_EditNodeCallback) setMemoryValueBackend,
+                                        (UA_ValueBackend *)(uintptr_t) &valueBackend);
+            break;
     }
 
 
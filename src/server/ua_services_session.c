@@ -16,6 +16,43 @@
 #include "ua_server_internal.h"
 #include "ua_services.h"
 
+enum ZIP_CMP
+cmpSessionNodeId(const UA_NodeId *a, const UA_NodeId *b) {
+    return (enum ZIP_CMP)UA_NodeId_order(a, b);
+}
+
+/* Look up the session in the index. Counts the visited tree nodes for the
+ * statistics. */
+static session_list_entry *
+findSessionByToken(UA_Server *server, const UA_NodeId *token) {
+    server->sessionLookupCount++;
+    session_list_entry *cur = ZIP_ROOT(&server->sessionsByToken);
+    while(cur) {
+        server->sessionLookupSteps++;
+        enum ZIP_CMP eq = cmpSessionNodeId(token, &cur->session.authenticationToken);
+        if(eq == ZIP_CMP_EQ)
+            break;
+        cur = (eq == ZIP_CMP_LESS) ?
+            ZIP_LEFT(cur, tokenTreeEntry) : ZIP_RIGHT(cur, tokenTreeEntry);
+    }
+    return cur;
+}
+
+static session_list_entry *
+findSessionById(UA_Server *server, const UA_NodeId *sessionId) {
+    server->sessionLookupCount++;
+    session_list_entry *cur = ZIP_ROOT(&server->sessionsById);
+    while(cur) {
+        server->sessionLookupSteps++;
+        enum ZIP_CMP eq = cmpSessionNodeId(sessionId, &cur->session.sessionId);
+        if(eq == ZIP_CMP_EQ)
+            break;
+        cur = (eq == ZIP_CMP_LESS) ?
+            ZIP_LEFT(cur, idTreeEntry) : ZIP_RIGHT(cur, idTreeEntry);
+    }
+    return cur;
+}
+
 /* Delayed callback to free the session memory */
 static void
 removeSessionCallback(UA_Server *server, session_list_entry *entry) {
@@ -58,15 +95,27 @@ UA_Server_removeSession(UA_Server *server, session_list_entry *sentry,
     /* Detach the Session from the SecureChannel */
     UA_Session_detachFromSecureChannel(session);
 
+    /* Forward the removal to the standby server */
+    replicateSessionRemoved(server, session);
+
     /* Deactivate the session */
     if(sentry->session.activated) {
         sentry->session.activated = false;
         server->activeSessionCount--;
     }
 
+    /* Stop the timeout timer */
+    if(sentry->timeoutCallbackId != 0) {
+        UA_EventLoop *el = server->config.eventLoop;
+        el->removeTimer(el, sentry->timeoutCallbackId);
+        sentry->timeoutCallbackId = 0;
+    }
+
     /* Detach the session from the session manager and make the capacity
      * available */
     LIST_REMOVE(sentry, pointers);
+    ZIP_REMOVE(UA_SessionTokenTree, &server->sessionsByToken, sentry);
+    ZIP_REMOVE(UA_SessionIdTree, &server->sessionsById, sentry);
     server->sessionCount--;
 
     switch(shutdownReason) {
@@ -103,28 +152,43 @@ UA_StatusCode
 UA_Server_removeSessionByToken(UA_Server *server, const UA_NodeId *token,
                                UA_ShutdownReason shutdownReason) {
     UA_LOCK_ASSERT(&server->serviceMutex);
-    session_list_entry *entry;
-    LIST_FOREACH(entry, &server->sessions, pointers) {
-        if(UA_NodeId_equal(&entry->session.authenticationToken, token)) {
-            UA_Server_removeSession(server, entry, shutdownReason);
-            return UA_STATUSCODE_GOOD;
-        }
+    session_list_entry *entry = findSessionByToken(server, token);
+    if(!entry)
+        return UA_STATUSCODE_BADSESSIONIDINVALID;
+    UA_Server_removeSession(server, entry, shutdownReason);
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Every Session has a one-shot timer at its validTill date. Requests move
+ * validTill forward without touching the timer. When the timer fires for a
+ * Session that was used in the meantime, it is re-armed at the new date. So
+ * only the Sessions that are about to time out are visited. */
+static UA_StatusCode
+scheduleSessionTimeout(UA_Server *server, session_list_entry *sentry);
+
+static void
+sessionTimeoutCallback(UA_Server *server, session_list_entry *sentry) {
+    UA_LOCK(&server->serviceMutex);
+    sentry->timeoutCallbackId = 0;
+    UA_EventLoop *el = server->config.eventLoop;
+    if(sentry->session.validTill >= el->dateTime_nowMonotonic(el) &&
+       scheduleSessionTimeout(server, sentry) == UA_STATUSCODE_GOOD) {
+        UA_UNLOCK(&server->serviceMutex);
+        return;
     }
-    return UA_STATUSCODE_BADSESSIONIDINVALID;
+    UA_LOG_INFO_SESSION(server->config.logging, &sentry->session,
+                        "Session has timed out");
+    UA_Server_removeSession(server, sentry, UA_SHUTDOWNREASON_TIMEOUT);
+    UA_UNLOCK(&server->serviceMutex);
 }
 
-void
-UA_Server_cleanupSessions(UA_Server *server, UA_DateTime nowMonotonic) {
+static UA_StatusCode
+scheduleSessionTimeout(UA_Server *server, session_list_entry *sentry) {
     UA_LOCK_ASSERT(&server->serviceMutex);
-    session_list_entry *sentry, *temp;
-    LIST_FOREACH_SAFE(sentry, &server->sessions, pointers, temp) {
-        /* Session has timed out? */
-        if(sentry->session.validTill >= nowMonotonic)
-            continue;
-        UA_LOG_INFO_SESSION(server->config.logging, &sentry->session,
-                            "Session has timed out");
-        UA_Server_removeSession(server, sentry, UA_SHUTDOWNREASON_TIMEOUT);
-    }
+    UA_EventLoop *el = server->config.eventLoop;
+    UA_DateTime date = sentry->session.validTill + 1;
+    return el->addTimer(el, (UA_Callback)sessionTimeoutCallback, server, sentry,
+                        0.0, &date, UA_TIMERPOLICY_ONCE, &sentry->timeoutCallbackId);
 }
 
 /************/
@@ -135,53 +199,43 @@ UA_Session *
 getSessionByToken(UA_Server *server, const UA_NodeId *token) {
     UA_LOCK_ASSERT(&server->serviceMutex);
 
-    session_list_entry *current = NULL;
-    LIST_FOREACH(current, &server->sessions, pointers) {
-        /* Token does not match */
-        if(!UA_NodeId_equal(&current->session.authenticationToken, token))
-            continue;
+    session_list_entry *current = findSessionByToken(server, token);
+    if(!current)
+        return NULL;
 
-        /* Session has timed out */
-        UA_EventLoop *el = server->config.eventLoop;
-        UA_DateTime now = el->dateTime_nowMonotonic(el);
-        if(now > current->session.validTill) {
-            UA_LOG_INFO_SESSION(server->config.logging, &current->session,
-                                "Client tries to use a session that has timed out");
-            return NULL;
-        }
-
-        return &current->session;
+    /* Session has timed out */
+    UA_EventLoop *el = server->config.eventLoop;
+    UA_DateTime now = el->dateTime_nowMonotonic(el);
+    if(now > current->session.validTill) {
+        UA_LOG_INFO_SESSION(server->config.logging, &current->session,
+                            "Client tries to use a session that has timed out");
+        return NULL;
     }
 
-    return NULL;
+    return &current->session;
 }
 
 UA_Session *
 getSessionById(UA_Server *server, const UA_NodeId *sessionId) {
     UA_LOCK_ASSERT(&server->serviceMutex);
 
-    session_list_entry *current = NULL;
-    LIST_FOREACH(current, &server->sessions, pointers) {
-        /* Token does not match */
-        if(!UA_NodeId_equal(&current->session.sessionId, sessionId))
-            continue;
-
-        /* Session has timed out */
-        UA_EventLoop *el = server->config.eventLoop;
-        UA_DateTime now = el->dateTime_nowMonotonic(el);
-        if(now > current->session.validTill) {
-            UA_LOG_INFO_SESSION(server->config.logging, &current->session,
-                                "Client tries to use a session that has timed out");
-            return NULL;
-        }
-
-        return &current->session;
+    session_list_entry *current = findSessionById(server, sessionId);
+    if(!current) {
+        if(UA_NodeId_equal(sessionId, &server->adminSession.sessionId))
+            return &server->adminSession;
+        return NULL;
     }
 
-    if(UA_NodeId_equal(sessionId, &server->adminSession.sessionId))
-        return &server->adminSession;
+    /* Session has timed out */
+    UA_EventLoop *el = server->config.eventLoop;
+    UA_DateTime now = el->dateTime_nowMonotonic(el);
+    if(now > current->session.validTill) {
+        UA_LOG_INFO_SESSION(server->config.logging, &current->session,
+                            "Client tries to use a session that has timed out");
+        return NULL;
+    }
 
-    return NULL;
+    return &current->session;
 }
 
 static UA_StatusCode
@@ -225,12 +279,11 @@ signCreateSessionResponse(UA_Server *server, UA_SecureChannel *channel,
     return retval;
 }
 
-/* Creates and adds a session. But it is not yet attached to a secure channel. */
-UA_StatusCode
-UA_Server_createSession(UA_Server *server, UA_SecureChannel *channel,
-                        const UA_CreateSessionRequest *request, UA_Session **session) {
-    UA_LOCK_ASSERT(&server->serviceMutex);
-
+/* Adds a session with the given SessionId and AuthenticationToken */
+static UA_StatusCode
+addSession(UA_Server *server, UA_SecureChannel *channel,
+           const UA_NodeId *sessionId, const UA_NodeId *token,
+           UA_Double timeout, UA_Session **session) {
     if(server->sessionCount >= server->config.maxSessions) {
         UA_LOG_WARNING_CHANNEL(server->config.logging, channel,
                                "Could not create a Session - Server limits reached");
@@ -244,13 +297,14 @@ UA_Server_createSession(UA_Server *server, UA_SecureChannel *channel,
 
     /* Initialize the Session */
     UA_Session_init(&newentry->session);
-    newentry->session.sessionId = UA_NODEID_GUID(1, UA_Guid_random());
-    newentry->session.authenticationToken = UA_NODEID_GUID(1, UA_Guid_random());
-
-    newentry->session.timeout = server->config.maxSessionTimeout;
-    if(request->requestedSessionTimeout <= server->config.maxSessionTimeout &&
-       request->requestedSessionTimeout > 0)
-        newentry->session.timeout = request->requestedSessionTimeout;
+    UA_StatusCode res = UA_NodeId_copy(sessionId, &newentry->session.sessionId);
+    res |= UA_NodeId_copy(token, &newentry->session.authenticationToken);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_Session_clear(&newentry->session, server);
+        UA_free(newentry);
+        return res;
+    }
+    newentry->session.timeout = timeout;
 
     /* Attach the session to the channel. But don't activate for now. */
     if(channel)
@@ -263,12 +317,47 @@ UA_Server_createSession(UA_Server *server, UA_SecureChannel *channel,
 
     /* Add to the server */
     LIST_INSERT_HEAD(&server->sessions, newentry, pointers);
+    ZIP_INSERT(UA_SessionTokenTree, &server->sessionsByToken, newentry);
+    ZIP_INSERT(UA_SessionIdTree, &server->sessionsById, newentry);
     server->sessionCount++;
 
+    res = scheduleSessionTimeout(server, newentry);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_Server_removeSession(server, newentry, UA_SHUTDOWNREASON_ABORT);
+        return res;
+    }
+
     *session = &newentry->session;
     return UA_STATUSCODE_GOOD;
 }
 
+/* Creates and adds a session. But it is not yet attached to a secure channel. */
+UA_StatusCode
+UA_Server_createSession(UA_Server *server, UA_SecureChannel *channel,
+                        const UA_CreateSessionRequest *request, UA_Session **session) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+
+    UA_Double timeout = server->config.maxSessionTimeout;
+    if(request->requestedSessionTimeout <= server->config.maxSessionTimeout &&
+       request->requestedSessionTimeout > 0)
+        timeout = request->requestedSessionTimeout;
+
+    UA_NodeId sessionId = UA_NODEID_GUID(1, UA_Guid_random());
+    UA_NodeId token = UA_NODEID_GUID(1, UA_Guid_random());
+    return addSession(server, channel, &sessionId, &token, timeout, session);
+}
+
+UA_StatusCode
+UA_Server_restoreSession(UA_Server *server, const UA_NodeId *sessionId,
+                         const UA_NodeId *token, UA_Double timeout,
+                         UA_Session **session) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+    if(findSessionById(server, sessionId) || findSessionByToken(server, token) ||
+       UA_NodeId_equal(sessionId, &server->adminSession.sessionId))
+        return UA_STATUSCODE_BADSESSIONIDINVALID;
+    return addSession(server, NULL, sessionId, token, timeout, session);
+}
+
 void
 Service_CreateSession(UA_Server *server, UA_SecureChannel *channel,
                       const UA_CreateSessionRequest *request,
@@ -793,6 +882,17 @@ Service_ActivateSession(UA_Server *server, UA_SecureChannel *channel,
                         &channel->remoteCertificate, &session->sessionId,
                         &req->userIdentityToken, &session->context);
     UA_LOCK(&server->serviceMutex);
+    UA_Session_clearDecisionCache(session);
+    session->roles = 0;
+    if(resp->responseHeader.serviceResult == UA_STATUSCODE_GOOD &&
+       server->config.accessControl.getSessionRoles) {
+        UA_UNLOCK(&server->serviceMutex);
+        UA_UInt64 roles = server->config.accessControl.
+            getSessionRoles(server, &server->config.accessControl,
+                            &session->sessionId, session->context);
+        UA_LOCK(&server->serviceMutex);
+        session->roles = roles;
+    }
     if(resp->responseHeader.serviceResult != UA_STATUSCODE_GOOD) {
         UA_LOG_WARNING_SESSION(server->config.logging, session,
                                "ActivateSession: The AccessControl "
@@ -896,6 +996,9 @@ Service_ActivateSession(UA_Server *server, UA_SecureChannel *channel,
     }
 #endif
 
+    /* Forward the activated Session to the standby server */
+    replicateSession(server, session);
+
     /* Log the user for which the Session was activated */
     UA_LOG_INFO_SESSION(server->config.logging, session,
                         "ActivateSession: Session activated with ClientUserId \"%S\"",
@@ -51,6 +51,45 @@ setSubscriptionSettings(UA_Server *server, UA_Subscription *subscription,
     subscription->priority = priority;
 }
 
+/* Add the Subscription to the server and the Session (can be NULL for a
+ * detached Subscription) and start the publish callback. The Subscription is
+ * deleted if this fails. */
+static UA_StatusCode
+registerSubscription(UA_Server *server, UA_Session *session,
+                     UA_Subscription *sub, UA_Boolean publishingEnabled) {
+    /* Register the subscription in the server */
+    LIST_INSERT_HEAD(&server->subscriptions, sub, serverListEntry);
+    server->subscriptionsSize++;
+
+    /* Update the server statistics */
+    server->serverDiagnosticsSummary.currentSubscriptionCount++;
+    server->serverDiagnosticsSummary.cumulatedSubscriptionCount++;
+
+    if(session) {
+        /* Attach the Subscription to the session */
+        UA_Session_attachSubscription(session, sub);
+
+        /* Create representation in the Session object */
+#ifdef UA_ENABLE_DIAGNOSTICS
+        createSubscriptionObject(server, session, sub);
+#endif
+    }
+
+    /* Set the subscription state. This also registers the callback.
+     * Note that also a disabled subscription publishes keepalives. */
+    UA_SubscriptionState sState = (publishingEnabled) ?
+        UA_SUBSCRIPTIONSTATE_ENABLED : UA_SUBSCRIPTIONSTATE_ENABLED_NOPUBLISH;
+    UA_StatusCode res = Subscription_setState(server, sub, sState);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_LOG_DEBUG_SESSION(server->config.logging, sub->session,
+                             "Subscription %" PRIu32 " | Could not register "
+                             "publish callback with error code %s",
+                             sub->subscriptionId, UA_StatusCode_name(res));
+        UA_Subscription_delete(server, sub);
+    }
+    return res;
+}
+
 void
 Service_CreateSubscription(UA_Server *server, UA_Session *session,
                            const UA_CreateSubscriptionRequest *request,
@@ -82,37 +121,17 @@ Service_CreateSubscription(UA_Server *server, UA_Session *session,
                             request->maxNotificationsPerPublish, request->priority);
     sub->subscriptionId = ++server->lastSubscriptionId;  /* Assign the SubscriptionId */
 
-    /* Register the subscription in the server */
-    LIST_INSERT_HEAD(&server->subscriptions, sub, serverListEntry);
-    server->subscriptionsSize++;
-
-    /* Update the server statistics */
-    server->serverDiagnosticsSummary.currentSubscriptionCount++;
-    server->serverDiagnosticsSummary.cumulatedSubscriptionCount++;
-
-    /* Attach the Subscription to the session */
-    UA_Session_attachSubscription(session, sub);
-
-    /* Create representation in the Session object */
-#ifdef UA_ENABLE_DIAGNOSTICS
-    createSubscriptionObject(server, session, sub);
-#endif
-
-    /* Set the subscription state. This also registers the callback.
-     * Note that also a disabled subscription publishes keepalives. */
-    UA_SubscriptionState sState = (request->publishingEnabled) ?
-        UA_SUBSCRIPTIONSTATE_ENABLED : UA_SUBSCRIPTIONSTATE_ENABLED_NOPUBLISH;
-    UA_StatusCode res = Subscription_setState(server, sub, sState);
+    /* Register the subscription and start publishing */
+    UA_StatusCode res =
+        registerSubscription(server, session, sub, request->publishingEnabled);
     if(res != UA_STATUSCODE_GOOD) {
-        UA_LOG_DEBUG_SESSION(server->config.logging, sub->session,
-                             "Subscription %" PRIu32 " | Could not register "
-                             "publish callback with error code %s",
-                             sub->subscriptionId, UA_StatusCode_name(res));
         response->responseHeader.serviceResult = res;
-        UA_Subscription_delete(server, sub);
         return;
     }
 
+    /* Forward to the standby server */
+    replicateSubscription(server, sub);
+
     UA_LOG_INFO_SUBSCRIPTION(server->config.logging, sub,
                              "Subscription created (Publishing interval %.2fms, "
                              "max %lu notifications per publish)",
@@ -126,6 +145,24 @@ Service_CreateSubscription(UA_Server *server, UA_Session *session,
     response->revisedMaxKeepAliveCount = sub->maxKeepAliveCount;
 }
 
+UA_StatusCode
+UA_Server_restoreSubscription(UA_Server *server, UA_Session *session,
+                              UA_Subscription *sub, UA_Boolean publishingEnabled) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+
+    /* The SubscriptionId must be unused */
+    if(sub->subscriptionId == 0 || getSubscriptionById(server, sub->subscriptionId)) {
+        UA_Subscription_delete(server, sub);
+        return UA_STATUSCODE_BADSUBSCRIPTIONIDINVALID;
+    }
+
+    /* Don't hand out the SubscriptionId again */
+    if(server->lastSubscriptionId < sub->subscriptionId)
+        server->lastSubscriptionId = sub->subscriptionId;
+
+    return registerSubscription(server, session, sub, publishingEnabled);
+}
+
 void
 Service_ModifySubscription(UA_Server *server, UA_Session *session,
                            const UA_ModifySubscriptionRequest *request,
@@ -153,14 +190,19 @@ Service_ModifySubscription(UA_Server *server, UA_Session *session,
     /* Reset the subscription lifetime */
     Subscription_resetLifetime(sub);
 
+    /* The publish interval or the priority has changed. Move to the matching
+     * position in the PublishGroups. */
+    if(sub->publishingInterval != oldPublishingInterval ||
+       sub->priority != oldPriority) {
+        UA_StatusCode res = Subscription_updatePublishGroup(server, sub);
+        if(res != UA_STATUSCODE_GOOD)
+            UA_LOG_WARNING_SUBSCRIPTION(server->config.logging, sub,
+                                        "Could not change the publishing interval. "
+                                        "The Subscription is stopped.");
+    }
+
     /* The publish interval has changed */
     if(sub->publishingInterval != oldPublishingInterval) {
-        /* Change the repeated callback to the new interval. This cannot fail as
-         * memory is reused. */
-        if(sub->publishCallbackId > 0)
-            changeRepeatedCallbackInterval(server, sub->publishCallbackId,
-                                           sub->publishingInterval);
-
         /* For each MonitoredItem check if it was/shall be attached to the
          * publish interval. This ensures that we have less cyclic callbacks
          * registered and that the notifications are fresh. */
@@ -190,6 +232,9 @@ Service_ModifySubscription(UA_Server *server, UA_Session *session,
 #ifdef UA_ENABLE_DIAGNOSTICS
     sub->modifyCount++;
 #endif
+
+    /* Forward the new settings to the standby server */
+    replicateSubscription(server, sub);
 }
 
 static void
@@ -211,6 +256,9 @@ Operation_SetPublishingMode(UA_Server *server, UA_Session *session,
 
     /* Reset the lifetime counter */
     Subscription_resetLifetime(sub);
+
+    /* Forward the publishing mode to the standby server */
+    replicateSubscription(server, sub);
 }
 
 void
@@ -287,7 +335,7 @@ Service_Publish(UA_Server *server, UA_Session *session,
         }
         /* Remove the acked transmission from the retransmission queue */
         response->results[i] =
-            UA_Subscription_removeRetransmissionMessage(sub, ack->sequenceNumber);
+            UA_Subscription_removeRetransmissionMessage(server, sub, ack->sequenceNumber);
     }
 
     /* Set the maxTime if a timeout hint is defined */
@@ -402,18 +450,17 @@ Service_Republish(UA_Server *server, UA_Session *session,
 #endif
 
     /* Find the notification in the retransmission queue  */
-    UA_NotificationMessageEntry *entry;
-    TAILQ_FOREACH(entry, &sub->retransmissionQueue, listEntry) {
-        if(entry->message.sequenceNumber == request->retransmitSequenceNumber)
-            break;
-    }
+    UA_NotificationMessageEntry *entry =
+        UA_Subscription_getRetransmissionMessage(sub, request->retransmitSequenceNumber);
     if(!entry) {
         response->responseHeader.serviceResult = UA_STATUSCODE_BADMESSAGENOTAVAILABLE;
         return;
     }
 
+    /* Decode the stored NotificationMessage into the response */
     response->responseHeader.serviceResult =
-        UA_NotificationMessage_copy(&entry->message, &response->notificationMessage);
+        UA_decodeBinary(&entry->message, &response->notificationMessage,
+                        &UA_TYPES[UA_TYPES_NOTIFICATIONMESSAGE], NULL);
 
     /* Update the subscription statistics for the case where we return a message */
 #ifdef UA_ENABLE_DIAGNOSTICS
@@ -434,7 +481,7 @@ setTransferredSequenceNumbers(const UA_Subscription *sub, UA_TransferResult *res
     UA_NotificationMessageEntry *entry;
     size_t i = 0;
     TAILQ_FOREACH(entry, &sub->retransmissionQueue, listEntry) {
-        result->availableSequenceNumbers[i] = entry->message.sequenceNumber;
+        result->availableSequenceNumbers[i] = entry->sequenceNumber;
         i++;
     }
 
@@ -513,12 +560,13 @@ Operation_TransferSubscription(UA_Server *server, UA_Session *session,
 
     /* Create an identical copy of the Subscription struct. The original
      * subscription remains in place until a StatusChange notification has been
-     * sent. The elements for lists and queues are moved over manually to ensure
-     * that all backpointers are set correctly. */
+     * sent. The lists and queues are relinked below. Their heads contain
+     * pointers into the original struct. */
     memcpy(newSub, sub, sizeof(UA_Subscription));
+    newSub->delayedCallbackRegistered = false;
 
     /* Set to the same state as the original subscription */
-    newSub->publishCallbackId = 0;
+    newSub->publishGroup = NULL;
     result->statusCode = Subscription_setState(server, newSub, sub->state);
     if(result->statusCode != UA_STATUSCODE_GOOD) {
         UA_Array_delete(result->availableSequenceNumbers,
@@ -531,38 +579,35 @@ Operation_TransferSubscription(UA_Server *server, UA_Session *session,
 
     /* <-- The point of no return --> */
 
-    /* Move over the MonitoredItems and adjust the backpointers */
-    LIST_INIT(&newSub->monitoredItems);
-    UA_MonitoredItem *mon, *mon_tmp;
-    LIST_FOREACH_SAFE(mon, &sub->monitoredItems, listEntry, mon_tmp) {
-        LIST_REMOVE(mon, listEntry);
+    /* Relink the lists of MonitoredItems. Only the backpointers of the
+     * MonitoredItems to their Subscription are rebound. */
+    LIST_MOVE(&newSub->monitoredItems, &sub->monitoredItems, listEntry);
+    LIST_MOVE(&newSub->samplingMonitoredItems, &sub->samplingMonitoredItems,
+              sampling.subscriptionSampling);
+    UA_MonitoredItem *mon;
+    LIST_FOREACH(mon, &newSub->monitoredItems, listEntry)
         mon->subscription = newSub;
-        LIST_INSERT_HEAD(&newSub->monitoredItems, mon, listEntry);
-    }
     sub->monitoredItemsSize = 0;
 
-    /* Move over the notification queue */
+    /* Relink the notification queue. The notifications point to their
+     * MonitoredItem only. */
     TAILQ_INIT(&newSub->notificationQueue);
-    UA_Notification *nn, *nn_tmp;
-    TAILQ_FOREACH_SAFE(nn, &sub->notificationQueue, subEntry, nn_tmp) {
-        TAILQ_REMOVE(&sub->notificationQueue, nn, subEntry);
-        TAILQ_INSERT_TAIL(&newSub->notificationQueue, nn, subEntry);
-    }
+    TAILQ_CONCAT(&newSub->notificationQueue, &sub->notificationQueue, subEntry);
     sub->notificationQueueSize = 0;
     sub->dataChangeNotifications = 0;
     sub->eventNotifications = 0;
 
+    /* Relink the retransmission queue. The index into the queue was copied
+     * over with the struct. */
     TAILQ_INIT(&newSub->retransmissionQueue);
-    UA_NotificationMessageEntry *nme, *nme_tmp;
-    TAILQ_FOREACH_SAFE(nme, &sub->retransmissionQueue, listEntry, nme_tmp) {
-        TAILQ_REMOVE(&sub->retransmissionQueue, nme, listEntry);
-        TAILQ_INSERT_TAIL(&newSub->retransmissionQueue, nme, listEntry);
-        if(oldSession)
-            oldSession->totalRetransmissionQueueSize -= 1;
-        sub->retransmissionQueueSize -= 1;
+    TAILQ_CONCAT(&newSub->retransmissionQueue, &sub->retransmissionQueue, listEntry);
+    if(oldSession) {
+        oldSession->totalRetransmissionQueueSize -= sub->retransmissionQueueSize;
+        oldSession->totalRetransmissionQueueBytes -= sub->retransmissionQueueBytes;
     }
-    UA_assert(sub->retransmissionQueueSize == 0);
     sub->retransmissionQueueSize = 0;
+    sub->retransmissionQueueBytes = 0;
+    memset(sub->retransmissionIndex, 0, sizeof(sub->retransmissionIndex));
 
     /* Add to the server */
     UA_assert(newSub->subscriptionId == sub->subscriptionId);
@@ -584,6 +629,9 @@ Operation_TransferSubscription(UA_Server *server, UA_Session *session,
     if(*sendInitialValues)
         UA_Subscription_resendData(server, newSub);
 
+    /* Forward the new Session of the Subscription to the standby server */
+    replicateSubscription(server, newSub);
+
     /* Do not update the statistics for the number of Subscriptions here. The
      * fact that we duplicate the subscription and move over the content is just
      * an implementtion detail.
@@ -162,10 +162,247 @@ isNodeInTreeIterateCallback(void *context, UA_ReferenceTarget *t) {
     return res;
 }
 
+/************************/
+/* Type Hierarchy Cache */
+/************************/
+
+#define UA_TYPEHIERARCHY_NONE UA_UINT32_MAX
+
+/* Number of lookups without the cache before it is rebuilt. While types are
+ * added (e.g. when a nodeset is loaded), the cache is not rebuilt after every
+ * new HasSubtype reference. */
+#define UA_TYPEHIERARCHY_REBUILD 32
+
+void
+invalidateTypeHierarchy(UA_Server *server) {
+    server->typeHierarchy.valid = false;
+    server->typeHierarchy.walks = 0;
+}
+
+void
+clearTypeHierarchy(UA_Server *server) {
+    UA_TypeHierarchy *th = &server->typeHierarchy;
+    for(size_t i = 0; i < th->capacity; i++) {
+        if(th->entries[i].used)
+            UA_NodeId_clear(&th->entries[i].nodeId);
+    }
+    UA_free(th->entries);
+    memset(th, 0, sizeof(UA_TypeHierarchy));
+}
+
+static UA_UInt32
+findTypeHierarchyEntry(const UA_TypeHierarchy *th, const UA_NodeId *id,
+                       UA_UInt32 hash) {
+    size_t mask = th->capacity - 1;
+    for(size_t i = hash & mask; th->entries[i].used; i = (i + 1) & mask) {
+        if(th->entries[i].hash == hash &&
+           UA_NodeId_equal(&th->entries[i].nodeId, id))
+            return (UA_UInt32)i;
+    }
+    return UA_TYPEHIERARCHY_NONE;
+}
+
+/* The capacity is chosen so that the table never fills up */
+static UA_UInt32
+addTypeHierarchyEntry(UA_TypeHierarchy *th, const UA_NodeId *id,
+                      UA_StatusCode *res) {
+    UA_UInt32 hash = UA_NodeId_hash(id);
+    size_t mask = th->capacity - 1;
+    size_t i = hash & mask;
+    for(; th->entries[i].used; i = (i + 1) & mask) {
+        if(th->entries[i].hash == hash &&
+           UA_NodeId_equal(&th->entries[i].nodeId, id))
+            return (UA_UInt32)i;
+    }
+    UA_TypeHierarchyEntry *e = &th->entries[i];
+    *res |= UA_NodeId_copy(id, &e->nodeId);
+    e->hash = hash;
+    e->used = true;
+    e->parent = UA_TYPEHIERARCHY_NONE;
+    e->firstChild = UA_TYPEHIERARCHY_NONE;
+    e->nextSibling = UA_TYPEHIERARCHY_NONE;
+    return (UA_UInt32)i;
+}
+
+struct TypeHierarchyBuildContext {
+    UA_TypeHierarchy *th;
+    const UA_NodeId *childId;
+    UA_UInt32 child;
+    size_t edges; /* Counted in the first pass */
+    UA_Boolean count;
+    UA_Boolean multipleParents;
+    UA_StatusCode res;
+};
+
+static void *
+typeHierarchyParentCallback(void *context, UA_ReferenceTarget *t) {
+    struct TypeHierarchyBuildContext *bc =
+        (struct TypeHierarchyBuildContext*)context;
+    if(!UA_NodePointer_isLocal(t->targetId))
+        return NULL;
+    if(bc->count) {
+        bc->edges++;
+        return NULL;
+    }
+    if(bc->child == UA_TYPEHIERARCHY_NONE)
+        bc->child = addTypeHierarchyEntry(bc->th, bc->childId, &bc->res);
+    UA_NodeId parentId = UA_NodePointer_toNodeId(t->targetId);
+    UA_UInt32 parent = addTypeHierarchyEntry(bc->th, &parentId, &bc->res);
+    UA_TypeHierarchyEntry *e = &bc->th->entries[bc->child];
+    if(e->parent != UA_TYPEHIERARCHY_NONE && e->parent != parent)
+        bc->multipleParents = true;
+    e->parent = parent;
+    return NULL;
+}
+
+/* Only the inverse HasSubtype references are considered. Like in the
+ * recursive search of isNodeInTree. */
+static void
+typeHierarchyVisitor(void *visitorCtx, const UA_Node *node) {
+    struct TypeHierarchyBuildContext *bc =
+        (struct TypeHierarchyBuildContext*)visitorCtx;
+    bc->childId = &node->head.nodeId;
+    bc->child = UA_TYPEHIERARCHY_NONE;
+    for(size_t i = 0; i < node->head.referencesSize; i++) {
+        UA_NodeReferenceKind *rk = &node->head.references[i];
+        if(!rk->isInverse ||
+           rk->referenceTypeIndex != UA_REFERENCETYPEINDEX_HASSUBTYPE)
+            continue;
+        UA_NodeReferenceKind_iterate(rk, typeHierarchyParentCallback, bc);
+    }
+}
+
+/* Number the entries in the order of a depth-first traversal from the roots.
+ * Entries in a HasSubtype cycle are not reachable and keep pre == 0. */
+static void
+numberTypeHierarchy(UA_TypeHierarchy *th) {
+    UA_TypeHierarchyEntry *e = th->entries;
+    for(UA_UInt32 i = 0; i < th->capacity; i++) {
+        if(!e[i].used || e[i].parent == UA_TYPEHIERARCHY_NONE)
+            continue;
+        e[i].nextSibling = e[e[i].parent].firstChild;
+        e[e[i].parent].firstChild = i;
+    }
+
+    UA_UInt32 counter = 0;
+    for(UA_UInt32 root = 0; root < th->capacity; root++) {
+        if(!e[root].used || e[root].parent != UA_TYPEHIERARCHY_NONE)
+            continue;
+        UA_UInt32 n = root;
+        e[n].depth = 0;
+        while(true) {
+            e[n].pre = ++counter;
+            UA_UInt32 c = e[n].firstChild;
+            if(c != UA_TYPEHIERARCHY_NONE) {
+                e[c].depth = (e[n].depth < UA_UINT16_MAX) ?
+                    (UA_UInt16)(e[n].depth + 1) : UA_UINT16_MAX;
+                n = c;
+                continue;
+            }
+            /* Go up until a sibling is found */
+            while(true) {
+                e[n].post = ++counter;
+                if(n == root)
+                    break;
+                UA_UInt32 sib = e[n].nextSibling;
+                if(sib != UA_TYPEHIERARCHY_NONE) {
+                    e[sib].depth = e[n].depth;
+                    n = sib;
+                    break;
+                }
+                n = e[n].parent;
+            }
+            if(n == root)
+                break;
+        }
+    }
+}
+
+static void
+buildTypeHierarchy(UA_Server *server) {
+    UA_TypeHierarchy *th = &server->typeHierarchy;
+    clearTypeHierarchy(server);
+    th->valid = true; /* Don't retry until the next invalidation */
+
+    /* Count the HasSubtype references */
+    struct TypeHierarchyBuildContext bc;
+    memset(&bc, 0, sizeof(struct TypeHierarchyBuildContext));
+    bc.th = th;
+    bc.count = true;
+    server->config.nodestore.iterate(server->config.nodestore.context,
+                                     typeHierarchyVisitor, &bc);
+
+    /* At most 2 entries per reference. Keep the load factor below 0.5. */
+    size_t capacity = 16;
+    while(capacity < bc.edges * 4)
+        capacity <<= 1;
+    th->entries = (UA_TypeHierarchyEntry*)
+        UA_calloc(capacity, sizeof(UA_TypeHierarchyEntry));
+    if(!th->entries)
+        return;
+    th->capacity = capacity;
+
+    /* Add the entries */
+    bc.count = false;
+    server->config.nodestore.iterate(server->config.nodestore.context,
+                                     typeHierarchyVisitor, &bc);
+
+    /* The hierarchy is no tree. Always use the recursive search. */
+    if(bc.multipleParents || bc.res != UA_STATUSCODE_GOOD) {
+        clearTypeHierarchy(server);
+        th->valid = true;
+        return;
+    }
+
+    numberTypeHierarchy(th);
+}
+
+/* Returns false if the cache cannot answer the lookup */
+static UA_Boolean
+lookupTypeHierarchy(UA_Server *server, const UA_NodeId *leafNode,
+                    const UA_NodeId *nodeToFind, UA_Boolean *found) {
+    UA_TypeHierarchy *th = &server->typeHierarchy;
+    if(!th->valid) {
+        if(th->walks < UA_TYPEHIERARCHY_REBUILD) {
+            th->walks++;
+            return false;
+        }
+        buildTypeHierarchy(server);
+    }
+    if(th->capacity == 0)
+        return false;
+
+    /* Without an entry, the leaf has no supertype */
+    *found = false;
+    UA_UInt32 l = findTypeHierarchyEntry(th, leafNode, UA_NodeId_hash(leafNode));
+    if(l == UA_TYPEHIERARCHY_NONE)
+        return true;
+    const UA_TypeHierarchyEntry *le = &th->entries[l];
+    if(le->pre == 0)
+        return false; /* Cycle, use the recursive search */
+
+    UA_UInt32 f = findTypeHierarchyEntry(th, nodeToFind, UA_NodeId_hash(nodeToFind));
+    if(f == UA_TYPEHIERARCHY_NONE)
+        return true;
+    const UA_TypeHierarchyEntry *fe = &th->entries[f];
+    *found = (fe->pre <= le->pre && le->post <= fe->post &&
+              le->depth - fe->depth <= UA_MAX_TREE_RECURSE);
+    return true;
+}
+
 UA_Boolean
 isNodeInTree(UA_Server *server, const UA_NodeId *leafNode,
              const UA_NodeId *nodeToFind,
              const UA_ReferenceTypeSet *relevantRefs) {
+    /* Use the cached HasSubtype hierarchy */
+    if(UA_NodeId_equal(leafNode, nodeToFind))
+        return true;
+    UA_ReferenceTypeSet hasSubtype = UA_REFTYPESET(UA_REFERENCETYPEINDEX_HASSUBTYPE);
+    UA_Boolean found;
+    if(memcmp(relevantRefs, &hasSubtype, sizeof(UA_ReferenceTypeSet)) == 0 &&
+       lookupTypeHierarchy(server, leafNode, nodeToFind, &found))
+        return found;
+
     struct IsNodeInTreeContext ctx;
     memset(&ctx, 0, sizeof(struct IsNodeInTreeContext));
     ctx.server = server;
@@ -248,8 +485,10 @@ RefTree_double(RefTree *rt) {
     return UA_STATUSCODE_GOOD;
 }
 
+/* Returns the position of the (new or existing) target in the targets array */
 static UA_StatusCode
-RefTree_add(RefTree *rt, UA_NodePointer target, UA_Boolean *duplicate) {
+RefTree_addIndex(RefTree *rt, UA_NodePointer target, UA_Boolean *duplicate,
+                 size_t *index) {
     UA_ExpandedNodeId en = UA_NodePointer_toExpandedNodeId(target);
 
     /* Is the target already in the tree? */
@@ -257,9 +496,12 @@ RefTree_add(RefTree *rt, UA_NodePointer target, UA_Boolean *duplicate) {
     memset(&dummy, 0, sizeof(RefEntry));
     dummy.target = &en;
     dummy.targetHash = UA_ExpandedNodeId_hash(&en);
-    if(ZIP_FIND(RefHead, &rt->head, &dummy)) {
+    RefEntry *found = ZIP_FIND(RefHead, &rt->head, &dummy);
+    if(found) {
         if(duplicate)
             *duplicate = true;
+        if(index)
+            *index = (size_t)(found->target - rt->targets);
         return UA_STATUSCODE_GOOD;
     }
 
@@ -278,10 +520,17 @@ RefTree_add(RefTree *rt, UA_NodePointer target, UA_Boolean *duplicate) {
     re->target = &rt->targets[rt->size];
     re->targetHash = dummy.targetHash;
     ZIP_INSERT(RefHead, &rt->head, re);
+    if(index)
+        *index = rt->size;
     rt->size++;
     return UA_STATUSCODE_GOOD;
 }
 
+static UA_StatusCode
+RefTree_add(RefTree *rt, UA_NodePointer target, UA_Boolean *duplicate) {
+    return RefTree_addIndex(rt, target, duplicate, NULL);
+}
+
 UA_StatusCode
 RefTree_addNodeId(RefTree *rt, const UA_NodeId *target,
                   UA_Boolean *duplicate) {
@@ -309,76 +558,129 @@ RefTree_containsNodeId(RefTree *rt, const UA_NodeId *target) {
 /* Browse Recursive */
 /********************/
 
+/* The nodes are visited breadth-first. The RefTree of visited nodes doubles as
+ * the queue. Every node is expanded once, also if it does not match the
+ * NodeClass mask. A node is found at the lowest depth first, so the depth limit
+ * does not cut off parts of the tree that are reachable via a shorter path. */
+
+#define BROWSERECURSIVE_START   0x01 /* Start node */
+#define BROWSERECURSIVE_REACHED 0x02 /* Reached from another node */
+#define BROWSERECURSIVE_MATCH   0x04 /* Matches the NodeClass mask */
+
 struct BrowseRecursiveContext {
     UA_Server *server;
-    RefTree *rt;
-    UA_UInt16 depth;
+    RefTree visited;
+    UA_Byte *flags; /* Flags for every entry in visited */
+    size_t flagsCapacity;
     UA_BrowseDirection browseDirection;
     UA_ReferenceTypeSet refTypes;
     UA_UInt32 nodeClassMask;
     UA_StatusCode status;
-    UA_Boolean includeStartNodes;
 };
 
-static void *
-browseRecursiveCallback(void *context, UA_ReferenceTarget *t) {
-    struct BrowseRecursiveContext *brc =
-        (struct BrowseRecursiveContext*)context;
-
-    /* Have we reached the max recursion depth? */
-    if(brc->depth >= UA_MAX_TREE_RECURSE)
-        return NULL;
-
-    /* Is this a non-local reference? If yes include it in the returned set. */
-    if(!UA_NodePointer_isLocal(t->targetId)) {
-        brc->status = RefTree_add(brc->rt, t->targetId, NULL);
-        return (brc->status == UA_STATUSCODE_GOOD) ? NULL : (void*)0x01;
+/* Add to the visited tree and set the flags */
+static UA_StatusCode
+browseRecursiveVisit(struct BrowseRecursiveContext *brc, UA_NodePointer target,
+                     UA_Byte flags) {
+    UA_Boolean duplicate = false;
+    size_t index = 0;
+    UA_StatusCode res =
+        RefTree_addIndex(&brc->visited, target, &duplicate, &index);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    if(index >= brc->flagsCapacity) {
+        size_t capacity = brc->visited.capacity;
+        UA_Byte *newFlags = (UA_Byte*)UA_realloc(brc->flags, capacity);
+        if(!newFlags)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        memset(&newFlags[brc->flagsCapacity], 0, capacity - brc->flagsCapacity);
+        brc->flags = newFlags;
+        brc->flagsCapacity = capacity;
     }
+    brc->flags[index] |= flags;
+    return UA_STATUSCODE_GOOD;
+}
 
-    /* We only look at the NodeClass attribute and a subset of the references.
-     * Get a node with only these elements if the NodeStore supports that. */
-    const UA_Node *node =
-        UA_NODESTORE_GETFROMREF_SELECTIVE(brc->server, t->targetId,
-                                          UA_NODEATTRIBUTESMASK_NODECLASS,
-                                          brc->refTypes, brc->browseDirection);
-    if(!node)
-        return NULL;
-
-    /* Add the current node if we don't want to skip it as a start node and it
-     * matches the nodeClassMask filter Recurse into the children in any
-     * case. */
-    const UA_NodeHead *head = &node->head;
-    if((brc->includeStartNodes || brc->depth > 0)  &&
-       matchClassMask(node, brc->nodeClassMask)) {
-        UA_Boolean duplicate = false;
-        brc->status = RefTree_addNodeId(brc->rt, &head->nodeId, &duplicate);
-        if(duplicate || brc->status != UA_STATUSCODE_GOOD)
-            goto cleanup;
-    }
+static void *
+browseRecursiveTargetCallback(void *context, UA_ReferenceTarget *t) {
+    struct BrowseRecursiveContext *brc = (struct BrowseRecursiveContext*)context;
+    brc->status = browseRecursiveVisit(brc, t->targetId, BROWSERECURSIVE_REACHED);
+    return (brc->status == UA_STATUSCODE_GOOD) ? NULL : (void*)0x01;
+}
 
-    /* Recurse */
-    brc->depth++;
-    void *res = NULL;
-    for(size_t i = 0; i < head->referencesSize && !res; i++) {
-        UA_NodeReferenceKind *rk = &head->references[i];
+static UA_StatusCode
+browseRecursiveDirection(struct BrowseRecursiveContext *brc,
+                         size_t startNodesSize, const UA_NodeId *startNodes) {
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    for(size_t i = 0; i < startNodesSize && res == UA_STATUSCODE_GOOD; i++)
+        res = browseRecursiveVisit(brc, UA_NodePointer_fromNodeId(&startNodes[i]),
+                                   BROWSERECURSIVE_START);
+
+    /* Process the queue. The depth increases when the end of the current level
+     * is reached. */
+    UA_UInt16 depth = 0;
+    size_t levelEnd = brc->visited.size;
+    for(size_t i = 0; i < brc->visited.size && res == UA_STATUSCODE_GOOD; i++) {
+        if(i == levelEnd) {
+            depth++;
+            levelEnd = brc->visited.size;
+        }
 
-        /* Reference in the right direction? */
-        if(rk->isInverse && brc->browseDirection == UA_BROWSEDIRECTION_FORWARD)
+        /* Non-local nodes are not expanded and always part of the result */
+        if(!UA_ExpandedNodeId_isLocal(&brc->visited.targets[i])) {
+            brc->flags[i] |= BROWSERECURSIVE_MATCH;
             continue;
-        if(!rk->isInverse && brc->browseDirection == UA_BROWSEDIRECTION_INVERSE)
+        }
+
+        /* We only look at the NodeClass attribute and a subset of the
+         * references. Get a node with only these elements if the NodeStore
+         * supports that. */
+        const UA_Node *node =
+            UA_NODESTORE_GET_SELECTIVE(brc->server, &brc->visited.targets[i].nodeId,
+                                       UA_NODEATTRIBUTESMASK_NODECLASS,
+                                       brc->refTypes, brc->browseDirection);
+        if(!node)
             continue;
 
-        /* Is the reference part of the hierarchy of references we look for? */
-        if(!UA_ReferenceTypeSet_contains(&brc->refTypes, rk->referenceTypeIndex))
+        if(matchClassMask(node, brc->nodeClassMask))
+            brc->flags[i] |= BROWSERECURSIVE_MATCH;
+
+        /* Have we reached the max recursion depth? */
+        if(depth + 1 >= UA_MAX_TREE_RECURSE) {
+            UA_NODESTORE_RELEASE(brc->server, node);
             continue;
+        }
+
+        /* Enqueue the targets */
+        const UA_NodeHead *head = &node->head;
+        for(size_t j = 0; j < head->referencesSize && res == UA_STATUSCODE_GOOD; j++) {
+            UA_NodeReferenceKind *rk = &head->references[j];
+
+            /* Reference in the right direction? */
+            if(rk->isInverse && brc->browseDirection == UA_BROWSEDIRECTION_FORWARD)
+                continue;
+            if(!rk->isInverse && brc->browseDirection == UA_BROWSEDIRECTION_INVERSE)
+                continue;
+
+            /* Is the reference part of the hierarchy of references we look for? */
+            if(!UA_ReferenceTypeSet_contains(&brc->refTypes, rk->referenceTypeIndex))
+                continue;
 
-        res = UA_NodeReferenceKind_iterate(rk, browseRecursiveCallback, brc);
+            UA_NodeReferenceKind_iterate(rk, browseRecursiveTargetCallback, brc);
+            res = brc->status;
+        }
+        UA_NODESTORE_RELEASE(brc->server, node);
     }
-    brc->depth--;
+    return res;
+}
 
- cleanup:
-    UA_NODESTORE_RELEASE(brc->server, node);
-    return (brc->status == UA_STATUSCODE_GOOD) ? NULL : (void*)0x01;
+static UA_Boolean
+browseRecursiveIsResult(UA_Byte flags, UA_Boolean includeStartNodes) {
+    if(!(flags & BROWSERECURSIVE_MATCH))
+        return false;
+    if(!(flags & BROWSERECURSIVE_START))
+        return true;
+    return includeStartNodes || (flags & BROWSERECURSIVE_REACHED);
 }
 
 UA_StatusCode
@@ -386,47 +688,78 @@ browseRecursive(UA_Server *server, size_t startNodesSize, const UA_NodeId *start
                 UA_BrowseDirection browseDirection, const UA_ReferenceTypeSet *refTypes,
                 UA_UInt32 nodeClassMask, UA_Boolean includeStartNodes,
                 size_t *resultsSize, UA_ExpandedNodeId **results) {
-    RefTree rt;
-    UA_StatusCode retval = RefTree_init(&rt);
-    if(retval != UA_STATUSCODE_GOOD)
-        return retval;
-
     struct BrowseRecursiveContext brc;
+    memset(&brc, 0, sizeof(struct BrowseRecursiveContext));
     brc.server = server;
-    brc.rt = &rt;
-    brc.depth = 0;
     brc.refTypes = *refTypes;
     brc.nodeClassMask = nodeClassMask;
-    brc.status = UA_STATUSCODE_GOOD;
-    brc.includeStartNodes = includeStartNodes;
-
-    for(size_t i = 0; i < startNodesSize && brc.status == UA_STATUSCODE_GOOD; i++) {
-        UA_ReferenceTarget target;
-        target.targetId = UA_NodePointer_fromNodeId(&startNodes[i]);
-
-        /* Call the inner recursive browse separately for the search direction.
-         * Otherwise we might take one step up and another step down in the
-         * search tree. */
-        if(browseDirection == UA_BROWSEDIRECTION_FORWARD ||
-           browseDirection == UA_BROWSEDIRECTION_BOTH) {
-            brc.browseDirection = UA_BROWSEDIRECTION_FORWARD;
-            browseRecursiveCallback(&brc, &target);
-        }
 
-        if(browseDirection == UA_BROWSEDIRECTION_INVERSE ||
-           browseDirection == UA_BROWSEDIRECTION_BOTH) {
+    /* Search separately for each direction. Otherwise we might take one step
+     * up and another step down in the search tree. */
+    RefTree forward;
+    memset(&forward, 0, sizeof(RefTree));
+    UA_Byte *forwardFlags = NULL;
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    if(browseDirection == UA_BROWSEDIRECTION_FORWARD ||
+       browseDirection == UA_BROWSEDIRECTION_BOTH) {
+        res = RefTree_init(&brc.visited);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+        brc.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+        res = browseRecursiveDirection(&brc, startNodesSize, startNodes);
+        forward = brc.visited;
+        forwardFlags = brc.flags;
+        memset(&brc.visited, 0, sizeof(RefTree));
+        brc.flags = NULL;
+        brc.flagsCapacity = 0;
+    }
+
+    if(res == UA_STATUSCODE_GOOD &&
+       (browseDirection == UA_BROWSEDIRECTION_INVERSE ||
+        browseDirection == UA_BROWSEDIRECTION_BOTH)) {
+        res = RefTree_init(&brc.visited);
+        if(res == UA_STATUSCODE_GOOD) {
             brc.browseDirection = UA_BROWSEDIRECTION_INVERSE;
-            browseRecursiveCallback(&brc, &target);
+            res = browseRecursiveDirection(&brc, startNodesSize, startNodes);
         }
-    }
 
-    if(rt.size > 0 && brc.status == UA_STATUSCODE_GOOD) {
-        *results = rt.targets;
-        *resultsSize = rt.size;
+        /* Merge the results of the forward direction */
+        for(size_t i = 0; i < forward.size && res == UA_STATUSCODE_GOOD; i++) {
+            if(!browseRecursiveIsResult(forwardFlags[i], includeStartNodes))
+                continue;
+            res = browseRecursiveVisit(&brc,
+                                       UA_NodePointer_fromExpandedNodeId(&forward.targets[i]),
+                                       BROWSERECURSIVE_MATCH | BROWSERECURSIVE_REACHED);
+        }
+        if(forward.targets)
+            RefTree_clear(&forward);
+        UA_free(forwardFlags);
     } else {
-        RefTree_clear(&rt);
+        brc.visited = forward;
+        brc.flags = forwardFlags;
     }
-    return brc.status;
+
+    /* Compact the visited nodes to the results. The tree-part of the RefTree
+     * is no longer consistent afterwards. */
+    size_t pos = 0;
+    for(size_t i = 0; i < brc.visited.size; i++) {
+        if(res == UA_STATUSCODE_GOOD &&
+           browseRecursiveIsResult(brc.flags[i], includeStartNodes)) {
+            brc.visited.targets[pos++] = brc.visited.targets[i];
+            continue;
+        }
+        UA_ExpandedNodeId_clear(&brc.visited.targets[i]);
+    }
+    brc.visited.size = pos;
+    UA_free(brc.flags);
+
+    if(pos > 0) {
+        *results = brc.visited.targets;
+        *resultsSize = pos;
+    } else if(brc.visited.targets) {
+        RefTree_clear(&brc.visited);
+    }
+    return res;
 }
 
 UA_StatusCode
@@ -509,6 +842,9 @@ struct ContinuationPoint {
     UA_NodePointer lastTarget;
     UA_Byte lastRefKindIndex;
     UA_Boolean lastRefInverse;
+    size_t lastTargetIndex; /* Position of the last target if the references
+                             * are stored in an array. Checked before searching
+                             * the array for the last target. */
 };
 
 ContinuationPoint *
@@ -529,6 +865,9 @@ struct BrowseContext {
                                      * lookups */
     UA_Boolean activeCP; /* true during "forwarding" to the position of the last
                           * reference target */
+    size_t arrayOffset; /* Targets skipped in the array while resuming */
+    UA_Boolean prefetched; /* The node was resolved in advance (can be NULL) */
+    const UA_Node *node;
 
     /* Results */
     RefResult rr;
@@ -624,6 +963,13 @@ browseReferencTargetCallback(void *context, UA_ReferenceTarget *t) {
         UA_NODESTORE_RELEASE(bc->server, target);
         return NULL;
     }
+
+    /* Omit targets that the session must not browse */
+    if(!checkRolePermission(bc->server, bc->session, &target->head,
+                            UA_ROLEPERMISSION_BROWSE)) {
+        UA_NODESTORE_RELEASE(bc->server, target);
+        return NULL;
+    }
     
     /* Reached maxrefs. Return the "abort" signal. */
     if(bc->rr.size >= cp->maxReferences) {
@@ -641,6 +987,8 @@ browseReferencTargetCallback(void *context, UA_ReferenceTarget *t) {
     cp->lastTarget = t->targetId;
     cp->lastRefKindIndex = bc->rk->referenceTypeIndex;
     cp->lastRefInverse = bc->rk->isInverse;
+    if(!bc->rk->hasRefTree && !bc->rk->isCompact)
+        cp->lastTargetIndex = bc->arrayOffset + (size_t)(t - bc->rk->targets.array);
 
     /* Abort if the status is not good. Also doesn't make a deep-copy of
      * cp->lastTarget after returning from here. */
@@ -685,7 +1033,12 @@ browseWithNode(struct BrowseContext *bc, const UA_NodeHead *head ) {
         UA_ReferenceIdTree left = {NULL}, right = {NULL};
         size_t nextTargetIndex = 0;
         if(bc->activeCP) {
-            if(rk->hasRefTree) {
+            if(rk->isCompact) {
+                /* Binary search for the position after the last target. The
+                 * compact representation is not modified. */
+                UA_NodeId lastId = UA_NodePointer_toNodeId(cp->lastTarget);
+                nextTargetIndex = UA_NodeReferenceKind_compactUpperBound(rk, &lastId);
+            } else if(rk->hasRefTree) {
                 /* Unzip the tree until the continuation point. All NodeIds
                  * larger than the last target are guaranteed to sit on the
                  * right-hand side. */
@@ -699,11 +1052,18 @@ browseWithNode(struct BrowseContext *bc, const UA_NodeHead *head ) {
                           &key, &left, &right);
                 rk->targets.tree.idRoot = right.root;
             } else {
-                /* Iterate over the array to find the match */
-                for(; nextTargetIndex < rk->targetsSize; nextTargetIndex++) {
-                    UA_ReferenceTarget *t = &rk->targets.array[nextTargetIndex];
-                    if(UA_NodePointer_equal(cp->lastTarget, t->targetId))
-                        break;
+                /* Try the stored position first. Iterate over the array to
+                 * find the match if the array was modified in between. */
+                nextTargetIndex = cp->lastTargetIndex;
+                if(nextTargetIndex >= rk->targetsSize ||
+                   !UA_NodePointer_equal(cp->lastTarget,
+                                         rk->targets.array[nextTargetIndex].targetId)) {
+                    for(nextTargetIndex = 0; nextTargetIndex < rk->targetsSize;
+                        nextTargetIndex++) {
+                        UA_ReferenceTarget *t = &rk->targets.array[nextTargetIndex];
+                        if(UA_NodePointer_equal(cp->lastTarget, t->targetId))
+                            break;
+                    }
                 }
                 if(nextTargetIndex == rk->targetsSize) {
                     /* Not found - assume that this reference kind is done */
@@ -713,6 +1073,7 @@ browseWithNode(struct BrowseContext *bc, const UA_NodeHead *head ) {
                 nextTargetIndex++; /* From the last index to the next index */
                 rk->targets.array = &rk->targets.array[nextTargetIndex];
                 rk->targetsSize -= nextTargetIndex;
+                bc->arrayOffset = nextTargetIndex;
             }
 
             /* Clear cp->lastTarget before it gets overwritten in the following
@@ -722,11 +1083,16 @@ browseWithNode(struct BrowseContext *bc, const UA_NodeHead *head ) {
 
         /* Iterate over all reference targets */
         bc->rk = rk;
-        void *res = UA_NodeReferenceKind_iterate(rk, browseReferencTargetCallback, bc);
+        void *res = (rk->isCompact) ?
+            UA_NodeReferenceKind_iterateCompact(rk, nextTargetIndex,
+                                                browseReferencTargetCallback, bc) :
+            UA_NodeReferenceKind_iterate(rk, browseReferencTargetCallback, bc);
 
         /* Undo the "skipping ahead" for the continuation point */
         if(bc->activeCP) {
-            if(rk->hasRefTree) {
+            if(rk->isCompact) {
+                /* Nothing to undo */
+            } else if(rk->hasRefTree) {
                 rk->targets.tree.idRoot =
                     ZIP_ZIP(UA_ReferenceIdTree, left.root, right.root);
             } else {
@@ -734,6 +1100,7 @@ browseWithNode(struct BrowseContext *bc, const UA_NodeHead *head ) {
                 rk->targets.array = rk->targets.array - nextTargetIndex;
                 rk->targetsSize += nextTargetIndex;
                 UA_assert(rk->targetsSize > 0);
+                bc->arrayOffset = 0;
             }
             bc->activeCP = false;
         }
@@ -772,17 +1139,26 @@ browse(struct BrowseContext *bc) {
         return;
     }
 
-    /* Get node with only the selected references and attributes */
-    const UA_Node *node =
-        UA_NODESTORE_GET_SELECTIVE(bc->server, &descr->nodeId,
-                                   resultMask2AttributesMask(descr->resultMask),
-                                   bc->resultRefs, descr->browseDirection);
+    /* Get node with only the selected references and attributes. A prefetched
+     * node is released by the caller. */
+    const UA_Node *node = bc->node;
+    if(!bc->prefetched)
+        node = UA_NODESTORE_GET_SELECTIVE(bc->server, &descr->nodeId,
+                                          resultMask2AttributesMask(descr->resultMask),
+                                          bc->resultRefs, descr->browseDirection);
     if(!node) {
         bc->status = UA_STATUSCODE_BADNODEIDUNKNOWN;
         return;
     }
 
     /* Check AccessControl rights */
+    if(!checkRolePermission(bc->server, bc->session, &node->head,
+                            UA_ROLEPERMISSION_BROWSE)) {
+        if(!bc->prefetched)
+            UA_NODESTORE_RELEASE(bc->server, node);
+        bc->status = UA_STATUSCODE_BADUSERACCESSDENIED;
+        return;
+    }
     if(bc->session != &bc->server->adminSession) {
         UA_LOCK_ASSERT(&bc->server->serviceMutex);
         UA_UNLOCK(&bc->server->serviceMutex);
@@ -791,7 +1167,8 @@ browse(struct BrowseContext *bc) {
                            &bc->session->sessionId, bc->session->context,
                            &descr->nodeId, node->head.context)) {
             UA_LOCK(&bc->server->serviceMutex);
-            UA_NODESTORE_RELEASE(bc->server, node);
+            if(!bc->prefetched)
+                UA_NODESTORE_RELEASE(bc->server, node);
             bc->status = UA_STATUSCODE_BADUSERACCESSDENIED;
             return;
         }
@@ -800,7 +1177,8 @@ browse(struct BrowseContext *bc) {
 
     /* Browse the node */
     browseWithNode(bc, &node->head);
-    UA_NODESTORE_RELEASE(bc->server, node);
+    if(!bc->prefetched)
+        UA_NODESTORE_RELEASE(bc->server, node);
 
     /* Is the reference type valid? This is very infrequent. So we only test
      * this if browsing came up empty. If the node has references of that type,
@@ -826,10 +1204,12 @@ browse(struct BrowseContext *bc) {
     }
 }
 
-/* Start to browse with no previous cp */
-void
-Operation_Browse(UA_Server *server, UA_Session *session, const UA_UInt32 *maxrefs,
-                 const UA_BrowseDescription *descr, UA_BrowseResult *result) {
+/* Start to browse with no previous cp. The node is prefetched if the
+ * BrowseDescriptions of the request are resolved in a batch. */
+static void
+browseOperation(UA_Server *server, UA_Session *session, const UA_UInt32 *maxrefs,
+                const UA_BrowseDescription *descr, UA_Boolean prefetched,
+                const UA_Node *node, UA_BrowseResult *result) {
     /* Stack-allocate a temporary cp */
     ContinuationPoint cp;
     memset(&cp, 0, sizeof(ContinuationPoint));
@@ -865,6 +1245,9 @@ Operation_Browse(UA_Server *server, UA_Session *session, const UA_UInt32 *maxref
     bc.status = UA_STATUSCODE_GOOD;
     bc.done = false;
     bc.activeCP = false;
+    bc.arrayOffset = 0;
+    bc.prefetched = prefetched;
+    bc.node = node;
     bc.resultRefs = cp.relevantReferences;
     if(cp.browseDescription.resultMask & UA_BROWSERESULTMASK_TYPEDEFINITION) {
         /* Get the node with additional reference types if we need to lookup the
@@ -925,6 +1308,7 @@ Operation_Browse(UA_Server *server, UA_Session *session, const UA_UInt32 *maxref
     UA_NodePointer_init(&cp.lastTarget); /* No longer clear below (cleanup) */
     cp2->lastRefKindIndex = cp.lastRefKindIndex;
     cp2->lastRefInverse = cp.lastRefInverse;
+    cp2->lastTargetIndex = cp.lastTargetIndex;
 
     /* Create a random bytestring via a Guid */
     ident = UA_Guid_new();
@@ -957,6 +1341,22 @@ Operation_Browse(UA_Server *server, UA_Session *session, const UA_UInt32 *maxref
     result->statusCode = retval;
 }
 
+void
+Operation_Browse(UA_Server *server, UA_Session *session, const UA_UInt32 *maxrefs,
+                 const UA_BrowseDescription *descr, UA_BrowseResult *result) {
+#ifdef UA_ENABLE_PUBSUB_INFORMATIONMODEL
+    UA_PubSubManager_materialize(server, &descr->nodeId);
+#endif
+    browseOperation(server, session, maxrefs, descr, false, NULL, result);
+}
+
+static void
+Operation_BrowseWithNode(UA_Server *server, UA_Session *session,
+                         const UA_UInt32 *maxrefs, const UA_BrowseDescription *descr,
+                         const UA_Node *node, UA_BrowseResult *result) {
+    browseOperation(server, session, maxrefs, descr, true, node, result);
+}
+
 void Service_Browse(UA_Server *server, UA_Session *session,
                     const UA_BrowseRequest *request, UA_BrowseResponse *response) {
     UA_LOG_DEBUG_SESSION(server->config.logging, session, "Processing BrowseRequest");
@@ -975,14 +1375,23 @@ void Service_Browse(UA_Server *server, UA_Session *session,
         return;
     }
 
+#ifdef UA_ENABLE_PUBSUB_INFORMATIONMODEL
+    /* Create lazy PubSub nodes before the nodes are prefetched */
+    for(size_t i = 0; i < request->nodesToBrowseSize; i++)
+        UA_PubSubManager_materialize(server, &request->nodesToBrowse[i].nodeId);
+#endif
+
     response->responseHeader.serviceResult =
-        UA_Server_processServiceOperations(server, session,
-                                           (UA_ServiceOperation)Operation_Browse,
-                                           &request->requestedMaxReferencesPerNode,
-                                           &request->nodesToBrowseSize,
-                                           &UA_TYPES[UA_TYPES_BROWSEDESCRIPTION],
-                                           &response->resultsSize,
-                                           &UA_TYPES[UA_TYPES_BROWSERESULT]);
+        UA_Server_processServiceOperationsWithNodes(server, session,
+                                                    (UA_ServiceOperation)Operation_Browse,
+                                                    (UA_ServiceOperationWithNode)
+                                                    Operation_BrowseWithNode,
+                                                    &request->requestedMaxReferencesPerNode,
+                                                    &request->nodesToBrowseSize,
+                                                    &UA_TYPES[UA_TYPES_BROWSEDESCRIPTION],
+                                                    offsetof(UA_BrowseDescription, nodeId),
+                                                    &response->resultsSize,
+                                                    &UA_TYPES[UA_TYPES_BROWSERESULT]);
 }
 
 UA_BrowseResult
@@ -1029,6 +1438,9 @@ Operation_BrowseNext(UA_Server *server, UA_Session *session,
     bc.status = UA_STATUSCODE_GOOD;
     bc.done = false;
     bc.activeCP = true;
+    bc.arrayOffset = 0;
+    bc.prefetched = false;
+    bc.node = NULL;
     bc.resultRefs = cp->relevantReferences;
     if(cp->browseDescription.resultMask & UA_BROWSERESULTMASK_TYPEDEFINITION) {
         /* Get the node with additional reference types if we need to lookup the
@@ -1118,6 +1530,12 @@ addBrowseHashTarget(void *context, UA_ReferenceTargetTreeElem *elem) {
     return (void*)(uintptr_t)RefTree_add(next, elem->target.targetId, NULL);
 }
 
+static void *
+addCompactBrowseHashTarget(void *context, UA_ReferenceTarget *t) {
+    RefTree *next = (RefTree*)context;
+    return (void*)(uintptr_t)RefTree_add(next, t->targetId, NULL);
+}
+
 static UA_StatusCode
 walkBrowsePathElement(UA_Server *server, UA_Session *session,
                       const UA_RelativePath *path, const size_t pathIndex,
@@ -1158,6 +1576,10 @@ walkBrowsePathElement(UA_Server *server, UA_Session *session,
             continue;
         }
 
+#ifdef UA_ENABLE_PUBSUB_INFORMATIONMODEL
+        UA_PubSubManager_materialize(server, &current->targets[i].nodeId);
+#endif
+
         /* Local Node. Add to the tree of results at the next depth. Get only
          * the NodeClass + BrowseName attribute and the selected ReferenceTypes
          * if the nodestore supports that. */
@@ -1203,7 +1625,14 @@ walkBrowsePathElement(UA_Server *server, UA_Session *session,
              * next iteration of the outer loop. So we only have to retrieve
              * every node just once. */
 
-            if(rk->hasRefTree) {
+            if(rk->isCompact) {
+                res = (UA_StatusCode)(uintptr_t)
+                    UA_NodeReferenceKind_iterateCompactName(rk, browseNameHash,
+                                                            addCompactBrowseHashTarget,
+                                                            next);
+                if(res != UA_STATUSCODE_GOOD)
+                    break;
+            } else if(rk->hasRefTree) {
                 res = (UA_StatusCode)(uintptr_t)
                     ZIP_ITER_KEY(UA_ReferenceNameTree,
                                  (UA_ReferenceNameTree*)&rk->targets.tree.nameRoot,
@@ -1232,12 +1661,9 @@ walkBrowsePathElement(UA_Server *server, UA_Session *session,
 }
 
 static void
-Operation_TranslateBrowsePathToNodeIds(UA_Server *server, UA_Session *session,
-                                       const UA_UInt32 *nodeClassMask,
-                                       const UA_BrowsePath *path,
-                                       UA_BrowsePathResult *result) {
-    UA_LOCK_ASSERT(&server->serviceMutex);
-
+walkBrowsePath(UA_Server *server, UA_Session *session,
+               const UA_UInt32 *nodeClassMask, const UA_BrowsePath *path,
+               UA_BrowsePathResult *result) {
     if(path->relativePath.elementsSize == 0) {
         result->statusCode = UA_STATUSCODE_BADNOTHINGTODO;
         return;
@@ -1360,6 +1786,133 @@ Operation_TranslateBrowsePathToNodeIds(UA_Server *server, UA_Session *session,
     }
 }
 
+/********************/
+/* BrowsePath Cache */
+/********************/
+
+void
+clearBrowsePathCache(UA_Server *server) {
+    UA_BrowsePathCache *bpc = &server->browsePathCache;
+    UA_BrowsePathCacheEntry *e, *e_tmp;
+    TAILQ_FOREACH_SAFE(e, &bpc->lru, lruEntry, e_tmp) {
+        TAILQ_REMOVE(&bpc->lru, e, lruEntry);
+        LIST_REMOVE(e, bucketEntry);
+        UA_BrowsePath_clear(&e->path);
+        UA_BrowsePathResult_clear(&e->result);
+        UA_free(e);
+    }
+    bpc->size = 0;
+}
+
+static UA_UInt32
+hashBrowsePath(const UA_BrowsePath *path, UA_UInt32 nodeClassMask) {
+    UA_UInt32 h = UA_NodeId_hash(&path->startingNode);
+    h = UA_ByteString_hash(h, (const UA_Byte*)&nodeClassMask, sizeof(UA_UInt32));
+    for(size_t i = 0; i < path->relativePath.elementsSize; i++) {
+        const UA_RelativePathElement *elem = &path->relativePath.elements[i];
+        UA_UInt32 refHash = UA_NodeId_hash(&elem->referenceTypeId) ^
+            (UA_UInt32)((elem->isInverse << 1) | elem->includeSubtypes);
+        h = UA_ByteString_hash(h, (const UA_Byte*)&refHash, sizeof(UA_UInt32));
+        h = UA_ByteString_hash(h, (const UA_Byte*)&elem->targetName.namespaceIndex,
+                               sizeof(UA_UInt16));
+        h = UA_ByteString_hash(h, elem->targetName.name.data,
+                               elem->targetName.name.length);
+    }
+    return h;
+}
+
+/* Empty the cache if the references have changed since the entries were
+ * added */
+static void
+checkBrowsePathCacheEpoch(UA_Server *server) {
+    UA_BrowsePathCache *bpc = &server->browsePathCache;
+    if(bpc->epoch == server->hierarchyEpoch)
+        return;
+    clearBrowsePathCache(server);
+    bpc->epoch = server->hierarchyEpoch;
+}
+
+static UA_Boolean
+lookupBrowsePathCache(UA_Server *server, const UA_BrowsePath *path,
+                      UA_UInt32 nodeClassMask, UA_UInt32 hash,
+                      UA_BrowsePathResult *result) {
+    checkBrowsePathCacheEpoch(server);
+    UA_BrowsePathCache *bpc = &server->browsePathCache;
+    UA_BrowsePathCacheEntry *e;
+    LIST_FOREACH(e, &bpc->buckets[hash & (UA_BROWSEPATHCACHE_BUCKETS - 1)],
+                 bucketEntry) {
+        if(e->hash != hash || e->nodeClassMask != nodeClassMask ||
+           !UA_equal(&e->path, path, &UA_TYPES[UA_TYPES_BROWSEPATH]))
+            continue;
+        if(UA_BrowsePathResult_copy(&e->result, result) != UA_STATUSCODE_GOOD)
+            return false;
+        /* Move to the front of the LRU list */
+        TAILQ_REMOVE(&bpc->lru, e, lruEntry);
+        TAILQ_INSERT_HEAD(&bpc->lru, e, lruEntry);
+        return true;
+    }
+    return false;
+}
+
+static void
+addBrowsePathCache(UA_Server *server, const UA_BrowsePath *path,
+                   UA_UInt32 nodeClassMask, UA_UInt32 hash,
+                   const UA_BrowsePathResult *result) {
+    checkBrowsePathCacheEpoch(server);
+    UA_BrowsePathCache *bpc = &server->browsePathCache;
+
+    /* Evict the least recently used entry */
+    UA_BrowsePathCacheEntry *e;
+    if(bpc->size >= UA_BROWSEPATHCACHE_SIZE) {
+        e = TAILQ_LAST(&bpc->lru, UA_BrowsePathCacheLru);
+        TAILQ_REMOVE(&bpc->lru, e, lruEntry);
+        LIST_REMOVE(e, bucketEntry);
+        UA_BrowsePath_clear(&e->path);
+        UA_BrowsePathResult_clear(&e->result);
+        UA_free(e);
+        bpc->size--;
+    }
+
+    e = (UA_BrowsePathCacheEntry*)UA_malloc(sizeof(UA_BrowsePathCacheEntry));
+    if(!e)
+        return;
+    UA_StatusCode res = UA_BrowsePath_copy(path, &e->path);
+    res |= UA_BrowsePathResult_copy(result, &e->result);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_BrowsePath_clear(&e->path);
+        UA_BrowsePathResult_clear(&e->result);
+        UA_free(e);
+        return;
+    }
+    e->hash = hash;
+    e->nodeClassMask = nodeClassMask;
+    TAILQ_INSERT_HEAD(&bpc->lru, e, lruEntry);
+    LIST_INSERT_HEAD(&bpc->buckets[hash & (UA_BROWSEPATHCACHE_BUCKETS - 1)],
+                     e, bucketEntry);
+    bpc->size++;
+}
+
+/* The result does not depend on the session. So it can be cached for all
+ * sessions until the references change. */
+static void
+Operation_TranslateBrowsePathToNodeIds(UA_Server *server, UA_Session *session,
+                                       const UA_UInt32 *nodeClassMask,
+                                       const UA_BrowsePath *path,
+                                       UA_BrowsePathResult *result) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+
+    UA_UInt32 hash = hashBrowsePath(path, *nodeClassMask);
+    if(lookupBrowsePathCache(server, path, *nodeClassMask, hash, result))
+        return;
+
+    walkBrowsePath(server, session, nodeClassMask, path, result);
+
+    /* Don't cache errors that may be transient (e.g. out-of-memory) */
+    if(result->statusCode == UA_STATUSCODE_GOOD ||
+       result->statusCode == UA_STATUSCODE_BADNOMATCH)
+        addBrowsePathCache(server, path, *nodeClassMask, hash, result);
+}
+
 UA_BrowsePathResult
 translateBrowsePathToNodeIds(UA_Server *server,
                              const UA_BrowsePath *browsePath) {
@@ -1461,7 +2014,6 @@ void Service_RegisterNodes(UA_Server *server, UA_Session *session,
                          "Processing RegisterNodesRequest");
     UA_LOCK_ASSERT(&server->serviceMutex);
 
-    //TODO: hang the nodeids to the session if really needed
     if(request->nodesToRegisterSize == 0) {
         response->responseHeader.serviceResult = UA_STATUSCODE_BADNOTHINGTODO;
         return;
@@ -1477,8 +2029,9 @@ void Service_RegisterNodes(UA_Server *server, UA_Session *session,
     response->responseHeader.serviceResult =
         UA_Array_copy(request->nodesToRegister, request->nodesToRegisterSize,
                       (void**)&response->registeredNodeIds, &UA_TYPES[UA_TYPES_NODEID]);
-    if(response->responseHeader.serviceResult == UA_STATUSCODE_GOOD)
-        response->registeredNodeIdsSize = request->nodesToRegisterSize;
+    if(response->responseHeader.serviceResult != UA_STATUSCODE_GOOD)
+        return;
+    response->registeredNodeIdsSize = request->nodesToRegisterSize;
 }
 
 void Service_UnregisterNodes(UA_Server *server, UA_Session *session,
@@ -1488,9 +2041,10 @@ void Service_UnregisterNodes(UA_Server *server, UA_Session *session,
                          "Processing UnRegisterNodesRequest");
     UA_LOCK_ASSERT(&server->serviceMutex);
 
-    //TODO: remove the nodeids from the session if really needed
-    if(request->nodesToUnregisterSize == 0)
+    if(request->nodesToUnregisterSize == 0) {
         response->responseHeader.serviceResult = UA_STATUSCODE_BADNOTHINGTODO;
+        return;
+    }
 
     /* Test the number of operations in the request */
     if(server->config.maxNodesPerRegisterNodes != 0 &&
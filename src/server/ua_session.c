@@ -25,6 +25,14 @@ void UA_Session_init(UA_Session *session) {
 #endif
 }
 
+void UA_Session_clearDecisionCache(UA_Session *session) {
+    for(size_t i = 0; i < session->decisionCacheSize; i++)
+        UA_NodeId_clear(&session->decisionCache[i].nodeId);
+    UA_free(session->decisionCache);
+    session->decisionCache = NULL;
+    session->decisionCacheSize = 0;
+}
+
 void UA_Session_clear(UA_Session *session, UA_Server* server) {
     UA_LOCK_ASSERT(&server->serviceMutex);
 
@@ -59,6 +67,8 @@ void UA_Session_clear(UA_Session *session, UA_Server* server) {
     UA_KeyValueMap_delete(session->attributes);
     session->attributes = NULL;
 
+    UA_Session_clearDecisionCache(session);
+
     UA_Array_delete(session->localeIds, session->localeIdsSize,
                     &UA_TYPES[UA_TYPES_STRING]);
     session->localeIds = NULL;
@@ -67,6 +77,8 @@ void UA_Session_clear(UA_Session *session, UA_Server* server) {
 #ifdef UA_ENABLE_DIAGNOSTICS
     UA_SessionDiagnosticsDataType_clear(&session->diagnostics);
     UA_SessionSecurityDiagnosticsDataType_clear(&session->securityDiagnostics);
+    UA_free(session->serviceCounters);
+    session->serviceCounters = NULL;
 #endif
 }
 
@@ -154,6 +166,7 @@ UA_Session_attachSubscription(UA_Session *session, UA_Subscription *sub) {
 
     /* Increase the number of outstanding retransmissions */
     session->totalRetransmissionQueueSize += sub->retransmissionQueueSize;
+    session->totalRetransmissionQueueBytes += sub->retransmissionQueueBytes;
 
     /* Insert at the end of the subscriptions of the same priority / just before
      * the subscriptions with the next lower priority. */
@@ -180,6 +193,7 @@ UA_Session_detachSubscription(UA_Server *server, UA_Session *session,
 
     /* Reduce the number of outstanding retransmissions */
     session->totalRetransmissionQueueSize -= sub->retransmissionQueueSize;
+    session->totalRetransmissionQueueBytes -= sub->retransmissionQueueBytes;
 
     /* Send remaining publish responses if the last subscription was removed */
     if(!releasePublishResponses || !TAILQ_EMPTY(&session->subscriptions))
@@ -248,14 +262,12 @@ UA_Session_queuePublishReq(UA_Session *session, UA_PublishResponseEntry* entry,
 UA_StatusCode
 UA_Server_closeSession(UA_Server *server, const UA_NodeId *sessionId) {
     UA_LOCK(&server->serviceMutex);
-    session_list_entry *entry;
     UA_StatusCode res = UA_STATUSCODE_BADSESSIONIDINVALID;
-    LIST_FOREACH(entry, &server->sessions, pointers) {
-        if(UA_NodeId_equal(&entry->session.sessionId, sessionId)) {
-            UA_Server_removeSession(server, entry, UA_SHUTDOWNREASON_CLOSE);
-            res = UA_STATUSCODE_GOOD;
-            break;
-        }
+    session_list_entry *entry =
+        ZIP_FIND(UA_SessionIdTree, &server->sessionsById, sessionId);
+    if(entry) {
+        UA_Server_removeSession(server, entry, UA_SHUTDOWNREASON_CLOSE);
+        res = UA_STATUSCODE_GOOD;
     }
     UA_UNLOCK(&server->serviceMutex);
     return res;
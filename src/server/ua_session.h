@@ -36,6 +36,34 @@ typedef struct UA_PublishResponseEntry {
 } UA_PublishResponseEntry;
 #endif
 
+#ifdef UA_ENABLE_DIAGNOSTICS
+/* Counters and processing times for the requests of one service (server-wide)
+ * or of all services (per session). The latency is measured in DateTime ticks
+ * (100ns) and only for requests that are answered right away. */
+typedef struct {
+    UA_UInt64 requestCount;
+    UA_UInt64 errorCount;
+    UA_UInt64 operationCount;
+    UA_UInt64 asyncCount;
+    size_t queueDepthHighWaterMark;
+    UA_LatencyHistogram latency;
+} UA_ServiceStats;
+#endif
+
+/* Cached decisions of the AccessControl plugin for a node */
+#define UA_ACCESSDECISION_RIGHTSMASK  0x01
+#define UA_ACCESSDECISION_ACCESSLEVEL 0x02
+#define UA_ACCESSDECISION_EXECUTABLE  0x04
+
+typedef struct {
+    UA_NodeId nodeId;
+    UA_UInt32 epoch; /* decisionEpoch of the AccessControl plugin */
+    UA_Byte valid;   /* Bitmask of the cached decisions */
+    UA_Byte userAccessLevel;
+    UA_Boolean userExecutable;
+    UA_UInt32 userRightsMask;
+} UA_AccessDecision;
+
 struct UA_Session {
     UA_Session *next; /* singly-linked list */
     UA_SecureChannel *channel; /* The pointer back to the SecureChannel in the session. */
@@ -47,6 +75,7 @@ struct UA_Session {
 
     void *context; /* Pointer assigned by the user in the
                     * accessControl->activateSession context */
+    UA_UInt64 roles; /* Bitmask from accessControl->getSessionRoles */
 
     UA_ByteString serverNonce;
 
@@ -57,6 +86,10 @@ struct UA_Session {
 
     UA_KeyValueMap *attributes;
 
+    /* Hashed by the NodeId. Allocated when first used. */
+    size_t decisionCacheSize;
+    UA_AccessDecision *decisionCache;
+
     /* TODO: Currently unused */
     UA_UInt32 maxRequestMessageSize;
     UA_UInt32 maxResponseMessageSize;
@@ -80,11 +113,20 @@ struct UA_Session {
     SIMPLEQ_HEAD(, UA_PublishResponseEntry) responseQueue;
 
     size_t totalRetransmissionQueueSize; /* Retransmissions of all subscriptions */
+    size_t totalRetransmissionQueueBytes;
 #endif
 
 #ifdef UA_ENABLE_DIAGNOSTICS
     UA_SessionSecurityDiagnosticsDataType securityDiagnostics;
     UA_SessionDiagnosticsDataType diagnostics;
+    UA_ServiceStats serviceStats;
+
+    /* Request counters per service with the same indices as the
+     * serviceDescriptions, followed by the counter for all requests. Updating
+     * the compact array is cheaper than updating the counters at their offsets
+     * in the large diagnostics structure. The counters are copied into the
+     * diagnostics structure only when it is read. */
+    UA_ServiceCounterDataType *serviceCounters;
 #endif
 };
 
@@ -97,6 +139,7 @@ void UA_Session_clear(UA_Session *session, UA_Server *server);
 void UA_Session_attachToSecureChannel(UA_Session *session, UA_SecureChannel *channel);
 void UA_Session_detachFromSecureChannel(UA_Session *session);
 UA_StatusCode UA_Session_generateNonce(UA_Session *session);
+void UA_Session_clearDecisionCache(UA_Session *session);
 
 /* If any activity on a session happens, the timeout is extended */
 void UA_Session_updateLifetime(UA_Session *session, UA_DateTime now,
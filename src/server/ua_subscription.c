@@ -25,8 +25,6 @@
 
 #ifdef UA_ENABLE_SUBSCRIPTIONS /* conditional compilation */
 
-#define UA_MAX_RETRANSMISSIONQUEUESIZE 256
-
 /****************/
 /* Notification */
 /****************/
@@ -34,21 +32,39 @@
 static void UA_Notification_dequeueMon(UA_Notification *n);
 static void UA_Notification_enqueueSub(UA_Notification *n);
 static void UA_Notification_dequeueSub(UA_Notification *n);
+static void removeRetransmissionMessage(UA_Server *server, UA_Subscription *sub,
+                                        UA_NotificationMessageEntry *entry);
 
 UA_Notification *
-UA_Notification_new(void) {
-    UA_Notification *n = (UA_Notification*)UA_calloc(1, sizeof(UA_Notification));
+UA_Notification_new(UA_Server *server) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+
+    /* Take from the pool or allocate */
+    UA_NotificationPool *pool = &server->notificationPool;
+    UA_Notification *n = pool->freeNotifications;
     if(n) {
-        /* Set the sentinel for a notification that is not enqueued a
-         * subscription */
-        TAILQ_NEXT(n, subEntry) = UA_SUBSCRIPTION_QUEUE_SENTINEL;
+        pool->freeNotifications = TAILQ_NEXT(n, subEntry);
+        pool->freeNotificationsSize--;
+        memset(n, 0, sizeof(UA_Notification));
+    } else {
+        n = (UA_Notification*)UA_calloc(1, sizeof(UA_Notification));
+        if(!n)
+            return NULL;
     }
+
+    pool->notificationsInUse++;
+    if(pool->notificationsInUse > pool->notificationsHighWaterMark)
+        pool->notificationsHighWaterMark = pool->notificationsInUse;
+
+    /* Set the sentinel for a notification that is not enqueued a
+     * subscription */
+    TAILQ_NEXT(n, subEntry) = UA_SUBSCRIPTION_QUEUE_SENTINEL;
     return n;
 }
 
 /* Dequeue and delete the notification */
 static void
-UA_Notification_delete(UA_Notification *n) {
+UA_Notification_delete(UA_Server *server, UA_Notification *n) {
     UA_assert(n != UA_SUBSCRIPTION_QUEUE_SENTINEL);
     UA_assert(n->mon);
     UA_Notification_dequeueMon(n);
@@ -63,7 +79,76 @@ UA_Notification_delete(UA_Notification *n) {
         UA_MonitoredItemNotification_clear(&n->data.dataChange);
         break;
     }
-    UA_free(n);
+
+    /* Return to the pool or free */
+    UA_NotificationPool *pool = &server->notificationPool;
+    UA_assert(pool->notificationsInUse > 0);
+    pool->notificationsInUse--;
+    if(pool->freeNotificationsSize >= server->config.notificationPoolSize) {
+        UA_free(n);
+        return;
+    }
+    TAILQ_NEXT(n, subEntry) = pool->freeNotifications;
+    pool->freeNotifications = n;
+    pool->freeNotificationsSize++;
+}
+
+UA_NotificationMessageEntry *
+UA_NotificationMessageEntry_new(UA_Server *server) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+
+    /* Take from the pool or allocate */
+    UA_NotificationPool *pool = &server->notificationPool;
+    UA_NotificationMessageEntry *entry = pool->freeEntries;
+    if(entry) {
+        pool->freeEntries = TAILQ_NEXT(entry, listEntry);
+        pool->freeEntriesSize--;
+    } else {
+        entry = (UA_NotificationMessageEntry*)
+            UA_malloc(sizeof(UA_NotificationMessageEntry));
+        if(!entry)
+            return NULL;
+    }
+
+    UA_ByteString_init(&entry->message);
+    pool->entriesInUse++;
+    if(pool->entriesInUse > pool->entriesHighWaterMark)
+        pool->entriesHighWaterMark = pool->entriesInUse;
+    return entry;
+}
+
+void
+UA_NotificationMessageEntry_delete(UA_Server *server,
+                                   UA_NotificationMessageEntry *entry) {
+    UA_ByteString_clear(&entry->message);
+
+    /* Return to the pool or free */
+    UA_NotificationPool *pool = &server->notificationPool;
+    UA_assert(pool->entriesInUse > 0);
+    pool->entriesInUse--;
+    if(pool->freeEntriesSize >= server->config.notificationPoolSize) {
+        UA_free(entry);
+        return;
+    }
+    TAILQ_NEXT(entry, listEntry) = pool->freeEntries;
+    pool->freeEntries = entry;
+    pool->freeEntriesSize++;
+}
+
+void
+UA_NotificationPool_clear(UA_NotificationPool *pool) {
+    while(pool->freeNotifications) {
+        UA_Notification *n = pool->freeNotifications;
+        pool->freeNotifications = TAILQ_NEXT(n, subEntry);
+        UA_free(n);
+    }
+    while(pool->freeEntries) {
+        UA_NotificationMessageEntry *entry = pool->freeEntries;
+        pool->freeEntries = TAILQ_NEXT(entry, listEntry);
+        UA_free(entry);
+    }
+    pool->freeNotificationsSize = 0;
+    pool->freeEntriesSize = 0;
 }
 
 /* Add to the MonitoredItem queue, update all counters and then handle overflow */
@@ -124,40 +209,20 @@ UA_Notification_enqueueSub(UA_Notification *n) {
     }
 }
 
-void
-UA_Notification_enqueueAndTrigger(UA_Server *server, UA_Notification *n) {
-    UA_MonitoredItem *mon = n->mon;
+/* Put the latest Notification of triggered (sampling) MonitoredItems into the
+ * publishing queue and schedule local publishing for the adminSubscription */
+static void
+UA_Notification_trigger(UA_Server *server, UA_MonitoredItem *mon,
+                        UA_DateTime nowMonotonic) {
     UA_Subscription *sub = mon->subscription;
-    UA_assert(sub); /* A MonitoredItem is always attached to a subscription. Can
-                     * be a local MonitoredItem that gets published immediately
-                     * with a callback. */
-
-    /* If reporting or (sampled+triggered), enqueue into the Subscription first
-     * and then into the MonitoredItem. UA_MonitoredItem_ensureQueueSpace
-     * (called within UA_Notification_enqueueMon) assumes the notification is
-     * already in the Subscription's publishing queue. */
-    UA_EventLoop *el = server->config.eventLoop;
-    UA_DateTime nowMonotonic = el->dateTime_nowMonotonic(el);
-    if(mon->monitoringMode == UA_MONITORINGMODE_REPORTING ||
-       (mon->monitoringMode == UA_MONITORINGMODE_SAMPLING &&
-        mon->triggeredUntil > nowMonotonic)) {
-        UA_Notification_enqueueSub(n);
-        mon->triggeredUntil = UA_INT64_MIN;
-        UA_LOG_DEBUG_SUBSCRIPTION(server->config.logging, mon->subscription,
-                                  "Notification enqueued (Queue size %lu)",
-                                  (long unsigned)mon->subscription->notificationQueueSize);
-    }
-
-    /* Insert into the MonitoredItem. This checks the queue size and
-     * handles overflow. */
-    UA_Notification_enqueueMon(server, n);
-
-    for(size_t i = mon->triggeringLinksSize - 1; i < mon->triggeringLinksSize; i--) {
+    UA_MonitoredItemCold *cold = mon->cold;
+    size_t linksSize = (cold) ? cold->triggeringLinksSize : 0;
+    for(size_t i = linksSize - 1; i < linksSize; i--) {
         /* Get the triggered MonitoredItem. Remove the link if the MI doesn't exist. */
         UA_MonitoredItem *triggeredMon =
-            UA_Subscription_getMonitoredItem(sub, mon->triggeringLinks[i]);
+            UA_Subscription_getMonitoredItem(sub, cold->triggeringLinks[i]);
         if(!triggeredMon) {
-            UA_MonitoredItem_removeLink(sub, mon, mon->triggeringLinks[i]);
+            UA_MonitoredItem_removeLink(sub, mon, cold->triggeringLinks[i]);
             continue;
         }
 
@@ -194,11 +259,111 @@ UA_Notification_enqueueAndTrigger(UA_Server *server, UA_Notification *n) {
         sub->delayedMoreNotifications.application = server;
         sub->delayedMoreNotifications.context = sub;
 
-        el = server->config.eventLoop;
+        UA_EventLoop *el = server->config.eventLoop;
         el->addDelayedCallback(el, &sub->delayedMoreNotifications);
     }
 }
 
+void
+UA_Notification_enqueueAndTrigger(UA_Server *server, UA_Notification *n) {
+    UA_MonitoredItem *mon = n->mon;
+    UA_assert(mon->subscription); /* A MonitoredItem is always attached to a
+                                   * subscription. Can be a local MonitoredItem
+                                   * that gets published immediately with a
+                                   * callback. */
+
+    /* If reporting or (sampled+triggered), enqueue into the Subscription first
+     * and then into the MonitoredItem. UA_MonitoredItem_ensureQueueSpace
+     * (called within UA_Notification_enqueueMon) assumes the notification is
+     * already in the Subscription's publishing queue. */
+    UA_EventLoop *el = server->config.eventLoop;
+    UA_DateTime nowMonotonic = el->dateTime_nowMonotonic(el);
+    if(mon->monitoringMode == UA_MONITORINGMODE_REPORTING ||
+       (mon->monitoringMode == UA_MONITORINGMODE_SAMPLING &&
+        mon->triggeredUntil > nowMonotonic)) {
+        UA_Notification_enqueueSub(n);
+        mon->triggeredUntil = UA_INT64_MIN;
+        UA_LOG_DEBUG_SUBSCRIPTION(server->config.logging, mon->subscription,
+                                  "Notification enqueued (Queue size %lu)",
+                                  (long unsigned)mon->subscription->notificationQueueSize);
+    }
+
+    /* Insert into the MonitoredItem. This checks the queue size and
+     * handles overflow. */
+    UA_Notification_enqueueMon(server, n);
+
+    UA_Notification_trigger(server, mon, nowMonotonic);
+}
+
+static void setOverflowInfoBits(UA_MonitoredItem *mon);
+
+UA_Boolean
+UA_Notification_recycleAndTrigger(UA_Server *server, UA_MonitoredItem *mon,
+                                  UA_DataValue *value) {
+    /* Only for data-change MonitoredItems with a full queue */
+    if(mon->itemToMonitor.attributeId == UA_ATTRIBUTEID_EVENTNOTIFIER ||
+       mon->queueSize == 0 || mon->queueSize != mon->parameters.queueSize)
+        return false;
+    UA_assert(mon->eventOverflows == 0);
+
+    UA_Subscription *sub = mon->subscription;
+    UA_assert(sub);
+
+    UA_EventLoop *el = server->config.eventLoop;
+    UA_DateTime nowMonotonic = el->dateTime_nowMonotonic(el);
+    UA_Boolean report = (mon->monitoringMode == UA_MONITORINGMODE_REPORTING ||
+                         (mon->monitoringMode == UA_MONITORINGMODE_SAMPLING &&
+                          mon->triggeredUntil > nowMonotonic));
+
+    /* Select the Notification that UA_MonitoredItem_ensureQueueSpace would
+     * remove and reuse it for the new sample. The resulting order in both
+     * queues is the same as for the enqueue-and-discard sequence. */
+    UA_Notification *n;
+    UA_Boolean overflow;
+    if(mon->parameters.discardOldest && mon->queueSize > 1) {
+        /* The oldest entry becomes the newest. Move its successor into its
+         * place in the per-Subscription queue. */
+        n = TAILQ_FIRST(&mon->queue);
+        overflow = (TAILQ_NEXT(n, subEntry) != UA_SUBSCRIPTION_QUEUE_SENTINEL);
+        UA_Notification *after = TAILQ_NEXT(n, monEntry);
+        if(overflow && TAILQ_NEXT(after, subEntry) != UA_SUBSCRIPTION_QUEUE_SENTINEL) {
+            TAILQ_REMOVE(&sub->notificationQueue, after, subEntry);
+            TAILQ_INSERT_AFTER(&sub->notificationQueue, n, after, subEntry);
+        }
+        UA_Notification_dequeueSub(n);
+        TAILQ_REMOVE(&mon->queue, n, monEntry);
+        TAILQ_INSERT_TAIL(&mon->queue, n, monEntry);
+        if(report)
+            UA_Notification_enqueueSub(n);
+    } else {
+        /* Overwrite the newest entry. It keeps its position in the
+         * per-Subscription queue. */
+        n = TAILQ_LAST(&mon->queue, NotificationQueue);
+        overflow = (TAILQ_NEXT(n, subEntry) != UA_SUBSCRIPTION_QUEUE_SENTINEL);
+        if(!report)
+            UA_Notification_dequeueSub(n);
+        else if(!overflow)
+            UA_Notification_enqueueSub(n);
+    }
+    if(report)
+        mon->triggeredUntil = UA_INT64_MIN;
+
+    /* Replace the value */
+    UA_DataValue_clear(&n->data.dataChange.value);
+    n->data.dataChange.value = *value;
+    n->data.dataChange.clientHandle = mon->parameters.clientHandle;
+
+    /* Leave an entry to indicate that notifications were removed */
+    if(overflow)
+        setOverflowInfoBits(mon);
+#ifdef UA_ENABLE_DIAGNOSTICS
+    sub->monitoringQueueOverflowCount++;
+#endif
+
+    UA_Notification_trigger(server, mon, nowMonotonic);
+    return true;
+}
+
 /* Remove from the MonitoredItem queue. This only happens if the Notification is
  * deleted right after. */
 static void
@@ -300,6 +465,11 @@ UA_Subscription_delete(UA_Server *server, UA_Subscription *sub) {
 
     UA_LOG_INFO_SUBSCRIPTION(server->config.logging, sub, "Subscription deleted");
 
+    /* Forward the removal to the standby server. A transferred Subscription
+     * lives on in its copy. */
+    if(sub->statusChange != UA_STATUSCODE_GOODSUBSCRIPTIONTRANSFERRED)
+        replicateSubscriptionRemoved(server, sub);
+
     /* Detach from the session if necessary */
     if(sub->session)
         UA_Session_detachSubscription(server, sub->session, sub, true);
@@ -323,12 +493,7 @@ UA_Subscription_delete(UA_Server *server, UA_Subscription *sub) {
     /* Delete Retransmission Queue */
     UA_NotificationMessageEntry *nme, *nme_tmp;
     TAILQ_FOREACH_SAFE(nme, &sub->retransmissionQueue, listEntry, nme_tmp) {
-        TAILQ_REMOVE(&sub->retransmissionQueue, nme, listEntry);
-        UA_NotificationMessage_clear(&nme->message);
-        UA_free(nme);
-        if(sub->session)
-            --sub->session->totalRetransmissionQueueSize;
-        --sub->retransmissionQueueSize;
+        removeRetransmissionMessage(server, sub, nme);
     }
     UA_assert(sub->retransmissionQueueSize == 0);
 
@@ -356,33 +521,43 @@ UA_Subscription_getMonitoredItem(UA_Subscription *sub, UA_UInt32 monitoredItemId
     return mon;
 }
 
+#define UA_RETRANSMISSION_SLOT(seq) ((seq) % UA_MAX_RETRANSMISSIONQUEUESIZE)
+
 static void
-removeOldestRetransmissionMessageFromSub(UA_Subscription *sub) {
-    UA_NotificationMessageEntry *oldestEntry =
-        TAILQ_LAST(&sub->retransmissionQueue, NotificationMessageQueue);
-    TAILQ_REMOVE(&sub->retransmissionQueue, oldestEntry, listEntry);
-    UA_NotificationMessage_clear(&oldestEntry->message);
-    UA_free(oldestEntry);
+removeRetransmissionMessage(UA_Server *server, UA_Subscription *sub,
+                            UA_NotificationMessageEntry *entry) {
+    UA_assert(sub->retransmissionIndex[UA_RETRANSMISSION_SLOT(entry->sequenceNumber)] == entry);
+    sub->retransmissionIndex[UA_RETRANSMISSION_SLOT(entry->sequenceNumber)] = NULL;
+    TAILQ_REMOVE(&sub->retransmissionQueue, entry, listEntry);
+    size_t bytes = entry->message.length;
+    UA_NotificationMessageEntry_delete(server, entry);
     --sub->retransmissionQueueSize;
-    if(sub->session)
+    sub->retransmissionQueueBytes -= bytes;
+    server->retransmissionQueueBytes -= bytes;
+    if(sub->session) {
         --sub->session->totalRetransmissionQueueSize;
+        sub->session->totalRetransmissionQueueBytes -= bytes;
+    }
+}
 
+static void
+removeOldestRetransmissionMessageFromSub(UA_Server *server, UA_Subscription *sub) {
+    removeRetransmissionMessage(server, sub, TAILQ_FIRST(&sub->retransmissionQueue));
 #ifdef UA_ENABLE_DIAGNOSTICS
     sub->discardedMessageCount++;
 #endif
 }
 
 static void
-removeOldestRetransmissionMessageFromSession(UA_Session *session) {
+removeOldestRetransmissionMessageFromSession(UA_Server *server, UA_Session *session) {
     UA_NotificationMessageEntry *oldestEntry = NULL;
     UA_Subscription *oldestSub = NULL;
     UA_Subscription *sub;
     TAILQ_FOREACH(sub, &session->subscriptions, sessionListEntry) {
-        UA_NotificationMessageEntry *first =
-            TAILQ_LAST(&sub->retransmissionQueue, NotificationMessageQueue);
+        UA_NotificationMessageEntry *first = TAILQ_FIRST(&sub->retransmissionQueue);
         if(!first)
             continue;
-        if(!oldestEntry || oldestEntry->message.publishTime > first->message.publishTime) {
+        if(!oldestEntry || oldestEntry->publishTime > first->publishTime) {
             oldestEntry = first;
             oldestSub = sub;
         }
@@ -390,53 +565,114 @@ removeOldestRetransmissionMessageFromSession(UA_Session *session) {
     UA_assert(oldestEntry);
     UA_assert(oldestSub);
 
-    removeOldestRetransmissionMessageFromSub(oldestSub);
+    removeOldestRetransmissionMessageFromSub(server, oldestSub);
 }
 
+/* Also considers the Subscriptions that are detached from their Session */
 static void
+removeOldestRetransmissionMessageFromServer(UA_Server *server) {
+    UA_NotificationMessageEntry *oldestEntry = NULL;
+    UA_Subscription *oldestSub = NULL;
+    UA_Subscription *sub;
+    LIST_FOREACH(sub, &server->subscriptions, serverListEntry) {
+        UA_NotificationMessageEntry *first = TAILQ_FIRST(&sub->retransmissionQueue);
+        if(!first)
+            continue;
+        if(!oldestEntry || oldestEntry->publishTime > first->publishTime) {
+            oldestEntry = first;
+            oldestSub = sub;
+        }
+    }
+    UA_assert(oldestEntry);
+    UA_assert(oldestSub);
+
+    removeOldestRetransmissionMessageFromSub(server, oldestSub);
+}
+
+void
 UA_Subscription_addRetransmissionMessage(UA_Server *server, UA_Subscription *sub,
                                          UA_NotificationMessageEntry *entry) {
+    /* The index slot is still taken by a message that is older by (a multiple
+     * of) UA_MAX_RETRANSMISSIONQUEUESIZE sequence numbers. Release it. */
+    size_t slot = UA_RETRANSMISSION_SLOT(entry->sequenceNumber);
+    if(sub->retransmissionIndex[slot]) {
+        UA_LOG_WARNING_SUBSCRIPTION(server->config.logging, sub,
+                                    "Subscription retransmission queue overflow");
+        removeRetransmissionMessage(server, sub, sub->retransmissionIndex[slot]);
+#ifdef UA_ENABLE_DIAGNOSTICS
+        sub->discardedMessageCount++;
+#endif
+    }
+
     /* Release the oldest entry if there is not enough space */
     UA_Session *session = sub->session;
     if(sub->retransmissionQueueSize >= UA_MAX_RETRANSMISSIONQUEUESIZE) {
         UA_LOG_WARNING_SUBSCRIPTION(server->config.logging, sub,
                                     "Subscription retransmission queue overflow");
-        removeOldestRetransmissionMessageFromSub(sub);
+        removeOldestRetransmissionMessageFromSub(server, sub);
     } else if(session && server->config.maxRetransmissionQueueSize > 0 &&
               session->totalRetransmissionQueueSize >=
               server->config.maxRetransmissionQueueSize) {
         UA_LOG_WARNING_SUBSCRIPTION(server->config.logging, sub,
                                     "Session-wide retransmission queue overflow");
-        removeOldestRetransmissionMessageFromSession(sub->session);
+        removeOldestRetransmissionMessageFromSession(server, sub->session);
+    }
+
+    /* Release the oldest entries until the message fits into the byte
+     * budgets. The new message is kept even if it exceeds a budget alone. */
+    size_t bytes = entry->message.length;
+    UA_UInt32 maxSessionBytes = server->config.maxRetransmissionQueueBytes;
+    if(session && maxSessionBytes > 0 &&
+       session->totalRetransmissionQueueBytes + bytes > maxSessionBytes) {
+        UA_LOG_WARNING_SUBSCRIPTION(server->config.logging, sub,
+                                    "Session-wide retransmission queue exceeds "
+                                    "the byte budget");
+        while(session->totalRetransmissionQueueSize > 0 &&
+              session->totalRetransmissionQueueBytes + bytes > maxSessionBytes)
+            removeOldestRetransmissionMessageFromSession(server, session);
+    }
+    UA_UInt32 maxServerBytes = server->config.maxRetransmissionBytes;
+    if(maxServerBytes > 0 && server->retransmissionQueueBytes + bytes > maxServerBytes) {
+        UA_LOG_WARNING_SUBSCRIPTION(server->config.logging, sub,
+                                    "Server-wide retransmission queues exceed "
+                                    "the byte budget");
+        while(server->retransmissionQueueBytes > 0 &&
+              server->retransmissionQueueBytes + bytes > maxServerBytes)
+            removeOldestRetransmissionMessageFromServer(server);
     }
 
     /* Add entry */
     TAILQ_INSERT_TAIL(&sub->retransmissionQueue, entry, listEntry);
+    sub->retransmissionIndex[slot] = entry;
     ++sub->retransmissionQueueSize;
-    if(session)
+    sub->retransmissionQueueBytes += bytes;
+    server->retransmissionQueueBytes += bytes;
+    if(session) {
         ++session->totalRetransmissionQueueSize;
+        session->totalRetransmissionQueueBytes += bytes;
+    }
+}
+
+UA_NotificationMessageEntry *
+UA_Subscription_getRetransmissionMessage(UA_Subscription *sub,
+                                         UA_UInt32 sequenceNumber) {
+    UA_NotificationMessageEntry *entry =
+        sub->retransmissionIndex[UA_RETRANSMISSION_SLOT(sequenceNumber)];
+    if(!entry || entry->sequenceNumber != sequenceNumber)
+        return NULL;
+    return entry;
 }
 
 UA_StatusCode
-UA_Subscription_removeRetransmissionMessage(UA_Subscription *sub, UA_UInt32 sequenceNumber) {
-    /* Find the retransmission message */
-    UA_NotificationMessageEntry *entry;
-    TAILQ_FOREACH(entry, &sub->retransmissionQueue, listEntry) {
-        if(entry->message.sequenceNumber == sequenceNumber)
-            break;
-    }
+UA_Subscription_removeRetransmissionMessage(UA_Server *server, UA_Subscription *sub,
+                                            UA_UInt32 sequenceNumber) {
+    UA_NotificationMessageEntry *entry =
+        UA_Subscription_getRetransmissionMessage(sub, sequenceNumber);
     if(!entry)
         return UA_STATUSCODE_BADSEQUENCENUMBERUNKNOWN;
 
     /* Remove the retransmission message */
-    TAILQ_REMOVE(&sub->retransmissionQueue, entry, listEntry);
-    --sub->retransmissionQueueSize;
-    UA_NotificationMessage_clear(&entry->message);
-    UA_free(entry);
-
-    if(sub->session)
-        --sub->session->totalRetransmissionQueueSize;
-
+    removeRetransmissionMessage(server, sub, entry);
     return UA_STATUSCODE_GOOD;
 }
 
@@ -545,14 +781,14 @@ prepareNotificationMessage(UA_Server *server, UA_Subscription *sub,
          * current Notification has been sent out. */
         UA_Notification *prev;
         while((prev = TAILQ_PREV(n, NotificationQueue, monEntry))) {
-            UA_Notification_delete(prev);
+            UA_Notification_delete(server, prev);
 
             /* Help the Clang scan-analyzer */
             UA_assert(prev != TAILQ_PREV(n, NotificationQueue, monEntry));
         }
 
         /* Delete the notification, remove from the queues and decrease the counters */
-        UA_Notification_delete(n);
+        UA_Notification_delete(server, n);
 
         totalNotifications++;
     }
@@ -696,14 +932,14 @@ UA_Subscription_localPublish(UA_Server *server, UA_Subscription *sub) {
          * current Notification has been sent out. */
         UA_Notification *prev;
         while((prev = TAILQ_PREV(n, NotificationQueue, monEntry))) {
-            UA_Notification_delete(prev);
+            UA_Notification_delete(server, prev);
 
             /* Help the Clang scan-analyzer */
             UA_assert(prev != TAILQ_PREV(n, NotificationQueue, monEntry));
         }
 
         /* Delete the notification, remove from the queues and decrease the counters */
-        UA_Notification_delete(n);
+        UA_Notification_delete(server, n);
     }
 
     UA_UNLOCK(&server->serviceMutex);
@@ -717,6 +953,71 @@ delayedPublishNotifications(UA_Server *server, UA_Subscription *sub) {
     UA_UNLOCK(&server->serviceMutex);
 }
 
+static UA_StatusCode
+encodeArrayToMessage(UA_MessageContext *mc, const void *array, size_t arraySize,
+                     const UA_DataType *type) {
+    UA_Int32 length = -1;
+    if(arraySize > UA_INT32_MAX)
+        return UA_STATUSCODE_BADENCODINGERROR;
+    if(arraySize > 0)
+        length = (UA_Int32)arraySize;
+    else if(array == UA_EMPTY_ARRAY_SENTINEL)
+        length = 0;
+    UA_StatusCode res = UA_MessageContext_encode(mc, &length, &UA_TYPES[UA_TYPES_INT32]);
+    uintptr_t ptr = (uintptr_t)array;
+    for(size_t i = 0; i < arraySize && res == UA_STATUSCODE_GOOD; i++) {
+        res = UA_MessageContext_encode(mc, (const void*)ptr, type);
+        ptr += type->memSize;
+    }
+    return res;
+}
+
+/* Send a PublishResponse where the NotificationMessage is taken from the
+ * encoded retransmission entry. The members are encoded in the order of the
+ * PublishResponse structure. */
+static UA_StatusCode
+sendPublishResponse(UA_Server *server, UA_SecureChannel *channel, UA_UInt32 requestId,
+                    UA_PublishResponse *response, const UA_ByteString *encodedMessage) {
+    if(!channel)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    UA_EventLoop *el = server->config.eventLoop;
+    response->responseHeader.timestamp = el->dateTime_now(el);
+
+    UA_MessageContext mc;
+    UA_StatusCode res = UA_MessageContext_begin(&mc, channel, requestId, UA_MESSAGETYPE_MSG);
+    UA_CHECK_STATUS(res, return res);
+
+    /* Each call cleans up the MessageContext internally in case of an error */
+    const UA_DataType *responseType = &UA_TYPES[UA_TYPES_PUBLISHRESPONSE];
+    res = UA_MessageContext_encode(&mc, &responseType->binaryEncodingId,
+                                   &UA_TYPES[UA_TYPES_NODEID]);
+    UA_CHECK_STATUS(res, return res);
+    res = UA_MessageContext_encode(&mc, &response->responseHeader,
+                                   &UA_TYPES[UA_TYPES_RESPONSEHEADER]);
+    UA_CHECK_STATUS(res, return res);
+    res = UA_MessageContext_encode(&mc, &response->subscriptionId,
+                                   &UA_TYPES[UA_TYPES_UINT32]);
+    UA_CHECK_STATUS(res, return res);
+    res = encodeArrayToMessage(&mc, response->availableSequenceNumbers,
+                               response->availableSequenceNumbersSize,
+                               &UA_TYPES[UA_TYPES_UINT32]);
+    UA_CHECK_STATUS(res, return res);
+    res = UA_MessageContext_encode(&mc, &response->moreNotifications,
+                                   &UA_TYPES[UA_TYPES_BOOLEAN]);
+    UA_CHECK_STATUS(res, return res);
+    res = UA_MessageContext_encodeRaw(&mc, encodedMessage);
+    UA_CHECK_STATUS(res, return res);
+    res = encodeArrayToMessage(&mc, response->results, response->resultsSize,
+                               &UA_TYPES[UA_TYPES_STATUSCODE]);
+    UA_CHECK_STATUS(res, return res);
+    res = encodeArrayToMessage(&mc, response->diagnosticInfos,
+                               response->diagnosticInfosSize,
+                               &UA_TYPES[UA_TYPES_DIAGNOSTICINFO]);
+    UA_CHECK_STATUS(res, return res);
+    return UA_MessageContext_finish(&mc);
+}
+
 /* Try to publish now. Enqueue a "next publish" as a delayed callback if not
  * done. */
 void
@@ -802,6 +1103,18 @@ UA_Subscription_publish(UA_Server *server, UA_Subscription *sub) {
         return;
     }
 
+    /* The client does not keep up with receiving. Pause publishing until the
+     * send queue of the SecureChannel is drained. The notifications remain
+     * queued in the meantime. */
+    if(UA_SecureChannel_isSendCongested(sub->session->channel)) {
+        UA_LOG_DEBUG_SUBSCRIPTION(server->config.logging, sub,
+                                  "The SecureChannel is congested. "
+                                  "The subscription is late.");
+        sub->late = true;
+        UA_Session_queuePublishReq(sub->session, pre, true); /* Re-enqueue */
+        return;
+    }
+
     UA_assert(pre);
     UA_assert(sub->session); /* Otherwise pre is NULL */
 
@@ -816,8 +1129,7 @@ UA_Subscription_publish(UA_Server *server, UA_Subscription *sub) {
     if(notifications > 0) {
         if(server->config.enableRetransmissionQueue) {
             /* Allocate the retransmission entry */
-            retransmission = (UA_NotificationMessageEntry*)
-                UA_malloc(sizeof(UA_NotificationMessageEntry));
+            retransmission = UA_NotificationMessageEntry_new(server);
             if(!retransmission) {
                 UA_LOG_WARNING_SUBSCRIPTION(server->config.logging, sub,
                                             "Could not allocate memory for retransmission. "
@@ -837,7 +1149,7 @@ UA_Subscription_publish(UA_Server *server, UA_Subscription *sub) {
                                         "The subscription is late.");
             /* If the retransmission queue is enabled a retransmission message is allocated */
             if(retransmission)
-                UA_free(retransmission);
+                UA_NotificationMessageEntry_delete(server, retransmission);
             sub->late = true;
             UA_Session_queuePublishReq(sub->session, pre, true); /* Re-enqueue */
             return;
@@ -860,16 +1172,35 @@ UA_Subscription_publish(UA_Server *server, UA_Subscription *sub) {
         /* If the retransmission queue is enabled a retransmission message is
          * allocated */
         if(retransmission) {
-            /* Put the notification message into the retransmission queue. This
-             * needs to be done here, so that the message itself is included in
-             * the available sequence numbers for acknowledgement. */
-            retransmission->message = response->notificationMessage;
-            UA_Subscription_addRetransmissionMessage(server, sub, retransmission);
+            /* Encode the notification message for the retransmission queue.
+             * The decoded message is no longer needed after that. If the
+             * encoding fails, the message is sent without retransmission. */
+            UA_StatusCode retval =
+                UA_encodeBinary(message, &UA_TYPES[UA_TYPES_NOTIFICATIONMESSAGE],
+                                &retransmission->message);
+            if(retval == UA_STATUSCODE_GOOD) {
+                retransmission->sequenceNumber = message->sequenceNumber;
+                retransmission->publishTime = message->publishTime;
+                UA_NotificationMessage_clear(message);
+            } else {
+                UA_LOG_WARNING_SUBSCRIPTION(server->config.logging, sub,
+                                            "Could not encode the notification "
+                                            "message for retransmission");
+                UA_NotificationMessageEntry_delete(server, retransmission);
+                retransmission = NULL;
+            }
         }
+
+        /* Put the notification message into the retransmission queue. This
+         * needs to be done here, so that the message itself is included in the
+         * available sequence numbers for acknowledgement. */
+        if(retransmission)
+            UA_Subscription_addRetransmissionMessage(server, sub, retransmission);
         /* Only if a notification was created, the sequence number must be
          * increased. For a keepalive the sequence number can be reused. */
         sub->nextSequenceNumber =
             UA_Subscription_nextSequenceNumber(sub->nextSequenceNumber);
+        replicateSequenceNumber(server, sub);
     }
 
     /* Get the available sequence numbers from the retransmission queue */
@@ -880,7 +1211,7 @@ UA_Subscription_publish(UA_Server *server, UA_Subscription *sub) {
     size_t i = 0;
     UA_NotificationMessageEntry *nme;
     TAILQ_FOREACH(nme, &sub->retransmissionQueue, listEntry) {
-        response->availableSequenceNumbers[i] = nme->message.sequenceNumber;
+        response->availableSequenceNumbers[i] = nme->sequenceNumber;
         ++i;
     }
     UA_assert(i == sub->retransmissionQueueSize);
@@ -889,8 +1220,12 @@ UA_Subscription_publish(UA_Server *server, UA_Subscription *sub) {
     UA_LOG_DEBUG_SUBSCRIPTION(server->config.logging, sub,
                               "Sending out a publish response with %" PRIu32
                               " notifications", notifications);
-    sendResponse(server, sub->session->channel, pre->requestId,
-                 (UA_Response*)response, &UA_TYPES[UA_TYPES_PUBLISHRESPONSE]);
+    if(retransmission)
+        sendPublishResponse(server, sub->session->channel, pre->requestId,
+                            response, &retransmission->message);
+    else
+        sendResponse(server, sub->session->channel, pre->requestId,
+                     (UA_Response*)response, &UA_TYPES[UA_TYPES_PUBLISHRESPONSE]);
 
     /* Reset the Subscription state to NORMAL. But only if all notifications
      * have been sent out. Otherwise keep the Subscription in the LATE state. So
@@ -906,10 +1241,6 @@ UA_Subscription_publish(UA_Server *server, UA_Subscription *sub) {
     sub->currentKeepAliveCount = 0;
 
     /* Free the response */
-    if(retransmission) {
-        /* NotificationMessage was moved into retransmission queue */
-        UA_NotificationMessage_init(&response->notificationMessage);
-    }
     response->availableSequenceNumbers = NULL;
     response->availableSequenceNumbersSize = 0;
     UA_PublishResponse_clear(&pre->response);
@@ -970,7 +1301,17 @@ UA_Subscription_resendData(UA_Server *server, UA_Subscription *sub) {
             continue;
 
         /* Create a notification with the last sampled value */
-        UA_MonitoredItem_createDataChangeNotification(server, mon, &mon->lastValue);
+        if(!mon->lastValueHashed) {
+            UA_MonitoredItem_createDataChangeNotification(server, mon, &mon->lastValue);
+            continue;
+        }
+
+        /* Only the hash of the last value was kept. Send the current value. */
+        UA_Session *session = (sub->session) ? sub->session : &server->adminSession;
+        UA_DataValue dv = readWithSession(server, session, &mon->itemToMonitor,
+                                          mon->timestampsToReturn);
+        UA_MonitoredItem_createDataChangeNotification(server, mon, &dv);
+        UA_DataValue_clear(&dv);
     }
 }
 
@@ -1000,41 +1341,135 @@ UA_Session_ensurePublishQueueSpace(UA_Server* server, UA_Session* session) {
 }
 
 static void
-sampleAndPublishCallback(UA_Server *server, UA_Subscription *sub) {
-    UA_LOCK(&server->serviceMutex);
-    UA_assert(sub);
-
+sampleAndPublish(UA_Server *server, UA_Subscription *sub) {
     UA_LOG_DEBUG_SUBSCRIPTION(server->config.logging, sub,
                               "Sample and Publish Callback");
 
     /* Sample the MonitoredItems with sampling interval <0 (which implies
      * sampling in the same interval as the subscription) */
-    UA_MonitoredItem *mon;
-    LIST_FOREACH(mon, &sub->samplingMonitoredItems, sampling.subscriptionSampling) {
-        UA_MonitoredItem_sample(server, mon);
+    UA_MonitoredItem *mon, *mon_tmp;
+    UA_MonitoredItem *batch[UA_SAMPLING_BATCHSIZE];
+    size_t batchSize = 0;
+    LIST_FOREACH_SAFE(mon, &sub->samplingMonitoredItems,
+                      sampling.subscriptionSampling, mon_tmp) {
+        batch[batchSize++] = mon;
+        if(batchSize == UA_SAMPLING_BATCHSIZE) {
+            UA_MonitoredItem_sampleBatch(server, batch, batchSize);
+            batchSize = 0;
+        }
     }
+    if(batchSize > 0)
+        UA_MonitoredItem_sampleBatch(server, batch, batchSize);
 
     /* Publish the queued notifications */
     UA_Subscription_publish(server, sub);
+}
 
+/* Sample and publish all Subscriptions of the group with a single acquisition
+ * of the service mutex. Subscriptions without a queued PublishRequest only
+ * update their keepalive and lifetime counters in UA_Subscription_publish.
+ * Subscriptions and PublishGroups are freed in a delayed callback. So they can
+ * be removed during the publishing. */
+static void
+UA_PublishGroup_publish(UA_Server *server, UA_PublishGroup *pg) {
+    UA_LOCK(&server->serviceMutex);
+    UA_MemoryCategory mc = UA_MemoryCategory_enter(UA_MEMORYCATEGORY_SUBSCRIPTIONS);
+    UA_Subscription *sub, *sub_tmp;
+    LIST_FOREACH_SAFE(sub, &pg->subscriptions, publishGroupEntry, sub_tmp) {
+        sampleAndPublish(server, sub);
+    }
+    UA_MemoryCategory_leave(mc);
     UA_UNLOCK(&server->serviceMutex);
 }
 
+static void
+delayedFreePublishGroup(void *application, void *context) {
+    UA_free(context);
+}
+
+static UA_StatusCode
+addToPublishGroup(UA_Server *server, UA_Subscription *sub) {
+    /* Find the group with the same publishing interval */
+    UA_PublishGroup *pg;
+    LIST_FOREACH(pg, &server->publishGroups, listEntry) {
+        if(pg->publishingInterval == sub->publishingInterval)
+            break;
+    }
+
+    /* Create a new group with its own repeated callback */
+    if(!pg) {
+        pg = (UA_PublishGroup*)UA_calloc(1, sizeof(UA_PublishGroup));
+        if(!pg)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        pg->publishingInterval = sub->publishingInterval;
+        UA_StatusCode res =
+            addRepeatedCallback(server, (UA_ServerCallback)UA_PublishGroup_publish,
+                                pg, pg->publishingInterval, &pg->callbackId);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_free(pg);
+            return res;
+        }
+        LIST_INSERT_HEAD(&server->publishGroups, pg, listEntry);
+    }
+
+    /* Insert ordered by descending priority. Behind the Subscriptions with the
+     * same priority. */
+    UA_Subscription *prev = NULL, *next;
+    LIST_FOREACH(next, &pg->subscriptions, publishGroupEntry) {
+        if(next->priority < sub->priority)
+            break;
+        prev = next;
+    }
+    if(prev)
+        LIST_INSERT_AFTER(prev, sub, publishGroupEntry);
+    else
+        LIST_INSERT_HEAD(&pg->subscriptions, sub, publishGroupEntry);
+    sub->publishGroup = pg;
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+removeFromPublishGroup(UA_Server *server, UA_Subscription *sub) {
+    UA_PublishGroup *pg = sub->publishGroup;
+    LIST_REMOVE(sub, publishGroupEntry);
+    sub->publishGroup = NULL;
+    if(!LIST_EMPTY(&pg->subscriptions))
+        return;
+
+    /* Remove the empty group. Free in a delayed callback, as the group might
+     * be currently publishing. */
+    removeCallback(server, pg->callbackId);
+    LIST_REMOVE(pg, listEntry);
+    pg->delayedFreePointers.callback = delayedFreePublishGroup;
+    pg->delayedFreePointers.application = NULL;
+    pg->delayedFreePointers.context = pg;
+    UA_EventLoop *el = server->config.eventLoop;
+    el->addDelayedCallback(el, &pg->delayedFreePointers);
+}
+
+UA_StatusCode
+Subscription_updatePublishGroup(UA_Server *server, UA_Subscription *sub) {
+    if(!sub->publishGroup)
+        return UA_STATUSCODE_GOOD;
+    removeFromPublishGroup(server, sub);
+    UA_StatusCode res = addToPublishGroup(server, sub);
+    if(res != UA_STATUSCODE_GOOD)
+        sub->state = UA_SUBSCRIPTIONSTATE_STOPPED;
+    return res;
+}
+
 UA_StatusCode
 Subscription_setState(UA_Server *server, UA_Subscription *sub,
                       UA_SubscriptionState state) {
     if(state <= UA_SUBSCRIPTIONSTATE_REMOVING) {
-        if(sub->publishCallbackId != 0) {
-            removeCallback(server, sub->publishCallbackId);
-            sub->publishCallbackId = 0;
+        if(sub->publishGroup) {
+            removeFromPublishGroup(server, sub);
 #ifdef UA_ENABLE_DIAGNOSTICS
             sub->disableCount++;
 #endif
         }
-    } else if(sub->publishCallbackId == 0) {
-        UA_StatusCode res =
-            addRepeatedCallback(server, (UA_ServerCallback)sampleAndPublishCallback,
-                                sub, sub->publishingInterval, &sub->publishCallbackId);
+    } else if(!sub->publishGroup) {
+        UA_StatusCode res = addToPublishGroup(server, sub);
         if(res != UA_STATUSCODE_GOOD) {
             sub->state = UA_SUBSCRIPTIONSTATE_STOPPED;
             return res;
@@ -1104,7 +1539,7 @@ createEventOverflowNotification(UA_Server *server, UA_Subscription *sub,
     efl.eventFieldsSize = 1;
 
     /* Allocate the notification */
-    UA_Notification *overflowNotification = UA_Notification_new();
+    UA_Notification *overflowNotification = UA_Notification_new(server);
     if(!overflowNotification) {
         UA_Variant_delete(efl.eventFields);
         return UA_STATUSCODE_BADOUTOFMEMORY;
@@ -1220,6 +1655,13 @@ UA_MonitoredItem_init(UA_MonitoredItem *mon) {
     mon->triggeredUntil = UA_INT64_MIN;
 }
 
+UA_MonitoredItemCold *
+UA_MonitoredItem_getCold(UA_MonitoredItem *mon) {
+    if(!mon->cold)
+        mon->cold = (UA_MonitoredItemCold*)UA_calloc(1, sizeof(UA_MonitoredItemCold));
+    return mon->cold;
+}
+
 static UA_StatusCode
 addMonitoredItemBackpointer(UA_Server *server, UA_Session *session,
                             UA_Node *node, void *data) {
@@ -1227,6 +1669,10 @@ addMonitoredItemBackpointer(UA_Server *server, UA_Session *session,
     UA_assert(mon != (UA_MonitoredItem*)~0);
     mon->sampling.nodeListNext = node->head.monitoredItems;
     node->head.monitoredItems = mon;
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    if(mon->itemToMonitor.attributeId == UA_ATTRIBUTEID_EVENTNOTIFIER)
+        server->eventMonitoredItemsEpoch++;
+#endif
     return UA_STATUSCODE_GOOD;
 }
 
@@ -1238,6 +1684,10 @@ removeMonitoredItemBackPointer(UA_Server *server, UA_Session *session,
 
     /* Edge case that it's the first element */
     UA_MonitoredItem *remove = (UA_MonitoredItem*)data;
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    if(remove->itemToMonitor.attributeId == UA_ATTRIBUTEID_EVENTNOTIFIER)
+        server->eventMonitoredItemsEpoch++;
+#endif
     if(node->head.monitoredItems == remove) {
         node->head.monitoredItems = remove->sampling.nodeListNext;
         return UA_STATUSCODE_GOOD;
@@ -1340,9 +1790,10 @@ UA_MonitoredItem_setMonitoringMode(UA_Server *server, UA_MonitoredItem *mon,
         UA_Notification *notification_tmp;
         UA_MonitoredItem_unregisterSampling(server, mon);
         TAILQ_FOREACH_SAFE(notification, &mon->queue, monEntry, notification_tmp) {
-            UA_Notification_delete(notification);
+            UA_Notification_delete(server, notification);
         }
         UA_DataValue_clear(&mon->lastValue);
+        mon->lastValueHashed = false;
         return UA_STATUSCODE_GOOD;
     }
 
@@ -1378,8 +1829,12 @@ UA_MonitoredItem_setMonitoringMode(UA_Server *server, UA_MonitoredItem *mon,
      * Event-MonitoredItem */
     if(oldMode == UA_MONITORINGMODE_DISABLED &&
        mon->monitoringMode > UA_MONITORINGMODE_DISABLED &&
-       mon->itemToMonitor.attributeId != UA_ATTRIBUTEID_EVENTNOTIFIER)
-        UA_MonitoredItem_sample(server, mon);
+       mon->itemToMonitor.attributeId != UA_ATTRIBUTEID_EVENTNOTIFIER) {
+        if(mon->deferInitialSample)
+            UA_MonitoredItem_deferInitialSample(server, mon);
+        else
+            UA_MonitoredItem_sample(server, mon);
+    }
 
     return UA_STATUSCODE_GOOD;
 }
@@ -1400,17 +1855,20 @@ UA_MonitoredItem_delete(UA_Server *server, UA_MonitoredItem *mon) {
     if(mon->registered)
         UA_Server_unregisterMonitoredItem(server, mon);
 
-    /* Remove the TriggeringLinks */
-    if(mon->triggeringLinksSize > 0) {
-        UA_free(mon->triggeringLinks);
-        mon->triggeringLinks = NULL;
-        mon->triggeringLinksSize = 0;
+    /* Remove the TriggeringLinks and the cached event filter */
+    if(mon->cold) {
+        UA_free(mon->cold->triggeringLinks);
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+        UA_EventFilterCache_clear(&mon->cold->eventFilterCache);
+#endif
+        UA_free(mon->cold);
+        mon->cold = NULL;
     }
 
     /* Remove the queued notifications attached to the subscription */
     UA_Notification *notification, *notification_tmp;
     TAILQ_FOREACH_SAFE(notification, &mon->queue, monEntry, notification_tmp) {
-        UA_Notification_delete(notification);
+        UA_Notification_delete(server, notification);
     }
 
     /* Remove the settings */
@@ -1522,7 +1980,7 @@ UA_MonitoredItem_ensureQueueSpace(UA_Server *server, UA_MonitoredItem *mon) {
         remove--;
 
         /* Delete the notification and remove it from the queues */
-        UA_Notification_delete(del);
+        UA_Notification_delete(server, del);
 
         /* Update the subscription diagnostics statistics */
 #ifdef UA_ENABLE_DIAGNOSTICS
@@ -1550,13 +2008,248 @@ UA_MonitoredItem_ensureQueueSpace(UA_Server *server, UA_MonitoredItem *mon) {
     }
 }
 
+#if UA_MULTITHREADING >= 200 && defined(UA_ARCHITECTURE_POSIX)
+/* Read the values of all MonitoredItems in parallel worker threads. Then
+ * process the samples in batches by the current thread. Returns false if the
+ * memory could not be allocated and the group has to be sampled serially. */
+static UA_Boolean
+UA_SamplingGroup_sampleParallel(UA_Server *server, UA_SamplingGroup *sg) {
+    size_t size = sg->monitoredItemsSize;
+    UA_MonitoredItem **mons = (UA_MonitoredItem**)
+        UA_malloc(size * sizeof(UA_MonitoredItem*));
+    UA_ReadOperation *ops = (UA_ReadOperation*)
+        UA_malloc(size * sizeof(UA_ReadOperation));
+    UA_DataValue *dvs = (UA_DataValue*)
+        UA_Array_new(size, &UA_TYPES[UA_TYPES_DATAVALUE]);
+    if(!mons || !ops || !dvs) {
+        UA_free(mons);
+        UA_free(ops);
+        UA_free(dvs);
+        return false;
+    }
+
+    size_t i = 0;
+    UA_MonitoredItem *mon;
+    LIST_FOREACH(mon, &sg->monitoredItems, sampling.cyclic.groupEntry) {
+        UA_assert(i < size);
+        UA_Subscription *sub = mon->subscription;
+        mons[i] = mon;
+        ops[i].session = (sub) ? sub->session : &server->adminSession;
+        ops[i].rvi = &mon->itemToMonitor;
+        ops[i].timestampsToReturn = mon->timestampsToReturn;
+        i++;
+    }
+
+    if(readParallel(server, size, ops, dvs) != UA_STATUSCODE_GOOD) {
+        UA_free(mons);
+        UA_free(ops);
+        UA_Array_delete(dvs, size, &UA_TYPES[UA_TYPES_DATAVALUE]);
+        return false;
+    }
+
+    /* The values are moved out of the dvs array */
+    for(i = 0; i < size; i += UA_SAMPLING_BATCHSIZE) {
+        size_t n = size - i;
+        if(n > UA_SAMPLING_BATCHSIZE)
+            n = UA_SAMPLING_BATCHSIZE;
+        UA_MonitoredItem_processSampleBatch(server, &mons[i], &dvs[i], n);
+    }
+    UA_free(mons);
+    UA_free(ops);
+    UA_free(dvs);
+    return true;
+}
+#endif
+
+/* Sample all MonitoredItems of the group with a single acquisition of the
+ * service mutex. MonitoredItems and SamplingGroups are freed in a delayed
+ * callback. So they can be removed during the sampling. */
+static void
+UA_SamplingGroup_sample(UA_Server *server, UA_SamplingGroup *sg) {
+    UA_LOCK(&server->serviceMutex);
+    UA_MemoryCategory mc = UA_MemoryCategory_enter(UA_MEMORYCATEGORY_MONITOREDITEMS);
+#if UA_MULTITHREADING >= 200 && defined(UA_ARCHITECTURE_POSIX)
+    UA_UInt32 threshold = server->config.parallelSamplingThreshold;
+    if(threshold > 0 && sg->monitoredItemsSize >= threshold &&
+       UA_SamplingGroup_sampleParallel(server, sg)) {
+        UA_MemoryCategory_leave(mc);
+        UA_UNLOCK(&server->serviceMutex);
+        return;
+    }
+#endif
+    UA_MonitoredItem *mon, *mon_tmp;
+    UA_MonitoredItem *batch[UA_SAMPLING_BATCHSIZE];
+    size_t batchSize = 0;
+    LIST_FOREACH_SAFE(mon, &sg->monitoredItems, sampling.cyclic.groupEntry, mon_tmp) {
+        batch[batchSize++] = mon;
+        if(batchSize == UA_SAMPLING_BATCHSIZE) {
+            UA_MonitoredItem_sampleBatch(server, batch, batchSize);
+            batchSize = 0;
+        }
+    }
+    if(batchSize > 0)
+        UA_MonitoredItem_sampleBatch(server, batch, batchSize);
+    UA_MemoryCategory_leave(mc);
+    UA_UNLOCK(&server->serviceMutex);
+}
+
+static enum ZIP_CMP
+cmpReadValueId(const UA_ReadValueId *a, const UA_ReadValueId *b) {
+    return (enum ZIP_CMP)UA_order(a, b, &UA_TYPES[UA_TYPES_READVALUEID]);
+}
+
+ZIP_FUNCTIONS(UA_SharedSampleTree, UA_MonitoredItem, sampling.cyclic.sharedEntry,
+              UA_ReadValueId, itemToMonitor, cmpReadValueId)
+
+static void
+delayedFreeSamplingGroup(void *application, void *context) {
+    UA_free(context);
+}
+
+static UA_StatusCode
+addToSamplingGroup(UA_Server *server, UA_MonitoredItem *mon) {
+    /* Find the group with the same sampling interval */
+    UA_SamplingGroup *sg;
+    LIST_FOREACH(sg, &server->samplingGroups, listEntry) {
+        if(sg->samplingInterval == mon->parameters.samplingInterval)
+            break;
+    }
+
+    /* Create a new group with its own repeated callback */
+    if(!sg) {
+        sg = (UA_SamplingGroup*)UA_calloc(1, sizeof(UA_SamplingGroup));
+        if(!sg)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        sg->samplingInterval = mon->parameters.samplingInterval;
+        UA_StatusCode res =
+            addRepeatedCallback(server, (UA_ServerCallback)UA_SamplingGroup_sample,
+                                sg, sg->samplingInterval, &sg->callbackId);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_free(sg);
+            return res;
+        }
+        LIST_INSERT_HEAD(&server->samplingGroups, sg, listEntry);
+    }
+
+    /* Insert after a MonitoredItem with the same ReadValueId */
+    UA_MonitoredItem *same =
+        ZIP_FIND(UA_SharedSampleTree, &sg->sharedSamples, &mon->itemToMonitor);
+    if(same) {
+        LIST_INSERT_AFTER(same, mon, sampling.cyclic.groupEntry);
+        mon->sampling.cyclic.shared = true;
+    } else {
+        LIST_INSERT_HEAD(&sg->monitoredItems, mon, sampling.cyclic.groupEntry);
+        ZIP_INSERT(UA_SharedSampleTree, &sg->sharedSamples, mon);
+        mon->sampling.cyclic.shared = false;
+    }
+    sg->monitoredItemsSize++;
+    mon->sampling.cyclic.group = sg;
+    return UA_STATUSCODE_GOOD;
+}
+
 static void
-UA_MonitoredItem_lockAndSample(UA_Server *server, UA_MonitoredItem *mon) {
+removeFromSamplingGroup(UA_Server *server, UA_MonitoredItem *mon) {
+    UA_SamplingGroup *sg = mon->sampling.cyclic.group;
+
+    /* The next MonitoredItem with the same ReadValueId takes over the index */
+    if(!mon->sampling.cyclic.shared) {
+        ZIP_REMOVE(UA_SharedSampleTree, &sg->sharedSamples, mon);
+        UA_MonitoredItem *next = LIST_NEXT(mon, sampling.cyclic.groupEntry);
+        if(next && next->sampling.cyclic.shared) {
+            next->sampling.cyclic.shared = false;
+            ZIP_INSERT(UA_SharedSampleTree, &sg->sharedSamples, next);
+        }
+    }
+
+    LIST_REMOVE(mon, sampling.cyclic.groupEntry);
+    sg->monitoredItemsSize--;
+    mon->sampling.cyclic.group = NULL;
+    if(!LIST_EMPTY(&sg->monitoredItems))
+        return;
+
+    /* Remove the empty group. Free in a delayed callback, as the group might
+     * be currently sampling. */
+    removeCallback(server, sg->callbackId);
+    LIST_REMOVE(sg, listEntry);
+    sg->delayedFreePointers.callback = delayedFreeSamplingGroup;
+    sg->delayedFreePointers.application = NULL;
+    sg->delayedFreePointers.context = sg;
+    UA_EventLoop *el = server->config.eventLoop;
+    el->addDelayedCallback(el, &sg->delayedFreePointers);
+}
+
+/* Maximum number of deferred initial samples taken per EventLoop iteration */
+#define UA_INITIALSAMPLES_PERITERATION (16 * UA_SAMPLING_BATCHSIZE)
+
+static void
+scheduleInitialSamples(UA_Server *server);
+
+static void
+sampleInitialSamples(UA_Server *server, void *_) {
     UA_LOCK(&server->serviceMutex);
-    UA_MonitoredItem_sample(server, mon);
+    server->initialSamplesCallbackId = 0;
+    UA_MemoryCategory mc = UA_MemoryCategory_enter(UA_MEMORYCATEGORY_MONITOREDITEMS);
+    UA_MonitoredItem *batch[UA_SAMPLING_BATCHSIZE];
+    size_t total = 0;
+    while(total < UA_INITIALSAMPLES_PERITERATION &&
+          !TAILQ_EMPTY(&server->initialSamples)) {
+        size_t batchSize = 0;
+        UA_MonitoredItem *mon;
+        while(batchSize < UA_SAMPLING_BATCHSIZE &&
+              (mon = TAILQ_FIRST(&server->initialSamples))) {
+            TAILQ_REMOVE(&server->initialSamples, mon, initialSampleEntry);
+            mon->initialSamplePending = false;
+            batch[batchSize++] = mon;
+        }
+        UA_MonitoredItem_sampleBatch(server, batch, batchSize);
+        total += batchSize;
+    }
+
+    /* Continue in the next iteration */
+    if(!TAILQ_EMPTY(&server->initialSamples))
+        scheduleInitialSamples(server);
+    UA_MemoryCategory_leave(mc);
     UA_UNLOCK(&server->serviceMutex);
 }
 
+/* A timer without delay is processed in the next EventLoop iteration */
+static void
+scheduleInitialSamples(UA_Server *server) {
+    if(server->initialSamplesCallbackId != 0)
+        return;
+    UA_EventLoop *el = server->config.eventLoop;
+    UA_StatusCode res =
+        el->addTimer(el, (UA_Callback)sampleInitialSamples, server, NULL, 0.0,
+                     NULL, UA_TIMERPOLICY_ONCE, &server->initialSamplesCallbackId);
+    if(res != UA_STATUSCODE_GOOD)
+        server->initialSamplesCallbackId = 0;
+}
+
+void
+UA_MonitoredItem_deferInitialSample(UA_Server *server, UA_MonitoredItem *mon) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+    mon->deferInitialSample = false;
+    if(mon->initialSamplePending)
+        return;
+    TAILQ_INSERT_TAIL(&server->initialSamples, mon, initialSampleEntry);
+    mon->initialSamplePending = true;
+    scheduleInitialSamples(server);
+}
+
+static void
+cancelInitialSample(UA_Server *server, UA_MonitoredItem *mon) {
+    if(!mon->initialSamplePending)
+        return;
+    TAILQ_REMOVE(&server->initialSamples, mon, initialSampleEntry);
+    mon->initialSamplePending = false;
+
+    /* Don't leave a pending callback (the server might be deleted before) */
+    if(TAILQ_EMPTY(&server->initialSamples) && server->initialSamplesCallbackId != 0) {
+        removeCallback(server, server->initialSamplesCallbackId);
+        server->initialSamplesCallbackId = 0;
+    }
+}
+
 UA_StatusCode
 UA_MonitoredItem_registerSampling(UA_Server *server, UA_MonitoredItem *mon) {
     UA_LOCK_ASSERT(&server->serviceMutex);
@@ -1585,13 +2278,11 @@ UA_MonitoredItem_registerSampling(UA_Server *server, UA_MonitoredItem *mon) {
                          sampling.subscriptionSampling);
         mon->samplingType = UA_MONITOREDITEMSAMPLINGTYPE_PUBLISH;
     } else {
-        /* DataChange MonitoredItems with a positive sampling interval have a
-         * repeated callback. Other MonitoredItems are attached to the Node in a
-         * linked list of backpointers. */
-        res = addRepeatedCallback(server,
-                                  (UA_ServerCallback)UA_MonitoredItem_lockAndSample,
-                                  mon, mon->parameters.samplingInterval,
-                                  &mon->sampling.callbackId);
+        /* DataChange MonitoredItems with a positive sampling interval are
+         * sampled by the repeated callback of their SamplingGroup. Other
+         * MonitoredItems are attached to the Node in a linked list of
+         * backpointers. */
+        res = addToSamplingGroup(server, mon);
         if(res == UA_STATUSCODE_GOOD)
             mon->samplingType = UA_MONITOREDITEMSAMPLINGTYPE_CYCLIC;
     }
@@ -1603,10 +2294,13 @@ void
 UA_MonitoredItem_unregisterSampling(UA_Server *server, UA_MonitoredItem *mon) {
     UA_LOCK_ASSERT(&server->serviceMutex);
 
+    /* The initial sample is no longer needed */
+    cancelInitialSample(server, mon);
+
     switch(mon->samplingType) {
     case UA_MONITOREDITEMSAMPLINGTYPE_CYCLIC:
-        /* Remove repeated callback */
-        removeCallback(server, mon->sampling.callbackId);
+        /* Leave the SamplingGroup */
+        removeFromSamplingGroup(server, mon);
         break;
 
     case UA_MONITOREDITEMSAMPLINGTYPE_EVENT: {
@@ -1634,28 +2328,33 @@ UA_MonitoredItem_unregisterSampling(UA_Server *server, UA_MonitoredItem *mon) {
 
 UA_StatusCode
 UA_MonitoredItem_removeLink(UA_Subscription *sub, UA_MonitoredItem *mon, UA_UInt32 linkId) {
+    /* No links defined */
+    UA_MonitoredItemCold *cold = mon->cold;
+    if(!cold)
+        return UA_STATUSCODE_BADMONITOREDITEMIDINVALID;
+
     /* Find the index */
     size_t i = 0;
-    for(; i < mon->triggeringLinksSize; i++) {
-        if(mon->triggeringLinks[i] == linkId)
+    for(; i < cold->triggeringLinksSize; i++) {
+        if(cold->triggeringLinks[i] == linkId)
             break;
     }
 
     /* Not existing / already removed */
-    if(i == mon->triggeringLinksSize)
+    if(i == cold->triggeringLinksSize)
         return UA_STATUSCODE_BADMONITOREDITEMIDINVALID;
 
     /* Remove the link */
-    mon->triggeringLinksSize--;
-    if(mon->triggeringLinksSize == 0) {
-        UA_free(mon->triggeringLinks);
-        mon->triggeringLinks = NULL;
+    cold->triggeringLinksSize--;
+    if(cold->triggeringLinksSize == 0) {
+        UA_free(cold->triggeringLinks);
+        cold->triggeringLinks = NULL;
     } else {
-        mon->triggeringLinks[i] = mon->triggeringLinks[mon->triggeringLinksSize];
+        cold->triggeringLinks[i] = cold->triggeringLinks[cold->triggeringLinksSize];
         UA_UInt32 *tmpLinks = (UA_UInt32*)
-            UA_realloc(mon->triggeringLinks, mon->triggeringLinksSize * sizeof(UA_UInt32));
+            UA_realloc(cold->triggeringLinks, cold->triggeringLinksSize * sizeof(UA_UInt32));
         if(tmpLinks)
-            mon->triggeringLinks = tmpLinks;
+            cold->triggeringLinks = tmpLinks;
     }
 
     /* Does the target MonitoredItem exist? This is stupid, but the CTT wants us
@@ -1676,22 +2375,26 @@ UA_MonitoredItem_addLink(UA_Subscription *sub, UA_MonitoredItem *mon, UA_UInt32
     if(!mon2)
         return UA_STATUSCODE_BADMONITOREDITEMIDINVALID;
 
+    UA_MonitoredItemCold *cold = UA_MonitoredItem_getCold(mon);
+    if(!cold)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
     /* Does the link already exist? */
-    for(size_t i = 0 ; i < mon->triggeringLinksSize; i++) {
-        if(mon->triggeringLinks[i] == linkId)
+    for(size_t i = 0 ; i < cold->triggeringLinksSize; i++) {
+        if(cold->triggeringLinks[i] == linkId)
             return UA_STATUSCODE_GOOD;
     }
 
     /* Allocate the memory */
     UA_UInt32 *tmpLinkIds = (UA_UInt32*)
-        UA_realloc(mon->triggeringLinks, (mon->triggeringLinksSize + 1) * sizeof(UA_UInt32));
+        UA_realloc(cold->triggeringLinks, (cold->triggeringLinksSize + 1) * sizeof(UA_UInt32));
     if(!tmpLinkIds)
         return UA_STATUSCODE_BADOUTOFMEMORY;
-    mon->triggeringLinks = tmpLinkIds;
+    cold->triggeringLinks = tmpLinkIds;
 
     /* Add the link */
-    mon->triggeringLinks[mon->triggeringLinksSize] = linkId;
-    mon->triggeringLinksSize++;
+    cold->triggeringLinks[cold->triggeringLinksSize] = linkId;
+    cold->triggeringLinksSize++;
     return UA_STATUSCODE_GOOD;
 }
 
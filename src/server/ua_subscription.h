@@ -23,6 +23,7 @@
 #include <open62541/plugin/nodestore.h>
 
 #include "ua_session.h"
+#include "ziptree.h"
 #include "../util/ua_util_internal.h"
 
 _UA_BEGIN_DECLS
@@ -71,8 +72,9 @@ typedef struct UA_Notification {
 } UA_Notification;
 
 /* Initializes and sets the sentinel pointers. Only create a notification if it
- * is also going to be immediately enqueued to a MonitoredItem (see below). */
-UA_Notification * UA_Notification_new(void);
+ * is also going to be immediately enqueued to a MonitoredItem (see below). The
+ * memory is taken from the notification pool of the server. */
+UA_Notification * UA_Notification_new(UA_Server *server);
 
 /* Notifications are always added to the queue of a MonitoredItem. That queue
  * can overflow. If Notifications are reported, they are also added to the queue
@@ -85,13 +87,53 @@ UA_Notification * UA_Notification_new(void);
 void UA_Notification_enqueueAndTrigger(UA_Server *server,
                                        UA_Notification *n);
 
+/* Reuse the Notification that would be discarded from the full queue of a
+ * data-change MonitoredItem for the new value. This saves the allocation and
+ * the relinking in UA_MonitoredItem_ensureQueueSpace. Takes ownership of the
+ * value and returns true if the queue was full. Otherwise nothing is done. */
+UA_Boolean
+UA_Notification_recycleAndTrigger(UA_Server *server, UA_MonitoredItem *mon,
+                                  UA_DataValue *value);
+
 /* A NotificationMessage contains an array of notifications.
- * Sent NotificationMessages are stored for the republish service. */
+ * Sent NotificationMessages are stored for the republish service. They are kept
+ * binary-encoded. This is more compact than the decoded structure and the bytes
+ * are copied directly into the send buffer of the publish response. */
 typedef struct UA_NotificationMessageEntry {
     TAILQ_ENTRY(UA_NotificationMessageEntry) listEntry;
-    UA_NotificationMessage message;
+    UA_UInt32 sequenceNumber;
+    UA_DateTime publishTime;
+    UA_ByteString message; /* Encoded NotificationMessage */
 } UA_NotificationMessageEntry;
 
+/* Released Notifications and NotificationMessageEntries are kept in free
+ * lists of the server for reuse. This avoids the malloc/free churn at high
+ * notification rates. The pool is protected by the service mutex. The size
+ * of the free lists is limited by config.notificationPoolSize. */
+typedef struct {
+    UA_Notification *freeNotifications; /* Linked via subEntry.tqe_next */
+    size_t freeNotificationsSize;
+    UA_NotificationMessageEntry *freeEntries; /* Linked via listEntry.tqe_next */
+    size_t freeEntriesSize;
+
+    /* Statistics */
+    size_t notificationsInUse;
+    size_t notificationsHighWaterMark;
+    size_t entriesInUse;
+    size_t entriesHighWaterMark;
+} UA_NotificationPool;
+
+void
+UA_NotificationPool_clear(UA_NotificationPool *pool);
+
+UA_NotificationMessageEntry *
+UA_NotificationMessageEntry_new(UA_Server *server);
+
+/* Clears the message and returns the entry to the pool */
+void
+UA_NotificationMessageEntry_delete(UA_Server *server,
+                                   UA_NotificationMessageEntry *entry);
+
 /* Queue Definitions */
 typedef TAILQ_HEAD(NotificationQueue, UA_Notification) NotificationQueue;
 typedef TAILQ_HEAD(NotificationMessageQueue, UA_NotificationMessageEntry)
@@ -108,13 +150,77 @@ typedef TAILQ_HEAD(NotificationMessageQueue, UA_NotificationMessageEntry)
  * <0: Attached to the subscription. Triggered just before every "publish". */
 typedef enum {
     UA_MONITOREDITEMSAMPLINGTYPE_NONE = 0,
-    UA_MONITOREDITEMSAMPLINGTYPE_CYCLIC, /* Cyclic callback */
+    UA_MONITOREDITEMSAMPLINGTYPE_CYCLIC, /* Cyclic callback of a SamplingGroup */
     UA_MONITOREDITEMSAMPLINGTYPE_EVENT,  /* Attached to the node. Can be a "write
                                           * event" for DataChange MonitoredItems
                                           * with a zero sampling interval .*/
     UA_MONITOREDITEMSAMPLINGTYPE_PUBLISH /* Attached to the subscription */
 } UA_MonitoredItemSamplingType;
 
+/* MonitoredItems with the same cyclic sampling interval share one repeated
+ * callback. The SamplingGroup samples all its MonitoredItems in one pass. The
+ * SamplingGroups are kept in a server-wide list and removed when the last
+ * MonitoredItem leaves.
+ *
+ * MonitoredItems with the same ReadValueId (for example from many clients
+ * showing the same screen) follow each other in the list of the group. The
+ * first of them is indexed in a tree. The others are marked as shared. A run
+ * of shared MonitoredItems in a batch is read only once. */
+#define UA_SAMPLING_BATCHSIZE 64
+
+typedef ZIP_HEAD(UA_SharedSampleTree, UA_MonitoredItem) UA_SharedSampleTree;
+
+typedef struct UA_SamplingGroup {
+    UA_DelayedCallback delayedFreePointers;
+    LIST_ENTRY(UA_SamplingGroup) listEntry;
+    UA_Double samplingInterval;
+    UA_UInt64 callbackId;
+    LIST_HEAD(, UA_MonitoredItem) monitoredItems;
+    size_t monitoredItemsSize;
+    UA_SharedSampleTree sharedSamples;
+} UA_SamplingGroup;
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+/* Filter state that is kept between the events of a MonitoredItem. Literal
+ * operands of the where-clause are kept after their implicit cast to the
+ * operand type they are compared against. The validity of the select clauses
+ * and the result of OfType operators only depend on the EventType. They are
+ * cached for the EventType of the last event. For events from flat fields, the
+ * position of each select clause in the field map is kept as well (the
+ * projection table). The cache is reset when the filter changes. */
+#define UA_EVENTFILTER_CACHEDOPERANDS 3 /* Cached literals per element */
+
+typedef struct {
+    UA_Variant *literals; /* UA_EVENTFILTER_CACHEDOPERANDS per where-clause
+                           * element, allocated with the first cast */
+    size_t literalsSize;
+    UA_NodeId eventType;
+    UA_UInt64 selectKnown; /* Bitmask over the select clauses */
+    UA_UInt64 selectValid;
+    UA_UInt64 ofTypeKnown; /* Bitmask over the where-clause elements */
+    UA_UInt64 ofTypeMatch;
+    UA_UInt16 *fieldIndex; /* Per select clause. UA_UINT16_MAX if unknown. */
+    size_t fieldIndexSize;
+} UA_EventFilterCache;
+
+void UA_EventFilterCache_clear(UA_EventFilterCache *cache);
+#endif
+
+/* Fields that most MonitoredItems don't use. They are kept in a side
+ * allocation that is created on demand. So the common DataChange-MonitoredItem
+ * (without triggering links) stays compact. */
+typedef struct {
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    UA_EventFilterCache eventFilterCache;
+#endif
+
+    /* Triggering Links */
+    size_t triggeringLinksSize;
+    UA_UInt32 *triggeringLinks;
+} UA_MonitoredItemCold;
+
+/* The fields are ordered to avoid padding. Several hundred thousand
+ * MonitoredItems can be alive in a server. */
 struct UA_MonitoredItem {
     UA_DelayedCallback delayedFreePointers;
     LIST_ENTRY(UA_MonitoredItem) listEntry; /* Linked list in the Subscription */
@@ -122,10 +228,21 @@ struct UA_MonitoredItem {
     UA_UInt32 monitoredItemId;
 
     /* Status and Settings */
-    UA_ReadValueId itemToMonitor;
     UA_MonitoringMode monitoringMode;
+    UA_ReadValueId itemToMonitor;
     UA_TimestampsToReturn timestampsToReturn;
     UA_Boolean registered;       /* Registered in the server / Subscription */
+
+    /* Created as part of a batch. The first sample is taken in a later
+     * iteration of the EventLoop. */
+    UA_Boolean deferInitialSample;
+    UA_Boolean initialSamplePending; /* Enqueued in the server */
+
+    /* For large values, only the hash of the last value is kept. Then
+     * lastValue contains no variant data. See the
+     * monitoredItemHashThreshold in the server config. */
+    UA_Boolean lastValueHashed;
+
     UA_DateTime triggeredUntil;  /* If the MonitoringMode is SAMPLING,
                                   * triggering the MonitoredItem puts the latest
                                   * Notification into the publishing queue (of
@@ -151,16 +268,20 @@ struct UA_MonitoredItem {
     /* Sampling */
     UA_MonitoredItemSamplingType samplingType;
     union {
-        UA_UInt64 callbackId;
+        struct {
+            LIST_ENTRY(UA_MonitoredItem) groupEntry;
+            UA_SamplingGroup *group;
+            ZIP_ENTRY(UA_MonitoredItem) sharedEntry;
+            UA_Boolean shared; /* Same ReadValueId as the previous
+                                * MonitoredItem in the group */
+        } cyclic;                       /* Cyclic: Member of a SamplingGroup */
         UA_MonitoredItem *nodeListNext; /* Event-Based: Attached to Node */
         LIST_ENTRY(UA_MonitoredItem) subscriptionSampling; /* Linked to publish
                                                             * interval */
     } sampling;
     UA_DataValue lastValue;
-
-    /* Triggering Links */
-    size_t triggeringLinksSize;
-    UA_UInt32 *triggeringLinks;
+    UA_UInt64 lastValueHash;
+    TAILQ_ENTRY(UA_MonitoredItem) initialSampleEntry;
 
     /* Notification Queue */
     NotificationQueue queue;
@@ -168,9 +289,17 @@ struct UA_MonitoredItem {
                        * (maximum) queueSize in the parameters. */
     size_t eventOverflows; /* Separate counter for the queue. Can at most double
                             * the queue size */
+
+    UA_MonitoredItemCold *cold; /* NULL until used */
 };
 
 void UA_MonitoredItem_init(UA_MonitoredItem *mon);
+
+/* Returns the side allocation with the rarely used fields. Allocates it if
+ * required. Returns NULL if out of memory. */
+UA_MonitoredItemCold *
+UA_MonitoredItem_getCold(UA_MonitoredItem *mon);
+
 void UA_MonitoredItem_delete(UA_Server *server, UA_MonitoredItem *mon);
 void UA_MonitoredItem_removeOverflowInfoBits(UA_MonitoredItem *mon);
 void UA_Server_registerMonitoredItem(UA_Server *server, UA_MonitoredItem *mon);
@@ -190,6 +319,26 @@ UA_MonitoredItem_setMonitoringMode(UA_Server *server, UA_MonitoredItem *mon,
 void
 UA_MonitoredItem_sample(UA_Server *server, UA_MonitoredItem *mon);
 
+/* Enqueue the first sample of a batch-created MonitoredItem. The queue is
+ * processed in chunks over the next iterations of the EventLoop. Removed from
+ * the queue when the sampling is unregistered. */
+void
+UA_MonitoredItem_deferInitialSample(UA_Server *server, UA_MonitoredItem *mon);
+
+/* Sample up to UA_SAMPLING_BATCHSIZE MonitoredItems together. The absolute
+ * deadbands of numeric scalars are evaluated for the entire batch in one
+ * pass. MonitoredItems whose sampling was unregistered meanwhile are
+ * skipped. */
+void
+UA_MonitoredItem_sampleBatch(UA_Server *server, UA_MonitoredItem **mons,
+                             size_t monsSize);
+
+/* Process the values that were sampled for a batch. The values are moved out
+ * of the dvs array. */
+void
+UA_MonitoredItem_processSampleBatch(UA_Server *server, UA_MonitoredItem **mons,
+                                    UA_DataValue *dvs, size_t monsSize);
+
 /* Do not use the value after calling this. It will be moved to mon or freed. */
 void
 UA_MonitoredItem_processSampledValue(UA_Server *server, UA_MonitoredItem *mon,
@@ -223,6 +372,22 @@ typedef enum {
     UA_SUBSCRIPTIONSTATE_ENABLED
 } UA_SubscriptionState;
 
+#define UA_MAX_RETRANSMISSIONQUEUESIZE 256
+
+/* Subscriptions with the same publishing interval share one repeated
+ * callback. The PublishGroup samples and publishes all its Subscriptions in one
+ * pass, ordered by descending priority. This aligns the publishing cycles of
+ * Subscriptions that compete for the PublishRequests of a Session. The groups
+ * are kept in a server-wide list and removed when the last Subscription
+ * leaves. */
+typedef struct UA_PublishGroup {
+    UA_DelayedCallback delayedFreePointers;
+    LIST_ENTRY(UA_PublishGroup) listEntry;
+    UA_Double publishingInterval;
+    UA_UInt64 callbackId;
+    LIST_HEAD(, UA_Subscription) subscriptions;
+} UA_PublishGroup;
+
 /* Subscriptions are managed in a server-wide linked list. If they are attached
  * to a Session, then they are additionaly in the per-Session linked-list. A
  * subscription is always generated for a Session. But the CloseSession Service
@@ -254,8 +419,9 @@ struct UA_Subscription {
     UA_UInt32 currentKeepAliveCount;
     UA_UInt32 currentLifetimeCount;
 
-    /* Publish Callback. Registered if id > 0. */
-    UA_UInt64 publishCallbackId;
+    /* Member of a PublishGroup if the Subscription is enabled */
+    UA_PublishGroup *publishGroup;
+    LIST_ENTRY(UA_Subscription) publishGroupEntry;
 
     /* Delayed callback to schedule publication of more notifications */
     UA_Boolean delayedCallbackRegistered;
@@ -276,9 +442,13 @@ struct UA_Subscription {
     UA_UInt32 dataChangeNotifications;
     UA_UInt32 eventNotifications;
 
-    /* Retransmission Queue */
+    /* Retransmission Queue. Ordered by sequence number. The index looks up
+     * the entries by their sequence number (modulo the maximum queue size) for
+     * the acknowledgements. */
     NotificationMessageQueue retransmissionQueue;
     size_t retransmissionQueueSize;
+    size_t retransmissionQueueBytes; /* Encoded length of the messages */
+    UA_NotificationMessageEntry *retransmissionIndex[UA_MAX_RETRANSMISSIONQUEUESIZE];
 
     /* Statistics for the server diagnostics. The fields are defined according
      * to the SubscriptionDiagnosticsDataType (Part 5, §12.15). */
@@ -309,10 +479,30 @@ UA_Subscription * UA_Subscription_new(void);
 void
 UA_Subscription_delete(UA_Server *server, UA_Subscription *sub);
 
+/* Register a Subscription with the SubscriptionId and settings of a replicated
+ * Subscription (see ua_server_replication.c). The session can be NULL for a
+ * detached Subscription. The Subscription is deleted if this fails. */
+UA_StatusCode
+UA_Server_restoreSubscription(UA_Server *server, UA_Session *session,
+                              UA_Subscription *sub, UA_Boolean publishingEnabled);
+
+/* Create a MonitoredItem with the MonitoredItemId of a replicated
+ * MonitoredItem */
+UA_StatusCode
+UA_Server_restoreMonitoredItem(UA_Server *server, UA_Session *session,
+                               UA_Subscription *sub, UA_UInt32 monitoredItemId,
+                               UA_TimestampsToReturn timestampsToReturn,
+                               const UA_MonitoredItemCreateRequest *request);
+
 UA_StatusCode
 Subscription_setState(UA_Server *server, UA_Subscription *sub,
                       UA_SubscriptionState state);
 
+/* Move an enabled Subscription to the PublishGroup for its current publishing
+ * interval and priority */
+UA_StatusCode
+Subscription_updatePublishGroup(UA_Server *server, UA_Subscription *sub);
+
 void
 Subscription_resetLifetime(UA_Subscription *sub);
 
@@ -329,8 +519,20 @@ UA_Subscription_localPublish(UA_Server *server, UA_Subscription *sub);
 void
 UA_Subscription_resendData(UA_Server *server, UA_Subscription *sub);
 
+/* Takes ownership of the entry. Releases the oldest messages if the count or
+ * byte limits of the Subscription, Session or server are reached. */
+void
+UA_Subscription_addRetransmissionMessage(UA_Server *server, UA_Subscription *sub,
+                                         UA_NotificationMessageEntry *entry);
+
+/* Look up a retransmission message by its sequence number. Returns NULL if the
+ * message is unknown. */
+UA_NotificationMessageEntry *
+UA_Subscription_getRetransmissionMessage(UA_Subscription *sub,
+                                         UA_UInt32 sequenceNumber);
+
 UA_StatusCode
-UA_Subscription_removeRetransmissionMessage(UA_Subscription *sub,
+UA_Subscription_removeRetransmissionMessage(UA_Server *server, UA_Subscription *sub,
                                             UA_UInt32 sequenceNumber);
 
 void
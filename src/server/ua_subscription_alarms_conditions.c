@@ -30,12 +30,59 @@ typedef struct UA_ConditionBranch {
     UA_Boolean isCallerAC;
 } UA_ConditionBranch;
 
+/* Fields of a condition whose NodeIds are cached in the condition entry. The
+ * state of a condition is read from these nodes on every transition and for
+ * every condition during ConditionRefresh. The NodeIds are resolved with a
+ * browse on first use only. */
+typedef enum {
+    UA_CONDITIONFIELD_RETAIN = 0,
+    UA_CONDITIONFIELD_ENABLEDSTATE_ID,
+    UA_CONDITIONFIELD_ACKEDSTATE_ID,
+    UA_CONDITIONFIELD_CONFIRMEDSTATE_ID,
+    UA_CONDITIONFIELD_ACTIVESTATE_ID,
+    UA_CONDITIONFIELD_CACHED
+} UA_ConditionCachedField;
+
+/* Limits of a LimitAlarm in the order of their evaluation */
+#define UA_LIMIT_HIGHHIGH 0
+#define UA_LIMIT_HIGH 1
+#define UA_LIMIT_LOWLOW 2
+#define UA_LIMIT_LOW 3
+#define UA_LIMITS 4
+#define UA_LIMITALARM_INPUT UA_LIMITS /* Watch on the input node */
+
+/* A watch connects a node to the limit alarm that evaluates it. The watches of
+ * all conditions are indexed by the NodeId of the watched node. Writing to the
+ * input node evaluates the alarm. Writing to a limit property updates the
+ * cached limit. */
+typedef struct UA_ConditionWatch {
+    ZIP_ENTRY(UA_ConditionWatch) treeEntry; /* server->conditionWatchTree */
+    UA_NodeId nodeId;
+    struct UA_Condition *condition;
+    UA_Byte target; /* Index of the limit or UA_LIMITALARM_INPUT */
+    UA_Boolean linked;
+} UA_ConditionWatch;
+
+/* State of a LimitAlarm for the evaluation without address space lookups.
+ * Created on the first evaluation. */
+typedef struct {
+    UA_ConditionWatch watches[UA_LIMITS + 1];
+    UA_Double limits[UA_LIMITS];
+    UA_Byte limitsSet;           /* Bitmask of the limits with a value */
+    UA_Double lastValue;         /* Last evaluated input value */
+    UA_ActiveState state;        /* Result of the last evaluation */
+    UA_Boolean evaluated;
+} UA_LimitAlarm;
+
 /* In Alarms and Conditions first implementation, A Condition
  * have only one ConditionBranch entry. */
 typedef struct UA_Condition {
     LIST_ENTRY(UA_Condition) listEntry;
+    ZIP_ENTRY(UA_Condition) idTreeEntry; /* server->conditionIdTree */
     LIST_HEAD(, UA_ConditionBranch) conditionBranches;
     UA_NodeId conditionId;
+    UA_ConditionSource *source;
+    UA_NodeId fieldIds[UA_CONDITIONFIELD_CACHED]; /* Null until resolved */
     UA_UInt16 lastSeverity;
     UA_DateTime lastSeveritySourceTimeStamp;
 
@@ -53,15 +100,29 @@ typedef struct UA_Condition {
     UA_ActiveState lastActiveState;
     UA_ActiveState currentActiveState;
     UA_Boolean isLimitAlarm;
+    UA_LimitAlarm *limitAlarm; /* NULL until the limits are evaluated */
 } UA_Condition;
 
 /* A ConditionSource can have multiple Conditions. */
 struct UA_ConditionSource {
     LIST_ENTRY(UA_ConditionSource) listEntry;
+    ZIP_ENTRY(UA_ConditionSource) treeEntry; /* server->conditionSourceTree */
     LIST_HEAD(, UA_Condition) conditions;
     UA_NodeId conditionSourceId;
 };
 
+static enum ZIP_CMP
+cmpConditionNodeId(const UA_NodeId *a, const UA_NodeId *b) {
+    return (enum ZIP_CMP)UA_NodeId_order(a, b);
+}
+
+ZIP_FUNCTIONS(UA_ConditionIdTree, UA_Condition, idTreeEntry,
+              UA_NodeId, conditionId, cmpConditionNodeId)
+ZIP_FUNCTIONS(UA_ConditionSourceTree, UA_ConditionSource, treeEntry,
+              UA_NodeId, conditionSourceId, cmpConditionNodeId)
+ZIP_FUNCTIONS(UA_ConditionWatchTree, UA_ConditionWatch, treeEntry,
+              UA_NodeId, nodeId, cmpConditionNodeId)
+
 #define CONDITIONOPTIONALFIELDS_SUPPORT // change array size!
 #define CONDITION_SEVERITYCHANGECALLBACK_ENABLE
 
@@ -159,6 +220,8 @@ static const UA_QualifiedName fieldActiveStateQN = STATIC_QN(CONDITION_FIELD_ACT
 static const UA_QualifiedName fieldTimeQN = STATIC_QN(CONDITION_FIELD_TIME);
 static const UA_QualifiedName fieldSourceQN = STATIC_QN(CONDITION_FIELD_SOURCENODE);
 static const UA_QualifiedName fieldLimitStateQN = STATIC_QN(CONDITION_FIELD_LIMITSTATE);
+static const UA_QualifiedName fieldCurrentStateQN = STATIC_QN(CONDITION_FIELD_CURRENTSTATE);
+static const UA_QualifiedName fieldInputNodeQN = STATIC_QN(CONDITION_FIELD_INPUTNODE);
 static const UA_QualifiedName fieldLowLimitQN = STATIC_QN(CONDITION_FIELD_LOWLIMIT);
 static const UA_QualifiedName fieldLowLowLimitQN = STATIC_QN(CONDITION_FIELD_LOWLOWLIMIT);
 static const UA_QualifiedName fieldHighLimitQN = STATIC_QN(CONDITION_FIELD_HIGHLIMIT);
@@ -210,28 +273,23 @@ addConditionOptionalField(UA_Server *server, const UA_NodeId condition,
 static UA_ConditionSource *
 getConditionSource(UA_Server *server, const UA_NodeId *sourceId) {
     UA_LOCK_ASSERT(&server->serviceMutex);
-    UA_ConditionSource *cs;
-    LIST_FOREACH(cs, &server->conditionSources, listEntry) {
-        if(UA_NodeId_equal(&cs->conditionSourceId, sourceId))
-            return cs;
-    }
-    return NULL;
+    return ZIP_FIND(UA_ConditionSourceTree, &server->conditionSourceTree, sourceId);
+}
+
+static UA_Condition *
+getConditionById(UA_Server *server, const UA_NodeId *conditionId) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+    return ZIP_FIND(UA_ConditionIdTree, &server->conditionIdTree, conditionId);
 }
 
 static UA_Condition *
 getCondition(UA_Server *server, const UA_NodeId *sourceId,
              const UA_NodeId *conditionId) {
     UA_LOCK_ASSERT(&server->serviceMutex);
-    UA_ConditionSource *cs = getConditionSource(server, sourceId);
-    if(!cs)
+    UA_Condition *c = getConditionById(server, conditionId);
+    if(!c || !UA_NodeId_equal(&c->source->conditionSourceId, sourceId))
         return NULL;
-
-    UA_Condition *c;
-    LIST_FOREACH(c, &cs->conditions, listEntry) {
-        if(UA_NodeId_equal(&c->conditionId, conditionId))
-            return c;
-    }
-    return NULL;
+    return c;
 }
 
 /* Function used to set a user specific callback to TwoStateVariable Fields of a
@@ -408,18 +466,53 @@ UA_Server_getFieldParentNodeId(UA_Server *server, const UA_NodeId *field, UA_Nod
     return res;
 }
 
+/* Returns the slot in the field cache of the condition or NULL if the field is
+ * not cached. The property is NULL for the field itself. */
+static UA_NodeId *
+getCachedFieldSlot(UA_Server *server, const UA_NodeId *conditionNodeId,
+                   const UA_QualifiedName *fieldName,
+                   const UA_QualifiedName *propertyName) {
+    UA_ConditionCachedField field;
+    if(!propertyName) {
+        if(!UA_QualifiedName_equal(fieldName, &fieldRetainQN))
+            return NULL;
+        field = UA_CONDITIONFIELD_RETAIN;
+    } else {
+        if(!UA_QualifiedName_equal(propertyName, &twoStateVariableIdQN))
+            return NULL;
+        if(UA_QualifiedName_equal(fieldName, &fieldEnabledStateQN))
+            field = UA_CONDITIONFIELD_ENABLEDSTATE_ID;
+        else if(UA_QualifiedName_equal(fieldName, &fieldAckedStateQN))
+            field = UA_CONDITIONFIELD_ACKEDSTATE_ID;
+        else if(UA_QualifiedName_equal(fieldName, &fieldConfirmedStateQN))
+            field = UA_CONDITIONFIELD_CONFIRMEDSTATE_ID;
+        else if(UA_QualifiedName_equal(fieldName, &fieldActiveStateQN))
+            field = UA_CONDITIONFIELD_ACTIVESTATE_ID;
+        else
+            return NULL;
+    }
+    UA_Condition *cond = getConditionById(server, conditionNodeId);
+    return (cond) ? &cond->fieldIds[field] : NULL;
+}
+
 /* Gets the NodeId of a Field (e.g. Severity) */
 static UA_StatusCode
 getConditionFieldNodeId(UA_Server *server, const UA_NodeId *conditionNodeId,
                         const UA_QualifiedName* fieldName, UA_NodeId *outFieldNodeId) {
     UA_LOCK_ASSERT(&server->serviceMutex);
 
+    UA_NodeId *cached = getCachedFieldSlot(server, conditionNodeId, fieldName, NULL);
+    if(cached && !UA_NodeId_isNull(cached))
+        return UA_NodeId_copy(cached, outFieldNodeId);
+
     UA_BrowsePathResult bpr =
         browseSimplifiedBrowsePath(server, *conditionNodeId, 1, fieldName);
     if(bpr.statusCode != UA_STATUSCODE_GOOD)
         return bpr.statusCode;
     UA_StatusCode retval = UA_NodeId_copy(&bpr.targets[0].targetId.nodeId, outFieldNodeId);
     UA_BrowsePathResult_clear(&bpr);
+    if(retval == UA_STATUSCODE_GOOD && cached)
+        UA_NodeId_copy(outFieldNodeId, cached); /* Not cached if out of memory */
     return retval;
 }
 
@@ -431,6 +524,11 @@ getConditionFieldPropertyNodeId(UA_Server *server, const UA_NodeId *originCondit
                                 UA_NodeId *outFieldPropertyNodeId) {
     UA_LOCK_ASSERT(&server->serviceMutex);
 
+    UA_NodeId *cached = getCachedFieldSlot(server, originCondition,
+                                           variableFieldName, variablePropertyName);
+    if(cached && !UA_NodeId_isNull(cached))
+        return UA_NodeId_copy(cached, outFieldPropertyNodeId);
+
     /* 1) Find Variable Field of the Condition */
     UA_BrowsePathResult bprConditionVariableField =
         browseSimplifiedBrowsePath(server, *originCondition, 1, variableFieldName);
@@ -450,6 +548,8 @@ getConditionFieldPropertyNodeId(UA_Server *server, const UA_NodeId *originCondit
     UA_NodeId_init(&bprVariableFieldProperty.targets[0].targetId.nodeId);
     UA_BrowsePathResult_clear(&bprConditionVariableField);
     UA_BrowsePathResult_clear(&bprVariableFieldProperty);
+    if(cached)
+        UA_NodeId_copy(outFieldPropertyNodeId, cached); /* Not cached if out of memory */
     return UA_STATUSCODE_GOOD;
 }
 
@@ -1938,7 +2038,9 @@ setConditionInConditionList(UA_Server *server, const UA_NodeId *conditionNodeId,
     }
 
     memset(conditionBranchListEntry, 0, sizeof(UA_ConditionBranch));
+    conditionListEntry->source = conditionSourceEntry;
     LIST_INSERT_HEAD(&conditionSourceEntry->conditions, conditionListEntry, listEntry);
+    ZIP_INSERT(UA_ConditionIdTree, &server->conditionIdTree, conditionListEntry);
     LIST_INSERT_HEAD(&conditionListEntry->conditionBranches, conditionBranchListEntry, listEntry);
     return UA_STATUSCODE_GOOD;
 }
@@ -1969,6 +2071,8 @@ appendConditionEntry(UA_Server *server, const UA_NodeId *conditionNodeId,
     }
 
     LIST_INSERT_HEAD(&server->conditionSources, conditionSourceListEntry, listEntry);
+    ZIP_INSERT(UA_ConditionSourceTree, &server->conditionSourceTree,
+               conditionSourceListEntry);
     return setConditionInConditionList(server, conditionNodeId, conditionSourceListEntry);
 }
 
@@ -1984,13 +2088,40 @@ deleteAllBranchesFromCondition(UA_Condition *cond) {
 }
 
 static void
-deleteCondition(UA_Condition *cond) {
+deleteLimitAlarm(UA_Server *server, UA_Condition *cond) {
+    UA_LimitAlarm *la = cond->limitAlarm;
+    if(!la)
+        return;
+    for(size_t i = 0; i <= UA_LIMITS; i++) {
+        if(la->watches[i].linked)
+            ZIP_REMOVE(UA_ConditionWatchTree, &server->conditionWatchTree,
+                       &la->watches[i]);
+        UA_NodeId_clear(&la->watches[i].nodeId);
+    }
+    UA_free(la);
+    cond->limitAlarm = NULL;
+}
+
+static void
+deleteCondition(UA_Server *server, UA_Condition *cond) {
+    deleteLimitAlarm(server, cond);
     deleteAllBranchesFromCondition(cond);
+    ZIP_REMOVE(UA_ConditionIdTree, &server->conditionIdTree, cond);
+    for(size_t i = 0; i < UA_CONDITIONFIELD_CACHED; i++)
+        UA_NodeId_clear(&cond->fieldIds[i]);
     UA_NodeId_clear(&cond->conditionId);
     LIST_REMOVE(cond, listEntry);
     UA_free(cond);
 }
 
+static void
+deleteConditionSource(UA_Server *server, UA_ConditionSource *source) {
+    ZIP_REMOVE(UA_ConditionSourceTree, &server->conditionSourceTree, source);
+    UA_NodeId_clear(&source->conditionSourceId);
+    LIST_REMOVE(source, listEntry);
+    UA_free(source);
+}
+
 void
 UA_ConditionList_delete(UA_Server *server) {
     UA_LOCK_ASSERT(&server->serviceMutex);
@@ -1999,11 +2130,9 @@ UA_ConditionList_delete(UA_Server *server) {
     LIST_FOREACH_SAFE(source, &server->conditionSources, listEntry, tmp_source) {
         UA_Condition *cond, *tmp_cond;
         LIST_FOREACH_SAFE(cond, &source->conditions, listEntry, tmp_cond) {
-            deleteCondition(cond);
+            deleteCondition(server, cond);
         }
-        UA_NodeId_clear(&source->conditionSourceId);
-        LIST_REMOVE(source, listEntry);
-        UA_free(source);
+        deleteConditionSource(server, source);
     }
     /* Free memory allocated for RefreshEvents NodeIds */
     UA_NodeId_clear(&server->refreshEvents[REFRESHEVENT_START_IDX]);
@@ -2017,16 +2146,17 @@ UA_getConditionId(UA_Server *server, const UA_NodeId *conditionNodeId,
                   UA_NodeId *outConditionId) {
     UA_LOCK_ASSERT(&server->serviceMutex);
 
-    /* Get ConditionSource Entry */
+    /* Lookup in the index of the ConditionIds */
+    UA_Condition *cond = getConditionById(server, conditionNodeId);
+    if(cond) {
+        *outConditionId = cond->conditionId;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    /* Search in the branches */
     UA_ConditionSource *source;
     LIST_FOREACH(source, &server->conditionSources, listEntry) {
-        /* Get Condition Entry */
-        UA_Condition *cond;
         LIST_FOREACH(cond, &source->conditions, listEntry) {
-            if(UA_NodeId_equal(&cond->conditionId, conditionNodeId)) {
-                *outConditionId = cond->conditionId;
-                return UA_STATUSCODE_GOOD;
-            }
             /* Get Branch Entry*/
             UA_ConditionBranch *branch;
             LIST_FOREACH(branch, &cond->conditionBranches, listEntry) {
@@ -2790,13 +2920,13 @@ setConditionField(UA_Server *server, const UA_NodeId condition,
                                      "Set Condition Field with Array value not implemented",);
     }
 
-    UA_BrowsePathResult bpr = browseSimplifiedBrowsePath(server, condition, 1, &fieldName);
-    if(bpr.statusCode != UA_STATUSCODE_GOOD)
-        return bpr.statusCode;
-
-    UA_StatusCode retval = writeValueAttribute(server, bpr.targets[0].targetId.nodeId, value);
-    UA_BrowsePathResult_clear(&bpr);
+    UA_NodeId fieldId;
+    UA_StatusCode retval = getConditionFieldNodeId(server, &condition, &fieldName, &fieldId);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
 
+    retval = writeValueAttribute(server, fieldId, value);
+    UA_NodeId_clear(&fieldId);
     return retval;
 }
 
@@ -2823,25 +2953,15 @@ setConditionVariableFieldProperty(UA_Server *server, const UA_NodeId condition,
                                        "Set Property of Condition Field with Array value not implemented",);
     }
 
-    /* 1) find Variable Field of the Condition*/
-    UA_BrowsePathResult bprConditionVariableField =
-        browseSimplifiedBrowsePath(server, condition, 1, &variableFieldName);
-    if(bprConditionVariableField.statusCode != UA_STATUSCODE_GOOD)
-        return bprConditionVariableField.statusCode;
-
-    /* 2) find Property of the Variable Field of the Condition*/
-    UA_BrowsePathResult bprVariableFieldProperty =
-        browseSimplifiedBrowsePath(server, bprConditionVariableField.targets->targetId.nodeId,
-                                   1, &variablePropertyName);
-    if(bprVariableFieldProperty.statusCode != UA_STATUSCODE_GOOD) {
-        UA_BrowsePathResult_clear(&bprConditionVariableField);
-        return bprVariableFieldProperty.statusCode;
-    }
-
+    UA_NodeId propertyId;
     UA_StatusCode retval =
-        writeValueAttribute(server, bprVariableFieldProperty.targets[0].targetId.nodeId, value);
-    UA_BrowsePathResult_clear(&bprConditionVariableField);
-    UA_BrowsePathResult_clear(&bprVariableFieldProperty);
+        getConditionFieldPropertyNodeId(server, &condition, &variableFieldName,
+                                        &variablePropertyName, &propertyId);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
+    retval = writeValueAttribute(server, propertyId, value);
+    UA_NodeId_clear(&propertyId);
     return retval;
 }
 
@@ -2908,31 +3028,18 @@ UA_Server_triggerConditionEvent(UA_Server *server, const UA_NodeId condition,
 UA_StatusCode
 UA_Server_deleteCondition(UA_Server *server, const UA_NodeId condition,
                           const UA_NodeId conditionSource) {
-    /* Get ConditionSource Entry */
-    UA_Boolean found = false; /* Delete from internal list */
-    UA_ConditionSource *source, *tmp_source;
-
+    /* Delete from internal list */
+    UA_Boolean found = false;
     UA_LOCK(&server->serviceMutex);
-    LIST_FOREACH_SAFE(source, &server->conditionSources, listEntry, tmp_source) {
-        if(!UA_NodeId_equal(&source->conditionSourceId, &conditionSource))
-            continue;
-
-        /* Get Condition Entry */
-        UA_Condition *cond, *tmp_cond;
-        LIST_FOREACH_SAFE(cond, &source->conditions, listEntry, tmp_cond) {
-            if(!UA_NodeId_equal(&cond->conditionId, &condition))
-                continue;
-            deleteCondition(cond);
+    UA_ConditionSource *source = getConditionSource(server, &conditionSource);
+    if(source) {
+        UA_Condition *cond = getCondition(server, &conditionSource, &condition);
+        if(cond) {
+            deleteCondition(server, cond);
             found = true;
-            break;
         }
-
-        if(LIST_EMPTY(&source->conditions)){
-            UA_NodeId_clear(&source->conditionSourceId);
-            LIST_REMOVE(source, listEntry);
-            UA_free(source);
-        }
-        break;
+        if(LIST_EMPTY(&source->conditions))
+            deleteConditionSource(server, source);
     }
     UA_UNLOCK(&server->serviceMutex);
 
@@ -2943,142 +3050,302 @@ UA_Server_deleteCondition(UA_Server *server, const UA_NodeId condition,
     return UA_Server_deleteNode(server, condition, true);
 }
 
-static UA_StatusCode
-getLowLimit(UA_Server *server, UA_NodeId conditionId, UA_Double *lowLimit) {
+/* Get the numeric scalar as a double */
+static UA_Boolean
+getLimitValue(const UA_Variant *v, UA_Double *out) {
+    if(!v->type || !UA_Variant_isScalar(v))
+        return false;
+    switch(v->type->typeKind) {
+    case UA_DATATYPEKIND_SBYTE:  *out = *(const UA_SByte*)v->data;  return true;
+    case UA_DATATYPEKIND_BYTE:   *out = *(const UA_Byte*)v->data;   return true;
+    case UA_DATATYPEKIND_INT16:  *out = *(const UA_Int16*)v->data;  return true;
+    case UA_DATATYPEKIND_UINT16: *out = *(const UA_UInt16*)v->data; return true;
+    case UA_DATATYPEKIND_INT32:  *out = *(const UA_Int32*)v->data;  return true;
+    case UA_DATATYPEKIND_UINT32: *out = *(const UA_UInt32*)v->data; return true;
+    case UA_DATATYPEKIND_INT64:  *out = (UA_Double)*(const UA_Int64*)v->data;  return true;
+    case UA_DATATYPEKIND_UINT64: *out = (UA_Double)*(const UA_UInt64*)v->data; return true;
+    case UA_DATATYPEKIND_FLOAT:  *out = *(const UA_Float*)v->data;  return true;
+    case UA_DATATYPEKIND_DOUBLE: *out = *(const UA_Double*)v->data; return true;
+    default: return false;
+    }
+}
+
+/* Load the limits into the condition and watch the limit properties for
+ * changes */
+static UA_LimitAlarm *
+getLimitAlarm(UA_Server *server, UA_Condition *cond) {
     UA_LOCK_ASSERT(&server->serviceMutex);
-    UA_Variant value;
-    UA_StatusCode retval =
-        readObjectProperty(server, conditionId,
-                           UA_QUALIFIEDNAME(0, CONDITION_FIELD_LOWLIMIT), &value);
-    *lowLimit = *(UA_Double*) value.data;
-    return retval;
+    if(cond->limitAlarm)
+        return cond->limitAlarm;
+
+    UA_LimitAlarm *la = (UA_LimitAlarm*)UA_calloc(1, sizeof(UA_LimitAlarm));
+    if(!la)
+        return NULL;
+    la->watches[UA_LIMITALARM_INPUT].condition = cond;
+    la->watches[UA_LIMITALARM_INPUT].target = UA_LIMITALARM_INPUT;
+
+    const UA_QualifiedName *limitNames[UA_LIMITS];
+    limitNames[UA_LIMIT_HIGHHIGH] = &fieldHighHighLimitQN;
+    limitNames[UA_LIMIT_HIGH] = &fieldHighLimitQN;
+    limitNames[UA_LIMIT_LOWLOW] = &fieldLowLowLimitQN;
+    limitNames[UA_LIMIT_LOW] = &fieldLowLimitQN;
+    for(UA_Byte i = 0; i < UA_LIMITS; i++) {
+        UA_ConditionWatch *w = &la->watches[i];
+        w->condition = cond;
+        w->target = i;
+        if(getConditionFieldNodeId(server, &cond->conditionId, limitNames[i],
+                                   &w->nodeId) != UA_STATUSCODE_GOOD)
+            continue; /* The optional limit does not exist */
+        UA_Variant v;
+        if(readWithReadValue(server, &w->nodeId, UA_ATTRIBUTEID_VALUE,
+                             &v) == UA_STATUSCODE_GOOD) {
+            if(getLimitValue(&v, &la->limits[i]))
+                la->limitsSet |= (UA_Byte)(1 << i);
+            UA_Variant_clear(&v);
+        }
+        ZIP_INSERT(UA_ConditionWatchTree, &server->conditionWatchTree, w);
+        w->linked = true;
+    }
+
+    cond->limitAlarm = la;
+    return la;
 }
 
-static UA_StatusCode
-getLowLowLimit(UA_Server *server, UA_NodeId conditionId, UA_Double *lowLowLimit) {
-    UA_LOCK_ASSERT(&server->serviceMutex);
-    UA_Variant value;
-    UA_StatusCode retval =
-        readObjectProperty(server, conditionId,
-                           UA_QUALIFIEDNAME(0, CONDITION_FIELD_LOWLOWLIMIT), &value);
-    *lowLowLimit = *(UA_Double*) value.data;
-    return retval;
+static UA_ActiveState
+evaluateLimits(const UA_LimitAlarm *la, UA_Double value) {
+    if((la->limitsSet & (1 << UA_LIMIT_HIGHHIGH)) && value >= la->limits[UA_LIMIT_HIGHHIGH])
+        return UA_ACTIVE_HIGHHIGH;
+    if((la->limitsSet & (1 << UA_LIMIT_HIGH)) && value >= la->limits[UA_LIMIT_HIGH])
+        return UA_ACTIVE_HIGH;
+    if((la->limitsSet & (1 << UA_LIMIT_LOWLOW)) && value <= la->limits[UA_LIMIT_LOWLOW])
+        return UA_ACTIVE_LOWLOW;
+    if((la->limitsSet & (1 << UA_LIMIT_LOW)) && value <= la->limits[UA_LIMIT_LOW])
+        return UA_ACTIVE_LOW;
+    return UA_INACTIVE;
 }
 
 static UA_StatusCode
-getHighLimit(UA_Server *server, UA_NodeId conditionId, UA_Double *highLimit) {
+writeLimitState(UA_Server *server, const UA_NodeId *conditionId,
+                UA_ActiveState state, const UA_NodeId *limitId) {
     UA_LOCK_ASSERT(&server->serviceMutex);
+
+    UA_NodeId limitState;
+    UA_StatusCode retval = getConditionFieldNodeId(server, conditionId,
+                                                   &fieldLimitStateQN, &limitState);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
+    UA_LocalizedText text = UA_LOCALIZEDTEXT(LOCALE_NULL, TEXT_NULL);
+    switch(state) {
+    case UA_ACTIVE_HIGHHIGH: text = UA_LOCALIZEDTEXT(LOCALE, ACTIVE_HIGHHIGH_TEXT); break;
+    case UA_ACTIVE_HIGH:     text = UA_LOCALIZEDTEXT(LOCALE, ACTIVE_HIGH_TEXT); break;
+    case UA_ACTIVE_LOWLOW:   text = UA_LOCALIZEDTEXT(LOCALE, ACTIVE_LOWLOW_TEXT); break;
+    case UA_ACTIVE_LOW:      text = UA_LOCALIZEDTEXT(LOCALE, ACTIVE_LOW_TEXT); break;
+    default: break;
+    }
+
     UA_Variant value;
-    UA_StatusCode retval =
-        readObjectProperty(server, conditionId,
-                           UA_QUALIFIEDNAME(0, CONDITION_FIELD_HIGHLIMIT), &value);
-    *highLimit = *(UA_Double*) value.data;
+    UA_Variant_setScalar(&value, &text, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+    retval = setConditionField(server, limitState, &value, fieldCurrentStateQN);
+    UA_Variant_setScalar(&value, (void*)(uintptr_t)limitId, &UA_TYPES[UA_TYPES_NODEID]);
+    retval |= setConditionVariableFieldProperty(server, limitState, &value,
+                                                fieldCurrentStateQN,
+                                                twoStateVariableIdQN);
+    UA_NodeId_clear(&limitState);
     return retval;
 }
 
+/* Evaluate the limit alarm for the value. The fields are only written if the
+ * LimitState changes. With triggerEvents, the transition also sets the
+ * ActiveState and emits an event for the condition. */
 static UA_StatusCode
-getHighHighLimit(UA_Server *server, UA_NodeId conditionId, UA_Double *highHighLimit) {
+evaluateLimitAlarm(UA_Server *server, UA_Condition *cond, UA_Double value,
+                   UA_Boolean triggerEvents) {
     UA_LOCK_ASSERT(&server->serviceMutex);
-    UA_Variant value;
-    UA_StatusCode retval =
-        readObjectProperty(server, conditionId,
-                           UA_QUALIFIEDNAME(0, CONDITION_FIELD_HIGHHIGHLIMIT), &value);
-    *highHighLimit = *(UA_Double*) value.data;
-    return retval;
+
+    UA_LimitAlarm *la = getLimitAlarm(server, cond);
+    if(!la)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    la->lastValue = value;
+    UA_ActiveState state = evaluateLimits(la, value);
+    UA_Boolean evaluated = la->evaluated;
+    UA_ActiveState lastState = la->state;
+    if(evaluated && state == lastState)
+        return UA_STATUSCODE_GOOD; /* No transition */
+    la->state = state;
+    la->evaluated = true;
+
+    /* Copy the NodeIds. The condition can be deleted while the callbacks of
+     * the written fields are running. */
+    UA_NodeId conditionId, sourceId, limitId;
+    UA_NodeId_init(&limitId);
+    UA_StatusCode res = UA_NodeId_copy(&cond->conditionId, &conditionId);
+    res |= UA_NodeId_copy(&cond->source->conditionSourceId, &sourceId);
+    switch(state) {
+    case UA_ACTIVE_HIGHHIGH:
+        res |= UA_NodeId_copy(&la->watches[UA_LIMIT_HIGHHIGH].nodeId, &limitId); break;
+    case UA_ACTIVE_HIGH:
+        res |= UA_NodeId_copy(&la->watches[UA_LIMIT_HIGH].nodeId, &limitId); break;
+    case UA_ACTIVE_LOWLOW:
+        res |= UA_NodeId_copy(&la->watches[UA_LIMIT_LOWLOW].nodeId, &limitId); break;
+    case UA_ACTIVE_LOW:
+        res |= UA_NodeId_copy(&la->watches[UA_LIMIT_LOW].nodeId, &limitId); break;
+    default: break;
+    }
+    if(res != UA_STATUSCODE_GOOD)
+        goto cleanup;
+
+    res = writeLimitState(server, &conditionId, state, &limitId);
+    if(res != UA_STATUSCODE_GOOD || !triggerEvents)
+        goto cleanup;
+
+    /* The ActiveState/Id callback emits the event when the alarm becomes
+     * active. All other transitions emit the event here. */
+    UA_Boolean active = (state != UA_INACTIVE);
+    UA_Boolean wasActive = (evaluated && lastState != UA_INACTIVE);
+    if(active != wasActive) {
+        UA_Variant v;
+        UA_Variant_setScalar(&v, &active, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        res = setConditionVariableFieldProperty(server, conditionId, &v,
+                                                fieldActiveStateQN, twoStateVariableIdQN);
+        if(res != UA_STATUSCODE_GOOD || active)
+            goto cleanup;
+    }
+    if((active || evaluated) &&
+       isTwoStateVariableInTrueState(server, &conditionId, &fieldEnabledStateQN))
+        res = triggerConditionEvent(server, conditionId, sourceId, NULL);
+
+ cleanup:
+    UA_NodeId_clear(&conditionId);
+    UA_NodeId_clear(&sourceId);
+    UA_NodeId_clear(&limitId);
+    return res;
 }
 
 static UA_StatusCode
 setLimitState(UA_Server *server, const UA_NodeId conditionId,
               UA_Double limitValue) {
     UA_LOCK_ASSERT(&server->serviceMutex);
+    UA_Condition *cond = getConditionById(server, &conditionId);
+    if(!cond)
+        return UA_STATUSCODE_BADNOTFOUND;
+    return evaluateLimitAlarm(server, cond, limitValue, false);
+}
 
-    UA_NodeId limitState;
-    UA_Double lowLowLimit;
-    UA_Double lowLimit;
-    UA_Double highLimit;
-    UA_Double highHighLimit;
-    UA_Variant value;
-    UA_QualifiedName currentStateField = UA_QUALIFIEDNAME(0,"CurrentState");
-    UA_QualifiedName currentStateIdField = UA_QUALIFIEDNAME(0,"Id");
-    UA_StatusCode retval = getConditionFieldNodeId(server, &conditionId,
-                                                   &fieldLimitStateQN, &limitState);
+typedef struct {
+    UA_Double value;
+    UA_NodeId *conditions; /* Conditions with the node as input */
+    size_t conditionsSize;
+} WatchContext;
 
-    retval |= getHighHighLimit(server, conditionId, &highHighLimit);
-    if(retval == UA_STATUSCODE_GOOD) {
-        if(limitValue >= highHighLimit) {
-            UA_NodeId highHighLimitId;
-            retval |= getConditionFieldNodeId(server, &conditionId,
-                                              &fieldHighHighLimitQN, &highHighLimitId);
-            UA_LocalizedText text = UA_LOCALIZEDTEXT(LOCALE, ACTIVE_HIGHHIGH_TEXT);
-            UA_Variant_setScalar(&value, &text, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
-            retval |= setConditionField(server, limitState, &value, currentStateField);
-            UA_Variant_setScalar(&value, &highHighLimitId, &UA_TYPES[UA_TYPES_NODEID]);
-            retval |= setConditionVariableFieldProperty(server, limitState, &value,
-                                                        currentStateField, currentStateIdField);
-            return retval;
-        }
-    }
+static void *
+collectWatch(void *context, UA_ConditionWatch *w) {
+    WatchContext *ctx = (WatchContext*)context;
+    UA_Condition *cond = w->condition;
+    if(w->target < UA_LIMITS) {
+        /* Update the cached limit. Reevaluate with the last input value. */
+        UA_LimitAlarm *la = cond->limitAlarm;
+        la->limits[w->target] = ctx->value;
+        la->limitsSet |= (UA_Byte)(1 << w->target);
+        if(!la->watches[UA_LIMITALARM_INPUT].linked)
+            return NULL;
+    }
+    UA_StatusCode res =
+        UA_Array_appendCopy((void**)&ctx->conditions, &ctx->conditionsSize,
+                            &cond->conditionId, &UA_TYPES[UA_TYPES_NODEID]);
+    (void)res; /* The alarm is not evaluated if out of memory */
+    return NULL;
+}
 
-    retval |= getHighLimit(server, conditionId, &highLimit);
-    if(retval == UA_STATUSCODE_GOOD) {
-        if(limitValue >= highLimit) {
-            UA_NodeId highLimitId;
-            retval |= getConditionFieldNodeId(server, &conditionId, &fieldHighLimitQN, &highLimitId);
-            UA_LocalizedText text = UA_LOCALIZEDTEXT(LOCALE, ACTIVE_HIGH_TEXT);
-            UA_Variant_setScalar(&value, &text, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
-            retval |= setConditionField(server, limitState, &value, currentStateField);
+static void
+evaluateWatches(UA_Server *server, const UA_NodeId *nodeId, UA_Double value) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
 
-            UA_Variant_setScalar(&value, &highLimitId, &UA_TYPES[UA_TYPES_NODEID]);
-            retval |= setConditionVariableFieldProperty(server, limitState, &value,
-                                                        currentStateField,
-                                                        currentStateIdField);
-            return retval;
+    /* Collect the affected conditions first. Writing the fields of one
+     * condition runs callbacks that can modify the index. */
+    WatchContext ctx;
+    memset(&ctx, 0, sizeof(WatchContext));
+    ctx.value = value;
+    ZIP_ITER_KEY(UA_ConditionWatchTree, &server->conditionWatchTree,
+                 nodeId, collectWatch, &ctx);
+
+    for(size_t i = 0; i < ctx.conditionsSize; i++) {
+        UA_Condition *cond = getConditionById(server, &ctx.conditions[i]);
+        if(!cond || !cond->limitAlarm)
+            continue;
+        UA_LimitAlarm *la = cond->limitAlarm;
+        UA_Double input = value;
+        if(!UA_NodeId_equal(&la->watches[UA_LIMITALARM_INPUT].nodeId, nodeId)) {
+            if(!la->evaluated)
+                continue; /* No input value yet */
+            input = la->lastValue;
         }
+        evaluateLimitAlarm(server, cond, input, true);
     }
+    UA_Array_delete(ctx.conditions, ctx.conditionsSize, &UA_TYPES[UA_TYPES_NODEID]);
+}
 
-    retval |= getLowLowLimit(server, conditionId, &lowLowLimit);
-    if(retval == UA_STATUSCODE_GOOD) {
-        if(limitValue <= lowLowLimit) {
-            UA_NodeId lowLowLimitId;
-            retval |= getConditionFieldNodeId(server, &conditionId,
-                                              &fieldLowLowLimitQN, &lowLowLimitId);
-            UA_LocalizedText text = UA_LOCALIZEDTEXT(LOCALE, ACTIVE_LOWLOW_TEXT);
-            UA_Variant_setScalar(&value, &text, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
-            retval |= setConditionField(server, limitState, &value, currentStateField);
-            UA_Variant_setScalar(&value, &lowLowLimitId, &UA_TYPES[UA_TYPES_NODEID]);
-            retval |= setConditionVariableFieldProperty(server, limitState, &value,
-                                                        currentStateField,
-                                                        currentStateIdField);
-            return retval;
-        }
+void
+UA_ConditionList_afterWrite(UA_Server *server, const UA_NodeId *nodeId,
+                            const UA_Variant *value) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+    UA_Double d;
+    if(!ZIP_FIND(UA_ConditionWatchTree, &server->conditionWatchTree, nodeId) ||
+       !getLimitValue(value, &d))
+        return;
+    evaluateWatches(server, nodeId, d);
+}
+
+UA_StatusCode
+UA_Server_setLimitAlarmInput(UA_Server *server, const UA_NodeId conditionId,
+                             const UA_NodeId inputNode) {
+    UA_LOCK(&server->serviceMutex);
+    UA_Condition *cond = getConditionById(server, &conditionId);
+    if(!cond) {
+        UA_UNLOCK(&server->serviceMutex);
+        return UA_STATUSCODE_BADNOTFOUND;
+    }
+    UA_LimitAlarm *la = getLimitAlarm(server, cond);
+    if(!la) {
+        UA_UNLOCK(&server->serviceMutex);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
     }
 
-    retval |= getLowLimit(server, conditionId, &lowLimit);
-    if(retval == UA_STATUSCODE_GOOD) {
-        if(limitValue <= lowLimit) {
-            UA_NodeId lowLimitId;
-            retval |= getConditionFieldNodeId(server, &conditionId, &fieldLowLimitQN, &lowLimitId);
-            UA_LocalizedText text = UA_LOCALIZEDTEXT(LOCALE, ACTIVE_LOW_TEXT);
-            UA_Variant_setScalar(&value, &text, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
-            retval |= setConditionField(server, limitState, &value, currentStateField);
-            UA_Variant_setScalar(&value, &lowLimitId, &UA_TYPES[UA_TYPES_NODEID]);
-            retval |= setConditionVariableFieldProperty(server, limitState, &value,
-                                                        currentStateField,
-                                                        currentStateIdField);
-            return retval;
+    /* Replace the watch of the input node */
+    UA_ConditionWatch *w = &la->watches[UA_LIMITALARM_INPUT];
+    if(w->linked) {
+        ZIP_REMOVE(UA_ConditionWatchTree, &server->conditionWatchTree, w);
+        w->linked = false;
+    }
+    UA_NodeId_clear(&w->nodeId);
+    la->evaluated = false;
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    if(!UA_NodeId_isNull(&inputNode)) {
+        res = UA_NodeId_copy(&inputNode, &w->nodeId);
+        if(res == UA_STATUSCODE_GOOD) {
+            ZIP_INSERT(UA_ConditionWatchTree, &server->conditionWatchTree, w);
+            w->linked = true;
         }
     }
 
-    UA_LocalizedText textNull = UA_LOCALIZEDTEXT(LOCALE_NULL, TEXT_NULL);
-    UA_Variant_setScalar(&value, &textNull, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
-    retval |= setConditionField(server, limitState, &value, currentStateField);
+    /* Expose the input in the InputNode property */
+    if(res == UA_STATUSCODE_GOOD) {
+        UA_Variant v;
+        UA_Variant_setScalar(&v, (void*)(uintptr_t)&inputNode, &UA_TYPES[UA_TYPES_NODEID]);
+        res = setConditionField(server, conditionId, &v, fieldInputNodeQN);
+    }
+    UA_UNLOCK(&server->serviceMutex);
+    return res;
+}
 
-    UA_NodeId nodeIdNull = UA_NODEID_NULL;
-    UA_Variant_setScalar(&value, &nodeIdNull, &UA_TYPES[UA_TYPES_NODEID]);
-    retval |= setConditionVariableFieldProperty(server, limitState, &value,
-                                                currentStateField,
-                                                currentStateIdField);
-    return retval;
+void
+UA_Server_evaluateLimitAlarms(UA_Server *server, size_t samplesSize,
+                              const UA_NodeId *inputNodes, const UA_Double *samples) {
+    UA_LOCK(&server->serviceMutex);
+    for(size_t i = 0; i < samplesSize; i++)
+        evaluateWatches(server, &inputNodes[i], samples[i]);
+    UA_UNLOCK(&server->serviceMutex);
 }
 
 UA_StatusCode
@@ -51,6 +51,27 @@ detectScalarDeadBand(const void *data1, const void *data2,
     }
 }
 
+/* Test arrays in blocks without branching inside the block. This lets the
+ * compiler vectorize the inner loop for the common numeric types. */
+#define UA_DEADBAND_BLOCK 64
+#define UA_DETECT_ARRAY_DEADBAND(TYPE) do {                             \
+    const TYPE *a1 = (const TYPE*)value->data;                          \
+    const TYPE *a2 = (const TYPE*)oldValue->data;                       \
+    for(size_t i = 0; i < length; i += UA_DEADBAND_BLOCK) {             \
+        size_t end = (length - i < UA_DEADBAND_BLOCK) ?                 \
+            length : i + UA_DEADBAND_BLOCK;                             \
+        int changed = 0;                                                \
+        for(size_t j = i; j < end; j++) {                               \
+            TYPE diff = (a1[j] > a2[j]) ?                               \
+                (TYPE)(a1[j] - a2[j]) : (TYPE)(a2[j] - a1[j]);          \
+            changed |= ((UA_Double)diff > deadbandValue);               \
+        }                                                               \
+        if(changed)                                                     \
+            return true;                                                \
+    }                                                                   \
+    return false;                                                       \
+} while(false);
+
 static UA_Boolean
 detectVariantDeadband(const UA_Variant *value, const UA_Variant *oldValue,
                       const UA_Double deadbandValue) {
@@ -61,6 +82,19 @@ detectVariantDeadband(const UA_Variant *value, const UA_Variant *oldValue,
     size_t length = 1;
     if(!UA_Variant_isScalar(value))
         length = value->arrayLength;
+
+    /* Vectorizable path for arrays of the common numeric types */
+    if(length > 1) {
+        switch(value->type->typeKind) {
+        case UA_DATATYPEKIND_DOUBLE: UA_DETECT_ARRAY_DEADBAND(UA_Double);
+        case UA_DATATYPEKIND_FLOAT:  UA_DETECT_ARRAY_DEADBAND(UA_Float);
+        case UA_DATATYPEKIND_INT32:  UA_DETECT_ARRAY_DEADBAND(UA_Int32);
+        case UA_DATATYPEKIND_UINT16: UA_DETECT_ARRAY_DEADBAND(UA_UInt16);
+        case UA_DATATYPEKIND_INT16:  UA_DETECT_ARRAY_DEADBAND(UA_Int16);
+        default: break;
+        }
+    }
+
     uintptr_t data = (uintptr_t)value->data;
     uintptr_t oldData = (uintptr_t)oldValue->data;
     UA_UInt32 memSize = value->type->memSize;
@@ -74,8 +108,56 @@ detectVariantDeadband(const UA_Variant *value, const UA_Variant *oldValue,
     return false;
 }
 
+/* Large values are not kept in the MonitoredItem. Only their hash is used for
+ * the change detection. Returns false if the value is not hashed. */
 static UA_Boolean
-detectValueChange(UA_Server *server, UA_MonitoredItem *mon, const UA_DataValue *dv) {
+hashSampledValue(UA_Server *server, const UA_MonitoredItem *mon,
+                 const UA_DataValue *dv, UA_UInt64 *hash) {
+    UA_UInt32 threshold = server->config.monitoredItemHashThreshold;
+    if(threshold == 0 || !dv->hasValue || !dv->value.type)
+        return false;
+
+    /* The deadband filter needs the last value */
+    const UA_ExtensionObject *filter = &mon->parameters.filter;
+    if(filter->content.decoded.type == &UA_TYPES[UA_TYPES_DATACHANGEFILTER] &&
+       ((const UA_DataChangeFilter*)filter->content.decoded.data)->deadbandType !=
+       UA_DEADBANDTYPE_NONE)
+        return false;
+
+    /* Hash the memory of pointer-free arrays and of strings */
+    const UA_Variant *v = &dv->value;
+    const void *data;
+    size_t size;
+    if(UA_Variant_isScalar(v)) {
+        if(v->type->typeKind != UA_DATATYPEKIND_STRING &&
+           v->type->typeKind != UA_DATATYPEKIND_BYTESTRING &&
+           v->type->typeKind != UA_DATATYPEKIND_XMLELEMENT)
+            return false;
+        const UA_String *str = (const UA_String*)v->data;
+        data = str->data;
+        size = str->length;
+    } else {
+        if(!v->type->pointerFree)
+            return false;
+        data = v->data;
+        size = v->arrayLength * v->type->memSize;
+    }
+    if(size < threshold)
+        return false;
+
+    UA_UInt64 h = UA_hash64((UA_UInt64)(uintptr_t)v->type,
+                            &v->arrayLength, sizeof(size_t));
+    h = UA_hash64(h, data, size);
+    if(v->arrayDimensionsSize > 0)
+        h = UA_hash64(h, v->arrayDimensions,
+                      v->arrayDimensionsSize * sizeof(UA_UInt32));
+    *hash = h;
+    return true;
+}
+
+static UA_Boolean
+detectValueChange(UA_Server *server, UA_MonitoredItem *mon,
+                  const UA_DataValue *dv, const UA_UInt64 *hash) {
     UA_LOCK_ASSERT(&server->serviceMutex);
 
     /* Status changes are always reported */
@@ -120,34 +202,82 @@ detectValueChange(UA_Server *server, UA_MonitoredItem *mon, const UA_DataValue *
     /* Has the value changed? */
     if(dv->hasValue != mon->lastValue.hasValue)
         return true;
+    if(hash || mon->lastValueHashed)
+        return (!hash || !mon->lastValueHashed || *hash != mon->lastValueHash);
     return !UA_equal(&dv->value, &mon->lastValue.value,
                      &UA_TYPES[UA_TYPES_VARIANT]);
 }
 
-UA_StatusCode
-UA_MonitoredItem_createDataChangeNotification(UA_Server *server, UA_MonitoredItem *mon,
-                                              const UA_DataValue *dv) {
-    /* Copy the value */
-    UA_DataValue valueCopy;
-    UA_StatusCode retval = UA_DataValue_copy(dv, &valueCopy);
-    if(retval != UA_STATUSCODE_GOOD)
-        return retval;
+/* Takes ownership of the value. It is cleared if the notification cannot be
+ * created. */
+static UA_StatusCode
+enqueueDataChangeNotification(UA_Server *server, UA_MonitoredItem *mon,
+                              UA_DataValue *value) {
+    /* The queue is full. Reuse the notification that would be discarded. */
+    if(UA_Notification_recycleAndTrigger(server, mon, value))
+        return UA_STATUSCODE_GOOD;
 
     /* Allocate a new notification */
-    UA_Notification *n = UA_Notification_new();
+    UA_Notification *n = UA_Notification_new(server);
     if(!n) {
-        UA_DataValue_clear(&valueCopy);
+        UA_DataValue_clear(value);
         return UA_STATUSCODE_BADOUTOFMEMORY;
     }
 
     /* Prepare and enqueue the notification */
     n->mon = mon;
-    n->data.dataChange.value = valueCopy;
+    n->data.dataChange.value = *value;
     n->data.dataChange.clientHandle = mon->parameters.clientHandle;
     UA_Notification_enqueueAndTrigger(server, n);
     return UA_STATUSCODE_GOOD;
 }
 
+UA_StatusCode
+UA_MonitoredItem_createDataChangeNotification(UA_Server *server, UA_MonitoredItem *mon,
+                                              const UA_DataValue *dv) {
+    /* Copy the value */
+    UA_DataValue valueCopy;
+    UA_StatusCode retval = UA_DataValue_copy(dv, &valueCopy);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    return enqueueDataChangeNotification(server, mon, &valueCopy);
+}
+
+/* The value has changed. Store the value and move the sample into the
+ * notification. */
+static void
+processChangedValue(UA_Server *server, UA_MonitoredItem *mon,
+                    UA_DataValue *value, UA_Boolean hashed, UA_UInt64 hash) {
+    /* Store the value for filter comparison and TransferSubscription. Keep
+     * only the hash of large values. Otherwise copy into the last value. For
+     * pointer-free scalars this reuses the memory without an allocation. */
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    mon->lastValueHashed = hashed;
+    mon->lastValueHash = hash;
+    if(hashed) {
+        UA_DataValue_clear(&mon->lastValue);
+        mon->lastValue = *value;
+        UA_Variant_init(&mon->lastValue.value);
+    } else {
+        res = UA_DataValue_copyReuse(value, &mon->lastValue);
+    }
+
+    /* Move the sample into the notification and enqueue it */
+    if(res == UA_STATUSCODE_GOOD)
+        res = enqueueDataChangeNotification(server, mon, value);
+    else
+        UA_DataValue_clear(value);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_LOG_WARNING_SUBSCRIPTION(server->config.logging, mon->subscription,
+                                    "MonitoredItem %" PRIi32 " | "
+                                    "Processing the sample returned the statuscode %s",
+                                    mon->monitoredItemId, UA_StatusCode_name(res));
+        /* Forget the last value. The next sample is detected as a change. */
+        UA_DataValue_clear(&mon->lastValue);
+        mon->lastValueHashed = false;
+    }
+}
+
 void
 UA_MonitoredItem_processSampledValue(UA_Server *server, UA_MonitoredItem *mon,
                                      UA_DataValue *value) {
@@ -155,7 +285,10 @@ UA_MonitoredItem_processSampledValue(UA_Server *server, UA_MonitoredItem *mon,
     UA_LOCK_ASSERT(&server->serviceMutex);
 
     /* Has the value changed (with the filters applied)? */
-    UA_Boolean changed = detectValueChange(server, mon, value);
+    UA_UInt64 hash = 0;
+    UA_Boolean hashed = hashSampledValue(server, mon, value, &hash);
+    UA_Boolean changed = detectValueChange(server, mon, value,
+                                           (hashed) ? &hash : NULL);
     if(!changed) {
         UA_LOG_DEBUG_SUBSCRIPTION(server->config.logging, mon->subscription,
                                   "MonitoredItem %" PRIi32 " | "
@@ -164,21 +297,7 @@ UA_MonitoredItem_processSampledValue(UA_Server *server, UA_MonitoredItem *mon,
         return;
     }
 
-    /* Prepare a notification and enqueue it */
-    UA_StatusCode res =
-        UA_MonitoredItem_createDataChangeNotification(server, mon, value);
-    if(res != UA_STATUSCODE_GOOD) {
-        UA_LOG_WARNING_SUBSCRIPTION(server->config.logging, mon->subscription,
-                                    "MonitoredItem %" PRIi32 " | "
-                                    "Processing the sample returned the statuscode %s",
-                                    mon->monitoredItemId, UA_StatusCode_name(res));
-        UA_DataValue_clear(value);
-        return;
-    }
-
-    /* Move/store the value for filter comparison and TransferSubscription */
-    UA_DataValue_clear(&mon->lastValue);
-    mon->lastValue = *value;
+    processChangedValue(server, mon, value, hashed, hash);
 }
 
 void
@@ -201,4 +320,163 @@ UA_MonitoredItem_sample(UA_Server *server, UA_MonitoredItem *mon) {
     UA_MonitoredItem_processSampledValue(server, mon, &dv);
 }
 
+/* Get the numeric scalar as a double. Only for the types that convert
+ * without loss of precision. */
+static UA_Boolean
+getDeadbandScalar(const UA_Variant *v, UA_Double *out) {
+    if(!v->type || !UA_Variant_isScalar(v))
+        return false;
+    switch(v->type->typeKind) {
+    case UA_DATATYPEKIND_SBYTE:  *out = *(const UA_SByte*)v->data;  return true;
+    case UA_DATATYPEKIND_BYTE:   *out = *(const UA_Byte*)v->data;   return true;
+    case UA_DATATYPEKIND_INT16:  *out = *(const UA_Int16*)v->data;  return true;
+    case UA_DATATYPEKIND_UINT16: *out = *(const UA_UInt16*)v->data; return true;
+    case UA_DATATYPEKIND_INT32:  *out = *(const UA_Int32*)v->data;  return true;
+    case UA_DATATYPEKIND_UINT32: *out = *(const UA_UInt32*)v->data; return true;
+    case UA_DATATYPEKIND_FLOAT:  *out = *(const UA_Float*)v->data;  return true;
+    case UA_DATATYPEKIND_DOUBLE: *out = *(const UA_Double*)v->data; return true;
+    default: return false;
+    }
+}
+
+/* Can the sample be decided by the absolute deadband alone? This is the case
+ * if the status is unchanged and both the sample and the last value are
+ * numeric scalars of the same type. */
+static UA_Boolean
+getDeadbandInput(const UA_MonitoredItem *mon, const UA_DataValue *dv,
+                 UA_Double *value, UA_Double *lastValue, UA_Double *deadband) {
+    const UA_ExtensionObject *filter = &mon->parameters.filter;
+    if(filter->content.decoded.type != &UA_TYPES[UA_TYPES_DATACHANGEFILTER])
+        return false;
+    const UA_DataChangeFilter *dcf = (const UA_DataChangeFilter*)
+        filter->content.decoded.data;
+    if(dcf->deadbandType != UA_DEADBANDTYPE_ABSOLUTE ||
+       dcf->trigger == UA_DATACHANGETRIGGER_STATUS)
+        return false;
+    if(dv->hasStatus != mon->lastValue.hasStatus ||
+       dv->status != mon->lastValue.status)
+        return false;
+    if(dv->value.type != mon->lastValue.value.type)
+        return false;
+    if(!getDeadbandScalar(&dv->value, value) ||
+       !getDeadbandScalar(&mon->lastValue.value, lastValue))
+        return false;
+    *deadband = dcf->deadbandValue;
+    return true;
+}
+
+/* The shared flag is a hint from the SamplingGroup. The ReadValueId is still
+ * compared as the MonitoredItems might have been removed from the group while
+ * sampling. */
+static UA_Boolean
+isSharedSample(const UA_MonitoredItem *mon, const UA_MonitoredItem *next) {
+    return (next->samplingType == UA_MONITOREDITEMSAMPLINGTYPE_CYCLIC &&
+            next->sampling.cyclic.shared &&
+            next->timestampsToReturn == mon->timestampsToReturn &&
+            UA_order(&next->itemToMonitor, &mon->itemToMonitor,
+                     &UA_TYPES[UA_TYPES_READVALUEID]) == UA_ORDER_EQ);
+}
+
+void
+UA_MonitoredItem_sampleBatch(UA_Server *server, UA_MonitoredItem **mons,
+                             size_t monsSize) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+    UA_assert(monsSize <= UA_SAMPLING_BATCHSIZE);
+
+    /* Sample the current values. Runs of MonitoredItems with the same
+     * ReadValueId are read together. The SamplingGroups keep them next to each
+     * other. */
+    UA_DataValue dvs[UA_SAMPLING_BATCHSIZE];
+    UA_Session *sessions[UA_SAMPLING_BATCHSIZE];
+    for(size_t i = 0; i < monsSize; i++) {
+        UA_MonitoredItem *mon = mons[i];
+        UA_assert(mon->itemToMonitor.attributeId != UA_ATTRIBUTEID_EVENTNOTIFIER);
+        UA_Subscription *sub = mon->subscription;
+        sessions[i] = (sub) ? sub->session : &server->adminSession;
+        UA_DataValue_init(&dvs[i]);
+    }
+    UA_DataSourceBatch batch;
+    memset(&batch, 0, sizeof(UA_DataSourceBatch));
+    for(size_t i = 0; i < monsSize;) {
+        const UA_MonitoredItem *mon = mons[i];
+        size_t n = 1;
+        while(i + n < monsSize && isSharedSample(mon, mons[i + n]))
+            n++;
+        if(n == 1 && server->dataSourceBatchRead && sessions[i]) {
+            /* Collect the reads of DataSources with a batch callback */
+            const UA_Node *node =
+                UA_NODESTORE_GET_SELECTIVE(server, &mon->itemToMonitor.nodeId,
+                                           UA_NODEATTRIBUTESMASK_VALUE,
+                                           UA_REFERENCETYPESET_NONE,
+                                           UA_BROWSEDIRECTION_INVALID);
+            if(deferDataSourceRead(server, &batch, sessions[i], node,
+                                   &mon->itemToMonitor, mon->timestampsToReturn,
+                                   &dvs[i])) {
+                i++;
+                continue;
+            }
+            if(node)
+                UA_NODESTORE_RELEASE(server, node);
+        }
+        if(n == 1)
+            dvs[i] = readWithSession(server, sessions[i], &mon->itemToMonitor,
+                                     mon->timestampsToReturn);
+        else
+            readShared(server, &mon->itemToMonitor, mon->timestampsToReturn,
+                       n, &sessions[i], &dvs[i]);
+        i += n;
+    }
+    readDataSourceBatch(server, &batch);
+    UA_MonitoredItem_processSampleBatch(server, mons, dvs, monsSize);
+}
+
+void
+UA_MonitoredItem_processSampleBatch(UA_Server *server, UA_MonitoredItem **mons,
+                                    UA_DataValue *dvs, size_t monsSize) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+    UA_assert(monsSize <= UA_SAMPLING_BATCHSIZE);
+
+    /* Collect the samples that are decided by the deadband alone */
+    UA_Double values[UA_SAMPLING_BATCHSIZE];
+    UA_Double lastValues[UA_SAMPLING_BATCHSIZE];
+    UA_Double deadbands[UA_SAMPLING_BATCHSIZE];
+    size_t deadbandIndex[UA_SAMPLING_BATCHSIZE];
+    size_t deadbandSize = 0;
+    for(size_t i = 0; i < monsSize; i++) {
+        if(getDeadbandInput(mons[i], &dvs[i], &values[deadbandSize],
+                            &lastValues[deadbandSize], &deadbands[deadbandSize]))
+            deadbandIndex[deadbandSize++] = i;
+    }
+
+    /* Evaluate the deadbands in one branch-free pass that the compiler can
+     * vectorize. NaN differences do not exceed the deadband. This is the same
+     * as in detectScalarDeadBand. */
+    UA_Byte exceeded[UA_SAMPLING_BATCHSIZE];
+    for(size_t j = 0; j < deadbandSize; j++) {
+        UA_Double diff = values[j] - lastValues[j];
+        diff = (diff < 0.0) ? -diff : diff;
+        exceeded[j] = (diff > deadbands[j]);
+    }
+
+    /* Process the samples. The MonitoredItems might have been removed while
+     * the values were read. They are freed only in a delayed callback. */
+    size_t j = 0;
+    for(size_t i = 0; i < monsSize; i++) {
+        UA_MonitoredItem *mon = mons[i];
+        UA_Boolean decided = (j < deadbandSize && deadbandIndex[j] == i);
+        UA_Boolean changed = (decided && exceeded[j]);
+        if(decided)
+            j++;
+        if(mon->samplingType == UA_MONITOREDITEMSAMPLINGTYPE_NONE ||
+           (decided && !changed)) {
+            UA_DataValue_clear(&dvs[i]);
+            continue;
+        }
+        if(changed)
+            processChangedValue(server, mon, &dvs[i], false, 0);
+        else
+            UA_MonitoredItem_processSampledValue(server, mon, &dvs[i]);
+    }
+}
+
 #endif /* UA_ENABLE_SUBSCRIPTIONS */
@@ -174,10 +174,11 @@ eventSetStandardFields(UA_Server *server, const UA_NodeId *event,
 }
 
 /* Filters an event according to the filter specified by mon and then adds it to
- * mons notification queue */
-UA_StatusCode
-UA_MonitoredItem_addEvent(UA_Server *server, UA_MonitoredItem *mon,
-                          const UA_NodeId *event) {
+ * mons notification queue. The event is either represented as a node or as a
+ * map of flat fields. */
+static UA_StatusCode
+addEvent(UA_Server *server, UA_MonitoredItem *mon, const UA_NodeId *event,
+         const UA_KeyValueMap *eventFields) {
     /* Get the filter */
     if(mon->parameters.filter.content.decoded.type != &UA_TYPES[UA_TYPES_EVENTFILTER])
         return UA_STATUSCODE_BADFILTERNOTALLOWED;
@@ -193,14 +194,15 @@ UA_MonitoredItem_addEvent(UA_Server *server, UA_MonitoredItem *mon,
     UA_EventFieldList values;
     UA_EventFieldList_init(&values);
 
-    UA_EventFilterResult efr; /* FilterResult contains only statuscodes. Ignored
-                               * outside the initial setup/validation. */
-    UA_EventFilterResult_init(&efr);
-
-    /* Evaluate the filter. Return if it doesn't match. */
-    UA_StatusCode ret = filterEvent(server, sub->session, event,
-                                    eventFilter, &values, &efr);
-    UA_EventFilterResult_clear(&efr);
+    /* Evaluate the filter. Return if it doesn't match. The filter cache is
+     * allocated on demand. Without it, the filter is evaluated uncached. */
+    UA_MonitoredItemCold *cold = UA_MonitoredItem_getCold(mon);
+    UA_EventFilterCache *cache = (cold) ? &cold->eventFilterCache : NULL;
+    UA_StatusCode ret = (eventFields) ?
+        filterEventFields(server, sub->session, eventFields, eventFilter,
+                          cache, &values) :
+        filterEvent(server, sub->session, event, eventFilter,
+                    cache, &values);
     if(ret != UA_STATUSCODE_GOOD) {
         UA_EventFieldList_clear(&values);
         if(ret == UA_STATUSCODE_BADNOMATCH)
@@ -209,7 +211,7 @@ UA_MonitoredItem_addEvent(UA_Server *server, UA_MonitoredItem *mon,
     }
 
     /* Allocate memory for the notification */
-    UA_Notification *notification = UA_Notification_new();
+    UA_Notification *notification = UA_Notification_new(server);
     if(!notification) {
         UA_EventFieldList_clear(&values);
         return UA_STATUSCODE_BADOUTOFMEMORY;
@@ -223,10 +225,17 @@ UA_MonitoredItem_addEvent(UA_Server *server, UA_MonitoredItem *mon,
     return UA_STATUSCODE_GOOD;
 }
 
+UA_StatusCode
+UA_MonitoredItem_addEvent(UA_Server *server, UA_MonitoredItem *mon,
+                          const UA_NodeId *event) {
+    return addEvent(server, mon, event, NULL);
+}
+
 #ifdef UA_ENABLE_HISTORIZING
 static void
 setHistoricalEvent(UA_Server *server, const UA_NodeId *origin,
-                   const UA_NodeId *emitNodeId, const UA_NodeId *eventNodeId) {
+                   const UA_NodeId *emitNodeId, const UA_NodeId *eventNodeId,
+                   const UA_KeyValueMap *eventFields) {
     UA_Variant historicalEventFilterValue;
     UA_Variant_init(&historicalEventFilterValue);
 
@@ -259,12 +268,12 @@ setHistoricalEvent(UA_Server *server, const UA_NodeId *origin,
     /* Finally, if found and valid then filter */
     UA_EventFilter *filter = (UA_EventFilter*) historicalEventFilterValue.data;
     UA_EventFieldList efl;
-    UA_EventFilterResult result;
-    retval = filterEvent(server, &server->adminSession, eventNodeId, filter, &efl, &result);
+    retval = (eventFields) ?
+        filterEventFields(server, &server->adminSession, eventFields, filter, NULL, &efl) :
+        filterEvent(server, &server->adminSession, eventNodeId, filter, NULL, &efl);
     if(retval == UA_STATUSCODE_GOOD)
         server->config.historyDatabase.setEvent(server, server->config.historyDatabase.context,
                                                 origin, emitNodeId, filter, &efl);
-    UA_EventFilterResult_clear(&result);
     UA_Variant_clear(&historicalEventFilterValue);
     UA_EventFieldList_clear(&efl);
 }
@@ -282,29 +291,10 @@ static const UA_NodeId isInFolderReferences[2] =
     {{0, UA_NODEIDTYPE_NUMERIC, {UA_NS0ID_ORGANIZES}},
      {0, UA_NODEIDTYPE_NUMERIC, {UA_NS0ID_HASCOMPONENT}}};
 
-UA_StatusCode
-triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
-             const UA_NodeId origin, UA_ByteString *outEventId,
-             const UA_Boolean deleteEventNode) {
-    UA_LOCK_ASSERT(&server->serviceMutex);
-
-    UA_LOG_DEBUG(server->config.logging, UA_LOGCATEGORY_SERVER,
-                 "Events: An event is triggered on node %N", origin);
-
-#ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
-    UA_Boolean isCallerAC = false;
-    if(isConditionOrBranch(server, &eventNodeId, &origin, &isCallerAC)) {
-        if(!isCallerAC) {
-          UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
-                                 "Condition Events: Please use A&C API to trigger Condition Events 0x%08X",
-                                  UA_STATUSCODE_BADINVALIDARGUMENT);
-          return UA_STATUSCODE_BADINVALIDARGUMENT;
-        }
-    }
-#endif /* UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS */
-
+static UA_StatusCode
+checkEventOrigin(UA_Server *server, const UA_NodeId *origin) {
     /* Check that the origin node exists */
-    const UA_Node *originNode = UA_NODESTORE_GET(server, &origin);
+    const UA_Node *originNode = UA_NODESTORE_GET(server, origin);
     if(!originNode) {
         UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_USERLAND,
                      "Origin node for event does not exist.");
@@ -328,26 +318,60 @@ triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
         refTypes = UA_ReferenceTypeSet_union(refTypes, tmpRefTypes);
     }
 
-    if(!isNodeInTree(server, &origin, &objectsFolderId, &refTypes)) {
+    if(!isNodeInTree(server, origin, &objectsFolderId, &refTypes)) {
         UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_USERLAND,
                      "Node for event must be in ObjectsFolder!");
         return UA_STATUSCODE_BADINVALIDARGUMENT;
     }
+    return UA_STATUSCODE_GOOD;
+}
 
-    /* Update the standard fields of the event */
-    retval = eventSetStandardFields(server, &eventNodeId, &origin, outEventId);
-    if(retval != UA_STATUSCODE_GOOD) {
-        UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
-                       "Events: Could not set the standard event fields with StatusCode %s",
-                       UA_StatusCode_name(retval));
-        return retval;
+/* Event Routes
+ * ------------
+ * The route of an origin is the list of Event-MonitoredItems of all nodes the
+ * event propagates to. Computing the route browses the hierarchy upwards. The
+ * routes are cached until the references or the Event-MonitoredItems change.
+ * The emitting of an event can call into userland (e.g. for the Read of the
+ * event fields) where the cache might be modified. Routes in use are then only
+ * detached from the cache and freed when they are released. */
+
+static void
+freeEventRoute(UA_EventRoute *route) {
+    UA_NodeId_clear(&route->origin);
+    UA_Array_delete(route->emitNodes, route->emitNodesSize, &UA_TYPES[UA_TYPES_NODEID]);
+    UA_free(route->monitoredItems);
+    UA_free(route);
+}
+
+static void
+removeEventRoute(UA_EventRouteCache *erc, UA_EventRoute *route) {
+    TAILQ_REMOVE(&erc->lru, route, lruEntry);
+    LIST_REMOVE(route, bucketEntry);
+    erc->size--;
+    if(route->refCount > 0)
+        route->detached = true;
+    else
+        freeEventRoute(route);
+}
+
+void
+clearEventRouteCache(UA_Server *server) {
+    UA_EventRouteCache *erc = &server->eventRouteCache;
+    UA_EventRoute *route, *route_tmp;
+    TAILQ_FOREACH_SAFE(route, &erc->lru, lruEntry, route_tmp) {
+        removeEventRoute(erc, route);
     }
+}
 
-    /* List of nodes that emit the node. Events propagate upwards (bubble up) in
-     * the node hierarchy. */
-    UA_ExpandedNodeId *emitNodes = NULL;
-    size_t emitNodesSize = 0;
+static void
+releaseEventRoute(UA_EventRoute *route) {
+    route->refCount--;
+    if(route->detached && route->refCount == 0)
+        freeEventRoute(route);
+}
 
+static UA_StatusCode
+computeEventRoute(UA_Server *server, UA_EventRoute *route) {
     /* Add the server node to the list of nodes from which the event is emitted.
      * The server node emits all events.
      *
@@ -356,10 +380,11 @@ triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
      * a Server and as such has implied HasEventSource References to every event
      * source in a Server. */
     UA_NodeId emitStartNodes[2];
-    emitStartNodes[0] = origin;
+    emitStartNodes[0] = route->origin;
     emitStartNodes[1] = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
 
     /* Get all ReferenceTypes over which the events propagate */
+    UA_StatusCode retval;
     UA_ReferenceTypeSet emitRefTypes;
     UA_ReferenceTypeSet_init(&emitRefTypes);
     for(size_t i = 0; i < EMIT_REFS_ROOT_COUNT; i++) {
@@ -369,12 +394,15 @@ triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
             UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
                            "Events: Could not create the list of references for event "
                            "propagation with StatusCode %s", UA_StatusCode_name(retval));
-            goto cleanup;
+            return retval;
         }
         emitRefTypes = UA_ReferenceTypeSet_union(emitRefTypes, tmpRefTypes);
     }
 
-    /* Get the list of nodes in the hierarchy that emits the event. */
+    /* Get the list of nodes in the hierarchy that emits the event. Events
+     * propagate upwards (bubble up) in the node hierarchy. */
+    UA_ExpandedNodeId *emitNodes = NULL;
+    size_t emitNodesSize = 0;
     retval = browseRecursive(server, 2, emitStartNodes, UA_BROWSEDIRECTION_INVERSE,
                              &emitRefTypes, UA_NODECLASS_UNSPECIFIED, true,
                              &emitNodesSize, &emitNodes);
@@ -382,45 +410,174 @@ triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
         UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
                        "Events: Could not create the list of nodes listening on the "
                        "event with StatusCode %s", UA_StatusCode_name(retval));
-        goto cleanup;
+        return retval;
     }
 
-    /* Add the event to the listening MonitoredItems at each relevant node */
-    for(size_t i = 0; i < emitNodesSize; i++) {
-        /* Get the node */
+    /* Collect the Event-MonitoredItems of the objects. The NodeIds of the
+     * objects are kept for the historical database. */
+    for(size_t i = 0; i < emitNodesSize && retval == UA_STATUSCODE_GOOD; i++) {
         const UA_Node *node = UA_NODESTORE_GET(server, &emitNodes[i].nodeId);
         if(!node)
             continue;
-
-        /* Only consider objects */
         if(node->head.nodeClass != UA_NODECLASS_OBJECT) {
             UA_NODESTORE_RELEASE(server, node);
             continue;
         }
-
-        /* Add event to monitoreditems */
+        retval = UA_Array_appendCopy((void**)&route->emitNodes, &route->emitNodesSize,
+                                     &emitNodes[i].nodeId, &UA_TYPES[UA_TYPES_NODEID]);
         UA_MonitoredItem *mon = node->head.monitoredItems;
-        for(; mon != NULL; mon = mon->sampling.nodeListNext) {
-            /* Is this an Event-MonitoredItem? */
+        for(; mon != NULL && retval == UA_STATUSCODE_GOOD;
+            mon = mon->sampling.nodeListNext) {
             if(mon->itemToMonitor.attributeId != UA_ATTRIBUTEID_EVENTNOTIFIER)
                 continue;
-            retval = UA_MonitoredItem_addEvent(server, mon, &eventNodeId);
-            if(retval != UA_STATUSCODE_GOOD) {
-                UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
-                               "Events: Could not add the event to a listening "
-                               "node with StatusCode %s", UA_StatusCode_name(retval));
-                retval = UA_STATUSCODE_GOOD; /* Only log problems with individual emit nodes */
+            UA_MonitoredItem **mons = (UA_MonitoredItem**)
+                UA_realloc(route->monitoredItems, sizeof(UA_MonitoredItem*) *
+                           (route->monitoredItemsSize + 1));
+            if(!mons) {
+                retval = UA_STATUSCODE_BADOUTOFMEMORY;
+                break;
             }
+            mons[route->monitoredItemsSize++] = mon;
+            route->monitoredItems = mons;
         }
-
         UA_NODESTORE_RELEASE(server, node);
+    }
 
-        /* Add event entry in the historical database */
+    UA_Array_delete(emitNodes, emitNodesSize, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
+    return retval;
+}
+
+/* Returns the route of the origin with an increased refCount */
+static UA_StatusCode
+getEventRoute(UA_Server *server, const UA_NodeId *origin, UA_EventRoute **outRoute) {
+    /* Empty the cache if the references or MonitoredItems have changed */
+    UA_EventRouteCache *erc = &server->eventRouteCache;
+    if(erc->hierarchyEpoch != server->hierarchyEpoch ||
+       erc->monitoredItemsEpoch != server->eventMonitoredItemsEpoch) {
+        clearEventRouteCache(server);
+        erc->hierarchyEpoch = server->hierarchyEpoch;
+        erc->monitoredItemsEpoch = server->eventMonitoredItemsEpoch;
+    }
+
+    /* Lookup in the cache */
+    UA_UInt32 hash = UA_NodeId_hash(origin);
+    UA_EventRoute *route;
+    LIST_FOREACH(route, &erc->buckets[hash & (UA_EVENTROUTECACHE_BUCKETS - 1)],
+                 bucketEntry) {
+        if(route->hash != hash || !UA_NodeId_equal(&route->origin, origin))
+            continue;
+        /* Move to the front of the LRU list */
+        TAILQ_REMOVE(&erc->lru, route, lruEntry);
+        TAILQ_INSERT_HEAD(&erc->lru, route, lruEntry);
+        route->refCount++;
+        *outRoute = route;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    /* Invalid origins are not cached. They are reported every time. */
+    UA_StatusCode retval = checkEventOrigin(server, origin);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
+    /* Compute the route */
+    route = (UA_EventRoute*)UA_calloc(1, sizeof(UA_EventRoute));
+    if(!route)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    route->hash = hash;
+    retval = UA_NodeId_copy(origin, &route->origin);
+    if(retval == UA_STATUSCODE_GOOD)
+        retval = computeEventRoute(server, route);
+    if(retval != UA_STATUSCODE_GOOD) {
+        freeEventRoute(route);
+        return retval;
+    }
+
+    /* The cache was modified during the computation. The route might be
+     * stale already. Use it only for this event. */
+    route->refCount = 1;
+    if(erc->hierarchyEpoch != server->hierarchyEpoch ||
+       erc->monitoredItemsEpoch != server->eventMonitoredItemsEpoch) {
+        route->detached = true;
+        *outRoute = route;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    /* Evict the least recently used entry and add the route */
+    if(erc->size >= UA_EVENTROUTECACHE_SIZE)
+        removeEventRoute(erc, TAILQ_LAST(&erc->lru, UA_EventRouteLru));
+    TAILQ_INSERT_HEAD(&erc->lru, route, lruEntry);
+    LIST_INSERT_HEAD(&erc->buckets[hash & (UA_EVENTROUTECACHE_BUCKETS - 1)],
+                     route, bucketEntry);
+    erc->size++;
+    *outRoute = route;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Add the event to the MonitoredItems along the route of the origin. The event
+ * is either represented as a node or as a map of flat fields. Problems with
+ * individual MonitoredItems are only logged. */
+static void
+emitEvent(UA_Server *server, const UA_EventRoute *route, const UA_NodeId *eventNodeId,
+          const UA_KeyValueMap *eventFields) {
+    /* Add the event to the listening MonitoredItems */
+    for(size_t i = 0; i < route->monitoredItemsSize; i++) {
+        UA_StatusCode retval = addEvent(server, route->monitoredItems[i], eventNodeId, eventFields);
+        if(retval != UA_STATUSCODE_GOOD) {
+            UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
+                           "Events: Could not add the event to a listening "
+                           "node with StatusCode %s", UA_StatusCode_name(retval));
+        }
+    }
+
+    /* Add event entry in the historical database */
 #ifdef UA_ENABLE_HISTORIZING
-        if(server->config.historyDatabase.setEvent)
-            setHistoricalEvent(server, &origin, &emitNodes[i].nodeId, &eventNodeId);
+    if(server->config.historyDatabase.setEvent) {
+        for(size_t i = 0; i < route->emitNodesSize; i++)
+            setHistoricalEvent(server, &route->origin, &route->emitNodes[i],
+                               eventNodeId, eventFields);
+    }
 #endif
+}
+
+UA_StatusCode
+triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
+             const UA_NodeId origin, UA_ByteString *outEventId,
+             const UA_Boolean deleteEventNode) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+
+    UA_LOG_DEBUG(server->config.logging, UA_LOGCATEGORY_SERVER,
+                 "Events: An event is triggered on node %N", origin);
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
+    UA_Boolean isCallerAC = false;
+    if(isConditionOrBranch(server, &eventNodeId, &origin, &isCallerAC)) {
+        if(!isCallerAC) {
+          UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
+                                 "Condition Events: Please use A&C API to trigger Condition Events 0x%08X",
+                                  UA_STATUSCODE_BADINVALIDARGUMENT);
+          return UA_STATUSCODE_BADINVALIDARGUMENT;
+        }
     }
+#endif /* UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS */
+
+    /* Check the origin and get the MonitoredItems listening on it */
+    UA_EventRoute *route = NULL;
+    UA_StatusCode retval = getEventRoute(server, &origin, &route);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
+    /* Update the standard fields of the event */
+    retval = eventSetStandardFields(server, &eventNodeId, &origin, outEventId);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
+                       "Events: Could not set the standard event fields with StatusCode %s",
+                       UA_StatusCode_name(retval));
+        releaseEventRoute(route);
+        return retval;
+    }
+
+    emitEvent(server, route, &eventNodeId, NULL);
+    releaseEventRoute(route);
 
     /* Delete the node representation of the event */
     if(deleteEventNode) {
@@ -431,9 +588,90 @@ triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
                            UA_StatusCode_name(retval));
         }
     }
+    return retval;
+}
 
- cleanup:
-    UA_Array_delete(emitNodes, emitNodesSize, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
+#define EVENT_STANDARD_FIELDS 4
+
+UA_StatusCode
+triggerEventFields(UA_Server *server, const UA_NodeId eventType,
+                   const UA_NodeId origin, const UA_KeyValueMap *fields,
+                   UA_ByteString *outEventId) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+
+    UA_LOG_DEBUG(server->config.logging, UA_LOGCATEGORY_SERVER,
+                 "Events: An event is triggered on node %N", origin);
+
+    /* Conditions have a state in the information model and cannot be
+     * triggered from flat fields */
+    UA_NodeId baseEventTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEEVENTTYPE);
+    UA_NodeId conditionTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_CONDITIONTYPE);
+    if(!isNodeInTree_singleRef(server, &eventType, &baseEventTypeId,
+                               UA_REFERENCETYPEINDEX_HASSUBTYPE) ||
+       isNodeInTree_singleRef(server, &eventType, &conditionTypeId,
+                              UA_REFERENCETYPEINDEX_HASSUBTYPE)) {
+        UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_USERLAND,
+                       "Events: %N is not a (non-Condition) EventType", eventType);
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+    }
+
+    /* Check the origin and get the MonitoredItems listening on it */
+    UA_EventRoute *route = NULL;
+    UA_StatusCode retval = getEventRoute(server, &origin, &route);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
+    /* Prepend the standard fields to a shallow copy of the user fields. The
+     * first entry for a key is used, so they cannot be overridden. The Time
+     * defaults to the ReceiveTime and is appended. */
+    size_t userFields = (fields) ? fields->mapSize : 0;
+    UA_KeyValuePair *map = (UA_KeyValuePair*)
+        UA_malloc(sizeof(UA_KeyValuePair) * (EVENT_STANDARD_FIELDS + userFields + 1));
+    if(!map) {
+        releaseEventRoute(route);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+
+    UA_ByteString eventId = UA_BYTESTRING_NULL;
+    retval = generateEventId(&eventId);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_free(map);
+        releaseEventRoute(route);
+        return retval;
+    }
+    UA_EventLoop *el = server->config.eventLoop;
+    UA_DateTime rcvTime = el->dateTime_now(el);
+
+    map[0].key = UA_QUALIFIEDNAME(0, "EventId");
+    UA_Variant_setScalar(&map[0].value, &eventId, &UA_TYPES[UA_TYPES_BYTESTRING]);
+    map[1].key = UA_QUALIFIEDNAME(0, "EventType");
+    UA_Variant_setScalar(&map[1].value, (void*)(uintptr_t)&eventType,
+                         &UA_TYPES[UA_TYPES_NODEID]);
+    map[2].key = UA_QUALIFIEDNAME(0, "SourceNode");
+    UA_Variant_setScalar(&map[2].value, (void*)(uintptr_t)&origin,
+                         &UA_TYPES[UA_TYPES_NODEID]);
+    map[3].key = UA_QUALIFIEDNAME(0, "ReceiveTime");
+    UA_Variant_setScalar(&map[3].value, &rcvTime, &UA_TYPES[UA_TYPES_DATETIME]);
+    if(userFields > 0)
+        memcpy(&map[EVENT_STANDARD_FIELDS], fields->map,
+               sizeof(UA_KeyValuePair) * userFields);
+    UA_KeyValueMap eventFields = {EVENT_STANDARD_FIELDS + userFields, map};
+    if(!UA_KeyValueMap_contains(&eventFields, UA_QUALIFIEDNAME(0, "Time"))) {
+        map[eventFields.mapSize].key = UA_QUALIFIEDNAME(0, "Time");
+        UA_Variant_setScalar(&map[eventFields.mapSize].value, &rcvTime,
+                             &UA_TYPES[UA_TYPES_DATETIME]);
+        eventFields.mapSize++;
+    }
+
+    emitEvent(server, route, NULL, &eventFields);
+    releaseEventRoute(route);
+    UA_free(map);
+
+    /* Return the EventId */
+    if(outEventId && retval == UA_STATUSCODE_GOOD)
+        *outEventId = eventId;
+    else
+        UA_ByteString_clear(&eventId);
     return retval;
 }
 
@@ -448,4 +686,15 @@ UA_Server_triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
     return res;
 }
 
+UA_StatusCode
+UA_Server_triggerEventFields(UA_Server *server, const UA_NodeId eventType,
+                             const UA_NodeId origin, const UA_KeyValueMap *fields,
+                             UA_ByteString *outEventId) {
+    UA_LOCK(&server->serviceMutex);
+    UA_StatusCode res =
+        triggerEventFields(server, eventType, origin, fields, outEventId);
+    UA_UNLOCK(&server->serviceMutex);
+    return res;
+}
+
 #endif /* UA_ENABLE_SUBSCRIPTIONS_EVENTS */
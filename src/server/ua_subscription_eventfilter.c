@@ -453,20 +453,212 @@ typedef struct {
     UA_Server *server;
     UA_Session *session;
     const UA_NodeId *eventNode;
+    const UA_KeyValueMap *eventFields; /* Used instead of the node if set */
     const UA_ContentFilter *filter;
-    UA_ContentFilterResult *filterResult;
+    UA_ContentFilterResult *filterResult; /* Can be NULL */
     UA_Variant results[UA_EVENTFILTER_MAXELEMENTS];
 
+    /* The EventType is read once per event */
+    UA_Boolean eventTypeRead;
+    UA_StatusCode eventTypeStatus;
+    UA_NodeId eventType;
+
+    /* Optional cache kept between the events of a MonitoredItem. The
+     * EventType-dependent entries are only used if typeCached is set. */
+    UA_EventFilterCache *cache;
+    UA_Boolean typeCached;
+
     /* The stack contains temporary variants. Cleaned up after the evaluation of
      * each operator. */
     size_t top;
     UA_Variant stack[UA_EVENTFILTER_MAXOPERANDS];
 } UA_FilterEvalContext;
 
+void
+UA_EventFilterCache_clear(UA_EventFilterCache *cache) {
+    UA_Array_delete(cache->literals, cache->literalsSize, &UA_TYPES[UA_TYPES_VARIANT]);
+    UA_NodeId_clear(&cache->eventType);
+    UA_free(cache->fieldIndex);
+    memset(cache, 0, sizeof(UA_EventFilterCache));
+}
+
+static void
+initFilterEvalContext(UA_FilterEvalContext *ctx, UA_Server *server,
+                      UA_Session *session, const UA_NodeId *eventNode,
+                      const UA_KeyValueMap *eventFields,
+                      const UA_ContentFilter *filter,
+                      UA_ContentFilterResult *filterResult,
+                      UA_EventFilterCache *cache) {
+    ctx->server = server;
+    ctx->session = session;
+    ctx->eventNode = eventNode;
+    ctx->eventFields = eventFields;
+    ctx->filter = filter;
+    ctx->filterResult = filterResult;
+    ctx->top = 0;
+    ctx->eventTypeRead = false;
+    ctx->eventTypeStatus = UA_STATUSCODE_GOOD;
+    UA_NodeId_init(&ctx->eventType);
+    ctx->cache = cache;
+    ctx->typeCached = false;
+
+    /* Pacify some compilers by initializing the first result */
+    UA_Variant_init(&ctx->results[0]);
+}
+
+static void
+clearFilterEvalContext(UA_FilterEvalContext *ctx) {
+    UA_NodeId_clear(&ctx->eventType);
+}
+
+/* Read the EventType of the event. If it differs from the EventType of the
+ * last event, the EventType-dependent entries of the cache are reset. */
+static UA_StatusCode
+resolveEventType(UA_FilterEvalContext *ctx) {
+    if(ctx->eventTypeRead)
+        return ctx->eventTypeStatus;
+    ctx->eventTypeRead = true;
+
+    UA_Variant eventTypeVar;
+    UA_Variant_init(&eventTypeVar);
+    UA_StatusCode res;
+    if(ctx->eventFields) {
+        const UA_Variant *field =
+            UA_KeyValueMap_get(ctx->eventFields, UA_QUALIFIEDNAME(0, "EventType"));
+        res = (field) ? UA_Variant_copy(field, &eventTypeVar) : UA_STATUSCODE_BADNOTFOUND;
+    } else {
+        res = readObjectProperty(ctx->server, *ctx->eventNode,
+                                 UA_QUALIFIEDNAME(0, "EventType"), &eventTypeVar);
+    }
+    if(res == UA_STATUSCODE_GOOD &&
+       !UA_Variant_hasScalarType(&eventTypeVar, &UA_TYPES[UA_TYPES_NODEID])) {
+        UA_LOG_WARNING(ctx->server->config.logging, UA_LOGCATEGORY_SERVER,
+                       "EventType has an invalid type.");
+        res = UA_STATUSCODE_BADINTERNALERROR;
+    }
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_Variant_clear(&eventTypeVar);
+        ctx->eventTypeStatus = res;
+        return res;
+    }
+
+    /* Move the NodeId out of the variant */
+    ctx->eventType = *(UA_NodeId*)eventTypeVar.data;
+    UA_free(eventTypeVar.data);
+
+    /* Reset the cache for a different EventType */
+    UA_EventFilterCache *cache = ctx->cache;
+    if(!cache)
+        return UA_STATUSCODE_GOOD;
+    if(!UA_NodeId_equal(&cache->eventType, &ctx->eventType)) {
+        cache->selectKnown = 0;
+        cache->ofTypeKnown = 0;
+        for(size_t i = 0; i < cache->fieldIndexSize; i++)
+            cache->fieldIndex[i] = UA_UINT16_MAX;
+        UA_NodeId_clear(&cache->eventType);
+        if(UA_NodeId_copy(&ctx->eventType, &cache->eventType) != UA_STATUSCODE_GOOD)
+            return UA_STATUSCODE_GOOD; /* Evaluate without the cache */
+    }
+    ctx->typeCached = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Returns the cache entry for a literal operand or NULL. The cached literals
+ * are allocated when the first cast is stored. */
+static UA_Variant *
+getCachedLiteral(UA_FilterEvalContext *ctx, size_t index, size_t operandIndex) {
+    UA_EventFilterCache *cache = ctx->cache;
+    if(!cache || operandIndex >= UA_EVENTFILTER_CACHEDOPERANDS)
+        return NULL;
+    const UA_ExtensionObject *op =
+        &ctx->filter->elements[index].filterOperands[operandIndex];
+    if(op->content.decoded.type != &UA_TYPES[UA_TYPES_LITERALOPERAND])
+        return NULL;
+    if(!cache->literals) {
+        size_t size = ctx->filter->elementsSize * UA_EVENTFILTER_CACHEDOPERANDS;
+        cache->literals = (UA_Variant*)UA_Array_new(size, &UA_TYPES[UA_TYPES_VARIANT]);
+        if(!cache->literals)
+            return NULL;
+        cache->literalsSize = size;
+    }
+    return &cache->literals[(index * UA_EVENTFILTER_CACHEDOPERANDS) + operandIndex];
+}
+
 /* Operand Resolving
  * ~~~~~~~~~~~~~~~~~
  * Methods that all resolve an operator operand to a Variant. */
 
+/* Does the key of a flat event field match the browse path? Nested fields use
+ * the BrowseNames of the path joined with '/' and the namespace index of the
+ * last path element, e.g. "EnabledState/Id". */
+static UA_Boolean
+matchFieldKey(const UA_QualifiedName *key, size_t pathSize,
+              const UA_QualifiedName *path) {
+    if(key->namespaceIndex != path[pathSize-1].namespaceIndex)
+        return false;
+    size_t pos = 0;
+    for(size_t i = 0; i < pathSize; i++) {
+        if(i > 0) {
+            if(pos >= key->name.length || key->name.data[pos] != '/')
+                return false;
+            pos++;
+        }
+        const UA_String *name = &path[i].name;
+        if(key->name.length - pos < name->length ||
+           (name->length > 0 &&
+            memcmp(&key->name.data[pos], name->data, name->length) != 0))
+            return false;
+        pos += name->length;
+    }
+    return (pos == key->name.length);
+}
+
+/* Events of the same type are usually triggered with the same field layout.
+ * The optional hint is the position of the field in the previous event. It is
+ * checked against the key before use and updated after a full search. */
+static const UA_Variant *
+findEventField(const UA_KeyValueMap *fields, const UA_SimpleAttributeOperand *sao,
+               UA_UInt16 *hint) {
+    if(hint && *hint < fields->mapSize &&
+       matchFieldKey(&fields->map[*hint].key, sao->browsePathSize, sao->browsePath))
+        return &fields->map[*hint].value;
+    for(size_t i = 0; i < fields->mapSize; i++) {
+        if(!matchFieldKey(&fields->map[i].key, sao->browsePathSize, sao->browsePath))
+            continue;
+        if(hint && i < UA_UINT16_MAX)
+            *hint = (UA_UInt16)i;
+        return &fields->map[i].value;
+    }
+    return NULL;
+}
+
+/* Resolve the SimpleAttributeOperand from the flat fields of an event that is
+ * not represented as a node. Only the Value attribute of fields selected by
+ * their BrowsePath is available. */
+static UA_StatusCode
+resolveEventField(const UA_KeyValueMap *fields, const UA_SimpleAttributeOperand *sao,
+                  UA_UInt16 *hint, UA_Variant *value) {
+    if(sao->attributeId != UA_ATTRIBUTEID_VALUE)
+        return UA_STATUSCODE_BADATTRIBUTEIDINVALID;
+    if(sao->browsePathSize == 0)
+        return UA_STATUSCODE_BADNOTFOUND;
+
+    const UA_Variant *field = findEventField(fields, sao, hint);
+    if(!field)
+        return UA_STATUSCODE_BADNOTFOUND;
+    if(UA_Variant_isEmpty(field))
+        return UA_STATUSCODE_BADNODATAAVAILABLE;
+
+    if(sao->indexRange.length == 0)
+        return UA_Variant_copy(field, value);
+    UA_NumericRange range;
+    UA_StatusCode res = UA_NumericRange_parse(&range, sao->indexRange);
+    UA_CHECK_STATUS(res, return res);
+    res = UA_Variant_copyRange(field, value, range);
+    UA_free(range.dimensions);
+    return res;
+}
+
 /* Part 4, 7.4.4.5 SimpleAttributeOperand: The clause can point to any attribute
  * of nodes. Either a child of the event node and also the event type. */
 static UA_StatusCode
@@ -559,6 +751,8 @@ resolveOperand(UA_FilterEvalContext *ctx, UA_ExtensionObject *op, UA_Variant *ou
     if(op->content.decoded.type == &UA_TYPES[UA_TYPES_SIMPLEATTRIBUTEOPERAND]) {
         UA_SimpleAttributeOperand *sao =
             (UA_SimpleAttributeOperand*)op->content.decoded.data;
+        if(ctx->eventFields)
+            return resolveEventField(ctx->eventFields, sao, NULL, out);
         return resolveSimpleAttributeOperand(ctx->server, ctx->session,
                                              ctx->eventNode, sao, out);
     }
@@ -571,8 +765,11 @@ resolveOperand(UA_FilterEvalContext *ctx, UA_ExtensionObject *op, UA_Variant *ou
 static UA_StatusCode
 setOperandError(UA_FilterEvalContext *ctx, size_t elementIndex,
                 size_t operandIndex, UA_StatusCode statusCode) {
+    if(!ctx->filterResult || elementIndex >= ctx->filterResult->elementResultsSize)
+        return statusCode;
     UA_ContentFilterElementResult *res = &ctx->filterResult->elementResults[elementIndex];
-    res->operandStatusCodes[operandIndex] = statusCode;
+    if(operandIndex < res->operandStatusCodesSize)
+        res->operandStatusCodes[operandIndex] = statusCode;
     /* The operator status is set globally in a single location upwards the call chain
      * res->statusCode = statusCode; */
     return statusCode;
@@ -593,26 +790,29 @@ ofTypeOperator(UA_FilterEvalContext *ctx, size_t index) {
         return setOperandError(ctx, index, 0, UA_STATUSCODE_BADFILTEROPERATORUNSUPPORTED);
 
     /* Read the event type */
-    UA_Variant eventTypeVar;
-    UA_Variant_init(&eventTypeVar);
-    const UA_NodeId *operandTypeId = (const UA_NodeId *)op0->data;
-    res = readObjectProperty(ctx->server, *ctx->eventNode,
-                             UA_QUALIFIEDNAME(0, "EventType"), &eventTypeVar);
+    res = resolveEventType(ctx);
     UA_CHECK_STATUS(res, return res);
 
-    if(!UA_Variant_hasScalarType(&eventTypeVar, &UA_TYPES[UA_TYPES_NODEID])) {
-        UA_LOG_WARNING(ctx->server->config.logging, UA_LOGCATEGORY_SERVER,
-                       "EventType has an invalid type.");
-        UA_Variant_clear(&eventTypeVar);
-        return UA_STATUSCODE_BADINTERNALERROR;
+    /* Check if the eventtype is equal to the operand or a subtype of it. The
+     * result is cached for the EventType. */
+    UA_Boolean ofType;
+    UA_UInt64 bit = (UA_UInt64)1 << index;
+    UA_EventFilterCache *cache = ctx->cache;
+    if(ctx->typeCached && (cache->ofTypeKnown & bit)) {
+        ofType = ((cache->ofTypeMatch & bit) != 0);
+    } else {
+        const UA_NodeId *operandTypeId = (const UA_NodeId *)op0->data;
+        ofType = isNodeInTree_singleRef(ctx->server, &ctx->eventType, operandTypeId,
+                                        UA_REFERENCETYPEINDEX_HASSUBTYPE);
+        if(ctx->typeCached) {
+            cache->ofTypeKnown |= bit;
+            if(ofType)
+                cache->ofTypeMatch |= bit;
+            else
+                cache->ofTypeMatch &= ~bit;
+        }
     }
-
-    /* Check if the eventtype is equal to the operand or a subtype of it */
-    const UA_NodeId *eventTypeId = (UA_NodeId*)eventTypeVar.data;
-    UA_Boolean ofType = isNodeInTree_singleRef(ctx->server, eventTypeId, operandTypeId,
-                                               UA_REFERENCETYPEINDEX_HASSUBTYPE);
     ctx->results[index] = t2v(ofType ? UA_TERNARY_TRUE : UA_TERNARY_FALSE);
-    UA_Variant_clear(&eventTypeVar);
     return UA_STATUSCODE_GOOD;
 }
 
@@ -685,6 +885,17 @@ castResolveOperands(UA_FilterEvalContext *ctx, size_t index, UA_Boolean setError
     /* Cast the operands. Put the result in the same location on the stack. */
     for(size_t pos = 0; pos < ctx->top; pos++) {
         UA_Variant orig = ctx->stack[pos];
+
+        /* Reuse the cast of a literal operand from a prior event. The original
+         * literal points into the filter and needs no cleanup. */
+        UA_Variant *cached = (orig.type && orig.type != targetType) ?
+            getCachedLiteral(ctx, index, pos) : NULL;
+        if(cached && cached->type == targetType) {
+            ctx->stack[pos] = *cached;
+            ctx->stack[pos].storageType = UA_VARIANT_DATA_NODELETE;
+            continue;
+        }
+
         res = castImplicit(&orig, targetType, &ctx->stack[pos]);
         if(res != UA_STATUSCODE_GOOD)
             return (setError) ? setOperandError(ctx, index, pos, res) : res;
@@ -694,6 +905,12 @@ castResolveOperands(UA_FilterEvalContext *ctx, size_t index, UA_Boolean setError
             ctx->stack[pos].storageType = orig.storageType;
         } else {
             UA_Variant_clear(&orig); /* Fresh allocation of the cast variant. Clean up. */
+            if(cached && ctx->stack[pos].type) {
+                /* Move the cast literal into the cache */
+                UA_Variant_clear(cached);
+                *cached = ctx->stack[pos];
+                ctx->stack[pos].storageType = UA_VARIANT_DATA_NODELETE;
+            }
         }
     }
 
@@ -920,28 +1137,13 @@ static const UA_FilterOperatorJumptableElement operatorJumptable[18] = {
     {bitwiseOrOperator, 2, 2}
 };
 
-UA_StatusCode
-evaluateWhereClause(UA_Server *server, UA_Session *session, const UA_NodeId *eventNode,
-                    const UA_ContentFilter *contentFilter,
-                    UA_ContentFilterResult *contentFilterResult) {
-    UA_LOCK_ASSERT(&server->serviceMutex);
-
+static UA_StatusCode
+evaluateWhereClauseContext(UA_FilterEvalContext *ctx) {
     /* An empty filter always succeeds */
+    const UA_ContentFilter *contentFilter = ctx->filter;
     if(contentFilter->elementsSize == 0)
         return UA_STATUSCODE_GOOD;
 
-    /* Prepare the context */
-    UA_FilterEvalContext ctx;
-    ctx.filterResult = contentFilterResult;
-    ctx.filter = contentFilter;
-    ctx.server = server;
-    ctx.session = session;
-    ctx.eventNode = eventNode;
-    ctx.top = 0;
-
-    /* Pacify some compilers by initializing the first result */
-    UA_Variant_init(&ctx.results[0]);
-
     /* Evaluate the filter. Iterate backwards over the filter elements and
      * resolve each. This ensures that all element-index operands point to an
      * evaluated element. */
@@ -949,137 +1151,128 @@ evaluateWhereClause(UA_Server *server, UA_Session *session, const UA_NodeId *eve
     int i = (int)contentFilter->elementsSize - 1;
     for(; i >= 0; i--) {
         UA_ContentFilterElement *cfe = &contentFilter->elements[i];
-        res = operatorJumptable[cfe->filterOperator].operatorMethod(&ctx, (size_t)i);
-        for(size_t j = 0; j < ctx.top; j++)
-            UA_Variant_clear(&ctx.stack[j]); /* clean up the stack */
-        ctx.top = 0;
+        res = operatorJumptable[cfe->filterOperator].operatorMethod(ctx, (size_t)i);
+        for(size_t j = 0; j < ctx->top; j++)
+            UA_Variant_clear(&ctx->stack[j]); /* clean up the stack */
+        ctx->top = 0;
         if(res != UA_STATUSCODE_GOOD)
             break;
     }
 
     /* The filter matches if the operator at the first position evaluates to TRUE */
-    if(res == UA_STATUSCODE_GOOD && v2t(&ctx.results[0]) != UA_TERNARY_TRUE)
+    if(res == UA_STATUSCODE_GOOD && v2t(&ctx->results[0]) != UA_TERNARY_TRUE)
         res = UA_STATUSCODE_BADNOMATCH;
 
     /* Clean up the element result variants */
     for(int j = (int)contentFilter->elementsSize - 1; j > i; j--)
-        UA_Variant_clear(&ctx.results[j]);
+        UA_Variant_clear(&ctx->results[j]);
     return res;
 }
 
-static UA_Boolean
-isValidEvent(UA_Server *server, const UA_NodeId *validEventParent,
-             const UA_NodeId *eventId) {
+UA_StatusCode
+evaluateWhereClause(UA_Server *server, UA_Session *session, const UA_NodeId *eventNode,
+                    const UA_ContentFilter *contentFilter,
+                    UA_ContentFilterResult *contentFilterResult) {
     UA_LOCK_ASSERT(&server->serviceMutex);
+    UA_FilterEvalContext ctx;
+    initFilterEvalContext(&ctx, server, session, eventNode, NULL, contentFilter,
+                          contentFilterResult, NULL);
+    UA_StatusCode res = evaluateWhereClauseContext(&ctx);
+    clearFilterEvalContext(&ctx);
+    return res;
+}
 
-    /* Find the eventType variableNode */
-    UA_QualifiedName findName = UA_QUALIFIEDNAME(0, "EventType");
-    UA_BrowsePathResult bpr = browseSimplifiedBrowsePath(server, *eventId, 1, &findName);
-    if(bpr.statusCode != UA_STATUSCODE_GOOD || bpr.targetsSize < 1) {
-        UA_BrowsePathResult_clear(&bpr);
-        return false;
-    }
-
-    /* Get the EventType Property Node */
-    UA_Variant tOutVariant;
-    UA_Variant_init(&tOutVariant);
-    /* Read the Value of EventType Property Node (the Value should be a NodeId) */
-    UA_StatusCode retval = readWithReadValue(server, &bpr.targets[0].targetId.nodeId,
-                                             UA_ATTRIBUTEID_VALUE, &tOutVariant);
-    if(retval != UA_STATUSCODE_GOOD ||
-       !UA_Variant_hasScalarType(&tOutVariant, &UA_TYPES[UA_TYPES_NODEID])) {
-        UA_BrowsePathResult_clear(&bpr);
-        return false;
-    }
-
-    const UA_NodeId *tEventType = (UA_NodeId*)tOutVariant.data;
-
+static UA_Boolean
+isValidEventType(UA_Server *server, const UA_NodeId *validEventParent,
+                 const UA_NodeId *eventType) {
     /* Check whether the EventType is a Subtype of CondtionType (Part 9 first
      * implementation) */
     UA_NodeId conditionTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_CONDITIONTYPE);
     if(UA_NodeId_equal(validEventParent, &conditionTypeId) &&
-       isNodeInTree_singleRef(server, tEventType, &conditionTypeId,
-                              UA_REFERENCETYPEINDEX_HASSUBTYPE)) {
-        UA_BrowsePathResult_clear(&bpr);
-        UA_Variant_clear(&tOutVariant);
+       isNodeInTree_singleRef(server, eventType, &conditionTypeId,
+                              UA_REFERENCETYPEINDEX_HASSUBTYPE))
         return true;
-    }
 
     /* EventType is not a Subtype of CondtionType (ConditionId Clause won't be
      * present in Events, which are not Conditions) */
     /* Check whether Valid Event other than Conditions */
     UA_NodeId baseEventTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEEVENTTYPE);
-    UA_Boolean isSubtypeOfBaseEvent =
-        isNodeInTree_singleRef(server, tEventType, &baseEventTypeId,
-                               UA_REFERENCETYPEINDEX_HASSUBTYPE);
+    return isNodeInTree_singleRef(server, eventType, &baseEventTypeId,
+                                  UA_REFERENCETYPEINDEX_HASSUBTYPE);
+}
+
+/* The validity of a select clause only depends on the EventType. The result is
+ * cached for the EventType. */
+static UA_Boolean
+isValidSelectClause(UA_FilterEvalContext *ctx, const UA_SimpleAttributeOperand *sc,
+                    size_t index) {
+    if(resolveEventType(ctx) != UA_STATUSCODE_GOOD)
+        return false;
 
-    UA_BrowsePathResult_clear(&bpr);
-    UA_Variant_clear(&tOutVariant);
-    return isSubtypeOfBaseEvent;
+    UA_EventFilterCache *cache = ctx->cache;
+    UA_UInt64 bit = (UA_UInt64)1 << index;
+    UA_Boolean cacheable = (ctx->typeCached && index < 64);
+    if(cacheable && (cache->selectKnown & bit))
+        return ((cache->selectValid & bit) != 0);
+
+    UA_Boolean valid = isValidEventType(ctx->server, &sc->typeDefinitionId,
+                                        &ctx->eventType);
+    if(cacheable) {
+        cache->selectKnown |= bit;
+        if(valid)
+            cache->selectValid |= bit;
+        else
+            cache->selectValid &= ~bit;
+    }
+    return valid;
 }
 
-UA_StatusCode
-filterEvent(UA_Server *server, UA_Session *session,
-            const UA_NodeId *eventNode, UA_EventFilter *filter,
-            UA_EventFieldList *efl, UA_EventFilterResult *result) {
+static UA_StatusCode
+filterEventInternal(UA_Server *server, UA_Session *session,
+                    const UA_NodeId *eventNode, const UA_KeyValueMap *eventFields,
+                    UA_EventFilter *filter, UA_EventFilterCache *cache,
+                    UA_EventFieldList *efl) {
     UA_LOCK_ASSERT(&server->serviceMutex);
 
+    UA_EventFieldList_init(efl);
     if(filter->selectClausesSize == 0)
         return UA_STATUSCODE_BADEVENTFILTERINVALID;
 
-    UA_EventFieldList_init(efl);
+    /* Evaluate the where filter. Do we event need to consider the event? The
+     * ContentFilterResult is only reported during the validation. Don't
+     * allocate it for every event. */
+    UA_FilterEvalContext ctx;
+    initFilterEvalContext(&ctx, server, session, eventNode, eventFields,
+                          &filter->whereClause, NULL, cache);
+    UA_StatusCode res = evaluateWhereClauseContext(&ctx);
+    if(res != UA_STATUSCODE_GOOD) {
+        clearFilterEvalContext(&ctx);
+        return res;
+    }
+
     efl->eventFields = (UA_Variant *)
         UA_Array_new(filter->selectClausesSize, &UA_TYPES[UA_TYPES_VARIANT]);
-    if(!efl->eventFields)
-        return UA_STATUSCODE_BADOUTOFMEMORY;
-    efl->eventFieldsSize = filter->selectClausesSize;
-
-    /* Empty event filter result */
-    UA_EventFilterResult_init(result);
-    result->selectClauseResultsSize = filter->selectClausesSize;
-    result->selectClauseResults = (UA_StatusCode *)
-        UA_Array_new(filter->selectClausesSize, &UA_TYPES[UA_TYPES_STATUSCODE]);
-    if(!result->selectClauseResults) {
-        UA_EventFieldList_clear(efl);
-        UA_EventFilterResult_clear(result);
+    if(!efl->eventFields) {
+        clearFilterEvalContext(&ctx);
         return UA_STATUSCODE_BADOUTOFMEMORY;
     }
+    efl->eventFieldsSize = filter->selectClausesSize;
 
-    /* Prepare content filter result structure */
-    if(filter->whereClause.elementsSize > 0) {
-        result->whereClauseResult.elementResultsSize = filter->whereClause.elementsSize;
-        result->whereClauseResult.elementResults = (UA_ContentFilterElementResult *)
-            UA_Array_new(filter->whereClause.elementsSize,
-                         &UA_TYPES[UA_TYPES_CONTENTFILTERELEMENTRESULT]);
-        if(!result->whereClauseResult.elementResults) {
-            UA_EventFieldList_clear(efl);
-            UA_EventFilterResult_clear(result);
-            return UA_STATUSCODE_BADOUTOFMEMORY;
-        }
-
-        for(size_t i = 0; i < filter->whereClause.elementsSize; ++i) {
-            UA_ContentFilterElementResult *er =
-                &result->whereClauseResult.elementResults[i];
-            UA_ContentFilterElement *cf = &filter->whereClause.elements[i];
-            er->operandStatusCodesSize = cf->filterOperandsSize;
-            er->operandStatusCodes = (UA_StatusCode *)
-                UA_Array_new(er->operandStatusCodesSize, &UA_TYPES[UA_TYPES_STATUSCODE]);
-            if(!er->operandStatusCodes) {
-                UA_EventFieldList_clear(efl);
-                UA_EventFilterResult_clear(result);
-                return UA_STATUSCODE_BADOUTOFMEMORY;
+    /* Prepare the projection table for the flat fields */
+    UA_UInt16 *fieldIndex = NULL;
+    if(eventFields && cache) {
+        if(cache->fieldIndexSize != filter->selectClausesSize) {
+            UA_free(cache->fieldIndex);
+            cache->fieldIndexSize = 0;
+            cache->fieldIndex = (UA_UInt16*)
+                UA_malloc(sizeof(UA_UInt16) * filter->selectClausesSize);
+            if(cache->fieldIndex) {
+                cache->fieldIndexSize = filter->selectClausesSize;
+                for(size_t i = 0; i < cache->fieldIndexSize; i++)
+                    cache->fieldIndex[i] = UA_UINT16_MAX;
             }
         }
-    }
-
-    /* Evaluate the where filter. Do we event need to consider the event? */
-    UA_StatusCode res = evaluateWhereClause(server, session, eventNode,
-                                            &filter->whereClause,
-                                            &result->whereClauseResult);
-    if(res != UA_STATUSCODE_GOOD){
-        UA_EventFieldList_clear(efl);
-        UA_EventFilterResult_clear(result);
-        return res;
+        fieldIndex = cache->fieldIndex;
     }
 
     /* Apply the select filter */
@@ -1089,24 +1282,39 @@ filterEvent(UA_Server *server, UA_Session *session,
         /* Check if the browsePath is BaseEventType, in which case nothing more
          * needs to be checked */
         if(!UA_NodeId_equal(&sc->typeDefinitionId, &baseEventTypeId) &&
-           !isValidEvent(server, &sc->typeDefinitionId, eventNode)) {
-            UA_Variant_init(&efl->eventFields[i]);
-            /* EventFilterResult currently isn't being used
-               notification->result.selectClauseResults[i] =
-                   UA_STATUSCODE_BADTYPEDEFINITIONINVALID; */
+           !isValidSelectClause(&ctx, sc, i))
             continue;
-        }
 
         /* Lookup the field. The overall filter can succeed even if a single
          * select-field cannot be resolved. */
-        result->selectClauseResults[i] =
+        if(eventFields)
+            resolveEventField(eventFields, sc, (fieldIndex) ? &fieldIndex[i] : NULL,
+                              &efl->eventFields[i]);
+        else
             resolveSimpleAttributeOperand(server, session, eventNode,
                                           sc, &efl->eventFields[i]);
     }
 
+    clearFilterEvalContext(&ctx);
     return UA_STATUSCODE_GOOD;
 }
 
+UA_StatusCode
+filterEvent(UA_Server *server, UA_Session *session,
+            const UA_NodeId *eventNode, UA_EventFilter *filter,
+            UA_EventFilterCache *cache, UA_EventFieldList *efl) {
+    return filterEventInternal(server, session, eventNode, NULL,
+                               filter, cache, efl);
+}
+
+UA_StatusCode
+filterEventFields(UA_Server *server, UA_Session *session,
+                  const UA_KeyValueMap *eventFields, UA_EventFilter *filter,
+                  UA_EventFilterCache *cache, UA_EventFieldList *efl) {
+    return filterEventInternal(server, session, NULL, eventFields,
+                               filter, cache, efl);
+}
+
 /*****************************************/
 /* Validation of Filters during Creation */
 /*****************************************/
@@ -18,6 +18,38 @@
 #include "ua_securechannel.h"
 #include "ua_types_encoding_binary.h"
 
+/* Chunks of long messages can be decrypted and verified by parallel worker
+ * threads (see decryptChunksParallel). The first OPN chunk of a new channel
+ * can be handed to a worker thread (see startAsyncHandshake). */
+#if UA_MULTITHREADING >= 200 && defined(UA_ARCHITECTURE_POSIX)
+#define UA_PARALLEL_DECRYPT
+#include <pthread.h>
+
+/* The first OPN chunk of a new channel is decrypted and verified by a worker
+ * thread if asyncHandshake is set. The channel does not process further chunks
+ * until the worker is done. The worker then registers a delayed callback that
+ * resumes the processing from the EventLoop. */
+struct UA_AsyncHandshake {
+    UA_SecureChannel *channel; /* NULL if the channel was cleared meanwhile */
+    UA_Chunk *chunk;
+    size_t offset;
+    void *application;
+    UA_ProcessMessageCallback *callback;
+    UA_EventLoop *el;
+    pthread_t thread;
+    UA_Boolean joined;
+    UA_DelayedCallback dc;
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+    /* The allocator is thread-local. Use the same as the processing thread. */
+    void * (*mallocSingleton)(size_t size);
+    void (*freeSingleton)(void *ptr);
+    void * (*callocSingleton)(size_t nelem, size_t elsize);
+    void * (*reallocSingleton)(void *ptr, size_t size);
+    UA_MemoryCategory memoryCategory;
+#endif
+};
+#endif
+
 #define UA_BITMASK_MESSAGETYPE 0x00ffffffu
 #define UA_BITMASK_CHUNKTYPE 0xff000000u
 
@@ -86,6 +118,14 @@ UA_SecureChannel_isConnected(UA_SecureChannel *channel) {
             channel->state < UA_SECURECHANNELSTATE_CLOSING);
 }
 
+UA_Boolean
+UA_SecureChannel_isSendCongested(UA_SecureChannel *channel) {
+    UA_ConnectionManager *cm = channel->connectionManager;
+    if(!cm || !cm->getSendQueueSize || !UA_SecureChannel_isConnected(channel))
+        return false;
+    return (cm->getSendQueueSize(cm, channel->connectionId) > 0);
+}
+
 void
 UA_SecureChannel_sendError(UA_SecureChannel *channel, UA_TcpErrorMessage *error) {
     if(!UA_SecureChannel_isConnected(channel))
@@ -117,6 +157,7 @@ UA_SecureChannel_sendError(UA_SecureChannel *channel, UA_TcpErrorMessage *error)
                                       &bufPos, &bufEnd, NULL, NULL);
     (void)retval; /* Encoding of these cannot fail */
     msg.length = header.messageSize;
+    UA_SecureChannel_capture(channel, true, msg.data, msg.length);
     cm->sendWithConnection(cm, channel->connectionId, &UA_KEYVALUEMAP_NULL, &msg);
 }
 
@@ -124,9 +165,38 @@ static void
 UA_Chunk_delete(UA_Chunk *chunk) {
     if(chunk->copied)
         UA_ByteString_clear(&chunk->bytes);
+    if(chunk->retainedIn)
+        chunk->retainedIn->freeNetworkBuffer(chunk->retainedIn,
+                                             chunk->retainedConnectionId,
+                                             &chunk->retained);
     UA_free(chunk);
 }
 
+/* The chunk has to outlive the network buffer. Retain the buffer in the
+ * ConnectionManager if possible. Otherwise copy the bytes. */
+static UA_StatusCode
+persistChunk(UA_SecureChannel *channel, UA_Chunk *chunk) {
+    if(chunk->copied || chunk->retainedIn)
+        return UA_STATUSCODE_GOOD;
+
+    UA_ConnectionManager *cm = channel->connectionManager;
+    if(cm && cm->retainNetworkBuffer && chunk->bytes.length > 0 &&
+       cm->retainNetworkBuffer(cm, channel->connectionId,
+                               &chunk->bytes) == UA_STATUSCODE_GOOD) {
+        chunk->retainedIn = cm;
+        chunk->retainedConnectionId = channel->connectionId;
+        chunk->retained = chunk->bytes;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    UA_ByteString copy;
+    UA_StatusCode res = UA_ByteString_copy(&chunk->bytes, &copy);
+    UA_CHECK_STATUS(res, return res);
+    chunk->bytes = copy;
+    chunk->copied = true;
+    return UA_STATUSCODE_GOOD;
+}
+
 static void
 deleteChunks(UA_ChunkQueue *queue) {
     UA_Chunk *chunk;
@@ -141,6 +211,7 @@ UA_SecureChannel_deleteBuffered(UA_SecureChannel *channel) {
     deleteChunks(&channel->completeChunks);
     deleteChunks(&channel->decryptedChunks);
     UA_ByteString_clear(&channel->incompleteChunk);
+    channel->incompleteChunkSize = 0;
 }
 
 void
@@ -164,6 +235,18 @@ UA_SecureChannel_clear(UA_SecureChannel *channel) {
     /* No sessions must be attached to this any longer */
     UA_assert(channel->sessions == NULL);
 
+#ifdef UA_PARALLEL_DECRYPT
+    /* Wait for the worker of a pending handshake before the context and the
+     * chunks are removed. The delayed callback is already registered and
+     * frees the handshake. */
+    if(channel->handshake) {
+        pthread_join(channel->handshake->thread, NULL);
+        channel->handshake->joined = true;
+        channel->handshake->channel = NULL;
+        channel->handshake = NULL;
+    }
+#endif
+
     /* Delete the channel context for the security policy */
     if(channel->securityPolicy) {
         channel->securityPolicy->channelModule.deleteContext(channel->channelContext);
@@ -190,6 +273,13 @@ UA_SecureChannel_clear(UA_SecureChannel *channel) {
     /* Delete remaining chunks */
     UA_SecureChannel_deleteBuffered(channel);
 
+    /* The pinned nodes were released after each request. Only the array
+     * remains. */
+    UA_free(channel->pinnedNodes);
+    channel->pinnedNodes = NULL;
+    channel->pinnedNodesSize = 0;
+    channel->pinnedNodesCapacity = 0;
+
     /* Reset the SecureChannel for reuse (in the client) */
     channel->securityMode = UA_MESSAGESECURITYMODE_INVALID;
     channel->shutdownReason = UA_SHUTDOWNREASON_CLOSE;
@@ -291,6 +381,7 @@ UA_SecureChannel_sendAsymmetricOPNMessage(UA_SecureChannel *channel,
                              securityHeaderLength, requestId, &encryptedLength);
     UA_CHECK_STATUS(res, goto error);
 
+    UA_SecureChannel_capture(channel, true, buf.data, pre_sig_length);
     res = signAndEncryptAsym(channel, pre_sig_length, &buf,
                              securityHeaderLength, total_length);
     UA_CHECK_STATUS(res, goto error);
@@ -354,12 +445,54 @@ encodeHeadersSym(UA_MessageContext *mc, size_t totalLength) {
     return res;
 }
 
+/* Send out the completed network buffers */
+static UA_StatusCode
+flushNetworkBuffers(UA_MessageContext *mc) {
+    UA_SecureChannel *channel = mc->channel;
+    UA_ConnectionManager *cm = channel->connectionManager;
+    if(mc->sendBuffersSize == 0)
+        return UA_STATUSCODE_GOOD;
+
+    /* The buffers are freed in the network layer. If sending goes wrong, the
+     * connection is removed in the next iteration of the SecureChannel. Set
+     * the SecureChannel to closing already. */
+    UA_StatusCode res;
+    if(mc->sendBuffersSize == 1)
+        res = cm->sendWithConnection(cm, channel->connectionId,
+                                     &UA_KEYVALUEMAP_NULL, &mc->sendBuffers[0]);
+    else
+        res = cm->sendWithConnectionV(cm, channel->connectionId,
+                                      &UA_KEYVALUEMAP_NULL, mc->sendBuffers,
+                                      mc->sendBuffersSize);
+    mc->sendBuffersSize = 0;
+    if(res != UA_STATUSCODE_GOOD && UA_SecureChannel_isConnected(channel))
+        channel->state = UA_SECURECHANNELSTATE_CLOSING;
+    return res;
+}
+
+/* Complete the network buffer. If the ConnectionManager supports
+ * scatter-gather sending, the network buffers are held back and sent out
+ * together once the message is finished. */
+static UA_StatusCode
+sendNetworkBuffer(UA_MessageContext *mc) {
+    UA_ConnectionManager *cm = mc->channel->connectionManager;
+    mc->networkBuffer.length = mc->networkBufferPos;
+    mc->networkBufferPos = 0;
+    mc->messageBuffer = UA_BYTESTRING_NULL;
+    mc->sendBuffers[mc->sendBuffersSize++] = mc->networkBuffer;
+    mc->networkBuffer = UA_BYTESTRING_NULL;
+    if(!mc->final && cm->sendWithConnectionV &&
+       mc->sendBuffersSize < UA_SECURECHANNEL_SEND_BUFFERS)
+        return UA_STATUSCODE_GOOD;
+    return flushNetworkBuffers(mc);
+}
+
 static UA_StatusCode
 sendSymmetricChunk(UA_MessageContext *mc) {
     UA_SecureChannel *channel = mc->channel;
     const UA_SecurityPolicy *sp = channel->securityPolicy;
     UA_ConnectionManager *cm = channel->connectionManager;
-    if(!UA_SecureChannel_isConnected(channel))
+    if(UA_UNLIKELY(!UA_SecureChannel_isConnected(channel)))
         return UA_STATUSCODE_BADCONNECTIONCLOSED;
 
     /* The size of the message payload */
@@ -411,21 +544,26 @@ sendSymmetricChunk(UA_MessageContext *mc) {
     res = encodeHeadersSym(mc, total_length);
     UA_CHECK_STATUS(res, goto error);
 
-    /* Sign and encrypt the messge */
+    /* Capture the plaintext and sign and encrypt the messge */
+    UA_SecureChannel_capture(channel, true, mc->messageBuffer.data, pre_sig_length);
     res = signAndEncryptSym(mc, pre_sig_length, total_length);
     UA_CHECK_STATUS(res, goto error);
 
-    /* Send the chunk. The buffer is freed in the network layer. If sending goes
-     * wrong, the connection is removed in the next iteration of the
-     * SecureChannel. Set the SecureChannel to closing already. */
-    res = cm->sendWithConnection(cm, channel->connectionId,
-                                 &UA_KEYVALUEMAP_NULL, &mc->messageBuffer);
-    if(res != UA_STATUSCODE_GOOD && UA_SecureChannel_isConnected(channel))
-        channel->state = UA_SECURECHANNELSTATE_CLOSING;
+    /* Send out once the network buffer cannot take another chunk */
+    mc->networkBufferPos += total_length;
+    if(mc->final || mc->networkBuffer.length - mc->networkBufferPos <
+       channel->config.sendBufferSize)
+        res = sendNetworkBuffer(mc);
+    return res;
 
  error:
-    /* Free the unused message buffer */
-    cm->freeNetworkBuffer(cm, channel->connectionId, &mc->messageBuffer);
+    /* Send the chunks completed so far. Their sequence numbers have already
+     * been used. Then free the unused network buffer. */
+    if(mc->networkBufferPos > 0)
+        sendNetworkBuffer(mc);
+    flushNetworkBuffers(mc);
+    cm->freeNetworkBuffer(cm, channel->connectionId, &mc->networkBuffer);
+    mc->messageBuffer = UA_BYTESTRING_NULL;
     return res;
 }
 
@@ -444,15 +582,28 @@ sendSymmetricEncodingCallback(void *data, UA_Byte **buf_pos,
 
     /* Set a new buffer for the next chunk */
     UA_ConnectionManager *cm = mc->channel->connectionManager;
-    if(!UA_SecureChannel_isConnected(mc->channel))
+    if(UA_UNLIKELY(!UA_SecureChannel_isConnected(mc->channel)))
         return UA_STATUSCODE_BADCONNECTIONCLOSED;
 
-    res = cm->allocNetworkBuffer(cm, mc->channel->connectionId,
-                                 &mc->messageBuffer,
-                                 mc->channel->config.sendBufferSize);
-    UA_CHECK_STATUS(res, return res);
+    /* The network buffer was sent out. Allocate a new one with space for
+     * several chunks. A ConnectionManager with a static send buffer might
+     * only provide the space for a single chunk. */
+    size_t chunkSize = mc->channel->config.sendBufferSize;
+    if(mc->networkBuffer.length == 0) {
+        res = UA_STATUSCODE_BADOUTOFMEMORY;
+        if(chunkSize <= SIZE_MAX / UA_SECURECHANNEL_SEND_CHUNKS)
+            res = cm->allocNetworkBuffer(cm, mc->channel->connectionId,
+                                         &mc->networkBuffer,
+                                         chunkSize * UA_SECURECHANNEL_SEND_CHUNKS);
+        if(res != UA_STATUSCODE_GOOD)
+            res = cm->allocNetworkBuffer(cm, mc->channel->connectionId,
+                                         &mc->networkBuffer, chunkSize);
+        UA_CHECK_STATUS(res, return res);
+    }
 
     /* Hide bytes for header, padding and signature */
+    mc->messageBuffer.data = &mc->networkBuffer.data[mc->networkBufferPos];
+    mc->messageBuffer.length = chunkSize;
     setBufPos(mc);
     *buf_pos = mc->buf_pos;
     *buf_end = mc->buf_end;
@@ -466,7 +617,7 @@ UA_MessageContext_begin(UA_MessageContext *mc, UA_SecureChannel *channel,
              return UA_STATUSCODE_BADINTERNALERROR);
 
     UA_ConnectionManager *cm = channel->connectionManager;
-    if(!UA_SecureChannel_isConnected(channel))
+    if(UA_UNLIKELY(!UA_SecureChannel_isConnected(channel)))
         return UA_STATUSCODE_BADCONNECTIONCLOSED;
 
     /* Create the chunking info structure */
@@ -475,17 +626,21 @@ UA_MessageContext_begin(UA_MessageContext *mc, UA_SecureChannel *channel,
     mc->chunksSoFar = 0;
     mc->messageSizeSoFar = 0;
     mc->final = false;
-    mc->messageBuffer = UA_BYTESTRING_NULL;
+    mc->networkBuffer = UA_BYTESTRING_NULL;
+    mc->networkBufferPos = 0;
+    mc->sendBuffersSize = 0;
     mc->messageType = messageType;
 
-    /* Allocate the message buffer */
+    /* Allocate the network buffer for the first chunk. Most messages have only
+     * a single chunk. */
     UA_StatusCode res =
         cm->allocNetworkBuffer(cm, channel->connectionId,
-                               &mc->messageBuffer,
+                               &mc->networkBuffer,
                                channel->config.sendBufferSize);
     UA_CHECK_STATUS(res, return res);
 
     /* Hide bytes for header, padding and signature */
+    mc->messageBuffer = mc->networkBuffer;
     setBufPos(mc);
     return UA_STATUSCODE_GOOD;
 }
@@ -496,11 +651,39 @@ UA_MessageContext_encode(UA_MessageContext *mc, const void *content,
     UA_StatusCode res =
         UA_encodeBinaryInternal(content, contentType, &mc->buf_pos, &mc->buf_end,
                                 sendSymmetricEncodingCallback, mc);
-    if(res != UA_STATUSCODE_GOOD && mc->messageBuffer.length > 0)
+    if(UA_UNLIKELY(res != UA_STATUSCODE_GOOD) && mc->messageBuffer.length > 0)
         UA_MessageContext_abort(mc);
     return res;
 }
 
+UA_StatusCode
+UA_MessageContext_encodeRaw(UA_MessageContext *mc, const UA_ByteString *raw) {
+    const UA_Byte *pos = raw->data;
+    size_t left = raw->length;
+    while(left > 0) {
+        /* Exchange the buffer if the current chunk is full */
+        if(mc->buf_pos >= mc->buf_end) {
+            UA_StatusCode res =
+                sendSymmetricEncodingCallback(mc, &mc->buf_pos, &mc->buf_end);
+            if(res != UA_STATUSCODE_GOOD) {
+                if(mc->messageBuffer.length > 0)
+                    UA_MessageContext_abort(mc);
+                return res;
+            }
+        }
+
+        /* Copy as much as fits into the chunk */
+        size_t len = (size_t)(mc->buf_end - mc->buf_pos);
+        if(len > left)
+            len = left;
+        memcpy(mc->buf_pos, pos, len);
+        mc->buf_pos += len;
+        pos += len;
+        left -= len;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
 UA_StatusCode
 UA_MessageContext_finish(UA_MessageContext *mc) {
     mc->final = true;
@@ -510,9 +693,25 @@ UA_MessageContext_finish(UA_MessageContext *mc) {
 void
 UA_MessageContext_abort(UA_MessageContext *mc) {
     UA_ConnectionManager *cm = mc->channel->connectionManager;
-    if(!UA_SecureChannel_isConnected(mc->channel))
+    if(!UA_SecureChannel_isConnected(mc->channel)) {
+        if(!cm)
+            return;
+        /* Release the held back network buffers */
+        for(size_t i = 0; i < mc->sendBuffersSize; i++)
+            cm->freeNetworkBuffer(cm, mc->channel->connectionId,
+                                  &mc->sendBuffers[i]);
+        mc->sendBuffersSize = 0;
+        cm->freeNetworkBuffer(cm, mc->channel->connectionId, &mc->networkBuffer);
+        mc->messageBuffer = UA_BYTESTRING_NULL;
         return;
-    cm->freeNetworkBuffer(cm, mc->channel->connectionId, &mc->messageBuffer);
+    }
+    /* Send the chunks completed so far. Their sequence numbers have already
+     * been used. */
+    if(mc->networkBufferPos > 0)
+        sendNetworkBuffer(mc);
+    flushNetworkBuffers(mc);
+    cm->freeNetworkBuffer(cm, mc->channel->connectionId, &mc->networkBuffer);
+    mc->messageBuffer = UA_BYTESTRING_NULL;
 }
 
 UA_StatusCode
@@ -566,8 +765,178 @@ processSequenceNumberSym(UA_SecureChannel *channel, UA_UInt32 sequenceNumber) {
 }
 #endif
 
+#ifdef UA_PARALLEL_DECRYPT
+
+static UA_StatusCode
+processChunks(UA_SecureChannel *channel, void *application,
+              UA_ProcessMessageCallback callback,
+              UA_DateTime nowMonotonic);
+
+static void *
+processAsyncHandshake(void *data) {
+    struct UA_AsyncHandshake *hs = (struct UA_AsyncHandshake*)data;
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+    UA_mallocSingleton = hs->mallocSingleton;
+    UA_freeSingleton = hs->freeSingleton;
+    UA_callocSingleton = hs->callocSingleton;
+    UA_reallocSingleton = hs->reallocSingleton;
+    UA_memoryCategory = hs->memoryCategory;
+#endif
+    const UA_SecureChannel *channel = hs->channel;
+    UA_Chunk *chunk = hs->chunk;
+    chunk->decryptResult =
+        decryptAndVerifyChunk(channel, &channel->securityPolicy->asymmetricModule.cryptoModule,
+                              chunk->messageType, &chunk->bytes, hs->offset);
+    chunk->decrypted = true;
+    hs->el->addDelayedCallback(hs->el, &hs->dc);
+    return NULL;
+}
+
+/* Resume the processing of the channel in the EventLoop */
+static void
+finishAsyncHandshake(void *application, void *context) {
+    (void)application;
+    struct UA_AsyncHandshake *hs = (struct UA_AsyncHandshake*)context;
+    if(!hs->joined)
+        pthread_join(hs->thread, NULL);
+    UA_SecureChannel *channel = hs->channel;
+    void *processApplication = hs->application;
+    UA_ProcessMessageCallback *callback = hs->callback;
+    UA_EventLoop *el = hs->el;
+    UA_free(hs);
+
+    /* The channel was cleared while the handshake was pending */
+    if(!channel)
+        return;
+    channel->handshake = NULL;
+    channel->handshakeOffloaded = true;
+    if(!UA_SecureChannel_isConnected(channel))
+        return;
+
+    /* Process the OPN chunk (already decrypted) and the chunks received in
+     * the meantime. Same as for errors returned from processBuffer. */
+    UA_StatusCode res = processChunks(channel, processApplication, callback,
+                                      el->dateTime_nowMonotonic(el));
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_TcpErrorMessage error;
+        error.error = res;
+        error.reason = UA_STRING_NULL;
+        UA_SecureChannel_sendError(channel, &error);
+        UA_SecureChannel_shutdown(channel, UA_SHUTDOWNREASON_ABORT);
+    }
+}
+
+/* Hand the decryption of the first OPN chunk to a worker thread. The chunk is
+ * copied first as the network buffer is released before the worker is done.
+ * Returns false if the chunk shall be decrypted right away. */
+static UA_Boolean
+startAsyncHandshake(UA_SecureChannel *channel, UA_Chunk *chunk, size_t offset,
+                    void *application, UA_ProcessMessageCallback callback) {
+    if(!channel->asyncHandshake || channel->handshake ||
+       channel->state == UA_SECURECHANNELSTATE_OPEN || !channel->connectionManager ||
+       UA_String_equal(&channel->securityPolicy->policyUri, &UA_SECURITY_POLICY_NONE_URI))
+        return false;
+
+    if(persistChunk(channel, chunk) != UA_STATUSCODE_GOOD)
+        return false;
+
+    struct UA_AsyncHandshake *hs = (struct UA_AsyncHandshake*)
+        UA_calloc(1, sizeof(struct UA_AsyncHandshake));
+    if(!hs)
+        return false;
+    hs->channel = channel;
+    hs->chunk = chunk;
+    hs->offset = offset;
+    hs->application = application;
+    hs->callback = callback;
+    hs->el = channel->connectionManager->eventSource.eventLoop;
+    hs->dc.callback = finishAsyncHandshake;
+    hs->dc.context = hs;
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+    hs->mallocSingleton = UA_mallocSingleton;
+    hs->freeSingleton = UA_freeSingleton;
+    hs->callocSingleton = UA_callocSingleton;
+    hs->reallocSingleton = UA_reallocSingleton;
+    hs->memoryCategory = UA_memoryCategory;
+#endif
+    channel->handshake = hs;
+    if(pthread_create(&hs->thread, NULL, processAsyncHandshake, hs) != 0) {
+        channel->handshake = NULL;
+        UA_free(hs);
+        return false;
+    }
+    return true;
+}
+
+#endif /* UA_PARALLEL_DECRYPT */
+
+void
+UA_CertificateCache_clear(UA_CertificateCache *cache) {
+    for(size_t i = 0; i < cache->size; i++)
+        UA_ByteString_clear(&cache->entries[i].certificate);
+    cache->size = 0;
+    cache->next = 0;
+}
+
+/* Verify the remote certificate with the CertificateGroup. Skip the
+ * verification if the certificate has passed it recently. */
+static UA_StatusCode
+verifyRemoteCertificate(UA_SecureChannel *channel,
+                        const UA_ByteString *certificate) {
+    if(!channel->certificateVerification)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    UA_CertificateGroup *cg = channel->certificateVerification;
+    UA_CertificateCache *cache = channel->certificateCache;
+    if(!cache || cache->ttl <= 0 || !channel->connectionManager)
+        return cg->verifyCertificate(cg, certificate);
+
+    /* Look up the certificate */
+    UA_EventLoop *el = channel->connectionManager->eventSource.eventLoop;
+    UA_DateTime now = el->dateTime_nowMonotonic(el);
+    UA_UInt32 hash = UA_ByteString_hash(0, certificate->data, certificate->length);
+    UA_CertificateCacheEntry *entry = NULL;
+    for(size_t i = 0; i < cache->size; i++) {
+        UA_CertificateCacheEntry *e = &cache->entries[i];
+        if(e->hash == hash && UA_ByteString_equal(&e->certificate, certificate)) {
+            if(e->expires > now) {
+                cache->hits++;
+                return UA_STATUSCODE_GOOD;
+            }
+            entry = e; /* Expired, verify again */
+            break;
+        }
+        if(!entry && e->expires <= now)
+            entry = e; /* Reuse the first expired entry */
+    }
+
+    UA_StatusCode res = cg->verifyCertificate(cg, certificate);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    /* Add to the cache. Failing to do so is not an error. */
+    if(!entry) {
+        if(cache->size < UA_CERTIFICATECACHE_SIZE) {
+            entry = &cache->entries[cache->size++];
+        } else {
+            entry = &cache->entries[cache->next];
+            cache->next = (cache->next + 1) % UA_CERTIFICATECACHE_SIZE;
+        }
+    }
+    if(!UA_ByteString_equal(&entry->certificate, certificate)) {
+        UA_ByteString_clear(&entry->certificate);
+        if(UA_ByteString_copy(certificate, &entry->certificate) != UA_STATUSCODE_GOOD) {
+            entry->expires = 0;
+            return UA_STATUSCODE_GOOD;
+        }
+    }
+    entry->hash = hash;
+    entry->expires = now + cache->ttl;
+    return UA_STATUSCODE_GOOD;
+}
+
 static UA_StatusCode
-unpackPayloadOPN(UA_SecureChannel *channel, UA_Chunk *chunk, void *application) {
+unpackPayloadOPN(UA_SecureChannel *channel, UA_Chunk *chunk, void *application,
+                 UA_ProcessMessageCallback callback) {
     UA_assert(chunk->bytes.length >= UA_SECURECHANNEL_MESSAGE_MIN_LENGTH);
     size_t offset = UA_SECURECHANNEL_MESSAGEHEADER_LENGTH; /* Skip the message header */
     UA_UInt32 secureChannelId;
@@ -579,13 +948,10 @@ unpackPayloadOPN(UA_SecureChannel *channel, UA_Chunk *chunk, void *application)
              &UA_TRANSPORT[UA_TRANSPORT_ASYMMETRICALGORITHMSECURITYHEADER], NULL);
     UA_CHECK_STATUS(res, return res);
 
-    if(asymHeader.senderCertificate.length > 0) {
-        if(channel->certificateVerification)
-            res = channel->certificateVerification->
-                verifyCertificate(channel->certificateVerification,
-                                  &asymHeader.senderCertificate);
-        else
-            res = UA_STATUSCODE_BADINTERNALERROR;
+    /* The certificate was already verified before the chunk was handed to
+     * the worker thread of an async handshake */
+    if(asymHeader.senderCertificate.length > 0 && !chunk->decrypted) {
+        res = verifyRemoteCertificate(channel, &asymHeader.senderCertificate);
         UA_CHECK_STATUS(res, goto error);
     }
 
@@ -593,7 +959,7 @@ unpackPayloadOPN(UA_SecureChannel *channel, UA_Chunk *chunk, void *application)
     if(!channel->securityPolicy) {
         if(channel->processOPNHeader)
             res = channel->processOPNHeader(application, channel, &asymHeader);
-        if(!channel->securityPolicy)
+        if(res == UA_STATUSCODE_GOOD && !channel->securityPolicy)
             res = UA_STATUSCODE_BADINTERNALERROR;
         UA_CHECK_STATUS(res, goto error);
     }
@@ -621,11 +987,25 @@ unpackPayloadOPN(UA_SecureChannel *channel, UA_Chunk *chunk, void *application)
     UA_AsymmetricAlgorithmSecurityHeader_clear(&asymHeader);
     UA_CHECK_STATUS(res, return res);
 
-    /* Decrypt the chunk payload */
-    res = decryptAndVerifyChunk(channel,
-                                &channel->securityPolicy->asymmetricModule.cryptoModule,
-                                chunk->messageType, &chunk->bytes, offset);
+    /* Decrypt the chunk payload. Unless this was already done by the worker
+     * of an async handshake. */
+    if(chunk->decrypted) {
+        res = chunk->decryptResult;
+    } else {
+#ifdef UA_PARALLEL_DECRYPT
+        if(startAsyncHandshake(channel, chunk, offset, application, callback))
+            return UA_STATUSCODE_GOODCOMPLETESASYNCHRONOUSLY;
+#else
+        (void)callback;
+#endif
+        res = decryptAndVerifyChunk(channel,
+                                    &channel->securityPolicy->asymmetricModule.cryptoModule,
+                                    chunk->messageType, &chunk->bytes, offset);
+    }
     UA_CHECK_STATUS(res, return res);
+    if(channel->securityPolicy->asymmetricModule.cryptoModule.
+       signatureAlgorithm.uri.length > 0)
+        channel->securedChunksReceived++;
 
     /* Decode the SequenceHeader */
     UA_SequenceHeader sequenceHeader;
@@ -664,7 +1044,7 @@ unpackPayloadMSG(UA_SecureChannel *channel, UA_Chunk *chunk,
 
 #if !defined(FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION)
     /* Check the ChannelId. Non-opened channels have the id zero. */
-    if(secureChannelId != channel->securityToken.channelId)
+    if(UA_UNLIKELY(secureChannelId != channel->securityToken.channelId))
         return UA_STATUSCODE_BADSECURECHANNELIDINVALID;
 #endif
 
@@ -672,11 +1052,17 @@ unpackPayloadMSG(UA_SecureChannel *channel, UA_Chunk *chunk,
     res = checkSymHeader(channel, tokenId, nowMonotonic);
     UA_CHECK_STATUS(res, return res);
 
-    /* Decrypt the chunk payload */
-    res = decryptAndVerifyChunk(channel,
-                                &channel->securityPolicy->symmetricModule.cryptoModule,
-                                chunk->messageType, &chunk->bytes, offset);
+    /* Decrypt the chunk payload. Unless this was already done in a parallel
+     * batch. */
+    if(chunk->decrypted)
+        res = chunk->decryptResult;
+    else
+        res = decryptAndVerifyChunk(channel,
+                                    &channel->securityPolicy->symmetricModule.cryptoModule,
+                                    chunk->messageType, &chunk->bytes, offset);
     UA_CHECK_STATUS(res, return res);
+    if(channel->securityMode != UA_MESSAGESECURITYMODE_NONE)
+        channel->securedChunksReceived++;
 
     /* Check the sequence number. Skip sequence number checking for fuzzer to
      * improve coverage */
@@ -707,7 +1093,7 @@ assembleProcessMessage(UA_SecureChannel *channel, void *application,
         SIMPLEQ_REMOVE_HEAD(&channel->decryptedChunks, pointers);
         UA_assert(chunk->chunkType == UA_CHUNKTYPE_FINAL);
         res = callback(application, channel, chunk->messageType,
-                       chunk->requestId, &chunk->bytes);
+                       chunk->requestId, &chunk->bytes, 1);
         UA_Chunk_delete(chunk);
         return res;
     }
@@ -717,7 +1103,7 @@ assembleProcessMessage(UA_SecureChannel *channel, void *application,
     UA_ChunkType chunkType = chunk->chunkType;
     UA_assert(chunkType == UA_CHUNKTYPE_INTERMEDIATE);
 
-    size_t messageSize = 0;
+    size_t chunksSize = 0;
     SIMPLEQ_FOREACH(chunk, &channel->decryptedChunks, pointers) {
         /* Consistency check */
         if(requestId != chunk->requestId)
@@ -727,63 +1113,292 @@ assembleProcessMessage(UA_SecureChannel *channel, void *application,
         if(chunk->messageType != messageType)
             return UA_STATUSCODE_BADTCPMESSAGETYPEINVALID;
 
-        /* Sum up the lengths */
-        messageSize += chunk->bytes.length;
+        chunksSize++;
         if(chunk->chunkType == UA_CHUNKTYPE_FINAL)
             break;
     }
 
-    /* Allocate memory for the full message */
-    UA_ByteString payload;
-    res = UA_ByteString_allocBuffer(&payload, messageSize);
-    UA_CHECK_STATUS(res, return res);
-
-    /* Assemble the full message */
-    size_t offset = 0;
-    while(true) {
+    /* The message is decoded directly from the chunks. Only the list of the
+     * chunk payloads is allocated. */
+    UA_ByteString *segments = (UA_ByteString*)
+        UA_malloc(chunksSize * sizeof(UA_ByteString));
+    UA_CHECK_MEM(segments, return UA_STATUSCODE_BADOUTOFMEMORY);
+
+    /* Take the chunks of the message from the queue. The channel could be
+     * cleared in the callback. */
+    UA_ChunkQueue messageChunks;
+    SIMPLEQ_INIT(&messageChunks);
+    for(size_t i = 0; i < chunksSize; i++) {
         chunk = SIMPLEQ_FIRST(&channel->decryptedChunks);
-        memcpy(&payload.data[offset], chunk->bytes.data, chunk->bytes.length);
-        offset += chunk->bytes.length;
         SIMPLEQ_REMOVE_HEAD(&channel->decryptedChunks, pointers);
-        UA_ChunkType ct = chunk->chunkType;
-        UA_Chunk_delete(chunk);
-        if(ct == UA_CHUNKTYPE_FINAL)
-            break;
+        SIMPLEQ_INSERT_TAIL(&messageChunks, chunk, pointers);
+        segments[i] = chunk->bytes;
     }
 
-    /* Process the assembled message */
-    res = callback(application, channel, messageType, requestId, &payload);
-    UA_ByteString_clear(&payload);
+    /* Process the message */
+    res = callback(application, channel, messageType, requestId,
+                   segments, chunksSize);
+
+    /* Clean up */
+    UA_free(segments);
+    while((chunk = SIMPLEQ_FIRST(&messageChunks))) {
+        SIMPLEQ_REMOVE_HEAD(&messageChunks, pointers);
+        UA_Chunk_delete(chunk);
+    }
     return res;
 }
 
 static UA_StatusCode
-persistCompleteChunks(UA_ChunkQueue *queue) {
+persistCompleteChunks(UA_SecureChannel *channel, UA_ChunkQueue *queue) {
     UA_Chunk *chunk;
     SIMPLEQ_FOREACH(chunk, queue, pointers) {
-        if(chunk->copied)
-            continue;
-        UA_ByteString copy;
-        UA_StatusCode res = UA_ByteString_copy(&chunk->bytes, &copy);
+        UA_StatusCode res = persistChunk(channel, chunk);
         UA_CHECK_STATUS(res, return res);
-        chunk->bytes = copy;
-        chunk->copied = true;
     }
     return UA_STATUSCODE_GOOD;
 }
 
+static UA_UInt32
+getMessageSize(const UA_Byte *header) {
+    UA_ByteString buf = {UA_SECURECHANNEL_MESSAGEHEADER_LENGTH, (UA_Byte*)(uintptr_t)header};
+    UA_TcpMessageHeader hdr;
+    size_t offset = 0;
+    UA_StatusCode res =
+        UA_decodeBinaryInternal(&buf, &offset, &hdr,
+                                &UA_TRANSPORT[UA_TRANSPORT_TCPMESSAGEHEADER], NULL);
+    UA_assert(res == UA_STATUSCODE_GOOD);
+    (void)res; /* pacify compilers if assert is ignored */
+    return hdr.messageSize;
+}
+
+/* Buffer the half-received chunk at the end of the buffer. The memory for the
+ * full chunk is allocated once the header is known. The remaining bytes are
+ * copied in when they arrive. So every byte is copied only once and the
+ * following chunks are processed in the network buffer. */
 static UA_StatusCode
 persistIncompleteChunk(UA_SecureChannel *channel, const UA_ByteString *buffer,
                        size_t offset) {
     UA_assert(channel->incompleteChunk.length == 0);
     UA_assert(offset < buffer->length);
     size_t length = buffer->length - offset;
-    UA_StatusCode res = UA_ByteString_allocBuffer(&channel->incompleteChunk, length);
+
+    /* The header was already checked in extractCompleteChunk */
+    size_t size = UA_SECURECHANNEL_MESSAGEHEADER_LENGTH;
+    if(length >= UA_SECURECHANNEL_MESSAGEHEADER_LENGTH)
+        size = getMessageSize(&buffer->data[offset]);
+    UA_assert(size > length);
+
+    UA_StatusCode res = UA_ByteString_allocBuffer(&channel->incompleteChunk, size);
     UA_CHECK_STATUS(res, return res);
     memcpy(channel->incompleteChunk.data, &buffer->data[offset], length);
+    channel->incompleteChunk.length = length;
+    channel->incompleteChunkSize = size;
     return UA_STATUSCODE_GOOD;
 }
 
+#ifdef UA_PARALLEL_DECRYPT
+
+#define UA_PARALLELDECRYPT_DEFAULTTHREADS 4
+#define UA_PARALLELDECRYPT_MAXTHREADS 64
+
+typedef struct {
+    const UA_SecureChannel *channel;
+    void *channelContext;
+    UA_Chunk **chunks;
+    size_t begin;
+    size_t end;
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+    /* The allocator is thread-local. Use the same as the processing thread. */
+    void * (*mallocSingleton)(size_t size);
+    void (*freeSingleton)(void *ptr);
+    void * (*callocSingleton)(size_t nelem, size_t elsize);
+    void * (*reallocSingleton)(void *ptr, size_t size);
+    UA_MemoryCategory memoryCategory;
+#endif
+} ParallelDecryptSlice;
+
+/* Only decrypt ahead of time if the remote keys cannot change before the
+ * chunks are unpacked. In the NORMAL renew state, the nonces of the channel
+ * belong to the current remote keys. */
+static UA_Boolean
+useParallelDecrypt(const UA_SecureChannel *channel) {
+    return (channel->parallelDecryptThreshold > 0 &&
+            channel->securityPolicy != NULL &&
+            channel->state == UA_SECURECHANNELSTATE_OPEN &&
+            channel->renewState == UA_SECURECHANNELRENEWSTATE_NORMAL &&
+            (channel->securityMode == UA_MESSAGESECURITYMODE_SIGN ||
+             channel->securityMode == UA_MESSAGESECURITYMODE_SIGNANDENCRYPT));
+}
+
+/* MSG chunk for the channel secured with the current SecurityToken */
+static UA_Boolean
+isParallelDecryptChunk(const UA_SecureChannel *channel, const UA_Chunk *chunk) {
+    if(chunk->messageType != UA_MESSAGETYPE_MSG || chunk->decrypted)
+        return false;
+    size_t offset = UA_SECURECHANNEL_MESSAGEHEADER_LENGTH;
+    UA_UInt32 secureChannelId = 0, tokenId = 0;
+    UA_UInt32_decodeBinary(&chunk->bytes, &offset, &secureChannelId);
+    UA_UInt32_decodeBinary(&chunk->bytes, &offset, &tokenId);
+    return (secureChannelId == channel->securityToken.channelId &&
+            tokenId == channel->securityToken.tokenId);
+}
+
+/* Wait with the processing until enough chunks of a long message have arrived
+ * for a parallel batch. The chunks remain in the completeChunks queue. At most
+ * parallelDecryptThreshold chunks (and no more than the channel limits) are
+ * buffered that way. */
+static UA_Boolean
+deferParallelDecrypt(const UA_SecureChannel *channel) {
+    if(!useParallelDecrypt(channel))
+        return false;
+    size_t count = channel->decryptedChunksCount;
+    size_t length = channel->decryptedChunksLength;
+    UA_Chunk *chunk, *last = NULL;
+    SIMPLEQ_FOREACH(chunk, &channel->completeChunks, pointers) {
+        if(!isParallelDecryptChunk(channel, chunk))
+            return false;
+        count++;
+        length += chunk->bytes.length;
+        last = chunk;
+    }
+    if(!last || last->chunkType != UA_CHUNKTYPE_INTERMEDIATE)
+        return false;
+    if((channel->config.localMaxChunkCount != 0 &&
+        count >= channel->config.localMaxChunkCount) ||
+       (channel->config.localMaxMessageSize != 0 &&
+        length >= channel->config.localMaxMessageSize))
+        return false;
+    return (count - channel->decryptedChunksCount < channel->parallelDecryptThreshold);
+}
+
+static void *
+processParallelDecryptSlice(void *data) {
+    ParallelDecryptSlice *slice = (ParallelDecryptSlice*)data;
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+    UA_mallocSingleton = slice->mallocSingleton;
+    UA_freeSingleton = slice->freeSingleton;
+    UA_callocSingleton = slice->callocSingleton;
+    UA_reallocSingleton = slice->reallocSingleton;
+    UA_memoryCategory = slice->memoryCategory;
+#endif
+    const UA_SecurityPolicyCryptoModule *cm =
+        &slice->channel->securityPolicy->symmetricModule.cryptoModule;
+    for(size_t i = slice->begin; i < slice->end; i++) {
+        UA_Chunk *chunk = slice->chunks[i];
+        chunk->decryptResult =
+            decryptAndVerifyChunkContext(slice->channel, slice->channelContext, cm,
+                                         chunk->messageType, &chunk->bytes,
+                                         UA_SECURECHANNEL_MESSAGE_MIN_LENGTH);
+        chunk->decrypted = true;
+    }
+    return NULL;
+}
+
+/* Decrypt and verify the leading MSG chunks of the completeChunks queue in
+ * parallel. The chunks are split into contiguous slices. The processing thread
+ * takes the first slice with the context of the channel. The keyed contexts of
+ * the SecurityPolicies are not thread-safe. So every worker gets a context of
+ * its own with the remote keys of the channel. The chunks are unpacked in their
+ * order afterwards, where the sequence numbers (inside the encrypted part) are
+ * checked. If no worker can be started, the slices are processed in the
+ * processing thread. */
+static void
+decryptChunksParallel(UA_SecureChannel *channel) {
+    if(!useParallelDecrypt(channel))
+        return;
+
+    /* Count the chunks of the batch */
+    size_t count = 0;
+    UA_Chunk *chunk;
+    SIMPLEQ_FOREACH(chunk, &channel->completeChunks, pointers) {
+        if(!isParallelDecryptChunk(channel, chunk))
+            break;
+        count++;
+    }
+    if(count < 2)
+        return;
+
+    /* Decrypt one by one during unpacking if out of memory */
+    UA_Chunk **chunks = (UA_Chunk**)UA_malloc(count * sizeof(UA_Chunk*));
+    if(!chunks)
+        return;
+    size_t i = 0;
+    SIMPLEQ_FOREACH(chunk, &channel->completeChunks, pointers) {
+        if(i == count)
+            break;
+        chunks[i++] = chunk;
+    }
+
+    /* Split into slices */
+    size_t threads = channel->parallelDecryptThreads;
+    if(threads == 0)
+        threads = UA_PARALLELDECRYPT_DEFAULTTHREADS;
+    if(threads > UA_PARALLELDECRYPT_MAXTHREADS)
+        threads = UA_PARALLELDECRYPT_MAXTHREADS;
+    if(threads > count)
+        threads = count;
+    const UA_SecurityPolicy *sp = channel->securityPolicy;
+    ParallelDecryptSlice slices[UA_PARALLELDECRYPT_MAXTHREADS];
+    pthread_t workers[UA_PARALLELDECRYPT_MAXTHREADS];
+    UA_Boolean started[UA_PARALLELDECRYPT_MAXTHREADS];
+    size_t sliceSize = (count + threads - 1) / threads;
+    for(size_t t = 0; t < threads; t++) {
+        ParallelDecryptSlice *slice = &slices[t];
+        slice->channel = channel;
+        slice->channelContext = channel->channelContext;
+        slice->chunks = chunks;
+        slice->begin = t * sliceSize;
+        slice->end = slice->begin + sliceSize;
+        if(slice->end > count)
+            slice->end = count;
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+        slice->mallocSingleton = UA_mallocSingleton;
+        slice->freeSingleton = UA_freeSingleton;
+        slice->callocSingleton = UA_callocSingleton;
+        slice->reallocSingleton = UA_reallocSingleton;
+        slice->memoryCategory = UA_memoryCategory;
+#endif
+        started[t] = false;
+        if(t == 0 || slice->begin >= slice->end)
+            continue;
+
+        /* Set up the context for the worker */
+        void *cc = NULL;
+        UA_StatusCode res = sp->channelModule.
+            newContext(sp, &channel->remoteCertificate, &cc);
+        if(res != UA_STATUSCODE_GOOD)
+            continue;
+        res = generateRemoteKeysContext(channel, cc);
+        if(res != UA_STATUSCODE_GOOD) {
+            sp->channelModule.deleteContext(cc);
+            continue;
+        }
+        slice->channelContext = cc;
+        started[t] = (pthread_create(&workers[t], NULL,
+                                     processParallelDecryptSlice, slice) == 0);
+        if(!started[t]) {
+            sp->channelModule.deleteContext(cc);
+            slice->channelContext = channel->channelContext;
+        }
+    }
+
+    /* Process the first slice and the slices where no worker could be
+     * started. Then wait for the workers. */
+    for(size_t t = 0; t < threads; t++) {
+        if(!started[t])
+            processParallelDecryptSlice(&slices[t]);
+    }
+    for(size_t t = 1; t < threads; t++) {
+        if(!started[t])
+            continue;
+        pthread_join(workers[t], NULL);
+        sp->channelModule.deleteContext(slices[t].channelContext);
+    }
+    UA_free(chunks);
+}
+
+#endif /* UA_PARALLEL_DECRYPT */
+
 /* Processes chunks and puts them into the payloads queue. Once a final chunk is
  * put into the queue, the message is assembled and the callback is called. The
  * queue will be cleared for the next message. */
@@ -791,11 +1406,23 @@ static UA_StatusCode
 processChunks(UA_SecureChannel *channel, void *application,
               UA_ProcessMessageCallback callback,
               UA_DateTime nowMonotonic) {
+#ifdef UA_PARALLEL_DECRYPT
+    /* Wait until the worker of the pending handshake is done */
+    if(channel->handshake)
+        return UA_STATUSCODE_GOOD;
+
+    /* Buffer the chunks of a long message or decrypt them in parallel */
+    if(deferParallelDecrypt(channel))
+        return UA_STATUSCODE_GOOD;
+    decryptChunksParallel(channel);
+#endif
+
     UA_Chunk *chunk;
     UA_StatusCode res = UA_STATUSCODE_GOOD;
     while((chunk = SIMPLEQ_FIRST(&channel->completeChunks))) {
         /* Remove from the complete-chunk queue */
         SIMPLEQ_REMOVE_HEAD(&channel->completeChunks, pointers);
+        UA_Byte *start = chunk->bytes.data;
 
         /* Check, decrypt and unpack the payload */
         if(chunk->messageType == UA_MESSAGETYPE_OPN) {
@@ -804,7 +1431,15 @@ processChunks(UA_SecureChannel *channel, void *application,
                channel->state != UA_SECURECHANNELSTATE_ACK_SENT)
                 res = UA_STATUSCODE_BADINVALIDSTATE;
             else
-                res = unpackPayloadOPN(channel, chunk, application);
+                res = unpackPayloadOPN(channel, chunk, application, callback);
+#ifdef UA_PARALLEL_DECRYPT
+            /* The chunk is decrypted by a worker thread. Put it back and
+             * continue once the worker is done. */
+            if(res == UA_STATUSCODE_GOODCOMPLETESASYNCHRONOUSLY) {
+                SIMPLEQ_INSERT_HEAD(&channel->completeChunks, chunk, pointers);
+                return UA_STATUSCODE_GOOD;
+            }
+#endif
         } else if(chunk->messageType == UA_MESSAGETYPE_MSG ||
                   chunk->messageType == UA_MESSAGETYPE_CLO) {
             if(channel->state == UA_SECURECHANNELSTATE_CLOSED)
@@ -816,11 +1451,22 @@ processChunks(UA_SecureChannel *channel, void *application,
             chunk->bytes.length -= UA_SECURECHANNEL_MESSAGEHEADER_LENGTH;
         }
 
-        if(res != UA_STATUSCODE_GOOD) {
+        if(UA_UNLIKELY(res != UA_STATUSCODE_GOOD)) {
             UA_Chunk_delete(chunk);
             return res;
         }
 
+        /* Capture the decrypted chunk (without padding and signature) */
+        UA_SecureChannel_capture(channel, false, start, (size_t)
+                                 (&chunk->bytes.data[chunk->bytes.length] - start));
+
+        /* The chunk was persisted before unpacking (buffered for a parallel
+         * batch). Move the payload to the start of the allocated memory. */
+        if(chunk->copied && chunk->bytes.data != start) {
+            memmove(start, chunk->bytes.data, chunk->bytes.length);
+            chunk->bytes.data = start;
+        }
+
         /* Add to the decrypted-chunk queue */
         SIMPLEQ_INSERT_TAIL(&channel->decryptedChunks, chunk, pointers);
 
@@ -861,9 +1507,11 @@ processChunks(UA_SecureChannel *channel, void *application,
     return UA_STATUSCODE_GOOD;
 }
 
+/* The chunk is added to the queue. It either points into the network buffer
+ * or takes ownership of the buffer memory (copied). */
 static UA_StatusCode
 extractCompleteChunk(UA_SecureChannel *channel, const UA_ByteString *buffer,
-                     size_t *offset, UA_Boolean *done) {
+                     size_t *offset, UA_Boolean *done, UA_Boolean copied) {
     /* At least 8 byte needed for the header. Wait for the next chunk. */
     size_t initial_offset = *offset;
     size_t remaining = buffer->length - initial_offset;
@@ -885,9 +1533,9 @@ extractCompleteChunk(UA_SecureChannel *channel, const UA_ByteString *buffer,
         (hdr.messageTypeAndChunkType & UA_BITMASK_CHUNKTYPE);
 
     /* The message size is not allowed */
-    if(hdr.messageSize < UA_SECURECHANNEL_MESSAGE_MIN_LENGTH)
+    if(UA_UNLIKELY(hdr.messageSize < UA_SECURECHANNEL_MESSAGE_MIN_LENGTH))
         return UA_STATUSCODE_BADTCPMESSAGETYPEINVALID;
-    if(hdr.messageSize > channel->config.recvBufferSize)
+    if(UA_UNLIKELY(hdr.messageSize > channel->config.recvBufferSize))
         return UA_STATUSCODE_BADTCPMESSAGETOOLARGE;
 
     /* Incomplete chunk */
@@ -927,38 +1575,85 @@ extractCompleteChunk(UA_SecureChannel *channel, const UA_ByteString *buffer,
     chunk->messageType = msgType;
     chunk->chunkType = chunkType;
     chunk->requestId = 0;
-    chunk->copied = false;
+    chunk->copied = copied;
+    chunk->retainedIn = NULL;
+    chunk->decrypted = false;
+    chunk->decryptResult = UA_STATUSCODE_GOOD;
 
     SIMPLEQ_INSERT_TAIL(&channel->completeChunks, chunk, pointers);
     return UA_STATUSCODE_GOOD;
 }
 
+/* Fill up the buffered incomplete chunk with the bytes from the start of the
+ * buffer. The offset is moved behind the consumed bytes. Once the chunk is
+ * complete, it is added to the queue and owns the memory. */
+static UA_StatusCode
+completeIncompleteChunk(UA_SecureChannel *channel, const UA_ByteString *buffer,
+                        size_t *offset) {
+    UA_ByteString *ic = &channel->incompleteChunk;
+
+    /* Complete the header. Then allocate the memory for the full chunk. */
+    if(ic->length < UA_SECURECHANNEL_MESSAGEHEADER_LENGTH) {
+        size_t n = UA_SECURECHANNEL_MESSAGEHEADER_LENGTH - ic->length;
+        if(n > buffer->length)
+            n = buffer->length;
+        memcpy(&ic->data[ic->length], buffer->data, n);
+        ic->length += n;
+        *offset = n;
+        if(ic->length < UA_SECURECHANNEL_MESSAGEHEADER_LENGTH)
+            return UA_STATUSCODE_GOOD;
+
+        UA_UInt32 messageSize = getMessageSize(ic->data);
+        if(messageSize < UA_SECURECHANNEL_MESSAGE_MIN_LENGTH)
+            return UA_STATUSCODE_BADTCPMESSAGETYPEINVALID;
+        if(messageSize > channel->config.recvBufferSize)
+            return UA_STATUSCODE_BADTCPMESSAGETOOLARGE;
+        UA_Byte *t = (UA_Byte*)UA_realloc(ic->data, messageSize);
+        UA_CHECK_MEM(t, return UA_STATUSCODE_BADOUTOFMEMORY);
+        ic->data = t;
+        channel->incompleteChunkSize = messageSize;
+    }
+
+    /* Copy the missing bytes */
+    size_t n = channel->incompleteChunkSize - ic->length;
+    if(n > buffer->length - *offset)
+        n = buffer->length - *offset;
+    memcpy(&ic->data[ic->length], &buffer->data[*offset], n);
+    ic->length += n;
+    *offset += n;
+    if(ic->length < channel->incompleteChunkSize)
+        return UA_STATUSCODE_GOOD;
+
+    /* Add the complete chunk. It takes ownership of the memory. */
+    size_t chunkOffset = 0;
+    UA_Boolean done = false;
+    UA_StatusCode res = extractCompleteChunk(channel, ic, &chunkOffset, &done, true);
+    UA_CHECK_STATUS(res, return res);
+    UA_assert(!done && chunkOffset == ic->length);
+    *ic = UA_BYTESTRING_NULL;
+    channel->incompleteChunkSize = 0;
+    return UA_STATUSCODE_GOOD;
+}
+
 UA_StatusCode
 UA_SecureChannel_processBuffer(UA_SecureChannel *channel, void *application,
                                UA_ProcessMessageCallback callback,
                                const UA_ByteString *buffer,
                                UA_DateTime nowMonotonic) {
-    /* Prepend the incomplete last chunk. This is usually done in the
-     * networklayer. But we test for a buffered incomplete chunk here again to
-     * work around "lazy" network layers. */
-    UA_ByteString appended = channel->incompleteChunk;
-    if(appended.length > 0) {
-        channel->incompleteChunk = UA_BYTESTRING_NULL;
-        UA_Byte *t = (UA_Byte*)UA_realloc(appended.data, appended.length + buffer->length);
-        UA_CHECK_MEM(t, UA_ByteString_clear(&appended);
-                     return UA_STATUSCODE_BADOUTOFMEMORY);
-        memcpy(&t[appended.length], buffer->data, buffer->length);
-        appended.data = t;
-        appended.length += buffer->length;
-        buffer = &appended;
+    UA_MemoryCategory mc = UA_MemoryCategory_enter(UA_MEMORYCATEGORY_SECURECHANNEL);
+
+    /* Complete the buffered incomplete chunk from the start of the buffer */
+    size_t offset = 0;
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    if(channel->incompleteChunk.length > 0) {
+        res = completeIncompleteChunk(channel, buffer, &offset);
+        UA_CHECK_STATUS(res, goto cleanup);
     }
 
     /* Loop over the received chunks */
-    size_t offset = 0;
-    UA_Boolean done = false;
-    UA_StatusCode res;
+    UA_Boolean done = (channel->incompleteChunk.length > 0);
     while(!done) {
-        res = extractCompleteChunk(channel, buffer, &offset, &done);
+        res = extractCompleteChunk(channel, buffer, &offset, &done, false);
         UA_CHECK_STATUS(res, goto cleanup);
     }
 
@@ -976,10 +1671,10 @@ UA_SecureChannel_processBuffer(UA_SecureChannel *channel, void *application,
 
     /* Persist full chunks that still point to the buffer. Can only return
      * UA_STATUSCODE_BADOUTOFMEMORY as an error code. So merging res works. */
-    res |= persistCompleteChunks(&channel->completeChunks);
-    res |= persistCompleteChunks(&channel->decryptedChunks);
+    res |= persistCompleteChunks(channel, &channel->completeChunks);
+    res |= persistCompleteChunks(channel, &channel->decryptedChunks);
 
  cleanup:
-    UA_ByteString_clear(&appended);
+    UA_MemoryCategory_leave(mc);
     return res;
 }
@@ -16,6 +16,7 @@
 #include <open62541/plugin/log.h>
 #include <open62541/plugin/securitypolicy.h>
 #include <open62541/plugin/eventloop.h>
+#include <open62541/plugin/capture.h>
 #include <open62541/transport_generated.h>
 
 #include "open62541_queue.h"
@@ -60,6 +61,14 @@ typedef struct UA_Session UA_Session;
 /* Minimum length of a valid message (ERR message with an empty reason) */
 #define UA_SECURECHANNEL_MESSAGE_MIN_LENGTH 16
 
+/* Number of chunks of a multi-chunk message that are collected in a network
+ * buffer and sent out together */
+#define UA_SECURECHANNEL_SEND_CHUNKS 4
+
+/* Number of network buffers that are held back and sent out with a single call
+ * if the ConnectionManager supports scatter-gather sending */
+#define UA_SECURECHANNEL_SEND_BUFFERS 8
+
 /* For chunked requests */
 typedef struct UA_Chunk {
     SIMPLEQ_ENTRY(UA_Chunk) pointers;
@@ -69,10 +78,41 @@ typedef struct UA_Chunk {
     UA_UInt32 requestId;
     UA_Boolean copied; /* Do the bytes point to a buffer from the network or was
                         * memory allocated for the chunk separately */
+    UA_ConnectionManager *retainedIn; /* The network buffer was retained in the
+                                       * ConnectionManager instead of copied */
+    uintptr_t retainedConnectionId;
+    UA_ByteString retained;           /* Released when the chunk is deleted */
+    UA_Boolean decrypted; /* Decrypted and verified ahead of time in a parallel
+                           * batch. The outcome is in decryptResult. */
+    UA_StatusCode decryptResult;
 } UA_Chunk;
 
 typedef SIMPLEQ_HEAD(UA_ChunkQueue, UA_Chunk) UA_ChunkQueue;
 
+/* Remote certificates that passed the verification of the CertificateGroup.
+ * Reconnecting peers present the same certificate again. The verification is
+ * then skipped until the entry expires. The lookup uses a hash of the
+ * certificate. The full certificate is compared for a match. If all entries
+ * are in use, the entries are replaced in a round-robin fashion. */
+#define UA_CERTIFICATECACHE_SIZE 64
+
+typedef struct {
+    UA_UInt32 hash;
+    UA_DateTime expires; /* Monotonic time */
+    UA_ByteString certificate;
+} UA_CertificateCacheEntry;
+
+typedef struct {
+    UA_DateTime ttl; /* 0 -> Disabled */
+    size_t size;
+    size_t next;  /* Next entry to replace */
+    size_t hits;  /* Verifications that were skipped */
+    UA_CertificateCacheEntry entries[UA_CERTIFICATECACHE_SIZE];
+} UA_CertificateCache;
+
+void
+UA_CertificateCache_clear(UA_CertificateCache *cache);
+
 typedef enum {
     UA_SECURECHANNELRENEWSTATE_NORMAL,
 
@@ -104,6 +144,9 @@ struct UA_SecureChannel {
     UA_ConnectionManager *connectionManager;
     uintptr_t connectionId;
 
+    /* Plaintext capture of the chunks. Optional, can be NULL. */
+    UA_PacketCapture *capture;
+
     /* Linked lists (only used in the server) */
     TAILQ_ENTRY(UA_SecureChannel) serverEntry;
     TAILQ_ENTRY(UA_SecureChannel) componentEntry;
@@ -139,10 +182,48 @@ struct UA_SecureChannel {
     UA_UInt32 receiveSequenceNumber;
     UA_UInt32 sendSequenceNumber;
 
+    /* Number of chunks that were signed and/or encrypted before sending and
+     * that were decrypted and/or verified after receiving */
+    size_t securedChunksSent;
+    size_t securedChunksReceived;
+
     /* Sessions that are bound to the SecureChannel (singly-linked list, only
      * used in the server) */
     UA_Session *sessions;
 
+#if UA_MULTITHREADING >= 200
+    /* Long multi-chunk messages are decrypted and verified by parallel worker
+     * threads if the server config sets a parallelDecryptThreshold. See
+     * processChunks. (Only used in the server.) */
+    UA_UInt32 parallelDecryptThreshold;
+    UA_UInt16 parallelDecryptThreads;
+
+    /* The first OPN chunk is decrypted and verified by a worker thread if
+     * asyncHandshake is set. The processing of the channel pauses while the
+     * handshake is pending and resumes from a delayed callback in the
+     * EventLoop. handshakeOffloaded is set once the OPN chunk was processed
+     * that way. (Only used in the server.) */
+    UA_Boolean asyncHandshake;
+    UA_Boolean handshakeOffloaded;
+    struct UA_AsyncHandshake *handshake;
+#endif
+
+    /* Nodes whose value is referenced (not copied) by the response of the Read
+     * request that is currently processed. The nodes are released after the
+     * response was encoded. Pinning is only enabled while a Read request
+     * received on this SecureChannel is processed. (Only used in the
+     * server.) */
+    UA_Boolean pinNodes;
+    const void **pinnedNodes;
+    size_t pinnedNodesSize;
+    size_t pinnedNodesCapacity;
+
+    /* Encoded body of the response (the members after the ResponseHeader) that
+     * is currently processed. Set by services that answer from a cache of
+     * encoded responses. The buffer is owned by the cache and must be sent out
+     * before the service mutex is released. (Only used in the server.) */
+    const UA_ByteString *encodedResponseBody;
+
     /* If a buffer is received, first all chunks are put into the completeChunks
      * queue. Then they are processed in order. This ensures that processing
      * buffers is reentrant with the correct processing order. (This has lead to
@@ -155,8 +236,11 @@ struct UA_SecureChannel {
     size_t decryptedChunksLength;
     UA_ByteString incompleteChunk; /* A half-received chunk (TCP is a
                                     * streaming protocol) is stored here */
+    size_t incompleteChunkSize;    /* Allocated for the full chunk */
 
     UA_CertificateGroup *certificateVerification;
+    UA_CertificateCache *certificateCache; /* (Only used in the server) */
+    UA_UInt64 timeoutCallbackId; /* One-shot timeout timer (only server) */
     UA_StatusCode (*processOPNHeader)(void *application, UA_SecureChannel *channel,
                                       const UA_AsymmetricAlgorithmSecurityHeader *asymHeader);
 };
@@ -185,6 +269,22 @@ UA_SecureChannel_setSecurityPolicy(UA_SecureChannel *channel,
 UA_Boolean
 UA_SecureChannel_isConnected(UA_SecureChannel *channel);
 
+/* Returns true if previously sent messages are still queued in the
+ * ConnectionManager because the remote side does not keep up */
+UA_Boolean
+UA_SecureChannel_isSendCongested(UA_SecureChannel *channel);
+
+/* Hand over a plaintext chunk to the capture plugin if enabled */
+static UA_INLINE void
+UA_SecureChannel_capture(UA_SecureChannel *channel, UA_Boolean sent,
+                         UA_Byte *data, size_t length) {
+    UA_PacketCapture *pc = channel->capture;
+    if(UA_LIKELY(!pc || !pc->enabled))
+        return;
+    UA_ByteString chunk = {length, data};
+    pc->capture(pc, channel->connectionId, sent, &chunk);
+}
+
 /* Returns true if the channel has timed out. Performs the SecurityToken
  * rollover if required and possible. */
 UA_Boolean
@@ -215,6 +315,11 @@ UA_SecureChannel_generateLocalKeys(const UA_SecureChannel *channel);
 UA_StatusCode
 generateRemoteKeys(const UA_SecureChannel *channel);
 
+/* Set the remote keys of the channel in another context of the channel's
+ * SecurityPolicy. Used for the contexts of the parallel decryption workers. */
+UA_StatusCode
+generateRemoteKeysContext(const UA_SecureChannel *channel, void *channelContext);
+
 /**
  * Sending Messages
  * ---------------- */
@@ -229,8 +334,8 @@ UA_SecureChannel_sendSymmetricMessage(UA_SecureChannel *channel, UA_UInt32 reque
                                       const UA_DataType *payloadType);
 
 /* The MessageContext is forwarded into the encoding layer so that we can send
- * chunks before continuing to encode. This lets us reuse a fixed chunk-sized
- * messages buffer. */
+ * chunks before continuing to encode. This keeps the memory for sending bounded
+ * also for very large messages. */
 typedef struct {
     UA_SecureChannel *channel;
     UA_UInt32 requestId;
@@ -239,6 +344,19 @@ typedef struct {
     UA_UInt16 chunksSoFar;
     size_t messageSizeSoFar;
 
+    /* The first chunk is encoded into a chunk-sized network buffer. Further
+     * chunks share a network buffer for UA_SECURECHANNEL_SEND_CHUNKS chunks
+     * that is sent out once it is full or the message is finished. The
+     * messageBuffer is the section of the network buffer for the current
+     * chunk. */
+    UA_ByteString networkBuffer;
+    size_t networkBufferPos; /* Length of the completed chunks */
+
+    /* Completed network buffers that are sent out together with
+     * sendWithConnectionV (if the ConnectionManager supports it) */
+    UA_ByteString sendBuffers[UA_SECURECHANNEL_SEND_BUFFERS];
+    size_t sendBuffersSize;
+
     UA_ByteString messageBuffer;
     UA_Byte *buf_pos;
     const UA_Byte *buf_end;
@@ -258,6 +376,11 @@ UA_StatusCode
 UA_MessageContext_encode(UA_MessageContext *mc, const void *content,
                          const UA_DataType *contentType);
 
+/* Append already binary-encoded content. Full chunks are sent out as for
+ * UA_MessageContext_encode. */
+UA_StatusCode
+UA_MessageContext_encodeRaw(UA_MessageContext *mc, const UA_ByteString *raw);
+
 /* Sends a symmetric message already encoded in the context. The context is
  * cleaned up, also in case of errors. */
 UA_StatusCode
@@ -273,10 +396,13 @@ UA_MessageContext_abort(UA_MessageContext *mc);
  * Receive Message
  * --------------- */
 
+/* The message body is passed as the list of the chunk payloads. Use
+ * UA_decodeBinarySegments to decode across the chunk boundaries. Only MSG
+ * messages can have more than one segment. */
 typedef UA_StatusCode
 (UA_ProcessMessageCallback)(void *application, UA_SecureChannel *channel,
                             UA_MessageType messageType, UA_UInt32 requestId,
-                            UA_ByteString *message);
+                            const UA_ByteString *message, size_t messageSegments);
 
 /* Process a received buffer. The callback function is called with the message
  * body if the message is complete. The message is removed afterwards. Returns
@@ -308,6 +434,14 @@ decryptAndVerifyChunk(const UA_SecureChannel *channel,
                       UA_MessageType messageType, UA_ByteString *chunk,
                       size_t offset);
 
+/* Same as above, but with the given SecurityPolicy channel context instead of
+ * the context of the channel */
+UA_StatusCode
+decryptAndVerifyChunkContext(const UA_SecureChannel *channel, void *channelContext,
+                             const UA_SecurityPolicyCryptoModule *cryptoModule,
+                             UA_MessageType messageType, UA_ByteString *chunk,
+                             size_t offset);
+
 size_t
 calculateAsymAlgSecurityHeaderLength(const UA_SecureChannel *channel);
 
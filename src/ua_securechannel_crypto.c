@@ -79,11 +79,15 @@ UA_SecureChannel_generateLocalKeys(const UA_SecureChannel *channel) {
 
 UA_StatusCode
 generateRemoteKeys(const UA_SecureChannel *channel) {
+    return generateRemoteKeysContext(channel, channel->channelContext);
+}
+
+UA_StatusCode
+generateRemoteKeysContext(const UA_SecureChannel *channel, void *cc) {
     const UA_SecurityPolicy *sp = channel->securityPolicy;
     UA_CHECK_MEM(sp, return UA_STATUSCODE_BADINTERNALERROR);
     UA_LOG_TRACE_CHANNEL(sp->logger, channel, "Generating new remote keys");
 
-    void *cc = channel->channelContext;
     const UA_SecurityPolicyChannelModule *cm = &sp->channelModule;
     const UA_SecurityPolicySymmetricModule *sm = &sp->symmetricModule;
     const UA_SecurityPolicyCryptoModule *crm = &sm->cryptoModule;
@@ -291,6 +295,7 @@ signAndEncryptAsym(UA_SecureChannel *channel, size_t preSignLength,
     UA_StatusCode retval = sp->asymmetricModule.cryptoModule.signatureAlgorithm.
         sign(channel->channelContext, &dataToSign, &signature);
     UA_CHECK_STATUS(retval, return retval);
+    channel->securedChunksSent++;
 
     /* Specification part 6, 6.7.4: The OpenSecureChannel Messages are
      * signed and encrypted if the SecurityMode is not None (even if the
@@ -325,6 +330,7 @@ signAndEncryptSym(UA_MessageContext *messageContext,
     UA_StatusCode res = sp->symmetricModule.cryptoModule.signatureAlgorithm.
         sign(channel->channelContext, &dataToSign, &signature);
     UA_CHECK_STATUS(res, return res);
+    messageContext->channel->securedChunksSent++;
 
     if(channel->securityMode != UA_MESSAGESECURITYMODE_SIGNANDENCRYPT)
         return UA_STATUSCODE_GOOD;
@@ -390,15 +396,14 @@ setBufPos(UA_MessageContext *mc) {
 /****************************/
 
 static size_t
-decodePadding(const UA_SecureChannel *channel,
-              const UA_SecurityPolicyCryptoModule *cryptoModule,
+decodePadding(void *cc, const UA_SecurityPolicyCryptoModule *cryptoModule,
               const UA_ByteString *chunk, size_t sigsize) {
     /* Read the byte with the padding size */
     size_t paddingSize = chunk->data[chunk->length - sigsize - 1];
 
     /* Extra padding size */
     if(cryptoModule->encryptionAlgorithm.
-       getLocalKeyLength(channel->channelContext) > 2048) {
+       getLocalKeyLength(cc) > 2048) {
         paddingSize <<= 8u;
         paddingSize += chunk->data[chunk->length - sigsize - 2];
         paddingSize += 1; /* Extra padding byte itself */
@@ -409,7 +414,7 @@ decodePadding(const UA_SecureChannel *channel,
 }
 
 static UA_StatusCode
-verifySignature(const UA_SecureChannel *channel,
+verifySignature(const UA_SecureChannel *channel, void *cc,
                 const UA_SecurityPolicyCryptoModule *cryptoModule,
                 const UA_ByteString *chunk, size_t sigsize) {
     UA_LOG_TRACE_CHANNEL(channel->securityPolicy->logger, channel,
@@ -418,7 +423,7 @@ verifySignature(const UA_SecureChannel *channel,
     const UA_ByteString content = {chunk->length - sigsize, chunk->data};
     const UA_ByteString sig = {sigsize, chunk->data + chunk->length - sigsize};
     UA_StatusCode retval = cryptoModule->signatureAlgorithm.
-        verify(channel->channelContext, &content, &sig);
+        verify(cc, &content, &sig);
     return retval;
 }
 
@@ -429,12 +434,21 @@ decryptAndVerifyChunk(const UA_SecureChannel *channel,
                       const UA_SecurityPolicyCryptoModule *cryptoModule,
                       UA_MessageType messageType, UA_ByteString *chunk,
                       size_t offset) {
+    return decryptAndVerifyChunkContext(channel, channel->channelContext,
+                                        cryptoModule, messageType, chunk, offset);
+}
+
+UA_StatusCode
+decryptAndVerifyChunkContext(const UA_SecureChannel *channel, void *cc,
+                             const UA_SecurityPolicyCryptoModule *cryptoModule,
+                             UA_MessageType messageType, UA_ByteString *chunk,
+                             size_t offset) {
     /* Decrypt the chunk */
     UA_StatusCode res = UA_STATUSCODE_GOOD;
     if(channel->securityMode == UA_MESSAGESECURITYMODE_SIGNANDENCRYPT ||
        messageType == UA_MESSAGETYPE_OPN) {
         UA_ByteString cipher = {chunk->length - offset, chunk->data + offset};
-        res = cryptoModule->encryptionAlgorithm.decrypt(channel->channelContext, &cipher);
+        res = cryptoModule->encryptionAlgorithm.decrypt(cc, &cipher);
         UA_CHECK_STATUS(res, return res);
         chunk->length = cipher.length + offset;
     }
@@ -447,8 +461,8 @@ decryptAndVerifyChunk(const UA_SecureChannel *channel,
 
     /* Verify the chunk signature */
     size_t sigsize = cryptoModule->signatureAlgorithm.
-        getRemoteSignatureSize(channel->channelContext);
-    res = verifySignature(channel, cryptoModule, chunk, sigsize);
+        getRemoteSignatureSize(cc);
+    res = verifySignature(channel, cc, cryptoModule, chunk, sigsize);
     UA_CHECK_STATUS(res,
        UA_LOG_WARNING_CHANNEL(channel->securityPolicy->logger, channel,
                               "Could not verify the signature"); return res);
@@ -458,7 +472,7 @@ decryptAndVerifyChunk(const UA_SecureChannel *channel,
     if(channel->securityMode == UA_MESSAGESECURITYMODE_SIGNANDENCRYPT ||
        (messageType == UA_MESSAGETYPE_OPN &&
         cryptoModule->encryptionAlgorithm.uri.length > 0)) {
-        padSize = decodePadding(channel, cryptoModule, chunk, sigsize);
+        padSize = decodePadding(cc, cryptoModule, chunk, sigsize);
         UA_LOG_TRACE_CHANNEL(channel->securityPolicy->logger, channel,
                              "Calculated padding size to be %lu",
                              (long unsigned)padSize);
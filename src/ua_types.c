@@ -112,6 +112,481 @@ UA_cleanupDataTypeWithCustom(const UA_DataTypeArray *customTypes) {
     }
 }
 
+/**********************/
+/* Data Type Registry */
+/**********************/
+
+/* Two open-addressing hash tables with linear probing. The capacity is a power
+ * of two and at most half-full. */
+struct UA_DataTypeRegistry {
+    size_t size;
+    size_t encodingSize; /* Replaced types can leave their encoding entry */
+    size_t capacity;
+    const UA_DataType **byTypeId;
+    const UA_DataType **byEncodingId;
+};
+
+static const UA_DataType **
+registrySlot(const UA_DataType **table, size_t capacity, const UA_NodeId *id,
+             UA_Boolean byEncodingId) {
+    size_t mask = capacity - 1;
+    size_t pos = UA_NodeId_hash(id) & mask;
+    while(table[pos]) {
+        const UA_NodeId *key = (byEncodingId) ?
+            &table[pos]->binaryEncodingId : &table[pos]->typeId;
+        if(UA_NodeId_equal(key, id))
+            break;
+        pos = (pos + 1) & mask;
+    }
+    return &table[pos];
+}
+
+static UA_StatusCode
+registryResize(UA_DataTypeRegistry *r, size_t capacity) {
+    const UA_DataType **byTypeId = (const UA_DataType**)
+        UA_calloc(capacity, sizeof(UA_DataType*));
+    const UA_DataType **byEncodingId = (const UA_DataType**)
+        UA_calloc(capacity, sizeof(UA_DataType*));
+    if(!byTypeId || !byEncodingId) {
+        UA_free(byTypeId);
+        UA_free(byEncodingId);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    for(size_t i = 0; i < r->capacity; i++) {
+        const UA_DataType *t = r->byTypeId[i];
+        if(t)
+            *registrySlot(byTypeId, capacity, &t->typeId, false) = t;
+        t = r->byEncodingId[i];
+        if(t)
+            *registrySlot(byEncodingId, capacity, &t->binaryEncodingId, true) = t;
+    }
+    UA_free(r->byTypeId);
+    UA_free(r->byEncodingId);
+    r->byTypeId = byTypeId;
+    r->byEncodingId = byEncodingId;
+    r->capacity = capacity;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+registryAddTypes(UA_DataTypeRegistry *r, const UA_DataType *types, size_t typesSize) {
+    size_t size = (r->size > r->encodingSize) ? r->size : r->encodingSize;
+    if(2 * (size + typesSize) > r->capacity) {
+        size_t capacity = (r->capacity) ? r->capacity : 64;
+        while(2 * (size + typesSize) > capacity)
+            capacity *= 2;
+        UA_StatusCode res = registryResize(r, capacity);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+    for(size_t i = 0; i < typesSize; i++) {
+        const UA_DataType *t = &types[i];
+        const UA_DataType **slot = registrySlot(r->byTypeId, r->capacity,
+                                                &t->typeId, false);
+        if(!*slot)
+            r->size++;
+        *slot = t; /* Replace an earlier definition */
+        if(UA_NodeId_isNull(&t->binaryEncodingId))
+            continue;
+        slot = registrySlot(r->byEncodingId, r->capacity, &t->binaryEncodingId, true);
+        if(!*slot)
+            r->encodingSize++;
+        *slot = t;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_DataTypeRegistry *
+UA_DataTypeRegistry_new(void) {
+    UA_DataTypeRegistry *r = (UA_DataTypeRegistry*)
+        UA_calloc(1, sizeof(UA_DataTypeRegistry));
+    if(!r)
+        return NULL;
+    if(registryAddTypes(r, UA_TYPES, UA_TYPES_COUNT) != UA_STATUSCODE_GOOD) {
+        UA_DataTypeRegistry_delete(r);
+        return NULL;
+    }
+    return r;
+}
+
+void
+UA_DataTypeRegistry_delete(UA_DataTypeRegistry *r) {
+    if(!r)
+        return;
+    UA_free(r->byTypeId);
+    UA_free(r->byEncodingId);
+    UA_free(r);
+}
+
+UA_StatusCode
+UA_DataTypeRegistry_add(UA_DataTypeRegistry *r, const UA_DataTypeArray *customTypes) {
+    for(; customTypes; customTypes = customTypes->next) {
+        UA_StatusCode res =
+            registryAddTypes(r, customTypes->types, customTypes->typesSize);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+const UA_DataType *
+UA_DataTypeRegistry_find(const UA_DataTypeRegistry *r, const UA_NodeId *typeId) {
+    return *registrySlot(r->byTypeId, r->capacity, typeId, false);
+}
+
+const UA_DataType *
+UA_DataTypeRegistry_findByBinary(const UA_DataTypeRegistry *r,
+                                 const UA_NodeId *encodingId) {
+    return *registrySlot(r->byEncodingId, r->capacity, encodingId, true);
+}
+
+/*************************/
+/* Runtime Type Creation */
+/*************************/
+
+#define UA_ALIGNOF(T) offsetof(struct { char c; T t; }, t)
+
+/* Alignment of the builtin types in memory */
+static const u8 builtinAlignment[UA_DATATYPEKIND_DIAGNOSTICINFO + 1] = {
+    UA_ALIGNOF(UA_Boolean), UA_ALIGNOF(UA_SByte), UA_ALIGNOF(UA_Byte),
+    UA_ALIGNOF(UA_Int16), UA_ALIGNOF(UA_UInt16), UA_ALIGNOF(UA_Int32),
+    UA_ALIGNOF(UA_UInt32), UA_ALIGNOF(UA_Int64), UA_ALIGNOF(UA_UInt64),
+    UA_ALIGNOF(UA_Float), UA_ALIGNOF(UA_Double), UA_ALIGNOF(UA_String),
+    UA_ALIGNOF(UA_DateTime), UA_ALIGNOF(UA_Guid), UA_ALIGNOF(UA_ByteString),
+    UA_ALIGNOF(UA_XmlElement), UA_ALIGNOF(UA_NodeId), UA_ALIGNOF(UA_ExpandedNodeId),
+    UA_ALIGNOF(UA_StatusCode), UA_ALIGNOF(UA_QualifiedName),
+    UA_ALIGNOF(UA_LocalizedText), UA_ALIGNOF(UA_ExtensionObject),
+    UA_ALIGNOF(UA_DataValue), UA_ALIGNOF(UA_Variant), UA_ALIGNOF(UA_DiagnosticInfo)
+};
+
+static size_t
+typeAlignment(const UA_DataType *type) {
+    if(type->typeKind <= UA_DATATYPEKIND_DIAGNOSTICINFO)
+        return builtinAlignment[type->typeKind];
+    if(type->typeKind == UA_DATATYPEKIND_ENUM)
+        return UA_ALIGNOF(UA_Int32);
+    if(type->typeKind != UA_DATATYPEKIND_STRUCTURE &&
+       type->typeKind != UA_DATATYPEKIND_OPTSTRUCT &&
+       type->typeKind != UA_DATATYPEKIND_UNION)
+        return UA_ALIGNOF(void*);
+    size_t align = (type->typeKind == UA_DATATYPEKIND_UNION) ?
+        UA_ALIGNOF(UA_UInt32) : 1;
+    for(size_t i = 0; i < type->membersSize; i++) {
+        const UA_DataTypeMember *m = &type->members[i];
+        size_t a = (m->isArray) ? UA_ALIGNOF(size_t) :
+            (m->isOptional) ? UA_ALIGNOF(void*) : typeAlignment(m->memberType);
+        if(a > align)
+            align = a;
+    }
+    return align;
+}
+
+static size_t
+alignUp(size_t offset, size_t align) {
+    return (offset + align - 1) & ~(align - 1);
+}
+
+static char *
+copyTypeName(const UA_String *name) {
+    char *s = (char*)UA_malloc(name->length + 1);
+    if(!s)
+        return NULL;
+    if(name->length > 0)
+        memcpy(s, name->data, name->length);
+    s[name->length] = 0;
+    return s;
+}
+
+/* Abstract types in structure fields are encoded as the builtin type they
+ * stand for */
+static const UA_DataType *
+resolveFieldType(const UA_DataTypeRegistry *reg,
+                 const UA_DataTypeSchemaHeader *schema, const UA_NodeId *id) {
+    const UA_DataType *t = UA_DataTypeRegistry_find(reg, id);
+    if(t)
+        return t;
+    for(size_t i = 0; i < schema->simpleDataTypesSize; i++) {
+        const UA_SimpleTypeDescription *st = &schema->simpleDataTypes[i];
+        if(!UA_NodeId_equal(&st->dataTypeId, id))
+            continue;
+        UA_NodeId builtin = UA_NODEID_NUMERIC(0, st->builtInType);
+        return UA_findDataType(&builtin);
+    }
+    if(id->namespaceIndex != 0 || id->identifierType != UA_NODEIDTYPE_NUMERIC)
+        return NULL;
+    switch(id->identifier.numeric) {
+    case UA_NS0ID_STRUCTURE:
+        return &UA_TYPES[UA_TYPES_EXTENSIONOBJECT];
+    case UA_NS0ID_BASEDATATYPE:
+    case UA_NS0ID_NUMBER:
+    case UA_NS0ID_INTEGER:
+    case UA_NS0ID_UINTEGER:
+        return &UA_TYPES[UA_TYPES_VARIANT];
+    case UA_NS0ID_ENUMERATION:
+        return &UA_TYPES[UA_TYPES_INT32];
+    default:
+        return NULL;
+    }
+}
+
+/* Returns UA_STATUSCODE_GOODCALLAGAIN if a member is a structure by value that
+ * is not yet complete. Then the type is retried after the others. */
+static UA_StatusCode
+createStructureType(UA_DataType *type, const UA_StructureDescription *sd,
+                    const UA_DataTypeRegistry *reg,
+                    const UA_DataTypeSchemaHeader *schema,
+                    const UA_DataType *newTypes, const UA_Boolean *complete,
+                    size_t newTypesSize) {
+    const UA_StructureDefinition *def = &sd->structureDefinition;
+    if(def->fieldsSize > 0xff)
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+    switch(def->structureType) {
+    case UA_STRUCTURETYPE_STRUCTURE:
+        type->typeKind = UA_DATATYPEKIND_STRUCTURE; break;
+    case UA_STRUCTURETYPE_STRUCTUREWITHOPTIONALFIELDS:
+        type->typeKind = UA_DATATYPEKIND_OPTSTRUCT; break;
+    case UA_STRUCTURETYPE_UNION:
+        type->typeKind = UA_DATATYPEKIND_UNION; break;
+    default:
+        return UA_STATUSCODE_BADNOTSUPPORTED; /* Subtyped values */
+    }
+
+    /* Resolve the member types first */
+    const UA_DataType *mts[0xff];
+    for(size_t i = 0; i < def->fieldsSize; i++) {
+        const UA_StructureField *f = &def->fields[i];
+        if(f->valueRank < UA_VALUERANK_ONE_OR_MORE_DIMENSIONS &&
+           f->valueRank != UA_VALUERANK_SCALAR)
+            return UA_STATUSCODE_BADNOTSUPPORTED;
+        mts[i] = resolveFieldType(reg, schema, &f->dataType);
+        if(!mts[i])
+            return UA_STATUSCODE_BADDATATYPEIDUNKNOWN;
+        /* The layout of a by-value member must be known */
+        if(f->valueRank == UA_VALUERANK_SCALAR && !f->isOptional &&
+           mts[i] >= newTypes && mts[i] < &newTypes[newTypesSize] &&
+           !complete[mts[i] - newTypes])
+            return (mts[i] == type) ?
+                UA_STATUSCODE_BADNOTSUPPORTED : UA_STATUSCODE_GOODCALLAGAIN;
+    }
+
+    UA_DataTypeMember *members = (UA_DataTypeMember*)
+        UA_calloc(def->fieldsSize, sizeof(UA_DataTypeMember));
+    if(!members && def->fieldsSize > 0)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    /* Compute the memory layout the same as the C compiler would for the
+     * generated struct */
+    UA_Boolean isUnion = (type->typeKind == UA_DATATYPEKIND_UNION);
+    UA_Boolean pointerFree = true;
+    UA_Boolean overlayable = !isUnion;
+    size_t binarySize = 0;
+    size_t offset = (isUnion) ? sizeof(UA_UInt32) : 0;
+    size_t end = offset;
+    size_t align = (isUnion) ? UA_ALIGNOF(UA_UInt32) : 1;
+    for(size_t i = 0; i < def->fieldsSize; i++) {
+        const UA_StructureField *f = &def->fields[i];
+        UA_DataTypeMember *m = &members[i];
+        m->memberType = mts[i];
+        m->isArray = (f->valueRank != UA_VALUERANK_SCALAR);
+        m->isOptional = (f->isOptional && !isUnion);
+        size_t a, size;
+        if(m->isArray) {
+            a = UA_ALIGNOF(size_t);
+            size = sizeof(size_t) + sizeof(void*);
+        } else if(m->isOptional) {
+            a = UA_ALIGNOF(void*);
+            size = sizeof(void*);
+        } else {
+            a = typeAlignment(mts[i]);
+            size = mts[i]->memSize;
+        }
+        if(a > align)
+            align = a;
+
+        /* Union members start after the switchfield. Their padding is the
+         * offset from the start of the union. */
+        size_t pos = alignUp(offset, a);
+        size_t padding = (isUnion) ? pos : pos - end;
+        if(padding > 63) {
+            UA_free(members);
+            return UA_STATUSCODE_BADNOTSUPPORTED;
+        }
+        m->padding = (UA_Byte)padding;
+#ifdef UA_ENABLE_TYPEDESCRIPTION
+        m->memberName = copyTypeName(&f->name);
+#endif
+
+        /* The fast paths of the codec depend on these properties */
+        if(m->isArray || m->isOptional || !mts[i]->pointerFree)
+            pointerFree = false;
+        if(m->isArray || m->isOptional || !mts[i]->overlayable || padding > 0)
+            overlayable = false;
+        if(m->isArray || m->isOptional || mts[i]->binarySize == 0 ||
+           (mts[i]->typeKind == UA_DATATYPEKIND_STRUCTURE && mts[i]->membersSize == 0))
+            binarySize = SIZE_MAX;
+        else if(binarySize != SIZE_MAX)
+            binarySize += mts[i]->binarySize;
+
+        if(isUnion) {
+            if(pos + size > end)
+                end = pos + size;
+        } else {
+            end = pos + size;
+            offset = end;
+        }
+    }
+
+    size_t memSize = alignUp(end, align);
+    if(memSize > 0xffff) {
+        UA_free(members);
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+    }
+    type->members = members;
+    type->membersSize = (UA_UInt32)def->fieldsSize;
+    type->memSize = (UA_UInt32)memSize;
+    type->pointerFree = pointerFree;
+    type->overlayable = (overlayable && memSize == end && def->fieldsSize > 0);
+    type->binarySize = (type->typeKind == UA_DATATYPEKIND_STRUCTURE &&
+                        binarySize != SIZE_MAX && def->fieldsSize > 0) ?
+        (UA_UInt32)binarySize : 0;
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+freeRuntimeTypes(UA_DataType *types, size_t typesSize) {
+    if(!types)
+        return;
+    for(size_t i = 0; i < typesSize; i++) {
+#ifdef UA_ENABLE_TYPEDESCRIPTION
+        UA_free((void*)(uintptr_t)types[i].typeName);
+        for(size_t j = 0; j < types[i].membersSize; j++)
+            UA_free((void*)(uintptr_t)types[i].members[j].memberName);
+#endif
+        UA_free(types[i].members);
+    }
+    UA_free(types);
+}
+
+static size_t
+nodeIdDataLength(const UA_NodeId *id) {
+    return (id->identifierType == UA_NODEIDTYPE_STRING ||
+            id->identifierType == UA_NODEIDTYPE_BYTESTRING) ?
+        id->identifier.string.length : 0;
+}
+
+/* The identifiers are stored behind the types array. So the cleanup of custom
+ * types (which does not know about NodeIds) frees them together with it. */
+static void
+copyNodeIdInline(UA_NodeId *dst, const UA_NodeId *src, UA_Byte **pos) {
+    *dst = *src;
+    size_t len = nodeIdDataLength(src);
+    if(len == 0)
+        return;
+    memcpy(*pos, src->identifier.string.data, len);
+    dst->identifier.string.data = *pos;
+    *pos += len;
+}
+
+UA_StatusCode
+UA_DataTypeArray_fromSchema(const UA_DataTypeSchemaHeader *schema,
+                            const UA_DataTypeArray *customTypes,
+                            UA_DataTypeArray **out) {
+    size_t structsSize = schema->structureDataTypesSize;
+    size_t typesSize = structsSize + schema->enumDataTypesSize;
+    if(typesSize == 0)
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+
+    /* Allocate the types together with the memory for their identifiers */
+    size_t idsLength = 0;
+    for(size_t i = 0; i < structsSize; i++) {
+        const UA_StructureDescription *sd = &schema->structureDataTypes[i];
+        idsLength += nodeIdDataLength(&sd->dataTypeId);
+        idsLength += nodeIdDataLength(&sd->structureDefinition.defaultEncodingId);
+    }
+    for(size_t i = 0; i < schema->enumDataTypesSize; i++)
+        idsLength += nodeIdDataLength(&schema->enumDataTypes[i].dataTypeId);
+    UA_DataType *types = (UA_DataType*)
+        UA_calloc(1, (typesSize * sizeof(UA_DataType)) + idsLength);
+    UA_Boolean *complete = (UA_Boolean*)UA_calloc(typesSize, sizeof(UA_Boolean));
+    UA_DataTypeArray *arr = (UA_DataTypeArray*)UA_malloc(sizeof(UA_DataTypeArray));
+    UA_DataTypeRegistry *reg = UA_DataTypeRegistry_new();
+    UA_StatusCode res = UA_STATUSCODE_BADOUTOFMEMORY;
+    if(!types || !complete || !arr || !reg)
+        goto cleanup;
+
+    /* Set the NodeIds and names */
+    UA_Byte *pos = (UA_Byte*)&types[typesSize];
+    for(size_t i = 0; i < structsSize; i++) {
+        const UA_StructureDescription *sd = &schema->structureDataTypes[i];
+        copyNodeIdInline(&types[i].typeId, &sd->dataTypeId, &pos);
+        copyNodeIdInline(&types[i].binaryEncodingId,
+                         &sd->structureDefinition.defaultEncodingId, &pos);
+#ifdef UA_ENABLE_TYPEDESCRIPTION
+        types[i].typeName = copyTypeName(&sd->name.name);
+#endif
+    }
+    for(size_t i = 0; i < schema->enumDataTypesSize; i++) {
+        const UA_EnumDescription *ed = &schema->enumDataTypes[i];
+        UA_DataType *t = &types[structsSize + i];
+        copyNodeIdInline(&t->typeId, &ed->dataTypeId, &pos);
+#ifdef UA_ENABLE_TYPEDESCRIPTION
+        t->typeName = copyTypeName(&ed->name.name);
+#endif
+        t->memSize = sizeof(UA_Int32);
+        t->typeKind = UA_DATATYPEKIND_ENUM;
+        t->pointerFree = true;
+        t->overlayable = UA_BINARY_OVERLAYABLE_INTEGER;
+        t->binarySize = 4;
+        complete[structsSize + i] = true;
+    }
+
+    /* Index the new types together with the existing ones to resolve the
+     * member types. The new types take precedence over existing definitions
+     * with the same NodeId. */
+    UA_DataTypeArray tmp = {NULL, typesSize, types, true};
+    memcpy(arr, &tmp, sizeof(UA_DataTypeArray));
+    res = UA_DataTypeRegistry_add(reg, customTypes);
+    if(res == UA_STATUSCODE_GOOD)
+        res = UA_DataTypeRegistry_add(reg, arr);
+    if(res != UA_STATUSCODE_GOOD)
+        goto cleanup;
+
+    /* Create the structures. Structures contained by value are completed
+     * first. Repeat until no more progress is made. */
+    size_t missing = structsSize;
+    while(missing > 0) {
+        size_t before = missing;
+        for(size_t i = 0; i < structsSize; i++) {
+            if(complete[i])
+                continue;
+            res = createStructureType(&types[i], &schema->structureDataTypes[i],
+                                      reg, schema, types, complete, typesSize);
+            if(res == UA_STATUSCODE_GOODCALLAGAIN)
+                continue;
+            if(res != UA_STATUSCODE_GOOD)
+                goto cleanup;
+            complete[i] = true;
+            missing--;
+        }
+        if(missing == before) {
+            res = UA_STATUSCODE_BADDATATYPEIDUNKNOWN; /* Cyclic by-value members */
+            goto cleanup;
+        }
+    }
+
+    UA_DataTypeRegistry_delete(reg);
+    UA_free(complete);
+    *out = arr;
+    return UA_STATUSCODE_GOOD;
+
+ cleanup:
+    UA_DataTypeRegistry_delete(reg);
+    UA_free(complete);
+    UA_free(arr);
+    freeRuntimeTypes(types, typesSize);
+    return res;
+}
+
 /*****************/
 /* Builtin Types */
 /*****************/
@@ -699,12 +1174,51 @@ UA_ExtensionObject_setValueCopy(UA_ExtensionObject *eo,
 }
 
 /* Variant */
+
+/* Shared variant data is preceded by the reference count. The union aligns
+ * the data behind the header for all builtin types. */
+typedef union {
+    size_t refCount;
+    UA_Double d;
+    UA_UInt64 u;
+    void *p;
+} VariantSharedHeader;
+
+#define VARIANT_SHARED_HEADER(data) ((VariantSharedHeader*)(data) - 1)
+
+static size_t
+Variant_dataLength(const UA_Variant *p) {
+    return (UA_Variant_isScalar(p)) ? 1 : p->arrayLength;
+}
+
+static void
+Variant_releaseShared(void *data, size_t length, const UA_DataType *type) {
+    VariantSharedHeader *h = VARIANT_SHARED_HEADER(data);
+    if(UA_atomic_subSize(&h->refCount, 1) > 0)
+        return;
+    if(!type->pointerFree) {
+        uintptr_t ptr = (uintptr_t)data;
+        for(size_t i = 0; i < length; i++) {
+            clearJumpTable[type->typeKind]((void*)ptr, type);
+            ptr += type->memSize;
+        }
+    }
+    UA_free(h);
+}
+
 static void
 Variant_clear(UA_Variant *p, const UA_DataType *_) {
     /* The content is "borrowed" */
     if(p->storageType == UA_VARIANT_DATA_NODELETE)
         return;
 
+    /* Release the reference to the shared value */
+    if(p->storageType == UA_VARIANT_DATA_SHARED) {
+        if(p->type && p->data > UA_EMPTY_ARRAY_SENTINEL)
+            Variant_releaseShared(p->data, Variant_dataLength(p), p->type);
+        p->data = NULL;
+    }
+
     /* Delete the value */
     if(p->type && p->data > UA_EMPTY_ARRAY_SENTINEL) {
         if(p->arrayLength == 0)
@@ -720,13 +1234,19 @@ Variant_clear(UA_Variant *p, const UA_DataType *_) {
 
 static UA_StatusCode
 Variant_copy(UA_Variant const *src, UA_Variant *dst, const UA_DataType *_) {
-    size_t length = src->arrayLength;
-    if(UA_Variant_isScalar(src))
-        length = 1;
-    UA_StatusCode retval = UA_Array_copy(src->data, length,
-                                         &dst->data, src->type);
-    if(retval != UA_STATUSCODE_GOOD)
-        return retval;
+    UA_StatusCode retval;
+    if(src->storageType == UA_VARIANT_DATA_SHARED &&
+       src->data > UA_EMPTY_ARRAY_SENTINEL) {
+        /* Take another reference instead of copying the data */
+        UA_atomic_addSize(&VARIANT_SHARED_HEADER(src->data)->refCount, 1);
+        dst->data = src->data;
+        dst->storageType = UA_VARIANT_DATA_SHARED;
+    } else {
+        retval = UA_Array_copy(src->data, Variant_dataLength(src),
+                               &dst->data, src->type);
+        if(retval != UA_STATUSCODE_GOOD)
+            return retval;
+    }
     dst->arrayLength = src->arrayLength;
     dst->type = src->type;
     if(src->arrayDimensions) {
@@ -739,6 +1259,65 @@ Variant_copy(UA_Variant const *src, UA_Variant *dst, const UA_DataType *_) {
     return UA_STATUSCODE_GOOD;
 }
 
+UA_StatusCode
+UA_Variant_share(UA_Variant *v) {
+    if(v->storageType == UA_VARIANT_DATA_SHARED)
+        return UA_STATUSCODE_GOOD;
+    if(v->storageType == UA_VARIANT_DATA_NODELETE)
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+    if(!v->type || v->data <= UA_EMPTY_ARRAY_SENTINEL)
+        return UA_STATUSCODE_GOOD; /* Nothing to share */
+
+    /* Move the data behind the header. The members are moved along. */
+    size_t length = Variant_dataLength(v);
+    if(length > (SIZE_MAX - sizeof(VariantSharedHeader)) / v->type->memSize)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    size_t size = length * v->type->memSize;
+    VariantSharedHeader *h = (VariantSharedHeader*)
+        UA_malloc(sizeof(VariantSharedHeader) + size);
+    if(!h)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    h->refCount = 1;
+    memcpy(h + 1, v->data, size);
+    UA_free(v->data);
+    v->data = h + 1;
+    v->storageType = UA_VARIANT_DATA_SHARED;
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_Variant_unshare(UA_Variant *v) {
+    if(v->storageType != UA_VARIANT_DATA_SHARED)
+        return UA_STATUSCODE_GOOD;
+    if(!v->type || v->data <= UA_EMPTY_ARRAY_SENTINEL) {
+        v->storageType = UA_VARIANT_DATA;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    /* The last reference moves the data out of the shared buffer. Otherwise
+     * make a private copy and release the reference. Other threads can release
+     * their references concurrently. So the refCount is read atomically. */
+    size_t length = Variant_dataLength(v);
+    VariantSharedHeader *h = VARIANT_SHARED_HEADER(v->data);
+    void *data;
+    if(UA_atomic_addSize(&h->refCount, 0) == 1) {
+        size_t size = length * v->type->memSize;
+        data = UA_malloc(size);
+        if(!data)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        memcpy(data, v->data, size);
+        UA_free(h);
+    } else {
+        UA_StatusCode res = UA_Array_copy(v->data, length, &data, v->type);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+        Variant_releaseShared(v->data, length, v->type);
+    }
+    v->data = data;
+    v->storageType = UA_VARIANT_DATA;
+    return UA_STATUSCODE_GOOD;
+}
+
 void
 UA_Variant_setScalar(UA_Variant *v, void * UA_RESTRICT p,
                      const UA_DataType *type) {
@@ -836,21 +1415,24 @@ checkAdjustRange(const UA_Variant *v, UA_NumericRange *range) {
     return UA_STATUSCODE_GOOD;
 }
 
-/* Computes the stride for copying the range elements.
- * - total: how many elements are in the range
- * - block: how big is each contiguous block of elements in the variant that
- *   maps into the range
- * - stride: how many elements are between the blocks (beginning to beginning)
- * - first: where does the first block begin */
-static void
-computeStrides(const UA_Variant *v, const UA_NumericRange range,
-               size_t *total, size_t *block, size_t *stride, size_t *first) {
-    /* Number of total elements to be copied */
-    size_t count = 1;
-    for(size_t i = 0; i < range.dimensionsSize; ++i)
-        count *= (range.dimensions[i].max - range.dimensions[i].min) + 1;
-    *total = count;
+/* The copy plan for a range within an array. The range is decomposed into runs
+ * of "block" contiguous elements. Adjacent dimensions that are fully covered by
+ * the range are merged into the block. The start positions of the runs are
+ * enumerated by the remaining outer dimensions (loops) with an element count
+ * and a stride each. The loops are ordered from the innermost dimension
+ * outwards. Dimensions with a single index in the range need no loop. */
+typedef struct {
+    size_t count; /* Total elements in the range */
+    size_t block; /* Elements in each contiguous run */
+    size_t first; /* Position of the first element */
+    size_t loopsSize;
+    size_t loopCount[UA_MAX_ARRAY_DIMS];
+    size_t loopStride[UA_MAX_ARRAY_DIMS];
+} RangePlan;
 
+static void
+computeRangePlan(const UA_Variant *v, const UA_NumericRange range,
+                 RangePlan *plan) {
     /* Assume one array dimension if none defined */
     u32 arrayLength = (u32)v->arrayLength;
     const u32 *dims = v->arrayDimensions;
@@ -860,26 +1442,128 @@ computeStrides(const UA_Variant *v, const UA_NumericRange range,
         dims = &arrayLength;
     }
 
-    /* Compute the stride length and the position of the first element */
-    *block = count;           /* Assume the range describes the entire array. */
-    *stride = v->arrayLength; /* So it can be copied as a contiguous block.   */
-    *first = 0;
+    plan->count = 1;
+    plan->block = 1;
+    plan->first = 0;
+    plan->loopsSize = 0;
     size_t running_dimssize = 1;
-    UA_Boolean found_contiguous = false;
+    UA_Boolean contiguous = true;
     for(size_t k = dims_count; k > 0;) {
         --k;
         size_t dimrange = 1 + range.dimensions[k].max - range.dimensions[k].min;
-        if(!found_contiguous && dimrange != dims[k]) {
-            /* Found the maximum block that can be copied contiguously */
-            found_contiguous = true;
-            *block = running_dimssize * dimrange;
-            *stride = running_dimssize * dims[k];
+        plan->count *= dimrange;
+        plan->first += running_dimssize * range.dimensions[k].min;
+        if(contiguous) {
+            /* Extend the block until the first partially covered dimension */
+            plan->block *= dimrange;
+            contiguous = (dimrange == dims[k]);
+        } else if(dimrange > 1) {
+            plan->loopCount[plan->loopsSize] = dimrange;
+            plan->loopStride[plan->loopsSize] = running_dimssize;
+            plan->loopsSize++;
         }
-        *first += running_dimssize * range.dimensions[k].min;
         running_dimssize *= dims[k];
     }
 }
 
+/* Iterates over the start positions of the runs in the plan */
+typedef struct {
+    const RangePlan *plan;
+    size_t pos;
+    size_t idx[UA_MAX_ARRAY_DIMS];
+} RangeIterator;
+
+static void
+RangeIterator_init(RangeIterator *it, const RangePlan *plan) {
+    it->plan = plan;
+    it->pos = plan->first;
+    memset(it->idx, 0, sizeof(size_t) * plan->loopsSize);
+}
+
+/* Advance the loops starting with the loop at index "from" */
+static void
+RangeIterator_next(RangeIterator *it, size_t from) {
+    const RangePlan *plan = it->plan;
+    for(size_t l = from; l < plan->loopsSize; l++) {
+        it->pos += plan->loopStride[l];
+        if(++it->idx[l] < plan->loopCount[l])
+            return;
+        it->pos -= plan->loopStride[l] * plan->loopCount[l];
+        it->idx[l] = 0;
+    }
+}
+
+/* Strided copy of single elements with a typed loop. Instead of a memcpy call
+ * per element, the compiler can unroll or vectorize the loop. */
+#define STRIDED_COPY(T, dst, dstStride, src, srcStride, n) do {         \
+        T *d_ = (T*)(dst);                                              \
+        const T *s_ = (const T*)(src);                                  \
+        for(size_t i_ = 0; i_ < (n); i_++)                              \
+            d_[i_ * (dstStride)] = s_[i_ * (srcStride)];                \
+    } while(0)
+
+static void
+stridedCopy(size_t elemSize, void *dst, size_t dstStride,
+            const void *src, size_t srcStride, size_t n) {
+    switch(elemSize) {
+    case 1: STRIDED_COPY(u8, dst, dstStride, src, srcStride, n); break;
+    case 2: STRIDED_COPY(u16, dst, dstStride, src, srcStride, n); break;
+    case 4: STRIDED_COPY(u32, dst, dstStride, src, srcStride, n); break;
+    case 8: STRIDED_COPY(u64, dst, dstStride, src, srcStride, n); break;
+    default: UA_assert(false); break;
+    }
+}
+
+/* Copy the memory of the elements in the range between the array and the
+ * dense buffer. Gather (array -> dense) for reading and scatter (dense ->
+ * array) for writing. Only for pointer-free types or for moving the
+ * elements. */
+static void
+copyRangeMemory(const RangePlan *plan, size_t elemSize, u8 *array,
+                u8 *dense, UA_Boolean gather) {
+    /* A single contiguous run */
+    if(plan->block == plan->count) {
+        if(gather)
+            memcpy(dense, &array[plan->first * elemSize], plan->count * elemSize);
+        else
+            memcpy(&array[plan->first * elemSize], dense, plan->count * elemSize);
+        return;
+    }
+
+    RangeIterator it;
+    RangeIterator_init(&it, plan);
+
+    /* Single elements (e.g. a column of a matrix). Copy the innermost loop
+     * with a strided kernel. */
+    if(plan->block == 1 && plan->loopsSize > 0 &&
+       (elemSize == 1 || elemSize == 2 || elemSize == 4 || elemSize == 8)) {
+        size_t n = plan->loopCount[0];
+        size_t stride = plan->loopStride[0];
+        for(size_t done = 0; done < plan->count; done += n) {
+            u8 *a = &array[it.pos * elemSize];
+            u8 *d = &dense[done * elemSize];
+            if(gather)
+                stridedCopy(elemSize, d, 1, a, stride, n);
+            else
+                stridedCopy(elemSize, a, stride, d, 1, n);
+            RangeIterator_next(&it, 1);
+        }
+        return;
+    }
+
+    /* One memcpy per contiguous run */
+    size_t runSize = plan->block * elemSize;
+    for(size_t done = 0; done < plan->count; done += plan->block) {
+        u8 *a = &array[it.pos * elemSize];
+        if(gather)
+            memcpy(dense, a, runSize);
+        else
+            memcpy(a, dense, runSize);
+        dense += runSize;
+        RangeIterator_next(&it, 0);
+    }
+}
+
 /* Is the type string-like? */
 static UA_Boolean
 isStringLike(const UA_DataType *type) {
@@ -963,10 +1647,10 @@ UA_Variant_copyRange(const UA_Variant *src, UA_Variant * UA_RESTRICT dst,
     if(retval != UA_STATUSCODE_GOOD)
         return retval;
 
-    /* Compute the strides */
-    size_t count, block, stride, first;
-    computeStrides(src, thisrange, &count, &block, &stride, &first);
-    UA_assert(block > 0);
+    /* Compute the copy plan */
+    RangePlan plan;
+    computeRangePlan(src, thisrange, &plan);
+    size_t count = plan.count;
 
     /* Allocate the array */
     UA_Variant_init(dst);
@@ -975,43 +1659,30 @@ UA_Variant_copyRange(const UA_Variant *src, UA_Variant * UA_RESTRICT dst,
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
     /* Copy the range */
-    size_t block_count = count / block;
     size_t elem_size = src->type->memSize;
-    uintptr_t nextdst = (uintptr_t)dst->data;
-    uintptr_t nextsrc = (uintptr_t)src->data + (elem_size * first);
-    if(nextrange.dimensionsSize == 0) {
-        /* no nextrange */
-        if(src->type->pointerFree) {
-            for(size_t i = 0; i < block_count; ++i) {
-                memcpy((void*)nextdst, (void*)nextsrc, elem_size * block);
-                nextdst += block * elem_size;
-                nextsrc += stride * elem_size;
-            }
-        } else {
-            for(size_t i = 0; i < block_count; ++i) {
-                for(size_t j = 0; j < block; ++j) {
-                    retval = UA_copy((const void*)nextsrc,
-                                     (void*)nextdst, src->type);
-                    nextdst += elem_size;
-                    nextsrc += elem_size;
-                }
-                nextsrc += (stride - block) * elem_size;
-            }
-        }
+    if(nextrange.dimensionsSize == 0 && src->type->pointerFree) {
+        copyRangeMemory(&plan, elem_size, (u8*)src->data, (u8*)dst->data, true);
     } else {
-        /* nextrange can only be used for variants and stringlike with remaining
-         * range of dimension 1 */
-        if(src->type != &UA_TYPES[UA_TYPES_VARIANT]) {
+        /* nextrange can only be used for variants and stringlike with
+         * remaining range of dimension 1 */
+        if(nextrange.dimensionsSize > 0 && src->type != &UA_TYPES[UA_TYPES_VARIANT]) {
             if(!stringLike)
                 retval = UA_STATUSCODE_BADINDEXRANGENODATA;
             if(nextrange.dimensionsSize != 1)
                 retval = UA_STATUSCODE_BADINDEXRANGENODATA;
         }
 
-        /* Copy the content */
-        for(size_t i = 0; i < block_count; ++i) {
-            for(size_t j = 0; j < block && retval == UA_STATUSCODE_GOOD; ++j) {
-                if(stringLike)
+        /* Copy element by element */
+        RangeIterator it;
+        RangeIterator_init(&it, &plan);
+        uintptr_t nextdst = (uintptr_t)dst->data;
+        for(size_t done = 0; done < count && retval == UA_STATUSCODE_GOOD;
+            done += plan.block) {
+            uintptr_t nextsrc = (uintptr_t)src->data + (elem_size * it.pos);
+            for(size_t j = 0; j < plan.block && retval == UA_STATUSCODE_GOOD; ++j) {
+                if(nextrange.dimensionsSize == 0)
+                    retval = UA_copy((const void*)nextsrc, (void*)nextdst, src->type);
+                else if(stringLike)
                     retval = copySubString((const UA_String*)nextsrc,
                                            (UA_String*)nextdst,
                                            nextrange.dimensions);
@@ -1022,7 +1693,7 @@ UA_Variant_copyRange(const UA_Variant *src, UA_Variant * UA_RESTRICT dst,
                 nextdst += elem_size;
                 nextsrc += elem_size;
             }
-            nextsrc += (stride - block) * elem_size;
+            RangeIterator_next(&it, 0);
         }
     }
 
@@ -1063,6 +1734,11 @@ Variant_setRange(UA_Variant *v, void *array, size_t arraySize,
     if(!v->type)
         return UA_STATUSCODE_BADINVALIDARGUMENT;
 
+    /* Shared data is immutable. Write into a private copy. */
+    UA_StatusCode retval = UA_Variant_unshare(v);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
     /* Upper bound of the dimensions for stack-allocation */
     if(range.dimensionsSize > UA_MAX_ARRAY_DIMS)
         return UA_STATUSCODE_BADINTERNALERROR;
@@ -1072,42 +1748,53 @@ Variant_setRange(UA_Variant *v, void *array, size_t arraySize,
     memcpy(thisrangedims, range.dimensions, sizeof(UA_NumericRangeDimension) * range.dimensionsSize);
     UA_NumericRange thisrange = {range.dimensionsSize, thisrangedims};
 
-    UA_StatusCode retval = checkAdjustRange(v, &thisrange);
+    retval = checkAdjustRange(v, &thisrange);
     if(retval != UA_STATUSCODE_GOOD)
         return retval;
 
-    /* Compute the strides */
-    size_t count, block, stride, first;
-    computeStrides(v, range, &count, &block, &stride, &first);
-    if(count != arraySize)
+    /* Compute the copy plan. The range must be entirely within the array. It
+     * was reduced to fit by checkAdjustRange otherwise. */
+    RangePlan plan;
+    computeRangePlan(v, thisrange, &plan);
+    if(plan.count != arraySize)
         return UA_STATUSCODE_BADINDEXRANGEINVALID;
 
     /* Move/copy the elements */
-    size_t block_count = count / block;
     size_t elem_size = v->type->memSize;
-    uintptr_t nextdst = (uintptr_t)v->data + (first * elem_size);
-    uintptr_t nextsrc = (uintptr_t)array;
     if(v->type->pointerFree || !copy) {
-        for(size_t i = 0; i < block_count; ++i) {
-            memcpy((void*)nextdst, (void*)nextsrc, elem_size * block);
-            nextsrc += block * elem_size;
-            nextdst += stride * elem_size;
+        /* Clear the replaced elements before moving in the new ones */
+        if(!v->type->pointerFree) {
+            RangeIterator it;
+            RangeIterator_init(&it, &plan);
+            for(size_t done = 0; done < plan.count; done += plan.block) {
+                uintptr_t nextdst = (uintptr_t)v->data + (elem_size * it.pos);
+                for(size_t j = 0; j < plan.block; ++j) {
+                    clearJumpTable[v->type->typeKind]((void*)nextdst, v->type);
+                    nextdst += elem_size;
+                }
+                RangeIterator_next(&it, 0);
+            }
         }
+        copyRangeMemory(&plan, elem_size, (u8*)v->data, (u8*)array, false);
     } else {
-        for(size_t i = 0; i < block_count; ++i) {
-            for(size_t j = 0; j < block; ++j) {
+        RangeIterator it;
+        RangeIterator_init(&it, &plan);
+        uintptr_t nextsrc = (uintptr_t)array;
+        for(size_t done = 0; done < plan.count; done += plan.block) {
+            uintptr_t nextdst = (uintptr_t)v->data + (elem_size * it.pos);
+            for(size_t j = 0; j < plan.block; ++j) {
                 clearJumpTable[v->type->typeKind]((void*)nextdst, v->type);
                 retval |= UA_copy((void*)nextsrc, (void*)nextdst, v->type);
                 nextdst += elem_size;
                 nextsrc += elem_size;
             }
-            nextdst += (stride - block) * elem_size;
+            RangeIterator_next(&it, 0);
         }
     }
 
     /* If members were moved, initialize original array to prevent reuse */
     if(!copy && !v->type->pointerFree)
-        memset(array, 0, sizeof(elem_size)*arraySize);
+        memset(array, 0, elem_size * arraySize);
 
     return retval;
 }
@@ -1168,6 +1855,25 @@ UA_DataValue_copyVariantRange(const UA_DataValue *src, UA_DataValue * UA_RESTRIC
     return retval;
 }
 
+UA_StatusCode
+UA_DataValue_copyReuse(const UA_DataValue *src, UA_DataValue *dst) {
+    /* Reuse the memory if both hold a pointer-free scalar of the same type */
+    const UA_Variant *sv = &src->value;
+    if(sv->type && sv->type == dst->value.type && sv->type->pointerFree &&
+       dst->value.storageType == UA_VARIANT_DATA &&
+       UA_Variant_isScalar(sv) && UA_Variant_isScalar(&dst->value)) {
+        UA_Variant tmp = dst->value;
+        memcpy(tmp.data, sv->data, sv->type->memSize);
+        memcpy(dst, src, sizeof(UA_DataValue));
+        dst->value = tmp;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    /* Make a deep copy */
+    DataValue_clear(dst, NULL);
+    return DataValue_copy(src, dst, NULL);
+}
+
 /* DiagnosticInfo */
 static void
 DiagnosticInfo_clear(UA_DiagnosticInfo *p, const UA_DataType *_) {
@@ -1649,6 +2355,40 @@ extensionObjectOrder(const UA_ExtensionObject *p1, const UA_ExtensionObject *p2,
     }
 }
 
+/* Bitwise identical elements of a pointer-free type are equal. (The reverse
+ * does not hold. For example -0.0 and 0.0, or padding bytes in structures.) So
+ * blocks of elements that are identical in memory are skipped with memcmp,
+ * which runs at memory bandwidth. Only the elements of a block with a
+ * difference are ordered with the type-specific rules. */
+#define UA_ORDER_BLOCKSIZE 256
+
+static UA_Order
+pointerFreeArrayOrder(const UA_Byte *u1, const UA_Byte *u2, size_t length,
+                      const UA_DataType *type) {
+    const size_t memSize = type->memSize;
+    size_t blockLength = UA_ORDER_BLOCKSIZE / memSize;
+    if(blockLength == 0)
+        blockLength = 1;
+    const UA_orderSignature orderElement = orderJumpTable[type->typeKind];
+    size_t i = 0;
+    while(i < length) {
+        size_t n = length - i;
+        if(n > blockLength)
+            n = blockLength;
+        if(memcmp(u1, u2, n * memSize) != 0) {
+            for(size_t j = 0; j < n; j++) {
+                UA_Order o = orderElement(&u1[j * memSize], &u2[j * memSize], type);
+                if(o != UA_ORDER_EQ)
+                    return o;
+            }
+        }
+        u1 += n * memSize;
+        u2 += n * memSize;
+        i += n;
+    }
+    return UA_ORDER_EQ;
+}
+
 /* Part 4: When testing for equality, a Server shall treat null and empty arrays
  * as equal.
  *
@@ -1661,6 +2401,9 @@ arrayOrder(const void *p1, size_t p1Length,
            const UA_DataType *type) {
     if(p1Length != p2Length)
         return (p1Length < p2Length) ? UA_ORDER_LESS : UA_ORDER_MORE;
+    if(type->pointerFree && p1Length > 0)
+        return pointerFreeArrayOrder((const UA_Byte*)p1, (const UA_Byte*)p2,
+                                     p1Length, type);
     uintptr_t u1 = (uintptr_t)p1;
     uintptr_t u2 = (uintptr_t)p2;
     for(size_t i = 0; i < p1Length; i++) {
@@ -1691,7 +2434,11 @@ variantOrder(const UA_Variant *p1, const UA_Variant *p2, const UA_DataType *_) {
             /* Mismatching array length? */
             if(p1->arrayLength != p2->arrayLength)
                 return (p1->arrayLength < p2->arrayLength) ? UA_ORDER_LESS : UA_ORDER_MORE;
-            o = arrayOrder(p1->data, p1->arrayLength, p2->data, p2->arrayLength, p1->type);
+            /* Same (shared) array? The order is reflexive, also for NaN. */
+            if(p1->data == p2->data)
+                o = UA_ORDER_EQ;
+            else
+                o = arrayOrder(p1->data, p1->arrayLength, p2->data, p2->arrayLength, p1->type);
         }
         if(o != UA_ORDER_EQ)
             return o;
@@ -1808,6 +2555,9 @@ diagnosticInfoOrder(const UA_DiagnosticInfo *p1, const UA_DiagnosticInfo *p2,
 
 static UA_Order
 structureOrder(const void *p1, const void *p2, const UA_DataType *type) {
+    /* Bitwise identical. Avoid the member-by-member comparison. */
+    if(type->pointerFree && memcmp(p1, p2, type->memSize) == 0)
+        return UA_ORDER_EQ;
     uintptr_t u1 = (uintptr_t)p1;
     uintptr_t u2 = (uintptr_t)p2;
     UA_Order o = UA_ORDER_EQ;
@@ -1943,6 +2693,118 @@ UA_Array_new(size_t size, const UA_DataType *type) {
     return UA_calloc(size, type->memSize);
 }
 
+/* Bulk kernels for arrays of structures. The members that own heap memory
+ * are collected once for the entire array. The other members are copied with
+ * a single memcpy of the array and skipped when the elements are cleared. */
+
+#define UA_BULK_MAXHEAPMEMBERS 32
+
+typedef struct {
+    const UA_DataType *type;
+    size_t offset;
+    UA_Boolean isArray;
+} HeapMember;
+
+/* Returns false if the kernels don't apply to the type */
+static UA_Boolean
+getHeapMembers(const UA_DataType *type, HeapMember *hm, size_t *hmSize) {
+    if(type->typeKind != UA_DATATYPEKIND_STRUCTURE)
+        return false;
+    size_t offset = 0;
+    size_t count = 0;
+    for(size_t i = 0; i < type->membersSize; ++i) {
+        const UA_DataTypeMember *m = &type->members[i];
+        const UA_DataType *mt = m->memberType;
+        offset += m->padding;
+        if(!m->isArray && mt->pointerFree) {
+            offset += mt->memSize;
+            continue;
+        }
+        if(count == UA_BULK_MAXHEAPMEMBERS)
+            return false;
+        hm[count].type = mt;
+        hm[count].offset = offset;
+        hm[count].isArray = m->isArray;
+        count++;
+        offset += (m->isArray) ? sizeof(size_t) + sizeof(void*) : mt->memSize;
+    }
+    *hmSize = count;
+    return true;
+}
+
+/* The dst array is a shallow copy of src. Replace the heap members with deep
+ * copies. All elements are processed also after an error. So that the array
+ * contains no borrowed pointers and can be deleted. */
+static UA_StatusCode
+copyHeapMembers(const void *src, void *dst, size_t size, const UA_DataType *type,
+                const HeapMember *hm, size_t hmSize) {
+    UA_StatusCode retval = UA_STATUSCODE_GOOD;
+    uintptr_t ptrs = (uintptr_t)src;
+    uintptr_t ptrd = (uintptr_t)dst;
+    for(size_t i = 0; i < size; ++i) {
+        for(size_t j = 0; j < hmSize; ++j) {
+            const UA_DataType *mt = hm[j].type;
+            const void *ms = (const void*)(ptrs + hm[j].offset);
+            void *md = (void*)(ptrd + hm[j].offset);
+            UA_StatusCode res;
+            if(hm[j].isArray) {
+                size_t *dst_size = (size_t*)md;
+                void **dst_data = (void**)((uintptr_t)md + sizeof(size_t));
+                *dst_size = 0;
+                *dst_data = NULL;
+                res = UA_Array_copy(*(void* const*)((uintptr_t)ms + sizeof(size_t)),
+                                    *(const size_t*)ms, dst_data, mt);
+                if(res == UA_STATUSCODE_GOOD)
+                    *dst_size = *(const size_t*)ms;
+            } else {
+                memset(md, 0, mt->memSize);
+                res = copyJumpTable[mt->typeKind](ms, md, mt);
+                if(res != UA_STATUSCODE_GOOD) {
+                    clearJumpTable[mt->typeKind](md, mt);
+                    memset(md, 0, mt->memSize);
+                }
+            }
+            retval |= res;
+        }
+        ptrs += type->memSize;
+        ptrd += type->memSize;
+    }
+    return retval;
+}
+
+static void
+clearHeapMembers(void *p, size_t size, const UA_DataType *type,
+                 const HeapMember *hm, size_t hmSize) {
+    uintptr_t ptr = (uintptr_t)p;
+    for(size_t i = 0; i < size; ++i) {
+        for(size_t j = 0; j < hmSize; ++j) {
+            void *m = (void*)(ptr + hm[j].offset);
+            if(hm[j].isArray)
+                UA_Array_delete(*(void**)((uintptr_t)m + sizeof(size_t)),
+                                *(size_t*)m, hm[j].type);
+            else
+                clearJumpTable[hm[j].type->typeKind](m, hm[j].type);
+        }
+        ptr += type->memSize;
+    }
+}
+
+/* Only the variant of a DataValue owns heap memory */
+static UA_StatusCode
+copyDataValueArray(const UA_DataValue *src, UA_DataValue *dst, size_t size) {
+    UA_StatusCode retval = UA_STATUSCODE_GOOD;
+    for(size_t i = 0; i < size; ++i) {
+        UA_Variant_init(&dst[i].value);
+        UA_StatusCode res = Variant_copy(&src[i].value, &dst[i].value, NULL);
+        if(res != UA_STATUSCODE_GOOD) {
+            Variant_clear(&dst[i].value, NULL);
+            UA_Variant_init(&dst[i].value);
+        }
+        retval |= res;
+    }
+    return retval;
+}
+
 UA_StatusCode
 UA_Array_copy(const void *src, size_t size,
               void **dst, const UA_DataType *type) {
@@ -1959,8 +2821,8 @@ UA_Array_copy(const void *src, size_t size,
     if(UA_UNLIKELY(!type || !src))
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    /* calloc, so we don't have to check retval in every iteration of copying */
-    *dst = UA_calloc(size, type->memSize);
+    /* Every element is initialized below. Also when the copy fails. */
+    *dst = UA_malloc(size * type->memSize);
     if(!*dst)
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
@@ -1969,13 +2831,24 @@ UA_Array_copy(const void *src, size_t size,
         return UA_STATUSCODE_GOOD;
     }
 
-    uintptr_t ptrs = (uintptr_t)src;
-    uintptr_t ptrd = (uintptr_t)*dst;
+    /* Shallow copy of the array. Then deep-copy the heap members. */
     UA_StatusCode retval = UA_STATUSCODE_GOOD;
-    for(size_t i = 0; i < size; ++i) {
-        retval |= UA_copy((void*)ptrs, (void*)ptrd, type);
-        ptrs += type->memSize;
-        ptrd += type->memSize;
+    HeapMember hm[UA_BULK_MAXHEAPMEMBERS];
+    size_t hmSize = 0;
+    if(type->typeKind == UA_DATATYPEKIND_DATAVALUE) {
+        memcpy(*dst, src, type->memSize * size);
+        retval = copyDataValueArray((const UA_DataValue*)src, (UA_DataValue*)*dst, size);
+    } else if(getHeapMembers(type, hm, &hmSize)) {
+        memcpy(*dst, src, type->memSize * size);
+        retval = copyHeapMembers(src, *dst, size, type, hm, hmSize);
+    } else {
+        uintptr_t ptrs = (uintptr_t)src;
+        uintptr_t ptrd = (uintptr_t)*dst;
+        for(size_t i = 0; i < size; ++i) {
+            retval |= UA_copy((void*)ptrs, (void*)ptrd, type);
+            ptrs += type->memSize;
+            ptrd += type->memSize;
+        }
     }
     if(retval != UA_STATUSCODE_GOOD) {
         UA_Array_delete(*dst, size, type);
@@ -2074,10 +2947,17 @@ UA_Array_appendCopy(void **p, size_t *size, const void *newElem,
 
 void
 UA_Array_delete(void *p, size_t size, const UA_DataType *type) {
-    if(!type->pointerFree) {
+    /* The elements are not reset as the array is freed */
+    HeapMember hm[UA_BULK_MAXHEAPMEMBERS];
+    size_t hmSize = 0;
+    if(type->pointerFree) {
+        /* Nothing to clear */
+    } else if(getHeapMembers(type, hm, &hmSize)) {
+        clearHeapMembers(p, size, type, hm, hmSize);
+    } else {
         uintptr_t ptr = (uintptr_t)p;
         for(size_t i = 0; i < size; ++i) {
-            UA_clear((void*)ptr, type);
+            clearJumpTable[type->typeKind]((void*)ptr, type);
             ptr += type->memSize;
         }
     }
@@ -2174,10 +3054,11 @@ readDimension(UA_Byte *buf, size_t buflen, UA_NumericRangeDimension *dim) {
 }
 
 UA_StatusCode
-UA_NumericRange_parse(UA_NumericRange *range, const UA_String str) {
+UA_NumericRange_parseInto(UA_NumericRange *range, UA_NumericRangeDimension *buf,
+                          size_t bufSize, const UA_String str) {
     size_t idx = 0;
-    size_t dimensionsMax = 0;
-    UA_NumericRangeDimension *dimensions = NULL;
+    size_t dimensionsMax = bufSize;
+    UA_NumericRangeDimension *dimensions = buf;
     UA_StatusCode retval = UA_STATUSCODE_GOOD;
     size_t offset = 0;
     while(true) {
@@ -2185,7 +3066,14 @@ UA_NumericRange_parse(UA_NumericRange *range, const UA_String str) {
         if(idx >= dimensionsMax) {
             UA_NumericRangeDimension *newds;
             size_t newdssize = sizeof(UA_NumericRangeDimension) * (dimensionsMax + 2);
-            newds = (UA_NumericRangeDimension*)UA_realloc(dimensions, newdssize);
+            if(dimensions == buf) {
+                /* Move out of the caller-provided buffer */
+                newds = (UA_NumericRangeDimension*)UA_malloc(newdssize);
+                if(newds && idx > 0)
+                    memcpy(newds, buf, sizeof(UA_NumericRangeDimension) * idx);
+            } else {
+                newds = (UA_NumericRangeDimension*)UA_realloc(dimensions, newdssize);
+            }
             if(!newds) {
                 retval = UA_STATUSCODE_BADOUTOFMEMORY;
                 break;
@@ -2218,9 +3106,14 @@ UA_NumericRange_parse(UA_NumericRange *range, const UA_String str) {
     if(retval == UA_STATUSCODE_GOOD && idx > 0) {
         range->dimensions = dimensions;
         range->dimensionsSize = idx;
-    } else {
+    } else if(dimensions != buf) {
         UA_free(dimensions);
     }
 
     return retval;
 }
+
+UA_StatusCode
+UA_NumericRange_parse(UA_NumericRange *range, const UA_String str) {
+    return UA_NumericRange_parseInto(range, NULL, 0, str);
+}
@@ -120,6 +120,191 @@ encodeWithExchangeBuffer(Ctx *ctx, const void *ptr, const UA_DataType *type) {
     return ret;
 }
 
+/************/
+/* Segments */
+/************/
+
+/* Decoding reads from a list of segments. All bounds checks have a fast path
+ * for the current segment. The functions here are only called when the
+ * current segment does not contain enough bytes. */
+
+/* Position in the message (across all segments) */
+static size_t
+ctxOffset(const Ctx *ctx) {
+    if(ctx->stitched)
+        return ctx->stitchOffset + (size_t)(ctx->pos - ctx->stitch);
+    return ctx->segmentOffset +
+        (size_t)(ctx->pos - ctx->segments[ctx->segment].data);
+}
+
+/* Bytes left in the message */
+static size_t
+ctxRemaining(const Ctx *ctx) {
+    if(!ctx->segments)
+        return (size_t)(ctx->end - ctx->pos);
+    return ctx->messageLength - ctxOffset(ctx);
+}
+
+/* Move to the segment that contains the message offset. An offset at a
+ * boundary points to the beginning of the following segment. */
+static void
+ctxSeek(Ctx *ctx, size_t offset) {
+    UA_assert(offset <= ctx->messageLength);
+    if(offset < ctx->segmentOffset) {
+        ctx->segment = 0;
+        ctx->segmentOffset = 0;
+    }
+    while(ctx->segment + 1 < ctx->segmentsSize &&
+          offset >= ctx->segmentOffset + ctx->segments[ctx->segment].length) {
+        ctx->segmentOffset += ctx->segments[ctx->segment].length;
+        ctx->segment++;
+    }
+    const UA_ByteString *seg = &ctx->segments[ctx->segment];
+    ctx->pos = &seg->data[offset - ctx->segmentOffset];
+    ctx->end = &seg->data[seg->length];
+    ctx->stitched = false;
+}
+
+/* Copy the next n bytes (possibly across segments) and advance */
+static UA_Boolean
+ctxRead(Ctx *ctx, void *dst, size_t n) {
+    if(UA_LIKELY(n <= (size_t)(ctx->end - ctx->pos))) {
+        memcpy(dst, ctx->pos, n);
+        ctx->pos += n;
+        return true;
+    }
+    if(!ctx->segments)
+        return false;
+    size_t offset = ctxOffset(ctx);
+    if(n > ctx->messageLength - offset)
+        return false;
+    u8 *d = (u8*)dst;
+    ctxSeek(ctx, offset);
+    while(n > (size_t)(ctx->end - ctx->pos)) {
+        size_t part = (size_t)(ctx->end - ctx->pos);
+        memcpy(d, ctx->pos, part);
+        d += part;
+        n -= part;
+        offset += part;
+        ctxSeek(ctx, offset);
+    }
+    memcpy(d, ctx->pos, n);
+    ctx->pos += n;
+    return true;
+}
+
+static UA_Boolean
+ctxSkip(Ctx *ctx, size_t n) {
+    if(UA_LIKELY(n <= (size_t)(ctx->end - ctx->pos))) {
+        ctx->pos += n;
+        return true;
+    }
+    if(!ctx->segments)
+        return false;
+    size_t offset = ctxOffset(ctx);
+    if(n > ctx->messageLength - offset)
+        return false;
+    ctxSeek(ctx, offset + n);
+    return true;
+}
+
+/* Make n contiguous bytes available at ctx->pos. If the value straddles a
+ * segment boundary, it is copied into the stitch buffer together with the
+ * bytes that follow. Reading continues in the segments once the stitch buffer
+ * is used up. */
+static UA_Boolean
+ctxNextSegment(Ctx *ctx, size_t n) {
+    if(!ctx->segments || n > sizeof(ctx->stitch))
+        return false;
+    size_t offset = ctxOffset(ctx);
+    size_t remaining = ctx->messageLength - offset;
+    if(n > remaining)
+        return false;
+    ctxSeek(ctx, offset);
+    if(n <= (size_t)(ctx->end - ctx->pos))
+        return true;
+    if(remaining > sizeof(ctx->stitch))
+        remaining = sizeof(ctx->stitch);
+    ctxRead(ctx, ctx->stitch, remaining);
+    ctx->stitchOffset = offset;
+    ctx->stitched = true;
+    ctx->pos = ctx->stitch;
+    ctx->end = &ctx->stitch[remaining];
+    return true;
+}
+
+#define DECODE_AVAILABLE(n)                                         \
+    (UA_LIKELY(ctx->pos + (n) <= ctx->end) || ctxNextSegment(ctx, n))
+
+/* Saved position to return to after a lookahead */
+typedef struct {
+    u8 *pos;
+    const u8 *end;
+    size_t segment;
+    size_t segmentOffset;
+} CtxMark;
+
+static void
+ctxMark(Ctx *ctx, CtxMark *mark) {
+    if(ctx->segments && ctx->stitched)
+        ctxSeek(ctx, ctxOffset(ctx)); /* Leave the stitch buffer */
+    mark->pos = ctx->pos;
+    mark->end = ctx->end;
+    mark->segment = ctx->segment;
+    mark->segmentOffset = ctx->segmentOffset;
+}
+
+static void
+ctxReset(Ctx *ctx, const CtxMark *mark) {
+    ctx->pos = mark->pos;
+    ctx->end = mark->end;
+    if(!ctx->segments)
+        return;
+    ctx->segment = mark->segment;
+    ctx->segmentOffset = mark->segmentOffset;
+    ctx->stitched = false;
+}
+
+/* Bytes decoded since the mark */
+static size_t
+ctxDistance(const Ctx *ctx, const CtxMark *mark) {
+    if(!ctx->segments)
+        return (size_t)(ctx->pos - mark->pos);
+    return ctxOffset(ctx) - (mark->segmentOffset +
+        (size_t)(mark->pos - ctx->segments[mark->segment].data));
+}
+
+/* Compare the next n bytes with data and advance */
+static UA_Boolean
+ctxMatch(Ctx *ctx, const u8 *data, size_t n) {
+    if(UA_LIKELY(n <= (size_t)(ctx->end - ctx->pos))) {
+        UA_Boolean match = (memcmp(ctx->pos, data, n) == 0);
+        ctx->pos += n;
+        return match;
+    }
+    u8 buf[32];
+    while(n > 0) {
+        size_t part = (n < sizeof(buf)) ? n : sizeof(buf);
+        if(!ctxRead(ctx, buf, part) || memcmp(buf, data, part) != 0)
+            return false;
+        data += part;
+        n -= part;
+    }
+    return true;
+}
+
+/* Scalar structure members whose memory layout is identical to the binary
+ * encoding are copied directly inside the structure loops. This avoids the
+ * indirect call through the jumptable and the buffer-exchange wrapper for each
+ * member. Floating point types are excluded as their NaN values are
+ * normalized during en-/decoding. */
+static UA_INLINE UA_Boolean
+directMember(const UA_DataType *mt) {
+    return (mt->overlayable &&
+            mt->typeKind != UA_DATATYPEKIND_FLOAT &&
+            mt->typeKind != UA_DATATYPEKIND_DOUBLE);
+}
+
 /*****************/
 /* Integer Types */
 /*****************/
@@ -188,7 +373,7 @@ FUNC_ENCODE_BINARY(Boolean) {
 }
 
 FUNC_DECODE_BINARY(Boolean) {
-    UA_CHECK(ctx->pos + 1 <= ctx->end, return UA_STATUSCODE_BADDECODINGERROR);
+    UA_CHECK(DECODE_AVAILABLE(1), return UA_STATUSCODE_BADDECODINGERROR);
     *dst = (*ctx->pos > 0) ? true : false;
     ++ctx->pos;
     return UA_STATUSCODE_GOOD;
@@ -204,7 +389,7 @@ FUNC_ENCODE_BINARY(Byte) {
 }
 
 FUNC_DECODE_BINARY(Byte) {
-    UA_CHECK(ctx->pos + sizeof(u8) <= ctx->end,
+    UA_CHECK(DECODE_AVAILABLE(sizeof(u8)),
              return UA_STATUSCODE_BADDECODINGERROR);
     *dst = *ctx->pos;
     ++ctx->pos;
@@ -225,7 +410,7 @@ FUNC_ENCODE_BINARY(UInt16) {
 }
 
 FUNC_DECODE_BINARY(UInt16) {
-    UA_CHECK(ctx->pos + sizeof(u16) <= ctx->end,
+    UA_CHECK(DECODE_AVAILABLE(sizeof(u16)),
              return UA_STATUSCODE_BADDECODINGERROR);
 #if UA_BINARY_OVERLAYABLE_INTEGER
     memcpy(dst, ctx->pos, sizeof(u16));
@@ -250,7 +435,7 @@ FUNC_ENCODE_BINARY(UInt32) {
 }
 
 FUNC_DECODE_BINARY(UInt32) {
-    UA_CHECK(ctx->pos + sizeof(u32) <= ctx->end,
+    UA_CHECK(DECODE_AVAILABLE(sizeof(u32)),
              return UA_STATUSCODE_BADDECODINGERROR);
 #if UA_BINARY_OVERLAYABLE_INTEGER
     memcpy(dst, ctx->pos, sizeof(u32));
@@ -275,7 +460,7 @@ FUNC_ENCODE_BINARY(UInt64) {
 }
 
 FUNC_DECODE_BINARY(UInt64) {
-    UA_CHECK(ctx->pos + sizeof(u64) <= ctx->end,
+    UA_CHECK(DECODE_AVAILABLE(sizeof(u64)),
              return UA_STATUSCODE_BADDECODINGERROR);
 #if UA_BINARY_OVERLAYABLE_INTEGER
     memcpy(dst, ctx->pos, sizeof(u64));
@@ -421,6 +606,110 @@ FUNC_DECODE_BINARY(Double) {
 /* Array Handling */
 /******************/
 
+/* Arrays of fixed-size numeric types that cannot be copied with memcpy (e.g.
+ * integers on big-endian targets or floating point values without native
+ * IEEE 754 layout) are converted in batches. The loops call the static
+ * per-element routines directly. So they get inlined and the compiler can
+ * vectorize the byte-swapping. This avoids the jumptable and the
+ * buffer-exchange wrapper for every element. */
+static UA_Boolean
+fixedSizeNumeric(const UA_DataType *type) {
+    switch(type->typeKind) {
+    case UA_DATATYPEKIND_INT16:
+    case UA_DATATYPEKIND_UINT16:
+    case UA_DATATYPEKIND_INT32:
+    case UA_DATATYPEKIND_UINT32:
+    case UA_DATATYPEKIND_INT64:
+    case UA_DATATYPEKIND_UINT64:
+    case UA_DATATYPEKIND_FLOAT:
+    case UA_DATATYPEKIND_DOUBLE:
+    case UA_DATATYPEKIND_DATETIME:
+    case UA_DATATYPEKIND_STATUSCODE:
+    case UA_DATATYPEKIND_ENUM:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/* The buffer has space for all elements */
+static void
+encodeFixedArray(Ctx *ctx, const void *src, size_t length,
+                 const UA_DataType *type) {
+    size_t i;
+    if(type->typeKind == UA_DATATYPEKIND_FLOAT) {
+        for(i = 0; i < length; i++)
+            Float_encodeBinary(ctx, &((const UA_Float*)src)[i], NULL);
+    } else if(type->typeKind == UA_DATATYPEKIND_DOUBLE) {
+        for(i = 0; i < length; i++)
+            Double_encodeBinary(ctx, &((const UA_Double*)src)[i], NULL);
+    } else if(type->memSize == sizeof(u16)) {
+        for(i = 0; i < length; i++)
+            UInt16_encodeBinary(ctx, &((const u16*)src)[i], NULL);
+    } else if(type->memSize == sizeof(u32)) {
+        for(i = 0; i < length; i++)
+            UInt32_encodeBinary(ctx, &((const u32*)src)[i], NULL);
+    } else {
+        UA_assert(type->memSize == sizeof(u64));
+        for(i = 0; i < length; i++)
+            UInt64_encodeBinary(ctx, &((const u64*)src)[i], NULL);
+    }
+}
+
+/* The buffer contains all elements */
+static void
+decodeFixedArray(Ctx *ctx, void *dst, size_t length,
+                 const UA_DataType *type) {
+    size_t i;
+    if(type->typeKind == UA_DATATYPEKIND_FLOAT) {
+        for(i = 0; i < length; i++)
+            (void)Float_decodeBinary(ctx, &((UA_Float*)dst)[i], NULL);
+    } else if(type->typeKind == UA_DATATYPEKIND_DOUBLE) {
+        for(i = 0; i < length; i++)
+            (void)Double_decodeBinary(ctx, &((UA_Double*)dst)[i], NULL);
+    } else if(type->memSize == sizeof(u16)) {
+        for(i = 0; i < length; i++)
+            (void)UInt16_decodeBinary(ctx, &((u16*)dst)[i], NULL);
+    } else if(type->memSize == sizeof(u32)) {
+        for(i = 0; i < length; i++)
+            (void)UInt32_decodeBinary(ctx, &((u32*)dst)[i], NULL);
+    } else {
+        UA_assert(type->memSize == sizeof(u64));
+        for(i = 0; i < length; i++)
+            (void)UInt64_decodeBinary(ctx, &((u64*)dst)[i], NULL);
+    }
+}
+
+static status
+Array_encodeBinaryFixed(Ctx *ctx, uintptr_t ptr, size_t length,
+                        const UA_DataType *type) {
+    /* CalcSize only */
+    if(ctx->end == NULL) {
+        ctx->pos += length * type->memSize;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    /* Encode as many elements as fit into the current chunk. Then exchange
+     * the buffer and continue. */
+    while(length > 0) {
+        size_t possible = (size_t)(ctx->end - ctx->pos) / type->memSize;
+        if(possible == 0) {
+            status ret = exchangeBuffer(ctx);
+            UA_assert(ret != UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED);
+            UA_CHECK_STATUS(ret, return ret);
+            if(UA_UNLIKELY(ctx->pos + type->memSize > ctx->end))
+                return UA_STATUSCODE_BADENCODINGERROR;
+            continue;
+        }
+        if(possible > length)
+            possible = length;
+        encodeFixedArray(ctx, (const void*)ptr, possible, type);
+        ptr += possible * type->memSize;
+        length -= possible;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
 static status
 Array_encodeBinaryOverlayable(Ctx *ctx, uintptr_t ptr, size_t memSize) {
     /* CalcSize only */
@@ -450,6 +739,9 @@ Array_encodeBinaryOverlayable(Ctx *ctx, uintptr_t ptr, size_t memSize) {
 static status
 Array_encodeBinaryComplex(Ctx *ctx, uintptr_t ptr, size_t length,
                           const UA_DataType *type) {
+    if(fixedSizeNumeric(type))
+        return Array_encodeBinaryFixed(ctx, ptr, length, type);
+
     /* Encode every element */
     for(size_t i = 0; i < length; ++i) {
         status ret = encodeWithExchangeBuffer(ctx, (const void*)ptr, type);
@@ -464,7 +756,7 @@ static status
 Array_encodeBinary(Ctx *ctx, const void *src, size_t length, const UA_DataType *type) {
     /* Check and convert the array length to int32 */
     i32 signed_length = -1;
-    if(length > UA_INT32_MAX)
+    if(UA_UNLIKELY(length > UA_INT32_MAX))
         return UA_STATUSCODE_BADINTERNALERROR;
     if(length > 0)
         signed_length = (i32)length;
@@ -476,6 +768,12 @@ Array_encodeBinary(Ctx *ctx, const void *src, size_t length, const UA_DataType *
     UA_assert(ret != UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED);
     UA_CHECK_STATUS(ret, return ret);
 
+    /* Only compute the size for types with a fixed binary size */
+    if(ctx->end == NULL && type->binarySize > 0) {
+        ctx->pos += length * type->binarySize;
+        return UA_STATUSCODE_GOOD;
+    }
+
     /* Encode the content */
     if(length > 0) {
         if(type->overlayable)
@@ -513,7 +811,7 @@ Array_decodeBinary(Ctx *ctx, void *UA_RESTRICT *UA_RESTRICT dst,
      * sizeof(UA_DataValue) == 80 and an empty DataValue is encoded with just
      * one byte. We use 128 as the smallest power of 2 larger than 80. */
     size_t length = (size_t)signed_length;
-    UA_CHECK(ctx->pos + ((type->memSize * length) / 128) <= ctx->end,
+    UA_CHECK((type->memSize * length) / 128 <= ctxRemaining(ctx),
              return UA_STATUSCODE_BADDECODINGERROR);
 
     /* Allocate memory */
@@ -522,19 +820,25 @@ Array_decodeBinary(Ctx *ctx, void *UA_RESTRICT *UA_RESTRICT dst,
 
     if(type->overlayable) {
         /* memcpy overlayable array */
-        if(ctx->pos + (type->memSize * length) > ctx->end){
+        if(UA_UNLIKELY(!ctxRead(ctx, *dst, type->memSize * length))) {
             ctxFree(ctx, *dst);
             *dst = NULL;
             return UA_STATUSCODE_BADDECODINGERROR;
         }
-        memcpy(*dst, ctx->pos, type->memSize * length);
-        ctx->pos += type->memSize * length;
+    } else if(fixedSizeNumeric(type)) {
+        /* Convert fixed-size numeric array members in one batch */
+        if(UA_UNLIKELY(type->memSize * length > ctxRemaining(ctx))) {
+            ctxFree(ctx, *dst);
+            *dst = NULL;
+            return UA_STATUSCODE_BADDECODINGERROR;
+        }
+        decodeFixedArray(ctx, *dst, length, type);
     } else {
         /* Decode array members */
         uintptr_t ptr = (uintptr_t)*dst;
         for(size_t i = 0; i < length; ++i) {
             ret = decodeBinaryJumpTable[type->typeKind](ctx, (void*)ptr, type);
-            if(ret != UA_STATUSCODE_GOOD) {
+            if(UA_UNLIKELY(ret != UA_STATUSCODE_GOOD)) {
                 if(!ctx->opts.calloc) {
                     /* +1 because last element is also already initialized */
                     UA_Array_delete(*dst, i + 1, type);
@@ -557,7 +861,41 @@ FUNC_ENCODE_BINARY(String) {
     return Array_encodeBinary(ctx, src->data, src->length, &UA_TYPES[UA_TYPES_BYTE]);
 }
 
+/* Point into the input buffer instead of allocating a copy */
+static status
+String_decodeBinaryBorrow(Ctx *ctx, UA_String *dst) {
+    i32 signed_length;
+    status ret = DECODE_DIRECT(&signed_length, UInt32); /* Int32 */
+    UA_CHECK_STATUS(ret, return ret);
+
+    /* Empty or null string */
+    if(signed_length <= 0) {
+        dst->length = 0;
+        dst->data = (signed_length < 0) ? NULL : (u8*)UA_EMPTY_ARRAY_SENTINEL;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    size_t length = (size_t)signed_length;
+    if(UA_LIKELY(length <= (size_t)(ctx->end - ctx->pos)) &&
+       !(ctx->segments && ctx->stitched)) {
+        dst->data = ctx->pos;
+        dst->length = length;
+        ctx->pos += length;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    /* The string crosses a segment boundary. Copy into the calloc memory. */
+    UA_CHECK(length <= ctxRemaining(ctx), return UA_STATUSCODE_BADDECODINGERROR);
+    dst->data = (u8*)ctxCalloc(ctx, length, 1);
+    UA_CHECK_MEM(dst->data, return UA_STATUSCODE_BADOUTOFMEMORY);
+    dst->length = length;
+    ctxRead(ctx, dst->data, length);
+    return UA_STATUSCODE_GOOD;
+}
+
 FUNC_DECODE_BINARY(String) {
+    if(ctx->opts.borrowStrings && ctx->opts.calloc)
+        return String_decodeBinaryBorrow(ctx, dst);
     return Array_decodeBinary(ctx, (void**)&dst->data, &dst->length, &UA_TYPES[UA_TYPES_BYTE]);
 }
 
@@ -579,10 +917,8 @@ FUNC_DECODE_BINARY(Guid) {
     ret |= DECODE_DIRECT(&dst->data1, UInt32);
     ret |= DECODE_DIRECT(&dst->data2, UInt16);
     ret |= DECODE_DIRECT(&dst->data3, UInt16);
-    UA_CHECK(ctx->pos + (8*sizeof(u8)) <= ctx->end,
+    UA_CHECK(ctxRead(ctx, dst->data4, 8*sizeof(u8)),
              return UA_STATUSCODE_BADDECODINGERROR);
-    memcpy(dst->data4, ctx->pos, 8*sizeof(u8));
-    ctx->pos += 8;
     return ret;
 }
 
@@ -738,7 +1074,7 @@ FUNC_ENCODE_BINARY(ExpandedNodeId) {
 
 FUNC_DECODE_BINARY(ExpandedNodeId) {
     /* Decode the encoding mask */
-    UA_CHECK(ctx->pos + 1 <= ctx->end, return UA_STATUSCODE_BADDECODINGERROR);
+    UA_CHECK(DECODE_AVAILABLE(1), return UA_STATUSCODE_BADDECODINGERROR);
     u8 encoding = *ctx->pos;
 
     /* Decode the NodeId */
@@ -814,10 +1150,17 @@ FUNC_DECODE_BINARY(LocalizedText) {
  * possible to reuse UA_findDataType */
 static const UA_DataType *
 UA_findDataTypeByBinaryInternal(Ctx *ctx, const UA_NodeId *typeId) {
-    /* Always look in the built-in types first. Assume that only numeric
-     * identifiers are used for the builtin types. (They may contain data types
-     * from all namespaces though.) */
-    if(typeId->identifierType == UA_NODEIDTYPE_NUMERIC) {
+    /* The registry contains the builtin types. Fall back to the customTypes
+     * that were not added to the registry. */
+    if(ctx->opts.typeRegistry) {
+        const UA_DataType *type =
+            UA_DataTypeRegistry_findByBinary(ctx->opts.typeRegistry, typeId);
+        if(type)
+            return type;
+    } else if(typeId->identifierType == UA_NODEIDTYPE_NUMERIC) {
+        /* Always look in the built-in types first. Assume that only numeric
+         * identifiers are used for the builtin types. (They may contain data
+         * types from all namespaces though.) */
         for(size_t i = 0; i < UA_TYPES_COUNT; ++i) {
             if(UA_TYPES[i].binaryEncodingId.identifier.numeric == typeId->identifier.numeric &&
                UA_TYPES[i].binaryEncodingId.namespaceIndex == typeId->namespaceIndex)
@@ -841,6 +1184,7 @@ const UA_DataType *
 UA_findDataTypeByBinary(const UA_NodeId *typeId) {
     Ctx ctx;
     ctx.opts.customTypes = NULL;
+    ctx.opts.typeRegistry = NULL;
     return UA_findDataTypeByBinaryInternal(&ctx, typeId);
 }
 
@@ -872,7 +1216,7 @@ FUNC_ENCODE_BINARY(ExtensionObject) {
     }
 
     /* Cannot encode with no data or no type description */
-    if(!src->content.decoded.type || !src->content.decoded.data)
+    if(UA_UNLIKELY(!src->content.decoded.type || !src->content.decoded.data))
         return UA_STATUSCODE_BADENCODINGERROR;
 
     /* Write the NodeId for the binary encoded type. This could perform a buffer
@@ -915,17 +1259,20 @@ ExtensionObject_decodeBinaryContent(Ctx *ctx, UA_ExtensionObject *dst,
     /* Unknown type, just take the binary content */
     if(!type) {
         dst->encoding = UA_EXTENSIONOBJECT_ENCODED_BYTESTRING;
-        UA_NodeId_copy(typeId, &dst->content.encoded.typeId);
+        if(ctx->opts.calloc)
+            dst->content.encoded.typeId = *typeId; /* Not freed with the calloc hook */
+        else
+            UA_NodeId_copy(typeId, &dst->content.encoded.typeId);
         return DECODE_DIRECT(&dst->content.encoded.body, String); /* ByteString */
     }
 
+    /* Jump over the length field (TODO: check if the decoded length matches) */
+    UA_CHECK(ctxSkip(ctx, 4), return UA_STATUSCODE_BADDECODINGERROR);
+
     /* Allocate memory */
     dst->content.decoded.data = ctxCalloc(ctx, 1, type->memSize);
     UA_CHECK_MEM(dst->content.decoded.data, return UA_STATUSCODE_BADOUTOFMEMORY);
 
-    /* Jump over the length field (TODO: check if the decoded length matches) */
-    ctx->pos += 4;
-
     /* Decode */
     dst->encoding = UA_EXTENSIONOBJECT_DECODED;
     dst->content.decoded.type = type;
@@ -1070,7 +1417,8 @@ static status
 Variant_decodeBinaryUnwrapExtensionObject(Ctx *ctx, UA_Variant *dst) {
     /* Save the position in the ByteString. If unwrapping is not possible, start
      * from here to decode a normal ExtensionObject. */
-    u8 *old_pos = ctx->pos;
+    CtxMark old_pos;
+    ctxMark(ctx, &old_pos);
 
     /* Decode the DataType */
     UA_NodeId typeId;
@@ -1087,11 +1435,12 @@ Variant_decodeBinaryUnwrapExtensionObject(Ctx *ctx, UA_Variant *dst) {
     if(encoding == UA_EXTENSIONOBJECT_ENCODED_BYTESTRING &&
        (dst->type = UA_findDataTypeByBinaryInternal(ctx, &typeId)) != NULL) {
         /* Jump over the length field (TODO: check if length matches) */
-        ctx->pos += 4;
+        UA_CHECK(ctxSkip(ctx, 4), ctxClearNodeId(ctx, &typeId);
+                 return UA_STATUSCODE_BADDECODINGERROR);
     } else {
         /* Reset and decode as ExtensionObject */
         dst->type = &UA_TYPES[UA_TYPES_EXTENSIONOBJECT];
-        ctx->pos = old_pos;
+        ctxReset(ctx, &old_pos);
     }
     ctxClearNodeId(ctx, &typeId);
 
@@ -1108,7 +1457,8 @@ Variant_decodeBinaryUnwrapExtensionObject(Ctx *ctx, UA_Variant *dst) {
 static status
 Variant_decodeBinaryUnwrapExtensionObjectArray(Ctx *ctx, void *UA_RESTRICT *UA_RESTRICT dst,
                                                size_t *out_length, const UA_DataType **type) {
-    u8 *orig_pos = ctx->pos;
+    CtxMark orig_pos;
+    ctxMark(ctx, &orig_pos);
 
     /* Decode the length */
     i32 signed_length;
@@ -1131,10 +1481,12 @@ Variant_decodeBinaryUnwrapExtensionObjectArray(Ctx *ctx, void *UA_RESTRICT *UA_R
      * ExtensionObject is at least 4 byte long (3 byte NodeId + 1 Byte encoding
      * field). */
     size_t length = (size_t)signed_length;
-    UA_CHECK(ctx->pos + ((4 * length) / 32) <= ctx->end,
+    UA_CHECK((4 * length) / 32 <= ctxRemaining(ctx),
              return UA_STATUSCODE_BADDECODINGERROR);
 
     /* Decode the type NodeId of the first member */
+    CtxMark members_pos;
+    ctxMark(ctx, &members_pos);
     UA_NodeId binTypeId;
     UA_NodeId_init(&binTypeId);
     ret |= DECODE_DIRECT(&binTypeId, NodeId);
@@ -1145,7 +1497,7 @@ Variant_decodeBinaryUnwrapExtensionObjectArray(Ctx *ctx, void *UA_RESTRICT *UA_R
     ctxClearNodeId(ctx, &binTypeId);
     if(!contentType) {
         /* DataType unknown, decode as ExtensionObject array */
-        ctx->pos = orig_pos;
+        ctxReset(ctx, &orig_pos);
         return Array_decodeBinary(ctx, dst, out_length, *type);
     }
 
@@ -1156,48 +1508,71 @@ Variant_decodeBinaryUnwrapExtensionObjectArray(Ctx *ctx, void *UA_RESTRICT *UA_R
     if(encoding != UA_EXTENSIONOBJECT_ENCODED_BYTESTRING) {
         /* Encoding format is not automatically decoded, decode as
          * ExtensionObject array */
-        ctx->pos = orig_pos;
+        ctxReset(ctx, &orig_pos);
         return Array_decodeBinary(ctx, dst, out_length, *type);
     }
 
-    /* Compare the header of all array members if the array can be unwrapped */
-    UA_ByteString header = {(uintptr_t)ctx->pos - (uintptr_t)orig_pos - 4, &orig_pos[4]};
-    UA_ByteString compare_header = header;
-    ctx->pos = &orig_pos[4];
+    /* The header of the first member. Copied if it crosses a segment
+     * boundary. */
+    UA_ByteString header = {ctxDistance(ctx, &members_pos), members_pos.pos};
+    u8 *header_copy = NULL;
+    if(header.length > (size_t)(members_pos.end - members_pos.pos)) {
+        header_copy = (u8*)UA_malloc(header.length);
+        UA_CHECK_MEM(header_copy, return UA_STATUSCODE_BADOUTOFMEMORY);
+        ctxReset(ctx, &members_pos);
+        ctxRead(ctx, header_copy, header.length);
+        header.data = header_copy;
+    }
 
+    /* Compare the header of all array members if the array can be unwrapped */
+    ctxReset(ctx, &members_pos);
     for(size_t i = 0; i < length; i++) {
-        compare_header.data = ctx->pos;
-        UA_CHECK(compare_header.data + compare_header.length <= ctx->end,
-                 return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED);
-        if(!UA_ByteString_equal(&header, &compare_header)) {
+        if(header.length > ctxRemaining(ctx)) {
+            ret = UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+            goto cleanup;
+        }
+        if(!ctxMatch(ctx, header.data, header.length)) {
             /* Different member types, decode as ExtensionObject array */
-            ctx->pos = orig_pos;
+            UA_free(header_copy);
+            ctxReset(ctx, &orig_pos);
             return Array_decodeBinary(ctx, dst, out_length, *type);
         }
 
         /* Decode the length field and jump to the next element */
-        ctx->pos += header.length;
         u32 member_length = 0;
         ret = DECODE_DIRECT(&member_length, UInt32);
-        UA_CHECK_STATUS(ret, return ret);
-        ctx->pos += member_length;
+        UA_CHECK_STATUS(ret, goto cleanup);
+        if(!ctxSkip(ctx, member_length)) {
+            ret = UA_STATUSCODE_BADDECODINGERROR;
+            goto cleanup;
+        }
     }
 
     /* Allocate memory for the unwrapped members */
     *dst = ctxCalloc(ctx, length, contentType->memSize);
-    UA_CHECK_MEM(*dst, return UA_STATUSCODE_BADOUTOFMEMORY);
+    if(!*dst) {
+        ret = UA_STATUSCODE_BADOUTOFMEMORY;
+        goto cleanup;
+    }
     *out_length = length;
     *type = contentType;
 
     /* Decode unwrapped members */
     uintptr_t array_pos = (uintptr_t)*dst;
-    ctx->pos = &orig_pos[4];
+    ctxReset(ctx, &members_pos);
     for(size_t i = 0; i < length && ret == UA_STATUSCODE_GOOD; i++) {
-        ctx->pos += header.length + 4; /* Jump over the header and length field */
+        /* Jump over the header and length field */
+        if(!ctxSkip(ctx, header.length + 4)) {
+            ret = UA_STATUSCODE_BADDECODINGERROR;
+            break;
+        }
         ret = decodeBinaryJumpTable[contentType->typeKind]
             (ctx, (void*)array_pos, contentType);
         array_pos += contentType->memSize;
     }
+
+ cleanup:
+    UA_free(header_copy);
     return ret;
 }
 
@@ -1278,7 +1653,7 @@ FUNC_ENCODE_BINARY(DataValue) {
     /* Encode the variant. */
     if(src->hasValue) {
         ret = ENCODE_DIRECT(&src->value, Variant);
-        if(ret != UA_STATUSCODE_GOOD)
+        if(UA_UNLIKELY(ret != UA_STATUSCODE_GOOD))
             return ret;
     }
 
@@ -1363,7 +1738,7 @@ FUNC_ENCODE_BINARY(DiagnosticInfo) {
         ret |= ENCODE_DIRECT(&src->locale, UInt32); /* Int32 */
     if(src->hasLocalizedText)
         ret |= ENCODE_DIRECT(&src->localizedText, UInt32); /* Int32 */
-    if(ret != UA_STATUSCODE_GOOD)
+    if(UA_UNLIKELY(ret != UA_STATUSCODE_GOOD))
         return ret;
 
     /* Encode the additional info. Can exchange the buffer. */
@@ -1445,6 +1820,12 @@ FUNC_DECODE_BINARY(DiagnosticInfo) {
 
 static status
 encodeBinaryStruct(Ctx *ctx, const void *src, const UA_DataType *type) {
+    /* Only compute the size for types with a fixed binary size */
+    if(ctx->end == NULL && type->binarySize > 0) {
+        ctx->pos += type->binarySize;
+        return UA_STATUSCODE_GOOD;
+    }
+
     /* Check the recursion limit */
     UA_CHECK(ctx->depth <= UA_ENCODING_MAX_RECURSION,
              return UA_STATUSCODE_BADENCODINGERROR);
@@ -1468,6 +1849,18 @@ encodeBinaryStruct(Ctx *ctx, const void *src, const UA_DataType *type) {
             continue;
         }
 
+        /* Scalar with a direct binary layout that fits into the buffer (or
+         * calcSize only). Otherwise use the generic encoding which exchanges
+         * the buffer if required. */
+        if(directMember(mt) &&
+           (ctx->end == NULL || ctx->pos + mt->memSize <= ctx->end)) {
+            if(ctx->end)
+                memcpy(ctx->pos, (const void*)ptr, mt->memSize);
+            ctx->pos += mt->memSize;
+            ptr += mt->memSize;
+            continue;
+        }
+
         /* Scalar */
         ret = encodeWithExchangeBuffer(ctx, (const void*)ptr, mt);
         UA_assert(ret != UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED);
@@ -1481,7 +1874,7 @@ encodeBinaryStruct(Ctx *ctx, const void *src, const UA_DataType *type) {
 static status
 encodeBinaryStructWithOptFields(Ctx *ctx, const void *src, const UA_DataType *type) {
     /* Check the recursion limit */
-    if(ctx->depth > UA_ENCODING_MAX_RECURSION)
+    if(UA_UNLIKELY(ctx->depth > UA_ENCODING_MAX_RECURSION))
         return UA_STATUSCODE_BADENCODINGERROR;
     ctx->depth++;
 
@@ -1636,7 +2029,7 @@ UA_encodeBinaryInternal(const void *src, const UA_DataType *type,
                         u8 **bufPos, const u8 **bufEnd,
                         UA_exchangeEncodeBuffer exchangeCallback,
                         void *exchangeHandle) {
-    if(!type || !src)
+    if(UA_UNLIKELY(!type || !src))
         return UA_STATUSCODE_BADENCODINGERROR;
 
     /* Set up the context */
@@ -1718,6 +2111,19 @@ decodeBinaryStructure(Ctx *ctx, void *dst, const UA_DataType *type) {
             continue;
         }
 
+        /* Scalar with a direct binary layout */
+        if(directMember(mt)) {
+            if(UA_LIKELY(ctx->pos + mt->memSize <= ctx->end)) {
+                memcpy((void*)ptr, ctx->pos, mt->memSize);
+                ctx->pos += mt->memSize;
+            } else if(!ctxRead(ctx, (void*)ptr, mt->memSize)) {
+                ret = UA_STATUSCODE_BADDECODINGERROR;
+                break;
+            }
+            ptr += mt->memSize;
+            continue;
+        }
+
         /* Scalar */
         ret = decodeBinaryJumpTable[mt->typeKind](ctx, (void *UA_RESTRICT)ptr, mt);
         ptr += mt->memSize;
@@ -1852,26 +2258,36 @@ const decodeBinarySignature decodeBinaryJumpTable[UA_DATATYPEKINDS] = {
 };
 
 status
-UA_decodeBinaryInternal(const UA_ByteString *src, size_t *offset,
-                        void *dst, const UA_DataType *type,
+UA_decodeBinarySegments(const UA_ByteString *segments, size_t segmentsSize,
+                        size_t *offset, void *dst, const UA_DataType *type,
                         const UA_DecodeBinaryOptions *options) {
+    UA_assert(segmentsSize > 0);
+
     /* Set up the context */
     Ctx ctx;
-    ctx.pos = &src->data[*offset];
-    ctx.end = &src->data[src->length];
     ctx.depth = 0;
     if(options)
         ctx.opts = *options;
     else
         memset(&ctx.opts, 0, sizeof(UA_DecodeBinaryOptions));
+    ctx.segments = segments;
+    ctx.segmentsSize = segmentsSize;
+    ctx.segment = 0;
+    ctx.segmentOffset = 0;
+    ctx.messageLength = 0;
+    for(size_t i = 0; i < segmentsSize; i++)
+        ctx.messageLength += segments[i].length;
+    memset(dst, 0, type->memSize); /* Initialize the value */
+    if(UA_UNLIKELY(*offset > ctx.messageLength))
+        return UA_STATUSCODE_BADDECODINGERROR;
+    ctxSeek(&ctx, *offset);
 
     /* Decode */
-    memset(dst, 0, type->memSize); /* Initialize the value */
     status ret = decodeBinaryJumpTable[type->typeKind](&ctx, dst, type);
 
     if(UA_LIKELY(ret == UA_STATUSCODE_GOOD)) {
         /* Set the new offset */
-        *offset = (size_t)(ctx.pos - src->data) / sizeof(u8);
+        *offset = ctxOffset(&ctx);
     } else {
         /* Clean up */
         ctxClear(&ctx, dst, type);
@@ -1879,6 +2295,13 @@ UA_decodeBinaryInternal(const UA_ByteString *src, size_t *offset,
     return ret;
 }
 
+status
+UA_decodeBinaryInternal(const UA_ByteString *src, size_t *offset,
+                        void *dst, const UA_DataType *type,
+                        const UA_DecodeBinaryOptions *options) {
+    return UA_decodeBinarySegments(src, 1, offset, dst, type, options);
+}
+
 UA_StatusCode
 UA_decodeBinary(const UA_ByteString *inBuf,
                 void *p, const UA_DataType *type,
@@ -1896,6 +2319,8 @@ UA_decodeBinary(const UA_ByteString *inBuf,
 
 size_t
 UA_calcSizeBinary(const void *p, const UA_DataType *type) {
+    if(type->binarySize > 0)
+        return type->binarySize;
     u8 *pos = NULL;
     const u8 *posEnd = NULL;
     UA_StatusCode res = UA_encodeBinaryInternal(p, type, &pos, &posEnd, NULL, NULL);
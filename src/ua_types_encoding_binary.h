@@ -31,6 +31,20 @@ typedef struct {
 
     UA_exchangeEncodeBuffer exchangeBufferCallback;
     void *exchangeBufferCallbackHandle;
+
+    /* Decoding can continue across a list of segments (e.g. the chunks of a
+     * message) without assembling them first. Then pos/end point into the
+     * current segment. Values that straddle the boundary to the next segment
+     * are copied into the stitch buffer. Set segments to NULL when pos/end are
+     * set up manually. */
+    const UA_ByteString *segments;
+    size_t segmentsSize;
+    size_t segment;       /* Index of the current segment */
+    size_t segmentOffset; /* Offset of the current segment in the message */
+    size_t messageLength; /* Sum of the segment lengths */
+    size_t stitchOffset;  /* Offset of the stitch buffer in the message */
+    UA_Boolean stitched;  /* pos/end point into the stitch buffer */
+    UA_Byte stitch[16];
 } Ctx;
 
 void * ctxCalloc(Ctx *ctx, size_t nelem, size_t elsize);
@@ -103,6 +117,17 @@ UA_decodeBinaryInternal(const UA_ByteString *src, size_t *offset,
                         const UA_DecodeBinaryOptions *options)
     UA_FUNC_ATTR_WARN_UNUSED_RESULT;
 
+/* Decodes a scalar value from a message that is split into several segments.
+ * The segments are read in order as if they were one contiguous buffer. The
+ * offset counts from the beginning of the first segment. Strings are only
+ * borrowed (see UA_DecodeBinaryOptions) if they do not cross a segment
+ * boundary. */
+UA_StatusCode
+UA_decodeBinarySegments(const UA_ByteString *segments, size_t segmentsSize,
+                        size_t *offset, void *dst, const UA_DataType *type,
+                        const UA_DecodeBinaryOptions *options)
+    UA_FUNC_ATTR_WARN_UNUSED_RESULT;
+
 const UA_DataType *
 UA_findDataTypeByBinary(const UA_NodeId *typeId);
 
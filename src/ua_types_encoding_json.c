@@ -16,6 +16,12 @@
 #include <float.h>
 #include <math.h>
 
+#if defined(__SSE2__)
+# include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+# include <arm_neon.h>
+#endif
+
 #include "../deps/itoa.h"
 #include "../deps/dtoa.h"
 #include "../deps/parse_num.h"
@@ -56,20 +62,65 @@
 #define ENCODE_DIRECT_JSON(SRC, TYPE) \
     TYPE##_encodeJson(ctx, (const UA_##TYPE*)SRC, NULL)
 
+/* Reallocate the growable output buffer with (at least) double the size. So
+ * the total copying overhead is linear in the length of the result. */
 static status UA_FUNC_ATTR_WARN_UNUSED_RESULT
-writeChar(CtxJson *ctx, char c) {
-    if(ctx->pos >= ctx->end)
+growJsonBuffer(CtxJson *ctx, size_t len) {
+    if(!ctx->growBuf)
         return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+    size_t used = (size_t)(ctx->pos - ctx->growBuf->data);
+    size_t size = ctx->growBuf->length;
+    while(size - used < len) {
+        if(size > SIZE_MAX / 2)
+            return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+        size *= 2;
+    }
+    UA_Byte *data = (UA_Byte*)UA_realloc(ctx->growBuf->data, size);
+    if(!data)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    ctx->growBuf->data = data;
+    ctx->growBuf->length = size;
+    ctx->pos = &data[used];
+    ctx->end = &data[size];
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Release the unused memory at the end of the grown buffer */
+void
+shrinkJsonBuffer(UA_ByteString *buf) {
+    if(buf->length == 0)
+        return;
+    UA_Byte *data = (UA_Byte*)UA_realloc(buf->data, buf->length);
+    if(data)
+        buf->data = data;
+}
+
+/* Ensure that len bytes can be written at the current position */
+static UA_INLINE status UA_FUNC_ATTR_WARN_UNUSED_RESULT
+reserveJson(CtxJson *ctx, size_t len) {
+    if(UA_LIKELY(ctx->pos + len <= ctx->end))
+        return UA_STATUSCODE_GOOD;
+    return growJsonBuffer(ctx, len);
+}
+
+#define RESERVE_JSON(len) do {                      \
+        status reserveRes = reserveJson(ctx, len);  \
+        if(reserveRes != UA_STATUSCODE_GOOD)        \
+            return reserveRes;                      \
+    } while(0)
+
+static status UA_FUNC_ATTR_WARN_UNUSED_RESULT
+writeChar(CtxJson *ctx, char c) {
+    RESERVE_JSON(1);
     if(!ctx->calcOnly)
         *ctx->pos = (UA_Byte)c;
     ctx->pos++;
     return UA_STATUSCODE_GOOD;
 }
 
-static status UA_FUNC_ATTR_WARN_UNUSED_RESULT
+status
 writeChars(CtxJson *ctx, const char *c, size_t len) {
-    if(ctx->pos + len > ctx->end)
-        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+    RESERVE_JSON(len);
     if(!ctx->calcOnly)
         memcpy(ctx->pos, c, len);
     ctx->pos += len;
@@ -255,8 +306,7 @@ ENCODE_JSON(Byte) {
     UA_UInt16 digits = itoaUnsigned(*src, buf, 10);
 
     /* Ensure destination can hold the data- */
-    if(ctx->pos + digits > ctx->end)
-        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+    RESERVE_JSON(digits);
 
     /* Copy digits to the output string/buffer. */
     if(!ctx->calcOnly)
@@ -269,8 +319,7 @@ ENCODE_JSON(Byte) {
 ENCODE_JSON(SByte) {
     char buf[5];
     UA_UInt16 digits = itoaSigned(*src, buf);
-    if(ctx->pos + digits > ctx->end)
-        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+    RESERVE_JSON(digits);
     if(!ctx->calcOnly)
         memcpy(ctx->pos, buf, digits);
     ctx->pos += digits;
@@ -282,8 +331,7 @@ ENCODE_JSON(UInt16) {
     char buf[6];
     UA_UInt16 digits = itoaUnsigned(*src, buf, 10);
 
-    if(ctx->pos + digits > ctx->end)
-        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+    RESERVE_JSON(digits);
 
     if(!ctx->calcOnly)
         memcpy(ctx->pos, buf, digits);
@@ -296,8 +344,7 @@ ENCODE_JSON(Int16) {
     char buf[7];
     UA_UInt16 digits = itoaSigned(*src, buf);
 
-    if(ctx->pos + digits > ctx->end)
-        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+    RESERVE_JSON(digits);
 
     if(!ctx->calcOnly)
         memcpy(ctx->pos, buf, digits);
@@ -310,8 +357,7 @@ ENCODE_JSON(UInt32) {
     char buf[11];
     UA_UInt16 digits = itoaUnsigned(*src, buf, 10);
 
-    if(ctx->pos + digits > ctx->end)
-        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+    RESERVE_JSON(digits);
 
     if(!ctx->calcOnly)
         memcpy(ctx->pos, buf, digits);
@@ -324,8 +370,7 @@ ENCODE_JSON(Int32) {
     char buf[12];
     UA_UInt16 digits = itoaSigned(*src, buf);
 
-    if(ctx->pos + digits > ctx->end)
-        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+    RESERVE_JSON(digits);
 
     if(!ctx->calcOnly)
         memcpy(ctx->pos, buf, digits);
@@ -341,8 +386,7 @@ ENCODE_JSON(UInt64) {
     buf[digits + 1] = '\"';
     UA_UInt16 length = (UA_UInt16)(digits + 2);
 
-    if(ctx->pos + length > ctx->end)
-        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+    RESERVE_JSON(length);
 
     if(!ctx->calcOnly)
         memcpy(ctx->pos, buf, length);
@@ -358,8 +402,7 @@ ENCODE_JSON(Int64) {
     buf[digits + 1] = '\"';
     UA_UInt16 length = (UA_UInt16)(digits + 2);
 
-    if(ctx->pos + length > ctx->end)
-        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+    RESERVE_JSON(length);
 
     if(!ctx->calcOnly)
         memcpy(ctx->pos, buf, length);
@@ -383,8 +426,7 @@ ENCODE_JSON(Float) {
         len = dtoa((UA_Double)*src, buffer);
     }
 
-    if(ctx->pos + len > ctx->end)
-        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+    RESERVE_JSON(len);
 
     if(!ctx->calcOnly)
         memcpy(ctx->pos, buffer, len);
@@ -408,8 +450,7 @@ ENCODE_JSON(Double) {
         len = dtoa(*src, buffer);
     }
 
-    if(ctx->pos + len > ctx->end)
-        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+    RESERVE_JSON(len);
 
     if(!ctx->calcOnly)
         memcpy(ctx->pos, buffer, len);
@@ -441,52 +482,71 @@ encodeJsonArray(CtxJson *ctx, const void *ptr, size_t length,
     return ret | writeJsonArrEnd(ctx);
 }
 
-static const uint32_t min_codepoints[5] = {0x00, 0x00, 0x80, 0x800, 0x10000};
 static const u8 hexmap[16] =
     {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'};
 
-/* Extract the next utf8 codepoint from the buffer. Return the next position in
- * the buffer or NULL upon an error. */
-static const unsigned char *
-extract_codepoint(const unsigned char *pos, size_t len, uint32_t *codepoint) {
-    UA_assert(len > 0);
-
-    *codepoint = pos[0];
-    if(UA_LIKELY(*codepoint < 0x80))
-        return pos + 1; /* Normal ASCII */
-
-    if(UA_UNLIKELY(*codepoint <= 0xC1))
-        return NULL; /* Continuation byte not allowed here */
-
-    unsigned char count;
-    if(*codepoint <= 0xDF) {
-        count = 2; /* 2-byte sequence */
-        *codepoint &= 0x1F;
-    } else if(*codepoint <= 0xEF) {
-        count = 3; /* 3-byte sequence */
-        *codepoint &= 0xF;
-    } else if(*codepoint <= 0xF4) {
-        count = 4; /* 4-byte sequence */
-        *codepoint &= 0x7;
-    } else {
-        return NULL; /* invalid utf8 */
-    }
-
-    if(UA_UNLIKELY(count > len))
-        return NULL; /* Not enough bytes left */
+/* Unprintable ASCII and the escape characters. All of them are single bytes
+ * below 0x80. The bytes of a multi-byte utf8 sequence are >= 0x80 and never
+ * need escaping. So the string can be scanned bytewise without decoding the
+ * codepoints. Malformed utf8 is printed anyway and the receiving side chooses
+ * how to handle it. */
+#define JSON_NEEDS_ESCAPE(c) \
+    ((c) < ' ' || (c) == 127 || (c) == '\\' || (c) == '\"')
 
-    for(unsigned char i = 1; i < count; i++) {
-        unsigned char byte = pos[i];
-        if(UA_UNLIKELY(byte < 0x80 || byte > 0xBF))
-            return NULL; /* Not a continuation byte */
-        *codepoint = (*codepoint << 6) + (byte & 0x3F);
+/* Return the position of the first byte that needs escaping (or the end).
+ * Tests 16 bytes at a time with SSE2/NEON and 8 bytes at a time otherwise. */
+static const unsigned char *
+findJsonEscape(const unsigned char *pos, const unsigned char *end) {
+#if defined(__SSE2__)
+    const __m128i ctrl = _mm_set1_epi8(' ' - 1);
+    const __m128i del = _mm_set1_epi8(127);
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i quote = _mm_set1_epi8('\"');
+    for(; end - pos >= 16; pos += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(const void*)pos);
+        /* Unsigned v <= 0x1F if max(v, 0x1F) == 0x1F */
+        __m128i m = _mm_cmpeq_epi8(_mm_max_epu8(v, ctrl), ctrl);
+        m = _mm_or_si128(m, _mm_cmpeq_epi8(v, del));
+        m = _mm_or_si128(m, _mm_cmpeq_epi8(v, backslash));
+        m = _mm_or_si128(m, _mm_cmpeq_epi8(v, quote));
+        unsigned mask = (unsigned)_mm_movemask_epi8(m);
+        if(mask != 0)
+            return pos + __builtin_ctz(mask);
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint8x16_t ctrl = vdupq_n_u8(' ');
+    const uint8x16_t del = vdupq_n_u8(127);
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    const uint8x16_t quote = vdupq_n_u8('\"');
+    for(; end - pos >= 16; pos += 16) {
+        uint8x16_t v = vld1q_u8(pos);
+        uint8x16_t m = vcltq_u8(v, ctrl);
+        m = vorrq_u8(m, vceqq_u8(v, del));
+        m = vorrq_u8(m, vceqq_u8(v, backslash));
+        m = vorrq_u8(m, vceqq_u8(v, quote));
+        if(vmaxvq_u8(m) != 0)
+            break; /* Find the exact position below */
+    }
+#else
+    /* SWAR: Test eight bytes in a 64bit word. The expressions are exact for
+     * whether any byte matches (not for which one). */
+    const uint64_t ones = 0x0101010101010101ull;
+    const uint64_t highs = 0x8080808080808080ull;
+    for(; end - pos >= 8; pos += 8) {
+        uint64_t x;
+        memcpy(&x, pos, 8);
+        uint64_t d = x ^ (ones * 127);
+        uint64_t b = x ^ (ones * '\\');
+        uint64_t q = x ^ (ones * '\"');
+        uint64_t hit = ((x - ones * ' ') & ~x) |
+            ((d - ones) & ~d) | ((b - ones) & ~b) | ((q - ones) & ~q);
+        if(hit & highs)
+            break; /* Find the exact position below */
     }
-
-    /* Not in Unicode range or too small for the encoding length */
-    if(UA_UNLIKELY(*codepoint > 0x10FFFF || *codepoint < min_codepoints[count]))
-        return NULL;
-
-    return pos + count; /* Return the new position in the pos */
+#endif
+    while(pos < end && !JSON_NEEDS_ESCAPE(*pos))
+        pos++;
+    return pos;
 }
 
 ENCODE_JSON(String) {
@@ -499,50 +559,27 @@ ENCODE_JSON(String) {
     UA_StatusCode ret = writeJsonQuote(ctx);
 
     const unsigned char *str = src->data;
-    const unsigned char *pos = str;
-    const unsigned char *end = str;
     const unsigned char *lim = str + src->length;
-    uint32_t codepoint = 0;
     while(1) {
-        /* Iterate over codepoints in the utf8 encoding. Until the first
-         * character that needs to be escaped. */
-        while(end < lim) {
-            end = extract_codepoint(pos, (size_t)(lim - pos), &codepoint);
-            if(!end)  {
-                /* A malformed utf8 character. Print anyway and let the
-                 * receiving side choose how to handle it. */
-                pos++;
-                end = pos;
-                continue;
-            }
-
-            /* Escape unprintable ASCII and escape characters */
-            if(codepoint < ' '   || codepoint == 127  ||
-               codepoint == '\\' || codepoint == '\"')
-                break;
-
-            pos = end;
-        }
-
-        /* Write out the characters that don't need escaping */
+        /* Write out the characters that don't need escaping in bulk */
+        const unsigned char *pos = findJsonEscape(str, lim);
         if(pos != str) {
-            if(ctx->pos + (pos - str) > ctx->end)
-                return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+            RESERVE_JSON((size_t)(pos - str));
             if(!ctx->calcOnly)
                 memcpy(ctx->pos, str, (size_t)(pos - str));
             ctx->pos += pos - str;
         }
 
         /* Reached the end of the utf8 encoding */
-        if(end == pos)
+        if(pos == lim)
             break;
 
         /* Handle an escaped character */
         size_t length = 2;
-        u8 seq[13];
+        u8 seq[6];
         const char *text;
 
-        switch(codepoint) {
+        switch(*pos) {
         case '\\': text = "\\\\"; break;
         case '\"': text = "\\\""; break;
         case '\b': text = "\\b"; break;
@@ -552,48 +589,20 @@ ENCODE_JSON(String) {
         case '\t': text = "\\t"; break;
         default:
             text = (char*)seq;
-            if(codepoint < 0x10000) {
-                /* codepoint is in BMP */
-                seq[0] = '\\';
-                seq[1] = 'u';
-                UA_Byte b1 = (UA_Byte)(codepoint >> 8u);
-                UA_Byte b2 = (UA_Byte)(codepoint >> 0u);
-                seq[2] = hexmap[(b1 & 0xF0u) >> 4u];
-                seq[3] = hexmap[b1 & 0x0Fu];
-                seq[4] = hexmap[(b2 & 0xF0u) >> 4u];
-                seq[5] = hexmap[b2 & 0x0Fu];
-                length = 6;
-            } else {
-                /* not in BMP -> construct a UTF-16 surrogate pair */
-                codepoint -= 0x10000;
-                UA_UInt32 first = 0xD800u | ((codepoint & 0xffc00u) >> 10u);
-                UA_UInt32 last = 0xDC00u | (codepoint & 0x003ffu);
-                UA_Byte fb1 = (UA_Byte)(first >> 8u);
-                UA_Byte fb2 = (UA_Byte)(first >> 0u);
-                UA_Byte lb1 = (UA_Byte)(last >> 8u);
-                UA_Byte lb2 = (UA_Byte)(last >> 0u);
-                seq[0] = '\\';
-                seq[1] = 'u';
-                seq[2] = hexmap[(fb1 & 0xF0u) >> 4u];
-                seq[3] = hexmap[fb1 & 0x0Fu];
-                seq[4] = hexmap[(fb2 & 0xF0u) >> 4u];
-                seq[5] = hexmap[fb2 & 0x0Fu];
-                seq[6] = '\\';
-                seq[7] = 'u';
-                seq[8] = hexmap[(lb1 & 0xF0u) >> 4u];
-                seq[9] = hexmap[lb1 & 0x0Fu];
-                seq[10] = hexmap[(lb2 & 0xF0u) >> 4u];
-                seq[11] = hexmap[lb2 & 0x0Fu];
-                length = 12;
-            }
+            seq[0] = '\\';
+            seq[1] = 'u';
+            seq[2] = '0';
+            seq[3] = '0';
+            seq[4] = hexmap[(*pos & 0xF0u) >> 4u];
+            seq[5] = hexmap[*pos & 0x0Fu];
+            length = 6;
             break;
         }
-        if(ctx->pos + length > ctx->end)
-            return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+        RESERVE_JSON(length);
         if(!ctx->calcOnly)
             memcpy(ctx->pos, text, length);
         ctx->pos += length;
-        str = pos = end;
+        str = pos + 1;
     }
 
     return ret | writeJsonQuote(ctx);
@@ -609,34 +618,21 @@ ENCODE_JSON(ByteString) {
         return retval;
     }
 
+    /* Encode directly into the output buffer */
+    size_t flen = 4 * ((src->length + 2) / 3);
+    if(flen < src->length)
+        return UA_STATUSCODE_BADENCODINGERROR; /* integer overflow */
+    RESERVE_JSON(flen + 2);
     status ret = writeJsonQuote(ctx);
-    size_t flen = 0;
-    unsigned char *ba64 = UA_base64(src->data, src->length, &flen);
-
-    /* Not converted, no mem */
-    if(!ba64)
-        return UA_STATUSCODE_BADENCODINGERROR;
-
-    if(ctx->pos + flen > ctx->end) {
-        UA_free(ba64);
-        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
-    }
-
-    /* Copy flen bytes to output stream. */
     if(!ctx->calcOnly)
-        memcpy(ctx->pos, ba64, flen);
+        UA_base64_buf(src->data, src->length, ctx->pos);
     ctx->pos += flen;
-
-    /* Base64 result no longer needed */
-    UA_free(ba64);
-
     return ret | writeJsonQuote(ctx);
 }
 
 /* Guid */
 ENCODE_JSON(Guid) {
-    if(ctx->pos + 38 > ctx->end) /* 36 + 2 (") */
-        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+    RESERVE_JSON(38); /* 36 + 2 (") */
     status ret = writeJsonQuote(ctx);
     if(!ctx->calcOnly)
         UA_Guid_to_hex(src, ctx->pos, false);
@@ -668,40 +664,56 @@ printNumber(i32 n, char *pos, u8 min_digits) {
 }
 
 ENCODE_JSON(DateTime) {
-    UA_DateTimeStruct tSt = UA_DateTime_toStruct(*src);
-
-    /* Format: -yyyy-MM-dd'T'HH:mm:ss.SSSSSSSSS'Z' is used. max 31 bytes.
-     * Note the optional minus for negative years. */
+    /* Split into seconds and a positive fraction of a second */
+    UA_DateTime sec = *src / UA_DATETIME_SEC;
+    UA_DateTime frac = *src % UA_DATETIME_SEC;
+    if(frac < 0) {
+        sec--;
+        frac += UA_DATETIME_SEC;
+    }
+
+    /* Print the prefix only if the second differs from the last DateTime.
+     * Format: -yyyy-MM-dd'T'HH:mm:ss. Note the optional minus for negative
+     * years. */
+    if(!ctx->dateTimeCached || ctx->dateTimeSec != sec) {
+        UA_DateTimeStruct tSt = UA_DateTime_toStruct(*src);
+        char *pos = ctx->dateTimePrefix;
+        pos += printNumber(tSt.year, pos, 4);
+        *(pos++) = '-';
+        pos += printNumber(tSt.month, pos, 2);
+        *(pos++) = '-';
+        pos += printNumber(tSt.day, pos, 2);
+        *(pos++) = 'T';
+        pos += printNumber(tSt.hour, pos, 2);
+        *(pos++) = ':';
+        pos += printNumber(tSt.min, pos, 2);
+        *(pos++) = ':';
+        pos += printNumber(tSt.sec, pos, 2);
+        UA_assert(pos <= &ctx->dateTimePrefix[sizeof(ctx->dateTimePrefix)]);
+        ctx->dateTimePrefixLen = (uint8_t)(pos - ctx->dateTimePrefix);
+        ctx->dateTimeSec = sec;
+        ctx->dateTimeCached = true;
+    }
+
+    /* Fraction of the second in 100ns steps without the trailing zeros */
     char buffer[UA_JSON_DATETIME_LENGTH];
-    char *pos = buffer;
-    pos += printNumber(tSt.year, pos, 4);
-    *(pos++) = '-';
-    pos += printNumber(tSt.month, pos, 2);
-    *(pos++) = '-';
-    pos += printNumber(tSt.day, pos, 2);
-    *(pos++) = 'T';
-    pos += printNumber(tSt.hour, pos, 2);
-    *(pos++) = ':';
-    pos += printNumber(tSt.min, pos, 2);
-    *(pos++) = ':';
-    pos += printNumber(tSt.sec, pos, 2);
-    *(pos++) = '.';
-    pos += printNumber(tSt.milliSec, pos, 3);
-    pos += printNumber(tSt.microSec, pos, 3);
-    pos += printNumber(tSt.nanoSec, pos, 3);
-
-    UA_assert(pos <= &buffer[UA_JSON_DATETIME_LENGTH]);
-
-    /* Remove trailing zeros */
-    pos--;
-    while(*pos == '0')
-        pos--;
-    if(*pos == '.')
-        pos--;
-
-    *(++pos) = 'Z';
-    UA_String str = {((uintptr_t)pos - (uintptr_t)buffer)+1, (UA_Byte*)buffer};
-    return ENCODE_DIRECT_JSON(&str, String);
+    size_t len = ctx->dateTimePrefixLen;
+    buffer[0] = '\"';
+    memcpy(&buffer[1], ctx->dateTimePrefix, len);
+    len++;
+    if(frac > 0) {
+        u8 digits = 7;
+        while(frac % 10 == 0) {
+            frac /= 10;
+            digits--;
+        }
+        buffer[len++] = '.';
+        len += printNumber((i32)frac, &buffer[len], digits);
+    }
+    buffer[len++] = 'Z';
+    buffer[len++] = '\"';
+    UA_assert(len <= UA_JSON_DATETIME_LENGTH);
+    return writeChars(ctx, buffer, len);
 }
 
 /* NodeId */
@@ -1285,12 +1297,12 @@ UA_encodeJson(const void *src, const UA_DataType *type, UA_ByteString *outBuf,
     if(!src || !type)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    /* Allocate buffer */
+    /* Allocate the buffer. It grows during the encoding. So the value is
+     * encoded in a single pass without computing the length first. */
     UA_Boolean allocated = false;
     status res = UA_STATUSCODE_GOOD;
     if(outBuf->length == 0) {
-        size_t len = UA_calcSizeJson(src, type, options);
-        res = UA_ByteString_allocBuffer(outBuf, len);
+        res = UA_ByteString_allocBuffer(outBuf, UA_JSON_ENCODING_INITIALSIZE);
         if(res != UA_STATUSCODE_GOOD)
             return res;
         allocated = true;
@@ -1301,6 +1313,8 @@ UA_encodeJson(const void *src, const UA_DataType *type, UA_ByteString *outBuf,
     memset(&ctx, 0, sizeof(ctx));
     ctx.pos = outBuf->data;
     ctx.end = &outBuf->data[outBuf->length];
+    if(allocated)
+        ctx.growBuf = outBuf;
     ctx.depth = 0;
     ctx.calcOnly = false;
     ctx.useReversible = true; /* default */
@@ -1319,11 +1333,15 @@ UA_encodeJson(const void *src, const UA_DataType *type, UA_ByteString *outBuf,
     res = encodeJsonJumpTable[type->typeKind](&ctx, src, type);
 
     /* Clean up */
-    if(res == UA_STATUSCODE_GOOD)
-        outBuf->length = (size_t)((uintptr_t)ctx.pos - (uintptr_t)outBuf->data);
-    else if(allocated)
-        UA_ByteString_clear(outBuf);
-    return res;
+    if(res != UA_STATUSCODE_GOOD) {
+        if(allocated)
+            UA_ByteString_clear(outBuf);
+        return res;
+    }
+    outBuf->length = (size_t)((uintptr_t)ctx.pos - (uintptr_t)outBuf->data);
+    if(allocated)
+        shrinkJsonBuffer(outBuf);
+    return UA_STATUSCODE_GOOD;
 }
 
 UA_StatusCode
@@ -2822,24 +2840,81 @@ const decodeJsonSignature decodeJsonJumpTable[UA_DATATYPEKINDS] = {
     (decodeJsonSignature)decodeJsonNotImplemented /* BitfieldCluster */
 };
 
+void
+UA_JsonTokenBuffer_clear(UA_JsonTokenBuffer *tb) {
+    UA_free(tb->tokens);
+    tb->tokens = NULL;
+    tb->tokensSize = 0;
+}
+
+void
+ParseCtx_init(ParseCtx *ctx, const UA_DecodeJsonOptions *options,
+              cj5_token *stackTokens, size_t stackTokensSize) {
+    memset(ctx, 0, sizeof(ParseCtx));
+    ctx->stackTokens = stackTokens;
+    ctx->tokens = stackTokens;
+    ctx->tokensCapacity = stackTokensSize;
+    if(!options)
+        return;
+
+    ctx->namespaces = options->namespaces;
+    ctx->namespacesSize = options->namespacesSize;
+    ctx->serverUris = options->serverUris;
+    ctx->serverUrisSize = options->serverUrisSize;
+    ctx->customTypes = options->customTypes;
+    ctx->maxTokens = options->maxTokens;
+    ctx->tokenBuffer = options->tokenBuffer;
+    if(ctx->tokenBuffer && ctx->tokenBuffer->tokensSize > stackTokensSize) {
+        ctx->tokens = (cj5_token*)ctx->tokenBuffer->tokens;
+        ctx->tokensCapacity = ctx->tokenBuffer->tokensSize;
+    }
+}
+
+void
+ParseCtx_clearTokens(ParseCtx *ctx) {
+    if(ctx->tokens != ctx->stackTokens &&
+       (!ctx->tokenBuffer || (void*)ctx->tokens != ctx->tokenBuffer->tokens))
+        UA_free((void*)(uintptr_t)ctx->tokens);
+    ctx->tokens = ctx->stackTokens;
+}
+
 status
-tokenize(ParseCtx *ctx, const UA_ByteString *src, size_t tokensSize,
-         size_t *decodedLength) {
+tokenize(ParseCtx *ctx, const UA_ByteString *src, size_t *decodedLength) {
     /* Tokenize */
     cj5_options options;
     options.stop_early = (decodedLength != NULL);
     cj5_result r = cj5_parse((char*)src->data, (unsigned int)src->length,
-                             ctx->tokens, (unsigned int)tokensSize, &options);
+                             ctx->tokens, (unsigned int)ctx->tokensCapacity,
+                             &options);
+
+    /* The parser continues counting the tokens after an overflow */
+    if(ctx->maxTokens > 0 && r.num_tokens > ctx->maxTokens)
+        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
 
     /* Handle overflow error by allocating the number of tokens the parser would
-     * have needed */
+     * have needed. Grow the token buffer if one is used, so that it can be
+     * reused for the next decoding. */
     if(r.error == CJ5_ERROR_OVERFLOW &&
-       tokensSize != r.num_tokens) {
-        ctx->tokens = (cj5_token*)
-            UA_malloc(sizeof(cj5_token) * r.num_tokens);
-        if(!ctx->tokens)
-            return UA_STATUSCODE_BADOUTOFMEMORY;
-        return tokenize(ctx, src, r.num_tokens, decodedLength);
+       ctx->tokensCapacity != r.num_tokens) {
+        if(ctx->tokenBuffer) {
+            void *tokens = UA_realloc(ctx->tokenBuffer->tokens,
+                                      sizeof(cj5_token) * r.num_tokens);
+            if(!tokens)
+                return UA_STATUSCODE_BADOUTOFMEMORY;
+            ctx->tokenBuffer->tokens = tokens;
+            ctx->tokenBuffer->tokensSize = r.num_tokens;
+            ctx->tokens = (cj5_token*)tokens;
+        } else {
+            ParseCtx_clearTokens(ctx);
+            ctx->tokens = (cj5_token*)
+                UA_malloc(sizeof(cj5_token) * r.num_tokens);
+            if(!ctx->tokens) {
+                ctx->tokens = ctx->stackTokens;
+                return UA_STATUSCODE_BADOUTOFMEMORY;
+            }
+        }
+        ctx->tokensCapacity = r.num_tokens;
+        return tokenize(ctx, src, decodedLength);
     }
 
     /* Cannot recover from other errors */
@@ -2866,24 +2941,14 @@ UA_decodeJson(const UA_ByteString *src, void *dst, const UA_DataType *type,
     /* Set up the context */
     cj5_token tokens[UA_JSON_MAXTOKENCOUNT];
     ParseCtx ctx;
-    memset(&ctx, 0, sizeof(ParseCtx));
-    ctx.tokens = tokens;
-
-    if(options) {
-        ctx.namespaces = options->namespaces;
-        ctx.namespacesSize = options->namespacesSize;
-        ctx.serverUris = options->serverUris;
-        ctx.serverUrisSize = options->serverUrisSize;
-        ctx.customTypes = options->customTypes;
-    }
+    ParseCtx_init(&ctx, options, tokens, UA_JSON_MAXTOKENCOUNT);
 
     /* Decode */
-    status ret = tokenize(&ctx, src, UA_JSON_MAXTOKENCOUNT,
-                          options ? options->decodedLength : NULL);
+    memset(dst, 0, type->memSize); /* Initialize the value */
+    status ret = tokenize(&ctx, src, options ? options->decodedLength : NULL);
     if(ret != UA_STATUSCODE_GOOD)
         goto cleanup;
 
-    memset(dst, 0, type->memSize); /* Initialize the value */
     ret = decodeJsonJumpTable[type->typeKind](&ctx, dst, type);
 
     /* Sanity check if all tokens were processed */
@@ -2892,11 +2957,7 @@ UA_decodeJson(const UA_ByteString *src, void *dst, const UA_DataType *type,
         ret = UA_STATUSCODE_BADDECODINGERROR;
 
  cleanup:
-
-    /* Free token array on the heap */
-    if(ctx.tokens != tokens)
-        UA_free((void*)(uintptr_t)ctx.tokens);
-
+    ParseCtx_clearTokens(&ctx);
     if(ret != UA_STATUSCODE_GOOD)
         UA_clear(dst, type);
     return ret;
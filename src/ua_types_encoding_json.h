@@ -20,10 +20,17 @@ _UA_BEGIN_DECLS
 #define UA_JSON_MAXTOKENCOUNT 256
 #define UA_JSON_ENCODING_MAX_RECURSION 100
 
+/* Initial size of the output buffer if the encoder allocates it */
+#define UA_JSON_ENCODING_INITIALSIZE 256
+
 typedef struct {
     uint8_t *pos;
     const uint8_t *end;
 
+    /* If set, the output buffer is owned by the encoder. It is reallocated
+     * when the end is reached. The length is the allocated size. */
+    UA_ByteString *growBuf;
+
     uint16_t depth; /* How often did we en-/decoding recurse? */
     UA_Boolean commaNeeded[UA_JSON_ENCODING_MAX_RECURSION];
     UA_Boolean useReversible;
@@ -38,8 +45,19 @@ typedef struct {
     UA_Boolean prettyPrint;
     UA_Boolean unquotedKeys;
     UA_Boolean stringNodeIds;
+
+    /* The "yyyy-MM-ddTHH:mm:ss" prefix of the last encoded DateTime. Encoded
+     * timestamps are mostly monotonic and often fall in the same second. */
+    UA_Boolean dateTimeCached;
+    uint8_t dateTimePrefixLen;
+    UA_DateTime dateTimeSec; /* Seconds of the cached prefix */
+    char dateTimePrefix[24];
 } CtxJson;
 
+/* Call after an encoding with growBuf. The length of the ByteString was set to
+ * the encoded length before. */
+void shrinkJsonBuffer(UA_ByteString *buf);
+
 UA_StatusCode writeJsonObjStart(CtxJson *ctx);
 UA_StatusCode writeJsonObjElm(CtxJson *ctx, const char *key,
                               const void *value, const UA_DataType *type);
@@ -52,6 +70,9 @@ UA_StatusCode writeJsonArrEnd(CtxJson *ctx);
 
 UA_StatusCode writeJsonKey(CtxJson *ctx, const char* key);
 
+/* Write raw (already encoded) characters */
+UA_StatusCode writeChars(CtxJson *ctx, const char *c, size_t len);
+
 /* Adds a comma if needed. Distinct elements go on a new line if pretty-printing
  * is enabled. */
 UA_StatusCode writeJsonBeforeElement(CtxJson *ctx, UA_Boolean distinct);
@@ -63,6 +84,14 @@ typedef struct {
     size_t index;
     UA_Byte depth;
 
+    /* Token storage. The tokens point either to the stack array of the caller
+     * or into the token buffer of the options. Otherwise they were allocated
+     * during the tokenization. */
+    cj5_token *stackTokens;
+    size_t tokensCapacity;
+    UA_JsonTokenBuffer *tokenBuffer;
+    size_t maxTokens;
+
     size_t namespacesSize;
     const UA_String *namespaces;
 
@@ -105,7 +134,16 @@ extern const encodeJsonSignature encodeJsonJumpTable[UA_DATATYPEKINDS];
 extern const decodeJsonSignature decodeJsonJumpTable[UA_DATATYPEKINDS];
 
 UA_StatusCode lookAheadForKey(ParseCtx *ctx, const char *search, size_t *resultIndex);
-UA_StatusCode tokenize(ParseCtx *ctx, const UA_ByteString *src, size_t tokensSize,
+
+/* Set up the context from the options. The stack array is used for the tokens
+ * unless the token buffer of the options is larger. */
+void ParseCtx_init(ParseCtx *ctx, const UA_DecodeJsonOptions *options,
+                   cj5_token *stackTokens, size_t stackTokensSize);
+
+/* Free the tokens if they were allocated during the tokenization */
+void ParseCtx_clearTokens(ParseCtx *ctx);
+
+UA_StatusCode tokenize(ParseCtx *ctx, const UA_ByteString *src,
                        size_t *decodedLength);
 
 static UA_INLINE
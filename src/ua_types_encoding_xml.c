@@ -11,6 +11,7 @@
 #include "../deps/parse_num.h"
 #include "../deps/libc_time.h"
 #include "../deps/dtoa.h"
+#include "../deps/base64.h"
 
 #ifndef UA_ENABLE_PARSING
 #error UA_ENABLE_PARSING required for XML encoding
@@ -365,11 +366,6 @@ UA_calcSizeXml(const void *src, const UA_DataType *type,
 /* Decode */
 /**********/
 
-#define CHECK_TOKEN_BOUNDS do {                   \
-    if(ctx->index >= ctx->tokensSize)             \
-        return UA_STATUSCODE_BADDECODINGERROR;    \
-    } while(0)
-
 /* Forward declarations*/
 #define DECODE_XML(TYPE) static status                   \
     TYPE##_decodeXml(ParseCtxXml *ctx, UA_##TYPE *dst,  \
@@ -597,6 +593,84 @@ DECODE_XML(Float) {
     return res;
 }
 
+/* Write the UTF-8 encoding of the code point. Returns the number of bytes or
+ * zero for an invalid code point. */
+static size_t
+utf8Encode(UA_UInt32 cp, UA_Byte *out) {
+    if(cp < 0x80) {
+        out[0] = (UA_Byte)cp;
+        return 1;
+    }
+    if(cp < 0x800) {
+        out[0] = (UA_Byte)(0xC0 | (cp >> 6));
+        out[1] = (UA_Byte)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if(cp < 0x10000) {
+        out[0] = (UA_Byte)(0xE0 | (cp >> 12));
+        out[1] = (UA_Byte)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (UA_Byte)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    if(cp < 0x110000) {
+        out[0] = (UA_Byte)(0xF0 | (cp >> 18));
+        out[1] = (UA_Byte)(0x80 | ((cp >> 12) & 0x3F));
+        out[2] = (UA_Byte)(0x80 | ((cp >> 6) & 0x3F));
+        out[3] = (UA_Byte)(0x80 | (cp & 0x3F));
+        return 4;
+    }
+    return 0;
+}
+
+/* Replace the entity reference at the beginning of the input (starting with
+ * '&'). The replacement is never longer than the reference. Returns the length
+ * of the reference or zero if it is invalid. */
+static size_t
+unescapeEntity(const char *in, size_t inLen, UA_Byte *out, size_t *outLen) {
+    const char *semi = (const char*)memchr(in, ';', (inLen < 12) ? inLen : 12);
+    if(!semi)
+        return 0;
+    size_t len = (size_t)(semi - in) + 1;
+    if(len == 4 && memcmp(in, "&lt;", 4) == 0) {
+        *out = '<'; *outLen = 1;
+    } else if(len == 4 && memcmp(in, "&gt;", 4) == 0) {
+        *out = '>'; *outLen = 1;
+    } else if(len == 5 && memcmp(in, "&amp;", 5) == 0) {
+        *out = '&'; *outLen = 1;
+    } else if(len == 6 && memcmp(in, "&quot;", 6) == 0) {
+        *out = '"'; *outLen = 1;
+    } else if(len == 6 && memcmp(in, "&apos;", 6) == 0) {
+        *out = '\''; *outLen = 1;
+    } else if(len > 3 && in[1] == '#') {
+        /* Character reference in decimal or hex */
+        UA_Boolean hex = (in[2] == 'x');
+        size_t i = (hex) ? 3 : 2;
+        if(i + 1 >= len)
+            return 0;
+        UA_UInt32 cp = 0;
+        for(; i < len - 1; i++) {
+            UA_Byte c = (UA_Byte)in[i];
+            UA_Byte lc = (UA_Byte)(c | 32);
+            if(c >= '0' && c <= '9')
+                cp = cp * ((hex) ? 16 : 10) + (UA_UInt32)(c - '0');
+            else if(hex && lc >= 'a' && lc <= 'f')
+                cp = cp * 16 + (UA_UInt32)(lc - 'a' + 10);
+            else
+                return 0;
+            if(cp >= 0x110000)
+                return 0;
+        }
+        *outLen = utf8Encode(cp, out);
+        if(*outLen == 0)
+            return 0;
+    } else {
+        return 0;
+    }
+    return len;
+}
+
+/* The String is copied from the input. Entity and character references are
+ * replaced during the copy. */
 DECODE_XML(String) {
     /* Empty string? */
     if(ctx->length == 0) {
@@ -605,14 +679,34 @@ DECODE_XML(String) {
         return UA_STATUSCODE_GOOD;
     }
 
-    /* Set the output */
-    dst->length = ctx->length;
-    if(dst->length > 0) {
-        dst->data = (UA_Byte*)(uintptr_t)ctx->data;
-    } else {
-        dst->data = (UA_Byte*)UA_EMPTY_ARRAY_SENTINEL;
+    UA_Byte *out = (UA_Byte*)UA_malloc(ctx->length);
+    if(!out)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    /* Copy the runs between the references in bulk */
+    size_t pos = 0, len = 0;
+    while(pos < ctx->length) {
+        const char *amp = (const char*)
+            memchr(&ctx->data[pos], '&', ctx->length - pos);
+        size_t run = (amp) ? (size_t)(amp - &ctx->data[pos]) : ctx->length - pos;
+        memcpy(&out[len], &ctx->data[pos], run);
+        pos += run;
+        len += run;
+        if(!amp)
+            break;
+        size_t outLen = 0;
+        size_t refLen = unescapeEntity(&ctx->data[pos], ctx->length - pos,
+                                       &out[len], &outLen);
+        if(refLen == 0) {
+            UA_free(out);
+            return UA_STATUSCODE_BADDECODINGERROR;
+        }
+        pos += refLen;
+        len += outLen;
     }
 
+    dst->data = out;
+    dst->length = len;
     return UA_STATUSCODE_GOOD;
 }
 
@@ -758,6 +852,744 @@ DECODE_XML(ExpandedNodeId) {
     return UA_ExpandedNodeId_parse(dst, str);
 }
 
+/* Pull Parser
+ * -----------
+ * The values of the structured types are decoded in a single pass over the
+ * input without a separate tokenization. Element names and text content are
+ * used in place. Only the decoded Strings, ByteStrings and XmlElements are
+ * allocated. Namespace prefixes of element names (e.g. "uax:") and attributes
+ * are ignored. Comments are allowed between elements. */
+
+static UA_Boolean
+xmlIsSpace(char c) {
+    return (c == ' ' || c == '\t' || c == '\n' || c == '\r');
+}
+
+typedef struct {
+    const char *name; /* Without the namespace prefix */
+    size_t nameLength;
+    UA_Boolean empty; /* <Name/> */
+} XmlTag;
+
+static UA_Boolean
+xmlNameEqual(const XmlTag *tag, const char *name) {
+    return (name && strncmp(tag->name, name, tag->nameLength) == 0 &&
+            name[tag->nameLength] == 0);
+}
+
+/* Skip whitespace, comments and processing instructions (also the xml
+ * declaration) */
+static status
+xmlSkipMisc(ParseCtxXml *ctx) {
+    while(ctx->pos < ctx->xmlLength) {
+        const char *c = &ctx->xml[ctx->pos];
+        size_t left = ctx->xmlLength - ctx->pos;
+        if(xmlIsSpace(*c)) {
+            ctx->pos++;
+            continue;
+        }
+        const char *close;
+        size_t closeLen;
+        if(left >= 2 && c[0] == '<' && c[1] == '?') {
+            close = "?>";
+            closeLen = 2;
+        } else if(left >= 4 && memcmp(c, "<!--", 4) == 0) {
+            close = "-->";
+            closeLen = 3;
+        } else {
+            break;
+        }
+        size_t p = ctx->pos + 2;
+        while(true) {
+            const char *next = (const char*)
+                memchr(&ctx->xml[p], close[0], ctx->xmlLength - p);
+            if(!next)
+                return UA_STATUSCODE_BADDECODINGERROR;
+            p = (size_t)(next - ctx->xml);
+            if(ctx->xmlLength - p >= closeLen && memcmp(next, close, closeLen) == 0)
+                break;
+            p++;
+        }
+        ctx->pos = p + closeLen;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+/* The content of the current element ends here (or the input ends) */
+static UA_Boolean
+xmlAtEnd(ParseCtxXml *ctx) {
+    if(xmlSkipMisc(ctx) != UA_STATUSCODE_GOOD)
+        return true;
+    return (ctx->pos + 1 >= ctx->xmlLength ||
+            (ctx->xml[ctx->pos] == '<' && ctx->xml[ctx->pos + 1] == '/'));
+}
+
+/* The next element content is a start tag */
+static UA_Boolean
+xmlAtStartTag(ParseCtxXml *ctx) {
+    return (!xmlAtEnd(ctx) && ctx->xml[ctx->pos] == '<');
+}
+
+static status
+xmlStartTag(ParseCtxXml *ctx, XmlTag *tag) {
+    status ret = xmlSkipMisc(ctx);
+    UA_CHECK_STATUS(ret, return ret);
+    if(ctx->pos + 1 >= ctx->xmlLength || ctx->xml[ctx->pos] != '<' ||
+       ctx->xml[ctx->pos + 1] == '/')
+        return UA_STATUSCODE_BADDECODINGERROR;
+
+    /* Parse the name */
+    size_t p = ctx->pos + 1;
+    size_t begin = p;
+    for(; p < ctx->xmlLength; p++) {
+        char c = ctx->xml[p];
+        if(xmlIsSpace(c) || c == '>' || c == '/')
+            break;
+        if(c == ':')
+            begin = p + 1; /* Remove the namespace prefix */
+    }
+    tag->name = &ctx->xml[begin];
+    tag->nameLength = p - begin;
+    if(tag->nameLength == 0)
+        return UA_STATUSCODE_BADDECODINGERROR;
+
+    /* Skip the attributes. Quoted values can contain '>'. */
+    char quote = 0;
+    for(; p < ctx->xmlLength; p++) {
+        char c = ctx->xml[p];
+        if(quote) {
+            if(c == quote)
+                quote = 0;
+        } else if(c == '"' || c == '\'') {
+            quote = c;
+        } else if(c == '>') {
+            break;
+        }
+    }
+    if(p >= ctx->xmlLength)
+        return UA_STATUSCODE_BADDECODINGERROR;
+    tag->empty = (ctx->xml[p - 1] == '/');
+    ctx->pos = p + 1;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Consume the end tag. The name is compared without the namespace prefix. */
+static status
+xmlEndTag(ParseCtxXml *ctx, const XmlTag *tag) {
+    status ret = xmlSkipMisc(ctx);
+    UA_CHECK_STATUS(ret, return ret);
+    if(ctx->pos + 1 >= ctx->xmlLength || ctx->xml[ctx->pos] != '<' ||
+       ctx->xml[ctx->pos + 1] != '/')
+        return UA_STATUSCODE_BADDECODINGERROR;
+    size_t p = ctx->pos + 2;
+    size_t begin = p;
+    for(; p < ctx->xmlLength && ctx->xml[p] != '>' && !xmlIsSpace(ctx->xml[p]); p++) {
+        if(ctx->xml[p] == ':')
+            begin = p + 1;
+    }
+    if(p - begin != tag->nameLength ||
+       memcmp(&ctx->xml[begin], tag->name, tag->nameLength) != 0)
+        return UA_STATUSCODE_BADDECODINGERROR;
+    while(p < ctx->xmlLength && ctx->xml[p] != '>')
+        p++;
+    if(p >= ctx->xmlLength)
+        return UA_STATUSCODE_BADDECODINGERROR;
+    ctx->pos = p + 1;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Skip the content of the current element including nested elements */
+static status
+xmlSkipContent(ParseCtxXml *ctx) {
+    size_t depth = 0;
+    while(true) {
+        const char *lt = (const char*)
+            memchr(&ctx->xml[ctx->pos], '<', ctx->xmlLength - ctx->pos);
+        if(!lt) {
+            ctx->pos = ctx->xmlLength;
+            return (depth == 0) ? UA_STATUSCODE_GOOD : UA_STATUSCODE_BADDECODINGERROR;
+        }
+        ctx->pos = (size_t)(lt - ctx->xml);
+        status ret = xmlSkipMisc(ctx);
+        UA_CHECK_STATUS(ret, return ret);
+        if(ctx->pos >= ctx->xmlLength || ctx->xml[ctx->pos] != '<')
+            continue; /* Text after a comment */
+        if(ctx->pos + 1 < ctx->xmlLength && ctx->xml[ctx->pos + 1] == '/') {
+            if(depth == 0)
+                return UA_STATUSCODE_GOOD;
+            const char *gt = (const char*)
+                memchr(&ctx->xml[ctx->pos], '>', ctx->xmlLength - ctx->pos);
+            if(!gt)
+                return UA_STATUSCODE_BADDECODINGERROR;
+            ctx->pos = (size_t)(gt - ctx->xml) + 1;
+            depth--;
+            continue;
+        }
+        XmlTag tag;
+        ret = xmlStartTag(ctx, &tag);
+        UA_CHECK_STATUS(ret, return ret);
+        if(!tag.empty)
+            depth++;
+    }
+}
+
+static status
+decodeXmlContent(ParseCtxXml *ctx, void *dst, const UA_DataType *type);
+
+/* Decode the text content with the scalar decoder */
+static status
+decodeXmlText(ParseCtxXml *ctx, void *dst, const UA_DataType *type) {
+    const char *text = &ctx->xml[ctx->pos];
+    const char *lt = (const char*)memchr(text, '<', ctx->xmlLength - ctx->pos);
+    size_t len = (lt) ? (size_t)(lt - text) : ctx->xmlLength - ctx->pos;
+    ctx->pos += len;
+
+    /* Whitespace around the value is only significant for strings */
+    if(type->typeKind != UA_DATATYPEKIND_STRING) {
+        while(len > 0 && xmlIsSpace(*text)) {
+            text++;
+            len--;
+        }
+        while(len > 0 && xmlIsSpace(text[len - 1]))
+            len--;
+    }
+
+    ctx->data = text;
+    ctx->length = len;
+    return decodeXmlJumpTable[type->typeKind](ctx, dst, type);
+}
+
+/* The NodeId and StatusCode can be wrapped into an element (<Identifier>,
+ * <Code>) or be given as text */
+static status
+decodeXmlTextOrWrapped(ParseCtxXml *ctx, void *dst, const UA_DataType *type,
+                       const char *wrapper) {
+    if(!xmlAtStartTag(ctx))
+        return decodeXmlText(ctx, dst, type);
+    XmlTag tag;
+    status ret = xmlStartTag(ctx, &tag);
+    UA_CHECK_STATUS(ret, return ret);
+    if(!xmlNameEqual(&tag, wrapper))
+        return UA_STATUSCODE_BADDECODINGERROR;
+    if(tag.empty)
+        return UA_STATUSCODE_GOOD;
+    ret = decodeXmlText(ctx, dst, type);
+    UA_CHECK_STATUS(ret, return ret);
+    return xmlEndTag(ctx, &tag);
+}
+
+/* Decode the repeated elements of an array. The array grows geometrically.
+ * So the elements are decoded in one pass without counting them first. */
+static status
+Array_decodeXml(ParseCtxXml *ctx, void **dst, const UA_DataType *type) {
+    size_t *size = (size_t*)dst - 1;
+    size_t capacity = 0;
+    while(!xmlAtEnd(ctx)) {
+        XmlTag tag;
+        status ret = xmlStartTag(ctx, &tag);
+        UA_CHECK_STATUS(ret, return ret);
+        if(*size == capacity) {
+            size_t newCapacity = (capacity == 0) ? 8 : capacity * 2;
+            void *data = UA_realloc(*dst, newCapacity * type->memSize);
+            UA_CHECK_MEM(data, return UA_STATUSCODE_BADOUTOFMEMORY);
+            memset((char*)data + capacity * type->memSize, 0,
+                   (newCapacity - capacity) * type->memSize);
+            *dst = data;
+            capacity = newCapacity;
+        }
+        void *elem = (char*)*dst + (*size * type->memSize);
+        (*size)++; /* Cleaned up also if decoding fails */
+        if(tag.empty)
+            continue;
+        ret = decodeXmlContent(ctx, elem, type);
+        UA_CHECK_STATUS(ret, return ret);
+        ret = xmlEndTag(ctx, &tag);
+        UA_CHECK_STATUS(ret, return ret);
+    }
+    if(*size == 0)
+        *dst = UA_EMPTY_ARRAY_SENTINEL;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Optional scalar field of a structure */
+static status
+Optional_decodeXml(ParseCtxXml *ctx, void **dst, const UA_DataType *type) {
+    *dst = UA_new(type);
+    UA_CHECK_MEM(*dst, return UA_STATUSCODE_BADOUTOFMEMORY);
+    return decodeXmlContent(ctx, *dst, type);
+}
+
+/* Lookup entry for the child elements. The entries are prepared once per
+ * value. They are expected in order. So the lookup mostly succeeds with the
+ * first comparison. */
+typedef struct {
+    const char *name;
+    size_t nameLength;
+    void *fieldPointer;
+    decodeXmlSignature function; /* NULL for decodeXmlContent */
+    const UA_DataType *type;
+    UA_Boolean found;
+} XmlDecodeEntry;
+
+static XmlDecodeEntry *
+lookupEntry(XmlDecodeEntry *entries, size_t entriesSize, size_t *next,
+            const XmlTag *tag) {
+    for(size_t i = 0; i < entriesSize; i++) {
+        size_t j = (*next + i) % entriesSize;
+        if(entries[j].nameLength == tag->nameLength &&
+           memcmp(entries[j].name, tag->name, tag->nameLength) == 0) {
+            *next = j + 1;
+            return &entries[j];
+        }
+    }
+    return NULL;
+}
+
+/* Unknown elements are skipped. Missing elements keep the default value. */
+static status
+decodeXmlFields(ParseCtxXml *ctx, XmlDecodeEntry *entries, size_t entriesSize) {
+    if(ctx->depth >= UA_XML_ENCODING_MAX_RECURSION - 1)
+        return UA_STATUSCODE_BADENCODINGERROR;
+    ctx->depth++;
+
+    size_t next = 0;
+    status ret = UA_STATUSCODE_GOOD;
+    while(ret == UA_STATUSCODE_GOOD && !xmlAtEnd(ctx)) {
+        XmlTag tag;
+        ret = xmlStartTag(ctx, &tag);
+        if(ret != UA_STATUSCODE_GOOD)
+            break;
+        XmlDecodeEntry *e = lookupEntry(entries, entriesSize, &next, &tag);
+        if(e && e->found) {
+            ret = UA_STATUSCODE_BADDECODINGERROR; /* Duplicate field */
+            break;
+        }
+        if(tag.empty) {
+            if(e)
+                e->found = true;
+            continue;
+        }
+        if(!e) {
+            ret = xmlSkipContent(ctx);
+        } else {
+            e->found = true;
+            ret = (e->function) ?
+                e->function(ctx, e->fieldPointer, e->type) :
+                decodeXmlContent(ctx, e->fieldPointer, e->type);
+        }
+        if(ret == UA_STATUSCODE_GOOD)
+            ret = xmlEndTag(ctx, &tag);
+    }
+
+    ctx->depth--;
+    return ret;
+}
+
+static void
+setEntry(XmlDecodeEntry *e, const char *name, void *fieldPointer,
+         decodeXmlSignature function, const UA_DataType *type) {
+    e->name = name;
+    e->nameLength = strlen(name);
+    e->fieldPointer = fieldPointer;
+    e->function = function;
+    e->type = type;
+    e->found = false;
+}
+
+DECODE_XML(StatusCode) {
+    UA_UInt64 out = 0;
+    status ret = decodeUnsigned(ctx->data, ctx->length, &out);
+    if(ret != UA_STATUSCODE_GOOD || out > UA_UINT32_MAX)
+        return UA_STATUSCODE_BADDECODINGERROR;
+    *dst = (UA_StatusCode)out;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Enumerations are encoded as <Name>_<Value> */
+static status
+decodeXmlEnum(ParseCtxXml *ctx, UA_Int32 *dst, const UA_DataType *type) {
+    size_t start = ctx->length;
+    while(start > 0 && ctx->data[start - 1] != '_')
+        start--;
+    UA_Int64 out = 0;
+    status ret = decodeSigned(&ctx->data[start], ctx->length - start, &out);
+    if(ret != UA_STATUSCODE_GOOD || out < UA_INT32_MIN || out > UA_INT32_MAX)
+        return UA_STATUSCODE_BADDECODINGERROR;
+    *dst = (UA_Int32)out;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Base64 encoding. Line breaks in the text are removed first. */
+DECODE_XML(ByteString) {
+    if(ctx->length == 0) {
+        dst->data = (UA_Byte*)UA_EMPTY_ARRAY_SENTINEL;
+        dst->length = 0;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    const unsigned char *in = (const unsigned char*)ctx->data;
+    size_t inLen = ctx->length;
+    unsigned char *compact = NULL;
+    for(size_t i = 0; i < ctx->length; i++) {
+        if(!xmlIsSpace(ctx->data[i]))
+            continue;
+        compact = (unsigned char*)UA_malloc(ctx->length);
+        UA_CHECK_MEM(compact, return UA_STATUSCODE_BADOUTOFMEMORY);
+        inLen = 0;
+        for(size_t j = 0; j < ctx->length; j++) {
+            if(!xmlIsSpace(ctx->data[j]))
+                compact[inLen++] = (unsigned char)ctx->data[j];
+        }
+        in = compact;
+        break;
+    }
+
+    size_t outLen = 0;
+    unsigned char *out = UA_unbase64(in, inLen, &outLen);
+    UA_free(compact);
+    if(!out)
+        return UA_STATUSCODE_BADDECODINGERROR;
+    dst->data = out;
+    dst->length = outLen;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* The XmlElement is the copied content of the element */
+DECODE_XML(XmlElement) {
+    size_t start = ctx->pos;
+    status ret = xmlSkipContent(ctx);
+    UA_CHECK_STATUS(ret, return ret);
+    UA_String content = {ctx->pos - start, (UA_Byte*)(uintptr_t)&ctx->xml[start]};
+    return UA_String_copy(&content, dst);
+}
+
+DECODE_XML(QualifiedName) {
+    XmlDecodeEntry entries[2];
+    setEntry(&entries[0], "NamespaceIndex", &dst->namespaceIndex, NULL,
+             &UA_TYPES[UA_TYPES_UINT16]);
+    setEntry(&entries[1], "Name", &dst->name, NULL, &UA_TYPES[UA_TYPES_STRING]);
+    return decodeXmlFields(ctx, entries, 2);
+}
+
+DECODE_XML(LocalizedText) {
+    XmlDecodeEntry entries[2];
+    setEntry(&entries[0], "Locale", &dst->locale, NULL, &UA_TYPES[UA_TYPES_STRING]);
+    setEntry(&entries[1], "Text", &dst->text, NULL, &UA_TYPES[UA_TYPES_STRING]);
+    return decodeXmlFields(ctx, entries, 2);
+}
+
+static const UA_DataType *
+findTypeByName(const XmlTag *tag, const UA_DataTypeArray *customTypes,
+               UA_Boolean customFirst) {
+    for(size_t round = 0; round < 2; round++) {
+        if((round == 0) == customFirst) {
+            for(const UA_DataTypeArray *ct = customTypes; ct; ct = ct->next) {
+                for(size_t i = 0; i < ct->typesSize; i++) {
+                    if(xmlNameEqual(tag, ct->types[i].typeName))
+                        return &ct->types[i];
+                }
+            }
+        } else {
+            for(size_t i = 0; i < UA_TYPES_COUNT; i++) {
+                if(xmlNameEqual(tag, UA_TYPES[i].typeName))
+                    return &UA_TYPES[i];
+            }
+        }
+    }
+    return NULL;
+}
+
+/* The TypeId of the XML encoding is not contained in the DataType description.
+ * So the type of the body is looked up by its element name if the TypeId is
+ * not the DataType NodeId. The type of the last body is tried first. That
+ * speeds up arrays of ExtensionObjects with the same type. */
+static const UA_DataType *
+lookupBodyType(ParseCtxXml *ctx, const UA_NodeId *typeId, const XmlTag *tag) {
+    const UA_DataType *type = ctx->lastBodyType;
+    if(type && xmlNameEqual(tag, type->typeName))
+        return type;
+    type = UA_findDataTypeWithCustom(typeId, ctx->customTypes);
+    if(!type || !xmlNameEqual(tag, type->typeName))
+        type = findTypeByName(tag, ctx->customTypes, typeId->namespaceIndex != 0);
+    if(type)
+        ctx->lastBodyType = type;
+    return type;
+}
+
+/* Bodies of an unknown type are kept in the XML encoding */
+static status
+decodeXmlBody(ParseCtxXml *ctx, UA_ExtensionObject *dst, UA_NodeId *typeId) {
+    size_t start = ctx->pos;
+    if(xmlAtStartTag(ctx)) {
+        XmlTag tag;
+        status ret = xmlStartTag(ctx, &tag);
+        UA_CHECK_STATUS(ret, return ret);
+        const UA_DataType *type = lookupBodyType(ctx, typeId, &tag);
+        if(type) {
+            void *data = UA_new(type);
+            UA_CHECK_MEM(data, return UA_STATUSCODE_BADOUTOFMEMORY);
+            dst->encoding = UA_EXTENSIONOBJECT_DECODED;
+            dst->content.decoded.type = type;
+            dst->content.decoded.data = data;
+            if(tag.empty)
+                return UA_STATUSCODE_GOOD;
+            ret = decodeXmlContent(ctx, data, type);
+            UA_CHECK_STATUS(ret, return ret);
+            return xmlEndTag(ctx, &tag);
+        }
+        ctx->pos = start;
+    }
+
+    status ret = xmlSkipContent(ctx);
+    UA_CHECK_STATUS(ret, return ret);
+    dst->encoding = UA_EXTENSIONOBJECT_ENCODED_XML;
+    dst->content.encoded.typeId = *typeId;
+    UA_NodeId_init(typeId);
+    UA_String body = {ctx->pos - start, (UA_Byte*)(uintptr_t)&ctx->xml[start]};
+    return UA_String_copy(&body, &dst->content.encoded.body);
+}
+
+DECODE_XML(ExtensionObject) {
+    if(ctx->depth >= UA_XML_ENCODING_MAX_RECURSION - 1)
+        return UA_STATUSCODE_BADENCODINGERROR;
+    ctx->depth++;
+
+    UA_NodeId typeId;
+    UA_NodeId_init(&typeId);
+    UA_Boolean hasBody = false;
+    status ret = UA_STATUSCODE_GOOD;
+    while(ret == UA_STATUSCODE_GOOD && !xmlAtEnd(ctx)) {
+        XmlTag tag;
+        ret = xmlStartTag(ctx, &tag);
+        if(ret != UA_STATUSCODE_GOOD || tag.empty)
+            continue;
+        if(xmlNameEqual(&tag, "TypeId") && !hasBody) {
+            UA_NodeId_clear(&typeId);
+            ret = decodeXmlTextOrWrapped(ctx, &typeId, &UA_TYPES[UA_TYPES_NODEID],
+                                         "Identifier");
+        } else if(xmlNameEqual(&tag, "Body") && !hasBody) {
+            hasBody = true;
+            ret = decodeXmlBody(ctx, dst, &typeId);
+        } else {
+            ret = xmlSkipContent(ctx);
+        }
+        if(ret == UA_STATUSCODE_GOOD)
+            ret = xmlEndTag(ctx, &tag);
+    }
+
+    if(ret == UA_STATUSCODE_GOOD && !hasBody) {
+        dst->encoding = UA_EXTENSIONOBJECT_ENCODED_NOBODY;
+        dst->content.encoded.typeId = typeId;
+        UA_NodeId_init(&typeId);
+    }
+    UA_NodeId_clear(&typeId);
+    ctx->depth--;
+    return ret;
+}
+
+/* Move the decoded content of ExtensionObjects into the Variant if all have the
+ * same type */
+static void
+Variant_unwrapExtensionObjects(UA_Variant *dst) {
+    UA_ExtensionObject *eo = (UA_ExtensionObject*)dst->data;
+    size_t size = (dst->arrayLength > 0) ? dst->arrayLength : 1;
+    if(dst->arrayLength == 0 && dst->data == UA_EMPTY_ARRAY_SENTINEL)
+        return;
+    const UA_DataType *type = NULL;
+    for(size_t i = 0; i < size; i++) {
+        if(eo[i].encoding != UA_EXTENSIONOBJECT_DECODED ||
+           (type && eo[i].content.decoded.type != type))
+            return;
+        type = eo[i].content.decoded.type;
+    }
+
+    if(UA_Variant_isScalar(dst)) {
+        dst->type = type;
+        dst->data = eo->content.decoded.data;
+        UA_free(eo);
+        return;
+    }
+
+    void *data = UA_malloc(size * type->memSize);
+    if(!data)
+        return; /* Keep the ExtensionObjects */
+    for(size_t i = 0; i < size; i++) {
+        memcpy((char*)data + (i * type->memSize),
+               eo[i].content.decoded.data, type->memSize);
+        UA_free(eo[i].content.decoded.data);
+    }
+    UA_free(eo);
+    dst->type = type;
+    dst->data = data;
+}
+
+/* The content is one element named after the built-in type or ListOf<Type>.
+ * Matrix values are not supported. */
+DECODE_XML(Variant) {
+    if(xmlAtEnd(ctx))
+        return UA_STATUSCODE_GOOD; /* Empty Variant */
+
+    XmlTag tag;
+    status ret = xmlStartTag(ctx, &tag);
+    UA_CHECK_STATUS(ret, return ret);
+    XmlTag typeTag = tag;
+    UA_Boolean isArray = (tag.nameLength > 6 && memcmp(tag.name, "ListOf", 6) == 0);
+    if(isArray) {
+        typeTag.name += 6;
+        typeTag.nameLength -= 6;
+    }
+    const UA_DataType *vt = NULL;
+    for(size_t i = 0; i <= UA_TYPES_DIAGNOSTICINFO; i++) {
+        if(xmlNameEqual(&typeTag, UA_TYPES[i].typeName)) {
+            vt = &UA_TYPES[i];
+            break;
+        }
+    }
+    if(!vt)
+        return UA_STATUSCODE_BADDECODINGERROR;
+
+    if(ctx->depth >= UA_XML_ENCODING_MAX_RECURSION - 1)
+        return UA_STATUSCODE_BADENCODINGERROR;
+    ctx->depth++;
+    dst->type = vt;
+    if(isArray) {
+        dst->data = UA_EMPTY_ARRAY_SENTINEL;
+        if(!tag.empty) {
+            dst->data = NULL;
+            ret = Array_decodeXml(ctx, &dst->data, vt);
+        }
+    } else {
+        dst->data = UA_new(vt);
+        if(!dst->data)
+            ret = UA_STATUSCODE_BADOUTOFMEMORY;
+        else if(!tag.empty)
+            ret = decodeXmlContent(ctx, dst->data, vt);
+    }
+    ctx->depth--;
+    UA_CHECK_STATUS(ret, return ret);
+
+    if(!tag.empty) {
+        ret = xmlEndTag(ctx, &tag);
+        UA_CHECK_STATUS(ret, return ret);
+    }
+    if(vt == &UA_TYPES[UA_TYPES_EXTENSIONOBJECT])
+        Variant_unwrapExtensionObjects(dst);
+    return UA_STATUSCODE_GOOD;
+}
+
+DECODE_XML(DataValue) {
+    XmlDecodeEntry entries[6];
+    setEntry(&entries[0], "Value", &dst->value, NULL, &UA_TYPES[UA_TYPES_VARIANT]);
+    setEntry(&entries[1], "StatusCode", &dst->status, NULL,
+             &UA_TYPES[UA_TYPES_STATUSCODE]);
+    setEntry(&entries[2], "SourceTimestamp", &dst->sourceTimestamp, NULL,
+             &UA_TYPES[UA_TYPES_DATETIME]);
+    setEntry(&entries[3], "SourcePicoseconds", &dst->sourcePicoseconds, NULL,
+             &UA_TYPES[UA_TYPES_UINT16]);
+    setEntry(&entries[4], "ServerTimestamp", &dst->serverTimestamp, NULL,
+             &UA_TYPES[UA_TYPES_DATETIME]);
+    setEntry(&entries[5], "ServerPicoseconds", &dst->serverPicoseconds, NULL,
+             &UA_TYPES[UA_TYPES_UINT16]);
+    status ret = decodeXmlFields(ctx, entries, 6);
+    dst->hasValue = entries[0].found;
+    dst->hasStatus = entries[1].found;
+    dst->hasSourceTimestamp = entries[2].found;
+    dst->hasSourcePicoseconds = entries[3].found;
+    dst->hasServerTimestamp = entries[4].found;
+    dst->hasServerPicoseconds = entries[5].found;
+    return ret;
+}
+
+/* The entries for the members are prepared once. Then the child elements are
+ * matched against them in a single pass. */
+static status
+decodeXmlStructure(ParseCtxXml *ctx, void *dst, const UA_DataType *type) {
+    uintptr_t ptr = (uintptr_t)dst;
+    size_t membersSize = type->membersSize;
+    UA_STACKARRAY(XmlDecodeEntry, entries, membersSize);
+    for(size_t i = 0; i < membersSize; i++) {
+        const UA_DataTypeMember *m = &type->members[i];
+        ptr += m->padding;
+        if(m->isArray) {
+            ptr += sizeof(size_t);
+            setEntry(&entries[i], m->memberName, (void*)ptr,
+                     (decodeXmlSignature)Array_decodeXml, m->memberType);
+            ptr += sizeof(void*);
+        } else if(m->isOptional) {
+            setEntry(&entries[i], m->memberName, (void*)ptr,
+                     (decodeXmlSignature)Optional_decodeXml, m->memberType);
+            ptr += sizeof(void*);
+        } else {
+            setEntry(&entries[i], m->memberName, (void*)ptr, NULL, m->memberType);
+            ptr += m->memberType->memSize;
+        }
+    }
+    return decodeXmlFields(ctx, entries, membersSize);
+}
+
+/* <SwitchField> selects the member that follows */
+static status
+decodeXmlUnion(ParseCtxXml *ctx, void *dst, const UA_DataType *type) {
+    if(xmlAtEnd(ctx))
+        return UA_STATUSCODE_GOOD;
+    XmlTag tag;
+    status ret = xmlStartTag(ctx, &tag);
+    UA_CHECK_STATUS(ret, return ret);
+    if(!xmlNameEqual(&tag, "SwitchField"))
+        return UA_STATUSCODE_BADDECODINGERROR;
+    UA_UInt32 *selection = (UA_UInt32*)dst;
+    if(!tag.empty) {
+        ret = decodeXmlText(ctx, selection, &UA_TYPES[UA_TYPES_UINT32]);
+        UA_CHECK_STATUS(ret, return ret);
+        ret = xmlEndTag(ctx, &tag);
+        UA_CHECK_STATUS(ret, return ret);
+    }
+
+    /* No content? */
+    if(*selection == 0)
+        return UA_STATUSCODE_GOOD;
+    if(*selection - 1 >= type->membersSize)
+        return UA_STATUSCODE_BADDECODINGERROR;
+
+    /* Decode the selected member */
+    const UA_DataTypeMember *m = &type->members[*selection - 1];
+    uintptr_t ptr = ((uintptr_t)dst) + m->padding; /* Includes the switchfield */
+    XmlDecodeEntry entry;
+    if(m->isArray)
+        setEntry(&entry, m->memberName, (void*)(ptr + sizeof(size_t)),
+                 (decodeXmlSignature)Array_decodeXml, m->memberType);
+    else
+        setEntry(&entry, m->memberName, (void*)ptr, NULL, m->memberType);
+    return decodeXmlFields(ctx, &entry, 1);
+}
+
+/* Decode the content of an element */
+static status
+decodeXmlContent(ParseCtxXml *ctx, void *dst, const UA_DataType *type) {
+    switch(type->typeKind) {
+    case UA_DATATYPEKIND_NODEID:
+    case UA_DATATYPEKIND_EXPANDEDNODEID:
+        return decodeXmlTextOrWrapped(ctx, dst, type, "Identifier");
+    case UA_DATATYPEKIND_STATUSCODE:
+        return decodeXmlTextOrWrapped(ctx, dst, type, "Code");
+    case UA_DATATYPEKIND_XMLELEMENT:
+    case UA_DATATYPEKIND_QUALIFIEDNAME:
+    case UA_DATATYPEKIND_LOCALIZEDTEXT:
+    case UA_DATATYPEKIND_EXTENSIONOBJECT:
+    case UA_DATATYPEKIND_DATAVALUE:
+    case UA_DATATYPEKIND_VARIANT:
+    case UA_DATATYPEKIND_DIAGNOSTICINFO:
+    case UA_DATATYPEKIND_DECIMAL:
+    case UA_DATATYPEKIND_STRUCTURE:
+    case UA_DATATYPEKIND_OPTSTRUCT:
+    case UA_DATATYPEKIND_UNION:
+    case UA_DATATYPEKIND_BITFIELDCLUSTER:
+        return decodeXmlJumpTable[type->typeKind](ctx, dst, type);
+    default:
+        return decodeXmlText(ctx, dst, type);
+    }
+}
+
 static status
 decodeXmlNotImplemented(ParseCtxXml *ctx, void *dst, const UA_DataType *type) {
     (void)dst, (void)type, (void)ctx;
@@ -779,22 +1611,22 @@ const decodeXmlSignature decodeXmlJumpTable[UA_DATATYPEKINDS] = {
     (decodeXmlSignature)String_decodeXml,           /* String */
     (decodeXmlSignature)DateTime_decodeXml,         /* DateTime */
     (decodeXmlSignature)Guid_decodeXml,             /* Guid */
-    (decodeXmlSignature)decodeXmlNotImplemented,    /* ByteString */
-    (decodeXmlSignature)decodeXmlNotImplemented,    /* XmlElement */
+    (decodeXmlSignature)ByteString_decodeXml,       /* ByteString */
+    (decodeXmlSignature)XmlElement_decodeXml,       /* XmlElement */
     (decodeXmlSignature)NodeId_decodeXml,           /* NodeId */
     (decodeXmlSignature)ExpandedNodeId_decodeXml,   /* ExpandedNodeId */
-    (decodeXmlSignature)decodeXmlNotImplemented,    /* StatusCode */
-    (decodeXmlSignature)decodeXmlNotImplemented,    /* QualifiedName */
-    (decodeXmlSignature)decodeXmlNotImplemented,    /* LocalizedText */
-    (decodeXmlSignature)decodeXmlNotImplemented,    /* ExtensionObject */
-    (decodeXmlSignature)decodeXmlNotImplemented,    /* DataValue */
-    (decodeXmlSignature)decodeXmlNotImplemented,    /* Variant */
+    (decodeXmlSignature)StatusCode_decodeXml,       /* StatusCode */
+    (decodeXmlSignature)QualifiedName_decodeXml,    /* QualifiedName */
+    (decodeXmlSignature)LocalizedText_decodeXml,    /* LocalizedText */
+    (decodeXmlSignature)ExtensionObject_decodeXml,  /* ExtensionObject */
+    (decodeXmlSignature)DataValue_decodeXml,        /* DataValue */
+    (decodeXmlSignature)Variant_decodeXml,          /* Variant */
     (decodeXmlSignature)decodeXmlNotImplemented,    /* DiagnosticInfo */
     (decodeXmlSignature)decodeXmlNotImplemented,    /* Decimal */
-    (decodeXmlSignature)decodeXmlNotImplemented,    /* Enum */
-    (decodeXmlSignature)decodeXmlNotImplemented,    /* Structure */
-    (decodeXmlSignature)decodeXmlNotImplemented,    /* Structure with optional fields */
-    (decodeXmlSignature)decodeXmlNotImplemented,    /* Union */
+    (decodeXmlSignature)decodeXmlEnum,              /* Enum */
+    (decodeXmlSignature)decodeXmlStructure,         /* Structure */
+    (decodeXmlSignature)decodeXmlStructure,         /* Structure with optional fields */
+    (decodeXmlSignature)decodeXmlUnion,             /* Union */
     (decodeXmlSignature)decodeXmlNotImplemented     /* BitfieldCluster */
 };
 
@@ -809,14 +1641,27 @@ UA_decodeXml(const UA_ByteString *src, void *dst, const UA_DataType *type,
     memset(&ctx, 0, sizeof(ParseCtxXml));
     ctx.data = (const char*)src->data;
     ctx.length = src->length;
+    ctx.xml = (const char*)src->data;
+    ctx.xmlLength = src->length;
     ctx.depth = 0;
     if(options) {
         ctx.customTypes = options->customTypes;
     }
 
-    /* Decode */
+    /* Decode. The scalars are given as text. The other types are given as the
+     * content of their element and decoded with the pull parser. */
     memset(dst, 0, type->memSize); /* Initialize the value */
-    status ret = decodeXmlJumpTable[type->typeKind](&ctx, dst, type);
+    status ret;
+    if(type->typeKind <= UA_DATATYPEKIND_BYTESTRING ||
+       type->typeKind == UA_DATATYPEKIND_ENUM) {
+        ret = decodeXmlJumpTable[type->typeKind](&ctx, dst, type);
+    } else {
+        ret = decodeXmlContent(&ctx, dst, type);
+        if(ret == UA_STATUSCODE_GOOD)
+            ret = xmlSkipMisc(&ctx);
+        if(ret == UA_STATUSCODE_GOOD && ctx.pos != ctx.xmlLength)
+            ret = UA_STATUSCODE_BADDECODINGERROR;
+    }
 
     if(ret != UA_STATUSCODE_GOOD) {
         UA_clear(dst, type);
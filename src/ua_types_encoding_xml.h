@@ -25,12 +25,21 @@ typedef struct {
 } CtxXml;
 
 typedef struct {
+    /* Text content of the current element for the decoding of scalars. Points
+     * into the input buffer. */
     const char* data;
     size_t length;
 
+    /* Pull parser over the input. The structured types consume the content of
+     * their element from pos up to (excluding) the end tag. */
+    const char *xml;
+    size_t xmlLength;
+    size_t pos;
+
     uint16_t depth; /* How often did we decoding recurse? */
 
     const UA_DataTypeArray *customTypes;
+    const UA_DataType *lastBodyType; /* Of the last decoded ExtensionObject */
 } ParseCtxXml;
 
 typedef UA_StatusCode
@@ -128,7 +128,7 @@ parse_nodeid_body(UA_NodeId *id, const char *body, const char *end) {
 }
 
 static UA_StatusCode
-parse_nodeid(UA_NodeId *id, const char *pos, const char *end) {
+lex_nodeid(UA_NodeId *id, const char *pos, const char *end) {
     *id = UA_NODEID_NULL; /* Reset the NodeId */
     LexContext context;
     memset(&context, 0, sizeof(LexContext));
@@ -253,6 +253,82 @@ yy11:
 
 }
 
+/* Fast path for the common forms "i=<n>", "ns=<n>;i=<n>" and "ns=<n>;s=<str>"
+ * without the lexer. Returns false if the string has a different form (or if
+ * the numbers overflow). Then the lexer decides. String identifiers point into
+ * the input. */
+static UA_Boolean
+parse_nodeid_fast(UA_NodeId *id, const char *pos, const char *end) {
+    UA_UInt32 ns = 0;
+    if(end - pos > 3 && pos[0] == 'n' && pos[1] == 's' && pos[2] == '=') {
+        pos += 3;
+        const char *nsStart = pos;
+        for(; pos < end && *pos >= '0' && *pos <= '9' && pos - nsStart < 5; pos++)
+            ns = (ns * 10) + (UA_UInt32)(*pos - '0');
+        if(pos == nsStart || ns > UA_UINT16_MAX || pos == end || *pos != ';')
+            return false;
+        pos++;
+    }
+
+    if(end - pos < 2 || pos[1] != '=')
+        return false;
+
+    if(pos[0] == 'i') {
+        pos += 2;
+        const char *numStart = pos;
+        UA_UInt64 num = 0;
+        for(; pos < end && *pos >= '0' && *pos <= '9' && pos - numStart < 10; pos++)
+            num = (num * 10) + (UA_UInt64)(*pos - '0');
+        if(pos == numStart || pos != end || num > UA_UINT32_MAX)
+            return false;
+        id->namespaceIndex = (UA_UInt16)ns;
+        id->identifierType = UA_NODEIDTYPE_NUMERIC;
+        id->identifier.numeric = (UA_UInt32)num;
+        return true;
+    }
+
+    if(pos[0] == 's') {
+        id->namespaceIndex = (UA_UInt16)ns;
+        id->identifierType = UA_NODEIDTYPE_STRING;
+        id->identifier.string.data = (UA_Byte*)(uintptr_t)(pos + 2);
+        id->identifier.string.length = (size_t)(end - (pos + 2));
+        return true;
+    }
+
+    return false;
+}
+
+static UA_StatusCode
+parse_nodeid(UA_NodeId *id, const char *pos, const char *end) {
+    if(!parse_nodeid_fast(id, pos, end))
+        return lex_nodeid(id, pos, end);
+    if(id->identifierType != UA_NODEIDTYPE_STRING)
+        return UA_STATUSCODE_GOOD;
+    UA_String borrowed = id->identifier.string;
+    return UA_String_copy(&borrowed, &id->identifier.string);
+}
+
+/* ByteString identifiers are decoded into a new buffer and cannot be
+ * borrowed */
+static UA_StatusCode
+parse_nodeid_borrowed(UA_NodeId *id, const char *pos, const char *end) {
+    if(parse_nodeid_fast(id, pos, end))
+        return UA_STATUSCODE_GOOD;
+    UA_StatusCode res = lex_nodeid(id, pos, end);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    if(id->identifierType == UA_NODEIDTYPE_BYTESTRING)
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+    if(id->identifierType == UA_NODEIDTYPE_STRING) {
+        /* The identifier is always the remainder of the input */
+        size_t len = id->identifier.string.length;
+        UA_String_clear(&id->identifier.string);
+        id->identifier.string.data = (UA_Byte*)(uintptr_t)(end - len);
+        id->identifier.string.length = len;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
 UA_StatusCode
 UA_NodeId_parse(UA_NodeId *id, const UA_String str) {
     UA_StatusCode res =
@@ -262,6 +338,71 @@ UA_NodeId_parse(UA_NodeId *id, const UA_String str) {
     return res;
 }
 
+UA_StatusCode
+UA_NodeId_parseBorrowed(UA_NodeId *id, const UA_String str) {
+    const char *end = (const char*)str.data + str.length;
+    UA_StatusCode res = parse_nodeid_borrowed(id, (const char*)str.data, end);
+    if(res != UA_STATUSCODE_GOOD) {
+        if(id->identifierType == UA_NODEIDTYPE_BYTESTRING)
+            UA_NodeId_clear(id);
+        *id = UA_NODEID_NULL;
+    }
+    return res;
+}
+
+UA_StatusCode
+UA_NodeId_parseArray(UA_NodeId **ids, const UA_String *strs, size_t strsSize,
+                     size_t *failedIndex) {
+    *ids = NULL;
+    if(strsSize == 0)
+        return UA_STATUSCODE_GOOD;
+
+    /* Upper bound for the identifier bytes. Decoded base64 is shorter than the
+     * input. */
+    size_t idBytes = 0;
+    for(size_t i = 0; i < strsSize; i++)
+        idBytes += strs[i].length;
+    UA_Byte *buf = (UA_Byte*)UA_malloc(sizeof(UA_NodeId) * strsSize + idBytes);
+    if(!buf)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_NodeId *out = (UA_NodeId*)buf;
+    UA_Byte *pos = buf + sizeof(UA_NodeId) * strsSize;
+
+    for(size_t i = 0; i < strsSize; i++) {
+        const char *s = (const char*)strs[i].data;
+        const char *e = s + strs[i].length;
+        UA_Boolean owned = false;
+        if(!parse_nodeid_fast(&out[i], s, e)) {
+            UA_StatusCode res = lex_nodeid(&out[i], s, e);
+            if(res != UA_STATUSCODE_GOOD) {
+                UA_NodeId_clear(&out[i]);
+                UA_free(buf);
+                if(failedIndex)
+                    *failedIndex = i;
+                return res;
+            }
+            owned = true;
+        }
+        if(out[i].identifierType != UA_NODEIDTYPE_STRING &&
+           out[i].identifierType != UA_NODEIDTYPE_BYTESTRING)
+            continue;
+
+        /* Move the identifier into the shared buffer */
+        UA_String *target = &out[i].identifier.string;
+        size_t len = target->length;
+        if(len > 0)
+            memcpy(pos, target->data, len);
+        if(owned)
+            UA_String_clear(target);
+        target->data = pos;
+        target->length = len;
+        pos += len;
+    }
+
+    *ids = out;
+    return UA_STATUSCODE_GOOD;
+}
+
 static UA_StatusCode
 parse_expandednodeid(UA_ExpandedNodeId *id, const char *pos, const char *end) {
     *id = UA_EXPANDEDNODEID_NULL; /* Reset the NodeId */
@@ -541,8 +682,21 @@ yy34:
 
 UA_StatusCode
 UA_ExpandedNodeId_parse(UA_ExpandedNodeId *id, const UA_String str) {
-    UA_StatusCode res =
-        parse_expandednodeid(id, (const char*)str.data, (const char*)str.data+str.length);
+    const char *pos = (const char*)str.data;
+    const char *end = pos + str.length;
+    if(parse_nodeid_fast(&id->nodeId, pos, end)) {
+        UA_NodeId tmp = id->nodeId;
+        *id = UA_EXPANDEDNODEID_NULL;
+        id->nodeId = tmp;
+        if(tmp.identifierType != UA_NODEIDTYPE_STRING)
+            return UA_STATUSCODE_GOOD;
+        UA_StatusCode res =
+            UA_String_copy(&tmp.identifier.string, &id->nodeId.identifier.string);
+        if(res != UA_STATUSCODE_GOOD)
+            *id = UA_EXPANDEDNODEID_NULL;
+        return res;
+    }
+    UA_StatusCode res = parse_expandednodeid(id, pos, end);
     if(res != UA_STATUSCODE_GOOD)
         UA_ExpandedNodeId_clear(id);
     return res;
@@ -129,7 +129,8 @@ static const struct urlSchema schemas[] = {
     {"opc.tcp://"},
     {"opc.udp://"},
     {"opc.eth://"},
-    {"opc.mqtt://"}
+    {"opc.mqtt://"},
+    {"opc.shm://"}
 };
 
 static const unsigned scNumSchemas = sizeof(schemas) / sizeof(schemas[0]);
@@ -557,16 +558,188 @@ UA_Guid_random(void) {
     return result;
 }
 
+/***********/
+/* Hashing */
+/***********/
+
+/* 64-bit hash following the xxHash64 construction. Four independent lanes
+ * consume 32 bytes per round. */
+
+#define UA_HASH64_PRIME1 0x9E3779B185EBCA87ULL
+#define UA_HASH64_PRIME2 0xC2B2AE3D27D4EB4FULL
+#define UA_HASH64_PRIME3 0x165667B19E3779F9ULL
+#define UA_HASH64_PRIME4 0x85EBCA77C2B2AE63ULL
+#define UA_HASH64_PRIME5 0x27D4EB2F165667C5ULL
+
+static UA_INLINE u64
+hash64_rotl(u64 x, unsigned r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static UA_INLINE u64
+hash64_read64(const u8 *p) {
+    u64 v;
+    memcpy(&v, p, sizeof(u64));
+    return v;
+}
+
+static UA_INLINE u64
+hash64_round(u64 acc, u64 input) {
+    acc += input * UA_HASH64_PRIME2;
+    acc = hash64_rotl(acc, 31);
+    return acc * UA_HASH64_PRIME1;
+}
+
+static UA_INLINE u64
+hash64_merge(u64 acc, u64 val) {
+    acc ^= hash64_round(0, val);
+    return acc * UA_HASH64_PRIME1 + UA_HASH64_PRIME4;
+}
+
+u64
+UA_hash64(u64 seed, const void *data, size_t size) {
+    const u8 *p = (const u8*)data;
+    const u8 *end = p + size;
+    u64 h;
+
+    if(size >= 32) {
+        const u8 *limit = end - 32;
+        u64 v1 = seed + UA_HASH64_PRIME1 + UA_HASH64_PRIME2;
+        u64 v2 = seed + UA_HASH64_PRIME2;
+        u64 v3 = seed;
+        u64 v4 = seed - UA_HASH64_PRIME1;
+        do {
+            v1 = hash64_round(v1, hash64_read64(p));
+            v2 = hash64_round(v2, hash64_read64(p + 8));
+            v3 = hash64_round(v3, hash64_read64(p + 16));
+            v4 = hash64_round(v4, hash64_read64(p + 24));
+            p += 32;
+        } while(p <= limit);
+        h = hash64_rotl(v1, 1) + hash64_rotl(v2, 7) +
+            hash64_rotl(v3, 12) + hash64_rotl(v4, 18);
+        h = hash64_merge(h, v1);
+        h = hash64_merge(h, v2);
+        h = hash64_merge(h, v3);
+        h = hash64_merge(h, v4);
+    } else {
+        h = seed + UA_HASH64_PRIME5;
+    }
+    h += (u64)size;
+
+    /* Remaining bytes */
+    for(; p + 8 <= end; p += 8) {
+        h ^= hash64_round(0, hash64_read64(p));
+        h = hash64_rotl(h, 27) * UA_HASH64_PRIME1 + UA_HASH64_PRIME4;
+    }
+    if(p + 4 <= end) {
+        u32 v;
+        memcpy(&v, p, sizeof(u32));
+        h ^= (u64)v * UA_HASH64_PRIME1;
+        h = hash64_rotl(h, 23) * UA_HASH64_PRIME2 + UA_HASH64_PRIME3;
+        p += 4;
+    }
+    for(; p < end; p++) {
+        h ^= (*p) * UA_HASH64_PRIME5;
+        h = hash64_rotl(h, 11) * UA_HASH64_PRIME1;
+    }
+
+    /* Avalanche */
+    h ^= h >> 33;
+    h *= UA_HASH64_PRIME2;
+    h ^= h >> 29;
+    h *= UA_HASH64_PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
 /********************/
 /* Malloc Singleton */
 /********************/
 
+static const char *memoryCategoryNames[UA_MEMORYCATEGORIES] =
+    {"default", "nodestore", "subscriptions", "securechannel", "pubsub", "encoding",
+     "sessions", "monitoreditems"};
+
+const char *
+UA_MemoryCategory_name(UA_MemoryCategory category) {
+    if((unsigned)category >= UA_MEMORYCATEGORIES)
+        return "unknown";
+    return memoryCategoryNames[category];
+}
+
+#if UA_MULTITHREADING >= 100 && defined(UA_DEBUG_LOCK_ORDER)
+# include <stdio.h>
+# include <stdlib.h>
+
+UA_EXPORT UA_THREAD_LOCAL unsigned char UA_lockRanksHeld[UA_LOCKRANKS];
+
+static const char *lockRankNames[UA_LOCKRANKS] =
+    {"none", "service", "asyncqueue", "asyncworker", "eventloop",
+     "timer", "profiler", "allocator", "log"};
+
+UA_EXPORT void
+UA_LockOrder_violation(UA_LockRank rank, UA_LockRank held) {
+    fprintf(stderr, "Lock order violation: Acquire a lock of rank %s while "
+            "holding a lock of rank %s\n", lockRankNames[rank], lockRankNames[held]);
+    abort();
+}
+#endif
+
 #ifdef UA_ENABLE_MALLOC_SINGLETON
 # include <stdlib.h>
 UA_EXPORT UA_THREAD_LOCAL void * (*UA_mallocSingleton)(size_t size) = malloc;
 UA_EXPORT UA_THREAD_LOCAL void (*UA_freeSingleton)(void *ptr) = free;
 UA_EXPORT UA_THREAD_LOCAL void * (*UA_callocSingleton)(size_t nelem, size_t elsize) = calloc;
 UA_EXPORT UA_THREAD_LOCAL void * (*UA_reallocSingleton)(void *ptr, size_t size) = realloc;
+
+UA_EXPORT UA_THREAD_LOCAL UA_MemoryCategory UA_memoryCategory = UA_MEMORYCATEGORY_DEFAULT;
+
+/* The allocator is global. So that the worker threads that copy the
+ * singletons from the requesting thread find it. */
+static UA_Allocator *allocatorSingleton = NULL;
+
+static void *
+allocatorMalloc(size_t size) {
+    return allocatorSingleton->malloc(allocatorSingleton, UA_memoryCategory, size);
+}
+
+static void
+allocatorFree(void *ptr) {
+    allocatorSingleton->free(allocatorSingleton, ptr);
+}
+
+static void *
+allocatorCalloc(size_t nelem, size_t elsize) {
+    return allocatorSingleton->calloc(allocatorSingleton, UA_memoryCategory,
+                                      nelem, elsize);
+}
+
+static void *
+allocatorRealloc(void *ptr, size_t size) {
+    return allocatorSingleton->realloc(allocatorSingleton, UA_memoryCategory,
+                                       ptr, size);
+}
+
+void
+UA_Allocator_set(UA_Allocator *a) {
+    allocatorSingleton = a;
+    if(!a) {
+        UA_mallocSingleton = malloc;
+        UA_freeSingleton = free;
+        UA_callocSingleton = calloc;
+        UA_reallocSingleton = realloc;
+        return;
+    }
+    UA_mallocSingleton = allocatorMalloc;
+    UA_freeSingleton = allocatorFree;
+    UA_callocSingleton = allocatorCalloc;
+    UA_reallocSingleton = allocatorRealloc;
+}
+
+UA_Allocator *
+UA_Allocator_get(void) {
+    return allocatorSingleton;
+}
 #endif
 
 /************************/
@@ -891,6 +1064,164 @@ UA_SimpleAttributeOperand_print(const UA_SimpleAttributeOperand *sao,
 
 #endif
 
+/*********/
+/* Arena */
+/*********/
+
+/* All allocations are aligned to the largest builtin scalar */
+#define UA_ARENA_ALIGN sizeof(UA_UInt64)
+#define UA_ARENA_HEADER \
+    ((sizeof(UA_ArenaBlock) + UA_ARENA_ALIGN - 1) & ~(UA_ARENA_ALIGN - 1))
+
+void *
+UA_Arena_calloc(void *context, size_t nelem, size_t elsize) {
+    UA_Arena *arena = (UA_Arena*)context;
+    if(elsize > 0 && nelem > SIZE_MAX / elsize)
+        return NULL;
+    size_t total = nelem * elsize;
+    if(total > SIZE_MAX - UA_ARENA_HEADER - UA_ARENA_ALIGN)
+        return NULL;
+    total = (total + UA_ARENA_ALIGN - 1) & ~(UA_ARENA_ALIGN - 1);
+
+    /* Add a new block to the front if the current block is exhausted */
+    UA_ArenaBlock *b = arena->blocks;
+    if(!b || b->pos + total > b->size) {
+        size_t size = (total > arena->blockSize) ? total : arena->blockSize;
+        b = (UA_ArenaBlock*)UA_malloc(UA_ARENA_HEADER + size);
+        if(!b)
+            return NULL;
+        b->size = size;
+        b->pos = 0;
+        b->next = arena->blocks;
+        arena->blocks = b;
+    }
+
+    void *mem = (u8*)b + UA_ARENA_HEADER + b->pos;
+    b->pos += total;
+    memset(mem, 0, total);
+    return mem;
+}
+
+void
+UA_Arena_reset(UA_Arena *arena) {
+    UA_ArenaBlock *b = arena->blocks;
+    if(!b)
+        return;
+
+    /* Keep the oldest block for reuse. Unless the first allocation made it
+     * larger than the configured size. Then a single large request does not
+     * keep the memory pinned. */
+    while(b->next) {
+        UA_ArenaBlock *next = b->next;
+        UA_free(b);
+        b = next;
+    }
+    if(b->size > arena->blockSize) {
+        UA_free(b);
+        arena->blocks = NULL;
+        return;
+    }
+    b->pos = 0;
+    arena->blocks = b;
+}
+
+void
+UA_Arena_clear(UA_Arena *arena) {
+    UA_Arena_reset(arena);
+    UA_free(arena->blocks);
+    arena->blocks = NULL;
+}
+
+/*********************/
+/* Latency Histogram */
+/*********************/
+
+#define UA_LATENCYHISTOGRAM_SUBBUCKETS (1u << UA_LATENCYHISTOGRAM_SUBBITS)
+
+static size_t
+latencyIndex(u64 value) {
+    if(value < UA_LATENCYHISTOGRAM_SUBBUCKETS)
+        return (size_t)value;
+    /* Position of the highest set bit */
+#if defined(__GNUC__) || defined(__clang__)
+    unsigned e = 63u - (unsigned)__builtin_clzll(value);
+#else
+    unsigned e = 0;
+    for(u64 v = value; v > 1; v >>= 1)
+        e++;
+#endif
+    if(e >= UA_LATENCYHISTOGRAM_MAXBITS)
+        return UA_LATENCYHISTOGRAM_BUCKETS - 1;
+    unsigned shift = e - UA_LATENCYHISTOGRAM_SUBBITS;
+    return ((size_t)(shift + 1) << UA_LATENCYHISTOGRAM_SUBBITS) +
+        (size_t)((value >> shift) & (UA_LATENCYHISTOGRAM_SUBBUCKETS - 1));
+}
+
+/* Largest value that falls into the bucket */
+static u64
+latencyUpperBound(size_t index) {
+    if(index < UA_LATENCYHISTOGRAM_SUBBUCKETS)
+        return index;
+    unsigned shift = (unsigned)(index >> UA_LATENCYHISTOGRAM_SUBBITS) - 1;
+    u64 sub = index & (UA_LATENCYHISTOGRAM_SUBBUCKETS - 1);
+    return ((UA_LATENCYHISTOGRAM_SUBBUCKETS + sub + 1) << shift) - 1;
+}
+
+static void
+latencyHalve(UA_LatencyHistogram *h) {
+    for(size_t i = 0; i < UA_LATENCYHISTOGRAM_BUCKETS; i++)
+        h->buckets[i] >>= 1;
+}
+
+void
+UA_LatencyHistogram_record(UA_LatencyHistogram *h, u64 value) {
+    size_t i = latencyIndex(value);
+    if(UA_UNLIKELY(h->buckets[i] == UA_UINT32_MAX))
+        latencyHalve(h);
+    h->buckets[i]++;
+    h->count++;
+    h->sum += value;
+    if(value > h->max)
+        h->max = value;
+}
+
+void
+UA_LatencyHistogram_merge(UA_LatencyHistogram *dst, const UA_LatencyHistogram *src) {
+    for(size_t i = 0; i < UA_LATENCYHISTOGRAM_BUCKETS; i++) {
+        while(UA_UNLIKELY(dst->buckets[i] > UA_UINT32_MAX - src->buckets[i]))
+            latencyHalve(dst);
+        dst->buckets[i] += src->buckets[i];
+    }
+    dst->count += src->count;
+    dst->sum += src->sum;
+    if(src->max > dst->max)
+        dst->max = src->max;
+}
+
+u64
+UA_LatencyHistogram_percentile(const UA_LatencyHistogram *h, double p) {
+    /* The buckets may have been halved. Compute the rank from their sum. */
+    u64 total = 0;
+    for(size_t i = 0; i < UA_LATENCYHISTOGRAM_BUCKETS; i++)
+        total += h->buckets[i];
+    if(total == 0)
+        return 0;
+    u64 rank = (u64)(p * (double)total);
+    if(rank == 0)
+        rank = 1;
+    u64 seen = 0;
+    for(size_t i = 0; i < UA_LATENCYHISTOGRAM_BUCKETS; i++) {
+        seen += h->buckets[i];
+        if(seen >= rank) {
+            if(i == UA_LATENCYHISTOGRAM_BUCKETS - 1)
+                break; /* Values beyond the range */
+            u64 bound = latencyUpperBound(i);
+            return (bound < h->max) ? bound : h->max;
+        }
+    }
+    return h->max;
+}
+
 /************************/
 /* Cryptography Helpers */
 /************************/
@@ -18,6 +18,7 @@
 #define UA_INTERNAL
 #include <open62541/types.h>
 #include <open62541/util.h>
+#include <open62541/plugin/allocator.h>
 #include <open62541/statuscodes.h>
 
 #include "../ua_types_encoding_binary.h"
@@ -37,6 +38,13 @@ _UA_BEGIN_DECLS
 void
 adjustType(UA_Variant *value, const UA_DataType *targetType);
 
+/* Copy src over the existing content of dst. If both hold a scalar of the same
+ * pointer-free type (Boolean, Int32, Double, ...), the memory of dst is reused
+ * and no allocation takes place. Otherwise dst is cleared and deep-copied. dst
+ * is left empty if the copy fails. */
+UA_StatusCode
+UA_DataValue_copyReuse(const UA_DataValue *src, UA_DataValue *dst);
+
 /* Short names for integer. These are not exposed on the public API, since many
  * user-applications make the same definitions in their headers. */
 typedef UA_Byte u8;
@@ -212,6 +220,100 @@ UA_cleanupDataTypeWithCustom(const UA_DataTypeArray *customTypes);
 size_t UA_EXPORT
 getCountOfOptionalFields(const UA_DataType *type);
 
+/* Parse a NumericRange into the caller-provided buffer for the dimensions.
+ * Only if the buffer is too small, the dimensions are allocated on the heap.
+ * Then they have to be freed if range->dimensions != buf. This avoids the heap
+ * allocation on the hot path of reading and writing with an IndexRange. */
+#define UA_NUMERICRANGE_BUFDIMS 4
+
+UA_StatusCode
+UA_NumericRange_parseInto(UA_NumericRange *range, UA_NumericRangeDimension *buf,
+                          size_t bufSize, const UA_String str);
+
+/* Arena allocator. Memory is bump-allocated from a list of blocks and released
+ * all at once. This is used with the calloc hook of UA_DecodeBinaryOptions to
+ * decode an entire message without individual allocations. The decoded value
+ * must not be _clear-ed afterwards. Resetting the arena keeps the first block
+ * for reuse if it has the configured blockSize. */
+typedef struct UA_ArenaBlock {
+    struct UA_ArenaBlock *next;
+    size_t size;
+    size_t pos;
+} UA_ArenaBlock;
+
+typedef struct {
+    UA_ArenaBlock *blocks; /* The current block is the first in the list */
+    size_t blockSize;      /* Minimum size of a new block (without header) */
+} UA_Arena;
+
+/* Matches the signature of the calloc hook in UA_DecodeBinaryOptions */
+void *
+UA_Arena_calloc(void *arena, size_t nelem, size_t elsize);
+
+void
+UA_Arena_reset(UA_Arena *arena);
+
+void
+UA_Arena_clear(UA_Arena *arena);
+
+/* Tag the allocations of the current thread with a memory category. Returns
+ * the previous category that is restored with _leave. */
+static UA_INLINE UA_MemoryCategory
+UA_MemoryCategory_enter(UA_MemoryCategory category) {
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+    UA_MemoryCategory before = UA_memoryCategory;
+    UA_memoryCategory = category;
+    return before;
+#else
+    (void)category;
+    return UA_MEMORYCATEGORY_DEFAULT;
+#endif
+}
+
+static UA_INLINE void
+UA_MemoryCategory_leave(UA_MemoryCategory before) {
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+    UA_memoryCategory = before;
+#else
+    (void)before;
+#endif
+}
+
+/* Log-linear latency histogram. The values are grouped by their power of two
+ * and every power of two is split into 2^SUBBITS linear buckets. So the
+ * relative error of the percentiles is below 1/2^SUBBITS (12.5%). Values
+ * beyond 2^MAXBITS fall into the last bucket. Recording is a few integer
+ * operations without allocations. If a bucket would overflow, all buckets are
+ * halved. This keeps the shape of the distribution. */
+#define UA_LATENCYHISTOGRAM_SUBBITS 3
+#define UA_LATENCYHISTOGRAM_MAXBITS 36
+#define UA_LATENCYHISTOGRAM_BUCKETS \
+    ((UA_LATENCYHISTOGRAM_MAXBITS - UA_LATENCYHISTOGRAM_SUBBITS + 1) << \
+     UA_LATENCYHISTOGRAM_SUBBITS)
+
+typedef struct {
+    u64 count; /* Recorded values (not reduced by the halving) */
+    u64 sum;
+    u64 max;
+    u32 buckets[UA_LATENCYHISTOGRAM_BUCKETS];
+} UA_LatencyHistogram;
+
+void
+UA_LatencyHistogram_record(UA_LatencyHistogram *h, u64 value);
+
+void
+UA_LatencyHistogram_merge(UA_LatencyHistogram *dst, const UA_LatencyHistogram *src);
+
+/* Returns the upper bound of the bucket that contains the percentile
+ * (0.0 < p <= 1.0), but not more than the maximum recorded value */
+u64
+UA_LatencyHistogram_percentile(const UA_LatencyHistogram *h, double p);
+
+/* Fast 64-bit hash of a memory area. Not cryptographically secure. Hashes
+ * can be chained by passing the previous result as the seed. */
+u64
+UA_hash64(u64 seed, const void *data, size_t size);
+
 /* Dump packet for debugging / fuzzing */
 #ifdef UA_DEBUG_DUMP_PKGS
 void UA_EXPORT
@@ -0,0 +1,644 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/plugin/log_stdout.h>
+#include <open62541/plugin/securitypolicy_default.h>
+#include <open62541/server_config_default.h>
+#include <open62541/types.h>
+
+#include "ua_securechannel.h"
+#include "ua_types_encoding_binary.h"
+
+#include <dirent.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * Corpus Replay Benchmark
+ * -----------------------
+ * Replays the binary message corpus of the fuzzer on several threads. The
+ * corpus was recorded from the traffic of the unit tests. So the message
+ * shapes are realistic. Every corpus file contains the chunks of one or more
+ * messages, followed by the four-byte memory limit of the fuzzer.
+ *
+ * The messages are grouped by the request type. For every type, two phases are
+ * measured:
+ *
+ * - process: The chunks go through UA_SecureChannel_processBuffer (header
+ *   checks, SecurityPolicy None, chunk assembly) and the request is decoded in
+ *   the message callback.
+ * - decode: Only the assembled message body is decoded.
+ *
+ * Every thread has its own SecureChannel. The threads replay the same shared
+ * corpus. Before a message is replayed, the ChannelId, TokenId and sequence
+ * number of the channel are set from the first chunk. Messages that cannot be
+ * processed in a first single-threaded pass are left out. */
+
+#define REPLAY_MAXTHREADS 256
+#define REPLAY_TYPENAME_LENGTH 64
+#define REPLAY_MASK_MESSAGETYPE 0x00ffffffu
+#define REPLAY_MASK_CHUNKTYPE 0xff000000u
+
+#ifndef UA_CORPUS_DIR
+#define UA_CORPUS_DIR "."
+#endif
+
+typedef struct {
+    UA_MessageType messageType;
+    UA_UInt32 channelId;
+    UA_UInt32 tokenId;
+    UA_UInt32 sequenceNumber;
+    UA_ByteString chunks; /* All chunks of the message */
+    UA_ByteString body;   /* Assembled message body (with the type NodeId) */
+    const UA_DataType *type;
+} ReplayMessage;
+
+typedef struct {
+    const UA_DataType *type;
+    size_t messagesSize;
+    ReplayMessage **messages;
+} ReplayGroup;
+
+typedef struct {
+    size_t messagesSize;
+    ReplayMessage *messages;
+    size_t groupsSize;
+    ReplayGroup *groups;
+    ReplayGroup all; /* All messages in the order of the corpus */
+    size_t skipped;
+} ReplayCorpus;
+
+typedef struct {
+    UA_SecureChannel channel;
+    UA_SecurityPolicy policy;
+    const UA_DataType *decodedType; /* Set in the message callback */
+    UA_ByteString *capture;         /* Copy the message body if set */
+} ReplayChannel;
+
+typedef struct {
+    pthread_t thread;
+    const ReplayGroup *group;
+    UA_Boolean decodeOnly;
+    size_t offset;     /* Start index in the group */
+    size_t count;      /* Number of replayed messages */
+    size_t bytes;      /* Replayed bytes */
+    size_t errors;
+    UA_UInt64 startNs;
+    UA_UInt64 endNs;
+} ReplayThread;
+
+typedef struct {
+    char name[REPLAY_TYPENAME_LENGTH + 16];
+    size_t corpusMessages;
+    size_t messages;
+    size_t bytes;
+    size_t errors;
+    double seconds;
+} ReplayResult;
+
+static UA_Logger *logger;
+static size_t messagesPerThread = 20000;
+
+static UA_UInt64
+nowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (UA_UInt64)ts.tv_sec * 1000000000u + (UA_UInt64)ts.tv_nsec;
+}
+
+static UA_UInt32
+readUInt32(const UA_Byte *p) {
+    return (UA_UInt32)p[0] | ((UA_UInt32)p[1] << 8) |
+        ((UA_UInt32)p[2] << 16) | ((UA_UInt32)p[3] << 24);
+}
+
+static void
+typeName(const UA_DataType *type, char *out) {
+#ifdef UA_ENABLE_TYPEDESCRIPTION
+    snprintf(out, REPLAY_TYPENAME_LENGTH, "%s", type->typeName);
+#else
+    snprintf(out, REPLAY_TYPENAME_LENGTH, "i=%u",
+             (unsigned)type->binaryEncodingId.identifier.numeric);
+#endif
+}
+
+/***********/
+/* Channel */
+/***********/
+
+/* Decode the request like the server does in processMSG */
+static UA_StatusCode
+decodeRequest(const UA_ByteString *message, size_t messageSegments,
+              const UA_DataType **outType) {
+    size_t offset = 0;
+    UA_NodeId typeId;
+    UA_StatusCode res = UA_decodeBinarySegments(message, messageSegments, &offset,
+                                                &typeId, &UA_TYPES[UA_TYPES_NODEID],
+                                                NULL);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    const UA_DataType *type = UA_findDataTypeByBinary(&typeId);
+    UA_NodeId_clear(&typeId);
+    if(!type)
+        return UA_STATUSCODE_BADDECODINGERROR;
+
+    union {
+        UA_ReadRequest read; /* Aligned storage for the request */
+        UA_Byte bytes[1024];
+    } request;
+    if(type->memSize > sizeof(request))
+        return UA_STATUSCODE_BADDECODINGERROR;
+    res = UA_decodeBinarySegments(message, messageSegments, &offset,
+                                  &request, type, NULL);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    UA_clear(&request, type);
+    *outType = type;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+replayCallback(void *application, UA_SecureChannel *channel,
+               UA_MessageType messageType, UA_UInt32 requestId,
+               const UA_ByteString *message, size_t messageSegments) {
+    (void)channel;
+    (void)messageType;
+    (void)requestId;
+    ReplayChannel *rc = (ReplayChannel*)application;
+    UA_StatusCode res = decodeRequest(message, messageSegments, &rc->decodedType);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    /* Keep the body for the decode-only phase */
+    if(rc->capture) {
+        size_t length = 0;
+        for(size_t i = 0; i < messageSegments; i++)
+            length += message[i].length;
+        res = UA_ByteString_allocBuffer(rc->capture, length);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+        length = 0;
+        for(size_t i = 0; i < messageSegments; i++) {
+            memcpy(&rc->capture->data[length], message[i].data, message[i].length);
+            length += message[i].length;
+        }
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+ReplayChannel_init(ReplayChannel *rc) {
+    memset(rc, 0, sizeof(ReplayChannel));
+    UA_StatusCode res = UA_SecurityPolicy_None(&rc->policy, UA_BYTESTRING_NULL, logger);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    UA_SecureChannel_init(&rc->channel);
+    rc->channel.config = UA_ConnectionConfig_default;
+    UA_ByteString remoteCertificate = UA_BYTESTRING_NULL;
+    res = UA_SecureChannel_setSecurityPolicy(&rc->channel, &rc->policy,
+                                             &remoteCertificate);
+    if(res != UA_STATUSCODE_GOOD) {
+        rc->policy.clear(&rc->policy);
+        return res;
+    }
+    rc->channel.state = UA_SECURECHANNELSTATE_OPEN;
+    rc->channel.securityMode = UA_MESSAGESECURITYMODE_NONE;
+    rc->channel.securityToken.createdAt = UA_DateTime_nowMonotonic();
+    rc->channel.securityToken.revisedLifetime = 3600000; /* 1h */
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+ReplayChannel_clear(ReplayChannel *rc) {
+    UA_SecureChannel_clear(&rc->channel);
+    rc->policy.clear(&rc->policy);
+}
+
+static UA_StatusCode
+ReplayChannel_process(ReplayChannel *rc, const ReplayMessage *m) {
+    UA_SecureChannel *channel = &rc->channel;
+    channel->securityToken.channelId = m->channelId;
+    channel->securityToken.tokenId = m->tokenId;
+    channel->receiveSequenceNumber = m->sequenceNumber - 1;
+    rc->decodedType = NULL;
+    UA_StatusCode res =
+        UA_SecureChannel_processBuffer(channel, rc, replayCallback, &m->chunks,
+                                       UA_DateTime_nowMonotonic());
+    if(res == UA_STATUSCODE_GOOD && !rc->decodedType)
+        res = UA_STATUSCODE_BADDECODINGERROR; /* Incomplete message */
+    if(res != UA_STATUSCODE_GOOD) {
+        /* Reset the channel after an error */
+        UA_SecureChannel_deleteBuffered(channel);
+        channel->state = UA_SECURECHANNELSTATE_OPEN;
+    }
+    return res;
+}
+
+static UA_StatusCode
+decodeBody(const ReplayMessage *m) {
+    const UA_DataType *type = NULL;
+    UA_StatusCode res = decodeRequest(&m->body, 1, &type);
+    if(res == UA_STATUSCODE_GOOD && type != m->type)
+        res = UA_STATUSCODE_BADDECODINGERROR;
+    return res;
+}
+
+/**********/
+/* Corpus */
+/**********/
+
+static ReplayGroup *
+getGroup(ReplayCorpus *corpus, const UA_DataType *type) {
+    for(size_t i = 0; i < corpus->groupsSize; i++) {
+        if(corpus->groups[i].type == type)
+            return &corpus->groups[i];
+    }
+    ReplayGroup *groups = (ReplayGroup*)
+        UA_realloc(corpus->groups, sizeof(ReplayGroup) * (corpus->groupsSize + 1));
+    if(!groups)
+        return NULL;
+    corpus->groups = groups;
+    ReplayGroup *g = &groups[corpus->groupsSize++];
+    memset(g, 0, sizeof(ReplayGroup));
+    g->type = type;
+    return g;
+}
+
+static UA_StatusCode
+addToGroup(ReplayGroup *g, ReplayMessage *m) {
+    ReplayMessage **messages = (ReplayMessage**)
+        UA_realloc(g->messages, sizeof(ReplayMessage*) * (g->messagesSize + 1));
+    if(!messages)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    g->messages = messages;
+    g->messages[g->messagesSize++] = m;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+addMessage(ReplayCorpus *corpus, UA_MessageType messageType,
+           const UA_Byte *data, size_t length) {
+    ReplayMessage *messages = (ReplayMessage*)
+        UA_realloc(corpus->messages, sizeof(ReplayMessage) * (corpus->messagesSize + 1));
+    if(!messages)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    corpus->messages = messages;
+    ReplayMessage *m = &messages[corpus->messagesSize];
+    memset(m, 0, sizeof(ReplayMessage));
+    m->messageType = messageType;
+    m->channelId = readUInt32(&data[8]);
+    if(messageType != UA_MESSAGETYPE_OPN) {
+        m->tokenId = readUInt32(&data[12]);
+        m->sequenceNumber = readUInt32(&data[16]);
+    }
+    UA_ByteString chunks = {length, (UA_Byte*)(uintptr_t)data};
+    UA_StatusCode res = UA_ByteString_copy(&chunks, &m->chunks);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    /* Process once to validate the message and capture the body */
+    ReplayChannel rc;
+    res = ReplayChannel_init(&rc);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_ByteString_clear(&m->chunks);
+        return res;
+    }
+    rc.capture = &m->body;
+    res = ReplayChannel_process(&rc, m);
+    m->type = rc.decodedType;
+    ReplayChannel_clear(&rc);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_ByteString_clear(&m->chunks);
+        UA_ByteString_clear(&m->body);
+        corpus->skipped++;
+        return UA_STATUSCODE_GOOD;
+    }
+    corpus->messagesSize++;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Split the file into messages. HEL/ACK/ERR are not replayed. */
+static UA_StatusCode
+addFile(ReplayCorpus *corpus, const UA_Byte *data, size_t length) {
+    if(length <= 4)
+        return UA_STATUSCODE_GOOD;
+    length -= 4; /* Memory limit of the fuzzer */
+
+    size_t pos = 0;
+    size_t messageStart = 0;
+    while(pos + UA_SECURECHANNEL_MESSAGE_MIN_LENGTH <= length) {
+        UA_UInt32 chunkSize = readUInt32(&data[pos + 4]);
+        if(chunkSize < UA_SECURECHANNEL_MESSAGE_MIN_LENGTH ||
+           chunkSize > length - pos)
+            break;
+        UA_UInt32 mt = readUInt32(&data[pos]) & REPLAY_MASK_MESSAGETYPE;
+        UA_UInt32 ct = readUInt32(&data[pos]) & REPLAY_MASK_CHUNKTYPE;
+        pos += chunkSize;
+        if(mt != UA_MESSAGETYPE_MSG && mt != UA_MESSAGETYPE_OPN &&
+           mt != UA_MESSAGETYPE_CLO) {
+            messageStart = pos;
+            continue;
+        }
+        if(ct == UA_CHUNKTYPE_INTERMEDIATE)
+            continue;
+        if(ct == UA_CHUNKTYPE_FINAL) {
+            UA_StatusCode res = addMessage(corpus, (UA_MessageType)mt,
+                                           &data[messageStart], pos - messageStart);
+            if(res != UA_STATUSCODE_GOOD)
+                return res;
+        }
+        messageStart = pos;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static int
+cmpNames(const void *a, const void *b) {
+    return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+static UA_StatusCode
+loadCorpus(ReplayCorpus *corpus, const char *dir) {
+    DIR *d = opendir(dir);
+    if(!d) {
+        fprintf(stderr, "Cannot open the corpus directory %s\n", dir);
+        return UA_STATUSCODE_BADNOTFOUND;
+    }
+
+    /* Sort the file names for a reproducible order */
+    size_t namesSize = 0;
+    char **names = NULL;
+    struct dirent *e;
+    while((e = readdir(d))) {
+        if(e->d_name[0] == '.')
+            continue;
+        char **n = (char**)UA_realloc(names, sizeof(char*) * (namesSize + 1));
+        if(!n)
+            break;
+        names = n;
+        size_t len = strlen(e->d_name);
+        names[namesSize] = (char*)UA_malloc(len + 1);
+        if(!names[namesSize])
+            break;
+        memcpy(names[namesSize++], e->d_name, len + 1);
+    }
+    closedir(d);
+    qsort(names, namesSize, sizeof(char*), cmpNames);
+
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    for(size_t i = 0; i < namesSize && res == UA_STATUSCODE_GOOD; i++) {
+        char path[1024];
+        snprintf(path, sizeof(path), "%s/%s", dir, names[i]);
+        FILE *f = fopen(path, "rb");
+        if(!f)
+            continue;
+        fseek(f, 0, SEEK_END);
+        long size = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        UA_ByteString buf = UA_BYTESTRING_NULL;
+        if(size > 0 &&
+           UA_ByteString_allocBuffer(&buf, (size_t)size) == UA_STATUSCODE_GOOD &&
+           fread(buf.data, 1, buf.length, f) == buf.length)
+            res = addFile(corpus, buf.data, buf.length);
+        UA_ByteString_clear(&buf);
+        fclose(f);
+    }
+    for(size_t i = 0; i < namesSize; i++)
+        UA_free(names[i]);
+    UA_free(names);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    /* Group by the request type. The pointers into the messages array are
+     * stable from here on. */
+    for(size_t i = 0; i < corpus->messagesSize; i++) {
+        ReplayMessage *m = &corpus->messages[i];
+        ReplayGroup *g = getGroup(corpus, m->type);
+        if(!g)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        res |= addToGroup(g, m);
+        res |= addToGroup(&corpus->all, m);
+    }
+    return res;
+}
+
+static void
+clearCorpus(ReplayCorpus *corpus) {
+    for(size_t i = 0; i < corpus->messagesSize; i++) {
+        UA_ByteString_clear(&corpus->messages[i].chunks);
+        UA_ByteString_clear(&corpus->messages[i].body);
+    }
+    for(size_t i = 0; i < corpus->groupsSize; i++)
+        UA_free(corpus->groups[i].messages);
+    UA_free(corpus->all.messages);
+    UA_free(corpus->groups);
+    UA_free(corpus->messages);
+}
+
+/**********/
+/* Replay */
+/**********/
+
+static void *
+replayThread(void *data) {
+    ReplayThread *t = (ReplayThread*)data;
+    const ReplayGroup *g = t->group;
+    ReplayChannel rc;
+    if(!t->decodeOnly && ReplayChannel_init(&rc) != UA_STATUSCODE_GOOD) {
+        t->errors = messagesPerThread;
+        return NULL;
+    }
+
+    size_t pos = t->offset % g->messagesSize;
+    t->startNs = nowNs();
+    for(size_t i = 0; i < messagesPerThread; i++) {
+        const ReplayMessage *m = g->messages[pos];
+        UA_StatusCode res;
+        if(t->decodeOnly) {
+            res = decodeBody(m);
+            t->bytes += m->body.length;
+        } else {
+            res = ReplayChannel_process(&rc, m);
+            t->bytes += m->chunks.length;
+        }
+        if(res != UA_STATUSCODE_GOOD)
+            t->errors++;
+        t->count++;
+        if(++pos == g->messagesSize)
+            pos = 0;
+    }
+    t->endNs = nowNs();
+
+    if(!t->decodeOnly)
+        ReplayChannel_clear(&rc);
+    return NULL;
+}
+
+/* The throughput is computed over the wall time from the start of the first
+ * to the end of the last thread */
+static void
+replayGroup(const ReplayGroup *g, const char *name, UA_Boolean decodeOnly,
+            size_t threadsSize, ReplayResult *result) {
+    ReplayThread threads[REPLAY_MAXTHREADS];
+    memset(threads, 0, sizeof(ReplayThread) * threadsSize);
+    for(size_t i = 0; i < threadsSize; i++) {
+        threads[i].group = g;
+        threads[i].decodeOnly = decodeOnly;
+        threads[i].offset = i * (g->messagesSize / threadsSize + 1);
+        if(pthread_create(&threads[i].thread, NULL, replayThread, &threads[i]) != 0) {
+            fprintf(stderr, "Cannot start the replay thread\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    memset(result, 0, sizeof(ReplayResult));
+    snprintf(result->name, sizeof(result->name), "%s/%s",
+             decodeOnly ? "decode" : "process", name);
+    result->corpusMessages = g->messagesSize;
+    UA_UInt64 start = UA_UINT64_MAX;
+    UA_UInt64 end = 0;
+    for(size_t i = 0; i < threadsSize; i++) {
+        pthread_join(threads[i].thread, NULL);
+        result->messages += threads[i].count;
+        result->bytes += threads[i].bytes;
+        result->errors += threads[i].errors;
+        if(threads[i].startNs < start)
+            start = threads[i].startNs;
+        if(threads[i].endNs > end)
+            end = threads[i].endNs;
+    }
+    result->seconds = (double)(end - start) / 1e9;
+}
+
+static void
+printResult(const ReplayResult *r) {
+    printf("%-48s %6lu %14.0f %14.2f %8lu\n", r->name,
+           (unsigned long)r->corpusMessages, (double)r->messages / r->seconds,
+           (double)r->bytes / r->seconds / 1e6, (unsigned long)r->errors);
+    fflush(stdout);
+}
+
+static void
+writeJson(FILE *f, size_t threadsSize, const ReplayCorpus *corpus,
+          const ReplayResult *results, size_t resultsSize) {
+    fprintf(f, "{\n");
+    fprintf(f, "  \"version\": \"%s\",\n", UA_OPEN62541_VER_COMMIT);
+    fprintf(f, "  \"threads\": %lu,\n", (unsigned long)threadsSize);
+    fprintf(f, "  \"messages_per_thread\": %lu,\n", (unsigned long)messagesPerThread);
+    fprintf(f, "  \"corpus_messages\": %lu,\n", (unsigned long)corpus->messagesSize);
+    fprintf(f, "  \"skipped_messages\": %lu,\n", (unsigned long)corpus->skipped);
+    fprintf(f, "  \"results\": [");
+    for(size_t i = 0; i < resultsSize; i++) {
+        const ReplayResult *r = &results[i];
+        fprintf(f, "%s\n    {\"name\": \"%s\", \"corpus_messages\": %lu, "
+                "\"messages\": %lu, \"bytes\": %lu, \"errors\": %lu, "
+                "\"seconds\": %.6f, \"messages_per_sec\": %.1f, "
+                "\"bytes_per_sec\": %.1f}",
+                (i > 0) ? "," : "", r->name, (unsigned long)r->corpusMessages,
+                (unsigned long)r->messages, (unsigned long)r->bytes,
+                (unsigned long)r->errors, r->seconds,
+                (double)r->messages / r->seconds, (double)r->bytes / r->seconds);
+    }
+    fprintf(f, "\n  ]\n}\n");
+}
+
+static void
+usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [-c <corpus dir>] [-t <threads>] [-n <messages>] "
+            "[-o <file.json>]\n"
+            "  -c  Directory with the binary message corpus\n"
+            "      (default " UA_CORPUS_DIR ")\n"
+            "  -t  Number of replay threads (default 1)\n"
+            "  -n  Messages replayed per thread and message type (default 20000)\n"
+            "  -o  Write the results as JSON\n", prog);
+}
+
+int main(int argc, char **argv) {
+    const char *dir = UA_CORPUS_DIR;
+    const char *output = NULL;
+    size_t threadsSize = 1;
+    for(int i = 1; i < argc; i++) {
+        if(i + 1 >= argc || argv[i][0] != '-' || strlen(argv[i]) != 2) {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        const char *val = argv[++i];
+        switch(argv[i-1][1]) {
+        case 'c': dir = val; break;
+        case 't': threadsSize = (size_t)strtoul(val, NULL, 10); break;
+        case 'n': messagesPerThread = (size_t)strtoul(val, NULL, 10); break;
+        case 'o': output = val; break;
+        default: usage(argv[0]); return EXIT_FAILURE;
+        }
+    }
+    if(threadsSize == 0 || threadsSize > REPLAY_MAXTHREADS || messagesPerThread == 0) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    /* Messages from the corpus that are rejected are not logged */
+    logger = UA_Log_Stdout_new(UA_LOGLEVEL_FATAL);
+
+    ReplayCorpus corpus;
+    memset(&corpus, 0, sizeof(ReplayCorpus));
+    UA_StatusCode res = loadCorpus(&corpus, dir);
+    if(res != UA_STATUSCODE_GOOD || corpus.messagesSize == 0) {
+        fprintf(stderr, "No messages loaded from %s\n", dir);
+        clearCorpus(&corpus);
+        logger->clear(logger);
+        return EXIT_FAILURE;
+    }
+    printf("Replaying %lu messages (%lu skipped) on %lu threads\n",
+           (unsigned long)corpus.messagesSize, (unsigned long)corpus.skipped,
+           (unsigned long)threadsSize);
+    printf("%-48s %6s %14s %14s %8s\n", "benchmark", "corpus",
+           "msgs/s", "MB/s", "errors");
+
+    size_t resultsSize = 2 * (corpus.groupsSize + 1);
+    ReplayResult *results = (ReplayResult*)UA_calloc(resultsSize, sizeof(ReplayResult));
+    if(!results) {
+        clearCorpus(&corpus);
+        logger->clear(logger);
+        return EXIT_FAILURE;
+    }
+
+    char name[REPLAY_TYPENAME_LENGTH];
+    size_t r = 0;
+    for(size_t i = 0; i < corpus.groupsSize; i++) {
+        typeName(corpus.groups[i].type, name);
+        replayGroup(&corpus.groups[i], name, false, threadsSize, &results[r]);
+        printResult(&results[r++]);
+        replayGroup(&corpus.groups[i], name, true, threadsSize, &results[r]);
+        printResult(&results[r++]);
+    }
+    replayGroup(&corpus.all, "all", false, threadsSize, &results[r]);
+    printResult(&results[r++]);
+    replayGroup(&corpus.all, "all", true, threadsSize, &results[r]);
+    printResult(&results[r++]);
+
+    int ret = EXIT_SUCCESS;
+    for(size_t i = 0; i < resultsSize; i++) {
+        if(results[i].errors > 0)
+            ret = EXIT_FAILURE; /* The corpus replayed fine in the first pass */
+    }
+    if(output) {
+        FILE *f = fopen(output, "w");
+        if(f) {
+            writeJson(f, threadsSize, &corpus, results, resultsSize);
+            fclose(f);
+        } else {
+            fprintf(stderr, "Cannot open %s\n", output);
+            ret = EXIT_FAILURE;
+        }
+    }
+
+    UA_free(results);
+    clearCorpus(&corpus);
+    logger->clear(logger);
+    return ret;
+}
@@ -0,0 +1,196 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/types.h>
+
+#include "ua_benchmark.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Binary encoding and decoding of common service messages. Every message is
+ * encoded once to get the buffer for the decoding benchmark. The encoding
+ * benchmark reuses a preallocated buffer. The decoding benchmark includes
+ * freeing the decoded message. */
+
+typedef struct {
+    const void *msg;
+    const UA_DataType *type;
+    UA_ByteString encoded;
+    UA_ByteString buf;
+    void *decoded;
+} EncodingContext;
+
+static void
+encodeMessage(void *context) {
+    EncodingContext *ctx = (EncodingContext*)context;
+    UA_ByteString out = ctx->buf;
+    UA_StatusCode res = UA_encodeBinary(ctx->msg, ctx->type, &out);
+    if(res != UA_STATUSCODE_GOOD)
+        abort();
+}
+
+static void
+decodeMessage(void *context) {
+    EncodingContext *ctx = (EncodingContext*)context;
+    UA_StatusCode res = UA_decodeBinary(&ctx->encoded, ctx->decoded, ctx->type, NULL);
+    if(res != UA_STATUSCODE_GOOD)
+        abort();
+    UA_clear(ctx->decoded, ctx->type);
+}
+
+static void
+calcSizeMessage(void *context) {
+    EncodingContext *ctx = (EncodingContext*)context;
+    if(UA_calcSizeBinary(ctx->msg, ctx->type) == 0)
+        abort();
+}
+
+static void
+benchmarkMessage(UA_Benchmark *b, const char *typeName, size_t n,
+                 size_t iterations, const void *msg, const UA_DataType *type) {
+    EncodingContext ctx;
+    ctx.msg = msg;
+    ctx.type = type;
+    UA_ByteString_init(&ctx.encoded);
+    if(UA_encodeBinary(msg, type, &ctx.encoded) != UA_STATUSCODE_GOOD ||
+       UA_ByteString_allocBuffer(&ctx.buf, ctx.encoded.length) != UA_STATUSCODE_GOOD)
+        abort();
+    ctx.decoded = UA_new(type);
+
+    char name[128];
+    snprintf(name, sizeof(name), "encoding/%s/encode", typeName);
+    UA_Benchmark_run(b, name, n, iterations, 1, encodeMessage, &ctx);
+    snprintf(name, sizeof(name), "encoding/%s/decode", typeName);
+    UA_Benchmark_run(b, name, n, iterations, 1, decodeMessage, &ctx);
+    snprintf(name, sizeof(name), "encoding/%s/calcsize", typeName);
+    UA_Benchmark_run(b, name, n, iterations, 1, calcSizeMessage, &ctx);
+
+    UA_delete(ctx.decoded, type);
+    UA_ByteString_clear(&ctx.buf);
+    UA_ByteString_clear(&ctx.encoded);
+}
+
+#define MSG_ITEMS 100
+#define ARRAY_LENGTH 1000
+
+static void
+benchmarkReadRequest(UA_Benchmark *b) {
+    UA_ReadRequest req;
+    UA_ReadRequest_init(&req);
+    req.timestampsToReturn = UA_TIMESTAMPSTORETURN_BOTH;
+    req.nodesToRead = (UA_ReadValueId*)
+        UA_Array_new(MSG_ITEMS, &UA_TYPES[UA_TYPES_READVALUEID]);
+    req.nodesToReadSize = MSG_ITEMS;
+    for(size_t i = 0; i < MSG_ITEMS; i++) {
+        req.nodesToRead[i].nodeId = UA_NODEID_NUMERIC(1, (UA_UInt32)(50000 + i));
+        req.nodesToRead[i].attributeId = UA_ATTRIBUTEID_VALUE;
+    }
+    benchmarkMessage(b, "ReadRequest", MSG_ITEMS, 10000, &req,
+                     &UA_TYPES[UA_TYPES_READREQUEST]);
+    UA_ReadRequest_clear(&req);
+}
+
+static void
+benchmarkReadResponse(UA_Benchmark *b) {
+    UA_ReadResponse resp;
+    UA_ReadResponse_init(&resp);
+    resp.results = (UA_DataValue*)
+        UA_Array_new(MSG_ITEMS, &UA_TYPES[UA_TYPES_DATAVALUE]);
+    resp.resultsSize = MSG_ITEMS;
+    for(size_t i = 0; i < MSG_ITEMS; i++) {
+        UA_Double d = (UA_Double)i * 0.5;
+        UA_Variant_setScalarCopy(&resp.results[i].value, &d, &UA_TYPES[UA_TYPES_DOUBLE]);
+        resp.results[i].hasValue = true;
+        resp.results[i].sourceTimestamp = UA_DATETIME_UNIX_EPOCH + (UA_DateTime)i;
+        resp.results[i].hasSourceTimestamp = true;
+        resp.results[i].serverTimestamp = UA_DATETIME_UNIX_EPOCH + (UA_DateTime)i;
+        resp.results[i].hasServerTimestamp = true;
+    }
+    benchmarkMessage(b, "ReadResponse", MSG_ITEMS, 10000, &resp,
+                     &UA_TYPES[UA_TYPES_READRESPONSE]);
+    UA_ReadResponse_clear(&resp);
+}
+
+static void
+benchmarkBrowseResponse(UA_Benchmark *b) {
+    UA_BrowseResponse resp;
+    UA_BrowseResponse_init(&resp);
+    resp.results = UA_BrowseResult_new();
+    resp.resultsSize = 1;
+    UA_BrowseResult *br = resp.results;
+    br->references = (UA_ReferenceDescription*)
+        UA_Array_new(MSG_ITEMS, &UA_TYPES[UA_TYPES_REFERENCEDESCRIPTION]);
+    br->referencesSize = MSG_ITEMS;
+    for(size_t i = 0; i < MSG_ITEMS; i++) {
+        char nameBuf[32];
+        snprintf(nameBuf, sizeof(nameBuf), "Variable %u", (unsigned)i);
+        UA_ReferenceDescription *rd = &br->references[i];
+        rd->referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+        rd->isForward = true;
+        rd->nodeId.nodeId = UA_NODEID_STRING_ALLOC(1, nameBuf);
+        rd->browseName = UA_QUALIFIEDNAME_ALLOC(1, nameBuf);
+        rd->displayName = UA_LOCALIZEDTEXT_ALLOC("en-US", nameBuf);
+        rd->nodeClass = UA_NODECLASS_VARIABLE;
+        rd->typeDefinition.nodeId =
+            UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE);
+    }
+    benchmarkMessage(b, "BrowseResponse", MSG_ITEMS, 5000, &resp,
+                     &UA_TYPES[UA_TYPES_BROWSERESPONSE]);
+    UA_BrowseResponse_clear(&resp);
+}
+
+static void
+benchmarkPublishResponse(UA_Benchmark *b) {
+    UA_DataChangeNotification *dcn = UA_DataChangeNotification_new();
+    dcn->monitoredItems = (UA_MonitoredItemNotification*)
+        UA_Array_new(MSG_ITEMS, &UA_TYPES[UA_TYPES_MONITOREDITEMNOTIFICATION]);
+    dcn->monitoredItemsSize = MSG_ITEMS;
+    for(size_t i = 0; i < MSG_ITEMS; i++) {
+        UA_MonitoredItemNotification *min = &dcn->monitoredItems[i];
+        min->clientHandle = (UA_UInt32)i;
+        UA_Int32 v = (UA_Int32)i;
+        UA_Variant_setScalarCopy(&min->value.value, &v, &UA_TYPES[UA_TYPES_INT32]);
+        min->value.hasValue = true;
+        min->value.sourceTimestamp = UA_DATETIME_UNIX_EPOCH + (UA_DateTime)i;
+        min->value.hasSourceTimestamp = true;
+    }
+
+    UA_PublishResponse resp;
+    UA_PublishResponse_init(&resp);
+    resp.subscriptionId = 1;
+    resp.notificationMessage.sequenceNumber = 1;
+    resp.notificationMessage.publishTime = UA_DATETIME_UNIX_EPOCH;
+    resp.notificationMessage.notificationData = UA_ExtensionObject_new();
+    resp.notificationMessage.notificationDataSize = 1;
+    UA_ExtensionObject_setValue(resp.notificationMessage.notificationData, dcn,
+                                &UA_TYPES[UA_TYPES_DATACHANGENOTIFICATION]);
+    benchmarkMessage(b, "PublishResponse", MSG_ITEMS, 10000, &resp,
+                     &UA_TYPES[UA_TYPES_PUBLISHRESPONSE]);
+    UA_PublishResponse_clear(&resp);
+}
+
+static void
+benchmarkVariantArray(UA_Benchmark *b) {
+    UA_Double *arr = (UA_Double*)
+        UA_Array_new(ARRAY_LENGTH, &UA_TYPES[UA_TYPES_DOUBLE]);
+    for(size_t i = 0; i < ARRAY_LENGTH; i++)
+        arr[i] = (UA_Double)i * 0.25;
+    UA_Variant v;
+    UA_Variant_setArray(&v, arr, ARRAY_LENGTH, &UA_TYPES[UA_TYPES_DOUBLE]);
+    benchmarkMessage(b, "Variant/DoubleArray", ARRAY_LENGTH, 20000, &v,
+                     &UA_TYPES[UA_TYPES_VARIANT]);
+    UA_Variant_clear(&v);
+}
+
+void
+UA_Benchmark_encoding(UA_Benchmark *b) {
+    if(!UA_Benchmark_enabled(b, "encoding/"))
+        return;
+    benchmarkReadRequest(b);
+    benchmarkReadResponse(b);
+    benchmarkBrowseResponse(b);
+    benchmarkPublishResponse(b);
+    benchmarkVariantArray(b);
+}
@@ -0,0 +1,179 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/server_pubsub.h>
+
+#include "server/ua_server_internal.h"
+#include "ua_pubsub.h"
+
+#include "ua_benchmark.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* The cycle time of a PubSub publisher with N fields. Every iteration runs the
+ * publish callback of the WriterGroup once. This includes the sampling of the
+ * fields, the encoding of the NetworkMessage and sending it over UDP.
+ *
+ * With UA_PUBSUB_RT_NONE, the fields are read from variables in the
+ * information model and the message is encoded from scratch. With
+ * UA_PUBSUB_RT_FIXED_SIZE, the fields point to static values and the message
+ * buffer is prepared once and only updated at the offsets of the fields. */
+
+#ifdef UA_ENABLE_PUBSUB
+
+#define PUBSUB_FIELDS 64
+#define PUBSUB_CYCLES 20000
+
+typedef struct {
+    UA_Server *server;
+    UA_PubSubManager *psm;
+    UA_WriterGroup *wg;
+    UA_UInt32 values[PUBSUB_FIELDS];
+    UA_DataValue *staticValues[PUBSUB_FIELDS];
+} PubSubContext;
+
+static void
+publishCycle(void *context) {
+    PubSubContext *ctx = (PubSubContext*)context;
+    ctx->values[0]++;
+    UA_WriterGroup_publishCallback(ctx->psm, ctx->wg);
+}
+
+static void
+benchmarkWriterGroup(UA_Benchmark *b, const char *name,
+                     UA_PubSubRTLevel rtLevel, size_t n) {
+    if(!UA_Benchmark_enabled(b, name))
+        return;
+
+    PubSubContext ctx;
+    memset(&ctx, 0, sizeof(PubSubContext));
+    ctx.server = UA_Benchmark_newServer();
+    if(!ctx.server)
+        abort();
+    UA_StatusCode res = UA_Server_run_startup(ctx.server);
+
+    UA_PubSubConnectionConfig connectionConfig;
+    memset(&connectionConfig, 0, sizeof(UA_PubSubConnectionConfig));
+    connectionConfig.name = UA_STRING("UADP Connection");
+    UA_NetworkAddressUrlDataType networkAddressUrl =
+        {UA_STRING_NULL, UA_STRING("opc.udp://224.0.0.22:4840/")};
+    UA_Variant_setScalar(&connectionConfig.address, &networkAddressUrl,
+                         &UA_TYPES[UA_TYPES_NETWORKADDRESSURLDATATYPE]);
+    connectionConfig.transportProfileUri =
+        UA_STRING("http://opcfoundation.org/UA-Profile/Transport/pubsub-udp-uadp");
+    connectionConfig.publisherId.idType = UA_PUBLISHERIDTYPE_UINT16;
+    connectionConfig.publisherId.id.uint16 = 2234;
+    UA_NodeId connectionId, pdsId, wgId, dswId;
+    res |= UA_Server_addPubSubConnection(ctx.server, &connectionConfig, &connectionId);
+
+    UA_PublishedDataSetConfig pdsConfig;
+    memset(&pdsConfig, 0, sizeof(UA_PublishedDataSetConfig));
+    pdsConfig.publishedDataSetType = UA_PUBSUB_DATASET_PUBLISHEDITEMS;
+    pdsConfig.name = UA_STRING("PublishedDataSet");
+    res |= UA_Server_addPublishedDataSet(ctx.server, &pdsConfig, &pdsId).addResult;
+
+    /* Add the fields */
+    for(size_t i = 0; i < n; i++) {
+        UA_DataSetFieldConfig dsfConfig;
+        memset(&dsfConfig, 0, sizeof(UA_DataSetFieldConfig));
+        dsfConfig.dataSetFieldType = UA_PUBSUB_DATASETFIELD_VARIABLE;
+        dsfConfig.field.variable.publishParameters.attributeId = UA_ATTRIBUTEID_VALUE;
+        if(rtLevel == UA_PUBSUB_RT_FIXED_SIZE) {
+            ctx.staticValues[i] = UA_DataValue_new();
+            UA_Variant_setScalar(&ctx.staticValues[i]->value, &ctx.values[i],
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+            ctx.staticValues[i]->value.storageType = UA_VARIANT_DATA_NODELETE;
+            ctx.staticValues[i]->hasValue = true;
+            dsfConfig.field.variable.rtValueSource.rtFieldSourceEnabled = true;
+            dsfConfig.field.variable.rtValueSource.staticValueSource =
+                &ctx.staticValues[i];
+        } else {
+            char varName[32];
+            snprintf(varName, sizeof(varName), "Field %u", (unsigned)i);
+            UA_VariableAttributes attr = UA_VariableAttributes_default;
+            UA_Variant_setScalar(&attr.value, &ctx.values[i],
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+            UA_NodeId varId = UA_NODEID_NUMERIC(1, (UA_UInt32)(50000 + i));
+            res |= UA_Server_addVariableNode(ctx.server, varId,
+                                             UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                             UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                             UA_QUALIFIEDNAME(1, varName),
+                                             UA_NODEID_NULL, attr, NULL, NULL);
+            dsfConfig.field.variable.publishParameters.publishedVariable = varId;
+        }
+        res |= UA_Server_addDataSetField(ctx.server, pdsId, &dsfConfig, NULL).result;
+    }
+
+    /* Add the WriterGroup */
+    UA_WriterGroupConfig wgConfig;
+    memset(&wgConfig, 0, sizeof(UA_WriterGroupConfig));
+    wgConfig.name = UA_STRING("WriterGroup");
+    wgConfig.publishingInterval = 100;
+    wgConfig.writerGroupId = 100;
+    wgConfig.rtLevel = rtLevel;
+    wgConfig.encodingMimeType = UA_PUBSUB_ENCODING_UADP;
+    UA_UadpWriterGroupMessageDataType wgm;
+    UA_UadpWriterGroupMessageDataType_init(&wgm);
+    wgm.networkMessageContentMask = (UA_UadpNetworkMessageContentMask)
+        (UA_UADPNETWORKMESSAGECONTENTMASK_PUBLISHERID |
+         UA_UADPNETWORKMESSAGECONTENTMASK_GROUPHEADER |
+         UA_UADPNETWORKMESSAGECONTENTMASK_WRITERGROUPID |
+         UA_UADPNETWORKMESSAGECONTENTMASK_PAYLOADHEADER);
+    wgConfig.messageSettings.encoding = UA_EXTENSIONOBJECT_DECODED;
+    wgConfig.messageSettings.content.decoded.type =
+        &UA_TYPES[UA_TYPES_UADPWRITERGROUPMESSAGEDATATYPE];
+    wgConfig.messageSettings.content.decoded.data = &wgm;
+    res |= UA_Server_addWriterGroup(ctx.server, connectionId, &wgConfig, &wgId);
+
+    UA_DataSetWriterConfig dswConfig;
+    memset(&dswConfig, 0, sizeof(UA_DataSetWriterConfig));
+    dswConfig.name = UA_STRING("DataSetWriter");
+    dswConfig.dataSetWriterId = 62541;
+    dswConfig.keyFrameCount = 10;
+    res |= UA_Server_addDataSetWriter(ctx.server, wgId, pdsId, &dswConfig, &dswId);
+    res |= UA_Server_enableAllPubSubComponents(ctx.server);
+    if(res != UA_STATUSCODE_GOOD) {
+        fprintf(stderr, "%s: PubSub configuration failed with %s\n",
+                name, UA_StatusCode_name(res));
+        abort();
+    }
+
+    /* Let the connection open its sockets */
+    for(size_t i = 0; i < 10; i++)
+        UA_Server_run_iterate(ctx.server, false);
+
+    ctx.psm = getPSM(ctx.server);
+    ctx.wg = UA_WriterGroup_find(ctx.psm, wgId);
+    if(!ctx.wg)
+        abort();
+    UA_Benchmark_run(b, name, n, PUBSUB_CYCLES, 1, publishCycle, &ctx);
+
+    UA_Server_run_shutdown(ctx.server);
+    UA_Server_delete(ctx.server);
+    for(size_t i = 0; i < n; i++) {
+        if(ctx.staticValues[i])
+            UA_DataValue_delete(ctx.staticValues[i]);
+    }
+}
+
+void
+UA_Benchmark_pubsub(UA_Benchmark *b) {
+    if(!UA_Benchmark_enabled(b, "pubsub/"))
+        return;
+    const size_t sizes[3] = {1, 16, PUBSUB_FIELDS};
+    for(size_t i = 0; i < 3; i++)
+        benchmarkWriterGroup(b, "pubsub/publish/rt_none",
+                             UA_PUBSUB_RT_NONE, sizes[i]);
+    for(size_t i = 0; i < 3; i++)
+        benchmarkWriterGroup(b, "pubsub/publish/rt_fixed_size",
+                             UA_PUBSUB_RT_FIXED_SIZE, sizes[i]);
+}
+
+#else
+
+void
+UA_Benchmark_pubsub(UA_Benchmark *b) {}
+
+#endif /* UA_ENABLE_PUBSUB */
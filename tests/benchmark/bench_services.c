@@ -0,0 +1,163 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/server.h>
+
+#include "server/ua_server_internal.h"
+#include "server/ua_services.h"
+
+#include "ua_benchmark.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Read, Write and Browse services with N operations per request. The services
+ * are called directly with the admin session. This measures the service
+ * processing without the message encoding and the network. */
+
+#define SERVICE_NODES 1000
+#define SERVICE_OPS 100000 /* Operations per round */
+
+typedef struct {
+    UA_Server *server;
+    UA_ReadRequest readReq;
+    UA_WriteRequest writeReq;
+    UA_BrowseRequest browseReq;
+    UA_Int32 counter;
+} ServiceContext;
+
+static void
+readNodes(void *context) {
+    ServiceContext *ctx = (ServiceContext*)context;
+    UA_ReadResponse resp;
+    UA_ReadResponse_init(&resp);
+    UA_LOCK(&ctx->server->serviceMutex);
+    Service_Read(ctx->server, &ctx->server->adminSession, &ctx->readReq, &resp);
+    UA_UNLOCK(&ctx->server->serviceMutex);
+    if(resp.responseHeader.serviceResult != UA_STATUSCODE_GOOD ||
+       resp.results[0].status != UA_STATUSCODE_GOOD)
+        abort();
+    UA_ReadResponse_clear(&resp);
+}
+
+static void
+writeNodes(void *context) {
+    ServiceContext *ctx = (ServiceContext*)context;
+    ctx->counter++;
+    UA_WriteResponse resp;
+    UA_WriteResponse_init(&resp);
+    UA_LOCK(&ctx->server->serviceMutex);
+    Service_Write(ctx->server, &ctx->server->adminSession, &ctx->writeReq, &resp);
+    UA_UNLOCK(&ctx->server->serviceMutex);
+    if(resp.responseHeader.serviceResult != UA_STATUSCODE_GOOD ||
+       resp.results[0] != UA_STATUSCODE_GOOD)
+        abort();
+    UA_WriteResponse_clear(&resp);
+}
+
+static void
+browseNodes(void *context) {
+    ServiceContext *ctx = (ServiceContext*)context;
+    UA_BrowseResponse resp;
+    UA_BrowseResponse_init(&resp);
+    UA_LOCK(&ctx->server->serviceMutex);
+    Service_Browse(ctx->server, &ctx->server->adminSession, &ctx->browseReq, &resp);
+    UA_UNLOCK(&ctx->server->serviceMutex);
+    if(resp.responseHeader.serviceResult != UA_STATUSCODE_GOOD ||
+       resp.results[0].statusCode != UA_STATUSCODE_GOOD)
+        abort();
+    UA_BrowseResponse_clear(&resp);
+}
+
+static void
+addVariables(UA_Server *server, UA_NodeId *nodeIds) {
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    UA_Int32 value = 42;
+    UA_Variant_setScalar(&attr.value, &value, &UA_TYPES[UA_TYPES_INT32]);
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+    for(size_t i = 0; i < SERVICE_NODES; i++) {
+        char name[32];
+        snprintf(name, sizeof(name), "Variable %u", (unsigned)i);
+        UA_StatusCode res =
+            UA_Server_addVariableNode(server, UA_NODEID_NUMERIC(1, (UA_UInt32)(50000 + i)),
+                                      UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                      UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                      UA_QUALIFIEDNAME(1, name), UA_NODEID_NULL,
+                                      attr, NULL, &nodeIds[i]);
+        if(res != UA_STATUSCODE_GOOD)
+            abort();
+    }
+}
+
+static void
+benchmarkSize(UA_Benchmark *b, ServiceContext *ctx,
+              const UA_NodeId *nodeIds, size_t n) {
+    UA_ReadValueId *rvis = (UA_ReadValueId*)
+        UA_Array_new(n, &UA_TYPES[UA_TYPES_READVALUEID]);
+    UA_WriteValue *wvs = (UA_WriteValue*)
+        UA_Array_new(n, &UA_TYPES[UA_TYPES_WRITEVALUE]);
+    UA_BrowseDescription *bds = (UA_BrowseDescription*)
+        UA_Array_new(n, &UA_TYPES[UA_TYPES_BROWSEDESCRIPTION]);
+    if(!rvis || !wvs || !bds)
+        abort();
+
+    /* The values point to the counter. Not deleted with the WriteValues. */
+    for(size_t i = 0; i < n; i++) {
+        rvis[i].nodeId = nodeIds[i];
+        rvis[i].attributeId = UA_ATTRIBUTEID_VALUE;
+        wvs[i].nodeId = nodeIds[i];
+        wvs[i].attributeId = UA_ATTRIBUTEID_VALUE;
+        wvs[i].value.hasValue = true;
+        UA_Variant_setScalar(&wvs[i].value.value, &ctx->counter,
+                             &UA_TYPES[UA_TYPES_INT32]);
+        wvs[i].value.value.storageType = UA_VARIANT_DATA_NODELETE;
+        bds[i].nodeId = nodeIds[i];
+        bds[i].browseDirection = UA_BROWSEDIRECTION_BOTH;
+        bds[i].includeSubtypes = true;
+        bds[i].resultMask = UA_BROWSERESULTMASK_ALL;
+    }
+
+    UA_ReadRequest_init(&ctx->readReq);
+    ctx->readReq.timestampsToReturn = UA_TIMESTAMPSTORETURN_SOURCE;
+    ctx->readReq.nodesToRead = rvis;
+    ctx->readReq.nodesToReadSize = n;
+    UA_WriteRequest_init(&ctx->writeReq);
+    ctx->writeReq.nodesToWrite = wvs;
+    ctx->writeReq.nodesToWriteSize = n;
+    UA_BrowseRequest_init(&ctx->browseReq);
+    ctx->browseReq.nodesToBrowse = bds;
+    ctx->browseReq.nodesToBrowseSize = n;
+
+    size_t iterations = SERVICE_OPS / n;
+    UA_Benchmark_run(b, "services/read", n, iterations, n, readNodes, ctx);
+    UA_Benchmark_run(b, "services/write", n, iterations, n, writeNodes, ctx);
+    UA_Benchmark_run(b, "services/browse", n, iterations / 4, n, browseNodes, ctx);
+
+    UA_ReadRequest_clear(&ctx->readReq);
+    UA_WriteRequest_clear(&ctx->writeReq);
+    UA_BrowseRequest_clear(&ctx->browseReq);
+}
+
+void
+UA_Benchmark_services(UA_Benchmark *b) {
+    if(!UA_Benchmark_enabled(b, "services/"))
+        return;
+
+    ServiceContext ctx;
+    memset(&ctx, 0, sizeof(ServiceContext));
+    ctx.server = UA_Benchmark_newServer();
+    if(!ctx.server)
+        abort();
+
+    UA_NodeId nodeIds[SERVICE_NODES];
+    addVariables(ctx.server, nodeIds);
+
+    const size_t sizes[3] = {1, 100, SERVICE_NODES};
+    for(size_t i = 0; i < 3; i++)
+        benchmarkSize(b, &ctx, nodeIds, sizes[i]);
+
+    for(size_t i = 0; i < SERVICE_NODES; i++)
+        UA_NodeId_clear(&nodeIds[i]);
+    UA_Server_delete(ctx.server);
+}
@@ -0,0 +1,229 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+
+#include "server/ua_server_internal.h"
+#include "server/ua_services.h"
+#include "server/ua_subscription.h"
+#include "testing_networklayers.h"
+
+#include "ua_benchmark.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Publish throughput with N MonitoredItems in one Subscription. Every
+ * iteration writes all monitored variables. The MonitoredItems have a sampling
+ * interval of zero and sample on every write. Then a PublishRequest is
+ * processed. The PublishResponse with N notifications is encoded and sent over
+ * a SecureChannel whose ConnectionManager discards the messages. */
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+
+#define SUBSCRIPTION_NODES 1000
+#define SUBSCRIPTION_OPS 50000 /* Notifications per round */
+
+typedef struct {
+    UA_Server *server;
+    UA_SecureChannel channel;
+    UA_Session *session;
+    UA_Subscription *sub;
+    UA_WriteRequest writeReq;
+    UA_PublishRequest pubReq;
+    UA_SubscriptionAcknowledgement ack;
+    UA_UInt32 requestId;
+    UA_Int32 counter;
+} SubscriptionContext;
+
+static void
+writeValues(SubscriptionContext *ctx) {
+    ctx->counter++;
+    UA_WriteResponse resp;
+    UA_WriteResponse_init(&resp);
+    Service_Write(ctx->server, &ctx->server->adminSession, &ctx->writeReq, &resp);
+    if(resp.responseHeader.serviceResult != UA_STATUSCODE_GOOD)
+        abort();
+    UA_WriteResponse_clear(&resp);
+}
+
+static void
+writeAndSample(void *context) {
+    SubscriptionContext *ctx = (SubscriptionContext*)context;
+    UA_LOCK(&ctx->server->serviceMutex);
+    writeValues(ctx);
+    UA_UNLOCK(&ctx->server->serviceMutex);
+}
+
+static void
+writeAndPublish(void *context) {
+    SubscriptionContext *ctx = (SubscriptionContext*)context;
+    UA_Server *server = ctx->server;
+    UA_LOCK(&server->serviceMutex);
+    writeValues(ctx);
+
+    /* Acknowledge the last message to keep the retransmission queue short */
+    ctx->ack.sequenceNumber = ctx->sub->nextSequenceNumber - 1;
+    ctx->pubReq.subscriptionAcknowledgementsSize = (ctx->ack.sequenceNumber > 0) ? 1 : 0;
+    UA_StatusCode res = Service_Publish(server, ctx->session, &ctx->pubReq,
+                                        ++ctx->requestId);
+    if(res != UA_STATUSCODE_GOOD)
+        abort();
+
+    /* Publish unless the PublishRequest was already used for a late
+     * Subscription */
+    if(ctx->session->responseQueueSize > 0)
+        UA_Subscription_publish(server, ctx->sub);
+    UA_UNLOCK(&server->serviceMutex);
+}
+
+static void
+createSubscription(SubscriptionContext *ctx) {
+    UA_CreateSubscriptionRequest req;
+    UA_CreateSubscriptionRequest_init(&req);
+    req.publishingEnabled = true;
+    req.requestedPublishingInterval = 1000.0;
+    req.requestedLifetimeCount = UA_UINT32_MAX;
+    req.requestedMaxKeepAliveCount = 10;
+    req.maxNotificationsPerPublish = 0; /* unlimited */
+    UA_CreateSubscriptionResponse resp;
+    UA_CreateSubscriptionResponse_init(&resp);
+    Service_CreateSubscription(ctx->server, ctx->session, &req, &resp);
+    if(resp.responseHeader.serviceResult != UA_STATUSCODE_GOOD)
+        abort();
+    ctx->sub = UA_Session_getSubscriptionById(ctx->session, resp.subscriptionId);
+    ctx->ack.subscriptionId = resp.subscriptionId;
+    UA_CreateSubscriptionResponse_clear(&resp);
+}
+
+static void
+createMonitoredItems(SubscriptionContext *ctx, const UA_NodeId *nodeIds, size_t n) {
+    UA_MonitoredItemCreateRequest *items = (UA_MonitoredItemCreateRequest*)
+        UA_Array_new(n, &UA_TYPES[UA_TYPES_MONITOREDITEMCREATEREQUEST]);
+    if(!items)
+        abort();
+    for(size_t i = 0; i < n; i++) {
+        UA_NodeId_copy(&nodeIds[i], &items[i].itemToMonitor.nodeId);
+        items[i].itemToMonitor.attributeId = UA_ATTRIBUTEID_VALUE;
+        items[i].monitoringMode = UA_MONITORINGMODE_REPORTING;
+        items[i].requestedParameters.clientHandle = (UA_UInt32)i;
+        items[i].requestedParameters.samplingInterval = 0.0;
+        items[i].requestedParameters.queueSize = 1;
+        items[i].requestedParameters.discardOldest = true;
+    }
+    UA_CreateMonitoredItemsRequest req;
+    UA_CreateMonitoredItemsRequest_init(&req);
+    req.subscriptionId = ctx->sub->subscriptionId;
+    req.timestampsToReturn = UA_TIMESTAMPSTORETURN_SOURCE;
+    req.itemsToCreate = items;
+    req.itemsToCreateSize = n;
+    UA_CreateMonitoredItemsResponse resp;
+    UA_CreateMonitoredItemsResponse_init(&resp);
+    Service_CreateMonitoredItems(ctx->server, ctx->session, &req, &resp);
+    if(resp.responseHeader.serviceResult != UA_STATUSCODE_GOOD ||
+       resp.results[0].statusCode != UA_STATUSCODE_GOOD)
+        abort();
+    UA_CreateMonitoredItemsResponse_clear(&resp);
+    UA_CreateMonitoredItemsRequest_clear(&req);
+}
+
+static void
+benchmarkSize(UA_Benchmark *b, const UA_NodeId *nodeIds, size_t n) {
+    SubscriptionContext ctx;
+    memset(&ctx, 0, sizeof(SubscriptionContext));
+    ctx.server = UA_Benchmark_newServer();
+    if(!ctx.server)
+        abort();
+
+    /* Add the variables */
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    UA_Variant_setScalar(&attr.value, &ctx.counter, &UA_TYPES[UA_TYPES_INT32]);
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+    for(size_t i = 0; i < n; i++) {
+        char name[32];
+        snprintf(name, sizeof(name), "Variable %u", (unsigned)i);
+        UA_StatusCode res =
+            UA_Server_addVariableNode(ctx.server, nodeIds[i],
+                                      UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                      UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                      UA_QUALIFIEDNAME(1, name), UA_NODEID_NULL,
+                                      attr, NULL, NULL);
+        if(res != UA_STATUSCODE_GOOD)
+            abort();
+    }
+
+    /* Open a SecureChannel with the None SecurityPolicy. The messages are
+     * discarded by the testing ConnectionManager. */
+    UA_SecureChannel_init(&ctx.channel);
+    ctx.channel.config = UA_ConnectionConfig_default;
+    ctx.channel.connectionManager = &testConnectionManagerTCP;
+    ctx.channel.state = UA_SECURECHANNELSTATE_OPEN;
+    ctx.channel.securityMode = UA_MESSAGESECURITYMODE_NONE;
+    UA_ByteString remoteCertificate = UA_BYTESTRING_NULL;
+    UA_SecureChannel_setSecurityPolicy(&ctx.channel,
+                                       &ctx.server->config.securityPolicies[0],
+                                       &remoteCertificate);
+    testConnectionLastSentBuf = NULL;
+
+    UA_CreateSessionRequest sessionReq;
+    UA_CreateSessionRequest_init(&sessionReq);
+    sessionReq.requestedSessionTimeout = UA_UINT32_MAX;
+    UA_LOCK(&ctx.server->serviceMutex);
+    UA_StatusCode res = UA_Server_createSession(ctx.server, &ctx.channel,
+                                                &sessionReq, &ctx.session);
+    if(res != UA_STATUSCODE_GOOD)
+        abort();
+    createSubscription(&ctx);
+    createMonitoredItems(&ctx, nodeIds, n);
+    UA_UNLOCK(&ctx.server->serviceMutex);
+
+    /* Prepare the requests */
+    UA_WriteValue *wvs = (UA_WriteValue*)
+        UA_Array_new(n, &UA_TYPES[UA_TYPES_WRITEVALUE]);
+    if(!wvs)
+        abort();
+    for(size_t i = 0; i < n; i++) {
+        wvs[i].nodeId = nodeIds[i];
+        wvs[i].attributeId = UA_ATTRIBUTEID_VALUE;
+        wvs[i].value.hasValue = true;
+        UA_Variant_setScalar(&wvs[i].value.value, &ctx.counter,
+                             &UA_TYPES[UA_TYPES_INT32]);
+    }
+    ctx.writeReq.nodesToWrite = wvs;
+    ctx.writeReq.nodesToWriteSize = n;
+    ctx.pubReq.subscriptionAcknowledgements = &ctx.ack;
+
+    size_t iterations = SUBSCRIPTION_OPS / n;
+    UA_Benchmark_run(b, "subscriptions/sample", n, iterations, n,
+                     writeAndSample, &ctx);
+    UA_Benchmark_run(b, "subscriptions/publish", n, iterations, n,
+                     writeAndPublish, &ctx);
+
+    /* The NodeIds and values of the WriteValues are not owned */
+    UA_free(wvs);
+    UA_Server_delete(ctx.server);
+    UA_SecureChannel_clear(&ctx.channel);
+}
+
+void
+UA_Benchmark_subscriptions(UA_Benchmark *b) {
+    if(!UA_Benchmark_enabled(b, "subscriptions/"))
+        return;
+
+    UA_NodeId nodeIds[SUBSCRIPTION_NODES];
+    for(size_t i = 0; i < SUBSCRIPTION_NODES; i++)
+        nodeIds[i] = UA_NODEID_NUMERIC(1, (UA_UInt32)(50000 + i));
+
+    const size_t sizes[3] = {1, 100, SUBSCRIPTION_NODES};
+    for(size_t i = 0; i < 3; i++)
+        benchmarkSize(b, nodeIds, sizes[i]);
+}
+
+#else
+
+void
+UA_Benchmark_subscriptions(UA_Benchmark *b) {}
+
+#endif /* UA_ENABLE_SUBSCRIPTIONS */
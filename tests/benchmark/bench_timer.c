@@ -0,0 +1,128 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "eventloop_common/timer.h"
+#include "eventloop_common/timer_wheel.h"
+
+#include "ua_benchmark.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Adding, removing and processing N timers in the ziptree timer and in the
+ * timing wheel. The intervals are between 100ms and 1s (like the sampling
+ * intervals of MonitoredItems). Every process step advances the clock by
+ * 100ms. */
+
+#define TIMER_INTERVAL(i) ((UA_Double)((i % 10) + 1) * 100.0)
+#define TIMER_OPS 200000 /* Timers added per round */
+
+typedef struct {
+    size_t n;
+    UA_UInt64 *ids;
+    UA_DateTime now;
+    size_t count;
+    UA_Timer zt;
+    UA_TimerWheel wheel;
+} TimerContext;
+
+static void
+timerCallback(void *application, void *data) {
+    ((TimerContext*)application)->count++;
+}
+
+static void
+ziptreeAddRemove(void *context) {
+    TimerContext *ctx = (TimerContext*)context;
+    UA_Timer t;
+    UA_Timer_init(&t);
+    for(size_t i = 0; i < ctx->n; i++) {
+        if(UA_Timer_add(&t, timerCallback, ctx, NULL, TIMER_INTERVAL(i), 0, NULL,
+                        UA_TIMERPOLICY_CURRENTTIME, &ctx->ids[i]) != UA_STATUSCODE_GOOD)
+            abort();
+    }
+    for(size_t i = 0; i < ctx->n; i++)
+        UA_Timer_remove(&t, ctx->ids[i]);
+    UA_Timer_clear(&t);
+}
+
+static void
+ziptreeProcess(void *context) {
+    TimerContext *ctx = (TimerContext*)context;
+    ctx->now += 100 * UA_DATETIME_MSEC;
+    UA_Timer_process(&ctx->zt, ctx->now);
+}
+
+static void
+wheelAddRemove(void *context) {
+    TimerContext *ctx = (TimerContext*)context;
+    UA_TimerWheel t;
+    UA_TimerWheel_init(&t);
+    for(size_t i = 0; i < ctx->n; i++) {
+        if(UA_TimerWheel_add(&t, timerCallback, ctx, NULL, TIMER_INTERVAL(i), 0, NULL,
+                             UA_TIMERPOLICY_CURRENTTIME, &ctx->ids[i]) != UA_STATUSCODE_GOOD)
+            abort();
+    }
+    for(size_t i = 0; i < ctx->n; i++)
+        UA_TimerWheel_remove(&t, ctx->ids[i]);
+    UA_TimerWheel_clear(&t);
+}
+
+static void
+wheelProcess(void *context) {
+    TimerContext *ctx = (TimerContext*)context;
+    ctx->now += 100 * UA_DATETIME_MSEC;
+    UA_TimerWheel_process(&ctx->wheel, ctx->now);
+}
+
+static void
+benchmarkSize(UA_Benchmark *b, size_t n) {
+    TimerContext ctx;
+    memset(&ctx, 0, sizeof(TimerContext));
+    ctx.n = n;
+    ctx.ids = (UA_UInt64*)UA_malloc(sizeof(UA_UInt64) * n);
+    if(!ctx.ids)
+        abort();
+
+    UA_Benchmark_run(b, "timer/ziptree/add_remove", n, TIMER_OPS / n, n,
+                     ziptreeAddRemove, &ctx);
+    UA_Benchmark_run(b, "timer/wheel/add_remove", n, TIMER_OPS / n, n,
+                     wheelAddRemove, &ctx);
+
+    /* One process step per iteration. About a third of the timers is due in
+     * every step. */
+    size_t steps = TIMER_OPS / n * 10;
+    if(UA_Benchmark_enabled(b, "timer/ziptree/process")) {
+        UA_Timer_init(&ctx.zt);
+        for(size_t i = 0; i < n; i++)
+            UA_Timer_add(&ctx.zt, timerCallback, &ctx, NULL, TIMER_INTERVAL(i),
+                         0, NULL, UA_TIMERPOLICY_CURRENTTIME, NULL);
+        ctx.now = 0;
+        UA_Benchmark_run(b, "timer/ziptree/process", n, steps, 1,
+                         ziptreeProcess, &ctx);
+        UA_Timer_clear(&ctx.zt);
+    }
+    if(UA_Benchmark_enabled(b, "timer/wheel/process")) {
+        UA_TimerWheel_init(&ctx.wheel);
+        for(size_t i = 0; i < n; i++)
+            UA_TimerWheel_add(&ctx.wheel, timerCallback, &ctx, NULL,
+                              TIMER_INTERVAL(i), 0, NULL,
+                              UA_TIMERPOLICY_CURRENTTIME, NULL);
+        ctx.now = 0;
+        UA_Benchmark_run(b, "timer/wheel/process", n, steps, 1,
+                         wheelProcess, &ctx);
+        UA_TimerWheel_clear(&ctx.wheel);
+    }
+
+    UA_free(ctx.ids);
+}
+
+void
+UA_Benchmark_timer(UA_Benchmark *b) {
+    if(!UA_Benchmark_enabled(b, "timer/"))
+        return;
+    const size_t sizes[3] = {100, 10000, 100000};
+    for(size_t i = 0; i < 3; i++)
+        benchmarkSize(b, sizes[i]);
+}
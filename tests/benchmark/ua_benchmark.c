@@ -0,0 +1,235 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/plugin/log_stdout.h>
+#include <open62541/server_config_default.h>
+
+#include "ua_benchmark.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define UA_BENCHMARK_MAXROUNDS 64
+
+#ifndef UA_BENCHMARK_BUILD_TYPE
+#define UA_BENCHMARK_BUILD_TYPE ""
+#endif
+
+typedef struct {
+    char *name;
+    size_t n;
+    size_t iterations;
+    size_t opsPerCall;
+    double minNs;    /* per operation */
+    double medianNs;
+    double meanNs;
+    double maxNs;
+} UA_BenchmarkResult;
+
+struct UA_Benchmark {
+    const char *filter;
+    size_t rounds;
+    double scale;
+    UA_Boolean quiet; /* Don't print the table (JSON goes to stdout) */
+
+    size_t resultsSize;
+    UA_BenchmarkResult *results;
+};
+
+/* Nanoseconds from a monotonic clock */
+static UA_UInt64
+nowNs(void) {
+#if defined(UA_ARCHITECTURE_POSIX) && defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (UA_UInt64)ts.tv_sec * 1000000000u + (UA_UInt64)ts.tv_nsec;
+#else
+    return (UA_UInt64)UA_DateTime_nowMonotonic() * 100u;
+#endif
+}
+
+static int
+cmpDouble(const void *a, const void *b) {
+    double da = *(const double*)a;
+    double db = *(const double*)b;
+    return (da > db) - (da < db);
+}
+
+/* The filter selects the benchmarks whose name starts with it */
+static UA_Boolean
+startsWith(const char *s, const char *prefix) {
+    return strncmp(s, prefix, strlen(prefix)) == 0;
+}
+
+UA_Boolean
+UA_Benchmark_enabled(const UA_Benchmark *b, const char *prefix) {
+    return !b->filter || startsWith(prefix, b->filter) ||
+        startsWith(b->filter, prefix);
+}
+
+void
+UA_Benchmark_run(UA_Benchmark *b, const char *name, size_t n,
+                 size_t iterations, size_t opsPerCall,
+                 UA_BenchmarkCallback callback, void *context) {
+    if(b->filter && !startsWith(name, b->filter))
+        return;
+
+    iterations = (size_t)((double)iterations * b->scale);
+    if(iterations == 0)
+        iterations = 1;
+    if(opsPerCall == 0)
+        opsPerCall = 1;
+
+    /* Warmup */
+    size_t warmup = iterations / 10 + 1;
+    for(size_t i = 0; i < warmup; i++)
+        callback(context);
+
+    /* Measure the rounds */
+    double ns[UA_BENCHMARK_MAXROUNDS];
+    double sum = 0.0;
+    double ops = (double)iterations * (double)opsPerCall;
+    for(size_t r = 0; r < b->rounds; r++) {
+        UA_UInt64 start = nowNs();
+        for(size_t i = 0; i < iterations; i++)
+            callback(context);
+        ns[r] = (double)(nowNs() - start) / ops;
+        sum += ns[r];
+    }
+    qsort(ns, b->rounds, sizeof(double), cmpDouble);
+
+    UA_BenchmarkResult *results = (UA_BenchmarkResult*)
+        UA_realloc(b->results, sizeof(UA_BenchmarkResult) * (b->resultsSize + 1));
+    if(!results) {
+        fprintf(stderr, "Out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    b->results = results;
+    UA_BenchmarkResult *res = &results[b->resultsSize++];
+    size_t nameLen = strlen(name);
+    res->name = (char*)UA_malloc(nameLen + 1);
+    if(!res->name) {
+        fprintf(stderr, "Out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(res->name, name, nameLen + 1);
+    res->n = n;
+    res->iterations = iterations;
+    res->opsPerCall = opsPerCall;
+    res->minNs = ns[0];
+    res->maxNs = ns[b->rounds - 1];
+    res->meanNs = sum / (double)b->rounds;
+    res->medianNs = (b->rounds % 2 == 1) ? ns[b->rounds / 2] :
+        (ns[b->rounds / 2 - 1] + ns[b->rounds / 2]) / 2.0;
+
+    if(!b->quiet) {
+        printf("%-48s %6lu %14.1f %14.1f %14.0f\n", res->name,
+               (unsigned long)res->n, res->minNs, res->medianNs,
+               1e9 / res->medianNs);
+        fflush(stdout);
+    }
+}
+
+UA_Server *
+UA_Benchmark_newServer(void) {
+    UA_ServerConfig config;
+    memset(&config, 0, sizeof(UA_ServerConfig));
+    config.logging = UA_Log_Stdout_new(UA_LOGLEVEL_ERROR);
+    UA_StatusCode res = UA_ServerConfig_setDefault(&config);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_ServerConfig_clear(&config);
+        return NULL;
+    }
+    return UA_Server_newWithConfig(&config);
+}
+
+static void
+writeJson(const UA_Benchmark *b, FILE *f) {
+    fprintf(f, "{\n");
+    fprintf(f, "  \"version\": \"%s\",\n", UA_OPEN62541_VER_COMMIT);
+    fprintf(f, "  \"build_type\": \"%s\",\n", UA_BENCHMARK_BUILD_TYPE);
+    fprintf(f, "  \"multithreading\": %d,\n", UA_MULTITHREADING);
+    fprintf(f, "  \"rounds\": %lu,\n", (unsigned long)b->rounds);
+    fprintf(f, "  \"scale\": %g,\n", b->scale);
+    fprintf(f, "  \"benchmarks\": [");
+    for(size_t i = 0; i < b->resultsSize; i++) {
+        const UA_BenchmarkResult *r = &b->results[i];
+        fprintf(f, "%s\n    {\"name\": \"%s\", \"n\": %lu, \"iterations\": %lu, "
+                "\"ops_per_iteration\": %lu, \"min_ns\": %.2f, \"median_ns\": %.2f, "
+                "\"mean_ns\": %.2f, \"max_ns\": %.2f, \"ops_per_sec\": %.1f}",
+                (i > 0) ? "," : "", r->name, (unsigned long)r->n,
+                (unsigned long)r->iterations, (unsigned long)r->opsPerCall,
+                r->minNs, r->medianNs, r->meanNs, r->maxNs, 1e9 / r->medianNs);
+    }
+    fprintf(f, "\n  ]\n}\n");
+}
+
+static void
+usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [-o <file.json>] [-f <filter>] [-r <rounds>] [-s <scale>]\n"
+            "  -o  Write the results as JSON (\"-\" for stdout)\n"
+            "  -f  Only run the benchmarks whose name starts with the filter\n"
+            "  -r  Number of measured rounds (default 5)\n"
+            "  -s  Scale factor for the iteration counts (default 1.0)\n", prog);
+}
+
+int main(int argc, char **argv) {
+    UA_Benchmark b;
+    memset(&b, 0, sizeof(UA_Benchmark));
+    b.rounds = 5;
+    b.scale = 1.0;
+    const char *output = NULL;
+
+    for(int i = 1; i < argc; i++) {
+        if(i + 1 >= argc || argv[i][0] != '-' || strlen(argv[i]) != 2) {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        const char *val = argv[++i];
+        switch(argv[i-1][1]) {
+        case 'o': output = val; break;
+        case 'f': b.filter = val; break;
+        case 'r': b.rounds = (size_t)strtoul(val, NULL, 10); break;
+        case 's': b.scale = strtod(val, NULL); break;
+        default: usage(argv[0]); return EXIT_FAILURE;
+        }
+    }
+    if(b.rounds == 0 || b.rounds > UA_BENCHMARK_MAXROUNDS || !(b.scale > 0.0)) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    b.quiet = (output && strcmp(output, "-") == 0);
+
+    if(!b.quiet)
+        printf("%-48s %6s %14s %14s %14s\n", "benchmark", "n",
+               "min ns/op", "median ns/op", "ops/s");
+
+    UA_Benchmark_encoding(&b);
+    UA_Benchmark_services(&b);
+    UA_Benchmark_subscriptions(&b);
+    UA_Benchmark_timer(&b);
+    UA_Benchmark_pubsub(&b);
+
+    int ret = EXIT_SUCCESS;
+    if(b.quiet) {
+        writeJson(&b, stdout);
+    } else if(output) {
+        FILE *f = fopen(output, "w");
+        if(f) {
+            writeJson(&b, f);
+            fclose(f);
+        } else {
+            fprintf(stderr, "Cannot open %s\n", output);
+            ret = EXIT_FAILURE;
+        }
+    }
+
+    for(size_t i = 0; i < b.resultsSize; i++)
+        UA_free(b.results[i].name);
+    UA_free(b.results);
+    return ret;
+}
@@ -0,0 +1,56 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef UA_BENCHMARK_H_
+#define UA_BENCHMARK_H_
+
+#include <open62541/server.h>
+
+_UA_BEGIN_DECLS
+
+/**
+ * Micro-Benchmarks
+ * ----------------
+ * Every benchmark runs a callback for a fixed number of iterations per round.
+ * The iteration counts are part of the benchmark definition and only change
+ * with the scale factor given on the command line. So the same workload is
+ * measured on every machine and the results can be compared between releases.
+ *
+ * After a warmup, the benchmark is run for several rounds. The time per
+ * operation is reported as the minimum, median, mean and maximum over the
+ * rounds. The results are printed as a table and written as JSON. */
+
+typedef struct UA_Benchmark UA_Benchmark;
+
+typedef void (*UA_BenchmarkCallback)(void *context);
+
+/* Returns true if a benchmark with the name prefix is selected by the filter.
+ * Used to skip the setup of benchmarks that are not run. */
+UA_Boolean
+UA_Benchmark_enabled(const UA_Benchmark *b, const char *prefix);
+
+/* Run the benchmark with the given name. The callback is executed iterations
+ * times per round. Every execution performs opsPerCall operations. n is the
+ * problem size that is recorded with the result (e.g. the number of nodes per
+ * request). */
+void
+UA_Benchmark_run(UA_Benchmark *b, const char *name, size_t n,
+                 size_t iterations, size_t opsPerCall,
+                 UA_BenchmarkCallback callback, void *context);
+
+/* Returns a server with a logger that only prints errors. The server is not
+ * started and does not open a network port. */
+UA_Server *
+UA_Benchmark_newServer(void);
+
+/* The benchmark suites */
+void UA_Benchmark_encoding(UA_Benchmark *b);
+void UA_Benchmark_services(UA_Benchmark *b);
+void UA_Benchmark_subscriptions(UA_Benchmark *b);
+void UA_Benchmark_timer(UA_Benchmark *b);
+void UA_Benchmark_pubsub(UA_Benchmark *b);
+
+_UA_END_DECLS
+
+#endif /* UA_BENCHMARK_H_ */
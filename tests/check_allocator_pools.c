@@ -0,0 +1,237 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/plugin/allocator_pools.h>
+
+#include <check.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+#include <open62541/client.h>
+#include <open62541/client_highlevel.h>
+#include <open62541/client_subscriptions.h>
+#include <open62541/server.h>
+
+#include "test_helpers.h"
+#include "thread_wrapper.h"
+#endif
+
+UA_Allocator *pools;
+
+static void setup(void) {
+    pools = UA_Allocator_Pools_new();
+    ck_assert(pools != NULL);
+}
+
+static void teardown(void) {
+    pools->clear(pools);
+}
+
+START_TEST(Pools_statistics) {
+    UA_MemoryStatistics ms;
+    void *p1 = pools->malloc(pools, UA_MEMORYCATEGORY_NODESTORE, 100);
+    void *p2 = pools->calloc(pools, UA_MEMORYCATEGORY_NODESTORE, 10, 10);
+    void *p3 = pools->malloc(pools, UA_MEMORYCATEGORY_PUBSUB, 10000);
+    ck_assert(p1 && p2 && p3);
+    for(size_t i = 0; i < 100; i++)
+        ck_assert_uint_eq(((UA_Byte*)p2)[i], 0);
+    memset(p3, 0xff, 10000);
+
+    pools->getStatistics(pools, UA_MEMORYCATEGORY_NODESTORE, &ms);
+    ck_assert_uint_eq(ms.bytesInUse, 200);
+    ck_assert_uint_eq(ms.blocksInUse, 2);
+    ck_assert_uint_eq(ms.allocations, 2);
+    ck_assert_uint_gt(ms.bytesReserved, 0);
+
+    pools->getStatistics(pools, UA_MEMORYCATEGORY_PUBSUB, &ms);
+    ck_assert_uint_eq(ms.bytesInUse, 10000);
+    ck_assert_uint_eq(ms.blocksInUse, 1);
+    ck_assert_uint_ge(ms.bytesReserved, 10000);
+
+    /* Freed in another category than the current one */
+    pools->free(pools, p1);
+    pools->free(pools, p2);
+    pools->free(pools, p3);
+
+    pools->getStatistics(pools, UA_MEMORYCATEGORY_NODESTORE, &ms);
+    ck_assert_uint_eq(ms.bytesInUse, 0);
+    ck_assert_uint_eq(ms.blocksInUse, 0);
+    ck_assert_uint_eq(ms.frees, 2);
+
+    /* Large blocks are returned to the system */
+    pools->getStatistics(pools, UA_MEMORYCATEGORY_PUBSUB, &ms);
+    ck_assert_uint_eq(ms.bytesInUse, 0);
+    ck_assert_uint_eq(ms.bytesReserved, 0);
+
+    pools->getStatistics(pools, UA_MEMORYCATEGORY_ENCODING, &ms);
+    ck_assert_uint_eq(ms.allocations, 0);
+    ck_assert_uint_eq(ms.bytesReserved, 0);
+} END_TEST
+
+START_TEST(Pools_reuse) {
+    void *p1 = pools->malloc(pools, UA_MEMORYCATEGORY_SUBSCRIPTIONS, 50);
+    pools->free(pools, p1);
+
+    /* Same size class */
+    void *p2 = pools->malloc(pools, UA_MEMORYCATEGORY_SUBSCRIPTIONS, 60);
+    ck_assert_ptr_eq(p1, p2);
+
+    /* Other category */
+    void *p3 = pools->malloc(pools, UA_MEMORYCATEGORY_DEFAULT, 60);
+    ck_assert_ptr_ne(p2, p3);
+    pools->free(pools, p2);
+    pools->free(pools, p3);
+
+    /* Many blocks across several slabs */
+    UA_MemoryStatistics ms;
+    void *blocks[1000];
+    for(size_t i = 0; i < 1000; i++) {
+        blocks[i] = pools->malloc(pools, UA_MEMORYCATEGORY_ENCODING, 256);
+        ck_assert(blocks[i] != NULL);
+        memset(blocks[i], (int)i, 256);
+    }
+    pools->getStatistics(pools, UA_MEMORYCATEGORY_ENCODING, &ms);
+    size_t reserved = ms.bytesReserved;
+    ck_assert_uint_ge(reserved, 1000 * 256);
+    for(size_t i = 0; i < 1000; i++)
+        pools->free(pools, blocks[i]);
+    for(size_t i = 0; i < 1000; i++)
+        blocks[i] = pools->malloc(pools, UA_MEMORYCATEGORY_ENCODING, 256);
+    pools->getStatistics(pools, UA_MEMORYCATEGORY_ENCODING, &ms);
+    ck_assert_uint_eq(ms.bytesReserved, reserved);
+    for(size_t i = 0; i < 1000; i++)
+        pools->free(pools, blocks[i]);
+} END_TEST
+
+START_TEST(Pools_realloc) {
+    UA_MemoryStatistics ms;
+    UA_Byte *p = (UA_Byte*)pools->realloc(pools, UA_MEMORYCATEGORY_SECURECHANNEL,
+                                          NULL, 20);
+    ck_assert(p != NULL);
+    for(UA_Byte i = 0; i < 20; i++)
+        p[i] = i;
+
+    /* Within the size class */
+    UA_Byte *p2 = (UA_Byte*)pools->realloc(pools, UA_MEMORYCATEGORY_DEFAULT, p, 30);
+    ck_assert_ptr_eq(p, p2);
+
+    /* To a larger size class. The block keeps its category. */
+    p = (UA_Byte*)pools->realloc(pools, UA_MEMORYCATEGORY_DEFAULT, p2, 1000);
+    for(UA_Byte i = 0; i < 20; i++)
+        ck_assert_uint_eq(p[i], i);
+
+    /* To a large block and back */
+    p = (UA_Byte*)pools->realloc(pools, UA_MEMORYCATEGORY_DEFAULT, p, 100000);
+    p = (UA_Byte*)pools->realloc(pools, UA_MEMORYCATEGORY_DEFAULT, p, 200000);
+    p = (UA_Byte*)pools->realloc(pools, UA_MEMORYCATEGORY_DEFAULT, p, 20);
+    for(UA_Byte i = 0; i < 20; i++)
+        ck_assert_uint_eq(p[i], i);
+
+    pools->getStatistics(pools, UA_MEMORYCATEGORY_SECURECHANNEL, &ms);
+    ck_assert_uint_eq(ms.bytesInUse, 20);
+    ck_assert_uint_eq(ms.blocksInUse, 1);
+    pools->getStatistics(pools, UA_MEMORYCATEGORY_DEFAULT, &ms);
+    ck_assert_uint_eq(ms.allocations, 0);
+
+    pools->free(pools, p);
+    pools->getStatistics(pools, UA_MEMORYCATEGORY_SECURECHANNEL, &ms);
+    ck_assert_uint_eq(ms.blocksInUse, 0);
+    ck_assert_uint_eq(ms.allocations, ms.frees);
+} END_TEST
+
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+
+UA_Server *server;
+UA_Boolean running;
+THREAD_HANDLE server_thread;
+
+THREAD_CALLBACK(serverloop) {
+    UA_Allocator_set(pools); /* The singletons are thread-local */
+    while(running)
+        UA_Server_run_iterate(server, true);
+    return 0;
+}
+
+static UA_UInt64
+categoryAllocations(UA_MemoryCategory cat) {
+    UA_MemoryStatistics ms;
+    UA_StatusCode res = pools->getStatistics(pools, cat, &ms);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    return ms.allocations;
+}
+
+START_TEST(Pools_singleton) {
+    UA_Allocator_set(pools);
+    ck_assert_ptr_eq(UA_Allocator_get(), pools);
+
+    server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+    UA_Server_run_startup(server);
+    running = true;
+    THREAD_CREATE(server_thread, serverloop);
+
+    /* The namespace zero is added to the nodestore */
+    ck_assert_uint_gt(categoryAllocations(UA_MEMORYCATEGORY_NODESTORE), 0);
+
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode res = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_CreateSubscriptionRequest request = UA_CreateSubscriptionRequest_default();
+    UA_CreateSubscriptionResponse response =
+        UA_Client_Subscriptions_create(client, request, NULL, NULL, NULL);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    UA_CreateSubscriptionResponse_clear(&response);
+
+    /* The statistics are exposed in the diagnostics */
+    UA_Variant val;
+    res = UA_Client_readValueAttribute(client,
+        UA_NODEID_STRING(1, "MemoryStatistics.Nodestore"), &val);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(val.type == &UA_TYPES[UA_TYPES_KEYVALUEPAIR]);
+    ck_assert_uint_eq(val.arrayLength, 5);
+    UA_KeyValuePair *kv = (UA_KeyValuePair*)val.data;
+    UA_String bytesInUse = UA_STRING_STATIC("BytesInUse");
+    ck_assert(UA_String_equal(&kv[0].key.name, &bytesInUse));
+    ck_assert(*(UA_UInt64*)kv[0].value.data > 0);
+    UA_Variant_clear(&val);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+
+    ck_assert_uint_gt(categoryAllocations(UA_MEMORYCATEGORY_SUBSCRIPTIONS), 0);
+    ck_assert_uint_gt(categoryAllocations(UA_MEMORYCATEGORY_SECURECHANNEL), 0);
+    ck_assert_uint_gt(categoryAllocations(UA_MEMORYCATEGORY_ENCODING), 0);
+
+    running = false;
+    THREAD_JOIN(server_thread);
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+
+    UA_Allocator_set(NULL);
+    ck_assert_ptr_eq(UA_Allocator_get(), NULL);
+} END_TEST
+
+#endif
+
+int main(void) {
+    Suite *s = suite_create("Allocator Pools");
+    TCase *tc = tcase_create("pools");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, Pools_statistics);
+    tcase_add_test(tc, Pools_reuse);
+    tcase_add_test(tc, Pools_realloc);
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+    tcase_add_test(tc, Pools_singleton);
+#endif
+    suite_add_tcase(s, tc);
+
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,171 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/client_subscriptions.h>
+#include <open62541/plugin/allocator_tracking.h>
+#include <open62541/server.h>
+
+#include <check.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_helpers.h"
+
+UA_Allocator *tracking;
+
+static void setup(void) {
+    tracking = UA_Allocator_Tracking_new();
+    ck_assert(tracking != NULL);
+}
+
+static void teardown(void) {
+    tracking->clear(tracking);
+}
+
+START_TEST(Tracking_statistics) {
+    UA_MemoryStatistics ms;
+    void *p1 = tracking->malloc(tracking, UA_MEMORYCATEGORY_SESSIONS, 100);
+    void *p2 = tracking->calloc(tracking, UA_MEMORYCATEGORY_SESSIONS, 10, 10);
+    ck_assert(p1 && p2);
+    for(size_t i = 0; i < 100; i++)
+        ck_assert_uint_eq(((UA_Byte*)p2)[i], 0);
+
+    tracking->getStatistics(tracking, UA_MEMORYCATEGORY_SESSIONS, &ms);
+    ck_assert_uint_eq(ms.bytesInUse, 200);
+    ck_assert_uint_eq(ms.blocksInUse, 2);
+    ck_assert_uint_eq(ms.allocations, 2);
+    ck_assert_uint_gt(ms.bytesReserved, 200);
+
+    /* The block keeps its category */
+    UA_Byte *p3 = (UA_Byte*)
+        tracking->realloc(tracking, UA_MEMORYCATEGORY_DEFAULT, p1, 10000);
+    ck_assert(p3 != NULL);
+    memset(p3, 0xff, 10000);
+    tracking->getStatistics(tracking, UA_MEMORYCATEGORY_SESSIONS, &ms);
+    ck_assert_uint_eq(ms.bytesInUse, 10100);
+    ck_assert_uint_eq(ms.blocksInUse, 2);
+    tracking->getStatistics(tracking, UA_MEMORYCATEGORY_DEFAULT, &ms);
+    ck_assert_uint_eq(ms.allocations, 0);
+
+    tracking->free(tracking, p2);
+    tracking->free(tracking, p3);
+    tracking->getStatistics(tracking, UA_MEMORYCATEGORY_SESSIONS, &ms);
+    ck_assert_uint_eq(ms.bytesInUse, 0);
+    ck_assert_uint_eq(ms.bytesReserved, 0);
+    ck_assert_uint_eq(ms.blocksInUse, 0);
+    ck_assert_uint_eq(ms.frees, 2);
+} END_TEST
+
+/* Without an allocator only the objects are counted */
+START_TEST(Tracking_reportWithoutAllocator) {
+    UA_Server *server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+    UA_MemoryReport report;
+    UA_StatusCode res = UA_Server_getMemoryReport(server, &report);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADNOTSUPPORTED);
+    ck_assert_uint_gt(report.nodes.objects, 0);
+    ck_assert_uint_eq(report.nodes.bytesInUse, 0);
+    ck_assert_uint_eq(report.sessions.objects, 0);
+    UA_Server_delete(server);
+} END_TEST
+
+#if defined(UA_ENABLE_MALLOC_SINGLETON) && defined(UA_ENABLE_SUBSCRIPTIONS)
+
+#define MONITOREDITEMS 100
+
+static void
+dataChangeCallback(UA_Server *server, UA_UInt32 monitoredItemId,
+                   void *monitoredItemContext, const UA_NodeId *nodeId,
+                   void *nodeContext, UA_UInt32 attributeId,
+                   const UA_DataValue *value) {
+}
+
+/* The footprint of the MonitoredItems and nodes is attributed to their
+ * categories */
+START_TEST(Tracking_memoryReport) {
+    UA_Allocator_set(tracking);
+    UA_Server *server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+
+    UA_MemoryReport before;
+    UA_StatusCode res = UA_Server_getMemoryReport(server, &before);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_uint_gt(before.nodes.objects, 0);
+    ck_assert_uint_gt(before.nodes.bytesInUse, 0);
+    ck_assert_uint_gt(before.nodes.bytesPerObject, 0);
+    ck_assert_uint_eq(before.monitoredItems.objects, 0);
+
+    /* Add variables and monitor them */
+    UA_UInt32 monIds[MONITOREDITEMS];
+    for(UA_UInt32 i = 0; i < MONITOREDITEMS; i++) {
+        UA_VariableAttributes attr = UA_VariableAttributes_default;
+        UA_Int32 v = (UA_Int32)i;
+        UA_Variant_setScalar(&attr.value, &v, &UA_TYPES[UA_TYPES_INT32]);
+        res = UA_Server_addVariableNode(server, UA_NODEID_NUMERIC(1, 5000 + i),
+                                        UA_NS0ID(OBJECTSFOLDER), UA_NS0ID(ORGANIZES),
+                                        UA_QUALIFIEDNAME(1, "Var"),
+                                        UA_NS0ID(BASEDATAVARIABLETYPE),
+                                        attr, NULL, NULL);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+        UA_MonitoredItemCreateRequest item =
+            UA_MonitoredItemCreateRequest_default(UA_NODEID_NUMERIC(1, 5000 + i));
+        item.requestedParameters.samplingInterval = 100.0;
+        UA_MonitoredItemCreateResult result =
+            UA_Server_createDataChangeMonitoredItem(server, UA_TIMESTAMPSTORETURN_BOTH,
+                                                    item, NULL, dataChangeCallback);
+        ck_assert_uint_eq(result.statusCode, UA_STATUSCODE_GOOD);
+        monIds[i] = result.monitoredItemId;
+    }
+
+    UA_MemoryReport report;
+    res = UA_Server_getMemoryReport(server, &report);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(report.nodes.objects, before.nodes.objects + MONITOREDITEMS);
+    ck_assert_uint_gt(report.nodes.bytesInUse, before.nodes.bytesInUse);
+    ck_assert_uint_eq(report.monitoredItems.objects, MONITOREDITEMS);
+    ck_assert_uint_gt(report.monitoredItems.bytesInUse, 0);
+    ck_assert_uint_eq(report.monitoredItems.bytesPerObject,
+                      report.monitoredItems.bytesInUse / MONITOREDITEMS);
+    ck_assert_uint_ge(report.monitoredItems.bytesPerObject, 100);
+    ck_assert_uint_eq(report.categories[UA_MEMORYCATEGORY_MONITOREDITEMS].bytesInUse,
+                      report.monitoredItems.bytesInUse);
+
+    /* The memory is released with the MonitoredItems. Except for the
+     * notifications that are kept in the pool for reuse. */
+    size_t bytesWithItems = report.monitoredItems.bytesInUse;
+    for(size_t i = 0; i < MONITOREDITEMS; i++) {
+        res = UA_Server_deleteMonitoredItem(server, monIds[i]);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+    UA_Server_run_iterate(server, false); /* Delayed cleanup */
+    res = UA_Server_getMemoryReport(server, &report);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(report.monitoredItems.objects, 0);
+    ck_assert_uint_lt(report.monitoredItems.bytesInUse, bytesWithItems / 2);
+
+    UA_Server_delete(server);
+    UA_Allocator_set(NULL);
+} END_TEST
+
+#endif
+
+int main(void) {
+    Suite *s = suite_create("Allocator Tracking");
+    TCase *tc = tcase_create("tracking");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, Tracking_statistics);
+    tcase_add_test(tc, Tracking_reportWithoutAllocator);
+#if defined(UA_ENABLE_MALLOC_SINGLETON) && defined(UA_ENABLE_SUBSCRIPTIONS)
+    tcase_add_test(tc, Tracking_memoryReport);
+#endif
+    suite_add_tcase(s, tc);
+
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
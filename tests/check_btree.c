@@ -0,0 +1,204 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "btree.h"
+
+#define TEST_ITERATIONS 5000
+
+static enum ZIP_CMP
+compareKeys(const void *k1, const void *k2) {
+    unsigned int key1 = *(const unsigned int*)k1;
+    unsigned int key2 = *(const unsigned int*)k2;
+    if(key1 == key2)
+        return ZIP_CMP_EQ;
+    return (key1 < key2) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+}
+
+/* Several keys share a rank. So the full comparison is exercised as well. */
+static btree_rank
+rankKey(const unsigned int *key) {
+    return *key / 16;
+}
+
+struct treeEntry {
+    unsigned int key;
+};
+
+BTREE_HEAD(tree, treeEntry);
+BTREE_FUNCTIONS(tree, treeEntry, unsigned int, key, compareKeys, rankKey)
+
+/* Check the B-tree invariants and return the depth. Every node except the root
+ * has at least BTREE_MINKEYS entries. All leaves are at the same depth. The
+ * entries are sorted and the ranks are consistent. */
+static size_t
+checkNode(struct btree_node *n, struct btree_node *root, size_t *count,
+          unsigned int min_key, unsigned int max_key) {
+    ck_assert_uint_le(n->count, BTREE_MAXKEYS);
+    if(n != root)
+        ck_assert_uint_ge(n->count, BTREE_MINKEYS);
+    ck_assert_uint_gt(n->count, 0);
+    size_t depth = 0;
+    for(unsigned short i = 0; i <= n->count; i++) {
+        unsigned int lower = (i > 0) ?
+            ((struct treeEntry*)n->elms[i-1])->key : min_key;
+        unsigned int upper = (i < n->count) ?
+            ((struct treeEntry*)n->elms[i])->key : max_key;
+        ck_assert_uint_le(lower, upper);
+        if(i < n->count) {
+            ck_assert_uint_eq(n->ranks[i], upper / 16);
+            (*count)++;
+        }
+        if(n->leaf)
+            continue;
+        size_t d = checkNode(n->children[i], root, count, lower, upper);
+        if(i > 0)
+            ck_assert_uint_eq(d, depth);
+        depth = d;
+    }
+    return depth + 1;
+}
+
+static void
+checkTree(struct tree *t, size_t expected) {
+    size_t count = 0;
+    if(t->root)
+        checkNode(t->root, t->root, &count, 0, ~0u);
+    ck_assert_uint_eq(count, expected);
+}
+
+struct iterContext {
+    unsigned int last;
+    size_t count;
+};
+
+static void *
+iterCallback(void *context, struct treeEntry *e) {
+    struct iterContext *ctx = (struct iterContext*)context;
+    ck_assert_uint_ge(e->key, ctx->last);
+    ctx->last = e->key;
+    ctx->count++;
+    return NULL;
+}
+
+static void *
+freeCallback(void *context, struct treeEntry *e) {
+    free(e);
+    return NULL;
+}
+
+START_TEST(randTree) {
+    srand(0);
+    struct tree t;
+    BTREE_INIT(&t);
+    struct treeEntry **entries = (struct treeEntry**)
+        malloc(sizeof(struct treeEntry*) * TEST_ITERATIONS);
+    for(unsigned int i = 0; i < TEST_ITERATIONS; i++) {
+        entries[i] = (struct treeEntry*)malloc(sizeof(struct treeEntry));
+        entries[i]->key = (unsigned int)rand();
+        ck_assert_int_eq(BTREE_INSERT(tree, &t, entries[i]), 0);
+    }
+    checkTree(&t, TEST_ITERATIONS);
+
+    for(unsigned int i = 0; i < TEST_ITERATIONS; i++) {
+        struct treeEntry *e = BTREE_FIND(tree, &t, &entries[i]->key);
+        ck_assert_ptr_ne(e, NULL);
+        ck_assert_uint_eq(e->key, entries[i]->key);
+    }
+
+    struct iterContext ctx = {0, 0};
+    BTREE_ITER(tree, &t, iterCallback, &ctx);
+    ck_assert_uint_eq(ctx.count, TEST_ITERATIONS);
+    ck_assert_uint_eq(BTREE_MAX(tree, &t)->key, ctx.last);
+
+    /* Remove in random order */
+    for(unsigned int i = TEST_ITERATIONS; i > 0; i--) {
+        unsigned int j = (unsigned int)rand() % i;
+        struct treeEntry *e = entries[j];
+        entries[j] = entries[i-1];
+        ck_assert_ptr_eq(BTREE_REMOVE(tree, &t, e), e);
+        ck_assert_ptr_eq(BTREE_REMOVE(tree, &t, e), NULL);
+        if(i % 100 == 0)
+            checkTree(&t, i - 1);
+        free(e);
+    }
+    ck_assert(BTREE_EMPTY(&t));
+    free(entries);
+} END_TEST
+
+START_TEST(duplicateKeys) {
+    struct tree t;
+    BTREE_INIT(&t);
+    struct treeEntry *entries[500];
+    for(unsigned int i = 0; i < 500; i++) {
+        entries[i] = (struct treeEntry*)malloc(sizeof(struct treeEntry));
+        entries[i]->key = i % 7;
+        ck_assert_int_eq(BTREE_INSERT(tree, &t, entries[i]), 0);
+    }
+    checkTree(&t, 500);
+
+    /* Visit only the elements with the key */
+    for(unsigned int key = 0; key < 8; key++) {
+        struct iterContext ctx = {key, 0};
+        BTREE_ITER_KEY(tree, &t, &key, iterCallback, &ctx);
+        ck_assert_uint_eq(ctx.last, key);
+        ck_assert_uint_eq(ctx.count, (key < 7) ? (500 + 6 - key) / 7 : 0);
+    }
+
+    /* Remove exactly the given element among the duplicates */
+    for(unsigned int i = 0; i < 500; i += 2) {
+        ck_assert_ptr_eq(BTREE_REMOVE(tree, &t, entries[i]), entries[i]);
+        free(entries[i]);
+    }
+    checkTree(&t, 250);
+    for(unsigned int i = 1; i < 500; i += 2) {
+        ck_assert_ptr_eq(BTREE_REMOVE(tree, &t, entries[i]), entries[i]);
+        ck_assert_ptr_eq(BTREE_REMOVE(tree, &t, entries[i]), NULL);
+    }
+    ck_assert(BTREE_EMPTY(&t));
+    for(unsigned int i = 1; i < 500; i += 2)
+        free(entries[i]);
+} END_TEST
+
+START_TEST(minMaxClear) {
+    struct tree t;
+    BTREE_INIT(&t);
+    ck_assert_ptr_eq(BTREE_MIN(tree, &t), NULL);
+    ck_assert_ptr_eq(BTREE_MAX(tree, &t), NULL);
+    for(unsigned int i = 0; i < TEST_ITERATIONS; i++) {
+        struct treeEntry *e = (struct treeEntry*)malloc(sizeof(struct treeEntry));
+        e->key = (i * 7919) % TEST_ITERATIONS;
+        ck_assert_int_eq(BTREE_INSERT(tree, &t, e), 0);
+    }
+    checkTree(&t, TEST_ITERATIONS);
+    ck_assert_uint_eq(BTREE_MIN(tree, &t)->key, 0);
+    ck_assert_uint_eq(BTREE_MAX(tree, &t)->key, TEST_ITERATIONS - 1);
+    unsigned int missing = TEST_ITERATIONS;
+    ck_assert_ptr_eq(BTREE_FIND(tree, &t, &missing), NULL);
+
+    /* Free the elements during the iteration, then the tree nodes */
+    BTREE_ITER(tree, &t, freeCallback, NULL);
+    BTREE_CLEAR(tree, &t);
+    ck_assert(BTREE_EMPTY(&t));
+} END_TEST
+
+int main(void) {
+    int number_failed = 0;
+    TCase *tc = tcase_create("btree");
+    tcase_add_test(tc, randTree);
+    tcase_add_test(tc, duplicateKeys);
+    tcase_add_test(tc, minMaxClear);
+    Suite *s = suite_create("Test btree library");
+    suite_add_tcase(s, tc);
+
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed += srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
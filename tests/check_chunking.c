@@ -6,6 +6,7 @@
 
 #include "ua_securechannel.h"
 #include "ua_types_encoding_binary.h"
+#include "util/ua_util_internal.h"
 
 #include <stdlib.h>
 #include <check.h>
@@ -62,6 +63,58 @@ START_TEST(encodeArrayIntoFiveChunksShallWork) {
     UA_Array_delete(ar, arraySize, &UA_TYPES[UA_TYPES_INT32]);
 } END_TEST
 
+/* Int32 arrays are overlayable on little-endian hosts. Clearing the flag
+ * forces the batch conversion of fixed-size numeric arrays. The batches are
+ * split where the chunk boundaries fall. */
+START_TEST(encodeNonOverlayableArrayIntoChunksShallWork) {
+    size_t arraySize = 30;
+    size_t chunkCount = 6;
+    size_t chunkSize = 30;
+    bufIndex = 0;
+    counter = 0;
+    dataCount = 0;
+    buffers = (UA_ByteString*)UA_Array_new(chunkCount, &UA_TYPES[UA_TYPES_BYTESTRING]);
+    for(size_t i = 0; i < chunkCount; i++)
+        UA_ByteString_allocBuffer(&buffers[i], chunkSize);
+
+    UA_DataType int32Type = UA_TYPES[UA_TYPES_INT32];
+    int32Type.overlayable = false;
+    UA_Int32 ar[30];
+    for(size_t i = 0; i < arraySize; i++)
+        ar[i] = (UA_Int32)(i * 0x01010101);
+    UA_Variant v;
+    UA_Variant_setArray(&v, ar, arraySize, &int32Type);
+
+    UA_Byte *pos = buffers[0].data;
+    const UA_Byte *end = &buffers[0].data[buffers[0].length];
+    UA_StatusCode retval = UA_encodeBinaryInternal(&v, &UA_TYPES[UA_TYPES_VARIANT],
+                                                   &pos, &end, sendChunkMockUp, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(counter, 4);
+    dataCount += (uintptr_t)(pos - buffers[bufIndex].data);
+    ck_assert_uint_eq(UA_calcSizeBinary(&v, &UA_TYPES[UA_TYPES_VARIANT]), dataCount);
+
+    /* Every chunk is filled with whole elements. The first chunk holds the
+     * encoding byte and the array length. Compare with the memcpy encoding. */
+    UA_Variant v2;
+    UA_Variant_setArray(&v2, ar, arraySize, &UA_TYPES[UA_TYPES_INT32]);
+    UA_ByteString expected = UA_BYTESTRING_NULL;
+    retval = UA_encodeBinary(&v2, &UA_TYPES[UA_TYPES_VARIANT], &expected);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    size_t offset = 0;
+    size_t used = 5 + ((chunkSize - 5) / 4) * 4;
+    for(size_t i = 0; i <= bufIndex; i++) {
+        if(i == bufIndex)
+            used = expected.length - offset;
+        ck_assert(memcmp(buffers[i].data, &expected.data[offset], used) == 0);
+        offset += used;
+        used = (chunkSize / 4) * 4;
+    }
+
+    UA_ByteString_clear(&expected);
+    UA_Array_delete(buffers, chunkCount, &UA_TYPES[UA_TYPES_BYTESTRING]);
+} END_TEST
+
 START_TEST(encodeStringIntoFiveChunksShallWork) {
     size_t stringLength = 120; //number of elements within the array which should be encoded
     size_t chunkCount = 6; // maximum chunk count
@@ -151,13 +204,154 @@ START_TEST(encodeTwoStringsIntoTenChunksShallWork) {
     UA_String_clear(&string);
 } END_TEST
 
+/* Message with strings, a Guid, numeric arrays and an array of
+ * ExtensionObjects that is unwrapped during decoding */
+static void
+segmentsTestMessage(UA_CallMethodRequest *req) {
+    UA_CallMethodRequest_init(req);
+    req->objectId = UA_NODEID_STRING_ALLOC(1, "a string nodeid in the header");
+    req->methodId = UA_NODEID_GUID(2, UA_GUID("09087e75-8e5e-499b-954f-f2a9603db28a"));
+    req->inputArgumentsSize = 4;
+    req->inputArguments = (UA_Variant*)
+        UA_Array_new(4, &UA_TYPES[UA_TYPES_VARIANT]);
+
+    UA_Argument args[3];
+    for(size_t i = 0; i < 3; i++) {
+        UA_Argument_init(&args[i]);
+        args[i].name = UA_STRING("argument");
+        args[i].dataType = UA_TYPES[UA_TYPES_DOUBLE].typeId;
+        args[i].valueRank = (UA_Int32)i;
+        args[i].description = UA_LOCALIZEDTEXT("en", "an argument");
+    }
+    UA_Variant_setArrayCopy(&req->inputArguments[0], args, 3,
+                            &UA_TYPES[UA_TYPES_ARGUMENT]);
+
+    UA_Double d[5] = {1.0, -2.5, 3.25, 1e10, 0.0};
+    UA_Variant_setArrayCopy(&req->inputArguments[1], d, 5, &UA_TYPES[UA_TYPES_DOUBLE]);
+    UA_Int64 n[3] = {-1, 1 << 20, UA_INT64_MAX};
+    UA_Variant_setArrayCopy(&req->inputArguments[2], n, 3, &UA_TYPES[UA_TYPES_INT64]);
+    UA_String str = UA_STRING("a longer string that crosses several segments");
+    UA_Variant_setScalarCopy(&req->inputArguments[3], &str, &UA_TYPES[UA_TYPES_STRING]);
+}
+
+/* Split the buffer into segments of the given length */
+static size_t
+splitSegments(const UA_ByteString *buf, size_t segLength, UA_ByteString *segments) {
+    size_t count = 0;
+    for(size_t pos = 0; pos < buf->length; pos += segLength) {
+        segments[count].data = &buf->data[pos];
+        segments[count].length = buf->length - pos;
+        if(segments[count].length > segLength)
+            segments[count].length = segLength;
+        count++;
+    }
+    return count;
+}
+
+START_TEST(decodeAcrossSegmentsShallWork) {
+    UA_CallMethodRequest req;
+    segmentsTestMessage(&req);
+    UA_ByteString buf = UA_BYTESTRING_NULL;
+    UA_StatusCode retval = UA_encodeBinary(&req, &UA_TYPES[UA_TYPES_CALLMETHODREQUEST], &buf);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_ByteString *segments = (UA_ByteString*)
+        UA_malloc(buf.length * sizeof(UA_ByteString));
+    for(size_t segLength = 1; segLength <= buf.length; segLength++) {
+        size_t segmentsSize = splitSegments(&buf, segLength, segments);
+        UA_CallMethodRequest out;
+        size_t offset = 0;
+        retval = UA_decodeBinarySegments(segments, segmentsSize, &offset, &out,
+                                         &UA_TYPES[UA_TYPES_CALLMETHODREQUEST], NULL);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(offset, buf.length);
+        ck_assert(out.inputArguments[0].type == &UA_TYPES[UA_TYPES_ARGUMENT]);
+        ck_assert_int_eq(UA_order(&req, &out, &UA_TYPES[UA_TYPES_CALLMETHODREQUEST]),
+                         UA_ORDER_EQ);
+        UA_CallMethodRequest_clear(&out);
+
+        /* The message is incomplete without the last segment */
+        if(segmentsSize > 1) {
+            offset = 0;
+            retval = UA_decodeBinarySegments(segments, segmentsSize - 1, &offset, &out,
+                                             &UA_TYPES[UA_TYPES_CALLMETHODREQUEST], NULL);
+            ck_assert_uint_ne(retval, UA_STATUSCODE_GOOD);
+        }
+    }
+
+    /* Two segments with the boundary at every position. Empty segments are
+     * skipped. */
+    for(size_t split = 0; split <= buf.length; split++) {
+        UA_ByteString two[3];
+        two[0].data = buf.data;
+        two[0].length = split;
+        two[1].data = NULL;
+        two[1].length = 0;
+        two[2].data = &buf.data[split];
+        two[2].length = buf.length - split;
+        UA_CallMethodRequest out;
+        size_t offset = 0;
+        retval = UA_decodeBinarySegments(two, 3, &offset, &out,
+                                         &UA_TYPES[UA_TYPES_CALLMETHODREQUEST], NULL);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        ck_assert_int_eq(UA_order(&req, &out, &UA_TYPES[UA_TYPES_CALLMETHODREQUEST]),
+                         UA_ORDER_EQ);
+        UA_CallMethodRequest_clear(&out);
+    }
+
+    UA_free(segments);
+    UA_ByteString_clear(&buf);
+    UA_CallMethodRequest_clear(&req);
+} END_TEST
+
+/* Strings are borrowed from the segments unless they cross a boundary */
+START_TEST(decodeAcrossSegmentsBorrowStrings) {
+    UA_CallMethodRequest req;
+    segmentsTestMessage(&req);
+    UA_ByteString buf = UA_BYTESTRING_NULL;
+    UA_StatusCode retval = UA_encodeBinary(&req, &UA_TYPES[UA_TYPES_CALLMETHODREQUEST], &buf);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_Arena arena;
+    memset(&arena, 0, sizeof(UA_Arena));
+    arena.blockSize = 1024;
+    UA_DecodeBinaryOptions opt;
+    memset(&opt, 0, sizeof(UA_DecodeBinaryOptions));
+    opt.calloc = UA_Arena_calloc;
+    opt.callocContext = &arena;
+    opt.borrowStrings = true;
+
+    UA_ByteString segments[4];
+    size_t segmentsSize = splitSegments(&buf, (buf.length / 4) + 1, segments);
+    UA_CallMethodRequest out;
+    size_t offset = 0;
+    retval = UA_decodeBinarySegments(segments, segmentsSize, &offset, &out,
+                                     &UA_TYPES[UA_TYPES_CALLMETHODREQUEST], &opt);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(UA_order(&req, &out, &UA_TYPES[UA_TYPES_CALLMETHODREQUEST]),
+                     UA_ORDER_EQ);
+
+    /* The first string is in the first segment */
+    UA_String *s = &out.objectId.identifier.string;
+    ck_assert(s->data >= buf.data && s->data + s->length <= &buf.data[buf.length]);
+
+    UA_Arena_clear(&arena);
+    UA_ByteString_clear(&buf);
+    UA_CallMethodRequest_clear(&req);
+} END_TEST
+
 int main(void) {
     Suite *s = suite_create("Chunked encoding");
     TCase *tc_message = tcase_create("encode chunking");
     tcase_add_test(tc_message,encodeArrayIntoFiveChunksShallWork);
+    tcase_add_test(tc_message,encodeNonOverlayableArrayIntoChunksShallWork);
     tcase_add_test(tc_message,encodeStringIntoFiveChunksShallWork);
     tcase_add_test(tc_message,encodeTwoStringsIntoTenChunksShallWork);
     suite_add_tcase(s, tc_message);
+    TCase *tc_decode = tcase_create("decode segments");
+    tcase_add_test(tc_decode, decodeAcrossSegmentsShallWork);
+    tcase_add_test(tc_decode, decodeAcrossSegmentsBorrowStrings);
+    suite_add_tcase(s, tc_decode);
 
     SRunner *sr = srunner_create(s);
     srunner_set_fork_status(sr, CK_NOFORK);
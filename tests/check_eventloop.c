@@ -6,10 +6,18 @@
 #include "testing_clock.h"
 #include <time.h>
 #include <stdio.h>
+#if defined(__linux__)
+#include <sched.h>
+#endif
 
 #include <stdlib.h>
+#include <string.h>
 #include <check.h>
 
+#if UA_MULTITHREADING >= 100
+#include "thread_wrapper.h"
+#endif
+
 #define N_EVENTS 10000
 
 UA_EventLoop *el;
@@ -52,10 +60,353 @@ START_TEST(benchmarkTimer) {
     el = NULL;
 } END_TEST
 
+#if defined(__linux__)
+/* The thread running the EventLoop gets pinned to the configured CPU */
+START_TEST(threadScheduling) {
+    cpu_set_t origSet;
+    ck_assert_int_eq(sched_getaffinity(0, sizeof(cpu_set_t), &origSet), 0);
+    UA_UInt32 cpu = (UA_UInt32)sched_getcpu();
+
+    el = UA_EventLoop_new_POSIX(NULL);
+    UA_KeyValueMap_setScalar(&el->params, UA_QUALIFIEDNAME(0, "cpu-affinity"),
+                             &cpu, &UA_TYPES[UA_TYPES_UINT32]);
+    el->start(el);
+    el->run(el, 0);
+
+    cpu_set_t set;
+    ck_assert_int_eq(sched_getaffinity(0, sizeof(cpu_set_t), &set), 0);
+    ck_assert_int_eq(CPU_COUNT(&set), 1);
+    ck_assert(CPU_ISSET(cpu, &set));
+
+    el->stop(el);
+    while(el->state != UA_EVENTLOOPSTATE_STOPPED)
+        el->run(el, 0);
+    el->free(el);
+    el = NULL;
+
+    sched_setaffinity(0, sizeof(cpu_set_t), &origSet);
+} END_TEST
+#endif
+
+/* Advances the fake clock by the duration (ms) given in the data */
+static void
+sleepCallback(void *application, void *data) {
+    UA_fakeSleep(*(UA_UInt32*)data);
+}
+
+static void
+delayedCallback(void *application, void *context) {
+    count++;
+}
+
+static const UA_EventLoopProfileEntry *
+findProfileEntry(const UA_EventLoopProfileEntry *entries, size_t entriesSize,
+                 UA_EventLoopProfileType type, UA_UInt64 id) {
+    for(size_t i = 0; i < entriesSize; i++) {
+        if(entries[i].type == type && entries[i].id == id)
+            return &entries[i];
+    }
+    return NULL;
+}
+
+static size_t
+countOccurrences(const UA_String *s, const char *pattern) {
+    size_t len = strlen(pattern);
+    size_t n = 0;
+    for(size_t i = 0; i + len <= s->length; i++) {
+        if(memcmp(&s->data[i], pattern, len) == 0)
+            n++;
+    }
+    return n;
+}
+
+START_TEST(profiling) {
+    el = UA_EventLoop_new_POSIX(NULL);
+    el->dateTime_nowMonotonic = UA_DateTime_now_fake;
+    el->start(el);
+
+    /* The slow timer takes longer than its interval. The fast timer has enough
+     * slack to never overrun even if delayed by the slow timer. */
+    UA_UInt32 fastDuration = 1, slowDuration = 150;
+    UA_UInt64 fastId, slowId;
+    UA_StatusCode res =
+        el->addTimer(el, sleepCallback, NULL, &fastDuration, 500.0, NULL,
+                     UA_TIMERPOLICY_CURRENTTIME, &fastId);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    res = el->addTimer(el, sleepCallback, NULL, &slowDuration, 100.0, NULL,
+                       UA_TIMERPOLICY_CURRENTTIME, &slowId);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    res = el->setProfiling(el, true, 16);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_DelayedCallback dc;
+    memset(&dc, 0, sizeof(UA_DelayedCallback));
+    dc.callback = delayedCallback;
+    el->addDelayedCallback(el, &dc);
+
+    for(size_t i = 0; i < 20; i++) {
+        UA_fakeSleep(10);
+        el->run(el, 0);
+    }
+
+    UA_EventLoopProfileEntry *entries;
+    size_t entriesSize;
+    res = el->getProfile(el, &entries, &entriesSize);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    const UA_EventLoopProfileEntry *e =
+        findProfileEntry(entries, entriesSize,
+                         UA_EVENTLOOPPROFILETYPE_ITERATION, 0);
+    ck_assert(e != NULL);
+    ck_assert_uint_eq(e->invocations, 20);
+
+    e = findProfileEntry(entries, entriesSize,
+                         UA_EVENTLOOPPROFILETYPE_TIMER, fastId);
+    ck_assert(e != NULL);
+    ck_assert_uint_gt(e->invocations, 0);
+    ck_assert_uint_eq(e->overruns, 0);
+    ck_assert_int_eq(e->timeMax, fastDuration * UA_DATETIME_MSEC);
+
+    e = findProfileEntry(entries, entriesSize,
+                         UA_EVENTLOOPPROFILETYPE_TIMER, slowId);
+    ck_assert(e != NULL);
+    ck_assert_uint_gt(e->invocations, 0);
+    ck_assert_uint_eq(e->overruns, e->invocations);
+    ck_assert_int_eq(e->timeLast, slowDuration * UA_DATETIME_MSEC);
+    ck_assert_int_eq(e->timeTotal,
+                     (UA_DateTime)e->invocations * slowDuration * UA_DATETIME_MSEC);
+
+    e = findProfileEntry(entries, entriesSize, UA_EVENTLOOPPROFILETYPE_DELAYED,
+                         (UA_UInt64)(uintptr_t)delayedCallback);
+    ck_assert(e != NULL);
+    ck_assert_uint_eq(e->invocations, 1);
+    UA_free(entries);
+
+    /* The trace keeps the last 16 events */
+    UA_String trace;
+    res = el->printProfileTrace(el, &trace);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(countOccurrences(&trace, "\"ph\":\"X\""), 16);
+    ck_assert_uint_eq(countOccurrences(&trace, "{\"displayTimeUnit\""), 1);
+    ck_assert_uint_gt(countOccurrences(&trace, "\"cat\":\"timer\""), 0);
+    UA_String_clear(&trace);
+
+    /* No more recording after disabling. The profile can still be read. */
+    res = el->setProfiling(el, false, 0);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < 5; i++) {
+        UA_fakeSleep(10);
+        el->run(el, 0);
+    }
+    res = el->getProfile(el, &entries, &entriesSize);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    e = findProfileEntry(entries, entriesSize,
+                         UA_EVENTLOOPPROFILETYPE_ITERATION, 0);
+    ck_assert(e != NULL);
+    ck_assert_uint_eq(e->invocations, 20);
+    UA_free(entries);
+
+    el->stop(el);
+    while(el->state != UA_EVENTLOOPSTATE_STOPPED)
+        el->run(el, 0);
+    el->free(el);
+    el = NULL;
+} END_TEST
+
+static size_t order[8];
+static size_t orderSize;
+
+static void
+orderCallback(void *application, void *context) {
+    order[orderSize++] = (size_t)(uintptr_t)context;
+    /* Re-added from within the callback: processed in the next iteration */
+    if(application)
+        el->addDelayedCallback(el, (UA_DelayedCallback*)application);
+}
+
+/* Delayed callbacks are processed in the order they were added */
+START_TEST(delayedCallbackOrder) {
+    el = UA_EventLoop_new_POSIX(NULL);
+    el->start(el);
+
+    UA_DelayedCallback dcs[5];
+    memset(dcs, 0, sizeof(dcs));
+    for(size_t i = 0; i < 5; i++) {
+        dcs[i].callback = orderCallback;
+        dcs[i].context = (void*)(uintptr_t)i;
+        el->addDelayedCallback(el, &dcs[i]);
+    }
+
+    /* Remove from the middle and from the end */
+    el->removeDelayedCallback(el, &dcs[2]);
+    el->removeDelayedCallback(el, &dcs[4]);
+
+    /* The second entry re-adds the removed last entry */
+    dcs[1].application = &dcs[4];
+
+    orderSize = 0;
+    el->run(el, 0);
+    ck_assert_uint_eq(orderSize, 3);
+    ck_assert_uint_eq(order[0], 0);
+    ck_assert_uint_eq(order[1], 1);
+    ck_assert_uint_eq(order[2], 3);
+
+    el->run(el, 0);
+    ck_assert_uint_eq(orderSize, 4);
+    ck_assert_uint_eq(order[3], 4);
+
+    el->run(el, 0);
+    ck_assert_uint_eq(orderSize, 4);
+
+    el->stop(el);
+    while(el->state != UA_EVENTLOOPSTATE_STOPPED)
+        el->run(el, 0);
+    el->free(el);
+    el = NULL;
+} END_TEST
+
+static UA_DateTime coarseTimes[4];
+
+static void
+coarseClockCallback(void *application, void *data) {
+    coarseTimes[0] = el->dateTime_now(el);
+    coarseTimes[1] = el->dateTime_nowMonotonic(el);
+    UA_realSleep(2);
+    coarseTimes[2] = el->dateTime_now(el);
+    coarseTimes[3] = el->dateTime_nowMonotonic(el);
+}
+
+/* With the coarse clock, the callbacks of one iteration see the same time */
+START_TEST(coarseClock) {
+    el = UA_EventLoop_new_POSIX(NULL);
+    UA_Boolean coarse = true;
+    UA_KeyValueMap_setScalar(&el->params, UA_QUALIFIEDNAME(0, "coarse-clock"),
+                             &coarse, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    el->start(el);
+
+    UA_DelayedCallback dc;
+    memset(&dc, 0, sizeof(dc));
+    dc.callback = coarseClockCallback;
+    el->addDelayedCallback(el, &dc);
+    el->run(el, 0);
+    ck_assert(coarseTimes[0] != 0);
+    ck_assert_int_eq(coarseTimes[0], coarseTimes[2]);
+    ck_assert_int_eq(coarseTimes[1], coarseTimes[3]);
+
+    /* The next iteration takes a new snapshot */
+    UA_DateTime last = coarseTimes[1];
+    el->addDelayedCallback(el, &dc);
+    el->run(el, 0);
+    ck_assert_int_gt(coarseTimes[1], last);
+
+    /* The stopped EventLoop reads the clock again */
+    el->stop(el);
+    while(el->state != UA_EVENTLOOPSTATE_STOPPED)
+        el->run(el, 0);
+    coarseClockCallback(NULL, NULL);
+    ck_assert_int_gt(coarseTimes[3], coarseTimes[1]);
+    el->free(el);
+    el = NULL;
+} END_TEST
+
+#if UA_MULTITHREADING >= 100
+#define PRODUCERS 4
+#define PRODUCER_CALLBACKS 10000
+
+static volatile size_t delayedCount;
+
+static void
+countCallback(void *application, void *context) {
+    delayedCount++;
+}
+
+THREAD_CALLBACK_PARAM(produceDelayed, param) {
+    UA_DelayedCallback *dcs = *(UA_DelayedCallback**)param;
+    for(size_t i = 0; i < PRODUCER_CALLBACKS; i++)
+        el->addDelayedCallback(el, &dcs[i]);
+    return 0;
+}
+
+/* Delayed callbacks are added from several threads while the EventLoop runs */
+START_TEST(delayedCallbackProducers) {
+    el = UA_EventLoop_new_POSIX(NULL);
+    el->start(el);
+
+    UA_DelayedCallback *dcs[PRODUCERS];
+    THREAD_HANDLE threads[PRODUCERS];
+    for(size_t i = 0; i < PRODUCERS; i++) {
+        dcs[i] = (UA_DelayedCallback*)
+            UA_calloc(PRODUCER_CALLBACKS, sizeof(UA_DelayedCallback));
+        for(size_t j = 0; j < PRODUCER_CALLBACKS; j++)
+            dcs[i][j].callback = countCallback;
+    }
+
+    delayedCount = 0;
+    for(size_t i = 0; i < PRODUCERS; i++)
+        THREAD_CREATE_PARAM(threads[i], produceDelayed, dcs[i]);
+    while(delayedCount < PRODUCERS * PRODUCER_CALLBACKS)
+        el->run(el, 1);
+    for(size_t i = 0; i < PRODUCERS; i++)
+        THREAD_JOIN(threads[i]);
+    el->run(el, 0);
+    ck_assert_uint_eq(delayedCount, PRODUCERS * PRODUCER_CALLBACKS);
+
+    el->stop(el);
+    while(el->state != UA_EVENTLOOPSTATE_STOPPED)
+        el->run(el, 0);
+    el->free(el);
+    el = NULL;
+    for(size_t i = 0; i < PRODUCERS; i++)
+        UA_free(dcs[i]);
+} END_TEST
+
+static volatile UA_Boolean cancelRunning;
+
+THREAD_CALLBACK(cancelLoop) {
+    while(cancelRunning)
+        el->cancel(el);
+    return 0;
+}
+
+/* A cancel from another thread ends the blocking wait of the EventLoop. The
+ * wakeup is re-armed after every iteration. */
+START_TEST(cancelFromThread) {
+    el = UA_EventLoop_new_POSIX(NULL);
+    el->start(el);
+
+    cancelRunning = true;
+    THREAD_HANDLE thread;
+    THREAD_CREATE(thread, cancelLoop);
+    UA_DateTime before = el->dateTime_nowMonotonic(el);
+    for(size_t i = 0; i < 100; i++)
+        el->run(el, 10000);
+    ck_assert_int_lt(el->dateTime_nowMonotonic(el) - before, 10 * UA_DATETIME_SEC);
+    cancelRunning = false;
+    THREAD_JOIN(thread);
+
+    el->stop(el);
+    while(el->state != UA_EVENTLOOPSTATE_STOPPED)
+        el->run(el, 0);
+    el->free(el);
+    el = NULL;
+} END_TEST
+#endif
+
 int main(void) {
     Suite *s  = suite_create("Test EventLoop");
     TCase *tc = tcase_create("test cases");
     tcase_add_test(tc, benchmarkTimer);
+    tcase_add_test(tc, profiling);
+    tcase_add_test(tc, delayedCallbackOrder);
+    tcase_add_test(tc, coarseClock);
+#if UA_MULTITHREADING >= 100
+    tcase_add_test(tc, delayedCallbackProducers);
+    tcase_add_test(tc, cancelFromThread);
+#endif
+#if defined(__linux__)
+    tcase_add_test(tc, threadScheduling);
+#endif
     suite_add_tcase(s, tc);
 
     SRunner *sr = srunner_create(s);
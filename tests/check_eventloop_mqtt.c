@@ -107,10 +107,77 @@ START_TEST(connectSubscribePublish) {
     el = NULL;
 } END_TEST
 
+static void
+openTopicConnection(UA_ConnectionManager *mcm, const char *topicName,
+                    UA_Boolean subscribe, uintptr_t *connectionId) {
+    UA_UInt16 port = 1883;
+    UA_String hostname = UA_STRING("localhost");
+    UA_String topic = UA_STRING((char*)(uintptr_t)topicName);
+    UA_KeyValuePair params[4];
+    params[0].key = UA_QUALIFIEDNAME(0, "port");
+    UA_Variant_setScalar(&params[0].value, &port, &UA_TYPES[UA_TYPES_UINT16]);
+    params[1].key = UA_QUALIFIEDNAME(0, "address");
+    UA_Variant_setScalar(&params[1].value, &hostname, &UA_TYPES[UA_TYPES_STRING]);
+    params[2].key = UA_QUALIFIEDNAME(0, "topic");
+    UA_Variant_setScalar(&params[2].value, &topic, &UA_TYPES[UA_TYPES_STRING]);
+    params[3].key = UA_QUALIFIEDNAME(0, "subscribe");
+    UA_Variant_setScalar(&params[3].value, &subscribe, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    UA_KeyValueMap kvm = {4, params};
+    UA_StatusCode res = mcm->openConnection(mcm, &kvm, NULL,
+                                            connectionId, connectionCallback);
+    ck_assert(res == UA_STATUSCODE_GOOD);
+}
+
+START_TEST(subscribeWildcards) {
+    UA_ConnectionManager *cm = UA_ConnectionManager_new_POSIX_TCP(UA_STRING("tcpCM"));
+    UA_ConnectionManager *mcm = UA_ConnectionManager_new_MQTT(UA_STRING("mqttCM"));
+    UA_EventLoop *el = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    el->registerEventSource(el, &cm->eventSource);
+    el->registerEventSource(el, &mcm->eventSource);
+    el->start(el);
+
+    /* All topic connections share the broker connection */
+    uintptr_t ids[5] = {0};
+    openTopicConnection(mcm, "wild/+", true, &ids[0]);
+    openTopicConnection(mcm, "wild/#", true, &ids[1]);
+    openTopicConnection(mcm, "wild/a/b", true, &ids[2]);
+    openTopicConnection(mcm, "wild/a", false, &ids[3]);
+    openTopicConnection(mcm, "wild/a/b", false, &ids[4]);
+    el->run(el, 100);
+
+    /* Matched by "wild/+" and "wild/#" */
+    messageCount = 0;
+    UA_ByteString msg = UA_BYTESTRING_ALLOC("open62541-msg");
+    UA_StatusCode res = mcm->sendWithConnection(mcm, ids[3], &UA_KEYVALUEMAP_NULL, &msg);
+    ck_assert(res == UA_STATUSCODE_GOOD);
+    while(messageCount < 2)
+        el->run(el, 100);
+
+    /* Matched by "wild/#" and "wild/a/b" */
+    msg = UA_BYTESTRING_ALLOC("open62541-msg");
+    res = mcm->sendWithConnection(mcm, ids[4], &UA_KEYVALUEMAP_NULL, &msg);
+    ck_assert(res == UA_STATUSCODE_GOOD);
+    while(messageCount < 4)
+        el->run(el, 100);
+    el->run(el, 100);
+    ck_assert_uint_eq(messageCount, 4);
+
+    el->stop(el);
+    int iteration = 0;
+    while(el->state != UA_EVENTLOOPSTATE_STOPPED && iteration < 10) {
+        UA_DateTime next = el->run(el, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+        iteration++;
+    }
+    ck_assert(el->state == UA_EVENTLOOPSTATE_STOPPED);
+    el->free(el);
+} END_TEST
+
 int main(void) {
     Suite *s  = suite_create("Test MQTT TCP EventLoop");
     TCase *tc = tcase_create("test cases");
     tcase_add_test(tc, connectSubscribePublish);
+    tcase_add_test(tc, subscribeWildcards);
     suite_add_tcase(s, tc);
 
     SRunner *sr = srunner_create(s);
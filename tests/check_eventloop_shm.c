@@ -0,0 +1,236 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/plugin/eventloop.h>
+#include <open62541/plugin/log_stdout.h>
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel_async.h>
+#include <open62541/server.h>
+#include <open62541/client.h>
+
+#include "testing_clock.h"
+#include <stdlib.h>
+#include <check.h>
+
+static UA_EventLoop *el;
+static unsigned connCount;
+static uintptr_t clientId;
+static uintptr_t serverId;
+static size_t receivedBytes;
+static UA_Boolean orderOk;
+
+/* The client connection has a non-NULL context. The payload is a byte
+ * sequence that is checked for the order. */
+static void
+connectionCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
+                   void *application, void **connectionContext,
+                   UA_ConnectionState status,
+                   const UA_KeyValueMap *params,
+                   UA_ByteString msg) {
+    if(status == UA_CONNECTIONSTATE_ESTABLISHED && msg.length == 0) {
+        connCount++;
+        if(*connectionContext != NULL)
+            clientId = connectionId;
+        else if(UA_KeyValueMap_contains(params, UA_QUALIFIEDNAME(0, "remote-address")))
+            serverId = connectionId;
+    }
+    if(status == UA_CONNECTIONSTATE_CLOSING)
+        connCount--;
+    for(size_t i = 0; i < msg.length; i++) {
+        if(msg.data[i] != (UA_Byte)((receivedBytes + i) % 251))
+            orderOk = false;
+    }
+    receivedBytes += msg.length;
+}
+
+static void
+runEventLoop(size_t iterations) {
+    for(size_t i = 0; i < iterations; i++) {
+        UA_DateTime next = el->run(el, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+    }
+}
+
+static void
+stopEventLoop(void) {
+    el->stop(el);
+    for(size_t i = 0; i < 100 && el->state != UA_EVENTLOOPSTATE_STOPPED; i++)
+        runEventLoop(1);
+    ck_assert(el->state == UA_EVENTLOOPSTATE_STOPPED);
+    ck_assert_uint_eq(connCount, 0);
+    el->free(el);
+    el = NULL;
+}
+
+static UA_ConnectionManager *
+setupConnection(UA_UInt32 ringSize) {
+    UA_ConnectionManager *cm = UA_ConnectionManager_new_POSIX_SHM(UA_STRING("shmCM"));
+    UA_KeyValueMap_setScalar(&cm->eventSource.params, UA_QUALIFIEDNAME(0, "ring-size"),
+                             &ringSize, &UA_TYPES[UA_TYPES_UINT32]);
+    el = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    el->registerEventSource(el, &cm->eventSource);
+    el->start(el);
+
+    UA_String name = UA_STRING("check_eventloop_shm");
+    UA_Boolean listen = true;
+    UA_KeyValuePair params[2];
+    params[0].key = UA_QUALIFIEDNAME(0, "address");
+    UA_Variant_setScalar(&params[0].value, &name, &UA_TYPES[UA_TYPES_STRING]);
+    params[1].key = UA_QUALIFIEDNAME(0, "listen");
+    UA_Variant_setScalar(&params[1].value, &listen, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    UA_KeyValueMap paramsMap = {2, params};
+
+    connCount = 0;
+    clientId = 0;
+    serverId = 0;
+    receivedBytes = 0;
+    orderOk = true;
+    UA_StatusCode retval =
+        cm->openConnection(cm, &paramsMap, NULL, NULL, connectionCallback);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(connCount, 1);
+
+    /* Open a client connection */
+    listen = false;
+    retval = cm->openConnection(cm, &paramsMap, NULL, (void*)0x01, connectionCallback);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < 10 && connCount < 3; i++)
+        runEventLoop(1);
+    ck_assert(clientId != 0);
+    ck_assert(serverId != 0);
+    ck_assert_uint_eq(connCount, 3);
+    return cm;
+}
+
+static void
+sendBytes(UA_ConnectionManager *cm, uintptr_t id, size_t offset, size_t length) {
+    UA_ByteString snd;
+    UA_StatusCode retval = cm->allocNetworkBuffer(cm, id, &snd, length);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    for(size_t j = 0; j < length; j++)
+        snd.data[j] = (UA_Byte)((offset + j) % 251);
+    retval = cm->sendWithConnection(cm, id, &UA_KEYVALUEMAP_NULL, &snd);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+}
+
+START_TEST(connectSHM) {
+    UA_ConnectionManager *cm = setupConnection(0);
+
+    /* Both directions */
+    sendBytes(cm, clientId, 0, 1000);
+    for(size_t i = 0; i < 10 && receivedBytes < 1000; i++)
+        runEventLoop(1);
+    ck_assert_uint_eq(receivedBytes, 1000);
+    sendBytes(cm, serverId, 1000, 1000);
+    for(size_t i = 0; i < 10 && receivedBytes < 2000; i++)
+        runEventLoop(1);
+    ck_assert_uint_eq(receivedBytes, 2000);
+    ck_assert(orderOk);
+
+    /* Closing the client connection also closes the server side */
+    cm->closeConnection(cm, clientId);
+    for(size_t i = 0; i < 10 && connCount > 1; i++)
+        runEventLoop(1);
+    ck_assert_uint_eq(connCount, 1);
+
+    stopEventLoop();
+} END_TEST
+
+/* Messages larger than the ring are queued and arrive in order */
+START_TEST(sendQueueSHM) {
+    UA_ConnectionManager *cm = setupConnection(4096);
+
+    size_t chunk = 10000;
+    size_t total = 0;
+    for(size_t i = 0; i < 20; i++) {
+        sendBytes(cm, clientId, total, chunk);
+        total += chunk;
+    }
+    ck_assert_uint_gt(cm->getSendQueueSize(cm, clientId), 0);
+
+    for(size_t i = 0; i < 1000 && receivedBytes < total; i++)
+        runEventLoop(1);
+    ck_assert_uint_eq(receivedBytes, total);
+    ck_assert_uint_eq(cm->getSendQueueSize(cm, clientId), 0);
+    ck_assert(orderOk);
+
+    stopEventLoop();
+} END_TEST
+
+static UA_Boolean readDone;
+
+static void
+readCallback(UA_Client *client, void *userdata, UA_UInt32 requestId,
+             UA_StatusCode status, UA_DataValue *value) {
+    ck_assert_uint_eq(status, UA_STATUSCODE_GOOD);
+    ck_assert(value->hasValue);
+    ck_assert(UA_Variant_isScalar(&value->value));
+    ck_assert_int_eq(*(UA_Int32*)value->value.data, UA_SERVERSTATE_RUNNING);
+    readDone = true;
+}
+
+/* A client reads from a server over a shared-memory endpoint */
+START_TEST(clientServerSHM) {
+    UA_Server *server = UA_Server_new();
+    UA_ServerConfig *sc = UA_Server_getConfig(server);
+    UA_Array_delete(sc->serverUrls, sc->serverUrlsSize, &UA_TYPES[UA_TYPES_STRING]);
+    UA_String url = UA_STRING("opc.shm://check_eventloop_shm_server");
+    UA_Array_copy(&url, 1, (void**)&sc->serverUrls, &UA_TYPES[UA_TYPES_STRING]);
+    sc->serverUrlsSize = 1;
+    ck_assert_uint_eq(UA_Server_run_startup(server), UA_STATUSCODE_GOOD);
+
+    UA_Client *client = UA_Client_new();
+    UA_ClientConfig_setDefault(UA_Client_getConfig(client));
+    UA_StatusCode retval =
+        UA_Client_connectAsync(client, "opc.shm://check_eventloop_shm_server");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_SessionState ss = UA_SESSIONSTATE_CLOSED;
+    for(size_t i = 0; i < 100 && ss != UA_SESSIONSTATE_ACTIVATED; i++) {
+        UA_Server_run_iterate(server, false);
+        UA_Client_run_iterate(client, 0);
+        UA_Client_getState(client, NULL, &ss, NULL);
+    }
+    ck_assert_uint_eq(ss, UA_SESSIONSTATE_ACTIVATED);
+
+    /* Read the server state */
+    readDone = false;
+    UA_UInt32 reqId = 0;
+    retval = UA_Client_readValueAttribute_async(
+        client, UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_STATE),
+        readCallback, NULL, &reqId);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < 100 && !readDone; i++) {
+        UA_Server_run_iterate(server, false);
+        UA_Client_run_iterate(client, 0);
+    }
+    ck_assert(readDone);
+
+    UA_Client_disconnectAsync(client);
+    for(size_t i = 0; i < 20 && ss != UA_SESSIONSTATE_CLOSED; i++) {
+        UA_Server_run_iterate(server, false);
+        UA_Client_run_iterate(client, 0);
+        UA_Client_getState(client, NULL, &ss, NULL);
+    }
+    UA_Client_delete(client);
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+} END_TEST
+
+int main(void) {
+    Suite *s  = suite_create("Test SHM EventLoop");
+    TCase *tc = tcase_create("test cases");
+    tcase_add_test(tc, connectSHM);
+    tcase_add_test(tc, sendQueueSHM);
+    tcase_add_test(tc, clientServerSHM);
+    suite_add_tcase(s, tc);
+
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all (sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -98,9 +98,16 @@ START_TEST(listenTCP) {
     ck_assert_uint_eq(connCount, 0);
 } END_TEST
 
+/* Run with the default epoll buffer and with only one socket event retrieved
+ * per EventLoop iteration */
 START_TEST(connectTCP) {
     UA_ConnectionManager *cm = UA_ConnectionManager_new_POSIX_TCP(UA_STRING("tcpCM"));
     el = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    if(_i == 1) {
+        UA_UInt32 maxEvents = 1;
+        UA_KeyValueMap_setScalar(&el->params, UA_QUALIFIEDNAME(0, "epoll-maxevents"),
+                                 &maxEvents, &UA_TYPES[UA_TYPES_UINT32]);
+    }
     el->registerEventSource(el, &cm->eventSource);
     el->start(el);
 
@@ -133,7 +140,7 @@ START_TEST(connectTCP) {
     UA_StatusCode retval =
         cm->openConnection(cm, &paramsMap, NULL, (void*)0x01, connectionCallback);
     ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
-    for(size_t i = 0; i < 2; i++) {
+    for(size_t i = 0; i < 10 && connCount < listenSockets + 2; i++) {
         UA_DateTime next = el->run(el, 1);
         UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
     }
@@ -149,7 +156,7 @@ START_TEST(connectTCP) {
     memcpy(snd.data, testMsg, strlen(testMsg));
     retval = cm->sendWithConnection(cm, clientId, NULL, &snd);
     ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
-    for(size_t i = 0; i < 2; i++) {
+    for(size_t i = 0; i < 10 && !received; i++) {
         UA_DateTime next = el->run(el, 1);
         UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
     }
@@ -159,7 +166,7 @@ START_TEST(connectTCP) {
     retval = cm->closeConnection(cm, clientId);
     ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
     ck_assert_uint_eq(connCount, listenSockets + 2);
-    for(size_t i = 0; i < 2; i++) {
+    for(size_t i = 0; i < 10 && connCount > listenSockets; i++) {
         UA_DateTime next = el->run(el, 1);
         UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
     }
@@ -180,11 +187,469 @@ START_TEST(connectTCP) {
     el = NULL;
 } END_TEST
 
+/* Messages are received while the EventLoop busy-polls the sockets */
+START_TEST(connectTCPBusyPoll) {
+    UA_ConnectionManager *cm = UA_ConnectionManager_new_POSIX_TCP(UA_STRING("tcpCM"));
+    el = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    UA_UInt32 busyPoll = 1000; /* 1ms */
+    UA_KeyValueMap_setScalar(&el->params, UA_QUALIFIEDNAME(0, "busy-poll"),
+                             &busyPoll, &UA_TYPES[UA_TYPES_UINT32]);
+    el->registerEventSource(el, &cm->eventSource);
+    el->start(el);
+
+    UA_UInt16 port = 4840;
+    UA_Boolean listen = true;
+    UA_String host = UA_STRING("localhost");
+
+    UA_KeyValuePair params[3];
+    params[0].key = UA_QUALIFIEDNAME(0, "port");
+    UA_Variant_setScalar(&params[0].value, &port, &UA_TYPES[UA_TYPES_UINT16]);
+    params[1].key = UA_QUALIFIEDNAME(0, "listen");
+    UA_Variant_setScalar(&params[1].value, &listen, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    params[2].key = UA_QUALIFIEDNAME(0, "address");
+    UA_Variant_setScalar(&params[2].value, &host, &UA_TYPES[UA_TYPES_STRING]);
+
+    UA_KeyValueMap paramsMap;
+    paramsMap.map = params;
+    paramsMap.mapSize = 3;
+
+    connCount = 0;
+    cm->openConnection(cm, &paramsMap, NULL, NULL, connectionCallback);
+    size_t listenSockets = connCount;
+
+    /* Open a client connection */
+    clientId = 0;
+    listen = false;
+    UA_StatusCode retval =
+        cm->openConnection(cm, &paramsMap, NULL, (void*)0x01, connectionCallback);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < 10 && connCount < listenSockets + 2; i++)
+        el->run(el, 1);
+    ck_assert(clientId != 0);
+    ck_assert_uint_eq(connCount, listenSockets + 2);
+
+    /* Send several messages from the client. They are picked up while
+     * spinning. */
+    for(size_t m = 0; m < 3; m++) {
+        received = false;
+        UA_ByteString snd;
+        retval = cm->allocNetworkBuffer(cm, clientId, &snd, strlen(testMsg));
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        memcpy(snd.data, testMsg, strlen(testMsg));
+        retval = cm->sendWithConnection(cm, clientId, NULL, &snd);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        for(size_t i = 0; i < 10 && !received; i++)
+            el->run(el, 1);
+        ck_assert(received);
+    }
+
+    /* Idle sockets: the EventLoop returns after the timeout */
+    UA_DateTime before = el->dateTime_nowMonotonic(el);
+    el->run(el, 10);
+    ck_assert(el->dateTime_nowMonotonic(el) - before < UA_DATETIME_SEC);
+
+    /* Stop the EventLoop */
+    el->stop(el);
+    for(size_t i = 0; i < 100 && el->state != UA_EVENTLOOPSTATE_STOPPED; i++)
+        el->run(el, 1);
+    ck_assert(el->state == UA_EVENTLOOPSTATE_STOPPED);
+    ck_assert_uint_eq(connCount, 0);
+    el->free(el);
+    el = NULL;
+} END_TEST
+
+static size_t receivedBytes;
+
+static void
+countingCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
+                 void *application, void **connectionContext,
+                 UA_ConnectionState status,
+                 const UA_KeyValueMap *params,
+                 UA_ByteString msg) {
+    if(*connectionContext != NULL)
+        clientId = connectionId;
+    if(msg.length == 0 && status == UA_CONNECTIONSTATE_ESTABLISHED)
+        connCount++;
+    if(status == UA_CONNECTIONSTATE_CLOSING)
+        connCount--;
+
+    /* The bytes arrive in order */
+    for(size_t i = 0; i < msg.length; i++)
+        ck_assert_uint_eq(msg.data[i], (UA_Byte)((receivedBytes + i) % 251));
+    receivedBytes += msg.length;
+}
+
+/* Sending to a peer that does not read returns right away. The data is queued
+ * and flushed once the peer reads. */
+START_TEST(sendQueueTCP) {
+    UA_ConnectionManager *cm = UA_ConnectionManager_new_POSIX_TCP(UA_STRING("tcpCM"));
+    UA_UInt32 queueSize = 1u << 26; /* 64MB */
+    UA_KeyValueMap_setScalar(&cm->eventSource.params,
+                             UA_QUALIFIEDNAME(0, "send-queue-size"),
+                             &queueSize, &UA_TYPES[UA_TYPES_UINT32]);
+    el = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    el->registerEventSource(el, &cm->eventSource);
+    el->start(el);
+
+    UA_UInt16 port = 4840;
+    UA_Boolean listen = true;
+    UA_String host = UA_STRING("localhost");
+
+    UA_KeyValuePair params[3];
+    params[0].key = UA_QUALIFIEDNAME(0, "port");
+    UA_Variant_setScalar(&params[0].value, &port, &UA_TYPES[UA_TYPES_UINT16]);
+    params[1].key = UA_QUALIFIEDNAME(0, "listen");
+    UA_Variant_setScalar(&params[1].value, &listen, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    params[2].key = UA_QUALIFIEDNAME(0, "address");
+    UA_Variant_setScalar(&params[2].value, &host, &UA_TYPES[UA_TYPES_STRING]);
+
+    UA_KeyValueMap paramsMap;
+    paramsMap.map = params;
+    paramsMap.mapSize = 3;
+
+    connCount = 0;
+    cm->openConnection(cm, &paramsMap, NULL, NULL, countingCallback);
+    size_t listenSockets = connCount;
+
+    /* Open a client connection */
+    clientId = 0;
+    listen = false;
+    UA_StatusCode retval =
+        cm->openConnection(cm, &paramsMap, NULL, (void*)0x01, countingCallback);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < 10 && connCount < listenSockets + 2; i++) {
+        UA_DateTime next = el->run(el, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+    }
+    ck_assert(clientId != 0);
+    ck_assert_uint_eq(connCount, listenSockets + 2);
+
+    /* Send more than the socket buffers can hold without running the
+     * EventLoop. Nothing is read on the server side in the meantime. */
+    receivedBytes = 0;
+    size_t chunk = 1u << 16;
+    size_t total = 0;
+    for(size_t i = 0; i < 512; i++) {
+        UA_ByteString snd;
+        retval = cm->allocNetworkBuffer(cm, clientId, &snd, chunk);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        for(size_t j = 0; j < chunk; j++)
+            snd.data[j] = (UA_Byte)((total + j) % 251);
+        retval = cm->sendWithConnection(cm, clientId, NULL, &snd);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        total += chunk;
+    }
+    ck_assert_uint_gt(cm->getSendQueueSize(cm, clientId), 0);
+
+    /* Run the EventLoop until everything has arrived */
+    for(size_t i = 0; i < 10000 && receivedBytes < total; i++)
+        el->run(el, 1);
+    ck_assert_uint_eq(receivedBytes, total);
+    ck_assert_uint_eq(cm->getSendQueueSize(cm, clientId), 0);
+
+    /* Stop the EventLoop */
+    el->stop(el);
+    for(size_t i = 0; i < 100 && el->state != UA_EVENTLOOPSTATE_STOPPED; i++) {
+        UA_DateTime next = el->run(el, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+    }
+    ck_assert(el->state == UA_EVENTLOOPSTATE_STOPPED);
+    ck_assert_uint_eq(connCount, 0);
+    el->free(el);
+    el = NULL;
+} END_TEST
+
+/* A connection is read several times per event, up to recv-max-reads */
+START_TEST(maxReadsTCP) {
+    UA_ConnectionManager *cm = UA_ConnectionManager_new_POSIX_TCP(UA_STRING("tcpCM"));
+    UA_UInt32 recvBufSize = 1024;
+    UA_KeyValueMap_setScalar(&cm->eventSource.params,
+                             UA_QUALIFIEDNAME(0, "recv-bufsize"),
+                             &recvBufSize, &UA_TYPES[UA_TYPES_UINT32]);
+    UA_UInt32 maxReads = 4;
+    UA_KeyValueMap_setScalar(&cm->eventSource.params,
+                             UA_QUALIFIEDNAME(0, "recv-max-reads"),
+                             &maxReads, &UA_TYPES[UA_TYPES_UINT32]);
+    el = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    el->registerEventSource(el, &cm->eventSource);
+    el->start(el);
+
+    UA_UInt16 port = 4840;
+    UA_Boolean listen = true;
+    UA_String host = UA_STRING("localhost");
+
+    UA_KeyValuePair params[3];
+    params[0].key = UA_QUALIFIEDNAME(0, "port");
+    UA_Variant_setScalar(&params[0].value, &port, &UA_TYPES[UA_TYPES_UINT16]);
+    params[1].key = UA_QUALIFIEDNAME(0, "listen");
+    UA_Variant_setScalar(&params[1].value, &listen, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    params[2].key = UA_QUALIFIEDNAME(0, "address");
+    UA_Variant_setScalar(&params[2].value, &host, &UA_TYPES[UA_TYPES_STRING]);
+
+    UA_KeyValueMap paramsMap;
+    paramsMap.map = params;
+    paramsMap.mapSize = 3;
+
+    connCount = 0;
+    cm->openConnection(cm, &paramsMap, NULL, NULL, countingCallback);
+    size_t listenSockets = connCount;
+
+    /* Open a client connection */
+    clientId = 0;
+    listen = false;
+    UA_StatusCode retval =
+        cm->openConnection(cm, &paramsMap, NULL, (void*)0x01, countingCallback);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < 10 && connCount < listenSockets + 2; i++)
+        el->run(el, 1);
+    ck_assert(clientId != 0);
+    ck_assert_uint_eq(connCount, listenSockets + 2);
+
+    /* Send more than fits into the receive buffer */
+    receivedBytes = 0;
+    size_t total = 16 * recvBufSize;
+    UA_ByteString snd;
+    retval = cm->allocNetworkBuffer(cm, clientId, &snd, total);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    for(size_t j = 0; j < total; j++)
+        snd.data[j] = (UA_Byte)(j % 251);
+    retval = cm->sendWithConnection(cm, clientId, NULL, &snd);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Several reads in one iteration, but not more than the limit */
+    for(size_t i = 0; i < 10 && receivedBytes == 0; i++)
+        el->run(el, 1);
+    ck_assert_uint_gt(receivedBytes, recvBufSize);
+    ck_assert_uint_le(receivedBytes, maxReads * recvBufSize);
+
+    /* The remainder arrives in the next iterations */
+    for(size_t i = 0; i < 100 && receivedBytes < total; i++)
+        el->run(el, 1);
+    ck_assert_uint_eq(receivedBytes, total);
+
+    /* Stop the EventLoop */
+    el->stop(el);
+    for(size_t i = 0; i < 100 && el->state != UA_EVENTLOOPSTATE_STOPPED; i++)
+        el->run(el, 1);
+    ck_assert(el->state == UA_EVENTLOOPSTATE_STOPPED);
+    ck_assert_uint_eq(connCount, 0);
+    el->free(el);
+    el = NULL;
+} END_TEST
+
+static unsigned acceptedCount;
+
+static void
+acceptingCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
+                  void *application, void **connectionContext,
+                  UA_ConnectionState status,
+                  const UA_KeyValueMap *params,
+                  UA_ByteString msg) {
+    if(msg.length == 0 && status == UA_CONNECTIONSTATE_ESTABLISHED)
+        connCount++;
+    if(status == UA_CONNECTIONSTATE_CLOSING)
+        connCount--;
+
+    /* Only the connections accepted by the server socket have the
+     * remote-address parameter */
+    if(msg.length == 0 && status == UA_CONNECTIONSTATE_ESTABLISHED &&
+       UA_KeyValueMap_contains(params, UA_QUALIFIEDNAME(0, "remote-address")))
+        acceptedCount++;
+}
+
+/* Connections from the same address beyond the accept-rate-limit are closed
+ * right away */
+START_TEST(acceptRateLimitTCP) {
+    UA_ConnectionManager *cm = UA_ConnectionManager_new_POSIX_TCP(UA_STRING("tcpCM"));
+    UA_UInt32 rateLimit = 2;
+    UA_KeyValueMap_setScalar(&cm->eventSource.params,
+                             UA_QUALIFIEDNAME(0, "accept-rate-limit"),
+                             &rateLimit, &UA_TYPES[UA_TYPES_UINT32]);
+    el = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    el->registerEventSource(el, &cm->eventSource);
+    el->start(el);
+
+    /* The rejected connections are closed by the server side first and
+     * remain in TIME_WAIT. Don't block the port for the other tests. */
+    UA_UInt16 port = 4841;
+    UA_Boolean listen = true;
+    UA_String host = UA_STRING("localhost");
+
+    UA_KeyValuePair params[3];
+    params[0].key = UA_QUALIFIEDNAME(0, "port");
+    UA_Variant_setScalar(&params[0].value, &port, &UA_TYPES[UA_TYPES_UINT16]);
+    params[1].key = UA_QUALIFIEDNAME(0, "listen");
+    UA_Variant_setScalar(&params[1].value, &listen, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    params[2].key = UA_QUALIFIEDNAME(0, "address");
+    UA_Variant_setScalar(&params[2].value, &host, &UA_TYPES[UA_TYPES_STRING]);
+
+    UA_KeyValueMap paramsMap;
+    paramsMap.map = params;
+    paramsMap.mapSize = 3;
+
+    connCount = 0;
+    acceptedCount = 0;
+    cm->openConnection(cm, &paramsMap, NULL, NULL, acceptingCallback);
+
+    /* Open several client connections at once */
+    listen = false;
+    for(size_t i = 0; i < 5; i++) {
+        UA_StatusCode retval =
+            cm->openConnection(cm, &paramsMap, NULL, (void*)0x01, acceptingCallback);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+    for(size_t i = 0; i < 20; i++)
+        el->run(el, 1);
+    ck_assert_uint_eq(acceptedCount, 2);
+
+    /* Stop the EventLoop */
+    el->stop(el);
+    for(size_t i = 0; i < 100 && el->state != UA_EVENTLOOPSTATE_STOPPED; i++)
+        el->run(el, 1);
+    ck_assert(el->state == UA_EVENTLOOPSTATE_STOPPED);
+    ck_assert_uint_eq(connCount, 0);
+    el->free(el);
+    el = NULL;
+} END_TEST
+
+static UA_ByteString retainedMsg;
+
+static void
+retainingCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
+                  void *application, void **connectionContext,
+                  UA_ConnectionState status,
+                  const UA_KeyValueMap *params,
+                  UA_ByteString msg) {
+    if(*connectionContext != NULL)
+        clientId = connectionId;
+    if(msg.length == 0 && status == UA_CONNECTIONSTATE_ESTABLISHED)
+        connCount++;
+    if(status == UA_CONNECTIONSTATE_CLOSING)
+        connCount--;
+    if(msg.length == 0)
+        return;
+
+    /* Keep the part after the first byte beyond the callback */
+    UA_ByteString part = {msg.length - 1, msg.data + 1};
+    UA_StatusCode res = cm->retainNetworkBuffer(cm, connectionId, &part);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    retainedMsg = part;
+    received = true;
+}
+
+/* Send and receive with buffers from the pool */
+START_TEST(bufferPoolTCP) {
+    UA_ConnectionManager *cm = UA_ConnectionManager_new_POSIX_TCP(UA_STRING("tcpCM"));
+    el = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    UA_UInt32 poolSize = 4;
+    UA_KeyValueMap_setScalar(&el->params, UA_QUALIFIEDNAME(0, "buffer-pool-size"),
+                             &poolSize, &UA_TYPES[UA_TYPES_UINT32]);
+    el->registerEventSource(el, &cm->eventSource);
+    el->start(el);
+
+    UA_EventLoopStatistics stats;
+    el->getStatistics(el, &stats);
+    ck_assert_uint_eq(stats.networkBuffers, 4);
+    ck_assert_uint_eq(stats.networkBuffersInUse, 0);
+
+    UA_UInt16 port = 4840;
+    UA_Boolean listen = true;
+    UA_String host = UA_STRING("localhost");
+
+    UA_KeyValuePair params[3];
+    params[0].key = UA_QUALIFIEDNAME(0, "port");
+    UA_Variant_setScalar(&params[0].value, &port, &UA_TYPES[UA_TYPES_UINT16]);
+    params[1].key = UA_QUALIFIEDNAME(0, "listen");
+    UA_Variant_setScalar(&params[1].value, &listen, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    params[2].key = UA_QUALIFIEDNAME(0, "address");
+    UA_Variant_setScalar(&params[2].value, &host, &UA_TYPES[UA_TYPES_STRING]);
+
+    UA_KeyValueMap paramsMap;
+    paramsMap.map = params;
+    paramsMap.mapSize = 3;
+
+    connCount = 0;
+    cm->openConnection(cm, &paramsMap, NULL, NULL, retainingCallback);
+    size_t listenSockets = connCount;
+
+    /* Open a client connection */
+    clientId = 0;
+    listen = false;
+    UA_StatusCode retval =
+        cm->openConnection(cm, &paramsMap, NULL, (void*)0x01, retainingCallback);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < 10 && connCount < listenSockets + 2; i++) {
+        UA_DateTime next = el->run(el, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+    }
+    ck_assert(clientId != 0);
+
+    /* The send buffer is taken from the pool and returned after sending */
+    received = false;
+    UA_ByteString snd;
+    retval = cm->allocNetworkBuffer(cm, clientId, &snd, strlen(testMsg));
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    el->getStatistics(el, &stats);
+    ck_assert_uint_eq(stats.networkBuffersInUse, 1);
+    memcpy(snd.data, testMsg, strlen(testMsg));
+    retval = cm->sendWithConnection(cm, clientId, NULL, &snd);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    el->getStatistics(el, &stats);
+    ck_assert_uint_eq(stats.networkBuffersInUse, 0);
+
+    /* The received buffer is retained until it is freed */
+    for(size_t i = 0; i < 10 && !received; i++) {
+        UA_DateTime next = el->run(el, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+    }
+    ck_assert(received);
+    UA_ByteString expected = UA_BYTESTRING(testMsg + 1);
+    ck_assert(UA_ByteString_equal(&retainedMsg, &expected));
+    el->getStatistics(el, &stats);
+    ck_assert_uint_eq(stats.networkBuffersInUse, 1);
+    cm->freeNetworkBuffer(cm, clientId, &retainedMsg);
+    el->getStatistics(el, &stats);
+    ck_assert_uint_eq(stats.networkBuffersInUse, 0);
+
+    /* Exhaust the pool. Then the buffers are allocated individually and cannot
+     * be retained. */
+    UA_ByteString bufs[5];
+    for(size_t i = 0; i < 5; i++) {
+        retval = cm->allocNetworkBuffer(cm, clientId, &bufs[i], 1000);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+    el->getStatistics(el, &stats);
+    ck_assert_uint_eq(stats.networkBuffersInUse, 4);
+    ck_assert_uint_eq(stats.networkBufferPoolMisses, 1);
+    ck_assert_uint_eq(cm->retainNetworkBuffer(cm, clientId, &bufs[4]),
+                      UA_STATUSCODE_BADNOTSUPPORTED);
+    for(size_t i = 0; i < 5; i++)
+        cm->freeNetworkBuffer(cm, clientId, &bufs[i]);
+    el->getStatistics(el, &stats);
+    ck_assert_uint_eq(stats.networkBuffersInUse, 0);
+
+    /* Stop the EventLoop */
+    el->stop(el);
+    for(size_t i = 0; i < 100 && el->state != UA_EVENTLOOPSTATE_STOPPED; i++) {
+        UA_DateTime next = el->run(el, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+    }
+    ck_assert(el->state == UA_EVENTLOOPSTATE_STOPPED);
+    ck_assert_uint_eq(connCount, 0);
+    el->free(el);
+    el = NULL;
+} END_TEST
+
 int main(void) {
     Suite *s  = suite_create("Test TCP EventLoop");
     TCase *tc = tcase_create("test cases");
     tcase_add_test(tc, listenTCP);
-    tcase_add_test(tc, connectTCP);
+    tcase_add_loop_test(tc, connectTCP, 0, 2);
+    tcase_add_test(tc, connectTCPBusyPoll);
+    tcase_add_test(tc, sendQueueTCP);
+    tcase_add_test(tc, maxReadsTCP);
+    tcase_add_test(tc, acceptRateLimitTCP);
+    tcase_add_test(tc, bufferPoolTCP);
     suite_add_tcase(s, tc);
 
     SRunner *sr = srunner_create(s);
@@ -16,6 +16,7 @@ static UA_EventLoop *el;
 static char *testMsg = "open62541";
 static uintptr_t clientId;
 static UA_Boolean received;
+static size_t receivedCount;
 
 typedef struct TestContext {
     unsigned connCount;
@@ -62,6 +63,7 @@ connectionCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
         UA_ByteString rcv = UA_BYTESTRING(testMsg);
         ck_assert(UA_String_equal(&msg, &rcv));
         received = true;
+        receivedCount++;
     }
 }
 
@@ -394,6 +396,255 @@ START_TEST(udpTalkerAndListener) {
     ck_assert_uint_eq(testContext.connCount, 0);
 } END_TEST
 
+/* Send several datagrams in one call and receive them with a single batched
+ * read on the listener side */
+START_TEST(udpTalkerAndListenerBatch) {
+    UA_EventLoop *elListener = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    UA_ConnectionManager *cmListener = UA_ConnectionManager_new_POSIX_UDP(UA_STRING("udpCM"));
+    UA_UInt32 batchSize = 16;
+    UA_KeyValueMap_setScalar(&cmListener->eventSource.params,
+                             UA_QUALIFIEDNAME(0, "recv-batchsize"),
+                             &batchSize, &UA_TYPES[UA_TYPES_UINT32]);
+    elListener->registerEventSource(elListener, &cmListener->eventSource);
+    elListener->start(elListener);
+
+    UA_EventLoop *elTalker = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    UA_ConnectionManager *cmTalker = UA_ConnectionManager_new_POSIX_UDP(UA_STRING("udpCM"));
+    elTalker->registerEventSource(elTalker, &cmTalker->eventSource);
+    elTalker->start(elTalker);
+
+    /* Open a listener connection */
+    UA_UInt16 port = 30000;
+    UA_Boolean listen = true;
+
+    UA_KeyValuePair params[3];
+    UA_KeyValueMap paramsMap = {2, params};
+    params[0].key = UA_QUALIFIEDNAME(0, "port");
+    UA_Variant_setScalar(&params[0].value, &port, &UA_TYPES[UA_TYPES_UINT16]);
+    params[1].key = UA_QUALIFIEDNAME(0, "listen");
+    UA_Variant_setScalar(&params[1].value, &listen, &UA_TYPES[UA_TYPES_BOOLEAN]);
+
+    TestContext testContext;
+    testContext.connCount = 0;
+
+    UA_StatusCode retval =
+        cmListener->openConnection(cmListener, &paramsMap, NULL, &testContext,
+                                   connectionCallback);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    size_t listenSockets = testContext.connCount;
+
+    /* Open a talker connection */
+    clientId = 0;
+    listen = false;
+    UA_String targetHost = UA_STRING("localhost");
+    params[2].key = UA_QUALIFIEDNAME(0, "address");
+    UA_Variant_setScalar(&params[2].value, &targetHost, &UA_TYPES[UA_TYPES_STRING]);
+    paramsMap.mapSize = 3;
+    retval = cmTalker->openConnection(cmTalker, &paramsMap, NULL, &testContext,
+                                      connectionCallback);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < 2; i++) {
+        UA_DateTime next = elTalker->run(elTalker, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+    }
+    ck_assert_uint_ne(clientId, 0);
+    ck_assert_uint_eq(testContext.connCount, listenSockets + 1);
+
+    /* Send a batch of datagrams from the talker */
+    ck_assert(cmTalker->sendWithConnectionV != NULL);
+    UA_ByteString snd[8];
+    for(size_t i = 0; i < 8; i++) {
+        retval = cmTalker->allocNetworkBuffer(cmTalker, clientId, &snd[i],
+                                              strlen(testMsg));
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        memcpy(snd[i].data, testMsg, strlen(testMsg));
+    }
+    received = false;
+    receivedCount = 0;
+    retval = cmTalker->sendWithConnectionV(cmTalker, clientId,
+                                           &UA_KEYVALUEMAP_NULL, snd, 8);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < 2 && receivedCount < 8; i++) {
+        UA_DateTime next = elListener->run(elListener, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+    }
+    ck_assert_uint_eq(receivedCount, 8);
+
+    /* Close the connection */
+    retval = cmTalker->closeConnection(cmTalker, clientId);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < 2; i++) {
+        UA_DateTime next = elTalker->run(elTalker, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+    }
+    ck_assert_uint_eq(testContext.connCount, listenSockets);
+
+    /* Stop the EventLoops */
+    elTalker->stop(elTalker);
+    for(int i = 0; i < 10 && elTalker->state != UA_EVENTLOOPSTATE_STOPPED; i++) {
+        UA_DateTime next = elTalker->run(elTalker, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+    }
+    ck_assert_int_eq(elTalker->state, UA_EVENTLOOPSTATE_STOPPED);
+    elTalker->free(elTalker);
+
+    elListener->stop(elListener);
+    for(int i = 0; i < 10 && elListener->state != UA_EVENTLOOPSTATE_STOPPED; i++) {
+        UA_DateTime next = elListener->run(elListener, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+    }
+    ck_assert_int_eq(elListener->state, UA_EVENTLOOPSTATE_STOPPED);
+    elListener->free(elListener);
+
+    ck_assert_uint_eq(testContext.connCount, 0);
+} END_TEST
+
+#ifdef __linux__
+START_TEST(udpTalkerAndListenerTxtime) {
+    UA_EventLoop *elListener = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    UA_ConnectionManager *cmListener = UA_ConnectionManager_new_POSIX_UDP(UA_STRING("udpCM"));
+    elListener->registerEventSource(elListener, &cmListener->eventSource);
+    elListener->start(elListener);
+
+    /* Unprivileged processes can use SO_TXTIME only with CLOCK_MONOTONIC */
+    UA_EventLoop *elTalker = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    UA_Int32 clockSource = CLOCK_MONOTONIC;
+    UA_KeyValueMap_setScalar(&elTalker->params,
+                             UA_QUALIFIEDNAME(0, "clock-source-monotonic"),
+                             &clockSource, &UA_TYPES[UA_TYPES_INT32]);
+    UA_ConnectionManager *cmTalker = UA_ConnectionManager_new_POSIX_UDP(UA_STRING("udpCM"));
+    elTalker->registerEventSource(elTalker, &cmTalker->eventSource);
+    elTalker->start(elTalker);
+
+    /* Open a listener connection */
+    UA_UInt16 port = 30000;
+    UA_Boolean listen = true;
+
+    UA_KeyValuePair params[4];
+    UA_KeyValueMap paramsMap = {2, params};
+    params[0].key = UA_QUALIFIEDNAME(0, "port");
+    UA_Variant_setScalar(&params[0].value, &port, &UA_TYPES[UA_TYPES_UINT16]);
+    params[1].key = UA_QUALIFIEDNAME(0, "listen");
+    UA_Variant_setScalar(&params[1].value, &listen, &UA_TYPES[UA_TYPES_BOOLEAN]);
+
+    TestContext testContext;
+    testContext.connCount = 0;
+
+    UA_StatusCode retval =
+        cmListener->openConnection(cmListener, &paramsMap, NULL, &testContext,
+                                   connectionCallback);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    size_t listenSockets = testContext.connCount;
+
+    /* Open a talker connection without txtime */
+    clientId = 0;
+    listen = false;
+    UA_String targetHost = UA_STRING("localhost");
+    params[2].key = UA_QUALIFIEDNAME(0, "address");
+    UA_Variant_setScalar(&params[2].value, &targetHost, &UA_TYPES[UA_TYPES_STRING]);
+    paramsMap.mapSize = 3;
+    retval = cmTalker->openConnection(cmTalker, &paramsMap, NULL, &testContext,
+                                      connectionCallback);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < 2; i++) {
+        UA_DateTime next = elTalker->run(elTalker, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+    }
+    ck_assert_uint_ne(clientId, 0);
+    uintptr_t plainId = clientId;
+
+    /* Sending with a txtime fails if not enabled for the connection */
+    UA_DateTime txtime = elTalker->dateTime_nowMonotonic(elTalker) + UA_DATETIME_MSEC;
+    UA_KeyValuePair sendParams[1];
+    UA_KeyValueMap sendParamsMap = {1, sendParams};
+    sendParams[0].key = UA_QUALIFIEDNAME(0, "txtime");
+    UA_Variant_setScalar(&sendParams[0].value, &txtime, &UA_TYPES[UA_TYPES_DATETIME]);
+    UA_ByteString snd;
+    retval = cmTalker->allocNetworkBuffer(cmTalker, plainId, &snd, strlen(testMsg));
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    memcpy(snd.data, testMsg, strlen(testMsg));
+    retval = cmTalker->sendWithConnection(cmTalker, plainId, &sendParamsMap, &snd);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADINTERNALERROR);
+
+    /* Open a talker connection with txtime */
+    clientId = 0;
+    UA_Boolean txtimeEnable = true;
+    params[3].key = UA_QUALIFIEDNAME(0, "txtime-enable");
+    UA_Variant_setScalar(&params[3].value, &txtimeEnable, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    paramsMap.mapSize = 4;
+    retval = cmTalker->openConnection(cmTalker, &paramsMap, NULL, &testContext,
+                                      connectionCallback);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < 2; i++) {
+        UA_DateTime next = elTalker->run(elTalker, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+    }
+    ck_assert_uint_ne(clientId, 0);
+    ck_assert_uint_eq(testContext.connCount, listenSockets + 2);
+
+    /* Send with a txtime. Without a txtime-aware qdisc the datagram leaves
+     * right away. */
+    retval = cmTalker->allocNetworkBuffer(cmTalker, clientId, &snd, strlen(testMsg));
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    memcpy(snd.data, testMsg, strlen(testMsg));
+    received = false;
+    receivedCount = 0;
+    retval = cmTalker->sendWithConnection(cmTalker, clientId, &sendParamsMap, &snd);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Send a batch with the same txtime */
+    if(cmTalker->sendWithConnectionV) {
+        UA_ByteString sndV[4];
+        for(size_t i = 0; i < 4; i++) {
+            retval = cmTalker->allocNetworkBuffer(cmTalker, clientId, &sndV[i],
+                                                  strlen(testMsg));
+            ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+            memcpy(sndV[i].data, testMsg, strlen(testMsg));
+        }
+        retval = cmTalker->sendWithConnectionV(cmTalker, clientId,
+                                               &sendParamsMap, sndV, 4);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+
+    size_t expected = (cmTalker->sendWithConnectionV) ? 5 : 1;
+    for(size_t i = 0; i < 10 && receivedCount < expected; i++) {
+        UA_DateTime next = elListener->run(elListener, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+    }
+    ck_assert_uint_eq(receivedCount, expected);
+
+    /* Close the connections */
+    retval = cmTalker->closeConnection(cmTalker, clientId);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    retval = cmTalker->closeConnection(cmTalker, plainId);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < 2; i++) {
+        UA_DateTime next = elTalker->run(elTalker, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+    }
+    ck_assert_uint_eq(testContext.connCount, listenSockets);
+
+    /* Stop the EventLoops */
+    elTalker->stop(elTalker);
+    for(int i = 0; i < 10 && elTalker->state != UA_EVENTLOOPSTATE_STOPPED; i++) {
+        UA_DateTime next = elTalker->run(elTalker, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+    }
+    ck_assert_int_eq(elTalker->state, UA_EVENTLOOPSTATE_STOPPED);
+    elTalker->free(elTalker);
+
+    elListener->stop(elListener);
+    for(int i = 0; i < 10 && elListener->state != UA_EVENTLOOPSTATE_STOPPED; i++) {
+        UA_DateTime next = elListener->run(elListener, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+    }
+    ck_assert_int_eq(elListener->state, UA_EVENTLOOPSTATE_STOPPED);
+    elListener->free(elListener);
+
+    ck_assert_uint_eq(testContext.connCount, 0);
+} END_TEST
+#endif
+
 START_TEST(udpTalkerAndListenerDifferentDestination) {
     /* create listener eventloop */
     UA_EventLoop *elListener = UA_EventLoop_new_POSIX(UA_Log_Stdout);
@@ -525,6 +776,10 @@ int main(void) {
     tcase_add_test(tc, connectUDPValidationFails);
     tcase_add_test(tc, connectUDPValidationSucceeds);
     tcase_add_test(tc, udpTalkerAndListener);
+    tcase_add_test(tc, udpTalkerAndListenerBatch);
+#ifdef __linux__
+    tcase_add_test(tc, udpTalkerAndListenerTxtime);
+#endif
     tcase_add_test(tc, udpTalkerAndListenerDifferentDestination);
     suite_add_tcase(s, tc);
 
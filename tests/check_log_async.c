@@ -0,0 +1,129 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/types.h>
+#include <open62541/plugin/log_async.h>
+
+#include <check.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define THREADS 4
+#define THREAD_MESSAGES 1000
+
+/* Redirect stdout into a temporary file */
+static FILE *captured;
+static int savedStdout;
+
+static void
+captureStdout(void) {
+    fflush(stdout);
+    captured = tmpfile();
+    ck_assert(captured != NULL);
+    savedStdout = dup(STDOUT_FILENO);
+    dup2(fileno(captured), STDOUT_FILENO);
+}
+
+static void
+restoreStdout(void) {
+    fflush(stdout);
+    dup2(savedStdout, STDOUT_FILENO);
+    close(savedStdout);
+    rewind(captured);
+}
+
+START_TEST(Log_Async_order) {
+    UA_Logger *logger = UA_Log_Async_new(UA_LOGLEVEL_INFO, 256);
+    ck_assert(logger != NULL);
+
+    captureStdout();
+    for(int i = 0; i < 100; i++)
+        UA_LOG_INFO(logger, UA_LOGCATEGORY_USERLAND, "message %i", i);
+    UA_LOG_DEBUG(logger, UA_LOGCATEGORY_USERLAND, "filtered");
+    UA_Log_Async_flush(logger);
+    restoreStdout();
+
+    size_t written, dropped;
+    UA_Log_Async_getStatistics(logger, &written, &dropped);
+    ck_assert_uint_eq(written, 100);
+    ck_assert_uint_eq(dropped, 0);
+
+    /* The messages are written in order */
+    char line[256];
+    int expected = 0;
+    while(fgets(line, sizeof(line), captured)) {
+        ck_assert(strstr(line, "userland") != NULL);
+        ck_assert(strstr(line, "filtered") == NULL);
+        char *msg = strstr(line, "message ");
+        ck_assert(msg != NULL);
+        ck_assert_int_eq(atoi(msg + strlen("message ")), expected);
+        expected++;
+    }
+    ck_assert_int_eq(expected, 100);
+    fclose(captured);
+
+    logger->clear(logger);
+} END_TEST
+
+static void *
+logThread(void *logger) {
+    for(int i = 0; i < THREAD_MESSAGES; i++)
+        UA_LOG_INFO((UA_Logger*)logger, UA_LOGCATEGORY_USERLAND, "message %i", i);
+    return NULL;
+}
+
+/* Concurrent logging into a small ring buffer. Every message is either
+ * written or counted as dropped. */
+START_TEST(Log_Async_concurrent) {
+    UA_Logger *logger = UA_Log_Async_new(UA_LOGLEVEL_INFO, 64);
+    ck_assert(logger != NULL);
+
+    captureStdout();
+    pthread_t threads[THREADS];
+    for(size_t i = 0; i < THREADS; i++)
+        pthread_create(&threads[i], NULL, logThread, logger);
+    for(size_t i = 0; i < THREADS; i++)
+        pthread_join(threads[i], NULL);
+    UA_Log_Async_flush(logger);
+
+    size_t written, dropped;
+    UA_Log_Async_getStatistics(logger, &written, &dropped);
+    ck_assert_uint_eq(written + dropped, THREADS * THREAD_MESSAGES);
+
+    /* Remaining messages are written before the logger is cleared */
+    UA_LOG_INFO(logger, UA_LOGCATEGORY_USERLAND, "last message");
+    logger->clear(logger);
+    restoreStdout();
+
+    char line[256];
+    size_t lines = 0;
+    UA_Boolean last = false;
+    while(fgets(line, sizeof(line), captured)) {
+        if(strstr(line, "message ") != NULL)
+            lines++;
+        if(strstr(line, "last message") != NULL)
+            last = true;
+    }
+    ck_assert_uint_eq(lines, written);
+    ck_assert(last);
+    fclose(captured);
+} END_TEST
+
+int main(void) {
+    Suite *s = suite_create("Test Async Logger");
+    TCase *tc = tcase_create("test cases");
+    tcase_add_test(tc, Log_Async_order);
+    tcase_add_test(tc, Log_Async_concurrent);
+    suite_add_tcase(s, tc);
+
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -452,14 +452,209 @@ START_TEST(SecureChannel_sendSymmetricMessage_invalidParameters) {
     ck_assert_msg(retval != UA_STATUSCODE_GOOD, "Expected failure");
 } END_TEST
 
+static UA_ByteString collectedData;
+static size_t collectedSends;
+
+static UA_StatusCode
+collectSendWithConnection(UA_ConnectionManager *cm, uintptr_t connectionId,
+                          const UA_KeyValueMap *params, UA_ByteString *buf) {
+    UA_Byte *data = (UA_Byte*)
+        UA_realloc(collectedData.data, collectedData.length + buf->length);
+    ck_assert_ptr_ne(data, NULL);
+    memcpy(&data[collectedData.length], buf->data, buf->length);
+    collectedData.data = data;
+    collectedData.length += buf->length;
+    collectedSends++;
+    UA_ByteString_clear(buf);
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+collectSendWithConnectionV(UA_ConnectionManager *cm, uintptr_t connectionId,
+                           const UA_KeyValueMap *params, UA_ByteString *bufs,
+                           size_t bufsSize) {
+    for(size_t i = 0; i < bufsSize; i++)
+        collectSendWithConnection(cm, connectionId, params, &bufs[i]);
+    collectedSends -= bufsSize - 1; /* Count as a single send */
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+collect_callback(void *application, UA_SecureChannel *channel,
+                 UA_MessageType messageType, UA_UInt32 requestId,
+                 const UA_ByteString *message, size_t messageSegments) {
+    ck_assert_uint_eq(messageType, UA_MESSAGETYPE_MSG);
+    ck_assert_uint_eq(requestId, 42);
+    UA_ByteString *received = (UA_ByteString*)application;
+    size_t offset = 0;
+    UA_NodeId typeId;
+    UA_StatusCode res =
+        UA_decodeBinarySegments(message, messageSegments, &offset, &typeId,
+                                &UA_TYPES[UA_TYPES_NODEID], NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(UA_NodeId_equal(&typeId,
+                              &UA_TYPES[UA_TYPES_BYTESTRING].binaryEncodingId));
+    return UA_decodeBinarySegments(message, messageSegments, &offset, received,
+                                   &UA_TYPES[UA_TYPES_BYTESTRING], NULL);
+}
+
+START_TEST(SecureChannel_sendSymmetricMessage_multiChunk) {
+    UA_ConnectionManager collectCM = testConnectionManagerTCP;
+    collectCM.sendWithConnection = collectSendWithConnection;
+    testChannel.connectionManager = &collectCM;
+    testChannel.securityMode = UA_MESSAGESECURITYMODE_NONE;
+    testChannel.config.sendBufferSize = 8192;
+    collectedData = UA_BYTESTRING_NULL;
+    collectedSends = 0;
+
+    UA_ByteString payload;
+    UA_StatusCode retval = UA_ByteString_allocBuffer(&payload, 100000);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < payload.length; i++)
+        payload.data[i] = (UA_Byte)i;
+
+    retval = UA_SecureChannel_sendSymmetricMessage(&testChannel, 42, UA_MESSAGETYPE_MSG,
+                                                   &payload,
+                                                   &UA_TYPES[UA_TYPES_BYTESTRING]);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* The first chunk is sent alone, then several chunks per send */
+    size_t chunks = (collectedData.length + 8191) / 8192;
+    ck_assert_uint_gt(chunks, UA_SECURECHANNEL_SEND_CHUNKS);
+    ck_assert_uint_gt(collectedSends, 1);
+    ck_assert_uint_lt(collectedSends, chunks);
+
+    /* The chunks are received in order */
+    testChannel.securityToken.createdAt = UA_DateTime_nowMonotonic();
+    testChannel.securityToken.revisedLifetime = 600000;
+    UA_ByteString received = UA_BYTESTRING_NULL;
+    retval = UA_SecureChannel_processBuffer(&testChannel, &received, collect_callback,
+                                            &collectedData, UA_DateTime_nowMonotonic());
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(UA_ByteString_equal(&received, &payload));
+
+    UA_ByteString_clear(&received);
+    UA_ByteString_clear(&payload);
+    UA_ByteString_clear(&collectedData);
+} END_TEST
+
+START_TEST(SecureChannel_sendSymmetricMessage_multiChunkV) {
+    UA_ConnectionManager collectCM = testConnectionManagerTCP;
+    collectCM.sendWithConnection = collectSendWithConnection;
+    collectCM.sendWithConnectionV = collectSendWithConnectionV;
+    testChannel.connectionManager = &collectCM;
+    testChannel.securityMode = UA_MESSAGESECURITYMODE_NONE;
+    testChannel.config.sendBufferSize = 8192;
+    collectedData = UA_BYTESTRING_NULL;
+    collectedSends = 0;
+
+    UA_ByteString payload;
+    UA_StatusCode retval = UA_ByteString_allocBuffer(&payload, 100000);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < payload.length; i++)
+        payload.data[i] = (UA_Byte)i;
+
+    retval = UA_SecureChannel_sendSymmetricMessage(&testChannel, 42, UA_MESSAGETYPE_MSG,
+                                                   &payload,
+                                                   &UA_TYPES[UA_TYPES_BYTESTRING]);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* All network buffers of the message are sent with a single call */
+    ck_assert_uint_eq(collectedSends, 1);
+
+    /* The chunks are received in order */
+    testChannel.securityToken.createdAt = UA_DateTime_nowMonotonic();
+    testChannel.securityToken.revisedLifetime = 600000;
+    UA_ByteString received = UA_BYTESTRING_NULL;
+    retval = UA_SecureChannel_processBuffer(&testChannel, &received, collect_callback,
+                                            &collectedData, UA_DateTime_nowMonotonic());
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(UA_ByteString_equal(&received, &payload));
+
+    UA_ByteString_clear(&received);
+    UA_ByteString_clear(&payload);
+    UA_ByteString_clear(&collectedData);
+} END_TEST
+
+static size_t retainedBuffers;
+
+/* The received data stays valid. Only count the references. */
+static UA_StatusCode
+countingRetainNetworkBuffer(UA_ConnectionManager *cm, uintptr_t connectionId,
+                            const UA_ByteString *buf) {
+    retainedBuffers++;
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+countingFreeNetworkBuffer(UA_ConnectionManager *cm, uintptr_t connectionId,
+                          UA_ByteString *buf) {
+    ck_assert_uint_gt(retainedBuffers, 0);
+    retainedBuffers--;
+    UA_ByteString_init(buf);
+}
+
+/* Receive the chunks in slices that split the chunk headers and bodies. The
+ * intermediate chunks are retained in the network buffer instead of copied. */
+START_TEST(SecureChannel_receiveMultiChunkSliced) {
+    UA_ConnectionManager collectCM = testConnectionManagerTCP;
+    collectCM.sendWithConnection = collectSendWithConnection;
+    testChannel.connectionManager = &collectCM;
+    testChannel.securityMode = UA_MESSAGESECURITYMODE_NONE;
+    testChannel.config.sendBufferSize = 8192;
+    collectedData = UA_BYTESTRING_NULL;
+    collectedSends = 0;
+
+    UA_ByteString payload;
+    UA_StatusCode retval = UA_ByteString_allocBuffer(&payload, 100000);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < payload.length; i++)
+        payload.data[i] = (UA_Byte)i;
+    retval = UA_SecureChannel_sendSymmetricMessage(&testChannel, 42, UA_MESSAGETYPE_MSG,
+                                                   &payload,
+                                                   &UA_TYPES[UA_TYPES_BYTESTRING]);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    collectCM.retainNetworkBuffer = countingRetainNetworkBuffer;
+    collectCM.freeNetworkBuffer = countingFreeNetworkBuffer;
+    retainedBuffers = 0;
+
+    testChannel.securityToken.createdAt = UA_DateTime_nowMonotonic();
+    testChannel.securityToken.revisedLifetime = 600000;
+    UA_ByteString received = UA_BYTESTRING_NULL;
+    const size_t slices[] = {1, 5, 3, 8191, 7, 20000, 8200, 4};
+    size_t pos = 0, maxRetained = 0;
+    for(size_t i = 0; pos < collectedData.length; i++) {
+        UA_ByteString slice = {slices[i % 8], &collectedData.data[pos]};
+        if(slice.length > collectedData.length - pos)
+            slice.length = collectedData.length - pos;
+        retval = UA_SecureChannel_processBuffer(&testChannel, &received,
+                                                collect_callback, &slice,
+                                                UA_DateTime_nowMonotonic());
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        pos += slice.length;
+        if(retainedBuffers > maxRetained)
+            maxRetained = retainedBuffers;
+    }
+    ck_assert(UA_ByteString_equal(&received, &payload));
+    ck_assert_uint_gt(maxRetained, 0);
+    ck_assert_uint_eq(retainedBuffers, 0);
+    ck_assert_uint_eq(testChannel.incompleteChunk.length, 0);
+
+    UA_ByteString_clear(&received);
+    UA_ByteString_clear(&payload);
+    UA_ByteString_clear(&collectedData);
+} END_TEST
+
 static UA_StatusCode
 process_callback(void *application, UA_SecureChannel *channel,
                  UA_MessageType messageType, UA_UInt32 requestId,
-                 UA_ByteString *message) {
+                 const UA_ByteString *message, size_t messageSegments) {
     ck_assert_ptr_ne(message, NULL);
     ck_assert_ptr_ne(application, NULL);
     if(message == NULL || application == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
+    ck_assert_uint_eq(messageSegments, 1);
     ck_assert_uint_ne(message->length, 0);
     ck_assert_ptr_ne(message->data, NULL);
     int *chunks_processed = (int *)application;
@@ -557,6 +752,9 @@ testSuite_SecureChannel(void) {
     tcase_add_test(tc_sendSymmetricMessage, SecureChannel_sendSymmetricMessage_modeNone);
     tcase_add_test(tc_sendSymmetricMessage, SecureChannel_sendSymmetricMessage_modeSign);
     tcase_add_test(tc_sendSymmetricMessage, SecureChannel_sendSymmetricMessage_modeSignAndEncrypt);
+    tcase_add_test(tc_sendSymmetricMessage, SecureChannel_sendSymmetricMessage_multiChunk);
+    tcase_add_test(tc_sendSymmetricMessage, SecureChannel_sendSymmetricMessage_multiChunkV);
+    tcase_add_test(tc_sendSymmetricMessage, SecureChannel_receiveMultiChunkSliced);
     suite_add_tcase(s, tc_sendSymmetricMessage);
 
     TCase *tc_processBuffer = tcase_create("Test chunk assembly");
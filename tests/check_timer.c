@@ -3,6 +3,7 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #include "../arch/eventloop_common/timer.h"
+#include "../arch/eventloop_common/timer_wheel.h"
 
 #include <check.h>
 #include <stdlib.h>
@@ -53,10 +54,220 @@ START_TEST(benchmarkTimer) {
     UA_Timer_clear(&timer);
 } END_TEST
 
+/* Compare the ziptree timer and the timing wheel for a growing number of
+ * timers with sampling-like intervals between 100ms and 1s. Each round adds
+ * the timers, processes every 100ms and then removes every timer
+ * individually. The processed duration is shortened for more timers to keep
+ * the number of callbacks in the same range. */
+#define BENCH_INTERVAL(i) ((UA_Double)((i % 10) + 1) * 100.0)
+
+static double
+elapsed(clock_t begin) {
+    return (double)(clock() - begin) / CLOCKS_PER_SEC;
+}
+
+static void
+benchmarkZiptree(size_t events, UA_DateTime duration, UA_UInt64 *ids) {
+    UA_Timer timer;
+    UA_Timer_init(&timer);
+    count = 0;
+
+    clock_t begin = clock();
+    for(size_t i = 0; i < events; i++) {
+        UA_StatusCode res =
+            UA_Timer_add(&timer, timerCallback, NULL, NULL, BENCH_INTERVAL(i),
+                         0, NULL, UA_TIMERPOLICY_CURRENTTIME, &ids[i]);
+        ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    }
+    double addTime = elapsed(begin);
+
+    begin = clock();
+    for(UA_DateTime now = 0; now <= duration; now += 100 * UA_DATETIME_MSEC)
+        UA_Timer_process(&timer, now);
+    double processTime = elapsed(begin);
+
+    begin = clock();
+    for(size_t i = 0; i < events; i++)
+        UA_Timer_remove(&timer, ids[i]);
+    double removeTime = elapsed(begin);
+
+    printf("ziptree %8lu timers: add %f s, process %f s (%lu callbacks), "
+           "remove %f s\n", (unsigned long)events, addTime, processTime,
+           (unsigned long)count, removeTime);
+    UA_Timer_clear(&timer);
+}
+
+static void
+benchmarkWheel(size_t events, UA_DateTime duration, UA_UInt64 *ids) {
+    UA_TimerWheel timer;
+    UA_TimerWheel_init(&timer);
+    count = 0;
+
+    clock_t begin = clock();
+    for(size_t i = 0; i < events; i++) {
+        UA_StatusCode res =
+            UA_TimerWheel_add(&timer, timerCallback, NULL, NULL, BENCH_INTERVAL(i),
+                              0, NULL, UA_TIMERPOLICY_CURRENTTIME, &ids[i]);
+        ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    }
+    double addTime = elapsed(begin);
+
+    begin = clock();
+    for(UA_DateTime now = 0; now <= duration; now += 100 * UA_DATETIME_MSEC)
+        UA_TimerWheel_process(&timer, now);
+    double processTime = elapsed(begin);
+
+    begin = clock();
+    for(size_t i = 0; i < events; i++)
+        UA_TimerWheel_remove(&timer, ids[i]);
+    double removeTime = elapsed(begin);
+
+    printf("wheel   %8lu timers: add %f s, process %f s (%lu callbacks), "
+           "remove %f s\n", (unsigned long)events, addTime, processTime,
+           (unsigned long)count, removeTime);
+    UA_TimerWheel_clear(&timer);
+}
+
+START_TEST(benchmarkTimerWheel) {
+    size_t sizes[2] = {100000, 1000000};
+    UA_DateTime durations[2] = {10 * UA_DATETIME_SEC, UA_DATETIME_SEC};
+    for(size_t i = 0; i < 2; i++) {
+        UA_UInt64 *ids = (UA_UInt64*)UA_malloc(sizeof(UA_UInt64) * sizes[i]);
+        ck_assert_ptr_ne(ids, NULL);
+        benchmarkZiptree(sizes[i], durations[i], ids);
+        size_t ziptreeCount = count;
+        benchmarkWheel(sizes[i], durations[i], ids);
+        ck_assert_uint_eq(count, ziptreeCount);
+        UA_free(ids);
+    }
+} END_TEST
+
+/* The timing wheel executes the same callbacks as the ziptree timer. Use
+ * intervals and processing times that cross the boundaries of all levels and
+ * make the driving timestamps jump. */
+#define N_COMPARE 2000
+
+static size_t ziptreeCounts[N_COMPARE];
+static size_t wheelCounts[N_COMPARE];
+
+static void
+countCallback(void *application, void *data) {
+    size_t *counts = (size_t*)application;
+    counts[(uintptr_t)data]++;
+}
+
+START_TEST(compareTimerWheel) {
+    UA_Timer zt;
+    UA_Timer_init(&zt);
+    UA_TimerWheel tw;
+    UA_TimerWheel_init(&tw);
+    memset(ziptreeCounts, 0, sizeof(ziptreeCounts));
+    memset(wheelCounts, 0, sizeof(wheelCounts));
+
+    UA_DateTime now = 12345 * UA_DATETIME_MSEC + 17;
+    srand(1);
+    for(uintptr_t i = 0; i < N_COMPARE; i++) {
+        /* Intervals from sub-millisecond to several hours */
+        UA_Double interval = (i % 4 == 0) ? (UA_Double)(rand() % 100) / 7.0 + 0.1 :
+            (i % 4 == 1) ? (UA_Double)(rand() % 5000) + 1 :
+            (i % 4 == 2) ? (UA_Double)(rand() % 1000000) + 1 :
+            (UA_Double)(rand() % 100000000) + 1;
+        UA_TimerPolicy policy = (i % 3 == 0) ? UA_TIMERPOLICY_ONCE :
+            (i % 3 == 1) ? UA_TIMERPOLICY_CURRENTTIME : UA_TIMERPOLICY_BASETIME;
+        UA_StatusCode res =
+            UA_Timer_add(&zt, countCallback, ziptreeCounts, (void*)i, interval,
+                         now, NULL, policy, NULL);
+        ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+        res = UA_TimerWheel_add(&tw, countCallback, wheelCounts, (void*)i, interval,
+                                now, NULL, policy, NULL);
+        ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    }
+
+    for(size_t i = 0; i < 20000; i++) {
+        UA_DateTime ztNext = UA_Timer_process(&zt, now);
+        UA_DateTime twNext = UA_TimerWheel_process(&tw, now);
+        /* The wheel may wake up early for cascading, never late */
+        ck_assert(twNext <= ztNext);
+        /* Mostly follow the wheel. Sometimes jump ahead. */
+        if(i % 97 == 0)
+            now += (UA_DateTime)(rand() % 1000000) * UA_DATETIME_MSEC;
+        else if(twNext != UA_INT64_MAX && twNext > now)
+            now = twNext;
+        else
+            now += UA_DATETIME_MSEC;
+    }
+
+    for(size_t i = 0; i < N_COMPARE; i++)
+        ck_assert_uint_eq(wheelCounts[i], ziptreeCounts[i]);
+
+    UA_Timer_clear(&zt);
+    UA_TimerWheel_clear(&tw);
+} END_TEST
+
+/* Remove and modify timers from within a callback of the same batch */
+static UA_TimerWheel *wheel;
+static UA_UInt64 wheelIds[3];
+static size_t wheelCalled[3];
+
+static void
+wheelModifyCallback(void *application, void *data) {
+    uintptr_t i = (uintptr_t)data;
+    wheelCalled[i]++;
+    if(i == 0) {
+        /* Remove the other timers. At least one of them is in the same
+         * batch. */
+        UA_TimerWheel_remove(wheel, wheelIds[1]);
+        UA_TimerWheel_modify(wheel, wheelIds[2], 1000.0, 0, NULL,
+                             UA_TIMERPOLICY_CURRENTTIME);
+    }
+}
+
+START_TEST(timerWheelModify) {
+    UA_TimerWheel tw;
+    UA_TimerWheel_init(&tw);
+    wheel = &tw;
+    memset(wheelCalled, 0, sizeof(wheelCalled));
+    for(uintptr_t i = 0; i < 3; i++) {
+        UA_StatusCode res =
+            UA_TimerWheel_add(&tw, wheelModifyCallback, NULL, (void*)i, 10.0, 0,
+                              NULL, UA_TIMERPOLICY_CURRENTTIME, &wheelIds[i]);
+        ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+        ck_assert_uint_ne(wheelIds[i], 0);
+    }
+
+    /* All three are due in the first round */
+    UA_TimerWheel_process(&tw, 10 * UA_DATETIME_MSEC);
+    ck_assert_uint_eq(wheelCalled[0], 1);
+    ck_assert_uint_le(wheelCalled[1], 1);
+
+    /* The removed timer is no longer called. The modified timer has a longer
+     * interval now. */
+    size_t called1 = wheelCalled[1];
+    size_t called2 = wheelCalled[2];
+    UA_TimerWheel_process(&tw, 20 * UA_DATETIME_MSEC);
+    ck_assert_uint_eq(wheelCalled[0], 2);
+    ck_assert_uint_eq(wheelCalled[1], called1);
+    ck_assert_uint_eq(wheelCalled[2], called2);
+
+    /* Removing a stale identifier does nothing */
+    UA_TimerWheel_remove(&tw, wheelIds[1]);
+    ck_assert_int_eq(UA_TimerWheel_modify(&tw, wheelIds[1], 10.0, 0, NULL,
+                                          UA_TIMERPOLICY_CURRENTTIME),
+                     UA_STATUSCODE_BADNOTFOUND);
+
+    UA_TimerWheel_process(&tw, 2000 * UA_DATETIME_MSEC);
+    ck_assert_uint_eq(wheelCalled[2], called2 + 1);
+
+    UA_TimerWheel_clear(&tw);
+} END_TEST
+
 int main(void) {
     Suite *s  = suite_create("Test Event Timer");
     TCase *tc = tcase_create("test cases");
     tcase_add_test(tc, benchmarkTimer);
+    tcase_add_test(tc, compareTimerWheel);
+    tcase_add_test(tc, timerWheelModify);
+    tcase_add_test(tc, benchmarkTimerWheel);
     suite_add_tcase(s, tc);
 
     SRunner *sr = srunner_create(s);
@@ -1103,6 +1103,54 @@ START_TEST(UA_QualifiedName_equalShallWorkOnExample) {
 }
 END_TEST
 
+/* Large pointer-free arrays are compared blockwise. The order of the first
+ * differing element decides, also with the special float rules. */
+START_TEST(UA_Variant_orderLargeArrays) {
+    size_t len = 10000;
+    UA_Double *d1 = (UA_Double*)UA_Array_new(len, &UA_TYPES[UA_TYPES_DOUBLE]);
+    UA_Double *d2 = (UA_Double*)UA_Array_new(len, &UA_TYPES[UA_TYPES_DOUBLE]);
+    for(size_t i = 0; i < len; i++)
+        d1[i] = d2[i] = (UA_Double)i;
+    UA_Variant v1, v2;
+    UA_Variant_setArray(&v1, d1, len, &UA_TYPES[UA_TYPES_DOUBLE]);
+    UA_Variant_setArray(&v2, d2, len, &UA_TYPES[UA_TYPES_DOUBLE]);
+    ck_assert(UA_order(&v1, &v2, &UA_TYPES[UA_TYPES_VARIANT]) == UA_ORDER_EQ);
+
+    /* Different bits, but equal values */
+    d1[5000] = 0.0;
+    d2[5000] = -0.0;
+    ck_assert(UA_order(&v1, &v2, &UA_TYPES[UA_TYPES_VARIANT]) == UA_ORDER_EQ);
+
+    /* The first difference decides */
+    d1[7000] = 1.0;
+    d2[9999] = -1.0;
+    ck_assert(UA_order(&v1, &v2, &UA_TYPES[UA_TYPES_VARIANT]) == UA_ORDER_LESS);
+    ck_assert(UA_order(&v2, &v1, &UA_TYPES[UA_TYPES_VARIANT]) == UA_ORDER_MORE);
+
+    /* NaN is less than every number */
+    d1[3] = NAN;
+    ck_assert(UA_order(&v1, &v2, &UA_TYPES[UA_TYPES_VARIANT]) == UA_ORDER_LESS);
+    UA_Variant_clear(&v1);
+    UA_Variant_clear(&v2);
+
+    /* Arrays of pointer-free structures */
+    UA_Range r1[300], r2[300];
+    memset(r1, 0, sizeof(r1));
+    memset(r2, 0, sizeof(r2));
+    for(size_t i = 0; i < 300; i++) {
+        r1[i].low = r2[i].low = (UA_Double)i;
+        r1[i].high = r2[i].high = (UA_Double)(2 * i);
+    }
+    UA_Variant_setArray(&v1, r1, 300, &UA_TYPES[UA_TYPES_RANGE]);
+    UA_Variant_setArray(&v2, r2, 300, &UA_TYPES[UA_TYPES_RANGE]);
+    ck_assert(UA_equal(&v1, &v2, &UA_TYPES[UA_TYPES_VARIANT]));
+    r2[299].high = 1.0;
+    ck_assert(UA_order(&v1, &v2, &UA_TYPES[UA_TYPES_VARIANT]) == UA_ORDER_MORE);
+    ck_assert(UA_equal(&r1[0], &r2[0], &UA_TYPES[UA_TYPES_RANGE]));
+    ck_assert(!UA_equal(&r1[299], &r2[299], &UA_TYPES[UA_TYPES_RANGE]));
+}
+END_TEST
+
 START_TEST(UA_ExpandedNodeId_hashIdentical) {
     // given
     UA_NodeId n = UA_NODEID_NUMERIC(1, 1234);
@@ -1361,6 +1409,46 @@ START_TEST(UA_DataValue_copyShallWorkOnInputExample) {
 }
 END_TEST
 
+START_TEST(UA_DataValue_copyReuseShallKeepScalarMemory) {
+    // given
+    UA_Double d1 = 1.5, d2 = 2.5;
+    UA_DataValue src, dst;
+    UA_DataValue_init(&src);
+    UA_DataValue_init(&dst);
+    UA_Variant_setScalarCopy(&src.value, &d1, &UA_TYPES[UA_TYPES_DOUBLE]);
+    src.hasValue = true;
+    UA_DataValue_copy(&src, &dst);
+    void *data = dst.value.data;
+
+    // when
+    *(UA_Double*)src.value.data = d2;
+    src.hasSourceTimestamp = true;
+    src.sourceTimestamp = 42;
+    UA_StatusCode retval = UA_DataValue_copyReuse(&src, &dst);
+
+    // then
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_ptr_eq(dst.value.data, data);
+    ck_assert(dst.value.data != src.value.data);
+    ck_assert(*(UA_Double*)dst.value.data == d2);
+    ck_assert(dst.hasSourceTimestamp);
+    ck_assert_int_eq(dst.sourceTimestamp, 42);
+
+    // when the type differs, a deep copy is made
+    UA_Int32 i = 7;
+    UA_Variant_clear(&src.value);
+    UA_Variant_setScalarCopy(&src.value, &i, &UA_TYPES[UA_TYPES_INT32]);
+    retval = UA_DataValue_copyReuse(&src, &dst);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_ptr_eq(dst.value.type, &UA_TYPES[UA_TYPES_INT32]);
+    ck_assert_int_eq(*(UA_Int32*)dst.value.data, 7);
+
+    // finally
+    UA_DataValue_clear(&src);
+    UA_DataValue_clear(&dst);
+}
+END_TEST
+
 START_TEST(UA_Variant_copyShallWorkOnSingleValueExample) {
     //given
     UA_String testString = (UA_String){5, (UA_Byte*)"OPCUA"};
@@ -1456,6 +1544,57 @@ START_TEST(UA_Variant_copyShallWorkOn1DArrayExample) {
 }
 END_TEST
 
+START_TEST(UA_Variant_copyShallShareSharedData) {
+    // given
+    UA_String *srcArray = (UA_String*)UA_Array_new(3, &UA_TYPES[UA_TYPES_STRING]);
+    srcArray[0] = UA_STRING_ALLOC("__open");
+    srcArray[1] = UA_STRING_ALLOC("_62541");
+    srcArray[2] = UA_STRING_ALLOC("opc ua");
+
+    UA_Variant value, copiedValue, copiedValue2;
+    UA_Variant_init(&copiedValue);
+    UA_Variant_init(&copiedValue2);
+    UA_Variant_setArray(&value, srcArray, 3, &UA_TYPES[UA_TYPES_STRING]);
+
+    //when
+    UA_StatusCode retval = UA_Variant_share(&value);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(value.storageType, UA_VARIANT_DATA_SHARED);
+    UA_Variant_copy(&value, &copiedValue);
+    UA_Variant_copy(&copiedValue, &copiedValue2);
+
+    //then
+    ck_assert_ptr_eq(value.data, copiedValue.data);
+    ck_assert_ptr_eq(value.data, copiedValue2.data);
+    ck_assert_int_eq(copiedValue.storageType, UA_VARIANT_DATA_SHARED);
+    ck_assert(UA_Variant_equal(&value, &copiedValue2));
+
+    /* Writing a range makes a private copy */
+    UA_String s = UA_STRING("xxxxxx");
+    UA_NumericRangeDimension d = {1, 1};
+    UA_NumericRange r = {1, &d};
+    retval = UA_Variant_setRangeCopy(&copiedValue, &s, 1, r);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(copiedValue.storageType, UA_VARIANT_DATA);
+    ck_assert_ptr_ne(value.data, copiedValue.data);
+    ck_assert(UA_String_equal(&((UA_String*)copiedValue.data)[1], &s));
+    UA_String orig = UA_STRING("_62541");
+    ck_assert(UA_String_equal(&((UA_String*)value.data)[1], &orig));
+    ck_assert(!UA_Variant_equal(&value, &copiedValue));
+
+    /* The last reference moves the data out */
+    UA_Variant_clear(&value);
+    retval = UA_Variant_unshare(&copiedValue2);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(copiedValue2.storageType, UA_VARIANT_DATA);
+    ck_assert_int_eq(((UA_String *)copiedValue2.data)[2].data[0], 'o');
+
+    //finally
+    UA_Variant_clear(&copiedValue);
+    UA_Variant_clear(&copiedValue2);
+}
+END_TEST
+
 START_TEST(UA_Variant_copyShallWorkOn2DArrayExample) {
     // given
     UA_Int32 *srcArray = (UA_Int32*)UA_Array_new(6, &UA_TYPES[UA_TYPES_INT32]);
@@ -1691,6 +1830,42 @@ START_TEST(UA_Variant_encodeDecodeShallWorkOnVariantWithArrayOfExtensionObjectsN
 }
 END_TEST
 
+START_TEST(UA_ChannelSecurityToken_encodeDecodeDirectMembers) {
+    UA_ChannelSecurityToken token;
+    UA_ChannelSecurityToken_init(&token);
+    token.channelId = 0x01020304;
+    token.tokenId = 0x05060708;
+    token.createdAt = 0x1112131415161718;
+    token.revisedLifetime = 600000;
+
+    UA_Byte data[24];
+    UA_ByteString dst = {sizeof(data), data};
+    ck_assert_uint_eq(UA_calcSizeBinary(&token, &UA_TYPES[UA_TYPES_CHANNELSECURITYTOKEN]), 20);
+    UA_StatusCode retval =
+        UA_encodeBinary(&token, &UA_TYPES[UA_TYPES_CHANNELSECURITYTOKEN], &dst);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(dst.length, 20);
+    ck_assert_uint_eq(data[0], 0x04);
+    ck_assert_uint_eq(data[4], 0x08);
+    ck_assert_uint_eq(data[8], 0x18);
+    ck_assert_uint_eq(data[15], 0x11);
+
+    UA_ChannelSecurityToken decoded;
+    retval = UA_decodeBinary(&dst, &decoded,
+                             &UA_TYPES[UA_TYPES_CHANNELSECURITYTOKEN], NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(UA_equal(&token, &decoded, &UA_TYPES[UA_TYPES_CHANNELSECURITYTOKEN]));
+
+    /* Truncated input and output buffers */
+    dst.length = 18;
+    retval = UA_decodeBinary(&dst, &decoded,
+                             &UA_TYPES[UA_TYPES_CHANNELSECURITYTOKEN], NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADDECODINGERROR);
+    retval = UA_encodeBinary(&token, &UA_TYPES[UA_TYPES_CHANNELSECURITYTOKEN], &dst);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADENCODINGERROR);
+}
+END_TEST
+
 START_TEST(UA_StatusCode_utils) {
 
     ck_assert(UA_TRUE == UA_StatusCode_isBad(UA_STATUSCODE_BADINTERNALERROR));
@@ -1762,6 +1937,7 @@ static Suite *testSuite_builtin(void) {
     tcase_add_test(tc_encode, UA_Variant_encodeDecodeShallWorkOnVariantWithArrayOfExtensionObjectsWithUnknownType);
     tcase_add_test(tc_encode, UA_Variant_encodeDecodeShallWorkOnVariantWithArrayOfExtensionObjectsXmlEncoded);
     tcase_add_test(tc_encode, UA_Variant_encodeDecodeShallWorkOnVariantWithArrayOfExtensionObjectsNoBody);
+    tcase_add_test(tc_encode, UA_ChannelSecurityToken_encodeDecodeDirectMembers);
     suite_add_tcase(s, tc_encode);
 
     TCase *tc_convert = tcase_create("convert");
@@ -1771,6 +1947,7 @@ static Suite *testSuite_builtin(void) {
 
     TCase *tc_equal = tcase_create("equal");
     tcase_add_test(tc_equal, UA_QualifiedName_equalShallWorkOnExample);
+    tcase_add_test(tc_equal, UA_Variant_orderLargeArrays);
     suite_add_tcase(s, tc_equal);
 
     TCase *tc_hash = tcase_create("hash");
@@ -1784,6 +1961,7 @@ static Suite *testSuite_builtin(void) {
     tcase_add_test(tc_copy, UA_Variant_copyShallWorkOnSingleValueExample);
     tcase_add_test(tc_copy, UA_Variant_copyShallWorkOn1DArrayExample);
     tcase_add_test(tc_copy, UA_Variant_copyShallWorkOn2DArrayExample);
+    tcase_add_test(tc_copy, UA_Variant_copyShallShareSharedData);
     tcase_add_test(tc_copy, UA_Variant_copyShallWorkOnByteStringIndexRange);
 
     tcase_add_test(tc_copy, UA_DiagnosticInfo_copyShallWorkOnExample);
@@ -1792,6 +1970,7 @@ static Suite *testSuite_builtin(void) {
     tcase_add_test(tc_copy, UA_Guid_copyShallWorkOnInputExample);
     tcase_add_test(tc_copy, UA_LocalizedText_copycstringShallWorkOnInputExample);
     tcase_add_test(tc_copy, UA_DataValue_copyShallWorkOnInputExample);
+    tcase_add_test(tc_copy, UA_DataValue_copyReuseShallKeepScalarMemory);
     suite_add_tcase(s, tc_copy);
 
     TCase *tc_utils = tcase_create("utils");
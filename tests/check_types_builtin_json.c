@@ -1088,6 +1088,40 @@ START_TEST(UA_DateTime_json_encode) {
 }
 END_TEST
 
+/* Consecutive DateTimes in an array reuse the prefix of the same second */
+START_TEST(UA_DateTimeArray_sameSecond_json_encode) {
+    UA_DateTime src[5];
+    src[0] = UA_DateTime_fromUnixTime(1234567);
+    src[1] = src[0] + 1;                       /* 100ns later */
+    src[2] = src[0] + 5 * UA_DATETIME_MSEC;    /* Same second */
+    src[3] = src[0] + UA_DATETIME_SEC;         /* Next second */
+    src[4] = -1;                               /* Before 1601 */
+    UA_Variant v;
+    UA_Variant_setArray(&v, src, 5, &UA_TYPES[UA_TYPES_DATETIME]);
+
+    UA_ByteString buf = UA_BYTESTRING_NULL;
+    status s = UA_encodeJson(&v, &UA_TYPES[UA_TYPES_VARIANT], &buf, NULL);
+    ck_assert_int_eq(s, UA_STATUSCODE_GOOD);
+
+    UA_ByteString result =
+        UA_BYTESTRING("{\"Type\":13,\"Body\":["
+                      "\"1970-01-15T06:56:07Z\","
+                      "\"1970-01-15T06:56:07.0000001Z\","
+                      "\"1970-01-15T06:56:07.005Z\","
+                      "\"1970-01-15T06:56:08Z\","
+                      "\"1600-12-31T23:59:59.9999999Z\"]}");
+    ck_assert(UA_ByteString_equal(&result, &buf));
+
+    UA_Variant out;
+    s = UA_decodeJson(&buf, &out, &UA_TYPES[UA_TYPES_VARIANT], NULL);
+    ck_assert_int_eq(s, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(out.arrayLength, 5);
+    ck_assert(memcmp(out.data, src, sizeof(src)) == 0);
+    UA_Variant_clear(&out);
+    UA_ByteString_clear(&buf);
+}
+END_TEST
+
 START_TEST(UA_DateTime_json_encode_null) {
     UA_DateTime src = 0;
     const UA_DataType *type = &UA_TYPES[UA_TYPES_DATETIME];
@@ -5464,6 +5498,133 @@ START_TEST(UA_Boolean_true_public_json_encode) {
 }
 END_TEST
 
+/* The output buffer is allocated and grown during the encoding. The result is
+ * the same as with a buffer of the size computed by UA_calcSizeJson. */
+START_TEST(UA_VariantArray_growBuffer_public_json_encode) {
+    UA_String strings[500];
+    for(size_t i = 0; i < 500; i++)
+        strings[i] = UA_STRING("a \"quoted\" string\twith escapes");
+    UA_Variant src;
+    UA_Variant_setArray(&src, strings, 500, &UA_TYPES[UA_TYPES_STRING]);
+
+    UA_EncodeJsonOptions options;
+    memset(&options, 0, sizeof(UA_EncodeJsonOptions));
+    options.prettyPrint = true;
+
+    UA_ByteString out = UA_BYTESTRING_NULL;
+    status s = UA_encodeJson(&src, &UA_TYPES[UA_TYPES_VARIANT], &out, &options);
+    ck_assert_int_eq(s, UA_STATUSCODE_GOOD);
+
+    size_t size = UA_calcSizeJson(&src, &UA_TYPES[UA_TYPES_VARIANT], &options);
+    ck_assert_uint_eq(out.length, size);
+    UA_ByteString expected;
+    s = UA_ByteString_allocBuffer(&expected, size);
+    ck_assert_int_eq(s, UA_STATUSCODE_GOOD);
+    s = UA_encodeJson(&src, &UA_TYPES[UA_TYPES_VARIANT], &expected, &options);
+    ck_assert_int_eq(s, UA_STATUSCODE_GOOD);
+    ck_assert(UA_ByteString_equal(&expected, &out));
+
+    UA_ByteString_clear(&expected);
+    UA_ByteString_clear(&out);
+}
+END_TEST
+
+/* Escaped characters at every offset of a long string with multi-byte utf8.
+ * The bulk scanning of the plain characters must find each of them. */
+START_TEST(UA_String_escapeOffsets_json_encode_decode) {
+    const char escapes[] = {'\"', '\\', '\n', '\t', 0x01, 0x1f, 0x7f};
+    const char *escaped[] =
+        {"\\\"", "\\\\", "\\n", "\\t", "\\u0001", "\\u001f", "\\u007f"};
+    char raw[80];
+    char expected[100];
+    for(size_t e = 0; e < sizeof(escapes); e++) {
+        for(size_t offset = 0; offset < 64; offset++) {
+            /* Plain ASCII with a two-byte utf8 character every 13 bytes */
+            for(size_t i = 0; i < 64; i++)
+                raw[i] = (char)('a' + (i % 26));
+            for(size_t i = 5; i + 1 < 64; i += 13) {
+                raw[i] = (char)0xc3;
+                raw[i+1] = (char)0xa4;
+            }
+            raw[offset] = escapes[e];
+            if(offset > 0 && (unsigned char)raw[offset-1] == 0xc3)
+                raw[offset-1] = 'x'; /* Don't split the utf8 character */
+            if(offset + 1 < 64 && (unsigned char)raw[offset+1] == 0xa4)
+                raw[offset+1] = 'y';
+
+            size_t len = 0;
+            expected[len++] = '\"';
+            memcpy(&expected[len], raw, offset);
+            len += offset;
+            memcpy(&expected[len], escaped[e], strlen(escaped[e]));
+            len += strlen(escaped[e]);
+            memcpy(&expected[len], &raw[offset+1], 63 - offset);
+            len += 63 - offset;
+            expected[len++] = '\"';
+
+            UA_String src = {64, (UA_Byte*)raw};
+            UA_ByteString out = UA_BYTESTRING_NULL;
+            status s = UA_encodeJson(&src, &UA_TYPES[UA_TYPES_STRING], &out, NULL);
+            ck_assert_int_eq(s, UA_STATUSCODE_GOOD);
+            ck_assert_uint_eq(out.length, len);
+            ck_assert(memcmp(out.data, expected, len) == 0);
+
+            UA_String dec;
+            s = UA_decodeJson(&out, &dec, &UA_TYPES[UA_TYPES_STRING], NULL);
+            ck_assert_int_eq(s, UA_STATUSCODE_GOOD);
+            ck_assert(UA_String_equal(&src, &dec));
+            UA_String_clear(&dec);
+            UA_ByteString_clear(&out);
+        }
+    }
+}
+END_TEST
+
+/* A large document is decoded with a reused token buffer. The buffer is grown
+ * once and then reused without reallocation. */
+START_TEST(UA_VariantArray_tokenBuffer_json_decode) {
+    UA_UInt32 values[1000];
+    for(size_t i = 0; i < 1000; i++)
+        values[i] = (UA_UInt32)i;
+    UA_Variant src;
+    UA_Variant_setArray(&src, values, 1000, &UA_TYPES[UA_TYPES_UINT32]);
+    UA_ByteString buf = UA_BYTESTRING_NULL;
+    status s = UA_encodeJson(&src, &UA_TYPES[UA_TYPES_VARIANT], &buf, NULL);
+    ck_assert_int_eq(s, UA_STATUSCODE_GOOD);
+
+    UA_JsonTokenBuffer tb;
+    memset(&tb, 0, sizeof(UA_JsonTokenBuffer));
+    UA_DecodeJsonOptions options;
+    memset(&options, 0, sizeof(UA_DecodeJsonOptions));
+    options.tokenBuffer = &tb;
+
+    void *tokens = NULL;
+    for(size_t i = 0; i < 3; i++) {
+        UA_Variant out;
+        s = UA_decodeJson(&buf, &out, &UA_TYPES[UA_TYPES_VARIANT], &options);
+        ck_assert_int_eq(s, UA_STATUSCODE_GOOD);
+        ck_assert(UA_order(&src, &out, &UA_TYPES[UA_TYPES_VARIANT]) == UA_ORDER_EQ);
+        UA_Variant_clear(&out);
+        ck_assert(tb.tokens != NULL);
+        ck_assert_uint_ge(tb.tokensSize, 1000);
+        if(i > 0)
+            ck_assert_ptr_eq(tb.tokens, tokens);
+        tokens = tb.tokens;
+    }
+
+    /* Limit the number of tokens */
+    options.tokenBuffer = NULL;
+    options.maxTokens = 500;
+    UA_Variant out;
+    s = UA_decodeJson(&buf, &out, &UA_TYPES[UA_TYPES_VARIANT], &options);
+    ck_assert_int_eq(s, UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED);
+
+    UA_JsonTokenBuffer_clear(&tb);
+    ck_assert(tb.tokens == NULL);
+    UA_ByteString_clear(&buf);
+}
+END_TEST
+
 static Suite *testSuite_builtin_json(void) {
     Suite *s = suite_create("Built-in Data Types 62541-6 Json");
 
@@ -5546,6 +5707,7 @@ static Suite *testSuite_builtin_json(void) {
     //DateTime
     tcase_add_test(tc_json_encode, UA_DateTime_json_encode);
     tcase_add_test(tc_json_encode, UA_DateTime_json_encode_null);
+    tcase_add_test(tc_json_encode, UA_DateTimeArray_sameSecond_json_encode);
     tcase_add_test(tc_json_encode, UA_DateTime_with_nanoseconds_json_encode);
 
 
@@ -5840,6 +6002,9 @@ static Suite *testSuite_builtin_json(void) {
     // public api
     tcase_add_test(tc_json_decode, UA_VariantBool_public_json_decode);
     tcase_add_test(tc_json_decode, UA_Boolean_true_public_json_encode);
+    tcase_add_test(tc_json_decode, UA_VariantArray_growBuffer_public_json_encode);
+    tcase_add_test(tc_json_decode, UA_String_escapeOffsets_json_encode_decode);
+    tcase_add_test(tc_json_decode, UA_VariantArray_tokenBuffer_json_decode);
 
     suite_add_tcase(s, tc_json_decode);
 
@@ -1969,6 +1969,7 @@ START_TEST(UA_String_xml_decode) {
     ck_assert_int_eq(out.data[3], 'd');
     ck_assert_int_eq(out.data[4], 'e');
     ck_assert_int_eq(out.data[5], 'f');
+    UA_String_clear(&out);
 }
 END_TEST
 
@@ -2001,6 +2002,7 @@ START_TEST(UA_String_unescapeBS_xml_decode) {
     ck_assert_int_eq(out.data[4], 'd');
     ck_assert_int_eq(out.data[5], 'e');
     ck_assert_int_eq(out.data[6], 'f');
+    UA_String_clear(&out);
 }
 END_TEST
 
@@ -2025,6 +2027,7 @@ START_TEST(UA_String_escape2_xml_decode) {
     ck_assert_int_eq(out.data[9], '\\');
     ck_assert_int_eq(out.data[10], 'o');
     ck_assert_int_eq(out.data[11], '\r');
+    UA_String_clear(&out);
 }
 END_TEST
 
@@ -2516,6 +2519,182 @@ START_TEST(UA_ExpandedNodeId_ByteString_xml_decode) {
 }
 END_TEST
 
+START_TEST(UA_String_entities_xml_decode) {
+    UA_String out;
+    UA_String_init(&out);
+    UA_ByteString buf = UA_STRING("a&lt;b&amp;c&#x41;&#66;&#x20AC;");
+
+    UA_StatusCode retval = UA_decodeXml(&buf, &out, &UA_TYPES[UA_TYPES_STRING], NULL);
+
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    UA_String expected = UA_STRING("a<b&cAB€");
+    ck_assert(UA_String_equal(&out, &expected));
+    UA_String_clear(&out);
+}
+END_TEST
+
+START_TEST(UA_String_badEntity_xml_decode) {
+    UA_String out;
+    UA_String_init(&out);
+    UA_ByteString buf = UA_STRING("a&foo;b");
+
+    UA_StatusCode retval = UA_decodeXml(&buf, &out, &UA_TYPES[UA_TYPES_STRING], NULL);
+
+    ck_assert_int_eq(retval, UA_STATUSCODE_BADDECODINGERROR);
+}
+END_TEST
+
+START_TEST(UA_ByteString_xml_decode) {
+    UA_ByteString out;
+    UA_ByteString_init(&out);
+    UA_ByteString buf = UA_STRING("YXNk\n  ZmFz");
+
+    UA_StatusCode retval = UA_decodeXml(&buf, &out, &UA_TYPES[UA_TYPES_BYTESTRING], NULL);
+
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    UA_ByteString expected = UA_STRING("asdfas");
+    ck_assert(UA_ByteString_equal(&out, &expected));
+    UA_ByteString_clear(&out);
+}
+END_TEST
+
+START_TEST(UA_LocalizedText_xml_decode) {
+    UA_LocalizedText out;
+    UA_LocalizedText_init(&out);
+    UA_ByteString buf = UA_STRING("<Locale>en</Locale><Text>Hello World</Text>");
+
+    UA_StatusCode retval =
+        UA_decodeXml(&buf, &out, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT], NULL);
+
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    UA_LocalizedText expected = UA_LOCALIZEDTEXT("en", "Hello World");
+    ck_assert(UA_String_equal(&out.locale, &expected.locale));
+    ck_assert(UA_String_equal(&out.text, &expected.text));
+    UA_LocalizedText_clear(&out);
+}
+END_TEST
+
+START_TEST(UA_QualifiedName_xml_decode) {
+    UA_QualifiedName out;
+    UA_QualifiedName_init(&out);
+    UA_ByteString buf = UA_STRING("<NamespaceIndex>2</NamespaceIndex><Name>Temp</Name>");
+
+    UA_StatusCode retval =
+        UA_decodeXml(&buf, &out, &UA_TYPES[UA_TYPES_QUALIFIEDNAME], NULL);
+
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    UA_QualifiedName expected = UA_QUALIFIEDNAME(2, "Temp");
+    ck_assert(UA_QualifiedName_equal(&out, &expected));
+    UA_QualifiedName_clear(&out);
+}
+END_TEST
+
+/* Namespace prefixes, comments, a wrapped NodeId, an array member, a nested
+ * LocalizedText and an unknown element in between */
+START_TEST(UA_Argument_xml_decode) {
+    UA_Argument out;
+    UA_Argument_init(&out);
+    UA_ByteString buf = UA_STRING(
+        "<?xml version=\"1.0\"?>\n"
+        "<uax:Name>Input</uax:Name>\n"
+        "<!-- A comment -->\n"
+        "<uax:DataType><uax:Identifier>i=6</uax:Identifier></uax:DataType>\n"
+        "<uax:Unknown attr=\"a>b\"><uax:Nested/>text</uax:Unknown>\n"
+        "<uax:ValueRank>1</uax:ValueRank>\n"
+        "<uax:ArrayDimensions><uax:UInt32>3</uax:UInt32></uax:ArrayDimensions>\n"
+        "<uax:Description><uax:Locale>en</uax:Locale>"
+        "<uax:Text>The input</uax:Text></uax:Description>\n");
+
+    UA_StatusCode retval = UA_decodeXml(&buf, &out, &UA_TYPES[UA_TYPES_ARGUMENT], NULL);
+
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    UA_String name = UA_STRING("Input");
+    ck_assert(UA_String_equal(&out.name, &name));
+    ck_assert(UA_NodeId_equal(&out.dataType, &UA_TYPES[UA_TYPES_INT32].typeId));
+    ck_assert_int_eq(out.valueRank, 1);
+    ck_assert_uint_eq(out.arrayDimensionsSize, 1);
+    ck_assert_uint_eq(out.arrayDimensions[0], 3);
+    UA_String text = UA_STRING("The input");
+    ck_assert(UA_String_equal(&out.description.text, &text));
+    UA_Argument_clear(&out);
+}
+END_TEST
+
+START_TEST(UA_Argument_wrongEndTag_xml_decode) {
+    UA_Argument out;
+    UA_Argument_init(&out);
+    UA_ByteString buf = UA_STRING("<Name>Input</Name><ValueRank>1</Rank>");
+
+    UA_StatusCode retval = UA_decodeXml(&buf, &out, &UA_TYPES[UA_TYPES_ARGUMENT], NULL);
+
+    ck_assert_int_eq(retval, UA_STATUSCODE_BADDECODINGERROR);
+}
+END_TEST
+
+/* The ExtensionObjects in the Variant are unwrapped to an array of Arguments.
+ * The TypeId is the XML encoding NodeId. */
+START_TEST(UA_Variant_ListOfExtensionObject_xml_decode) {
+    UA_Variant out;
+    UA_Variant_init(&out);
+    UA_ByteString buf = UA_STRING(
+        "<ListOfExtensionObject>"
+        "<ExtensionObject><TypeId><Identifier>i=297</Identifier></TypeId>"
+        "<Body><Argument><Name>A</Name><ValueRank>-1</ValueRank></Argument></Body>"
+        "</ExtensionObject>"
+        "<ExtensionObject><TypeId><Identifier>i=297</Identifier></TypeId>"
+        "<Body><Argument><Name>B</Name><ValueRank>1</ValueRank></Argument></Body>"
+        "</ExtensionObject>"
+        "</ListOfExtensionObject>");
+
+    UA_StatusCode retval = UA_decodeXml(&buf, &out, &UA_TYPES[UA_TYPES_VARIANT], NULL);
+
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(out.type == &UA_TYPES[UA_TYPES_ARGUMENT]);
+    ck_assert_uint_eq(out.arrayLength, 2);
+    UA_Argument *args = (UA_Argument*)out.data;
+    UA_String b = UA_STRING("B");
+    ck_assert(UA_String_equal(&args[1].name, &b));
+    ck_assert_int_eq(args[0].valueRank, -1);
+    ck_assert_int_eq(args[1].valueRank, 1);
+    UA_Variant_clear(&out);
+}
+END_TEST
+
+START_TEST(UA_Variant_Scalar_xml_decode) {
+    UA_Variant out;
+    UA_Variant_init(&out);
+    UA_ByteString buf = UA_STRING("<Double> 42.5 </Double>");
+
+    UA_StatusCode retval = UA_decodeXml(&buf, &out, &UA_TYPES[UA_TYPES_VARIANT], NULL);
+
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasScalarType(&out, &UA_TYPES[UA_TYPES_DOUBLE]));
+    ck_assert(*(UA_Double*)out.data == 42.5);
+    UA_Variant_clear(&out);
+}
+END_TEST
+
+/* The body of an unknown type is kept in the XML encoding */
+START_TEST(UA_ExtensionObject_unknown_xml_decode) {
+    UA_ExtensionObject out;
+    UA_ExtensionObject_init(&out);
+    UA_ByteString buf = UA_STRING(
+        "<TypeId><Identifier>ns=1;i=5001</Identifier></TypeId>"
+        "<Body><MyType><Field>1</Field></MyType></Body>");
+
+    UA_StatusCode retval =
+        UA_decodeXml(&buf, &out, &UA_TYPES[UA_TYPES_EXTENSIONOBJECT], NULL);
+
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(out.encoding, UA_EXTENSIONOBJECT_ENCODED_XML);
+    UA_NodeId typeId = UA_NODEID_NUMERIC(1, 5001);
+    ck_assert(UA_NodeId_equal(&out.content.encoded.typeId, &typeId));
+    UA_String body = UA_STRING("<MyType><Field>1</Field></MyType>");
+    ck_assert(UA_String_equal(&out.content.encoded.body, &body));
+    UA_ExtensionObject_clear(&out);
+}
+END_TEST
+
 
 static Suite *testSuite_builtin_xml(void) {
     Suite *s = suite_create("Built-in Data Types 62541-5 Xml");
@@ -2683,6 +2862,17 @@ static Suite *testSuite_builtin_xml(void) {
     tcase_add_test(tc_xml_decode, UA_ExpandedNodeId_String_Namespace_ServerUri_xml_decode);
     tcase_add_test(tc_xml_decode, UA_ExpandedNodeId_ByteString_xml_decode);
 
+    tcase_add_test(tc_xml_decode, UA_String_entities_xml_decode);
+    tcase_add_test(tc_xml_decode, UA_String_badEntity_xml_decode);
+    tcase_add_test(tc_xml_decode, UA_ByteString_xml_decode);
+    tcase_add_test(tc_xml_decode, UA_LocalizedText_xml_decode);
+    tcase_add_test(tc_xml_decode, UA_QualifiedName_xml_decode);
+    tcase_add_test(tc_xml_decode, UA_Argument_xml_decode);
+    tcase_add_test(tc_xml_decode, UA_Argument_wrongEndTag_xml_decode);
+    tcase_add_test(tc_xml_decode, UA_Variant_ListOfExtensionObject_xml_decode);
+    tcase_add_test(tc_xml_decode, UA_Variant_Scalar_xml_decode);
+    tcase_add_test(tc_xml_decode, UA_ExtensionObject_unknown_xml_decode);
+
     suite_add_tcase(s, tc_xml_decode);
 
     return s;
@@ -0,0 +1,184 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/server.hpp>
+#include <open62541/server_config_default.h>
+
+#include <check.h>
+#include <stdlib.h>
+
+#include <string_view>
+#include <utility>
+
+static_assert(ua::isBound<UA_Int32>);
+static_assert(ua::isBound<const UA_String>);
+static_assert(!ua::isBound<int*>);
+static_assert(sizeof(ua::Owned<UA_Variant>) == sizeof(UA_Variant));
+
+START_TEST(bindTypes) {
+    ck_assert_ptr_eq(ua::dataType<UA_Boolean>(), &UA_TYPES[UA_TYPES_BOOLEAN]);
+    ck_assert_ptr_eq(ua::dataType<UA_Byte>(), &UA_TYPES[UA_TYPES_BYTE]);
+    ck_assert_ptr_eq(ua::dataType<UA_Double>(), &UA_TYPES[UA_TYPES_DOUBLE]);
+    ck_assert_ptr_eq(ua::dataType<UA_NodeId>(), &UA_TYPES[UA_TYPES_NODEID]);
+    ck_assert_ptr_eq(ua::dataType<UA_Variant>(), &UA_TYPES[UA_TYPES_VARIANT]);
+} END_TEST
+
+START_TEST(moveTransfersBuffers) {
+    ua::Owned<UA_String> a = ua::toString("hello");
+    ck_assert_uint_eq(a->length, 5);
+    const UA_Byte *buf = a->data;
+
+    /* The buffer is moved, not copied */
+    ua::Owned<UA_String> b(std::move(a));
+    ck_assert_ptr_eq(b->data, buf);
+    ck_assert_uint_eq(a->length, 0);
+    ck_assert_ptr_eq(a->data, NULL);
+
+    ua::Owned<UA_String> c;
+    c = std::move(b);
+    ck_assert_ptr_eq(c->data, buf);
+    ck_assert(ua::view(*c) == "hello");
+
+    /* Explicit deep copy */
+    ua::Owned<UA_String> d;
+    ck_assert_uint_eq(d.copyFrom(*c), UA_STATUSCODE_GOOD);
+    ck_assert_ptr_ne(d->data, buf);
+    ck_assert(UA_String_equal(d.get(), c.get()));
+
+    /* Adopt from and release to the C API */
+    UA_String raw = c.release();
+    ck_assert_ptr_eq(raw.data, buf);
+    ua::Owned<UA_String> e = ua::Owned<UA_String>::adopt(raw);
+    ck_assert_ptr_eq(raw.data, NULL);
+    ck_assert_ptr_eq(e->data, buf);
+} END_TEST
+
+START_TEST(stringViews) {
+    std::string_view sv("borrowed");
+    UA_String s = ua::borrow(sv);
+    ck_assert_ptr_eq(s.data, (const UA_Byte*)sv.data());
+    ck_assert_uint_eq(s.length, sv.size());
+    ck_assert(ua::view(s) == sv);
+    ck_assert(ua::view(UA_STRING_NULL).empty());
+} END_TEST
+
+START_TEST(variantMoveScalar) {
+    ua::Owned<UA_LocalizedText> lt;
+    lt->locale = UA_STRING_ALLOC("en-US");
+    lt->text = UA_STRING_ALLOC("the answer");
+    const UA_Byte *text = lt->text.data;
+
+    ua::Owned<UA_Variant> v;
+    ck_assert_uint_eq(ua::setScalar(v, std::move(lt)), UA_STATUSCODE_GOOD);
+    ck_assert_ptr_eq(lt->text.data, NULL);
+
+    const UA_LocalizedText *p = ua::scalar<UA_LocalizedText>(*v);
+    ck_assert_ptr_ne(p, NULL);
+    ck_assert_ptr_eq(p->text.data, text);
+    ck_assert_ptr_eq(ua::scalar<UA_String>(*v), NULL);
+
+    /* Numbers are set by value */
+    ck_assert_uint_eq(ua::setScalar(v, (UA_Int32)42), UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(*ua::scalar<UA_Int32>(*v), 42);
+} END_TEST
+
+START_TEST(variantArrays) {
+    ua::OwnedArray<UA_Double> arr(4);
+    ck_assert_ptr_ne(arr.data(), NULL);
+    for(size_t i = 0; i < arr.size(); i++)
+        arr[i] = (UA_Double)i;
+    const UA_Double *data = arr.data();
+
+    ua::Owned<UA_Variant> v;
+    ua::setArray(v, std::move(arr));
+    ck_assert_ptr_eq(arr.data(), NULL);
+
+    ua::ArrayView<const UA_Double> view = ua::array<UA_Double>(*v);
+    ck_assert_ptr_eq(view.data(), data);
+    ck_assert_uint_eq(view.size(), 4);
+    UA_Double sum = 0.0;
+    for(UA_Double d : view)
+        sum += d;
+    ck_assert(sum == 6.0);
+    ck_assert(ua::array<UA_Float>(*v).empty());
+
+    /* Empty array with the sentinel */
+    ua::setArray(v, ua::OwnedArray<UA_Int32>());
+    ck_assert(UA_Variant_hasArrayType(v.get(), &UA_TYPES[UA_TYPES_INT32]));
+    ck_assert(ua::array<UA_Int32>(*v).empty());
+    ck_assert_ptr_eq(ua::array<UA_Int32>(*v).data(), NULL);
+
+    /* Borrowed variant for the C API */
+    UA_Int32 ints[3] = {1, 2, 3};
+    UA_Variant b = ua::borrowArray(ua::ArrayView<const UA_Int32>(ints));
+    ck_assert_ptr_eq(b.data, ints);
+    ck_assert_uint_eq(b.arrayLength, 3);
+} END_TEST
+
+START_TEST(serverValueHandle) {
+    UA_Server *server = UA_Server_new();
+    ck_assert_ptr_ne(server, NULL);
+
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    UA_String initial = ua::borrow("initial");
+    attr.value = ua::borrowScalar(initial);
+    UA_NodeId nodeId = UA_NODEID_NUMERIC(1, 5000);
+    UA_QualifiedName name;
+    name.namespaceIndex = 1;
+    name.name = ua::borrow("cpp.string");
+    UA_StatusCode res =
+        UA_Server_addVariableNode(server, nodeId, UA_NS0ID(OBJECTSFOLDER),
+                                  UA_NS0ID(ORGANIZES),
+                                  name, UA_NODEID_NULL, attr, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    ua::ValueHandle<UA_String> h;
+    ck_assert(!h.valid());
+    ck_assert_uint_eq(h.resolve(server, nodeId), UA_STATUSCODE_GOOD);
+    ck_assert(h.valid());
+
+    ua::Owned<UA_String> s;
+    ck_assert_uint_eq(h.read(s), UA_STATUSCODE_GOOD);
+    ck_assert(ua::view(*s) == "initial");
+
+    ck_assert_uint_eq(h.write(ua::borrow("updated")), UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(h.read(s), UA_STATUSCODE_GOOD);
+    ck_assert(ua::view(*s) == "updated");
+
+    /* Wrong type */
+    ua::ValueHandle<UA_Int32> hi;
+    ck_assert_uint_eq(hi.resolve(server, nodeId), UA_STATUSCODE_GOOD);
+    UA_Int32 i = 0;
+    ck_assert_uint_eq(hi.read(i), UA_STATUSCODE_BADTYPEMISMATCH);
+
+    /* Moved handles are released once */
+    ua::ValueHandle<UA_String> h2(std::move(h));
+    ck_assert(!h.valid());
+    ck_assert_uint_eq(h2.read(s), UA_STATUSCODE_GOOD);
+    h2.reset();
+    hi.reset();
+
+    UA_Server_delete(server);
+} END_TEST
+
+int main(void) {
+    int number_failed = 0;
+    TCase *tc = tcase_create("cpp");
+    tcase_add_test(tc, bindTypes);
+    tcase_add_test(tc, moveTransfersBuffers);
+    tcase_add_test(tc, stringViews);
+    tcase_add_test(tc, variantMoveScalar);
+    tcase_add_test(tc, variantArrays);
+    tcase_add_test(tc, serverValueHandle);
+    Suite *s = suite_create("Test the C++ type wrappers");
+    suite_add_tcase(s, tc);
+
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed += srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
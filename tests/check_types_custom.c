@@ -3,10 +3,14 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #include <open62541/types.h>
+#include <open62541/util.h>
+
+#include "util/ua_util_internal.h"
 
 #include <stdlib.h>
 #include <check.h>
 #include <math.h>
+#include <float.h>
 
 #ifdef __clang__
 //required for ck_assert_ptr_eq and const casting
@@ -74,7 +78,8 @@ static const UA_DataType PointType = {
     false,                           /* .overlayable (depends on endianness and
                                          the absence of padding) */
     3,                               /* .membersSize */
-    members
+    members,                         /* .members */
+    12                               /* .binarySize */
 };
 
 const UA_DataTypeArray customDataTypes = {NULL, 1, &PointType, UA_FALSE};
@@ -133,7 +138,8 @@ static const UA_DataType OptType = {
         false,                           /* .overlayable (depends on endianness and
                                          the absence of padding) */
         4,                               /* .membersSize */
-        Opt_members
+        Opt_members,                     /* .members */
+        0                                /* .binarySize */
 };
 
 const UA_DataTypeArray customDataTypesOptStruct = {&customDataTypes, 2, &OptType, UA_FALSE};
@@ -191,7 +197,8 @@ static const UA_DataType ArrayOptType = {
     false,                           /* .overlayable (depends on endianness and
                                          the absence of padding) */
     4,                               /* .membersSize */
-    ArrayOptStruct_members
+    ArrayOptStruct_members,          /* .members */
+    0                                /* .binarySize */
 };
 
 const UA_DataTypeArray customDataTypesOptArrayStruct = {&customDataTypesOptStruct, 3, &ArrayOptType, UA_FALSE};
@@ -232,7 +239,8 @@ static const UA_DataType UniType = {
         false,
         false,
         2,
-        Uni_members
+        Uni_members,
+        0
 };
 
 const UA_DataTypeArray customDataTypesUnion = {&customDataTypesOptArrayStruct, 2, &UniType, UA_FALSE};
@@ -283,7 +291,8 @@ const UA_DataType selfContainingUnionType = {
     false, /* .pointerFree */
     false, /* .overlayable */
     2, /* .membersSize */
-    SelfContainingUnion_members  /* .members */
+    SelfContainingUnion_members, /* .members */
+    0 /* .binarySize */
 };
 
 const UA_DataTypeArray customDataTypesSelfContainingUnion = {NULL, 1, &selfContainingUnionType, UA_FALSE};
@@ -402,6 +411,73 @@ START_TEST(parseCustomArray) {
     UA_ByteString_clear(&buf);
 } END_TEST
 
+START_TEST(parseCustomArrayTypeRegistry) {
+    UA_DataTypeRegistry *r = UA_DataTypeRegistry_new();
+    ck_assert(r != NULL);
+
+    /* The builtin types are contained from the start */
+    ck_assert(UA_DataTypeRegistry_find(r, &UA_TYPES[UA_TYPES_READREQUEST].typeId) ==
+              &UA_TYPES[UA_TYPES_READREQUEST]);
+    ck_assert(UA_DataTypeRegistry_findByBinary(r, &UA_TYPES[UA_TYPES_READREQUEST].binaryEncodingId) ==
+              &UA_TYPES[UA_TYPES_READREQUEST]);
+    ck_assert(UA_DataTypeRegistry_find(r, &PointType.typeId) == NULL);
+    ck_assert(UA_DataTypeRegistry_findByBinary(r, &PointType.binaryEncodingId) == NULL);
+
+    UA_StatusCode retval = UA_DataTypeRegistry_add(r, &customDataTypes);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(UA_DataTypeRegistry_find(r, &PointType.typeId) == &PointType);
+    ck_assert(UA_DataTypeRegistry_findByBinary(r, &PointType.binaryEncodingId) == &PointType);
+
+    /* Adding the same type again replaces the entry */
+    retval = UA_DataTypeRegistry_add(r, &customDataTypes);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(UA_DataTypeRegistry_find(r, &PointType.typeId) == &PointType);
+
+    Point ps[10];
+    for(size_t i = 0; i < 10; ++i) {
+        ps[i].x = (UA_Float)(1*i);
+        ps[i].y = (UA_Float)(2*i);
+        ps[i].z = (UA_Float)(3*i);
+    }
+
+    UA_Variant var;
+    UA_Variant_init(&var);
+    UA_Variant_setArray(&var, (void*)ps, 10, &PointType);
+
+    UA_ByteString buf = UA_BYTESTRING_NULL;
+    retval = UA_encodeBinary(&var, &UA_TYPES[UA_TYPES_VARIANT], &buf);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Decode with the registry only */
+    UA_Variant var2;
+    UA_DecodeBinaryOptions opt;
+    memset(&opt, 0, sizeof(UA_DecodeBinaryOptions));
+    opt.typeRegistry = r;
+    retval = UA_decodeBinary(&buf, &var2, &UA_TYPES[UA_TYPES_VARIANT], &opt);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(var2.type == &PointType);
+    ck_assert_uint_eq(var2.arrayLength, 10);
+    for(size_t i = 0; i < 10; i++) {
+        Point *p2 = &((Point*)var2.data)[i];
+        ck_assert((int)p2->x == (int)ps[i].x);
+        ck_assert((int)p2->z == (int)ps[i].z);
+    }
+    UA_Variant_clear(&var2);
+
+    /* Types that are not in the registry fall back to the customTypes */
+    UA_DataTypeRegistry *builtinOnly = UA_DataTypeRegistry_new();
+    opt.typeRegistry = builtinOnly;
+    opt.customTypes = &customDataTypes;
+    retval = UA_decodeBinary(&buf, &var2, &UA_TYPES[UA_TYPES_VARIANT], &opt);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(var2.type == &PointType);
+    UA_Variant_clear(&var2);
+
+    UA_DataTypeRegistry_delete(builtinOnly);
+    UA_DataTypeRegistry_delete(r);
+    UA_ByteString_clear(&buf);
+} END_TEST
+
 START_TEST(parseCustomStructureWithOptionalFields) {
         Opt o;
         memset(&o, 0, sizeof(Opt));
@@ -686,18 +762,270 @@ START_TEST(parseSelfContainingUnionSelfMember) {
         UA_ByteString_clear(&buf);
     } END_TEST
 
+static void
+setField(UA_StructureField *f, const char *name, UA_NodeId dataType,
+         UA_Int32 valueRank, UA_Boolean isOptional) {
+    UA_StructureField_init(f);
+    f->name = UA_STRING((char*)(uintptr_t)name);
+    f->dataType = dataType;
+    f->valueRank = valueRank;
+    f->isOptional = isOptional;
+}
+
+static void
+setStructure(UA_StructureDescription *sd, const UA_DataType *type,
+             UA_StructureType structureType, UA_StructureField *fields,
+             size_t fieldsSize) {
+    UA_StructureDescription_init(sd);
+    sd->dataTypeId = type->typeId;
+    sd->structureDefinition.defaultEncodingId = type->binaryEncodingId;
+    sd->structureDefinition.structureType = structureType;
+    sd->structureDefinition.fields = fields;
+    sd->structureDefinition.fieldsSize = fieldsSize;
+}
+
+START_TEST(runtimeTypesFromSchema) {
+    UA_NodeId floatId = UA_TYPES[UA_TYPES_FLOAT].typeId;
+    UA_StructureField pointFields[3];
+    setField(&pointFields[0], "x", floatId, UA_VALUERANK_SCALAR, false);
+    setField(&pointFields[1], "y", floatId, UA_VALUERANK_SCALAR, false);
+    setField(&pointFields[2], "z", floatId, UA_VALUERANK_SCALAR, false);
+    UA_StructureField optFields[4];
+    setField(&optFields[0], "a", UA_TYPES[UA_TYPES_INT16].typeId, UA_VALUERANK_SCALAR, false);
+    setField(&optFields[1], "b", floatId, UA_VALUERANK_SCALAR, true);
+    setField(&optFields[2], "c", floatId, UA_VALUERANK_SCALAR, true);
+    setField(&optFields[3], "d", UA_TYPES[UA_TYPES_STRING].typeId, UA_VALUERANK_SCALAR, true);
+    UA_StructureField uniFields[2];
+    setField(&uniFields[0], "optionA", UA_TYPES[UA_TYPES_DOUBLE].typeId,
+             UA_VALUERANK_SCALAR, false);
+    setField(&uniFields[1], "optionB", UA_TYPES[UA_TYPES_STRING].typeId,
+             UA_VALUERANK_SCALAR, false);
+    UA_StructureField selfFields[2];
+    setField(&selfFields[0], "_double", UA_TYPES[UA_TYPES_DOUBLE].typeId,
+             UA_VALUERANK_SCALAR, false);
+    setField(&selfFields[1], "Array", selfContainingUnionType.typeId,
+             UA_VALUERANK_ONE_DIMENSION, false);
+
+    /* Contains Point by value and is defined before it */
+    UA_DataType outerType = PointType;
+    outerType.typeId = UA_NODEID_NUMERIC(1, 4300);
+    outerType.binaryEncodingId = UA_NODEID_STRING(1, "Outer.Binary");
+    UA_StructureField outerFields[3];
+    setField(&outerFields[0], "flag", UA_TYPES[UA_TYPES_BOOLEAN].typeId,
+             UA_VALUERANK_SCALAR, false);
+    setField(&outerFields[1], "point", PointType.typeId, UA_VALUERANK_SCALAR, false);
+    setField(&outerFields[2], "color", UA_NODEID_NUMERIC(1, 4301),
+             UA_VALUERANK_SCALAR, false);
+
+    UA_StructureDescription sds[5];
+    setStructure(&sds[0], &outerType, UA_STRUCTURETYPE_STRUCTURE, outerFields, 3);
+    setStructure(&sds[1], &PointType, UA_STRUCTURETYPE_STRUCTURE, pointFields, 3);
+    setStructure(&sds[2], &OptType, UA_STRUCTURETYPE_STRUCTUREWITHOPTIONALFIELDS,
+                 optFields, 4);
+    setStructure(&sds[3], &UniType, UA_STRUCTURETYPE_UNION, uniFields, 2);
+    setStructure(&sds[4], &selfContainingUnionType, UA_STRUCTURETYPE_UNION,
+                 selfFields, 2);
+    UA_EnumDescription colorEnum;
+    UA_EnumDescription_init(&colorEnum);
+    colorEnum.dataTypeId = UA_NODEID_NUMERIC(1, 4301);
+    colorEnum.name = UA_QUALIFIEDNAME(1, "Color");
+    colorEnum.builtInType = UA_NS0ID_INT32;
+
+    UA_DataTypeSchemaHeader schema;
+    UA_DataTypeSchemaHeader_init(&schema);
+    schema.structureDataTypes = sds;
+    schema.structureDataTypesSize = 5;
+    schema.enumDataTypes = &colorEnum;
+    schema.enumDataTypesSize = 1;
+
+    UA_DataTypeArray *arr = NULL;
+    UA_StatusCode retval = UA_DataTypeArray_fromSchema(&schema, NULL, &arr);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(arr->typesSize, 6);
+    ck_assert(arr->cleanup);
+
+    /* Same memory layout as the compiled definitions */
+    const UA_DataType *compiled[4] = {&PointType, &OptType, &UniType,
+                                      &selfContainingUnionType};
+    for(size_t i = 0; i < 4; i++) {
+        const UA_DataType *t = &arr->types[i+1];
+        const UA_DataType *c = compiled[i];
+        ck_assert(UA_NodeId_equal(&t->typeId, &c->typeId));
+        ck_assert(UA_NodeId_equal(&t->binaryEncodingId, &c->binaryEncodingId));
+        ck_assert_uint_eq(t->memSize, c->memSize);
+        ck_assert_uint_eq(t->typeKind, c->typeKind);
+        ck_assert_uint_eq(t->pointerFree, c->pointerFree);
+        ck_assert_uint_eq(t->binarySize, c->binarySize);
+        ck_assert_uint_eq(t->membersSize, c->membersSize);
+        for(size_t j = 0; j < c->membersSize; j++) {
+            ck_assert_uint_eq(t->members[j].padding, c->members[j].padding);
+            ck_assert_uint_eq(t->members[j].isArray, c->members[j].isArray);
+            ck_assert_uint_eq(t->members[j].isOptional, c->members[j].isOptional);
+        }
+    }
+    ck_assert(arr->types[4].members[1].memberType == &arr->types[4]);
+    ck_assert(arr->types[0].members[1].memberType == &arr->types[1]);
+    ck_assert(arr->types[0].members[2].memberType == &arr->types[5]);
+    ck_assert_uint_eq(arr->types[5].typeKind, UA_DATATYPEKIND_ENUM);
+    ck_assert_uint_eq(arr->types[0].binarySize, 1 + 12 + 4);
+
+    /* Decode with the runtime type and encode again */
+    UA_Float b = 2.5f;
+    UA_String d = UA_STRING("open62541");
+    Opt o = {3, &b, NULL, &d};
+    UA_ByteString buf = UA_BYTESTRING_NULL;
+    retval = UA_encodeBinary(&o, &OptType, &buf);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    Opt o2;
+    retval = UA_decodeBinary(&buf, &o2, &arr->types[2], NULL);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(o2.a, 3);
+    ck_assert(o2.b != NULL && *o2.b == 2.5f);
+    ck_assert(o2.c == NULL);
+    ck_assert(o2.d != NULL && UA_String_equal(o2.d, &d));
+    UA_ByteString buf2 = UA_BYTESTRING_NULL;
+    retval = UA_encodeBinary(&o2, &arr->types[2], &buf2);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(UA_ByteString_equal(&buf, &buf2));
+    UA_clear(&o2, &arr->types[2]);
+    UA_ByteString_clear(&buf);
+    UA_ByteString_clear(&buf2);
+
+    /* The schema can be stored and used again */
+    retval = UA_encodeBinary(&schema, &UA_TYPES[UA_TYPES_DATATYPESCHEMAHEADER], &buf);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    UA_DataTypeSchemaHeader schema2;
+    retval = UA_decodeBinary(&buf, &schema2, &UA_TYPES[UA_TYPES_DATATYPESCHEMAHEADER], NULL);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    UA_ByteString_clear(&buf);
+    UA_DataTypeArray *arr2 = NULL;
+    retval = UA_DataTypeArray_fromSchema(&schema2, NULL, &arr2);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    UA_DataTypeSchemaHeader_clear(&schema2);
+    ck_assert(UA_NodeId_equal(&arr2->types[0].binaryEncodingId,
+                              &outerType.binaryEncodingId));
+    ck_assert_uint_eq(arr2->types[0].memSize, arr->types[0].memSize);
+    UA_cleanupDataTypeWithCustom(arr2);
+
+    /* Unknown member types are rejected */
+    setField(&outerFields[2], "color", UA_NODEID_NUMERIC(1, 4999),
+             UA_VALUERANK_SCALAR, false);
+    retval = UA_DataTypeArray_fromSchema(&schema, NULL, &arr2);
+    ck_assert_int_eq(retval, UA_STATUSCODE_BADDATATYPEIDUNKNOWN);
+
+    UA_cleanupDataTypeWithCustom(arr);
+} END_TEST
+
+/* Numeric arrays with member types that are not overlayable. On little-endian
+ * hosts with IEEE 754 floats, this is the only way to exercise the batch
+ * conversion of fixed-size numeric arrays in the binary codec. */
+
+typedef struct {
+    size_t int16Size;
+    UA_Int16 *int16;
+    size_t uint32Size;
+    UA_UInt32 *uint32;
+    size_t int64Size;
+    UA_Int64 *int64;
+    size_t floatsSize;
+    UA_Float *floats;
+    size_t doublesSize;
+    UA_Double *doubles;
+    size_t dateTimesSize;
+    UA_DateTime *dateTimes;
+} NumericArrays;
+
+#define NUMERICARRAYS_MEMBERS 6
+
+static const UA_UInt16 numericTypeIndex[NUMERICARRAYS_MEMBERS] = {
+    UA_TYPES_INT16, UA_TYPES_UINT32, UA_TYPES_INT64,
+    UA_TYPES_FLOAT, UA_TYPES_DOUBLE, UA_TYPES_DATETIME};
+
+static UA_DataType fixedNumericTypes[NUMERICARRAYS_MEMBERS];
+static UA_DataTypeMember fixedNumericMembers[NUMERICARRAYS_MEMBERS];
+static UA_DataTypeMember numericMembers[NUMERICARRAYS_MEMBERS];
+
+static void
+initNumericArraysType(UA_DataType *fixedType, UA_DataType *type) {
+    memset(fixedNumericMembers, 0, sizeof(fixedNumericMembers));
+    memset(numericMembers, 0, sizeof(numericMembers));
+    for(size_t i = 0; i < NUMERICARRAYS_MEMBERS; i++) {
+        fixedNumericTypes[i] = UA_TYPES[numericTypeIndex[i]];
+        fixedNumericTypes[i].overlayable = false;
+        fixedNumericMembers[i].memberType = &fixedNumericTypes[i];
+        fixedNumericMembers[i].isArray = true;
+        numericMembers[i].memberType = &UA_TYPES[numericTypeIndex[i]];
+        numericMembers[i].isArray = true;
+    }
+
+    memset(type, 0, sizeof(UA_DataType));
+    type->typeId = UA_NODEID_NUMERIC(1, 4243);
+    type->binaryEncodingId = UA_NODEID_NUMERIC(1, 4244);
+    type->memSize = sizeof(NumericArrays);
+    type->typeKind = UA_DATATYPEKIND_STRUCTURE;
+    type->membersSize = NUMERICARRAYS_MEMBERS;
+    type->members = numericMembers;
+    *fixedType = *type;
+    fixedType->members = fixedNumericMembers;
+}
+
+START_TEST(parseNonOverlayableNumericArrays) {
+    UA_DataType type, fixedType;
+    initNumericArraysType(&fixedType, &type);
+
+    UA_Int16 int16[3] = {-2, 0, 0x1234};
+    UA_UInt32 uint32[4] = {0, 1, 0xdeadbeef, UA_UINT32_MAX};
+    UA_Int64 int64[2] = {UA_INT64_MIN, 0x0102030405060708};
+    UA_Float floats[4] = {0.0f, -0.0f, 1.5f, (UA_Float)INFINITY};
+    UA_Double doubles[5] = {0.0, -1.25, 3.14159265358979, DBL_MAX, -INFINITY};
+    UA_DateTime dateTimes[1] = {UA_DATETIME_UNIX_EPOCH};
+    NumericArrays na = {3, int16, 4, uint32, 2, int64,
+                        4, floats, 5, doubles, 1, dateTimes};
+
+    /* The batch encoding is identical to the memcpy encoding */
+    UA_ByteString fixedBuf = UA_BYTESTRING_NULL;
+    UA_ByteString buf = UA_BYTESTRING_NULL;
+    UA_StatusCode retval = UA_encodeBinary(&na, &fixedType, &fixedBuf);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    retval = UA_encodeBinary(&na, &type, &buf);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(UA_ByteString_equal(&fixedBuf, &buf));
+    ck_assert_uint_eq(UA_calcSizeBinary(&na, &fixedType), buf.length);
+
+    /* Decode with the batch conversion */
+    NumericArrays out;
+    retval = UA_decodeBinary(&buf, &out, &fixedType, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(UA_order(&na, &out, &type) == UA_ORDER_EQ);
+    ck_assert(signbit(out.floats[1]));
+
+    /* Truncated input is rejected */
+    buf.length -= 4;
+    NumericArrays out2;
+    retval = UA_decodeBinary(&buf, &out2, &fixedType, NULL);
+    ck_assert_uint_ne(retval, UA_STATUSCODE_GOOD);
+    buf.length += 4;
+
+    UA_clear(&out, &fixedType);
+    UA_ByteString_clear(&buf);
+    UA_ByteString_clear(&fixedBuf);
+} END_TEST
+
 int main(void) {
     Suite *s  = suite_create("Test Custom DataType Encoding");
     TCase *tc = tcase_create("test cases");
     tcase_add_test(tc, parseCustomScalar);
     tcase_add_test(tc, parseCustomScalarExtensionObject);
     tcase_add_test(tc, parseCustomArray);
+    tcase_add_test(tc, parseCustomArrayTypeRegistry);
     tcase_add_test(tc, parseCustomStructureWithOptionalFields);
     tcase_add_test(tc, parseCustomUnion);
     tcase_add_test(tc, parseSelfContainingUnionNormalMember);
     tcase_add_test(tc, parseSelfContainingUnionSelfMember);
     tcase_add_test(tc, parseCustomStructureWithOptionalFieldsWithArrayNotContained);
     tcase_add_test(tc, parseCustomStructureWithOptionalFieldsWithArrayContained);
+    tcase_add_test(tc, runtimeTypesFromSchema);
+    tcase_add_test(tc, parseNonOverlayableNumericArrays);
     suite_add_tcase(s, tc);
 
     SRunner *sr = srunner_create(s);
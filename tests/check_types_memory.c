@@ -53,6 +53,50 @@ START_TEST(arrayCopyShallMakeADeepCopy) {
 }
 END_TEST
 
+START_TEST(arrayCopyStructureShallMakeADeepCopy) {
+    // given
+    UA_ReadValueId a1[16];
+    UA_DataValue d1[16];
+    for(size_t i = 0; i < 16; i++) {
+        UA_ReadValueId_init(&a1[i]);
+        a1[i].nodeId = UA_NODEID_STRING_ALLOC(1, "node");
+        a1[i].attributeId = (UA_UInt32)i;
+        a1[i].indexRange = UA_STRING_ALLOC("1:2");
+        a1[i].dataEncoding = UA_QUALIFIEDNAME_ALLOC(0, "Default Binary");
+        UA_DataValue_init(&d1[i]);
+        UA_Variant_setScalarCopy(&d1[i].value, &a1[i].indexRange,
+                                 &UA_TYPES[UA_TYPES_STRING]);
+        d1[i].hasValue = true;
+        d1[i].sourceTimestamp = (UA_DateTime)i;
+        d1[i].hasSourceTimestamp = true;
+    }
+    // when
+    UA_ReadValueId *a2;
+    UA_DataValue *d2;
+    UA_StatusCode retval =
+        UA_Array_copy(a1, 16, (void **)&a2, &UA_TYPES[UA_TYPES_READVALUEID]);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    retval = UA_Array_copy(d1, 16, (void **)&d2, &UA_TYPES[UA_TYPES_DATAVALUE]);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    // then
+    for(size_t i = 0; i < 16; i++) {
+        ck_assert(UA_order(&a1[i], &a2[i], &UA_TYPES[UA_TYPES_READVALUEID]) == UA_ORDER_EQ);
+        ck_assert_ptr_ne(a1[i].indexRange.data, a2[i].indexRange.data);
+        ck_assert_ptr_ne(a1[i].nodeId.identifier.string.data,
+                         a2[i].nodeId.identifier.string.data);
+        ck_assert(UA_order(&d1[i], &d2[i], &UA_TYPES[UA_TYPES_DATAVALUE]) == UA_ORDER_EQ);
+        ck_assert_ptr_ne(d1[i].value.data, d2[i].value.data);
+    }
+    // finally
+    for(size_t i = 0; i < 16; i++) {
+        UA_ReadValueId_clear(&a1[i]);
+        UA_DataValue_clear(&d1[i]);
+    }
+    UA_Array_delete(a2, 16, &UA_TYPES[UA_TYPES_READVALUEID]);
+    UA_Array_delete(d2, 16, &UA_TYPES[UA_TYPES_DATAVALUE]);
+}
+END_TEST
+
 START_TEST(encodeShallYieldDecode) {
     // given
     UA_ByteString msg1, msg2;
@@ -225,6 +269,30 @@ START_TEST(calcSizeBinaryShallBeCorrect) {
 }
 END_TEST
 
+START_TEST(calcSizeBinaryFixedSizeArray) {
+    const UA_DataType *type = &UA_TYPES[_i];
+    if(type->binarySize == 0)
+        return;
+
+    /* The size of arrays is computed from the fixed binary size. Structures
+     * are wrapped in ExtensionObjects in the Variant. */
+    UA_Variant v;
+    UA_Variant_init(&v);
+    void *arr = UA_Array_new(3, type);
+    UA_Variant_setArray(&v, arr, 3, type);
+    size_t predicted_size = UA_calcSizeBinary(&v, &UA_TYPES[UA_TYPES_VARIANT]);
+    if(type->typeKind <= UA_DATATYPEKIND_DIAGNOSTICINFO)
+        ck_assert_uint_eq(predicted_size, 1 + 4 + 3 * type->binarySize);
+
+    UA_ByteString msg = UA_BYTESTRING_NULL;
+    UA_StatusCode retval = UA_encodeBinary(&v, &UA_TYPES[UA_TYPES_VARIANT], &msg);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(msg.length, predicted_size);
+    UA_Variant_clear(&v);
+    UA_ByteString_clear(&msg);
+}
+END_TEST
+
 int main(void) {
     int number_failed = 0;
     SRunner *sr;
@@ -233,6 +301,7 @@ int main(void) {
     TCase *tc = tcase_create("Empty Objects");
     tcase_add_loop_test(tc, newAndEmptyObjectShallBeDeleted, UA_TYPES_BOOLEAN, UA_TYPES_COUNT - 1);
     tcase_add_test(tc, arrayCopyShallMakeADeepCopy);
+    tcase_add_test(tc, arrayCopyStructureShallMakeADeepCopy);
     tcase_add_loop_test(tc, encodeShallYieldDecode, UA_TYPES_BOOLEAN, UA_TYPES_COUNT - 1);
     suite_add_tcase(s, tc);
     tc = tcase_create("Truncated Buffers");
@@ -249,6 +318,7 @@ int main(void) {
 
     tc = tcase_create("Test calcSizeBinary");
     tcase_add_loop_test(tc, calcSizeBinaryShallBeCorrect, UA_TYPES_BOOLEAN, UA_TYPES_COUNT - 1);
+    tcase_add_loop_test(tc, calcSizeBinaryFixedSizeArray, UA_TYPES_BOOLEAN, UA_TYPES_COUNT - 1);
     suite_add_tcase(s, tc);
 
     sr = srunner_create(s);
@@ -43,6 +43,64 @@ START_TEST(base64) {
     UA_ByteString_clear(&test2out);
 } END_TEST
 
+static void
+refBase64(const UA_Byte *in, size_t len, char *out) {
+    static const char tab[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    for(size_t i = 0; i < len; i += 3) {
+        unsigned v = (unsigned)in[i] << 16;
+        if(i + 1 < len) v |= (unsigned)in[i+1] << 8;
+        if(i + 2 < len) v |= in[i+2];
+        *out++ = tab[(v >> 18) & 0x3f];
+        *out++ = tab[(v >> 12) & 0x3f];
+        *out++ = (i + 1 < len) ? tab[(v >> 6) & 0x3f] : '=';
+        *out++ = (i + 2 < len) ? tab[v & 0x3f] : '=';
+    }
+}
+
+/* Covers the block sizes of the vectorized implementations and the scalar
+ * remainder */
+START_TEST(base64Lengths) {
+    UA_Byte data[200];
+    char ref[272];
+    for(size_t i = 0; i < sizeof(data); i++)
+        data[i] = (UA_Byte)UA_UInt32_random();
+    for(size_t len = 1; len <= sizeof(data); len++) {
+        UA_ByteString bs = {len, data};
+        UA_String b64;
+        ck_assert_int_eq(UA_ByteString_toBase64(&bs, &b64), UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(b64.length, 4 * ((len + 2) / 3));
+        refBase64(data, len, ref);
+        ck_assert(memcmp(b64.data, ref, b64.length) == 0);
+
+        UA_ByteString out;
+        ck_assert_int_eq(UA_ByteString_fromBase64(&out, &b64), UA_STATUSCODE_GOOD);
+        ck_assert(UA_ByteString_equal(&bs, &out));
+        UA_ByteString_clear(&out);
+
+        /* The URL-safe alphabet decodes to the same */
+        for(size_t i = 0; i < b64.length; i++) {
+            if(b64.data[i] == '+') b64.data[i] = '-';
+            if(b64.data[i] == '/') b64.data[i] = '_';
+        }
+        ck_assert_int_eq(UA_ByteString_fromBase64(&out, &b64), UA_STATUSCODE_GOOD);
+        ck_assert(UA_ByteString_equal(&bs, &out));
+        UA_ByteString_clear(&out);
+
+        /* An invalid character anywhere is detected */
+        if(len % 17 == 0 && len > 0) {
+            for(size_t i = 0; i < b64.length; i++) {
+                UA_Byte orig = b64.data[i];
+                b64.data[i] = (i % 2) ? '*' : 0xc3;
+                ck_assert_int_ne(UA_ByteString_fromBase64(&out, &b64),
+                                 UA_STATUSCODE_GOOD);
+                b64.data[i] = orig;
+            }
+        }
+        UA_String_clear(&b64);
+    }
+} END_TEST
+
 /* Example taken from Part 6, 5.2.2.6 */
 START_TEST(parseGuid) {
     UA_Guid guid = UA_GUID("72962B91-FA75-4AE6-8D28-B404DC7DAF63");
@@ -115,6 +173,86 @@ START_TEST(parseNodeIdByteString) {
     UA_NodeId_clear(&id);
 } END_TEST
 
+/* The fast path and the lexer must agree. The last entries are outside the
+ * fast path (overflow, leading zeros beyond the digit limit, etc.). */
+START_TEST(parseNodeIdFastPath) {
+    const char *strs[] = {"i=0", "i=4294967295", "ns=65535;i=7", "ns=0;s=",
+                          "ns=2;s=a;b=c", "s=x", "ns=1;g=09087e75-8e5e-499b-954f-f2a9603db28a",
+                          "i=4294967296", "ns=65536;i=1", "ns=000001;s=y",
+                          "i=", "ns=;i=1", "ns=1i=1", "x=1", "i=12a", ""};
+    UA_StatusCode expected[] = {UA_STATUSCODE_GOOD, UA_STATUSCODE_GOOD,
+                                UA_STATUSCODE_GOOD, UA_STATUSCODE_GOOD,
+                                UA_STATUSCODE_GOOD, UA_STATUSCODE_GOOD,
+                                UA_STATUSCODE_GOOD, UA_STATUSCODE_GOOD,
+                                UA_STATUSCODE_GOOD, UA_STATUSCODE_GOOD,
+                                UA_STATUSCODE_GOOD, UA_STATUSCODE_BADDECODINGERROR,
+                                UA_STATUSCODE_BADDECODINGERROR,
+                                UA_STATUSCODE_BADDECODINGERROR,
+                                UA_STATUSCODE_BADDECODINGERROR,
+                                UA_STATUSCODE_BADDECODINGERROR};
+    for(size_t i = 0; i < sizeof(strs) / sizeof(strs[0]); i++) {
+        UA_String str = UA_STRING((char*)(uintptr_t)strs[i]);
+        UA_NodeId id, borrowed;
+        UA_StatusCode res = UA_NodeId_parse(&id, str);
+        ck_assert_uint_eq(res, expected[i]);
+        res = UA_NodeId_parseBorrowed(&borrowed, str);
+        ck_assert_uint_eq(res, expected[i]);
+        ck_assert(UA_NodeId_equal(&id, &borrowed));
+        if(borrowed.identifierType == UA_NODEIDTYPE_STRING &&
+           borrowed.identifier.string.length > 0)
+            ck_assert_ptr_eq(borrowed.identifier.string.data,
+                             str.data + str.length - borrowed.identifier.string.length);
+
+        UA_ExpandedNodeId eid;
+        res = UA_ExpandedNodeId_parse(&eid, str);
+        ck_assert_uint_eq(res, expected[i]);
+        ck_assert(UA_NodeId_equal(&id, &eid.nodeId));
+        ck_assert_uint_eq(eid.serverIndex, 0);
+        ck_assert_ptr_eq(eid.namespaceUri.data, NULL);
+        UA_ExpandedNodeId_clear(&eid);
+        UA_NodeId_clear(&id);
+    }
+
+    UA_NodeId id = UA_NODEID("ns=1;i=4294967295");
+    ck_assert_uint_eq(id.identifier.numeric, 4294967295u);
+    ck_assert_uint_eq(id.namespaceIndex, 1);
+
+    UA_NodeId bid;
+    UA_StatusCode res =
+        UA_NodeId_parseBorrowed(&bid, UA_STRING("ns=1;b=b3BlbjYyNTQxIQ=="));
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADNOTSUPPORTED);
+    ck_assert(UA_NodeId_isNull(&bid));
+} END_TEST
+
+START_TEST(parseNodeIdArray) {
+    UA_String strs[5];
+    strs[0] = UA_STRING("ns=1;i=42");
+    strs[1] = UA_STRING("ns=2;s=Tag.Sub");
+    strs[2] = UA_STRING("ns=1;b=b3BlbjYyNTQxIQ==");
+    strs[3] = UA_STRING("ns=70000;s=Wrapped");
+    strs[4] = UA_STRING("g=09087e75-8e5e-499b-954f-f2a9603db28a");
+    UA_NodeId *ids = NULL;
+    UA_StatusCode res = UA_NodeId_parseArray(&ids, strs, 5, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < 5; i++) {
+        UA_NodeId id;
+        res = UA_NodeId_parse(&id, strs[i]);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        ck_assert(UA_NodeId_equal(&id, &ids[i]));
+        UA_NodeId_clear(&id);
+    }
+    /* The identifiers live in the same allocation */
+    ck_assert_ptr_eq(ids[1].identifier.string.data, (UA_Byte*)&ids[5]);
+    UA_free(ids);
+
+    strs[3] = UA_STRING("ns=1;x=1");
+    size_t failed = 0;
+    res = UA_NodeId_parseArray(&ids, strs, 5, &failed);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADDECODINGERROR);
+    ck_assert_uint_eq(failed, 3);
+    ck_assert_ptr_eq(ids, NULL);
+} END_TEST
+
 START_TEST(parseExpandedNodeIdInteger) {
     UA_ExpandedNodeId id = UA_EXPANDEDNODEID("ns=1;i=1337");
     ck_assert_int_eq(id.nodeId.identifierType, UA_NODEIDTYPE_NUMERIC);
@@ -359,6 +497,7 @@ int main(void) {
     Suite *s  = suite_create("Test Builtin Type Parsing");
     TCase *tc = tcase_create("test cases");
     tcase_add_test(tc, base64);
+    tcase_add_test(tc, base64Lengths);
     tcase_add_test(tc, parseGuid);
     tcase_add_test(tc, parseNodeIdNumeric);
     tcase_add_test(tc, parseNodeIdNumeric2);
@@ -366,6 +505,8 @@ int main(void) {
     tcase_add_test(tc, parseNodeIdGuid);
     tcase_add_test(tc, parseNodeIdGuidFail);
     tcase_add_test(tc, parseNodeIdByteString);
+    tcase_add_test(tc, parseNodeIdFastPath);
+    tcase_add_test(tc, parseNodeIdArray);
     tcase_add_test(tc, parseExpandedNodeIdInteger);
     tcase_add_test(tc, parseExpandedNodeIdInteger2);
     tcase_add_test(tc, parseExpandedNodeIdIntegerNSU);
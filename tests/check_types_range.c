@@ -116,6 +116,150 @@ START_TEST(copyArrayRangeUpperBoundOutOfRange) {
 }
 END_TEST
 
+/* Reference implementation: test every index of the array for the range */
+static void
+checkRangeCopy(const UA_UInt32 *dims, size_t dimsSize, const UA_NumericRange r,
+               const UA_Variant *v, const UA_Variant *v2) {
+    size_t total = v->arrayLength;
+    size_t expected = 0;
+    const UA_UInt32 *src = (const UA_UInt32*)v->data;
+    const UA_UInt32 *dst = (const UA_UInt32*)v2->data;
+    for(size_t i = 0; i < total; i++) {
+        size_t rest = i;
+        UA_Boolean inRange = true;
+        for(size_t k = dimsSize; k > 0; k--) {
+            size_t idx = rest % dims[k-1];
+            rest /= dims[k-1];
+            if(idx < r.dimensions[k-1].min || idx > r.dimensions[k-1].max)
+                inRange = false;
+        }
+        if(!inRange)
+            continue;
+        ck_assert_uint_lt(expected, v2->arrayLength);
+        ck_assert_uint_eq(dst[expected], src[i]);
+        expected++;
+    }
+    ck_assert_uint_eq(expected, v2->arrayLength);
+}
+
+/* Several partially covered dimensions in a 3D array */
+START_TEST(copyRange3D) {
+    UA_UInt32 dims[3] = {4, 5, 6};
+    UA_UInt32 arr[4*5*6];
+    for(UA_UInt32 i = 0; i < 4*5*6; i++)
+        arr[i] = i;
+    UA_Variant v;
+    UA_Variant_setArray(&v, arr, 4*5*6, &UA_TYPES[UA_TYPES_UINT32]);
+    v.arrayDimensions = dims;
+    v.arrayDimensionsSize = 3;
+
+    const char *ranges[] = {"0:3,1:2,1:2", "1:2,0:4,3", "2,1:3,0:5",
+                            "0:3,0:4,0:5", "1:3,2,0:5", "3,4,5", "0:3,1:3,4"};
+    for(size_t i = 0; i < sizeof(ranges) / sizeof(ranges[0]); i++) {
+        UA_NumericRange r;
+        UA_StatusCode retval =
+            UA_NumericRange_parse(&r, UA_STRING((char*)(uintptr_t)ranges[i]));
+        ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+        UA_Variant v2;
+        retval = UA_Variant_copyRange(&v, &v2, r);
+        ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+        checkRangeCopy(dims, 3, r, &v, &v2);
+        ck_assert_uint_eq(v2.arrayDimensionsSize, 3);
+        UA_Variant_clear(&v2);
+        UA_free(r.dimensions);
+    }
+} END_TEST
+
+/* Write a column into a matrix and read it back */
+START_TEST(setRangeColumn) {
+    UA_UInt32 dims[2] = {100, 50};
+    UA_Double *matrix = (UA_Double*)
+        UA_Array_new(100 * 50, &UA_TYPES[UA_TYPES_DOUBLE]);
+    UA_Variant v;
+    UA_Variant_setArray(&v, matrix, 100 * 50, &UA_TYPES[UA_TYPES_DOUBLE]);
+    UA_StatusCode retval =
+        UA_Array_copy(dims, 2, (void**)&v.arrayDimensions,
+                      &UA_TYPES[UA_TYPES_UINT32]);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    v.arrayDimensionsSize = 2;
+
+    UA_Double column[100];
+    for(size_t i = 0; i < 100; i++)
+        column[i] = (UA_Double)i + 0.5;
+    UA_NumericRange r;
+    retval = UA_NumericRange_parse(&r, UA_STRING("0:99,7"));
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    retval = UA_Variant_setRangeCopy(&v, column, 100, r);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < 100; i++) {
+        ck_assert(matrix[i * 50 + 7] == column[i]);
+        ck_assert(matrix[i * 50 + 6] == 0.0);
+    }
+
+    UA_Variant v2;
+    retval = UA_Variant_copyRange(&v, &v2, r);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(v2.arrayLength, 100);
+    ck_assert(memcmp(v2.data, column, sizeof(column)) == 0);
+    UA_Variant_clear(&v2);
+    UA_free(r.dimensions);
+
+    /* The written range must be within the array */
+    retval = UA_NumericRange_parse(&r, UA_STRING("60:159,7"));
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    retval = UA_Variant_setRangeCopy(&v, column, 100, r);
+    ck_assert_int_eq(retval, UA_STATUSCODE_BADINDEXRANGEINVALID);
+    UA_free(r.dimensions);
+
+    UA_Variant_clear(&v);
+} END_TEST
+
+/* Move strings into a range. The replaced strings are freed. */
+START_TEST(setRangeMoveStrings) {
+    UA_String *arr = (UA_String*)UA_Array_new(6, &UA_TYPES[UA_TYPES_STRING]);
+    for(size_t i = 0; i < 6; i++)
+        arr[i] = UA_STRING_ALLOC("old");
+    UA_Variant v;
+    UA_Variant_setArray(&v, arr, 6, &UA_TYPES[UA_TYPES_STRING]);
+
+    UA_String repl[2];
+    repl[0] = UA_STRING_ALLOC("new0");
+    repl[1] = UA_STRING_ALLOC("new1");
+    UA_NumericRange r;
+    UA_StatusCode retval = UA_NumericRange_parse(&r, UA_STRING("2:3"));
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    retval = UA_Variant_setRange(&v, repl, 2, r);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(repl[0].data == NULL && repl[1].data == NULL);
+    UA_String new1 = UA_STRING("new1");
+    ck_assert(UA_String_equal(&arr[3], &new1));
+    UA_free(r.dimensions);
+    UA_Variant_clear(&v);
+} END_TEST
+
+START_TEST(parseRangeInto) {
+    UA_NumericRangeDimension buf[2];
+    UA_NumericRange range;
+    UA_StatusCode retval =
+        UA_NumericRange_parseInto(&range, buf, 2, UA_STRING("1:2,3"));
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_ptr_eq(range.dimensions, buf);
+    ck_assert_uint_eq(range.dimensionsSize, 2);
+
+    /* Too many dimensions for the buffer */
+    retval = UA_NumericRange_parseInto(&range, buf, 2, UA_STRING("1:2,3,4:5,6"));
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_ptr_ne(range.dimensions, buf);
+    ck_assert_uint_eq(range.dimensionsSize, 4);
+    ck_assert_uint_eq(range.dimensions[0].max, 2);
+    ck_assert_uint_eq(range.dimensions[2].min, 4);
+    ck_assert_uint_eq(range.dimensions[3].max, 6);
+    UA_free(range.dimensions);
+
+    retval = UA_NumericRange_parseInto(&range, buf, 2, UA_STRING("1:2,3,x"));
+    ck_assert_int_eq(retval, UA_STATUSCODE_BADINDEXRANGEINVALID);
+} END_TEST
+
 int main(void) {
     Suite *s  = suite_create("Test Variant Range Access");
     TCase *tc = tcase_create("test cases");
@@ -124,6 +268,10 @@ int main(void) {
     tcase_add_test(tc, copySimpleArrayRange);
     tcase_add_test(tc, copyIntoStringArrayRange);
     tcase_add_test(tc, copyArrayRangeUpperBoundOutOfRange);
+    tcase_add_test(tc, copyRange3D);
+    tcase_add_test(tc, setRangeColumn);
+    tcase_add_test(tc, setRangeMoveStrings);
+    tcase_add_test(tc, parseRangeInto);
     suite_add_tcase(s, tc);
 
     SRunner *sr = srunner_create(s);
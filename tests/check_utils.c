@@ -567,6 +567,129 @@ START_TEST(idOrderString) {
     ck_assert(UA_NodeId_order(&id_str_d, &id_str_c) == UA_ORDER_MORE);
 } END_TEST
 
+START_TEST(arenaDecode) {
+    UA_Arena arena;
+    memset(&arena, 0, sizeof(UA_Arena));
+    /* The array fits into the first block, the strings need more blocks */
+    arena.blockSize = 8 * sizeof(UA_ReadValueId) + 64;
+
+    UA_ReadRequest req;
+    UA_ReadRequest_init(&req);
+    UA_ReadValueId rvi[8];
+    for(size_t i = 0; i < 8; i++) {
+        UA_ReadValueId_init(&rvi[i]);
+        rvi[i].nodeId = UA_NODEID_STRING(1, "some.rather.long.node.identifier");
+        rvi[i].attributeId = UA_ATTRIBUTEID_VALUE;
+    }
+    req.nodesToRead = rvi;
+    req.nodesToReadSize = 8;
+
+    UA_ByteString buf = UA_BYTESTRING_NULL;
+    UA_StatusCode res = UA_encodeBinary(&req, &UA_TYPES[UA_TYPES_READREQUEST], &buf);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_DecodeBinaryOptions opts;
+    memset(&opts, 0, sizeof(UA_DecodeBinaryOptions));
+    opts.callocContext = &arena;
+    opts.calloc = UA_Arena_calloc;
+
+    /* Decode twice to reuse the retained block */
+    for(size_t j = 0; j < 2; j++) {
+        UA_ReadRequest out;
+        res = UA_decodeBinary(&buf, &out, &UA_TYPES[UA_TYPES_READREQUEST], &opts);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(out.nodesToReadSize, 8);
+        ck_assert(UA_NodeId_equal(&out.nodesToRead[7].nodeId, &rvi[7].nodeId));
+        ck_assert_uint_eq((uintptr_t)out.nodesToRead % sizeof(UA_UInt64), 0);
+        ck_assert(arena.blocks->next != NULL); /* Multiple blocks were used */
+        UA_Arena_reset(&arena);
+        ck_assert(arena.blocks->next == NULL);
+        ck_assert_uint_eq(arena.blocks->pos, 0);
+    }
+
+    UA_Arena_clear(&arena);
+    ck_assert(arena.blocks == NULL);
+    UA_ByteString_clear(&buf);
+} END_TEST
+
+START_TEST(arenaResetOversized) {
+    UA_Arena arena;
+    memset(&arena, 0, sizeof(UA_Arena));
+    arena.blockSize = 64;
+
+    /* A block of the configured size is kept */
+    ck_assert(UA_Arena_calloc(&arena, 1, 16) != NULL);
+    UA_Arena_reset(&arena);
+    ck_assert(arena.blocks != NULL);
+    ck_assert_uint_eq(arena.blocks->size, 64);
+
+    /* An oversized first block is released */
+    UA_Arena_clear(&arena);
+    ck_assert(UA_Arena_calloc(&arena, 1, 4096) != NULL);
+    ck_assert(UA_Arena_calloc(&arena, 1, 16) != NULL);
+    UA_Arena_reset(&arena);
+    ck_assert(arena.blocks == NULL);
+
+    /* The arena remains usable */
+    ck_assert(UA_Arena_calloc(&arena, 1, 16) != NULL);
+    UA_Arena_clear(&arena);
+} END_TEST
+
+START_TEST(arenaDecodeBorrowStrings) {
+    UA_Arena arena;
+    memset(&arena, 0, sizeof(UA_Arena));
+    arena.blockSize = 256;
+
+    UA_Byte blob[100];
+    for(size_t i = 0; i < 100; i++)
+        blob[i] = (UA_Byte)i;
+    UA_ByteString bs = {100, blob};
+
+    UA_WriteValue wv;
+    UA_WriteValue_init(&wv);
+    wv.nodeId = UA_NODEID_STRING(1, "firmware");
+    wv.attributeId = UA_ATTRIBUTEID_VALUE;
+    UA_Variant_setScalar(&wv.value.value, &bs, &UA_TYPES[UA_TYPES_BYTESTRING]);
+    wv.value.hasValue = true;
+    UA_WriteRequest req;
+    UA_WriteRequest_init(&req);
+    req.nodesToWrite = &wv;
+    req.nodesToWriteSize = 1;
+
+    UA_ByteString buf = UA_BYTESTRING_NULL;
+    UA_StatusCode res = UA_encodeBinary(&req, &UA_TYPES[UA_TYPES_WRITEREQUEST], &buf);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_DecodeBinaryOptions opts;
+    memset(&opts, 0, sizeof(UA_DecodeBinaryOptions));
+    opts.callocContext = &arena;
+    opts.calloc = UA_Arena_calloc;
+    opts.borrowStrings = true;
+
+    UA_WriteRequest out;
+    res = UA_decodeBinary(&buf, &out, &UA_TYPES[UA_TYPES_WRITEREQUEST], &opts);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(out.nodesToWriteSize, 1);
+    ck_assert(UA_NodeId_equal(&out.nodesToWrite[0].nodeId, &wv.nodeId));
+    const UA_ByteString *outBs = (const UA_ByteString*)
+        out.nodesToWrite[0].value.value.data;
+    ck_assert(UA_ByteString_equal(outBs, &bs));
+
+    /* The content points into the encoded buffer */
+    const UA_String *id = &out.nodesToWrite[0].nodeId.identifier.string;
+    ck_assert(id->data > buf.data && id->data < buf.data + buf.length);
+    ck_assert(outBs->data > buf.data && outBs->data + 100 <= buf.data + buf.length);
+    UA_Arena_reset(&arena);
+
+    /* A truncated buffer is rejected */
+    UA_ByteString trunc = {buf.length - 10, buf.data};
+    res = UA_decodeBinary(&trunc, &out, &UA_TYPES[UA_TYPES_WRITEREQUEST], &opts);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADDECODINGERROR);
+
+    UA_Arena_clear(&arena);
+    UA_ByteString_clear(&buf);
+} END_TEST
+
 static Suite* testSuite_Utils(void) {
     Suite *s = suite_create("Utils");
     TCase *tc_endpointUrl_split = tcase_create("EndpointUrl_split");
@@ -580,6 +703,9 @@ static Suite* testSuite_Utils(void) {
     tcase_add_test(tc_utils, readNumberWithBase);
     tcase_add_test(tc_utils, StatusCode_msg);
     tcase_add_test(tc_utils, stringCompare);
+    tcase_add_test(tc_utils, arenaDecode);
+    tcase_add_test(tc_utils, arenaResetOversized);
+    tcase_add_test(tc_utils, arenaDecodeBorrowStrings);
     suite_add_tcase(s,tc_utils);
 
 
@@ -142,6 +142,51 @@ START_TEST(Client_endpoints) {
 }
 END_TEST
 
+START_TEST(Client_endpoints_cached) {
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_EndpointDescription* first = NULL;
+    size_t firstSize = 0;
+    UA_StatusCode retval = UA_Client_getEndpoints(client, "opc.tcp://localhost:4840",
+                                                  &firstSize, &first);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(firstSize > 0);
+
+    /* The second response is served from the encoded cache */
+    UA_EndpointDescription* second = NULL;
+    size_t secondSize = 0;
+    retval = UA_Client_getEndpoints(client, "opc.tcp://localhost:4840",
+                                    &secondSize, &second);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(firstSize, secondSize);
+    for(size_t i = 0; i < firstSize; i++)
+        ck_assert(UA_equal(&first[i], &second[i],
+                           &UA_TYPES[UA_TYPES_ENDPOINTDESCRIPTION]));
+    UA_LOCK(&server->serviceMutex);
+    ck_assert_uint_eq(server->endpointsCache.size, 1);
+    UA_UNLOCK(&server->serviceMutex);
+    UA_Array_delete(second, secondSize, &UA_TYPES[UA_TYPES_ENDPOINTDESCRIPTION]);
+
+    /* Modifying the config invalidates the cache */
+    UA_LOCK(&server->serviceMutex);
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    UA_String_clear(&config->applicationDescription.productUri);
+    config->applicationDescription.productUri = UA_STRING_ALLOC("urn:cached:product");
+    UA_UNLOCK(&server->serviceMutex);
+
+    retval = UA_Client_getEndpoints(client, "opc.tcp://localhost:4840",
+                                    &secondSize, &second);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(firstSize, secondSize);
+    UA_String productUri = UA_STRING("urn:cached:product");
+    for(size_t i = 0; i < secondSize; i++)
+        ck_assert(UA_String_equal(&second[i].server.productUri, &productUri));
+
+    UA_Array_delete(first, firstSize, &UA_TYPES[UA_TYPES_ENDPOINTDESCRIPTION]);
+    UA_Array_delete(second, secondSize, &UA_TYPES[UA_TYPES_ENDPOINTDESCRIPTION]);
+    UA_Client_delete(client);
+}
+END_TEST
+
 START_TEST(Client_endpoints_empty) {
     /* Issue a getEndpoints call with empty endpointUrl.
      * Using UA_Client_getEndpoints automatically passes the client->endpointUrl as requested endpointUrl.
@@ -195,6 +240,47 @@ START_TEST(Client_read) {
 }
 END_TEST
 
+START_TEST(Client_requestArena) {
+    /* Small arena to force additional blocks for the large array */
+    server->config.requestArenaSize = 256;
+
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode retval =
+        UA_Client_connectUsername(client, "opc.tcp://localhost:4840", "user1", "password");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_Int32 *array = (UA_Int32*)UA_Array_new(VARLENGTH, &UA_TYPES[UA_TYPES_INT32]);
+    for(size_t i = 0; i < VARLENGTH; i++)
+        array[i] = (UA_Int32)(VARLENGTH - i);
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    UA_Variant_setArray(&attr.value, array, VARLENGTH, &UA_TYPES[UA_TYPES_INT32]);
+    attr.dataType = UA_TYPES[UA_TYPES_INT32].typeId;
+    UA_NodeId nodeId = UA_NODEID_STRING(1, "arena.variable");
+    retval = UA_Client_addVariableNode(client, nodeId,
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                       UA_QUALIFIEDNAME(1, "arena.variable"),
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                       attr, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_Variant_clear(&attr.value);
+
+    UA_Variant val;
+
+    retval = UA_Client_readValueAttribute(client, nodeId, &val);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(val.type == &UA_TYPES[UA_TYPES_INT32]);
+    ck_assert_uint_eq(val.arrayLength, VARLENGTH);
+    UA_Int32 *var = (UA_Int32*)val.data;
+    for(size_t i = 0; i < VARLENGTH; i++)
+        ck_assert_int_eq(var[i], (UA_Int32)(VARLENGTH - i));
+    UA_Variant_clear(&val);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+}
+END_TEST
+
 START_TEST(Client_renewSecureChannel) {
     UA_Client *client = UA_Client_newForUnitTest();
     UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
@@ -459,8 +545,10 @@ static Suite* testSuite_Client(void) {
     tcase_add_test(tc_client, Client_connect_username);
     tcase_add_test(tc_client, Client_delete_without_connect);
     tcase_add_test(tc_client, Client_endpoints);
+    tcase_add_test(tc_client, Client_endpoints_cached);
     tcase_add_test(tc_client, Client_endpoints_empty);
     tcase_add_test(tc_client, Client_read);
+    tcase_add_test(tc_client, Client_requestArena);
     tcase_add_test(tc_client, Client_closes_on_server_error);
     suite_add_tcase(s,tc_client);
     TCase *tc_client_reconnect = tcase_create("Client Reconnect");
@@ -223,6 +223,131 @@ START_TEST(Client_read_async_timed) {
         UA_Client_delete(client);
 } END_TEST
 
+static void
+asyncReadCallbackModified(UA_Client *client, void *userdata,
+                          UA_UInt32 requestId, const UA_ReadResponse *response) {
+    UA_UInt16 *asyncCounter = (UA_UInt16*) userdata;
+    (*asyncCounter) += 100;
+}
+
+START_TEST(Client_read_async_modifyCallback) {
+        UA_Client *client = UA_Client_newForUnitTest();
+        UA_ClientConfig *clientConfig = UA_Client_getConfig(client);
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+        clientConfig->outStandingPublishRequests = 0;
+#endif
+
+        UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+        UA_ReadRequest rr;
+        UA_ReadRequest_init(&rr);
+        UA_ReadValueId rvid;
+        UA_ReadValueId_init(&rvid);
+        rvid.attributeId = UA_ATTRIBUTEID_VALUE;
+        rvid.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_CURRENTTIME);
+        rr.nodesToRead = &rvid;
+        rr.nodesToReadSize = 1;
+
+        /* Send requests with different timeouts. Modify the callback of one
+         * request in the middle. */
+        UA_UInt16 asyncCounter = 0;
+        UA_UInt32 reqIds[10];
+        for(size_t i = 0; i < 10; i++) {
+            rr.requestHeader.timeoutHint = (UA_UInt32)(10000 - i * 100);
+            retval = __UA_Client_AsyncService(client, &rr, &UA_TYPES[UA_TYPES_READREQUEST],
+                                              (UA_ClientAsyncServiceCallback)asyncReadCallback,
+                                              &UA_TYPES[UA_TYPES_READRESPONSE],
+                                              &asyncCounter, &reqIds[i]);
+            ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        }
+
+        retval = UA_Client_modifyAsyncCallback(client, reqIds[5], &asyncCounter,
+                                               (UA_ClientAsyncServiceCallback)
+                                               asyncReadCallbackModified);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+        /* Unknown RequestId */
+        retval = UA_Client_modifyAsyncCallback(client, reqIds[9] + 1000, &asyncCounter,
+                                               (UA_ClientAsyncServiceCallback)
+                                               asyncReadCallbackModified);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_BADNOTFOUND);
+
+        while(asyncCounter < 109)
+            UA_Client_run_iterate(client, 999);
+        ck_assert_uint_eq(asyncCounter, 109);
+
+        /* All calls are removed from the indexes */
+        ck_assert_ptr_eq(ZIP_ROOT(&client->asyncServiceCallsById), NULL);
+        ck_assert_ptr_eq(ZIP_ROOT(&client->asyncServiceCallsByDeadline), NULL);
+
+        UA_Client_disconnect(client);
+        UA_Client_delete(client);
+} END_TEST
+
+static void
+asyncReadCallbackCoalesced(UA_Client *client, void *userdata,
+                           UA_UInt32 requestId, const UA_ReadResponse *response) {
+    UA_UInt16 *asyncCounter = (UA_UInt16*) userdata;
+    ck_assert_uint_eq(response->responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response->resultsSize, 1);
+    ck_assert(response->results[0].hasValue);
+    ck_assert(UA_Variant_hasScalarType(&response->results[0].value,
+                                       &UA_TYPES[UA_TYPES_DATETIME]));
+    (*asyncCounter)++;
+}
+
+START_TEST(Client_read_async_coalesced) {
+        UA_Client *client = UA_Client_newForUnitTest();
+        UA_ClientConfig *clientConfig = UA_Client_getConfig(client);
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+        clientConfig->outStandingPublishRequests = 0;
+#endif
+        clientConfig->readCoalescingMaxNodes = 4;
+        clientConfig->readCoalescingWindow = 1;
+
+        UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+        UA_ReadRequest rr;
+        UA_ReadRequest_init(&rr);
+        UA_ReadValueId rvid;
+        UA_ReadValueId_init(&rvid);
+        rvid.attributeId = UA_ATTRIBUTEID_VALUE;
+        rvid.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_CURRENTTIME);
+        rr.nodesToRead = &rvid;
+        rr.nodesToReadSize = 1;
+
+        /* Ten reads are combined into three requests */
+        UA_UInt16 asyncCounter = 0;
+        UA_UInt32 reqIds[10];
+        for(size_t i = 0; i < 10; i++) {
+            retval = __UA_Client_AsyncService(client, &rr, &UA_TYPES[UA_TYPES_READREQUEST],
+                                              (UA_ClientAsyncServiceCallback)
+                                              asyncReadCallbackCoalesced,
+                                              &UA_TYPES[UA_TYPES_READRESPONSE],
+                                              &asyncCounter, &reqIds[i]);
+            ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        }
+        ck_assert_uint_eq(reqIds[0], reqIds[3]);
+        ck_assert_uint_ne(reqIds[3], reqIds[4]);
+        ck_assert_uint_eq(reqIds[4], reqIds[7]);
+        ck_assert_uint_ne(reqIds[7], reqIds[8]);
+        ck_assert_uint_eq(reqIds[8], reqIds[9]);
+
+        /* Only the first full batch is in flight */
+        ck_assert_uint_eq(client->readBatchesInFlight, 1);
+
+        while(asyncCounter < 10)
+            UA_Client_run_iterate(client, 999);
+        ck_assert_uint_eq(asyncCounter, 10);
+        ck_assert_uint_eq(client->readBatchesInFlight, 0);
+        ck_assert(SIMPLEQ_EMPTY(&client->readBatches));
+
+        UA_Client_disconnect(client);
+        UA_Client_delete(client);
+} END_TEST
+
 static UA_Boolean inactivityCallbackTriggered = false;
 
 static void inactivityCallback(UA_Client *client) {
@@ -275,6 +400,8 @@ static Suite* testSuite_Client(void) {
     tcase_add_test(tc_client, Client_read_async);
     tcase_add_test(tc_client, Client_readNodeClass_async);
     tcase_add_test(tc_client, Client_read_async_timed);
+    tcase_add_test(tc_client, Client_read_async_modifyCallback);
+    tcase_add_test(tc_client, Client_read_async_coalesced);
     tcase_add_test(tc_client, Client_connectivity_check);
     tcase_add_test(tc_client, Client_highlevel_async_readValue);
 
@@ -22,6 +22,30 @@ THREAD_HANDLE server_thread;
 #define CUSTOM_NS "http://open62541.org/ns/test"
 #define CUSTOM_NS_UPPER "http://open62541.org/ns/Test"
 
+/* Custom type known only to the server */
+typedef struct {
+    UA_Float x;
+    UA_Float y;
+    UA_Float z;
+} Point;
+
+static UA_DataTypeMember Point_members[3] = {
+    {UA_TYPENAME("x") &UA_TYPES[UA_TYPES_FLOAT], 0, false, false},
+    {UA_TYPENAME("y") &UA_TYPES[UA_TYPES_FLOAT],
+     offsetof(Point, y) - offsetof(Point, x) - sizeof(UA_Float), false, false},
+    {UA_TYPENAME("z") &UA_TYPES[UA_TYPES_FLOAT],
+     offsetof(Point, z) - offsetof(Point, y) - sizeof(UA_Float), false, false}
+};
+
+static const UA_DataType PointType = {
+    UA_TYPENAME("Point")
+    {2, UA_NODEIDTYPE_NUMERIC, {5000}}, /* .typeId */
+    {2, UA_NODEIDTYPE_NUMERIC, {5001}}, /* .binaryEncodingId */
+    sizeof(Point), UA_DATATYPEKIND_STRUCTURE, true, false, 3, Point_members, 12
+};
+
+static const UA_DataTypeArray serverTypes = {NULL, 1, &PointType, false};
+
 THREAD_CALLBACK(serverloop) {
     while (running)
         UA_Server_run_iterate(server, true);
@@ -34,6 +58,7 @@ static void setup(void) {
     ck_assert(server != NULL);
 
     ck_assert_uint_eq(2, UA_Server_addNamespace(server, CUSTOM_NS));
+    UA_Server_getConfig(server)->customDataTypes = &serverTypes;
 
     UA_Server_run_startup(server);
     THREAD_CREATE(server_thread, serverloop);
@@ -73,6 +98,106 @@ START_TEST(Misc_NamespaceGetIndex) {
     ck_assert_uint_eq(retval, UA_STATUSCODE_BADNOTFOUND);
 } END_TEST
 
+/* The values of the Read response point into the nodes of the server until the
+ * response is encoded. They must not be affected by later writes. */
+START_TEST(Misc_ReadValueArray) {
+    UA_String strings[3] = {UA_STRING_STATIC("a"), UA_STRING_STATIC("bb"),
+                            UA_STRING_STATIC("ccc")};
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    UA_Variant_setArray(&attr.value, strings, 3, &UA_TYPES[UA_TYPES_STRING]);
+    UA_NodeId nodeId = UA_NODEID_STRING(1, "ReadValueArray");
+    UA_StatusCode retval =
+        UA_Server_addVariableNode(server, nodeId, UA_NS0ID(OBJECTSFOLDER),
+                                  UA_NS0ID(ORGANIZES), UA_QUALIFIEDNAME(1, "Array"),
+                                  UA_NS0ID(BASEDATAVARIABLETYPE), attr, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Read the same node twice and once with an index range */
+    UA_ReadValueId rvi[3];
+    for(size_t i = 0; i < 3; i++) {
+        UA_ReadValueId_init(&rvi[i]);
+        rvi[i].nodeId = nodeId;
+        rvi[i].attributeId = UA_ATTRIBUTEID_VALUE;
+    }
+    rvi[2].indexRange = UA_STRING("1");
+
+    for(size_t round = 0; round < 2; round++) {
+        UA_ReadRequest request;
+        UA_ReadRequest_init(&request);
+        request.nodesToRead = rvi;
+        request.nodesToReadSize = 3;
+        UA_ReadResponse response = UA_Client_Service_read(client, request);
+        ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(response.resultsSize, 3);
+        for(size_t i = 0; i < 2; i++) {
+            UA_Variant *v = &response.results[i].value;
+            ck_assert_uint_eq(response.results[i].status, UA_STATUSCODE_GOOD);
+            ck_assert_uint_eq(v->arrayLength, 3);
+            ck_assert(UA_String_equal(&((UA_String*)v->data)[2], &strings[2]));
+        }
+        ck_assert_uint_eq(response.results[2].value.arrayLength, 1);
+        ck_assert(UA_String_equal((UA_String*)response.results[2].value.data,
+                                  &strings[1]));
+        UA_ReadResponse_clear(&response);
+
+        /* Replace the value on the server side */
+        strings[2] = UA_STRING("dddd");
+        retval = UA_Server_writeValue(server, nodeId, attr.value);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+} END_TEST
+
+/* Replace the value while the access level is checked. The Read request is
+ * still processed. The first result points into the pinned node. */
+static UA_Byte
+getUserAccessLevel_write(UA_Server *s, UA_AccessControl *ac,
+                         const UA_NodeId *sessionId, void *sessionContext,
+                         const UA_NodeId *nodeId, void *nodeContext) {
+    UA_String strings[2] = {UA_STRING_STATIC("new"), UA_STRING_STATIC("value")};
+    UA_Variant v;
+    UA_Variant_setArray(&v, strings, 2, &UA_TYPES[UA_TYPES_STRING]);
+    UA_Server_writeValue(s, *nodeId, v);
+    return 0xFF;
+}
+
+START_TEST(Misc_ReadValueWrittenDuringRead) {
+    UA_String strings[3] = {UA_STRING_STATIC("a"), UA_STRING_STATIC("bb"),
+                            UA_STRING_STATIC("ccc")};
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    UA_Variant_setArray(&attr.value, strings, 3, &UA_TYPES[UA_TYPES_STRING]);
+    UA_NodeId nodeId = UA_NODEID_STRING(1, "ReadValueWritten");
+    UA_StatusCode retval =
+        UA_Server_addVariableNode(server, nodeId, UA_NS0ID(OBJECTSFOLDER),
+                                  UA_NS0ID(ORGANIZES), UA_QUALIFIEDNAME(1, "Array"),
+                                  UA_NS0ID(BASEDATAVARIABLETYPE), attr, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    config->accessControl.getUserAccessLevel = getUserAccessLevel_write;
+
+    UA_ReadValueId rvi[2];
+    for(size_t i = 0; i < 2; i++) {
+        UA_ReadValueId_init(&rvi[i]);
+        rvi[i].nodeId = nodeId;
+        rvi[i].attributeId = UA_ATTRIBUTEID_VALUE;
+    }
+    UA_ReadRequest request;
+    UA_ReadRequest_init(&request);
+    request.nodesToRead = rvi;
+    request.nodesToReadSize = 2;
+    UA_ReadResponse response = UA_Client_Service_read(client, request);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.resultsSize, 2);
+    for(size_t i = 0; i < 2; i++) {
+        ck_assert_uint_eq(response.results[i].status, UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(response.results[i].value.arrayLength, 2);
+    }
+    UA_String expected = UA_STRING("value");
+    ck_assert(UA_String_equal(&((UA_String*)response.results[1].value.data)[1],
+                              &expected));
+    UA_ReadResponse_clear(&response);
+} END_TEST
+
 UA_NodeId newReferenceTypeId;
 UA_NodeId newObjectTypeId;
 UA_NodeId newDataTypeId;
@@ -84,6 +209,60 @@ UA_NodeId newViewId;
 
 #ifdef UA_ENABLE_NODEMANAGEMENT
 
+#ifdef UA_ENABLE_TYPEDESCRIPTION
+START_TEST(Misc_ImportDataTypes) {
+    UA_DataTypeAttributes dattr = UA_DataTypeAttributes_default;
+    dattr.displayName = UA_LOCALIZEDTEXT("en-US", "Point");
+    UA_StatusCode retval =
+        UA_Server_addDataTypeNode(server, PointType.typeId, UA_NS0ID(STRUCTURE),
+                                  UA_NS0ID(HASSUBTYPE), UA_QUALIFIEDNAME(2, "Point"),
+                                  dattr, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    Point p = {1.0f, 2.0f, 3.0f};
+    UA_VariableAttributes vattr = UA_VariableAttributes_default;
+    vattr.dataType = PointType.typeId;
+    UA_Variant_setScalar(&vattr.value, &p, &PointType);
+    UA_NodeId pointId = UA_NODEID_STRING(2, "point");
+    retval = UA_Server_addVariableNode(server, pointId, UA_NS0ID(OBJECTSFOLDER),
+                                       UA_NS0ID(ORGANIZES), UA_QUALIFIEDNAME(2, "point"),
+                                       UA_NS0ID(BASEDATAVARIABLETYPE), vattr, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Unknown to the client */
+    UA_Variant v;
+    retval = UA_Client_readValueAttribute(client, pointId, &v);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(v.type == &UA_TYPES[UA_TYPES_EXTENSIONOBJECT]);
+    UA_Variant_clear(&v);
+
+    /* Import the definition from the server */
+    UA_DataTypeSchemaHeader schema;
+    retval = UA_Client_readDataTypeSchema(client, 1, &PointType.typeId, &schema);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(schema.structureDataTypesSize, 1);
+    ck_assert_uint_eq(schema.namespacesSize, 3);
+    ck_assert(UA_NodeId_equal(&schema.structureDataTypes[0].structureDefinition.defaultEncodingId,
+                              &PointType.binaryEncodingId));
+    retval = UA_Client_addDataTypes(client, &schema);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_DataTypeSchemaHeader_clear(&schema);
+
+    const UA_DataType *type = UA_Client_findDataType(client, &PointType.typeId);
+    ck_assert(type != NULL);
+    ck_assert(type != &PointType);
+    ck_assert_uint_eq(type->memSize, sizeof(Point));
+
+    /* Decoded with the generated type */
+    retval = UA_Client_readValueAttribute(client, pointId, &v);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(v.type == type);
+    Point *p2 = (Point*)v.data;
+    ck_assert(p2->x == 1.0f && p2->y == 2.0f && p2->z == 3.0f);
+    UA_Variant_clear(&v);
+} END_TEST
+#endif
+
 START_TEST(Node_Add) {
     UA_StatusCode retval;
 
@@ -316,6 +495,70 @@ START_TEST(Node_Browse) {
 }
 END_TEST
 
+START_TEST(Node_Crawl) {
+    UA_ClientBrowseCache *cache = UA_ClientBrowseCache_new();
+    ck_assert_ptr_ne(cache, NULL);
+
+    /* Small requests to test the BrowseNext and the continuation point limit
+     * of the server */
+    UA_ClientCrawlOptions options;
+    memset(&options, 0, sizeof(UA_ClientCrawlOptions));
+    options.nodesPerBrowse = 5;
+    options.maxReferencesPerNode = 3;
+    UA_NodeId serverId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
+    UA_StatusCode retval = UA_Client_crawl(client, serverId, cache, &options);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    size_t size = UA_ClientBrowseCache_size(cache);
+    ck_assert_uint_gt(size, 50);
+
+    /* The start node has no ReferenceDescription */
+    const UA_ReferenceDescription *ref = UA_ClientBrowseCache_get(cache, &serverId);
+    ck_assert_ptr_ne(ref, NULL);
+    ck_assert_uint_eq(ref->nodeClass, UA_NODECLASS_UNSPECIFIED);
+
+    UA_NodeId statusId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_CURRENTTIME);
+    ref = UA_ClientBrowseCache_get(cache, &statusId);
+    ck_assert_ptr_ne(ref, NULL);
+    ck_assert_uint_eq(ref->nodeClass, UA_NODECLASS_VARIABLE);
+    UA_QualifiedName currentTime = UA_QUALIFIEDNAME(0, "CurrentTime");
+    ck_assert(UA_QualifiedName_equal(&ref->browseName, &currentTime));
+
+    /* Nodes outside of the hierarchy below the start node are not known */
+    UA_NodeId typesId = UA_NODEID_NUMERIC(0, UA_NS0ID_TYPESFOLDER);
+    ck_assert_ptr_eq(UA_ClientBrowseCache_get(cache, &typesId), NULL);
+
+    /* Same result with the defaults. Known nodes are not added again. */
+    retval = UA_Client_crawl(client, serverId, cache, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(UA_ClientBrowseCache_size(cache), size);
+    UA_ClientBrowseCache *cache2 = UA_ClientBrowseCache_new();
+    retval = UA_Client_crawl(client, serverId, cache2, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(UA_ClientBrowseCache_size(cache2), size);
+    UA_ClientBrowseCache_delete(cache2);
+
+    /* Reads of static attributes are answered from the attached cache */
+    UA_Client_setBrowseCache(client, cache);
+    UA_LocalizedText newName = UA_LOCALIZEDTEXT("", "Renamed");
+    retval = UA_Server_writeDisplayName(server, statusId, newName);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_LocalizedText displayName;
+    retval = UA_Client_readDisplayNameAttribute(client, statusId, &displayName);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(UA_String_equal(&displayName.text, &ref->displayName.text));
+    UA_LocalizedText_clear(&displayName);
+
+    /* Detached, the server is asked again */
+    UA_Client_setBrowseCache(client, NULL);
+    retval = UA_Client_readDisplayNameAttribute(client, statusId, &displayName);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(UA_String_equal(&displayName.text, &newName.text));
+    UA_LocalizedText_clear(&displayName);
+
+    UA_ClientBrowseCache_delete(cache);
+}
+END_TEST
+
 START_TEST(Node_Register) {
     UA_RegisterNodesRequest req;
     UA_RegisterNodesRequest_init(&req);
@@ -1040,6 +1283,11 @@ static Suite *testSuite_Client(void) {
     tcase_add_checked_fixture(tc_misc, setup, teardown);
     tcase_add_test(tc_misc, Misc_State);
     tcase_add_test(tc_misc, Misc_NamespaceGetIndex);
+    tcase_add_test(tc_misc, Misc_ReadValueArray);
+    tcase_add_test(tc_misc, Misc_ReadValueWrittenDuringRead);
+#ifdef UA_ENABLE_TYPEDESCRIPTION
+    tcase_add_test(tc_misc, Misc_ImportDataTypes);
+#endif
     suite_add_tcase(s, tc_misc);
 
     TCase *tc_nodes = tcase_create("Client Highlevel Node Management");
@@ -1048,6 +1296,7 @@ static Suite *testSuite_Client(void) {
     tcase_add_test(tc_nodes, Node_Add);
 #endif
     tcase_add_test(tc_nodes, Node_Browse);
+    tcase_add_test(tc_nodes, Node_Crawl);
     tcase_add_test(tc_nodes, Node_Register);
     suite_add_tcase(s, tc_nodes);
 
@@ -7,6 +7,7 @@
 
 #include <open62541/client.h>
 #include <open62541/client_config_default.h>
+#include <open62541/client_highlevel_async.h>
 #include <open62541/plugin/historydata/history_data_backend.h>
 #include <open62541/plugin/historydata/history_data_backend_memory.h>
 #include <open62541/plugin/historydata/history_data_gathering_default.h>
@@ -332,6 +333,103 @@ START_TEST(Client_HistorizingReadRawTwoInv)
 }
 END_TEST
 
+#define STREAM_NODES 3
+
+typedef struct {
+    size_t received[STREAM_NODES];
+    size_t responses[STREAM_NODES];
+    UA_Boolean ordered;
+    size_t stopAfter; /* Stop reading node 0 after n responses */
+    UA_Boolean done;
+    UA_StatusCode status;
+} StreamContext;
+
+static UA_Boolean
+streamSink(UA_Client *clt, void *context, size_t nodeIndex,
+           const UA_HistoryReadResult *result) {
+    StreamContext *sc = (StreamContext*)context;
+    ck_assert_uint_lt(nodeIndex, STREAM_NODES);
+    ck_assert_uint_eq(result->statusCode, UA_STATUSCODE_GOOD);
+    UA_HistoryData *data = (UA_HistoryData*)result->historyData.content.decoded.data;
+    for(size_t i = 0; i < data->dataValuesSize; i++) {
+        size_t pos = sc->received[nodeIndex] + i;
+        if(pos >= testDataSize || data->dataValues[i].sourceTimestamp != testData[pos])
+            sc->ordered = false;
+    }
+    sc->received[nodeIndex] += data->dataValuesSize;
+    sc->responses[nodeIndex]++;
+    return !(nodeIndex == 0 && sc->responses[0] == sc->stopAfter);
+}
+
+static void
+streamDone(UA_Client *clt, void *context, UA_StatusCode status) {
+    StreamContext *sc = (StreamContext*)context;
+    sc->done = true;
+    sc->status = status;
+}
+
+static void
+runStream(StreamContext *sc) {
+    UA_ReadRawModifiedDetails details;
+    UA_ReadRawModifiedDetails_init(&details);
+    details.startTime = TESTDATA_START_TIME;
+    details.endTime = TESTDATA_STOP_TIME;
+    details.numValuesPerNode = 2;
+    UA_ExtensionObject eo;
+    UA_ExtensionObject_setValue(&eo, &details,
+                                &UA_TYPES[UA_TYPES_READRAWMODIFIEDDETAILS]);
+
+    UA_HistoryReadValueId nodes[STREAM_NODES];
+    for(size_t i = 0; i < STREAM_NODES; i++) {
+        UA_HistoryReadValueId_init(&nodes[i]);
+        nodes[i].nodeId = outNodeId;
+    }
+
+    UA_ClientHistoryReadOptions options;
+    memset(&options, 0, sizeof(UA_ClientHistoryReadOptions));
+    options.nodesPerRequest = 2;
+    options.maxInFlight = 2;
+    options.timestampsToReturn = UA_TIMESTAMPSTORETURN_BOTH;
+
+    UA_StatusCode ret =
+        UA_Client_HistoryRead_stream_async(client, &eo, nodes, STREAM_NODES, &options,
+                                           streamSink, streamDone, sc);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    while(!sc->done) {
+        ret = UA_Client_run_iterate(client, 100);
+        ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    }
+}
+
+START_TEST(Client_HistorizingReadStream) {
+    StreamContext sc;
+    memset(&sc, 0, sizeof(StreamContext));
+    sc.ordered = true;
+    runStream(&sc);
+    ck_assert_uint_eq(sc.status, UA_STATUSCODE_GOOD);
+    ck_assert(sc.ordered);
+    for(size_t i = 0; i < STREAM_NODES; i++) {
+        ck_assert_uint_eq(sc.received[i], testDataSize);
+        ck_assert_uint_eq(sc.responses[i], (testDataSize + 1) / 2);
+    }
+}
+END_TEST
+
+START_TEST(Client_HistorizingReadStreamStop) {
+    StreamContext sc;
+    memset(&sc, 0, sizeof(StreamContext));
+    sc.ordered = true;
+    sc.stopAfter = 1;
+    runStream(&sc);
+    ck_assert_uint_eq(sc.status, UA_STATUSCODE_GOOD);
+    ck_assert(sc.ordered);
+    ck_assert_uint_eq(sc.responses[0], 1);
+    ck_assert_uint_eq(sc.received[0], 2);
+    ck_assert_uint_eq(sc.received[1], testDataSize);
+    ck_assert_uint_eq(sc.received[2], testDataSize);
+}
+END_TEST
+
 START_TEST(Client_HistorizingInsertRawSuccess)
 {
     UA_StatusCode ret = UA_Client_HistoryRead_raw(client,
@@ -625,6 +723,8 @@ testSuite_Client(void) {
     tcase_add_test(tc_client, Client_HistorizingReadRawAllInv);
     tcase_add_test(tc_client, Client_HistorizingReadRawOneInv);
     tcase_add_test(tc_client, Client_HistorizingReadRawTwoInv);
+    tcase_add_test(tc_client, Client_HistorizingReadStream);
+    tcase_add_test(tc_client, Client_HistorizingReadStreamStop);
     tcase_add_test(tc_client, Client_HistorizingInsertRawSuccess);
     tcase_add_test(tc_client, Client_HistorizingReplaceRawSuccess);
     tcase_add_test(tc_client, Client_HistorizingUpdateRawSuccess);
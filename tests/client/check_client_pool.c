@@ -0,0 +1,184 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/client.h>
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel_async.h>
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+
+#include "client/ua_client_internal.h"
+
+#include <check.h>
+#include <stdlib.h>
+
+#include "test_helpers.h"
+#include "testing_clock.h"
+#include "thread_wrapper.h"
+
+#define POOLSIZE 3
+
+UA_Server *server;
+UA_Boolean running;
+THREAD_HANDLE server_thread;
+
+THREAD_CALLBACK(serverloop) {
+    while(running)
+        UA_Server_run_iterate(server, true);
+    return 0;
+}
+
+static void setup(void) {
+    running = true;
+    server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+    UA_Server_run_startup(server);
+    THREAD_CREATE(server_thread, serverloop);
+}
+
+static void teardown(void) {
+    running = false;
+    THREAD_JOIN(server_thread);
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+}
+
+static UA_ClientPool *
+newPool(UA_Client **clients) {
+    UA_ClientPool *pool = UA_ClientPool_new();
+    ck_assert(pool != NULL);
+    for(size_t i = 0; i < POOLSIZE; i++) {
+        clients[i] = UA_Client_newForUnitTest();
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+        UA_Client_getConfig(clients[i])->outStandingPublishRequests = 0;
+#endif
+        UA_StatusCode res = UA_ClientPool_addClient(pool, clients[i]);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+    return pool;
+}
+
+static size_t
+activatedClients(UA_Client **clients) {
+    size_t activated = 0;
+    for(size_t i = 0; i < POOLSIZE; i++) {
+        UA_SessionState ss;
+        UA_Client_getState(clients[i], NULL, &ss, NULL);
+        if(ss == UA_SESSIONSTATE_ACTIVATED)
+            activated++;
+    }
+    return activated;
+}
+
+START_TEST(ClientPool_connect) {
+    UA_Client *clients[POOLSIZE];
+    UA_ClientPool *pool = newPool(clients);
+
+    /* The EventLoop is shared */
+    for(size_t i = 1; i < POOLSIZE; i++)
+        ck_assert_ptr_eq(UA_Client_getConfig(clients[i])->eventLoop,
+                         UA_Client_getConfig(clients[0])->eventLoop);
+
+    /* No session yet */
+    ck_assert_ptr_eq(UA_ClientPool_getClient(pool), NULL);
+
+    UA_StatusCode res = UA_ClientPool_connectAsync(pool, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < 100 && activatedClients(clients) < POOLSIZE; i++) {
+        res = UA_ClientPool_run_iterate(pool, 10);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+    ck_assert_uint_eq(activatedClients(clients), POOLSIZE);
+
+    /* Every client has its own SecureChannel */
+    for(size_t i = 1; i < POOLSIZE; i++)
+        ck_assert_uint_ne(clients[i]->channel.securityToken.channelId,
+                          clients[0]->channel.securityToken.channelId);
+
+    UA_ClientPool_delete(pool);
+} END_TEST
+
+static void
+readCallback(UA_Client *client, void *userdata, UA_UInt32 requestId,
+             UA_StatusCode status, UA_DataValue *value) {
+    UA_UInt16 *counter = (UA_UInt16*)userdata;
+    ck_assert_uint_eq(status, UA_STATUSCODE_GOOD);
+    (*counter)++;
+}
+
+START_TEST(ClientPool_loadBalance) {
+    UA_Client *clients[POOLSIZE];
+    UA_ClientPool *pool = newPool(clients);
+
+    UA_StatusCode res = UA_ClientPool_connectAsync(pool, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    while(activatedClients(clients) < POOLSIZE)
+        UA_ClientPool_run_iterate(pool, 10);
+
+    /* The requests are spread evenly over the clients */
+    UA_UInt16 counter = 0;
+    for(size_t i = 0; i < 3 * POOLSIZE; i++) {
+        UA_Client *client = UA_ClientPool_getClient(pool);
+        ck_assert(client != NULL);
+        res = UA_Client_readValueAttribute_async(client,
+                  UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_CURRENTTIME),
+                  readCallback, &counter, NULL);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+    for(size_t i = 0; i < POOLSIZE; i++)
+        ck_assert_uint_eq(clients[i]->asyncServiceCallsSize, 3);
+
+    while(counter < 3 * POOLSIZE)
+        UA_ClientPool_run_iterate(pool, 10);
+    for(size_t i = 0; i < POOLSIZE; i++)
+        ck_assert_uint_eq(clients[i]->asyncServiceCallsSize, 0);
+
+    UA_ClientPool_delete(pool);
+} END_TEST
+
+START_TEST(ClientPool_reconnect) {
+    UA_Client *clients[POOLSIZE];
+    UA_ClientPool *pool = newPool(clients);
+
+    UA_StatusCode res = UA_ClientPool_connectAsync(pool, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    while(activatedClients(clients) < POOLSIZE)
+        UA_ClientPool_run_iterate(pool, 10);
+
+    /* A client that gave up is connected again by the pool */
+    UA_Client_disconnect(clients[1]);
+    clients[1]->connectStatus = UA_STATUSCODE_BADCONNECTIONCLOSED;
+    ck_assert_uint_eq(activatedClients(clients), POOLSIZE - 1);
+    for(size_t i = 0; i < 100 && activatedClients(clients) < POOLSIZE; i++)
+        UA_ClientPool_run_iterate(pool, 10);
+    ck_assert_uint_eq(activatedClients(clients), POOLSIZE);
+
+    /* No reconnect after the pool was disconnected */
+    UA_ClientPool_disconnect(pool);
+    UA_ClientPool_run_iterate(pool, 10);
+    ck_assert_uint_eq(activatedClients(clients), 0);
+
+    UA_ClientPool_delete(pool);
+} END_TEST
+
+static Suite* testSuite_ClientPool(void) {
+    Suite *s = suite_create("Client Pool");
+    TCase *tc_pool = tcase_create("Client Pool Basic");
+    tcase_add_checked_fixture(tc_pool, setup, teardown);
+    tcase_add_test(tc_pool, ClientPool_connect);
+    tcase_add_test(tc_pool, ClientPool_loadBalance);
+    tcase_add_test(tc_pool, ClientPool_reconnect);
+    suite_add_tcase(s, tc_pool);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_ClientPool();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
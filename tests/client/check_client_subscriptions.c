@@ -177,6 +177,170 @@ START_TEST(Client_subscription) {
 }
 END_TEST
 
+static size_t batchSize;
+static UA_UInt32 batchMonIds[2];
+static void *batchMonContexts[2];
+
+static void
+dataChangeBatchHandler(UA_Client *client, UA_UInt32 subId, void *subContext,
+                       UA_DataChangeNotification *notification,
+                       const UA_UInt32 *monIds, void * const *monContexts) {
+    batchSize = notification->monitoredItemsSize;
+    for(size_t i = 0; i < batchSize && i < 2; i++) {
+        batchMonIds[i] = monIds[i];
+        batchMonContexts[i] = monContexts[i];
+    }
+}
+
+START_TEST(Client_subscription_batchCallback) {
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_CreateSubscriptionRequest request = UA_CreateSubscriptionRequest_default();
+    UA_CreateSubscriptionResponse response = UA_Client_Subscriptions_create(client, request,
+                                                                            NULL, NULL, NULL);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    UA_UInt32 subId = response.subscriptionId;
+
+    retval = UA_Client_Subscriptions_setDataChangeBatchCallback(client, 99999,
+                                                                dataChangeBatchHandler);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADSUBSCRIPTIONIDINVALID);
+    retval = UA_Client_Subscriptions_setDataChangeBatchCallback(client, subId,
+                                                                dataChangeBatchHandler);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Two MonitoredItems with different contexts */
+    UA_UInt32 contexts[2];
+    UA_UInt32 monIds[2];
+    UA_UInt32 nodes[2] = {UA_NS0ID_SERVER_SERVERSTATUS_STATE,
+                          UA_NS0ID_SERVER_SERVICELEVEL};
+    for(size_t i = 0; i < 2; i++) {
+        UA_MonitoredItemCreateRequest monRequest =
+            UA_MonitoredItemCreateRequest_default(UA_NODEID_NUMERIC(0, nodes[i]));
+        UA_MonitoredItemCreateResult monResponse =
+            UA_Client_MonitoredItems_createDataChange(client, subId,
+                                                      UA_TIMESTAMPSTORETURN_BOTH,
+                                                      monRequest, &contexts[i],
+                                                      dataChangeHandler, NULL);
+        ck_assert_uint_eq(monResponse.statusCode, UA_STATUSCODE_GOOD);
+        monIds[i] = monResponse.monitoredItemId;
+    }
+
+    /* manually control the server thread */
+    running = false;
+    THREAD_JOIN(server_thread);
+
+    batchSize = 0;
+    notificationReceived = false;
+    UA_fakeSleep((UA_UInt32)publishingInterval + 1);
+    for(size_t i = 0; i < 3 && batchSize == 0; i++) {
+        UA_Server_run_iterate(server, true);
+        retval = UA_Client_run_iterate(client, 1);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+
+    /* Both items arrive in one call. The per-item callback is bypassed. */
+    ck_assert_uint_eq(batchSize, 2);
+    ck_assert_uint_eq(notificationReceived, false);
+    for(size_t i = 0; i < 2; i++) {
+        size_t j = (batchMonIds[0] == monIds[i]) ? 0 : 1;
+        ck_assert_uint_eq(batchMonIds[j], monIds[i]);
+        ck_assert_ptr_eq(batchMonContexts[j], &contexts[i]);
+    }
+
+    /* run the server in an independent thread again */
+    running = true;
+    THREAD_CREATE(server_thread, serverloop);
+
+    retval = UA_Client_Subscriptions_deleteSingle(client, subId);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+}
+END_TEST
+
+#define BULK_ITEMS 50
+
+START_TEST(Client_subscription_createDataChangesBulk) {
+    /* Limit the MonitoredItems per call in the server */
+    running = false;
+    THREAD_JOIN(server_thread);
+    UA_Server_getConfig(server)->maxMonitoredItemsPerCall = 7;
+    running = true;
+    THREAD_CREATE(server_thread, serverloop);
+
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_CreateSubscriptionRequest request = UA_CreateSubscriptionRequest_default();
+    UA_CreateSubscriptionResponse response = UA_Client_Subscriptions_create(client, request,
+                                                                            NULL, NULL, NULL);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    UA_UInt32 subId = response.subscriptionId;
+
+    UA_MonitoredItemCreateRequest items[BULK_ITEMS];
+    UA_Client_DataChangeNotificationCallback callbacks[BULK_ITEMS];
+    UA_Client_DeleteMonitoredItemCallback deleteCallbacks[BULK_ITEMS];
+    UA_UInt32 contexts[BULK_ITEMS];
+    void *contextPtrs[BULK_ITEMS];
+    for(size_t i = 0; i < BULK_ITEMS; i++) {
+        items[i] = UA_MonitoredItemCreateRequest_default(
+            UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_CURRENTTIME));
+        callbacks[i] = dataChangeHandler;
+        deleteCallbacks[i] = NULL;
+        contexts[i] = (UA_UInt32)i;
+        contextPtrs[i] = &contexts[i];
+    }
+    /* The last item fails on its own */
+    items[BULK_ITEMS - 1].itemToMonitor.nodeId = UA_NODEID_NUMERIC(0, 99999);
+
+    UA_CreateMonitoredItemsRequest createRequest;
+    UA_CreateMonitoredItemsRequest_init(&createRequest);
+    createRequest.subscriptionId = subId;
+    createRequest.timestampsToReturn = UA_TIMESTAMPSTORETURN_BOTH;
+    createRequest.itemsToCreate = items;
+    createRequest.itemsToCreateSize = BULK_ITEMS;
+
+    /* Too many items for a single request */
+    UA_CreateMonitoredItemsResponse createResponse =
+        UA_Client_MonitoredItems_createDataChanges(client, createRequest, contextPtrs,
+                                                   callbacks, deleteCallbacks);
+    ck_assert_uint_eq(createResponse.responseHeader.serviceResult,
+                      UA_STATUSCODE_BADTOOMANYOPERATIONS);
+    UA_CreateMonitoredItemsResponse_clear(&createResponse);
+
+    /* Split into chunks */
+    createResponse =
+        UA_Client_MonitoredItems_createDataChangesBulk(client, createRequest, contextPtrs,
+                                                       callbacks, deleteCallbacks);
+    ck_assert_uint_eq(createResponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(createResponse.resultsSize, BULK_ITEMS);
+    ck_assert_uint_eq(client->maxMonitoredItemsPerCall, 7);
+    for(size_t i = 0; i < BULK_ITEMS - 1; i++)
+        ck_assert_uint_eq(createResponse.results[i].statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(createResponse.results[BULK_ITEMS - 1].statusCode,
+                      UA_STATUSCODE_BADNODEIDUNKNOWN);
+
+    /* Every chunk created its own MonitoredItems */
+    for(size_t i = 0; i < BULK_ITEMS - 1; i++) {
+        ck_assert_uint_ne(createResponse.results[i].monitoredItemId, 0);
+        for(size_t j = 0; j < i; j++)
+            ck_assert_uint_ne(createResponse.results[i].monitoredItemId,
+                              createResponse.results[j].monitoredItemId);
+    }
+    UA_CreateMonitoredItemsResponse_clear(&createResponse);
+
+    retval = UA_Client_Subscriptions_deleteSingle(client, subId);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+}
+END_TEST
+
 START_TEST(Client_subscription_async) {
     UA_Client *client = UA_Client_newForUnitTest();
     UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
@@ -1411,6 +1575,54 @@ START_TEST(Client_subscription_async_sub) {
 }
 END_TEST
 
+START_TEST(Client_subscription_adaptPublishRequests) {
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_ClientConfig *cc = UA_Client_getConfig(client);
+    cc->outStandingPublishRequests = 5;
+    cc->minOutStandingPublishRequests = 1;
+
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Subscription without MonitoredItems. Only keep-alives are sent. */
+    UA_CreateSubscriptionRequest request = UA_CreateSubscriptionRequest_default();
+    request.requestedMaxKeepAliveCount = 1;
+    UA_CreateSubscriptionResponse response =
+        UA_Client_Subscriptions_create(client, request, NULL, NULL, NULL);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+
+    /* Start at the lower limit */
+    ck_assert_uint_eq(client->targetOutStandingPublishRequests, 1);
+    ck_assert_uint_eq(client->currentlyOutStandingPublishRequests, 1);
+
+    /* manually control the server thread */
+    running = false;
+    THREAD_JOIN(server_thread);
+
+    /* Raise the target. The next response fills up the PublishRequests. The
+     * following keep-alives bring the number back down. */
+    client->targetOutStandingPublishRequests = 5;
+    UA_UInt16 maxOutStanding = 0;
+    for(size_t i = 0; i < 10; i++) {
+        UA_fakeSleep((UA_UInt32)publishingInterval + 1);
+        UA_Server_run_iterate(server, true);
+        UA_Client_run_iterate(client, 1);
+        if(client->currentlyOutStandingPublishRequests > maxOutStanding)
+            maxOutStanding = client->currentlyOutStandingPublishRequests;
+    }
+    ck_assert_uint_eq(maxOutStanding, 5);
+    ck_assert_uint_eq(client->targetOutStandingPublishRequests, 1);
+    ck_assert_uint_le(client->currentlyOutStandingPublishRequests, 1);
+
+    /* Get the server back up */
+    running = true;
+    THREAD_CREATE(server_thread, serverloop);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+}
+END_TEST
+
 START_TEST(Client_subscription_reconnect) {
     UA_Client *client = UA_Client_newForUnitTest();
 
@@ -1584,6 +1796,65 @@ START_TEST(Client_subscription_transfer) {
 }
 END_TEST
 
+START_TEST(Client_subscription_sessionLost) {
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_CreateSubscriptionRequest request = UA_CreateSubscriptionRequest_default();
+    UA_CreateSubscriptionResponse response = UA_Client_Subscriptions_create(client, request,
+                                                                            NULL, NULL, NULL);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    UA_UInt32 subId = response.subscriptionId;
+
+    UA_MonitoredItemCreateRequest monRequest =
+        UA_MonitoredItemCreateRequest_default(UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_CURRENTTIME));
+    UA_MonitoredItemCreateResult monResponse =
+        UA_Client_MonitoredItems_createDataChange(client, subId,
+                                                  UA_TIMESTAMPSTORETURN_BOTH,
+                                                  monRequest, NULL, dataChangeHandler, NULL);
+    ck_assert_uint_eq(monResponse.statusCode, UA_STATUSCODE_GOOD);
+
+    /* Close the Session behind the back of the client. The Subscription
+     * remains in the server. */
+    UA_CloseSessionRequest creq;
+    UA_CloseSessionRequest_init(&creq);
+    creq.deleteSubscriptions = false;
+    UA_CloseSessionResponse cres;
+    __UA_Client_Service(client, &creq, &UA_TYPES[UA_TYPES_CLOSESESSIONREQUEST],
+                        &cres, &UA_TYPES[UA_TYPES_CLOSESESSIONRESPONSE]);
+    ck_assert_uint_eq(cres.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    UA_CloseSessionResponse_clear(&cres);
+
+    /* manually control the server thread */
+    running = false;
+    THREAD_JOIN(server_thread);
+
+    /* The client creates a new Session and transfers the Subscription */
+    notificationReceived = false;
+    for(size_t i = 0; i < 50 && !notificationReceived; i++) {
+        UA_fakeSleep((UA_UInt32)publishingInterval + 1);
+        UA_Server_run_iterate(server, true);
+        UA_Client_run_iterate(client, 1);
+    }
+    ck_assert_uint_eq(notificationReceived, true);
+    ck_assert(LIST_EMPTY(&client->heldSubscriptions));
+    UA_Client_Subscription *sub = LIST_FIRST(&client->subscriptions);
+    ck_assert_ptr_ne(sub, NULL);
+    ck_assert_uint_eq(sub->subscriptionId, subId);
+
+    /* run the server in an independent thread again */
+    running = true;
+    THREAD_CREATE(server_thread, serverloop);
+
+    retval = UA_Client_Subscriptions_deleteSingle(client, subId);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+}
+END_TEST
+
 #ifdef UA_ENABLE_METHODCALLS
 START_TEST(Client_methodcall) {
     UA_Client *client = UA_Client_newForUnitTest();
@@ -1654,6 +1925,7 @@ static Suite* testSuite_Client(void) {
     tcase_add_checked_fixture(tc_client, setup, teardown);
     tcase_add_test(tc_client, Client_subscription);
     tcase_add_test(tc_client, Client_subscription_async);
+    tcase_add_test(tc_client, Client_subscription_batchCallback);
     tcase_add_test(tc_client, Client_subscription_statusChange);
     tcase_add_test(tc_client, Client_subscription_timeout);
     tcase_add_test(tc_client, Client_subscription_detach);
@@ -1662,13 +1934,16 @@ static Suite* testSuite_Client(void) {
     tcase_add_test(tc_client, Client_subscription_createDataChanges_negativeInterval);
     tcase_add_test(tc_client, Client_subscription_modifyMonitoredItem);
     tcase_add_test(tc_client, Client_subscription_createDataChanges_async);
+    tcase_add_test(tc_client, Client_subscription_createDataChangesBulk);
     tcase_add_test(tc_client, Client_subscription_keepAlive);
     tcase_add_test(tc_client, Client_subscription_priority);
     tcase_add_test(tc_client, Client_subscription_without_notification);
     tcase_add_test(tc_client, Client_subscription_async_sub);
+    tcase_add_test(tc_client, Client_subscription_adaptPublishRequests);
     tcase_add_test(tc_client, Client_subscription_reconnect);
     tcase_add_test(tc_client, Client_subscription_server_disappears);
     tcase_add_test(tc_client, Client_subscription_transfer);
+    tcase_add_test(tc_client, Client_subscription_sessionLost);
     tcase_add_test(tc_client, Client_subscription_writeBurst);
     suite_add_tcase(s,tc_client);
 
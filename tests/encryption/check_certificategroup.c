@@ -316,6 +316,51 @@ START_TEST(get_rejectedlist) {
 }
 END_TEST
 
+#ifdef UA_ENABLE_ENCRYPTION_OPENSSL
+/* Remembered results are discarded when the trust list changes */
+START_TEST(verify_cache) {
+    UA_ByteString certificate;
+    certificate.length = CERT_DER_LENGTH;
+    certificate.data = CERT_DER_DATA;
+
+    UA_UInt32 cacheSize = 4;
+    UA_KeyValuePair param;
+    param.key = UA_QUALIFIEDNAME(0, "verifyCacheSize");
+    UA_Variant_setScalar(&param.value, &cacheSize, &UA_TYPES[UA_TYPES_UINT32]);
+    UA_KeyValueMap params = {1, &param};
+
+    UA_TrustListDataType trustList;
+    memset(&trustList, 0, sizeof(UA_TrustListDataType));
+    UA_CertificateGroup certGroup;
+    memset(&certGroup, 0, sizeof(UA_CertificateGroup));
+    UA_NodeId groupId =
+        UA_NODEID_NUMERIC(0, UA_NS0ID_SERVERCONFIGURATION_CERTIFICATEGROUPS_DEFAULTAPPLICATIONGROUP);
+    UA_StatusCode retval =
+        UA_CertificateGroup_Memorystore(&certGroup, &groupId, &trustList, NULL, &params);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Accepted with the empty trust list. Then taken from the cache. */
+    retval = certGroup.verifyCertificate(&certGroup, &certificate);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    retval = certGroup.verifyCertificate(&certGroup, &certificate);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* The certificate is only an issuer now */
+    trustList.specifiedLists = UA_TRUSTLISTMASKS_ISSUERCERTIFICATES;
+    trustList.issuerCertificates = &certificate;
+    trustList.issuerCertificatesSize = 1;
+    retval = certGroup.setTrustList(&certGroup, &trustList);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < 2; i++) {
+        retval = certGroup.verifyCertificate(&certGroup, &certificate);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_BADCERTIFICATEUNTRUSTED);
+    }
+
+    certGroup.clear(&certGroup);
+}
+END_TEST
+#endif
+
 static Suite* testSuite_encryption(void) {
     Suite *s = suite_create("CertificateGroup");
     TCase *tc_encryption_memorystore = tcase_create("CertificateGroup Memorystore");
@@ -326,6 +371,9 @@ static Suite* testSuite_encryption(void) {
     tcase_add_test(tc_encryption_memorystore, add_to_trustlist);
     tcase_add_test(tc_encryption_memorystore, remove_from_trustlist);
     tcase_add_test(tc_encryption_memorystore, get_rejectedlist);
+#ifdef UA_ENABLE_ENCRYPTION_OPENSSL
+    tcase_add_test(tc_encryption_memorystore, verify_cache);
+#endif
 #endif /* UA_ENABLE_ENCRYPTION */
     suite_add_tcase(s,tc_encryption_memorystore);
 
@@ -298,6 +298,214 @@ START_TEST(encryption_connect_pem) {
 }
 END_TEST
 
+#if UA_MULTITHREADING >= 200
+/* Messages that span many chunks are decrypted by parallel worker threads */
+START_TEST(encryption_parallel_decrypt) {
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    config->parallelDecryptThreshold = 4;
+    config->parallelDecryptThreads = 3;
+
+    /* Add a variable for the large value */
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+    UA_NodeId nodeId = UA_NODEID_STRING(1, "large.value");
+    UA_StatusCode retval =
+        UA_Server_addVariableNode(server, nodeId, UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, "large.value"),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                  attr, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_ByteString certificate;
+    certificate.length = CERT_DER_LENGTH;
+    certificate.data = CERT_DER_DATA;
+    UA_ByteString privateKey;
+    privateKey.length = KEY_DER_LENGTH;
+    privateKey.data = KEY_DER_DATA;
+
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_ClientConfig *cc = UA_Client_getConfig(client);
+    UA_ClientConfig_setDefaultEncryption(cc, certificate, privateKey,
+                                         NULL, 0, NULL, 0);
+    cc->certificateVerification.clear(&cc->certificateVerification);
+    UA_CertificateGroup_AcceptAll(&cc->certificateVerification);
+    cc->securityPolicyUri =
+        UA_STRING_ALLOC("http://opcfoundation.org/UA/SecurityPolicy#Basic256Sha256");
+    retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Write a value of 1MB (multiple parallel batches) and read it back */
+    for(size_t round = 0; round < 2; round++) {
+        UA_ByteString large;
+        retval = UA_ByteString_allocBuffer(&large, 1 << 20);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        for(size_t i = 0; i < large.length; i++)
+            large.data[i] = (UA_Byte)(i * 7 + round);
+        UA_Variant val;
+        UA_Variant_setScalar(&val, &large, &UA_TYPES[UA_TYPES_BYTESTRING]);
+        retval = UA_Client_writeValueAttribute(client, nodeId, &val);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+        UA_Variant out;
+        UA_Variant_init(&out);
+        retval = UA_Client_readValueAttribute(client, nodeId, &out);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        ck_assert(UA_Variant_hasScalarType(&out, &UA_TYPES[UA_TYPES_BYTESTRING]));
+        ck_assert(UA_ByteString_equal(&large, (UA_ByteString*)out.data));
+        UA_Variant_clear(&out);
+        UA_ByteString_clear(&large);
+    }
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+}
+END_TEST
+
+/* The OPN request of a new SecureChannel is decrypted by a worker thread */
+START_TEST(encryption_async_handshake) {
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    config->asyncHandshake = true;
+
+    UA_ByteString certificate;
+    certificate.length = CERT_DER_LENGTH;
+    certificate.data = CERT_DER_DATA;
+    UA_ByteString privateKey;
+    privateKey.length = KEY_DER_LENGTH;
+    privateKey.data = KEY_DER_DATA;
+
+    for(size_t round = 0; round < 2; round++) {
+        UA_Client *client = UA_Client_newForUnitTest();
+        UA_ClientConfig *cc = UA_Client_getConfig(client);
+        UA_ClientConfig_setDefaultEncryption(cc, certificate, privateKey,
+                                             NULL, 0, NULL, 0);
+        cc->certificateVerification.clear(&cc->certificateVerification);
+        UA_CertificateGroup_AcceptAll(&cc->certificateVerification);
+        cc->securityPolicyUri =
+            UA_STRING_ALLOC("http://opcfoundation.org/UA/SecurityPolicy#Basic256Sha256");
+        UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+        UA_Variant val;
+        UA_Variant_init(&val);
+        UA_NodeId nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_STATE);
+        retval = UA_Client_readValueAttribute(client, nodeId, &val);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        UA_Variant_clear(&val);
+
+        UA_Client_disconnect(client);
+        UA_Client_delete(client);
+    }
+
+    UA_ServerStatistics stats = UA_Server_getStatistics(server);
+    ck_assert_uint_ge(stats.scs.asyncHandshakeCount, 2);
+}
+END_TEST
+#endif
+
+/* The symmetric keys are replaced when the SecurityToken is renewed */
+START_TEST(encryption_renew_securechannel) {
+    UA_ByteString certificate;
+    certificate.length = CERT_DER_LENGTH;
+    certificate.data = CERT_DER_DATA;
+    UA_ByteString privateKey;
+    privateKey.length = KEY_DER_LENGTH;
+    privateKey.data = KEY_DER_DATA;
+
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_ClientConfig *cc = UA_Client_getConfig(client);
+    UA_ClientConfig_setDefaultEncryption(cc, certificate, privateKey,
+                                         NULL, 0, NULL, 0);
+    cc->certificateVerification.clear(&cc->certificateVerification);
+    UA_CertificateGroup_AcceptAll(&cc->certificateVerification);
+    cc->securityPolicyUri =
+        UA_STRING_ALLOC("http://opcfoundation.org/UA/SecurityPolicy#Basic256Sha256");
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_UInt32 channelId = client->channel.securityToken.channelId;
+    UA_NodeId nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_STATE);
+    for(size_t round = 0; round < 3; round++) {
+        /* Renew the SecurityToken */
+        UA_UInt32 tokenId = client->channel.securityToken.tokenId;
+        UA_fakeSleep((UA_UInt32)(client->channel.securityToken.revisedLifetime * 0.8));
+        for(size_t i = 0; i < 50 && client->channel.securityToken.tokenId == tokenId; i++) {
+            retval = UA_Client_run_iterate(client, 10);
+            ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        }
+        ck_assert_uint_ne(client->channel.securityToken.tokenId, tokenId);
+        ck_assert_uint_eq(client->channel.securityToken.channelId, channelId);
+
+        /* The messages are signed and encrypted with the new keys */
+        UA_Variant val;
+        UA_Variant_init(&val);
+        retval = UA_Client_readValueAttribute(client, nodeId, &val);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        UA_Variant_clear(&val);
+    }
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+}
+END_TEST
+
+/* The certificate of a reconnecting client is verified only once */
+START_TEST(encryption_certificate_cache) {
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    config->certificateCacheTtl = 60 * 1000;
+
+    UA_ByteString certificate;
+    certificate.length = CERT_DER_LENGTH;
+    certificate.data = CERT_DER_DATA;
+    UA_ByteString privateKey;
+    privateKey.length = KEY_DER_LENGTH;
+    privateKey.data = KEY_DER_DATA;
+
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_ClientConfig *cc = UA_Client_getConfig(client);
+    UA_ClientConfig_setDefaultEncryption(cc, certificate, privateKey,
+                                         NULL, 0, NULL, 0);
+    cc->certificateVerification.clear(&cc->certificateVerification);
+    UA_CertificateGroup_AcceptAll(&cc->certificateVerification);
+    cc->securityPolicyUri =
+        UA_STRING_ALLOC("http://opcfoundation.org/UA/SecurityPolicy#Basic256Sha256");
+
+    /* The client keeps the selected endpoint for the reconnect */
+    for(size_t round = 0; round < 3; round++) {
+        UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        UA_Client_disconnect(client);
+    }
+    UA_Client_delete(client);
+
+    UA_ServerStatistics stats = UA_Server_getStatistics(server);
+    ck_assert_uint_eq(stats.scs.certificateCacheHitCount, 2);
+}
+END_TEST
+
+/* New SecureChannels are rejected once the handshake tokens are used up */
+START_TEST(encryption_handshake_limit) {
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    config->maxHandshakesPerSecond = 1;
+    config->maxHandshakeBurst = 1;
+
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_Client *client2 = UA_Client_newForUnitTest();
+    retval = UA_Client_connect(client2, "opc.tcp://localhost:4840");
+    ck_assert_uint_ne(retval, UA_STATUSCODE_GOOD);
+    UA_Client_delete(client2);
+
+    UA_ServerStatistics stats = UA_Server_getStatistics(server);
+    ck_assert_uint_eq(stats.scs.handshakeRejectCount, 1);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+}
+END_TEST
+
 static Suite* testSuite_encryption(void) {
     Suite *s = suite_create("Encryption");
     TCase *tc_encryption = tcase_create("Encryption basic256sha256");
@@ -305,6 +513,13 @@ static Suite* testSuite_encryption(void) {
 #ifdef UA_ENABLE_ENCRYPTION
     tcase_add_test(tc_encryption, encryption_connect);
     tcase_add_test(tc_encryption, encryption_connect_pem);
+#if UA_MULTITHREADING >= 200
+    tcase_add_test(tc_encryption, encryption_parallel_decrypt);
+    tcase_add_test(tc_encryption, encryption_async_handshake);
+#endif
+    tcase_add_test(tc_encryption, encryption_renew_securechannel);
+    tcase_add_test(tc_encryption, encryption_handshake_limit);
+    tcase_add_test(tc_encryption, encryption_certificate_cache);
 #endif /* UA_ENABLE_ENCRYPTION */
     suite_add_tcase(s,tc_encryption);
 
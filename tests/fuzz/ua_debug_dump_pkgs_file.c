@@ -113,7 +113,8 @@ UA_debug_dumpSetServiceName(const UA_ByteString *msg, char serviceNameTarget[100
 static UA_StatusCode
 UA_debug_dump_setName(void *application, UA_SecureChannel *channel,
                       UA_MessageType messagetype, UA_UInt32 requestId,
-                      UA_ByteString *message) {
+                      const UA_ByteString *message, size_t messageSegments) {
+    (void)messageSegments; /* The NodeId is at the beginning of the first chunk */
     struct UA_dump_filename *dump_filename = (struct UA_dump_filename *)application;
     dump_filename->messageType = UA_debug_dumpGetMessageTypePrefix(messagetype);
     if(messagetype == UA_MESSAGETYPE_MSG)
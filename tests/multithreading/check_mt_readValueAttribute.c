@@ -5,6 +5,7 @@
 #include <open62541/plugin/log_stdout.h>
 #include <open62541/client_config_default.h>
 #include <open62541/client_highlevel.h>
+#include <open62541/plugin/nodestore_default.h>
 #include <check.h>
 #include <stdlib.h>
 
@@ -47,6 +48,23 @@ static void setup(void) {
     THREAD_CREATE(server_thread, serverloop);
 }
 
+/* The local reads share the service lock */
+static void setupConcurrentReads(void) {
+    tc.running = true;
+    UA_ServerConfig config;
+    memset(&config, 0, sizeof(UA_ServerConfig));
+    UA_Nodestore_ConcurrentHashMap(&config.nodestore);
+    UA_ServerConfig_setDefault(&config);
+    config.eventLoop->dateTime_now = UA_DateTime_now_fake;
+    config.eventLoop->dateTime_nowMonotonic = UA_DateTime_now_fake;
+    config.tcpReuseAddr = true;
+    tc.server = UA_Server_newWithConfig(&config);
+    ck_assert(tc.server != NULL);
+    addVariableNode();
+    UA_Server_run_startup(tc.server);
+    THREAD_CREATE(server_thread, serverloop);
+}
+
 static
 void server_readValueAttribute(void * value) {
     UA_ReadValueId rvi;
@@ -69,7 +87,14 @@ void server_readValueAttribute(void * value) {
     UA_StatusCode ret = UA_Server_readValue(tc.server, rvi.nodeId, &var);
     ck_assert_int_eq(UA_STATUSCODE_GOOD, ret);
     ck_assert_int_eq(42, *(UA_Int32 *)var.data);
+    UA_Variant_clear(&var);
 
+    // read 3 (the lock is released around the DataSource callback)
+    ret = UA_Server_readValue(tc.server,
+                              UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_CURRENTTIME),
+                              &var);
+    ck_assert_int_eq(UA_STATUSCODE_GOOD, ret);
+    ck_assert(&UA_TYPES[UA_TYPES_DATETIME] == var.type);
     UA_Variant_clear(&var);
 }
 
@@ -107,6 +132,10 @@ static Suite* testSuite_immutableNodes(void) {
     tcase_add_checked_fixture(valueCallback, setup, teardown);
     tcase_add_test(valueCallback, readValueAttribute);
     suite_add_tcase(s,valueCallback);
+    TCase *concurrentReads = tcase_create("Read attribute with shared lock");
+    tcase_add_checked_fixture(concurrentReads, setupConcurrentReads, teardown);
+    tcase_add_test(concurrentReads, readValueAttribute);
+    suite_add_tcase(s,concurrentReads);
     return s;
 }
 
@@ -0,0 +1,142 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
+#include <open62541/client_highlevel_async.h>
+#include <check.h>
+#include <stdlib.h>
+
+#include "test_helpers.h"
+#include "thread_wrapper.h"
+#include "mt_testing.h"
+
+#define NUMBER_OF_CLIENTS 8
+#define ITERATIONS_PER_CLIENT 20
+#define WRITES_PER_ITERATION 5
+
+static UA_NodeId
+clientVariable(size_t index) {
+    return UA_NODEID_NUMERIC(1, 2000 + (UA_UInt32)index);
+}
+
+static void
+addVariables(void) {
+    for(size_t i = 0; i < NUMBER_OF_CLIENTS; i++) {
+        UA_VariableAttributes attr = UA_VariableAttributes_default;
+        UA_Int32 zero = 0;
+        UA_Variant_setScalar(&attr.value, &zero, &UA_TYPES[UA_TYPES_INT32]);
+        attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+        char name[32];
+        snprintf(name, sizeof(name), "Client%u", (unsigned)i);
+        UA_StatusCode res =
+            UA_Server_addVariableNode(tc.server, clientVariable(i),
+                                      UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                      UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                      UA_QUALIFIEDNAME(1, name),
+                                      UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                      attr, NULL, NULL);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+}
+
+static void
+startServer(UA_UInt32 requestArenaSize) {
+    tc.running = true;
+    tc.server = UA_Server_newForUnitTest();
+    ck_assert(tc.server != NULL);
+    UA_ServerConfig *config = UA_Server_getConfig(tc.server);
+    config->requestWorkers = 4;
+    config->requestArenaSize = requestArenaSize;
+    addVariables();
+    UA_Server_run_startup(tc.server);
+    THREAD_CREATE(server_thread, serverloop);
+}
+
+static void setup(void) {
+    startServer(0);
+}
+
+static void setupArena(void) {
+    startServer(4096);
+}
+
+static void
+writeCallback(UA_Client *client, void *userdata, UA_UInt32 requestId,
+              UA_WriteResponse *wr) {
+    ck_assert_uint_eq(wr->responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(wr->resultsSize, 1);
+    ck_assert_uint_eq(wr->results[0], UA_STATUSCODE_GOOD);
+    (*(size_t*)userdata)++;
+}
+
+/* The writes are sent without waiting for the responses. The Read that
+ * follows must see the value of the last write as the requests of a Session
+ * are processed in order. */
+static void
+client_writeRead(void *value) {
+    ThreadContext tmp = (*(ThreadContext *) value);
+    UA_Client *client = tc.clients[tmp.index];
+    UA_NodeId nodeId = clientVariable(tmp.index);
+
+    size_t written = 0;
+    UA_Int32 last = 0;
+    for(size_t i = 0; i < WRITES_PER_ITERATION; i++) {
+        last = (UA_Int32)(tmp.counter * WRITES_PER_ITERATION + i);
+        UA_Variant v;
+        UA_Variant_setScalar(&v, &last, &UA_TYPES[UA_TYPES_INT32]);
+        UA_StatusCode res =
+            UA_Client_writeValueAttribute_async(client, nodeId, &v, writeCallback,
+                                                &written, NULL);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+
+    UA_Variant val;
+    UA_StatusCode res = UA_Client_readValueAttribute(client, nodeId, &val);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(val.type == &UA_TYPES[UA_TYPES_INT32]);
+    ck_assert_int_eq(*(UA_Int32*)val.data, last);
+    ck_assert_uint_eq(written, WRITES_PER_ITERATION);
+    UA_Variant_clear(&val);
+}
+
+static void
+initTest(void) {
+    for(size_t i = 0; i < tc.numberofClients; i++)
+        setThreadContext(&tc.clientContext[i], i, ITERATIONS_PER_CLIENT,
+                         client_writeRead);
+}
+
+START_TEST(requestsOfSessionInOrder) {
+    startMultithreading();
+} END_TEST
+
+static Suite* testSuite_requestExecutor(void) {
+    Suite *s = suite_create("Request Executor");
+    TCase *tc_order = tcase_create("Per-Session order");
+    tcase_add_checked_fixture(tc_order, setup, teardown);
+    tcase_add_test(tc_order, requestsOfSessionInOrder);
+    suite_add_tcase(s, tc_order);
+
+    TCase *tc_arena = tcase_create("Per-Session order with arena");
+    tcase_add_checked_fixture(tc_arena, setupArena, teardown);
+    tcase_add_test(tc_arena, requestsOfSessionInOrder);
+    suite_add_tcase(s, tc_arena);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_requestExecutor();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+
+    createThreadContext(0, NUMBER_OF_CLIENTS, NULL);
+    initTest();
+    srunner_run_all(sr, CK_NORMAL);
+    deleteThreadContext();
+
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -33,9 +33,9 @@ START_TEST(AddPublisherUsingBinaryFile) {
     UA_PubSubManager *psm = getPSM(server);
     UA_ByteString publisherConfiguration = loadFile("../../tests/pubsub/check_publisher_configuration.bin");
     ck_assert(publisherConfiguration.length > 0);
-    UA_LOCK(&server->serviceMutex);
-    UA_StatusCode retVal = UA_PubSubManager_loadPubSubConfigFromByteString(psm, publisherConfiguration);
+    UA_StatusCode retVal = UA_Server_loadPubSubConfigFromByteString(server, publisherConfiguration);
     ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    UA_LOCK(&server->serviceMutex);
     UA_PubSubConnection *connection;
     UA_WriterGroup *writerGroup;
     UA_DataSetWriter *dataSetWriter;
@@ -69,9 +69,9 @@ START_TEST(AddSubscriberUsingBinaryFile) {
     UA_PubSubManager *psm = getPSM(server);
     UA_ByteString subscriberConfiguration = loadFile("../../tests/pubsub/check_subscriber_configuration.bin");
     ck_assert(subscriberConfiguration.length > 0);
-    UA_LOCK(&server->serviceMutex);
-    UA_StatusCode retVal = UA_PubSubManager_loadPubSubConfigFromByteString(psm, subscriberConfiguration);
+    UA_StatusCode retVal = UA_Server_loadPubSubConfigFromByteString(server, subscriberConfiguration);
     ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    UA_LOCK(&server->serviceMutex);
     UA_PubSubConnection *connection;
     UA_ReaderGroup *readerGroup;
     UA_DataSetReader *dataSetReader;
@@ -101,11 +101,95 @@ START_TEST(AddSubscriberUsingBinaryFile) {
     UA_ByteString_clear(&subscriberConfiguration);
 } END_TEST
 
+/* DataSetWriters are matched with their PublishedDataSet by name */
+START_TEST(WriteAndLoadManyDataSetWriters) {
+    const size_t count = 200;
+    UA_NodeId *pdsIds = (UA_NodeId*)UA_calloc(count, sizeof(UA_NodeId));
+    char name[32];
+    for(size_t i = 0; i < count; i++) {
+        UA_PublishedDataSetConfig pdsConfig;
+        memset(&pdsConfig, 0, sizeof(UA_PublishedDataSetConfig));
+        pdsConfig.publishedDataSetType = UA_PUBSUB_DATASET_PUBLISHEDITEMS;
+        snprintf(name, sizeof(name), "PDS %u", (unsigned)i);
+        pdsConfig.name = UA_STRING(name);
+        ck_assert_int_eq(UA_Server_addPublishedDataSet(server, &pdsConfig,
+                                                       &pdsIds[i]).addResult,
+                         UA_STATUSCODE_GOOD);
+    }
+
+    UA_PubSubConnectionConfig connectionConfig;
+    memset(&connectionConfig, 0, sizeof(UA_PubSubConnectionConfig));
+    connectionConfig.name = UA_STRING("UADP Connection");
+    UA_NetworkAddressUrlDataType networkAddressUrl =
+        {UA_STRING_NULL, UA_STRING("opc.udp://224.0.0.22:4840/")};
+    UA_Variant_setScalar(&connectionConfig.address, &networkAddressUrl,
+                         &UA_TYPES[UA_TYPES_NETWORKADDRESSURLDATATYPE]);
+    connectionConfig.transportProfileUri =
+        UA_STRING("http://opcfoundation.org/UA-Profile/Transport/pubsub-udp-uadp");
+    UA_NodeId connectionId;
+    ck_assert_int_eq(UA_Server_addPubSubConnection(server, &connectionConfig, &connectionId),
+                     UA_STATUSCODE_GOOD);
+
+    UA_WriterGroupConfig writerGroupConfig;
+    memset(&writerGroupConfig, 0, sizeof(UA_WriterGroupConfig));
+    writerGroupConfig.name = UA_STRING("WriterGroup");
+    writerGroupConfig.publishingInterval = 100;
+    writerGroupConfig.encodingMimeType = UA_PUBSUB_ENCODING_UADP;
+    UA_UadpWriterGroupMessageDataType writerGroupMessage;
+    UA_UadpWriterGroupMessageDataType_init(&writerGroupMessage);
+    UA_ExtensionObject_setValue(&writerGroupConfig.messageSettings, &writerGroupMessage,
+                                &UA_TYPES[UA_TYPES_UADPWRITERGROUPMESSAGEDATATYPE]);
+    UA_NodeId writerGroupId;
+    ck_assert_int_eq(UA_Server_addWriterGroup(server, connectionId, &writerGroupConfig,
+                                              &writerGroupId), UA_STATUSCODE_GOOD);
+
+    /* The DataSetWriters do not set the DataSetName in their config */
+    for(size_t i = 0; i < count; i++) {
+        UA_DataSetWriterConfig dataSetWriterConfig;
+        memset(&dataSetWriterConfig, 0, sizeof(UA_DataSetWriterConfig));
+        snprintf(name, sizeof(name), "DSW %u", (unsigned)i);
+        dataSetWriterConfig.name = UA_STRING(name);
+        dataSetWriterConfig.dataSetWriterId = (UA_UInt16)(i + 1);
+        ck_assert_int_eq(UA_Server_addDataSetWriter(server, writerGroupId,
+                                                    pdsIds[(i * 7) % count],
+                                                    &dataSetWriterConfig, NULL),
+                         UA_STATUSCODE_GOOD);
+    }
+    UA_free(pdsIds);
+
+    /* Load into a fresh server */
+    UA_ByteString buffer;
+    ck_assert_int_eq(UA_Server_writePubSubConfigurationToByteString(server, &buffer),
+                     UA_STATUSCODE_GOOD);
+    UA_Server *server2 = UA_Server_newForUnitTest();
+    ck_assert_int_eq(UA_Server_loadPubSubConfigFromByteString(server2, buffer),
+                     UA_STATUSCODE_GOOD);
+    UA_ByteString_clear(&buffer);
+
+    UA_PubSubManager *psm = getPSM(server2);
+    ck_assert_uint_eq(psm->publishedDataSetsSize, count);
+    UA_PubSubConnection *connection = TAILQ_FIRST(&psm->connections);
+    ck_assert(connection != NULL);
+    UA_WriterGroup *writerGroup = LIST_FIRST(&connection->writerGroups);
+    ck_assert(writerGroup != NULL);
+    ck_assert_uint_eq(writerGroup->writersCount, count);
+    UA_DataSetWriter *dataSetWriter;
+    LIST_FOREACH(dataSetWriter, &writerGroup->writers, listEntry) {
+        size_t i = (size_t)(dataSetWriter->config.dataSetWriterId - 1);
+        snprintf(name, sizeof(name), "PDS %u", (unsigned)((i * 7) % count));
+        UA_String expected = UA_STRING(name);
+        ck_assert(dataSetWriter->connectedDataSet != NULL);
+        ck_assert(UA_String_equal(&expected, &dataSetWriter->connectedDataSet->config.name));
+    }
+    UA_Server_delete(server2);
+} END_TEST
+
 int main(void) {
     TCase *tc_pubsub_file_configuration = tcase_create("File Configuration");
     tcase_add_checked_fixture(tc_pubsub_file_configuration, setup, teardown);
     tcase_add_test(tc_pubsub_file_configuration, AddPublisherUsingBinaryFile);
     tcase_add_test(tc_pubsub_file_configuration, AddSubscriberUsingBinaryFile);
+    tcase_add_test(tc_pubsub_file_configuration, WriteAndLoadManyDataSetWriters);
 
     Suite *s = suite_create("PubSub file configuration");
     suite_add_tcase(s, tc_pubsub_file_configuration);
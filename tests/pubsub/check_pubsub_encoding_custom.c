@@ -68,7 +68,8 @@ static const UA_DataType PointType = {
     false,                           /* .overlayable (depends on endianness and
                                          the absence of padding) */
     3,                               /* .membersSize */
-    members
+    members,                         /* .members */
+    12                               /* .binarySize */
 };
 
 const UA_DataTypeArray customDataTypes = {NULL, 1, &PointType, UA_FALSE};
@@ -127,7 +128,8 @@ static const UA_DataType OptType = {
         false,                           /* .overlayable (depends on endianness and
                                          the absence of padding) */
         4,                               /* .membersSize */
-        Opt_members
+        Opt_members,                     /* .members */
+        0                                /* .binarySize */
 };
 
 const UA_DataTypeArray customDataTypesOptStruct = {&customDataTypes, 2, &OptType, UA_FALSE};
@@ -185,7 +187,8 @@ static const UA_DataType ArrayOptType = {
     false,                           /* .overlayable (depends on endianness and
                                          the absence of padding) */
     4,                               /* .membersSize */
-    ArrayOptStruct_members
+    ArrayOptStruct_members,          /* .members */
+    0                                /* .binarySize */
 };
 
 const UA_DataTypeArray customDataTypesOptArrayStruct = {&customDataTypesOptStruct, 3, &ArrayOptType, UA_FALSE};
@@ -226,7 +229,8 @@ static const UA_DataType UniType = {
         false,
         false,
         2,
-        Uni_members
+        Uni_members,
+        0
 };
 
 const UA_DataTypeArray customDataTypesUnion = {&customDataTypesOptArrayStruct, 2, &UniType, UA_FALSE};
@@ -277,7 +281,8 @@ const UA_DataType selfContainingUnionType = {
     false, /* .pointerFree */
     false, /* .overlayable */
     2, /* .membersSize */
-    SelfContainingUnion_members  /* .members */
+    SelfContainingUnion_members, /* .members */
+    0 /* .binarySize */
 };
 
 const UA_DataTypeArray customDataTypesSelfContainingUnion = {NULL, 1, &selfContainingUnionType, UA_FALSE};
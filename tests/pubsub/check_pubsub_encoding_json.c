@@ -106,6 +106,90 @@ START_TEST(UA_PubSub_EncodeAllOptionalFields) {
 }
 END_TEST
 
+START_TEST(UA_PubSub_EncodeTemplate) {
+    UA_NetworkMessage m;
+    memset(&m, 0, sizeof(UA_NetworkMessage));
+    m.version = 1;
+    m.networkMessageType = UA_NETWORKMESSAGE_DATASET;
+    m.payloadHeaderEnabled = true;
+    m.payloadHeader.dataSetPayloadHeader.count = 1;
+    UA_UInt16 dsWriter1 = 12345;
+    m.payloadHeader.dataSetPayloadHeader.dataSetWriterIds = &dsWriter1;
+    m.publisherIdEnabled = true;
+    m.publisherId.idType = UA_PUBLISHERIDTYPE_STRING;
+    m.publisherId.id.string = UA_STRING("Pub\"lisher");
+
+    UA_DataSetMessage dsm;
+    memset(&dsm, 0, sizeof(UA_DataSetMessage));
+    m.payload.dataSetPayload.dataSetMessages = &dsm;
+    dsm.header.dataSetMessageValid = true;
+    dsm.header.fieldEncoding = UA_FIELDENCODING_VARIANT;
+    dsm.header.dataSetMessageType = UA_DATASETMESSAGE_DATAKEYFRAME;
+    dsm.header.dataSetMessageSequenceNrEnabled = true;
+    dsm.header.dataSetMessageSequenceNr = 4711;
+
+    /* The field names need to be escaped */
+    UA_String fieldNames[2] = {UA_STRING_STATIC("Field\"1"), UA_STRING_STATIC("Field\\2")};
+    UA_DataValue fields[2];
+    UA_UInt32 iv = 27;
+    UA_Double dv = 2.5;
+    UA_DataValue_init(&fields[0]);
+    UA_DataValue_init(&fields[1]);
+    UA_Variant_setScalar(&fields[0].value, &iv, &UA_TYPES[UA_TYPES_UINT32]);
+    UA_Variant_setScalar(&fields[1].value, &dv, &UA_TYPES[UA_TYPES_DOUBLE]);
+    fields[0].hasValue = true;
+    fields[1].hasValue = true;
+    dsm.data.keyFrameData.fieldCount = 2;
+    dsm.data.keyFrameData.dataSetFields = fields;
+    dsm.data.keyFrameData.fieldNames = fieldNames;
+
+    /* Encode the reference without the template */
+    size_t size = UA_NetworkMessage_calcSizeJsonInternal(&m, NULL, 0, NULL, 0, true);
+    UA_ByteString reference;
+    UA_StatusCode rv = UA_ByteString_allocBuffer(&reference, size);
+    ck_assert_int_eq(rv, UA_STATUSCODE_GOOD);
+    UA_Byte *bufPos = reference.data;
+    const UA_Byte *bufEnd = &reference.data[reference.length];
+    rv = UA_NetworkMessage_encodeJsonInternal(&m, &bufPos, &bufEnd, NULL, 0, NULL, 0, true);
+    ck_assert_int_eq(rv, UA_STATUSCODE_GOOD);
+
+    /* Prepare the template. The field names in the message are not used. */
+    UA_NetworkMessageJsonTemplate tmpl;
+    UA_String *fieldKeys = NULL;
+    rv = UA_NetworkMessage_encodeJsonHeader(&m, &tmpl.header);
+    ck_assert_int_eq(rv, UA_STATUSCODE_GOOD);
+    rv = UA_NetworkMessage_encodeJsonFieldKeys(fieldNames, 2, &fieldKeys);
+    ck_assert_int_eq(rv, UA_STATUSCODE_GOOD);
+    const UA_String *dsmKeys[1] = {fieldKeys};
+    tmpl.fieldKeys = dsmKeys;
+    dsm.data.keyFrameData.fieldNames = NULL;
+
+    ck_assert_uint_eq(UA_NetworkMessage_calcSizeJsonTemplate(&m, &tmpl), size);
+
+    /* Encoding fails if the buffer is too small */
+    UA_ByteString buffer;
+    rv = UA_ByteString_allocBuffer(&buffer, size);
+    ck_assert_int_eq(rv, UA_STATUSCODE_GOOD);
+    bufPos = buffer.data;
+    rv = UA_NetworkMessage_encodeJsonTemplate(&m, &tmpl, &bufPos,
+                                              &buffer.data[size - 1]);
+    ck_assert_int_eq(rv, UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED);
+
+    /* The template encoding is identical to the reference */
+    bufPos = buffer.data;
+    rv = UA_NetworkMessage_encodeJsonTemplate(&m, &tmpl, &bufPos,
+                                              &buffer.data[size]);
+    ck_assert_int_eq(rv, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq((size_t)(bufPos - buffer.data), size);
+    ck_assert(UA_ByteString_equal(&buffer, &reference));
+
+    UA_ByteString_clear(&buffer);
+    UA_ByteString_clear(&reference);
+    UA_String_clear(&tmpl.header);
+    UA_Array_delete(fieldKeys, 2, &UA_TYPES[UA_TYPES_STRING]);
+}
+END_TEST
+
 START_TEST(UA_PubSub_EnDecode) {
     UA_NetworkMessage m;
     memset(&m, 0, sizeof(UA_NetworkMessage));
@@ -382,6 +466,7 @@ static Suite *testSuite_networkmessage(void) {
 
 
     tcase_add_test(tc_json_networkmessage, UA_PubSub_EncodeAllOptionalFields);
+    tcase_add_test(tc_json_networkmessage, UA_PubSub_EncodeTemplate);
     tcase_add_test(tc_json_networkmessage, UA_PubSub_EnDecode);
     tcase_add_test(tc_json_networkmessage, UA_NetworkMessage_oneMessage_twoFields_json_decode);
     tcase_add_test(tc_json_networkmessage, UA_NetworkMessage_json_decode);
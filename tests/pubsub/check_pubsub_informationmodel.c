@@ -514,6 +514,74 @@ START_TEST(ReadDataSetWriterIdWGAndCompareWithInternalValue){
     UA_Variant_clear(&value);
     } END_TEST
 
+static UA_Boolean
+nodeExists(UA_NodeId id) {
+    UA_NodeClass nodeClass;
+    return (UA_Server_readNodeClass(server, id, &nodeClass) == UA_STATUSCODE_GOOD);
+}
+
+static void
+browseNode(UA_NodeId id) {
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = id;
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+    bd.resultMask = UA_BROWSERESULTMASK_ALL;
+    UA_BrowseResult br = UA_Server_browse(server, 0, &bd);
+    ck_assert_uint_eq(br.statusCode, UA_STATUSCODE_GOOD);
+    UA_BrowseResult_clear(&br);
+}
+
+START_TEST(LazyInformationModel){
+    UA_Server_getConfig(server)->pubSubConfig.lazyInformationModel = true;
+    setupBasicPubSubConfiguration();
+
+    /* Only NodeIds are reserved */
+    ck_assert(!UA_NodeId_isNull(&connection1));
+    ck_assert(!nodeExists(connection1));
+    ck_assert(!nodeExists(publishedDataSet1));
+
+    /* Browsing the parent creates one level */
+    browseNode(UA_NODEID_NUMERIC(0, UA_NS0ID_PUBLISHSUBSCRIBE));
+    ck_assert(nodeExists(connection1));
+    ck_assert(nodeExists(connection2));
+    ck_assert(!nodeExists(writerGroup1));
+    ck_assert(!nodeExists(readerGroup1));
+
+    browseNode(connection1);
+    ck_assert(nodeExists(writerGroup1));
+    ck_assert(nodeExists(readerGroup1));
+    ck_assert(!nodeExists(writerGroup3));
+    ck_assert(!nodeExists(dataSetWriter1));
+    ck_assert(!nodeExists(dataSetReader1));
+
+    /* Translating a path from the WriterGroup creates the DataSetWriters and
+     * the PublishedDataSets they reference */
+    UA_NodeId dswNode =
+        findSingleChildNode(server, UA_QUALIFIEDNAME(0, "DataSetWriter 1"),
+                            UA_NODEID_NUMERIC(0, UA_NS0ID_HASDATASETWRITER), writerGroup1);
+    ck_assert(UA_NodeId_equal(&dswNode, &dataSetWriter1));
+    ck_assert(nodeExists(publishedDataSet1));
+    ck_assert(nodeExists(publishedDataSet2));
+    ck_assert(!nodeExists(dataSetWriter3));
+
+    /* The materialized nodes are backed by the PubSub components */
+    UA_NodeId dswIdNode =
+        findSingleChildNode(server, UA_QUALIFIEDNAME(0, "DataSetWriterId"),
+                            UA_NODEID_NUMERIC(0, UA_NS0ID_HASPROPERTY), dataSetWriter4);
+    UA_Variant value;
+    ck_assert_int_eq(UA_Server_readValue(server, dswIdNode, &value), UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(*(UA_UInt16*)value.data, 62541);
+    UA_Variant_clear(&value);
+
+    /* Removing components with and without representation */
+    ck_assert_int_eq(UA_Server_removeDataSetWriter(server, dataSetWriter1), UA_STATUSCODE_GOOD);
+    ck_assert(!nodeExists(dataSetWriter1));
+    ck_assert_int_eq(UA_Server_removePubSubConnection(server, connection2), UA_STATUSCODE_GOOD);
+    ck_assert(!nodeExists(connection2));
+    ck_assert_int_eq(UA_Server_removeDataSetWriter(server, dataSetWriter3), UA_STATUSCODE_GOOD);
+} END_TEST
+
 int main(void) {
     TCase *tc_add_pubsub_informationmodel = tcase_create("PubSub add single elements and check information model representation");
     tcase_add_checked_fixture(tc_add_pubsub_informationmodel, setup, teardown);
@@ -548,12 +616,17 @@ int main(void) {
     tcase_add_checked_fixture(tc_add_pubsub_dataSetWriterElements, setup, teardown);
     tcase_add_test(tc_add_pubsub_dataSetWriterElements, ReadDataSetWriterIdWGAndCompareWithInternalValue);
 
+    TCase *tc_lazy_informationmodel = tcase_create("PubSub lazy information model");
+    tcase_add_checked_fixture(tc_lazy_informationmodel, setup, teardown);
+    tcase_add_test(tc_lazy_informationmodel, LazyInformationModel);
+
     Suite *s = suite_create("PubSub WriterGroups/DataSetReader/Fields handling and publishing");
     suite_add_tcase(s, tc_add_pubsub_informationmodel);
     suite_add_tcase(s, tc_add_pubsub_writergroupelements);
     suite_add_tcase(s, tc_add_pubsub_pubsubconnectionelements);
     suite_add_tcase(s, tc_add_pubsub_dataSetReaderElements);
     suite_add_tcase(s, tc_add_pubsub_dataSetWriterElements);
+    suite_add_tcase(s, tc_lazy_informationmodel);
 
     SRunner *sr = srunner_create(s);
     srunner_set_fork_status(sr, CK_NOFORK);
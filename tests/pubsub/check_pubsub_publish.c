@@ -136,6 +136,41 @@ START_TEST(AddWriterGroupWithInvalidConnectionId){
         ck_assert_int_ne(retVal, UA_STATUSCODE_GOOD);
     } END_TEST
 
+START_TEST(AddWriterGroupWithTransmitTimeOffset){
+        UA_WriterGroupConfig writerGroupConfig;
+        memset(&writerGroupConfig, 0, sizeof(writerGroupConfig));
+        writerGroupConfig.name = UA_STRING("WriterGroup 1");
+        writerGroupConfig.publishingInterval = 10;
+
+        /* The transmit time has to be within the publishing cycle */
+        writerGroupConfig.transmitTimeOffset = 10;
+        UA_NodeId localWriterGroup;
+        UA_StatusCode retVal =
+            UA_Server_addWriterGroup(server, connection1, &writerGroupConfig,
+                                     &localWriterGroup);
+        ck_assert_int_eq(retVal, UA_STATUSCODE_BADCONFIGURATIONERROR);
+
+        writerGroupConfig.transmitTimeOffset = 2.5;
+        retVal = UA_Server_addWriterGroup(server, connection1, &writerGroupConfig,
+                                          &localWriterGroup);
+        ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+
+        /* The transmit time is at the offset into the cycle of the monotonic
+         * clock */
+        UA_PubSubManager *psm = getPSM(server);
+        UA_WriterGroup *wg = UA_WriterGroup_find(psm, localWriterGroup);
+        ck_assert(wg != NULL);
+        UA_EventLoop *el = server->config.eventLoop;
+        UA_DateTime before = el->dateTime_nowMonotonic(el);
+        UA_WriterGroup_publishCallback(psm, wg);
+        ck_assert_int_gt(wg->txtime, before - 10 * UA_DATETIME_MSEC);
+        ck_assert_int_lt(wg->txtime, before + 10 * UA_DATETIME_MSEC);
+        UA_DateTime phase = (wg->txtime - UA_DATETIME_UNIX_EPOCH) % (10 * UA_DATETIME_MSEC);
+        if(phase < 0)
+            phase += 10 * UA_DATETIME_MSEC;
+        ck_assert_int_eq(phase, (UA_DateTime)(2.5 * UA_DATETIME_MSEC));
+    } END_TEST
+
 START_TEST(GetWriterGroupConfigurationAndCompareValues){
         UA_StatusCode retVal = UA_STATUSCODE_GOOD;
         UA_WriterGroupConfig writerGroupConfig;
@@ -535,6 +570,291 @@ START_TEST(PublishDataSetFieldAsDeltaFrame){
         ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
     } END_TEST
 
+static void
+generateDeltaTestMessage(UA_DataSetWriter *dsw, UA_DataSetMessage *dsm) {
+    memset(dsm, 0, sizeof(UA_DataSetMessage));
+    UA_LOCK(&server->serviceMutex);
+    UA_StatusCode res = UA_DataSetWriter_generateDataSetMessage(getPSM(server), dsm, dsw);
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+}
+
+static void
+writeDeltaTestVariable(UA_NodeId id, UA_Int32 value) {
+    UA_Variant v;
+    UA_Variant_setScalar(&v, &value, &UA_TYPES[UA_TYPES_INT32]);
+    ck_assert_int_eq(UA_Server_writeValue(server, id, v), UA_STATUSCODE_GOOD);
+}
+
+START_TEST(GenerateDeltaFramesWithChangedFieldsOnly){
+        UA_Server_getConfig(server)->pubSubConfig.enableDeltaFrames = true;
+        setupDataSetWriterTestEnvironment();
+        setupPublishedDataSetTestEnvironment();
+
+        /* One field per variable */
+        UA_NodeId vars[3];
+        for(size_t i = 0; i < 3; i++) {
+            UA_VariableAttributes attr = UA_VariableAttributes_default;
+            UA_Int32 initial = 0;
+            UA_Variant_setScalar(&attr.value, &initial, &UA_TYPES[UA_TYPES_INT32]);
+            attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+            UA_StatusCode retVal =
+                UA_Server_addVariableNode(server, UA_NODEID_NULL,
+                                          UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                          UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                          UA_QUALIFIEDNAME(1, "Delta Variable"),
+                                          UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                          attr, NULL, &vars[i]);
+            ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+
+            UA_DataSetFieldConfig dataSetFieldConfig;
+            memset(&dataSetFieldConfig, 0, sizeof(UA_DataSetFieldConfig));
+            dataSetFieldConfig.dataSetFieldType = UA_PUBSUB_DATASETFIELD_VARIABLE;
+            dataSetFieldConfig.field.variable.fieldNameAlias = UA_STRING("Delta Variable");
+            dataSetFieldConfig.field.variable.publishParameters.publishedVariable = vars[i];
+            dataSetFieldConfig.field.variable.publishParameters.attributeId = UA_ATTRIBUTEID_VALUE;
+            retVal = UA_Server_addDataSetField(server, publishedDataSet1,
+                                               &dataSetFieldConfig, NULL).result;
+            ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+        }
+
+        /* Four messages per KeyFrame interval */
+        UA_DataSetWriterConfig dataSetWriterConfig;
+        memset(&dataSetWriterConfig, 0, sizeof(dataSetWriterConfig));
+        dataSetWriterConfig.name = UA_STRING("DataSetWriter 1");
+        dataSetWriterConfig.keyFrameCount = 4;
+        UA_StatusCode retVal =
+            UA_Server_addDataSetWriter(server, writerGroup1, publishedDataSet1,
+                                       &dataSetWriterConfig, &dataSetWriter1);
+        ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+        UA_DataSetWriter *dsw = UA_DataSetWriter_find(getPSM(server), dataSetWriter1);
+        ck_assert_ptr_ne(dsw, NULL);
+        ck_assert_uint_eq(dsw->lastSamplesCount, 3);
+
+        /* The interval starts with a KeyFrame */
+        UA_DataSetMessage dsm;
+        generateDeltaTestMessage(dsw, &dsm);
+        ck_assert_int_eq(dsm.header.dataSetMessageType, UA_DATASETMESSAGE_DATAKEYFRAME);
+        ck_assert_uint_eq(dsm.data.keyFrameData.fieldCount, 3);
+        UA_DataSetMessage_clear(&dsm);
+
+        /* Nothing changed */
+        generateDeltaTestMessage(dsw, &dsm);
+        ck_assert_int_eq(dsm.header.dataSetMessageType, UA_DATASETMESSAGE_DATADELTAFRAME);
+        ck_assert_uint_eq(dsm.data.deltaFrameData.fieldCount, 0);
+        UA_DataSetMessage_clear(&dsm);
+
+        /* Only the changed field is sent */
+        writeDeltaTestVariable(vars[1], 42);
+        generateDeltaTestMessage(dsw, &dsm);
+        ck_assert_int_eq(dsm.header.dataSetMessageType, UA_DATASETMESSAGE_DATADELTAFRAME);
+        ck_assert_uint_eq(dsm.data.deltaFrameData.fieldCount, 1);
+        ck_assert_uint_eq(dsm.data.deltaFrameData.deltaFrameFields[0].fieldIndex, 1);
+        ck_assert_int_eq(*(UA_Int32*)dsm.data.deltaFrameData.deltaFrameFields[0].
+                         fieldValue.value.data, 42);
+        UA_DataSetMessage_clear(&dsm);
+
+        generateDeltaTestMessage(dsw, &dsm);
+        ck_assert_int_eq(dsm.header.dataSetMessageType, UA_DATASETMESSAGE_DATADELTAFRAME);
+        UA_DataSetMessage_clear(&dsm);
+
+        /* The next interval starts with a KeyFrame */
+        generateDeltaTestMessage(dsw, &dsm);
+        ck_assert_int_eq(dsm.header.dataSetMessageType, UA_DATASETMESSAGE_DATAKEYFRAME);
+        UA_DataSetMessage_clear(&dsm);
+
+        /* All fields changed. Sent as a KeyFrame which restarts the interval. */
+        for(size_t i = 0; i < 3; i++)
+            writeDeltaTestVariable(vars[i], 7);
+        generateDeltaTestMessage(dsw, &dsm);
+        ck_assert_int_eq(dsm.header.dataSetMessageType, UA_DATASETMESSAGE_DATAKEYFRAME);
+        ck_assert_uint_eq(dsm.data.keyFrameData.fieldCount, 3);
+        ck_assert_int_eq(*(UA_Int32*)dsm.data.keyFrameData.dataSetFields[2].value.data, 7);
+        UA_DataSetMessage_clear(&dsm);
+        ck_assert_uint_eq(dsw->deltaFrameCounter, 1);
+
+        writeDeltaTestVariable(vars[2], 8);
+        generateDeltaTestMessage(dsw, &dsm);
+        ck_assert_int_eq(dsm.header.dataSetMessageType, UA_DATASETMESSAGE_DATADELTAFRAME);
+        ck_assert_uint_eq(dsm.data.deltaFrameData.fieldCount, 1);
+        ck_assert_uint_eq(dsm.data.deltaFrameData.deltaFrameFields[0].fieldIndex, 2);
+        UA_DataSetMessage_clear(&dsm);
+    } END_TEST
+
+static size_t sendVCalls;
+static size_t sendVBuffers;
+static UA_StatusCode
+(*sendVOrig)(UA_ConnectionManager *cm, uintptr_t connectionId,
+             const UA_KeyValueMap *params, UA_ByteString *bufs, size_t bufsSize);
+
+static UA_StatusCode
+countSendV(UA_ConnectionManager *cm, uintptr_t connectionId,
+           const UA_KeyValueMap *params, UA_ByteString *bufs, size_t bufsSize) {
+    sendVCalls++;
+    sendVBuffers += bufsSize;
+    return sendVOrig(cm, connectionId, params, bufs, bufsSize);
+}
+
+/* The NetworkMessages of WriterGroups publishing in the same EventLoop
+ * iteration are sent with a single call */
+START_TEST(BatchSendOfWriterGroupsInOneIteration) {
+    UA_PublishedDataSetConfig pdsConfig;
+    memset(&pdsConfig, 0, sizeof(UA_PublishedDataSetConfig));
+    pdsConfig.publishedDataSetType = UA_PUBSUB_DATASET_PUBLISHEDITEMS;
+    pdsConfig.name = UA_STRING(publishedDataSet1Name);
+    UA_StatusCode retVal =
+        UA_Server_addPublishedDataSet(server, &pdsConfig, &publishedDataSet1).addResult;
+    UA_DataSetFieldConfig dataSetFieldConfig;
+    memset(&dataSetFieldConfig, 0, sizeof(UA_DataSetFieldConfig));
+    dataSetFieldConfig.dataSetFieldType = UA_PUBSUB_DATASETFIELD_VARIABLE;
+    dataSetFieldConfig.field.variable.fieldNameAlias = UA_STRING("Server localtime");
+    dataSetFieldConfig.field.variable.publishParameters.publishedVariable =
+        UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_CURRENTTIME);
+    dataSetFieldConfig.field.variable.publishParameters.attributeId = UA_ATTRIBUTEID_VALUE;
+    retVal |= UA_Server_addDataSetField(server, publishedDataSet1,
+                                        &dataSetFieldConfig, NULL).result;
+
+    UA_WriterGroupConfig writerGroupConfig;
+    memset(&writerGroupConfig, 0, sizeof(writerGroupConfig));
+    writerGroupConfig.publishingInterval = 1000;
+    writerGroupConfig.encodingMimeType = UA_PUBSUB_ENCODING_UADP;
+    UA_DataSetWriterConfig dataSetWriterConfig;
+    memset(&dataSetWriterConfig, 0, sizeof(dataSetWriterConfig));
+    dataSetWriterConfig.name = UA_STRING("DataSetWriter");
+    UA_NodeId wgs[3];
+    for(size_t i = 0; i < 3; i++) {
+        writerGroupConfig.name = UA_STRING("WriterGroup");
+        writerGroupConfig.writerGroupId = (UA_UInt16)(i + 1);
+        retVal |= UA_Server_addWriterGroup(server, connection1, &writerGroupConfig, &wgs[i]);
+        UA_NodeId dsw;
+        retVal |= UA_Server_addDataSetWriter(server, wgs[i], publishedDataSet1,
+                                             &dataSetWriterConfig, &dsw);
+        retVal |= UA_Server_enableDataSetWriter(server, dsw);
+        retVal |= UA_Server_enableWriterGroup(server, wgs[i]);
+    }
+    retVal |= UA_Server_enablePubSubConnection(server, connection1);
+    ck_assert_uint_eq(retVal, UA_STATUSCODE_GOOD);
+
+    UA_LOCK(&server->serviceMutex);
+    UA_PubSubConnection *c = UA_PubSubConnection_find(getPSM(server), connection1);
+    ck_assert(c != NULL);
+    ck_assert(c->sendChannel != 0);
+    ck_assert(c->cm->sendWithConnectionV != NULL);
+    sendVOrig = c->cm->sendWithConnectionV;
+    c->cm->sendWithConnectionV = countSendV;
+    UA_UNLOCK(&server->serviceMutex);
+
+    sendVCalls = 0;
+    sendVBuffers = 0;
+    for(size_t i = 0; i < 3; i++)
+        UA_Server_WriterGroup_publish(server, wgs[i]);
+    ck_assert_uint_eq(sendVCalls, 0);
+    UA_Server_run_iterate(server, false);
+    ck_assert_uint_eq(sendVCalls, 1);
+    ck_assert_uint_eq(sendVBuffers, 3);
+
+    UA_LOCK(&server->serviceMutex);
+    c->cm->sendWithConnectionV = sendVOrig;
+    UA_UNLOCK(&server->serviceMutex);
+} END_TEST
+
+/* The publish cycles are counted with their jitter. A late cycle is an
+ * overrun and the skipped cycles are counted as missed. */
+START_TEST(WriterGroupCycleStatistics) {
+    UA_PublishedDataSetConfig pdsConfig;
+    memset(&pdsConfig, 0, sizeof(UA_PublishedDataSetConfig));
+    pdsConfig.publishedDataSetType = UA_PUBSUB_DATASET_PUBLISHEDITEMS;
+    pdsConfig.name = UA_STRING(publishedDataSet1Name);
+    UA_StatusCode retVal =
+        UA_Server_addPublishedDataSet(server, &pdsConfig, &publishedDataSet1).addResult;
+    UA_DataSetFieldConfig dataSetFieldConfig;
+    memset(&dataSetFieldConfig, 0, sizeof(UA_DataSetFieldConfig));
+    dataSetFieldConfig.dataSetFieldType = UA_PUBSUB_DATASETFIELD_VARIABLE;
+    dataSetFieldConfig.field.variable.fieldNameAlias = UA_STRING("Server localtime");
+    dataSetFieldConfig.field.variable.publishParameters.publishedVariable =
+        UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_CURRENTTIME);
+    dataSetFieldConfig.field.variable.publishParameters.attributeId = UA_ATTRIBUTEID_VALUE;
+    retVal |= UA_Server_addDataSetField(server, publishedDataSet1,
+                                        &dataSetFieldConfig, NULL).result;
+
+    UA_WriterGroupConfig writerGroupConfig;
+    memset(&writerGroupConfig, 0, sizeof(writerGroupConfig));
+    writerGroupConfig.name = UA_STRING("WriterGroup");
+    writerGroupConfig.publishingInterval = 100;
+    writerGroupConfig.writerGroupId = 1;
+    writerGroupConfig.encodingMimeType = UA_PUBSUB_ENCODING_UADP;
+    retVal |= UA_Server_addWriterGroup(server, connection1, &writerGroupConfig,
+                                       &writerGroup1);
+    UA_DataSetWriterConfig dataSetWriterConfig;
+    memset(&dataSetWriterConfig, 0, sizeof(dataSetWriterConfig));
+    dataSetWriterConfig.name = UA_STRING("DataSetWriter");
+    retVal |= UA_Server_addDataSetWriter(server, writerGroup1, publishedDataSet1,
+                                         &dataSetWriterConfig, &dataSetWriter1);
+    retVal |= UA_Server_enableDataSetWriter(server, dataSetWriter1);
+    retVal |= UA_Server_enablePubSubConnection(server, connection1);
+    retVal |= UA_Server_enableWriterGroup(server, writerGroup1);
+    ck_assert_uint_eq(retVal, UA_STATUSCODE_GOOD);
+
+    UA_PubSubCycleStatistics stats;
+    retVal = UA_Server_getWriterGroupCycleStatistics(server, writerGroup1, &stats);
+    ck_assert_uint_eq(retVal, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(stats.cycleCount, 0);
+    ck_assert_uint_eq(stats.recentCyclesSize, 0);
+
+    /* Two cycles on time, then one cycle 250ms late */
+    UA_Server_WriterGroup_publish(server, writerGroup1);
+    UA_fakeSleep(100);
+    UA_Server_WriterGroup_publish(server, writerGroup1);
+    UA_fakeSleep(100);
+    UA_Server_WriterGroup_publish(server, writerGroup1);
+    UA_fakeSleep(350);
+    UA_Server_WriterGroup_publish(server, writerGroup1);
+
+    retVal = UA_Server_getWriterGroupCycleStatistics(server, writerGroup1, &stats);
+    ck_assert_uint_eq(retVal, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(stats.cycleCount, 4);
+    ck_assert_uint_eq(stats.overrunCount, 1);
+    ck_assert_uint_eq(stats.missedCycleCount, 3);
+    ck_assert(stats.stages[UA_PUBSUBSTAGE_JITTER].min == 0.0);
+    ck_assert(stats.stages[UA_PUBSUBSTAGE_JITTER].max == 250.0);
+    ck_assert(stats.stages[UA_PUBSUBSTAGE_JITTER].mean > 83.0);
+    ck_assert(stats.stages[UA_PUBSUBSTAGE_JITTER].mean < 84.0);
+    ck_assert_uint_eq(stats.recentCyclesSize, 4);
+    ck_assert_int_eq(stats.recentCycles[3] - stats.recentCycles[0],
+                     550 * UA_DATETIME_MSEC);
+
+    /* The reset keeps the last cycle for the jitter */
+    retVal = UA_Server_resetPubSubCycleStatistics(server, writerGroup1);
+    ck_assert_uint_eq(retVal, UA_STATUSCODE_GOOD);
+    UA_fakeSleep(100);
+    UA_Server_WriterGroup_publish(server, writerGroup1);
+    retVal = UA_Server_getWriterGroupCycleStatistics(server, writerGroup1, &stats);
+    ck_assert_uint_eq(retVal, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(stats.cycleCount, 1);
+    ck_assert_uint_eq(stats.overrunCount, 0);
+    ck_assert(stats.stages[UA_PUBSUBSTAGE_JITTER].max == 0.0);
+
+#ifdef UA_ENABLE_PUBSUB_INFORMATIONMODEL
+    /* The statistics are exposed in the information model */
+    UA_QualifiedName name = UA_QUALIFIEDNAME(1, "CycleStatistics");
+    UA_BrowsePathResult bpr =
+        UA_Server_browseSimplifiedBrowsePath(server, writerGroup1, 1, &name);
+    ck_assert_uint_eq(bpr.statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(bpr.targetsSize, 1);
+    UA_Variant value;
+    retVal = UA_Server_readValue(server, bpr.targets[0].targetId.nodeId, &value);
+    ck_assert_uint_eq(retVal, UA_STATUSCODE_GOOD);
+    ck_assert(value.type == &UA_TYPES[UA_TYPES_KEYVALUEPAIR]);
+    ck_assert_uint_eq(value.arrayLength, 3 + 4 * UA_PUBSUBSTAGES);
+    UA_KeyValuePair *kv = (UA_KeyValuePair*)value.data;
+    UA_String cycleCount = UA_STRING("CycleCount");
+    ck_assert(UA_String_equal(&kv[0].key.name, &cycleCount));
+    ck_assert_uint_eq(*(UA_UInt64*)kv[0].value.data, 1);
+    UA_Variant_clear(&value);
+    UA_BrowsePathResult_clear(&bpr);
+#endif
+} END_TEST
+
 int main(void) {
     TCase *tc_add_pubsub_writergroup = tcase_create("PubSub WriterGroup items handling");
     tcase_add_checked_fixture(tc_add_pubsub_writergroup, setup, teardown);
@@ -543,6 +863,7 @@ int main(void) {
     tcase_add_test(tc_add_pubsub_writergroup, AddWriterGroupWithNullConfig);
     tcase_add_test(tc_add_pubsub_writergroup, AddWriterGroupWithInvalidConnectionId);
     tcase_add_test(tc_add_pubsub_writergroup, GetWriterGroupConfigurationAndCompareValues);
+    tcase_add_test(tc_add_pubsub_writergroup, AddWriterGroupWithTransmitTimeOffset);
 
     TCase *tc_add_pubsub_datasetwriter = tcase_create("PubSub DataSetWriter items handling");
     tcase_add_checked_fixture(tc_add_pubsub_datasetwriter, setup, teardown);
@@ -567,6 +888,9 @@ int main(void) {
     tcase_add_checked_fixture(tc_pubsub_publish, setup, teardown);
     tcase_add_test(tc_pubsub_publish, SinglePublishDataSetFieldAndPublishTimestampTest);
     tcase_add_test(tc_pubsub_publish, PublishDataSetFieldAsDeltaFrame);
+    tcase_add_test(tc_pubsub_publish, GenerateDeltaFramesWithChangedFieldsOnly);
+    tcase_add_test(tc_pubsub_publish, BatchSendOfWriterGroupsInOneIteration);
+    tcase_add_test(tc_pubsub_publish, WriterGroupCycleStatistics);
 
     Suite *s = suite_create("PubSub WriterGroups/Writer/Fields handling and publishing");
     suite_add_tcase(s, tc_add_pubsub_writergroup);
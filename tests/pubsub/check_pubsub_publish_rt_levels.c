@@ -425,6 +425,53 @@ externalDataWriteCallback(UA_Server *s, const UA_NodeId *sessionId,
     return UA_STATUSCODE_GOOD;
 }
 
+START_TEST(PublishInformationModelFieldWithoutExternalSource) {
+        ck_assert(addMinimalPubSubConfiguration() == UA_STATUSCODE_GOOD);
+        UA_WriterGroupConfig writerGroupConfig;
+        memset(&writerGroupConfig, 0, sizeof(UA_WriterGroupConfig));
+        writerGroupConfig.name = UA_STRING("Demo WriterGroup");
+        writerGroupConfig.publishingInterval = PUBLISH_INTERVAL;
+        writerGroupConfig.writerGroupId = 100;
+        writerGroupConfig.encodingMimeType = UA_PUBSUB_ENCODING_UADP;
+        writerGroupConfig.rtLevel = UA_PUBSUB_RT_FIXED_SIZE;
+        UA_UadpWriterGroupMessageDataType *wgm = UA_UadpWriterGroupMessageDataType_new();
+        wgm->networkMessageContentMask = UA_UADPNETWORKMESSAGECONTENTMASK_PAYLOADHEADER;
+        writerGroupConfig.messageSettings.content.decoded.data = wgm;
+        writerGroupConfig.messageSettings.content.decoded.type =
+            &UA_TYPES[UA_TYPES_UADPWRITERGROUPMESSAGEDATATYPE];
+        writerGroupConfig.messageSettings.encoding = UA_EXTENSIONOBJECT_DECODED;
+        ck_assert(UA_Server_addWriterGroup(server, connectionIdentifier, &writerGroupConfig, &writerGroupIdent) == UA_STATUSCODE_GOOD);
+        UA_UadpWriterGroupMessageDataType_delete(wgm);
+
+        /* The variable keeps its value in the node. There is no external value
+         * source for the fixed offsets. */
+        UA_VariableAttributes attr = UA_VariableAttributes_default;
+        UA_UInt32 myInteger = 42;
+        UA_Variant_setScalar(&attr.value, &myInteger, &UA_TYPES[UA_TYPES_UINT32]);
+        attr.dataType = UA_TYPES[UA_TYPES_UINT32].typeId;
+        ck_assert_int_eq(UA_Server_addVariableNode(server, UA_NODEID_NULL,
+                                                   UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                                   UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                                   UA_QUALIFIEDNAME(1, "test node"),
+                                                   UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                                   attr, NULL, &variableNodeId), UA_STATUSCODE_GOOD);
+        UA_DataSetFieldConfig dsfConfig;
+        memset(&dsfConfig, 0, sizeof(UA_DataSetFieldConfig));
+        dsfConfig.field.variable.publishParameters.publishedVariable = variableNodeId;
+        dsfConfig.field.variable.publishParameters.attributeId = UA_ATTRIBUTEID_VALUE;
+        dsfConfig.field.variable.rtValueSource.rtInformationModelNode = UA_TRUE;
+        ck_assert(UA_Server_addDataSetField(server, publishedDataSetIdent, &dsfConfig, &dataSetFieldIdent).result == UA_STATUSCODE_GOOD);
+
+        UA_DataSetWriterConfig dataSetWriterConfig;
+        memset(&dataSetWriterConfig, 0, sizeof(UA_DataSetWriterConfig));
+        dataSetWriterConfig.name = UA_STRING("Test DataSetWriter");
+        dataSetWriterConfig.dataSetWriterId = 62541;
+        ck_assert(UA_Server_addDataSetWriter(server, writerGroupIdent, publishedDataSetIdent, &dataSetWriterConfig, &dataSetWriterIdent) == UA_STATUSCODE_GOOD);
+
+        /* The value source is resolved when the WriterGroup is frozen */
+        ck_assert(UA_Server_enableWriterGroup(server, writerGroupIdent) != UA_STATUSCODE_GOOD);
+} END_TEST
+
 START_TEST(PubSubConfigWithInformationModelRTVariable) {
         ck_assert(addMinimalPubSubConfiguration() == UA_STATUSCODE_GOOD);
         //add a new variable to the information model
@@ -560,6 +607,148 @@ START_TEST(PubSubConfigWithMultipleInformationModelRTVariables) {
         }
     } END_TEST
 
+static UA_NodeId
+addRTField(UA_NodeId pds, UA_DataValue **source) {
+    UA_DataSetFieldConfig dsfConfig;
+    memset(&dsfConfig, 0, sizeof(UA_DataSetFieldConfig));
+    dsfConfig.field.variable.rtValueSource.rtFieldSourceEnabled = true;
+    dsfConfig.field.variable.rtValueSource.staticValueSource = source;
+    dsfConfig.field.variable.publishParameters.attributeId = UA_ATTRIBUTEID_VALUE;
+    UA_NodeId fieldId;
+    UA_DataSetFieldResult res = UA_Server_addDataSetField(server, pds, &dsfConfig, &fieldId);
+    ck_assert_uint_eq(res.result, UA_STATUSCODE_GOOD);
+    return fieldId;
+}
+
+/* Copy of the buffered message with the sequence numbers set to zero */
+static UA_ByteString
+bufferedMessageCopy(void) {
+    UA_LOCK(&server->serviceMutex);
+    UA_WriterGroup *wg = UA_WriterGroup_find(getPSM(server), writerGroupIdent);
+    ck_assert(wg != NULL);
+    UA_NetworkMessageOffsetBuffer *nmob = &wg->bufferedMessage;
+    UA_ByteString copy;
+    UA_ByteString_copy(&nmob->buffer, &copy);
+    for(size_t i = 0; i < nmob->offsetsSize; i++) {
+        ck_assert_uint_lt(nmob->offsets[i].offset, copy.length);
+        if(nmob->offsets[i].contentType == UA_PUBSUB_OFFSETTYPE_DATASETMESSAGE_SEQUENCENUMBER ||
+           nmob->offsets[i].contentType == UA_PUBSUB_OFFSETTYPE_NETWORKMESSAGE_SEQUENCENUMBER)
+            memset(&copy.data[nmob->offsets[i].offset], 0, 2);
+    }
+    UA_UNLOCK(&server->serviceMutex);
+    return copy;
+}
+
+/* The incrementally updated offset table matches a full freeze */
+static void
+checkAgainstRefreeze(void) {
+    UA_ByteString incremental = bufferedMessageCopy();
+    ck_assert_uint_eq(UA_Server_disableWriterGroup(server, writerGroupIdent), UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(UA_Server_enableWriterGroup(server, writerGroupIdent), UA_STATUSCODE_GOOD);
+    UA_ByteString full = bufferedMessageCopy();
+    ck_assert(UA_ByteString_equal(&incremental, &full));
+    UA_ByteString_clear(&incremental);
+    UA_ByteString_clear(&full);
+}
+
+START_TEST(ChangeFieldsOfFrozenRTWriterGroup) {
+    ck_assert(addMinimalPubSubConfiguration() == UA_STATUSCODE_GOOD);
+    UA_WriterGroupConfig writerGroupConfig;
+    memset(&writerGroupConfig, 0, sizeof(UA_WriterGroupConfig));
+    writerGroupConfig.name = UA_STRING("Demo WriterGroup");
+    writerGroupConfig.publishingInterval = PUBLISH_INTERVAL;
+    writerGroupConfig.writerGroupId = 100;
+    writerGroupConfig.encodingMimeType = UA_PUBSUB_ENCODING_UADP;
+    writerGroupConfig.rtLevel = UA_PUBSUB_RT_FIXED_SIZE;
+    UA_UadpWriterGroupMessageDataType *wgm = UA_UadpWriterGroupMessageDataType_new();
+    wgm->networkMessageContentMask = (UA_UadpNetworkMessageContentMask)
+        (UA_UADPNETWORKMESSAGECONTENTMASK_PAYLOADHEADER |
+         UA_UADPNETWORKMESSAGECONTENTMASK_GROUPHEADER |
+         UA_UADPNETWORKMESSAGECONTENTMASK_SEQUENCENUMBER);
+    writerGroupConfig.messageSettings.content.decoded.data = wgm;
+    writerGroupConfig.messageSettings.content.decoded.type =
+        &UA_TYPES[UA_TYPES_UADPWRITERGROUPMESSAGEDATATYPE];
+    writerGroupConfig.messageSettings.encoding = UA_EXTENSIONOBJECT_DECODED;
+    ck_assert(UA_Server_addWriterGroup(server, connectionIdentifier, &writerGroupConfig,
+                                       &writerGroupIdent) == UA_STATUSCODE_GOOD);
+    UA_UadpWriterGroupMessageDataType_delete(wgm);
+
+    /* A second PublishedDataSet for the DataSetMessage after the changed one */
+    UA_PublishedDataSetConfig pdsConfig;
+    memset(&pdsConfig, 0, sizeof(UA_PublishedDataSetConfig));
+    pdsConfig.publishedDataSetType = UA_PUBSUB_DATASET_PUBLISHEDITEMS;
+    pdsConfig.name = UA_STRING("Second PDS");
+    UA_NodeId pds2;
+    ck_assert_uint_eq(UA_Server_addPublishedDataSet(server, &pdsConfig, &pds2).addResult,
+                      UA_STATUSCODE_GOOD);
+
+    staticSource1 = UA_DataValue_new();
+    UA_UInt32 intValue = 1000;
+    UA_Variant_setScalarCopy(&staticSource1->value, &intValue, &UA_TYPES[UA_TYPES_UINT32]);
+    staticSource2 = UA_DataValue_new();
+    UA_Double doubleValue = 2.0;
+    UA_Variant_setScalarCopy(&staticSource2->value, &doubleValue, &UA_TYPES[UA_TYPES_DOUBLE]);
+    addRTField(publishedDataSetIdent, &staticSource1);
+    addRTField(pds2, &staticSource1);
+
+    UA_DataSetWriterConfig dataSetWriterConfig;
+    memset(&dataSetWriterConfig, 0, sizeof(UA_DataSetWriterConfig));
+    dataSetWriterConfig.name = UA_STRING("Test DataSetWriter");
+    UA_UadpDataSetWriterMessageDataType *dswm = UA_UadpDataSetWriterMessageDataType_new();
+    dswm->dataSetMessageContentMask = UA_UADPDATASETMESSAGECONTENTMASK_SEQUENCENUMBER;
+    dataSetWriterConfig.messageSettings.content.decoded.data = dswm;
+    dataSetWriterConfig.messageSettings.content.decoded.type =
+        &UA_TYPES[UA_TYPES_UADPDATASETWRITERMESSAGEDATATYPE];
+    dataSetWriterConfig.messageSettings.encoding = UA_EXTENSIONOBJECT_DECODED;
+    dataSetWriterConfig.dataSetWriterId = 1;
+    ck_assert(UA_Server_addDataSetWriter(server, writerGroupIdent, publishedDataSetIdent,
+                                         &dataSetWriterConfig, &dataSetWriterIdent) == UA_STATUSCODE_GOOD);
+    dataSetWriterConfig.dataSetWriterId = 2;
+    UA_NodeId dsw2;
+    ck_assert(UA_Server_addDataSetWriter(server, writerGroupIdent, pds2,
+                                         &dataSetWriterConfig, &dsw2) == UA_STATUSCODE_GOOD);
+    UA_UadpDataSetWriterMessageDataType_delete(dswm);
+    ck_assert(UA_Server_enableWriterGroup(server, writerGroupIdent) == UA_STATUSCODE_GOOD);
+    ck_assert(UA_Server_enableDataSetWriter(server, dataSetWriterIdent) == UA_STATUSCODE_GOOD);
+    ck_assert(UA_Server_enableDataSetWriter(server, dsw2) == UA_STATUSCODE_GOOD);
+    UA_ByteString initial = bufferedMessageCopy();
+
+    /* Add a field to the first DataSetMessage while the WriterGroup is frozen */
+    UA_NodeId fieldId = addRTField(publishedDataSetIdent, &staticSource2);
+    UA_ByteString added = bufferedMessageCopy();
+    ck_assert_uint_eq(added.length, initial.length + 9); /* Double in a Variant */
+    UA_ByteString_clear(&added);
+    checkAgainstRefreeze();
+
+    /* Publish with the new offset table */
+    UA_fakeSleep(PUBLISH_INTERVAL + 1);
+    UA_Server_run_iterate(server, false);
+
+    /* A field without an external value source is rolled back */
+    UA_DataSetFieldConfig dsfConfig;
+    memset(&dsfConfig, 0, sizeof(UA_DataSetFieldConfig));
+    dsfConfig.field.variable.rtValueSource.rtFieldSourceEnabled = true;
+    dsfConfig.field.variable.rtValueSource.rtInformationModelNode = true;
+    dsfConfig.field.variable.publishParameters.publishedVariable =
+        UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_CURRENTTIME);
+    dsfConfig.field.variable.publishParameters.attributeId = UA_ATTRIBUTEID_VALUE;
+    ck_assert_uint_ne(UA_Server_addDataSetField(server, publishedDataSetIdent,
+                                                &dsfConfig, NULL).result, UA_STATUSCODE_GOOD);
+    UA_DataSetMetaDataType metaData;
+    ck_assert_uint_eq(UA_Server_getPublishedDataSetMetaData(server, publishedDataSetIdent,
+                                                            &metaData), UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(metaData.fieldsSize, 2);
+    UA_DataSetMetaDataType_clear(&metaData);
+
+    /* Remove the field again */
+    ck_assert_uint_eq(UA_Server_removeDataSetField(server, fieldId).result, UA_STATUSCODE_GOOD);
+    UA_ByteString removed = bufferedMessageCopy();
+    ck_assert(UA_ByteString_equal(&removed, &initial));
+    UA_ByteString_clear(&removed);
+    UA_ByteString_clear(&initial);
+    checkAgainstRefreeze();
+} END_TEST
+
 int main(void) {
     TCase *tc_pubsub_rt_static_value_source = tcase_create("PubSub RT publish with static value sources");
     tcase_add_checked_fixture(tc_pubsub_rt_static_value_source, setup, teardown);
@@ -574,6 +763,8 @@ int main(void) {
     tcase_add_test(tc_pubsub_rt_fixed_offsets, PublishSingleFieldWithFixedOffsets);
     tcase_add_test(tc_pubsub_rt_fixed_offsets, PublishPDSWithMultipleFieldsAndFixedOffset);
     tcase_add_test(tc_pubsub_rt_fixed_offsets, PublishSingleFieldInCustomCallback);
+    tcase_add_test(tc_pubsub_rt_fixed_offsets, PublishInformationModelFieldWithoutExternalSource);
+    tcase_add_test(tc_pubsub_rt_fixed_offsets, ChangeFieldsOfFrozenRTWriterGroup);
 
     Suite *s = suite_create("PubSub RT configuration levels");
     suite_add_tcase(s, tc_pubsub_rt_static_value_source);
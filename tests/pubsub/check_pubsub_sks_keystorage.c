@@ -286,6 +286,18 @@ START_TEST(TestPubSubKeyStorage_MovetoNextKeyCallback){
     UA_LOCK(&server->serviceMutex);
     ck_assert_ptr_ne(tKeyStorage, NULL);
     UA_PubSubKeyListItem *nextCurrentKey = TAILQ_NEXT(tKeyStorage->currentItem, keyListEntry);
+
+    /* The context for the next key is prepared ahead of the rollover */
+    UA_PubSubManager *psm = getPSM(server);
+    UA_WriterGroup *wg = UA_WriterGroup_find(psm, writerGroup);
+    UA_ReaderGroup *rg = UA_ReaderGroup_find(psm, readerGroup);
+    ck_assert_uint_eq(wg->nextSecurityTokenId, nextCurrentKey->keyID);
+    ck_assert_uint_eq(rg->nextSecurityTokenId, nextCurrentKey->keyID);
+    void *wgNextContext = wg->nextSecurityPolicyContext;
+    void *rgNextContext = rg->nextSecurityPolicyContext;
+    ck_assert_ptr_ne(wgNextContext, NULL);
+    ck_assert_ptr_ne(rgNextContext, NULL);
+
     UA_fakeSleep(2000);
     UA_UNLOCK(&server->serviceMutex);
 
@@ -294,11 +306,15 @@ START_TEST(TestPubSubKeyStorage_MovetoNextKeyCallback){
     ck_assert_msg(UA_ByteString_equal(&nextCurrentKey->key, &tKeyStorage->currentItem->key), "Expected Current key to be the First Future key after first TimeToNextKey expires");
     /*securityTokenId must be updated after KeyLifeTime elapses*/
     ck_assert_uint_eq(nextCurrentKey->keyID, tKeyStorage->currentTokenId);
-    UA_PubSubManager *psm = getPSM(server);
-    UA_WriterGroup *wg = UA_WriterGroup_find(psm, writerGroup);
     ck_assert_uint_eq(wg->securityTokenId, nextCurrentKey->keyID);
-    UA_ReaderGroup *rg = UA_ReaderGroup_find(psm, readerGroup);
     ck_assert_uint_eq(rg->securityTokenId, nextCurrentKey->keyID);
+
+    /* The prepared contexts were swapped in. The following key is prepared. */
+    ck_assert_ptr_eq(wg->securityPolicyContext, wgNextContext);
+    ck_assert_ptr_eq(rg->securityPolicyContext, rgNextContext);
+    UA_PubSubKeyListItem *followingKey = TAILQ_NEXT(nextCurrentKey, keyListEntry);
+    ck_assert_uint_eq(wg->nextSecurityTokenId, followingKey->keyID);
+    ck_assert_uint_eq(rg->nextSecurityTokenId, followingKey->keyID);
 } END_TEST
 
 START_TEST(TestPubSubKeystorage_ImportedKey){
@@ -854,6 +854,15 @@ START_TEST(SinglePublishSubscribeInt32) {
         UA_fakeSleep(PUBLISH_INTERVAL + 1);
         UA_Server_run_iterate(server,true);
         checkReceived();
+
+        /* The received messages are counted as ReaderGroup cycles */
+        UA_PubSubCycleStatistics stats;
+        retVal = UA_Server_getReaderGroupCycleStatistics(server, readerGroupId, &stats);
+        ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+        ck_assert_uint_ge(stats.cycleCount, 1);
+        ck_assert_uint_eq(stats.recentCyclesSize,
+                          (stats.cycleCount < UA_PUBSUB_CYCLEHISTORY) ?
+                          stats.cycleCount : UA_PUBSUB_CYCLEHISTORY);
 } END_TEST
 
 START_TEST(SinglePublishSubscribeInt32StatusCode) {
@@ -1854,11 +1863,30 @@ START_TEST(MultiPublishSubscribeInt32) {
 
     ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
     UA_FieldTargetDataType_clear(&targetVar.targetVariable);
+
+    /* Add readers for other DataSetWriters. They must not receive the
+     * messages. */
+    UA_NodeId otherReaderId;
+    for(UA_UInt16 i = 0; i < 100; i++) {
+        readerConfig.dataSetWriterId = (UA_UInt16)(DATASET_WRITER_ID + 1 + i);
+        retVal = UA_Server_addDataSetReader(server, readerGroupId, &readerConfig,
+                                            &otherReaderId);
+        ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+        UA_NodeId_clear(&otherReaderId);
+    }
+    readerConfig.dataSetWriterId = DATASET_WRITER_ID;
     UA_free(pMetaData->fields);
 
     /* run server - publisher and subscriber */
     ck_assert_int_eq(UA_STATUSCODE_GOOD, UA_Server_enableAllPubSubComponents(server));
 
+    /* The readers are indexed when the ReaderGroup is frozen */
+    UA_ReaderGroup *rg = UA_ReaderGroup_find(getPSM(server), readerGroupId);
+    ck_assert(rg != NULL);
+    ck_assert(rg->readerIndex != NULL);
+    ck_assert_uint_eq(rg->readerIndexCount, 102);
+    ck_assert_uint_ge(rg->readerIndexSize, 102);
+
     /* run server - publisher and subscriber */
     UA_fakeSleep(50 + 1);
     UA_Server_run_iterate(server,true);
@@ -1886,6 +1914,11 @@ START_TEST(MultiPublishSubscribeInt32) {
                      *(UA_UInt32 *)subscribedNodeData.data);
     UA_Variant_clear(&subscribedNodeData);
     UA_Variant_clear(&publishedNodeData);
+
+    /* Removing a reader from the enabled ReaderGroup updates the index */
+    ck_assert_int_eq(UA_STATUSCODE_GOOD,
+                     UA_Server_removeDataSetReader(server, reader2Id));
+    ck_assert_uint_eq(rg->readerIndexCount, 101);
 } END_TEST
 
 static void
@@ -470,11 +470,12 @@ static UA_DataValue *subscriberIndirectDataValues[NUMVARS];
 static void PublishSubscribeWithWriteCallback_Helper(
     UA_NodeId *publisherNode,
     UA_UInt32 **publisherData,
-    UA_Boolean useRawEncoding) {
+    UA_Boolean useRawEncoding,
+    UA_PubSubRTLevel readerRtLevel) {
 
     /* test fast-path with subscriber write callback */
-    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND, "PublishSubscribeWithWriteCallback_Helper(): useRawEncoding = %s",
-        (useRawEncoding == UA_TRUE) ? "true" : "false");
+    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND, "PublishSubscribeWithWriteCallback_Helper(): useRawEncoding = %s, readerRtLevel = %d",
+        (useRawEncoding == UA_TRUE) ? "true" : "false", (int)readerRtLevel);
 
     /* configure the connection */
     int i;
@@ -536,7 +537,7 @@ static void PublishSubscribeWithWriteCallback_Helper(
     UA_ReaderGroupConfig readerGroupConfig;
     memset (&readerGroupConfig, 0, sizeof (UA_ReaderGroupConfig));
     readerGroupConfig.name = UA_STRING ("ReaderGroup Test");
-    readerGroupConfig.rtLevel = UA_PUBSUB_RT_DETERMINISTIC;
+    readerGroupConfig.rtLevel = readerRtLevel;
     retVal |= UA_Server_addReaderGroup(server, connectionIdentifier, &readerGroupConfig, &readerGroupIdentifier);
 
     /* Data Set Reader */
@@ -643,6 +644,15 @@ static void PublishSubscribeWithWriteCallback_Helper(
         ck_assert_uint_eq(*(publisherData[i]), sSubscriberWriteValue[i]);
     }
 
+    /* The fixed-size reader copies the values directly into the external
+     * data values */
+    if(readerRtLevel == UA_PUBSUB_RT_FIXED_SIZE) {
+        UA_DataSetReader *dsr = UA_DataSetReader_find(psm, readerIdentifier);
+        ck_assert(dsr != NULL);
+        ck_assert_ptr_ne(dsr->directFields, NULL);
+        ck_assert_uint_eq(dsr->directFieldsSize, NUMVARS);
+    }
+
     ck_assert_int_eq(UA_STATUSCODE_GOOD, UA_Server_setWriterGroupDisabled(server, writerGroupIdent));
     ck_assert_int_eq(UA_STATUSCODE_GOOD, UA_Server_setReaderGroupDisabled(server, readerGroupIdentifier));
 
@@ -753,8 +763,14 @@ START_TEST(PublishSubscribeWithWriteCallback) {
         ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
     }
 
-    PublishSubscribeWithWriteCallback_Helper(publisherNode, publisherData, UA_FALSE);
-    PublishSubscribeWithWriteCallback_Helper(publisherNode, publisherData, UA_TRUE);
+    PublishSubscribeWithWriteCallback_Helper(publisherNode, publisherData, UA_FALSE,
+                                             UA_PUBSUB_RT_DETERMINISTIC);
+    PublishSubscribeWithWriteCallback_Helper(publisherNode, publisherData, UA_TRUE,
+                                             UA_PUBSUB_RT_DETERMINISTIC);
+    PublishSubscribeWithWriteCallback_Helper(publisherNode, publisherData, UA_FALSE,
+                                             UA_PUBSUB_RT_FIXED_SIZE);
+    PublishSubscribeWithWriteCallback_Helper(publisherNode, publisherData, UA_TRUE,
+                                             UA_PUBSUB_RT_FIXED_SIZE);
 
     /* cleanup */
     for (i = 0; i < NUMVARS; i++) {
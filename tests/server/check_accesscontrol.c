@@ -4,6 +4,7 @@
 
 #include <open62541/client.h>
 #include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
 #include <open62541/server.h>
 #include <open62541/server_config_default.h>
 #include <open62541/plugin/accesscontrol_default.h>
@@ -45,6 +46,37 @@ static void setup(void) {
     THREAD_CREATE(server_thread, serverloop);
 }
 
+static size_t accessLevelCalls;
+static UA_Byte (*defaultGetUserAccessLevel)(UA_Server *server, UA_AccessControl *ac,
+                                            const UA_NodeId *sessionId,
+                                            void *sessionContext,
+                                            const UA_NodeId *nodeId,
+                                            void *nodeContext);
+
+static UA_Byte
+countingGetUserAccessLevel(UA_Server *s, UA_AccessControl *ac,
+                           const UA_NodeId *sessionId, void *sessionContext,
+                           const UA_NodeId *nodeId, void *nodeContext) {
+    accessLevelCalls++;
+    return defaultGetUserAccessLevel(s, ac, sessionId, sessionContext,
+                                     nodeId, nodeContext);
+}
+
+static void setupDecisionCache(void) {
+    running = true;
+    server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    defaultGetUserAccessLevel = config->accessControl.getUserAccessLevel;
+    config->accessControl.getUserAccessLevel = countingGetUserAccessLevel;
+    config->accessControl.decisionCacheSize = 64;
+    accessLevelCalls = 0;
+
+    UA_Server_run_startup(server);
+    THREAD_CREATE(server_thread, serverloop);
+}
+
 static void teardown(void) {
     running = false;
     THREAD_JOIN(server_thread);
@@ -89,6 +121,146 @@ START_TEST(Client_pass_fail) {
     UA_Client_delete(client);
 } END_TEST
 
+/* The decision of the AccessControl plugin is only requested once for the
+ * node until the epoch changes */
+START_TEST(Client_decisionCache) {
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_NodeId nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_STATE);
+    for(size_t i = 0; i < 10; i++) {
+        UA_Variant value;
+        retval = UA_Client_readValueAttribute(client, nodeId, &value);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        UA_Variant_clear(&value);
+    }
+    ck_assert_uint_eq(accessLevelCalls, 1);
+
+    UA_Server_getConfig(server)->accessControl.decisionEpoch++;
+    UA_Variant value;
+    retval = UA_Client_readValueAttribute(client, nodeId, &value);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_Variant_clear(&value);
+    ck_assert_uint_eq(accessLevelCalls, 2);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+} END_TEST
+
+#define ROLE_OBSERVER 0x01
+#define ROLE_OPERATOR 0x02
+
+static UA_UInt64 sessionRoles;
+
+static UA_UInt64
+getTestSessionRoles(UA_Server *s, UA_AccessControl *ac,
+                    const UA_NodeId *sessionId, void *sessionContext) {
+    return sessionRoles;
+}
+
+static void
+addRoleNode(UA_UInt32 id, const char *name, const UA_NodeRoleMasks *masks) {
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    UA_Int32 zero = 0;
+    UA_Variant_setScalar(&attr.value, &zero, &UA_TYPES[UA_TYPES_INT32]);
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+    UA_StatusCode res =
+        UA_Server_addVariableNode(server, UA_NODEID_NUMERIC(1, id),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, (char*)(uintptr_t)name),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                  attr, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    res = UA_Server_setNodeRoleMasks(server, UA_NODEID_NUMERIC(1, id), masks);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+}
+
+static void setupRoles(void) {
+    running = true;
+    server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    config->accessControl.getSessionRoles = getTestSessionRoles;
+
+    UA_NodeRoleMasks operated = {ROLE_OBSERVER | ROLE_OPERATOR, ROLE_OPERATOR,
+                                 ROLE_OPERATOR, 0};
+    addRoleNode(4000, "Operated", &operated);
+    UA_NodeRoleMasks hidden = {ROLE_OPERATOR, ROLE_OPERATOR, ROLE_OPERATOR, 0};
+    addRoleNode(4001, "Hidden", &hidden);
+
+    UA_Server_run_startup(server);
+    THREAD_CREATE(server_thread, serverloop);
+}
+
+static UA_Boolean
+browseObjectsFor(UA_Client *client, UA_UInt32 id) {
+    UA_BrowseRequest bReq;
+    UA_BrowseRequest_init(&bReq);
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    bd.resultMask = UA_BROWSERESULTMASK_ALL;
+    bReq.nodesToBrowse = &bd;
+    bReq.nodesToBrowseSize = 1;
+    UA_BrowseResponse bResp = UA_Client_Service_browse(client, bReq);
+    ck_assert_uint_eq(bResp.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(bResp.resultsSize, 1);
+    UA_Boolean found = false;
+    UA_NodeId target = UA_NODEID_NUMERIC(1, id);
+    for(size_t i = 0; i < bResp.results[0].referencesSize; i++) {
+        if(UA_NodeId_equal(&bResp.results[0].references[i].nodeId.nodeId, &target))
+            found = true;
+    }
+    UA_BrowseResponse_clear(&bResp);
+    return found;
+}
+
+/* The role masks of a node are evaluated against the roles of the session */
+START_TEST(Client_roleMasks) {
+    UA_NodeId operated = UA_NODEID_NUMERIC(1, 4000);
+    UA_Int32 one = 1;
+    UA_Variant v;
+    UA_Variant_setScalar(&v, &one, &UA_TYPES[UA_TYPES_INT32]);
+
+    /* Observer: can browse the node but not read or write its value */
+    sessionRoles = ROLE_OBSERVER;
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_Variant value;
+    retval = UA_Client_readValueAttribute(client, operated, &value);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADUSERACCESSDENIED);
+    retval = UA_Client_writeValueAttribute(client, operated, &v);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADUSERACCESSDENIED);
+    ck_assert(browseObjectsFor(client, 4000));
+    ck_assert(!browseObjectsFor(client, 4001));
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+
+    /* Operator: full access */
+    sessionRoles = ROLE_OPERATOR;
+    client = UA_Client_newForUnitTest();
+    retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    retval = UA_Client_writeValueAttribute(client, operated, &v);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    retval = UA_Client_readValueAttribute(client, operated, &value);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(*(UA_Int32*)value.data, 1);
+    UA_Variant_clear(&value);
+    ck_assert(browseObjectsFor(client, 4000));
+    ck_assert(browseObjectsFor(client, 4001));
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+
+    /* The server itself is not restricted */
+    retval = UA_Server_readValue(server, UA_NODEID_NUMERIC(1, 4001), &value);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_Variant_clear(&value);
+} END_TEST
 
 static Suite* testSuite_Client(void) {
     Suite *s = suite_create("Client");
@@ -99,6 +271,16 @@ static Suite* testSuite_Client(void) {
     tcase_add_test(tc_client_user, Client_user_fail);
     tcase_add_test(tc_client_user, Client_pass_fail);
     suite_add_tcase(s,tc_client_user);
+
+    TCase *tc_decision_cache = tcase_create("Decision Cache");
+    tcase_add_checked_fixture(tc_decision_cache, setupDecisionCache, teardown);
+    tcase_add_test(tc_decision_cache, Client_decisionCache);
+    suite_add_tcase(s,tc_decision_cache);
+
+    TCase *tc_roles = tcase_create("Role Masks");
+    tcase_add_checked_fixture(tc_roles, setupRoles, teardown);
+    tcase_add_test(tc_roles, Client_roleMasks);
+    suite_add_tcase(s,tc_roles);
     return s;
 }
 
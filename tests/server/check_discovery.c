@@ -8,6 +8,7 @@
 #include <open62541/plugin/certificategroup_default.h>
 
 #include "server/ua_server_internal.h"
+#include "server/ua_services.h"
 #include "../encryption/certificates.h"
 
 #include <fcntl.h>
@@ -621,6 +622,80 @@ START_TEST(Server_new_shutdown_delete) {
 }
 END_TEST
 
+#define MANY_SERVERS 500
+
+static UA_StatusCode
+registerDirect(UA_Server *server, size_t index, UA_Boolean isOnline) {
+    char uri[64];
+    snprintf(uri, sizeof(uri), "urn:open62541.test.server_%u", (unsigned)index);
+    UA_String discoveryUrl = UA_STRING("opc.tcp://localhost:4841");
+    UA_LocalizedText serverName = UA_LOCALIZEDTEXT("en", "Registered Server");
+    UA_RegisterServerRequest request;
+    UA_RegisterServerRequest_init(&request);
+    request.server.serverUri = UA_STRING(uri);
+    request.server.serverNames = &serverName;
+    request.server.serverNamesSize = 1;
+    request.server.serverType = UA_APPLICATIONTYPE_SERVER;
+    request.server.discoveryUrls = &discoveryUrl;
+    request.server.discoveryUrlsSize = 1;
+    request.server.isOnline = isOnline;
+    UA_RegisterServerResponse response;
+    UA_RegisterServerResponse_init(&response);
+    UA_LOCK(&server->serviceMutex);
+    Service_RegisterServer(server, &server->adminSession, &request, &response);
+    UA_UNLOCK(&server->serviceMutex);
+    UA_StatusCode res = response.responseHeader.serviceResult;
+    UA_RegisterServerResponse_clear(&response);
+    return res;
+}
+
+static size_t
+findDirect(UA_Server *server, const UA_String *serverUris, size_t serverUrisSize) {
+    UA_FindServersRequest request;
+    UA_FindServersRequest_init(&request);
+    request.serverUris = (UA_String*)(uintptr_t)serverUris;
+    request.serverUrisSize = serverUrisSize;
+    UA_FindServersResponse response;
+    UA_FindServersResponse_init(&response);
+    UA_LOCK(&server->serviceMutex);
+    Service_FindServers(server, &server->adminSession, &request, &response);
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    size_t found = response.serversSize;
+    UA_FindServersResponse_clear(&response);
+    return found;
+}
+
+/* The registered servers are looked up by their ServerUri. The response
+ * without filter is cached until the registrations change. */
+START_TEST(Server_registerMany) {
+    UA_Server *pServer = UA_Server_newForUnitTest();
+    configure_lds_server(pServer);
+
+    for(size_t i = 0; i < MANY_SERVERS; i++)
+        ck_assert_uint_eq(registerDirect(pServer, i, true), UA_STATUSCODE_GOOD);
+    /* Registering again updates the existing entry */
+    ck_assert_uint_eq(registerDirect(pServer, 7, true), UA_STATUSCODE_GOOD);
+
+    /* The LDS itself is part of the response */
+    ck_assert_uint_eq(findDirect(pServer, NULL, 0), MANY_SERVERS + 1);
+    ck_assert_uint_eq(findDirect(pServer, NULL, 0), MANY_SERVERS + 1);
+
+    UA_String uris[3] = {UA_STRING("urn:open62541.test.server_42"),
+                         UA_STRING("urn:open62541.test.server_unknown"),
+                         UA_STRING("urn:open62541.test.server_42")};
+    ck_assert_uint_eq(findDirect(pServer, uris, 3), 1);
+
+    /* Unregistering drops the cached response */
+    ck_assert_uint_eq(registerDirect(pServer, 42, false), UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(findDirect(pServer, NULL, 0), MANY_SERVERS);
+    ck_assert_uint_eq(findDirect(pServer, uris, 3), 0);
+    ck_assert_uint_eq(registerDirect(pServer, 42, false), UA_STATUSCODE_BADNOTHINGTODO);
+
+    UA_Server_delete(pServer);
+}
+END_TEST
+
 START_TEST(Server_registerUnregister) {
     registerServer();
     registerServer(); // register twice just for fun
@@ -689,6 +764,7 @@ static Suite* testSuite_Client(void) {
     TCase *tc_new_del = tcase_create("New Delete");
     tcase_add_test(tc_new_del, Server_new_delete);
     tcase_add_test(tc_new_del, Server_new_shutdown_delete);
+    tcase_add_test(tc_new_del, Server_registerMany);
     suite_add_tcase(s,tc_new_del);
 
     TCase *tc_register = tcase_create("RegisterServer");
@@ -117,6 +117,93 @@ START_TEST(Server_LocalMonitoredItem) {
         UA_Server_run_iterate(server, 1);
     }
     ck_assert_uint_eq(callbackCount, 11);
+
+    /* The released notifications are pooled for reuse */
+    UA_ServerStatistics stat = UA_Server_getStatistics(server);
+    ck_assert_uint_eq(stat.ns.notificationCount, 0);
+    ck_assert_uint_ge(stat.ns.notificationHighWaterMark, 1);
+    ck_assert_uint_eq(stat.ns.notificationPoolSize,
+                      stat.ns.notificationHighWaterMark);
+}
+END_TEST
+
+static void
+dataChangeCountCallback(UA_Server *thisServer, UA_UInt32 monitoredItemId,
+                        void *monitoredItemContext, const UA_NodeId *nodeId,
+                        void *nodeContext, UA_UInt32 attributeId,
+                        const UA_DataValue *value) {
+    callbackCount++;
+}
+
+/* More MonitoredItems than fit into one sampling batch */
+#define DEADBAND_ITEMS 150
+
+START_TEST(Server_LocalMonitoredItemDeadbandBatch) {
+    callbackCount = 0;
+
+    UA_DataChangeFilter filter;
+    UA_DataChangeFilter_init(&filter);
+    filter.trigger = UA_DATACHANGETRIGGER_STATUSVALUE;
+    filter.deadbandType = UA_DEADBANDTYPE_ABSOLUTE;
+    filter.deadbandValue = 2.0;
+
+    UA_Double value = 10.0;
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    UA_Variant_setScalar(&attr.value, &value, &UA_TYPES[UA_TYPES_DOUBLE]);
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+    for(UA_UInt32 i = 0; i < DEADBAND_ITEMS; i++) {
+        UA_NodeId id = UA_NODEID_NUMERIC(1, 50000 + i);
+        UA_StatusCode res =
+            UA_Server_addVariableNode(server, id, parentNodeId, parentReferenceNodeId,
+                                      UA_QUALIFIEDNAME(1, "deadband"),
+                                      UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                      attr, NULL, NULL);
+        ASSERT_STATUSCODE(res, UA_STATUSCODE_GOOD);
+
+        UA_MonitoredItemCreateRequest monitorRequest =
+            UA_MonitoredItemCreateRequest_default(id);
+        monitorRequest.requestedParameters.samplingInterval = (double)100;
+        monitorRequest.monitoringMode = UA_MONITORINGMODE_REPORTING;
+        UA_ExtensionObject_setValue(&monitorRequest.requestedParameters.filter,
+                                    &filter, &UA_TYPES[UA_TYPES_DATACHANGEFILTER]);
+        UA_MonitoredItemCreateResult result =
+            UA_Server_createDataChangeMonitoredItem(server, UA_TIMESTAMPSTORETURN_BOTH,
+                                                    monitorRequest, NULL,
+                                                    &dataChangeCountCallback);
+        ASSERT_STATUSCODE(result.statusCode, UA_STATUSCODE_GOOD);
+    }
+    UA_Server_run_iterate(server, false);
+    ck_assert_uint_eq(callbackCount, DEADBAND_ITEMS);
+
+    /* Changes within the deadband are not reported */
+    UA_Variant val;
+    UA_Variant_setScalar(&val, &value, &UA_TYPES[UA_TYPES_DOUBLE]);
+    value = 11.0;
+    for(UA_UInt32 i = 0; i < DEADBAND_ITEMS; i++)
+        UA_Server_writeValue(server, UA_NODEID_NUMERIC(1, 50000 + i), val);
+    UA_fakeSleep(100);
+    UA_Server_run_iterate(server, 1);
+    ck_assert_uint_eq(callbackCount, DEADBAND_ITEMS);
+
+    /* Changes outside the deadband are reported */
+    value = 15.0;
+    for(UA_UInt32 i = 0; i < DEADBAND_ITEMS; i += 2)
+        UA_Server_writeValue(server, UA_NODEID_NUMERIC(1, 50000 + i), val);
+    UA_fakeSleep(100);
+    UA_Server_run_iterate(server, 1);
+    ck_assert_uint_eq(callbackCount, DEADBAND_ITEMS + DEADBAND_ITEMS / 2);
+
+    /* The status is always reported */
+    UA_DataValue dv;
+    UA_DataValue_init(&dv);
+    dv.hasValue = true;
+    dv.value = val;
+    dv.hasStatus = true;
+    dv.status = UA_STATUSCODE_UNCERTAIN;
+    UA_Server_writeDataValue(server, UA_NODEID_NUMERIC(1, 50001), dv);
+    UA_fakeSleep(100);
+    UA_Server_run_iterate(server, 1);
+    ck_assert_uint_eq(callbackCount, DEADBAND_ITEMS + DEADBAND_ITEMS / 2 + 1);
 }
 END_TEST
 
@@ -191,7 +278,8 @@ static UA_DataType PointType = {
     false,                           /* .overlayable (depends on endianness and
                                          the absence of padding) */
     1,                               /* .membersSize */
-    members
+    members,                         /* .members */
+    4                                /* .binarySize */
 };
 
 UA_DataTypeArray customDataTypes = {NULL, 1, &PointType, UA_FALSE};
@@ -322,6 +410,44 @@ START_TEST(Server_LocalMonitoredItemIndexRangeOutOfBounds) {
 }
 END_TEST
 
+START_TEST(Server_LocalMonitoredItemHashedValue) {
+    callbackCount = 0;
+    expectedDataValueStatus = UA_STATUSCODE_GOOD;
+    UA_Server_getConfig(server)->monitoredItemHashThreshold = 8;
+
+    UA_MonitoredItemCreateRequest monitorRequest =
+        UA_MonitoredItemCreateRequest_default(outNodeId);
+    monitorRequest.requestedParameters.samplingInterval = (double)100;
+    monitorRequest.monitoringMode = UA_MONITORINGMODE_REPORTING;
+    UA_MonitoredItemCreateResult result = UA_Server_createDataChangeMonitoredItem(
+        server, UA_TIMESTAMPSTORETURN_BOTH, monitorRequest, NULL,
+        &dataChangeNotificationValidateStatusCallback);
+    ASSERT_STATUSCODE(result.statusCode, UA_STATUSCODE_GOOD);
+    UA_Server_run_iterate(server, false);
+    ck_assert_uint_eq(callbackCount, 1);
+
+    /* Writing the same value does not trigger */
+    UA_UInt32 myUint32Array[3] = {40, 41, 42};
+    UA_Variant val;
+    UA_Variant_setArray(&val, myUint32Array, 3, &UA_TYPES[UA_TYPES_UINT32]);
+    UA_Server_writeValue(server, outNodeId, val);
+    UA_fakeSleep(100);
+    UA_Server_run_iterate(server, 1);
+    ck_assert_uint_eq(callbackCount, 1);
+
+    /* A changed value triggers */
+    myUint32Array[2] = 43;
+    UA_Server_writeValue(server, outNodeId, val);
+    UA_fakeSleep(100);
+    UA_Server_run_iterate(server, 1);
+    ck_assert_uint_eq(callbackCount, 2);
+
+    UA_fakeSleep(100);
+    UA_Server_run_iterate(server, 1);
+    ck_assert_uint_eq(callbackCount, 2);
+}
+END_TEST
+
 static Suite * testSuite_Client(void) {
     Suite *s = suite_create("Local Monitored Item");
     TCase *tc_server = tcase_create("Local Monitored Item Basic");
@@ -329,12 +455,14 @@ static Suite * testSuite_Client(void) {
     tcase_add_test(tc_server, Server_LocalMonitoredItem);
     tcase_add_test(tc_server, Server_LocalMonitoredItem_dataSource);
     tcase_add_test(tc_server, Server_LocalMonitoredItem_CustomType);
+    tcase_add_test(tc_server, Server_LocalMonitoredItemDeadbandBatch);
     suite_add_tcase(s, tc_server);
 
     TCase *tc_server_indexrange = tcase_create("Local Monitored Item Index Range");
     tcase_add_checked_fixture(tc_server_indexrange, setupIndexRange, teardown);
     tcase_add_test(tc_server_indexrange, Server_LocalMonitoredItemIndexRange);
     tcase_add_test(tc_server_indexrange, Server_LocalMonitoredItemIndexRangeOutOfBounds);
+    tcase_add_test(tc_server_indexrange, Server_LocalMonitoredItemHashedValue);
     suite_add_tcase(s, tc_server_indexrange);
 
     return s;
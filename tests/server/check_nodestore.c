@@ -4,6 +4,8 @@
 
 #include <open62541/types.h>
 #include <open62541/util.h>
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
 #include <open62541/plugin/nodestore_default.h>
 #include "open62541/plugin/nodestore.h"
 #include "open62541/types_generated.h"
@@ -27,6 +29,10 @@ static void setupHashMap(void) {
     UA_Nodestore_HashMap(&ns);
 }
 
+static void setupConcurrentHashMap(void) {
+    UA_Nodestore_ConcurrentHashMap(&ns);
+}
+
 static void teardown(void) {
     ns.clear(ns.context);
 }
@@ -191,6 +197,187 @@ START_TEST(failToFindNonExistentNodeInUA_NodeStoreWithSeveralEntries) {
 }
 END_TEST
 
+START_TEST(compactKeepsNodesAccessible) {
+    for(UA_UInt32 i = 1; i <= 200; i++) {
+        UA_Node* n = createNode(0,i);
+        ns.insertNode(ns.context, n, NULL);
+    }
+
+    /* A node that is currently used is not moved */
+    UA_NodeId held = UA_NODEID_NUMERIC(0,10);
+    const UA_Node *nh = ns.getNode(ns.context, &held, ~(UA_UInt32)0,
+                                   UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    ns.compact(ns.context);
+    const UA_Node *nh2 = ns.getNode(ns.context, &held, ~(UA_UInt32)0,
+                                    UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    ck_assert_ptr_eq(nh, nh2);
+    ns.releaseNode(ns.context, nh);
+    ns.releaseNode(ns.context, nh2);
+
+    zeroCnt = 0;
+    visitCnt = 0;
+    ns.iterate(ns.context, checkZeroVisitor, NULL);
+    ck_assert_int_eq(zeroCnt, 0);
+    ck_assert_int_eq(visitCnt, 200);
+
+    /* Packed nodes can be found, edited and removed */
+    UA_NodeId in = UA_NODEID_NUMERIC(0,25);
+    UA_Node *ne = ns.getEditNode(ns.context, &in, ~(UA_UInt32)0,
+                                 UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    ck_assert_ptr_ne(ne, NULL);
+    ne->head.writeMask = 42;
+    ns.releaseNode(ns.context, ne);
+    const UA_Node *nr = ns.getNode(ns.context, &in, ~(UA_UInt32)0,
+                                   UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    ck_assert_uint_eq(nr->head.writeMask, 42);
+    ck_assert_int_eq(nr->head.nodeId.identifier.numeric, 25);
+    ns.releaseNode(ns.context, nr);
+
+    for(UA_UInt32 i = 1; i <= 200; i += 2) {
+        UA_NodeId id = UA_NODEID_NUMERIC(0,i);
+        ck_assert_int_eq(ns.removeNode(ns.context, &id), UA_STATUSCODE_GOOD);
+    }
+    UA_Node* n = createNode(0,1);
+    ck_assert_int_eq(ns.insertNode(ns.context, n, NULL), UA_STATUSCODE_GOOD);
+}
+END_TEST
+
+START_TEST(getNodesResolvesBatch) {
+    for(UA_UInt32 i = 1; i <= 100; i++) {
+        UA_Node* n = createNode(0,i);
+        ns.insertNode(ns.context, n, NULL);
+    }
+
+    /* More than one internal batch, every third NodeId is unknown */
+    UA_NodeId ids[40];
+    const UA_NodeId *idPtrs[40];
+    const UA_Node *nodes[40];
+    for(UA_UInt32 i = 0; i < 40; i++) {
+        UA_UInt32 numeric = (i % 3 == 0) ? 1000 + i : 2 * i + 1;
+        ids[i] = UA_NODEID_NUMERIC(0, numeric);
+        idPtrs[i] = &ids[i];
+    }
+    ns.getNodes(ns.context, 40, idPtrs, ~(UA_UInt32)0, UA_REFERENCETYPESET_ALL,
+                UA_BROWSEDIRECTION_BOTH, nodes);
+    for(UA_UInt32 i = 0; i < 40; i++) {
+        if(i % 3 == 0) {
+            ck_assert_ptr_eq(nodes[i], NULL);
+            continue;
+        }
+        ck_assert_ptr_ne(nodes[i], NULL);
+        ck_assert(UA_NodeId_equal(&nodes[i]->head.nodeId, &ids[i]));
+        ns.releaseNode(ns.context, nodes[i]);
+    }
+}
+END_TEST
+
+START_TEST(editNodeIsCopyOnWrite) {
+    UA_Node* n1 = createNode(0,2253);
+    ns.insertNode(ns.context, n1, NULL);
+    UA_NodeId in1 = UA_NODEID_NUMERIC(0,2253);
+
+    /* A reader holds the original node during the edit */
+    const UA_Node *nr = ns.getNode(ns.context, &in1, ~(UA_UInt32)0,
+                                   UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    ck_assert_ptr_eq(nr, n1);
+
+    UA_Node *ne = ns.getEditNode(ns.context, &in1, ~(UA_UInt32)0,
+                                 UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    ck_assert_ptr_ne(ne, NULL);
+    ck_assert_ptr_ne(ne, nr);
+    ne->head.writeMask = 42;
+    ns.releaseNode(ns.context, ne);
+
+    /* The reader still sees the original version */
+    ck_assert_uint_eq(nr->head.writeMask, 0);
+
+    /* Newly retrieved pointers see the change */
+    const UA_Node *nr2 = ns.getNode(ns.context, &in1, ~(UA_UInt32)0,
+                                    UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    ck_assert_ptr_eq(nr2, ne);
+    ck_assert_uint_eq(nr2->head.writeMask, 42);
+
+    /* The retired version is freed once the last reader is released (checked
+     * by the leak sanitizer) */
+    ns.releaseNode(ns.context, nr);
+    ns.releaseNode(ns.context, nr2);
+
+    UA_StatusCode retval = ns.removeNode(ns.context, &in1);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+}
+END_TEST
+
+/* An edited copy is not published if the node was replaced meanwhile */
+START_TEST(releaseEditNodeReportsConflict) {
+    UA_Node* n1 = createNode(0,2253);
+    ns.insertNode(ns.context, n1, NULL);
+    UA_NodeId in1 = UA_NODEID_NUMERIC(0,2253);
+
+    UA_Node *ne1 = ns.getEditNode(ns.context, &in1, ~(UA_UInt32)0,
+                                  UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    UA_Node *ne2 = ns.getEditNode(ns.context, &in1, ~(UA_UInt32)0,
+                                  UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    ck_assert_ptr_ne(ne1, NULL);
+    ck_assert_ptr_ne(ne2, NULL);
+    ne1->head.writeMask = 1;
+    ne2->head.writeMask = 2;
+    UA_StatusCode retval = ns.releaseEditNode(ns.context, ne1);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    retval = ns.releaseEditNode(ns.context, ne2);
+    ck_assert_int_eq(retval, UA_STATUSCODE_BADINTERNALERROR);
+
+    /* The first edit is kept */
+    const UA_Node *nr = ns.getNode(ns.context, &in1, ~(UA_UInt32)0,
+                                   UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    ck_assert_uint_eq(nr->head.writeMask, 1);
+    ns.releaseNode(ns.context, nr);
+
+    retval = ns.removeNode(ns.context, &in1);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+}
+END_TEST
+
+START_TEST(serverWithConcurrentHashMap) {
+    UA_ServerConfig config;
+    memset(&config, 0, sizeof(UA_ServerConfig));
+    UA_Nodestore_ConcurrentHashMap(&config.nodestore);
+    UA_ServerConfig_setDefault(&config);
+    UA_Server *server = UA_Server_newWithConfig(&config);
+    ck_assert_ptr_ne(server, NULL);
+
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    UA_Int32 value = 5;
+    UA_Variant_setScalar(&attr.value, &value, &UA_TYPES[UA_TYPES_INT32]);
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+    UA_NodeId varId = UA_NODEID_STRING(1, "var");
+    UA_StatusCode retval =
+        UA_Server_addVariableNode(server, varId,
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, "var"),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                  attr, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* The write goes through the copy-on-write edit path */
+    UA_Variant v;
+    value = 7;
+    UA_Variant_setScalar(&v, &value, &UA_TYPES[UA_TYPES_INT32]);
+    retval = UA_Server_writeValue(server, varId, v);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_Variant out;
+    retval = UA_Server_readValue(server, varId, &out);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(*(UA_Int32*)out.data, 7);
+    UA_Variant_clear(&out);
+
+    retval = UA_Server_deleteNode(server, varId, true);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_Server_delete(server);
+}
+END_TEST
+
 /************************************/
 /* Performance Profiling Test Cases */
 /************************************/
@@ -221,6 +408,48 @@ static void *profileGetThread(void *arg) {
 
 #define N 10000 /* make bigger to test */
 
+#if UA_MULTITHREADING >= 200
+static volatile UA_Boolean writerRunning;
+
+static void *replaceThread(void *arg) {
+    UA_NodeId id = UA_NODEID_NUMERIC(0, 1);
+    while(writerRunning) {
+        for(UA_UInt32 i = 0; i < N && writerRunning; i += 97) {
+            id.identifier.numeric = i + 1;
+            UA_Node *ne = ns.getEditNode(ns.context, &id, ~(UA_UInt32)0,
+                                         UA_REFERENCETYPESET_ALL,
+                                         UA_BROWSEDIRECTION_BOTH);
+            ne->head.writeMask++;
+            ns.releaseNode(ns.context, ne);
+        }
+    }
+    return NULL;
+}
+
+START_TEST(concurrentReadersAndWriter) {
+    for(UA_UInt32 i = 0; i < N; i++) {
+        UA_Node *n = createNode(0,i+1);
+        ns.insertNode(ns.context, n, NULL);
+    }
+
+    /* Readers run in parallel to a writer that replaces nodes */
+    writerRunning = true;
+    pthread_t w;
+    pthread_create(&w, NULL, replaceThread, NULL);
+    pthread_t t[4];
+    struct UA_NodeStoreProfileTest p[4];
+    for(int i = 0; i < 4; i++) {
+        p[i] = (struct UA_NodeStoreProfileTest){i*(N/4), (i+1)*(N/4), 20};
+        pthread_create(&t[i], NULL, profileGetThread, &p[i]);
+    }
+    for(int i = 0; i < 4; i++)
+        pthread_join(t[i], NULL);
+    writerRunning = false;
+    pthread_join(w, NULL);
+}
+END_TEST
+#endif
+
 START_TEST(profileGetDelete) {
     clock_t begin, end;
     begin = clock();
@@ -293,6 +522,8 @@ static Suite * namespace_suite (void) {
     tcase_add_test (tc_find_hm, findNodeInExpandedNamespace);
     tcase_add_test (tc_find_hm, failToFindNonExistentNodeInUA_NodeStoreWithSeveralEntries);
     tcase_add_test (tc_find_hm, failToFindNodeInOtherUA_NodeStore);
+    tcase_add_test (tc_find_hm, compactKeepsNodesAccessible);
+    tcase_add_test (tc_find_hm, getNodesResolvesBatch);
     suite_add_tcase (s, tc_find_hm);
 
     TCase *tc_replace_hm = tcase_create("Replace-HashMap");
@@ -312,6 +543,43 @@ static Suite * namespace_suite (void) {
     tcase_add_test (tc_profile_hm, profileGetDelete);
     suite_add_tcase (s, tc_profile_hm);
 
+    TCase* tc_find_chm = tcase_create ("Find-ConcurrentHashMap");
+    tcase_add_checked_fixture(tc_find_chm, setupConcurrentHashMap, teardown);
+    tcase_add_test (tc_find_chm, findNodeInUA_NodeStoreWithSingleEntry);
+    tcase_add_test (tc_find_chm, findNodeInUA_NodeStoreWithSeveralEntries);
+    tcase_add_test (tc_find_chm, findNodeInExpandedNamespace);
+    tcase_add_test (tc_find_chm, failToFindNonExistentNodeInUA_NodeStoreWithSeveralEntries);
+    tcase_add_test (tc_find_chm, failToFindNodeInOtherUA_NodeStore);
+    tcase_add_test (tc_find_chm, compactKeepsNodesAccessible);
+    tcase_add_test (tc_find_chm, getNodesResolvesBatch);
+    suite_add_tcase (s, tc_find_chm);
+
+    TCase *tc_replace_chm = tcase_create("Replace-ConcurrentHashMap");
+    tcase_add_checked_fixture(tc_replace_chm, setupConcurrentHashMap, teardown);
+    tcase_add_test (tc_replace_chm, replaceExistingNode);
+    tcase_add_test (tc_replace_chm, replaceOldNode);
+    tcase_add_test (tc_replace_chm, editNodeIsCopyOnWrite);
+    tcase_add_test (tc_replace_chm, releaseEditNodeReportsConflict);
+    suite_add_tcase (s, tc_replace_chm);
+
+    TCase* tc_iterate_chm = tcase_create ("Iterate-ConcurrentHashMap");
+    tcase_add_checked_fixture(tc_iterate_chm, setupConcurrentHashMap, teardown);
+    tcase_add_test (tc_iterate_chm, iterateOverUA_NodeStoreShallNotVisitEmptyNodes);
+    tcase_add_test (tc_iterate_chm, iterateOverExpandedNamespaceShallNotVisitEmptyNodes);
+    suite_add_tcase (s, tc_iterate_chm);
+
+    TCase* tc_profile_chm = tcase_create ("Profile-ConcurrentHashMap");
+    tcase_add_checked_fixture(tc_profile_chm, setupConcurrentHashMap, teardown);
+    tcase_add_test (tc_profile_chm, profileGetDelete);
+#if UA_MULTITHREADING >= 200
+    tcase_add_test (tc_profile_chm, concurrentReadersAndWriter);
+#endif
+    suite_add_tcase (s, tc_profile_chm);
+
+    TCase* tc_server_chm = tcase_create ("Server-ConcurrentHashMap");
+    tcase_add_test (tc_server_chm, serverWithConcurrentHashMap);
+    suite_add_tcase (s, tc_server_chm);
+
     return s;
 }
 
@@ -19,6 +19,15 @@
 
 #include "check.h"
 
+#ifdef UA_ARCHITECTURE_POSIX
+#include <open62541/plugin/nodestore_default.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
 static UA_Server *server = NULL;
 
 static void setup(void) {
@@ -47,6 +56,34 @@ START_TEST(checkGetNamespaceByName) {
     ck_assert_uint_eq(found, UA_STATUSCODE_GOOD);
 } END_TEST
 
+START_TEST(checkAddManyNamespaces) {
+    /* Grows the lookup table several times */
+    char uri[64];
+    for(size_t i = 0; i < 200; i++) {
+        snprintf(uri, sizeof(uri), "http://example.org/ns/%u", (unsigned)i);
+        UA_UInt16 nsIndex = UA_Server_addNamespace(server, uri);
+        ck_assert_uint_eq(nsIndex, i + 2);
+    }
+
+    /* The indices are stable when a namespace is added again */
+    ck_assert_uint_eq(UA_Server_addNamespace(server, "http://example.org/ns/17"), 19);
+    ck_assert_uint_eq(UA_Server_addNamespace(server, "http://opcfoundation.org/UA/"), 0);
+
+    for(size_t i = 0; i < 200; i++) {
+        snprintf(uri, sizeof(uri), "http://example.org/ns/%u", (unsigned)i);
+        size_t foundIndex = 0;
+        UA_StatusCode res = UA_Server_getNamespaceByName(server, UA_STRING(uri), &foundIndex);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(foundIndex, i + 2);
+    }
+
+    size_t foundIndex = 0;
+    UA_StatusCode res = UA_Server_getNamespaceByName(server,
+                                                     UA_STRING("http://example.org/ns/200"),
+                                                     &foundIndex);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADNOTFOUND);
+} END_TEST
+
 START_TEST(checkGetNamespaceById) {
     UA_String searchResultNamespace;
     UA_StatusCode notFound = UA_Server_getNamespaceByIndex(server, 10, &searchResultNamespace);
@@ -66,6 +103,221 @@ START_TEST(checkGetNamespaceById) {
     UA_String_clear(&searchResultNamespace);
 } END_TEST
 
+static UA_Boolean
+browseContains(UA_Server *s, const UA_NodeId *parent, const UA_NodeId *target) {
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = *parent;
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+    bd.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_HIERARCHICALREFERENCES);
+    bd.includeSubtypes = true;
+    bd.resultMask = UA_BROWSERESULTMASK_NONE;
+    UA_BrowseResult br = UA_Server_browse(s, 0, &bd);
+    UA_Boolean found = false;
+    for(size_t i = 0; i < br.referencesSize; i++) {
+        if(UA_NodeId_equal(&br.references[i].nodeId.nodeId, target))
+            found = true;
+    }
+    UA_BrowseResult_clear(&br);
+    return found;
+}
+
+/* A new ReferenceType, an object below the objects folder and a variable below
+ * the object with the new ReferenceType */
+static void
+addSnapshotNodes(UA_Server *s, UA_NodeId *refTypeId,
+                 UA_NodeId *objId, UA_NodeId *varId) {
+    UA_UInt16 nsIndex = UA_Server_addNamespace(s, "urn:test:snapshot");
+
+    /* A new hierarchical ReferenceType */
+    *refTypeId = UA_NODEID_NUMERIC(nsIndex, 1000);
+    UA_ReferenceTypeAttributes rattr = UA_ReferenceTypeAttributes_default;
+    rattr.inverseName = UA_LOCALIZEDTEXT("", "IsSnapshotChildOf");
+    UA_StatusCode ret =
+        UA_Server_addReferenceTypeNode(s, *refTypeId,
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+                                       UA_QUALIFIEDNAME(nsIndex, "HasSnapshotChild"),
+                                       rattr, NULL, NULL);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+
+    *objId = UA_NODEID_STRING(nsIndex, "snapshot-object");
+    UA_ObjectAttributes oattr = UA_ObjectAttributes_default;
+    oattr.displayName = UA_LOCALIZEDTEXT("en-US", "SnapshotObject");
+    ret = UA_Server_addObjectNode(s, *objId,
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                  UA_QUALIFIEDNAME(nsIndex, "SnapshotObject"),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                  oattr, NULL, NULL);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+
+    *varId = UA_NODEID_NUMERIC(nsIndex, 1001);
+    UA_VariableAttributes vattr = UA_VariableAttributes_default;
+    UA_Double d = 42.5;
+    UA_Variant_setScalar(&vattr.value, &d, &UA_TYPES[UA_TYPES_DOUBLE]);
+    ret = UA_Server_addVariableNode(s, *varId, *objId, *refTypeId,
+                                    UA_QUALIFIEDNAME(nsIndex, "SnapshotVar"),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                    vattr, NULL, NULL);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+}
+
+START_TEST(checkAddressSpaceSnapshot) {
+    UA_NodeId refTypeId, objId, varId;
+    addSnapshotNodes(server, &refTypeId, &objId, &varId);
+    UA_String objName = UA_STRING("SnapshotObject");
+
+    UA_ByteString snapshot;
+    UA_StatusCode ret = UA_Server_saveAddressSpaceSnapshot(server, &snapshot);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    ck_assert_uint_gt(snapshot.length, 0);
+
+    /* Restore into a fresh server */
+    UA_Server *server2 = UA_Server_newForUnitTest();
+    ck_assert(server2 != NULL);
+    ret = UA_Server_loadAddressSpaceSnapshot(server2, &snapshot);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    UA_ByteString_clear(&snapshot);
+
+    UA_Variant out;
+    ret = UA_Server_readValue(server2, varId, &out);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasScalarType(&out, &UA_TYPES[UA_TYPES_DOUBLE]));
+    ck_assert(*(UA_Double*)out.data == 42.5);
+    UA_Variant_clear(&out);
+
+    UA_QualifiedName bn;
+    ret = UA_Server_readBrowseName(server2, objId, &bn);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    ck_assert(UA_String_equal(&bn.name, &objName));
+    UA_QualifiedName_clear(&bn);
+
+    /* The references of the existing ns0 node were merged. The new
+     * ReferenceType is known as a hierarchical reference. */
+    UA_NodeId objectsId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    ck_assert(browseContains(server2, &objectsId, &objId));
+    ck_assert(browseContains(server2, &objId, &varId));
+
+    UA_Server_delete(server2);
+} END_TEST
+
+#ifdef UA_ARCHITECTURE_POSIX
+static void
+writeSnapshotFile(UA_Server *s, char *path) {
+    UA_ByteString snapshot;
+    UA_StatusCode ret = UA_Server_saveAddressSpaceSnapshot(s, &snapshot);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    int fd = mkstemp(path);
+    ck_assert_int_ge(fd, 0);
+    FILE *f = fdopen(fd, "wb");
+    ck_assert(f != NULL);
+    ck_assert_uint_eq(fwrite(snapshot.data, 1, snapshot.length, f), snapshot.length);
+    fclose(f);
+    UA_ByteString_clear(&snapshot);
+}
+
+START_TEST(checkMappedFileNodestore) {
+    UA_NodeId refTypeId, objId, varId;
+    addSnapshotNodes(server, &refTypeId, &objId, &varId);
+    char path[] = "/tmp/open62541_snapshot_XXXXXX";
+    writeSnapshotFile(server, path);
+
+    /* Serve the nodes from the file with a small cache */
+    UA_ServerConfig config;
+    memset(&config, 0, sizeof(UA_ServerConfig));
+    UA_StatusCode ret = UA_Nodestore_MappedFile(&config.nodestore, path, 4, NULL);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    UA_ServerConfig_setDefault(&config);
+    UA_Server *server2 = UA_Server_newWithConfig(&config);
+    ck_assert(server2 != NULL);
+    UA_Server_addNamespace(server2, "urn:test:snapshot");
+
+    UA_Variant out;
+    ret = UA_Server_readValue(server2, varId, &out);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    ck_assert(*(UA_Double*)out.data == 42.5);
+    UA_Variant_clear(&out);
+
+    /* The references from ns0 and with the ReferenceType from the file */
+    UA_NodeId objectsId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    ck_assert(browseContains(server2, &objectsId, &objId));
+    ck_assert(browseContains(server2, &objId, &varId));
+
+    /* Modified nodes are kept in memory */
+    UA_Double d = 7.0;
+    UA_Variant v;
+    UA_Variant_setScalar(&v, &d, &UA_TYPES[UA_TYPES_DOUBLE]);
+    ret = UA_Server_writeValue(server2, varId, v);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    ret = UA_Server_readValue(server2, varId, &out);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    ck_assert(*(UA_Double*)out.data == 7.0);
+    UA_Variant_clear(&out);
+
+    /* Removed nodes from the file are no longer visible */
+    ret = UA_Server_deleteNode(server2, varId, true);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    ret = UA_Server_readValue(server2, varId, &out);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_BADNODEIDUNKNOWN);
+
+    UA_Server_delete(server2);
+    unlink(path);
+} END_TEST
+
+START_TEST(checkMappedFileNodestoreNs0) {
+    UA_NodeId refTypeId, objId, varId;
+    addSnapshotNodes(server, &refTypeId, &objId, &varId);
+    char path[] = "/tmp/open62541_snapshot_XXXXXX";
+    writeSnapshotFile(server, path);
+
+    /* Namespace 0 is also served from the file */
+    UA_ServerConfig config;
+    memset(&config, 0, sizeof(UA_ServerConfig));
+    UA_StatusCode ret = UA_Nodestore_MappedFileNs0(&config.nodestore, path, 16, NULL);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    UA_ServerConfig_setDefault(&config);
+    UA_Server *server2 = UA_Server_newWithConfig(&config);
+    ck_assert(server2 != NULL);
+    UA_Server_addNamespace(server2, "urn:test:snapshot");
+
+    UA_Variant out;
+    ret = UA_Server_readValue(server2, varId, &out);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    ck_assert(*(UA_Double*)out.data == 42.5);
+    UA_Variant_clear(&out);
+
+    /* The ReferenceType hierarchy is known. The ReferenceType from the file is
+     * a subtype of HierarchicalReferences. */
+    UA_NodeId objectsId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    UA_NodeId serverId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
+    UA_NodeId statusId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS);
+    ck_assert(browseContains(server2, &objectsId, &serverId));
+    ck_assert(browseContains(server2, &serverId, &statusId));
+    ck_assert(browseContains(server2, &objectsId, &objId));
+    ck_assert(browseContains(server2, &objId, &varId));
+
+    /* The data sources of namespace 0 are set up by the server */
+    ret = UA_Server_readValue(server2,
+                              UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_CURRENTTIME),
+                              &out);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasScalarType(&out, &UA_TYPES[UA_TYPES_DATETIME]));
+    ck_assert(*(UA_DateTime*)out.data > 0);
+    UA_Variant_clear(&out);
+
+    ret = UA_Server_readValue(server2,
+                              UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_NAMESPACEARRAY),
+                              &out);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(out.arrayLength, 3);
+    UA_Variant_clear(&out);
+
+    UA_Server_delete(server2);
+    unlink(path);
+} END_TEST
+#endif
+
 static void timedCallbackHandler(UA_Server *s, void *data) {
     *((UA_Boolean*)data) = false;  // stop the server via a timedCallback
 }
@@ -80,6 +332,36 @@ START_TEST(checkServer_run) {
     ck_assert_int_eq(ret, UA_STATUSCODE_GOOD);
 } END_TEST
 
+#if defined(__linux__)
+/* The thread that starts the server is pinned to the configured CPUs */
+START_TEST(checkServer_threadPlacement) {
+    cpu_set_t before;
+    ck_assert_int_eq(sched_getaffinity(0, sizeof(cpu_set_t), &before), 0);
+
+    /* Pin to the first CPU the thread is currently allowed to run on */
+    UA_UInt32 cpu = 0;
+    while(!CPU_ISSET(cpu, &before))
+        cpu++;
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    config->eventLoopPlacement.cpus = (UA_UInt32*)UA_malloc(sizeof(UA_UInt32));
+    config->eventLoopPlacement.cpus[0] = cpu;
+    config->eventLoopPlacement.cpusSize = 1;
+
+    UA_StatusCode ret = UA_Server_run_startup(server);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    cpu_set_t after;
+    ck_assert_int_eq(sched_getaffinity(0, sizeof(cpu_set_t), &after), 0);
+    ck_assert_int_eq(CPU_COUNT(&after), 1);
+    ck_assert(CPU_ISSET(cpu, &after));
+    UA_Server_run_iterate(server, false);
+    ret = UA_Server_run_shutdown(server);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+
+    /* Restore the affinity for the following tests */
+    sched_setaffinity(0, sizeof(cpu_set_t), &before);
+} END_TEST
+#endif
+
 int main(void) {
     Suite *s = suite_create("server");
 
@@ -88,7 +370,16 @@ int main(void) {
     tcase_add_test(tc_call, checkGetConfig);
     tcase_add_test(tc_call, checkGetNamespaceByName);
     tcase_add_test(tc_call, checkGetNamespaceById);
+    tcase_add_test(tc_call, checkAddManyNamespaces);
     tcase_add_test(tc_call, checkServer_run);
+#if defined(__linux__)
+    tcase_add_test(tc_call, checkServer_threadPlacement);
+#endif
+    tcase_add_test(tc_call, checkAddressSpaceSnapshot);
+#ifdef UA_ARCHITECTURE_POSIX
+    tcase_add_test(tc_call, checkMappedFileNodestore);
+    tcase_add_test(tc_call, checkMappedFileNodestoreNs0);
+#endif
     suite_add_tcase(s, tc_call);
 
     SRunner *sr = srunner_create(s);
@@ -122,6 +122,133 @@ START_TEST(splitCreation) {
 }
 END_TEST
 
+#define MANY_CONDITIONS 64
+
+/* Conditions are looked up in an index. Delete them in a different order than
+ * they were created and access the cached Retain field in between. */
+START_TEST(createDeleteMany) {
+    UA_NodeId conditions[MANY_CONDITIONS];
+    UA_NodeId source = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
+    for(size_t i = 0; i < MANY_CONDITIONS; i++) {
+        UA_StatusCode retval = UA_Server_createCondition(
+            server_ac, UA_NODEID_NULL,
+            UA_NODEID_NUMERIC(0, UA_NS0ID_OFFNORMALALARMTYPE),
+            UA_QUALIFIEDNAME(0, "Condition createDeleteMany"),
+            source, UA_NODEID_NULL, &conditions[i]);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+
+    UA_Boolean retain = true;
+    UA_Variant value;
+    UA_Variant_setScalar(&value, &retain, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    for(size_t i = 0; i < MANY_CONDITIONS; i++) {
+        for(size_t j = 0; j < 2; j++) {
+            UA_StatusCode retval =
+                UA_Server_setConditionField(server_ac, conditions[i], &value,
+                                            UA_QUALIFIEDNAME(0, "Retain"));
+            ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        }
+    }
+
+    for(size_t i = 0; i < MANY_CONDITIONS; i += 2) {
+        UA_StatusCode retval = UA_Server_deleteCondition(server_ac, conditions[i], source);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+    for(size_t i = 0; i < MANY_CONDITIONS; i += 2) {
+        UA_StatusCode retval = UA_Server_deleteCondition(server_ac, conditions[i], source);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_BADNOTFOUND);
+    }
+    for(size_t i = 1; i < MANY_CONDITIONS; i += 2) {
+        UA_StatusCode retval = UA_Server_deleteCondition(server_ac, conditions[i], source);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+}
+END_TEST
+
+static void
+checkLimitState(const UA_NodeId condition, const char *expected) {
+    UA_QualifiedName path[2] = {UA_QUALIFIEDNAME(0, "LimitState"),
+                                UA_QUALIFIEDNAME(0, "CurrentState")};
+    UA_BrowsePathResult bpr =
+        UA_Server_browseSimplifiedBrowsePath(server_ac, condition, 2, path);
+    ck_assert_uint_eq(bpr.statusCode, UA_STATUSCODE_GOOD);
+    UA_Variant value;
+    UA_StatusCode retval =
+        UA_Server_readValue(server_ac, bpr.targets[0].targetId.nodeId, &value);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasScalarType(&value, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]));
+    UA_String expectedText = UA_STRING((char*)(uintptr_t)expected);
+    ck_assert(UA_String_equal(&((UA_LocalizedText*)value.data)->text, &expectedText));
+    UA_Variant_clear(&value);
+    UA_BrowsePathResult_clear(&bpr);
+}
+
+/* The limit alarm is evaluated when its input node is written. The limits are
+ * cached and updated when the limit properties are written. */
+START_TEST(limitAlarmInput) {
+    UA_NodeId input = UA_NODEID_NUMERIC(1, 5000);
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    UA_Double zero = 0.0;
+    UA_Variant_setScalar(&attr.value, &zero, &UA_TYPES[UA_TYPES_DOUBLE]);
+    UA_StatusCode retval =
+        UA_Server_addVariableNode(server_ac, input,
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, "LimitInput"),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                  attr, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_NodeId condition;
+    UA_NodeId source = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
+    retval = UA_Server_createCondition(
+        server_ac, UA_NODEID_NULL,
+        UA_NODEID_NUMERIC(0, UA_NS0ID_EXCLUSIVELEVELALARMTYPE),
+        UA_QUALIFIEDNAME(0, "Condition limitAlarmInput"),
+        source, UA_NODEID_NULL, &condition);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    retval = UA_Server_setLimitAlarmInput(server_ac, condition, input);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_Double limit = 10.0;
+    retval = UA_Server_writeObjectProperty_scalar(server_ac, condition,
+                                                  UA_QUALIFIEDNAME(0, "HighLimit"),
+                                                  &limit, &UA_TYPES[UA_TYPES_DOUBLE]);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_Variant v;
+    UA_Double high = 20.0;
+    UA_Variant_setScalar(&v, &high, &UA_TYPES[UA_TYPES_DOUBLE]);
+    retval = UA_Server_writeValue(server_ac, input, v);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    checkLimitState(condition, "High active");
+
+    /* Raising the limit reevaluates the last input value */
+    limit = 30.0;
+    retval = UA_Server_writeObjectProperty_scalar(server_ac, condition,
+                                                  UA_QUALIFIEDNAME(0, "HighLimit"),
+                                                  &limit, &UA_TYPES[UA_TYPES_DOUBLE]);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    checkLimitState(condition, "");
+
+    /* Batch evaluation of samples */
+    UA_Double samples[2] = {40.0, 5.0};
+    UA_NodeId inputs[2] = {input, input};
+    UA_Server_evaluateLimitAlarms(server_ac, 1, inputs, samples);
+    checkLimitState(condition, "High active");
+    UA_Server_evaluateLimitAlarms(server_ac, 2, inputs, samples);
+    checkLimitState(condition, "");
+
+    retval = UA_Server_deleteCondition(server_ac, condition, source);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* The input is no longer watched */
+    retval = UA_Server_writeValue(server_ac, input, v);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+}
+END_TEST
+
 #endif
 
 int main(void) {
@@ -131,6 +258,8 @@ int main(void) {
 #ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
     tcase_add_test(tc_call, createDelete);
     tcase_add_test(tc_call, splitCreation);
+    tcase_add_test(tc_call, createDeleteMany);
+    tcase_add_test(tc_call, limitAlarmInput);
 #endif
     tcase_add_checked_fixture(tc_call, setup, teardown);
 
@@ -8,6 +8,7 @@
 #include <open62541/server.h>
 #include <open62541/client.h>
 #include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
 #include <open62541/client_highlevel_async.h>
 #include <open62541/plugin/log_stdout.h>
 
@@ -33,6 +34,36 @@ methodCallback(UA_Server *serverArg,
     return UA_STATUSCODE_GOOD;
 }
 
+static UA_Int32 dataSourceValue;
+
+static UA_StatusCode
+readDataSource(UA_Server *serverArg, const UA_NodeId *sessionId, void *sessionContext,
+               const UA_NodeId *nodeId, void *nodeContext, UA_Boolean sourceTimeStamp,
+               const UA_NumericRange *range, UA_DataValue *value) {
+    UA_Variant_setScalarCopy(&value->value, &dataSourceValue, &UA_TYPES[UA_TYPES_INT32]);
+    value->hasValue = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+writeDataSource(UA_Server *serverArg, const UA_NodeId *sessionId, void *sessionContext,
+                const UA_NodeId *nodeId, void *nodeContext,
+                const UA_NumericRange *range, const UA_DataValue *value) {
+    if(!UA_Variant_hasScalarType(&value->value, &UA_TYPES[UA_TYPES_INT32]))
+        return UA_STATUSCODE_BADTYPEMISMATCH;
+    dataSourceValue = *(UA_Int32*)value->value.data;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_ReadResponse readResponse;
+
+static void
+clientReadCallback(UA_Client *client, void *userdata,
+                   UA_UInt32 requestId, void *response) {
+    UA_ReadResponse_copy((UA_ReadResponse*)response, &readResponse);
+    clientCounter++;
+}
+
 static void
 clientReceiveCallback(UA_Client *client, void *userdata,
                       UA_UInt32 requestId, UA_CallResponse *cr) {
@@ -46,13 +77,15 @@ THREAD_CALLBACK(serverloop) {
     return 0;
 }
 
-static void setup(void) {
+static void setupWithWorkers(UA_UInt16 workers) {
     clientCounter = 0;
+    dataSourceValue = 42;
     running = true;
     server = UA_Server_newForUnitTest();
     ck_assert(server != NULL);
     UA_ServerConfig *config = UA_Server_getConfig(server);
     config->asyncOperationTimeout = 2000.0; /* 2 seconds */
+    config->asyncOperationWorkers = workers;
 
     UA_MethodAttributes methodAttr = UA_MethodAttributes_default;
     methodAttr.executable = true;
@@ -79,10 +112,32 @@ static void setup(void) {
     res = UA_Server_setMethodNodeAsync(server, UA_NODEID_STRING(1, "asyncMethod"), true);
     ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
 
+    /* Asynchronous DataSource variable */
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+    UA_DataSource dataSource = {readDataSource, writeDataSource};
+    res = UA_Server_addDataSourceVariableNode(server, UA_NODEID_STRING(1, "asyncVariable"),
+                                              UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                              UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                              UA_QUALIFIEDNAME(1, "asyncVariable"),
+                                              UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                              attr, dataSource, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    res = UA_Server_setVariableNodeAsync(server, UA_NODEID_STRING(1, "asyncVariable"), true);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
     UA_Server_run_startup(server);
     THREAD_CREATE(server_thread, serverloop);
 }
 
+static void setup(void) {
+    setupWithWorkers(0);
+}
+
+static void setupBuiltinWorkers(void) {
+    setupWithWorkers(2);
+}
+
 static void teardown(void) {
     running = false;
     THREAD_JOIN(server_thread);
@@ -301,6 +356,159 @@ START_TEST(Async_timeout_worker) {
     UA_Client_delete(client);
 } END_TEST
 
+START_TEST(Async_read) {
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Stop the server thread. Iterate manually from now on */
+    running = false;
+    THREAD_JOIN(server_thread);
+
+    /* Read the async variable and the sync NamespaceArray in one request */
+    UA_ReadValueId rvi[2];
+    UA_ReadValueId_init(&rvi[0]);
+    rvi[0].nodeId = UA_NODEID_STRING(1, "asyncVariable");
+    rvi[0].attributeId = UA_ATTRIBUTEID_VALUE;
+    UA_ReadValueId_init(&rvi[1]);
+    rvi[1].nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_NAMESPACEARRAY);
+    rvi[1].attributeId = UA_ATTRIBUTEID_VALUE;
+    UA_ReadRequest rr;
+    UA_ReadRequest_init(&rr);
+    rr.nodesToRead = rvi;
+    rr.nodesToReadSize = 2;
+    rr.timestampsToReturn = UA_TIMESTAMPSTORETURN_NEITHER;
+    retval = __UA_Client_AsyncService(client, &rr, &UA_TYPES[UA_TYPES_READREQUEST],
+                                      clientReadCallback,
+                                      &UA_TYPES[UA_TYPES_READRESPONSE], NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_Server_run_iterate(server, true);
+    UA_Client_run_iterate(client, 0);
+    ck_assert_uint_eq(clientCounter, 0);
+
+    /* Execute the read operation in the "worker" */
+    UA_AsyncOperationType aot;
+    const UA_AsyncOperationRequest *request;
+    void *context = NULL;
+    UA_Boolean haveAsync =
+        UA_Server_getAsyncOperationNonBlocking(server, &aot, &request, &context, NULL);
+    ck_assert_uint_eq(haveAsync, true);
+    ck_assert_int_eq(aot, UA_ASYNCOPERATIONTYPE_READ);
+    UA_AsyncOperationResponse response;
+    response.readResult = UA_Server_read(server, &request->readValueId,
+                                         UA_TIMESTAMPSTORETURN_BOTH);
+    UA_Server_setAsyncOperationResult(server, &response, context);
+    UA_DataValue_clear(&response.readResult);
+
+    /* Iterate and pick up the async response to be sent out */
+    UA_fakeSleep(1000);
+    UA_Server_run_iterate(server, true);
+    UA_Client_run_iterate(client, 0);
+    ck_assert_uint_eq(clientCounter, 1);
+
+    ck_assert_uint_eq(readResponse.resultsSize, 2);
+    ck_assert(UA_Variant_hasScalarType(&readResponse.results[0].value,
+                                       &UA_TYPES[UA_TYPES_INT32]));
+    ck_assert_int_eq(*(UA_Int32*)readResponse.results[0].value.data, 42);
+    ck_assert(!readResponse.results[0].hasServerTimestamp);
+    ck_assert(readResponse.results[1].hasValue);
+    UA_ReadResponse_clear(&readResponse);
+
+    running = true;
+    THREAD_CREATE(server_thread, serverloop);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+} END_TEST
+
+/* Records the operations handed to the executor. They are completed from the
+ * test thread while the server thread blocks in the EventLoop. */
+static void * volatile executorOperation;
+static volatile UA_AsyncOperationType executorOperationType;
+
+static void
+asyncExecutor(UA_Server *serverArg, void *executorContext,
+              UA_AsyncOperationType type, const UA_AsyncOperationRequest *request,
+              void *context, UA_DateTime timeout) {
+    executorOperationType = type;
+    executorOperation = context;
+}
+
+START_TEST(Async_call_executor) {
+    executorOperation = NULL;
+    UA_Server_setAsyncOperationExecutor(server, asyncExecutor, NULL);
+
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    retval = UA_Client_call_async(client,
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_STRING(1, "asyncMethod"),
+                                  0, NULL, clientReceiveCallback, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* The operation is pushed to the executor */
+    for(size_t i = 0; i < 1000 && !executorOperation; i++)
+        UA_Client_run_iterate(client, 1);
+    ck_assert(executorOperation != NULL);
+    ck_assert_int_eq(executorOperationType, UA_ASYNCOPERATIONTYPE_CALL);
+    ck_assert_uint_eq(clientCounter, 0);
+
+    /* Complete from this thread. The clock does not advance. So the response
+     * is only sent if the result wakes up the server thread. */
+    UA_AsyncOperationResponse response;
+    UA_CallMethodResult_init(&response.callMethodResult);
+    UA_Server_setAsyncOperationResult(server, &response, executorOperation);
+    for(size_t i = 0; i < 1000 && clientCounter == 0; i++)
+        UA_Client_run_iterate(client, 1);
+    ck_assert_uint_eq(clientCounter, 1);
+
+    UA_Server_setAsyncOperationExecutor(server, NULL, NULL);
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+} END_TEST
+
+START_TEST(Async_readWrite_builtinWorkers) {
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_Variant value;
+    UA_Variant_init(&value);
+    retval = UA_Client_readValueAttribute(client, UA_NODEID_STRING(1, "asyncVariable"),
+                                          &value);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasScalarType(&value, &UA_TYPES[UA_TYPES_INT32]));
+    ck_assert_int_eq(*(UA_Int32*)value.data, 42);
+    UA_Variant_clear(&value);
+
+    UA_Int32 newValue = 23;
+    UA_Variant_setScalar(&value, &newValue, &UA_TYPES[UA_TYPES_INT32]);
+    retval = UA_Client_writeValueAttribute(client, UA_NODEID_STRING(1, "asyncVariable"),
+                                           &value);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(dataSourceValue, 23);
+
+    /* The async method is also executed by the built-in workers */
+    UA_CallMethodRequest cmr;
+    UA_CallMethodRequest_init(&cmr);
+    cmr.objectId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    cmr.methodId = UA_NODEID_STRING(1, "asyncMethod");
+    UA_CallRequest creq;
+    UA_CallRequest_init(&creq);
+    creq.methodsToCall = &cmr;
+    creq.methodsToCallSize = 1;
+    UA_CallResponse cres = UA_Client_Service_call(client, creq);
+    ck_assert_uint_eq(cres.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(cres.resultsSize, 1);
+    ck_assert_uint_eq(cres.results[0].statusCode, UA_STATUSCODE_GOOD);
+    UA_CallResponse_clear(&cres);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+} END_TEST
+
 static Suite* method_async_suite(void) {
     /* set up unit test for internal data structures */
     Suite *s = suite_create("Async Method");
@@ -312,8 +520,15 @@ static Suite* method_async_suite(void) {
     tcase_add_test(tc_manager, Async_cancel);
     tcase_add_test(tc_manager, Async_cancel_multiple);
     tcase_add_test(tc_manager, Async_timeout_worker);
+    tcase_add_test(tc_manager, Async_read);
+    tcase_add_test(tc_manager, Async_call_executor);
     suite_add_tcase(s, tc_manager);
 
+    TCase* tc_workers = tcase_create("BuiltinWorkers");
+    tcase_add_checked_fixture(tc_workers, setupBuiltinWorkers, teardown);
+    tcase_add_test(tc_workers, Async_readWrite_builtinWorkers);
+    suite_add_tcase(s, tc_workers);
+
     return s;
 }
 
@@ -0,0 +1,176 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/client.h>
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
+#include <open62541/plugin/capture_pcapng.h>
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+
+#include "test_helpers.h"
+
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "thread_wrapper.h"
+
+#define CAPTURE_FILE "check_server_capture.pcapng"
+
+UA_Server *server;
+UA_PacketCapture *capture;
+UA_Boolean running;
+THREAD_HANDLE server_thread;
+
+THREAD_CALLBACK(serverloop) {
+    while(running)
+        UA_Server_run_iterate(server, true);
+    return 0;
+}
+
+static void setup(void) {
+    server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+    capture = UA_PacketCapture_Pcapng_new(CAPTURE_FILE, 0);
+    ck_assert(capture != NULL);
+    UA_Server_getConfig(server)->packetCapture = capture;
+    UA_Server_run_startup(server);
+    running = true;
+    THREAD_CREATE(server_thread, serverloop);
+}
+
+static void teardown(void) {
+    running = false;
+    THREAD_JOIN(server_thread);
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server); /* Also clears the capture */
+    remove(CAPTURE_FILE);
+}
+
+static void
+connectAndRead(void) {
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode res = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_Variant val;
+    res = UA_Client_readValueAttribute(client,
+        UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_STATE), &val);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_Variant_clear(&val);
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+}
+
+static UA_UInt32
+readUInt32(const UA_Byte *pos) {
+    UA_UInt32 v;
+    memcpy(&v, pos, sizeof(UA_UInt32));
+    return v;
+}
+
+static UA_UInt16
+readUInt16BE(const UA_Byte *pos) {
+    return (UA_UInt16)((pos[0] << 8) | pos[1]);
+}
+
+START_TEST(Capture_pcapng) {
+    connectAndRead();
+    UA_PacketCapture_Pcapng_flush(capture);
+
+    size_t captured, dropped;
+    UA_PacketCapture_Pcapng_getStatistics(capture, &captured, &dropped);
+    ck_assert_uint_gt(captured, 0);
+    ck_assert_uint_eq(dropped, 0);
+
+    /* Read the file */
+    FILE *f = fopen(CAPTURE_FILE, "rb");
+    ck_assert(f != NULL);
+    UA_Byte *buf = (UA_Byte*)UA_malloc(1 << 20);
+    size_t len = fread(buf, 1, 1 << 20, f);
+    fclose(f);
+
+    /* Section header and interface description with raw IP */
+    ck_assert_uint_ge(len, 48);
+    ck_assert_uint_eq(readUInt32(buf), 0x0A0D0D0A);
+    ck_assert_uint_eq(readUInt32(&buf[8]), 0x1A2B3C4D);
+    ck_assert_uint_eq(readUInt32(&buf[28]), 1);
+    UA_UInt16 linkType;
+    memcpy(&linkType, &buf[36], 2);
+    ck_assert_uint_eq(linkType, 101);
+
+    /* Enhanced packet blocks. The first packet is the HEL from the client, the
+     * second is the ACK from the server. The MessageSize is the length of the
+     * TCP payload. */
+    size_t pos = 48, packets = 0;
+    UA_Boolean hel = false, ack = false, msg = false;
+    while(pos < len) {
+        ck_assert_uint_eq(readUInt32(&buf[pos]), 6);
+        UA_UInt32 blockLength = readUInt32(&buf[pos + 4]);
+        ck_assert_uint_eq(blockLength % 4, 0);
+        ck_assert_uint_le(pos + blockLength, len);
+        ck_assert_uint_eq(readUInt32(&buf[pos + blockLength - 4]), blockLength);
+
+        const UA_Byte *ip = &buf[pos + 28];
+        const UA_Byte *tcp = &ip[20];
+        const UA_Byte *payload = &tcp[20];
+        UA_UInt32 packetLength = readUInt32(&buf[pos + 20]);
+        ck_assert_uint_eq(readUInt16BE(&ip[2]), packetLength);
+        size_t payloadLength = packetLength - 40;
+        UA_UInt32 messageSize = (UA_UInt32)payload[4] | (UA_UInt32)payload[5] << 8 |
+            (UA_UInt32)payload[6] << 16 | (UA_UInt32)payload[7] << 24;
+        ck_assert_uint_eq(messageSize, payloadLength);
+
+        UA_Boolean sent = (readUInt16BE(tcp) == 4840);
+        if(packets == 0) {
+            ck_assert(!sent);
+            hel = (memcmp(payload, "HEL", 3) == 0);
+        } else if(packets == 1) {
+            ck_assert(sent);
+            ack = (memcmp(payload, "ACK", 3) == 0);
+        } else if(memcmp(payload, "MSG", 3) == 0) {
+            msg = true;
+        }
+        packets++;
+        pos += blockLength;
+    }
+    ck_assert(hel);
+    ck_assert(ack);
+    ck_assert(msg);
+    ck_assert_uint_eq(packets, captured);
+    UA_free(buf);
+} END_TEST
+
+START_TEST(Capture_disabled) {
+    capture->enabled = false;
+    connectAndRead();
+    UA_PacketCapture_Pcapng_flush(capture);
+
+    size_t captured, dropped;
+    UA_PacketCapture_Pcapng_getStatistics(capture, &captured, &dropped);
+    ck_assert_uint_eq(captured, 0);
+
+    /* Enable at runtime */
+    capture->enabled = true;
+    connectAndRead();
+    UA_PacketCapture_Pcapng_getStatistics(capture, &captured, &dropped);
+    ck_assert_uint_gt(captured, 0);
+} END_TEST
+
+int main(void) {
+    Suite *s = suite_create("Server Packet Capture");
+    TCase *tc = tcase_create("pcapng");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, Capture_pcapng);
+    tcase_add_test(tc, Capture_disabled);
+    suite_add_tcase(s, tc);
+
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
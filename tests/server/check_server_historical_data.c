@@ -10,6 +10,8 @@
 #include <open62541/client_highlevel.h>
 #include <open62541/plugin/historydata/history_data_backend.h>
 #include <open62541/plugin/historydata/history_data_backend_memory.h>
+#include <open62541/plugin/historydata/history_data_backend_compressed.h>
+#include <open62541/plugin/historydata/history_data_backend_file.h>
 #include <open62541/plugin/historydata/history_data_gathering_default.h>
 #include <open62541/plugin/historydata/history_database_default.h>
 #include <open62541/plugin/historydatabase.h>
@@ -21,6 +23,10 @@
 #include <check.h>
 #include <stdlib.h>
 #include <stdio.h>
+#ifdef UA_ARCHITECTURE_POSIX
+#include <dirent.h>
+#include <unistd.h>
+#endif
 
 #include "test_helpers.h"
 #include "testing_clock.h"
@@ -925,6 +931,96 @@ START_TEST(Server_HistorizingBackendMemory)
 }
 END_TEST
 
+START_TEST(Server_HistorizingReadRawCursor)
+{
+    UA_HistoryDataBackend backend = UA_HistoryDataBackend_Memory(1, 1000);
+    UA_HistorizingNodeIdSettings setting;
+    setting.historizingBackend = backend;
+    setting.maxHistoryDataResponseSize = 7;
+    setting.historizingUpdateStrategy = UA_HISTORIZINGUPDATESTRATEGY_USER;
+    UA_StatusCode ret = gathering->registerNodeId(server, gathering->context, &outNodeId, setting);
+    ck_assert_str_eq(UA_StatusCode_name(ret), UA_StatusCode_name(UA_STATUSCODE_GOOD));
+
+    for(UA_Int64 i = 0; i < 1000; i++) {
+        UA_DataValue value;
+        UA_DataValue_init(&value);
+        UA_Variant_setScalar(&value.value, &i, &UA_TYPES[UA_TYPES_INT64]);
+        value.hasValue = true;
+        value.hasSourceTimestamp = true;
+        value.sourceTimestamp = (i + 1) * UA_DATETIME_SEC;
+        ret = backend.serverSetHistoryData(server, backend.context, NULL, NULL,
+                                           &outNodeId, false, &value);
+        ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    }
+
+    /* Page through the values in reverse order. Every follow-up call resumes
+     * from the cursor of the continuation point. */
+    UA_ByteString cp = UA_BYTESTRING_NULL;
+    UA_Int64 expected = 999;
+    size_t requests = 0;
+    do {
+        UA_HistoryReadResponse response;
+        UA_HistoryReadResponse_init(&response);
+        requestHistory(1000 * UA_DATETIME_SEC, 0, &response, 0, false, &cp);
+        requests++;
+        ck_assert_uint_eq(response.resultsSize, 1);
+        ck_assert_uint_eq(response.results[0].statusCode, UA_STATUSCODE_GOOD);
+        UA_HistoryData *data = (UA_HistoryData*)
+            response.results[0].historyData.content.decoded.data;
+        ck_assert(data->dataValuesSize > 0 && data->dataValuesSize <= 7);
+        for(size_t j = 0; j < data->dataValuesSize; j++) {
+            ck_assert(data->dataValues[j].value.type == &UA_TYPES[UA_TYPES_INT64]);
+            ck_assert_int_eq(*(UA_Int64*)data->dataValues[j].value.data, expected);
+            expected--;
+        }
+        UA_ByteString_clear(&cp);
+        UA_ByteString_copy(&response.results[0].continuationPoint, &cp);
+        UA_HistoryReadResponse_clear(&response);
+    } while(cp.length > 0);
+    ck_assert_int_eq(expected, -1);
+    ck_assert_uint_eq(requests, (1000 + 6) / 7);
+
+    /* Release a continuation point. It cannot be used afterwards. */
+    UA_HistoryReadResponse response;
+    UA_HistoryReadResponse_init(&response);
+    requestHistory(UA_DATETIME_SEC, 1000 * UA_DATETIME_SEC, &response, 0, false, NULL);
+    ck_assert_uint_eq(response.results[0].statusCode, UA_STATUSCODE_GOOD);
+    ck_assert(response.results[0].continuationPoint.length > 0);
+    UA_ByteString_copy(&response.results[0].continuationPoint, &cp);
+    UA_HistoryReadResponse_clear(&response);
+
+    UA_ReadRawModifiedDetails *details = UA_ReadRawModifiedDetails_new();
+    details->startTime = UA_DATETIME_SEC;
+    details->endTime = 1000 * UA_DATETIME_SEC;
+    UA_HistoryReadValueId *valueId = UA_HistoryReadValueId_new();
+    UA_NodeId_copy(&outNodeId, &valueId->nodeId);
+    UA_ByteString_copy(&cp, &valueId->continuationPoint);
+    UA_HistoryReadRequest request;
+    UA_HistoryReadRequest_init(&request);
+    request.historyReadDetails.encoding = UA_EXTENSIONOBJECT_DECODED;
+    request.historyReadDetails.content.decoded.type = &UA_TYPES[UA_TYPES_READRAWMODIFIEDDETAILS];
+    request.historyReadDetails.content.decoded.data = details;
+    request.timestampsToReturn = UA_TIMESTAMPSTORETURN_BOTH;
+    request.releaseContinuationPoints = true;
+    request.nodesToReadSize = 1;
+    request.nodesToRead = valueId;
+    UA_LOCK(&server->serviceMutex);
+    Service_HistoryRead(server, &server->adminSession, &request, &response);
+    UA_UNLOCK(&server->serviceMutex);
+    UA_HistoryReadRequest_clear(&request);
+    ck_assert_uint_eq(response.results[0].statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.results[0].continuationPoint.length, 0);
+    UA_HistoryReadResponse_clear(&response);
+
+    requestHistory(UA_DATETIME_SEC, 1000 * UA_DATETIME_SEC, &response, 0, false, &cp);
+    ck_assert_uint_eq(response.results[0].statusCode,
+                      UA_STATUSCODE_BADCONTINUATIONPOINTINVALID);
+    UA_HistoryReadResponse_clear(&response);
+    UA_ByteString_clear(&cp);
+    UA_HistoryDataBackend_Memory_clear(&setting.historizingBackend);
+}
+END_TEST
+
 START_TEST(Server_HistorizingRandomIndexBackend)
 {
     UA_HistoryDataBackend backend = UA_HistoryDataBackend_randomindextest(testData);
@@ -953,6 +1049,555 @@ START_TEST(Server_HistorizingRandomIndexBackend)
 }
 END_TEST
 
+START_TEST(Server_HistorizingBackendCompressed)
+{
+    /* Small blocks to test the lookup across blocks */
+    UA_HistoryDataBackend backend = UA_HistoryDataBackend_Compressed(4);
+    UA_HistorizingNodeIdSettings setting;
+    setting.historizingBackend = backend;
+    setting.maxHistoryDataResponseSize = 1000;
+    setting.historizingUpdateStrategy = UA_HISTORIZINGUPDATESTRATEGY_USER;
+    UA_StatusCode ret = gathering->registerNodeId(server, gathering->context, &outNodeId, setting);
+    ck_assert_str_eq(UA_StatusCode_name(ret), UA_StatusCode_name(UA_STATUSCODE_GOOD));
+
+    // empty backend should not crash
+    UA_UInt32 retval = testHistoricalDataBackend(100);
+    fprintf(stderr, "%x tests expected failed.\n", retval);
+
+    // fill backend (not in timestamp order)
+    ck_assert_uint_eq(fillHistoricalDataBackend(backend), true);
+
+    // read all in one
+    retval = testHistoricalDataBackend(100);
+    fprintf(stderr, "%x tests failed.\n", retval);
+    ck_assert_uint_eq(retval, 0);
+
+    // read continuous one at one request
+    retval = testHistoricalDataBackend(1);
+    fprintf(stderr, "%x tests failed.\n", retval);
+    ck_assert_uint_eq(retval, 0);
+
+    // read continuous two at one request
+    retval = testHistoricalDataBackend(2);
+    fprintf(stderr, "%x tests failed.\n", retval);
+    ck_assert_uint_eq(retval, 0);
+    UA_HistoryDataBackend_Compressed_clear(&setting.historizingBackend);
+}
+END_TEST
+
+START_TEST(Server_HistorizingBackendCompressedUpdate)
+{
+    UA_HistoryDataBackend backend = UA_HistoryDataBackend_Compressed(4);
+    UA_HistorizingNodeIdSettings setting;
+    setting.historizingBackend = backend;
+    setting.maxHistoryDataResponseSize = 1000;
+    setting.historizingUpdateStrategy = UA_HISTORIZINGUPDATESTRATEGY_USER;
+    UA_StatusCode ret = gathering->registerNodeId(server, gathering->context, &outNodeId, setting);
+    ck_assert_str_eq(UA_StatusCode_name(ret), UA_StatusCode_name(UA_STATUSCODE_GOOD));
+
+    // fill backend with insert
+    ck_assert_str_eq(UA_StatusCode_name(updateHistory(UA_PERFORMUPDATETYPE_INSERT, testData, NULL, NULL))
+                                        , UA_StatusCode_name(UA_STATUSCODE_GOOD));
+
+    testResult(testDataSorted, NULL);
+
+    // delete some values
+    ck_assert_str_eq(UA_StatusCode_name(deleteHistory(DELETE_START_TIME, DELETE_STOP_TIME)),
+                     UA_StatusCode_name(UA_STATUSCODE_GOOD));
+
+    testResult(testDataAfterDelete, NULL);
+
+    // update all and insert some
+    UA_StatusCode *result = NULL;
+    size_t resultSize = 0;
+    ck_assert_uint_eq(updateHistory(UA_PERFORMUPDATETYPE_UPDATE, testDataSorted, &result, &resultSize),
+                      UA_STATUSCODE_GOOD);
+
+    for (size_t i = 0; i < resultSize; ++i) {
+        ck_assert_str_eq(UA_StatusCode_name(result[i]), UA_StatusCode_name(testDataUpdateResult[i]));
+    }
+    UA_Array_delete(result, resultSize, &UA_TYPES[UA_TYPES_STATUSCODE]);
+
+    UA_HistoryData data;
+    UA_HistoryData_init(&data);
+
+    testResult(testDataSorted, &data);
+
+    for (size_t i = 0; i < data.dataValuesSize; ++i) {
+        ck_assert_uint_eq(data.dataValues[i].hasValue, true);
+        ck_assert(data.dataValues[i].value.type == &UA_TYPES[UA_TYPES_INT64]);
+        ck_assert_int_eq(*((UA_Int64*)data.dataValues[i].value.data), UA_PERFORMUPDATETYPE_UPDATE);
+    }
+
+    UA_HistoryData_clear(&data);
+    UA_HistoryDataBackend_Compressed_clear(&setting.historizingBackend);
+}
+END_TEST
+
+START_TEST(Server_HistorizingBackendCompressedRatio)
+{
+    UA_HistoryDataBackend backend = UA_HistoryDataBackend_Compressed(0);
+    const size_t samples = 10000;
+    const UA_DateTime start = TIMESTAMP_FIRST;
+
+    /* A slowly changing signal with a regular sampling interval. Every 1000th
+     * sample is a String that is not compressed. */
+    for(size_t i = 0; i < samples; i++) {
+        UA_DataValue value;
+        UA_DataValue_init(&value);
+        value.hasValue = true;
+        UA_Double d = (UA_Double)(i / 10) * 0.5;
+        UA_String str = UA_STRING("text");
+        if(i % 1000 == 999)
+            UA_Variant_setScalar(&value.value, &str, &UA_TYPES[UA_TYPES_STRING]);
+        else
+            UA_Variant_setScalar(&value.value, &d, &UA_TYPES[UA_TYPES_DOUBLE]);
+        value.hasSourceTimestamp = true;
+        value.sourceTimestamp = start + (UA_DateTime)i * UA_DATETIME_SEC;
+        value.hasServerTimestamp = true;
+        value.serverTimestamp = value.sourceTimestamp + 5 * UA_DATETIME_MSEC;
+        UA_StatusCode ret = backend.serverSetHistoryData(server, backend.context, NULL, NULL,
+                                                         &outNodeId, true, &value);
+        ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    }
+
+    /* Less than two bytes per sample */
+    size_t usage = UA_HistoryDataBackend_Compressed_memoryUsage(&backend);
+    fprintf(stderr, "%lu bytes for %lu samples.\n",
+            (unsigned long)usage, (unsigned long)samples);
+    ck_assert_uint_lt(usage, samples * 2);
+
+    /* The samples are restored */
+    ck_assert_uint_eq(backend.getEnd(server, backend.context, NULL, NULL, &outNodeId), samples);
+    for(size_t i = 0; i < samples; i += 7) {
+        size_t index = backend.getDateTimeMatch(server, backend.context, NULL, NULL, &outNodeId,
+                                                start + (UA_DateTime)i * UA_DATETIME_SEC,
+                                                MATCH_EQUAL);
+        ck_assert_uint_eq(index, i);
+        const UA_DataValue *value =
+            backend.getDataValue(server, backend.context, NULL, NULL, &outNodeId, index);
+        ck_assert_int_eq(value->serverTimestamp,
+                         value->sourceTimestamp + 5 * UA_DATETIME_MSEC);
+        if(i % 1000 == 999) {
+            UA_String str = UA_STRING("text");
+            ck_assert(value->value.type == &UA_TYPES[UA_TYPES_STRING]);
+            ck_assert(UA_String_equal((UA_String*)value->value.data, &str));
+        } else {
+            ck_assert(value->value.type == &UA_TYPES[UA_TYPES_DOUBLE]);
+            ck_assert(*(UA_Double*)value->value.data == (UA_Double)(i / 10) * 0.5);
+        }
+    }
+
+    UA_HistoryDataBackend_Compressed_clear(&backend);
+}
+END_TEST
+
+#define AGGREGATE_BASE (1000 * UA_DATETIME_SEC)
+
+static void
+requestProcessed(UA_DateTime start, UA_DateTime end, UA_Double interval,
+                 UA_UInt32 aggregate, UA_ByteString *continuationPoint,
+                 UA_HistoryReadResponse *response) {
+    UA_ReadProcessedDetails *details = UA_ReadProcessedDetails_new();
+    details->startTime = start;
+    details->endTime = end;
+    details->processingInterval = interval;
+    details->aggregateTypeSize = 1;
+    details->aggregateType = UA_NodeId_new();
+    *details->aggregateType = UA_NODEID_NUMERIC(0, aggregate);
+
+    UA_HistoryReadValueId *valueId = UA_HistoryReadValueId_new();
+    UA_NodeId_copy(&outNodeId, &valueId->nodeId);
+    if (continuationPoint)
+        UA_ByteString_copy(continuationPoint, &valueId->continuationPoint);
+
+    UA_HistoryReadRequest request;
+    UA_HistoryReadRequest_init(&request);
+    request.historyReadDetails.encoding = UA_EXTENSIONOBJECT_DECODED;
+    request.historyReadDetails.content.decoded.type = &UA_TYPES[UA_TYPES_READPROCESSEDDETAILS];
+    request.historyReadDetails.content.decoded.data = details;
+    request.timestampsToReturn = UA_TIMESTAMPSTORETURN_SOURCE;
+    request.nodesToReadSize = 1;
+    request.nodesToRead = valueId;
+
+    UA_LOCK(&server->serviceMutex);
+    Service_HistoryRead(server, &server->adminSession, &request, response);
+    UA_UNLOCK(&server->serviceMutex);
+    UA_HistoryReadRequest_clear(&request);
+}
+
+static UA_HistoryData *
+processedData(UA_HistoryReadResponse *response) {
+    ck_assert_str_eq(UA_StatusCode_name(response->responseHeader.serviceResult),
+                     UA_StatusCode_name(UA_STATUSCODE_GOOD));
+    ck_assert_uint_eq(response->resultsSize, 1);
+    ck_assert_str_eq(UA_StatusCode_name(response->results[0].statusCode),
+                     UA_StatusCode_name(UA_STATUSCODE_GOOD));
+    ck_assert(response->results[0].historyData.content.decoded.type == &UA_TYPES[UA_TYPES_HISTORYDATA]);
+    return (UA_HistoryData*)response->results[0].historyData.content.decoded.data;
+}
+
+static UA_Double
+processedValue(const UA_DataValue *dv) {
+    ck_assert_uint_eq(dv->hasValue, true);
+    if (dv->value.type == &UA_TYPES[UA_TYPES_INT32])
+        return *(UA_Int32*)dv->value.data;
+    ck_assert(dv->value.type == &UA_TYPES[UA_TYPES_DOUBLE]);
+    return *(UA_Double*)dv->value.data;
+}
+
+/* 100 samples with the values 0 to 99 one second apart, and a bad sample */
+static void
+fillAggregateData(UA_HistoryDataBackend *backend) {
+    for (UA_UInt32 i = 0; i < 100; ++i) {
+        UA_DataValue dv;
+        UA_DataValue_init(&dv);
+        UA_Variant_setScalar(&dv.value, &i, &UA_TYPES[UA_TYPES_UINT32]);
+        dv.hasValue = true;
+        dv.hasSourceTimestamp = true;
+        dv.sourceTimestamp = AGGREGATE_BASE + i * UA_DATETIME_SEC;
+        backend->serverSetHistoryData(server, backend->context, NULL, NULL,
+                                      &outNodeId, true, &dv);
+    }
+    UA_DataValue bad;
+    UA_DataValue_init(&bad);
+    UA_UInt32 badValue = 1000;
+    UA_Variant_setScalar(&bad.value, &badValue, &UA_TYPES[UA_TYPES_UINT32]);
+    bad.hasValue = true;
+    bad.hasStatus = true;
+    bad.status = UA_STATUSCODE_BADSENSORFAILURE;
+    bad.hasSourceTimestamp = true;
+    bad.sourceTimestamp = AGGREGATE_BASE + 5 * UA_DATETIME_SEC + UA_DATETIME_SEC / 2;
+    backend->serverSetHistoryData(server, backend->context, NULL, NULL,
+                                  &outNodeId, true, &bad);
+}
+
+static void
+testAggregates(void) {
+    UA_DateTime start = AGGREGATE_BASE;
+    UA_DateTime end = AGGREGATE_BASE + 100 * UA_DATETIME_SEC;
+    UA_HistoryReadResponse response;
+
+    /* Ten intervals of ten samples */
+    const UA_UInt32 aggregates[5] = {UA_NS0ID_AGGREGATEFUNCTION_AVERAGE,
+                                     UA_NS0ID_AGGREGATEFUNCTION_MINIMUM,
+                                     UA_NS0ID_AGGREGATEFUNCTION_MAXIMUM,
+                                     UA_NS0ID_AGGREGATEFUNCTION_COUNT,
+                                     UA_NS0ID_AGGREGATEFUNCTION_INTERPOLATIVE};
+    const UA_Double offsets[5] = {4.5, 0.0, 9.0, 0.0, 0.0};
+    for (size_t a = 0; a < 5; ++a) {
+        UA_HistoryReadResponse_init(&response);
+        requestProcessed(start, end, 10000.0, aggregates[a], NULL, &response);
+        UA_HistoryData *data = processedData(&response);
+        ck_assert_uint_eq(data->dataValuesSize, 10);
+        for (size_t k = 0; k < 10; ++k) {
+            const UA_DataValue *dv = &data->dataValues[k];
+            ck_assert_uint_eq(dv->hasSourceTimestamp, true);
+            ck_assert_int_eq(dv->sourceTimestamp, start + (UA_DateTime)k * 10 * UA_DATETIME_SEC);
+            ck_assert(UA_StatusCode_isGood(dv->status));
+            UA_Double expected = (aggregates[a] == UA_NS0ID_AGGREGATEFUNCTION_COUNT) ?
+                10.0 : (UA_Double)(k * 10) + offsets[a];
+            ck_assert(processedValue(dv) == expected);
+        }
+        UA_HistoryReadResponse_clear(&response);
+    }
+
+    /* Interpolation between two samples */
+    UA_HistoryReadResponse_init(&response);
+    requestProcessed(start + UA_DATETIME_SEC / 4, end, 0,
+                     UA_NS0ID_AGGREGATEFUNCTION_INTERPOLATIVE, NULL, &response);
+    UA_HistoryData *data = processedData(&response);
+    ck_assert_uint_eq(data->dataValuesSize, 1);
+    ck_assert(processedValue(&data->dataValues[0]) == 0.25);
+    UA_HistoryReadResponse_clear(&response);
+
+    /* Interval without data */
+    UA_HistoryReadResponse_init(&response);
+    requestProcessed(end + UA_DATETIME_SEC, end + 2 * UA_DATETIME_SEC, 0,
+                     UA_NS0ID_AGGREGATEFUNCTION_AVERAGE, NULL, &response);
+    data = processedData(&response);
+    ck_assert_uint_eq(data->dataValuesSize, 1);
+    ck_assert_str_eq(UA_StatusCode_name(data->dataValues[0].status),
+                     UA_StatusCode_name(UA_STATUSCODE_BADNODATA));
+    UA_HistoryReadResponse_clear(&response);
+
+    /* Reverse order */
+    UA_HistoryReadResponse_init(&response);
+    requestProcessed(end, start, 10000.0, UA_NS0ID_AGGREGATEFUNCTION_MAXIMUM,
+                     NULL, &response);
+    data = processedData(&response);
+    ck_assert_uint_eq(data->dataValuesSize, 10);
+    for (size_t k = 0; k < 10; ++k) {
+        ck_assert_int_eq(data->dataValues[k].sourceTimestamp, end - (UA_DateTime)k * 10 * UA_DATETIME_SEC);
+        ck_assert(processedValue(&data->dataValues[k]) == (UA_Double)(99 - k * 10));
+    }
+    UA_HistoryReadResponse_clear(&response);
+
+    /* Paging with continuation points */
+    UA_HistorizingNodeIdSettings setting =
+        *gathering->getHistorizingSetting(server, gathering->context, &outNodeId);
+    setting.maxHistoryDataResponseSize = 4;
+    gathering->updateNodeIdSetting(server, gathering->context, &outNodeId, setting);
+    UA_ByteString cp = UA_BYTESTRING_NULL;
+    size_t k = 0;
+    do {
+        UA_HistoryReadResponse_init(&response);
+        requestProcessed(start, end, 10000.0, UA_NS0ID_AGGREGATEFUNCTION_AVERAGE,
+                         &cp, &response);
+        data = processedData(&response);
+        ck_assert_uint_le(data->dataValuesSize, 4);
+        for (size_t j = 0; j < data->dataValuesSize; ++j, ++k)
+            ck_assert(processedValue(&data->dataValues[j]) == (UA_Double)(k * 10) + 4.5);
+        UA_ByteString_clear(&cp);
+        UA_ByteString_copy(&response.results[0].continuationPoint, &cp);
+        UA_HistoryReadResponse_clear(&response);
+    } while (cp.length > 0);
+    ck_assert_uint_eq(k, 10);
+}
+
+START_TEST(Server_HistorizingReadProcessed)
+{
+    UA_HistorizingNodeIdSettings setting;
+    setting.historizingBackend = UA_HistoryDataBackend_Memory(1, 200);
+    setting.maxHistoryDataResponseSize = 1000;
+    setting.historizingUpdateStrategy = UA_HISTORIZINGUPDATESTRATEGY_USER;
+    UA_StatusCode ret = gathering->registerNodeId(server, gathering->context, &outNodeId, setting);
+    ck_assert_str_eq(UA_StatusCode_name(ret), UA_StatusCode_name(UA_STATUSCODE_GOOD));
+    fillAggregateData(&setting.historizingBackend);
+    testAggregates();
+    UA_HistoryDataBackend_Memory_clear(&setting.historizingBackend);
+}
+END_TEST
+
+START_TEST(Server_HistorizingReadProcessedRollup)
+{
+    /* Small blocks, so that the intervals contain whole and partial blocks */
+    UA_HistorizingNodeIdSettings setting;
+    setting.historizingBackend = UA_HistoryDataBackend_Compressed(8);
+    setting.maxHistoryDataResponseSize = 1000;
+    setting.historizingUpdateStrategy = UA_HISTORIZINGUPDATESTRATEGY_USER;
+    ck_assert_ptr_ne(setting.historizingBackend.getAggregateSummary, NULL);
+    UA_StatusCode ret = gathering->registerNodeId(server, gathering->context, &outNodeId, setting);
+    ck_assert_str_eq(UA_StatusCode_name(ret), UA_StatusCode_name(UA_STATUSCODE_GOOD));
+    fillAggregateData(&setting.historizingBackend);
+    testAggregates();
+
+    /* The cached rollups are invalidated by changes */
+    UA_DataValue dv;
+    UA_DataValue_init(&dv);
+    UA_Double v = 1000.0;
+    UA_Variant_setScalar(&dv.value, &v, &UA_TYPES[UA_TYPES_DOUBLE]);
+    dv.hasValue = true;
+    dv.hasSourceTimestamp = true;
+    dv.sourceTimestamp = AGGREGATE_BASE + 50 * UA_DATETIME_SEC;
+    ret = setting.historizingBackend.replaceDataValue(server, setting.historizingBackend.context,
+                                                      NULL, NULL, &outNodeId, &dv);
+    ck_assert_str_eq(UA_StatusCode_name(ret), UA_StatusCode_name(UA_STATUSCODE_GOOD));
+    UA_HistoryReadResponse response;
+    UA_HistoryReadResponse_init(&response);
+    requestProcessed(AGGREGATE_BASE, AGGREGATE_BASE + 100 * UA_DATETIME_SEC, 0,
+                     UA_NS0ID_AGGREGATEFUNCTION_MAXIMUM, NULL, &response);
+    UA_HistoryData *data = processedData(&response);
+    ck_assert_uint_eq(data->dataValuesSize, 1);
+    ck_assert(processedValue(&data->dataValues[0]) == 1000.0);
+    UA_HistoryReadResponse_clear(&response);
+    UA_HistoryDataBackend_Compressed_clear(&setting.historizingBackend);
+}
+END_TEST
+
+START_TEST(Server_HistorizingGatheringBatched)
+{
+    /* A small queue so that the producer has to store values itself */
+    UA_HistoryDataGathering batched = UA_HistoryDataGathering_Batched(1, 64);
+    ck_assert_ptr_ne(batched.context, NULL);
+
+    UA_HistorizingNodeIdSettings setting;
+    setting.historizingBackend = UA_HistoryDataBackend_Memory(1, 1000);
+    setting.maxHistoryDataResponseSize = 1000;
+    setting.historizingUpdateStrategy = UA_HISTORIZINGUPDATESTRATEGY_VALUESET;
+    UA_StatusCode ret = batched.registerNodeId(server, batched.context, &outNodeId, setting);
+    ck_assert_str_eq(UA_StatusCode_name(ret), UA_StatusCode_name(UA_STATUSCODE_GOOD));
+
+    UA_DataValue dv;
+    UA_DataValue_init(&dv);
+    UA_UInt32 val;
+    UA_Variant_setScalar(&dv.value, &val, &UA_TYPES[UA_TYPES_UINT32]);
+    dv.hasValue = true;
+    dv.hasSourceTimestamp = true;
+    for(val = 0; val < 1000; ++val) {
+        dv.sourceTimestamp = (UA_DateTime)(val + 1) * UA_DATETIME_MSEC;
+        batched.setValue(server, batched.context, NULL, NULL, &outNodeId, true, &dv);
+    }
+
+    /* The reads through the wrapped backend see all queued values */
+    const UA_HistorizingNodeIdSettings *s =
+        batched.getHistorizingSetting(server, batched.context, &outNodeId);
+    ck_assert_ptr_ne(s, NULL);
+    const UA_HistoryDataBackend *b = &s->historizingBackend;
+    size_t first = b->firstIndex(server, b->context, NULL, NULL, &outNodeId);
+    size_t last = b->lastIndex(server, b->context, NULL, NULL, &outNodeId);
+    ck_assert_uint_eq(b->resultSize(server, b->context, NULL, NULL, &outNodeId,
+                                    first, last), 1000);
+    size_t index = first;
+    for(UA_UInt32 i = 0; i < 1000; ++i) {
+        const UA_DataValue *v = b->getDataValue(server, b->context, NULL, NULL,
+                                                &outNodeId, index);
+        ck_assert_ptr_ne(v, NULL);
+        ck_assert_int_eq(v->sourceTimestamp, (UA_DateTime)(i + 1) * UA_DATETIME_MSEC);
+        ck_assert_uint_eq(*(UA_UInt32*)v->value.data, i);
+        index = b->getDateTimeMatch(server, b->context, NULL, NULL, &outNodeId,
+                                    v->sourceTimestamp, MATCH_AFTER);
+    }
+
+    /* Queued values are stored before the gathering is deleted */
+    dv.sourceTimestamp = 1001 * UA_DATETIME_MSEC;
+    batched.setValue(server, batched.context, NULL, NULL, &outNodeId, true, &dv);
+    batched.deleteMembers(&batched);
+    b = &setting.historizingBackend;
+    first = b->firstIndex(server, b->context, NULL, NULL, &outNodeId);
+    last = b->lastIndex(server, b->context, NULL, NULL, &outNodeId);
+    ck_assert_uint_eq(b->resultSize(server, b->context, NULL, NULL, &outNodeId,
+                                    first, last), 1001);
+    UA_HistoryDataBackend_Memory_clear(&setting.historizingBackend);
+}
+END_TEST
+
+#ifdef UA_ARCHITECTURE_POSIX
+static void
+removeDirectory(const char *path) {
+    DIR *dir = opendir(path);
+    ck_assert_ptr_ne(dir, NULL);
+    struct dirent *de;
+    char file[512];
+    while((de = readdir(dir))) {
+        if(strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0)
+            continue;
+        snprintf(file, sizeof(file), "%s/%s", path, de->d_name);
+        unlink(file);
+    }
+    closedir(dir);
+    rmdir(path);
+}
+
+static void
+openFileBackend(UA_HistoryDataBackend *backend, const char *path) {
+    /* Several segments for the test data and a commit every few samples */
+    UA_HistoryDataBackendFileOptions options;
+    memset(&options, 0, sizeof(options));
+    options.segmentDuration = 60 * UA_DATETIME_SEC;
+    options.commitSamples = 4;
+    UA_StatusCode ret = UA_HistoryDataBackend_File(backend, path, &options);
+    ck_assert_str_eq(UA_StatusCode_name(ret), UA_StatusCode_name(UA_STATUSCODE_GOOD));
+}
+
+START_TEST(Server_HistorizingBackendFile)
+{
+    char path[] = "/tmp/open62541_history_XXXXXX";
+    ck_assert_ptr_ne(mkdtemp(path), NULL);
+
+    UA_HistoryDataBackend backend;
+    openFileBackend(&backend, path);
+    UA_HistorizingNodeIdSettings setting;
+    setting.historizingBackend = backend;
+    setting.maxHistoryDataResponseSize = 1000;
+    setting.historizingUpdateStrategy = UA_HISTORIZINGUPDATESTRATEGY_USER;
+    UA_StatusCode ret = gathering->registerNodeId(server, gathering->context, &outNodeId, setting);
+    ck_assert_str_eq(UA_StatusCode_name(ret), UA_StatusCode_name(UA_STATUSCODE_GOOD));
+
+    // empty backend should not crash
+    UA_UInt32 retval = testHistoricalDataBackend(100);
+    fprintf(stderr, "%x tests expected failed.\n", retval);
+
+    // fill backend
+    ck_assert_uint_eq(fillHistoricalDataBackend(backend), true);
+
+    // read all in one
+    retval = testHistoricalDataBackend(100);
+    fprintf(stderr, "%x tests failed.\n", retval);
+    ck_assert_uint_eq(retval, 0);
+
+    // reopen from the segment files
+    UA_HistoryDataBackend_File_clear(&setting.historizingBackend);
+    openFileBackend(&setting.historizingBackend, path);
+    ret = gathering->updateNodeIdSetting(server, gathering->context, &outNodeId, setting);
+    ck_assert_str_eq(UA_StatusCode_name(ret), UA_StatusCode_name(UA_STATUSCODE_GOOD));
+
+    // read continuous one at one request
+    retval = testHistoricalDataBackend(1);
+    fprintf(stderr, "%x tests failed.\n", retval);
+    ck_assert_uint_eq(retval, 0);
+
+    // read continuous two at one request
+    retval = testHistoricalDataBackend(2);
+    fprintf(stderr, "%x tests failed.\n", retval);
+    ck_assert_uint_eq(retval, 0);
+    UA_HistoryDataBackend_File_clear(&setting.historizingBackend);
+    removeDirectory(path);
+}
+END_TEST
+
+START_TEST(Server_HistorizingBackendFileUpdate)
+{
+    char path[] = "/tmp/open62541_history_XXXXXX";
+    ck_assert_ptr_ne(mkdtemp(path), NULL);
+
+    UA_HistoryDataBackend backend;
+    openFileBackend(&backend, path);
+    UA_HistorizingNodeIdSettings setting;
+    setting.historizingBackend = backend;
+    setting.maxHistoryDataResponseSize = 1000;
+    setting.historizingUpdateStrategy = UA_HISTORIZINGUPDATESTRATEGY_USER;
+    UA_StatusCode ret = gathering->registerNodeId(server, gathering->context, &outNodeId, setting);
+    ck_assert_str_eq(UA_StatusCode_name(ret), UA_StatusCode_name(UA_STATUSCODE_GOOD));
+
+    // fill backend with insert
+    ck_assert_str_eq(UA_StatusCode_name(updateHistory(UA_PERFORMUPDATETYPE_INSERT, testData, NULL, NULL))
+                                        , UA_StatusCode_name(UA_STATUSCODE_GOOD));
+
+    // delete some values
+    ck_assert_str_eq(UA_StatusCode_name(deleteHistory(DELETE_START_TIME, DELETE_STOP_TIME)),
+                     UA_StatusCode_name(UA_STATUSCODE_GOOD));
+
+    testResult(testDataAfterDelete, NULL);
+
+    // update all and insert some
+    UA_StatusCode *result = NULL;
+    size_t resultSize = 0;
+    ck_assert_uint_eq(updateHistory(UA_PERFORMUPDATETYPE_UPDATE, testDataSorted, &result, &resultSize),
+                      UA_STATUSCODE_GOOD);
+    for (size_t i = 0; i < resultSize; ++i) {
+        ck_assert_str_eq(UA_StatusCode_name(result[i]), UA_StatusCode_name(testDataUpdateResult[i]));
+    }
+    UA_Array_delete(result, resultSize, &UA_TYPES[UA_TYPES_STATUSCODE]);
+
+    // compact the segments with the replaced samples
+    ret = UA_HistoryDataBackend_File_maintain(&setting.historizingBackend);
+    ck_assert_str_eq(UA_StatusCode_name(ret), UA_StatusCode_name(UA_STATUSCODE_GOOD));
+
+    // reopen from the segment files
+    UA_HistoryDataBackend_File_clear(&setting.historizingBackend);
+    openFileBackend(&setting.historizingBackend, path);
+    ret = gathering->updateNodeIdSetting(server, gathering->context, &outNodeId, setting);
+    ck_assert_str_eq(UA_StatusCode_name(ret), UA_StatusCode_name(UA_STATUSCODE_GOOD));
+
+    UA_HistoryData data;
+    UA_HistoryData_init(&data);
+
+    testResult(testDataSorted, &data);
+
+    for (size_t i = 0; i < data.dataValuesSize; ++i) {
+        ck_assert_uint_eq(data.dataValues[i].hasValue, true);
+        ck_assert(data.dataValues[i].value.type == &UA_TYPES[UA_TYPES_INT64]);
+        ck_assert_int_eq(*((UA_Int64*)data.dataValues[i].value.data), UA_PERFORMUPDATETYPE_UPDATE);
+    }
+
+    UA_HistoryData_clear(&data);
+    UA_HistoryDataBackend_File_clear(&setting.historizingBackend);
+    removeDirectory(path);
+}
+END_TEST
+#endif
+
 static Suite *
 testSuite_Client(void) {
     Suite *s = suite_create("Server Historical Data");
@@ -962,11 +1607,22 @@ testSuite_Client(void) {
     tcase_add_test(tc_server, Server_HistorizingStrategyUser);
     tcase_add_test(tc_server, Server_HistorizingStrategyValueSet);
     tcase_add_test(tc_server, Server_HistorizingBackendMemory);
+    tcase_add_test(tc_server, Server_HistorizingReadRawCursor);
     tcase_add_test(tc_server, Server_HistorizingRandomIndexBackend);
     tcase_add_test(tc_server, Server_HistorizingUpdateDelete);
     tcase_add_test(tc_server, Server_HistorizingUpdateInsert);
     tcase_add_test(tc_server, Server_HistorizingUpdateReplace);
     tcase_add_test(tc_server, Server_HistorizingUpdateUpdate);
+    tcase_add_test(tc_server, Server_HistorizingBackendCompressed);
+    tcase_add_test(tc_server, Server_HistorizingBackendCompressedUpdate);
+    tcase_add_test(tc_server, Server_HistorizingBackendCompressedRatio);
+    tcase_add_test(tc_server, Server_HistorizingGatheringBatched);
+    tcase_add_test(tc_server, Server_HistorizingReadProcessed);
+    tcase_add_test(tc_server, Server_HistorizingReadProcessedRollup);
+#ifdef UA_ARCHITECTURE_POSIX
+    tcase_add_test(tc_server, Server_HistorizingBackendFile);
+    tcase_add_test(tc_server, Server_HistorizingBackendFileUpdate);
+#endif
     suite_add_tcase(s, tc_server);
 
     return s;
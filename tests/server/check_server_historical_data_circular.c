@@ -180,6 +180,7 @@ START_TEST(Server_HistorizingStrategyValueSet) {
     //
     //                  | 10 | 11 | 12 | 13 | 14 | 5 | 6 | 7 | 8 | 9 |
     //
+    // The values are returned in timestamp order, starting with the oldest.
     UA_fakeSleep(100);
     UA_DateTime start = UA_DateTime_now_fake(NULL);
     UA_fakeSleep(100);
@@ -214,10 +215,7 @@ START_TEST(Server_HistorizingStrategyValueSet) {
             ck_assert_uint_eq(data->dataValues[j].hasValue, true);
             ck_assert(data->dataValues[j].value.type == &UA_TYPES[UA_TYPES_UINT32]);
             UA_UInt32 * value = (UA_UInt32 *)data->dataValues[j].value.data;
-            if(j >= 5)
-                ck_assert_uint_eq(*value, j);
-            else
-                ck_assert_uint_eq(*value, j + 10);
+            ck_assert_uint_eq(*value, j + 5);
         }
     }
     UA_HistoryReadResponse_clear(&response);
@@ -225,12 +223,88 @@ START_TEST(Server_HistorizingStrategyValueSet) {
 }
 END_TEST
 
+static void
+setSample(const UA_HistoryDataBackend *backend, UA_UInt32 value, UA_DateTime t) {
+    UA_DataValue dv;
+    UA_DataValue_init(&dv);
+    UA_Variant_setScalar(&dv.value, &value, &UA_TYPES[UA_TYPES_UINT32]);
+    dv.hasValue = true;
+    dv.sourceTimestamp = t;
+    dv.hasSourceTimestamp = true;
+    backend->serverSetHistoryData(server, backend->context, NULL, NULL,
+                                  &outNodeId, true, &dv);
+}
+
+static void
+checkHistory(UA_DateTime start, UA_DateTime end,
+             const UA_UInt32 *expected, size_t expectedSize) {
+    UA_HistoryReadResponse response;
+    UA_HistoryReadResponse_init(&response);
+    requestHistory(start, end, &response, 0, false, NULL);
+    ck_assert_str_eq(UA_StatusCode_name(response.responseHeader.serviceResult),
+                     UA_StatusCode_name(UA_STATUSCODE_GOOD));
+    ck_assert_uint_eq(response.resultsSize, 1);
+    ck_assert_str_eq(UA_StatusCode_name(response.results[0].statusCode),
+                     UA_StatusCode_name(UA_STATUSCODE_GOOD));
+    UA_HistoryData *data = (UA_HistoryData *)response.results[0].historyData.content.decoded.data;
+    ck_assert_uint_eq(data->dataValuesSize, expectedSize);
+    for(size_t j = 0; j < data->dataValuesSize; ++j)
+        ck_assert_uint_eq(*(UA_UInt32 *)data->dataValues[j].value.data, expected[j]);
+    UA_HistoryReadResponse_clear(&response);
+}
+
+START_TEST(Server_HistorizingCircularTimeRange) {
+    UA_HistorizingNodeIdSettings setting;
+    setting.historizingBackend = UA_HistoryDataBackend_Memory_Circular(3, 10);
+    setting.maxHistoryDataResponseSize = 100;
+    setting.historizingUpdateStrategy = UA_HISTORIZINGUPDATESTRATEGY_USER;
+    UA_LOCK(&server->serviceMutex);
+    UA_StatusCode retval = gathering->registerNodeId(server, gathering->context, &outNodeId, setting);
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_str_eq(UA_StatusCode_name(retval), UA_StatusCode_name(UA_STATUSCODE_GOOD));
+    const UA_HistoryDataBackend *backend = &setting.historizingBackend;
+
+    // The buffer wraps around twice. It holds the values 15 to 24.
+    for(UA_UInt32 i = 0; i < 25; ++i)
+        setSample(backend, i, i * UA_DATETIME_SEC);
+    const UA_UInt32 range[4] = {18, 19, 20, 21};
+    checkHistory(18 * UA_DATETIME_SEC, 22 * UA_DATETIME_SEC, range, 4);
+    const UA_UInt32 reverse[4] = {21, 20, 19, 18};
+    checkHistory(21 * UA_DATETIME_SEC, 17 * UA_DATETIME_SEC, reverse, 4);
+
+    // A late sample is sorted in. The oldest sample is dropped.
+    setSample(backend, 100, 20 * UA_DATETIME_SEC + UA_DATETIME_SEC / 2);
+    const UA_UInt32 late[10] = {16, 17, 18, 19, 20, 100, 21, 22, 23, 24};
+    checkHistory(0, 30 * UA_DATETIME_SEC, late, 10);
+
+    // A sample that is older than all samples of a full buffer is not kept
+    setSample(backend, 200, 1 * UA_DATETIME_SEC);
+    checkHistory(0, 30 * UA_DATETIME_SEC, late, 10);
+
+    // Delete samples across the wrap-around
+    retval = backend->removeDataValue(server, backend->context, NULL, NULL, &outNodeId,
+                                      19 * UA_DATETIME_SEC, 22 * UA_DATETIME_SEC);
+    ck_assert_str_eq(UA_StatusCode_name(retval), UA_StatusCode_name(UA_STATUSCODE_GOOD));
+    const UA_UInt32 removed[6] = {16, 17, 18, 22, 23, 24};
+    checkHistory(0, 30 * UA_DATETIME_SEC, removed, 6);
+
+    // New samples fill the free space before older samples are replaced
+    for(UA_UInt32 i = 25; i < 30; ++i)
+        setSample(backend, i, i * UA_DATETIME_SEC);
+    const UA_UInt32 refilled[10] = {17, 18, 22, 23, 24, 25, 26, 27, 28, 29};
+    checkHistory(0, 30 * UA_DATETIME_SEC, refilled, 10);
+
+    UA_HistoryDataBackend_Memory_clear(&setting.historizingBackend);
+}
+END_TEST
+
 static Suite *
 testSuite_Client(void) {
     Suite *s = suite_create("Server Historical Data");
     TCase *tc_server = tcase_create("Server Historical Data Circular");
     tcase_add_checked_fixture(tc_server, setup, teardown);
     tcase_add_test(tc_server, Server_HistorizingStrategyValueSet);
+    tcase_add_test(tc_server, Server_HistorizingCircularTimeRange);
     suite_add_tcase(s, tc_server);
 
     return s;
@@ -0,0 +1,410 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <open62541/plugin/historydata/history_data_gathering_default.h>
+#include <open62541/plugin/historydata/history_database_default.h>
+#include <open62541/plugin/historydata/history_event_backend_memory.h>
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+
+#include <check.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "test_helpers.h"
+#include "server/ua_server_internal.h"
+
+#define EVENTS 100
+#define T0 (UA_DATETIME_UNIX_EPOCH + 1000 * UA_DATETIME_SEC)
+
+static UA_Server *server;
+static UA_NodeId eventType;
+static UA_NodeId subEventType;
+static UA_NodeId emitterId;
+static UA_NodeId sourceA;
+static UA_NodeId sourceB;
+
+/* The selected fields of the stored and the read events */
+static UA_QualifiedName timeName;
+static UA_QualifiedName typeName;
+static UA_QualifiedName sourceName;
+static UA_QualifiedName severityName;
+static UA_QualifiedName messageName;
+
+static UA_SimpleAttributeOperand
+fieldOperand(UA_QualifiedName *name) {
+    UA_SimpleAttributeOperand sao;
+    UA_SimpleAttributeOperand_init(&sao);
+    sao.typeDefinitionId = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEEVENTTYPE);
+    sao.browsePathSize = 1;
+    sao.browsePath = name;
+    sao.attributeId = UA_ATTRIBUTEID_VALUE;
+    return sao;
+}
+
+static void
+addObject(const char *name, const UA_NodeId parent, UA_Byte eventNotifier,
+          UA_NodeId *outId) {
+    UA_ObjectAttributes attr = UA_ObjectAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", (char*)(uintptr_t)name);
+    attr.eventNotifier = eventNotifier;
+    UA_StatusCode retval =
+        UA_Server_addObjectNode(server, UA_NODEID_NULL, parent,
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                UA_QUALIFIEDNAME(1, (char*)(uintptr_t)name),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                attr, NULL, outId);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+}
+
+static void
+addEventType(const char *name, const UA_NodeId parent, UA_NodeId *outId) {
+    UA_ObjectTypeAttributes attr = UA_ObjectTypeAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", (char*)(uintptr_t)name);
+    UA_StatusCode retval =
+        UA_Server_addObjectTypeNode(server, UA_NODEID_NULL, parent,
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+                                    UA_QUALIFIEDNAME(1, (char*)(uintptr_t)name),
+                                    attr, NULL, outId);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+}
+
+static void
+addHistoricalEventFilter(void) {
+    UA_SimpleAttributeOperand select[5];
+    select[0] = fieldOperand(&timeName);
+    select[1] = fieldOperand(&typeName);
+    select[2] = fieldOperand(&sourceName);
+    select[3] = fieldOperand(&severityName);
+    select[4] = fieldOperand(&messageName);
+    UA_EventFilter filter;
+    UA_EventFilter_init(&filter);
+    filter.selectClausesSize = 5;
+    filter.selectClauses = select;
+
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", "HistoricalEventFilter");
+    attr.dataType = UA_TYPES[UA_TYPES_EVENTFILTER].typeId;
+    UA_Variant_setScalar(&attr.value, &filter, &UA_TYPES[UA_TYPES_EVENTFILTER]);
+    UA_StatusCode retval =
+        UA_Server_addVariableNode(server, UA_NODEID_NULL, emitterId,
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_HASPROPERTY),
+                                  UA_QUALIFIEDNAME(0, "HistoricalEventFilter"),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_PROPERTYTYPE),
+                                  attr, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+}
+
+/* Event i has the time T0 + i seconds and the severity 100 + 10 * i. Every
+ * fourth event is of the subtype, every second event comes from sourceB. */
+static void
+emitEvent(UA_UInt32 i) {
+    UA_NodeId eventNodeId;
+    UA_StatusCode retval =
+        UA_Server_createEvent(server, (i % 4 == 0) ? subEventType : eventType,
+                              &eventNodeId);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_DateTime time = T0 + i * UA_DATETIME_SEC;
+    UA_UInt16 severity = (UA_UInt16)(100 + 10 * i);
+    UA_LocalizedText message = UA_LOCALIZEDTEXT("en-US", "Generated Event");
+    retval = UA_Server_writeObjectProperty_scalar(server, eventNodeId, timeName,
+                                                  &time, &UA_TYPES[UA_TYPES_DATETIME]);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    retval = UA_Server_writeObjectProperty_scalar(server, eventNodeId, severityName,
+                                                  &severity, &UA_TYPES[UA_TYPES_UINT16]);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    retval = UA_Server_writeObjectProperty_scalar(server, eventNodeId, messageName,
+                                                  &message, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    retval = UA_Server_triggerEvent(server, eventNodeId, (i % 2) ? sourceB : sourceA,
+                                    NULL, true);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+}
+
+static void setup(void) {
+    timeName = UA_QUALIFIEDNAME(0, "Time");
+    typeName = UA_QUALIFIEDNAME(0, "EventType");
+    sourceName = UA_QUALIFIEDNAME(0, "SourceNode");
+    severityName = UA_QUALIFIEDNAME(0, "Severity");
+    messageName = UA_QUALIFIEDNAME(0, "Message");
+
+    server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    config->historyDatabase =
+        UA_HistoryDatabase_defaultWithEvents(UA_HistoryDataGathering_Default(1),
+                                             UA_HistoryEventBackend_Memory());
+    UA_StatusCode retval = UA_Server_run_startup(server);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    addEventType("HistoryEventType", UA_NODEID_NUMERIC(0, UA_NS0ID_BASEEVENTTYPE),
+                 &eventType);
+    addEventType("HistorySubEventType", eventType, &subEventType);
+    addObject("Emitter", UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+              UA_EVENTNOTIFIER_SUBSCRIBE_TO_EVENT | UA_EVENTNOTIFIER_HISTORY_READ,
+              &emitterId);
+    addObject("SourceA", emitterId, 0, &sourceA);
+    addObject("SourceB", emitterId, 0, &sourceB);
+    addHistoricalEventFilter();
+
+    /* Emit the events out of time order */
+    for(UA_UInt32 i = 0; i < EVENTS; i++)
+        emitEvent((i * 37) % EVENTS);
+}
+
+static void teardown(void) {
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+}
+
+/* Reads the Time, Severity and SourceNode of the events */
+static void
+requestEvents(const UA_NodeId *nodeId, UA_DateTime start, UA_DateTime end,
+              UA_UInt32 numValuesPerNode, const UA_ContentFilter *where,
+              const UA_ByteString *continuationPoint,
+              UA_HistoryReadResponse *response) {
+    UA_SimpleAttributeOperand select[3];
+    select[0] = fieldOperand(&timeName);
+    select[1] = fieldOperand(&severityName);
+    select[2] = fieldOperand(&sourceName);
+
+    UA_ReadEventDetails details;
+    UA_ReadEventDetails_init(&details);
+    details.startTime = start;
+    details.endTime = end;
+    details.numValuesPerNode = numValuesPerNode;
+    details.filter.selectClausesSize = 3;
+    details.filter.selectClauses = select;
+    if(where)
+        details.filter.whereClause = *where;
+
+    UA_HistoryReadValueId valueId;
+    UA_HistoryReadValueId_init(&valueId);
+    valueId.nodeId = *nodeId;
+    if(continuationPoint)
+        valueId.continuationPoint = *continuationPoint;
+
+    UA_HistoryReadRequest request;
+    UA_HistoryReadRequest_init(&request);
+    UA_ExtensionObject_setValue(&request.historyReadDetails, &details,
+                                &UA_TYPES[UA_TYPES_READEVENTDETAILS]);
+    request.timestampsToReturn = UA_TIMESTAMPSTORETURN_SOURCE;
+    request.nodesToReadSize = 1;
+    request.nodesToRead = &valueId;
+
+    UA_HistoryReadResponse_init(response);
+    UA_LOCK(&server->serviceMutex);
+    Service_HistoryRead(server, &server->adminSession, &request, response);
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_uint_eq(response->responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response->resultsSize, 1);
+}
+
+static UA_HistoryEvent *
+historyEvent(UA_HistoryReadResponse *response) {
+    ck_assert_uint_eq(response->results[0].statusCode, UA_STATUSCODE_GOOD);
+    ck_assert(response->results[0].historyData.content.decoded.type ==
+              &UA_TYPES[UA_TYPES_HISTORYEVENT]);
+    return (UA_HistoryEvent*)response->results[0].historyData.content.decoded.data;
+}
+
+/* The index of the event from its time */
+static UA_UInt32
+eventIndex(const UA_HistoryEventFieldList *efl) {
+    ck_assert_uint_eq(efl->eventFieldsSize, 3);
+    ck_assert(UA_Variant_isScalar(&efl->eventFields[0]));
+    ck_assert_uint_eq(efl->eventFields[0].type->typeKind, UA_DATATYPEKIND_DATETIME);
+    UA_DateTime time = *(UA_DateTime*)efl->eventFields[0].data;
+    UA_UInt32 i = (UA_UInt32)((time - T0) / UA_DATETIME_SEC);
+    ck_assert(UA_Variant_hasScalarType(&efl->eventFields[1], &UA_TYPES[UA_TYPES_UINT16]));
+    ck_assert_uint_eq(*(UA_UInt16*)efl->eventFields[1].data, 100 + 10 * i);
+    ck_assert(UA_Variant_hasScalarType(&efl->eventFields[2], &UA_TYPES[UA_TYPES_NODEID]));
+    ck_assert(UA_NodeId_equal((UA_NodeId*)efl->eventFields[2].data,
+                              (i % 2) ? &sourceB : &sourceA));
+    return i;
+}
+
+/* Reads all matching events in [first, last] and checks that they are the
+ * expected events in order */
+static void
+checkEvents(const UA_ContentFilter *where, UA_UInt32 first, UA_UInt32 last,
+            UA_Boolean reverse, UA_UInt32 numValuesPerNode,
+            UA_Boolean (*expected)(UA_UInt32 i)) {
+    UA_DateTime start = T0 + first * UA_DATETIME_SEC;
+    UA_DateTime end = T0 + last * UA_DATETIME_SEC;
+    UA_UInt32 next = reverse ? last : first;
+    UA_Boolean done = false;
+    UA_ByteString continuationPoint = UA_BYTESTRING_NULL;
+    do {
+        UA_HistoryReadResponse response;
+        requestEvents(&emitterId, reverse ? end : start, reverse ? start : end,
+                      numValuesPerNode, where, &continuationPoint, &response);
+        UA_ByteString_clear(&continuationPoint);
+        UA_HistoryEvent *he = historyEvent(&response);
+        if(numValuesPerNode > 0)
+            ck_assert_uint_le(he->eventsSize, numValuesPerNode);
+        for(size_t k = 0; k < he->eventsSize; k++) {
+            UA_UInt32 i = eventIndex(&he->events[k]);
+            while(!expected(next))
+                next = reverse ? next - 1 : next + 1;
+            ck_assert_uint_eq(i, next);
+            next = reverse ? next - 1 : next + 1;
+        }
+        done = (response.results[0].continuationPoint.length == 0);
+        UA_ByteString_copy(&response.results[0].continuationPoint, &continuationPoint);
+        UA_HistoryReadResponse_clear(&response);
+    } while(!done);
+
+    /* No further expected events */
+    while(reverse ? (next >= first && next <= last) : next <= last) {
+        ck_assert(!expected(next));
+        next = reverse ? next - 1 : next + 1;
+    }
+}
+
+static void
+setOperands(UA_ContentFilterElement *e, UA_FilterOperator op,
+            UA_ExtensionObject *operands, size_t operandsSize) {
+    UA_ContentFilterElement_init(e);
+    e->filterOperator = op;
+    e->filterOperands = operands;
+    e->filterOperandsSize = operandsSize;
+}
+
+static UA_Boolean allEvents(UA_UInt32 i) { return true; }
+static UA_Boolean subtypeEvents(UA_UInt32 i) { return i % 4 == 0; }
+static UA_Boolean sourceASevere(UA_UInt32 i) { return i % 2 == 0 && 100 + 10 * i >= 600; }
+static UA_Boolean twoSeverities(UA_UInt32 i) { return i == 0 || i == 10; }
+static UA_Boolean aboveTwoHundred(UA_UInt32 i) { return 100 + 10 * i > 200; }
+
+START_TEST(Server_HistorizingEventsTimeRange) {
+    checkEvents(NULL, 0, EVENTS - 1, false, 0, allEvents);
+    checkEvents(NULL, 0, EVENTS - 1, true, 0, allEvents);
+    checkEvents(NULL, 20, 40, false, 0, allEvents);
+    checkEvents(NULL, 20, 40, true, 0, allEvents);
+
+    /* Continuation points */
+    checkEvents(NULL, 0, EVENTS - 1, false, 30, allEvents);
+    checkEvents(NULL, 5, 95, true, 7, allEvents);
+
+    /* Only the end time, read backwards */
+    UA_HistoryReadResponse response;
+    requestEvents(&emitterId, 0, T0 + 9 * UA_DATETIME_SEC, 3, NULL, NULL, &response);
+    UA_HistoryEvent *he = historyEvent(&response);
+    ck_assert_uint_eq(he->eventsSize, 3);
+    ck_assert_uint_eq(eventIndex(&he->events[0]), 9);
+    ck_assert_uint_eq(eventIndex(&he->events[2]), 7);
+    UA_HistoryReadResponse_clear(&response);
+
+    /* The sources do not have the HistoryRead bit */
+    requestEvents(&sourceA, T0, T0 + EVENTS * UA_DATETIME_SEC, 0, NULL, NULL, &response);
+    ck_assert_uint_eq(response.results[0].statusCode, UA_STATUSCODE_BADUSERACCESSDENIED);
+    UA_HistoryReadResponse_clear(&response);
+} END_TEST
+
+START_TEST(Server_HistorizingEventsFiltered) {
+    /* OfType includes the subtypes */
+    UA_LiteralOperand typeLiteral;
+    UA_Variant_setScalar(&typeLiteral.value, &subEventType, &UA_TYPES[UA_TYPES_NODEID]);
+    UA_ExtensionObject ofTypeOperands[1];
+    UA_ExtensionObject_setValue(&ofTypeOperands[0], &typeLiteral,
+                                &UA_TYPES[UA_TYPES_LITERALOPERAND]);
+    UA_ContentFilterElement ofType;
+    setOperands(&ofType, UA_FILTEROPERATOR_OFTYPE, ofTypeOperands, 1);
+    UA_ContentFilter where;
+    where.elementsSize = 1;
+    where.elements = &ofType;
+    checkEvents(&where, 0, EVENTS - 1, false, 0, subtypeEvents);
+    UA_Variant_setScalar(&typeLiteral.value, &eventType, &UA_TYPES[UA_TYPES_NODEID]);
+    checkEvents(&where, 0, EVENTS - 1, false, 0, allEvents);
+
+    /* AND of the SourceNode and a Severity range, answered by the indexes */
+    UA_SimpleAttributeOperand sourceField = fieldOperand(&sourceName);
+    UA_SimpleAttributeOperand severityField = fieldOperand(&severityName);
+    UA_LiteralOperand sourceLiteral;
+    UA_Variant_setScalar(&sourceLiteral.value, &sourceA, &UA_TYPES[UA_TYPES_NODEID]);
+    UA_UInt32 severity = 600;
+    UA_LiteralOperand severityLiteral;
+    UA_Variant_setScalar(&severityLiteral.value, &severity, &UA_TYPES[UA_TYPES_UINT32]);
+    UA_ElementOperand first = {1};
+    UA_ElementOperand second = {2};
+
+    UA_ExtensionObject andOperands[2];
+    UA_ExtensionObject_setValue(&andOperands[0], &first, &UA_TYPES[UA_TYPES_ELEMENTOPERAND]);
+    UA_ExtensionObject_setValue(&andOperands[1], &second, &UA_TYPES[UA_TYPES_ELEMENTOPERAND]);
+    UA_ExtensionObject sourceOperands[2];
+    UA_ExtensionObject_setValue(&sourceOperands[0], &sourceField,
+                                &UA_TYPES[UA_TYPES_SIMPLEATTRIBUTEOPERAND]);
+    UA_ExtensionObject_setValue(&sourceOperands[1], &sourceLiteral,
+                                &UA_TYPES[UA_TYPES_LITERALOPERAND]);
+    UA_ExtensionObject severityOperands[2];
+    UA_ExtensionObject_setValue(&severityOperands[0], &severityField,
+                                &UA_TYPES[UA_TYPES_SIMPLEATTRIBUTEOPERAND]);
+    UA_ExtensionObject_setValue(&severityOperands[1], &severityLiteral,
+                                &UA_TYPES[UA_TYPES_LITERALOPERAND]);
+
+    UA_ContentFilterElement elements[3];
+    setOperands(&elements[0], UA_FILTEROPERATOR_AND, andOperands, 2);
+    setOperands(&elements[1], UA_FILTEROPERATOR_EQUALS, sourceOperands, 2);
+    setOperands(&elements[2], UA_FILTEROPERATOR_GREATERTHANOREQUAL, severityOperands, 2);
+    where.elementsSize = 3;
+    where.elements = elements;
+    checkEvents(&where, 0, EVENTS - 1, false, 0, sourceASevere);
+    checkEvents(&where, 0, EVENTS - 1, true, 4, sourceASevere);
+
+    /* OR is evaluated on the stored fields */
+    UA_UInt16 severity1 = 100;
+    UA_UInt16 severity2 = 200;
+    UA_LiteralOperand severityLiteral1, severityLiteral2;
+    UA_Variant_setScalar(&severityLiteral1.value, &severity1, &UA_TYPES[UA_TYPES_UINT16]);
+    UA_Variant_setScalar(&severityLiteral2.value, &severity2, &UA_TYPES[UA_TYPES_UINT16]);
+    UA_ExtensionObject severityOperands2[2];
+    severityOperands2[0] = severityOperands[0];
+    UA_ExtensionObject_setValue(&severityOperands[1], &severityLiteral1,
+                                &UA_TYPES[UA_TYPES_LITERALOPERAND]);
+    UA_ExtensionObject_setValue(&severityOperands2[1], &severityLiteral2,
+                                &UA_TYPES[UA_TYPES_LITERALOPERAND]);
+    setOperands(&elements[0], UA_FILTEROPERATOR_OR, andOperands, 2);
+    setOperands(&elements[1], UA_FILTEROPERATOR_EQUALS, severityOperands, 2);
+    setOperands(&elements[2], UA_FILTEROPERATOR_EQUALS, severityOperands2, 2);
+    checkEvents(&where, 0, EVENTS - 1, false, 0, twoSeverities);
+
+    /* The literal first */
+    UA_ExtensionObject swappedOperands[2];
+    swappedOperands[0] = severityOperands2[1];
+    swappedOperands[1] = severityOperands2[0];
+    setOperands(&elements[0], UA_FILTEROPERATOR_LESSTHAN, swappedOperands, 2);
+    where.elementsSize = 1;
+    checkEvents(&where, 0, EVENTS - 1, false, 0, aboveTwoHundred);
+
+    /* Unsupported operator */
+    setOperands(&elements[0], UA_FILTEROPERATOR_LIKE, swappedOperands, 2);
+    UA_HistoryReadResponse response;
+    requestEvents(&emitterId, T0, T0 + EVENTS * UA_DATETIME_SEC, 0, &where, NULL, &response);
+    ck_assert_uint_eq(response.results[0].statusCode,
+                      UA_STATUSCODE_BADFILTEROPERATORUNSUPPORTED);
+    UA_HistoryReadResponse_clear(&response);
+} END_TEST
+
+static Suite *
+testSuite_HistoricalEvents(void) {
+    Suite *s = suite_create("Server Historical Events");
+    TCase *tc_server = tcase_create("Server Historical Events Memory");
+    tcase_add_checked_fixture(tc_server, setup, teardown);
+    tcase_add_test(tc_server, Server_HistorizingEventsTimeRange);
+    tcase_add_test(tc_server, Server_HistorizingEventsFiltered);
+    suite_add_tcase(s, tc_server);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_HistoricalEvents();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr,CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
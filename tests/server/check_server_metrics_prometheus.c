@@ -0,0 +1,251 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/client.h>
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
+#include <open62541/plugin/metrics_prometheus.h>
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+
+#include "test_helpers.h"
+
+#include <check.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "thread_wrapper.h"
+
+#define METRICS_PORT 9464
+
+UA_Server *server;
+UA_Boolean running;
+THREAD_HANDLE server_thread;
+
+THREAD_CALLBACK(serverloop) {
+    while(running)
+        UA_Server_run_iterate(server, true);
+    return 0;
+}
+
+static void setup(void) {
+    server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+    UA_Server_run_startup(server);
+}
+
+static void teardown(void) {
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+}
+
+static UA_Boolean
+contains(const UA_String *s, const char *pattern) {
+    size_t len = strlen(pattern);
+    for(size_t i = 0; i + len <= s->length; i++) {
+        if(memcmp(&s->data[i], pattern, len) == 0)
+            return true;
+    }
+    return false;
+}
+
+START_TEST(Metrics_print) {
+    UA_String out = UA_STRING_NULL;
+    UA_StatusCode res = UA_MetricsExporter_Prometheus_print(server, &out);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(contains(&out, "# TYPE opcua_sessions gauge\nopcua_sessions 0\n"));
+    ck_assert(contains(&out, "opcua_secure_channels 0\n"));
+    ck_assert(contains(&out, "opcua_secured_chunks_total{direction=\"sent\"} 0\n"));
+    ck_assert(contains(&out, "# TYPE opcua_eventloop_timers gauge\n"));
+    ck_assert(contains(&out, "opcua_eventloop_iterations_total "));
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    ck_assert(contains(&out, "opcua_subscriptions 0\n"));
+    ck_assert(contains(&out, "opcua_monitored_items 0\n"));
+#endif
+#ifdef UA_ENABLE_PUBSUB
+    ck_assert(contains(&out, "opcua_pubsub_publish_cycle_overruns_total 0\n"));
+#endif
+    UA_String_clear(&out);
+} END_TEST
+
+START_TEST(Metrics_session) {
+    running = true;
+    THREAD_CREATE(server_thread, serverloop);
+
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode res = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_Variant value;
+    res = UA_Client_readValueAttribute(client,
+                                       UA_NS0ID(SERVER_SERVERSTATUS_CURRENTTIME),
+                                       &value);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_Variant_clear(&value);
+
+    UA_String out = UA_STRING_NULL;
+    res = UA_MetricsExporter_Prometheus_print(server, &out);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(contains(&out, "opcua_sessions 1\n"));
+    ck_assert(contains(&out, "opcua_secure_channels 1\n"));
+    ck_assert(contains(&out, "opcua_sessions_created_total 1\n"));
+#if defined(UA_ENABLE_DIAGNOSTICS) && defined(UA_ENABLE_TYPEDESCRIPTION)
+    ck_assert(contains(&out, "opcua_service_requests_total{service=\"Read\"} 1\n"));
+    ck_assert(contains(&out, "opcua_service_latency_seconds{service=\"Read\","
+                       "quantile=\"0.99\"} "));
+    ck_assert(contains(&out, "opcua_service_latency_seconds_count{service=\"Read\"} 1\n"));
+#endif
+    UA_String_clear(&out);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+
+    running = false;
+    THREAD_JOIN(server_thread);
+} END_TEST
+
+/* HTTP client on the EventLoop of the server */
+static UA_ByteString received;
+static uintptr_t clientConnection;
+static const char *httpRequest;
+
+static void
+httpClientCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
+                   void *application, void **connectionContext,
+                   UA_ConnectionState state, const UA_KeyValueMap *params,
+                   UA_ByteString msg) {
+    if(state == UA_CONNECTIONSTATE_CLOSING) {
+        clientConnection = 0;
+        return;
+    }
+    if(state != UA_CONNECTIONSTATE_ESTABLISHED)
+        return;
+    if(clientConnection == 0) {
+        clientConnection = connectionId;
+        UA_ByteString buf;
+        size_t len = strlen(httpRequest);
+        UA_StatusCode res = cm->allocNetworkBuffer(cm, connectionId, &buf, len);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        memcpy(buf.data, httpRequest, len);
+        res = cm->sendWithConnection(cm, connectionId, &UA_KEYVALUEMAP_NULL, &buf);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+    if(msg.length == 0)
+        return;
+    UA_Byte *data = (UA_Byte*)UA_realloc(received.data, received.length + msg.length);
+    ck_assert(data != NULL);
+    memcpy(data + received.length, msg.data, msg.length);
+    received.data = data;
+    received.length += msg.length;
+}
+
+/* Length of the header including the empty line. Zero if incomplete. */
+static size_t
+headerLength(void) {
+    for(size_t i = 0; i + 3 < received.length; i++) {
+        if(memcmp(&received.data[i], "\r\n\r\n", 4) == 0)
+            return i + 4;
+    }
+    return 0;
+}
+
+static size_t
+contentLength(void) {
+    const char *key = "Content-Length: ";
+    size_t keyLen = strlen(key);
+    size_t hl = headerLength();
+    for(size_t i = 0; i + keyLen < hl; i++) {
+        if(memcmp(&received.data[i], key, keyLen) == 0)
+            return strtoul((const char*)&received.data[i + keyLen], NULL, 10);
+    }
+    return 0;
+}
+
+static UA_Boolean
+responseComplete(void) {
+    size_t hl = headerLength();
+    return (hl > 0 && received.length >= hl + contentLength());
+}
+
+/* Send the request and iterate the server until the response has arrived */
+static void
+httpGet(const char *request) {
+    UA_ByteString_clear(&received);
+    clientConnection = 0;
+    httpRequest = request;
+
+    UA_ConnectionManager *cm = NULL;
+    UA_EventLoop *el = UA_Server_getConfig(server)->eventLoop;
+    UA_String tcpString = UA_STRING("tcp");
+    for(UA_EventSource *es = el->eventSources; es; es = es->next) {
+        if(es->eventSourceType == UA_EVENTSOURCETYPE_CONNECTIONMANAGER &&
+           UA_String_equal(&((UA_ConnectionManager*)es)->protocol, &tcpString))
+            cm = (UA_ConnectionManager*)es;
+    }
+    ck_assert(cm != NULL);
+
+    UA_UInt16 port = METRICS_PORT;
+    UA_String host = UA_STRING("localhost");
+    UA_KeyValuePair params[2];
+    params[0].key = UA_QUALIFIEDNAME(0, "port");
+    UA_Variant_setScalar(&params[0].value, &port, &UA_TYPES[UA_TYPES_UINT16]);
+    params[1].key = UA_QUALIFIEDNAME(0, "address");
+    UA_Variant_setScalar(&params[1].value, &host, &UA_TYPES[UA_TYPES_STRING]);
+    UA_KeyValueMap paramsMap = {2, params};
+    UA_StatusCode res =
+        cm->openConnection(cm, &paramsMap, NULL, (void*)0x01, httpClientCallback);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    for(size_t i = 0; i < 1000 && !responseComplete(); i++)
+        UA_Server_run_iterate(server, false);
+    ck_assert(responseComplete());
+    ck_assert_uint_eq(received.length, headerLength() + contentLength());
+
+    /* Close the client connection */
+    if(clientConnection != 0)
+        cm->closeConnection(cm, clientConnection);
+    for(size_t i = 0; i < 100 && clientConnection != 0; i++)
+        UA_Server_run_iterate(server, false);
+}
+
+START_TEST(Metrics_http) {
+    UA_MetricsExporter *me =
+        UA_MetricsExporter_Prometheus_new(server, NULL, METRICS_PORT);
+    ck_assert(me != NULL);
+
+    httpGet("GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    ck_assert(contains(&received, "HTTP/1.1 200 OK\r\n"));
+    ck_assert(contains(&received, "Content-Type: text/plain; version=0.0.4"));
+    ck_assert(contains(&received, "\r\n\r\n# HELP opcua_secure_channels "));
+    ck_assert(contains(&received, "opcua_eventloop_iterations_total "));
+
+    httpGet("GET /other HTTP/1.1\r\n\r\n");
+    ck_assert(contains(&received, "HTTP/1.1 404 Not Found\r\n"));
+
+    httpGet("POST /metrics HTTP/1.1\r\n\r\n");
+    ck_assert(contains(&received, "HTTP/1.1 405 Method Not Allowed\r\n"));
+
+    UA_ByteString_clear(&received);
+    UA_MetricsExporter_delete(me);
+} END_TEST
+
+static Suite *testSuite_metrics(void) {
+    TCase *tc = tcase_create("Metrics");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, Metrics_print);
+    tcase_add_test(tc, Metrics_session);
+    tcase_add_test(tc, Metrics_http);
+    Suite *s = suite_create("Prometheus Metrics Exporter");
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_metrics();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
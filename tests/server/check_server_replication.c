@@ -0,0 +1,277 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+
+#include "server/ua_server_internal.h"
+#include "server/ua_services.h"
+#include "server/ua_subscription.h"
+
+#include <check.h>
+#include <stdlib.h>
+
+#include "test_helpers.h"
+
+static UA_Server *primary = NULL;
+static UA_Server *standby = NULL;
+static UA_Session *session = NULL;
+static size_t deltas = 0;
+
+static void
+forwardDelta(UA_Server *server, void *context, const UA_ByteString *delta) {
+    UA_StatusCode res = UA_Server_applyReplicationDelta((UA_Server*)context, delta);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    deltas++;
+}
+
+static void setup(void) {
+    deltas = 0;
+    primary = UA_Server_newForUnitTest();
+    ck_assert(primary != NULL);
+    standby = UA_Server_newForUnitTest();
+    ck_assert(standby != NULL);
+    UA_Server_run_startup(primary);
+    UA_Server_run_startup(standby);
+
+    /* Create a Session that counts as activated */
+    UA_CreateSessionRequest request;
+    UA_CreateSessionRequest_init(&request);
+    request.requestedSessionTimeout = UA_UINT32_MAX;
+    UA_LOCK(&primary->serviceMutex);
+    UA_StatusCode res = UA_Server_createSession(primary, NULL, &request, &session);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    session->activated = true;
+    primary->activeSessionCount++;
+    UA_UNLOCK(&primary->serviceMutex);
+
+    /* Connect the standby */
+    res = UA_Server_setReplicationCallback(primary, forwardDelta, standby);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_ByteString state;
+    res = UA_Server_getReplicationState(primary, &state);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    res = UA_Server_applyReplicationDelta(standby, &state);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_ByteString_clear(&state);
+}
+
+static void teardown(void) {
+    UA_Server_run_shutdown(primary);
+    UA_Server_delete(primary);
+    UA_Server_run_shutdown(standby);
+    UA_Server_delete(standby);
+}
+
+static UA_UInt32
+createSubscription(void) {
+    UA_CreateSubscriptionRequest request;
+    UA_CreateSubscriptionRequest_init(&request);
+    request.publishingEnabled = true;
+    request.requestedPublishingInterval = 250.0;
+    request.requestedMaxKeepAliveCount = 20;
+    request.priority = 7;
+
+    UA_CreateSubscriptionResponse response;
+    UA_CreateSubscriptionResponse_init(&response);
+    UA_LOCK(&primary->serviceMutex);
+    Service_CreateSubscription(primary, session, &request, &response);
+    UA_UNLOCK(&primary->serviceMutex);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    UA_UInt32 subscriptionId = response.subscriptionId;
+    UA_CreateSubscriptionResponse_clear(&response);
+    return subscriptionId;
+}
+
+static UA_UInt32
+createMonitoredItem(UA_UInt32 subscriptionId, UA_UInt32 attributeId) {
+    UA_MonitoredItemCreateRequest item;
+    UA_MonitoredItemCreateRequest_init(&item);
+    item.itemToMonitor.nodeId =
+        UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_CURRENTTIME);
+    item.itemToMonitor.attributeId = attributeId;
+    item.monitoringMode = UA_MONITORINGMODE_REPORTING;
+    item.requestedParameters.samplingInterval = 100.0;
+    item.requestedParameters.queueSize = 3;
+
+    UA_CreateMonitoredItemsRequest request;
+    UA_CreateMonitoredItemsRequest_init(&request);
+    request.subscriptionId = subscriptionId;
+    request.timestampsToReturn = UA_TIMESTAMPSTORETURN_BOTH;
+    request.itemsToCreateSize = 1;
+    request.itemsToCreate = &item;
+
+    UA_CreateMonitoredItemsResponse response;
+    UA_CreateMonitoredItemsResponse_init(&response);
+    UA_LOCK(&primary->serviceMutex);
+    Service_CreateMonitoredItems(primary, session, &request, &response);
+    UA_UNLOCK(&primary->serviceMutex);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.resultsSize, 1);
+    ck_assert_uint_eq(response.results[0].statusCode, UA_STATUSCODE_GOOD);
+    UA_UInt32 monitoredItemId = response.results[0].monitoredItemId;
+    UA_CreateMonitoredItemsResponse_clear(&response);
+    return monitoredItemId;
+}
+
+START_TEST(Server_replicationTakeOver) {
+    UA_UInt32 subscriptionId = createSubscription();
+    UA_UInt32 monId1 = createMonitoredItem(subscriptionId, UA_ATTRIBUTEID_VALUE);
+    UA_UInt32 monId2 = createMonitoredItem(subscriptionId, UA_ATTRIBUTEID_BROWSENAME);
+    UA_UInt32 monId3 = createMonitoredItem(subscriptionId, UA_ATTRIBUTEID_DISPLAYNAME);
+
+    /* Delete the second MonitoredItem */
+    UA_DeleteMonitoredItemsRequest delRequest;
+    UA_DeleteMonitoredItemsRequest_init(&delRequest);
+    delRequest.subscriptionId = subscriptionId;
+    delRequest.monitoredItemIdsSize = 1;
+    delRequest.monitoredItemIds = &monId2;
+    UA_DeleteMonitoredItemsResponse delResponse;
+    UA_DeleteMonitoredItemsResponse_init(&delResponse);
+    UA_LOCK(&primary->serviceMutex);
+    Service_DeleteMonitoredItems(primary, session, &delRequest, &delResponse);
+    UA_UNLOCK(&primary->serviceMutex);
+    ck_assert_uint_eq(delResponse.results[0], UA_STATUSCODE_GOOD);
+    UA_DeleteMonitoredItemsResponse_clear(&delResponse);
+
+    /* The deltas are delivered in the next EventLoop iteration */
+    ck_assert_uint_eq(deltas, 0);
+    UA_Server_run_iterate(primary, false);
+    ck_assert_uint_eq(deltas, 1);
+
+    UA_StatusCode res = UA_Server_takeOverReplication(standby);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_LOCK(&standby->serviceMutex);
+    UA_Session *s = getSessionByToken(standby, &session->authenticationToken);
+    ck_assert_ptr_ne(s, NULL);
+    ck_assert(UA_NodeId_equal(&s->sessionId, &session->sessionId));
+    ck_assert(s->activated);
+    ck_assert(UA_ByteString_equal(&s->serverNonce, &session->serverNonce));
+
+    UA_Subscription *sub = UA_Session_getSubscriptionById(s, subscriptionId);
+    ck_assert_ptr_ne(sub, NULL);
+    ck_assert(sub->publishingInterval == 250.0);
+    ck_assert_uint_eq(sub->maxKeepAliveCount, 20);
+    ck_assert_uint_eq(sub->priority, 7);
+    ck_assert_uint_eq(sub->state, UA_SUBSCRIPTIONSTATE_ENABLED);
+    ck_assert_uint_eq(sub->monitoredItemsSize, 2);
+
+    UA_MonitoredItem *mon = UA_Subscription_getMonitoredItem(sub, monId1);
+    ck_assert_ptr_ne(mon, NULL);
+    ck_assert_uint_eq(mon->itemToMonitor.attributeId, UA_ATTRIBUTEID_VALUE);
+    ck_assert_uint_eq(mon->timestampsToReturn, UA_TIMESTAMPSTORETURN_BOTH);
+    ck_assert_uint_eq(mon->parameters.queueSize, 3);
+    ck_assert_ptr_eq(UA_Subscription_getMonitoredItem(sub, monId2), NULL);
+    mon = UA_Subscription_getMonitoredItem(sub, monId3);
+    ck_assert_ptr_ne(mon, NULL);
+    ck_assert_uint_eq(mon->itemToMonitor.attributeId, UA_ATTRIBUTEID_DISPLAYNAME);
+
+    /* New identifiers do not collide with the restored ones */
+    ck_assert_uint_ge(standby->lastSubscriptionId, subscriptionId);
+    ck_assert_uint_ge(sub->lastMonitoredItemId, monId3);
+    UA_UNLOCK(&standby->serviceMutex);
+} END_TEST
+
+START_TEST(Server_replicationSequenceNumber) {
+    UA_UInt32 subscriptionId = createSubscription();
+    UA_Server_run_iterate(primary, false);
+
+    /* Advance the sequence number as a publish with notifications does */
+    UA_LOCK(&primary->serviceMutex);
+    UA_Subscription *sub = UA_Session_getSubscriptionById(session, subscriptionId);
+    ck_assert_ptr_ne(sub, NULL);
+    sub->nextSequenceNumber = 42;
+    replicateSequenceNumber(primary, sub);
+    UA_UNLOCK(&primary->serviceMutex);
+    UA_Server_run_iterate(primary, false);
+
+    UA_StatusCode res = UA_Server_takeOverReplication(standby);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_LOCK(&standby->serviceMutex);
+    sub = getSubscriptionById(standby, subscriptionId);
+    ck_assert_ptr_ne(sub, NULL);
+    ck_assert_uint_eq(sub->nextSequenceNumber, 42);
+    UA_UNLOCK(&standby->serviceMutex);
+} END_TEST
+
+START_TEST(Server_replicationRemove) {
+    UA_UInt32 subscriptionId = createSubscription();
+    createMonitoredItem(subscriptionId, UA_ATTRIBUTEID_VALUE);
+    UA_Server_run_iterate(primary, false);
+
+    /* Removing the Session also removes its Subscriptions */
+    UA_NodeId token = session->authenticationToken;
+    UA_LOCK(&primary->serviceMutex);
+    UA_StatusCode res =
+        UA_Server_removeSessionByToken(primary, &token, UA_SHUTDOWNREASON_CLOSE);
+    UA_UNLOCK(&primary->serviceMutex);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_Server_run_iterate(primary, false);
+
+    res = UA_Server_takeOverReplication(standby);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_LOCK(&standby->serviceMutex);
+    ck_assert_ptr_eq(getSessionByToken(standby, &token), NULL);
+    ck_assert_ptr_eq(getSubscriptionById(standby, subscriptionId), NULL);
+    ck_assert_uint_eq(standby->sessionCount, 0);
+    UA_UNLOCK(&standby->serviceMutex);
+} END_TEST
+
+START_TEST(Server_replicationFullState) {
+    UA_UInt32 subscriptionId = createSubscription();
+    UA_UInt32 monId = createMonitoredItem(subscriptionId, UA_ATTRIBUTEID_VALUE);
+
+    /* A new standby is synchronized from the full state */
+    UA_Server *standby2 = UA_Server_newForUnitTest();
+    ck_assert(standby2 != NULL);
+    UA_ByteString state;
+    UA_StatusCode res = UA_Server_getReplicationState(primary, &state);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    res = UA_Server_applyReplicationDelta(standby2, &state);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* A truncated delta is rejected */
+    state.length--;
+    res = UA_Server_applyReplicationDelta(standby2, &state);
+    ck_assert_uint_ne(res, UA_STATUSCODE_GOOD);
+    state.length++;
+    res = UA_Server_applyReplicationDelta(standby2, &state);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_ByteString_clear(&state);
+
+    res = UA_Server_takeOverReplication(standby2);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_LOCK(&standby2->serviceMutex);
+    UA_Subscription *sub = getSubscriptionById(standby2, subscriptionId);
+    ck_assert_ptr_ne(sub, NULL);
+    ck_assert_ptr_ne(sub->session, NULL);
+    ck_assert(UA_NodeId_equal(&sub->session->sessionId, &session->sessionId));
+    ck_assert_ptr_ne(UA_Subscription_getMonitoredItem(sub, monId), NULL);
+    UA_UNLOCK(&standby2->serviceMutex);
+    UA_Server_delete(standby2);
+} END_TEST
+
+static Suite * testSuite_Replication(void) {
+    Suite *s = suite_create("Server Replication");
+    TCase *tc = tcase_create("Core");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, Server_replicationTakeOver);
+    tcase_add_test(tc, Server_replicationSequenceNumber);
+    tcase_add_test(tc, Server_replicationRemove);
+    tcase_add_test(tc, Server_replicationFullState);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    int number_failed = 0;
+    Suite *s = testSuite_Replication();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed += srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,319 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/client.h>
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+
+#include "server/ua_server_internal.h"
+#include "test_helpers.h"
+
+#include <check.h>
+#include <stdlib.h>
+
+#include "thread_wrapper.h"
+
+#define READ_REQUESTS 20
+
+UA_Server *server;
+UA_Boolean running;
+THREAD_HANDLE server_thread;
+
+THREAD_CALLBACK(serverloop) {
+    while(running)
+        UA_Server_run_iterate(server, true);
+    return 0;
+}
+
+static void setup(void) {
+    running = true;
+    server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+    UA_Server_run_startup(server);
+    THREAD_CREATE(server_thread, serverloop);
+}
+
+static void teardown(void) {
+    running = false;
+    THREAD_JOIN(server_thread);
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+}
+
+static UA_Client *
+connectClient(void) {
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode res = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    return client;
+}
+
+/* Send Read requests with two nodes each */
+static void
+sendReads(UA_Client *client, size_t count) {
+    UA_ReadValueId rvi[2];
+    UA_ReadValueId_init(&rvi[0]);
+    UA_ReadValueId_init(&rvi[1]);
+    rvi[0].nodeId = UA_NS0ID(SERVER_SERVERSTATUS_CURRENTTIME);
+    rvi[0].attributeId = UA_ATTRIBUTEID_VALUE;
+    rvi[1].nodeId = UA_NS0ID(SERVER_SERVERSTATUS_STATE);
+    rvi[1].attributeId = UA_ATTRIBUTEID_VALUE;
+    UA_ReadRequest req;
+    UA_ReadRequest_init(&req);
+    req.nodesToRead = rvi;
+    req.nodesToReadSize = 2;
+    for(size_t i = 0; i < count; i++) {
+        UA_ReadResponse resp = UA_Client_Service_read(client, req);
+        ck_assert_uint_eq(resp.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+        UA_ReadResponse_clear(&resp);
+    }
+}
+
+START_TEST(LatencyHistogram_percentiles) {
+    UA_LatencyHistogram h;
+    memset(&h, 0, sizeof(UA_LatencyHistogram));
+    for(u64 v = 1; v <= 10000; v++)
+        UA_LatencyHistogram_record(&h, v);
+    ck_assert_uint_eq(h.count, 10000);
+    ck_assert_uint_eq(h.max, 10000);
+
+    /* The relative error is below 12.5% */
+    u64 p50 = UA_LatencyHistogram_percentile(&h, 0.5);
+    ck_assert(p50 >= 5000 && p50 <= 5625);
+    u64 p99 = UA_LatencyHistogram_percentile(&h, 0.99);
+    ck_assert(p99 >= 9900 && p99 <= 10000);
+    ck_assert_uint_eq(UA_LatencyHistogram_percentile(&h, 1.0), 10000);
+
+    /* Merging keeps the distribution */
+    UA_LatencyHistogram h2;
+    memset(&h2, 0, sizeof(UA_LatencyHistogram));
+    UA_LatencyHistogram_merge(&h2, &h);
+    UA_LatencyHistogram_merge(&h2, &h);
+    ck_assert_uint_eq(h2.count, 20000);
+    ck_assert_uint_eq(UA_LatencyHistogram_percentile(&h2, 0.5), p50);
+
+    /* Values beyond the range end up in the last bucket */
+    UA_LatencyHistogram_record(&h, (u64)1 << 50);
+    ck_assert_uint_eq(UA_LatencyHistogram_percentile(&h, 1.0), (u64)1 << 50);
+} END_TEST
+
+START_TEST(ServiceStatistics_read) {
+    UA_Client *client = connectClient();
+    sendReads(client, READ_REQUESTS);
+
+    UA_ServiceStatistics stats;
+    UA_StatusCode res =
+        UA_Server_getServiceStatistics(server, &UA_TYPES[UA_TYPES_READREQUEST], &stats);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    /* The client reads the namespace array during the connect */
+    ck_assert_uint_ge(stats.requestCount, READ_REQUESTS);
+    ck_assert_uint_ge(stats.operationCount, 2 * READ_REQUESTS);
+    ck_assert_uint_eq(stats.errorCount, 0);
+    ck_assert_uint_eq(stats.asyncCount, 0);
+    /* The latencies are zero with the frozen clock of the unit tests */
+    ck_assert(stats.latencyP50 <= stats.latencyP99);
+    ck_assert(stats.latencyP99 <= stats.latencyMax);
+
+    /* The combined statistics include the session services */
+    UA_ServiceStatistics all;
+    res = UA_Server_getServiceStatistics(server, NULL, &all);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_uint_gt(all.requestCount, stats.requestCount);
+
+    /* Unknown service */
+    res = UA_Server_getServiceStatistics(server, &UA_TYPES[UA_TYPES_INT32], &stats);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADSERVICEUNSUPPORTED);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+} END_TEST
+
+START_TEST(ServiceStatistics_session) {
+    UA_Client *client1 = connectClient();
+    UA_Client *client2 = connectClient();
+    sendReads(client1, READ_REQUESTS);
+
+    /* Find the two sessions in the server */
+    UA_NodeId sessionIds[2];
+    size_t sessions = 0;
+    UA_LOCK(&server->serviceMutex);
+    session_list_entry *sentry;
+    LIST_FOREACH(sentry, &server->sessions, pointers) {
+        ck_assert(sessions < 2);
+        UA_NodeId_copy(&sentry->session.sessionId, &sessionIds[sessions++]);
+    }
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_uint_eq(sessions, 2);
+
+    /* Only one of the sessions sent the reads */
+    UA_ServiceStatistics s1, s2;
+    UA_StatusCode res = UA_Server_getSessionServiceStatistics(server, &sessionIds[0], &s1);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    res = UA_Server_getSessionServiceStatistics(server, &sessionIds[1], &s2);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_UInt64 busy = (s1.requestCount > s2.requestCount) ? s1.requestCount : s2.requestCount;
+    UA_UInt64 idle = (s1.requestCount > s2.requestCount) ? s2.requestCount : s1.requestCount;
+    ck_assert_uint_ge(busy, READ_REQUESTS);
+    ck_assert_uint_lt(idle, READ_REQUESTS);
+
+    /* Reset */
+    UA_Server_resetServiceStatistics(server);
+    res = UA_Server_getSessionServiceStatistics(server, &sessionIds[0], &s1);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(s1.requestCount, 0);
+    ck_assert(s1.latencyMax == 0.0);
+
+    UA_NodeId unknown = UA_NODEID_GUID(1, UA_GUID_NULL);
+    res = UA_Server_getSessionServiceStatistics(server, &unknown, &s1);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADSESSIONIDINVALID);
+
+    UA_NodeId_clear(&sessionIds[0]);
+    UA_NodeId_clear(&sessionIds[1]);
+    UA_Client_disconnect(client1);
+    UA_Client_disconnect(client2);
+    UA_Client_delete(client1);
+    UA_Client_delete(client2);
+} END_TEST
+
+static const UA_Variant *
+findKey(const UA_Variant *v, const char *key) {
+    const UA_KeyValuePair *kv = (const UA_KeyValuePair*)v->data;
+    for(size_t i = 0; i < v->arrayLength; i++) {
+        UA_String k = UA_STRING((char*)(uintptr_t)key);
+        if(UA_String_equal(&kv[i].key.name, &k))
+            return &kv[i].value;
+    }
+    return NULL;
+}
+
+START_TEST(ServiceStatistics_nodes) {
+    UA_Client *client = connectClient();
+    UA_Server_resetServiceStatistics(server);
+    sendReads(client, READ_REQUESTS);
+
+    /* The server-wide statistics of the Read service */
+    UA_Variant v;
+    UA_StatusCode res =
+        UA_Client_readValueAttribute(client, UA_NODEID_STRING(1, "ServiceStatistics.Read"), &v);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(v.type == &UA_TYPES[UA_TYPES_KEYVALUEPAIR]);
+    const UA_Variant *count = findKey(&v, "RequestCount");
+    ck_assert(count != NULL);
+    ck_assert(count->type == &UA_TYPES[UA_TYPES_UINT64]);
+    ck_assert_uint_eq(*(UA_UInt64*)count->data, READ_REQUESTS);
+    const UA_Variant *ops = findKey(&v, "OperationCount");
+    ck_assert(ops != NULL);
+    ck_assert_uint_eq(*(UA_UInt64*)ops->data, 2 * READ_REQUESTS);
+    const UA_Variant *p99 = findKey(&v, "LatencyP99");
+    ck_assert(p99 != NULL);
+    ck_assert(p99->type == &UA_TYPES[UA_TYPES_DOUBLE]);
+    UA_Variant_clear(&v);
+
+    /* The statistics below the session diagnostics object */
+    UA_BrowsePath bp;
+    UA_BrowsePath_init(&bp);
+    UA_RelativePathElement rpe[2];
+    UA_RelativePathElement_init(&rpe[0]);
+    UA_RelativePathElement_init(&rpe[1]);
+    rpe[0].referenceTypeId = UA_NS0ID(HASCOMPONENT);
+    rpe[1].referenceTypeId = UA_NS0ID(HASCOMPONENT);
+    rpe[1].targetName = UA_QUALIFIEDNAME(1, "ServiceStatistics");
+    UA_LOCK(&server->serviceMutex);
+    UA_Session *session = &LIST_FIRST(&server->sessions)->session;
+    UA_QualifiedName sessionName = UA_QUALIFIEDNAME(0, "");
+    UA_String_copy(&session->sessionName, &sessionName.name);
+    UA_UNLOCK(&server->serviceMutex);
+    rpe[0].targetName = sessionName;
+    bp.startingNode = UA_NS0ID(SERVER_SERVERDIAGNOSTICS_SESSIONSDIAGNOSTICSSUMMARY);
+    bp.relativePath.elements = rpe;
+    bp.relativePath.elementsSize = 2;
+    UA_BrowsePathResult bpr = UA_Server_translateBrowsePathToNodeIds(server, &bp);
+    ck_assert_uint_eq(bpr.statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(bpr.targetsSize, 1);
+
+    res = UA_Client_readValueAttribute(client, bpr.targets[0].targetId.nodeId, &v);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    count = findKey(&v, "RequestCount");
+    ck_assert(count != NULL);
+    ck_assert_uint_ge(*(UA_UInt64*)count->data, READ_REQUESTS);
+    UA_Variant_clear(&v);
+
+    UA_BrowsePathResult_clear(&bpr);
+    UA_QualifiedName_clear(&sessionName);
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+} END_TEST
+
+START_TEST(SessionDiagnostics_counters) {
+    UA_Client *client = connectClient();
+    sendReads(client, READ_REQUESTS);
+
+    /* The counters are not reset with the service statistics */
+    UA_Server_resetServiceStatistics(server);
+
+    UA_BrowsePath bp;
+    UA_BrowsePath_init(&bp);
+    UA_RelativePathElement rpe[2];
+    UA_RelativePathElement_init(&rpe[0]);
+    UA_RelativePathElement_init(&rpe[1]);
+    rpe[0].referenceTypeId = UA_NS0ID(HASCOMPONENT);
+    rpe[1].referenceTypeId = UA_NS0ID(HASCOMPONENT);
+    rpe[1].targetName = UA_QUALIFIEDNAME(0, "SessionDiagnostics");
+    UA_LOCK(&server->serviceMutex);
+    UA_Session *session = &LIST_FIRST(&server->sessions)->session;
+    UA_QualifiedName sessionName = UA_QUALIFIEDNAME(0, "");
+    UA_String_copy(&session->sessionName, &sessionName.name);
+    UA_UNLOCK(&server->serviceMutex);
+    rpe[0].targetName = sessionName;
+    bp.startingNode = UA_NS0ID(SERVER_SERVERDIAGNOSTICS_SESSIONSDIAGNOSTICSSUMMARY);
+    bp.relativePath.elements = rpe;
+    bp.relativePath.elementsSize = 2;
+    UA_BrowsePathResult bpr = UA_Server_translateBrowsePathToNodeIds(server, &bp);
+    ck_assert_uint_eq(bpr.statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(bpr.targetsSize, 1);
+
+    UA_Variant v;
+    UA_StatusCode res =
+        UA_Client_readValueAttribute(client, bpr.targets[0].targetId.nodeId, &v);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(v.type == &UA_TYPES[UA_TYPES_SESSIONDIAGNOSTICSDATATYPE]);
+    UA_SessionDiagnosticsDataType *sd = (UA_SessionDiagnosticsDataType*)v.data;
+    ck_assert_uint_ge(sd->readCount.totalCount, READ_REQUESTS);
+    ck_assert_uint_eq(sd->readCount.errorCount, 0);
+    ck_assert_uint_gt(sd->totalRequestCount.totalCount, sd->readCount.totalCount);
+    ck_assert_uint_eq(sd->writeCount.totalCount, 0);
+    UA_Variant_clear(&v);
+
+    UA_BrowsePathResult_clear(&bpr);
+    UA_QualifiedName_clear(&sessionName);
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+} END_TEST
+
+static Suite *testSuite_ServiceStatistics(void) {
+    Suite *s = suite_create("ServiceStatistics");
+    TCase *tc_hist = tcase_create("LatencyHistogram");
+    tcase_add_test(tc_hist, LatencyHistogram_percentiles);
+    suite_add_tcase(s, tc_hist);
+    TCase *tc = tcase_create("Server");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, ServiceStatistics_read);
+    tcase_add_test(tc, ServiceStatistics_session);
+    tcase_add_test(tc, ServiceStatistics_nodes);
+    tcase_add_test(tc, SessionDiagnostics_counters);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_ServiceStatistics();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr,CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -972,6 +972,48 @@ START_TEST(WriteSingleAttributeValueRangeFromArray) {
     ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
 } END_TEST
 
+START_TEST(WriteSingleAttributeValueShared) {
+    UA_Server_getConfig(server)->sharedValueThreshold = 16;
+
+    UA_Int32 myArray[9] = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+    UA_UInt32 myArrayDimensions[2] = {3, 3};
+    UA_WriteValue wValue;
+    UA_WriteValue_init(&wValue);
+    UA_Variant_setArray(&wValue.value.value, myArray, 9, &UA_TYPES[UA_TYPES_INT32]);
+    wValue.value.value.arrayDimensions = myArrayDimensions;
+    wValue.value.value.arrayDimensionsSize = 2;
+    wValue.value.hasValue = true;
+    wValue.nodeId = UA_NODEID_STRING(1, "myarray");
+    wValue.attributeId = UA_ATTRIBUTEID_VALUE;
+    UA_StatusCode retval = UA_Server_write(server, &wValue);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Both reads reference the same buffer */
+    UA_ReadValueId rvi;
+    UA_ReadValueId_init(&rvi);
+    rvi.nodeId = UA_NODEID_STRING(1, "myarray");
+    rvi.attributeId = UA_ATTRIBUTEID_VALUE;
+    UA_DataValue resp1 = UA_Server_read(server, &rvi, UA_TIMESTAMPSTORETURN_NEITHER);
+    UA_DataValue resp2 = UA_Server_read(server, &rvi, UA_TIMESTAMPSTORETURN_NEITHER);
+    ck_assert_uint_eq(resp1.value.storageType, UA_VARIANT_DATA_SHARED);
+    ck_assert_ptr_eq(resp1.value.data, resp2.value.data);
+    ck_assert_int_eq(((UA_Int32*)resp1.value.data)[0], 1);
+
+    /* Writing a range does not change the values that were read before */
+    UA_Int32 myInteger = 20;
+    UA_Variant_setScalar(&wValue.value.value, &myInteger, &UA_TYPES[UA_TYPES_INT32]);
+    wValue.indexRange = UA_STRING("0,0");
+    retval = UA_Server_write(server, &wValue);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    UA_DataValue resp3 = UA_Server_read(server, &rvi, UA_TIMESTAMPSTORETURN_NEITHER);
+    ck_assert_int_eq(((UA_Int32*)resp1.value.data)[0], 1);
+    ck_assert_int_eq(((UA_Int32*)resp3.value.data)[0], 20);
+
+    UA_DataValue_clear(&resp1);
+    UA_DataValue_clear(&resp2);
+    UA_DataValue_clear(&resp3);
+} END_TEST
+
 START_TEST(WriteSingleAttributeDataType) {
     UA_WriteValue wValue;
     UA_WriteValue_init(&wValue);
@@ -1083,6 +1125,221 @@ START_TEST(WriteSingleDataSourceAttributeValue) {
     ck_assert_int_eq(retval, UA_STATUSCODE_BADWRITENOTSUPPORTED);
 } END_TEST
 
+/* The writes are grouped by node. Each write keeps its own result and the
+ * writes to the same node are applied in the order of the request. */
+START_TEST(WriteMultipleAttributesGroupedByNode) {
+    UA_Int32 values[2] = {1, 2};
+    UA_LocalizedText name = UA_LOCALIZEDTEXT("locale", "grouped");
+    UA_WriteValue wv[6];
+    for(size_t i = 0; i < 6; i++) {
+        UA_WriteValue_init(&wv[i]);
+        wv[i].attributeId = UA_ATTRIBUTEID_VALUE;
+        wv[i].value.hasValue = true;
+        UA_Variant_setScalar(&wv[i].value.value, &values[i / 3], &UA_TYPES[UA_TYPES_INT32]);
+    }
+    wv[0].nodeId = UA_NODEID_STRING(1, "the.answer");
+    wv[1].nodeId = UA_NODEID_STRING(1, "unknown");
+    wv[2].nodeId = UA_NODEID_STRING(1, "the.answer");
+    wv[2].attributeId = UA_ATTRIBUTEID_DISPLAYNAME;
+    UA_Variant_setScalar(&wv[2].value.value, &name, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+    wv[3].nodeId = UA_NODEID_STRING(1, "cpu.temperature");
+    wv[4].nodeId = UA_NODEID_STRING(1, "the.answer");
+    wv[5].nodeId = UA_NODEID_STRING(1, "unknown");
+
+    UA_WriteRequest request;
+    UA_WriteRequest_init(&request);
+    request.nodesToWrite = wv;
+    request.nodesToWriteSize = 6;
+    UA_WriteResponse response;
+    UA_WriteResponse_init(&response);
+    UA_LOCK(&server->serviceMutex);
+    Service_Write(server, &server->adminSession, &request, &response);
+    UA_UNLOCK(&server->serviceMutex);
+
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.resultsSize, 6);
+    ck_assert_uint_eq(response.results[0], UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.results[1], UA_STATUSCODE_BADNODEIDUNKNOWN);
+    ck_assert_uint_eq(response.results[2], UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.results[3], UA_STATUSCODE_BADWRITENOTSUPPORTED);
+    ck_assert_uint_eq(response.results[4], UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.results[5], UA_STATUSCODE_BADNODEIDUNKNOWN);
+    UA_WriteResponse_clear(&response);
+
+    /* The last write to the value wins */
+    UA_Variant value;
+    UA_StatusCode retval =
+        UA_Server_readValue(server, UA_NODEID_STRING(1, "the.answer"), &value);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasScalarType(&value, &UA_TYPES[UA_TYPES_INT32]));
+    ck_assert_int_eq(*(UA_Int32*)value.data, 2);
+    UA_Variant_clear(&value);
+
+    UA_LocalizedText displayName;
+    retval = UA_Server_readDisplayName(server, UA_NODEID_STRING(1, "the.answer"),
+                                       &displayName);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(UA_String_equal(&displayName.text, &name.text));
+    UA_LocalizedText_clear(&displayName);
+} END_TEST
+
+START_TEST(ValueHandleReadWrite) {
+    UA_NodeId nodeId = UA_NODEID_STRING(1, "the.answer");
+    UA_ValueHandle *handle = NULL;
+    UA_StatusCode retval = UA_Server_getValueHandle(server, nodeId, &handle);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_Int32 i = 0;
+    retval = UA_Server_readValueHandle(server, handle, &UA_TYPES[UA_TYPES_INT32], &i);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(i, 42);
+
+    /* Written in place */
+    i = 43;
+    retval = UA_Server_writeValueHandle(server, handle, &UA_TYPES[UA_TYPES_INT32], &i);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    i = 0;
+    retval = UA_Server_readValueHandle(server, handle, &UA_TYPES[UA_TYPES_INT32], &i);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(i, 43);
+
+    UA_Variant value;
+    retval = UA_Server_readValue(server, nodeId, &value);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasScalarType(&value, &UA_TYPES[UA_TYPES_INT32]));
+    ck_assert_int_eq(*(UA_Int32*)value.data, 43);
+    UA_Variant_clear(&value);
+
+    /* Changes from the regular write are visible */
+    i = 44;
+    UA_Variant_setScalar(&value, &i, &UA_TYPES[UA_TYPES_INT32]);
+    retval = UA_Server_writeValue(server, nodeId, value);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    i = 0;
+    retval = UA_Server_readValueHandle(server, handle, &UA_TYPES[UA_TYPES_INT32], &i);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(i, 44);
+
+    /* A different type goes through the Write service */
+    UA_Double d = 1.5;
+    retval = UA_Server_writeValueHandle(server, handle, &UA_TYPES[UA_TYPES_DOUBLE], &d);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    retval = UA_Server_readValueHandle(server, handle, &UA_TYPES[UA_TYPES_INT32], &i);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADTYPEMISMATCH);
+    d = 0.0;
+    retval = UA_Server_readValueHandle(server, handle, &UA_TYPES[UA_TYPES_DOUBLE], &d);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(d == 1.5);
+
+    /* Non-scalar type */
+    UA_String str = UA_STRING("str");
+    retval = UA_Server_writeValueHandle(server, handle, &UA_TYPES[UA_TYPES_STRING], &str);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_String out;
+    retval = UA_Server_readValueHandle(server, handle, &UA_TYPES[UA_TYPES_STRING], &out);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(UA_String_equal(&str, &out));
+    UA_String_clear(&out);
+
+    /* The node is resolved again after it was removed */
+    retval = UA_Server_deleteNode(server, nodeId, true);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    retval = UA_Server_readValueHandle(server, handle, &UA_TYPES[UA_TYPES_STRING], &out);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADNODEIDUNKNOWN);
+    UA_Server_releaseValueHandle(server, handle);
+
+    /* Only VariableNodes */
+    retval = UA_Server_getValueHandle(server, UA_NS0ID(OBJECTSFOLDER), &handle);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADNODECLASSINVALID);
+
+    /* Not released handles are cleaned up with the server */
+    retval = UA_Server_getValueHandle(server, UA_NODEID_STRING(1, "cpu.temperature"),
+                                      &handle);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+} END_TEST
+
+START_TEST(WriteSingleAttributeValueMemoryBackend) {
+    UA_Int32 image[4] = {1, 2, 3, 4};
+    volatile size_t seqlock = 0;
+
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.dataType = UA_TYPES[UA_TYPES_INT32].typeId;
+    attr.valueRank = UA_VALUERANK_ONE_DIMENSION;
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+    UA_UInt32 arrayDims[1] = {4};
+    attr.arrayDimensions = arrayDims;
+    attr.arrayDimensionsSize = 1;
+    UA_Variant_setArray(&attr.value, image, 4, &UA_TYPES[UA_TYPES_INT32]);
+    UA_NodeId nodeId = UA_NODEID_STRING(1, "process.image");
+    UA_StatusCode retval =
+        UA_Server_addVariableNode(server, nodeId, UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, "process image"),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                  attr, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_ValueBackend backend;
+    memset(&backend, 0, sizeof(UA_ValueBackend));
+    backend.backendType = UA_VALUEBACKENDTYPE_MEMORY;
+    backend.backend.memory.data = image;
+    backend.backend.memory.type = &UA_TYPES[UA_TYPES_INT32];
+    backend.backend.memory.arrayLength = 4;
+    backend.backend.memory.seqlock = &seqlock;
+    retval = UA_Server_setVariableNode_valueBackend(server, nodeId, backend);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* The read sees changes of the region */
+    image[2] = 42;
+    UA_Variant value;
+    retval = UA_Server_readValue(server, nodeId, &value);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(value.arrayLength, 4);
+    ck_assert_int_eq(((UA_Int32*)value.data)[2], 42);
+    ck_assert(value.data != image);
+    UA_Variant_clear(&value);
+
+    /* Writes go into the region */
+    UA_Int32 written[4] = {5, 6, 7, 8};
+    UA_Variant_setArray(&value, written, 4, &UA_TYPES[UA_TYPES_INT32]);
+    retval = UA_Server_writeValue(server, nodeId, value);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(image[0], 5);
+    ck_assert_int_eq(image[3], 8);
+    ck_assert_uint_eq(seqlock, 2);
+
+    /* The length of the region is fixed */
+    UA_Variant_setArray(&value, written, 3, &UA_TYPES[UA_TYPES_INT32]);
+    retval = UA_Server_writeValue(server, nodeId, value);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADOUTOFRANGE);
+
+    /* Write a range */
+    UA_Int32 element = 99;
+    UA_WriteValue wValue;
+    UA_WriteValue_init(&wValue);
+    wValue.nodeId = nodeId;
+    wValue.attributeId = UA_ATTRIBUTEID_VALUE;
+    wValue.indexRange = UA_STRING("1");
+    wValue.value.hasValue = true;
+    UA_Variant_setScalar(&wValue.value.value, &element, &UA_TYPES[UA_TYPES_INT32]);
+    retval = UA_Server_write(server, &wValue);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(image[0], 5);
+    ck_assert_int_eq(image[1], 99);
+    ck_assert_int_eq(image[2], 7);
+    ck_assert_uint_eq(seqlock, 4);
+
+    /* A reader does not complete while a write is ongoing */
+    seqlock++;
+    retval = UA_Server_readValue(server, nodeId, &value);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADRESOURCEUNAVAILABLE);
+    seqlock++;
+    retval = UA_Server_readValue(server, nodeId, &value);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(((UA_Int32*)value.data)[1], 99);
+    UA_Variant_clear(&value);
+} END_TEST
+
 START_TEST(CheckDisplayNameLocalization) {
     /* Add a german localization for the DisplayName attribute */
     UA_WriteValue wValue;
@@ -1177,6 +1434,318 @@ START_TEST(CheckDescriptionLocalization) {
     UA_LocalizedText_clear(&lt);
 } END_TEST
 
+#if UA_MULTITHREADING >= 200
+/* The parallel processing yields the same results as the serial one */
+START_TEST(ReadParallel) {
+    UA_ReadValueId rvi[40];
+    for(size_t i = 0; i < 40; i++) {
+        UA_ReadValueId_init(&rvi[i]);
+        rvi[i].attributeId = UA_ATTRIBUTEID_VALUE;
+        switch(i % 5) {
+        case 0: rvi[i].nodeId = UA_NODEID_STRING(1, "the.answer"); break;
+        case 1: rvi[i].nodeId = UA_NODEID_STRING(1, "cpu.temperature"); break;
+        case 2:
+            rvi[i].nodeId = UA_NODEID_STRING(1, "myarray");
+            rvi[i].indexRange = UA_STRING("1:2");
+            break;
+        case 3: rvi[i].nodeId = UA_NODEID_STRING(1, "unknown"); break;
+        default:
+            rvi[i].nodeId = UA_NODEID_STRING(1, "the.answer");
+            rvi[i].attributeId = UA_ATTRIBUTEID_USERACCESSLEVEL;
+            break;
+        }
+    }
+    UA_ReadRequest request;
+    UA_ReadRequest_init(&request);
+    request.nodesToRead = rvi;
+    request.nodesToReadSize = 40;
+    request.timestampsToReturn = UA_TIMESTAMPSTORETURN_NEITHER;
+
+    UA_ReadResponse serial;
+    UA_ReadResponse_init(&serial);
+    UA_LOCK(&server->serviceMutex);
+    Service_Read(server, &server->adminSession, &request, &serial);
+    UA_UNLOCK(&server->serviceMutex);
+
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    config->parallelReadThreshold = 10;
+    config->parallelReadThreads = 3;
+    UA_ReadResponse parallel;
+    UA_ReadResponse_init(&parallel);
+    UA_LOCK(&server->serviceMutex);
+    Service_Read(server, &server->adminSession, &request, &parallel);
+    UA_UNLOCK(&server->serviceMutex);
+
+    ck_assert_uint_eq(parallel.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(parallel.resultsSize, 40);
+    for(size_t i = 0; i < 40; i++)
+        ck_assert(UA_order(&serial.results[i], &parallel.results[i],
+                           &UA_TYPES[UA_TYPES_DATAVALUE]) == UA_ORDER_EQ);
+    ck_assert_uint_eq(parallel.results[3].status, UA_STATUSCODE_BADNODEIDUNKNOWN);
+    ck_assert(parallel.results[1].hasValue);
+
+    UA_ReadResponse_clear(&serial);
+    UA_ReadResponse_clear(&parallel);
+} END_TEST
+
+/* The workers share the Session of the request. The decision cache of the
+ * Session is not used during the parallel processing. */
+START_TEST(ReadParallelDecisionCache) {
+    UA_ReadValueId rvi[2000];
+    for(size_t i = 0; i < 2000; i++) {
+        UA_ReadValueId_init(&rvi[i]);
+        rvi[i].attributeId = (i % 2) ? UA_ATTRIBUTEID_USERACCESSLEVEL :
+            UA_ATTRIBUTEID_USERWRITEMASK;
+        switch(i % 3) {
+        case 0: rvi[i].nodeId = UA_NODEID_STRING(1, "the.answer"); break;
+        case 1: rvi[i].nodeId = UA_NODEID_STRING(1, "myarray"); break;
+        default: rvi[i].nodeId = UA_NODEID_STRING(1, "cpu.temperature"); break;
+        }
+    }
+    UA_ReadRequest request;
+    UA_ReadRequest_init(&request);
+    request.nodesToRead = rvi;
+    request.nodesToReadSize = 2000;
+    request.timestampsToReturn = UA_TIMESTAMPSTORETURN_NEITHER;
+
+    UA_Session session;
+    UA_Session_init(&session);
+    session.sessionId = UA_NODEID_NUMERIC(1, 4711);
+
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    config->accessControl.decisionCacheSize = 4;
+    config->parallelReadThreshold = 10;
+    config->parallelReadThreads = 4;
+    UA_ReadResponse parallel;
+    for(size_t i = 0; i < 10; i++) {
+        UA_ReadResponse_init(&parallel);
+        UA_LOCK(&server->serviceMutex);
+        Service_Read(server, &session, &request, &parallel);
+        UA_UNLOCK(&server->serviceMutex);
+        ck_assert_uint_eq(parallel.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(parallel.resultsSize, 2000);
+        if(i < 9)
+            UA_ReadResponse_clear(&parallel);
+    }
+
+    /* The serial processing fills the cache and yields the same results */
+    config->parallelReadThreshold = 0;
+    UA_ReadResponse serial;
+    UA_ReadResponse_init(&serial);
+    UA_LOCK(&server->serviceMutex);
+    Service_Read(server, &session, &request, &serial);
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_ptr_ne(session.decisionCache, NULL);
+    for(size_t i = 0; i < 2000; i++) {
+        ck_assert(parallel.results[i].hasValue);
+        ck_assert(UA_order(&serial.results[i], &parallel.results[i],
+                           &UA_TYPES[UA_TYPES_DATAVALUE]) == UA_ORDER_EQ);
+    }
+
+    UA_Session_clearDecisionCache(&session);
+    UA_ReadResponse_clear(&serial);
+    UA_ReadResponse_clear(&parallel);
+} END_TEST
+
+static UA_THREAD_LOCAL UA_Boolean requestingThread;
+static size_t parallelSourceReads;
+static size_t parallelSourceForeignReads;
+
+/* Calls back into the server API */
+static UA_StatusCode
+readParallelSource(UA_Server *server_,
+                   const UA_NodeId *sessionId, void *sessionContext,
+                   const UA_NodeId *nodeId, void *nodeContext,
+                   UA_Boolean sourceTimeStamp, const UA_NumericRange *range,
+                   UA_DataValue *dataValue) {
+    parallelSourceReads++;
+    if(!requestingThread)
+        parallelSourceForeignReads++;
+    UA_Variant answer;
+    UA_StatusCode res =
+        UA_Server_readValue(server_, UA_NODEID_STRING(1, "the.answer"), &answer);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    UA_Variant_setScalarCopy(&dataValue->value, answer.data, answer.type);
+    dataValue->hasValue = true;
+    UA_Variant_clear(&answer);
+    return UA_STATUSCODE_GOOD;
+}
+
+/* DataSources are read by the requesting thread after the workers are done.
+ * The pooled workers are reused for the next request. */
+START_TEST(ReadParallelDataSource) {
+    UA_DataSource ds;
+    ds.read = readParallelSource;
+    ds.write = NULL;
+    UA_VariableAttributes vattr = UA_VariableAttributes_default;
+    UA_StatusCode res =
+        UA_Server_addDataSourceVariableNode(server, UA_NODEID_STRING(1, "parallel.source"),
+                                            UA_NS0ID(OBJECTSFOLDER), UA_NS0ID(ORGANIZES),
+                                            UA_QUALIFIEDNAME(1, "parallel source"),
+                                            UA_NS0ID(BASEDATAVARIABLETYPE),
+                                            vattr, ds, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_ReadValueId rvi[300];
+    for(size_t i = 0; i < 300; i++) {
+        UA_ReadValueId_init(&rvi[i]);
+        rvi[i].attributeId = UA_ATTRIBUTEID_VALUE;
+        rvi[i].nodeId = (i % 3 == 0) ? UA_NODEID_STRING(1, "parallel.source") :
+            UA_NODEID_STRING(1, "the.answer");
+    }
+    UA_ReadRequest request;
+    UA_ReadRequest_init(&request);
+    request.nodesToRead = rvi;
+    request.nodesToReadSize = 300;
+    request.timestampsToReturn = UA_TIMESTAMPSTORETURN_NEITHER;
+
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    config->parallelReadThreshold = 10;
+    config->parallelReadThreads = 4;
+    requestingThread = true;
+    parallelSourceReads = 0;
+    parallelSourceForeignReads = 0;
+    for(size_t round = 0; round < 5; round++) {
+        UA_ReadResponse response;
+        UA_ReadResponse_init(&response);
+        UA_LOCK(&server->serviceMutex);
+        Service_Read(server, &server->adminSession, &request, &response);
+        UA_UNLOCK(&server->serviceMutex);
+        ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(response.resultsSize, 300);
+        for(size_t i = 0; i < 300; i++) {
+            ck_assert(response.results[i].hasValue);
+            ck_assert(UA_order(&response.results[0].value, &response.results[i].value,
+                               &UA_TYPES[UA_TYPES_VARIANT]) == UA_ORDER_EQ);
+        }
+        UA_ReadResponse_clear(&response);
+    }
+    requestingThread = false;
+    ck_assert_uint_eq(parallelSourceReads, 5 * 100);
+    ck_assert_uint_eq(parallelSourceForeignReads, 0);
+} END_TEST
+#endif
+
+static size_t registerReads;
+static size_t batchReads;
+static size_t batchItems;
+static int deviceA, deviceB;
+
+static UA_StatusCode
+readRegister(UA_Server *server_,
+             const UA_NodeId *sessionId, void *sessionContext,
+             const UA_NodeId *nodeId, void *nodeContext,
+             UA_Boolean sourceTimeStamp, const UA_NumericRange *range,
+             UA_DataValue *dataValue) {
+    registerReads++;
+    UA_UInt32 reg = (UA_UInt32)(uintptr_t)nodeContext;
+    dataValue->hasValue = true;
+    return UA_Variant_setScalarCopy(&dataValue->value, &reg, &UA_TYPES[UA_TYPES_UINT32]);
+}
+
+static UA_StatusCode
+readRegisterBatch(UA_Server *server_, const UA_NodeId *sessionId,
+                  void *sessionContext, void *device,
+                  UA_Boolean includeSourceTimeStamp,
+                  size_t itemsSize, const UA_DataSourceReadItem *items) {
+    batchReads++;
+    batchItems += itemsSize;
+    for(size_t i = 0; i < itemsSize; i++) {
+        /* Registers of device B are 100 and up */
+        UA_UInt32 reg = (UA_UInt32)(uintptr_t)items[i].nodeContext;
+        ck_assert((device == &deviceB) == (reg >= 100));
+        items[i].value->hasValue = true;
+        UA_Variant_setScalarCopy(&items[i].value->value, &reg,
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+        if(includeSourceTimeStamp) {
+            items[i].value->sourceTimestamp = 1234;
+            items[i].value->hasSourceTimestamp = true;
+        }
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+START_TEST(ReadDataSourceBatch) {
+    UA_DataSource ds;
+    ds.read = readRegister;
+    ds.write = NULL;
+    UA_VariableAttributes vattr = UA_VariableAttributes_default;
+    const UA_UInt32 regs[4] = {1, 2, 100, 101};
+    for(size_t i = 0; i < 4; i++) {
+        UA_NodeId id = UA_NODEID_NUMERIC(1, 5000 + (UA_UInt32)i);
+        UA_StatusCode res =
+            UA_Server_addDataSourceVariableNode(server, id,
+                                                UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                                UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                                UA_QUALIFIEDNAME(1, "register"),
+                                                UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                                vattr, ds, (void*)(uintptr_t)regs[i], NULL);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        res = UA_Server_setVariableNode_dataSourceReadBatch(server, id, readRegisterBatch,
+                                                            (regs[i] < 100) ?
+                                                            &deviceA : &deviceB);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+
+    /* Interleave the devices with other reads */
+    UA_ReadValueId rvi[7];
+    for(size_t i = 0; i < 7; i++) {
+        UA_ReadValueId_init(&rvi[i]);
+        rvi[i].attributeId = UA_ATTRIBUTEID_VALUE;
+    }
+    rvi[0].nodeId = UA_NODEID_NUMERIC(1, 5002);
+    rvi[1].nodeId = UA_NODEID_STRING(1, "the.answer");
+    rvi[2].nodeId = UA_NODEID_NUMERIC(1, 5000);
+    rvi[3].nodeId = UA_NODEID_STRING(1, "cpu.temperature");
+    rvi[4].nodeId = UA_NODEID_NUMERIC(1, 5003);
+    rvi[5].nodeId = UA_NODEID_NUMERIC(1, 5001);
+    rvi[6].nodeId = UA_NODEID_NUMERIC(1, 5001);
+    rvi[6].attributeId = UA_ATTRIBUTEID_DISPLAYNAME;
+    UA_ReadRequest request;
+    UA_ReadRequest_init(&request);
+    request.nodesToRead = rvi;
+    request.nodesToReadSize = 7;
+    request.timestampsToReturn = UA_TIMESTAMPSTORETURN_SOURCE;
+
+    registerReads = batchReads = batchItems = 0;
+    UA_ReadResponse response;
+    UA_ReadResponse_init(&response);
+    UA_LOCK(&server->serviceMutex);
+    Service_Read(server, &server->adminSession, &request, &response);
+    UA_UNLOCK(&server->serviceMutex);
+
+    /* One batch per device */
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.resultsSize, 7);
+    ck_assert_uint_eq(batchReads, 2);
+    ck_assert_uint_eq(batchItems, 4);
+    ck_assert_uint_eq(registerReads, 0);
+    const size_t regIndex[4] = {2, 5, 0, 4};
+    for(size_t i = 0; i < 4; i++) {
+        UA_DataValue *dv = &response.results[regIndex[i]];
+        ck_assert(dv->hasValue);
+        ck_assert(dv->value.type == &UA_TYPES[UA_TYPES_UINT32]);
+        ck_assert_uint_eq(*(UA_UInt32*)dv->value.data, regs[i]);
+        ck_assert(dv->hasSourceTimestamp);
+        ck_assert_int_eq(dv->sourceTimestamp, 1234);
+        ck_assert(!dv->hasServerTimestamp);
+    }
+    ck_assert(response.results[1].hasValue);
+    ck_assert(response.results[3].hasValue);
+    ck_assert(response.results[6].value.type == &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+    UA_ReadResponse_clear(&response);
+
+    /* Single reads use the read callback */
+    UA_ReadValueId single = rvi[0];
+    UA_DataValue dv = UA_Server_read(server, &single, UA_TIMESTAMPSTORETURN_NEITHER);
+    ck_assert(dv.hasValue);
+    ck_assert_uint_eq(*(UA_UInt32*)dv.value.data, 100);
+    ck_assert_uint_eq(registerReads, 1);
+    ck_assert_uint_eq(batchReads, 2);
+    UA_DataValue_clear(&dv);
+} END_TEST
+
 static Suite * testSuite_services_attributes(void) {
     Suite *s = suite_create("services_attributes_read");
 
@@ -1212,6 +1781,12 @@ static Suite * testSuite_services_attributes(void) {
     tcase_add_test(tc_readSingleAttributes, ReadSingleDataSourceAttributeDataTypeWithoutTimestamp);
     tcase_add_test(tc_readSingleAttributes, ReadSingleDataSourceAttributeArrayDimensionsWithoutTimestamp);
     tcase_add_test(tc_readSingleAttributes, ReadSingleAttributeDataTypeDefinitionWithoutTimestamp);
+#if UA_MULTITHREADING >= 200
+    tcase_add_test(tc_readSingleAttributes, ReadParallel);
+    tcase_add_test(tc_readSingleAttributes, ReadParallelDecisionCache);
+    tcase_add_test(tc_readSingleAttributes, ReadParallelDataSource);
+#endif
+    tcase_add_test(tc_readSingleAttributes, ReadDataSourceBatch);
 
     suite_add_tcase(s, tc_readSingleAttributes);
 
@@ -1235,6 +1810,7 @@ static Suite * testSuite_services_attributes(void) {
     tcase_add_test(tc_writeSingleAttributes, WriteSingleAttributeDataType);
     tcase_add_test(tc_writeSingleAttributes, WriteSingleAttributeValueRangeFromScalar);
     tcase_add_test(tc_writeSingleAttributes, WriteSingleAttributeValueRangeFromArray);
+    tcase_add_test(tc_writeSingleAttributes, WriteSingleAttributeValueShared);
     tcase_add_test(tc_writeSingleAttributes, WriteSingleAttributeValueRank);
     tcase_add_test(tc_writeSingleAttributes, WriteSingleAttributeArrayDimensions);
     tcase_add_test(tc_writeSingleAttributes, WriteSingleAttributeAccessLevel);
@@ -1243,6 +1819,9 @@ static Suite * testSuite_services_attributes(void) {
     tcase_add_test(tc_writeSingleAttributes, WriteSingleAttributeHistorizing);
     tcase_add_test(tc_writeSingleAttributes, WriteSingleAttributeExecutable);
     tcase_add_test(tc_writeSingleAttributes, WriteSingleDataSourceAttributeValue);
+    tcase_add_test(tc_writeSingleAttributes, WriteMultipleAttributesGroupedByNode);
+    tcase_add_test(tc_writeSingleAttributes, WriteSingleAttributeValueMemoryBackend);
+    tcase_add_test(tc_writeSingleAttributes, ValueHandleReadWrite);
 
     suite_add_tcase(s, tc_writeSingleAttributes);
 
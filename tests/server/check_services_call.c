@@ -238,6 +238,72 @@ START_TEST(callMethodWithEmptyArgument) {
 #endif
 } END_TEST
 
+START_TEST(callMethodCachedDefinitionsFollowChanges) {
+    UA_Argument inputArgument;
+    UA_Argument_init(&inputArgument);
+    inputArgument.name = UA_STRING("Value");
+    inputArgument.dataType = UA_TYPES[UA_TYPES_INT32].typeId;
+    inputArgument.valueRank = UA_VALUERANK_SCALAR;
+
+    UA_MethodAttributes attr = UA_MethodAttributes_default;
+    attr.executable = true;
+    attr.userExecutable = true;
+    UA_NodeId methodId = UA_NODEID_STRING(1, "cached");
+    UA_NodeId inputArgumentsId = UA_NODEID_NUMERIC(1, 62000);
+    UA_StatusCode res =
+        UA_Server_addMethodNodeEx(server, methodId,
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                  UA_QUALIFIEDNAME(1, "Cached"), attr, &methodCallback,
+                                  1, &inputArgument, inputArgumentsId, NULL,
+                                  0, NULL, UA_NODEID_NULL, NULL, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_Int32 value = 42;
+    UA_Variant input;
+    UA_Variant_setScalar(&input, &value, &UA_TYPES[UA_TYPES_INT32]);
+    UA_CallMethodRequest callMethodRequest;
+    UA_CallMethodRequest_init(&callMethodRequest);
+    callMethodRequest.inputArgumentsSize = 1;
+    callMethodRequest.inputArguments = &input;
+    callMethodRequest.methodId = methodId;
+    callMethodRequest.objectId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+
+    /* Repeated calls use the cached definitions */
+    for(size_t i = 0; i < 2; i++) {
+        UA_CallMethodResult result = UA_Server_call(server, &callMethodRequest);
+        ck_assert_uint_eq(result.statusCode, UA_STATUSCODE_GOOD);
+        UA_CallMethodResult_clear(&result);
+    }
+
+    /* Not a component of the Server object */
+    callMethodRequest.objectId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
+    UA_CallMethodResult result = UA_Server_call(server, &callMethodRequest);
+    ck_assert_uint_eq(result.statusCode, UA_STATUSCODE_BADMETHODINVALID);
+    UA_CallMethodResult_clear(&result);
+
+    /* Adding the reference makes the call valid */
+    res = UA_Server_addReference(server, UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER),
+                                 UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                 UA_EXPANDEDNODEID_STRING(1, "cached"), true);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    result = UA_Server_call(server, &callMethodRequest);
+    ck_assert_uint_eq(result.statusCode, UA_STATUSCODE_GOOD);
+    UA_CallMethodResult_clear(&result);
+
+    /* Writing the argument definitions changes the type-check */
+    inputArgument.dataType = UA_TYPES[UA_TYPES_DOUBLE].typeId;
+    UA_Variant definition;
+    UA_Variant_setArray(&definition, &inputArgument, 1, &UA_TYPES[UA_TYPES_ARGUMENT]);
+    res = UA_Server_writeValue(server, inputArgumentsId, definition);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    result = UA_Server_call(server, &callMethodRequest);
+    ck_assert_uint_eq(result.statusCode, UA_STATUSCODE_BADINVALIDARGUMENT);
+    ck_assert_uint_eq(result.inputArgumentResultsSize, 1);
+    ck_assert_uint_eq(result.inputArgumentResults[0], UA_STATUSCODE_BADTYPEMISMATCH);
+    UA_CallMethodResult_clear(&result);
+} END_TEST
+
 START_TEST(callObjectTypeMethodOnInstance) {
 /* Minimal nodeset does not add any method nodes we may call here */
 #if defined(UA_GENERATED_NAMESPACE_ZERO) && defined(UA_ENABLE_SUBSCRIPTIONS)
@@ -339,6 +405,7 @@ int main(void) {
     tcase_add_test(tc_call, callMethodWithEmptyArgument);
     tcase_add_test(tc_call, callObjectTypeMethodOnInstance);
     tcase_add_test(tc_call, callObjectTypeMethodOnInstance2);
+    tcase_add_test(tc_call, callMethodCachedDefinitionsFollowChanges);
     suite_add_tcase(s, tc_call);
 
     SRunner *sr = srunner_create(s);
@@ -376,6 +376,161 @@ START_TEST(AddObjectWithConstructor) {
     ck_assert_int_eq(constructorCalled, true);
 } END_TEST
 
+START_TEST(BulkLoadDefersCheckAndConstructor) {
+    addVariableTypeNode();
+
+    UA_NodeId objecttypeid = UA_NODEID_NUMERIC(0, 13371337);
+    UA_ObjectTypeAttributes attr = UA_ObjectTypeAttributes_default;
+    UA_StatusCode res =
+        UA_Server_addObjectTypeNode(server, objecttypeid,
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+                                    UA_QUALIFIEDNAME(0, "myobjecttype"), attr,
+                                    NULL, NULL);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    UA_NodeTypeLifecycle lifecycle;
+    lifecycle.constructor = objectConstructor;
+    lifecycle.destructor = NULL;
+    res = UA_Server_setNodeTypeLifecycle(server, objecttypeid, lifecycle);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+
+    res = UA_Server_beginBulkLoad(server);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(UA_Server_beginBulkLoad(server), UA_STATUSCODE_BADINVALIDSTATE);
+
+    /* The constructor is not called during the bulk load */
+    constructorCalled = false;
+    UA_ObjectAttributes oAttr = UA_ObjectAttributes_default;
+    res = UA_Server_addObjectNode(server, UA_NODEID_NUMERIC(1, 9000),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                  UA_QUALIFIEDNAME(1, "BulkObject"), objecttypeid,
+                                  oAttr, NULL, NULL);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(!constructorCalled);
+
+    /* The type-check is deferred. The array dimensions don't fit the type. */
+    UA_UInt32 arrayDims[1] = {3};
+    UA_VariableAttributes vAttr = UA_VariableAttributes_default;
+    vAttr.dataType = UA_TYPES[UA_TYPES_DOUBLE].typeId;
+    vAttr.valueRank = UA_VALUERANK_ONE_DIMENSION;
+    vAttr.arrayDimensions = arrayDims;
+    vAttr.arrayDimensionsSize = 1;
+    UA_NodeId badVariable = UA_NODEID_NUMERIC(1, 9001);
+    res = UA_Server_addVariableNode(server, badVariable,
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                    UA_QUALIFIEDNAME(1, "BulkVariable"), pointTypeId,
+                                    vAttr, NULL, NULL);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+
+    /* The check fails at the end and removes the variable */
+    res = UA_Server_endBulkLoad(server);
+    ck_assert_int_eq(res, UA_STATUSCODE_BADTYPEMISMATCH);
+    ck_assert(constructorCalled);
+    UA_NodeClass nc;
+    res = UA_Server_readNodeClass(server, badVariable, &nc);
+    ck_assert_int_eq(res, UA_STATUSCODE_BADNODEIDUNKNOWN);
+    res = UA_Server_readNodeClass(server, UA_NODEID_NUMERIC(1, 9000), &nc);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+
+    ck_assert_int_eq(UA_Server_endBulkLoad(server), UA_STATUSCODE_BADINVALIDSTATE);
+} END_TEST
+
+static UA_Boolean tableFinishCalled = false;
+
+static UA_StatusCode
+tableNode_begin(UA_Server *server_, UA_UInt16 *ns) {
+    UA_ObjectAttributes attr = UA_ObjectAttributes_default;
+    return UA_Server_addNode_begin(server_, UA_NODECLASS_OBJECT,
+                                   UA_NODEID_NUMERIC(ns[1], 7003),
+                                   UA_NODEID_NUMERIC(ns[1], 7001),
+                                   UA_NODEID_NUMERIC(ns[0], UA_NS0ID_HASCOMPONENT),
+                                   UA_QUALIFIEDNAME(ns[1], "TableFunctionObject"),
+                                   UA_NODEID_NUMERIC(ns[0], UA_NS0ID_BASEOBJECTTYPE),
+                                   (const UA_NodeAttributes*)&attr,
+                                   &UA_TYPES[UA_TYPES_OBJECTATTRIBUTES], NULL, NULL);
+}
+
+static UA_StatusCode
+tableNode_finish(UA_Server *server_, UA_UInt16 *ns) {
+    tableFinishCalled = true;
+    return UA_Server_addNode_finish(server_, UA_NODEID_NUMERIC(ns[1], 7003));
+}
+
+static const char * const tableStrings[] = {
+    "", "TableObjectType", "TableObject", "en", "Table Object", "TableVariable"};
+static const char * const tableDescriptions[] = {"", "A variable from the table"};
+static const UA_UInt32 tableArrayDimensions[] = {3};
+static const UA_NodeTableReference tableReferences[] = {
+    {{0, UA_NS0ID_ORGANIZES}, {0, UA_NS0ID_OBJECTSFOLDER}, false}};
+static const UA_NodeTableEntry tableNodes[] = {
+    {NULL, NULL, {1, 7000}, {0, UA_NS0ID_BASEOBJECTTYPE}, {0, UA_NS0ID_HASSUBTYPE},
+     {0, 0}, {0, 0}, 1, 1, 0, 1, 0, 0, 0, 0, 0.0, 0, 0, 0, 0,
+     UA_NODECLASS_OBJECTTYPE, 0, 0, 0, 0},
+    {NULL, NULL, {1, 7001}, {0, UA_NS0ID_OBJECTSFOLDER}, {0, UA_NS0ID_ORGANIZES},
+     {1, 7000}, {0, 0}, 1, 2, 3, 4, 0, 0, 0, 0, 0.0, 0, 0, 0, 0,
+     UA_NODECLASS_OBJECT, 0, UA_EVENTNOTIFIER_SUBSCRIBE_TO_EVENT, 0, 0},
+    {NULL, NULL, {1, 7002}, {1, 7001}, {0, UA_NS0ID_HASCOMPONENT},
+     {0, UA_NS0ID_BASEDATAVARIABLETYPE}, {0, UA_NS0ID_DOUBLE}, 1, 5, 0, 5, 1, 0, 0, 0,
+     100.0, UA_VALUERANK_ONE_DIMENSION, 0, 0, 1, UA_NODECLASS_VARIABLE, 0, 0,
+     UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE, UA_ACCESSLEVELMASK_READ},
+    {tableNode_begin, tableNode_finish, {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0},
+     0, 0, 0, 0, 0, 0, 0, 0, 0.0, 0, 0, 0, 0, UA_NODECLASS_OBJECT, 0, 0, 0, 0}};
+
+START_TEST(AddNodeTable) {
+    UA_NodeTable table = {tableNodes, 4, tableReferences, tableStrings,
+                          tableDescriptions, tableArrayDimensions};
+    UA_UInt16 ns[2] = {0, 1};
+    tableFinishCalled = false;
+    UA_StatusCode res = UA_Server_addNodeTable(server, &table, ns);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(tableFinishCalled);
+
+    UA_Byte eventNotifier = 0;
+    res = UA_Server_readEventNotifier(server, UA_NODEID_NUMERIC(1, 7001), &eventNotifier);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(eventNotifier, UA_EVENTNOTIFIER_SUBSCRIBE_TO_EVENT);
+
+    UA_LocalizedText dn;
+    res = UA_Server_readDisplayName(server, UA_NODEID_NUMERIC(1, 7001), &dn);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    UA_LocalizedText expectedDn = UA_LOCALIZEDTEXT("en", "Table Object");
+    ck_assert(UA_LocalizedText_equal(&dn, &expectedDn));
+    UA_LocalizedText_clear(&dn);
+
+    UA_NodeId dataType;
+    res = UA_Server_readDataType(server, UA_NODEID_NUMERIC(1, 7002), &dataType);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(UA_NodeId_equal(&dataType, &UA_TYPES[UA_TYPES_DOUBLE].typeId));
+
+    UA_Variant dims;
+    res = UA_Server_readArrayDimensions(server, UA_NODEID_NUMERIC(1, 7002), &dims);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(dims.arrayLength, 1);
+    ck_assert_uint_eq(*(UA_UInt32*)dims.data, 3);
+    UA_Variant_clear(&dims);
+
+    /* The reference from the table */
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = UA_NODEID_NUMERIC(1, 7002);
+    bd.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+    bd.browseDirection = UA_BROWSEDIRECTION_INVERSE;
+    UA_BrowseResult br = UA_Server_browse(server, 0, &bd);
+    ck_assert_int_eq(br.statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(br.referencesSize, 1);
+    ck_assert_uint_eq(br.references[0].nodeId.nodeId.identifier.numeric,
+                      UA_NS0ID_OBJECTSFOLDER);
+    UA_BrowseResult_clear(&br);
+
+    /* The node added by the callbacks */
+    UA_NodeClass nc;
+    res = UA_Server_readNodeClass(server, UA_NODEID_NUMERIC(1, 7003), &nc);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(nc, UA_NODECLASS_OBJECT);
+} END_TEST
+
 static UA_Boolean destructorCalled = false;
 
 static void
@@ -493,6 +648,69 @@ START_TEST(DeleteObjectAndReferences) {
 } END_TEST
 
 
+/* Delete a subtree where an outside node references a deeply nested member.
+ * The references within the subtree go away with the nodes. The reference from
+ * the outside node is removed. */
+START_TEST(DeleteSubtreeWithExternalReference) {
+    UA_ObjectAttributes attr = UA_ObjectAttributes_default;
+    UA_NodeId rootId;
+    UA_StatusCode res =
+        UA_Server_addObjectNode(server, UA_NODEID_NULL,
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                UA_QUALIFIEDNAME(1, "Root"),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                attr, NULL, &rootId);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_NodeId ids[60];
+    for(size_t i = 0; i < 60; i++) {
+        /* Ten children of the root, five grandchildren each */
+        UA_NodeId parent = (i < 10) ? rootId : ids[(i - 10) / 5];
+        res = UA_Server_addObjectNode(server, UA_NODEID_NULL, parent,
+                                      UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                      UA_QUALIFIEDNAME(1, "Child"),
+                                      UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                      attr, NULL, &ids[i]);
+        ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    }
+
+    /* Non-hierarchical reference from outside into the subtree */
+    UA_NodeId outsideId;
+    res = UA_Server_addObjectNode(server, UA_NODEID_NULL,
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, "Outside"),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                  attr, NULL, &outsideId);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    UA_ExpandedNodeId target = UA_EXPANDEDNODEID_NULL;
+    target.nodeId = ids[59];
+    res = UA_Server_addReference(server, outsideId,
+                                 UA_NODEID_NUMERIC(0, UA_NS0ID_GENERATESEVENT),
+                                 target, true);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+
+    res = UA_Server_deleteNode(server, rootId, true);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_NodeClass nc;
+    for(size_t i = 0; i < 60; i++) {
+        res = UA_Server_readNodeClass(server, ids[i], &nc);
+        ck_assert_int_eq(res, UA_STATUSCODE_BADNODEIDUNKNOWN);
+    }
+
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = outsideId;
+    bd.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_GENERATESEVENT);
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+    UA_BrowseResult br = UA_Server_browse(server, 0, &bd);
+    ck_assert_int_eq(br.statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(br.referencesSize, 0);
+    UA_BrowseResult_clear(&br);
+} END_TEST
+
 /* Example taken from tutorial_server_object.c */
 START_TEST(InstantiateObjectType) {
     /* Define the object type */
@@ -591,6 +809,90 @@ START_TEST(InstantiateObjectType) {
     ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
 } END_TEST
 
+static size_t
+countChildren(const UA_NodeId nodeId, const char *name) {
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = nodeId;
+    bd.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_AGGREGATES);
+    bd.includeSubtypes = true;
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+    bd.resultMask = UA_BROWSERESULTMASK_BROWSENAME;
+    UA_BrowseResult br = UA_Server_browse(server, 0, &bd);
+    ck_assert_uint_eq(br.statusCode, UA_STATUSCODE_GOOD);
+    size_t count = 0;
+    for(size_t i = 0; i < br.referencesSize; i++) {
+        UA_QualifiedName qn = UA_QUALIFIEDNAME(1, (char*)(uintptr_t)name);
+        if(UA_QualifiedName_equal(&br.references[i].browseName, &qn))
+            count++;
+    }
+    UA_BrowseResult_clear(&br);
+    return count;
+}
+
+static UA_NodeId
+addMandatoryVariable(const UA_NodeId parent, const char *name) {
+    UA_VariableAttributes vAttr = UA_VariableAttributes_default;
+    vAttr.displayName = UA_LOCALIZEDTEXT("en-US", (char*)(uintptr_t)name);
+    UA_NodeId id;
+    UA_StatusCode retval =
+        UA_Server_addVariableNode(server, UA_NODEID_NULL, parent,
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                  UA_QUALIFIEDNAME(1, (char*)(uintptr_t)name),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                  vAttr, NULL, &id);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+#ifdef UA_GENERATED_NAMESPACE_ZERO
+    retval = UA_Server_addReference(server, id,
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_HASMODELLINGRULE),
+                                    UA_EXPANDEDNODEID_NUMERIC(0, UA_NS0ID_MODELLINGRULE_MANDATORY), true);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+#endif
+    return id;
+}
+
+/* Children that are overridden in a subtype are instantiated only once. Every
+ * instance gets its own copy of the children. */
+START_TEST(InstantiateObjectTypeOverriddenChild) {
+    UA_ObjectTypeAttributes otAttr = UA_ObjectTypeAttributes_default;
+    UA_NodeId baseTypeId;
+    UA_StatusCode retval =
+        UA_Server_addObjectTypeNode(server, UA_NODEID_NULL,
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+                                    UA_QUALIFIEDNAME(1, "BaseValveType"), otAttr,
+                                    NULL, &baseTypeId);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    addMandatoryVariable(baseTypeId, "Position");
+    addMandatoryVariable(baseTypeId, "Serial");
+
+    UA_NodeId typeId;
+    retval = UA_Server_addObjectTypeNode(server, UA_NODEID_NULL, baseTypeId,
+                                         UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+                                         UA_QUALIFIEDNAME(1, "ValveType"), otAttr,
+                                         NULL, &typeId);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    addMandatoryVariable(typeId, "Position");
+    addMandatoryVariable(typeId, "Flow");
+
+#ifdef UA_GENERATED_NAMESPACE_ZERO
+    const char *names[3] = {"Position", "Serial", "Flow"};
+    for(size_t i = 0; i < 2; i++) {
+        UA_NodeId objId;
+        UA_ObjectAttributes oAttr = UA_ObjectAttributes_default;
+        retval = UA_Server_addObjectNode(server, UA_NODEID_NULL,
+                                         UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                         UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                         UA_QUALIFIEDNAME(1, "Valve"), typeId,
+                                         oAttr, NULL, &objId);
+        ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+        for(size_t j = 0; j < 3; j++)
+            ck_assert_uint_eq(countChildren(objId, names[j]), 1);
+        UA_NodeId_clear(&objId);
+    }
+#endif
+} END_TEST
+
 START_TEST(ObjectWithDynamicVariableChild) {
     /* Add a ServerRedundancyType object */
     UA_ObjectAttributes attr = UA_ObjectAttributes_default;
@@ -752,7 +1054,10 @@ int main(void) {
     tcase_add_test(tc_addnodes, AddComplexTypeWithInheritance);
     tcase_add_test(tc_addnodes, AddNodeTwiceGivesError);
     tcase_add_test(tc_addnodes, AddObjectWithConstructor);
+    tcase_add_test(tc_addnodes, BulkLoadDefersCheckAndConstructor);
+    tcase_add_test(tc_addnodes, AddNodeTable);
     tcase_add_test(tc_addnodes, InstantiateObjectType);
+    tcase_add_test(tc_addnodes, InstantiateObjectTypeOverriddenChild);
     tcase_add_test(tc_addnodes, ObjectWithDynamicVariableChild);
     suite_add_tcase(s, tc_addnodes);
 
@@ -760,6 +1065,7 @@ int main(void) {
     tcase_add_checked_fixture(tc_deletenodes, setup, teardown);
     tcase_add_test(tc_deletenodes, DeleteObjectWithDestructor);
     tcase_add_test(tc_deletenodes, DeleteObjectAndReferences);
+    tcase_add_test(tc_deletenodes, DeleteSubtreeWithExternalReference);
     suite_add_tcase(s, tc_deletenodes);
 
     TCase *tc_addreferences = tcase_create("addreferences");
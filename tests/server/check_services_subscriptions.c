@@ -208,6 +208,137 @@ START_TEST(Server_republish) {
 END_TEST
 
 
+START_TEST(Server_republishEncoded) {
+    createSubscription();
+
+    UA_LOCK(&server->serviceMutex);
+    UA_Subscription *sub = UA_Session_getSubscriptionById(session, subscriptionId);
+    ck_assert_ptr_ne(sub, NULL);
+    UA_assert(sub);
+
+    /* Store an encoded NotificationMessage for retransmission */
+    UA_DataChangeNotification dcn;
+    UA_DataChangeNotification_init(&dcn);
+    UA_MonitoredItemNotification min;
+    UA_MonitoredItemNotification_init(&min);
+    UA_UInt32 value = 42;
+    min.clientHandle = 7;
+    min.value.hasValue = true;
+    UA_Variant_setScalar(&min.value.value, &value, &UA_TYPES[UA_TYPES_UINT32]);
+    dcn.monitoredItems = &min;
+    dcn.monitoredItemsSize = 1;
+
+    UA_NotificationMessage msg;
+    UA_NotificationMessage_init(&msg);
+    msg.sequenceNumber = 5;
+    msg.publishTime = UA_DateTime_now();
+    UA_ExtensionObject eo;
+    UA_ExtensionObject_setValueNoDelete(&eo, &dcn,
+                                        &UA_TYPES[UA_TYPES_DATACHANGENOTIFICATION]);
+    msg.notificationData = &eo;
+    msg.notificationDataSize = 1;
+
+    UA_NotificationMessageEntry *entry = UA_NotificationMessageEntry_new(server);
+    ck_assert_ptr_ne(entry, NULL);
+    UA_assert(entry);
+    entry->sequenceNumber = msg.sequenceNumber;
+    entry->publishTime = msg.publishTime;
+    UA_StatusCode res = UA_encodeBinary(&msg, &UA_TYPES[UA_TYPES_NOTIFICATIONMESSAGE],
+                                        &entry->message);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_Subscription_addRetransmissionMessage(server, sub, entry);
+
+    /* Republish decodes the stored message */
+    UA_RepublishRequest request;
+    UA_RepublishRequest_init(&request);
+    request.subscriptionId = subscriptionId;
+    request.retransmitSequenceNumber = 5;
+    UA_RepublishResponse response;
+    UA_RepublishResponse_init(&response);
+    Service_Republish(server, session, &request, &response);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert(UA_equal(&msg, &response.notificationMessage,
+                       &UA_TYPES[UA_TYPES_NOTIFICATIONMESSAGE]));
+    UA_RepublishResponse_clear(&response);
+
+    /* Unknown sequence numbers that map to the same index slot */
+    res = UA_Subscription_removeRetransmissionMessage(server, sub,
+                                                      5 + UA_MAX_RETRANSMISSIONQUEUESIZE);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADSEQUENCENUMBERUNKNOWN);
+
+    /* Acknowledging removes the message */
+    res = UA_Subscription_removeRetransmissionMessage(server, sub, 5);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(sub->retransmissionQueueSize, 0);
+    UA_UNLOCK(&server->serviceMutex);
+}
+END_TEST
+
+static void
+addRetransmission(UA_Subscription *sub, UA_UInt32 sequenceNumber, size_t length) {
+    UA_NotificationMessageEntry *entry = UA_NotificationMessageEntry_new(server);
+    ck_assert_ptr_ne(entry, NULL);
+    UA_assert(entry);
+    entry->sequenceNumber = sequenceNumber;
+    entry->publishTime = UA_DateTime_now();
+    UA_StatusCode res = UA_ByteString_allocBuffer(&entry->message, length);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_Subscription_addRetransmissionMessage(server, sub, entry);
+    UA_fakeSleep(1); /* Distinct publish times */
+}
+
+/* The oldest retransmission messages are released to keep the byte budgets */
+START_TEST(Server_retransmissionBytes) {
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    config->maxRetransmissionQueueBytes = 250;
+    config->maxRetransmissionBytes = 350;
+
+    createSubscription();
+    UA_Subscription *sub1 = UA_Session_getSubscriptionById(session, subscriptionId);
+    createSubscription();
+    UA_Subscription *sub2 = UA_Session_getSubscriptionById(session, subscriptionId);
+    UA_Session *session1 = session;
+    createSession();
+    createSubscription();
+    UA_Subscription *sub3 = UA_Session_getSubscriptionById(session, subscriptionId);
+
+    UA_LOCK(&server->serviceMutex);
+    addRetransmission(sub1, 1, 100);
+    addRetransmission(sub2, 1, 100);
+    ck_assert_uint_eq(session1->totalRetransmissionQueueBytes, 200);
+
+    /* The oldest message of the Session is released */
+    addRetransmission(sub2, 2, 100);
+    ck_assert_uint_eq(sub1->retransmissionQueueSize, 0);
+    ck_assert_uint_eq(sub2->retransmissionQueueSize, 2);
+    ck_assert_uint_eq(session1->totalRetransmissionQueueBytes, 200);
+    ck_assert_uint_eq(server->retransmissionQueueBytes, 200);
+
+    /* The oldest message of the server is released */
+    addRetransmission(sub3, 1, 200);
+    ck_assert_uint_eq(sub2->retransmissionQueueSize, 1);
+    ck_assert_ptr_eq(UA_Subscription_getRetransmissionMessage(sub2, 1), NULL);
+    ck_assert_ptr_ne(UA_Subscription_getRetransmissionMessage(sub2, 2), NULL);
+    ck_assert_uint_eq(session1->totalRetransmissionQueueBytes, 100);
+    ck_assert_uint_eq(session->totalRetransmissionQueueBytes, 200);
+    ck_assert_uint_eq(server->retransmissionQueueBytes, 300);
+
+    /* A message larger than the budget is kept alone */
+    addRetransmission(sub3, 2, 500);
+    ck_assert_uint_eq(sub2->retransmissionQueueSize, 0);
+    ck_assert_uint_eq(sub3->retransmissionQueueSize, 1);
+    ck_assert_uint_eq(server->retransmissionQueueBytes, 500);
+
+    /* Acknowledging releases the bytes */
+    UA_StatusCode res = UA_Subscription_removeRetransmissionMessage(server, sub3, 2);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(sub3->retransmissionQueueBytes, 0);
+    ck_assert_uint_eq(session->totalRetransmissionQueueBytes, 0);
+    ck_assert_uint_eq(server->retransmissionQueueBytes, 0);
+    UA_UNLOCK(&server->serviceMutex);
+}
+END_TEST
+
 START_TEST(Server_republish_invalid) {
     UA_RepublishRequest request;
     UA_RepublishRequest_init(&request);
@@ -584,6 +715,98 @@ START_TEST(Server_overflow) {
 }
 END_TEST
 
+START_TEST(Server_overflowDiscardNewest) {
+    /* Create a subscription */
+    UA_CreateSubscriptionRequest createSubscriptionRequest;
+    UA_CreateSubscriptionResponse createSubscriptionResponse;
+
+    UA_CreateSubscriptionRequest_init(&createSubscriptionRequest);
+    createSubscriptionRequest.publishingEnabled = true;
+    UA_CreateSubscriptionResponse_init(&createSubscriptionResponse);
+    UA_LOCK(&server->serviceMutex);
+    Service_CreateSubscription(server, session, &createSubscriptionRequest, &createSubscriptionResponse);
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_uint_eq(createSubscriptionResponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    UA_UInt32 localSubscriptionId = createSubscriptionResponse.subscriptionId;
+    UA_CreateSubscriptionResponse_clear(&createSubscriptionResponse);
+
+    /* Create a monitoredItem that keeps the newest sample */
+    UA_CreateMonitoredItemsRequest createMonitoredItemsRequest;
+    UA_CreateMonitoredItemsRequest_init(&createMonitoredItemsRequest);
+    createMonitoredItemsRequest.subscriptionId = localSubscriptionId;
+    createMonitoredItemsRequest.timestampsToReturn = UA_TIMESTAMPSTORETURN_SERVER;
+    UA_MonitoredItemCreateRequest item;
+    UA_MonitoredItemCreateRequest_init(&item);
+    item.itemToMonitor.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_CURRENTTIME);
+    item.itemToMonitor.attributeId = UA_ATTRIBUTEID_VALUE;
+    item.monitoringMode = UA_MONITORINGMODE_REPORTING;
+    item.requestedParameters.queueSize = 3;
+    item.requestedParameters.discardOldest = false;
+    createMonitoredItemsRequest.itemsToCreateSize = 1;
+    createMonitoredItemsRequest.itemsToCreate = &item;
+
+    UA_CreateMonitoredItemsResponse createMonitoredItemsResponse;
+    UA_CreateMonitoredItemsResponse_init(&createMonitoredItemsResponse);
+    UA_LOCK(&server->serviceMutex);
+    Service_CreateMonitoredItems(server, session, &createMonitoredItemsRequest, &createMonitoredItemsResponse);
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_uint_eq(createMonitoredItemsResponse.resultsSize, 1);
+    ck_assert_uint_eq(createMonitoredItemsResponse.results[0].statusCode, UA_STATUSCODE_GOOD);
+    UA_UInt32 localMonitoredItemId = createMonitoredItemsResponse.results[0].monitoredItemId;
+    UA_CreateMonitoredItemsResponse_clear(&createMonitoredItemsResponse);
+
+    UA_MonitoredItem *mon = NULL;
+    UA_Subscription *sub;
+    TAILQ_FOREACH(sub, &session->subscriptions, sessionListEntry) {
+        if(sub->subscriptionId == localSubscriptionId)
+            break;
+    }
+    ck_assert_ptr_ne(sub, NULL);
+    UA_assert(sub);
+    mon = UA_Subscription_getMonitoredItem(sub, localMonitoredItemId);
+    ck_assert_ptr_ne(mon, NULL);
+    UA_assert(mon);
+
+    /* Fill the queue and overflow it twice */
+    for(size_t i = 0; i < 4; i++) {
+        UA_fakeSleep(1); /* modify the server's currenttime */
+        UA_LOCK(&server->serviceMutex);
+        UA_MonitoredItem_sample(server, mon);
+        UA_UNLOCK(&server->serviceMutex);
+    }
+    ck_assert_uint_eq(mon->queueSize, 3);
+    ck_assert_uint_eq(sub->notificationQueueSize, 3);
+
+    /* The oldest entries are kept. The newest has the overflow bit. */
+    UA_Notification *first = TAILQ_FIRST(&mon->queue);
+    UA_Notification *last = TAILQ_LAST(&mon->queue, NotificationQueue);
+    ck_assert_uint_eq(first->data.dataChange.value.hasStatus, false);
+    ck_assert_uint_eq(last->data.dataChange.value.hasStatus, true);
+    ck_assert_uint_eq(last->data.dataChange.value.status,
+                      UA_STATUSCODE_INFOTYPE_DATAVALUE | UA_STATUSCODE_INFOBITS_OVERFLOW);
+    ck_assert_ptr_eq(TAILQ_LAST(&sub->notificationQueue, NotificationQueue), last);
+
+    UA_DateTime *newest = (UA_DateTime*)last->data.dataChange.value.value.data;
+    UA_DateTime *oldest = (UA_DateTime*)first->data.dataChange.value.value.data;
+    ck_assert(*newest > *oldest);
+
+    /* Remove the subscription */
+    UA_DeleteSubscriptionsRequest deleteSubscriptionsRequest;
+    UA_DeleteSubscriptionsRequest_init(&deleteSubscriptionsRequest);
+    deleteSubscriptionsRequest.subscriptionIdsSize = 1;
+    deleteSubscriptionsRequest.subscriptionIds = &localSubscriptionId;
+    UA_DeleteSubscriptionsResponse deleteSubscriptionsResponse;
+    UA_DeleteSubscriptionsResponse_init(&deleteSubscriptionsResponse);
+    UA_LOCK(&server->serviceMutex);
+    Service_DeleteSubscriptions(server, session, &deleteSubscriptionsRequest,
+                                &deleteSubscriptionsResponse);
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_uint_eq(deleteSubscriptionsResponse.resultsSize, 1);
+    ck_assert_uint_eq(deleteSubscriptionsResponse.results[0], UA_STATUSCODE_GOOD);
+    UA_DeleteSubscriptionsResponse_clear(&deleteSubscriptionsResponse);
+}
+END_TEST
+
 START_TEST(Server_setMonitoringMode) {
     createSubscription();
     createMonitoredItem();
@@ -863,6 +1086,556 @@ START_TEST(Server_negativeSamplingInterval) {
 }
 END_TEST
 
+static size_t
+countSamplingGroups(UA_Double samplingInterval, size_t *groupSize) {
+    size_t count = 0;
+    UA_SamplingGroup *sg;
+    LIST_FOREACH(sg, &server->samplingGroups, listEntry) {
+        count++;
+        if(sg->samplingInterval != samplingInterval)
+            continue;
+        *groupSize = 0;
+        UA_MonitoredItem *mon;
+        LIST_FOREACH(mon, &sg->monitoredItems, sampling.cyclic.groupEntry)
+            (*groupSize)++;
+    }
+    return count;
+}
+
+/* MonitoredItems with the same sampling interval share a SamplingGroup */
+START_TEST(Server_samplingGroups) {
+    createSubscription();
+
+    UA_Double intervals[3] = {250.0, 1000.0, 250.0};
+    UA_MonitoredItemCreateRequest items[3];
+    for(size_t i = 0; i < 3; i++) {
+        UA_MonitoredItemCreateRequest_init(&items[i]);
+        items[i].itemToMonitor.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
+        items[i].itemToMonitor.attributeId = UA_ATTRIBUTEID_BROWSENAME;
+        items[i].monitoringMode = UA_MONITORINGMODE_REPORTING;
+        items[i].requestedParameters.samplingInterval = intervals[i];
+    }
+
+    UA_CreateMonitoredItemsRequest request;
+    UA_CreateMonitoredItemsRequest_init(&request);
+    request.subscriptionId = subscriptionId;
+    request.timestampsToReturn = UA_TIMESTAMPSTORETURN_SERVER;
+    request.itemsToCreateSize = 3;
+    request.itemsToCreate = items;
+
+    UA_CreateMonitoredItemsResponse response;
+    UA_CreateMonitoredItemsResponse_init(&response);
+    UA_LOCK(&server->serviceMutex);
+    Service_CreateMonitoredItems(server, session, &request, &response);
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.resultsSize, 3);
+    UA_UInt32 ids[3];
+    for(size_t i = 0; i < 3; i++) {
+        ck_assert_uint_eq(response.results[i].statusCode, UA_STATUSCODE_GOOD);
+        ck_assert(response.results[i].revisedSamplingInterval == intervals[i]);
+        ids[i] = response.results[i].monitoredItemId;
+    }
+    UA_CreateMonitoredItemsResponse_clear(&response);
+
+    size_t groupSize = 0;
+    ck_assert_uint_eq(countSamplingGroups(250.0, &groupSize), 2);
+    ck_assert_uint_eq(groupSize, 2);
+
+    /* Sample */
+    UA_fakeSleep(1000);
+    UA_Server_run_iterate(server, false);
+
+    /* The group remains until the last MonitoredItem is deleted */
+    UA_DeleteMonitoredItemsRequest deleteRequest;
+    UA_DeleteMonitoredItemsRequest_init(&deleteRequest);
+    deleteRequest.subscriptionId = subscriptionId;
+    deleteRequest.monitoredItemIdsSize = 2;
+    deleteRequest.monitoredItemIds = ids;
+    UA_DeleteMonitoredItemsResponse deleteResponse;
+    UA_DeleteMonitoredItemsResponse_init(&deleteResponse);
+    UA_LOCK(&server->serviceMutex);
+    Service_DeleteMonitoredItems(server, session, &deleteRequest, &deleteResponse);
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_uint_eq(deleteResponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    UA_DeleteMonitoredItemsResponse_clear(&deleteResponse);
+
+    ck_assert_uint_eq(countSamplingGroups(250.0, &groupSize), 1);
+    ck_assert_uint_eq(groupSize, 1);
+
+    UA_DeleteMonitoredItemsResponse_init(&deleteResponse);
+    deleteRequest.monitoredItemIdsSize = 1;
+    deleteRequest.monitoredItemIds = &ids[2];
+    UA_LOCK(&server->serviceMutex);
+    Service_DeleteMonitoredItems(server, session, &deleteRequest, &deleteResponse);
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_uint_eq(deleteResponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    UA_DeleteMonitoredItemsResponse_clear(&deleteResponse);
+
+    ck_assert(LIST_EMPTY(&server->samplingGroups));
+    UA_Server_run_iterate(server, false);
+}
+END_TEST
+
+/* Large requests defer the initial samples to the next EventLoop iterations */
+START_TEST(Server_createMonitoredItemsBatch) {
+    UA_Server_getConfig(server)->monitoredItemsBatchThreshold = 3;
+    createSubscription();
+
+    UA_MonitoredItemCreateRequest items[4];
+    for(size_t i = 0; i < 4; i++) {
+        UA_MonitoredItemCreateRequest_init(&items[i]);
+        items[i].itemToMonitor.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
+        items[i].itemToMonitor.attributeId = UA_ATTRIBUTEID_BROWSENAME;
+        items[i].monitoringMode = UA_MONITORINGMODE_REPORTING;
+        items[i].requestedParameters.samplingInterval = 250.0;
+    }
+
+    UA_CreateMonitoredItemsRequest request;
+    UA_CreateMonitoredItemsRequest_init(&request);
+    request.subscriptionId = subscriptionId;
+    request.timestampsToReturn = UA_TIMESTAMPSTORETURN_SERVER;
+    request.itemsToCreateSize = 4;
+    request.itemsToCreate = items;
+
+    UA_CreateMonitoredItemsResponse response;
+    UA_CreateMonitoredItemsResponse_init(&response);
+    UA_LOCK(&server->serviceMutex);
+    Service_CreateMonitoredItems(server, session, &request, &response);
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.resultsSize, 4);
+    for(size_t i = 0; i < 4; i++)
+        ck_assert_uint_eq(response.results[i].statusCode, UA_STATUSCODE_GOOD);
+    UA_UInt32 deleteId = response.results[0].monitoredItemId;
+    UA_CreateMonitoredItemsResponse_clear(&response);
+
+    /* Not sampled yet */
+    UA_Subscription *sub = UA_Session_getSubscriptionById(session, subscriptionId);
+    ck_assert_ptr_ne(sub, NULL);
+    ck_assert_uint_eq(sub->notificationQueueSize, 0);
+    size_t pending = 0;
+    UA_MonitoredItem *mon;
+    TAILQ_FOREACH(mon, &server->initialSamples, initialSampleEntry)
+        pending++;
+    ck_assert_uint_eq(pending, 4);
+
+    /* Deleted MonitoredItems are removed from the queue */
+    UA_DeleteMonitoredItemsRequest deleteRequest;
+    UA_DeleteMonitoredItemsRequest_init(&deleteRequest);
+    deleteRequest.subscriptionId = subscriptionId;
+    deleteRequest.monitoredItemIdsSize = 1;
+    deleteRequest.monitoredItemIds = &deleteId;
+    UA_DeleteMonitoredItemsResponse deleteResponse;
+    UA_DeleteMonitoredItemsResponse_init(&deleteResponse);
+    UA_LOCK(&server->serviceMutex);
+    Service_DeleteMonitoredItems(server, session, &deleteRequest, &deleteResponse);
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_uint_eq(deleteResponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    UA_DeleteMonitoredItemsResponse_clear(&deleteResponse);
+
+    /* The initial samples are taken in the next iteration */
+    UA_Server_run_iterate(server, false);
+    ck_assert(TAILQ_EMPTY(&server->initialSamples));
+    ck_assert_uint_eq(sub->notificationQueueSize, 3);
+}
+END_TEST
+
+/* The transfer relinks the MonitoredItems and queues to the new Subscription */
+START_TEST(Server_transferSubscription) {
+    createSubscription();
+
+    UA_Double intervals[3] = {-1.0, 250.0, -1.0};
+    UA_MonitoredItemCreateRequest items[3];
+    for(size_t i = 0; i < 3; i++) {
+        UA_MonitoredItemCreateRequest_init(&items[i]);
+        items[i].itemToMonitor.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
+        items[i].itemToMonitor.attributeId = UA_ATTRIBUTEID_BROWSENAME;
+        items[i].monitoringMode = UA_MONITORINGMODE_REPORTING;
+        items[i].requestedParameters.samplingInterval = intervals[i];
+    }
+
+    UA_CreateMonitoredItemsRequest request;
+    UA_CreateMonitoredItemsRequest_init(&request);
+    request.subscriptionId = subscriptionId;
+    request.timestampsToReturn = UA_TIMESTAMPSTORETURN_SERVER;
+    request.itemsToCreateSize = 3;
+    request.itemsToCreate = items;
+
+    UA_CreateMonitoredItemsResponse response;
+    UA_CreateMonitoredItemsResponse_init(&response);
+    UA_LOCK(&server->serviceMutex);
+    Service_CreateMonitoredItems(server, session, &request, &response);
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.resultsSize, 3);
+    UA_UInt32 deleteId = response.results[2].monitoredItemId; /* List head */
+    UA_CreateMonitoredItemsResponse_clear(&response);
+
+    UA_Subscription *oldSub = UA_Session_getSubscriptionById(session, subscriptionId);
+    ck_assert_ptr_ne(oldSub, NULL);
+    UA_UInt32 queued = oldSub->notificationQueueSize;
+    ck_assert_uint_eq(queued, 3);
+
+    /* Transfer to a second Session */
+    UA_Session *oldSession = session;
+    createSession();
+    UA_TransferSubscriptionsRequest trequest;
+    UA_TransferSubscriptionsRequest_init(&trequest);
+    trequest.subscriptionIds = &subscriptionId;
+    trequest.subscriptionIdsSize = 1;
+    UA_TransferSubscriptionsResponse tresponse;
+    UA_TransferSubscriptionsResponse_init(&tresponse);
+    UA_LOCK(&server->serviceMutex);
+    Service_TransferSubscriptions(server, session, &trequest, &tresponse);
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_uint_eq(tresponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(tresponse.resultsSize, 1);
+    ck_assert_uint_eq(tresponse.results[0].statusCode, UA_STATUSCODE_GOOD);
+    UA_TransferSubscriptionsResponse_clear(&tresponse);
+    ck_assert_ptr_eq(UA_Session_getSubscriptionById(oldSession, subscriptionId), NULL);
+
+    UA_Subscription *sub = UA_Session_getSubscriptionById(session, subscriptionId);
+    ck_assert_ptr_ne(sub, NULL);
+    ck_assert_ptr_ne(sub, oldSub);
+    ck_assert_uint_eq(sub->monitoredItemsSize, 3);
+    ck_assert_uint_eq(sub->notificationQueueSize, queued);
+    UA_MonitoredItem *mon;
+    LIST_FOREACH(mon, &sub->monitoredItems, listEntry)
+        ck_assert_ptr_eq(mon->subscription, sub);
+    size_t count = 0;
+    LIST_FOREACH(mon, &sub->samplingMonitoredItems, sampling.subscriptionSampling)
+        count++;
+    ck_assert_uint_eq(count, 2);
+    mon = LIST_FIRST(&sub->samplingMonitoredItems);
+    ck_assert_ptr_eq(mon->sampling.subscriptionSampling.le_prev,
+                     &sub->samplingMonitoredItems.lh_first);
+    count = 0;
+    UA_Notification *n;
+    TAILQ_FOREACH(n, &sub->notificationQueue, subEntry)
+        count++;
+    ck_assert_uint_eq(count, queued);
+
+    /* The original Subscription is removed in its next publish cycle. Then
+     * remove a MonitoredItem from the relinked lists. */
+    for(size_t i = 0; i < 3; i++) {
+        UA_fakeSleep((UA_UInt32)sub->publishingInterval + 1);
+        UA_Server_run_iterate(server, false);
+    }
+    UA_DeleteMonitoredItemsRequest deleteRequest;
+    UA_DeleteMonitoredItemsRequest_init(&deleteRequest);
+    deleteRequest.subscriptionId = subscriptionId;
+    deleteRequest.monitoredItemIdsSize = 1;
+    deleteRequest.monitoredItemIds = &deleteId;
+    UA_DeleteMonitoredItemsResponse deleteResponse;
+    UA_DeleteMonitoredItemsResponse_init(&deleteResponse);
+    UA_LOCK(&server->serviceMutex);
+    Service_DeleteMonitoredItems(server, session, &deleteRequest, &deleteResponse);
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_uint_eq(deleteResponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(deleteResponse.results[0], UA_STATUSCODE_GOOD);
+    UA_DeleteMonitoredItemsResponse_clear(&deleteResponse);
+    ck_assert_uint_eq(sub->monitoredItemsSize, 2);
+}
+END_TEST
+
+static UA_NodeId deniedSessionId;
+
+static UA_Byte
+denySessionAccessLevel(UA_Server *s, UA_AccessControl *ac,
+                       const UA_NodeId *sessionId, void *sessionContext,
+                       const UA_NodeId *nodeId, void *nodeContext) {
+    if(sessionId && UA_NodeId_equal(sessionId, &deniedSessionId))
+        return 0;
+    return 0xFF;
+}
+
+static void
+createMonitoredItemsShared(const UA_NodeId *nodeId, size_t count) {
+    UA_MonitoredItemCreateRequest items[2];
+    for(size_t i = 0; i < count; i++) {
+        UA_MonitoredItemCreateRequest_init(&items[i]);
+        items[i].itemToMonitor.nodeId = *nodeId;
+        items[i].itemToMonitor.attributeId = UA_ATTRIBUTEID_VALUE;
+        items[i].monitoringMode = UA_MONITORINGMODE_REPORTING;
+        items[i].requestedParameters.samplingInterval = 250.0;
+    }
+
+    UA_CreateMonitoredItemsRequest request;
+    UA_CreateMonitoredItemsRequest_init(&request);
+    request.subscriptionId = subscriptionId;
+    request.timestampsToReturn = UA_TIMESTAMPSTORETURN_SERVER;
+    request.itemsToCreateSize = count;
+    request.itemsToCreate = items;
+
+    UA_CreateMonitoredItemsResponse response;
+    UA_CreateMonitoredItemsResponse_init(&response);
+    UA_LOCK(&server->serviceMutex);
+    Service_CreateMonitoredItems(server, session, &request, &response);
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.resultsSize, count);
+    for(size_t i = 0; i < count; i++)
+        ck_assert_uint_eq(response.results[i].statusCode, UA_STATUSCODE_GOOD);
+    UA_CreateMonitoredItemsResponse_clear(&response);
+}
+
+/* MonitoredItems of different Sessions on the same node are sampled together.
+ * The value is only shared with Sessions that have the access rights. */
+START_TEST(Server_sharedSampling) {
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    UA_Int32 value = 1;
+    UA_Variant_setScalar(&attr.value, &value, &UA_TYPES[UA_TYPES_INT32]);
+    UA_NodeId varId = UA_NODEID_STRING(1, "sharedSampling");
+    UA_StatusCode res =
+        UA_Server_addVariableNode(server, varId, UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, "sharedSampling"),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                  attr, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* Two MonitoredItems on the node and one on another node in the first
+     * Session. Two MonitoredItems on the node in the second Session. */
+    createSubscription();
+    UA_Subscription *subA = UA_Session_getSubscriptionById(session, subscriptionId);
+    createMonitoredItemsShared(&varId, 2);
+    UA_NodeId otherId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_STATE);
+    createMonitoredItemsShared(&otherId, 1);
+    createSession();
+    createSubscription();
+    UA_Subscription *subB = UA_Session_getSubscriptionById(session, subscriptionId);
+    createMonitoredItemsShared(&varId, 2);
+
+    /* The MonitoredItems on the node follow each other in the group */
+    UA_SamplingGroup *sg = LIST_FIRST(&server->samplingGroups);
+    ck_assert_ptr_ne(sg, NULL);
+    ck_assert_uint_eq(sg->monitoredItemsSize, 5);
+    UA_MonitoredItem *mon;
+    size_t shared = 0, run = 0, maxRun = 0;
+    LIST_FOREACH(mon, &sg->monitoredItems, sampling.cyclic.groupEntry) {
+        if(mon->sampling.cyclic.shared) {
+            shared++;
+            run++;
+        } else {
+            run = 1;
+        }
+        if(run > maxRun)
+            maxRun = run;
+    }
+    ck_assert_uint_eq(shared, 3);
+    ck_assert_uint_eq(maxRun, 4);
+
+    /* Deny the access for the second Session */
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    config->accessControl.getUserAccessLevel = denySessionAccessLevel;
+    config->accessControl.decisionEpoch++;
+    deniedSessionId = session->sessionId;
+
+    /* Change the value and sample */
+    value = 2;
+    UA_Variant v;
+    UA_Variant_setScalar(&v, &value, &UA_TYPES[UA_TYPES_INT32]);
+    res = UA_Server_writeValue(server, varId, v);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_fakeSleep(250);
+    UA_Server_run_iterate(server, false);
+
+    size_t count = 0;
+    LIST_FOREACH(mon, &subA->monitoredItems, listEntry) {
+        if(!UA_NodeId_equal(&mon->itemToMonitor.nodeId, &varId))
+            continue;
+        ck_assert(mon->lastValue.hasValue);
+        ck_assert_int_eq(*(UA_Int32*)mon->lastValue.value.data, 2);
+        count++;
+    }
+    LIST_FOREACH(mon, &subB->monitoredItems, listEntry) {
+        ck_assert(!mon->lastValue.hasValue);
+        ck_assert(mon->lastValue.hasStatus);
+        ck_assert_uint_eq(mon->lastValue.status, UA_STATUSCODE_BADUSERACCESSDENIED);
+        count++;
+    }
+    ck_assert_uint_eq(count, 4);
+
+    /* Deleting the indexed MonitoredItem hands the index to the next one */
+    UA_MonitoredItem *first = NULL;
+    LIST_FOREACH(mon, &sg->monitoredItems, sampling.cyclic.groupEntry) {
+        if(UA_NodeId_equal(&mon->itemToMonitor.nodeId, &varId)) {
+            first = mon;
+            break;
+        }
+    }
+    ck_assert_ptr_ne(first, NULL);
+    ck_assert(!first->sampling.cyclic.shared);
+    UA_MonitoredItem *next = LIST_NEXT(first, sampling.cyclic.groupEntry);
+    ck_assert(next->sampling.cyclic.shared);
+    UA_LOCK(&server->serviceMutex);
+    UA_MonitoredItem_delete(server, first);
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert(!next->sampling.cyclic.shared);
+
+    /* A new MonitoredItem joins the remaining ones */
+    createMonitoredItemsShared(&varId, 1);
+    ck_assert_ptr_eq(LIST_NEXT(next, sampling.cyclic.groupEntry)->subscription, subB);
+    ck_assert(LIST_NEXT(next, sampling.cyclic.groupEntry)->sampling.cyclic.shared);
+    UA_Server_run_iterate(server, false);
+}
+END_TEST
+
+#if UA_MULTITHREADING >= 200 && defined(UA_ARCHITECTURE_POSIX)
+/* Large SamplingGroups read the values in parallel worker threads. The
+ * DataSource of the CurrentTime is read by the EventLoop thread. */
+START_TEST(Server_parallelSampling) {
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    config->parallelSamplingThreshold = 10;
+    config->parallelReadThreads = 4;
+
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    UA_Int32 value = 1;
+    UA_Variant_setScalar(&attr.value, &value, &UA_TYPES[UA_TYPES_INT32]);
+    UA_NodeId varId = UA_NODEID_STRING(1, "parallelSampling");
+    UA_StatusCode res =
+        UA_Server_addVariableNode(server, varId, UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, "parallelSampling"),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                  attr, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    createSubscription();
+
+    UA_MonitoredItemCreateRequest items[100];
+    for(size_t i = 0; i < 100; i++) {
+        UA_MonitoredItemCreateRequest_init(&items[i]);
+        items[i].itemToMonitor.nodeId = (i % 10 == 0) ?
+            UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_CURRENTTIME) : varId;
+        items[i].itemToMonitor.attributeId = UA_ATTRIBUTEID_VALUE;
+        items[i].monitoringMode = UA_MONITORINGMODE_REPORTING;
+        items[i].requestedParameters.samplingInterval = 250.0;
+    }
+
+    UA_CreateMonitoredItemsRequest request;
+    UA_CreateMonitoredItemsRequest_init(&request);
+    request.subscriptionId = subscriptionId;
+    request.timestampsToReturn = UA_TIMESTAMPSTORETURN_SERVER;
+    request.itemsToCreateSize = 100;
+    request.itemsToCreate = items;
+
+    UA_CreateMonitoredItemsResponse response;
+    UA_CreateMonitoredItemsResponse_init(&response);
+    UA_LOCK(&server->serviceMutex);
+    Service_CreateMonitoredItems(server, session, &request, &response);
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.resultsSize, 100);
+    for(size_t i = 0; i < 100; i++)
+        ck_assert_uint_eq(response.results[i].statusCode, UA_STATUSCODE_GOOD);
+    UA_CreateMonitoredItemsResponse_clear(&response);
+
+    size_t groupSize = 0;
+    ck_assert_uint_eq(countSamplingGroups(250.0, &groupSize), 1);
+    ck_assert_uint_eq(groupSize, 100);
+    ck_assert_uint_eq(LIST_FIRST(&server->samplingGroups)->monitoredItemsSize, 100);
+
+    /* Change the value and sample */
+    value = 2;
+    UA_Variant v;
+    UA_Variant_setScalar(&v, &value, &UA_TYPES[UA_TYPES_INT32]);
+    res = UA_Server_writeValue(server, varId, v);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_fakeSleep(250);
+    UA_Server_run_iterate(server, false);
+
+    UA_Subscription *sub = UA_Session_getSubscriptionById(session, subscriptionId);
+    ck_assert_ptr_ne(sub, NULL);
+    UA_MonitoredItem *mon;
+    size_t count = 0;
+    LIST_FOREACH(mon, &sub->monitoredItems, listEntry) {
+        count++;
+        ck_assert(mon->lastValue.hasValue);
+        if(mon->lastValue.value.type == &UA_TYPES[UA_TYPES_INT32])
+            ck_assert_int_eq(*(UA_Int32*)mon->lastValue.value.data, 2);
+        else
+            ck_assert(mon->lastValue.value.type == &UA_TYPES[UA_TYPES_DATETIME]);
+    }
+    ck_assert_uint_eq(count, 100);
+}
+END_TEST
+#endif
+
+/* Subscriptions with the same publishing interval share a PublishGroup that is
+ * ordered by descending priority */
+START_TEST(Server_publishGroups) {
+    UA_UInt32 ids[3];
+    UA_Byte priorities[3] = {1, 5, 3};
+    for(size_t i = 0; i < 3; i++) {
+        UA_CreateSubscriptionRequest request;
+        UA_CreateSubscriptionRequest_init(&request);
+        request.publishingEnabled = true;
+        request.requestedPublishingInterval = 500.0;
+        request.priority = priorities[i];
+        UA_CreateSubscriptionResponse response;
+        UA_CreateSubscriptionResponse_init(&response);
+        UA_LOCK(&server->serviceMutex);
+        Service_CreateSubscription(server, session, &request, &response);
+        UA_UNLOCK(&server->serviceMutex);
+        ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+        ids[i] = response.subscriptionId;
+        UA_CreateSubscriptionResponse_clear(&response);
+    }
+
+    UA_PublishGroup *pg = LIST_FIRST(&server->publishGroups);
+    ck_assert_ptr_ne(pg, NULL);
+    UA_assert(pg);
+    ck_assert_ptr_eq(LIST_NEXT(pg, listEntry), NULL);
+    UA_Subscription *sub = LIST_FIRST(&pg->subscriptions);
+    ck_assert_uint_eq(sub->subscriptionId, ids[1]);
+    sub = LIST_NEXT(sub, publishGroupEntry);
+    ck_assert_uint_eq(sub->subscriptionId, ids[2]);
+    sub = LIST_NEXT(sub, publishGroupEntry);
+    ck_assert_uint_eq(sub->subscriptionId, ids[0]);
+
+    /* Publish all Subscriptions in one callback */
+    UA_fakeSleep(501);
+    UA_Server_run_iterate(server, false);
+
+    /* Changing the interval moves the Subscription to a new group */
+    UA_ModifySubscriptionRequest modRequest;
+    UA_ModifySubscriptionRequest_init(&modRequest);
+    modRequest.subscriptionId = ids[1];
+    modRequest.requestedPublishingInterval = 1000.0;
+    modRequest.priority = priorities[1];
+    UA_ModifySubscriptionResponse modResponse;
+    UA_ModifySubscriptionResponse_init(&modResponse);
+    UA_LOCK(&server->serviceMutex);
+    Service_ModifySubscription(server, session, &modRequest, &modResponse);
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_uint_eq(modResponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    UA_ModifySubscriptionResponse_clear(&modResponse);
+
+    size_t groups = 0;
+    LIST_FOREACH(pg, &server->publishGroups, listEntry)
+        groups++;
+    ck_assert_uint_eq(groups, 2);
+
+    /* Remove the subscriptions */
+    UA_DeleteSubscriptionsRequest delRequest;
+    UA_DeleteSubscriptionsRequest_init(&delRequest);
+    delRequest.subscriptionIdsSize = 3;
+    delRequest.subscriptionIds = ids;
+    UA_DeleteSubscriptionsResponse delResponse;
+    UA_DeleteSubscriptionsResponse_init(&delResponse);
+    UA_LOCK(&server->serviceMutex);
+    Service_DeleteSubscriptions(server, session, &delRequest, &delResponse);
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_uint_eq(delResponse.resultsSize, 3);
+    UA_DeleteSubscriptionsResponse_clear(&delResponse);
+
+    ck_assert(LIST_EMPTY(&server->publishGroups));
+    UA_Server_run_iterate(server, false);
+}
+END_TEST
+
 #endif /* UA_ENABLE_SUBSCRIPTIONS */
 
 static Suite* testSuite_Client(void) {
@@ -877,14 +1650,25 @@ static Suite* testSuite_Client(void) {
     tcase_add_test(tc_server, Server_createMonitoredItems);
     tcase_add_test(tc_server, Server_modifyMonitoredItems);
     tcase_add_test(tc_server, Server_overflow);
+    tcase_add_test(tc_server, Server_overflowDiscardNewest);
     tcase_add_test(tc_server, Server_setMonitoringMode);
     tcase_add_test(tc_server, Server_deleteMonitoredItems);
     tcase_add_test(tc_server, Server_republish);
+    tcase_add_test(tc_server, Server_republishEncoded);
+    tcase_add_test(tc_server, Server_retransmissionBytes);
     tcase_add_test(tc_server, Server_republish_invalid);
     tcase_add_test(tc_server, Server_deleteSubscription);
     tcase_add_test(tc_server, Server_publishCallback);
     tcase_add_test(tc_server, Server_lifeTimeCount);
     tcase_add_test(tc_server, Server_invalidPublishingInterval);
+    tcase_add_test(tc_server, Server_samplingGroups);
+    tcase_add_test(tc_server, Server_createMonitoredItemsBatch);
+    tcase_add_test(tc_server, Server_publishGroups);
+    tcase_add_test(tc_server, Server_transferSubscription);
+    tcase_add_test(tc_server, Server_sharedSampling);
+#if UA_MULTITHREADING >= 200 && defined(UA_ARCHITECTURE_POSIX)
+    tcase_add_test(tc_server, Server_parallelSampling);
+#endif
 #endif /* UA_ENABLE_SUBSCRIPTIONS */
     suite_add_tcase(s, tc_server);
 
@@ -4,6 +4,7 @@
 
 #include <open62541/client.h>
 #include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
 #include <open62541/server.h>
 #include <open62541/server_config_default.h>
 
@@ -271,6 +272,59 @@ START_TEST(Service_Browse_ReferenceTypes) {
 }
 END_TEST
 
+START_TEST(Service_IsNodeInTree_TypeHierarchy) {
+    UA_Server *server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+
+    /* BaseObjectType <- T1 <- T2 */
+    UA_NodeId baseObjectType = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE);
+    UA_NodeId folderType = UA_NODEID_NUMERIC(0, UA_NS0ID_FOLDERTYPE);
+    UA_NodeId hasSubtype = UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE);
+    UA_NodeId t1 = UA_NODEID_NUMERIC(1, 5001);
+    UA_NodeId t2 = UA_NODEID_NUMERIC(1, 5002);
+    UA_ObjectTypeAttributes attr = UA_ObjectTypeAttributes_default;
+    UA_StatusCode res =
+        UA_Server_addObjectTypeNode(server, t1, baseObjectType, hasSubtype,
+                                    UA_QUALIFIEDNAME(1, "T1"), attr, NULL, NULL);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    res = UA_Server_addObjectTypeNode(server, t2, t1, hasSubtype,
+                                      UA_QUALIFIEDNAME(1, "T2"), attr, NULL, NULL);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+
+    /* Repeat the checks. The first ones search the nodestore, the later ones
+     * use the cached hierarchy. */
+    for(size_t i = 0; i < 100; i++) {
+        ck_assert(isNodeInTree_singleRef(server, &t2, &t2, UA_REFERENCETYPEINDEX_HASSUBTYPE));
+        ck_assert(isNodeInTree_singleRef(server, &t2, &t1, UA_REFERENCETYPEINDEX_HASSUBTYPE));
+        ck_assert(isNodeInTree_singleRef(server, &t2, &baseObjectType,
+                                         UA_REFERENCETYPEINDEX_HASSUBTYPE));
+        ck_assert(!isNodeInTree_singleRef(server, &baseObjectType, &t2,
+                                          UA_REFERENCETYPEINDEX_HASSUBTYPE));
+        ck_assert(!isNodeInTree_singleRef(server, &t2, &folderType,
+                                          UA_REFERENCETYPEINDEX_HASSUBTYPE));
+        ck_assert(isNodeInTree_singleRef(server, &folderType, &baseObjectType,
+                                         UA_REFERENCETYPEINDEX_HASSUBTYPE));
+    }
+
+    /* Move T2 below the FolderType */
+    UA_ExpandedNodeId t2Exp = UA_EXPANDEDNODEID_NUMERIC(1, 5002);
+    res = UA_Server_deleteReference(server, t1, hasSubtype, true, t2Exp, true);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    res = UA_Server_addReference(server, folderType, hasSubtype, t2Exp, true);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+
+    for(size_t i = 0; i < 100; i++) {
+        ck_assert(!isNodeInTree_singleRef(server, &t2, &t1, UA_REFERENCETYPEINDEX_HASSUBTYPE));
+        ck_assert(isNodeInTree_singleRef(server, &t2, &folderType,
+                                         UA_REFERENCETYPEINDEX_HASSUBTYPE));
+        ck_assert(isNodeInTree_singleRef(server, &t2, &baseObjectType,
+                                         UA_REFERENCETYPEINDEX_HASSUBTYPE));
+    }
+
+    UA_Server_delete(server);
+}
+END_TEST
+
 START_TEST(Service_Browse_Recursive) {
     UA_Server *server = UA_Server_newForUnitTest();
     ck_assert(server != NULL);
@@ -303,6 +357,72 @@ START_TEST(Service_Browse_Recursive) {
 }
 END_TEST
 
+/* A node reachable via a long and a short path. The nodes below are found
+ * although the long path reaches the recursion limit. */
+START_TEST(Service_Browse_RecursiveShortestPath) {
+    UA_Server *server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+
+    UA_NodeId organizes = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+    UA_NodeId folderType = UA_NODEID_NUMERIC(0, UA_NS0ID_FOLDERTYPE);
+    UA_ObjectAttributes attr = UA_ObjectAttributes_default;
+
+    /* Long path: Start -> 1 -> ... -> 48 -> Shared */
+    UA_NodeId start = UA_NODEID_NUMERIC(1, 8000);
+    UA_StatusCode res =
+        UA_Server_addObjectNode(server, start, UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                organizes, UA_QUALIFIEDNAME(1, "Start"), folderType,
+                                attr, NULL, NULL);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    UA_NodeId parent = start;
+    for(UA_UInt32 i = 1; i <= 48; i++) {
+        UA_NodeId id = UA_NODEID_NUMERIC(1, 8000 + i);
+        res = UA_Server_addObjectNode(server, id, parent, organizes,
+                                      UA_QUALIFIEDNAME(1, "Chain"), folderType,
+                                      attr, NULL, NULL);
+        ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+        parent = id;
+    }
+    UA_NodeId shared = UA_NODEID_NUMERIC(1, 8100);
+    res = UA_Server_addObjectNode(server, shared, parent, organizes,
+                                  UA_QUALIFIEDNAME(1, "Shared"), folderType,
+                                  attr, NULL, NULL);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+
+    /* Short path: Start -> Shared -> Leaf */
+    UA_ExpandedNodeId sharedExp = UA_EXPANDEDNODEID_NUMERIC(1, 8100);
+    res = UA_Server_addReference(server, start, organizes, sharedExp, true);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    UA_NodeId leaf = UA_NODEID_NUMERIC(1, 8101);
+    res = UA_Server_addObjectNode(server, leaf, shared, organizes,
+                                  UA_QUALIFIEDNAME(1, "Leaf"), folderType,
+                                  attr, NULL, NULL);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = start;
+    bd.referenceTypeId = organizes;
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+    size_t resultSize = 0;
+    UA_ExpandedNodeId *result = NULL;
+    res = UA_Server_browseRecursive(server, &bd, &resultSize, &result);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+
+    /* 48 chain nodes, Shared and Leaf */
+    ck_assert_uint_eq(resultSize, 50);
+    UA_Boolean foundLeaf = false;
+    for(size_t i = 0; i < resultSize; i++) {
+        ck_assert(!UA_NodeId_equal(&result[i].nodeId, &start));
+        foundLeaf |= UA_NodeId_equal(&result[i].nodeId, &leaf);
+    }
+    ck_assert(foundLeaf);
+
+    UA_Array_delete(result, resultSize, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
+    UA_Server_delete(server);
+}
+END_TEST
+
 START_TEST(Service_Browse_Localization) {
     UA_Server *server = UA_Server_newForUnitTest();
     ck_assert(server != NULL);
@@ -458,6 +578,226 @@ START_TEST(Service_TranslateBrowsePathsWithHashCollision) {
 }
 END_TEST
 
+/* Wide folders get a BrowseName index independent of the nodestore */
+START_TEST(Service_TranslateBrowsePathsWideFolder) {
+    UA_NodeId folderId = UA_NODEID_NUMERIC(1, 6000);
+    UA_ObjectAttributes oattr = UA_ObjectAttributes_default;
+    UA_StatusCode res =
+        UA_Server_addObjectNode(server_translate_browse, folderId,
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                UA_QUALIFIEDNAME(1, "WideFolder"),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_FOLDERTYPE),
+                                oattr, NULL, NULL);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+
+    char name[32];
+    for(UA_UInt32 i = 0; i < 100; i++) {
+        snprintf(name, sizeof(name), "Child%u", (unsigned)i);
+        UA_VariableAttributes vattr = UA_VariableAttributes_default;
+        res = UA_Server_addVariableNode(server_translate_browse,
+                                        UA_NODEID_NUMERIC(1, 6001 + i), folderId,
+                                        UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                        UA_QUALIFIEDNAME(1, name),
+                                        UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                        vattr, NULL, NULL);
+        ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    }
+
+    /* The Organizes references of the folder are organized in a tree */
+    const UA_Node *folder = UA_NODESTORE_GET(server_translate_browse, &folderId);
+    ck_assert(folder != NULL);
+    UA_Boolean foundTree = false;
+    for(size_t i = 0; i < folder->head.referencesSize; i++) {
+        const UA_NodeReferenceKind *rk = &folder->head.references[i];
+        if(!rk->isInverse && rk->targetsSize == 100)
+            foundTree = rk->hasRefTree;
+    }
+    UA_NODESTORE_RELEASE(server_translate_browse, folder);
+    ck_assert(foundTree);
+
+    UA_RelativePathElement rpe;
+    UA_RelativePathElement_init(&rpe);
+    rpe.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+    UA_BrowsePath browsePath;
+    UA_BrowsePath_init(&browsePath);
+    browsePath.startingNode = folderId;
+    browsePath.relativePath.elements = &rpe;
+    browsePath.relativePath.elementsSize = 1;
+    for(UA_UInt32 i = 0; i < 100; i++) {
+        snprintf(name, sizeof(name), "Child%u", (unsigned)i);
+        rpe.targetName = UA_QUALIFIEDNAME(1, name);
+        UA_BrowsePathResult bpr =
+            UA_Server_translateBrowsePathToNodeIds(server_translate_browse, &browsePath);
+        ck_assert_int_eq(bpr.statusCode, UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(bpr.targetsSize, 1);
+        ck_assert_uint_eq(bpr.targets[0].targetId.nodeId.identifier.numeric, 6001 + i);
+        UA_BrowsePathResult_clear(&bpr);
+    }
+}
+END_TEST
+
+/* Bulk-loaded wide folders use the compact reference representation */
+START_TEST(Service_TranslateBrowsePathsCompactFolder) {
+    UA_Server *server = server_translate_browse;
+    UA_NodeId folderId = UA_NODEID_NUMERIC(1, 8000);
+    UA_StatusCode res = UA_Server_beginBulkLoad(server);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    UA_ObjectAttributes oattr = UA_ObjectAttributes_default;
+    res = UA_Server_addObjectNode(server, folderId,
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, "CompactFolder"),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_FOLDERTYPE),
+                                  oattr, NULL, NULL);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+
+    /* Add the children in reverse order of the NodeId */
+    char name[32];
+    for(UA_UInt32 i = 100; i > 0; i--) {
+        snprintf(name, sizeof(name), "Child%u", (unsigned)i);
+        UA_VariableAttributes vattr = UA_VariableAttributes_default;
+        res = UA_Server_addVariableNode(server, UA_NODEID_NUMERIC(1, 8000 + i),
+                                        folderId, UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                        UA_QUALIFIEDNAME(1, name),
+                                        UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                        vattr, NULL, NULL);
+        ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    }
+    res = UA_Server_endBulkLoad(server);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+
+    const UA_Node *folder = UA_NODESTORE_GET(server, &folderId);
+    ck_assert(folder != NULL);
+    UA_Boolean foundCompact = false;
+    for(size_t i = 0; i < folder->head.referencesSize; i++) {
+        const UA_NodeReferenceKind *rk = &folder->head.references[i];
+        if(!rk->isInverse && rk->targetsSize == 100)
+            foundCompact = rk->isCompact;
+    }
+    UA_NODESTORE_RELEASE(server, folder);
+    ck_assert(foundCompact);
+
+    /* Resolve every child by its BrowseName */
+    UA_RelativePathElement rpe;
+    UA_RelativePathElement_init(&rpe);
+    rpe.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+    UA_BrowsePath browsePath;
+    UA_BrowsePath_init(&browsePath);
+    browsePath.startingNode = folderId;
+    browsePath.relativePath.elements = &rpe;
+    browsePath.relativePath.elementsSize = 1;
+    for(UA_UInt32 i = 1; i <= 100; i++) {
+        snprintf(name, sizeof(name), "Child%u", (unsigned)i);
+        rpe.targetName = UA_QUALIFIEDNAME(1, name);
+        UA_BrowsePathResult bpr = UA_Server_translateBrowsePathToNodeIds(server, &browsePath);
+        ck_assert_int_eq(bpr.statusCode, UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(bpr.targetsSize, 1);
+        ck_assert_uint_eq(bpr.targets[0].targetId.nodeId.identifier.numeric, 8000 + i);
+        UA_BrowsePathResult_clear(&bpr);
+    }
+
+    /* Browse with continuation points. The children come in order. */
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = folderId;
+    bd.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+    UA_UInt32 next = 8001;
+    UA_BrowseResult br = UA_Server_browse(server, 7, &bd);
+    while(true) {
+        ck_assert_int_eq(br.statusCode, UA_STATUSCODE_GOOD);
+        for(size_t i = 0; i < br.referencesSize; i++)
+            ck_assert_uint_eq(br.references[i].nodeId.nodeId.identifier.numeric, next++);
+        if(br.continuationPoint.length == 0)
+            break;
+        UA_ByteString cp = br.continuationPoint;
+        UA_ByteString_init(&br.continuationPoint);
+        UA_BrowseResult_clear(&br);
+        br = UA_Server_browseNext(server, false, &cp);
+        UA_ByteString_clear(&cp);
+    }
+    UA_BrowseResult_clear(&br);
+    ck_assert_uint_eq(next, 8101);
+
+    /* Removing a child keeps the compact representation */
+    res = UA_Server_deleteNode(server, UA_NODEID_NUMERIC(1, 8050), true);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    rpe.targetName = UA_QUALIFIEDNAME(1, "Child50");
+    UA_BrowsePathResult bpr = UA_Server_translateBrowsePathToNodeIds(server, &browsePath);
+    ck_assert_int_eq(bpr.statusCode, UA_STATUSCODE_BADNOMATCH);
+    UA_BrowsePathResult_clear(&bpr);
+    rpe.targetName = UA_QUALIFIEDNAME(1, "Child51");
+    bpr = UA_Server_translateBrowsePathToNodeIds(server, &browsePath);
+    ck_assert_int_eq(bpr.statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(bpr.targets[0].targetId.nodeId.identifier.numeric, 8051);
+    UA_BrowsePathResult_clear(&bpr);
+
+    /* Adding a child switches back to the tree */
+    UA_VariableAttributes vattr = UA_VariableAttributes_default;
+    res = UA_Server_addVariableNode(server, UA_NODEID_NUMERIC(1, 8050), folderId,
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                    UA_QUALIFIEDNAME(1, "Child50"),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                    vattr, NULL, NULL);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    folder = UA_NODESTORE_GET(server, &folderId);
+    ck_assert(folder != NULL);
+    UA_Boolean foundTree = false;
+    for(size_t i = 0; i < folder->head.referencesSize; i++) {
+        const UA_NodeReferenceKind *rk = &folder->head.references[i];
+        if(!rk->isInverse && rk->targetsSize == 100)
+            foundTree = rk->hasRefTree && !rk->isCompact;
+    }
+    UA_NODESTORE_RELEASE(server, folder);
+    ck_assert(foundTree);
+    rpe.targetName = UA_QUALIFIEDNAME(1, "Child50");
+    bpr = UA_Server_translateBrowsePathToNodeIds(server, &browsePath);
+    ck_assert_int_eq(bpr.statusCode, UA_STATUSCODE_GOOD);
+    UA_BrowsePathResult_clear(&bpr);
+}
+END_TEST
+
+/* Cached results are invalidated when the references change */
+START_TEST(Service_TranslateBrowsePathsCached) {
+    UA_QualifiedName name = UA_QUALIFIEDNAME(1, "CachedChild");
+    UA_NodeId objects = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    UA_BrowsePathResult bpr =
+        UA_Server_browseSimplifiedBrowsePath(server_translate_browse, objects, 1, &name);
+    ck_assert_int_eq(bpr.statusCode, UA_STATUSCODE_BADNOMATCH);
+    UA_BrowsePathResult_clear(&bpr);
+
+    /* Add the child. The cached BadNoMatch is no longer returned. */
+    UA_NodeId childId = UA_NODEID_NUMERIC(1, 7000);
+    UA_VariableAttributes vattr = UA_VariableAttributes_default;
+    UA_StatusCode res =
+        UA_Server_addVariableNode(server_translate_browse, childId, objects,
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES), name,
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                  vattr, NULL, NULL);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+
+    for(size_t i = 0; i < 2; i++) {
+        bpr = UA_Server_browseSimplifiedBrowsePath(server_translate_browse,
+                                                   objects, 1, &name);
+        ck_assert_int_eq(bpr.statusCode, UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(bpr.targetsSize, 1);
+        ck_assert(UA_NodeId_equal(&bpr.targets[0].targetId.nodeId, &childId));
+        UA_BrowsePathResult_clear(&bpr);
+    }
+
+    /* Remove the reference to the child */
+    UA_ExpandedNodeId childExp = UA_EXPANDEDNODEID_NUMERIC(1, 7000);
+    res = UA_Server_deleteReference(server_translate_browse, objects,
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                    true, childExp, true);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    bpr = UA_Server_browseSimplifiedBrowsePath(server_translate_browse, objects, 1, &name);
+    ck_assert_int_eq(bpr.statusCode, UA_STATUSCODE_BADNOMATCH);
+    UA_BrowsePathResult_clear(&bpr);
+}
+END_TEST
+
 START_TEST(Service_TranslateBrowsePathsNoMatches) {
     UA_BrowsePath browsePath;
     UA_BrowsePath_init(&browsePath);
@@ -493,6 +833,63 @@ START_TEST(BrowseSimplifiedBrowsePath) {
 }
 END_TEST
 
+static void
+addRegisteredTestNode(const char *id, UA_Int32 value) {
+    char *name = (char*)(uintptr_t)id;
+    UA_VariableAttributes vattr = UA_VariableAttributes_default;
+    UA_Variant_setScalar(&vattr.value, &value, &UA_TYPES[UA_TYPES_INT32]);
+    UA_StatusCode res =
+        UA_Server_addVariableNode(server_translate_browse, UA_NODEID_STRING(1, name),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, name),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                  vattr, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+}
+
+/* RegisterNodes returns the NodeIds unchanged. Lookups of string NodeIds use
+ * the hash cached in the NodeHead. */
+START_TEST(Service_RegisterNodes_Unchanged) {
+    addRegisteredTestNode("registered.tag", 23);
+
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode res = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_NodeId toRegister[2];
+    toRegister[0] = UA_NODEID_STRING(1, "registered.tag");
+    toRegister[1] = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
+    UA_RegisterNodesRequest req;
+    UA_RegisterNodesRequest_init(&req);
+    req.nodesToRegister = toRegister;
+    req.nodesToRegisterSize = 2;
+    UA_RegisterNodesResponse resp = UA_Client_Service_registerNodes(client, req);
+    ck_assert_uint_eq(resp.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(resp.registeredNodeIdsSize, 2);
+    ck_assert(UA_NodeId_equal(&resp.registeredNodeIds[0], &toRegister[0]));
+    ck_assert(UA_NodeId_equal(&resp.registeredNodeIds[1], &toRegister[1]));
+
+    UA_Variant out;
+    res = UA_Client_readValueAttribute(client, resp.registeredNodeIds[0], &out);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(*(UA_Int32*)out.data, 23);
+    UA_Variant_clear(&out);
+
+    UA_UnregisterNodesRequest ureq;
+    UA_UnregisterNodesRequest_init(&ureq);
+    ureq.nodesToUnregister = resp.registeredNodeIds;
+    ureq.nodesToUnregisterSize = resp.registeredNodeIdsSize;
+    UA_UnregisterNodesResponse uresp = UA_Client_Service_unregisterNodes(client, ureq);
+    ck_assert_uint_eq(uresp.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    UA_UnregisterNodesResponse_clear(&uresp);
+
+    UA_RegisterNodesResponse_clear(&resp);
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+}
+END_TEST
+
 static Suite *testSuite_Service_TranslateBrowsePathsToNodeIds(void) {
     Suite *s = suite_create("Service_TranslateBrowsePathsToNodeIds");
     TCase *tc_browse = tcase_create("Browse Service");
@@ -502,6 +899,8 @@ static Suite *testSuite_Service_TranslateBrowsePathsToNodeIds(void) {
     tcase_add_test(tc_browse, Service_Browse_ReferenceTypes);
     tcase_add_test(tc_browse, Service_Browse_WithMaxResults);
     tcase_add_test(tc_browse, Service_Browse_Recursive);
+    tcase_add_test(tc_browse, Service_Browse_RecursiveShortestPath);
+    tcase_add_test(tc_browse, Service_IsNodeInTree_TypeHierarchy);
     tcase_add_test(tc_browse, Service_Browse_Localization);
     suite_add_tcase(s, tc_browse);
 
@@ -509,8 +908,12 @@ static Suite *testSuite_Service_TranslateBrowsePathsToNodeIds(void) {
     tcase_add_unchecked_fixture(tc_translate, setup_server, teardown_server);
     tcase_add_test(tc_translate, ServiceTest_TranslateBrowsePathsToNodeIds);
     tcase_add_test(tc_translate, Service_TranslateBrowsePathsWithHashCollision);
+    tcase_add_test(tc_translate, Service_TranslateBrowsePathsWideFolder);
+    tcase_add_test(tc_translate, Service_TranslateBrowsePathsCompactFolder);
+    tcase_add_test(tc_translate, Service_TranslateBrowsePathsCached);
     tcase_add_test(tc_translate, Service_TranslateBrowsePathsNoMatches);
     tcase_add_test(tc_translate, BrowseSimplifiedBrowsePath);
+    tcase_add_test(tc_translate, Service_RegisterNodes_Unchanged);
 
     suite_add_tcase(s, tc_translate);
 
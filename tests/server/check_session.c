@@ -8,9 +8,11 @@
 #include <open62541/server_config_default.h>
 #include <open62541/types.h>
 
+#include "server/ua_server_internal.h"
 #include "server/ua_services.h"
 #include "client/ua_client_internal.h"
 #include "test_helpers.h"
+#include "testing_clock.h"
 
 #include <check.h>
 #include <stdlib.h>
@@ -114,6 +116,119 @@ START_TEST(Session_updateLifetime_ShallWork) {
 }
 END_TEST
 
+#define SESSIONINDEX_COUNT 1000
+
+START_TEST(Session_lookupByIndex) {
+    UA_Server *srv = UA_Server_newForUnitTest();
+    ck_assert(srv != NULL);
+    UA_Server_getConfig(srv)->maxSessions = SESSIONINDEX_COUNT;
+
+    UA_CreateSessionRequest req;
+    UA_CreateSessionRequest_init(&req);
+    UA_Session *sessions[SESSIONINDEX_COUNT];
+
+    UA_LOCK(&srv->serviceMutex);
+    for(size_t i = 0; i < SESSIONINDEX_COUNT; i++) {
+        UA_StatusCode res = UA_Server_createSession(srv, NULL, &req, &sessions[i]);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+
+    /* Every session is found by its token and id */
+    UA_UNLOCK(&srv->serviceMutex);
+    UA_ServerStatistics before = UA_Server_getStatistics(srv);
+    UA_LOCK(&srv->serviceMutex);
+    for(size_t i = 0; i < SESSIONINDEX_COUNT; i++) {
+        ck_assert_ptr_eq(getSessionByToken(srv, &sessions[i]->authenticationToken),
+                         sessions[i]);
+        ck_assert_ptr_eq(getSessionById(srv, &sessions[i]->sessionId), sessions[i]);
+    }
+    UA_UNLOCK(&srv->serviceMutex);
+    UA_ServerStatistics after = UA_Server_getStatistics(srv);
+    UA_LOCK(&srv->serviceMutex);
+    size_t lookups = after.ss.sessionLookupCount - before.ss.sessionLookupCount;
+    size_t steps = after.ss.sessionLookupSteps - before.ss.sessionLookupSteps;
+    ck_assert_uint_eq(lookups, 2 * SESSIONINDEX_COUNT);
+    /* A linear search would need SESSIONINDEX_COUNT/2 steps on average */
+    ck_assert_uint_lt(steps / lookups, 50);
+
+    /* Unknown tokens are not found */
+    UA_NodeId unknown = UA_NODEID_GUID(1, UA_Guid_random());
+    ck_assert_ptr_eq(getSessionByToken(srv, &unknown), NULL);
+    ck_assert_ptr_eq(getSessionById(srv, &unknown), NULL);
+
+    /* Remove every second session */
+    for(size_t i = 0; i < SESSIONINDEX_COUNT; i += 2) {
+        UA_StatusCode res =
+            UA_Server_removeSessionByToken(srv, &sessions[i]->authenticationToken,
+                                           UA_SHUTDOWNREASON_CLOSE);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+    for(size_t i = 0; i < SESSIONINDEX_COUNT; i++) {
+        UA_Session *expected = (i % 2 == 0) ? NULL : sessions[i];
+        ck_assert_ptr_eq(getSessionById(srv, &sessions[i]->sessionId), expected);
+    }
+    UA_UNLOCK(&srv->serviceMutex);
+
+    UA_Server_run_iterate(srv, false);
+    UA_Server_delete(srv);
+} END_TEST
+
+/* Sessions time out by their own timer. Sessions that were used in the
+ * meantime are kept. */
+START_TEST(Session_timeoutTimer) {
+    UA_Server *srv = UA_Server_newForUnitTest();
+    ck_assert(srv != NULL);
+    UA_Server_getConfig(srv)->maxSessions = 100;
+
+    UA_CreateSessionRequest req;
+    UA_CreateSessionRequest_init(&req);
+    req.requestedSessionTimeout = 1000.0;
+    UA_Session *sessions[100];
+
+    UA_LOCK(&srv->serviceMutex);
+    for(size_t i = 0; i < 100; i++) {
+        UA_StatusCode res = UA_Server_createSession(srv, NULL, &req, &sessions[i]);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+    UA_UNLOCK(&srv->serviceMutex);
+
+    /* Use every second session after 600ms */
+    UA_fakeSleep(600);
+    UA_Server_run_iterate(srv, false);
+    UA_EventLoop *el = UA_Server_getConfig(srv)->eventLoop;
+    UA_LOCK(&srv->serviceMutex);
+    for(size_t i = 0; i < 100; i += 2)
+        UA_Session_updateLifetime(sessions[i], el->dateTime_now(el),
+                                  el->dateTime_nowMonotonic(el));
+    ck_assert_uint_eq(srv->sessionCount, 100);
+    UA_UNLOCK(&srv->serviceMutex);
+
+    /* The unused sessions time out */
+    UA_fakeSleep(500);
+    UA_Server_run_iterate(srv, false);
+    UA_LOCK(&srv->serviceMutex);
+    ck_assert_uint_eq(srv->sessionCount, 50);
+    for(size_t i = 0; i < 100; i += 2)
+        ck_assert_ptr_eq(getSessionById(srv, &sessions[i]->sessionId), sessions[i]);
+    UA_UNLOCK(&srv->serviceMutex);
+
+    /* The re-armed timers fire for the remaining sessions */
+    UA_fakeSleep(500);
+    UA_Server_run_iterate(srv, false);
+    UA_LOCK(&srv->serviceMutex);
+    ck_assert_uint_eq(srv->sessionCount, 50);
+    UA_UNLOCK(&srv->serviceMutex);
+    UA_fakeSleep(200);
+    UA_Server_run_iterate(srv, false);
+    UA_LOCK(&srv->serviceMutex);
+    ck_assert_uint_eq(srv->sessionCount, 0);
+    ck_assert_uint_eq(srv->serverDiagnosticsSummary.sessionTimeoutCount, 100);
+    UA_UNLOCK(&srv->serviceMutex);
+
+    UA_Server_run_iterate(srv, false);
+    UA_Server_delete(srv);
+} END_TEST
+
 static Suite* testSuite_Session(void) {
     Suite *s = suite_create("Session");
     TCase *tc_session = tcase_create("Core");
@@ -122,6 +237,10 @@ static Suite* testSuite_Session(void) {
     tcase_add_test(tc_session, Session_init_ShallWork);
     tcase_add_test(tc_session, Session_updateLifetime_ShallWork);
     suite_add_tcase(s,tc_session);
+    TCase *tc_index = tcase_create("Index");
+    tcase_add_test(tc_index, Session_lookupByIndex);
+    tcase_add_test(tc_index, Session_timeoutTimer);
+    suite_add_tcase(s,tc_index);
     return s;
 }
 
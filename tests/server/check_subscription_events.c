@@ -390,6 +390,118 @@ START_TEST(generateEvents) {
     UA_DeleteMonitoredItemsResponse_clear(&deleteResponse);
 } END_TEST
 
+/* Events triggered from flat fields are filtered like the node events */
+START_TEST(generateEventsFromFields) {
+    UA_MonitoredItemCreateResult createResult = addMonitoredItem(handler_events_simple, true, true);
+    ck_assert_uint_eq(createResult.statusCode, UA_STATUSCODE_GOOD);
+    monitoredItemId = createResult.monitoredItemId;
+
+    UA_UInt16 eventSeverity = 1000;
+    UA_LocalizedText message = UA_LOCALIZEDTEXT("en-US", "Generated Event");
+    UA_KeyValuePair fieldPairs[2];
+    fieldPairs[0].key = UA_QUALIFIEDNAME(0, "Severity");
+    UA_Variant_setScalar(&fieldPairs[0].value, &eventSeverity, &UA_TYPES[UA_TYPES_UINT16]);
+    fieldPairs[1].key = UA_QUALIFIEDNAME(0, "Message");
+    UA_Variant_setScalar(&fieldPairs[1].value, &message, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+    UA_KeyValueMap fields = {2, fieldPairs};
+
+    /* Only EventTypes are accepted */
+    serverMutexLock();
+    UA_StatusCode retval =
+        UA_Server_triggerEventFields(server, UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER),
+                                     UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER),
+                                     &fields, NULL);
+    serverMutexUnlock();
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADINVALIDARGUMENT);
+
+    UA_ByteString eventId = UA_BYTESTRING_NULL;
+    serverMutexLock();
+    retval = UA_Server_triggerEventFields(server, eventType,
+                                          UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER),
+                                          &fields, &eventId);
+    serverMutexUnlock();
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(eventId.length, 16);
+    UA_ByteString_clear(&eventId);
+
+    notificationReceived = false;
+    sleepUntilAnswer(publishingInterval + 100);
+    retval = UA_Client_run_iterate(client, 0);
+    sleepUntilAnswer(publishingInterval + 100);
+    retval |= UA_Client_run_iterate(client, 0);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(notificationReceived, true);
+
+    UA_DeleteMonitoredItemsRequest deleteRequest;
+    UA_DeleteMonitoredItemsRequest_init(&deleteRequest);
+    deleteRequest.subscriptionId = subscriptionId;
+    deleteRequest.monitoredItemIds = &monitoredItemId;
+    deleteRequest.monitoredItemIdsSize = 1;
+    UA_DeleteMonitoredItemsResponse deleteResponse =
+        UA_Client_MonitoredItems_delete(client, deleteRequest);
+    sleepUntilAnswer(publishingInterval + 100);
+    ck_assert_uint_eq(deleteResponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    UA_DeleteMonitoredItemsResponse_clear(&deleteResponse);
+} END_TEST
+
+static UA_StatusCode
+triggerFieldsEventLocked(void) {
+    UA_UInt16 eventSeverity = 1000;
+    UA_LocalizedText message = UA_LOCALIZEDTEXT("en-US", "Generated Event");
+    UA_KeyValuePair fieldPairs[2];
+    fieldPairs[0].key = UA_QUALIFIEDNAME(0, "Severity");
+    UA_Variant_setScalar(&fieldPairs[0].value, &eventSeverity, &UA_TYPES[UA_TYPES_UINT16]);
+    fieldPairs[1].key = UA_QUALIFIEDNAME(0, "Message");
+    UA_Variant_setScalar(&fieldPairs[1].value, &message, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+    UA_KeyValueMap fields = {2, fieldPairs};
+    serverMutexLock();
+    UA_StatusCode retval =
+        UA_Server_triggerEventFields(server, eventType,
+                                     UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER),
+                                     &fields, NULL);
+    serverMutexUnlock();
+    return retval;
+}
+
+/* The cached event route of the origin follows the MonitoredItems */
+START_TEST(eventRouteFollowsMonitoredItems) {
+    /* Cache the route without a listening MonitoredItem */
+    UA_StatusCode retval = triggerFieldsEventLocked();
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_MonitoredItemCreateResult createResult = addMonitoredItem(handler_events_simple, true, true);
+    ck_assert_uint_eq(createResult.statusCode, UA_STATUSCODE_GOOD);
+    monitoredItemId = createResult.monitoredItemId;
+
+    retval = triggerFieldsEventLocked();
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    notificationReceived = false;
+    sleepUntilAnswer(publishingInterval + 100);
+    retval = UA_Client_run_iterate(client, 0);
+    sleepUntilAnswer(publishingInterval + 100);
+    retval |= UA_Client_run_iterate(client, 0);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(notificationReceived, true);
+
+    UA_DeleteMonitoredItemsRequest deleteRequest;
+    UA_DeleteMonitoredItemsRequest_init(&deleteRequest);
+    deleteRequest.subscriptionId = subscriptionId;
+    deleteRequest.monitoredItemIds = &monitoredItemId;
+    deleteRequest.monitoredItemIdsSize = 1;
+    UA_DeleteMonitoredItemsResponse deleteResponse =
+        UA_Client_MonitoredItems_delete(client, deleteRequest);
+    ck_assert_uint_eq(deleteResponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    UA_DeleteMonitoredItemsResponse_clear(&deleteResponse);
+
+    /* The deleted MonitoredItem is no longer part of the route */
+    retval = triggerFieldsEventLocked();
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    notificationReceived = false;
+    sleepUntilAnswer(publishingInterval + 100);
+    UA_Client_run_iterate(client, 0);
+    ck_assert_uint_eq(notificationReceived, false);
+} END_TEST
+
 static bool hasBaseModelChangeEventType(void) {
 
     UA_QualifiedName readBrowsename;
@@ -399,6 +511,74 @@ static bool hasBaseModelChangeEventType(void) {
     return !(retval == UA_STATUSCODE_BADNODEIDUNKNOWN);
 }
 
+/* The positions of the select clauses in the flat fields are kept between the
+ * events. A different field layout is still resolved correctly. */
+START_TEST(eventFieldsProjection) {
+    UA_SimpleAttributeOperand sc[3];
+    UA_QualifiedName paths[3] = {UA_QUALIFIEDNAME(0, "Message"),
+                                 UA_QUALIFIEDNAME(0, "Severity"),
+                                 UA_QUALIFIEDNAME(0, "Missing")};
+    for(size_t i = 0; i < 3; i++) {
+        UA_SimpleAttributeOperand_init(&sc[i]);
+        sc[i].typeDefinitionId = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEEVENTTYPE);
+        sc[i].browsePathSize = 1;
+        sc[i].browsePath = &paths[i];
+        sc[i].attributeId = UA_ATTRIBUTEID_VALUE;
+    }
+    UA_EventFilter filter;
+    UA_EventFilter_init(&filter);
+    filter.selectClauses = sc;
+    filter.selectClausesSize = 3;
+
+    UA_UInt16 severity = 500;
+    UA_LocalizedText message = UA_LOCALIZEDTEXT("en-US", "Projected");
+    UA_KeyValuePair pairs[3];
+    pairs[0].key = UA_QUALIFIEDNAME(0, "EventType");
+    UA_Variant_setScalar(&pairs[0].value, &eventType, &UA_TYPES[UA_TYPES_NODEID]);
+    pairs[1].key = UA_QUALIFIEDNAME(0, "Severity");
+    UA_Variant_setScalar(&pairs[1].value, &severity, &UA_TYPES[UA_TYPES_UINT16]);
+    pairs[2].key = UA_QUALIFIEDNAME(0, "Message");
+    UA_Variant_setScalar(&pairs[2].value, &message, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+    UA_KeyValueMap fields = {3, pairs};
+
+    UA_EventFilterCache cache;
+    memset(&cache, 0, sizeof(UA_EventFilterCache));
+    UA_EventFieldList efl;
+    for(size_t round = 0; round < 3; round++) {
+        if(round == 2) {
+            /* Swap the layout */
+            UA_KeyValuePair tmp = pairs[1];
+            pairs[1] = pairs[2];
+            pairs[2] = tmp;
+        }
+        serverMutexLock();
+        UA_LOCK(&server->serviceMutex);
+        UA_StatusCode retval =
+            filterEventFields(server, &server->adminSession, &fields,
+                              &filter, &cache, &efl);
+        UA_UNLOCK(&server->serviceMutex);
+        serverMutexUnlock();
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(efl.eventFieldsSize, 3);
+        ck_assert(UA_Variant_hasScalarType(&efl.eventFields[0],
+                                           &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]));
+        ck_assert(UA_LocalizedText_equal((UA_LocalizedText*)efl.eventFields[0].data,
+                                         &message));
+        ck_assert(UA_Variant_hasScalarType(&efl.eventFields[1],
+                                           &UA_TYPES[UA_TYPES_UINT16]));
+        ck_assert_uint_eq(*(UA_UInt16*)efl.eventFields[1].data, severity);
+        ck_assert(UA_Variant_isEmpty(&efl.eventFields[2]));
+        UA_EventFieldList_clear(&efl);
+
+        /* The projection table points to the current layout */
+        ck_assert_uint_eq(cache.fieldIndexSize, 3);
+        ck_assert_uint_eq(cache.fieldIndex[0], (round < 2) ? 2 : 1);
+        ck_assert_uint_eq(cache.fieldIndex[1], (round < 2) ? 1 : 2);
+        ck_assert_uint_eq(cache.fieldIndex[2], UA_UINT16_MAX);
+    }
+    UA_EventFilterCache_clear(&cache);
+} END_TEST
+
 START_TEST(createAbstractEvent) {
     if (!hasBaseModelChangeEventType())
         return;
@@ -919,6 +1099,9 @@ static Suite *testSuite_Client(void) {
     tcase_add_unchecked_fixture(tc_server, setup, teardown);
     tcase_add_test(tc_server, generateEventEmptyFilter);
     tcase_add_test(tc_server, generateEvents);
+    tcase_add_test(tc_server, generateEventsFromFields);
+    tcase_add_test(tc_server, eventRouteFollowsMonitoredItems);
+    tcase_add_test(tc_server, eventFieldsProjection);
     tcase_add_test(tc_server, createAbstractEvent);
     tcase_add_test(tc_server, createAbstractEventWithParent);
     tcase_add_test(tc_server, createNonAbstractEventWithParent);
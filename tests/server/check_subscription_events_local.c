@@ -117,11 +117,127 @@ START_TEST(generateEvents) {
     ck_assert_uint_eq(callbackCount, 3);
 } END_TEST
 
+static unsigned filteredCount = 0;
+
+static void
+filteredEventCallback(UA_Server *server, UA_UInt32 monitoredItemId,
+                      void *monitoredItemContext, const UA_KeyValueMap eventFields) {
+    filteredCount++;
+}
+
+static void
+setSeverity(const UA_NodeId eventNodeId, UA_UInt16 severity) {
+    UA_QualifiedName severityName = UA_QUALIFIEDNAME(0, "Severity");
+    UA_BrowsePathResult bpr =
+        UA_Server_browseSimplifiedBrowsePath(server, eventNodeId, 1, &severityName);
+    ck_assert_uint_eq(bpr.statusCode, UA_STATUSCODE_GOOD);
+    UA_Variant value;
+    UA_Variant_setScalar(&value, &severity, &UA_TYPES[UA_TYPES_UINT16]);
+    UA_Server_writeValue(server, bpr.targets[0].targetId.nodeId, value);
+    UA_BrowsePathResult_clear(&bpr);
+}
+
+/* The where-clause is evaluated repeatedly for the same MonitoredItem. The
+ * literal needs an implicit cast and the OfType result depends on the
+ * EventType. Both are cached between the events. */
+START_TEST(filterWhereClauseRepeated) {
+    UA_NodeId otherEventType;
+    UA_ObjectTypeAttributes attr = UA_ObjectTypeAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", "OtherEventType");
+    UA_Server_addObjectTypeNode(server, UA_NODEID_NULL,
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_BASEEVENTTYPE),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+                                UA_QUALIFIEDNAME(0, "OtherEventType"),
+                                attr, NULL, &otherEventType);
+
+    UA_EventFilter ef;
+    UA_EventFilter_init(&ef);
+    ef.selectClauses = UA_SimpleAttributeOperand_new();
+    ef.selectClausesSize = 1;
+    UA_SimpleAttributeOperand_parse(&ef.selectClauses[0], UA_STRING("/Severity"));
+
+    /* AND(OfType(eventType), Severity > (Byte)200) */
+    ef.whereClause.elements = (UA_ContentFilterElement*)
+        UA_Array_new(3, &UA_TYPES[UA_TYPES_CONTENTFILTERELEMENT]);
+    ef.whereClause.elementsSize = 3;
+    UA_ContentFilterElement *elm = ef.whereClause.elements;
+
+    elm[0].filterOperator = UA_FILTEROPERATOR_AND;
+    elm[0].filterOperands = (UA_ExtensionObject*)
+        UA_Array_new(2, &UA_TYPES[UA_TYPES_EXTENSIONOBJECT]);
+    elm[0].filterOperandsSize = 2;
+    for(UA_UInt32 i = 0; i < 2; i++) {
+        UA_ElementOperand *eo = UA_ElementOperand_new();
+        eo->index = i + 1;
+        UA_ExtensionObject_setValue(&elm[0].filterOperands[i], eo,
+                                    &UA_TYPES[UA_TYPES_ELEMENTOPERAND]);
+    }
+
+    elm[1].filterOperator = UA_FILTEROPERATOR_OFTYPE;
+    elm[1].filterOperands = UA_ExtensionObject_new();
+    elm[1].filterOperandsSize = 1;
+    UA_LiteralOperand *typeOp = UA_LiteralOperand_new();
+    UA_Variant_setScalarCopy(&typeOp->value, &eventType, &UA_TYPES[UA_TYPES_NODEID]);
+    UA_ExtensionObject_setValue(&elm[1].filterOperands[0], typeOp,
+                                &UA_TYPES[UA_TYPES_LITERALOPERAND]);
+
+    elm[2].filterOperator = UA_FILTEROPERATOR_GREATERTHAN;
+    elm[2].filterOperands = (UA_ExtensionObject*)
+        UA_Array_new(2, &UA_TYPES[UA_TYPES_EXTENSIONOBJECT]);
+    elm[2].filterOperandsSize = 2;
+    UA_SimpleAttributeOperand *sao = UA_SimpleAttributeOperand_new();
+    UA_SimpleAttributeOperand_parse(sao, UA_STRING("/Severity"));
+    UA_ExtensionObject_setValue(&elm[2].filterOperands[0], sao,
+                                &UA_TYPES[UA_TYPES_SIMPLEATTRIBUTEOPERAND]);
+    UA_LiteralOperand *lo = UA_LiteralOperand_new();
+    UA_Byte threshold = 200;
+    UA_Variant_setScalarCopy(&lo->value, &threshold, &UA_TYPES[UA_TYPES_BYTE]);
+    UA_ExtensionObject_setValue(&elm[2].filterOperands[1], lo,
+                                &UA_TYPES[UA_TYPES_LITERALOPERAND]);
+
+    UA_MonitoredItemCreateResult res =
+        UA_Server_createEventMonitoredItem(server, UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER),
+                                           ef, NULL, filteredEventCallback);
+    ck_assert_uint_eq(res.statusCode, UA_STATUSCODE_GOOD);
+    UA_EventFilter_clear(&ef);
+
+    UA_NodeId eventNodeId;
+    eventSetup(&eventNodeId);
+    UA_NodeId otherEventNodeId;
+    UA_Server_createEvent(server, otherEventType, &otherEventNodeId);
+    setSeverity(otherEventNodeId, 1000);
+
+    const UA_NodeId serverId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
+    UA_Server_triggerEvent(server, eventNodeId, serverId, NULL, false);
+    UA_Server_triggerEvent(server, eventNodeId, serverId, NULL, false);
+    UA_Server_run_iterate(server, false);
+    ck_assert_uint_eq(filteredCount, 2);
+
+    /* Different EventType */
+    UA_Server_triggerEvent(server, otherEventNodeId, serverId, NULL, false);
+    UA_Server_run_iterate(server, false);
+    ck_assert_uint_eq(filteredCount, 2);
+
+    /* Back to the original EventType, below the threshold */
+    setSeverity(eventNodeId, 100);
+    UA_Server_triggerEvent(server, eventNodeId, serverId, NULL, false);
+    UA_Server_run_iterate(server, false);
+    ck_assert_uint_eq(filteredCount, 2);
+
+    setSeverity(eventNodeId, 300);
+    UA_Server_triggerEvent(server, eventNodeId, serverId, NULL, false);
+    UA_Server_run_iterate(server, false);
+    ck_assert_uint_eq(filteredCount, 3);
+
+    UA_Server_deleteMonitoredItem(server, res.monitoredItemId);
+} END_TEST
+
 static Suite *testSuite_event(void) {
     Suite *s = suite_create("Server Local Subscription Events");
     TCase *tc_server = tcase_create("Server Local Subscription Events");
     tcase_add_unchecked_fixture(tc_server, setup, teardown);
     tcase_add_test(tc_server, generateEvents);
+    tcase_add_test(tc_server, filterWhereClauseRepeated);
     suite_add_tcase(s, tc_server);
     return s;
 }
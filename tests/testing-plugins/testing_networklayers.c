@@ -45,12 +45,12 @@ testFreeNetworkBuffer(UA_ConnectionManager *cm, uintptr_t connectionId,
     UA_ByteString_clear(buf);
 }
 
+/* The optional members (sendWithConnectionV, ...) are left NULL */
 UA_ConnectionManager testConnectionManagerTCP = {
-    {0}, /* eventSource */
-    UA_STRING_STATIC("tcp"),
-    testOpenConnection,
-    testSendWithConnection,
-    testCloseConnection,
-    testAllocNetworkBuffer,
-    testFreeNetworkBuffer
+    .protocol = UA_STRING_STATIC("tcp"),
+    .openConnection = testOpenConnection,
+    .sendWithConnection = testSendWithConnection,
+    .closeConnection = testCloseConnection,
+    .allocNetworkBuffer = testAllocNetworkBuffer,
+    .freeNetworkBuffer = testFreeNetworkBuffer
 };
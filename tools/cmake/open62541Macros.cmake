@@ -273,6 +273,7 @@ endfunction()
 #
 #   [INTERNAL]      Optional argument. If given, then the generated node set code will use internal headers.
 #   [AUTOLOAD]      Optional argument. If given, the nodeset is automatically attached to the server.
+#   [TABLE]         Optional argument. If given, the nodes are generated as static tables for UA_Server_addNodeTable.
 #
 #   Arguments taking one value:
 #
@@ -297,7 +298,7 @@ endfunction()
 function(ua_generate_nodeset)
     find_package(Python3 REQUIRED)
 
-    set(options INTERNAL AUTOLOAD)
+    set(options INTERNAL AUTOLOAD TABLE)
     set(oneValueArgs NAME TYPES_ARRAY OUTPUT_DIR IGNORE TARGET_PREFIX BLACKLIST FILES_BSD)
     set(multiValueArgs FILE DEPENDS_TYPES DEPENDS_NS DEPENDS_TARGET)
     cmake_parse_arguments(UA_GEN_NS "${options}" "${oneValueArgs}" "${multiValueArgs}" ${ARGN} )
@@ -351,6 +352,11 @@ function(ua_generate_nodeset)
         set(GEN_INTERNAL_HEADERS "--internal-headers")
     endif()
 
+    set(GEN_BACKEND "")
+    if (UA_GEN_NS_TABLE)
+        set(GEN_BACKEND "--backend=open62541_table")
+    endif()
+
     set(GEN_NS0 "")
     set(TARGET_SUFFIX "ns-${UA_GEN_NS_NAME}")
     set(FILE_SUFFIX "_${UA_GEN_NS_NAME}_generated")
@@ -398,6 +404,7 @@ function(ua_generate_nodeset)
                        PRE_BUILD
                        COMMAND ${Python3_EXECUTABLE} ${open62541_TOOLS_DIR}/nodeset_compiler/nodeset_compiler.py
                        ${GEN_INTERNAL_HEADERS}
+                       ${GEN_BACKEND}
                        ${GEN_NS0}
                        ${GEN_BIN_SIZE}
                        ${GEN_IGNORE}
@@ -415,6 +422,7 @@ function(ua_generate_nodeset)
                        ${open62541_TOOLS_DIR}/nodeset_compiler/backend_open62541.py
                        ${open62541_TOOLS_DIR}/nodeset_compiler/backend_open62541_nodes.py
                        ${open62541_TOOLS_DIR}/nodeset_compiler/backend_open62541_datatypes.py
+                       ${open62541_TOOLS_DIR}/nodeset_compiler/backend_open62541_table.py
                        ${UA_GEN_NS_FILE}
                        ${UA_GEN_NS_DEPENDS_NS}
                        ${GEN_BLACKLIST_DEPENDS}
@@ -25,6 +25,7 @@ from datatypes import NodeId
 from nodes import *
 from nodeset import *
 from backend_open62541_nodes import generateNodeCode_begin, generateNodeCode_finish, generateReferenceCode
+from backend_open62541_table import NodeTable, peekTypeDef
 
 # Kahn's algorithm: https://algocoding.wordpress.com/2015/04/05/topological-sorting-python/
 def sortNodes(nodeset):
@@ -115,7 +116,23 @@ def sortNodes(nodeset):
 # Generate C Code #
 ###################
 
-def generateOpen62541Code(nodeset, outfilename, internal_headers=False, typesArray=[]):
+def printedReferences(node, nodeset, printed_ids):
+    # References to the nodes printed so far. The references to the later
+    # nodes are added as their inverse.
+    refs = []
+    for ref in node.references:
+        if ref.target not in printed_ids:
+            continue
+        if node.hidden and nodeset.nodes[ref.target].hidden:
+            continue
+        if node.parent is not None and ref.target == node.parent.id \
+            and ref.referenceType == node.parentReference.id:
+            # Skip parent reference
+            continue
+        refs.append(ref)
+    return refs
+
+def generateOpen62541Code(nodeset, outfilename, internal_headers=False, typesArray=[], tables=False):
     outfilebase = basename(outfilename)
     # Printing functions
     outfileh = codecs.open(outfilename + ".h", r"w+", encoding='utf-8')
@@ -172,9 +189,19 @@ _UA_END_DECLS
 
     printed_ids = set()
     reftypes_functionNumbers = list()
+    table = NodeTable(outfilebase) if tables else None
     for node in sorted_nodes:
         printed_ids.add(node.id)
 
+        # Describe the node in the static table if possible
+        if table is not None and not node.hidden:
+            typeDef = peekTypeDef(node)
+            refs = [r for r in printedReferences(node, nodeset, printed_ids) if r is not typeDef]
+            if table.canTable(node, nodeset, refs):
+                table.addRow(node, nodeset, refs)
+                continue
+            table.addFunctionRow(node, "function_" + outfilebase + "_" + str(functionNumber))
+
         if not node.hidden:
             writec("\n/* " + str(node.displayName) + " - " + str(node.id) + " */")
             code_global = []
@@ -193,15 +220,7 @@ _UA_END_DECLS
                 writec(code)
 
         # Print inverse references leading to this node
-        for ref in node.references:
-            if ref.target not in printed_ids:
-                continue
-            if node.hidden and nodeset.nodes[ref.target].hidden:
-                continue
-            if node.parent is not None and ref.target == node.parent.id \
-                and ref.referenceType == node.parentReference.id:
-                # Skip parent reference
-                continue
+        for ref in printedReferences(node, nodeset, printed_ids):
             writec(generateReferenceCode(ref))
 
         if node.hidden:
@@ -235,6 +254,9 @@ _UA_END_DECLS
         functionNumber = functionNumber + 1
 
 
+    if table is not None:
+        table.write(writec)
+
     # Load generated types
     for arr in typesArray:
         if arr == "UA_TYPES":
@@ -281,7 +303,10 @@ UA_StatusCode retVal = UA_STATUSCODE_GOOD;""" % (outfilebase))
         writec("UA_Server_getConfig(server)->customDataTypes = &custom" + arr + ";\n")
         writec("}")
 
-    if functionNumber > 0:
+    if table is not None:
+        if len(table.rows) > 0:
+            writec("retVal |= UA_Server_addNodeTable(server, &table_%s, ns);" % outfilebase)
+    elif functionNumber > 0:
         for i in range(0, functionNumber):
             writec("retVal |= function_{outfilebase}_{idx}_begin(server, ns);". \
                    format(outfilebase=outfilebase, idx=str(i)))
@@ -0,0 +1,208 @@
+#!/usr/bin/env python3
+
+### This Source Code Form is subject to the terms of the Mozilla Public
+### License, v. 2.0. If a copy of the MPL was not distributed with this
+### file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+# Generates the static node table for UA_Server_addNodeTable. The nodes that
+# cannot be described by the table columns fall back to the generated
+# _begin/_finish functions of the open62541 backend.
+
+from datatypes import NodeId
+from nodes import ReferenceTypeNode, ObjectNode, VariableNode, VariableTypeNode, MethodNode, ObjectTypeNode, DataTypeNode, ViewNode
+from backend_open62541_datatypes import makeCIdentifier, makeCLiteral, splitStringLiterals
+from backend_open62541_nodes import setNodeDatatypeRecursive, setNodeValueRankRecursive
+
+hasTypeDefinition = NodeId("ns=0;i=40")
+
+def isNumericNodeId(nodeId):
+    return nodeId is None or not nodeId or nodeId.i is not None
+
+def peekTypeDef(node):
+    # Like node.popTypeDef() without removing the reference
+    for ref in node.references:
+        if ref.referenceType == hasTypeDefinition and ref.isForward:
+            return ref
+    return None
+
+class StringPool(object):
+    def __init__(self):
+        self.index = {'""': 0}
+        self.literals = ['""']
+
+    def add(self, value):
+        if value is None or value == "":
+            return 0
+        lit = splitStringLiterals(makeCLiteral(value))
+        if lit not in self.index:
+            self.index[lit] = len(self.literals)
+            self.literals.append(lit)
+        return self.index[lit]
+
+class NodeTable(object):
+    def __init__(self, name):
+        self.name = name
+        self.rows = []
+        self.references = []
+        self.strings = StringPool()
+        self.descriptions = StringPool()
+        self.dims = []
+
+    def nodeIdCode(self, nodeId):
+        if not nodeId:
+            return "{0, 0}"
+        return "{%d, %du}" % (nodeId.ns, nodeId.i)
+
+    def addDims(self, dims):
+        # Reuse an existing sequence of the same dimensions
+        for i in range(0, len(self.dims) - len(dims) + 1):
+            if self.dims[i:i+len(dims)] == dims:
+                return i
+        self.dims.extend(dims)
+        return len(self.dims) - len(dims)
+
+    def canTable(self, node, nodeset, refs):
+        """Nodes with numeric NodeIds and without a value, method or localized
+        description are described by the table columns."""
+        if isinstance(node, MethodNode) or isinstance(node.parent, MethodNode):
+            return False
+        if not isNumericNodeId(node.id):
+            return False
+        if node.parent is not None and (not isNumericNodeId(node.parent.id) or
+                                        not isNumericNodeId(node.parentReference.id)):
+            return False
+        if isinstance(node, VariableNode) or isinstance(node, ObjectNode):
+            typeDef = peekTypeDef(node)
+            if typeDef is not None and not isNumericNodeId(typeDef.target):
+                return False
+        if isinstance(node, VariableNode) or isinstance(node, VariableTypeNode):
+            if node.value is not None:
+                return False
+            if node.dataType is not None and not isNumericNodeId(node.dataType):
+                return False
+        if node.description is not None and node.description.locale:
+            return False
+        for ref in refs:
+            if not isNumericNodeId(ref.referenceType) or not isNumericNodeId(ref.target):
+                return False
+        return True
+
+    def addFunctionRow(self, node, functionName):
+        self.rows.append("{%s_begin, %s_finish, {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}, "
+                         "0, 0, 0, 0, 0, 0, 0, 0, 0.0, 0, 0, 0, 0, %s, 0, 0, 0, 0}" %
+                         (functionName, functionName, nodeClassCode(node)))
+
+    def addRow(self, node, nodeset, refs):
+        flags = []
+        eventNotifier = 0
+        accessLevel = 0
+        userAccessLevel = 0
+        minimumSamplingInterval = 0.0
+        valueRank = 0
+        dims = 0
+        dataType = None
+        inverseName = 0
+        typeDef = NodeId()
+
+        if isinstance(node, VariableNode) or isinstance(node, VariableTypeNode):
+            if node.valueRank is None:
+                setNodeValueRankRecursive(node, nodeset)
+            if node.dataType is None:
+                setNodeDatatypeRecursive(node, nodeset)
+            if nodeset.getBaseDataType(nodeset.getDataTypeNode(node.dataType)) is None:
+                raise RuntimeError("Cannot get BaseDataType for dataType : " + str(node.dataType) +
+                                   " of node " + node.browseName.name + " " + str(node.id))
+            dataType = node.dataType
+            valueRank = node.valueRank
+            if valueRank > 0:
+                if len(node.arrayDimensions) == valueRank:
+                    dims = self.addDims([int(str(v)) for v in node.arrayDimensions])
+                else:
+                    dims = self.addDims([0] * valueRank)
+
+        if isinstance(node, VariableNode) or isinstance(node, ObjectNode):
+            typeDef = node.popTypeDef().target
+
+        if isinstance(node, ReferenceTypeNode):
+            if node.isAbstract:
+                flags.append("UA_NODETABLE_ISABSTRACT")
+            if node.symmetric:
+                flags.append("UA_NODETABLE_SYMMETRIC")
+            inverseName = self.strings.add(node.inverseName)
+        elif isinstance(node, ObjectNode):
+            eventNotifier = node.eventNotifier & 13 if node.eventNotifier else 0
+        elif isinstance(node, VariableTypeNode):
+            if node.isAbstract:
+                flags.append("UA_NODETABLE_ISABSTRACT")
+        elif isinstance(node, VariableNode):
+            if node.historizing:
+                flags.append("UA_NODETABLE_HISTORIZING")
+            minimumSamplingInterval = node.minimumSamplingInterval
+            accessLevel = node.accessLevel
+            userAccessLevel = node.userAccessLevel
+        elif isinstance(node, ObjectTypeNode) or isinstance(node, DataTypeNode):
+            if node.isAbstract:
+                flags.append("UA_NODETABLE_ISABSTRACT")
+        elif isinstance(node, ViewNode):
+            if node.containsNoLoops:
+                flags.append("UA_NODETABLE_CONTAINSNOLOOPS")
+            eventNotifier = int(node.eventNotifier)
+
+        displayNameLocale = 0
+        displayName = 0
+        if node.displayName is not None:
+            displayNameLocale = self.strings.add(node.displayName.locale)
+            displayName = self.strings.add(node.displayName.text)
+        description = 0
+        if node.description is not None:
+            description = self.descriptions.add(node.description.text)
+
+        refsOffset = len(self.references)
+        for ref in refs:
+            self.references.append("{%s, %s, %s}" % (self.nodeIdCode(ref.referenceType),
+                                                     self.nodeIdCode(ref.target),
+                                                     "true" if ref.isForward else "false"))
+
+        parentId = node.parent.id if node.parent else NodeId()
+        parentRef = node.parentReference.id if node.parent else NodeId()
+        self.rows.append("{NULL, NULL, %s, %s, %s, %s, %s, %d, %d, %d, %d, %d, %d, %d, %d, "
+                         "%f, %d, %d, %d, %d, %s, %s, %d, %d, %d}" %
+                         (self.nodeIdCode(node.id), self.nodeIdCode(parentId),
+                          self.nodeIdCode(parentRef), self.nodeIdCode(typeDef),
+                          self.nodeIdCode(dataType), node.browseName.ns,
+                          self.strings.add(node.browseName.name), displayNameLocale,
+                          displayName, description, inverseName, node.writeMask or 0,
+                          node.userWriteMask or 0, minimumSamplingInterval, valueRank,
+                          dims, refsOffset, len(refs), nodeClassCode(node),
+                          " | ".join(flags) if flags else "0", eventNotifier,
+                          accessLevel, userAccessLevel))
+
+    def write(self, writec):
+        name = self.name
+        if len(self.references) == 0:
+            self.references.append("{{0, 0}, {0, 0}, false}")
+        if len(self.dims) == 0:
+            self.dims.append(0)
+        writec("\nstatic const char * const strings_%s[] = {" % name)
+        writec(",\n".join(self.strings.literals) + "};")
+        writec("\n#ifdef UA_ENABLE_NODESET_COMPILER_DESCRIPTIONS")
+        writec("static const char * const descriptions_%s[] = {" % name)
+        writec(",\n".join(self.descriptions.literals) + "};")
+        writec("#endif")
+        writec("\nstatic const UA_UInt32 arrayDimensions_%s[] = {" % name)
+        writec(", ".join([str(d) for d in self.dims]) + "};")
+        writec("\nstatic const UA_NodeTableReference references_%s[] = {" % name)
+        writec(",\n".join(self.references) + "};")
+        writec("\nstatic const UA_NodeTableEntry nodes_%s[] = {" % name)
+        writec(",\n".join(self.rows) + "};")
+        writec("\nstatic const UA_NodeTable table_%s = {" % name)
+        writec("nodes_%s, %d, references_%s, strings_%s," % (name, len(self.rows), name, name))
+        writec("#ifdef UA_ENABLE_NODESET_COMPILER_DESCRIPTIONS")
+        writec("descriptions_%s," % name)
+        writec("#else")
+        writec("NULL,")
+        writec("#endif")
+        writec("arrayDimensions_%s};" % name)
+
+def nodeClassCode(node):
+    return "UA_NODECLASS_" + makeCIdentifier(node.__class__.__name__.upper().replace("NODE", ""))
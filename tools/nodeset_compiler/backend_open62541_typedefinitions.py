@@ -29,6 +29,17 @@ builtin_overlayable = {"SByte": "true",
                                "offsetof(UA_Guid, data3) == (sizeof(UA_UInt16) + sizeof(UA_UInt32)) && " +
                                "offsetof(UA_Guid, data4) == (2*sizeof(UA_UInt32)))"}
 
+# Encoded size in bytes of the builtin types with a fixed binary size. Also
+# used for the fixed size of structures that contain only such members.
+builtin_binarysize = {"Boolean": 1, "SByte": 1, "Byte": 1,
+                      "Int16": 2, "UInt16": 2, "Int32": 4, "UInt32": 4,
+                      "Int64": 8, "UInt64": 8, "Float": 4, "Double": 8,
+                      "DateTime": 8, "StatusCode": 4, "Guid": 16}
+
+enum_binarysize = {"UA_TYPES_BYTE": 1, "UA_TYPES_UINT16": 2,
+                   "UA_TYPES_INT32": 4, "UA_TYPES_UINT32": 4,
+                   "UA_TYPES_UINT64": 8}
+
 whitelistFuncAttrWarnUnusedResult = []  # for instances [ "String", "ByteString", "LocalizedText" ]
 
 
@@ -124,6 +135,32 @@ class CGenerator:
             return self.get_struct_overlayable(datatype)
         raise RuntimeError("Unknown datatype")
 
+    @staticmethod
+    def get_type_binarysize(datatype):
+        # Returns zero if the encoded size depends on the value
+        if isinstance(datatype, BuiltinType):
+            return builtin_binarysize.get(datatype.name, 0)
+        if isinstance(datatype, OpaqueType):
+            return builtin_binarysize.get(datatype.base_type, 0)
+        if isinstance(datatype, EnumerationType):
+            return enum_binarysize.get(datatype.strTypeIndex, 0)
+        if isinstance(datatype, StructType):
+            if datatype.is_union or datatype.is_recursive or len(datatype.members) == 0:
+                return 0
+            size = 0
+            for m in datatype.members:
+                if m.is_array or m.is_optional:
+                    return 0
+                # Structures without members are encoded as ExtensionObject
+                if isinstance(m.member_type, StructType) and not m.member_type.members:
+                    return 0
+                member_size = CGenerator.get_type_binarysize(m.member_type)
+                if member_size == 0:
+                    return 0
+                size += member_size
+            return size
+        return 0
+
     def print_datatype(self, datatype, namespaceMap):
         typeid = "{{{}, {}}}".format("0", getNodeidTypeAndId(datatype.nodeId))
         binaryEncodingId = "{{{}, {}}}".format("0",
@@ -139,7 +176,8 @@ class CGenerator:
                "    " + pointerfree + ", /* .pointerFree */\n" + \
                "    " + self.get_type_overlayable(datatype) + ", /* .overlayable */\n" + \
                "    " + str(len(datatype.members)) + ", /* .membersSize */\n" + \
-               "    %s_members" % idName + "  /* .members */\n" + \
+               "    %s_members" % idName + ", /* .members */\n" + \
+               "    " + str(self.get_type_binarysize(datatype)) + "  /* .binarySize */\n" + \
                "}"
 
     @staticmethod
@@ -83,7 +83,7 @@ parser.add_argument('--backend',
                     default='open62541',
                     const='open62541',
                     nargs='?',
-                    choices=['open62541', 'graphviz'],
+                    choices=['open62541', 'open62541_table', 'graphviz'],
                     help='Backend for the output files (default: %(default)s)')
 
 args = parser.parse_args()
@@ -224,6 +224,10 @@ if args.backend == "open62541":
     # Create the C code with the open62541 backend of the compiler
     from backend_open62541 import generateOpen62541Code
     generateOpen62541Code(ns, args.outputFile, args.internal_headers, args.typesArray)
+elif args.backend == "open62541_table":
+    # Static node tables that are loaded with UA_Server_addNodeTable
+    from backend_open62541 import generateOpen62541Code
+    generateOpen62541Code(ns, args.outputFile, args.internal_headers, args.typesArray, tables=True)
 elif args.backend == "graphviz":
     from backend_graphviz import generateGraphvizCode
     generateGraphvizCode(ns, filename=args.outputFile)
@@ -0,0 +1,908 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+/* Enable POSIX features */
+#if !defined(_XOPEN_SOURCE)
+# define _XOPEN_SOURCE 600
+#endif
+#ifndef _DEFAULT_SOURCE
+# define _DEFAULT_SOURCE
+#endif
+/* On older systems we need to define _BSD_SOURCE.
+ * _DEFAULT_SOURCE is an alias for that. */
+#ifndef _BSD_SOURCE
+# define _BSD_SOURCE
+#endif
+
+#include <open62541/client.h>
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
+#include <open62541/client_highlevel_async.h>
+#include <open62541/client_subscriptions.h>
+#include <open62541/plugin/log_stdout.h>
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if UA_MULTITHREADING >= 100 && defined(UA_ARCHITECTURE_POSIX)
+# define UA_LOAD_THREADS
+# include <pthread.h>
+# include <sys/resource.h>
+# include <unistd.h>
+#endif
+
+/**
+ * Load Generator
+ * --------------
+ * Opens many Sessions to a server and keeps them busy with a mix of Read,
+ * Write and Browse requests. Optionally, every Session creates Subscriptions
+ * with MonitoredItems and a fraction of the Sessions is disconnected and
+ * reconnected periodically (reconnect waves).
+ *
+ * The Sessions are distributed over worker threads. Every thread runs one
+ * UA_ClientPool, i.e. all clients of a thread share one EventLoop. The
+ * requests are sent asynchronously. Each Session has at most --inflight
+ * outstanding requests (closed loop). With --rate, the total request rate is
+ * limited by a token bucket (open loop up to the inflight limit).
+ *
+ * The latency of every operation is recorded in a log-linear histogram with
+ * a relative resolution of about 3%. At the end, the count, error count,
+ * throughput and the p50/p99/p999 latencies are printed per operation. */
+
+typedef enum {
+    OP_READ = 0,
+    OP_WRITE,
+    OP_BROWSE,
+    OP_SUBSCRIBE, /* CreateSubscription and CreateMonitoredItems */
+    OP_CONNECT,   /* Initial connect until the Session is activated */
+    OP_RECONNECT, /* Disconnect until the Session is activated again */
+    OP_COUNT
+} LoadOp;
+
+static const char *opNames[OP_COUNT] = {
+    "read", "write", "browse", "subscribe", "connect", "reconnect"
+};
+
+/* Histogram */
+
+#define HIST_SUBBITS 5
+#define HIST_SUBBUCKETS (1 << HIST_SUBBITS)
+#define HIST_BUCKETS (HIST_SUBBUCKETS * 40) /* Up to 2^44us */
+
+typedef struct {
+    UA_UInt64 count;
+    UA_UInt64 errors;
+    UA_UInt64 sum;
+    UA_UInt64 max;
+    UA_UInt64 buckets[HIST_BUCKETS];
+} Histogram;
+
+/* Values below HIST_SUBBUCKETS get their own bucket. Above, every power of
+ * two is split into HIST_SUBBUCKETS linear sub-buckets. */
+static size_t
+histIndex(UA_UInt64 v) {
+    if(v < HIST_SUBBUCKETS)
+        return (size_t)v;
+    size_t msb = HIST_SUBBITS;
+    while(v >> (msb + 1))
+        msb++;
+    size_t exp = msb - HIST_SUBBITS + 1;
+    size_t index = (exp << HIST_SUBBITS) + (size_t)((v >> (exp - 1)) & (HIST_SUBBUCKETS - 1));
+    return (index < HIST_BUCKETS) ? index : HIST_BUCKETS - 1;
+}
+
+/* Upper bound of the values in the bucket */
+static UA_UInt64
+histValue(size_t index) {
+    size_t exp = index >> HIST_SUBBITS;
+    UA_UInt64 sub = index & (HIST_SUBBUCKETS - 1);
+    if(exp == 0)
+        return sub;
+    return ((HIST_SUBBUCKETS + sub + 1) << (exp - 1)) - 1;
+}
+
+static void
+histRecord(Histogram *h, UA_UInt64 us, UA_Boolean error) {
+    h->count++;
+    if(error)
+        h->errors++;
+    h->sum += us;
+    if(us > h->max)
+        h->max = us;
+    h->buckets[histIndex(us)]++;
+}
+
+static void
+histMerge(Histogram *dst, const Histogram *src) {
+    dst->count += src->count;
+    dst->errors += src->errors;
+    dst->sum += src->sum;
+    if(src->max > dst->max)
+        dst->max = src->max;
+    for(size_t i = 0; i < HIST_BUCKETS; i++)
+        dst->buckets[i] += src->buckets[i];
+}
+
+static UA_UInt64
+histPercentile(const Histogram *h, double q) {
+    if(h->count == 0)
+        return 0;
+    UA_UInt64 target = (UA_UInt64)(q * (double)h->count);
+    if(target == 0)
+        target = 1;
+    UA_UInt64 seen = 0;
+    for(size_t i = 0; i < HIST_BUCKETS; i++) {
+        seen += h->buckets[i];
+        if(seen >= target) {
+            UA_UInt64 v = histValue(i);
+            return (v < h->max) ? v : h->max;
+        }
+    }
+    return h->max;
+}
+
+/* Configuration */
+
+static const char *url = NULL;
+static size_t sessions = 10;
+static size_t threads = 1;
+static double duration = 10.0;    /* seconds */
+static double rate = 0.0;         /* requests per second, 0 = unlimited */
+static size_t inflight = 1;       /* per session */
+static UA_UInt32 mix[3] = {8, 0, 2}; /* read:write:browse */
+static size_t subscriptions = 0;  /* per session */
+static size_t items = 10;         /* per subscription */
+static double interval = 1000.0;  /* publishing and sampling interval in ms */
+static double reconnectInterval = 0.0; /* seconds, 0 = no reconnect waves */
+static double reconnectFraction = 0.1;
+static UA_Boolean jsonOutput = false;
+static UA_NodeId readNode;
+static UA_NodeId writeNode;
+static UA_NodeId browseNode;
+static UA_Variant writeValue;
+
+static volatile UA_Boolean running = true;
+static UA_DateTime endTime; /* Monotonic */
+
+static void
+stopHandler(int sig) {
+    running = false;
+}
+
+/* Session and thread state */
+
+struct LoadThread;
+
+typedef struct {
+    struct LoadThread *thread;
+    UA_Client *client;
+    size_t inflight;
+    UA_Boolean activated;
+    UA_DateTime connectStart;   /* Pending connect or reconnect */
+    UA_Boolean reconnecting;    /* Measure as reconnect */
+    UA_Boolean waveDisconnect;  /* Disconnected by a reconnect wave */
+    size_t subscriptions;       /* Created on the server */
+    size_t subscriptionsPending;
+} LoadSession;
+
+typedef struct LoadThread {
+    size_t index;
+    UA_ClientPool *pool;
+    LoadSession *sessions;
+    size_t sessionsSize;
+    size_t nextSession;
+    UA_UInt64 rng;
+    double tokens;
+    UA_DateTime lastRefill;
+    UA_DateTime nextWave;
+    UA_DateTime stopped;
+    UA_UInt64 notifications;
+    Histogram hist[OP_COUNT];
+#ifdef UA_LOAD_THREADS
+    pthread_t pthread;
+#endif
+} LoadThread;
+
+typedef struct {
+    LoadSession *session;
+    LoadOp op;
+    UA_DateTime start;
+} LoadRequest;
+
+static UA_UInt64
+xorshift(UA_UInt64 *state) {
+    UA_UInt64 x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+/* The timestamps use the system monotonic clock. The clock source of the
+ * EventLoop is only configured once it is started. */
+static void
+recordOp(LoadThread *t, LoadOp op, UA_DateTime start, UA_Boolean error) {
+    UA_DateTime now = UA_DateTime_nowMonotonic();
+    UA_UInt64 us = (now > start) ? (UA_UInt64)(now - start) / UA_DATETIME_USEC : 0;
+    histRecord(&t->hist[op], us, error);
+}
+
+/* Called with the client mutex unlocked. Only the bookkeeping is done here,
+ * new requests are sent from the main loop of the thread. */
+static void
+stateCallback(UA_Client *client, UA_SecureChannelState channelState,
+              UA_SessionState sessionState, UA_StatusCode connectStatus) {
+    LoadSession *s = (LoadSession*)UA_Client_getContext(client);
+    if(!s)
+        return;
+    UA_Boolean activated = (sessionState == UA_SESSIONSTATE_ACTIVATED);
+    LoadThread *t = s->thread;
+    if(!activated && s->activated && s->connectStart == 0) {
+        /* Session lost without a reconnect wave */
+        s->connectStart = UA_DateTime_nowMonotonic();
+        s->reconnecting = true;
+    }
+    if(activated && !s->activated && s->connectStart != 0) {
+        recordOp(t, s->reconnecting ? OP_RECONNECT : OP_CONNECT,
+                 s->connectStart, false);
+        s->connectStart = 0;
+        s->reconnecting = false;
+    }
+    s->activated = activated;
+}
+
+static void
+responseCallback(UA_Client *client, void *userdata,
+                 UA_UInt32 requestId, void *response) {
+    LoadRequest *req = (LoadRequest*)userdata;
+    LoadSession *s = req->session;
+    const UA_ResponseHeader *rh = (const UA_ResponseHeader*)response;
+    recordOp(s->thread, req->op, req->start,
+             rh->serviceResult != UA_STATUSCODE_GOOD);
+    s->inflight--;
+    UA_free(req);
+}
+
+static UA_StatusCode
+sendRequest(LoadSession *s, LoadOp op) {
+    LoadThread *t = s->thread;
+    LoadRequest *req = (LoadRequest*)UA_malloc(sizeof(LoadRequest));
+    if(!req)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    req->session = s;
+    req->op = op;
+    req->start = UA_DateTime_nowMonotonic();
+
+    UA_StatusCode res;
+    if(op == OP_READ) {
+        UA_ReadValueId rvid;
+        UA_ReadValueId_init(&rvid);
+        rvid.nodeId = readNode;
+        rvid.attributeId = UA_ATTRIBUTEID_VALUE;
+        UA_ReadRequest rr;
+        UA_ReadRequest_init(&rr);
+        rr.nodesToRead = &rvid;
+        rr.nodesToReadSize = 1;
+        res = UA_Client_sendAsyncReadRequest(s->client, &rr,
+                  (UA_ClientAsyncReadCallback)(uintptr_t)responseCallback, req, NULL);
+    } else if(op == OP_WRITE) {
+        UA_WriteValue wv;
+        UA_WriteValue_init(&wv);
+        wv.nodeId = writeNode;
+        wv.attributeId = UA_ATTRIBUTEID_VALUE;
+        wv.value.value = writeValue;
+        wv.value.hasValue = true;
+        UA_WriteRequest wr;
+        UA_WriteRequest_init(&wr);
+        wr.nodesToWrite = &wv;
+        wr.nodesToWriteSize = 1;
+        res = UA_Client_sendAsyncWriteRequest(s->client, &wr,
+                  (UA_ClientAsyncWriteCallback)(uintptr_t)responseCallback, req, NULL);
+    } else {
+        UA_BrowseDescription bd;
+        UA_BrowseDescription_init(&bd);
+        bd.nodeId = browseNode;
+        bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+        bd.includeSubtypes = true;
+        bd.resultMask = UA_BROWSERESULTMASK_ALL;
+        UA_BrowseRequest br;
+        UA_BrowseRequest_init(&br);
+        br.nodesToBrowse = &bd;
+        br.nodesToBrowseSize = 1;
+        res = UA_Client_sendAsyncBrowseRequest(s->client, &br,
+                  (UA_ClientAsyncBrowseCallback)(uintptr_t)responseCallback, req, NULL);
+    }
+
+    if(res != UA_STATUSCODE_GOOD) {
+        histRecord(&t->hist[op], 0, true);
+        UA_free(req);
+        return res;
+    }
+    s->inflight++;
+    return UA_STATUSCODE_GOOD;
+}
+
+static LoadOp
+selectOp(LoadThread *t) {
+    UA_UInt32 total = mix[0] + mix[1] + mix[2];
+    UA_UInt32 r = (UA_UInt32)(xorshift(&t->rng) % total);
+    if(r < mix[0])
+        return OP_READ;
+    if(r < mix[0] + mix[1])
+        return OP_WRITE;
+    return OP_BROWSE;
+}
+
+/* Subscriptions */
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+
+static void
+dataChangeCallback(UA_Client *client, UA_UInt32 subId, void *subContext,
+                   UA_UInt32 monId, void *monContext, UA_DataValue *value) {
+    LoadSession *s = (LoadSession*)subContext;
+    s->thread->notifications++;
+}
+
+static void
+deleteSubscriptionCallback(UA_Client *client, UA_UInt32 subId, void *subContext) {
+    LoadSession *s = (LoadSession*)subContext;
+    if(s->subscriptions > 0)
+        s->subscriptions--;
+}
+
+static void
+monitoredItemsCallback(UA_Client *client, void *userdata,
+                       UA_UInt32 requestId, void *response) {
+    LoadRequest *req = (LoadRequest*)userdata;
+    LoadSession *s = req->session;
+    UA_CreateMonitoredItemsResponse *resp =
+        (UA_CreateMonitoredItemsResponse*)response;
+    UA_Boolean error = (resp->responseHeader.serviceResult != UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < resp->resultsSize; i++)
+        error |= (resp->results[i].statusCode != UA_STATUSCODE_GOOD);
+    recordOp(s->thread, OP_SUBSCRIBE, req->start, error);
+    s->subscriptionsPending--;
+    UA_free(req);
+}
+
+static void
+subscriptionCallback(UA_Client *client, void *userdata,
+                     UA_UInt32 requestId, void *response) {
+    LoadRequest *req = (LoadRequest*)userdata;
+    LoadSession *s = req->session;
+    UA_CreateSubscriptionResponse *resp = (UA_CreateSubscriptionResponse*)response;
+    if(resp->responseHeader.serviceResult != UA_STATUSCODE_GOOD)
+        goto error;
+    s->subscriptions++;
+
+    /* All MonitoredItems sample the read node */
+    UA_MonitoredItemCreateRequest *mis = (UA_MonitoredItemCreateRequest*)
+        UA_calloc(items, sizeof(UA_MonitoredItemCreateRequest));
+    void **contexts = (void**)UA_calloc(items, sizeof(void*));
+    UA_Client_DataChangeNotificationCallback *callbacks =
+        (UA_Client_DataChangeNotificationCallback*)
+        UA_calloc(items, sizeof(UA_Client_DataChangeNotificationCallback));
+    UA_StatusCode res = UA_STATUSCODE_BADOUTOFMEMORY;
+    if(mis && contexts && callbacks) {
+        for(size_t i = 0; i < items; i++) {
+            mis[i] = UA_MonitoredItemCreateRequest_default(readNode);
+            mis[i].requestedParameters.samplingInterval = interval;
+            callbacks[i] = dataChangeCallback;
+        }
+        UA_CreateMonitoredItemsRequest mir;
+        UA_CreateMonitoredItemsRequest_init(&mir);
+        mir.subscriptionId = resp->subscriptionId;
+        mir.timestampsToReturn = UA_TIMESTAMPSTORETURN_NEITHER;
+        mir.itemsToCreate = mis;
+        mir.itemsToCreateSize = items;
+        res = UA_Client_MonitoredItems_createDataChanges_async(client, mir, contexts,
+                                                                callbacks, NULL,
+                                                                monitoredItemsCallback,
+                                                                req, NULL);
+    }
+    /* The arrays are copied for the request. The NodeIds in the items point
+     * to the static readNode and are not deleted. */
+    UA_free(mis);
+    UA_free(contexts);
+    UA_free(callbacks);
+    if(res == UA_STATUSCODE_GOOD)
+        return;
+
+ error:
+    recordOp(s->thread, OP_SUBSCRIBE, req->start, true);
+    s->subscriptionsPending--;
+    UA_free(req);
+}
+
+static void
+createSubscription(LoadSession *s) {
+    LoadThread *t = s->thread;
+    LoadRequest *req = (LoadRequest*)UA_malloc(sizeof(LoadRequest));
+    if(!req)
+        return;
+    req->session = s;
+    req->op = OP_SUBSCRIBE;
+    req->start = UA_DateTime_nowMonotonic();
+
+    UA_CreateSubscriptionRequest csr = UA_CreateSubscriptionRequest_default();
+    csr.requestedPublishingInterval = interval;
+    UA_StatusCode res =
+        UA_Client_Subscriptions_create_async(s->client, csr, s, NULL,
+                                             deleteSubscriptionCallback,
+                                             subscriptionCallback, req, NULL);
+    if(res != UA_STATUSCODE_GOOD) {
+        histRecord(&t->hist[OP_SUBSCRIBE], 0, true);
+        UA_free(req);
+        return;
+    }
+    s->subscriptionsPending++;
+}
+
+#endif /* UA_ENABLE_SUBSCRIPTIONS */
+
+/* Disconnect a random fraction of the activated Sessions. They are
+ * reconnected in the main loop. */
+static void
+reconnectWave(LoadThread *t, UA_DateTime now) {
+    UA_UInt64 threshold = (UA_UInt64)(reconnectFraction * 1000000.0);
+    for(size_t i = 0; i < t->sessionsSize; i++) {
+        LoadSession *s = &t->sessions[i];
+        if(!s->activated || xorshift(&t->rng) % 1000000 >= threshold)
+            continue;
+        s->reconnecting = true;
+        s->waveDisconnect = true;
+        s->connectStart = now;
+        UA_Client_disconnectAsync(s->client);
+    }
+}
+
+static void
+runThread(LoadThread *t) {
+    UA_DateTime waveInterval = (UA_DateTime)(reconnectInterval * UA_DATETIME_SEC);
+    double threadRate = rate / (double)threads;
+    double burst = (threadRate > 100.0) ? threadRate / 100.0 : 1.0;
+    t->lastRefill = UA_DateTime_nowMonotonic();
+    t->nextWave = t->lastRefill + waveInterval;
+
+    while(running) {
+        /* The pool retries failed connections. No need to check the result. */
+        UA_ClientPool_run_iterate(t->pool, 1);
+
+        UA_DateTime now = UA_DateTime_nowMonotonic();
+        if(now >= endTime) {
+            running = false;
+            break;
+        }
+        if(waveInterval > 0 && now >= t->nextWave) {
+            reconnectWave(t, now);
+            t->nextWave = now + waveInterval;
+        }
+
+        /* Refill the token bucket */
+        if(threadRate > 0.0) {
+            t->tokens += threadRate * (double)(now - t->lastRefill) / UA_DATETIME_SEC;
+            if(t->tokens > burst)
+                t->tokens = burst;
+        }
+        t->lastRefill = now;
+
+        /* Reconnect the Sessions of a wave right away. Otherwise the pool
+         * backs off for the client timeout between the attempts. Failed
+         * attempts are retried by the pool. */
+        for(size_t i = 0; i < t->sessionsSize; i++) {
+            LoadSession *s = &t->sessions[i];
+            if(!s->waveDisconnect)
+                continue;
+            UA_SecureChannelState channelState;
+            UA_StatusCode connectStatus;
+            UA_Client_getState(s->client, &channelState, NULL, &connectStatus);
+            if(channelState != UA_SECURECHANNELSTATE_CLOSED)
+                continue;
+            s->waveDisconnect = false;
+            if(connectStatus != UA_STATUSCODE_GOOD)
+                UA_Client_connectAsync(s->client, url);
+        }
+
+        /* Send requests in round-robin order over the Sessions */
+        size_t idle = 0;
+        while(running && idle < t->sessionsSize) {
+            LoadSession *s = &t->sessions[t->nextSession];
+            t->nextSession = (t->nextSession + 1) % t->sessionsSize;
+            if(!s->activated) {
+                idle++;
+                continue;
+            }
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+            if(s->subscriptions + s->subscriptionsPending < subscriptions)
+                createSubscription(s);
+#endif
+            if(s->inflight >= inflight) {
+                idle++;
+                continue;
+            }
+            if(threadRate > 0.0) {
+                if(t->tokens < 1.0)
+                    break;
+                t->tokens -= 1.0;
+            }
+            if(sendRequest(s, selectOp(t)) != UA_STATUSCODE_GOOD)
+                idle++;
+            else
+                idle = 0;
+        }
+    }
+    t->stopped = UA_DateTime_nowMonotonic();
+}
+
+/* Close all Sessions at once. UA_ClientPool_delete disconnects the clients
+ * one after the other, each waiting for the CloseSession response. */
+static void
+closeThread(LoadThread *t) {
+    for(size_t i = 0; i < t->sessionsSize; i++) {
+        t->sessions[i].waveDisconnect = false;
+        UA_Client_disconnectAsync(t->sessions[i].client);
+    }
+    UA_EventLoop *el = UA_Client_getConfig(t->sessions[0].client)->eventLoop;
+    UA_DateTime end = UA_DateTime_nowMonotonic() + 2 * UA_DATETIME_SEC;
+    size_t open = t->sessionsSize;
+    while(open > 0 && UA_DateTime_nowMonotonic() < end) {
+        el->run(el, 10);
+        open = 0;
+        for(size_t i = 0; i < t->sessionsSize; i++) {
+            UA_SecureChannelState channelState;
+            UA_Client_getState(t->sessions[i].client, &channelState, NULL, NULL);
+            if(channelState != UA_SECURECHANNELSTATE_CLOSED)
+                open++;
+        }
+    }
+}
+
+#ifdef UA_LOAD_THREADS
+static void *
+threadMain(void *context) {
+    runThread((LoadThread*)context);
+    closeThread((LoadThread*)context);
+    return NULL;
+}
+
+/* Every Session uses a socket. Raise the limit of open files as far as
+ * allowed. */
+static void
+raiseFileLimit(void) {
+    struct rlimit rl;
+    if(getrlimit(RLIMIT_NOFILE, &rl) != 0)
+        return;
+    if(rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+}
+#endif
+
+static UA_Client *
+newClient(void *context) {
+    UA_ClientConfig cc;
+    memset(&cc, 0, sizeof(UA_ClientConfig));
+    cc.logging = UA_Log_Stdout_new(UA_LOGLEVEL_WARNING);
+    UA_StatusCode res = UA_ClientConfig_setDefault(&cc);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_ClientConfig_clear(&cc);
+        return NULL;
+    }
+    cc.clientContext = context;
+    if(context)
+        cc.stateCallback = stateCallback;
+    return UA_Client_newWithConfig(&cc);
+}
+
+static UA_StatusCode
+setupThread(LoadThread *t, LoadSession *sessionsStart, size_t sessionsSize) {
+    t->sessions = sessionsStart;
+    t->sessionsSize = sessionsSize;
+    t->rng = 0x9E3779B97F4A7C15ULL * (t->index + 1);
+    t->pool = UA_ClientPool_new();
+    if(!t->pool)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    for(size_t i = 0; i < sessionsSize; i++) {
+        LoadSession *s = &sessionsStart[i];
+        s->thread = t;
+        s->client = newClient(s);
+        if(!s->client)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        UA_StatusCode res = UA_ClientPool_addClient(t->pool, s->client);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_Client_delete(s->client);
+            s->client = NULL;
+            return res;
+        }
+    }
+    UA_DateTime now = UA_DateTime_nowMonotonic();
+    for(size_t i = 0; i < sessionsSize; i++)
+        sessionsStart[i].connectStart = now;
+    return UA_ClientPool_connectAsync(t->pool, url);
+}
+
+/* Connect once synchronously to check the server and to read the value that
+ * is written back by the Write requests */
+static UA_StatusCode
+probeServer(void) {
+    UA_Client *client = newClient(NULL);
+    if(!client)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_StatusCode res = UA_Client_connect(client, url);
+    if(res == UA_STATUSCODE_GOOD && mix[1] > 0)
+        res = UA_Client_readValueAttribute(client, writeNode, &writeValue);
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+    return res;
+}
+
+/* Output */
+
+static void
+printResults(const Histogram *hist, UA_UInt64 notifications, double elapsed) {
+    if(jsonOutput) {
+        printf("{\n  \"url\": \"%s\",\n  \"sessions\": %lu,\n  \"threads\": %lu,\n"
+               "  \"duration\": %.3f,\n  \"notifications\": %llu,\n  \"operations\": [",
+               url, (unsigned long)sessions, (unsigned long)threads, elapsed,
+               (unsigned long long)notifications);
+        UA_Boolean first = true;
+        for(size_t i = 0; i < OP_COUNT; i++) {
+            const Histogram *h = &hist[i];
+            if(h->count == 0)
+                continue;
+            printf("%s\n    {\"op\": \"%s\", \"count\": %llu, \"errors\": %llu, "
+                   "\"ops_per_sec\": %.1f, \"mean_us\": %.1f, \"p50_us\": %llu, "
+                   "\"p99_us\": %llu, \"p999_us\": %llu, \"max_us\": %llu}",
+                   first ? "" : ",", opNames[i],
+                   (unsigned long long)h->count, (unsigned long long)h->errors,
+                   (double)h->count / elapsed, (double)h->sum / (double)h->count,
+                   (unsigned long long)histPercentile(h, 0.5),
+                   (unsigned long long)histPercentile(h, 0.99),
+                   (unsigned long long)histPercentile(h, 0.999),
+                   (unsigned long long)h->max);
+            first = false;
+        }
+        printf("\n  ]\n}\n");
+        return;
+    }
+
+    printf("%lu sessions, %lu threads, %.1fs\n",
+           (unsigned long)sessions, (unsigned long)threads, elapsed);
+    printf("%-10s %10s %8s %10s %10s %10s %10s %10s\n", "op", "count", "errors",
+           "ops/s", "p50[us]", "p99[us]", "p999[us]", "max[us]");
+    for(size_t i = 0; i < OP_COUNT; i++) {
+        const Histogram *h = &hist[i];
+        if(h->count == 0)
+            continue;
+        printf("%-10s %10llu %8llu %10.1f %10llu %10llu %10llu %10llu\n", opNames[i],
+               (unsigned long long)h->count, (unsigned long long)h->errors,
+               (double)h->count / elapsed,
+               (unsigned long long)histPercentile(h, 0.5),
+               (unsigned long long)histPercentile(h, 0.99),
+               (unsigned long long)histPercentile(h, 0.999),
+               (unsigned long long)h->max);
+    }
+    if(notifications > 0)
+        printf("notifications: %llu (%.1f/s)\n", (unsigned long long)notifications,
+               (double)notifications / elapsed);
+}
+
+static void
+usage(void) {
+    printf("Usage: ua-load <server-url> [options]\n"
+           " --sessions <n>: Number of Sessions [default: 10]\n"
+           " --threads <n>: Worker threads, each with one EventLoop [default: 1]\n"
+           " --duration <s>: Test duration in seconds [default: 10]\n"
+           " --rate <n>: Total requests per second, 0 for unlimited [default: 0]\n"
+           " --inflight <n>: Outstanding requests per Session [default: 1]\n"
+           " --mix <r:w:b>: Weights of Read, Write and Browse [default: 8:0:2]\n"
+           " --read-node <nodeid>: Node for Read and MonitoredItems "
+           "[default: ns=0;i=2258]\n"
+           " --write-node <nodeid>: Variable for Write. Required for a non-zero "
+           "write weight\n"
+           " --browse-node <nodeid>: Node for Browse [default: ns=0;i=85]\n"
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+           " --subscriptions <n>: Subscriptions per Session [default: 0]\n"
+           " --items <n>: MonitoredItems per Subscription [default: 10]\n"
+           " --interval <ms>: Publishing and sampling interval [default: 1000]\n"
+#endif
+           " --reconnect-interval <s>: Period of the reconnect waves, 0 to "
+           "disable [default: 0]\n"
+           " --reconnect-fraction <f>: Fraction of the Sessions reconnected per "
+           "wave [default: 0.1]\n"
+           " --json: Print the results as JSON\n"
+           " --help: Print this message\n");
+}
+
+static int
+parseNode(UA_NodeId *id, const char *str) {
+    UA_NodeId_clear(id);
+    if(UA_NodeId_parse(id, UA_STRING((char*)(uintptr_t)str)) == UA_STATUSCODE_GOOD)
+        return 0;
+    fprintf(stderr, "Cannot parse the NodeId %s\n", str);
+    return -1;
+}
+
+static int
+parseMix(const char *str) {
+    unsigned r, w, b;
+    if(sscanf(str, "%u:%u:%u", &r, &w, &b) != 3 || r + w + b == 0) {
+        fprintf(stderr, "Cannot parse the mix %s\n", str);
+        return -1;
+    }
+    mix[0] = r;
+    mix[1] = w;
+    mix[2] = b;
+    return 0;
+}
+
+static int
+parseArgs(int argc, char **argv) {
+    if(argc < 2 || strstr(argv[1], "--") == argv[1])
+        return -1;
+    url = argv[1];
+    for(int argpos = 2; argpos < argc; argpos++) {
+        const char *opt = argv[argpos];
+        if(strcmp(opt, "--json") == 0) {
+            jsonOutput = true;
+            continue;
+        }
+        /* All other options have an argument */
+        if(argpos + 1 >= argc)
+            return -1;
+        const char *arg = argv[++argpos];
+        if(strcmp(opt, "--sessions") == 0)
+            sessions = strtoul(arg, NULL, 10);
+        else if(strcmp(opt, "--threads") == 0)
+            threads = strtoul(arg, NULL, 10);
+        else if(strcmp(opt, "--duration") == 0)
+            duration = atof(arg);
+        else if(strcmp(opt, "--rate") == 0)
+            rate = atof(arg);
+        else if(strcmp(opt, "--inflight") == 0)
+            inflight = strtoul(arg, NULL, 10);
+        else if(strcmp(opt, "--mix") == 0) {
+            if(parseMix(arg) != 0)
+                return -1;
+        } else if(strcmp(opt, "--read-node") == 0) {
+            if(parseNode(&readNode, arg) != 0)
+                return -1;
+        } else if(strcmp(opt, "--write-node") == 0) {
+            if(parseNode(&writeNode, arg) != 0)
+                return -1;
+        } else if(strcmp(opt, "--browse-node") == 0) {
+            if(parseNode(&browseNode, arg) != 0)
+                return -1;
+        }
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+        else if(strcmp(opt, "--subscriptions") == 0)
+            subscriptions = strtoul(arg, NULL, 10);
+        else if(strcmp(opt, "--items") == 0)
+            items = strtoul(arg, NULL, 10);
+        else if(strcmp(opt, "--interval") == 0)
+            interval = atof(arg);
+#endif
+        else if(strcmp(opt, "--reconnect-interval") == 0)
+            reconnectInterval = atof(arg);
+        else if(strcmp(opt, "--reconnect-fraction") == 0)
+            reconnectFraction = atof(arg);
+        else
+            return -1;
+    }
+
+    if(sessions == 0 || inflight == 0 || items == 0)
+        return -1;
+    if(threads == 0)
+        threads = 1;
+    if(threads > sessions)
+        threads = sessions;
+#ifndef UA_LOAD_THREADS
+    threads = 1;
+#endif
+    if(mix[1] > 0 && UA_NodeId_isNull(&writeNode)) {
+        fprintf(stderr, "A write weight requires --write-node\n");
+        return -1;
+    }
+    return 0;
+}
+
+int
+main(int argc, char **argv) {
+    readNode = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_CURRENTTIME);
+    browseNode = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    if(argc > 1 && strcmp(argv[1], "--help") == 0) {
+        usage();
+        return 0;
+    }
+    if(parseArgs(argc, argv) != 0) {
+        usage();
+        return -1;
+    }
+
+    signal(SIGINT, stopHandler);
+    signal(SIGTERM, stopHandler);
+#ifdef UA_LOAD_THREADS
+    raiseFileLimit();
+#endif
+
+    int ret = -1;
+    LoadSession *sessionArray = NULL;
+    LoadThread *threadArray = NULL;
+    UA_StatusCode res = probeServer();
+    if(res != UA_STATUSCODE_GOOD) {
+        fprintf(stderr, "Cannot connect to %s: %s\n", url, UA_StatusCode_name(res));
+        goto cleanup;
+    }
+
+    sessionArray = (LoadSession*)UA_calloc(sessions, sizeof(LoadSession));
+    threadArray = (LoadThread*)UA_calloc(threads, sizeof(LoadThread));
+    if(!sessionArray || !threadArray)
+        goto cleanup;
+
+    /* Distribute the Sessions evenly over the threads */
+    size_t offset = 0;
+    for(size_t i = 0; i < threads; i++) {
+        size_t n = sessions / threads + ((i < sessions % threads) ? 1 : 0);
+        threadArray[i].index = i;
+        res = setupThread(&threadArray[i], &sessionArray[offset], n);
+        if(res != UA_STATUSCODE_GOOD) {
+            fprintf(stderr, "Cannot set up the sessions: %s\n",
+                    UA_StatusCode_name(res));
+            goto cleanup;
+        }
+        offset += n;
+    }
+
+    UA_DateTime start = UA_DateTime_nowMonotonic();
+    endTime = start + (UA_DateTime)(duration * UA_DATETIME_SEC);
+#ifdef UA_LOAD_THREADS
+    for(size_t i = 0; i < threads; i++)
+        pthread_create(&threadArray[i].pthread, NULL, threadMain, &threadArray[i]);
+    for(size_t i = 0; i < threads; i++)
+        pthread_join(threadArray[i].pthread, NULL);
+#else
+    runThread(&threadArray[0]);
+    closeThread(&threadArray[0]);
+#endif
+    UA_DateTime stopped = start;
+    for(size_t i = 0; i < threads; i++) {
+        if(threadArray[i].stopped > stopped)
+            stopped = threadArray[i].stopped;
+    }
+    double elapsed = (double)(stopped - start) / UA_DATETIME_SEC;
+
+    /* Merge the results of the threads */
+    Histogram *hist = (Histogram*)UA_calloc(OP_COUNT, sizeof(Histogram));
+    if(!hist)
+        goto cleanup;
+    UA_UInt64 notifications = 0;
+    for(size_t i = 0; i < threads; i++) {
+        for(size_t j = 0; j < OP_COUNT; j++)
+            histMerge(&hist[j], &threadArray[i].hist[j]);
+        notifications += threadArray[i].notifications;
+    }
+    printResults(hist, notifications, elapsed);
+    UA_free(hist);
+    ret = 0;
+
+ cleanup:
+    if(threadArray) {
+        for(size_t i = 0; i < threads; i++) {
+            if(threadArray[i].pool)
+                UA_ClientPool_delete(threadArray[i].pool);
+        }
+    }
+    UA_free(threadArray);
+    UA_free(sessionArray);
+    UA_Variant_clear(&writeValue);
+    UA_NodeId_clear(&readNode);
+    UA_NodeId_clear(&writeNode);
+    UA_NodeId_clear(&browseNode);
+    return ret;
+}